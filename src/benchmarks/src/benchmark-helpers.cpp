@@ -0,0 +1,46 @@
+#include "benchmark-helpers.h"
+#include <QCryptographicHash>
+
+
+QMap<QString, QString> sampleDetails(int index)
+{
+	const QString id = QString::number(7331 + index);
+	const QString md5 = QCryptographicHash::hash(id.toLatin1(), QCryptographicHash::Md5).toHex();
+
+	QMap<QString, QString> details;
+	details["md5"] = md5;
+	details["ext"] = "jpg";
+	details["author"] = "superauthor";
+	details["status"] = "active";
+	details["id"] = id;
+	details["score"] = "21";
+	details["parent_id"] = "1337";
+	details["file_size"] = "1234567";
+	details["creator_id"] = "1234";
+	details["has_children"] = "true";
+	details["has_note"] = "true";
+	details["has_comments"] = "true";
+	details["file_url"] = "https://test.com/img/" + md5 + ".jpg";
+	details["sample_url"] = "https://test.com/sample/" + md5 + ".jpg";
+	details["preview_url"] = "https://test.com/preview/" + md5 + ".jpg";
+	details["width"] = "1920";
+	details["height"] = "1080";
+	details["source"] = "https://google.com/";
+	details["tags_general"] = "1girl long_hair blush smile looking_at_viewer solo short_sleeves skirt tag1 tag2 tag3";
+	details["tags_artist"] = "artist1";
+	details["tags_copyright"] = "copyright1 copyright2";
+	details["tags_character"] = "character1 character2";
+	details["created_at"] = "1471513944";
+	details["rating"] = "safe";
+	return details;
+}
+
+QStringList sampleTags(int count, const QString &prefix)
+{
+	QStringList tags;
+	tags.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		tags.append(prefix + "_" + QString::number(i));
+	}
+	return tags;
+}
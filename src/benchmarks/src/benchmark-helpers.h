@@ -0,0 +1,19 @@
+#ifndef BENCHMARK_HELPERS_H
+#define BENCHMARK_HELPERS_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+
+/**
+ * Details of a typical image, the ID and MD5 depending on the given index.
+ */
+QMap<QString, QString> sampleDetails(int index = 0);
+
+/**
+ * Generate the given number of distinct tag names.
+ */
+QStringList sampleTags(int count, const QString &prefix = "tag");
+
+#endif // BENCHMARK_HELPERS_H
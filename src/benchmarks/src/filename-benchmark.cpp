@@ -0,0 +1,61 @@
+#include "filename-benchmark.h"
+#include <QSettings>
+#include <QtTest>
+#include "benchmark-helpers.h"
+#include "models/filename.h"
+#include "models/image.h"
+#include "models/image-factory.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "source-helpers.h"
+
+
+void FilenameBenchmark::initTestCase()
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	m_profile = makeProfile();
+	m_profile->getSettings()->setValue("Save/character_multiple", "replaceAll");
+	m_profile->getSettings()->setValue("Save/copyright_multiple", "replaceAll");
+
+	Site *site = m_profile->getSites().value("danbooru.donmai.us");
+	QVERIFY(site != nullptr);
+
+	m_image = ImageFactory::build(site, sampleDetails(), m_profile);
+	QVERIFY(!m_image.isNull());
+
+	// Tokens are computed once per image, so compute them beforehand to only measure the rendering itself
+	m_image->tokens(m_profile);
+}
+
+void FilenameBenchmark::cleanupTestCase()
+{
+	m_image.clear();
+	delete m_profile;
+}
+
+void FilenameBenchmark::path_data()
+{
+	QTest::addColumn<QString>("format");
+
+	QTest::newRow("simple") << "%md5%.%ext%";
+	QTest::newRow("tokens") << "%artist% - %copyright% - %character% - %id%.%ext%";
+	QTest::newRow("options") << "%artist:maxlength=20% - %general:count=5,separator=_% - %date:format=yyyy-MM-dd%.%ext%";
+	QTest::newRow("conditionals") << "<%artist% - ><\"1girl\"solo/><-\"solo\"group/>%md5%.%ext%";
+	QTest::newRow("javascript") << "javascript:artist + ' - ' + md5 + '.' + ext";
+}
+
+void FilenameBenchmark::path()
+{
+	QFETCH(QString, format);
+
+	const Filename filename(format);
+	const QMap<QString, Token> &tokens = m_image->tokens(m_profile);
+
+	QStringList paths;
+	QBENCHMARK {
+		paths = filename.path(tokens, m_profile, "/home/test/Pictures", 7, Filename::Complex | Filename::CapLength | Filename::Fix);
+	}
+	QVERIFY(!paths.isEmpty());
+}
@@ -0,0 +1,27 @@
+#ifndef FILENAME_BENCHMARK_H
+#define FILENAME_BENCHMARK_H
+
+#include <QObject>
+#include <QSharedPointer>
+
+
+class Image;
+class Profile;
+
+class FilenameBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+
+		void path_data();
+		void path();
+
+	private:
+		Profile *m_profile = nullptr;
+		QSharedPointer<Image> m_image;
+};
+
+#endif // FILENAME_BENCHMARK_H
@@ -0,0 +1,82 @@
+#include "filtering-benchmark.h"
+#include <QtTest>
+#include "benchmark-helpers.h"
+#include "models/filtering/blacklist.h"
+#include "models/filtering/post-filter.h"
+#include "models/image.h"
+#include "models/image-factory.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "source-helpers.h"
+
+
+void FilteringBenchmark::initTestCase()
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	m_profile = makeProfile();
+
+	Site *site = m_profile->getSites().value("danbooru.donmai.us");
+	QVERIFY(site != nullptr);
+
+	m_image = ImageFactory::build(site, sampleDetails(), m_profile);
+	QVERIFY(!m_image.isNull());
+	m_image->tokens(m_profile);
+}
+
+void FilteringBenchmark::cleanupTestCase()
+{
+	m_image.clear();
+	delete m_profile;
+}
+
+void FilteringBenchmark::blacklist_data()
+{
+	QTest::addColumn<QStringList>("tags");
+
+	for (int count : { 10, 1000, 10000 }) {
+		QTest::newRow(qPrintable(QString("%1 tags").arg(count))) << sampleTags(count, "blacklisted");
+		QTest::newRow(qPrintable(QString("%1 wildcards").arg(count))) << sampleTags(count, "blacklisted*");
+		QTest::newRow(qPrintable(QString("%1 combinations").arg(count))) << sampleTags(count, "blacklisted rating:explicit");
+	}
+}
+
+/**
+ * The worst case of a blacklist not matching, as all of its lines have to be checked.
+ */
+void FilteringBenchmark::blacklist()
+{
+	QFETCH(QStringList, tags);
+
+	const Blacklist blacklist(tags);
+	const QMap<QString, Token> &tokens = m_image->tokens(m_profile);
+
+	bool matches = true;
+	QBENCHMARK {
+		matches = blacklist.matches(tokens);
+	}
+	QVERIFY(!matches);
+}
+
+void FilteringBenchmark::postFilter_data()
+{
+	QTest::addColumn<QStringList>("filters");
+
+	QTest::newRow("tags") << QStringList { "1girl", "-solo", "long_hair" };
+	QTest::newRow("meta") << QStringList { "rating:safe", "width:>=1000", "score:10..50", "md5:" + sampleDetails().value("md5") };
+	QTest::newRow("tokens") << QStringList { "%artist%", "-%copyright%:copyright3" };
+	QTest::newRow("many") << sampleTags(100, "-filtered");
+}
+
+void FilteringBenchmark::postFilter()
+{
+	QFETCH(QStringList, filters);
+
+	const PostFilter postFilter(filters);
+	const QMap<QString, Token> &tokens = m_image->tokens(m_profile);
+
+	QBENCHMARK {
+		postFilter.match(tokens);
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef FILTERING_BENCHMARK_H
+#define FILTERING_BENCHMARK_H
+
+#include <QObject>
+#include <QSharedPointer>
+
+
+class Image;
+class Profile;
+
+class FilteringBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+
+		void blacklist_data();
+		void blacklist();
+		void postFilter_data();
+		void postFilter();
+
+	private:
+		Profile *m_profile = nullptr;
+		QSharedPointer<Image> m_image;
+};
+
+#endif // FILTERING_BENCHMARK_H
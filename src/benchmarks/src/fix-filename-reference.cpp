@@ -0,0 +1,164 @@
+#include "fix-filename-reference.h"
+#include <QByteArray>
+#include <QFileInfo>
+#include <QStringList>
+
+
+// https://stackoverflow.com/questions/26629382/how-to-shorten-qstring-in-a-way-that-when-converted-to-utf-8-it-is-shorter-than
+static bool cutStringToUtf8BytesReference(QString &str, int limit)
+{
+	QByteArray output = str.toUtf8();
+	if (output.size() > limit) {
+		int truncateAt = 0;
+		for (int i = limit; i > 0; i--) {
+			if ((output[i] & 0xC0) != 0x80) {
+				truncateAt = i;
+				break;
+			}
+		}
+		output.truncate(truncateAt);
+		str = QString::fromUtf8(output);
+		return true;
+	}
+	return false;
+}
+
+QString fixFilenameLinuxReference(const QString &fn, const QString &path, int maxLength)
+{
+	// Fix parameters
+	const QString sep = QStringLiteral("/");
+	maxLength = maxLength == 0 ? 255 : maxLength;
+	QString filename = path + fn;
+
+	// Divide filename
+	QStringList parts = filename.split(sep);
+	QString file, ext;
+	if (!fn.isEmpty()) {
+		file = parts.takeLast();;
+		const int lastDot = file.lastIndexOf('.');
+		if (lastDot != -1) {
+			ext = file.right(file.length() - lastDot - 1);
+			file = file.left(lastDot);
+		}
+	}
+
+	// Fix directories (each part cannot be more than 255 bytes)
+	for (QString &part : parts) {
+		cutStringToUtf8BytesReference(part, 255);
+	}
+
+	// A filename cannot exceed 255 bytes
+	const int extlen = ext.isEmpty() ? 0 : ext.length() + 1;
+	cutStringToUtf8BytesReference(file, maxLength - extlen);
+
+	// Join parts back
+	QString dirpart = parts.join(sep);
+	filename = (dirpart.isEmpty() ? QString() : dirpart + (!fn.isEmpty() ? sep : QString())) + file;
+
+	// Get separation between filename and path
+	int index = -1;
+	const int pathGroups = path.count(sep);
+	for (int i = 0; i < pathGroups; ++i) {
+		index = filename.indexOf(sep, index + 1);
+	}
+
+	// Put extension and drive back
+	filename = filename + (!ext.isEmpty() ? "." + ext : QString());
+	if (!fn.isEmpty()) {
+		filename = filename.right(filename.length() - index - 1);
+	}
+
+	QFileInfo fi(filename);
+	QString suffix = fi.suffix();
+	filename = (fi.path() != "." ? fi.path() + "/" : QString()) + fi.completeBaseName().left(245) + (suffix.isEmpty() ? QString() : "." + fi.suffix());
+
+	return filename;
+}
+
+#ifndef MAX_PATH
+	#define MAX_PATH 260
+#endif
+
+QString fixFilenameWindowsReference(const QString &fn, const QString &path, int maxLength, bool invalidChars)
+{
+	// Fix parameters
+	const QString sep = QStringLiteral("\\");
+	maxLength = maxLength == 0 ? MAX_PATH : maxLength;
+	QString filename = (path + fn).trimmed();
+
+	// Drive
+	QString drive;
+	if (filename.mid(1, 2) == QLatin1String(":\\")) {
+		drive = filename.left(3);
+		filename = filename.right(filename.length() - 3);
+	}
+
+	// Forbidden characters
+	if (invalidChars) {
+		filename.replace('<', '_').replace('>', '_').replace(':', '_').remove('"').replace('/', '_').replace('|', '_').remove('?').replace('*', '_');
+	}
+
+	// Fobidden directories or filenames
+	static const QStringList forbidden { "CON", "PRN", "AUX", "NUL", "COM1", "COM2", "COM3", "COM4", "COM5", "COM6", "COM7", "COM8", "COM9", "LPT1", "LPT2", "LPT3", "LPT4", "LPT5", "LPT6", "LPT7", "LPT8", "LPT9" };
+
+	// Divide filename
+	QStringList parts = filename.split(sep);
+	QString file, ext;
+	if (!fn.isEmpty()) {
+		file = parts.takeLast();
+		const int lastDot = file.lastIndexOf('.');
+		if (lastDot != -1) {
+			ext = file.right(file.length() - lastDot - 1);
+			file = file.left(lastDot);
+		}
+	}
+
+	// Fix directories
+	for (QString &part : parts) {
+		// A part cannot be one in the forbidden list
+		if (invalidChars && forbidden.contains(part, Qt::CaseInsensitive)) {
+			part = part + "!";
+		}
+
+		// A part cannot finish by a period
+		while (invalidChars && part.endsWith('.')) {
+			part = part.left(part.length() - 1).trimmed();
+		}
+
+		// A part cannot start or finish with a space
+		part = part.trimmed();
+
+		// A part should still allow creating a file
+		if (part.length() > maxLength - 12) {
+			part = part.left(qMax(0, maxLength - 12)).trimmed();
+		}
+	}
+
+	// Join parts back
+	QString dirpart = parts.join(sep);
+	if (dirpart.length() > maxLength - 12) {
+		dirpart = dirpart.left(qMax(0, maxLength - 12)).trimmed();
+	}
+	filename = (dirpart.isEmpty() ? QString() : dirpart + (!fn.isEmpty() ? sep : QString())) + file;
+
+	// A filename cannot exceed MAX_PATH (-1 for <NUL> and -3 for drive "C:\")
+	if (filename.length() > maxLength - 1 - 3 - ext.length() - 1) {
+		filename = filename.left(qMax(0, maxLength - 1 - 3 - ext.length() - 1)).trimmed();
+	}
+
+	// Get separation between filename and path
+	int index = -1;
+	const int pathGroups = path.count(sep);
+	for (int i = 0; i < pathGroups - (!drive.isEmpty() ? 1 : 0); ++i) {
+		index = filename.indexOf(sep, index + 1);
+	}
+	index += drive.length();
+
+	// Put extension and drive back
+	filename = drive + filename + (!ext.isEmpty() ? "." + ext : QString());
+	if (!fn.isEmpty()) {
+		filename = filename.right(filename.length() - index - 1);
+	}
+
+	return filename;
+}
@@ -0,0 +1,15 @@
+#ifndef FIX_FILENAME_REFERENCE_H
+#define FIX_FILENAME_REFERENCE_H
+
+#include <QString>
+
+
+/**
+ * Previous implementations of fixFilenameWindows() and fixFilenameLinux(), doing one pass per replaced character
+ * and converting each path component to UTF-8. They are only kept to compare both the speed and the results of the
+ * current implementations against them.
+ */
+QString fixFilenameWindowsReference(const QString &fn, const QString &path, int maxLength, bool invalidChars = true);
+QString fixFilenameLinuxReference(const QString &fn, const QString &path, int maxLength);
+
+#endif // FIX_FILENAME_REFERENCE_H
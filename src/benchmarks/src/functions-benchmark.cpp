@@ -0,0 +1,201 @@
+#include "functions-benchmark.h"
+#include <QTemporaryDir>
+#include <QtTest>
+#include "fix-filename-reference.h"
+#include "functions.h"
+#include "utils/md5-multi-buffer.h"
+
+#define PATH_COUNT 1000
+#define PATH_REPEAT 1000
+#define MD5_FILE_COUNT 2000
+
+
+/**
+ * Generate a varied set of filenames: plain, with invalid characters, reserved names, non-ASCII and long ones.
+ */
+static QStringList samplePaths(const QString &sep)
+{
+	static const QStringList words {
+		"artist1", "1girl", "long_hair", "copyright: \"name\"", "<tag>", "what?", "a|b", "star*", "CON", "lpt1",
+		"trailing.", " spaced ", "日本語", "émoji 😀", "tag", "x",
+	};
+
+	QStringList ret;
+	ret.reserve(PATH_COUNT);
+	for (int i = 0; i < PATH_COUNT; ++i) {
+		QStringList parts;
+		const int partCount = 1 + i % 4;
+		for (int p = 0; p < partCount; ++p) {
+			QString part = words[(i * 7 + p * 3) % words.count()];
+			if ((i + p) % 13 == 0) {
+				part = part.repeated(40);
+			}
+			parts.append(part + " " + QString::number(i));
+		}
+		ret.append(parts.join(sep) + (i % 5 == 0 ? ".jpeg" : ".jpg"));
+	}
+	return ret;
+}
+
+
+void FunctionsBenchmark::fixFilenameWindows_data()
+{
+	QTest::addColumn<QString>("filename");
+	QTest::addColumn<QString>("path");
+	QTest::addColumn<int>("maxLength");
+
+	QTest::newRow("short") << "artist1 - 7331.jpg" << "C:\\Users\\test\\Pictures\\" << 0;
+	QTest::newRow("invalid chars") << "copyright1: \"character1\" <artist1> | 7331?.jpg" << "C:\\Users\\test\\Pictures\\" << 0;
+	QTest::newRow("directories") << "copyright1\\character1\\artist1\\1girl long_hair blush smile  .jpg" << "C:\\Users\\test\\Pictures\\" << 0;
+	QTest::newRow("capped") << QString("tag ").repeated(100) + ".jpg" << "C:\\Users\\test\\Pictures\\" << 259;
+}
+
+void FunctionsBenchmark::fixFilenameWindows()
+{
+	QFETCH(QString, filename);
+	QFETCH(QString, path);
+	QFETCH(int, maxLength);
+
+	QString result;
+	QBENCHMARK {
+		result = ::fixFilenameWindows(filename, path, maxLength);
+	}
+	QVERIFY(!result.isEmpty());
+}
+
+void FunctionsBenchmark::fixFilenameLinux_data()
+{
+	QTest::addColumn<QString>("filename");
+	QTest::addColumn<QString>("path");
+	QTest::addColumn<int>("maxLength");
+
+	QTest::newRow("short") << "artist1 - 7331.jpg" << "/home/test/Pictures/" << 0;
+	QTest::newRow("directories") << "copyright1/character1/artist1/1girl long_hair blush smile  .jpg" << "/home/test/Pictures/" << 0;
+	QTest::newRow("capped") << QString("tag ").repeated(100) + ".jpg" << "/home/test/Pictures/" << 255;
+}
+
+void FunctionsBenchmark::fixFilenameLinux()
+{
+	QFETCH(QString, filename);
+	QFETCH(QString, path);
+	QFETCH(int, maxLength);
+
+	QString result;
+	QBENCHMARK {
+		result = ::fixFilenameLinux(filename, path, maxLength);
+	}
+	QVERIFY(!result.isEmpty());
+}
+
+void FunctionsBenchmark::fixFilenameMillion_data()
+{
+	QTest::addColumn<bool>("windows");
+	QTest::addColumn<bool>("reference");
+
+	QTest::newRow("windows") << true << false;
+	QTest::newRow("windows (reference)") << true << true;
+	QTest::newRow("linux") << false << false;
+	QTest::newRow("linux (reference)") << false << true;
+}
+
+void FunctionsBenchmark::fixFilenameMillion()
+{
+	QFETCH(bool, windows);
+	QFETCH(bool, reference);
+
+	const QString path = windows ? "C:\\Users\\test\\Pictures\\" : "/home/test/Pictures/";
+	const QStringList filenames = samplePaths(windows ? "\\" : "/");
+
+	int total = 0;
+	QBENCHMARK_ONCE {
+		for (int i = 0; i < PATH_REPEAT; ++i) {
+			for (const QString &filename : filenames) {
+				const QString result = windows
+					? (reference ? fixFilenameWindowsReference(filename, path, 0) : ::fixFilenameWindows(filename, path, 0))
+					: (reference ? fixFilenameLinuxReference(filename, path, 0) : ::fixFilenameLinux(filename, path, 0));
+				total += result.length();
+			}
+		}
+	}
+	QVERIFY(total > 0);
+}
+
+void FunctionsBenchmark::fixFilenameSameResults()
+{
+	for (int maxLength : { 0, 50, 255 }) {
+		for (const QString &filename : samplePaths("\\")) {
+			QCOMPARE(::fixFilenameWindows(filename, "C:\\Users\\test\\", maxLength), fixFilenameWindowsReference(filename, "C:\\Users\\test\\", maxLength));
+			QCOMPARE(::fixFilenameWindows(filename, "", maxLength, false), fixFilenameWindowsReference(filename, "", maxLength, false));
+		}
+		for (const QString &filename : samplePaths("/")) {
+			QCOMPARE(::fixFilenameLinux(filename, "/home/test/", maxLength), fixFilenameLinuxReference(filename, "/home/test/", maxLength));
+		}
+	}
+}
+
+void FunctionsBenchmark::decodeHtmlEntities_data()
+{
+	QTest::addColumn<QString>("html");
+
+	QTest::newRow("no entities") << "1girl long_hair blush smile";
+	QTest::newRow("entities") << "Pok&eacute;mon &amp; Friends &#8211; &quot;title&quot;";
+}
+
+void FunctionsBenchmark::decodeHtmlEntities()
+{
+	QFETCH(QString, html);
+
+	QString result;
+	QBENCHMARK {
+		result = ::decodeHtmlEntities(html);
+	}
+	QVERIFY(!result.isEmpty());
+}
+
+void FunctionsBenchmark::fileMd5_data()
+{
+	QTest::addColumn<int>("fileSize");
+	QTest::addColumn<bool>("multiBuffer");
+
+	for (int fileSize : { 4 * 1024, 200 * 1024 }) {
+		QTest::newRow(qPrintable(QString("%1 KB").arg(fileSize / 1024))) << fileSize << false;
+		QTest::newRow(qPrintable(QString("%1 KB (multi-buffer)").arg(fileSize / 1024))) << fileSize << true;
+	}
+}
+
+/**
+ * Hashing many small files from a single thread, like each worker of the MD5 fix tool does.
+ */
+void FunctionsBenchmark::fileMd5()
+{
+	QFETCH(int, fileSize);
+	QFETCH(bool, multiBuffer);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	QStringList paths;
+	for (int i = 0; i < MD5_FILE_COUNT; ++i) {
+		const QString path = dir.filePath(QString::number(i) + ".bin");
+		QFile file(path);
+		QVERIFY(file.open(QFile::WriteOnly));
+		file.write(QByteArray(fileSize + i % 100, static_cast<char>(i)));
+		paths.append(path);
+	}
+
+	QStringList md5s;
+	QBENCHMARK {
+		if (multiBuffer) {
+			md5s.clear();
+			for (int i = 0; i < paths.count(); i += Md5MultiBuffer::Lanes) {
+				md5s.append(Md5MultiBuffer::hashFiles(paths.mid(i, Md5MultiBuffer::Lanes)));
+			}
+		} else {
+			md5s.clear();
+			for (const QString &path : paths) {
+				md5s.append(getFileMd5(path));
+			}
+		}
+	}
+	QCOMPARE(md5s.count(), paths.count());
+	QCOMPARE(md5s.last(), getFileMd5(paths.last()));
+}
@@ -0,0 +1,25 @@
+#ifndef FUNCTIONS_BENCHMARK_H
+#define FUNCTIONS_BENCHMARK_H
+
+#include <QObject>
+
+
+class FunctionsBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void fixFilenameWindows_data();
+		void fixFilenameWindows();
+		void fixFilenameLinux_data();
+		void fixFilenameLinux();
+		void fixFilenameMillion_data();
+		void fixFilenameMillion();
+		void fixFilenameSameResults();
+		void decodeHtmlEntities_data();
+		void decodeHtmlEntities();
+		void fileMd5_data();
+		void fileMd5();
+};
+
+#endif // FUNCTIONS_BENCHMARK_H
@@ -0,0 +1,49 @@
+#include "image-factory-benchmark.h"
+#include <QtTest>
+#include "benchmark-helpers.h"
+#include "models/image.h"
+#include "models/image-factory.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "source-helpers.h"
+
+
+void ImageFactoryBenchmark::initTestCase()
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	m_profile = makeProfile();
+
+	m_site = m_profile->getSites().value("danbooru.donmai.us");
+	QVERIFY(m_site != nullptr);
+}
+
+void ImageFactoryBenchmark::cleanupTestCase()
+{
+	delete m_profile;
+}
+
+void ImageFactoryBenchmark::build()
+{
+	const QMap<QString, QString> details = sampleDetails();
+
+	QSharedPointer<Image> image;
+	QBENCHMARK {
+		image = ImageFactory::build(m_site, details, m_profile);
+	}
+	QVERIFY(!image.isNull());
+}
+
+/**
+ * Building an image and computing its tokens, as done for each image of a page when filtering its results.
+ */
+void ImageFactoryBenchmark::buildWithTokens()
+{
+	const QMap<QString, QString> details = sampleDetails();
+
+	QBENCHMARK {
+		QSharedPointer<Image> image = ImageFactory::build(m_site, details, m_profile);
+		image->tokens(m_profile);
+	}
+}
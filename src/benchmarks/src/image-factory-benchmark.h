@@ -0,0 +1,26 @@
+#ifndef IMAGE_FACTORY_BENCHMARK_H
+#define IMAGE_FACTORY_BENCHMARK_H
+
+#include <QObject>
+
+
+class Profile;
+class Site;
+
+class ImageFactoryBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+
+		void build();
+		void buildWithTokens();
+
+	private:
+		Profile *m_profile = nullptr;
+		Site *m_site = nullptr;
+};
+
+#endif // IMAGE_FACTORY_BENCHMARK_H
@@ -0,0 +1,89 @@
+#include "javascript-parsing-benchmark.h"
+#include <QFile>
+#include <QtTest>
+#include "models/api/api.h"
+#include "models/page.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "source-helpers.h"
+
+
+/**
+ * Sources and sites having recorded result pages in the test resources.
+ */
+static const QList<QPair<QString, QString>> sites {
+	{ "Danbooru (2.0)", "danbooru.donmai.us" },
+	{ "Gelbooru (0.2)", "gelbooru.com" },
+	{ "E621", "e621.net" },
+	{ "Philomena", "derpibooru.org" },
+};
+
+
+void JavascriptParsingBenchmark::initTestCase()
+{
+	for (const auto &site : sites) {
+		setupSource(site.first);
+		setupSite(site.first, site.second);
+	}
+
+	m_profile = makeProfile();
+}
+
+void JavascriptParsingBenchmark::cleanupTestCase()
+{
+	delete m_profile;
+}
+
+void JavascriptParsingBenchmark::parsePage_data()
+{
+	QTest::addColumn<QString>("site");
+	QTest::addColumn<QString>("api");
+	QTest::addColumn<QString>("file");
+
+	const QList<QPair<QString, QString>> apis {
+		{ "Xml", "results.xml" },
+		{ "Json", "results.json" },
+		{ "Html", "results.html" },
+	};
+	for (const auto &site : sites) {
+		for (const auto &api : apis) {
+			const QString file = "tests/resources/pages/" + site.second + "/" + api.second;
+			if (QFile::exists(file)) {
+				QTest::newRow(qPrintable(site.second + " " + api.first)) << site.second << api.first << file;
+			}
+		}
+	}
+}
+
+void JavascriptParsingBenchmark::parsePage()
+{
+	QFETCH(QString, site);
+	QFETCH(QString, api);
+	QFETCH(QString, file);
+
+	Site *s = m_profile->getSites().value(site);
+	QVERIFY(s != nullptr);
+
+	Api *a = nullptr;
+	for (Api *siteApi : s->getApis()) {
+		if (siteApi->getName() == api) {
+			a = siteApi;
+		}
+	}
+	if (a == nullptr) {
+		QSKIP("API not available for this site");
+	}
+
+	QFile f(file);
+	QVERIFY(f.open(QFile::ReadOnly));
+	const QByteArray source = f.readAll();
+
+	Page page(m_profile, s, QList<Site*>() << s, QStringList() << "test");
+
+	ParsedPage parsed;
+	QBENCHMARK {
+		parsed = a->parsePage(&page, source, 200, 0);
+	}
+	QVERIFY(parsed.error.isEmpty());
+	QVERIFY(!parsed.images.isEmpty());
+}
@@ -0,0 +1,24 @@
+#ifndef JAVASCRIPT_PARSING_BENCHMARK_H
+#define JAVASCRIPT_PARSING_BENCHMARK_H
+
+#include <QObject>
+
+
+class Profile;
+
+class JavascriptParsingBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+		void cleanupTestCase();
+
+		void parsePage_data();
+		void parsePage();
+
+	private:
+		Profile *m_profile = nullptr;
+};
+
+#endif // JAVASCRIPT_PARSING_BENCHMARK_H
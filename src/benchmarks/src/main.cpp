@@ -0,0 +1,69 @@
+#include <QApplication>
+#include <QDir>
+#include <QStringList>
+#include <QtTest>
+#include "filename-benchmark.h"
+#include "filtering-benchmark.h"
+#include "functions.h"
+#include "functions-benchmark.h"
+#include "image-factory-benchmark.h"
+#include "javascript-parsing-benchmark.h"
+#include "md5-database-benchmark.h"
+#include "network-manager-benchmark.h"
+#include "tag-database-benchmark.h"
+
+
+/**
+ * Run a benchmark class, writing its results to its own file in the output directory if there is one.
+ */
+static int run(QObject *benchmark, const QStringList &args, const QString &outputDir, const QString &format)
+{
+	QStringList benchmarkArgs = args;
+	if (!outputDir.isEmpty()) {
+		const QString ext = format == "junitxml" || format == "lightxml" ? "xml" : format;
+		const QString file = QDir(outputDir).filePath(QString(benchmark->metaObject()->className()) + "." + ext);
+		benchmarkArgs << "-o" << file + "," + format;
+	}
+
+	const int ret = QTest::qExec(benchmark, benchmarkArgs);
+	delete benchmark;
+	return ret;
+}
+
+int main(int argc, char* argv[])
+{
+	QApplication app(argc, argv);
+
+	// Used for networking and finding test resource files
+	setTestModeEnabled(true);
+
+	// Extract our own options, passing all the others to QtTest
+	QStringList args;
+	QString outputDir;
+	QString format = "xml";
+	const QStringList appArgs = app.arguments();
+	for (int i = 0; i < appArgs.count(); ++i) {
+		const QString &arg = appArgs[i];
+		if (arg == "--output" && i + 1 < appArgs.count()) {
+			outputDir = appArgs[++i];
+		} else if (arg == "--format" && i + 1 < appArgs.count()) {
+			format = appArgs[++i];
+		} else {
+			args.append(arg);
+		}
+	}
+	if (!outputDir.isEmpty()) {
+		QDir().mkpath(outputDir);
+	}
+
+	int ret = 0;
+	ret |= run(new FunctionsBenchmark(), args, outputDir, format);
+	ret |= run(new FilenameBenchmark(), args, outputDir, format);
+	ret |= run(new FilteringBenchmark(), args, outputDir, format);
+	ret |= run(new ImageFactoryBenchmark(), args, outputDir, format);
+	ret |= run(new TagDatabaseBenchmark(), args, outputDir, format);
+	ret |= run(new Md5DatabaseBenchmark(), args, outputDir, format);
+	ret |= run(new JavascriptParsingBenchmark(), args, outputDir, format);
+	ret |= run(new NetworkManagerBenchmark(), args, outputDir, format);
+	return ret;
+}
@@ -0,0 +1,114 @@
+#include "md5-database-benchmark.h"
+#include <QCryptographicHash>
+#include <QList>
+#include <QPair>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "models/md5-database/md5-database-binary.h"
+#include "models/md5-database/md5-database-sqlite.h"
+#include "models/md5-database/md5-database-text.h"
+
+
+static QString md5(int i)
+{
+	return QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Md5).toHex();
+}
+
+static Md5Database *makeDatabase(const QString &backend, const QString &dir, QSettings *settings)
+{
+	if (backend == "sqlite") {
+		return new Md5DatabaseSqlite(dir + "/md5s.sqlite", settings);
+	}
+	if (backend == "binary") {
+		return new Md5DatabaseBinary(dir + "/md5s.bin", settings);
+	}
+	return new Md5DatabaseText(dir + "/md5s.txt", settings);
+}
+
+static void addBackendRows(const QList<int> &sizes)
+{
+	QTest::addColumn<QString>("backend");
+	QTest::addColumn<int>("size");
+
+	for (const QString &backend : { QString("text"), QString("binary"), QString("sqlite") }) {
+		for (int size : sizes) {
+			QTest::newRow(qPrintable(QString("%1 %2").arg(backend).arg(size))) << backend << size;
+		}
+	}
+}
+
+static void fill(Md5Database *database, int size)
+{
+	QList<QPair<QString, QString>> md5s;
+	md5s.reserve(size);
+	for (int i = 0; i < size; ++i) {
+		md5s.append(QPair<QString, QString>(md5(i), QString("/home/test/Pictures/%1.jpg").arg(i)));
+	}
+	database->addAll(md5s);
+	database->sync();
+}
+
+
+void Md5DatabaseBenchmark::exists_data()
+{
+	addBackendRows({ 1000, 100000 });
+}
+
+/**
+ * Checking whether images were already downloaded, half of them being in the database.
+ */
+void Md5DatabaseBenchmark::exists()
+{
+	QFETCH(QString, backend);
+	QFETCH(int, size);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	QSettings settings(dir.filePath("settings.ini"), QSettings::IniFormat);
+	settings.setValue("Save/keepDeletedMd5", true); // The files don't exist, but we only want to measure the lookup
+
+	QScopedPointer<Md5Database> database(makeDatabase(backend, dir.path(), &settings));
+	fill(database.data(), size);
+
+	int found = 0;
+	QBENCHMARK {
+		found = 0;
+		for (int i = 0; i < 100; ++i) {
+			if (!database->exists(md5(i % 2 == 0 ? i * (size / 100) : size + i)).isEmpty()) {
+				found++;
+			}
+		}
+	}
+	QCOMPARE(found, 50);
+}
+
+void Md5DatabaseBenchmark::add_data()
+{
+	addBackendRows({ 0, 100000 });
+}
+
+/**
+ * Adding the MD5 of a page of downloaded images to an existing database.
+ */
+void Md5DatabaseBenchmark::add()
+{
+	QFETCH(QString, backend);
+	QFETCH(int, size);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	QSettings settings(dir.filePath("settings.ini"), QSettings::IniFormat);
+
+	QScopedPointer<Md5Database> database(makeDatabase(backend, dir.path(), &settings));
+	fill(database.data(), size);
+
+	int next = size;
+	QBENCHMARK {
+		for (int i = 0; i < 20; ++i, ++next) {
+			database->add(md5(next), QString("/home/test/Pictures/%1.jpg").arg(next));
+		}
+		database->sync();
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef MD5_DATABASE_BENCHMARK_H
+#define MD5_DATABASE_BENCHMARK_H
+
+#include <QObject>
+
+
+class Md5DatabaseBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void exists_data();
+		void exists();
+		void add_data();
+		void add();
+};
+
+#endif // MD5_DATABASE_BENCHMARK_H
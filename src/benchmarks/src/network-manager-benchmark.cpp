@@ -0,0 +1,79 @@
+#include "network-manager-benchmark.h"
+#include <QList>
+#include <QNetworkRequest>
+#include <QSignalSpy>
+#include <QtTest>
+#include "concurrent-multi-queue.h"
+#include "custom-network-access-manager.h"
+#include "network/network-manager.h"
+#include "network/network-reply.h"
+
+
+void NetworkManagerBenchmark::schedule_data()
+{
+	QTest::addColumn<int>("concurrency");
+
+	for (int concurrency : { 1, 6, 32 }) {
+		QTest::newRow(qPrintable(QString::number(concurrency))) << concurrency;
+	}
+}
+
+/**
+ * Scheduling 1000 requests answered instantly, so that the overhead of the manager itself is measured.
+ */
+void NetworkManagerBenchmark::schedule()
+{
+	QFETCH(int, concurrency);
+
+	NetworkManager manager;
+	manager.setMaxConcurrency(concurrency);
+
+	QBENCHMARK {
+		QList<NetworkReply*> replies;
+		for (int i = 0; i < 1000; ++i) {
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+			replies.append(manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/?i=" + QString::number(i))), i % 3));
+		}
+
+		QSignalSpy spy(replies.last(), SIGNAL(finished()));
+		QVERIFY(spy.wait());
+		while (NetworkManager::activeRequests() > 0) {
+			QCoreApplication::processEvents();
+		}
+		qDeleteAll(replies);
+	}
+
+	CustomNetworkAccessManager::NextFiles.clear();
+}
+
+void NetworkManagerBenchmark::multiQueue_data()
+{
+	QTest::addColumn<int>("keys");
+
+	for (int keys : { 1, 10, 100 }) {
+		QTest::newRow(qPrintable(QString::number(keys))) << keys;
+	}
+}
+
+/**
+ * Dequeuing 10000 items spread between keys.
+ */
+void NetworkManagerBenchmark::multiQueue()
+{
+	QFETCH(int, keys);
+
+	QBENCHMARK {
+		ConcurrentMultiQueue queue;
+		queue.setGlobalConcurrency(8);
+		queue.setKeyConcurrency(2);
+		QObject::connect(&queue, &ConcurrentMultiQueue::dequeued, [&queue, keys](const QVariant &item) {
+			queue.next(QString::number(item.toInt() % keys));
+		});
+
+		QSignalSpy spy(&queue, SIGNAL(finished()));
+		for (int i = 0; i < 10000; ++i) {
+			queue.append(i % 3, i, QString::number(i % keys));
+		}
+		QVERIFY(spy.wait());
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef NETWORK_MANAGER_BENCHMARK_H
+#define NETWORK_MANAGER_BENCHMARK_H
+
+#include <QObject>
+
+
+class NetworkManagerBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void schedule_data();
+		void schedule();
+		void multiQueue_data();
+		void multiQueue();
+};
+
+#endif // NETWORK_MANAGER_BENCHMARK_H
@@ -0,0 +1,63 @@
+#include "tag-database-benchmark.h"
+#include <QList>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "benchmark-helpers.h"
+#include "tags/tag.h"
+#include "tags/tag-database-in-memory.h"
+#include "tags/tag-database-sqlite.h"
+#include "tags/tag-type.h"
+
+
+void TagDatabaseBenchmark::getTagTypes_data()
+{
+	QTest::addColumn<QString>("backend");
+	QTest::addColumn<int>("size");
+	QTest::addColumn<int>("lookups");
+
+	for (const QString &backend : { QString("memory"), QString("sqlite") }) {
+		QTest::newRow(qPrintable(backend + " 100k, 20 tags")) << backend << 100000 << 20;
+		QTest::newRow(qPrintable(backend + " 100k, 500 tags")) << backend << 100000 << 500;
+		QTest::newRow(qPrintable(backend + " 1M, 20 tags")) << backend << 1000000 << 20;
+	}
+}
+
+/**
+ * Looking up the types of the tags of an image, half of which exist in the database.
+ */
+void TagDatabaseBenchmark::getTagTypes()
+{
+	QFETCH(QString, backend);
+	QFETCH(int, size);
+	QFETCH(int, lookups);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+
+	QScopedPointer<TagDatabase> database(backend == "sqlite"
+		? (TagDatabase*) new TagDatabaseSqlite("tests/resources/tag-types.txt", dir.filePath("tags.db"))
+		: (TagDatabase*) new TagDatabaseInMemory("tests/resources/tag-types.txt", dir.filePath("tags.txt")));
+	QVERIFY(database->open());
+	QVERIFY(database->load());
+
+	const QStringList types { "general", "artist", "copyright", "character" };
+	QList<Tag> tags;
+	tags.reserve(size);
+	for (const QString &name : sampleTags(size)) {
+		tags.append(Tag(name, TagType(types[tags.count() % types.count()])));
+	}
+	database->setTags(tags);
+
+	// Spread the looked up tags over the whole database
+	QStringList search;
+	for (int i = 0; i < lookups; ++i) {
+		search.append(i % 2 == 0 ? QString("tag_%1").arg(static_cast<qint64>(i) * size / lookups) : QString("missing_%1").arg(i));
+	}
+
+	QMap<QString, TagType> result;
+	QBENCHMARK {
+		result = database->getTagTypes(search);
+	}
+	QCOMPARE(result.count(), (lookups + 1) / 2);
+}
@@ -0,0 +1,16 @@
+#ifndef TAG_DATABASE_BENCHMARK_H
+#define TAG_DATABASE_BENCHMARK_H
+
+#include <QObject>
+
+
+class TagDatabaseBenchmark : public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void getTagTypes_data();
+		void getTagTypes();
+};
+
+#endif // TAG_DATABASE_BENCHMARK_H
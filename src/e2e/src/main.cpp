@@ -1,5 +1,6 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -14,9 +15,18 @@
 #include "models/profile.h"
 #include "models/site.h"
 #include "models/source.h"
+#include "network/network-archive.h"
 #include "tags/tag.h"
 
 
+struct Throughput
+{
+	int pages = 0;
+	int images = 0;
+	qint64 elapsed = 0;
+};
+
+
 bool opCompare(const QString &op, int left, int right)
 {
 	if (right == -1) {
@@ -56,12 +66,28 @@ int main(int argc, char *argv[])
 
 	const QCommandLineOption inputOption(QStringList() << "i" << "input", "Input JSON configuration file", "input");
 	const QCommandLineOption outputOption(QStringList() << "o" << "output", "Output JSON result file", "output");
+	const QCommandLineOption recordOption(QStringList() << "record", "Record all responses to the given network archive", "archive");
+	const QCommandLineOption replayOption(QStringList() << "replay", "Replay the responses from the given network archive instead of loading the sites", "archive");
+	const QCommandLineOption iterationsOption(QStringList() << "iterations", "Number of times each page is loaded, to measure the throughput", "count", "1");
 	parser.addOption(inputOption);
 	parser.addOption(outputOption);
+	parser.addOption(recordOption);
+	parser.addOption(replayOption);
+	parser.addOption(iterationsOption);
 	parser.process(app);
 
 	Logger::getInstance().setLogLevel(Logger::Warning);
 
+	// Must be done before loading the profile, as sites don't throttle requests when replaying
+	if (parser.isSet(recordOption) && !NetworkArchive::getInstance().open(parser.value(recordOption), NetworkArchive::Record)) {
+		return 1;
+	}
+	if (parser.isSet(replayOption) && !NetworkArchive::getInstance().open(parser.value(replayOption), NetworkArchive::Replay)) {
+		return 1;
+	}
+	const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+	QMap<QString, Throughput> throughputs;
+
 	QFile f(parser.value(inputOption));
 	if (!f.open(QFile::ReadOnly | QFile::Text)) {
 		return 1;
@@ -139,10 +165,18 @@ int main(int argc, char *argv[])
 
 				auto page = new Page(profile, site, allSites.values(), QStringList() << search, pageI, limit);
 				auto pageApi = new PageApi(page, profile, site, api, search.split(' '), pageI, limit);
-				QEventLoop loop;
-				QObject::connect(pageApi, &PageApi::finishedLoading, &loop, &QEventLoop::quit);
-				QTimer::singleShot(1, pageApi, SLOT(load()));
-				loop.exec();
+				Throughput &throughput = throughputs[sourceName];
+				for (int i = 0; i < iterations; ++i) {
+					QEventLoop loop;
+					QObject::connect(pageApi, &PageApi::finishedLoading, &loop, &QEventLoop::quit);
+					QElapsedTimer timer;
+					timer.start();
+					QTimer::singleShot(0, pageApi, SLOT(load()));
+					loop.exec();
+					throughput.elapsed += timer.nsecsElapsed();
+					throughput.pages++;
+					throughput.images += pageApi->images().count();
+				}
 
 				apiJson["status"] = "ok";
 				QStringList message;
@@ -189,6 +223,26 @@ int main(int argc, char *argv[])
 	}
 
 	profile->setBlacklistedTags(oldBlacklist);
+	NetworkArchive::getInstance().close();
+
+	// Throughput per source, mostly meaningful when replaying as there is no network latency nor throttling
+	QJsonObject performanceJson;
+	for (auto it = throughputs.constBegin(); it != throughputs.constEnd(); ++it) {
+		const Throughput &throughput = it.value();
+		const double seconds = qMax(static_cast<double>(throughput.elapsed) / 1e9, 1e-9);
+		const double pagesPerSecond = throughput.pages / seconds;
+		const double imagesPerSecond = throughput.images / seconds;
+		qDebug() << "#" << "Throughput" << it.key() << ":" << pagesPerSecond << "pages/s," << imagesPerSecond << "images/s";
+
+		performanceJson[it.key()] = QJsonObject {
+			{ "pages", throughput.pages },
+			{ "images", throughput.images },
+			{ "ms", static_cast<double>(throughput.elapsed) / 1e6 },
+			{ "pagesPerSecond", pagesPerSecond },
+			{ "imagesPerSecond", imagesPerSecond },
+		};
+	}
+	allJson["_performance"] = performanceJson;
 
 	QJsonDocument outDoc(allJson);
 	QFile fOut(parser.value(outputOption));
@@ -1,21 +1,20 @@
 #include "async-image-provider.h"
-#include <QNetworkAccessManager>
+#include <QImage>
 #include <QRect>
 #include <QString>
 #include "async-image-response.h"
 #include "functions.h"
 #include "models/profile.h"
 #include "models/site.h"
+#include "utils/thumbnail-cache.h"
 
 
 AsyncImageProvider::AsyncImageProvider(Profile *profile)
-	: m_profile(profile)
+	: m_profile(profile), m_thumbnailCache(profile->thumbnailCache())
 {}
 
 QQuickImageResponse *AsyncImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
-	Q_UNUSED(requestedSize);
-
 	const QStringList parts = id.split("¤", Qt::SkipEmptyParts);
 	const QString siteKey = parts[0];
 	const QString url = parts[1];
@@ -25,14 +24,18 @@ QQuickImageResponse *AsyncImageProvider::requestImageResponse(const QString &id,
 		rect = stringToRect(parts[2]);
 	}
 
-	Site *site = m_profile->getSites().value(siteKey);
-	const auto request = site->makeRequest(site->fixUrl(url), QUrl(), "preview", nullptr, {}, false);
-
-	auto *manager = new QNetworkAccessManager(nullptr);
-	auto *reply = manager->get(request);
+	// Decoded thumbnails are kept in memory already cropped and scaled, so they depend on the requested size too
+	const QString cacheKey = ThumbnailCache::key(siteKey, url);
+	const QString imageKey = QStringLiteral("%1@%2x%3@%4").arg(cacheKey).arg(requestedSize.width()).arg(requestedSize.height()).arg(parts.size() > 2 ? parts[2] : QString());
+	const QImage cached = m_thumbnailCache->image(imageKey);
+	if (!cached.isNull()) {
+		return new AsyncImageResponse(cached, QRect());
+	}
 
-	auto *ret = new AsyncImageResponse(reply, rect);
-	QObject::connect(ret, &AsyncImageResponse::finished, manager, &QNetworkAccessManager::deleteLater);
+	Site *site = m_profile->getSites().value(siteKey);
+	if (site == nullptr) {
+		return new AsyncImageResponse(QImage(), QRect());
+	}
 
-	return ret;
+	return new AsyncImageResponse(site, url, rect, requestedSize, m_thumbnailCache, cacheKey, imageKey);
 }
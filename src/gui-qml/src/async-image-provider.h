@@ -7,6 +7,7 @@
 
 
 class Profile;
+class ThumbnailCache;
 
 class AsyncImageProvider : public QQuickAsyncImageProvider
 {
@@ -16,6 +17,7 @@ class AsyncImageProvider : public QQuickAsyncImageProvider
 
 	private:
 		Profile *m_profile;
+		ThumbnailCache *m_thumbnailCache;
 };
 
 #endif // ASYNC_IMAGE_PROVIDER_H
@@ -1,13 +1,60 @@
 #include "async-image-response.h"
+#include <QBuffer>
 #include <QImage>
-#include <QNetworkReply>
+#include <QImageReader>
 #include <QQuickTextureFactory>
+#include <QtConcurrent>
+#include "models/site.h"
+#include "network/network-reply.h"
+#include "utils/thumbnail-cache.h"
 
 
-AsyncImageResponse::AsyncImageResponse(QNetworkReply *reply, const QRect &rect)
-	: m_reply(reply), m_rect(rect)
+/**
+ * Decode a thumbnail, cropping it to the given rect if any, and directly scaling it down to the requested size.
+ */
+static QImage decodeThumbnail(const QByteArray &data, const QRect &rect, const QSize &requestedSize)
 {
-	connect(m_reply, &QNetworkReply::finished, this, &AsyncImageResponse::replyFinished);
+	QBuffer buffer;
+	buffer.setData(data);
+	buffer.open(QIODevice::ReadOnly);
+	QImageReader reader(&buffer);
+
+	QSize size = reader.size();
+	if (!rect.isNull() && !rect.isEmpty()) {
+		reader.setClipRect(rect);
+		size = rect.size();
+	}
+
+	// A requested size of zero in one dimension means that it depends on the other one
+	if (size.isValid() && (requestedSize.width() > 0 || requestedSize.height() > 0)) {
+		const QSize box(requestedSize.width() > 0 ? requestedSize.width() : size.width(), requestedSize.height() > 0 ? requestedSize.height() : size.height());
+		const QSize scaled = size.scaled(box, Qt::KeepAspectRatio);
+		if (scaled.width() < size.width() || scaled.height() < size.height()) {
+			reader.setScaledSize(scaled);
+		}
+	}
+
+	return reader.read();
+}
+
+
+AsyncImageResponse::AsyncImageResponse(Site *site, QString url, const QRect &rect, const QSize &requestedSize, ThumbnailCache *cache, QString cacheKey, QString imageKey)
+	: m_site(site), m_url(std::move(url)), m_rect(rect), m_requestedSize(requestedSize), m_cache(cache), m_cacheKey(std::move(cacheKey)), m_imageKey(std::move(imageKey)), m_decodeWatcher(this)
+{
+	connect(&m_decodeWatcher, &QFutureWatcher<QImage>::finished, this, &AsyncImageResponse::decoded);
+
+	// Image providers are called from the QML image loading thread, but the network manager lives in the site's one
+	moveToThread(m_site->thread());
+	QMetaObject::invokeMethod(this, &AsyncImageResponse::start, Qt::QueuedConnection);
+}
+
+AsyncImageResponse::AsyncImageResponse(const QImage &image, const QRect &rect)
+	: m_rect(rect)
+{
+	setImage(image);
+
+	// The response must not be finished before being returned by the provider
+	QMetaObject::invokeMethod(this, &AsyncImageResponse::finished, Qt::QueuedConnection);
 }
 
 QQuickTextureFactory *AsyncImageResponse::textureFactory() const
@@ -15,18 +62,86 @@ QQuickTextureFactory *AsyncImageResponse::textureFactory() const
 	return m_texture;
 }
 
+void AsyncImageResponse::cancel()
+{
+	// Can be called from the QML image loading thread, while the reply lives in this object's thread
+	QMetaObject::invokeMethod(this, [this]() {
+		m_cancelled = true;
+		if (m_reply != nullptr && m_reply->isRunning()) {
+			m_reply->abort();
+		}
+	}, Qt::QueuedConnection);
+}
+
+void AsyncImageResponse::setImage(QImage image)
+{
+	if (!m_rect.isNull() && !m_rect.isEmpty()) {
+		image = image.copy(m_rect);
+	}
+
+	m_texture = QQuickTextureFactory::textureFactoryForImage(image);
+}
+
+void AsyncImageResponse::start()
+{
+	// Try the disk cache before the network, reading it on the worker thread too
+	m_fromCache = true;
+	ThumbnailCache *cache = m_cache;
+	const QString key = m_cacheKey;
+	const QRect rect = m_rect;
+	const QSize requestedSize = m_requestedSize;
+	m_decodeWatcher.setFuture(QtConcurrent::run([cache, key, rect, requestedSize]() {
+		const QByteArray data = cache->data(key);
+		return data.isEmpty() ? QImage() : decodeThumbnail(data, rect, requestedSize);
+	}));
+}
+
+void AsyncImageResponse::loadFromNetwork()
+{
+	m_fromCache = false;
+	m_reply = m_site->get(m_site->fixUrl(m_url), Site::QueryType::Thumbnail, QUrl(), "preview");
+	connect(m_reply, &NetworkReply::finished, this, &AsyncImageResponse::replyFinished);
+}
+
 void AsyncImageResponse::replyFinished()
 {
-	if (m_reply->error() == QNetworkReply::NoError) {
-		QImage thumbnail;
-		thumbnail.loadFromData(m_reply->readAll());
+	m_reply->deleteLater();
+	if (m_cancelled || m_reply->error() != NetworkReply::NetworkError::NoError) {
+		m_reply = nullptr;
+		emit finished();
+		return;
+	}
 
-		if (!m_rect.isNull() && !m_rect.isEmpty()) {
-			thumbnail = thumbnail.copy(m_rect);
-		}
+	m_data = m_reply->readAll();
+	m_reply = nullptr;
+	decode(m_data);
+}
+
+void AsyncImageResponse::decode(const QByteArray &data)
+{
+	m_decodeWatcher.setFuture(QtConcurrent::run(decodeThumbnail, data, m_rect, m_requestedSize));
+}
+
+void AsyncImageResponse::decoded()
+{
+	const QImage image = m_decodeWatcher.result();
 
-		m_texture = QQuickTextureFactory::textureFactoryForImage(thumbnail);
+	// Invalid or missing cached thumbnails are loaded again from the network
+	if (image.isNull() && m_fromCache && !m_cancelled) {
+		m_cache->remove(m_cacheKey);
+		loadFromNetwork();
+		return;
 	}
 
+	// Only valid thumbnails are stored in the cache
+	if (!image.isNull()) {
+		m_cache->setImage(m_imageKey, image);
+		if (!m_data.isEmpty()) {
+			m_cache->setData(m_cacheKey, m_data);
+		}
+	}
+	m_data.clear();
+
+	m_texture = QQuickTextureFactory::textureFactoryForImage(image);
 	emit finished();
-};
+}
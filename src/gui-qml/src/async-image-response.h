@@ -1,25 +1,58 @@
 #ifndef ASYNC_IMAGE_RESPONSE_H
 #define ASYNC_IMAGE_RESPONSE_H
 
+#include <QFutureWatcher>
+#include <QImage>
 #include <QQuickImageResponse>
 #include <QRect>
+#include <QSize>
+#include <QString>
 
 
-class QNetworkReply;
+class NetworkReply;
 class QQuickTextureFactory;
+class Site;
+class ThumbnailCache;
 
+/**
+ * Loads a thumbnail for QML, first from the disk cache then from the network.
+ *
+ * The response lives in the site's thread, so that its requests go through the site's network manager, with its
+ * throttling and cookies. Thumbnails are always decoded on a worker thread, directly at the requested size.
+ */
 class AsyncImageResponse : public QQuickImageResponse
 {
+	Q_OBJECT
+
 	public:
-		explicit AsyncImageResponse(QNetworkReply *reply, const QRect &rect);
+		explicit AsyncImageResponse(Site *site, QString url, const QRect &rect, const QSize &requestedSize, ThumbnailCache *cache, QString cacheKey, QString imageKey);
+		explicit AsyncImageResponse(const QImage &image, const QRect &rect);
 		QQuickTextureFactory *textureFactory() const override;
+		void cancel() override;
+
+	protected:
+		void setImage(QImage image);
+		void decode(const QByteArray &data);
+		void loadFromNetwork();
 
 	protected slots:
+		void start();
 		void replyFinished();
+		void decoded();
 
 	private:
-		QNetworkReply *m_reply;
+		Site *m_site = nullptr;
+		QString m_url;
+		NetworkReply *m_reply = nullptr;
 		QRect m_rect;
+		QSize m_requestedSize;
+		ThumbnailCache *m_cache = nullptr;
+		QString m_cacheKey;
+		QString m_imageKey;
+		bool m_fromCache = false;
+		bool m_cancelled = false;
+		QByteArray m_data;
+		QFutureWatcher<QImage> m_decodeWatcher;
 		QQuickTextureFactory *m_texture = nullptr;
 };
 
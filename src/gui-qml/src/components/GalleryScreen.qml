@@ -77,6 +77,7 @@ Page {
 
                 onOpenImage: mainStackView.push(imageScreen, { index: index })
                 onRefresh: galleryLoader.load()
+                onEndReached: if (gSettings.resultsInfiniteScroll.value) galleryLoader.loadNext()
             }
 
             Loading {
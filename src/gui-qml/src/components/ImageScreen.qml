@@ -12,7 +12,7 @@ Page {
 
     property var images
     property int index
-    property var image: images[swipeView.currentIndex]
+    property var image: images.get(swipeView.currentIndex)
 
     property bool hasSample: image.sampleUrl !== image.fileUrl && image.sampleUrl !== image.previewUrl
     property bool showHd: !gSettings.viewer_viewSamples.value
@@ -122,13 +122,13 @@ Page {
                         color: gSettings.imageBackgroundColor.value || "transparent"
 
                         Loader {
-                            active: !modelData.isVideo
+                            active: !model.result.isVideo
                             anchors.fill: parent
 
                             sourceComponent: ColumnLayout {
                                 ImageLoader {
                                     id: loader
-                                    image: modelData.image
+                                    image: model.result.image
                                     size: (showHd || !hasSample ? ImageLoader.Full : ImageLoader.Sample)
                                 }
 
@@ -137,7 +137,7 @@ Page {
                                     Layout.fillWidth: true
                                     Layout.fillHeight: true
                                     source: loader.source
-                                    animated: modelData.isAnimated
+                                    animated: model.result.isAnimated
                                     clip: true
                                 }
 
@@ -150,12 +150,12 @@ Page {
                         }
 
                         Loader {
-                            active: modelData.isVideo
+                            active: model.result.isVideo
                             anchors.fill: parent
 
                             sourceComponent: VideoPlayer {
                                 fillMode: VideoOutput.PreserveAspectFit
-                                source: showHd || !hasSample ? modelData.fileUrl : modelData.sampleUrl
+                                source: showHd || !hasSample ? model.result.fileUrl : model.result.sampleUrl
                                 clip: true
                                 autoPlay: index == swipeView.currentIndex
                             }
@@ -168,7 +168,7 @@ Page {
 
                         Label {
                             anchors.fill: parent
-                            text: (Material.theme == Material.Dark ? modelData.tagsDark : modelData.tags).join("<br/>")
+                            text: (Material.theme == Material.Dark ? model.result.tagsDark : model.result.tags).join("<br/>")
                             textFormat: Text.RichText
 
                             onLinkActivated: {
@@ -178,7 +178,7 @@ Page {
                         }
                     }
 
-                    Component.onCompleted: modelData.loadTags()
+                    Component.onCompleted: model.result.loadTags()
                 }
             }
         }
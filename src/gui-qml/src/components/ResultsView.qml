@@ -8,11 +8,12 @@ import QtQuick.Layouts 1.12
 
 import "../vendor"
 
-ScrollView {
+Item {
     id: root
 
     signal openImage(int index)
     signal refresh()
+    signal endReached()
 
     property var results
     property double thumbnailHeightToWidthRatio: 0
@@ -20,93 +21,162 @@ ScrollView {
     property int thumbnailRadius: 0
     property bool thumbnailPadding: false
     property var thumbnailFillMode: Image.PreserveAspectFit
-
-    contentHeight: resultsLayout.contentHeight
-    clip: true
-    padding: thumbnailPadding
-        ? root.thumbnailSpacing / 2
-        : -root.thumbnailSpacing / 2
+    property int columns: window.width > window.height
+        ? gSettings.resultsColumnCountLandscape.value
+        : gSettings.resultsColumnCountPortrait.value
 
     onThumbnailHeightToWidthRatioChanged: resultsRefresher.restart()
     onThumbnailSpacingChanged: resultsRefresher.restart()
     onThumbnailPaddingChanged: resultsRefresher.restart()
     onThumbnailFillModeChanged: resultsRefresher.restart()
 
-    Flickable {
-        property bool atBeginningStart: false
-        onFlickStarted: {
-            atBeginningStart = atYBeginning
-        }
-        onFlickEnded: {
-            if (atYBeginning && atBeginningStart) {
-                refresh()
+    // Fixed-ratio thumbnails can be virtualized, while the flow layout needs all delegates to place them
+    Loader {
+        id: viewLoader
+        anchors.fill: parent
+        sourceComponent: root.thumbnailHeightToWidthRatio < 0.1 ? flowView : gridView
+    }
+
+    Component {
+        id: thumbnail
+
+        Item {
+            width: GridView.view ? GridView.view.cellWidth : 0
+            height: img.height + root.thumbnailSpacing
+
+            Image {
+                id: img
+                source: "image://async/" + model.siteUrl + "¤" + model.previewUrl + "¤" + model.previewRect
+                fillMode: root.thumbnailFillMode
+                anchors.centerIn: parent
+                width: parent.width - root.thumbnailSpacing
+                height: root.thumbnailHeightToWidthRatio < 0.1
+                    ? img.width * (img.implicitHeight / img.implicitWidth)
+                    : img.width * root.thumbnailHeightToWidthRatio
+
+                onHeightChanged: resultsRefresher.restart()
+
+                layer.enabled: root.thumbnailRadius > 0
+                layer.effect: OpacityMask {
+                    maskSource: Rectangle {
+                        anchors.centerIn: parent
+                        width: img.width
+                        height: img.height
+                        radius: root.thumbnailRadius
+                    }
+                }
+
+                InnerBorder {
+                    visible: model.color.a > 0
+                    color: model.color
+                    size: 3
+                }
+
+                Badge {
+                    visible: !!model.badge
+                    text: model.badge
+                }
+            }
+
+            MouseArea {
+                anchors.fill: parent
+                onClicked: model.isGallery
+                    ? mainStackView.push(galleryScreen, { gallery: model.result.image })
+                    : mainStackView.push(imageScreen, { index: index })
             }
         }
+    }
 
-        ColumnFlow {
-            id: resultsLayout
-
-            anchors.fill: parent
-            columns: window.width > window.height
-                ? gSettings.resultsColumnCountLandscape.value
-                : gSettings.resultsColumnCountPortrait.value
-            model: results
-
-            onColumnsChanged: resultsRefresher.restart()
-
-            delegate: Item {
-                height: img.height + root.thumbnailSpacing
-
-                Image {
-                    id: img
-                    source: "image://async/" + modelData.siteUrl + "¤" + modelData.previewUrl + "¤" + modelData.previewRect
-                    fillMode: root.thumbnailFillMode
-                    anchors.centerIn: parent
-                    width: parent.width - root.thumbnailSpacing
-                    height: root.thumbnailHeightToWidthRatio < 0.1
-                        ? img.width * (img.implicitHeight / img.implicitWidth)
-                        : img.width * root.thumbnailHeightToWidthRatio
-
-                    onHeightChanged: resultsRefresher.restart()
-
-                    layer.enabled: root.thumbnailRadius > 0
-                    layer.effect: OpacityMask {
-                        maskSource: Rectangle {
-                            anchors.centerIn: parent
-                            width: img.width
-                            height: img.height
-                            radius: root.thumbnailRadius
-                        }
-                    }
+    Component {
+        id: flowView
 
-                    InnerBorder {
-                        visible: modelData.color.a > 0
-                        color: modelData.color
-                        size: 3
-                    }
+        ScrollView {
+            function reEvalColumns() {
+                resultsLayout.reEvalColumns()
+            }
+
+            contentHeight: resultsLayout.contentHeight
+            clip: true
+            padding: root.thumbnailPadding
+                ? root.thumbnailSpacing / 2
+                : -root.thumbnailSpacing / 2
 
-                    Badge {
-                        visible: !!modelData.badge
-                        text: modelData.badge
+            Flickable {
+                property bool atBeginningStart: false
+                onFlickStarted: {
+                    atBeginningStart = atYBeginning
+                }
+                onFlickEnded: {
+                    if (atYBeginning && atBeginningStart) {
+                        root.refresh()
                     }
                 }
+                onAtYEndChanged: {
+                    if (atYEnd && contentHeight > height) {
+                        root.endReached()
+                    }
+                }
+
+                ColumnFlow {
+                    id: resultsLayout
 
-                MouseArea {
                     anchors.fill: parent
-                    onClicked: modelData.isGallery
-                        ? mainStackView.push(galleryScreen, { gallery: modelData.image })
-                        : mainStackView.push(imageScreen, { index: index })
+                    columns: root.columns
+                    model: root.results
+                    delegate: thumbnail
+
+                    onColumnsChanged: resultsRefresher.restart()
+                }
+            }
+        }
+    }
+
+    Component {
+        id: gridView
+
+        ScrollView {
+            clip: true
+            padding: root.thumbnailPadding
+                ? root.thumbnailSpacing / 2
+                : -root.thumbnailSpacing / 2
+
+            GridView {
+                property bool atBeginningStart: false
+
+                model: root.results
+                delegate: thumbnail
+                cellWidth: width / Math.max(1, root.columns)
+                cellHeight: (cellWidth - root.thumbnailSpacing) * root.thumbnailHeightToWidthRatio + root.thumbnailSpacing
+                cacheBuffer: cellHeight * 2
+                reuseItems: true
+
+                onFlickStarted: {
+                    atBeginningStart = atYBeginning
+                }
+                onFlickEnded: {
+                    if (atYBeginning && atBeginningStart) {
+                        root.refresh()
+                    }
+                }
+                onAtYEndChanged: {
+                    if (atYEnd && contentHeight > height) {
+                        root.endReached()
+                    }
                 }
             }
         }
+    }
 
-        Timer {
-            id: resultsRefresher
-            interval: 100
-            running: false
-            repeat: false
+    Timer {
+        id: resultsRefresher
+        interval: 100
+        running: false
+        repeat: false
 
-            onTriggered: resultsLayout.reEvalColumns()
+        onTriggered: {
+            if (viewLoader.item && viewLoader.item.reEvalColumns) {
+                viewLoader.item.reEvalColumns()
+            }
         }
     }
 }
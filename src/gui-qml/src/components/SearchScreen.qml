@@ -142,6 +142,7 @@ Page {
 
                 onOpenImage: mainStackView.push(imageScreen, { index: index })
                 onRefresh: load()
+                onEndReached: if (gSettings.resultsInfiniteScroll.value) pageLoader.loadNext()
             }
 
             Loading {
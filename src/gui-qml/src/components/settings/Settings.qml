@@ -49,6 +49,11 @@ Item {
         def: false
         obj: root.obj
     }
+    property Setting resultsInfiniteScroll: Setting {
+        key: "resultsInfiniteScroll"
+        def: false
+        obj: root.obj
+    }
     property Setting save_filename: Setting {
         key: "Save/filename"
         def: "%md5%.%ext%"
@@ -72,6 +72,12 @@ ColumnLayout {
         setting: gSettings.resultsRoundImages
         Layout.fillWidth: true
     }
+    CheckBoxSetting {
+        name: qsTr("Infinite scroll")
+        subtitle: qsTr("Load the next page when reaching the bottom of the results.")
+        setting: gSettings.resultsInfiniteScroll
+        Layout.fillWidth: true
+    }
 
     SettingTitle {
         Layout.fillWidth: true
@@ -6,16 +6,33 @@
 #include "models/image.h"
 #include "models/page.h"
 #include "models/profile.h"
-#include "models/qml-image.h"
 #include "models/site.h"
 
 
 SearchLoader::SearchLoader(QObject *parent)
-	: Loader(parent), m_page(1), m_perPage(20), m_hasPrev(false), m_hasNext(false)
+	: Loader(parent), m_page(1), m_perPage(20), m_results(new QmlImageModel(this)), m_hasPrev(false), m_hasNext(false)
 {}
 
 
 void SearchLoader::search(SearchQuery query)
+{
+	m_query = std::move(query);
+	loadPage(m_page, false);
+}
+
+/**
+ * Load the page following the last one loaded, appending its results instead of replacing them.
+ */
+void SearchLoader::loadNext()
+{
+	if (status() == Status::Loading || !m_hasNext || m_lastPage == nullptr) {
+		return;
+	}
+
+	loadPage(m_lastPage->page() + 1, true);
+}
+
+void SearchLoader::loadPage(int pageNumber, bool append)
 {
 	setStatus(Status::Loading);
 	setError("");
@@ -28,11 +45,14 @@ void SearchLoader::search(SearchQuery query)
 	site->login();
 	loop.exec();
 
-	Page *page = new Page(m_profile, site, m_profile->getSites().values(), std::move(query), m_page, m_perPage, m_postFilter.split(' '), false, this);
+	Page *page = new Page(m_profile, site, m_profile->getSites().values(), m_query, pageNumber, m_perPage, m_postFilter.split(' '), false, this);
+	if (append) {
+		page->setLastPage(m_lastPage);
+	}
+	m_append = append;
 	connect(page, &Page::finishedLoading, this, &SearchLoader::searchFinished);
 	connect(page, &Page::failedLoading, this, &SearchLoader::searchFinished);
 	page->load(false);
-
 }
 
 void SearchLoader::searchFinished(Page *page)
@@ -45,17 +65,24 @@ void SearchLoader::searchFinished(Page *page)
 	const QList<QSharedPointer<Image>> results = page->images();
 	const bool hideBlacklisted = m_profile->getSettings()->value("hideblacklisted", false).toBool();
 
-	m_results.clear();
-	m_results.reserve(results.count());
+	QList<QSharedPointer<Image>> images;
+	images.reserve(results.count());
 	for (const QSharedPointer<Image> &img : results) {
-		if (hideBlacklisted && !m_profile->getBlacklist().match(img->tokens(m_profile)).isEmpty()) {
+		if (hideBlacklisted && m_profile->getBlacklist().matches(img->tokens(m_profile))) {
 			continue;
 		}
-		m_results.append(new QmlImage(img, m_profile, this));
+		images.append(img);
 	}
 
-	m_hasPrev = page->page() > 1;
-	emit hasPrevChanged();
+	// Appended pages keep the existing rows and delegates as they are
+	if (m_append) {
+		m_results->append(images);
+	} else {
+		m_results->reset(images, m_profile);
+		m_hasPrev = page->page() > 1;
+		emit hasPrevChanged();
+	}
+	m_lastPage = page;
 
 	int pageCount = page->pagesCount();
 	int maxPages = page->maxPagesCount();
@@ -65,6 +92,5 @@ void SearchLoader::searchFinished(Page *page)
 	m_hasNext = pageCount > page->page() || page->imagesCount() == -1 || page->pagesCount() == -1 || (page->imagesCount() == 0 && page->pageImageCount() > 0);
 	emit hasNextChanged();
 
-	emit resultsChanged();
 	setStatus(Status::Ready);
 }
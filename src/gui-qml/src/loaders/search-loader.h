@@ -2,14 +2,13 @@
 #define SEARCH_LOADER_H
 
 #include "loader.h"
-#include <QList>
 #include <QString>
+#include "models/qml-image-model.h"
 #include "models/search-query/search-query.h"
 
 
 class Page;
 class Profile;
-class QmlImage;
 
 class SearchLoader : public Loader
 {
@@ -21,7 +20,7 @@ class SearchLoader : public Loader
 	Q_PROPERTY(QString postFilter READ postFilter WRITE setPostFilter NOTIFY postFilterChanged)
 	Q_PROPERTY(Profile * profile READ profile WRITE setProfile NOTIFY profileChanged)
 
-	Q_PROPERTY(QList<QmlImage*> results READ results NOTIFY resultsChanged)
+	Q_PROPERTY(QmlImageModel * results READ results CONSTANT)
 	Q_PROPERTY(bool hasPrev READ hasPrev NOTIFY hasPrevChanged)
 	Q_PROPERTY(bool hasNext READ hasNext NOTIFY hasNextChanged)
 
@@ -43,22 +42,27 @@ class SearchLoader : public Loader
 		Profile *profile() const { return m_profile; }
 		void setProfile(Profile *profile) { m_profile = profile; emit profileChanged(); }
 
-		const QList<QmlImage*> &results() const { return m_results; }
+		QmlImageModel *results() const { return m_results; }
 		bool hasPrev() const { return m_hasPrev; }
 		bool hasNext() const { return m_hasNext; }
 
+	public slots:
+		void loadNext();
+
 	protected slots:
 		void search(SearchQuery query);
 
 	private slots:
 		void searchFinished(Page *page);
 
+	protected:
+		void loadPage(int page, bool append);
+
 	signals:
 		void siteChanged();
 		void pageChanged();
 		void perPageChanged();
 		void postFilterChanged();
-		void resultsChanged();
 		void profileChanged();
 		void hasPrevChanged();
 		void hasNextChanged();
@@ -70,7 +74,11 @@ class SearchLoader : public Loader
 		QString m_postFilter;
 		Profile *m_profile;
 
-		QList<QmlImage*> m_results;
+		SearchQuery m_query;
+		Page *m_lastPage = nullptr;
+		bool m_append = false;
+
+		QmlImageModel *m_results;
 		bool m_hasPrev;
 		bool m_hasNext;
 };
@@ -23,7 +23,7 @@
 MainScreen::MainScreen(Profile *profile, ShareUtils *shareUtils, QObject *parent)
 	: QObject(parent), m_profile(profile), m_shareUtils(shareUtils)
 {
-	connect(&Logger::getInstance(), &Logger::newLog, this, &MainScreen::newLog);
+	connect(&Logger::getInstance(), &Logger::newLogs, this, &MainScreen::newLogs);
 	logSystemInformation(m_profile);
 
 	refreshSites();
@@ -64,12 +64,14 @@ void MainScreen::refreshFavorites()
 	emit favoritesChanged();
 }
 
-void MainScreen::newLog(const QString &message)
+void MainScreen::newLogs(const QStringList &messages)
 {
-	if (!m_log.isEmpty()) {
-		m_log += "<br/>";
+	for (const QString &message : messages) {
+		if (!m_log.isEmpty()) {
+			m_log += "<br/>";
+		}
+		m_log += logToHtml(message);
 	}
-	m_log += logToHtml(message);
 
 	emit logChanged();
 }
@@ -168,16 +170,7 @@ void MainScreen::loadSuggestions(const QString &prefix, int limit)
 		return;
 	}
 
-	// Get the first element for which the comparison "elt < prefix" is wrong
-	const auto &cmp = m_profile->getAutoComplete();
-	auto it = std::lower_bound(cmp.constBegin(), cmp.constEnd(), prefix);
-
-	// Get max $limit results starting with the prefix
-	while (it != cmp.constEnd() && it->startsWith(prefix) && m_autoComplete.count() < limit) {
-		m_autoComplete.append(*it);
-		++it;
-	}
-
+	m_autoComplete = m_profile->getAutoCompleteIndex().complete(prefix, limit);
 	emit autoCompleteChanged();
 }
 
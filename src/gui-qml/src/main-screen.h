@@ -37,7 +37,7 @@ class MainScreen : public QObject
 		Profile *profile() const { return m_profile; }
 
 	public slots:
-		void newLog(const QString &message);
+		void newLogs(const QStringList &messages);
 		void downloadImage(const QSharedPointer<Image> &image);
 		void shareImage(const QSharedPointer<Image> &image);
 		QString addSite(const QString &type, const QString &host, bool https);
@@ -16,6 +16,7 @@
 #include "models/qml-auth.h"
 #include "models/qml-auth-setting-field.h"
 #include "models/qml-image.h"
+#include "models/qml-image-model.h"
 #include "models/qml-site.h"
 #include "settings.h"
 #include "share/share-utils.h"
@@ -64,7 +65,7 @@ int main(int argc, char *argv[])
 	qRegisterMetaType<Profile*>("Profile*");
 	qRegisterMetaType<Settings*>("Settings*");
 	qRegisterMetaType<QmlImage*>("QmlImage*");
-	qRegisterMetaType<QList<QmlImage*>>("QList>QmlImage*>");
+	qRegisterMetaType<QmlImageModel*>("QmlImageModel*");
 	qRegisterMetaType<QmlSite*>("QmlSite*");
 	qRegisterMetaType<QList<QmlSite*>>("QList<QmlSite*>");
 	qRegisterMetaType<QList<QmlAuth*>>("QList<QmlAuth*>");
@@ -0,0 +1,123 @@
+#include "models/qml-image-model.h"
+#include <QColor>
+#include <QModelIndex>
+#include <QVariant>
+#include "functions.h"
+#include "models/image.h"
+#include "models/qml-image.h"
+#include "models/site.h"
+
+
+QmlImageModel::QmlImageModel(QObject *parent)
+	: QAbstractListModel(parent)
+{}
+
+
+int QmlImageModel::count() const
+{
+	return m_images.count();
+}
+
+int QmlImageModel::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid()) {
+		return 0;
+	}
+	return m_images.count();
+}
+
+QVariant QmlImageModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_images.count()) {
+		return {};
+	}
+
+	const QSharedPointer<Image> &img = m_images[index.row()];
+	switch (role)
+	{
+		case ResultRole:
+			return QVariant::fromValue(get(index.row()));
+
+		case PreviewUrlRole:
+			return img->url(Image::Size::Thumbnail).toString();
+
+		case PreviewRectRole:
+			return rectToString(img->rect(Image::Size::Thumbnail));
+
+		case SiteUrlRole:
+			return img->parentSite()->url();
+
+		case BadgeRole:
+			return img->counter();
+
+		case ColorRole:
+			return img->color().isValid() ? img->color() : QColor(0, 0, 0, 0);
+
+		case IsGalleryRole:
+			return img->isGallery();
+
+		default:
+			return {};
+	}
+}
+
+QHash<int, QByteArray> QmlImageModel::roleNames() const
+{
+	return {
+		{ ResultRole, "result" },
+		{ PreviewUrlRole, "previewUrl" },
+		{ PreviewRectRole, "previewRect" },
+		{ SiteUrlRole, "siteUrl" },
+		{ BadgeRole, "badge" },
+		{ ColorRole, "color" },
+		{ IsGalleryRole, "isGallery" },
+	};
+}
+
+
+QmlImage *QmlImageModel::get(int row) const
+{
+	if (row < 0 || row >= m_images.count()) {
+		return nullptr;
+	}
+
+	QmlImage *&wrapper = m_wrappers[row];
+	if (wrapper == nullptr) {
+		wrapper = new QmlImage(m_images[row], m_profile, const_cast<QmlImageModel*>(this));
+	}
+	return wrapper;
+}
+
+
+void QmlImageModel::reset(const QList<QSharedPointer<Image>> &images, Profile *profile)
+{
+	beginResetModel();
+
+	// QML may still be using the previous wrappers until the views are updated
+	for (QmlImage *wrapper : qAsConst(m_wrappers)) {
+		if (wrapper != nullptr) {
+			wrapper->deleteLater();
+		}
+	}
+
+	m_profile = profile;
+	m_images = images;
+	m_wrappers.fill(nullptr, images.count());
+
+	endResetModel();
+	emit countChanged();
+}
+
+void QmlImageModel::append(const QList<QSharedPointer<Image>> &images)
+{
+	if (images.isEmpty()) {
+		return;
+	}
+
+	beginInsertRows(QModelIndex(), m_images.count(), m_images.count() + images.count() - 1);
+	m_images.append(images);
+	m_wrappers.resize(m_images.count());
+	endInsertRows();
+
+	emit countChanged();
+}
@@ -0,0 +1,64 @@
+#ifndef QML_IMAGE_MODEL_H
+#define QML_IMAGE_MODEL_H
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+
+class Image;
+class Profile;
+class QmlImage;
+class QModelIndex;
+class QVariant;
+
+/**
+ * List model over the results of a search, exposed to QML views.
+ *
+ * Loading another page only appends its rows, so that endless scrolling doesn't rebuild the existing delegates.
+ * Thumbnails only need a few cheap roles, the full QmlImage wrapper of a result only being created the first time a
+ * view asks for it (when it is opened in the viewer for example).
+ */
+class QmlImageModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+	public:
+		enum Role
+		{
+			ResultRole = Qt::UserRole,
+			PreviewUrlRole,
+			PreviewRectRole,
+			SiteUrlRole,
+			BadgeRole,
+			ColorRole,
+			IsGalleryRole,
+		};
+
+		explicit QmlImageModel(QObject *parent = nullptr);
+
+		int count() const;
+		int rowCount(const QModelIndex &parent = {}) const override;
+		QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+		QHash<int, QByteArray> roleNames() const override;
+
+		Q_INVOKABLE QmlImage *get(int row) const;
+
+		void reset(const QList<QSharedPointer<Image>> &images, Profile *profile);
+		void append(const QList<QSharedPointer<Image>> &images);
+
+	signals:
+		void countChanged();
+
+	private:
+		Profile *m_profile = nullptr;
+		QList<QSharedPointer<Image>> m_images;
+		mutable QVector<QmlImage*> m_wrappers; // Created on demand
+};
+
+#endif // QML_IMAGE_MODEL_H
@@ -8,6 +8,7 @@
 #include <utility>
 #include "functions.h"
 #include "models/image.h"
+#include "models/profile.h"
 #include "models/site.h"
 #include "tags/tag-stylist.h"
 
@@ -46,8 +47,8 @@ class QmlImage : public QObject
 		QString sampleUrl() const { return m_image->url(Image::Size::Sample).toString(); }
 		QString fileUrl() const { return m_image->url(Image::Size::Full).toString(); }
 		QString siteUrl() const { return m_image->parentSite()->url(); }
-		QStringList tags() const { return TagStylist(m_profile).stylished(m_image->tags(), true, false, "type", false); }
-		QStringList tagsDark() const { return TagStylist(m_profile).stylished(m_image->tags(), true, false, "type", true); }
+		QStringList tags() const { return m_profile->tagStylist()->stylished(m_image->tags(), true, false, "type", false); }
+		QStringList tagsDark() const { return m_profile->tagStylist()->stylished(m_image->tags(), true, false, "type", true); }
 		QString badge() const { return m_image->counter(); }
 		QColor color() const { return m_image->color().isValid() ? m_image->color() : QColor(0, 0, 0, 0); }
 		bool isAnimated() const { return !m_image->isAnimated().isEmpty(); }
@@ -1,5 +1,4 @@
 #include "batch/add-group-window.h"
-#include <QCompleter>
 #include <QSettings>
 #include <QStringList>
 #include <ui_add-group-window.h>
@@ -18,17 +17,13 @@ AddGroupWindow::AddGroupWindow(Site *selected, Profile *profile, QWidget *parent
 	ui->comboSites->addItems(keys);
 	ui->comboSites->setCurrentIndex(keys.indexOf(selected->url()));
 
-	auto *completer = new QCompleter(profile->getAutoComplete(), this);
-	completer->setCaseSensitivity(Qt::CaseInsensitive);
-	completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
-
 	m_lineTags = new TextEdit(profile, this);
-	m_lineTags->setCompleter(completer);
+	m_lineTags->setAutoCompleteIndex(&profile->getAutoCompleteIndex());
 	ui->formLayout->setWidget(1, QFormLayout::FieldRole, m_lineTags);
 	setTabOrder(ui->comboSites, m_lineTags);
 
 	m_linePostFiltering = new TextEdit(profile, this);
-	m_linePostFiltering->setCompleter(completer);
+	m_linePostFiltering->setAutoCompleteIndex(&profile->getAutoCompleteIndex());
 	ui->formLayout->setWidget(5, QFormLayout::FieldRole, m_linePostFiltering);
 	setTabOrder(ui->spinLimit, m_linePostFiltering);
 }
@@ -50,7 +50,7 @@ void TagsDock::refresh()
 	clearLayout(ui->layoutTags);
 
 	QAffiche *taglabel = new QAffiche(QVariant(), 0, QColor(), this);
-	taglabel->setText(TagStylist(m_profile).stylished(m_currentTab->results(), true, true).join("<br/>"));
+	taglabel->setText(m_profile->tagStylist()->stylished(m_currentTab->results(), true, true).join("<br/>"));
 	taglabel->setTextInteractionFlags(Qt::LinksAccessibleByMouse);
 
 	connect(taglabel, SIGNAL(linkActivated(QString)), this, SIGNAL(open(QString)));
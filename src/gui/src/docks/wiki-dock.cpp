@@ -43,5 +43,10 @@ void WikiDock::tabChanged(SearchTab *tab)
 void WikiDock::refresh()
 {
 	static const QString style = "<style>.title { font-weight: bold; } ul { margin-left: -30px; }</style>";
-	ui->labelWiki->setText(style + m_currentTab->wiki());
+
+	// Laying out rich text is costly, so avoid doing it again when switching between tabs with the same wiki
+	const QString html = style + m_currentTab->wiki();
+	if (html != ui->labelWiki->text()) {
+		ui->labelWiki->setText(html);
+	}
 }
@@ -8,9 +8,12 @@
 #include "models/profile.h"
 #include "models/site.h"
 
+#define STATUS_COLUMN 0
+#define PROGRESS_COLUMN 11
+
 
 DownloadGroupTableModel::DownloadGroupTableModel(Profile *profile, QList<DownloadQueryGroup> &downloads, QWidget *parent)
-	: QAbstractTableModel(parent), m_profile(profile), m_downloads(downloads)
+	: QAbstractTableModel(parent), m_profile(profile), m_downloads(downloads), m_statuses(downloads.count(), -1)
 {}
 
 const DownloadQueryGroup &DownloadGroupTableModel::dataForRow(int row)
@@ -57,7 +60,10 @@ QVariant DownloadGroupTableModel::data(const QModelIndex &index, int role) const
 			QIcon(":/images/status/downloading.png"),
 			QIcon(":/images/status/ok.png"),
 		};
-		int status = m_statuses.contains(row) ? m_statuses[row] : (download.progressVal <= 0 ? 0 : (download.progressVal >= download.total ? 2 : 1));
+		int status = this->status(row);
+		if (status < 0) {
+			status = download.progressVal <= 0 ? 0 : (download.progressVal >= download.total ? 2 : 1);
+		}
 		if (status >= s_iconMap.count()) {
 			return {};
 		}
@@ -114,6 +120,7 @@ bool DownloadGroupTableModel::setData(const QModelIndex &index, const QVariant &
 
 	download.progressVal = 0;
 	download.progressFinished = false;
+	download.checkpoint = DownloadQueryGroup::Checkpoint();
 
 	const QString val = value.toString();
 	bool isInt = false;
@@ -180,6 +187,7 @@ bool DownloadGroupTableModel::setData(const QModelIndex &index, const QVariant &
 	}
 
 	emit dataChanged(index, index, { role });
+	progressChanged(index.row());
 	return true;
 }
 
@@ -204,6 +212,7 @@ bool DownloadGroupTableModel::insertRows(int row, int count, const QModelIndex &
 	for (int i = 0; i < count; ++i) {
 		m_downloads.insert(row, DownloadQueryGroup(m_profile->getSettings(), QStringList(), 1, 10, 10, QStringList(), m_profile->getSites().first()));
 	}
+	m_statuses.insert(row, count, -1);
 	endInsertRows();
 	return true;
 }
@@ -215,6 +224,7 @@ bool DownloadGroupTableModel::removeRows(int row, int count, const QModelIndex &
 	for (int i = 0; i < count; ++i) {
 		m_downloads.removeAt(row);
 	}
+	m_statuses.remove(row, count);
 	endRemoveRows();
 	return true;
 }
@@ -228,8 +238,10 @@ bool DownloadGroupTableModel::moveRows(const QModelIndex &sourceParent, int sour
 
 	for (int i = 0; i < count; ++i) {
 		m_downloads.insert(destinationChild + i, m_downloads[sourceRow]);
+		m_statuses.insert(destinationChild + i, m_statuses[sourceRow]);
 		int removeIndex = destinationChild > sourceRow ? sourceRow : sourceRow + 1;
 		m_downloads.removeAt(removeIndex);
+		m_statuses.remove(removeIndex);
 	}
 
 	endMoveRows();
@@ -248,28 +260,41 @@ bool DownloadGroupTableModel::dropMimeData(const QMimeData *data, Qt::DropAction
 }
 
 
-void DownloadGroupTableModel::inserted(int position)
+void DownloadGroupTableModel::inserted(int position, int count)
 {
-	beginInsertRows(QModelIndex(), position, position);
+	beginInsertRows(QModelIndex(), position, position + count - 1);
+	m_statuses.insert(position, count, -1);
 	endInsertRows();
 }
 
-void DownloadGroupTableModel::removed(int position)
+void DownloadGroupTableModel::removed(int position, int count)
 {
-	beginRemoveRows(QModelIndex(), position, position);
+	beginRemoveRows(QModelIndex(), position, position + count - 1);
+	m_statuses.remove(position, count);
 	endRemoveRows();
 }
 
-void DownloadGroupTableModel::changed(int position)
+void DownloadGroupTableModel::changed(int position, int count)
 {
 	auto topLeft = index(position, 0);
-	auto bottomRight = index(position, columnCount() - 1);
+	auto bottomRight = index(position + count - 1, columnCount() - 1);
 	emit dataChanged(topLeft, bottomRight);
 }
 
+void DownloadGroupTableModel::progressChanged(int position)
+{
+	emitColumnChanged(PROGRESS_COLUMN, position, position);
+
+	// Without an explicit status, the icon depends on the progress
+	if (status(position) < 0) {
+		emitColumnChanged(STATUS_COLUMN, position, position, { Qt::DecorationRole });
+	}
+}
+
 void DownloadGroupTableModel::cleared()
 {
 	beginResetModel();
+	m_statuses.fill(-1, m_downloads.count());
 	endResetModel();
 }
 
@@ -280,8 +305,37 @@ bool DownloadGroupTableModel::setStatus(const DownloadQueryGroup &download, int
 		return false;
 	}
 
-	m_statuses[position] = status;
-	changed(position);
-
+	setStatus(position, status);
 	return true;
 }
+
+void DownloadGroupTableModel::setStatus(int position, int status)
+{
+	if (position < 0 || position >= m_statuses.count() || m_statuses[position] == status) {
+		return;
+	}
+
+	m_statuses[position] = static_cast<qint8>(status);
+	emitColumnChanged(STATUS_COLUMN, position, position, { Qt::DecorationRole });
+}
+
+void DownloadGroupTableModel::setStatuses(int status)
+{
+	if (m_statuses.isEmpty()) {
+		return;
+	}
+
+	m_statuses.fill(static_cast<qint8>(status));
+	emitColumnChanged(STATUS_COLUMN, 0, m_statuses.count() - 1, { Qt::DecorationRole });
+}
+
+
+int DownloadGroupTableModel::status(int row) const
+{
+	return row >= 0 && row < m_statuses.count() ? m_statuses[row] : -1;
+}
+
+void DownloadGroupTableModel::emitColumnChanged(int column, int first, int last, const QVector<int> &roles)
+{
+	emit dataChanged(index(first, column), index(last, column), roles);
+}
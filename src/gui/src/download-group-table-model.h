@@ -4,6 +4,7 @@
 #include <QAbstractTableModel>
 #include <QList>
 #include <QMap>
+#include <QVector>
 #include "downloader/download-query-group.h"
 
 
@@ -37,16 +38,23 @@ class DownloadGroupTableModel : public QAbstractTableModel
 
 	public slots:
 		// Handle signals when the underlying data changes
-		void inserted(int position);
-		void removed(int position);
-		void changed(int position);
+		void inserted(int position, int count = 1);
+		void removed(int position, int count = 1);
+		void changed(int position, int count = 1);
+		void progressChanged(int position);
 		void cleared();
 		bool setStatus(const DownloadQueryGroup &download, int status);
+		void setStatus(int position, int status);
+		void setStatuses(int status);
+
+	protected:
+		int status(int row) const;
+		void emitColumnChanged(int column, int first, int last, const QVector<int> &roles = {});
 
 	private:
 		const Profile *m_profile;
 		QList<DownloadQueryGroup> &m_downloads;
-		QMap<int, int> m_statuses;
+		QVector<qint8> m_statuses; // One per row, -1 if the status should be guessed from the progress
 };
 
 #endif // DOWNLOAD_GROUP_TABLE_MODEL_H
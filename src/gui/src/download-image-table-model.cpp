@@ -10,7 +10,7 @@
 
 
 DownloadImageTableModel::DownloadImageTableModel(QList<DownloadQueryImage> &downloads, QObject *parent)
-	: QAbstractTableModel(parent), m_downloads(downloads)
+	: QAbstractTableModel(parent), m_downloads(downloads), m_rows(downloads.count())
 {}
 
 
@@ -41,65 +41,93 @@ QVariant DownloadImageTableModel::headerData(int section, Qt::Orientation orient
 
 QVariant DownloadImageTableModel::data(const QModelIndex &index, int role) const
 {
-	const DownloadQueryImage &download = m_downloads[index.row()];
-	const QSharedPointer<Image> &img = download.image;
-
 	if (role != Qt::DisplayRole) {
 		return {};
 	}
 
+	const DownloadQueryImage &download = m_downloads[index.row()];
+	const QSharedPointer<Image> &img = download.image;
+
 	switch (index.column())
 	{
 		case 0: return QString::number(img->id());
 		case 1: return img->md5();
-		case 2: return img->token<QString>("rating");
-		case 3: return img->tagsString().join(' ');
+		case 2: return row(index.row()).rating;
+		case 3: return row(index.row()).tags;
 		case 4: return img->fileUrl().toString();
-		case 5: return img->createdAt().toString(Qt::ISODate);
-		case 6: return img->search().join(' ');
+		case 5: return row(index.row()).date;
+		case 6: return row(index.row()).search;
 		case 7: return download.site->url();
 		case 8: return download.filename;
 		case 9: return download.path;
+		case 10: return row(index.row()).fileSize;
+		case 11: return row(index.row()).dimensions;
+	}
 
-		case 10: {
-			double size = img->fileSize();
-			const QString unit = getUnit(&size);
-			return size > 0
-				? QStringLiteral("%1 %2").arg(size).arg(unit)
-				: QString();
-		}
+	return {};
+}
 
-		case 11:
-			return img->width() > 0 && img->height() > 0
-				? QStringLiteral("%1 x %2").arg(img->width()).arg(img->height())
-				: QString();
+const DownloadImageTableModel::Row &DownloadImageTableModel::row(int position) const
+{
+	if (m_rows.count() != m_downloads.count()) {
+		m_rows.resize(m_downloads.count());
 	}
 
-	return {};
+	Row &row = m_rows[position];
+	if (row.loaded) {
+		return row;
+	}
+
+	const QSharedPointer<Image> &img = m_downloads[position].image;
+	row.rating = img->token<QString>("rating");
+	row.tags = img->tagsString().join(' ');
+	row.date = img->createdAt().toString(Qt::ISODate);
+	row.search = img->search().join(' ');
+
+	double size = img->fileSize();
+	const QString unit = getUnit(&size);
+	row.fileSize = size > 0
+		? QStringLiteral("%1 %2").arg(size).arg(unit)
+		: QString();
+
+	row.dimensions = img->width() > 0 && img->height() > 0
+		? QStringLiteral("%1 x %2").arg(img->width()).arg(img->height())
+		: QString();
+
+	row.loaded = true;
+	return row;
 }
 
 
-void DownloadImageTableModel::inserted(int position)
+void DownloadImageTableModel::inserted(int position, int count)
 {
-	beginInsertRows(QModelIndex(), position, position);
+	beginInsertRows(QModelIndex(), position, position + count - 1);
+	m_rows.insert(position, count, Row());
 	endInsertRows();
 }
 
-void DownloadImageTableModel::removed(int position)
+void DownloadImageTableModel::removed(int position, int count)
 {
-	beginRemoveRows(QModelIndex(), position, position);
+	beginRemoveRows(QModelIndex(), position, position + count - 1);
+	m_rows.remove(position, count);
 	endRemoveRows();
 }
 
-void DownloadImageTableModel::changed(int position)
+void DownloadImageTableModel::changed(int position, int count)
 {
+	for (int i = position; i < position + count && i < m_rows.count(); ++i) {
+		m_rows[i].loaded = false;
+	}
+
 	auto topLeft = index(position, 0);
-	auto bottomRight = index(position, columnCount() - 1);
+	auto bottomRight = index(position + count - 1, columnCount() - 1);
 	emit dataChanged(topLeft, bottomRight);
 }
 
 void DownloadImageTableModel::cleared()
 {
 	beginResetModel();
+	m_rows.clear();
+	m_rows.resize(m_downloads.count());
 	endResetModel();
 }
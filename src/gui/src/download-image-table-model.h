@@ -3,6 +3,8 @@
 
 #include <QAbstractTableModel>
 #include <QList>
+#include <QString>
+#include <QVector>
 #include "downloader/download-query-image.h"
 
 
@@ -23,13 +25,31 @@ class DownloadImageTableModel : public QAbstractTableModel
 
 	public slots:
 		// Handle signals when the underlying data changes
-		void inserted(int position);
-		void removed(int position);
-		void changed(int position);
+		void inserted(int position, int count = 1);
+		void removed(int position, int count = 1);
+		void changed(int position, int count = 1);
 		void cleared();
 
+	protected:
+		/**
+		 * Display values that are expensive to compute, built the first time a row is shown.
+		 */
+		struct Row
+		{
+			bool loaded = false;
+			QString rating;
+			QString tags;
+			QString date;
+			QString search;
+			QString fileSize;
+			QString dimensions;
+		};
+
+		const Row &row(int position) const;
+
 	private:
 		QList<DownloadQueryImage> &m_downloads;
+		mutable QVector<Row> m_rows;
 };
 
 #endif // DOWNLOAD_IMAGE_TABLE_MODEL_H
@@ -45,6 +45,7 @@
 #include "network/network-reply.h"
 #include "settings/options-window.h"
 #include "settings/start-window.h"
+#include "startup-orchestrator.h"
 #include "tabs/downloads-tab.h"
 #include "tabs/favorites-tab.h"
 #include "tabs/gallery-tab.h"
@@ -52,6 +53,8 @@
 #include "tabs/monitors-tab.h"
 #include "tabs/pool-tab.h"
 #include "tabs/search-tab.h"
+#include "tabs/tab-placeholder.h"
+#include "tabs/tabs-journal.h"
 #include "tabs/tabs-loader.h"
 #include "tabs/tag-tab.h"
 #include "tag-context-menu.h"
@@ -65,6 +68,7 @@
 #include "utils/md5-database-converter/md5-database-converter.h"
 #include "utils/md5-fix/md5-fix.h"
 #include "utils/rename-existing/rename-existing-1.h"
+#include "utils/statistics/statistics-window.h"
 #include "utils/tag-loader/tag-loader.h"
 
 
@@ -77,6 +81,7 @@ void MainWindow::init(const QStringList &args, const QMap<QString, QString> &par
 
 	m_settings = m_profile->getSettings();
 	auto sites = m_profile->getSites();
+	m_tabsJournal = new TabsJournal(m_profile->getPath() + "/tabs.json");
 
 	m_themeLoader = new ThemeLoader(savePath("themes/", true, false), m_settings, this);
 	m_themeLoader->setTheme(m_settings->value("theme", "Default").toString());
@@ -235,6 +240,7 @@ void MainWindow::init(const QStringList &args, const QMap<QString, QString> &par
 	connect(tagsDock, &TagsDock::openInNewTab, this, &MainWindow::loadTagTab);
 	connect(this, &MainWindow::tabChanged, tagsDock, &TagsDock::tabChanged);
 	ui->dockTagsLayout->addWidget(tagsDock);
+	StartupOrchestrator::getInstance().phase("docks");
 
 	// Action on first load
 	if (m_settings->value("firstload", true).toBool()) {
@@ -262,7 +268,15 @@ void MainWindow::init(const QStringList &args, const QMap<QString, QString> &par
 
 	// Download queue
 	const int maxConcurrency = qMax(1, qMin(m_settings->value("Save/simultaneous").toInt(), 10));
-	m_downloadQueue = new DownloadQueue(maxConcurrency, this);
+	const int maxConcurrencyPerSite = qMax(0, m_settings->value("Save/simultaneousPerSite", 0).toInt());
+	m_downloadQueue = new DownloadQueue(maxConcurrency, this, maxConcurrencyPerSite);
+	if (m_settings->value("Save/simultaneousAdaptive", false).toBool()) {
+		const int minConcurrency = m_settings->value("Save/simultaneousAdaptiveMin", 1).toInt();
+		m_downloadQueue->setAdaptiveConcurrency(minConcurrency, maxConcurrencyPerSite > 0 ? maxConcurrencyPerSite : maxConcurrency);
+	}
+	m_downloadQueue->setBandwidthLimit(DownloadQueue::Manual, m_settings->value("Network/bandwidthLimitManual", 0).toLongLong() * 1024);
+	m_downloadQueue->setBandwidthLimit(DownloadQueue::Batch, m_settings->value("Network/bandwidthLimitBatch", 0).toLongLong() * 1024);
+	m_downloadQueue->setBandwidthLimit(DownloadQueue::Background, m_settings->value("Network/bandwidthLimitBackground", 0).toLongLong() * 1024);
 
 	// Tab bar context menu
 	ui->tabWidget->tabBar()->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -283,9 +297,9 @@ void MainWindow::init(const QStringList &args, const QMap<QString, QString> &par
 	connect(ui->actionSaveDownloadsList, &QAction::triggered, m_downloadsTab, &DownloadsTab::saveFile);
 	connect(ui->actionLoadDownloadsList, &QAction::triggered, m_downloadsTab, &DownloadsTab::loadFile);
 
-	// Restore download lists
+	// Restore download lists once the window is shown, as they can be big
 	if (m_restore) {
-		m_downloadsTab->loadLinkList(m_profile->getPath() + "/restore.igl");
+		StartupOrchestrator::getInstance().defer("restore download lists", [this]() { m_downloadsTab->restoreLinkList(); }, StartupOrchestrator::High);
 	}
 
 	// Favorites tab
@@ -343,16 +357,20 @@ void MainWindow::init(const QStringList &args, const QMap<QString, QString> &par
 		m_selectedSites.append(site);
 	}
 
-	// Initial login on selected sources
+	StartupOrchestrator::getInstance().phase("tabs");
+
+	// Initial login on selected sources, then restore the search tabs
 	m_waitForLogin = 0;
-	if (m_selectedSites.isEmpty()) {
-		initialLoginsDone();
-	} else {
-		m_waitForLogin += m_selectedSites.count();
-		for (Site *site : qAsConst(m_selectedSites)) {
-			site->login();
+	StartupOrchestrator::getInstance().defer("restore tabs", [this]() {
+		if (m_selectedSites.isEmpty()) {
+			initialLoginsDone();
+		} else {
+			m_waitForLogin += m_selectedSites.count();
+			for (Site *site : qAsConst(m_selectedSites)) {
+				site->login();
+			}
 		}
-	}
+	}, StartupOrchestrator::High);
 
 	log(QStringLiteral("End of initialization"), Logger::Debug);
 }
@@ -433,6 +451,7 @@ void MainWindow::initialLoginsDone()
 MainWindow::~MainWindow()
 {
 	m_profile->deleteLater();
+	delete m_tabsJournal;
 
 	delete ui;
 	ui = nullptr;
@@ -501,7 +520,7 @@ void MainWindow::addGalleryTab(Site *site, QSharedPointer<Image> gallery, bool b
 	auto *w = new GalleryTab(site, std::move(gallery), m_profile, m_downloadQueue, this);
 	this->addSearchTab(w, background, save, source);
 }
-void MainWindow::addSearchTab(SearchTab *w, bool background, bool save, SearchTab *source)
+void MainWindow::addSearchTab(SearchTab *w, bool background, bool save, SearchTab *source, int position)
 {
 	if (source != nullptr) {
 		w->setSources(source->sources());
@@ -520,9 +539,13 @@ void MainWindow::addSearchTab(SearchTab *w, bool background, bool save, SearchTa
 		title = tr("New tab");
 	}
 
-	int pos = m_loaded ? ui->tabWidget->currentIndex() + (!m_tabs.isEmpty() ? 1 : 0) : m_tabs.count();
+	int pos = position;
+	if (pos < 0) {
+		pos = m_loaded ? ui->tabWidget->currentIndex() + (!m_tabs.isEmpty() ? 1 : 0) : m_tabs.count() + m_tabPlaceholders.count();
+	}
 	int index = ui->tabWidget->insertTab(pos, w, title);
 	m_tabs.append(w);
+	m_tabsJournal->setDirty(w);
 
 	m_tabSelector->updateCounter();
 
@@ -537,17 +560,77 @@ void MainWindow::addSearchTab(SearchTab *w, bool background, bool save, SearchTa
 	}
 
 	if (save) {
-		saveTabs(m_profile->getPath() + "/tabs.json");
+		saveTabs();
 	}
 }
 
-bool MainWindow::saveTabs(const QString &filename)
+void MainWindow::addTabPlaceholder(TabPlaceholder *placeholder)
+{
+	const int index = ui->tabWidget->insertTab(m_tabs.count() + m_tabPlaceholders.count(), placeholder, placeholder->windowTitle());
+	m_tabPlaceholders.append(placeholder);
+	m_tabsJournal->setDirty(placeholder);
+
+	m_tabSelector->updateCounter();
+
+	QPushButton *closeTab = new QPushButton(QIcon(":/images/close.png"), "", this);
+		closeTab->setFlat(true);
+		closeTab->resize(QSize(8, 8));
+		connect(closeTab, &QPushButton::clicked, this, [this, placeholder]() { closeTabPlaceholder(placeholder); });
+		ui->tabWidget->findChild<QTabBar*>()->setTabButton(index, QTabBar::RightSide, closeTab);
+}
+void MainWindow::restoreTabPlaceholder(TabPlaceholder *placeholder)
 {
-	return TabsLoader::save(filename, m_tabs, ui->tabWidget->currentWidget());
+	const int index = ui->tabWidget->indexOf(placeholder);
+	m_tabPlaceholders.removeAll(placeholder);
+
+	// Avoid restoring the neighbour tabs while the tab widget is being changed
+	m_restoringPlaceholder = true;
+	SearchTab *tab = TabsLoader::loadTab(placeholder->info(), m_profile, m_downloadQueue, this, true);
+	if (tab != nullptr) {
+		addSearchTab(tab, false, false, nullptr, index);
+	} else {
+		log(QStringLiteral("Could not restore tab \"%1\"").arg(placeholder->windowTitle()), Logger::Warning);
+	}
+	ui->tabWidget->removeTab(ui->tabWidget->indexOf(placeholder));
+	placeholder->deleteLater();
+	m_restoringPlaceholder = false;
+
+	m_tabSelector->updateCounter();
+	setCurrentTab(ui->tabWidget->currentWidget());
+}
+void MainWindow::closeTabPlaceholder(TabPlaceholder *placeholder)
+{
+	m_closedTabs.push(placeholder->info());
+	if (m_closedTabs.count() > CLOSED_TAB_HISTORY_MAX) {
+		m_closedTabs.removeFirst();
+	}
+	ui->actionRestoreLastClosedTab->setEnabled(true);
+
+	m_tabPlaceholders.removeAll(placeholder);
+	ui->tabWidget->removeTab(ui->tabWidget->indexOf(placeholder));
+	placeholder->deleteLater();
+	m_tabSelector->updateCounter();
+}
+
+bool MainWindow::saveTabs(bool compact)
+{
+	// Tabs are saved in the order they are displayed, placeholders included
+	QList<QWidget*> tabs;
+	for (int i = 0; i < ui->tabWidget->count(); ++i) {
+		QWidget *widget = ui->tabWidget->widget(i);
+		if (m_tabs.contains(qobject_cast<SearchTab*>(widget)) || m_tabPlaceholders.contains(qobject_cast<TabPlaceholder*>(widget))) {
+			tabs.append(widget);
+		}
+	}
+
+	// Only the changes are saved, unless we want to get rid of the journal
+	return compact
+		? m_tabsJournal->compact(tabs, ui->tabWidget->currentWidget())
+		: m_tabsJournal->save(tabs, ui->tabWidget->currentWidget());
 }
 bool MainWindow::loadTabs(const QString &filename)
 {
-	QList<SearchTab*> tabs;
+	QList<QWidget*> tabs;
 	QVariant currentTab;
 
 	if (!TabsLoader::load(filename, tabs, currentTab, m_profile, m_downloadQueue, this)) {
@@ -555,7 +638,14 @@ bool MainWindow::loadTabs(const QString &filename)
 	}
 
 	bool preload = m_settings->value("preloadAllTabs", false).toBool();
-	for (auto tab : qAsConst(tabs)) {
+	for (QWidget *widget : qAsConst(tabs)) {
+		auto *placeholder = qobject_cast<TabPlaceholder*>(widget);
+		if (placeholder != nullptr) {
+			addTabPlaceholder(placeholder);
+			continue;
+		}
+
+		auto *tab = qobject_cast<SearchTab*>(widget);
 		addSearchTab(tab, true, false);
 		if (!preload) {
 			m_tabsWaitingForPreload.append(tab);
@@ -574,10 +664,11 @@ void MainWindow::updateTabTitle(SearchTab *tab)
 		ui->tabWidget->setTabText(index, newText);
 	}
 }
-void MainWindow::updateTabs()
+void MainWindow::updateTabs(SearchTab *tab)
 {
+	m_tabsJournal->setDirty(tab);
 	if (m_loaded) {
-		saveTabs(m_profile->getPath() + "/tabs.json");
+		saveTabs();
 	}
 }
 void MainWindow::tabClosed(SearchTab *tab)
@@ -615,7 +706,7 @@ void MainWindow::currentTabChanged(int tab)
 {
 	Q_UNUSED(tab);
 
-	if (!m_loaded) {
+	if (!m_loaded || m_restoringPlaceholder) {
 		return;
 	}
 
@@ -633,6 +724,13 @@ void MainWindow::setCurrentTab(QWidget *widget)
 		Analytics::getInstance().sendScreenView("Log");
 	}
 
+	// Restored tabs are only built when first shown
+	auto placeholder = qobject_cast<TabPlaceholder*>(widget);
+	if (placeholder != nullptr) {
+		restoreTabPlaceholder(placeholder);
+		return;
+	}
+
 	// Handle "normal" search tabs
 	auto searchTab = qobject_cast<SearchTab*>(widget);
 	if (searchTab != nullptr) {
@@ -741,7 +839,7 @@ void MainWindow::closeEvent(QCloseEvent *e)
 	}
 
 	// Confirm before closing if there is a batch download or multiple tabs
-	if (m_settings->value("confirm_close", true).toBool() && (m_tabs.count() > 1 || m_downloadsTab->isDownloading())) {
+	if (m_settings->value("confirm_close", true).toBool() && (m_tabs.count() + m_tabPlaceholders.count() > 1 || m_downloadsTab->isDownloading())) {
 		QMessageBox msgBox(this);
 		msgBox.setText(tr("Are you sure you want to quit?"));
 		msgBox.setIcon(QMessageBox::Warning);
@@ -769,13 +867,12 @@ void MainWindow::closeEvent(QCloseEvent *e)
 		}
 	}
 
-	// End analytics session
+	// End analytics session, its messages being sent during the next run
 	Analytics::getInstance().endSession();
-	Analytics::getInstance().startSending();
 
 	log(QStringLiteral("Saving..."), Logger::Debug);
-		m_downloadsTab->saveLinkList(m_profile->getPath() + "/restore.igl");
-		saveTabs(m_profile->getPath() + "/tabs.json");
+		m_downloadsTab->saveLinkListDefault();
+		saveTabs(true);
 		m_settings->setValue("state", saveState());
 		m_settings->setValue("geometry", saveGeometry());
 		m_settings->setValue("crashed", false);
@@ -882,6 +979,11 @@ void MainWindow::utilTagLoader()
 	auto *win = new TagLoader(m_profile);
 	win->show();
 }
+void MainWindow::utilStatistics()
+{
+	auto *win = new StatisticsWindow(this);
+	win->show();
+}
 void MainWindow::utilMd5DatabaseConverter()
 {
 	auto *win = new Md5DatabaseConverter(m_profile);
@@ -30,7 +30,9 @@ class MonitorsTab;
 class QSettings;
 class SettingsDock;
 class Site;
+class TabPlaceholder;
 class TabSelector;
+class TabsJournal;
 class Tag;
 class ThemeLoader;
 
@@ -62,21 +64,25 @@ class MainWindow : public QMainWindow
 		void md5FixOpen();
 		void renameExisting();
 		void utilTagLoader();
+		void utilStatistics();
 		void utilMd5DatabaseConverter();
 		void changeEvent(QEvent *event) override;
 		// Tabs
 		void addTab(const QString &tag = "", bool background = false, bool save = true, SearchTab *source = nullptr);
 		void addPoolTab(int pool = 0, const QString &site = "", bool background = false, bool save = true, SearchTab *source = nullptr);
 		void addGalleryTab(Site *site, QSharedPointer<Image> gallery, bool background = false, bool save = true, SearchTab *source = nullptr);
-		void addSearchTab(SearchTab*, bool background = false, bool save = true, SearchTab *source = nullptr);
+		void addSearchTab(SearchTab*, bool background = false, bool save = true, SearchTab *source = nullptr, int position = -1);
+		void addTabPlaceholder(TabPlaceholder *placeholder);
+		void restoreTabPlaceholder(TabPlaceholder *placeholder);
+		void closeTabPlaceholder(TabPlaceholder *placeholder);
 		void updateTabTitle(SearchTab*);
 		void tabClosed(SearchTab*);
 		void restoreLastClosedTab();
 		void currentTabChanged(int);
 		void closeCurrentTab();
-		bool saveTabs(const QString &filename);
+		bool saveTabs(bool compact = false);
 		bool loadTabs(const QString &filename);
-		void updateTabs();
+		void updateTabs(SearchTab *tab);
 		void focusSearch();
 		void tabNext();
 		void tabPrev();
@@ -120,6 +126,8 @@ class MainWindow : public QMainWindow
 		LanguageLoader m_languageLoader;
 		SearchTab *m_currentTab;
 		QList<SearchTab*> m_tabs, m_tabsWaitingForPreload;
+		QList<TabPlaceholder*> m_tabPlaceholders;
+		bool m_restoringPlaceholder = false;
 		QList<Site*> m_selectedSites;
 		FavoritesTab *m_favoritesTab;
 		DownloadsTab *m_downloadsTab;
@@ -130,6 +138,7 @@ class MainWindow : public QMainWindow
 		QStack<QJsonObject> m_closedTabs;
 		NetworkManager m_networkManager;
 		TabSelector *m_tabSelector;
+		TabsJournal *m_tabsJournal = nullptr;
 		DownloadQueue *m_downloadQueue;
 		SettingsDock *m_settingsDock;
 		ThemeLoader *m_themeLoader;
@@ -31,6 +31,7 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QPointer>
 #include <QSettings>
 #include <QSslSocket>
 #include <QString>
@@ -41,6 +42,10 @@
 #include "main-window.h"
 #include "models/page-api.h"
 #include "models/profile.h"
+#include "network/bandwidth-limiter.h"
+#include "network/network-thread.h"
+#include "utils/memory-budget.h"
+#include "startup-orchestrator.h"
 #include "updater/update-dialog.h"
 #if !defined(USE_CLI) && defined(USE_BREAKPAD)
 	#include <QFileInfo>
@@ -71,6 +76,8 @@ int main(int argc, char *argv[])
 	app.setOrganizationName("Bionus");
 	app.setOrganizationDomain("bionus.fr.cr");
 
+	StartupOrchestrator &startup = StartupOrchestrator::getInstance();
+
 	// Handler for custom URL protocols, redirecting to the main program through HTTP calls
 	if (argc == 3 && QString(argv[1]) == "--url-protocol") {
 		QNetworkAccessManager manager;
@@ -121,9 +128,33 @@ int main(int argc, char *argv[])
 	// Ensure SSL libraries are loaded
 	QSslSocket::supportsSsl();
 
+	// Run the network stack on its own thread, so that busy UI work does not slow down transfers
+	// It is started before loading the profile, as its sites create the network managers
+	const QSettings networkSettings(savePath("settings.ini"), QSettings::IniFormat);
+	if (networkSettings.value("Network/ioThread", true).toBool()) {
+		NetworkThread::getInstance().start();
+		QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+			NetworkThread::getInstance().stop();
+		});
+	}
+
+	// Process-wide download rate limit, in KB/s
+	BandwidthLimiter::global().setRate(networkSettings.value("Network/bandwidthLimit", 0).toLongLong() * 1024);
+
+	// Memory used by the in-memory caches, in MB
+	MemoryBudget::getInstance().setBudget(networkSettings.value("memoryBudget", 1024).toLongLong() * 1024 * 1024);
+
+	startup.phase("application");
+
 	Profile *profile = new Profile(savePath());
-	profile->purgeTemp(24 * 60 * 60);
+	QPointer<Profile> profilePtr(profile);
+	startup.defer("purge temporary files", [profilePtr]() {
+		if (!profilePtr.isNull()) {
+			profilePtr->purgeTemp(24 * 60 * 60);
+		}
+	}, StartupOrchestrator::Low);
 	QSettings *settings = profile->getSettings();
+	startup.phase("profile");
 
 	// Default to the GUI unless USE_CLI is defined
 	bool defaultToGui = true;
@@ -152,35 +183,36 @@ int main(int argc, char *argv[])
 	// Analytics
 	Analytics::getInstance().setTrackingID("UA-22768717-6");
 	Analytics::getInstance().setEnabled(settings->value("send_usage_data", true).toBool());
-	Analytics::getInstance().startSession();
-	Analytics::getInstance().sendEvent("lifecycle", "start");
-
-	// Check for updates
-	const int cfuInterval = settings->value("check_for_updates", 24 * 60 * 60).toInt();
-	QDateTime lastCfu = settings->value("last_check_for_updates", QDateTime()).toDateTime();
-	if (cfuInterval >= 0 && (!lastCfu.isValid() || lastCfu.addSecs(cfuInterval) <= QDateTime::currentDateTime())) {
-		settings->setValue("last_check_for_updates", QDateTime::currentDateTime());
-
-		bool shouldQuit = false;
-		auto *updateDialog = new UpdateDialog(&shouldQuit);
-		auto *el = new QEventLoop();
-		QObject::connect(updateDialog, &UpdateDialog::noUpdateAvailable, el, &QEventLoop::quit);
-		QObject::connect(updateDialog, &UpdateDialog::rejected, el, &QEventLoop::quit);
-
-		updateDialog->checkForUpdates();
-		el->exec();
-		el->deleteLater();
-		updateDialog->deleteLater();
-
-		if (shouldQuit) {
-			return 0;
-		}
-	}
+	startup.defer("analytics", []() {
+		Analytics::getInstance().startSession();
+		Analytics::getInstance().sendEvent("lifecycle", "start");
+	}, StartupOrchestrator::Low);
 
 	// Run the main window
 	auto *mainWindow = new MainWindow(profile);
 	mainWindow->init(positionalArgs, params);
 	mainWindow->show();
+	startup.phase("main window");
+
+	// Check for updates, the dialog closing the main window if an update is installed
+	const int cfuInterval = settings->value("check_for_updates", 24 * 60 * 60).toInt();
+	QDateTime lastCfu = settings->value("last_check_for_updates", QDateTime()).toDateTime();
+	if (cfuInterval >= 0 && (!lastCfu.isValid() || lastCfu.addSecs(cfuInterval) <= QDateTime::currentDateTime())) {
+		QPointer<MainWindow> window(mainWindow);
+		startup.defer("check for updates", [settings, window]() {
+			if (window.isNull()) {
+				return;
+			}
+			settings->setValue("last_check_for_updates", QDateTime::currentDateTime());
+
+			static bool shouldQuit = false;
+			auto *updateDialog = new UpdateDialog(&shouldQuit, window);
+			QObject::connect(updateDialog, &UpdateDialog::noUpdateAvailable, updateDialog, &QObject::deleteLater);
+			QObject::connect(updateDialog, &UpdateDialog::rejected, updateDialog, &QObject::deleteLater);
+			updateDialog->checkForUpdates();
+		});
+	}
 
+	startup.ready();
 	return app.exec();
 }
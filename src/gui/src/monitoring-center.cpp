@@ -1,5 +1,8 @@
 #include "monitoring-center.h"
+#include <QElapsedTimer>
 #include <QEventLoop>
+#include <QMap>
+#include <QSet>
 #include <QSettings>
 #include <QSystemTrayIcon>
 #include <QTimer>
@@ -11,13 +14,20 @@
 #include "models/favorite.h"
 #include "models/image.h"
 #include "models/monitor.h"
+#include "models/monitor-batcher.h"
 #include "models/monitor-manager.h"
+#include "models/monitor-scheduler.h"
 #include "models/profile.h"
 #include "models/search-query/tag-search-query.h"
 #include "models/site.h"
 
 #define MONITOR_CHECK_LIMIT 20
 #define MONITOR_CHECK_TOTAL 1000
+#define MONITOR_BATCH_SIZE 2
+#define MONITOR_BATCH_MAX_LIMIT 100
+#define MONITOR_JITTER 0.1
+#define MONITOR_MAX_CHECKS_PER_TICK 20
+#define MONITOR_BURST_DELAY 10
 
 
 MonitoringCenter::MonitoringCenter(Profile *profile, DownloadQueue *downloadQueue, QSystemTrayIcon *trayIcon, QObject *parent)
@@ -35,14 +45,6 @@ void MonitoringCenter::start()
 	QTimer::singleShot(secsDelay * 1000, this, SLOT(tick()));
 }
 
-void MonitoringCenter::checkMonitor(Monitor &monitor, const Favorite &favorite)
-{
-	bool newImages = checkMonitor(monitor, favorite.getName().split(' ', Qt::SkipEmptyParts), favorite.getPostFiltering());
-	if (newImages) {
-		emit m_profile->favoritesChanged();
-	}
-}
-
 bool MonitoringCenter::checkMonitor(Monitor &monitor, const SearchQuery &search, const QStringList &postFiltering)
 {
 	const int delay = monitor.delay();
@@ -56,6 +58,9 @@ bool MonitoringCenter::checkMonitor(Monitor &monitor, const SearchQuery &search,
 	emit statusChanged(monitor, MonitoringStatus::Checking);
 	log(QStringLiteral("Monitoring new images for '%1' on '%2'").arg(search.toString(), siteNames.join(", ")), Logger::Info);
 
+	// Custom orders give no guarantee about the order of the IDs
+	const bool sortedById = !search.toString().contains("order:") && !search.toString().contains("sort:");
+
 	int count = 0;
 	int newImages = 0;
 	QList<QSharedPointer<Image>> newImagesList;
@@ -68,22 +73,38 @@ bool MonitoringCenter::checkMonitor(Monitor &monitor, const SearchQuery &search,
 		loader.start();
 
 		// Load all images
+		const qulonglong lastId = monitor.lastId(site);
+		qulonglong maxId = lastId;
+		bool reachedKnown = false;
 		bool firstRun = true;
 		int countRun = 0;
 		int newImagesRun = 0;
-		while ((firstRun || monitor.download()) && loader.hasNext() && newImagesRun == countRun) {
+		while ((firstRun || monitor.download()) && loader.hasNext() && !reachedKnown && newImagesRun == countRun) {
 			// Load the next page
 			QList<QSharedPointer<Image>> allImages = loader.next();
 			countRun += allImages.count();
 
 			// Filter out old images
 			for (const QSharedPointer<Image> &img : allImages) {
-				if (img->createdAt() > monitor.lastCheck() && (delay <= 0 || img->createdAt() <= limit)) {
+				if (isNewImage(monitor, img, lastId)) {
+					// Images more recent than the delay will be counted on a later check
+					if (delay > 0 && img->createdAt() > limit) {
+						continue;
+					}
 					newImagesList.append(img);
 					newImagesRun++;
+				} else if (lastId > 0 && sortedById) {
+					// No need to look at the next images, as all of them were already checked
+					reachedKnown = true;
+				}
+				if (delay <= 0 || img->createdAt() <= limit) {
+					maxId = qMax(maxId, img->id());
 				}
 			}
 		}
+		if (maxId > lastId) {
+			monitor.setLastId(site, maxId);
+		}
 
 		count += countRun;
 		newImages += newImagesRun;
@@ -99,17 +120,7 @@ bool MonitoringCenter::checkMonitor(Monitor &monitor, const SearchQuery &search,
 	emit statusChanged(monitor, MonitoringStatus::Performing);
 
 	// Send notification
-	if (monitor.notify() && newImages > 0 && m_trayIcon != nullptr && m_trayIcon->isVisible()) {
-		QString msg;
-		if (count == 1) {
-			msg = tr("New images found for tag '%1' on '%2'");
-		} else if (newImages < count) {
-			msg = tr("%n new image(s) found for tag '%1' on '%2'", "", newImages);
-		} else {
-			msg = tr("More than %n new image(s) found for tag '%1' on '%2'", "", newImages);
-		}
-		m_trayIcon->showMessage(tr("Grabber monitoring"), msg.arg(search.toString(), siteNames.join(", ")), QSystemTrayIcon::Information);
-	}
+	notifyNewImages(monitor, search.toString(), siteNames.join(", "), newImages, count == 1, newImages < count);
 
 	// Add images to download queue
 	if (monitor.download() && newImages > 0) {
@@ -149,6 +160,172 @@ bool MonitoringCenter::checkMonitor(Monitor &monitor, const SearchQuery &search,
 	return newImages > 0;
 }
 
+/**
+ * Whether an image is more recent than the last check of a monitor, using its ID if known or its date otherwise.
+ */
+bool MonitoringCenter::isNewImage(const Monitor &monitor, const QSharedPointer<Image> &img, qulonglong lastId)
+{
+	if (lastId > 0 && img->id() > 0) {
+		return img->id() > lastId;
+	}
+	return img->createdAt() > monitor.lastCheck();
+}
+
+void MonitoringCenter::notifyNewImages(const Monitor &monitor, const QString &search, const QString &sites, int newImages, bool single, bool precise)
+{
+	if (!monitor.notify() || newImages <= 0 || m_trayIcon == nullptr || !m_trayIcon->isVisible()) {
+		return;
+	}
+
+	QString msg;
+	if (single) {
+		msg = tr("New images found for tag '%1' on '%2'");
+	} else if (precise) {
+		msg = tr("%n new image(s) found for tag '%1' on '%2'", "", newImages);
+	} else {
+		msg = tr("More than %n new image(s) found for tag '%1' on '%2'", "", newImages);
+	}
+	m_trayIcon->showMessage(tr("Grabber monitoring"), msg.arg(search, sites), QSystemTrayIcon::Information);
+}
+
+/**
+ * Check the monitors watching a single tag on the same site using a single "OR" search when the site supports it.
+ * Monitors checked this way are removed from the list.
+ */
+void MonitoringCenter::checkBatches(QList<DueMonitor> &due, int maxBatchSize)
+{
+	// Group the monitors which can be checked along others by site
+	QMap<Site*, QList<int>> bySite;
+	for (int i = 0; i < due.count(); ++i) {
+		const DueMonitor &d = due[i];
+		if (d.monitor->download() || d.monitor->sites().count() != 1 || MonitorBatcher::batchTag(d.query, d.postFiltering).isEmpty()) {
+			continue;
+		}
+		bySite[d.monitor->sites().first()].append(i);
+	}
+
+	QSet<int> checked;
+	for (auto it = bySite.constBegin(); it != bySite.constEnd(); ++it) {
+		const QList<int> &indexes = it.value();
+		for (int from = 0; from + 1 < indexes.count(); from += maxBatchSize) {
+			const QList<int> batchIndexes = indexes.mid(from, maxBatchSize);
+
+			QList<DueMonitor> batch;
+			for (int index : batchIndexes) {
+				batch.append(due[index]);
+			}
+
+			if (batch.count() > 1 && checkBatch(it.key(), batch)) {
+				for (int index : batchIndexes) {
+					checked.insert(index);
+				}
+			}
+		}
+	}
+
+	for (int i = due.count() - 1; i >= 0; --i) {
+		if (checked.contains(i)) {
+			due.removeAt(i);
+		}
+	}
+}
+
+/**
+ * Check several monitors of the same site using a single search, and dispatch its results to each monitor.
+ *
+ * @return False if the monitors could not be checked together, in which case they need to be checked separately
+ */
+bool MonitoringCenter::checkBatch(Site *site, const QList<DueMonitor> &batch)
+{
+	QStringList tags;
+	for (const DueMonitor &d : batch) {
+		tags.append(MonitorBatcher::batchTag(d.query, d.postFiltering));
+	}
+
+	const QString search = MonitorBatcher::orSearch(site, tags);
+	if (search.isEmpty()) {
+		return false;
+	}
+
+	for (const DueMonitor &d : batch) {
+		emit statusChanged(*d.monitor, MonitoringStatus::Checking);
+	}
+	log(QStringLiteral("Monitoring new images for '%1' on '%2'").arg(search, site->name()), Logger::Info);
+
+	// Load the first page of the combined search, with enough room for the results of all the monitors
+	const int limit = qMin(MONITOR_CHECK_LIMIT * batch.count(), MONITOR_BATCH_MAX_LIMIT);
+	DownloadQueryGroup query(m_profile->getSettings(), SearchQuery(search.split(' ', Qt::SkipEmptyParts)), 1, limit, limit, QStringList(), site);
+	PackLoader loader(m_profile, query, limit, this);
+	loader.start();
+	const QList<QSharedPointer<Image>> images = loader.hasNext() ? loader.next() : QList<QSharedPointer<Image>>();
+
+	// Results can only be dispatched back to each monitor using their tags
+	QDateTime oldest;
+	for (const QSharedPointer<Image> &img : images) {
+		if (img->tags().isEmpty()) {
+			log(QStringLiteral("Missing tags in the results of '%1' on '%2', checking the monitors separately").arg(search, site->name()), Logger::Info);
+			for (const DueMonitor &d : batch) {
+				emit statusChanged(*d.monitor, MonitoringStatus::Waiting);
+			}
+			return false;
+		}
+		if (!oldest.isValid() || img->createdAt() < oldest) {
+			oldest = img->createdAt();
+		}
+	}
+	const bool full = images.count() >= limit;
+
+	bool newFavoriteImages = false;
+	for (int i = 0; i < batch.count(); ++i) {
+		Monitor &monitor = *batch[i].monitor;
+		const QString &tag = tags[i];
+		const int delay = monitor.delay();
+		const QDateTime limitDate = QDateTime::currentDateTimeUtc().addSecs(-delay);
+
+		const qulonglong lastId = monitor.lastId(site);
+		qulonglong maxId = lastId;
+		int newImages = 0;
+		for (const QSharedPointer<Image> &img : images) {
+			if (!MonitorBatcher::hasTag(img->tags(), tag) || (delay > 0 && img->createdAt() > limitDate)) {
+				continue;
+			}
+			if (isNewImage(monitor, img, lastId)) {
+				newImages++;
+			}
+			maxId = qMax(maxId, img->id());
+		}
+		if (maxId > lastId) {
+			monitor.setLastId(site, maxId);
+		}
+
+		// If the page is full, this tag might have other new images older than the ones returned
+		const bool precise = !full || (oldest.isValid() && oldest <= monitor.lastCheck());
+
+		emit statusChanged(monitor, MonitoringStatus::Performing);
+		notifyNewImages(monitor, tag, site->name(), newImages, false, precise);
+
+		monitor.setLastCheck(limitDate);
+		monitor.setLastState(images.isEmpty() ? "empty" : (newImages == 0 ? "finished" : "ok"));
+		monitor.setCumulated(monitor.cumulated() + newImages, precise);
+
+		emit statusChanged(monitor, MonitoringStatus::Waiting);
+
+		if (batch[i].favorite && newImages > 0) {
+			newFavoriteImages = true;
+		}
+	}
+
+	m_changed = true;
+	if (!m_waitingForQueue) {
+		sync();
+	}
+	if (newFavoriteImages) {
+		emit m_profile->favoritesChanged();
+	}
+
+	return true;
+}
+
 void MonitoringCenter::sync()
 {
 	// Save only if there were changes to the monitors
@@ -165,58 +342,85 @@ void MonitoringCenter::tick()
 		return;
 	}
 
-	qint64 minNextMonitoring = -1;
 	log(QStringLiteral("Monitoring tick"), Logger::Info);
-
-	// Favorites
+	QElapsedTimer elapsed;
+	elapsed.start();
+
+	QSettings *settings = m_profile->getSettings();
+	const double jitterRatio = settings->value("Monitoring/jitter", MONITOR_JITTER).toDouble();
+	const int maxChecks = settings->value("Monitoring/maxChecksPerTick", MONITOR_MAX_CHECKS_PER_TICK).toInt();
+
+	// Schedule all monitors by their next check time, spread by their jitter
+	QList<DueMonitor> monitors;
+	QList<qint64> jitters;
+	MonitorScheduler scheduler;
+	const auto schedule = [&](const DueMonitor &d) {
+		QStringList seed { d.query.toString() };
+		for (Site *site : d.monitor->sites()) {
+			seed.append(site->url());
+		}
+		const qint64 jitter = MonitorScheduler::jitter(seed.join('|'), d.monitor->interval(), jitterRatio);
+		monitors.append(d);
+		jitters.append(jitter);
+		scheduler.add(monitors.count() - 1, d.monitor->secsToNextCheck(jitter));
+	};
 	QList<Favorite> &favs = m_profile->getFavorites();
-	for (int j = 0; j < favs.count(); ++j) {
-		Favorite &fav = favs[j];
+	for (Favorite &fav : favs) {
 		for (Monitor &monitor : fav.getMonitors()) {
-			// If this favorite's monitoring expired, we check it for updates
-			qint64 next = monitor.secsToNextCheck();
-			if (next <= 0) {
-				checkMonitor(monitor, fav);
-				next = monitor.secsToNextCheck();
-			}
+			schedule(DueMonitor { &monitor, SearchQuery(fav.getName().split(' ', Qt::SkipEmptyParts)), fav.getPostFiltering(), true });
+		}
+	}
+	for (Monitor &monitor : m_profile->monitorManager()->monitors()) {
+		schedule(DueMonitor { &monitor, monitor.query(), monitor.postFilters(), false });
+	}
 
-			if (m_waitingForQueue) {
-				return;
-			}
+	m_queueDepth = scheduler.dueCount();
+	m_lag = scheduler.lag();
+	if (m_queueDepth > 0) {
+		log(QStringLiteral("%1 monitors to check, the oldest being %2 seconds late").arg(m_queueDepth).arg(m_lag), Logger::Info);
+	}
 
-			// Only keep the soonest expiring timeout
-			if (next < minNextMonitoring || minNextMonitoring == -1) {
-				minNextMonitoring = next;
-			}
-		}
+	// Only check a limited number of monitors at once, to prevent bursts of requests
+	const QList<int> dueKeys = scheduler.takeDue(maxChecks > 0 ? maxChecks : -1);
+	QList<DueMonitor> due;
+	for (int key : dueKeys) {
+		due.append(monitors[key]);
 	}
 
-	// Normal monitors
-	for (Monitor &monitor : m_profile->monitorManager()->monitors()) {
-		// If this favorite's monitoring expired, we check it for updates
-		qint64 next = monitor.secsToNextCheck();
-		if (next <= 0) {
-			checkMonitor(monitor, monitor.query(), monitor.postFilters());
-			next = monitor.secsToNextCheck();
+	// Monitors which can be checked together use fewer requests
+	const int maxBatchSize = settings->value("Monitoring/batchSize", MONITOR_BATCH_SIZE).toInt();
+	if (maxBatchSize > 1) {
+		checkBatches(due, maxBatchSize);
+	}
+
+	for (const DueMonitor &d : qAsConst(due)) {
+		const bool newImages = checkMonitor(*d.monitor, d.query, d.postFiltering);
+		if (d.favorite && newImages) {
+			emit m_profile->favoritesChanged();
 		}
 
 		if (m_waitingForQueue) {
 			return;
 		}
+	}
 
-		// Only keep the soonest expiring timeout
-		if (next < minNextMonitoring || minNextMonitoring == -1) {
-			minNextMonitoring = next;
-		}
+	// Reschedule the monitors that were just checked, keeping the times relative to the start of this tick
+	const qint64 elapsedSecs = elapsed.elapsed() / 1000;
+	for (int key : dueKeys) {
+		scheduler.add(key, monitors[key].monitor->secsToNextCheck(jitters[key]) + elapsedSecs);
 	}
 
-	// Re-run this method as soon as one of the monitoring timeout expires
-	if (minNextMonitoring > 0) {
-		log(QStringLiteral("Next monitoring will be in %1 seconds").arg(minNextMonitoring), Logger::Info);
-		QTimer::singleShot(minNextMonitoring * 1000, this, SLOT(tick()));
-	} else {
+	if (scheduler.isEmpty()) {
 		log(QStringLiteral("Monitoring finished"), Logger::Info);
+		return;
 	}
+
+	// Re-run this method as soon as the next monitor expires, or a bit later if some are still waiting
+	const qint64 next = scheduler.dueCount() > 0
+		? MONITOR_BURST_DELAY
+		: qMax(static_cast<qint64>(1), scheduler.secsToNext() - elapsedSecs);
+	log(QStringLiteral("Next monitoring will be in %1 seconds").arg(next), Logger::Info);
+	QTimer::singleShot(next * 1000, this, SLOT(tick()));
 }
 
 void MonitoringCenter::queueEmpty()
@@ -239,3 +443,13 @@ bool MonitoringCenter::isRunning() const
 {
 	return !m_stop;
 }
+
+int MonitoringCenter::queueDepth() const
+{
+	return m_queueDepth;
+}
+
+qint64 MonitoringCenter::lag() const
+{
+	return m_lag;
+}
@@ -1,16 +1,20 @@
 #ifndef MONITORING_CENTER_H
 #define MONITORING_CENTER_H
 
+#include <QList>
 #include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include "models/search-query/search-query.h"
 
 
 class DownloadQueue;
-class Favorite;
+class Image;
 class ImageDownloader;
 class Monitor;
 class Profile;
 class QSystemTrayIcon;
-class SearchQuery;
+class Site;
 
 class MonitoringCenter : public QObject
 {
@@ -28,6 +32,16 @@ class MonitoringCenter : public QObject
 		explicit MonitoringCenter(Profile *profile, DownloadQueue *downloadQueue, QSystemTrayIcon *trayIcon, QObject *parent = nullptr);
 		bool isRunning() const;
 
+		/**
+		 * The number of monitors that were due at the last tick.
+		 */
+		int queueDepth() const;
+
+		/**
+		 * How late the most late monitor was at the last tick, in seconds.
+		 */
+		qint64 lag() const;
+
 	public slots:
 		void start();
 		void stop();
@@ -37,8 +51,19 @@ class MonitoringCenter : public QObject
 		void queueEmpty();
 
 	protected:
-		void checkMonitor(Monitor &monitor, const Favorite &favorite);
+		struct DueMonitor
+		{
+			Monitor *monitor;
+			SearchQuery query;
+			QStringList postFiltering;
+			bool favorite;
+		};
+
 		bool checkMonitor(Monitor &monitor, const SearchQuery &search, const QStringList &postFiltering);
+		void checkBatches(QList<DueMonitor> &due, int maxBatchSize);
+		bool checkBatch(Site *site, const QList<DueMonitor> &batch);
+		static bool isNewImage(const Monitor &monitor, const QSharedPointer<Image> &img, qulonglong lastId);
+		void notifyNewImages(const Monitor &monitor, const QString &search, const QString &sites, int newImages, bool single, bool precise);
 		void sync();
 
 	signals:
@@ -51,6 +76,8 @@ class MonitoringCenter : public QObject
 		bool m_waitingForQueue = false;
 		bool m_changed = false;
 		bool m_stop = false;
+		int m_queueDepth = 0;
+		qint64 m_lag = 0;
 };
 
 #endif // MONITORING_CENTER_H
@@ -1,6 +1,5 @@
 #include "search-window.h"
 #include <QCalendarWidget>
-#include <QCompleter>
 #include <QCryptographicHash>
 #include <QFile>
 #include <QFileDialog>
@@ -31,10 +30,7 @@ SearchWindow::SearchWindow(QString tags, Profile *profile, QWidget *parent)
 
 	m_tags = new TextEdit(profile, this);
 		m_tags->setContextMenuPolicy(Qt::CustomContextMenu);
-		auto *completer = new QCompleter(profile->getAutoComplete(), m_tags);
-			completer->setCaseSensitivity(Qt::CaseInsensitive);
-			completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
-			m_tags->setCompleter(completer);
+		m_tags->setAutoCompleteIndex(&profile->getAutoCompleteIndex());
 		connect(m_tags, &TextEdit::returnPressed, this, &SearchWindow::accept);
 	ui->formLayout->setWidget(0, QFormLayout::FieldRole, m_tags);
 
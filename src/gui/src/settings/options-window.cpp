@@ -589,7 +589,7 @@ void OptionsWindow::addSourceRegistry()
 		return;
 	}
 
-	auto *sourceRegistry = new SourceRegistry(url);
+	auto *sourceRegistry = new SourceRegistry(url, m_profile->getPath() + "/cache/");
 	auto receiver = new QObject(this);
 	connect(sourceRegistry, &SourceRegistry::loaded, receiver, [=](bool ok) {
 		receiver->deleteLater();
@@ -85,10 +85,12 @@ void SiteWindow::accept()
 		ui->progressBar->setMaximum(m_sources.count());
 		ui->progressBar->show();
 
-		SourceGuesser sourceGuesser(m_url, m_sources, this);
-		connect(&sourceGuesser, &SourceGuesser::progress, ui->progressBar, &QProgressBar::setValue);
-		connect(&sourceGuesser, &SourceGuesser::finished, this, &SiteWindow::finish);
-		sourceGuesser.start();
+		// Guessing is asynchronous, and cancelled if the window is closed before it finishes
+		delete m_sourceGuesser;
+		m_sourceGuesser = new SourceGuesser(m_url, m_sources, this);
+		connect(m_sourceGuesser, &SourceGuesser::progress, ui->progressBar, &QProgressBar::setValue);
+		connect(m_sourceGuesser, &SourceGuesser::finished, this, &SiteWindow::finish);
+		m_sourceGuesser->start();
 
 		return;
 	}
@@ -14,6 +14,7 @@ namespace Ui
 
 class Profile;
 class Source;
+class SourceGuesser;
 
 class SiteWindow : public QDialog
 {
@@ -36,6 +37,7 @@ class SiteWindow : public QDialog
 		Profile *m_profile;
 		QList<Source*> m_sources;
 		QString m_url;
+		SourceGuesser *m_sourceGuesser = nullptr;
 };
 
 #endif // SITE_WINDOW_H
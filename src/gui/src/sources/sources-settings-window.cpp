@@ -73,6 +73,7 @@ SourcesSettingsWindow::SourcesSettingsWindow(Profile *profile, Site *site, QWidg
 	ui->spinThrottlePage->setValue(site->setting("download/throttle_page", 0).toInt());
 	ui->spinThrottleRetry->setValue(site->setting("download/throttle_retry", 0).toInt());
 	ui->spinThrottleThumbnail->setValue(site->setting("download/throttle_thumbnail", 0).toInt());
+	ui->checkProbeHeaders->setChecked(site->setting("download/probe_headers", false).toBool());
 
 	// Source order
 	ui->checkSourcesDefault->setChecked(site->setting("sources/usedefault", true).toBool());
@@ -315,6 +316,7 @@ void SourcesSettingsWindow::saveSettings()
 	m_site->setSetting("download/throttle_page", ui->spinThrottlePage->value(), 0);
 	m_site->setSetting("download/throttle_retry", ui->spinThrottleRetry->value(), 0);
 	m_site->setSetting("download/throttle_thumbnail", ui->spinThrottleThumbnail->value(), 0);
+	m_site->setSetting("download/probe_headers", ui->checkProbeHeaders->isChecked(), false);
 
 	const QStringList defs { "xml", "json", "regex", "rss" };
 	QStringList sources { "" };
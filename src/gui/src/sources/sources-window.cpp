@@ -13,6 +13,7 @@
 #include "sources/sources-settings-window.h"
 #include "ui/QAffiche.h"
 #include "ui/QBouton.h"
+#include "updater/source-updater.h"
 
 
 SourcesWindow::SourcesWindow(Profile *profile, QList<Site*> selected, QWidget *parent)
@@ -276,11 +277,12 @@ void SourcesWindow::checkAll(int check)
 
 void SourcesWindow::checkForUpdates()
 {
-	for (auto it = m_sources.constBegin(); it != m_sources.constEnd(); ++it) {
-		const SourceUpdater &updater = it.value()->getUpdater();
-		connect(&updater, &SourceUpdater::finished, this, &SourcesWindow::checkForUpdatesReceived);
-		updater.checkForUpdates();
+	if (m_sourceUpdater == nullptr) {
+		m_sourceUpdater = new SourceUpdater(m_sources.values(), m_profile->getPath() + "/cache/");
+		m_sourceUpdater->setParent(this);
+		connect(m_sourceUpdater, &SourceUpdater::finished, this, &SourcesWindow::checkForUpdatesReceived);
 	}
+	m_sourceUpdater->checkForUpdates();
 }
 void SourcesWindow::checkForUpdatesReceived(const QString &sourceName, bool isNew)
 {
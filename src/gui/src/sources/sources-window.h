@@ -18,6 +18,7 @@ class Profile;
 class QBouton;
 class Site;
 class Source;
+class SourceUpdater;
 
 struct SourceRow
 {
@@ -78,6 +79,7 @@ class SourcesWindow : public QDialog
 		const QMap<QString, Source*> &m_sources;
 		QMap<QString, QStringList> m_presets;
 		NetworkReply *m_checkForSourceReply;
+		SourceUpdater *m_sourceUpdater = nullptr;
 };
 
 #endif // SOURCESWINDOW_H
@@ -4,6 +4,7 @@
 #include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QHash>
 #include <QMenu>
 #include <QMessageBox>
 #include <QShortcut>
@@ -22,21 +23,30 @@
 #include "commands/commands.h"
 #include "download-group-table-model.h"
 #include "download-image-table-model.h"
+#include "downloader/details-batcher.h"
 #include "downloader/download-query-group.h"
 #include "downloader/download-query-image.h"
 #include "downloader/download-query-loader.h"
+#include "downloader/download-query-snapshot.h"
 #include "downloader/image-downloader.h"
+#include "downloader/progress-aggregator.h"
+#include "exiftool-queue.h"
 #include "full-width-drop-proxy-style.h"
 #include "functions.h"
 #include "helpers.h"
 #include "loader/pack-loader.h"
 #include "logger.h"
+#include "login/session-manager.h"
 #include "main-window.h"
 #include "models/filename.h"
 #include "models/page.h"
 #include "models/profile.h"
+#include "models/site.h"
 #include "progress-bar-delegate.h"
 
+#define RESTORE_CHUNK_SIZE 500
+#define MAX_SIMULTANEOUS_DOWNLOADS 30
+
 
 DownloadsTab::DownloadsTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent)
 	: QWidget(parent), ui(new Ui::DownloadsTab), m_profile(profile), m_settings(profile->getSettings()), m_downloadQueue(downloadQueue), m_parent(parent), m_getAll(false), m_progressDialog(nullptr), m_batchAutomaticRetries(0), m_finishedSoundEffect(this)
@@ -52,6 +62,16 @@ DownloadsTab::DownloadsTab(Profile *profile, DownloadQueue *downloadQueue, MainW
 	m_batchsModel = new DownloadImageTableModel(m_batchs, this);
 	ui->tableBatchUniques->setModel(m_batchsModel);
 
+	m_progressAggregator = new ProgressAggregator(m_settings->value("progress_interval", 100).toInt(), this);
+	connect(m_progressAggregator, &ProgressAggregator::imageProgress, this, &DownloadsTab::getAllProgress);
+
+	m_sessionManager = new SessionManager(this);
+	connect(m_sessionManager, &SessionManager::progress, this, [this](int current, int max) {
+		m_progressDialog->setCurrentMax(max);
+		m_progressDialog->setCurrentValue(current);
+	});
+	connect(m_sessionManager, &SessionManager::finished, this, &DownloadsTab::getAllFinishedLogins);
+
 	ui->tableBatchGroups->loadGeometry(m_settings, "Downloads/Groups");
 	ui->tableBatchUniques->loadGeometry(m_settings, "Downloads/Uniques", QList<int> { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
 
@@ -72,6 +92,7 @@ DownloadsTab::DownloadsTab(Profile *profile, DownloadQueue *downloadQueue, MainW
 	m_saveLinkList->setInterval(100);
 	m_saveLinkList->setSingleShot(true);
 	connect(m_saveLinkList, &QTimer::timeout, this, &DownloadsTab::saveLinkListDefault);
+	m_restoreSnapshot = new DownloadQuerySnapshot(m_profile->getPath() + "/restore.igl");
 
 	m_finishedSoundEffect.setSource(QUrl(":/sounds/finished.wav"));
 }
@@ -79,6 +100,7 @@ DownloadsTab::DownloadsTab(Profile *profile, DownloadQueue *downloadQueue, MainW
 DownloadsTab::~DownloadsTab()
 {
 	close();
+	delete m_restoreSnapshot;
 	delete ui;
 }
 
@@ -177,6 +199,7 @@ void DownloadsTab::batchClear()
 		return;
 	}
 
+	finishRestore();
 	m_batchs.clear();
 	m_batchsModel->cleared();
 
@@ -207,12 +230,17 @@ void DownloadsTab::batchRemoveGroups(QList<int> rows)
 
 	std::sort(rows.begin(), rows.end());
 
-	int rem = 0;
-	for (int i : qAsConst(rows)) {
-		int pos = i - rem;
-		m_groupBatchsModel->removed(pos);
-		m_groupBatchs.removeAt(pos);
-		rem++;
+	// Remove contiguous rows all at once, starting from the end so that positions stay valid
+	for (int i = rows.count() - 1; i >= 0;) {
+		int count = 1;
+		while (i - count >= 0 && rows[i - count] == rows[i] - count) {
+			count++;
+		}
+
+		const int pos = rows[i] - count + 1;
+		m_groupBatchsModel->removed(pos, count);
+		m_groupBatchs.erase(m_groupBatchs.begin() + pos, m_groupBatchs.begin() + pos + count);
+		i -= count;
 	}
 
 	saveLinkListLater();
@@ -226,12 +254,17 @@ void DownloadsTab::batchRemoveUniques(QList<int> rows)
 
 	std::sort(rows.begin(), rows.end());
 
-	int rem = 0;
-	for (int i : qAsConst(rows)) {
-		int pos = i - rem;
-		m_batchsModel->removed(pos);
-		m_batchs.removeAt(pos);
-		rem++;
+	// Remove contiguous rows all at once, starting from the end so that positions stay valid
+	for (int i = rows.count() - 1; i >= 0;) {
+		int count = 1;
+		while (i - count >= 0 && rows[i - count] == rows[i] - count) {
+			count++;
+		}
+
+		const int pos = rows[i] - count + 1;
+		m_batchsModel->removed(pos, count);
+		m_batchs.erase(m_batchs.begin() + pos, m_batchs.begin() + pos + count);
+		i -= count;
 	}
 
 	saveLinkListLater();
@@ -262,9 +295,7 @@ void DownloadsTab::batchMove(int diff)
 		auto sourceBatch = m_groupBatchs.takeAt(sourceRow);
 		m_groupBatchs.insert(destRow, sourceBatch);
 
-		for (int j = sourceRow; j != destRow; (diff < 0 ? --j : ++j)) {
-			m_groupBatchsModel->changed(j);
-		}
+		m_groupBatchsModel->changed(qMin(sourceRow, destRow), qAbs(destRow - sourceRow) + 1);
 	}
 
 	QItemSelection selection;
@@ -382,7 +413,9 @@ void DownloadsTab::saveLinkListLater()
 }
 bool DownloadsTab::saveLinkListDefault()
 {
-	return saveLinkList(m_profile->getPath() + "/restore.igl");
+	// The restore file is saved incrementally, so it must contain the whole list first
+	finishRestore();
+	return m_restoreSnapshot->save(m_batchs, m_groupBatchs);
 }
 bool DownloadsTab::saveLinkList(const QString &filename, bool saveProgress)
 {
@@ -418,17 +451,72 @@ bool DownloadsTab::loadLinkList(const QString &filename)
 
 	log(tr("Loading %n download(s)", "", newBatchs.count() + newGroupBatchs.count()), Logger::Info);
 
-	for (const auto &queryImage : qAsConst(newBatchs)) {
-		batchAddUnique(queryImage, false);
+	appendUniques(newBatchs);
+	appendGroups(newGroupBatchs);
+	updateGroupCount();
+
+	return true;
+}
+bool DownloadsTab::restoreLinkList()
+{
+	const QString path = m_profile->getPath() + "/restore.igl";
+	if (!DownloadQuerySnapshot::isSnapshot(path)) {
+		return loadLinkList(path);
 	}
-	for (const auto &queryGroup : qAsConst(newGroupBatchs)) {
-		m_groupBatchs.append(queryGroup);
-		m_groupBatchsModel->inserted(m_groupBatchs.count() - 1);
+	if (!m_restoreSnapshot->open()) {
+		return false;
 	}
+
+	log(tr("Loading %n download(s)", "", m_restoreSnapshot->groupCount() + m_restoreSnapshot->uniqueCount()), Logger::Info);
+
+	appendGroups(m_restoreSnapshot->readGroups(m_profile));
 	updateGroupCount();
 
+	// Unique images are much more numerous, so they are loaded in chunks to keep the UI responsive
+	restoreNextUniques();
+
 	return true;
 }
+void DownloadsTab::restoreNextUniques()
+{
+	if (m_restoreSnapshot->atEnd()) {
+		return;
+	}
+
+	appendUniques(m_restoreSnapshot->readUniques(m_profile, RESTORE_CHUNK_SIZE));
+
+	if (!m_restoreSnapshot->atEnd()) {
+		QTimer::singleShot(0, this, &DownloadsTab::restoreNextUniques);
+	}
+}
+void DownloadsTab::finishRestore()
+{
+	if (!m_restoreSnapshot->atEnd()) {
+		appendUniques(m_restoreSnapshot->readUniques(m_profile));
+	}
+}
+
+void DownloadsTab::appendGroups(const QList<DownloadQueryGroup> &groups)
+{
+	if (groups.isEmpty()) {
+		return;
+	}
+
+	const int first = m_groupBatchs.count();
+	m_groupBatchs.append(groups);
+	m_groupBatchsModel->inserted(first, groups.count());
+}
+void DownloadsTab::appendUniques(const QList<DownloadQueryImage> &uniques)
+{
+	if (uniques.isEmpty()) {
+		return;
+	}
+
+	// Loaded images are new objects, so there is no need to check for duplicates
+	const int first = m_batchs.count();
+	m_batchs.append(uniques);
+	m_batchsModel->inserted(first, uniques.count());
+}
 
 QIcon &DownloadsTab::getIcon(const QString &path)
 {
@@ -457,6 +545,7 @@ void DownloadsTab::getAll(bool all)
 		log(QStringLiteral("Batch download start cancelled because another one is already running."), Logger::Warning);
 		return;
 	}
+	finishRestore();
 	if (m_settings->value("Save/path").toString().isEmpty()) {
 		error(this, tr("You did not specify a save folder!"));
 		return;
@@ -491,7 +580,7 @@ void DownloadsTab::getAll(bool all)
 	m_getAllSkippedImages.clear();
 	m_batchPending.clear();
 	m_waitingPackLoaders.clear();
-	m_currentPackLoader = nullptr;
+	m_currentPackLoaders.clear();
 	m_batchUniqueDownloading.clear();
 
 	if (!all) {
@@ -523,12 +612,16 @@ void DownloadsTab::getAll(bool all)
 	}
 	m_getAllLimit = m_batchs.size();
 
-	for (const auto &batch : m_groupBatchs) {
-		m_groupBatchsModel->setStatus(batch, 0);
-	}
+	m_groupBatchsModel->setStatuses(0);
 	m_profile->getCommands().before();
 	m_batchDownloading.clear();
 
+	// Keep metadata writes out of the way of downloads if needed
+	if (!m_exiftoolHeld && m_settings->value("Save/MetadataExiftoolDeferred", false).toBool()) {
+		m_profile->getExiftool().hold();
+		m_exiftoolHeld = true;
+	}
+
 	QSet<int> toDownload = selectedRows(ui->tableBatchGroups);
 
 	int resumeCount = 0;
@@ -561,6 +654,8 @@ void DownloadsTab::getAll(bool all)
 		if (m_groupBatchs[b].progressFinished || !resume) {
 			m_groupBatchs[b].progressVal = 0;
 			m_batchPending[b].progressVal = 0;
+			m_groupBatchs[b].checkpoint = DownloadQueryGroup::Checkpoint();
+			m_batchPending[b].checkpoint = DownloadQueryGroup::Checkpoint();
 		}
 		m_groupBatchs[b].progressFinished = false;
 		m_batchPending[b].progressFinished = false;
@@ -611,41 +706,12 @@ void DownloadsTab::getAllLogin()
 	m_progressDialog->clear();
 	m_progressDialog->setText(tr("Logging in, please wait..."));
 
-	m_getAllLogins.clear();
+	// Log into all the sites of the batch at the same time, skipping those whose session is still valid
+	QList<Site*> sites;
 	for (auto it = m_batchPending.constBegin(); it != m_batchPending.constEnd(); ++it) {
-		Site *site = it.value().site;
-		if (!m_getAllLogins.contains(site)) {
-			m_getAllLogins.append(site);
-		}
-	}
-
-	if (m_getAllLogins.empty()) {
-		getAllFinishedLogins();
-		return;
-	}
-
-	m_progressDialog->setCurrentValue(0);
-	m_progressDialog->setCurrentMax(m_getAllLogins.count());
-
-	for (Site *site : m_getAllLogins) {
-		connect(site, &Site::loggedIn, this, &DownloadsTab::getAllFinishedLogin, Qt::QueuedConnection);
-		site->login();
-	}
-}
-void DownloadsTab::getAllFinishedLogin(Site *site, Site::LoginResult result)
-{
-	Q_UNUSED(result)
-
-	if (m_getAllLogins.empty()) {
-		return;
-	}
-
-	m_progressDialog->setCurrentValue(m_progressDialog->currentValue() + 1);
-	m_getAllLogins.removeAll(site);
-
-	if (m_getAllLogins.empty()) {
-		getAllFinishedLogins();
+		sites.append(it.value().site);
 	}
+	m_sessionManager->login(sites);
 }
 
 void DownloadsTab::getAllFinishedLogins()
@@ -659,6 +725,9 @@ void DownloadsTab::getAllFinishedLogins()
 		total += b.total;
 
 		auto packLoader = new PackLoader(m_profile, b, usePacking ? imagesPerPack : -1, this);
+		packLoader->setPrefetch(m_settings->value("packing_prefetch", 1).toInt(), m_settings->value("packing_prefetch_images", 1000).toInt());
+		packLoader->setGalleryPrefetch(m_settings->value("packing_prefetch_galleries", 4).toInt());
+		packLoader->setUseMaxLimit(m_settings->value("packing_max_limit", true).toBool());
 		connect(packLoader, &PackLoader::finishedPage, this, &DownloadsTab::getAllFinishedPage);
 		m_waitingPackLoaders.enqueue(packLoader);
 	}
@@ -669,26 +738,42 @@ void DownloadsTab::getAllFinishedLogins()
 
 void DownloadsTab::getNextPack()
 {
-	// If the current pack loader is not finished
-	if (m_currentPackLoader != nullptr && m_currentPackLoader->hasNext()) {
-		getAllGetPages();
-	}
-	// If there are pending packs
-	else if (!m_waitingPackLoaders.isEmpty()) {
-		if (m_currentPackLoader != nullptr) {
-			m_currentPackLoader->deleteLater();
+	// Remove the groups that are finished
+	for (int i = m_currentPackLoaders.count() - 1; i >= 0; --i) {
+		if (!m_currentPackLoaders[i]->hasNext()) {
+			m_currentPackLoaders.takeAt(i)->deleteLater();
 		}
+	}
 
-		m_currentPackLoader = m_waitingPackLoaders.dequeue();
-		m_currentPackLoader->start();
+	// Start pending groups, but only one per site at a time to respect their throttling
+	const int maxGroups = qMax(1, m_settings->value("Save/simultaneousGroups", 1).toInt());
+	for (int i = 0; i < m_waitingPackLoaders.count() && m_currentPackLoaders.count() < maxGroups;) {
+		Site *site = m_waitingPackLoaders[i]->query().site;
+		bool siteBusy = false;
+		for (PackLoader *current : qAsConst(m_currentPackLoaders)) {
+			if (current->query().site == site) {
+				siteBusy = true;
+				break;
+			}
+		}
+		if (siteBusy) {
+			++i;
+			continue;
+		}
 
-		getAllGetPages();
+		PackLoader *packLoader = m_waitingPackLoaders.takeAt(i);
+		packLoader->start();
+		m_currentPackLoaders.append(packLoader);
 	}
+
 	// Only images to download
-	else {
+	if (m_currentPackLoaders.isEmpty()) {
 		m_batchAutomaticRetries = m_settings->value("Save/automaticretries", 0).toInt();
 		getAllImages();
+		return;
 	}
+
+	getAllGetPages();
 }
 
 void DownloadsTab::getAllGetPages()
@@ -696,15 +781,52 @@ void DownloadsTab::getAllGetPages()
 	m_progressDialog->clearImages();
 	m_progressDialog->setText(tr("Downloading pages, please wait..."));
 
-	const auto &query = m_currentPackLoader->query();
-	const int images = m_currentPackLoader->nextPackSize();
-	const int pages = qMax(1, qCeil(static_cast<qreal>(images) / query.perpage));
+	int pages = 0;
+	m_batchCurrentPackSize = 0;
+	for (PackLoader *packLoader : qAsConst(m_currentPackLoaders)) {
+		const int images = packLoader->nextPackSize();
+		pages += qMax(1, qCeil(static_cast<qreal>(images) / packLoader->query().perpage));
+		m_batchCurrentPackSize += images;
+	}
 
 	m_progressDialog->setCurrentValue(0);
 	m_progressDialog->setCurrentMax(pages);
-	m_batchCurrentPackSize = images;
 
-	getAllFinishedImages(m_currentPackLoader->next());
+	// Get a pack from each running group, their pages being prefetched in parallel
+	QList<QList<BatchDownloadImage>> packs;
+	const QList<PackLoader*> packLoaders = m_currentPackLoaders;
+	for (PackLoader *packLoader : packLoaders) {
+		const int row = getRowForPackLoader(packLoader);
+		if (row < 0) {
+			log("Images received from unknown batch", Logger::Error);
+			continue;
+		}
+
+		QList<BatchDownloadImage> pack;
+		for (const auto &img : packLoader->next()) {
+			BatchDownloadImage d;
+			d.image = img;
+			d.queryGroup = &m_batchPending[row];
+			pack.append(d);
+		}
+
+		// Save where to resume this group from if the batch is stopped before this pack is downloaded
+		m_groupBatchs[row].checkpoint = packLoader->checkpoint();
+		m_batchPending[row].checkpoint = packLoader->checkpoint();
+		packs.append(pack);
+	}
+
+	getAllFinishedImages(packs);
+}
+
+int DownloadsTab::getRowForPackLoader(PackLoader *packLoader) const
+{
+	for (auto it = m_batchPending.constBegin(); it != m_batchPending.constEnd(); ++it) {
+		if (it.value() == packLoader->query()) {
+			return it.key();
+		}
+	}
+	return -1;
 }
 
 /**
@@ -720,35 +842,32 @@ void DownloadsTab::getAllFinishedPage(Page *page)
 }
 
 /**
- * Called when a page have been loaded and parsed.
+ * Called when packs have been loaded and parsed.
  *
- * @param images The images results on this page
+ * @param packs The images results of each running group
  */
-void DownloadsTab::getAllFinishedImages(const QList<QSharedPointer<Image>> &images)
+void DownloadsTab::getAllFinishedImages(const QList<QList<BatchDownloadImage>> &packs)
 {
-	int row = -1;
-	for (auto it = m_batchPending.constBegin(); it != m_batchPending.constEnd(); ++it) {
-		if (it.value() == m_currentPackLoader->query()) {
-			row = it.key();
+	// Interleave the groups so that simultaneous downloads are spread between them
+	int count = 0;
+	for (int i = 0;; ++i) {
+		bool added = false;
+		for (const auto &pack : packs) {
+			if (i < pack.count()) {
+				m_getAllRemaining.append(pack[i]);
+				added = true;
+				count++;
+			}
+		}
+		if (!added) {
 			break;
 		}
 	}
-	if (row < 0) {
-		log("Images received from unknown batch", Logger::Error);
-		return;
-	}
-
-	for (const auto &img : images) {
-		BatchDownloadImage d;
-		d.image = img;
-		d.queryGroup = &m_batchPending[row];
-		m_getAllRemaining.append(d);
-	}
 
 	// Ignore for aborted/resumed calls (partial packs)
-	if (m_getAll && !images.isEmpty()) {
+	if (m_getAll && count > 0) {
 		// Update image to take into account unlisted images
-		int unlisted = m_batchCurrentPackSize - images.count();
+		int unlisted = m_batchCurrentPackSize - count;
 		m_getAllImagesCount -= unlisted;
 	}
 
@@ -770,6 +889,9 @@ void DownloadsTab::getAllImages()
 	m_progressDialog->clearImages();
 	m_progressDialog->setText(tr("Preparing images, please wait..."));
 	m_progressDialog->setCount(m_getAllRemaining.count());
+	const int globalNeedTags = ImageDownloader::needExactTags(m_settings);
+	QHash<const DownloadQuery*, int> queryNeedTags;
+	QHash<Site*, QList<QSharedPointer<Image>>> needDetails;
 	for (const BatchDownloadImage &download : qAsConst(m_getAllRemaining)) {
 		const int siteId = download.siteId(m_groupBatchs);
 		QSharedPointer<Image> img = download.image;
@@ -778,6 +900,21 @@ void DownloadsTab::getAllImages()
 		m_progressDialog->addImage(img->url(), siteId, img->fileSize());
 		connect(img.data(), &Image::urlChanged, m_progressDialog, &BatchWindow::imageUrlChanged);
 		connect(img.data(), &Image::urlChanged, this, &DownloadsTab::imageUrlChanged);
+
+		// Find images that will need their details to be loaded before saving
+		const DownloadQuery *query = download.query();
+		auto needTags = queryNeedTags.find(query);
+		if (needTags == queryNeedTags.end()) {
+			needTags = queryNeedTags.insert(query, qMax(globalNeedTags, Filename(query->filename).needExactTags(query->site, m_settings)));
+		}
+		if (needTags.value() == 2 || (needTags.value() == 1 && img->hasUnknownTag())) {
+			needDetails[img->parentSite()].append(img);
+		}
+	}
+
+	// Their details can then be loaded together, instead of one request per image
+	for (auto it = needDetails.constBegin(); it != needDetails.constEnd(); ++it) {
+		it.key()->detailsBatcher()->prefetch(it.value());
 	}
 
 	// Set some values on the batch window
@@ -788,14 +925,32 @@ void DownloadsTab::getAllImages()
 	m_progressDialog->setTotalValue(m_getAllDownloaded + m_getAllExists + m_getAllIgnored + m_getAllErrors + m_getAllResumed);
 	m_progressDialog->setTotalMax(m_getAllImagesCount);
 
+	// Images from several sites (such as unique images added from a selection) are downloaded in parallel, as long as
+	// each site stays within its own limit
+	QSet<QString> sites;
+	for (const BatchDownloadImage &download : qAsConst(m_getAllRemaining)) {
+		sites.insert(siteKey(download.image));
+	}
+	const int simultaneous = qMax(1, qMin(m_settings->value("Save/simultaneous").toInt(), 10));
+	const int perSite = m_settings->value("Save/simultaneousPerSite", 0).toInt();
+	m_getAllSiteLimit = perSite > 0 ? perSite : simultaneous;
+	m_getAllSiteDownloading.clear();
+	m_getAllParked = 0;
+
 	// We start the simultaneous downloads
-	int count = qMax(1, qMin(m_settings->value("Save/simultaneous").toInt(), 10));
+	const int count = qBound(simultaneous, m_getAllSiteLimit * sites.count(), qMax(simultaneous, MAX_SIMULTANEOUS_DOWNLOADS));
 	m_getAllCurrentlyProcessing.storeRelaxed(count);
 	for (int i = 0; i < count; i++) {
 		_getAll();
 	}
 }
 
+QString DownloadsTab::siteKey(const QSharedPointer<Image> &img)
+{
+	Site *site = img->parentSite();
+	return site != nullptr ? site->url() : QString();
+}
+
 void DownloadsTab::_getAll()
 {
 	// We quit as soon as the user cancels
@@ -805,9 +960,24 @@ void DownloadsTab::_getAll()
 
 	// If there are still images do download
 	if (!m_getAllRemaining.empty()) {
-		// We take the first image to download
-		BatchDownloadImage download = m_getAllRemaining.takeFirst();
+		// We take the first image of a site that can still start a download
+		int index = -1;
+		for (int i = 0; i < m_getAllRemaining.count(); ++i) {
+			if (m_getAllSiteDownloading.value(siteKey(m_getAllRemaining[i].image)) < m_getAllSiteLimit) {
+				index = i;
+				break;
+			}
+		}
+
+		// Otherwise, we wait for a download to finish
+		if (index < 0) {
+			m_getAllParked++;
+			return;
+		}
+
+		BatchDownloadImage download = m_getAllRemaining.takeAt(index);
 		m_getAllDownloading.append(download);
+		m_getAllSiteDownloading[siteKey(download.image)]++;
 
 		int siteId = download.siteId(m_groupBatchs);
 		getAllGetImage(download, siteId);
@@ -834,16 +1004,24 @@ void DownloadsTab::getAllImageOk(const BatchDownloadImage &download, int siteId,
 		int row = getRowForSite(siteId);
 		m_groupBatchs[row].progressVal++;
 		m_batchPending[row].progressVal++;
-		m_groupBatchsModel->changed(row);
+		m_groupBatchsModel->progressChanged(row);
 
 		if (m_groupBatchs[row].progressVal >= m_groupBatchs[row].total) {
-			m_groupBatchsModel->setStatus(m_groupBatchs[row], 2);
+			m_groupBatchsModel->setStatus(row, 2);
 		}
 	}
 
 	m_getAllDownloading.removeAll(download);
+	m_getAllSiteDownloading[siteKey(download.image)]--;
 	QCoreApplication::processEvents();
 	QTimer::singleShot(0, this, SLOT(_getAll()));
+
+	// A slot was freed for this site, so the workers waiting for one can try again
+	const int parked = m_getAllParked;
+	m_getAllParked = 0;
+	for (int i = 0; i < parked; ++i) {
+		QTimer::singleShot(0, this, SLOT(_getAll()));
+	}
 }
 
 void DownloadsTab::imageUrlChanged(const QUrl &before, const QUrl &after)
@@ -905,7 +1083,7 @@ void DownloadsTab::getAllGetImage(const BatchDownloadImage &download, int siteId
 	QString filename = download.query()->filename;
 	QString path = download.query()->path;
 	if (siteId >= 0) {
-		m_groupBatchsModel->setStatus(m_groupBatchs[row], 1);
+		m_groupBatchsModel->setStatus(row, 1);
 	}
 
 	// Track download progress
@@ -924,7 +1102,7 @@ void DownloadsTab::getAllGetImage(const BatchDownloadImage &download, int siteId
 		imgDownloader->setBlacklist(&m_profile->getBlacklist());
 	}
 	connect(imgDownloader, &ImageDownloader::saved, this, &DownloadsTab::getAllGetImageSaved, Qt::UniqueConnection);
-	connect(imgDownloader, &ImageDownloader::downloadProgress, this, &DownloadsTab::getAllProgress, Qt::UniqueConnection);
+	connect(imgDownloader, &ImageDownloader::downloadProgress, m_progressAggregator, &ProgressAggregator::update, Qt::UniqueConnection);
 	m_getAllImageDownloaders[img] = imgDownloader;
 	imgDownloader->save();
 }
@@ -934,6 +1112,7 @@ void DownloadsTab::getAllGetImageSaved(const QSharedPointer<Image> &img, QList<I
 	// Delete ImageDownloader to prevent leaks
 	m_getAllImageDownloaders[img]->deleteLater();
 	m_getAllImageDownloaders.remove(img);
+	m_progressAggregator->remove(img);
 
 	// Find related download query
 	const BatchDownloadImage *downloadPtr = nullptr;
@@ -994,7 +1173,7 @@ void DownloadsTab::getAllGetImageSaved(const QSharedPointer<Image> &img, QList<I
 		m_getAll404s++;
 	} else if (res == Image::SaveResult::AlreadyExistsDisk) {
 		m_getAllExists++;
-	} else if (res == Image::SaveResult::Blacklisted || res == Image::SaveResult::AlreadyExistsMd5 || res == Image::SaveResult::AlreadyExistsDeletedMd5) {
+	} else if (res == Image::SaveResult::Blacklisted || res == Image::SaveResult::AlreadyExistsMd5 || res == Image::SaveResult::AlreadyExistsDeletedMd5 || res == Image::SaveResult::AlreadyExistsSimilar) {
 		m_getAllIgnored++;
 	} else if (!diskError) {
 		m_getAllDownloaded++;
@@ -1009,18 +1188,28 @@ void DownloadsTab::getAllGetImageSaved(const QSharedPointer<Image> &img, QList<I
 void DownloadsTab::getAllCancel()
 {
 	log(QStringLiteral("Cancelling downloads..."), Logger::Info);
+	m_sessionManager->cancel();
 	m_progressDialog->cancel();
-	if (m_currentPackLoader != nullptr) {
-		m_currentPackLoader->abort();
+	for (PackLoader *packLoader : qAsConst(m_currentPackLoaders)) {
+		packLoader->abort();
 	}
 	for (auto it = m_getAllImageDownloaders.constBegin(); it != m_getAllImageDownloaders.constEnd(); ++it) {
 		it.value()->abort();
 	}
 	m_getAll = false;
+	releaseExiftool();
 	ui->widgetDownloadButtons->setEnabled(true);
 	DONE();
 }
 
+void DownloadsTab::releaseExiftool()
+{
+	if (m_exiftoolHeld) {
+		m_profile->getExiftool().release();
+		m_exiftoolHeld = false;
+	}
+}
+
 void DownloadsTab::getAllSkip()
 {
 	log(QStringLiteral("Skipping downloads..."), Logger::Info);
@@ -1031,6 +1220,8 @@ void DownloadsTab::getAllSkip()
 	}
 	m_getAllSkippedImages.append(m_getAllDownloading);
 	m_getAllDownloading.clear();
+	m_getAllSiteDownloading.clear();
+	m_getAllParked = 0;
 
 	m_getAllSkipped += count;
 	m_progressDialog->setTotalValue(m_getAllDownloaded + m_getAllExists + m_getAllIgnored + m_getAllErrors + m_getAllResumed);
@@ -1044,7 +1235,11 @@ void DownloadsTab::getAllSkip()
 
 void DownloadsTab::getAllFinished()
 {
-	if (!m_waitingPackLoaders.isEmpty() || (m_currentPackLoader != nullptr && m_currentPackLoader->hasNext())) {
+	bool hasNext = !m_waitingPackLoaders.isEmpty();
+	for (PackLoader *packLoader : qAsConst(m_currentPackLoaders)) {
+		hasNext = hasNext || packLoader->hasNext();
+	}
+	if (hasNext) {
 		getNextPack();
 		return;
 	}
@@ -1053,10 +1248,10 @@ void DownloadsTab::getAllFinished()
 	m_progressDialog->setTotalValue(m_progressDialog->totalMax());
 
 	// Delete objects
-	if (m_currentPackLoader != nullptr) {
-		m_currentPackLoader->deleteLater();
-		m_currentPackLoader = nullptr;
+	for (PackLoader *packLoader : qAsConst(m_currentPackLoaders)) {
+		packLoader->deleteLater();
 	}
+	m_currentPackLoaders.clear();
 
 	// Retry in case of error
 	int failedCount = m_getAllErrors + m_getAllSkipped;
@@ -1141,6 +1336,7 @@ void DownloadsTab::getAllFinished()
 
 	// End of batch download
 	m_profile->getCommands().after();
+	releaseExiftool();
 	ui->widgetDownloadButtons->setEnabled(true);
 	log(QStringLiteral("Batch download finished"), Logger::Info);
 }
@@ -1150,8 +1346,8 @@ void DownloadsTab::getAllPause()
 	if (m_progressDialog->isPaused()) {
 		log(QStringLiteral("Pausing downloads..."), Logger::Info);
 		m_getAll = false;
-		if (m_currentPackLoader != nullptr) {
-			m_currentPackLoader->abort();
+		for (PackLoader *packLoader : qAsConst(m_currentPackLoaders)) {
+			packLoader->abort();
 		}
 		for (auto it = m_getAllImageDownloaders.constBegin(); it != m_getAllImageDownloaders.constEnd(); ++it) {
 			it.value()->abort();
@@ -1160,7 +1356,7 @@ void DownloadsTab::getAllPause()
 		log(QStringLiteral("Recovery of downloads..."), Logger::Info);
 		m_getAll = true;
 		if (m_getAllDownloading.isEmpty()) {
-			getAllFinishedImages(QList<QSharedPointer<Image>>());
+			getAllFinishedImages(QList<QList<BatchDownloadImage>>());
 		} else {
 			for (const auto &download : qAsConst(m_getAllDownloading)) {
 				getAllGetImage(download, download.siteId(m_groupBatchs));
@@ -24,14 +24,17 @@ class DownloadGroupTableModel;
 class DownloadImageTableModel;
 class DownloadQueryGroup;
 class DownloadQueryImage;
+class DownloadQuerySnapshot;
 class DownloadQueue;
 class ImageDownloader;
 struct ImageSaveResult;
 class PackLoader;
 class Page;
 class Profile;
+class ProgressAggregator;
 class QElapsedTimer;
 class QTimer;
+class SessionManager;
 class MainWindow;
 
 class DownloadsTab : public QWidget
@@ -76,12 +79,15 @@ class DownloadsTab : public QWidget
 		bool saveLinkListDefault();
 		bool saveLinkList(const QString &filename, bool saveProgress = true);
 		bool loadLinkList(const QString &filename);
+		bool restoreLinkList();
+		void restoreNextUniques();
+		void finishRestore();
 
 		// Download
 		void batchSel();
 		void getAll(bool all = true);
 		void getAllFinishedPage(Page *page);
-		void getAllFinishedImages(const QList<QSharedPointer<Image>> &images);
+		void getAllFinishedImages(const QList<QList<BatchDownloadImage>> &packs);
 		void getAllImages();
 		void getAllGetImage(const BatchDownloadImage &download, int siteId);
 		void getAllGetImageSaved(const QSharedPointer<Image> &img, QList<ImageSaveResult> result);
@@ -93,9 +99,10 @@ class DownloadsTab : public QWidget
 		void getNextPack();
 		void getAllGetPages();
 		void getAllFinished();
-		void getAllFinishedLogin(Site *site, Site::LoginResult result);
 		void getAllFinishedLogins();
 		int getRowForSite(int siteId);
+		static QString siteKey(const QSharedPointer<Image> &img);
+		int getRowForPackLoader(PackLoader *packLoader) const;
 		void getAllImageOk(const BatchDownloadImage &download, int siteId, bool retry = false);
 		void imageUrlChanged(const QUrl &before, const QUrl &after);
 		void _getAll();
@@ -109,6 +116,9 @@ class DownloadsTab : public QWidget
 		void changeEvent(QEvent *event) override;
 		void closeEvent(QCloseEvent *event) override;
 		QSet<int> selectedRows(QTableView *table) const;
+		void appendGroups(const QList<DownloadQueryGroup> &groups);
+		void appendUniques(const QList<DownloadQueryImage> &uniques);
+		void releaseExiftool();
 
 	private:
 		Ui::DownloadsTab *ui;
@@ -119,6 +129,7 @@ class DownloadsTab : public QWidget
 
 		int m_getAllDownloaded, m_getAllExists, m_getAllIgnored, m_getAllIgnoredPre, m_getAll404s, m_getAllErrors, m_getAllSkipped, m_getAllResumed, m_getAllLimit;
 		bool m_getAll;
+		bool m_exiftoolHeld = false;
 		BatchWindow *m_progressDialog;
 		QMap<QUrl, QElapsedTimer> m_downloadTime;
 		QMap<QUrl, QElapsedTimer> m_downloadTimeLast;
@@ -129,13 +140,18 @@ class DownloadsTab : public QWidget
 		QList<DownloadQueryGroup> m_groupBatchs;
 		QList<BatchDownloadImage> m_getAllRemaining, m_getAllDownloading, m_getAllFailed, m_getAllSkippedImages;
 		QMap<QSharedPointer<Image>, ImageDownloader*> m_getAllImageDownloaders;
+		ProgressAggregator *m_progressAggregator;
 		QMap<QString, QIcon> m_icons;
 		QQueue<PackLoader*> m_waitingPackLoaders;
-		PackLoader *m_currentPackLoader = nullptr;
-		QList<Site*> m_getAllLogins;
+		QList<PackLoader*> m_currentPackLoaders;
+		SessionManager *m_sessionManager;
 		int m_batchAutomaticRetries, m_getAllImagesCount, m_batchCurrentPackSize;
 		QAtomicInt m_getAllCurrentlyProcessing;
+		QHash<QString, int> m_getAllSiteDownloading;
+		int m_getAllSiteLimit = 0;
+		int m_getAllParked = 0;
 		QTimer *m_saveLinkList;
+		DownloadQuerySnapshot *m_restoreSnapshot;
 		DownloadGroupTableModel *m_groupBatchsModel;
 		DownloadImageTableModel *m_batchsModel;
 		QSoundEffect m_finishedSoundEffect;
@@ -1,8 +1,13 @@
 #include "tabs/favorites-tab.h"
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QMenu>
 #include <QMessageBox>
+#include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
+#include <QtConcurrent>
 #include <QtMath>
 #include <ui_favorites-tab.h>
 #include <algorithm>
@@ -22,6 +27,9 @@
 #include "ui/text-edit.h"
 
 #define FAVORITES_THUMB_SIZE 150
+#define VISIBLE_FAVORITES_DELAY 50
+#define FAVORITES_LOAD_SCREENS 1
+#define FAVORITES_THUMBNAILS_CACHE_SIZE (20 * 1024)
 
 
 FavoritesTab::FavoritesTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent)
@@ -62,6 +70,7 @@ FavoritesTab::FavoritesTab(Profile *profile, DownloadQueue *downloadQueue, MainW
 	ui_buttonFirstPage = ui->buttonFirstPage;
 	ui_buttonPreviousPage = ui->buttonPreviousPage;
 	ui_scrollAreaResults = ui->scrollAreaResults;
+	initResultsScrollArea();
 
 	// Search field
 	m_postFiltering = createAutocomplete();
@@ -87,6 +96,15 @@ FavoritesTab::FavoritesTab(Profile *profile, DownloadQueue *downloadQueue, MainW
 	closeShortcut->setContext(Qt::WidgetWithChildrenShortcut);
 	connect(closeShortcut, &QShortcut::activated, this, &FavoritesTab::favoritesBack);
 
+	// Only load the thumbnails of visible favorites
+	m_thumbnails.setMaxCost(FAVORITES_THUMBNAILS_CACHE_SIZE);
+	m_visibleFavoritesTimer.setSingleShot(true);
+	m_visibleFavoritesTimer.setInterval(VISIBLE_FAVORITES_DELAY);
+	connect(&m_visibleFavoritesTimer, &QTimer::timeout, this, &FavoritesTab::updateVisibleFavorites);
+	QScrollBar *scrollBar = ui->scrollArea->verticalScrollBar();
+	connect(scrollBar, &QScrollBar::valueChanged, [this]() { m_visibleFavoritesTimer.start(); });
+	connect(scrollBar, &QScrollBar::rangeChanged, [this]() { m_visibleFavoritesTimer.start(); });
+
 	connect(m_profile, &Profile::favoritesChanged, this, &FavoritesTab::updateFavorites);
 	updateFavorites();
 }
@@ -131,6 +149,7 @@ void FavoritesTab::updateFavorites()
 	}
 
 	clearLayout(m_favoritesLayout);
+	m_lazyThumbnails.clear();
 
 	if (m_favorites.isEmpty()) {
 		ui->labelFavorites->setText(tr("You don't have any favorite yet."));
@@ -164,9 +183,7 @@ void FavoritesTab::updateFavorites()
 		if (display.contains("i")) {
 			const bool resizeInsteadOfCropping = m_settings->value("resizeInsteadOfCropping", true).toBool();
 
-			QPixmap img = fav.getImage();
 			QBouton *image = new QBouton(fav.getName(), resizeInsteadOfCropping, false, 0, QColor(), this);
-				image->scale(img, QSize(imageSize, imageSize));
 				image->setFixedSize(dim, dim);
 				image->setFlat(true);
 				image->setToolTip(xt);
@@ -178,6 +195,7 @@ void FavoritesTab::updateFavorites()
 			{ image->setCounter(QString::number(maxNewImages) + (!precise ? "+" : QString())); }
 
 			l->addWidget(image);
+			m_lazyThumbnails.append(LazyThumbnail { image, fav });
 		}
 
 		QString label;
@@ -206,6 +224,86 @@ void FavoritesTab::updateFavorites()
 
 		m_favoritesLayout->addWidget(w);
 	}
+
+	m_visibleFavoritesTimer.start();
+}
+
+/**
+ * Load the thumbnails of the favorites which are visible or close to it.
+ */
+void FavoritesTab::updateVisibleFavorites()
+{
+	if (!isVisible() || m_lazyThumbnails.isEmpty()) {
+		return;
+	}
+
+	QWidget *viewport = ui->scrollArea->viewport();
+	const int height = viewport->height();
+	const QRect loadArea = viewport->rect().adjusted(0, -height * FAVORITES_LOAD_SCREENS, 0, height * FAVORITES_LOAD_SCREENS);
+
+	for (auto it = m_lazyThumbnails.begin(); it != m_lazyThumbnails.end();) {
+		QBouton *button = it->button.data();
+		if (button == nullptr) {
+			it = m_lazyThumbnails.erase(it);
+			continue;
+		}
+
+		const QRect geometry(button->mapTo(viewport, QPoint(0, 0)), button->size());
+		if (viewport->isAncestorOf(button) && loadArea.intersects(geometry)) {
+			loadFavoriteThumbnail(button, it->favorite);
+			it = m_lazyThumbnails.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/**
+ * Set a favorite's thumbnail from the cache, or decode it in the background.
+ */
+void FavoritesTab::loadFavoriteThumbnail(QBouton *button, const Favorite &fav)
+{
+	const QString path = fav.getImagePath();
+	if (path.isEmpty()) {
+		return;
+	}
+
+	const qreal upscale = m_settings->value("thumbnailUpscale", 1.0).toDouble();
+	const int imageSize = qFloor(FAVORITES_THUMB_SIZE * upscale);
+
+	// The thumbnail file is overwritten when changing a favorite's image, so its date is part of the key
+	const QString key = path + "|" + QString::number(QFileInfo(path).lastModified().toMSecsSinceEpoch());
+	QPixmap *cached = m_thumbnails.object(key);
+	if (cached != nullptr) {
+		button->scale(*cached, QSize(imageSize, imageSize));
+		return;
+	}
+
+	QPointer<QBouton> guard(button);
+	auto *watcher = new QFutureWatcher<QImage>(this);
+	connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, guard, key, imageSize]() {
+		const QImage image = watcher->result();
+		watcher->deleteLater();
+		if (image.isNull()) {
+			return;
+		}
+
+		auto *pixmap = new QPixmap(QPixmap::fromImage(image));
+		const int cost = qMax(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8 / 1024);
+		if (!guard.isNull()) {
+			guard->scale(*pixmap, QSize(imageSize, imageSize));
+		}
+		m_thumbnails.insert(key, pixmap, cost);
+	});
+	watcher->setFuture(QtConcurrent::run([fav]() {
+		return fav.getThumbnail();
+	}));
+}
+
+void FavoritesTab::showEvent(QShowEvent *event)
+{
+	SearchTab::showEvent(event);
+	m_visibleFavoritesTimer.start();
 }
 
 
@@ -2,7 +2,12 @@
 #define FAVORITES_TAB_H
 
 #include "tabs/search-tab.h"
+#include <QCache>
 #include <QDateTime>
+#include <QPixmap>
+#include <QPointer>
+#include <QTimer>
+#include "models/favorite.h"
 
 
 namespace Ui
@@ -13,6 +18,7 @@ namespace Ui
 
 class MainWindow;
 class Page;
+class QBouton;
 class QMenu;
 
 class FavoritesTab : public SearchTab
@@ -29,6 +35,8 @@ class FavoritesTab : public SearchTab
 
 	protected:
 		void changeEvent(QEvent *event) override;
+		void showEvent(QShowEvent *event) override;
+		void loadFavoriteThumbnail(QBouton *button, const Favorite &fav);
 		void thumbnailContextMenu(QMenu *menu, const QSharedPointer<Image> &img) override;
 
 	public slots:
@@ -43,6 +51,7 @@ class FavoritesTab : public SearchTab
 		// Favorites
 		void favoriteProperties(const QString &name);
 		void updateFavorites();
+		void updateVisibleFavorites();
 		void loadFavorite(const QString &name);
 		void checkFavorites();
 		void loadNextFavorite();
@@ -62,6 +71,16 @@ class FavoritesTab : public SearchTab
 		QString m_currentTags;
 		int m_currentFav;
 		FixedSizeGridLayout *m_favoritesLayout;
+
+		// Favorite thumbnails are only loaded once visible
+		struct LazyThumbnail
+		{
+			QPointer<QBouton> button;
+			Favorite favorite;
+		};
+		QList<LazyThumbnail> m_lazyThumbnails;
+		QCache<QString, QPixmap> m_thumbnails;
+		QTimer m_visibleFavoritesTimer;
 };
 
 #endif // FAVORITES_TAB_H
@@ -50,6 +50,7 @@ GalleryTab::GalleryTab(Profile *profile, DownloadQueue *downloadQueue, MainWindo
 	ui_buttonFirstPage = ui->buttonFirstPage;
 	ui_buttonPreviousPage = ui->buttonPreviousPage;
 	ui_scrollAreaResults = ui->scrollAreaResults;
+	initResultsScrollArea();
 
 	// Post-filtering
 	m_postFiltering = createAutocomplete();
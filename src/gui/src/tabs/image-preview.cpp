@@ -8,6 +8,7 @@
 #include <QMovie>
 #include <QRandomGenerator>
 #include <QSettings>
+#include <QtConcurrent>
 #include <QtMath>
 #include <QUrl>
 #include <QVBoxLayout>
@@ -22,6 +23,8 @@
 #include "models/profile.h"
 #include "models/site.h"
 #include "network/network-reply.h"
+#include "threads/resizer.h"
+#include "utils/thumbnail-cache.h"
 #include "ui/QBouton.h"
 
 
@@ -34,6 +37,9 @@ ImagePreview::ImagePreview(QSharedPointer<Image> image, QWidget *container, Prof
 	m_name = image->name();
 	m_childrenCount = image->counter().toInt();
 
+	const QString siteUrl = image->parentSite() != nullptr ? image->parentSite()->url() : QString();
+	m_cacheKey = ThumbnailCache::key(siteUrl, !image->md5().isEmpty() ? image->md5() : m_thumbnailUrl.toString());
+
 	auto *layout = new QVBoxLayout();
 	layout->setContentsMargins(0, 0, 0, 0);
 	container->setLayout(layout);
@@ -75,7 +81,32 @@ void ImagePreview::showLoadingMessage()
 
 void ImagePreview::load()
 {
+	m_loaded = true;
+
+	// The thumbnail might still be in memory if it was loaded by another preview of the same image
+	if (m_reply == nullptr && !m_image->previewImage().isNull()) {
+		finishedLoading();
+		return;
+	}
+
 	if (m_thumbnailUrl.isValid()) {
+		// Try the thumbnail cache before the network, unless we're already following a redirection
+		if (m_reply == nullptr) {
+			ThumbnailCache *cache = m_profile->thumbnailCache();
+			const QImage image = cache->image(m_cacheKey);
+			if (!image.isNull()) {
+				m_image->setPreviewImage(QPixmap::fromImage(image));
+				resizeThumbnail(image, QByteArray(), true);
+				return;
+			}
+			const QByteArray data = cache->data(m_cacheKey);
+			if (!data.isEmpty()) {
+				showLoadingMessage();
+				resizeThumbnail(QImage(), data, true);
+				return;
+			}
+		}
+
 		if (m_reply != nullptr) {
 			m_reply->deleteLater();
 		} else {
@@ -90,10 +121,37 @@ void ImagePreview::load()
 	}
 }
 
+void ImagePreview::unload()
+{
+	if (!m_loaded) {
+		return;
+	}
+	m_loaded = false;
+
+	if (m_reply != nullptr) {
+		m_reply->disconnect(this);
+		if (m_reply->isRunning()) {
+			m_reply->abort();
+		}
+		m_reply->deleteLater();
+		m_reply = nullptr;
+	}
+
+	// Keep the same size so that the rest of the grid doesn't move
+	m_container->setMinimumSize(m_container->size());
+	clearLayout(m_container->layout());
+	m_bouton = nullptr;
+	m_resizer = nullptr;
+	m_cacheData.clear();
+	m_thumbnail = QPixmap();
+
+	m_image->setPreviewImage(QPixmap());
+}
+
 void ImagePreview::abort()
 {
 	m_aborted = true;
-	if (m_reply->isRunning()) {
+	if (m_reply != nullptr && m_reply->isRunning()) {
 		m_reply->abort();
 	}
 }
@@ -147,35 +205,107 @@ void ImagePreview::finishedLoadingPreview()
 		return;
 	}
 
-	// Load preview from result
-	QPixmap thumbnail;
-	thumbnail.loadFromData(m_reply->readAll());
-	if (thumbnail.isNull()) {
-		log(QStringLiteral("One of the thumbnails is empty (`%1`).").arg(m_image->url(Image::Size::Thumbnail).toString()), Logger::Error);
-		if (m_image->hasTag(QStringLiteral("flash"))) {
-			thumbnail.load(QStringLiteral(":/images/flash.png"));
-		} else {
-			return;
-		}
+	resizeThumbnail(QImage(), m_reply->readAll(), false);
+}
+
+/**
+ * Decode and scale the thumbnail on a worker thread, the resizer deleting itself once done.
+ */
+void ImagePreview::resizeThumbnail(const QImage &image, const QByteArray &data, bool fromCache)
+{
+	m_fromCache = fromCache;
+	m_cacheData = fromCache ? QByteArray() : data;
+
+	m_resizer = new Resizer();
+	if (!data.isEmpty()) {
+		m_resizer->setInput(data);
+	} else {
+		m_resizer->setInput(image);
+	}
+	m_resizer->setSize(thumbnailSize());
+	connect(m_resizer, &Resizer::loaded, this, &ImagePreview::thumbnailDecoded);
+	connect(m_resizer, &Resizer::finished, this, &ImagePreview::thumbnailResized);
+	connect(m_resizer, &Resizer::error, this, &ImagePreview::thumbnailFailed);
+	connect(m_resizer, &Resizer::finished, m_resizer, &QObject::deleteLater);
+	connect(m_resizer, &Resizer::error, m_resizer, &QObject::deleteLater);
+	QtConcurrent::run(m_resizer, &Resizer::run);
+}
+
+void ImagePreview::thumbnailDecoded(const QImage &thumbnail)
+{
+	if (sender() != m_resizer) {
+		return;
+	}
+
+	m_image->setPreviewImage(QPixmap::fromImage(thumbnail));
+
+	// Only valid thumbnails are stored in the cache
+	ThumbnailCache *cache = m_profile->thumbnailCache();
+	cache->setImage(m_cacheKey, thumbnail);
+	if (!m_cacheData.isEmpty()) {
+		cache->setData(m_cacheKey, m_cacheData);
+		m_cacheData.clear();
+	}
+}
+
+void ImagePreview::thumbnailResized(const QImage &thumbnail)
+{
+	if (sender() != m_resizer) {
+		return;
+	}
+	m_resizer = nullptr;
+
+	m_thumbnail = QPixmap::fromImage(thumbnail);
+	finishedLoading();
+}
+
+void ImagePreview::thumbnailFailed()
+{
+	if (sender() != m_resizer) {
+		return;
+	}
+	m_resizer = nullptr;
+	m_cacheData.clear();
+
+	// Invalid cached thumbnails are removed and loaded again from the network
+	if (m_fromCache) {
+		m_profile->thumbnailCache()->remove(m_cacheKey);
+		load();
+		return;
+	}
+
+	log(QStringLiteral("One of the thumbnails is empty (`%1`).").arg(m_image->url(Image::Size::Thumbnail).toString()), Logger::Error);
+	if (!m_image->hasTag(QStringLiteral("flash"))) {
+		return;
 	}
-	m_image->setPreviewImage(thumbnail);
 
+	m_image->setPreviewImage(QPixmap(QStringLiteral(":/images/flash.png")));
 	finishedLoading();
 }
 
+QSize ImagePreview::thumbnailSize() const
+{
+	const qreal upscale = m_profile->getSettings()->value("thumbnailUpscale", 1.0).toDouble();
+	const int imageSize = qFloor(150 * upscale);
+	return QSize(imageSize, imageSize);
+}
+
 void ImagePreview::finishedLoading()
 {
 	auto *layout = m_container->layout();
 
 	clearLayout(layout);
 
-	if (m_reply != nullptr) {
+	// Unless the container has a fixed size, let it fit the thumbnail once it is loaded
+	if (m_container->minimumSize() != m_container->maximumSize()) {
+		m_container->setMinimumSize(0, 0);
+	}
+
+	if (m_thumbnailUrl.isValid()) {
 		QSettings *settings = m_profile->getSettings();
 		const bool resizeInsteadOfCropping = settings->value("resizeInsteadOfCropping", true).toBool();
 		const bool resultsScrollArea = settings->value("resultsScrollArea", true).toBool();
 		const int borderSize = settings->value("borders", 3).toInt();
-		const qreal upscale = settings->value("thumbnailUpscale", 1.0).toDouble();
-		const int imageSize = qFloor(150 * upscale);
 
 		QBouton *l = new QBouton(0, resizeInsteadOfCropping, resultsScrollArea, borderSize, m_image->color(), m_container);
 		l->setCheckable(true);
@@ -184,11 +314,12 @@ void ImagePreview::finishedLoading()
 		l->setInvertToggle(settings->value("invertToggle", false).toBool());
 		l->setToolTip(m_image->tooltip());
 
-		const QPixmap &thumbnail = m_image->previewImage();
+		// The thumbnail was usually already scaled off the GUI thread
+		const QPixmap thumbnail = !m_thumbnail.isNull() ? m_thumbnail : m_image->previewImage();
 		if (thumbnail.isNull()) {
-			l->scale(QPixmap(":/images/noimage.png"), QSize(imageSize, imageSize));
+			l->scale(QPixmap(":/images/noimage.png"), thumbnailSize());
 		} else {
-			l->scale(thumbnail, QSize(imageSize, imageSize));
+			l->scale(thumbnail, thumbnailSize());
 		}
 		if (m_childrenCount > 0) {
 			l->setCounter(QString::number(m_childrenCount));
@@ -205,7 +336,11 @@ void ImagePreview::finishedLoading()
 		layout->addWidget(new QLabel(m_name));
 	}
 
-	emit finished();
+	// Only notify the first time, not when the thumbnail is loaded again after having been released
+	if (!m_finished) {
+		m_finished = true;
+		emit finished();
+	}
 }
 
 void ImagePreview::toggledWithId(int id, bool toggle, bool range)
@@ -2,10 +2,13 @@
 #define IMAGE_PREVIEW_H
 
 #include <functional>
+#include <QByteArray>
 #include <QObject>
+#include <QImage>
 #include <QPixmap>
 #include <QPointer>
 #include <QSharedPointer>
+#include <QSize>
 #include <QString>
 #include <QUrl>
 
@@ -19,7 +22,14 @@ class QBouton;
 class QMenu;
 class QMovie;
 class QWidget;
+class Resizer;
 
+/**
+ * Thumbnail of an image in a results grid.
+ *
+ * The thumbnail is only loaded when load() is called, and can be released with unload() while keeping the container
+ * at the same size, so that results that are not visible don't keep their widgets and pixmaps in memory.
+ */
 class ImagePreview : public QObject
 {
 	Q_OBJECT
@@ -28,9 +38,12 @@ class ImagePreview : public QObject
 		ImagePreview(QSharedPointer<Image> image, QWidget *container, Profile *profile, DownloadQueue *downloadQueue, MainWindow *mainWindow, QObject *parent = nullptr);
 		~ImagePreview();
 		void setCustomContextMenu(std::function<void (QMenu *, const QSharedPointer<Image> &)> customContextMenu);
+		QWidget *container() const { return m_container; }
+		bool isLoaded() const { return m_loaded; }
 
 	public slots:
 		void load();
+		void unload();
 		void abort();
 		void setChecked(bool checked);
 		void setDownloadProgress(qint64 v1, qint64 v2);
@@ -38,9 +51,14 @@ class ImagePreview : public QObject
 	protected:
 		void showLoadingMessage();
 		void finishedLoading();
+		QSize thumbnailSize() const;
+		void resizeThumbnail(const QImage &image, const QByteArray &data, bool fromCache);
 
 	protected slots:
 		void finishedLoadingPreview();
+		void thumbnailDecoded(const QImage &thumbnail);
+		void thumbnailResized(const QImage &thumbnail);
+		void thumbnailFailed();
 		void customContextMenuRequested();
 		void contextSaveImage();
 		void contextSaveImageAs();
@@ -61,8 +79,15 @@ class ImagePreview : public QObject
 		static QMovie *m_loadingMovie;
 
 		NetworkReply *m_reply = nullptr;
+		Resizer *m_resizer = nullptr;
+		QPixmap m_thumbnail;
+		QString m_cacheKey;
+		QByteArray m_cacheData;
+		bool m_fromCache = false;
 		bool m_aborted = false;
 		bool m_checked = false;
+		bool m_loaded = false;
+		bool m_finished = false;
 
 		QUrl m_thumbnailUrl;
 		QString m_name;
@@ -1,14 +1,21 @@
 #include "tabs/log-tab.h"
+#include <QApplication>
+#include <QClipboard>
 #include <QDesktopServices>
 #include <QDir>
 #include <QFile>
-#include <QRegularExpression>
+#include <QModelIndex>
 #include <QScrollBar>
+#include <QShortcut>
+#include <algorithm>
 #include <ui_log-tab.h>
 #include "functions.h"
 #include "helpers.h"
 #include "logger.h"
-#include "utils/logging.h"
+#include "utils/log-model.h"
+
+// Older messages can still be read in the log file
+#define MAX_LOG_LINES 10000
 
 
 LogTab::LogTab(QWidget *parent)
@@ -16,16 +23,38 @@ LogTab::LogTab(QWidget *parent)
 {
 	ui->setupUi(this);
 
-	// Load already written log
+	m_model = new LogModel(MAX_LOG_LINES, this);
+	ui->listLog->setModel(m_model);
+	ui->comboLevel->setCurrentIndex(Logger::Debug);
+
+	connect(ui->comboLevel, SIGNAL(currentIndexChanged(int)), this, SLOT(setMinimumLevel(int)));
+	connect(ui->lineSearch, &QLineEdit::textChanged, m_model, &LogModel::setSearch);
+	connect(ui->listLog, &QListView::doubleClicked, this, &LogTab::openLink);
+	connect(new QShortcut(QKeySequence::Copy, ui->listLog, nullptr, nullptr, Qt::WidgetShortcut), &QShortcut::activated, this, &LogTab::copySelection);
+
+	// Only follow new messages if the view was already scrolled to the bottom
+	connect(m_model, &LogModel::rowsAboutToBeInserted, this, &LogTab::rowsAboutToBeInserted);
+	connect(m_model, &LogModel::rowsInserted, this, &LogTab::rowsInserted);
+	connect(m_model, &LogModel::modelReset, ui->listLog, &QListView::scrollToBottom);
+
+	// Load already written log, only reading its end as older lines would not fit in the model anyway
 	QFile logFile(Logger::getInstance().logFile());
 	if (logFile.open(QFile::ReadOnly | QFile::Text)) {
+		const qint64 maxSize = static_cast<qint64>(MAX_LOG_LINES) * 200;
+		if (logFile.size() > maxSize) {
+			logFile.seek(logFile.size() - maxSize);
+			logFile.readLine(); // Skip the partial line
+		}
+
+		QStringList lines;
 		while (!logFile.atEnd()) {
-			write(logFile.readLine());
+			lines.append(logFile.readLine());
 		}
 		logFile.close();
+		writeAll(lines);
 	}
 
-	connect(&Logger::getInstance(), &Logger::newLog, this, &LogTab::write);
+	connect(&Logger::getInstance(), &Logger::newLogs, this, &LogTab::writeAll);
 }
 
 LogTab::~LogTab()
@@ -36,8 +65,16 @@ LogTab::~LogTab()
 
 void LogTab::write(const QString &msg)
 {
-	ui->labelLog->appendHtml(logToHtml(msg));
-	ui->labelLog->verticalScrollBar()->setValue(ui->labelLog->verticalScrollBar()->maximum());
+	m_model->add(QStringList() << msg);
+}
+
+void LogTab::writeAll(const QStringList &messages)
+{
+	if (messages.isEmpty()) {
+		return;
+	}
+
+	m_model->add(messages);
 }
 
 void LogTab::clear()
@@ -48,7 +85,7 @@ void LogTab::clear()
 		logFile.close();
 	}
 
-	ui->labelLog->clear();
+	m_model->clear();
 }
 
 void LogTab::open()
@@ -64,6 +101,45 @@ void LogTab::openDir()
 	}
 }
 
+void LogTab::setMinimumLevel(int level)
+{
+	m_model->setMinimumLevel(static_cast<Logger::LogLevel>(level));
+}
+
+void LogTab::copySelection()
+{
+	QModelIndexList indexes = ui->listLog->selectionModel()->selectedIndexes();
+	std::sort(indexes.begin(), indexes.end());
+
+	QStringList lines;
+	lines.reserve(indexes.count());
+	for (const QModelIndex &index : qAsConst(indexes)) {
+		lines.append(index.data().toString());
+	}
+	QApplication::clipboard()->setText(lines.join('\n'));
+}
+
+void LogTab::openLink(const QModelIndex &index)
+{
+	const QString link = index.data(LogModel::LinkRole).toString();
+	if (!link.isEmpty()) {
+		QDesktopServices::openUrl(link);
+	}
+}
+
+void LogTab::rowsAboutToBeInserted()
+{
+	const QScrollBar *scrollBar = ui->listLog->verticalScrollBar();
+	m_atBottom = scrollBar->value() >= scrollBar->maximum();
+}
+
+void LogTab::rowsInserted()
+{
+	if (m_atBottom) {
+		ui->listLog->scrollToBottom();
+	}
+}
+
 void LogTab::changeEvent(QEvent *event)
 {
 	// Automatically re-translate this tab on language change
@@ -1,6 +1,7 @@
 #ifndef LOG_TAB_H
 #define LOG_TAB_H
 
+#include <QStringList>
 #include <QWidget>
 
 
@@ -10,6 +11,9 @@ namespace Ui
 }
 
 
+class LogModel;
+class QModelIndex;
+
 class LogTab : public QWidget
 {
 	Q_OBJECT
@@ -20,15 +24,25 @@ class LogTab : public QWidget
 
 	public slots:
 		void write(const QString &msg);
+		void writeAll(const QStringList &messages);
 		void clear();
 		void open();
 		void openDir();
 
+	protected slots:
+		void setMinimumLevel(int level);
+		void copySelection();
+		void openLink(const QModelIndex &index);
+		void rowsAboutToBeInserted();
+		void rowsInserted();
+
 	protected:
 		void changeEvent(QEvent *event) override;
 
 	private:
 		Ui::LogTab *ui;
+		LogModel *m_model;
+		bool m_atBottom = true;
 };
 
 #endif // LOG_TAB_H
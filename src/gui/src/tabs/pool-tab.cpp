@@ -36,6 +36,7 @@ PoolTab::PoolTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow *par
 	ui_buttonFirstPage = ui->buttonFirstPage;
 	ui_buttonPreviousPage = ui->buttonPreviousPage;
 	ui_scrollAreaResults = ui->scrollAreaResults;
+	initResultsScrollArea();
 
 	QStringList sources = m_sites.keys();
 	for (const QString &source : sources) {
@@ -1,10 +1,14 @@
 #include "tabs/search-tab.h"
-#include <QCompleter>
+#include <QDateTime>
 #include <QEventLoop>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QMenu>
 #include <QMessageBox>
 #include <QMouseEvent>
+#include <QScrollBar>
 #include <QSet>
+#include <QtConcurrent>
 #include <QtMath>
 #include <algorithm>
 #include "downloader/download-query-image.h"
@@ -19,10 +23,13 @@
 #include "models/favorite.h"
 #include "models/filename.h"
 #include "models/filtering/post-filter.h"
+#include "models/page-cache.h"
+#include "models/page-summary-cache.h"
 #include "models/page.h"
 #include "models/profile.h"
 #include "models/site.h"
 #include "sources/sources-window.h"
+#include "tags/tag-counter.h"
 #include "tabs/image-preview.h"
 #include "ui/fixed-size-grid-layout.h"
 #include "ui/QBouton.h"
@@ -31,6 +38,10 @@
 #include "viewer/viewer-window.h"
 
 #define FIXED_IMAGE_WIDTH 150
+#define VISIBLE_PREVIEWS_DELAY 50
+#define PREVIEWS_LOAD_SCREENS 1
+#define PREVIEWS_KEEP_SCREENS 3
+#define TAGS_UPDATE_DELAY 100
 
 
 SearchTab::SearchTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent, QString screenName)
@@ -46,13 +57,28 @@ SearchTab::SearchTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow
 	for (auto it = m_sites.constBegin(); it != m_sites.constEnd(); ++it) {
 		Site *site = it.value();
 		const QStringList modifiers = site->getApis().first()->modifiers();
-		m_completion.append(modifiers);
+		m_modifiers.append(modifiers);
+		profile->getAutoCompleteIndex().add(modifiers);
 	}
-	m_completion.removeDuplicates();
+	m_modifiers.removeDuplicates();
+	m_completion.append(m_modifiers);
 
 	// Auto-complete list
 	m_completion.append(profile->getAutoComplete());
 
+	// Recently loaded pages, to go back to them without loading them again
+	m_pageCache = new PageCache(m_settings->value("pageCacheAge", 5 * 60).toInt(), m_settings->value("pageCacheSize", 20).toInt());
+
+	// Thumbnails are only loaded when they get close to the visible area
+	m_visiblePreviewsTimer.setSingleShot(true);
+	m_visiblePreviewsTimer.setInterval(VISIBLE_PREVIEWS_DELAY);
+	connect(&m_visiblePreviewsTimer, &QTimer::timeout, this, &SearchTab::updateVisiblePreviews);
+
+	// Tags are only updated once per burst of loaded pages
+	m_tagsTimer.setSingleShot(true);
+	m_tagsTimer.setInterval(m_settings->value("tagsUpdateDelay", TAGS_UPDATE_DELAY).toInt());
+	connect(&m_tagsTimer, &QTimer::timeout, this, &SearchTab::updateTags);
+
 	setSelectedSources(m_settings);
 }
 
@@ -69,6 +95,13 @@ void SearchTab::init()
 
 	if (infinite == "scroll") {
 		connect(ui_scrollAreaResults, &VerticalScrollArea::endOfScrollReached, this, &SearchTab::endlessLoad);
+
+		// Start loading the next page a bit before reaching the end, so that scrolling doesn't stop
+		if (m_settings->value("infiniteScrollPrefetchRows", 3).toInt() > 0) {
+			QScrollBar *scrollBar = ui_scrollAreaResults->verticalScrollBar();
+			connect(scrollBar, &QScrollBar::valueChanged, this, &SearchTab::prefetchEndlessLoad);
+			connect(scrollBar, &QScrollBar::rangeChanged, this, &SearchTab::prefetchEndlessLoad);
+		}
 	}
 
 	if (infinite != "disabled" && ui_checkMergeResults != nullptr) {
@@ -82,8 +115,19 @@ void SearchTab::init()
 	}
 }
 
+/**
+ * Update the visible thumbnails when the results are scrolled or resized.
+ */
+void SearchTab::initResultsScrollArea()
+{
+	QScrollBar *scrollBar = ui_scrollAreaResults->verticalScrollBar();
+	connect(scrollBar, &QScrollBar::valueChanged, [this]() { m_visiblePreviewsTimer.start(); });
+	connect(scrollBar, &QScrollBar::rangeChanged, [this]() { m_visiblePreviewsTimer.start(); });
+}
+
 SearchTab::~SearchTab()
 {
+	delete m_pageCache;
 	m_pages.clear();
 	m_images.clear();
 	qDeleteAll(m_checkboxes);
@@ -128,44 +172,118 @@ void SearchTab::optionsChanged()
 
 void SearchTab::setTagsFromPages(const QMap<QString, QList<QSharedPointer<Page>>> &pages)
 {
+	// Pages often finish loading in bursts, so only the last ones of a burst are used to update the tags
+	m_tagsPages = pages;
+	m_tagsTimer.start();
+}
+
+void SearchTab::updateTags()
+{
+	// Wait for the current update to finish, the latest pages will be used right after
+	if (m_tagsUpdating) {
+		m_tagsOutdated = true;
+		return;
+	}
+
 	// Tags for this page
-	QList<Tag> tagList;
-	QStringList tagsGot;
-	for (const auto &ps : pages) {
+	QList<QList<Tag>> pagesTags;
+	for (const auto &ps : qAsConst(m_tagsPages)) {
 		const auto page = ps.last();
-		if (!page->isValid()) {
-			continue;
+		if (page->isValid()) {
+			pagesTags.append(page->tags());
 		}
+	}
+	m_tagsPages.clear();
 
-		QList<Tag> tags = page->tags();
-		for (const Tag &tag : tags) {
-			if (!tag.text().isEmpty()) {
-				// Add to auto-complete list if it has enough count
-				if (tag.count() >= m_settings->value("tagsautoadd", 10).toInt() && !m_completion.contains(tag.text())) {
-					m_profile->addAutoComplete(tag.text());
-					m_completion.append(tag.text());
-				}
+	// Merging and sorting thousands of tags is done in a worker thread to keep the UI responsive
+	m_tagsUpdating = true;
+	const int generation = m_tagsGeneration;
+	auto *watcher = new QFutureWatcher<QList<Tag>>(this);
+	connect(watcher, &QFutureWatcher<QList<Tag>>::finished, this, [this, watcher, generation]() {
+		const QList<Tag> tags = watcher->result();
+		watcher->deleteLater();
+		m_tagsUpdating = false;
 
+		// The results were cleared while the tags were being computed
+		if (generation != m_tagsGeneration) {
+			return;
+		}
+
+		addTagsToAutoComplete(tags);
+		m_tags = tags;
+		emit tagsChanged();
+
+		if (m_tagsOutdated) {
+			m_tagsOutdated = false;
+			updateTags();
+		}
+	});
+	watcher->setFuture(QtConcurrent::run([pagesTags]() {
+		TagCounter counter;
+		for (const QList<Tag> &tags : pagesTags) {
+			for (const Tag &tag : tags) {
 				// If we already have this tag in the list, we increase its count
-				if (tagsGot.contains(tag.text())) {
-					const int index = tagsGot.indexOf(tag.text());
-					tagList[index].setCount(tagList[index].count() + tag.count());
-				} else {
-					tagList.append(tag);
-					tagsGot.append(tag.text());
+				if (!tag.text().isEmpty()) {
+					counter.add(tag, tag.count());
 				}
 			}
 		}
+
+		// We sort tags by frequency
+		return counter.sortedTags();
+	}));
+}
+
+void SearchTab::cachePageSummary(Page *page)
+{
+	if (!page->isValid()) {
+		return;
 	}
 
-	// We sort tags by frequency
-	std::sort(tagList.begin(), tagList.end(), sortTagsByCount);
+	PageSummaryCache::Summary summary;
+	summary.wiki = page->wiki();
+	summary.tags = page->tags();
+	page->site()->pageSummaryCache()->insert(page->search(), page->page(), summary);
+}
 
-	m_tags = tagList;
-	emit tagsChanged();
+/**
+ * The cached values are replaced as soon as the actual results are loaded.
+ */
+void SearchTab::loadCachedPageSummary(Page *page)
+{
+	PageSummaryCache::Summary summary;
+	if (!page->site()->pageSummaryCache()->get(page->search(), page->page(), &summary)) {
+		return;
+	}
+
+	if (m_wiki.isEmpty() && !summary.wiki.isEmpty()) {
+		m_wiki = summary.wiki;
+		emit wikiChanged();
+	}
+	if (m_tags.isEmpty() && !summary.tags.isEmpty()) {
+		m_tags = summary.tags;
+		emit tagsChanged();
+	}
+}
+
+void SearchTab::addTagsToAutoComplete(const QList<Tag> &tags)
+{
+	const int minCount = m_settings->value("tagsautoadd", 10).toInt();
+	for (const Tag &tag : tags) {
+		// Add to auto-complete list if it has enough count
+		if (tag.count() >= minCount) {
+			if (!m_completion.contains(tag.text())) {
+				m_profile->addAutoComplete(tag.text());
+				m_completion.append(tag.text());
+			}
+
+			// Keep the suggestions ranked using the latest post counts
+			m_profile->getAutoCompleteIndex().add(tag.text(), tag.count());
+		}
+	}
 }
 
-QStringList SearchTab::reasonsToFail(Page *page, const QStringList &completion, QString *meant)
+QStringList SearchTab::reasonsToFail(Page *page, const QStringList &modifiers, QString *meant)
 {
 	QStringList reasons = QStringList();
 
@@ -199,33 +317,39 @@ QStringList SearchTab::reasonsToFail(Page *page, const QStringList &completion,
 	// Auto-correct
 	if (meant != nullptr && !page->search().isEmpty()) {
 		QMap<QString, QString> results, clean;
-		QList<QChar> modifiers { '~', '-' };
+		QList<QChar> prefixes { '~', '-' };
 
 		int c = 0;
 		for (QString tag : page->search()) {
 			QChar modifier;
-			if (modifiers.contains(tag[0])) {
+			if (prefixes.contains(tag[0])) {
 				modifier = tag[0];
 				tag = tag.mid(1);
 			}
 
+			// Site modifiers are few, so they are simply checked one by one before looking in the auto-complete tree
 			int lev = qCeil((tag.length() - 1) / 4.0);
-			for (const QString &comp : completion) {
-				// Ignore tags that are too long
-				if (abs(comp.length() - tag.length()) > lev) {
-					continue;
-				}
-
-				const int d = levenshtein(tag, comp);
+			QString found;
+			for (const QString &comp : modifiers) {
+				const int d = levenshtein(tag, comp, lev - 1);
 				if (d < lev) {
-					if (results[tag].isEmpty()) {
-						c++;
-					}
-					results[tag] = "<b>" + comp + "</b>";
-					clean[tag] = comp;
+					found = comp;
 					lev = d;
 				}
 			}
+			int treeDistance;
+			const QString treeFound = m_profile->getAutoCompleteTree().closest(tag, lev - 1, &treeDistance);
+			if (!treeFound.isEmpty()) {
+				found = treeFound;
+				lev = treeDistance;
+			}
+			if (!found.isEmpty()) {
+				if (results[tag].isEmpty()) {
+					c++;
+				}
+				results[tag] = "<b>" + found + "</b>";
+				clean[tag] = found;
+			}
 
 			if (lev == 0) {
 				results[tag] = tag;
@@ -256,7 +380,11 @@ void SearchTab::clear()
 	m_pageMax = -1;
 	m_endlessLoadOffset = 0;
 
-	// Clear page details
+	// Clear page details, dropping any pending tags update
+	m_tagsTimer.stop();
+	m_tagsPages.clear();
+	m_tagsOutdated = false;
+	m_tagsGeneration++;
 	m_tags.clear();
 	emit tagsChanged();
 	m_wiki.clear();
@@ -295,6 +423,7 @@ void SearchTab::clear()
 
 	m_pages.clear();
 	m_images.clear();
+	m_mergedProportions.clear();
 
 	m_selectedImagesPtrs.clear();
 	m_thumbnailsLoading.clear();
@@ -309,10 +438,7 @@ TextEdit *SearchTab::createAutocomplete()
 
 	// Add auto-complete if necessary
 	if (m_settings->value("autocompletion", true).toBool()) {
-		auto *completer = new QCompleter(m_completion, ret);
-		completer->setCaseSensitivity(Qt::CaseInsensitive);
-
-		ret->setCompleter(completer);
+		ret->setAutoCompleteIndex(&m_profile->getAutoCompleteIndex());
 	}
 
 	return ret;
@@ -371,13 +497,18 @@ void SearchTab::finishedLoading(Page *page)
 	const bool merged = ui_checkMergeResults != nullptr && ui_checkMergeResults->isChecked();
 	const QList<QSharedPointer<Image>> images = merged ? mergeResults(page->page(), validImages) : validImages;
 
-	m_images.append(images);
+	if (merged) {
+		insertMergedImages(images);
+	} else {
+		m_images.append(images);
+	}
 
 	updatePaginationButtons(page);
 	addResultsPage(page, images, merged, filteredImages);
 
 	if (!m_settings->value("useregexfortags", true).toBool()) {
 		setTagsFromPages(m_pages);
+		cachePageSummary(page);
 	}
 
 	postLoading(page, images);
@@ -464,8 +595,18 @@ void SearchTab::postLoading(Page *page, const QList<QSharedPointer<Image>> &imag
 		}
 	}
 
-	// Load thumbnails
-	for (const auto &img : images) {
+	// Load thumbnails, in the order of their position in the merged results so that each can be inserted at its place
+	QList<QSharedPointer<Image>> thumbnails = images;
+	if (merged) {
+		QHash<Image*, int> positions;
+		for (int i = 0; i < m_images.count(); ++i) {
+			positions.insert(m_images[i].data(), i);
+		}
+		std::sort(thumbnails.begin(), thumbnails.end(), [&positions](const QSharedPointer<Image> &a, const QSharedPointer<Image> &b) {
+			return positions.value(a.data()) < positions.value(b.data());
+		});
+	}
+	for (const auto &img : qAsConst(thumbnails)) {
 		addResultsImage(img, page, merged);
 	}
 
@@ -519,10 +660,11 @@ void SearchTab::finishedLoadingTags(Page *page)
 	setTagsFromPages(m_pages);
 
 	// Wiki
-	if (!page->wiki().isEmpty()) {
+	if (!page->wiki().isEmpty() && page->wiki() != m_wiki) {
 		m_wiki = page->wiki();
 		emit wikiChanged();
 	}
+	cachePageSummary(page);
 
 	updatePaginationButtons(page);
 
@@ -609,46 +751,89 @@ double getImageKnownTagProportion(const QSharedPointer<Image> &img)
 	return (static_cast<double>(known) / static_cast<double>(img->tags().count()));
 }
 
+/**
+ * Remove the images already shown in the results, keeping the version with the most known tags among the sites.
+ */
 QList<QSharedPointer<Image>> SearchTab::mergeResults(int page, const QList<QSharedPointer<Image>> &results)
 {
-	QMap<QString, double> pageMd5s;
-	for (const QSharedPointer<Image> &img : qAsConst(m_images)) {
-		QString md5 = img->md5();
+	QList<QSharedPointer<Image>> ret;
+	for (const QSharedPointer<Image> &img : results) {
+		const QString md5 = img->md5();
 		if (md5.isEmpty()) {
+			ret.append(img);
+			continue;
+		}
+
+		// Images shown in a previous page are not shown again
+		if (containsMergedMd5(page, md5)) {
 			continue;
 		}
 
 		const double proportion = getImageKnownTagProportion(img);
-		pageMd5s[md5] = proportion;
-		addMergedMd5(page, md5);
+		auto it = m_mergedProportions.find(md5);
+		if (it == m_mergedProportions.end()) {
+			m_mergedProportions.insert(md5, proportion);
+			addMergedMd5(page, md5);
+			ret.append(img);
+		} else if (proportion > it.value()) {
+			it.value() = proportion;
+			for (QList<QSharedPointer<Image>> *list : { &m_images, &ret }) {
+				for (QSharedPointer<Image> &existing : *list) {
+					if (existing->md5() == md5) {
+						existing = img;
+					}
+				}
+			}
+		}
 	}
 
-	QMap<QString, int> imgMd5s;
-	for (int i = 0; i < m_images.count(); ++i) {
-		imgMd5s.insert(m_images[i]->md5(), i);
+	return ret;
+}
+
+/**
+ * Newest images first, using their IDs when their dates are unknown or equal.
+ */
+static bool mergedImageLessThan(const QSharedPointer<Image> &a, const QSharedPointer<Image> &b)
+{
+	const QDateTime dateA = a->createdAt();
+	const QDateTime dateB = b->createdAt();
+	if (dateA.isValid() && dateB.isValid() && dateA != dateB) {
+		return dateA > dateB;
 	}
+	return a->id() > b->id();
+}
 
-	QList<QSharedPointer<Image>> ret;
-	for (const QSharedPointer<Image> &img : results) {
-		QString md5 = img->md5();
-		const double proportion = getImageKnownTagProportion(img);
+/**
+ * Insert the results of a site among the ones of the other sites already loaded for this page, each site's results
+ * being already sorted, without moving the results of the previous pages. The merged results are thus always
+ * sorted, whatever the order in which the sites answer.
+ */
+void SearchTab::insertMergedImages(const QList<QSharedPointer<Image>> &images)
+{
+	const int start = qMin(m_mergedPageStart, m_images.count());
+	for (const QSharedPointer<Image> &img : images) {
+		const auto it = std::upper_bound(m_images.begin() + start, m_images.end(), img, mergedImageLessThan);
+		m_images.insert(it, img);
+	}
+}
 
-		if (md5.isEmpty() || ((!pageMd5s.contains(md5) || proportion > pageMd5s[md5]) && !containsMergedMd5(page, md5))) {
-			if (pageMd5s.contains(md5) && proportion > pageMd5s[md5]) {
-				m_images[imgMd5s[md5]] = img;
-				pageMd5s[md5] = proportion;
-			} else {
-				ret.append(img);
+/**
+ * Images can move when other sites' results are inserted before them, so their position is looked up when needed.
+ */
+int SearchTab::mergedImagePosition(const QSharedPointer<Image> &img) const
+{
+	const int index = m_images.indexOf(img);
+	if (index >= 0 || img->md5().isEmpty()) {
+		return index;
+	}
 
-				if (!md5.isEmpty()) {
-					pageMd5s[md5] = proportion;
-					addMergedMd5(page, md5);
-				}
-			}
+	// The image may have been replaced by a better version from another site
+	for (int i = 0; i < m_images.count(); ++i) {
+		if (m_images[i]->md5() == img->md5()) {
+			return i;
 		}
 	}
-
-	return ret;
+	return -1;
 }
 
 void SearchTab::addMergedMd5(int page, const QString &md5)
@@ -764,7 +949,7 @@ void SearchTab::setPageLabelText(QLabel *txt, Page *page, const QList<QSharedPoi
 	// No results message
 	if (images.isEmpty()) {
 		QString meant;
-		QStringList reasons = reasonsToFail(page, m_completion, &meant);
+		QStringList reasons = reasonsToFail(page, m_modifiers, &meant);
 		if (!meant.isEmpty() && ui_widgetMeant != nullptr) {
 			ui_widgetMeant->show();
 			ui_labelMeant->setText(meant);
@@ -836,9 +1021,12 @@ QWidget *SearchTab::createImageThumbnail()
 	const qreal upscale = m_settings->value("thumbnailUpscale", 1.0).toDouble();
 	const int imageSize = qFloor(FIXED_IMAGE_WIDTH * upscale);
 
+	// Thumbnails are loaded lazily, so the placeholder should have roughly the same size to keep the grid stable
+	const int dim = imageSize + borderSize * 2;
 	if (fixedWidthLayout) {
-		const int dim = imageSize + borderSize * 2;
 		w->setFixedSize(dim, dim);
+	} else {
+		w->setMinimumSize(dim, dim);
 	}
 
 	return w;
@@ -938,12 +1126,65 @@ void SearchTab::addResultsImage(const QSharedPointer<Image> &img, Page *page, bo
 	m_thumbnailsLoading.insert(preview, img);
 
 	FixedSizeGridLayout *layout = m_layouts[layoutKey];
-	layout->insertWidget(relativePosition, widget);
+	layout->insertWidget(qMin(relativePosition, layout->count()), widget);
 
 	connect(preview, &ImagePreview::finished, this, &SearchTab::finishedLoadingPreview);
-	connect(preview, &ImagePreview::clicked, [this, absolutePosition]() { this->openImage(absolutePosition); });
-	connect(preview, &ImagePreview::toggled, [this, absolutePosition](bool toggle, bool range) { this->toggleImage(absolutePosition, toggle, range); });
-	preview->load();
+	if (merge) {
+		connect(preview, &ImagePreview::clicked, [this, img]() { this->openImage(mergedImagePosition(img)); });
+		connect(preview, &ImagePreview::toggled, [this, img](bool toggle, bool range) {
+			const int position = mergedImagePosition(img);
+			if (position >= 0) {
+				this->toggleImage(position, toggle, range);
+			}
+		});
+	} else {
+		connect(preview, &ImagePreview::clicked, [this, absolutePosition]() { this->openImage(absolutePosition); });
+		connect(preview, &ImagePreview::toggled, [this, absolutePosition](bool toggle, bool range) { this->toggleImage(absolutePosition, toggle, range); });
+	}
+
+	// Without scroll area, all results are always visible
+	if (m_settings->value("resultsScrollArea", true).toBool()) {
+		m_visiblePreviewsTimer.start();
+	} else {
+		preview->load();
+	}
+}
+
+/**
+ * Load the thumbnails close to the visible area of the results, and release the ones far away from it.
+ */
+void SearchTab::updateVisiblePreviews()
+{
+	if (!isVisible() || !m_settings->value("resultsScrollArea", true).toBool()) {
+		return;
+	}
+
+	QWidget *viewport = ui_scrollAreaResults->viewport();
+	const int height = viewport->height();
+	const QRect loadArea = viewport->rect().adjusted(0, -height * PREVIEWS_LOAD_SCREENS, 0, height * PREVIEWS_LOAD_SCREENS);
+	const QRect keepArea = viewport->rect().adjusted(0, -height * PREVIEWS_KEEP_SCREENS, 0, height * PREVIEWS_KEEP_SCREENS);
+
+	for (ImagePreview *preview : qAsConst(m_boutons)) {
+		QWidget *container = preview->container();
+		if (!viewport->isAncestorOf(container)) {
+			continue;
+		}
+
+		const QRect geometry(container->mapTo(viewport, QPoint(0, 0)), container->size());
+		if (loadArea.intersects(geometry)) {
+			if (!preview->isLoaded()) {
+				preview->load();
+			}
+		} else if (!keepArea.intersects(geometry)) {
+			preview->unload();
+		}
+	}
+}
+
+void SearchTab::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+	m_visiblePreviewsTimer.start();
 }
 
 void SearchTab::addHistory(const SearchQuery &query, int page, int ipp, int cols)
@@ -977,7 +1218,9 @@ void SearchTab::historyBack()
 	ui_spinPage->setValue(m_history[m_history_cursor]["page"].toInt());
 	ui_spinImagesPerPage->setValue(m_history[m_history_cursor]["ipp"].toInt());
 	ui_spinColumns->setValue(m_history[m_history_cursor]["columns"].toInt());
+	m_usePageCache = true;
 	setTags(m_history[m_history_cursor]["tags"]);
+	m_usePageCache = false;
 
 	ui_buttonHistoryNext->setEnabled(true);
 	if (m_history_cursor == 0) {
@@ -996,7 +1239,9 @@ void SearchTab::historyNext()
 	ui_spinPage->setValue(m_history[m_history_cursor]["page"].toInt());
 	ui_spinImagesPerPage->setValue(m_history[m_history_cursor]["ipp"].toInt());
 	ui_spinColumns->setValue(m_history[m_history_cursor]["columns"].toInt());
+	m_usePageCache = true;
 	setTags(m_history[m_history_cursor]["tags"]);
+	m_usePageCache = false;
 
 	ui_buttonHistoryBack->setEnabled(true);
 	if (m_history_cursor == m_history.size() - 1) {
@@ -1326,6 +1571,26 @@ void SearchTab::endlessLoad()
 	loadPage();
 }
 
+/**
+ * Load the next page once the user scrolled within a few rows of thumbnails of the end of the results.
+ * Endless loading is disabled while a page is loading, so there is never more than one page loaded in advance.
+ */
+void SearchTab::prefetchEndlessLoad()
+{
+	if (!m_endlessLoadingEnabled || m_images.isEmpty()) {
+		return;
+	}
+
+	const int rows = m_settings->value("infiniteScrollPrefetchRows", 3).toInt();
+	const qreal upscale = m_settings->value("thumbnailUpscale", 1.0).toDouble();
+	const int rowHeight = qFloor(FIXED_IMAGE_WIDTH * upscale) + m_settings->value("borders", 3).toInt() * 2 + m_settings->value("Margins/vertical", 6).toInt();
+
+	const QScrollBar *scrollBar = ui_scrollAreaResults->verticalScrollBar();
+	if (scrollBar->maximum() > 0 && scrollBar->maximum() - scrollBar->value() <= rows * rowHeight) {
+		endlessLoad();
+	}
+}
+
 void SearchTab::loadPage()
 {
 	const bool merged = ui_checkMergeResults != nullptr && ui_checkMergeResults->isChecked();
@@ -1336,6 +1601,7 @@ void SearchTab::loadPage()
 	m_page = 0;
 
 	// Reset merged state
+	m_mergedPageStart = m_images.count();
 	if (merged && ui_progressMergeResults != nullptr) {
 		ui_progressMergeResults->setValue(0);
 		ui_progressMergeResults->setMaximum(m_pages.count());
@@ -1351,21 +1617,33 @@ void SearchTab::loadPage()
 			query.urls = m_lastUrls.take(site->url());
 		}
 
-		// Load results
+		// Re-use the page if it was loaded recently, when coming back to it
 		const QStringList postFiltering = postFilter(true);
-		Page *page = new Page(m_profile, site, m_sites.values(), query, currentPage, perPage, postFiltering, false, this, 0, m_lastPage, m_lastPageMinId, m_lastPageMaxId, m_lastPageMinDate, m_lastPageMaxDate);
-		connect(page, &Page::finishedLoading, this, &SearchTab::finishedLoading);
-		connect(page, &Page::failedLoading, this, &SearchTab::failedLoading);
-		connect(page, &Page::httpsRedirect, this, &SearchTab::httpsRedirect);
+		const QString cacheKey = PageCache::key(site->url(), query, currentPage, perPage, postFiltering);
+		QSharedPointer<Page> sharedPage = m_usePageCache && query.urls.isEmpty() ? m_pageCache->get(cacheKey) : QSharedPointer<Page>();
+		const bool fromCache = !sharedPage.isNull();
 
-		// Keep pointer to the new page
-		if (m_lastPages.contains(page->website())) {
-			page->setLastPage(m_lastPages[page->website()].data());
+		// Load results
+		if (!fromCache) {
+			sharedPage.reset(new Page(m_profile, site, m_sites.values(), query, currentPage, perPage, postFiltering, false, this, 0, m_lastPage, m_lastPageMinId, m_lastPageMaxId, m_lastPageMinDate, m_lastPageMaxDate));
+			connect(sharedPage.data(), &Page::finishedLoading, this, &SearchTab::finishedLoading);
+			connect(sharedPage.data(), &Page::failedLoading, this, &SearchTab::failedLoading);
+			connect(sharedPage.data(), &Page::httpsRedirect, this, &SearchTab::httpsRedirect);
+
+			if (m_lastPages.contains(sharedPage->website())) {
+				sharedPage->setLastPage(m_lastPages[sharedPage->website()].data());
+			}
+			if (query.urls.isEmpty()) {
+				m_pageCache->insert(cacheKey, sharedPage);
+			}
 		}
+		Page *page = sharedPage.data();
+
+		// Keep pointer to the new page
 		if (!m_pages.contains(page->website())) {
 			m_pages.insert(page->website(), QList<QSharedPointer<Page>>());
 		}
-		m_pages[page->website()].append(QSharedPointer<Page>(page));
+		m_pages[page->website()].append(sharedPage);
 
 		// Setup the layout
 		if (!merged) {
@@ -1385,6 +1663,27 @@ void SearchTab::loadPage()
 			continue;
 		}
 
+		// Cached pages are displayed as if they just finished loading, once all the pages are set up
+		if (fromCache) {
+			log(QStringLiteral("[%1] Page %2 loaded from the cache").arg(site->url()).arg(currentPage), Logger::Debug);
+			const bool loadTags = m_settings->value("useregexfortags", true).toBool();
+			QTimer::singleShot(0, page, [this, sharedPage, loadTags]() {
+				if (!m_pages.value(sharedPage->website()).contains(sharedPage)) {
+					return;
+				}
+				finishedLoading(sharedPage.data());
+				if (loadTags) {
+					finishedLoadingTags(sharedPage.data());
+				}
+			});
+			continue;
+		}
+
+		// Show the wiki and tags of the last identical search while the new one is loading
+		if (m_endlessLoadOffset == 0) {
+			loadCachedPageSummary(page);
+		}
+
 		// Load tags if necessary
 		if (m_settings->value("useregexfortags", true).toBool()) {
 			connect(page, &Page::finishedLoadingTags, this, &SearchTab::finishedLoadingTags);
@@ -1480,29 +1779,39 @@ void SearchTab::onLoad()
 {}
 
 
+/**
+ * Load the results, re-using the pages loaded recently instead of loading them again.
+ */
+void SearchTab::loadCached()
+{
+	m_usePageCache = true;
+	load();
+	m_usePageCache = false;
+}
+
 void SearchTab::firstPage()
 {
 	ui_spinPage->setValue(1);
-	load();
+	loadCached();
 }
 void SearchTab::previousPage()
 {
 	if (ui_spinPage->value() > 1) {
 		ui_spinPage->setValue(ui_spinPage->value() - 1);
-		load();
+		loadCached();
 	}
 }
 void SearchTab::nextPage()
 {
 	if (ui_spinPage->value() < ui_spinPage->maximum()) {
 		ui_spinPage->setValue(ui_spinPage->value() + 1);
-		load();
+		loadCached();
 	}
 }
 void SearchTab::lastPage()
 {
 	ui_spinPage->setValue(m_pageMax);
-	load();
+	loadCached();
 }
 
 void SearchTab::setImagesPerPage(int ipp)
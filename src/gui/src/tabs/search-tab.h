@@ -2,6 +2,7 @@
 #define SEARCH_TAB_H
 
 #include <QCheckBox>
+#include <QHash>
 #include <QLabel>
 #include <QLayout>
 #include <QList>
@@ -11,6 +12,7 @@
 #include <QSignalMapper>
 #include <QSpinBox>
 #include <QStackedWidget>
+#include <QTimer>
 #include <QWidget>
 #include "models/image.h"
 #include "models/search-query/search-query.h"
@@ -22,6 +24,7 @@ class DownloadQueue;
 class Favorite;
 class MainWindow;
 class NetworkReply;
+class PageCache;
 class Profile;
 class ImagePreview;
 class FixedSizeGridLayout;
@@ -63,14 +66,20 @@ class SearchTab : public QWidget
 	protected:
 		void setSelectedSources(QSettings *settings);
 		void setTagsFromPages(const QMap<QString, QList<QSharedPointer<Page>>> &pages);
+		void updateTags();
+		void cachePageSummary(Page *page);
+		void loadCachedPageSummary(Page *page);
+		void addTagsToAutoComplete(const QList<Tag> &tags);
 		void addHistory(const SearchQuery &query, int page, int ipp, int cols);
-		QStringList reasonsToFail(Page *page, const QStringList &completion = QStringList(), QString *meant = nullptr);
+		QStringList reasonsToFail(Page *page, const QStringList &modifiers = QStringList(), QString *meant = nullptr);
 		void clear();
+		void initResultsScrollArea();
 		TextEdit *createAutocomplete();
 		QWidget *createImageThumbnail();
 		FixedSizeGridLayout *createImagesLayout(QSettings *settings);
 		virtual void thumbnailContextMenu(QMenu *menu, const QSharedPointer<Image> &img);
 		QList<QSharedPointer<Page>> getPagesToDownload();
+		void showEvent(QShowEvent *event) override;
 
 	protected slots:
 		void contextSaveSelected();
@@ -105,19 +114,24 @@ class SearchTab : public QWidget
 		void historyNext();
 		// Results
 		virtual void load() = 0;
+		void loadCached();
 		virtual void updateTitle() = 0;
 		void loadTags(SearchQuery query);
 		void endlessLoad();
+		void prefetchEndlessLoad();
 		void loadPage();
 		virtual void addResultsPage(Page *page, const QList<QSharedPointer<Image>> &images, bool merged, int filteredImages, const QString &noResultsMessage = nullptr);
 		void setMergedLabelText(QLabel *txt, const QList<QSharedPointer<Image>> &images);
 		virtual void setPageLabelText(QLabel *txt, Page *page, const QList<QSharedPointer<Image>> &images, int filteredImages, const QString &noResultsMessage = nullptr);
 		void addResultsImage(const QSharedPointer<Image> &img, Page *page, bool merge = false);
 		void finishedLoadingPreview();
+		void updateVisiblePreviews();
 		// Merged
 		QList<QSharedPointer<Image>> mergeResults(int page, const QList<QSharedPointer<Image>> &results);
 		void addMergedMd5(int page, const QString &md5);
 		bool containsMergedMd5(int page, const QString &md5);
+		void insertMergedImages(const QList<QSharedPointer<Image>> &images);
+		int mergedImagePosition(const QSharedPointer<Image> &img) const;
 		// Loading
 		void finishedLoading(Page *page);
 		void failedLoading(Page *page);
@@ -162,6 +176,11 @@ class SearchTab : public QWidget
 		QList<QCheckBox*> m_checkboxes;
 		QList<Favorite> &m_favorites;
 		QList<Tag> m_tags;
+		QTimer m_tagsTimer;
+		QMap<QString, QList<QSharedPointer<Page>>> m_tagsPages;
+		bool m_tagsUpdating = false;
+		bool m_tagsOutdated = false;
+		int m_tagsGeneration = 0;
 		MainWindow *m_parent;
 		QSettings *m_settings;
 		QString m_wiki;
@@ -170,10 +189,14 @@ class SearchTab : public QWidget
 		bool m_isLocked = false;
 
 		QStringList m_completion;
+		QStringList m_modifiers;
 		QMap<ImagePreview*, QSharedPointer<Image>> m_thumbnailsLoading;
+		QTimer m_visiblePreviewsTimer;
 		QList<QSharedPointer<Image>> m_images;
 		QMap<QString, QList<QSharedPointer<Page>>> m_pages;
 		QMap<QString, QSharedPointer<Page>> m_lastPages;
+		PageCache *m_pageCache;
+		bool m_usePageCache = false;
 		QMap<Site*, QLabel*> m_siteLabels;
 		QMap<Site*, QVBoxLayout*> m_siteLayouts;
 		QMap<Page*, FixedSizeGridLayout*> m_layouts;
@@ -193,6 +216,8 @@ class SearchTab : public QWidget
 		SearchQuery m_lastQuery;
 		bool m_hasLastQuery = false;
 		QList<QPair<int, QSet<QString>>> m_mergedMd5s;
+		QHash<QString, double> m_mergedProportions;
+		int m_mergedPageStart = 0;
 
 		// UI stuff
 		TextEdit *m_postFiltering = nullptr;
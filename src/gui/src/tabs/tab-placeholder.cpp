@@ -0,0 +1,33 @@
+#include "tabs/tab-placeholder.h"
+#include <QJsonArray>
+#include <QStringList>
+#include <utility>
+
+
+TabPlaceholder::TabPlaceholder(QJsonObject info, QWidget *parent)
+	: QWidget(parent), m_info(std::move(info))
+{
+	setWindowTitle(title());
+}
+
+/**
+ * Same title as the one the actual tab would have, without having to build it.
+ */
+QString TabPlaceholder::title() const
+{
+	QStringList tags;
+	for (const auto &tag : m_info["tags"].toArray()) {
+		tags.append(tag.toString());
+	}
+	const QString search = tags.join(' ').replace("&", "&&");
+
+	const QString type = m_info["type"].toString();
+	if (type == "pool") {
+		return "Pool #" + QString::number(m_info["pool"].toInt()) + (search.isEmpty() ? QString() : " - " + search);
+	}
+	if (type == "gallery") {
+		const QString name = m_info["gallery"].toObject()["name"].toString();
+		return name.isEmpty() ? tr("Gallery") : name;
+	}
+	return search.isEmpty() ? tr("Search") : search;
+}
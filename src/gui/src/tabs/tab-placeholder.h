@@ -0,0 +1,28 @@
+#ifndef TAB_PLACEHOLDER_H
+#define TAB_PLACEHOLDER_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QWidget>
+
+
+/**
+ * Lightweight stand-in for a restored search tab, only keeping its saved information.
+ *
+ * Restored tabs are created as placeholders, and only replaced by the actual tab when first shown, so that
+ * restoring many tabs neither builds all their widgets nor loads all their results on startup.
+ */
+class TabPlaceholder : public QWidget
+{
+	Q_OBJECT
+
+	public:
+		explicit TabPlaceholder(QJsonObject info, QWidget *parent = nullptr);
+		const QJsonObject &info() const { return m_info; }
+		QString title() const;
+
+	private:
+		QJsonObject m_info;
+};
+
+#endif // TAB_PLACEHOLDER_H
@@ -0,0 +1,191 @@
+#include "tabs-journal.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMap>
+#include <QWidget>
+#include <utility>
+#include "logger.h"
+#include "tabs-loader.h"
+
+#define JOURNAL_MAX_ENTRIES 1000
+#define JOURNAL_MIN_SIZE (1024 * 1024)
+
+
+TabsJournal::TabsJournal(QString path)
+	: m_path(std::move(path)), m_journalPath(journalPath(m_path))
+{}
+
+QString TabsJournal::journalPath(const QString &path)
+{
+	return path + ".journal";
+}
+
+
+void TabsJournal::replay(const QString &path, QJsonObject &tabs)
+{
+	QFile f(journalPath(path));
+	if (!f.open(QFile::ReadOnly)) {
+		return;
+	}
+
+	// Journals of another version of the tabs file would give garbage
+	const QJsonObject header = QJsonDocument::fromJson(f.readLine()).object();
+	if (header["session"].toString().isEmpty() || header["session"] != tabs["session"]) {
+		return;
+	}
+
+	// The tabs of the file are identified by their position
+	QMap<int, QJsonObject> data;
+	QJsonArray order;
+	const QJsonArray baseTabs = tabs["tabs"].toArray();
+	for (int i = 0; i < baseTabs.count(); ++i) {
+		data.insert(i, baseTabs[i].toObject());
+		order.append(i);
+	}
+	QJsonValue current = tabs["current"];
+
+	int count = 0;
+	while (!f.atEnd()) {
+		// The last line might be incomplete if we crashed while writing it
+		QJsonParseError error;
+		const QJsonObject entry = QJsonDocument::fromJson(f.readLine(), &error).object();
+		if (error.error != QJsonParseError::NoError) {
+			break;
+		}
+
+		if (entry.contains("tab")) {
+			data.insert(entry["tab"].toInt(), entry["data"].toObject());
+		} else if (entry.contains("order")) {
+			order = entry["order"].toArray();
+			current = entry["current"];
+		}
+		count++;
+	}
+
+	QJsonArray result;
+	for (const QJsonValue &id : qAsConst(order)) {
+		if (data.contains(id.toInt())) {
+			result.append(data[id.toInt()]);
+		}
+	}
+	tabs["tabs"] = result;
+	tabs["current"] = current;
+
+	log(QStringLiteral("Restored %1 changes from the tabs journal").arg(count), Logger::Debug);
+}
+
+
+void TabsJournal::setDirty(QWidget *tab)
+{
+	m_dirty.insert(tab);
+}
+
+bool TabsJournal::save(const QList<QWidget*> &tabs, QWidget *currentTab)
+{
+	if (!m_started || m_entries >= JOURNAL_MAX_ENTRIES) {
+		return compact(tabs, currentTab);
+	}
+
+	// Forget closed tabs
+	const QSet<QWidget*> open(tabs.constBegin(), tabs.constEnd());
+	for (auto it = m_ids.begin(); it != m_ids.end();) {
+		if (!open.contains(it.key())) {
+			it = m_ids.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	QByteArray entries;
+	int count = 0;
+
+	// Changed tabs, new tabs being always written
+	QJsonArray order;
+	for (QWidget *tab : tabs) {
+		auto it = m_ids.find(tab);
+		if (it == m_ids.end()) {
+			it = m_ids.insert(tab, m_nextId++);
+			m_dirty.insert(tab);
+		}
+
+		QJsonObject data;
+		if (m_dirty.contains(tab) && TabsLoader::tabToJson(tab, data)) {
+			QJsonObject entry;
+			entry["tab"] = it.value();
+			entry["data"] = data;
+			entries += QJsonDocument(entry).toJson(QJsonDocument::Compact) + "\n";
+			count++;
+		}
+		order.append(it.value());
+	}
+	m_dirty.clear();
+
+	// Opened, closed or moved tabs
+	const QJsonValue current = TabsLoader::currentTabJson(tabs, currentTab);
+	if (order != m_lastOrder || current != m_lastCurrent) {
+		QJsonObject entry;
+		entry["order"] = order;
+		entry["current"] = current;
+		entries += QJsonDocument(entry).toJson(QJsonDocument::Compact) + "\n";
+		count++;
+
+		m_lastOrder = order;
+		m_lastCurrent = current;
+	}
+
+	if (count == 0) {
+		return true;
+	}
+
+	QFile f(m_journalPath);
+	if (!f.open(QFile::WriteOnly | QFile::Append) || f.write(entries) != entries.size()) {
+		log(QStringLiteral("Error writing the tabs journal, saving all tabs instead"), Logger::Warning);
+		return compact(tabs, currentTab);
+	}
+	f.close();
+	m_entries += count;
+
+	// Replaying a journal bigger than the file itself would be slower than just reading a new file
+	if (f.size() > qMax<qint64>(m_baseSize, JOURNAL_MIN_SIZE)) {
+		return compact(tabs, currentTab);
+	}
+
+	return true;
+}
+
+bool TabsJournal::compact(const QList<QWidget*> &tabs, QWidget *currentTab)
+{
+	const qint64 session = QDateTime::currentMSecsSinceEpoch();
+	if (!TabsLoader::save(m_path, tabs, currentTab, session)) {
+		return false;
+	}
+
+	// Start a new journal, the old one being ignored from now on even if we can't remove it
+	QJsonObject header;
+	header["session"] = QString::number(session);
+	QFile f(m_journalPath);
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		m_started = false;
+		return true;
+	}
+	f.write(QJsonDocument(header).toJson(QJsonDocument::Compact) + "\n");
+	f.close();
+
+	// Tabs of the file are identified by their position
+	m_ids.clear();
+	m_dirty.clear();
+	m_lastOrder = QJsonArray();
+	for (int i = 0; i < tabs.count(); ++i) {
+		m_ids.insert(tabs[i], i);
+		m_lastOrder.append(i);
+	}
+	m_nextId = tabs.count();
+	m_lastCurrent = TabsLoader::currentTabJson(tabs, currentTab);
+	m_entries = 0;
+	m_baseSize = QFileInfo(m_path).size();
+	m_started = true;
+
+	return true;
+}
@@ -0,0 +1,63 @@
+#ifndef TABS_JOURNAL_H
+#define TABS_JOURNAL_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+
+class QWidget;
+
+/**
+ * Saves the open tabs incrementally, so that it is cheap enough to be done after every change.
+ *
+ * Instead of rewriting the tabs file each time, only the tabs that changed since the last save are appended to a
+ * journal next to it, along with the order of the tabs when it changed. The tabs file is only written entirely once
+ * the journal grows too big, when the journal is started over.
+ */
+class TabsJournal
+{
+	public:
+		explicit TabsJournal(QString path);
+
+		/**
+		 * Apply the journal of a tabs file on its contents, if it was started from this version of the file.
+		 */
+		static void replay(const QString &path, QJsonObject &tabs);
+
+		/**
+		 * Mark a tab as changed, so that it is written during the next save.
+		 */
+		void setDirty(QWidget *tab);
+
+		/**
+		 * Append the changes since the last save to the journal.
+		 */
+		bool save(const QList<QWidget*> &tabs, QWidget *currentTab);
+
+		/**
+		 * Write the tabs file entirely, and start a new journal.
+		 */
+		bool compact(const QList<QWidget*> &tabs, QWidget *currentTab);
+
+	protected:
+		static QString journalPath(const QString &path);
+
+	private:
+		QString m_path;
+		QString m_journalPath;
+		bool m_started = false;
+		QHash<QWidget*, int> m_ids;
+		QSet<QWidget*> m_dirty;
+		int m_nextId = 0;
+		QJsonArray m_lastOrder;
+		QJsonValue m_lastCurrent;
+		int m_entries = 0;
+		qint64 m_baseSize = 0;
+};
+
+#endif // TABS_JOURNAL_H
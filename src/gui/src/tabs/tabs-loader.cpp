@@ -3,6 +3,7 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QSettings>
 #include <QVariant>
 #include "downloads-tab.h"
@@ -14,12 +15,14 @@
 #include "models/profile.h"
 #include "monitors-tab.h"
 #include "pool-tab.h"
+#include "tab-placeholder.h"
+#include "tabs-journal.h"
 #include "tag-tab.h"
 #include "ui_pool-tab.h"
 #include "ui_tag-tab.h"
 
 
-bool TabsLoader::load(const QString &path, QList<SearchTab*> &allTabs, QVariant &currentTab, Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent)
+bool TabsLoader::load(const QString &path, QList<QWidget*> &allTabs, QVariant &currentTab, Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent)
 {
 	QSettings *settings = profile->getSettings();
 	const bool preload = settings->value("preloadAllTabs", false).toBool();
@@ -72,6 +75,10 @@ bool TabsLoader::load(const QString &path, QList<SearchTab*> &allTabs, QVariant
 	const QByteArray data = f.readAll();
 	QJsonDocument loadDoc = QJsonDocument::fromJson(data);
 	QJsonObject object = loadDoc.object();
+	f.close();
+
+	// Apply the changes saved since the file was last written entirely
+	TabsJournal::replay(path, object);
 
 	const int version = object["version"].toInt();
 	switch (version)
@@ -84,9 +91,17 @@ bool TabsLoader::load(const QString &path, QList<SearchTab*> &allTabs, QVariant
 				currentTab = object["current"].toInt();
 			}
 
+			// The current tab is shown right away, so it's the only one not worth a placeholder
+			const int current = currentTab.type() == QVariant::Int ? currentTab.toInt() : -1;
+
 			QJsonArray tabs = object["tabs"].toArray();
-			for (auto tabJson : tabs) {
-				QJsonObject infos = tabJson.toObject();
+			for (int i = 0; i < tabs.count(); ++i) {
+				QJsonObject infos = tabs[i].toObject();
+				if (!preload && i != current) {
+					allTabs.append(new TabPlaceholder(infos, parent));
+					continue;
+				}
+
 				SearchTab *tab = loadTab(infos, profile, downloadQueue, parent, preload);
 				if (tab != nullptr) {
 					allTabs.append(tab);
@@ -125,21 +140,25 @@ SearchTab *TabsLoader::loadTab(QJsonObject info, Profile *profile, DownloadQueue
 	return nullptr;
 }
 
-bool TabsLoader::save(const QString &path, QList<SearchTab*> &allTabs, QWidget *currentTab)
+bool TabsLoader::tabToJson(QWidget *widget, QJsonObject &json)
 {
-	QFile saveFile(path);
-	if (!saveFile.open(QFile::WriteOnly)) {
-		return false;
+	auto *placeholder = qobject_cast<TabPlaceholder*>(widget);
+	if (placeholder != nullptr) {
+		json = placeholder->info();
+		return true;
 	}
 
-	QJsonArray tabsJson;
-	for (auto tab : allTabs) {
-		QJsonObject tabJson;
-		tab->write(tabJson);
-		tabsJson.append(tabJson);
+	auto *tab = qobject_cast<SearchTab*>(widget);
+	if (tab != nullptr) {
+		tab->write(json);
+		return true;
 	}
 
-	// Find tab index
+	return false;
+}
+
+QJsonValue TabsLoader::currentTabJson(const QList<QWidget*> &allTabs, QWidget *currentTab)
+{
 	// TODO(Bionus): just remember the overall index over all opened tabs
 	QVariant current;
 	if (qobject_cast<FavoritesTab*>(currentTab) != nullptr) {
@@ -151,19 +170,39 @@ bool TabsLoader::save(const QString &path, QList<SearchTab*> &allTabs, QWidget *
 	} else if (qobject_cast<LogTab*>(currentTab) != nullptr) {
 		current = "log";
 	} else {
-		current = allTabs.indexOf(qobject_cast<SearchTab*>(currentTab));
+		current = allTabs.indexOf(currentTab);
+	}
+	return QJsonValue::fromVariant(current);
+}
+
+bool TabsLoader::save(const QString &path, const QList<QWidget*> &allTabs, QWidget *currentTab, qint64 session)
+{
+	// Written to a temporary file first, so that a crash while saving doesn't lose the whole session
+	QSaveFile saveFile(path);
+	if (!saveFile.open(QFile::WriteOnly)) {
+		return false;
+	}
+
+	QJsonArray tabsJson;
+	for (QWidget *widget : allTabs) {
+		QJsonObject tabJson;
+		if (tabToJson(widget, tabJson)) {
+			tabsJson.append(tabJson);
+		}
 	}
 
 	// Generate result
 	QJsonObject full;
 	full["version"] = 2;
-	full["current"] = QJsonValue::fromVariant(current);
+	full["current"] = currentTabJson(allTabs, currentTab);
 	full["tabs"] = tabsJson;
+	if (session != 0) {
+		full["session"] = QString::number(session);
+	}
 
 	// Write result
 	QJsonDocument saveDoc(full);
 	saveFile.write(saveDoc.toJson());
-	saveFile.close();
 
-	return true;
+	return saveFile.commit();
 }
@@ -2,6 +2,8 @@
 #define TABS_LOADER_H
 
 #include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
 #include <QMap>
 #include <QString>
 
@@ -16,9 +18,23 @@ class QWidget;
 class TabsLoader
 {
 	public:
-		static bool load(const QString &path, QList<SearchTab*> &allTabs, QVariant &currentTab, Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent);
+		/**
+		 * Load the tabs saved in a file. Unless all tabs are preloaded, all but the current one are restored as
+		 * placeholders (TabPlaceholder), to be replaced by the actual tab using loadTab() when first shown.
+		 */
+		static bool load(const QString &path, QList<QWidget*> &allTabs, QVariant &currentTab, Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent);
 		static SearchTab *loadTab(QJsonObject info, Profile *profile, DownloadQueue *downloadQueue, MainWindow *parent, bool preload);
-		static bool save(const QString &path, QList<SearchTab*> &allTabs, QWidget *currentTab);
+
+		/**
+		 * Save a list of search tabs or tab placeholders to a file.
+		 *
+		 * @param session Identifier of the journal of changes that can be applied on top of this file, 0 for none.
+		 */
+		static bool save(const QString &path, const QList<QWidget*> &allTabs, QWidget *currentTab, qint64 session = 0);
+
+		// Serialization of a single search tab or tab placeholder, and of the current tab
+		static bool tabToJson(QWidget *widget, QJsonObject &json);
+		static QJsonValue currentTabJson(const QList<QWidget*> &allTabs, QWidget *currentTab);
 };
 
 #endif // TABS_LOADER_H
@@ -46,6 +46,7 @@ TagTab::TagTab(Profile *profile, DownloadQueue *downloadQueue, MainWindow *paren
 	ui_buttonPreviousPage = ui->buttonPreviousPage;
 	ui_buttonEndlessLoad = ui->buttonEndlessLoad;
 	ui_scrollAreaResults = ui->scrollAreaResults;
+	initResultsScrollArea();
 
 	// Search fields
 	m_search = createAutocomplete();
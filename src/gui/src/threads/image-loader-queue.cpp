@@ -1,60 +1,100 @@
 #include "threads/image-loader-queue.h"
-#include <QObject>
-#include <QPixmap>
+#include <QImage>
+#include <QString>
+#include <QtConcurrent>
 #include "threads/image-loader.h"
 
 
-ImageLoaderQueue::ImageLoaderQueue(ImageLoader *imageLoader, QObject *parent)
-	: QObject(parent), m_next(QByteArray()), m_waiting(false), m_cancelNext(false), m_hasNext(false)
+ImageLoaderQueue::ImageLoaderQueue(int maxThreads, bool latestWins, QObject *parent)
+	: QObject(parent), m_latestWins(latestWins)
 {
-	connect(this, &ImageLoaderQueue::loadImage, imageLoader, &ImageLoader::load);
-	connect(imageLoader, &ImageLoader::finished, this, &ImageLoaderQueue::loadingSuccess);
-	connect(imageLoader, &ImageLoader::failed, this, &ImageLoaderQueue::loadingFinished);
+	m_pool.setMaxThreadCount(qMax(1, maxThreads));
 }
 
-void ImageLoaderQueue::clear()
+ImageLoaderQueue::~ImageLoaderQueue()
 {
-	// If we have a loading waiting when we clear, we must not emit for it
-	if (m_waiting) {
-		m_cancelNext = true;
+	clear();
+	m_pool.waitForDone();
+}
+
+int ImageLoaderQueue::load(const QString &path, QSize maxSize, bool preview)
+{
+	if (m_latestWins) {
+		clear();
 	}
 
-	m_next = QByteArray();
-	m_hasNext = false;
+	const int id = ++m_lastId;
+	Token token(new QAtomicInt(0));
+	m_tokens.insert(id, token);
+
+	QtConcurrent::run(&m_pool, [this, id, token, path, maxSize, preview]() {
+		decode(id, token, path, maxSize, preview);
+	});
+
+	return id;
 }
 
-void ImageLoaderQueue::load(const QByteArray &data)
+void ImageLoaderQueue::cancel(int id)
 {
-	// If we are already waiting for a loading, we queue this data
-	if (m_waiting) {
-		m_next = QByteArray(data);
-		m_hasNext = true;
-		return;
+	const Token token = m_tokens.take(id);
+	if (!token.isNull()) {
+		token->storeRelease(1);
 	}
+}
 
-	m_waiting = true;
-	emit loadImage(data);
+void ImageLoaderQueue::clear()
+{
+	for (const Token &token : qAsConst(m_tokens)) {
+		token->storeRelease(1);
+	}
+	m_tokens.clear();
 }
 
-void ImageLoaderQueue::loadingSuccess(const QPixmap &pixmap, int size)
+/**
+ * Run in one of the pool's threads.
+ */
+void ImageLoaderQueue::decode(int id, const Token &token, const QString &path, QSize maxSize, bool preview)
 {
-	// We only emit the event if the loading was successful and not cancelled
-	if (!m_cancelNext) {
-		emit finished(pixmap, size);
+	if (token->loadAcquire() != 0) {
+		return;
 	}
 
-	loadingFinished();
+	if (preview) {
+		QSize fullSize;
+		const QImage image = ImageLoader::decodePreview(path, maxSize, &fullSize);
+		if (!image.isNull()) {
+			deliver(id, token, image, fullSize, true);
+		}
+
+		if (token->loadAcquire() != 0) {
+			return;
+		}
+	}
+
+	QSize fullSize;
+	const QImage image = ImageLoader::decodeFile(path, maxSize, &fullSize);
+	deliver(id, token, image, fullSize, false);
 }
 
-void ImageLoaderQueue::loadingFinished()
+/**
+ * Emit the result in the queue's thread, checking the token again so that requests cancelled in the meantime do not
+ * emit anything.
+ */
+void ImageLoaderQueue::deliver(int id, const Token &token, const QImage &image, QSize fullSize, bool preview)
 {
-	m_waiting = false;
-	m_cancelNext = false;
-
-	// If we have some data in the queue, we load it directly
-	if (m_hasNext) {
-		load(m_next);
-		m_next = QByteArray();
-		m_hasNext = false;
-	}
+	QMetaObject::invokeMethod(this, [this, id, token, image, fullSize, preview]() {
+		if (token->loadAcquire() != 0) {
+			return;
+		}
+
+		if (!preview) {
+			m_tokens.remove(id);
+		}
+
+		if (image.isNull()) {
+			emit failed(id);
+		} else {
+			emit loaded(id, image, fullSize, preview);
+		}
+	}, Qt::QueuedConnection);
 }
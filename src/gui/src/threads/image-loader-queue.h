@@ -1,37 +1,61 @@
 #ifndef IMAGE_LOADER_QUEUE_H
 #define IMAGE_LOADER_QUEUE_H
 
-#include <QByteArray>
+#include <QAtomicInt>
+#include <QHash>
 #include <QObject>
-
-
-class ImageLoader;
-class QPixmap;
-
+#include <QSharedPointer>
+#include <QSize>
+#include <QThreadPool>
+
+
+class QImage;
+class QString;
+
+/**
+ * Decode image files in a pool of threads, so that a slow decoding (such as a big GIF or WebP) doesn't delay the next
+ * ones.
+ *
+ * Each request gets a cancellation token, checked before each decoding step and before emitting its result, so that
+ * cancelled requests never emit anything. In "latest wins" mode, starting a request cancels all the previous ones,
+ * which is what the viewer needs when quickly navigating between images: requests still waiting for a thread are then
+ * skipped without being decoded at all.
+ */
 class ImageLoaderQueue : public QObject
 {
 	Q_OBJECT
 
 	public:
-		explicit ImageLoaderQueue(ImageLoader *imageLoader, QObject *parent = nullptr);
+		explicit ImageLoaderQueue(int maxThreads = 2, bool latestWins = true, QObject *parent = nullptr);
+		~ImageLoaderQueue() override;
+
+		/**
+		 * Start decoding an image file, downscaled to fit in the given size if it's bigger.
+		 *
+		 * @param preview For big images, emit a low resolution preview first
+		 * @return The ID of the request, passed to the "loaded" and "failed" signals
+		 */
+		int load(const QString &path, QSize maxSize, bool preview = true);
+
+		void cancel(int id);
 
 	public slots:
-		void load(const QByteArray &data);
 		void clear();
 
-	private slots:
-		void loadingSuccess(const QPixmap &, int);
-		void loadingFinished();
-
 	signals:
-		void finished(const QPixmap &, int);
-		void loadImage(const QByteArray &);
+		void loaded(int id, const QImage &image, QSize fullSize, bool preview);
+		void failed(int id);
+
+	protected:
+		using Token = QSharedPointer<QAtomicInt>;
+		void decode(int id, const Token &token, const QString &path, QSize maxSize, bool preview);
+		void deliver(int id, const Token &token, const QImage &image, QSize fullSize, bool preview);
 
 	private:
-		QByteArray m_next;
-		bool m_waiting;
-		bool m_cancelNext;
-		bool m_hasNext;
+		QThreadPool m_pool;
+		bool m_latestWins;
+		int m_lastId = 0;
+		QHash<int, Token> m_tokens;
 };
 
 #endif // IMAGE_LOADER_QUEUE_H
@@ -1,17 +1,61 @@
 #include "threads/image-loader.h"
-#include <QPixmap>
+#include <QImage>
+#include <QImageReader>
+#include <QString>
 
+#define PREVIEW_MIN_PIXELS (2000 * 2000)
+#define PREVIEW_SCALE 8
 
-ImageLoader::ImageLoader(QObject *parent)
-	: QObject(parent)
-{}
 
-void ImageLoader::load(const QByteArray &data)
+/**
+ * Get the size to decode an image at, so that it fits in the given size while keeping its aspect ratio.
+ */
+static QSize decodeSize(QImageReader &reader, QSize maxSize, QSize *displayFullSize)
 {
-	QPixmap img;
-	if (img.loadFromData(data)) {
-		emit finished(img, data.size());
-	} else {
-		emit failed();
+	// Sizes are before applying the EXIF orientation
+	const QSize fullSize = reader.size();
+	const bool rotated = reader.transformation().testFlag(QImageIOHandler::TransformationRotate90);
+	if (rotated) {
+		maxSize.transpose();
 	}
+	if (displayFullSize != nullptr) {
+		*displayFullSize = rotated ? fullSize.transposed() : fullSize;
+	}
+
+	if (fullSize.isValid() && !maxSize.isEmpty() && (fullSize.width() > maxSize.width() || fullSize.height() > maxSize.height())) {
+		return fullSize.scaled(maxSize, Qt::KeepAspectRatio);
+	}
+	return fullSize;
+}
+
+QImage ImageLoader::decodeFile(const QString &path, QSize maxSize, QSize *fullSize)
+{
+	QImageReader reader(path);
+	reader.setAutoTransform(true);
+
+	// Formats that can't decode at a lower resolution are scaled by the reader after decoding
+	const QSize targetSize = decodeSize(reader, maxSize, fullSize);
+	if (targetSize != reader.size()) {
+		reader.setScaledSize(targetSize);
+	}
+
+	const QImage image = reader.read();
+	if (fullSize != nullptr && !fullSize->isValid()) {
+		*fullSize = image.size();
+	}
+	return image;
+}
+
+QImage ImageLoader::decodePreview(const QString &path, QSize maxSize, QSize *fullSize)
+{
+	// Only formats that can decode at a lower resolution (such as JPEG) are faster to preview
+	QImageReader reader(path);
+	const QSize targetSize = decodeSize(reader, maxSize, fullSize);
+	if (!reader.supportsOption(QImageIOHandler::ScaledSize) || targetSize.width() * targetSize.height() < PREVIEW_MIN_PIXELS) {
+		return QImage();
+	}
+
+	reader.setAutoTransform(true);
+	reader.setScaledSize(targetSize / PREVIEW_SCALE);
+	return reader.read();
 }
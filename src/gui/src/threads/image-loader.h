@@ -1,25 +1,25 @@
 #ifndef IMAGE_LOADER_H
 #define IMAGE_LOADER_H
 
-#include <QObject>
+#include <QSize>
 
 
-class QByteArray;
-class QPixmap;
+class QImage;
+class QString;
 
-class ImageLoader : public QObject
+class ImageLoader
 {
-	Q_OBJECT
-
 	public:
-		explicit ImageLoader(QObject *parent = nullptr);
-
-	public slots:
-		void load(const QByteArray &data);
-
-	signals:
-		void finished(const QPixmap &, int);
-		void failed();
+		/**
+		 * Decode an image file, downscaled to fit in the given size if it's bigger.
+		 */
+		static QImage decodeFile(const QString &path, QSize maxSize, QSize *fullSize = nullptr);
+
+		/**
+		 * Decode a low resolution preview of a big image file, which is usually much faster than decoding it fully.
+		 * Returns a null image if the file is too small or its format can't decode at a lower resolution.
+		 */
+		static QImage decodePreview(const QString &path, QSize maxSize, QSize *fullSize = nullptr);
 };
 
 #endif // IMAGE_LOADER_H
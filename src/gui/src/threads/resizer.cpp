@@ -8,14 +8,21 @@ Resizer::Resizer(QObject *parent)
 
 void Resizer::run()
 {
+	const bool decoded = !m_inputFilename.isEmpty() || !m_inputData.isEmpty();
 	if (!m_inputFilename.isEmpty()) {
 		m_input.load(m_inputFilename);
+	} else if (!m_inputData.isEmpty()) {
+		m_input.loadFromData(m_inputData);
+		m_inputData.clear();
 	}
 
 	if (m_input.isNull()) {
 		emit error();
 		return;
 	}
+	if (decoded) {
+		emit loaded(m_input);
+	}
 
 	QImage output = m_input.scaled(m_size, m_aspectMode, Qt::SmoothTransformation);
 	emit finished(output);
@@ -41,3 +48,8 @@ void Resizer::setInput(const QString &filename)
 {
 	m_inputFilename = filename;
 }
+
+void Resizer::setInput(const QByteArray &data)
+{
+	m_inputData = data;
+}
@@ -1,12 +1,17 @@
 #ifndef RESIZER_H
 #define RESIZER_H
 
+#include <QByteArray>
 #include <QImage>
 #include <QObject>
 #include <QSize>
 #include <QString>
 
 
+/**
+ * Decodes and scales an image. Designed to be run on a worker thread, the results being emitted as QImage so that
+ * only the conversion to QPixmap needs to happen on the GUI thread.
+ */
 class Resizer : public QObject
 {
 	Q_OBJECT
@@ -19,10 +24,12 @@ class Resizer : public QObject
 		void setAspectRatioMode(Qt::AspectRatioMode mode);
 		void setInput(const QImage &input);
 		void setInput(const QString &filename);
+		void setInput(const QByteArray &data);
 		void run();
 
 	signals:
 		void error();
+		void loaded(const QImage &input);
 		void finished(const QImage &output);
 
 	private:
@@ -30,6 +37,7 @@ class Resizer : public QObject
 		Qt::AspectRatioMode m_aspectMode;
 		QImage m_input;
 		QString m_inputFilename;
+		QByteArray m_inputData;
 };
 
 #endif // IMAGE_THREAD_H
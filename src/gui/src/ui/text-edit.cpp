@@ -1,15 +1,23 @@
 #include "text-edit.h"
 #include <QAbstractItemView>
 #include <QApplication>
+#include <QColor>
 #include <QCompleter>
+#include <QFont>
 #include <QMenu>
 #include <QScrollBar>
 #include <QSettings>
+#include <QStringListModel>
 #include <QStyleOptionFrameV2>
 #include <QTextDocumentFragment>
 #include <QWheelEvent>
 #include "functions.h"
 #include "models/profile.h"
+#include "search-syntax-highlighter.h"
+#include "utils/auto-complete-index.h"
+
+#define COMPLETION_LIMIT 50
+#define COMPLETION_DELAY 30
 
 
 TextEdit::TextEdit(Profile *profile, QWidget *parent)
@@ -23,7 +31,17 @@ TextEdit::TextEdit(Profile *profile, QWidget *parent)
 	setFixedHeight(sizeHint().height());
 	setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(this, &QTextEdit::customContextMenuRequested, this, &TextEdit::openCustomContextMenu);
+
+	// Highlighting is incremental, so it does not need to be re-done on every key press
+	m_highlighter = new SearchSyntaxHighlighter(true, document());
+	doColor();
 	connect(m_profile, &Profile::favoritesChanged, this, &TextEdit::doColor);
+	connect(m_profile, &Profile::keptForLaterChanged, this, &TextEdit::doColor);
+
+	// Completion is only computed once the user stops typing, for the text under the cursor at that time
+	m_completionTimer.setSingleShot(true);
+	m_completionTimer.setInterval(COMPLETION_DELAY);
+	connect(&m_completionTimer, &QTimer::timeout, this, &TextEdit::updateCompletion);
 }
 
 QSize TextEdit::sizeHint() const
@@ -49,82 +67,43 @@ void TextEdit::wheelEvent(QWheelEvent *e)
 }
 
 /**
- * Colorize the contents of the text field.
+ * Update the colors of favorite and kept for later tags, re-highlighting the field if they changed.
  */
 void TextEdit::doColor()
 {
-	QString txt = " " + this->toPlainText().toHtmlEscaped() + " ";
+	QSettings *settings = m_profile->getSettings();
 
-	// Color favorite tags
-	QFont fontFavorites;
-	fontFavorites.fromString(m_profile->getSettings()->value("Coloring/Fonts/favorites").toString());
-	const QString colorFavorites = m_profile->getSettings()->value("Coloring/Colors/favorites", "#ffc0cb").toString();
-	const QString styleFavorites = "color:" + colorFavorites + "; " + qFontToCss(fontFavorites);
+	QStringList favorites;
+	favorites.reserve(m_favorites.count());
 	for (const Favorite &fav : qAsConst(m_favorites)) {
-		txt.replace(" " + fav.getName() + " ", " <span style=\"" + styleFavorites + "\">" + fav.getName() + "</span> ");
+		favorites.append(fav.getName());
 	}
+	m_highlighter->setFavorites(favorites, tagFormat(settings, "favorites", "#ffc0cb"));
+	m_highlighter->setKeptForLater(m_viewItLater, tagFormat(settings, "keptForLater", "#000000"));
+}
 
-	// Color kept for later tags
-	QFont fontKeptForLater;
-	fontKeptForLater.fromString(m_profile->getSettings()->value("Coloring/Fonts/keptForLater").toString());
-	const QString colorKeptForLater = m_profile->getSettings()->value("Coloring/Colors/keptForLater", "#000000").toString();
-	const QString styleKeptForLater = "color:" + colorKeptForLater + "; " + qFontToCss(fontKeptForLater);
-	for (const QString &tag : qAsConst(m_viewItLater)) {
-		txt.replace(" " + tag + " ", " <span style=\"" + styleKeptForLater + "\">" + tag + "</span> ");
+QTextCharFormat TextEdit::tagFormat(QSettings *settings, const QString &key, const QString &defaultColor)
+{
+	QTextCharFormat format;
+	format.setForeground(QColor(settings->value("Coloring/Colors/" + key, defaultColor).toString()));
+
+	const QString font = settings->value("Coloring/Fonts/" + key).toString();
+	if (!font.isEmpty()) {
+		QFont qFont;
+		qFont.fromString(font);
+		format.setFont(qFont);
 	}
 
-	// Color meta-tags
-	static const QRegularExpression regexOr(" ~([^ ]+)"),
-		regexExclude(" -([^ ]+)"),
-		regexMeta(" (user|fav|md5|pool|rating|source|status|approver|unlocked|sub|id|width|height|score|mpixels|filesize|filetype|date|gentags|arttags|chartags|copytags|status|status|approver|order|parent|sort|grabber):([^ ]*)", QRegularExpression::CaseInsensitiveOption),
-		regexMd5(" ([0-9A-F]{32})", QRegularExpression::CaseInsensitiveOption),
-		regexUrl(" (https?://[^\\s/$.?#].[^\\s]*) ");
-	txt.replace(regexOr, R"( <span style="color:green">~\1</span>)");
-	txt.replace(regexExclude, R"( <span style="color:red">-\1</span>)");
-	txt.replace(regexMeta, R"( <span style="color:brown">\1:\2</span>)");
-	txt.replace(regexMd5, R"( <span style="color:purple">\1</span>)");
-	txt.replace(regexUrl, R"( <span style="color:blue">\1</span>)");
-
-	// Replace spaces to not be trimmed by the HTML renderer
-	txt = txt.mid(1, txt.length() - 2);
-	int depth = 0;
-	for (QChar &ch : txt) {
-		if (ch == ' ' && depth == 0) {
-			ch = QChar(29);
-		} else if (ch == '<') {
-			depth++;
-		} else if (ch == '>') {
-			depth--;
-		}
-	}
-	txt.replace(QChar(29), "&nbsp;");
-
-	// Setup cursor
-	QTextCursor cursor = textCursor();
-	const int pos = cursor.columnNumber();
-	const int start = cursor.selectionStart();
-	const int end = cursor.selectionEnd();
-	setHtml(txt);
-
-	// If the cursor is at the right side of (if any) selected text
-	if (pos == end) {
-		cursor.setPosition(start, QTextCursor::MoveAnchor);
-		cursor.setPosition(end, QTextCursor::KeepAnchor);
-	} else {
-		cursor.setPosition(end, QTextCursor::MoveAnchor);
-		cursor.setPosition(start, QTextCursor::KeepAnchor);
-	}
-	setTextCursor(cursor);
+	return format;
 }
 
 /**
- * Set the text of the field and color it.
+ * Set the text of the field.
  * @param text The text the field should be set to.
  */
 void TextEdit::setText(const QString &text)
 {
-	QTextEdit::setText(text);
-	doColor();
+	setPlainText(text);
 }
 
 void TextEdit::setCompleter(QCompleter *completer)
@@ -151,6 +130,13 @@ QCompleter *TextEdit::completer() const
 	return c;
 }
 
+void TextEdit::setAutoCompleteIndex(const AutoCompleteIndex *index)
+{
+	m_autoCompleteIndex = index;
+	m_completionModel = new QStringListModel(this);
+	setCompleter(new QCompleter(m_completionModel, this));
+}
+
 void TextEdit::insertCompletion(const QString &completion)
 {
 	if (c->widget() != this) {
@@ -187,6 +173,9 @@ void TextEdit::focusInEvent(QFocusEvent *e)
 		c->setWidget(this);
 	}
 
+	// Pick up color changes made in the settings
+	doColor();
+
 	QTextEdit::focusInEvent(e);
 }
 
@@ -199,12 +188,12 @@ void TextEdit::keyPressEvent(QKeyEvent *e)
 		{
 			case Qt::Key_Enter:
 			case Qt::Key_Return:
+				m_completionTimer.stop();
 				c->popup()->hide();
 				if (curr.isEmpty() || under == curr) {
 					emit returnPressed();
 				} else {
 					insertCompletion(curr);
-					doColor();
 				}
 				return;
 
@@ -219,12 +208,12 @@ void TextEdit::keyPressEvent(QKeyEvent *e)
 	const bool isShortcut = (e->modifiers().testFlag(Qt::ControlModifier) && e->key() == Qt::Key_Space); // CTRL+Space
 	if (c == nullptr || !isShortcut) { // do not process the shortcut when we have a completer
 		if (e->key() == Qt::Key_Enter || e->key() == Qt::Key_Return) {
+			m_completionTimer.stop();
 			emit returnPressed();
 			return;
 		}
 		QTextEdit::keyPressEvent(e);
 	}
-	doColor();
 
 	const bool ctrlOrShift = e->modifiers().testFlag(Qt::ControlModifier) || e->modifiers().testFlag(Qt::ShiftModifier);
 	if (c == nullptr || (ctrlOrShift && e->text().isEmpty())) {
@@ -233,14 +222,34 @@ void TextEdit::keyPressEvent(QKeyEvent *e)
 
 	static QString eow(" ");
 	const bool hasModifier = (e->modifiers() != Qt::NoModifier) && !ctrlOrShift;
-	QString completionPrefix = textUnderCursor();
 
-	if (!isShortcut && (hasModifier || e->text().isEmpty() || completionPrefix.length() < 3 || eow.contains(e->text().right(1)))) {
+	if (!isShortcut && (hasModifier || e->text().isEmpty() || eow.contains(e->text().right(1)))) {
+		m_completionTimer.stop();
+		c->popup()->hide();
+		return;
+	}
+
+	// Restarting the timer drops the completion requested for the previous key press
+	m_completionForced = m_completionForced || isShortcut;
+	m_completionTimer.start();
+}
+
+void TextEdit::updateCompletion()
+{
+	const QString completionPrefix = textUnderCursor();
+	const bool forced = m_completionForced;
+	m_completionForced = false;
+
+	if (!forced && completionPrefix.length() < 3) {
 		c->popup()->hide();
 		return;
 	}
 
 	if (completionPrefix != c->completionPrefix()) {
+		// Only give the best suggestions to the completer, instead of letting it filter the whole list
+		if (m_autoCompleteIndex != nullptr) {
+			m_completionModel->setStringList(m_autoCompleteIndex->complete(completionPrefix, COMPLETION_LIMIT));
+		}
 		c->setCompletionPrefix(completionPrefix);
 	}
 
@@ -375,5 +384,4 @@ void TextEdit::insertFav(QAction *act)
 	cursor.setPosition(pos + text.length(), QTextCursor::KeepAnchor);
 
 	this->setTextCursor(cursor);
-	this->doColor();
 }
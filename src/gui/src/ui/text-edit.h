@@ -3,13 +3,19 @@
 
 #include <QString>
 #include <QStringList>
+#include <QTextCharFormat>
 #include <QTextEdit>
+#include <QTimer>
 
 
+class AutoCompleteIndex;
 class Favorite;
 class Profile;
 class QCompleter;
+class QSettings;
+class QStringListModel;
 class QWidget;
+class SearchSyntaxHighlighter;
 
 class TextEdit : public QTextEdit
 {
@@ -19,6 +25,12 @@ class TextEdit : public QTextEdit
 		explicit TextEdit(Profile *profile, QWidget *parent = nullptr);
 		void setCompleter(QCompleter *completer);
 		QCompleter *completer() const;
+
+		/**
+		 * Use a completer only showing the most popular words of the index for the word being typed.
+		 */
+		void setAutoCompleteIndex(const AutoCompleteIndex *index);
+
 		QSize sizeHint() const override;
 		void doColor();
 		void setText(const QString &text);
@@ -30,9 +42,11 @@ class TextEdit : public QTextEdit
 
 	private:
 		QString textUnderCursor() const;
+		static QTextCharFormat tagFormat(QSettings *settings, const QString &key, const QString &defaultColor);
 
 	private slots:
 		void insertCompletion(const QString &completion);
+		void updateCompletion();
 		void insertFav(QAction *act);
 		void openCustomContextMenu(const QPoint &pos);
 		void setFavorite();
@@ -46,6 +60,11 @@ class TextEdit : public QTextEdit
 
 	private:
 		QCompleter *c;
+		const AutoCompleteIndex *m_autoCompleteIndex = nullptr;
+		QStringListModel *m_completionModel = nullptr;
+		QTimer m_completionTimer;
+		bool m_completionForced = false;
+		SearchSyntaxHighlighter *m_highlighter;
 		Profile *m_profile;
 		QList<Favorite> &m_favorites;
 		QStringList &m_viewItLater;
@@ -1,18 +1,20 @@
 #include "utils/blacklist-fix/blacklist-fix-1.h"
 #include <QCryptographicHash>
 #include <QDir>
-#include <QDirIterator>
 #include <QMessageBox>
 #include <QSettings>
 #include <ui_blacklist-fix-1.h>
 #include "functions.h"
 #include "helpers.h"
 #include "logger.h"
+#include "models/api/api.h"
+#include "models/filtering/post-filter.h"
 #include "models/image.h"
 #include "models/page.h"
 #include "models/profile.h"
 #include "models/site.h"
 #include "utils/blacklist-fix/blacklist-fix-2.h"
+#include "utils/md5-fix/md5-fix-worker.h"
 
 
 BlacklistFix1::BlacklistFix1(Site *selected, Profile *profile, QWidget *parent)
@@ -31,12 +33,26 @@ BlacklistFix1::BlacklistFix1(Site *selected, Profile *profile, QWidget *parent)
 
 	ui->textBlacklist->setPlainText(profile->getBlacklist().toString());
 
+	qRegisterMetaType<QList<QPair<QString, QString>>>("QList<QPair<QString,QString>>");
+
+	// Files are listed and hashed in the background, the same way as in the MD5 fixer
+	m_worker = new Md5FixWorker();
+	m_worker->moveToThread(&m_thread);
+	connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+	connect(this, &BlacklistFix1::startWorker, m_worker, &Md5FixWorker::doWork);
+	connect(m_worker, &Md5FixWorker::md5sCalculated, this, &BlacklistFix1::workerMd5sCalculated);
+	connect(m_worker, &Md5FixWorker::finished, this, &BlacklistFix1::workerFinished);
+	m_thread.start();
+
 	resize(size().width(), 0);
 }
 
 BlacklistFix1::~BlacklistFix1()
 {
 	delete ui;
+
+	m_thread.quit();
+	m_thread.wait();
 }
 
 void BlacklistFix1::on_buttonCancel_clicked()
@@ -65,33 +81,32 @@ void BlacklistFix1::on_buttonContinue_clicked()
 		return;
 	}
 
-	// Get all files from the destination directory
-	QVector<QPair<QString, QString>> files;
-	QDirIterator it(dir, QDirIterator::Subdirectories);
-	while (it.hasNext()) {
-		it.next();
-		if (!it.fileInfo().isDir()) {
-			int len = it.filePath().length() - dir.absolutePath().length() - 1;
-			files.append(QPair<QString, QString>(it.filePath().right(len), it.filePath()));
-		}
-	}
+	// Show a busy progress bar while the files are listed and hashed
+	ui->progressBar->setValue(0);
+	ui->progressBar->setMaximum(0);
+	ui->progressBar->show();
 
-	// Parse all files
-	for (const QPair<QString, QString> &file : files) {
-		QString md5 = ui->radioForce->isChecked()
-			? getFileMd5(file.second)
-			: getFilenameMd5(file.first, ui->lineFilename->text());
-
-		if (!md5.isEmpty()) {
-			QMap<QString, QString> det;
-			det.insert("md5", md5);
-			det.insert("path", file.first);
-			det.insert("path_full", file.second);
-			m_details.append(det);
-		}
+	m_directory = dir.absolutePath();
+	emit startWorker(m_directory, ui->lineFilename->text(), QStringList(), ui->radioForce->isChecked(), QString());
+}
+
+void BlacklistFix1::workerMd5sCalculated(const QList<QPair<QString, QString>> &md5s)
+{
+	const QDir dir(m_directory);
+	for (const auto &md5 : md5s) {
+		QMap<QString, QString> det;
+		det.insert("md5", md5.first);
+		det.insert("path", dir.relativeFilePath(md5.second));
+		det.insert("path_full", md5.second);
+		m_details.append(det);
 	}
+}
 
-	int response = QMessageBox::question(this, tr("Blacklist fixer"), tr("You are about to download information from %n image(s). Are you sure you want to continue?", "", m_details.count()), QMessageBox::Yes | QMessageBox::No);
+void BlacklistFix1::workerFinished(int loadedCount)
+{
+	ui->progressBar->hide();
+
+	int response = QMessageBox::question(this, tr("Blacklist fixer"), tr("You are about to download information from %n image(s). Are you sure you want to continue?", "", loadedCount), QMessageBox::Yes | QMessageBox::No);
 	if (response == QMessageBox::Yes) {
 		// Show progress bar
 		ui->progressBar->setValue(0);
@@ -104,30 +119,116 @@ void BlacklistFix1::on_buttonContinue_clicked()
 	}
 }
 
-void BlacklistFix1::getAll(Page *p)
+/**
+ * The API used to search for many MD5s at once, or nullptr if the site doesn't support it.
+ */
+Api *BlacklistFix1::batchApi(Site *site) const
 {
-	if (p != nullptr && !p->images().empty()) {
-		QSharedPointer<Image> img = p->images().first();
-		m_getAll[img->md5()].insert("tags", img->tagsString().join(' '));
-		ui->progressBar->setValue(ui->progressBar->value() + 1);
-		p->deleteLater();
+	for (Api *api : site->getLoggedInApis()) {
+		if (api->batchMd5sMax() <= 0) {
+			continue;
+		}
+
+		// The listing must contain the tags of the images
+		const QStringList forcedTokens = api->forcedTokens();
+		if (forcedTokens.contains("*") || forcedTokens.contains("tags")) {
+			continue;
+		}
+
+		return api;
 	}
+	return nullptr;
+}
 
-	if (!m_details.empty()) {
-		QMap<QString, QString> det = m_details.takeFirst();
+void BlacklistFix1::loadBatch(Site *site, Api *api)
+{
+	QStringList md5s;
+	const int max = api->batchMd5sMax();
+	while (md5s.count() < max && !m_details.isEmpty()) {
+		const QMap<QString, QString> det = m_details.takeFirst();
 		m_getAll.insert(det.value("md5"), det);
+		md5s.append(det.value("md5"));
+	}
+
+	const QString search = api->batchMd5sSearch(md5s);
+	log(QStringLiteral("Loading tags of %1 images at once").arg(md5s.count()), Logger::Info);
+
+	Page *page = new Page(m_profile, site, { site }, QStringList { search }, 1, md5s.count(), QStringList(), false, this);
+	auto *pageApi = new PageApi(page, m_profile, site, api, page->query(), 1, md5s.count(), PostFilter(), false, page);
+	m_batches.insert(pageApi, qMakePair(page, md5s.count()));
+
+	connect(pageApi, &PageApi::finishedLoading, this, &BlacklistFix1::batchFinished);
+	pageApi->load();
+}
 
-		Page *page = new Page(m_profile, m_sites.value(ui->comboSource->currentText()), m_sites.values(), QStringList("md5:" + det.value("md5")), 1, 1);
-		connect(page, &Page::finishedLoading, this, &BlacklistFix1::getAll);
-		page->load();
+void BlacklistFix1::batchFinished(PageApi *pageApi, PageApi::LoadResult status)
+{
+	const auto it = m_batches.find(pageApi);
+	if (it == m_batches.end()) {
+		return;
+	}
+	Page *page = it->first;
+	const int count = it->second;
+	m_batches.erase(it);
+
+	// Images missing from the results are considered as not found, as they would be with single searches
+	if (status == PageApi::LoadResult::Ok) {
+		for (const QSharedPointer<Image> &img : pageApi->images()) {
+			const auto det = m_getAll.find(img->md5());
+			if (det != m_getAll.end()) {
+				det->insert("tags", img->tagsString().join(' '));
+			}
+		}
 	} else {
-		Blacklist blacklist;
-		for (const QString &tags : ui->textBlacklist->toPlainText().split("\n", Qt::SkipEmptyParts)) {
-			blacklist.add(tags.trimmed().split(' ', Qt::SkipEmptyParts));
+		log(QStringLiteral("Error loading tags of %1 images at once").arg(count), Logger::Warning);
+	}
+
+	ui->progressBar->setValue(ui->progressBar->value() + count);
+	page->deleteLater();
+
+	getAll();
+}
+
+void BlacklistFix1::getAll(Page *p)
+{
+	if (p != nullptr) {
+		if (!p->images().empty()) {
+			QSharedPointer<Image> img = p->images().first();
+			m_getAll[img->md5()].insert("tags", img->tagsString().join(' '));
 		}
+		ui->progressBar->setValue(ui->progressBar->value() + 1);
+		p->deleteLater();
+	}
 
-		BlacklistFix2 *bf2 = new BlacklistFix2(m_getAll.values(), blacklist);
-		close();
-		bf2->show();
+	if (m_details.empty()) {
+		showResults();
+		return;
 	}
+
+	// Search many images at once if possible
+	Site *site = m_sites.value(ui->comboSource->currentText());
+	Api *api = batchApi(site);
+	if (api != nullptr) {
+		loadBatch(site, api);
+		return;
+	}
+
+	QMap<QString, QString> det = m_details.takeFirst();
+	m_getAll.insert(det.value("md5"), det);
+
+	Page *page = new Page(m_profile, site, m_sites.values(), QStringList("md5:" + det.value("md5")), 1, 1);
+	connect(page, &Page::finishedLoading, this, &BlacklistFix1::getAll);
+	page->load();
+}
+
+void BlacklistFix1::showResults()
+{
+	Blacklist blacklist;
+	for (const QString &tags : ui->textBlacklist->toPlainText().split("\n", Qt::SkipEmptyParts)) {
+		blacklist.add(tags.trimmed().split(' ', Qt::SkipEmptyParts));
+	}
+
+	BlacklistFix2 *bf2 = new BlacklistFix2(m_getAll.values(), blacklist);
+	close();
+	bf2->show();
 }
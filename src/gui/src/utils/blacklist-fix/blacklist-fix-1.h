@@ -2,7 +2,13 @@
 #define BLACKLIST_FIX_1_H
 
 #include <QDialog>
+#include <QHash>
+#include <QList>
 #include <QMap>
+#include <QPair>
+#include <QString>
+#include <QThread>
+#include "models/page-api.h"
 
 
 namespace Ui
@@ -11,10 +17,18 @@ namespace Ui
 }
 
 
+class Api;
+class Md5FixWorker;
 class Profile;
 class Site;
 class Page;
 
+/**
+ * First step of the blacklist fixer, getting the tags of all the files of a directory.
+ *
+ * Files are listed and hashed in a background thread by the same worker as the MD5 fixer. Their tags are then
+ * searched by MD5, many of them at once if the site supports it (see "batchMd5s" in the source models).
+ */
 class BlacklistFix1 : public QDialog
 {
 	Q_OBJECT
@@ -25,15 +39,32 @@ class BlacklistFix1 : public QDialog
 
 	private slots:
 		void getAll(Page *p = nullptr);
+		void batchFinished(PageApi *pageApi, PageApi::LoadResult status);
 		void on_buttonCancel_clicked();
 		void on_buttonContinue_clicked();
 
+		// Worker events
+		void workerMd5sCalculated(const QList<QPair<QString, QString>> &md5s);
+		void workerFinished(int loadedCount);
+
+	protected:
+		Api *batchApi(Site *site) const;
+		void loadBatch(Site *site, Api *api);
+		void showResults();
+
+	signals:
+		void startWorker(const QString &dir, const QString &format, const QStringList &suffixes, bool force, const QString &cacheFile);
+
 	private:
 		Ui::BlacklistFix1 *ui;
 		Profile *m_profile;
 		QMap<QString, Site*> m_sites;
+		QThread m_thread;
+		Md5FixWorker *m_worker;
+		QString m_directory;
 		QList<QMap<QString, QString>> m_details;
 		QMap<QString, QMap<QString, QString>> m_getAll;
+		QHash<PageApi*, QPair<Page*, int>> m_batches;
 };
 
 #endif // BLACKLIST_FIX_1_H
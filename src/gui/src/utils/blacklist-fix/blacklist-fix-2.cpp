@@ -8,6 +8,18 @@
 #include "models/filtering/post-filter.h"
 
 
+struct ThumbnailLoader
+{
+	typedef QImage result_type;
+
+	QImage operator()(const QString &path) const
+	{
+		const QImage image(path);
+		return image.isNull() ? image : image.scaledToHeight(50, Qt::SmoothTransformation);
+	}
+};
+
+
 BlacklistFix2::BlacklistFix2(QList<QMap<QString, QString>> details, Blacklist blacklist, QWidget *parent)
 	: QDialog(parent), ui(new Ui::BlacklistFix2), m_details(std::move(details)), m_blacklist(std::move(blacklist))
 {
@@ -45,17 +57,28 @@ BlacklistFix2::BlacklistFix2(QList<QMap<QString, QString>> details, Blacklist bl
 	headerView->resizeSection(1, 50);
 	headerView->setSectionResizeMode(2, QHeaderView::Stretch);
 
-	QtConcurrent::run(this, &BlacklistFix2::loadThumbnails);
+	// Thumbnails are decoded in parallel, and each one is shown as soon as it is ready
+	QStringList paths;
+	paths.reserve(m_details.count());
+	for (const auto &det : qAsConst(m_details)) {
+		paths.append(det.value("path_full"));
+	}
+	connect(&m_thumbnailsWatcher, &QFutureWatcher<QImage>::resultReadyAt, this, &BlacklistFix2::thumbnailLoaded);
+	m_thumbnailsWatcher.setFuture(QtConcurrent::mapped(paths, ThumbnailLoader()));
 }
 BlacklistFix2::~BlacklistFix2()
 {
+	m_thumbnailsWatcher.cancel();
+	m_thumbnailsWatcher.waitForFinished();
+
 	delete ui;
 }
 
-void BlacklistFix2::loadThumbnails()
+void BlacklistFix2::thumbnailLoaded(int index)
 {
-	for (int i = 0; i < m_previews.count(); ++i) {
-		m_previews[i]->setPixmap(QPixmap(m_details[i]["path_full"]).scaledToHeight(50, Qt::SmoothTransformation));
+	const QImage image = m_thumbnailsWatcher.resultAt(index);
+	if (!image.isNull()) {
+		m_previews[index]->setPixmap(QPixmap::fromImage(image));
 	}
 }
 
@@ -95,6 +118,9 @@ void BlacklistFix2::on_buttonOk_clicked()
 	// Sort in ascending order to help the following foreach with deletion
 	std::sort(rows.begin(), rows.end());
 
+	// Removing rows deletes their preview label, so no thumbnail must be set anymore
+	m_thumbnailsWatcher.cancel();
+
 	// Delete files and their associated rows
 	int rem = 0;
 	for (int i : qAsConst(rows)) {
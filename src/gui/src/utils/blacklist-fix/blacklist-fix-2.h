@@ -2,6 +2,8 @@
 #define BLACKLIST_FIX_2_H
 
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QLabel>
 #include "models/filtering/blacklist.h"
 
@@ -22,7 +24,7 @@ class BlacklistFix2 : public QDialog
 		~BlacklistFix2() override;
 
 	private slots:
-		void loadThumbnails();
+		void thumbnailLoaded(int index);
 		void on_buttonSelectBlacklisted_clicked();
 		void on_buttonCancel_clicked();
 		void on_buttonOk_clicked();
@@ -32,6 +34,7 @@ class BlacklistFix2 : public QDialog
 		QList<QMap<QString, QString>> m_details;
 		QList<QLabel*> m_previews;
 		Blacklist m_blacklist;
+		QFutureWatcher<QImage> m_thumbnailsWatcher;
 };
 
 #endif // BLACKLIST_FIX_2_H
@@ -1,14 +1,65 @@
 #include "utils/empty-dirs-fix/empty-dirs-fix-1.h"
 #include <QDir>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QSettings>
 #include <QStringList>
+#include <QtConcurrent>
 #include <ui_empty-dirs-fix-1.h>
 #include "functions.h"
 #include "models/profile.h"
 #include "utils/empty-dirs-fix/empty-dirs-fix-2.h"
 
 
+/**
+ * Check whether a directory is empty, in a single pass over its tree.
+ * If it is not, its empty sub-directories are added to the list, otherwise the caller adds the directory itself.
+ */
+static bool listEmptyDirs(const QDir &dir, QStringList &emptyDirs)
+{
+	bool empty = true;
+	QStringList found;
+
+	// Symbolic links are not followed, and count as content of their directory
+	const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+	for (const QFileInfo &entry : entries) {
+		if (!entry.isDir() || entry.isSymLink()) {
+			empty = false;
+			continue;
+		}
+
+		const QString path = dir.path() + "/" + entry.fileName();
+		if (listEmptyDirs(QDir(path), found)) {
+			found.append(path);
+		} else {
+			empty = false;
+		}
+	}
+
+	if (!empty) {
+		emptyDirs.append(found);
+	}
+	return empty;
+}
+
+/**
+ * Get the empty folders of a top-level folder, which is itself returned if it is empty.
+ */
+struct EmptyDirsScanner
+{
+	typedef QStringList result_type;
+
+	QStringList operator()(const QString &path) const
+	{
+		QStringList found;
+		if (listEmptyDirs(QDir(path), found)) {
+			return QStringList { path };
+		}
+		return found;
+	}
+};
+
+
 EmptyDirsFix1::EmptyDirsFix1(Profile *profile, QWidget *parent)
 	: QDialog(parent), ui(new Ui::EmptyDirsFix1)
 {
@@ -16,55 +67,63 @@ EmptyDirsFix1::EmptyDirsFix1(Profile *profile, QWidget *parent)
 
 	QSettings *settings = profile->getSettings();
 	ui->lineFolder->setText(settings->value("Save/path").toString());
+	ui->progressBar->hide();
+
+	connect(&m_scanWatcher, &QFutureWatcher<QStringList>::progressRangeChanged, ui->progressBar, &QProgressBar::setRange);
+	connect(&m_scanWatcher, &QFutureWatcher<QStringList>::progressValueChanged, ui->progressBar, &QProgressBar::setValue);
+	connect(&m_scanWatcher, &QFutureWatcher<QStringList>::finished, this, &EmptyDirsFix1::scanFinished);
+
+	resize(size().width(), 0);
 }
 
 EmptyDirsFix1::~EmptyDirsFix1()
 {
+	m_scanWatcher.cancel();
+	m_scanWatcher.waitForFinished();
+
 	delete ui;
 }
 
 
 void EmptyDirsFix1::next()
 {
-	QStringList dirs = mkList(QDir(fixFilename("", ui->lineFolder->text())));
+	ui->buttonContinue->setEnabled(false);
 
-	// We don't continue if there were no folders found
-	if (dirs.isEmpty()) {
-		QMessageBox::information(this, tr("Empty folders fixer"), tr("No empty folder found."));
-		close();
-		return;
+	// Top-level folders are scanned in parallel
+	const QDir root(fixFilename("", ui->lineFolder->text()));
+	QStringList dirs;
+	for (const QFileInfo &entry : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+		if (!entry.isSymLink()) {
+			dirs.append(root.path() + "/" + entry.fileName());
+		}
 	}
 
-	auto *edf2 = new EmptyDirsFix2(dirs);
-	close();
-	edf2->show();
+	ui->progressBar->setValue(0);
+	ui->progressBar->setMaximum(dirs.count());
+	ui->progressBar->show();
+
+	m_scanWatcher.setFuture(QtConcurrent::mapped(dirs, EmptyDirsScanner()));
 }
 
-QStringList EmptyDirsFix1::mkList(const QDir &dir)
+void EmptyDirsFix1::scanFinished()
 {
-	QStringList ret;
-	QStringList dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-	for (int i = 0; i < dirs.size(); i++) {
-		if (isEmpty(QDir(dir.path() + "/" + dirs.at(i)))) {
-			ret.append(dir.path() + "/" + dirs.at(i));
-		} else {
-			ret.append(mkList(QDir(dir.path() + "/" + dirs.at(i))));
-		}
+	if (m_scanWatcher.isCanceled()) {
+		return;
 	}
-	return ret;
-}
 
-bool EmptyDirsFix1::isEmpty(const QDir &dir)
-{
-	QStringList files = dir.entryList(QDir::Files);
-	if (!files.isEmpty()) {
-		return false;
+	QStringList dirs;
+	for (const QStringList &found : m_scanWatcher.future().results()) {
+		dirs.append(found);
 	}
 
-	QStringList dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-	bool empty = true;
-	for (int i = 0; i < dirs.size(); i++) {
-		empty = empty && isEmpty(QDir(dir.path() + "/" + dirs.at(i)));
+	// We don't continue if there were no folders found
+	if (dirs.isEmpty()) {
+		QMessageBox::information(this, tr("Empty folders fixer"), tr("No empty folder found."));
+		close();
+		return;
 	}
-	return empty;
+
+	auto *edf2 = new EmptyDirsFix2(dirs);
+	close();
+	edf2->show();
 }
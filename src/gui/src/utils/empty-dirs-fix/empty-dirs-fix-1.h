@@ -2,6 +2,8 @@
 #define EMPTY_DIRS_FIX_1_H
 
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QStringList>
 
 
 namespace Ui
@@ -11,9 +13,12 @@ namespace Ui
 
 
 class Profile;
-class QDir;
-class QStringList;
 
+/**
+ * First step of the empty folders fixer, finding the empty folders of a directory.
+ *
+ * Each top-level folder is scanned in parallel in the background, the progress bar showing how many were done.
+ */
 class EmptyDirsFix1 : public QDialog
 {
 	Q_OBJECT
@@ -25,12 +30,12 @@ class EmptyDirsFix1 : public QDialog
 	public slots:
 		void next();
 
-	private:
-		QStringList mkList(const QDir &dir);
-		bool isEmpty(const QDir &dir);
+	private slots:
+		void scanFinished();
 
 	private:
 		Ui::EmptyDirsFix1 *ui;
+		QFutureWatcher<QStringList> m_scanWatcher;
 };
 
 #endif // EMPTY_DIRS_FIX_1_H
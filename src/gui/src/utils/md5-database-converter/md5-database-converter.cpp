@@ -2,8 +2,9 @@
 #include <QMessageBox>
 #include <ui_md5-database-converter.h>
 #include "models/md5-database/md5-database.h"
-#include "models/md5-database/md5-database-text.h"
+#include "models/md5-database/md5-database-binary.h"
 #include "models/md5-database/md5-database-sqlite.h"
+#include "models/md5-database/md5-database-text.h"
 #include "models/profile.h"
 
 
@@ -21,7 +22,6 @@ Md5DatabaseConverter::Md5DatabaseConverter(Profile *profile, QWidget *parent)
 		ui->labelError->hide();
 	}
 
-	m_dbSqlite = new Md5DatabaseSqlite(m_profile->getPath() + "/md5s.sqlite", m_profile->getSettings());
 	m_dbText = md5sText;
 
 	ui->progressBar->hide();
@@ -53,12 +53,21 @@ void Md5DatabaseConverter::start()
 
 	// Migrate database
 	const auto &md5s = m_dbText->getAll();
-	m_dbSqlite->setMd5s(md5s);
-	m_dbSqlite->sync();
+	int count;
+	if (ui->comboTarget->currentIndex() == 1) {
+		Md5DatabaseBinary dbBinary(m_profile->getPath() + "/md5s.bin", m_profile->getSettings());
+		dbBinary.setMd5s(md5s);
+		count = dbBinary.count();
+	} else {
+		Md5DatabaseSqlite dbSqlite(m_profile->getPath() + "/md5s.sqlite", m_profile->getSettings());
+		dbSqlite.setMd5s(md5s);
+		dbSqlite.sync();
+		count = dbSqlite.count();
+	}
 
 	// Hide progress bar
 	ui->progressBar->hide();
 	resize(size().width(), 0);
 
-	QMessageBox::information(this, tr("Finished"), tr("%n md5(s) converted (out of %1)", "", m_dbSqlite->count()).arg(m_dbText->count()));
+	QMessageBox::information(this, tr("Finished"), tr("%n md5(s) converted (out of %1)", "", count).arg(m_dbText->count()));
 }
@@ -10,7 +10,6 @@ namespace Ui
 }
 
 
-class Md5DatabaseSqlite;
 class Md5DatabaseText;
 class Profile;
 class Site;
@@ -30,7 +29,6 @@ class Md5DatabaseConverter : public QDialog
 	private:
 		Ui::Md5DatabaseConverter *ui;
 		Profile *m_profile;
-		Md5DatabaseSqlite *m_dbSqlite;
 		Md5DatabaseText *m_dbText;
 };
 
@@ -1,35 +1,174 @@
 #include "utils/md5-fix/md5-fix-worker.h"
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
 #include "functions.h"
+#include "logger.h"
+#include "utils/file-utils.h"
+#include "utils/md5-multi-buffer.h"
 
+#define CHUNK_SIZE 64
 
-void Md5FixWorker::doWork(const QString &d, const QString &format, const QStringList &suffixes, bool force)
+
+/**
+ * Hash a group of files, except the ones whose size and modification date didn't change since their MD5 was cached.
+ * Files of the same group are hashed together, each in its own lane of the multi-buffer MD5.
+ */
+struct Md5FixHasher
+{
+	typedef QList<Md5FixWorker::File> result_type;
+
+	const QHash<QString, Md5FixWorker::File> *cache;
+
+	QList<Md5FixWorker::File> operator()(const QStringList &paths) const
+	{
+		QList<Md5FixWorker::File> files;
+		files.reserve(paths.count());
+		QStringList toHash;
+		QList<int> toHashIndexes;
+
+		for (const QString &path : paths) {
+			const QFileInfo info(path);
+			Md5FixWorker::File file { path, info.size(), info.lastModified().toMSecsSinceEpoch(), QString() };
+
+			const auto it = cache->constFind(path);
+			if (it != cache->constEnd() && it->size == file.size && it->lastModified == file.lastModified) {
+				file.md5 = it->md5;
+			} else {
+				toHash.append(path);
+				toHashIndexes.append(files.count());
+			}
+
+			files.append(file);
+		}
+
+		const QStringList md5s = Md5MultiBuffer::hashFiles(toHash);
+		for (int i = 0; i < md5s.count(); ++i) {
+			files[toHashIndexes[i]].md5 = md5s[i];
+		}
+
+		return files;
+	}
+};
+
+
+QHash<QString, Md5FixWorker::File> Md5FixWorker::loadCache(const QString &cacheFile)
+{
+	QHash<QString, File> cache;
+	if (cacheFile.isEmpty()) {
+		return cache;
+	}
+
+	QFile file(cacheFile);
+	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+		return cache;
+	}
+
+	// Each line is "size;lastModified;md5;path", the path being last as it can contain semicolons
+	while (!file.atEnd()) {
+		const QString line = QString::fromUtf8(file.readLine()).trimmed();
+		const QStringList parts = line.split(';');
+		if (parts.count() < 4) {
+			continue;
+		}
+
+		const QString path = line.section(';', 3);
+		cache.insert(path, File { path, parts[0].toLongLong(), parts[1].toLongLong(), parts[2] });
+	}
+
+	return cache;
+}
+
+void Md5FixWorker::saveCache(const QString &cacheFile, const QHash<QString, File> &cache)
+{
+	if (cacheFile.isEmpty()) {
+		return;
+	}
+
+	QFile file(cacheFile);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+		log(QStringLiteral("Could not open MD5 cache file '%1': %2").arg(cacheFile, file.errorString()), Logger::Error);
+		return;
+	}
+
+	for (const File &entry : cache) {
+		if (!entry.md5.isEmpty()) {
+			file.write(QString("%1;%2;%3;%4\n").arg(QString::number(entry.size), QString::number(entry.lastModified), entry.md5, entry.path).toUtf8());
+		}
+	}
+}
+
+void Md5FixWorker::doWork(const QString &d, const QString &format, const QStringList &suffixes, bool force, const QString &cacheFile)
 {
 	QDir dir(d);
 
-	// Get all files from the destination directory
-	auto files = listFilesFromDirectory(dir, suffixes);
-	emit maximumSet(files.count());
+	QHash<QString, File> cache;
+	if (force) {
+		cache = loadCache(cacheFile);
+	}
 
 	int loaded = 0;
 	int total = 0;
 
-	// Parse all files
-	for (const auto &file : files) {
-		const QString fileName = file.first;
-		const QString path = dir.absoluteFilePath(fileName);
+	// Parse all files, chunk by chunk
+	QStringList chunk;
+	const auto processChunk = [&]() {
+		QList<QPair<QString, QString>> md5s;
 
-		QString md5 = force
-			? getFileMd5(path)
-			: getFilenameMd5(fileName, format);
+		if (force) {
+			QList<QStringList> groups;
+			for (int i = 0; i < chunk.count(); ++i) {
+				if (i % Md5MultiBuffer::Lanes == 0) {
+					groups.append(QStringList());
+				}
+				groups.last().append(dir.absoluteFilePath(chunk[i]));
+			}
 
-		if (!md5.isEmpty()) {
-			emit md5Calculated(md5, path);
-			loaded++;
+			const QList<QList<File>> hashed = QtConcurrent::blockingMapped<QList<QList<File>>>(groups, Md5FixHasher { &cache });
+			for (const QList<File> &group : hashed) {
+				for (const File &file : group) {
+					if (!file.md5.isEmpty()) {
+						md5s.append(qMakePair(file.md5, file.path));
+						cache.insert(file.path, file);
+					}
+				}
+			}
+		} else {
+			for (const QString &fileName : qAsConst(chunk)) {
+				const QString md5 = getFilenameMd5(fileName, format);
+				if (!md5.isEmpty()) {
+					md5s.append(qMakePair(md5, dir.absoluteFilePath(fileName)));
+				}
+			}
 		}
-		total++;
 
+		loaded += md5s.count();
+		total += chunk.count();
+		chunk.clear();
+
+		if (!md5s.isEmpty()) {
+			emit md5sCalculated(md5s);
+		}
 		emit valueSet(total);
+	};
+
+	// Files are processed as soon as they are found, so the total count is only known at the end
+	emit maximumSet(0);
+	walkFilesFromDirectory(dir, suffixes, [&](const QString &fileName, const QStringList &) {
+		chunk.append(fileName);
+		if (chunk.count() >= CHUNK_SIZE) {
+			processChunk();
+		}
+		return true;
+	});
+	if (!chunk.isEmpty()) {
+		processChunk();
+	}
+
+	if (force) {
+		saveCache(cacheFile, cache);
 	}
 
 	emit finished(loaded);
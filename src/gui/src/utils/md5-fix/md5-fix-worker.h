@@ -1,20 +1,44 @@
 #ifndef MD5_FIX_WORKER_H
 #define MD5_FIX_WORKER_H
 
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPair>
+#include <QString>
 
 
+/**
+ * Calculates the MD5s of all the files of a directory.
+ *
+ * Files are hashed in parallel, in chunks so that only a limited number of them are being read at the same time.
+ * When hashing file contents, the size, modification date and MD5 of each file is saved to a cache file, so that
+ * running the tool again on the same directory only hashes files that changed since.
+ */
 class Md5FixWorker : public QObject
 {
 	Q_OBJECT
 
+	public:
+		struct File
+		{
+			QString path;
+			qint64 size;
+			qint64 lastModified;
+			QString md5;
+		};
+
 	public slots:
-		void doWork(const QString &dir, const QString &filename, const QStringList &suffixes, bool force);
+		void doWork(const QString &dir, const QString &filename, const QStringList &suffixes, bool force, const QString &cacheFile);
+
+	protected:
+		static QHash<QString, File> loadCache(const QString &cacheFile);
+		static void saveCache(const QString &cacheFile, const QHash<QString, File> &cache);
 
 	signals:
 		void maximumSet(int max);
 		void valueSet(int value);
-		void md5Calculated(const QString &md5, const QString &path);
+		void md5sCalculated(const QList<QPair<QString, QString>> &md5s);
 		void finished(int loadedCount);
 };
 
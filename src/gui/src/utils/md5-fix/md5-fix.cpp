@@ -22,13 +22,15 @@ Md5Fix::Md5Fix(Profile *profile, QWidget *parent)
 	ui->lineSuffixes->setText(getExternalLogFilesSuffixes(profile->getSettings()).join(", "));
 	ui->progressBar->hide();
 
+	qRegisterMetaType<QList<QPair<QString, QString>>>("QList<QPair<QString,QString>>");
+
 	m_worker = new Md5FixWorker();
 	m_worker->moveToThread(&m_thread);
 	connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
 	connect(this, &Md5Fix::startWorker, m_worker, &Md5FixWorker::doWork);
 	connect(m_worker, &Md5FixWorker::maximumSet, this, &Md5Fix::workerMaximumSet);
 	connect(m_worker, &Md5FixWorker::valueSet, this, &Md5Fix::workerValueSet);
-	connect(m_worker, &Md5FixWorker::md5Calculated, this, &Md5Fix::workerMd5Calculated);
+	connect(m_worker, &Md5FixWorker::md5sCalculated, this, &Md5Fix::workerMd5sCalculated);
 	connect(m_worker, &Md5FixWorker::finished, this, &Md5Fix::workerFinished);
 
 	m_thread.start();
@@ -52,11 +54,10 @@ void Md5Fix::cancel()
 
 void Md5Fix::workerMaximumSet(int max)
 {
-	if (max > 0) {
-		ui->progressBar->setValue(0);
-		ui->progressBar->setMaximum(max);
-		ui->progressBar->show();
-	}
+	// A maximum of 0 shows a busy indicator, for when the number of files is not known yet
+	ui->progressBar->setValue(0);
+	ui->progressBar->setMaximum(max);
+	ui->progressBar->show();
 }
 
 void Md5Fix::workerValueSet(int value)
@@ -64,9 +65,9 @@ void Md5Fix::workerValueSet(int value)
 	ui->progressBar->setValue(value);
 }
 
-void Md5Fix::workerMd5Calculated(const QString &md5, const QString &path)
+void Md5Fix::workerMd5sCalculated(const QList<QPair<QString, QString>> &md5s)
 {
-	m_profile->addMd5(md5, path);
+	m_profile->addMd5s(md5s);
 }
 
 void Md5Fix::workerFinished(int loadedCount)
@@ -109,5 +110,5 @@ void Md5Fix::start()
 		suffix = suffix.trimmed();
 	}
 
-	emit startWorker(dir, ui->lineFilename->text(), suffixes, force);
+	emit startWorker(dir, ui->lineFilename->text(), suffixes, force, m_profile->getPath() + "/md5-fix-cache.txt");
 }
@@ -29,11 +29,11 @@ class Md5Fix : public QDialog
 		// Worker events
 		void workerMaximumSet(int max);
 		void workerValueSet(int value);
-		void workerMd5Calculated(const QString &md5, const QString &path);
+		void workerMd5sCalculated(const QList<QPair<QString, QString>> &md5s);
 		void workerFinished(int loadedCount);
 
 	signals:
-		void startWorker(const QString &dir, const QString &format, const QStringList &suffixes, bool force);
+		void startWorker(const QString &dir, const QString &format, const QStringList &suffixes, bool force, const QString &cacheFile);
 
 	private:
 		Ui::Md5Fix *ui;
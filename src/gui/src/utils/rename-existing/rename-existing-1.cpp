@@ -5,20 +5,106 @@
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QSettings>
+#include <QtConcurrent>
 #include <ui_rename-existing-1.h>
+#include "downloader/details-batcher.h"
 #include "functions.h"
 #include "helpers.h"
 #include "loader/token.h"
 #include "logger.h"
 #include "models/api/api.h"
 #include "models/filename.h"
+#include "models/filtering/post-filter.h"
 #include "models/image.h"
 #include "models/page.h"
 #include "models/profile.h"
 #include "models/site.h"
 #include "network/network-reply.h"
+#include "utils/file-utils.h"
 #include "utils/rename-existing/rename-existing-2.h"
 
+#define SIMULTANEOUS_REQUESTS 5
+#define RESULTS_CHUNK_SIZE 100
+#define SCAN_CHUNK_SIZE 256
+
+
+enum class RenameExistingKey
+{
+	FilenameMd5,
+	FileMd5,
+	FilenameId,
+};
+
+/**
+ * Get the key of a file from its name or its content. Used in parallel, since it can require reading whole files.
+ */
+struct RenameExistingKeyGetter
+{
+	typedef RenameExistingFile result_type;
+
+	QString root;
+	RenameExistingKey type;
+	QString format;
+
+	RenameExistingFile operator()(const QPair<QString, QStringList> &file) const
+	{
+		const QString path = root + QLatin1Char('/') + file.first;
+
+		RenameExistingFile det;
+		if (type == RenameExistingKey::FilenameId) {
+			det.key = getFilenameId(file.first, format);
+		} else if (type == RenameExistingKey::FileMd5) {
+			det.key = getFileMd5(path);
+		} else {
+			det.key = getFilenameMd5(file.first, format);
+		}
+		if (det.key.isEmpty()) {
+			return det;
+		}
+
+		det.path = QDir::toNativeSeparators(path);
+		if (!file.second.isEmpty()) {
+			QStringList children;
+			children.reserve(file.second.count());
+			for (const QString &child : file.second) {
+				children.append(QDir::toNativeSeparators(root + QLatin1Char('/') + child));
+			}
+			det.children = children;
+		}
+		return det;
+	}
+};
+
+static QList<RenameExistingFile> scanDirectory(const QString &root, const QStringList &suffixes, RenameExistingKey type, const QString &format)
+{
+	QList<RenameExistingFile> ret;
+	QList<QPair<QString, QStringList>> chunk;
+	const auto parseChunk = [&]() {
+		const auto parsed = QtConcurrent::blockingMapped<QList<RenameExistingFile>>(chunk, RenameExistingKeyGetter { root, type, format });
+		for (const RenameExistingFile &det : parsed) {
+			if (!det.key.isEmpty()) {
+				ret.append(det);
+			}
+		}
+		chunk.clear();
+	};
+
+	// Files are parsed as soon as they are found, while the next directories are being listed
+	walkFilesFromDirectory(QDir(root), suffixes, [&](const QString &fileName, const QStringList &children) {
+		chunk.append(qMakePair(fileName, children));
+		if (chunk.count() >= SCAN_CHUNK_SIZE) {
+			parseChunk();
+		}
+		return true;
+	});
+	if (!chunk.isEmpty()) {
+		parseChunk();
+	}
+
+	return ret;
+}
+
+
 
 RenameExisting1::RenameExisting1(Site *selected, Profile *profile, QWidget *parent)
 	: QDialog(parent), ui(new Ui::RenameExisting1), m_profile(profile), m_sites(profile->getSites()), m_needDetails(0), m_useIdKey(false)
@@ -36,6 +122,8 @@ RenameExisting1::RenameExisting1(Site *selected, Profile *profile, QWidget *pare
 	ui->lineFilenameDestination->setText(settings->value("Save/filename").toString());
 	ui->progressBar->hide();
 
+	connect(&m_scanWatcher, &QFutureWatcher<QList<RenameExistingFile>>::finished, this, &RenameExisting1::scanFinished);
+
 	resize(size().width(), 0);
 }
 
@@ -46,10 +134,26 @@ RenameExisting1::~RenameExisting1()
 
 void RenameExisting1::on_buttonCancel_clicked()
 {
+	cancel();
 	emit rejected();
 	close();
 }
 
+void RenameExisting1::cancel()
+{
+	m_cancelled = true;
+	for (auto it = m_replies.constBegin(); it != m_replies.constEnd(); ++it) {
+		it.key()->abort();
+	}
+
+	// Renaming only part of the files is not possible
+	if (m_nextStep != nullptr) {
+		disconnect(m_nextStep, nullptr, this, nullptr);
+		m_nextStep->close();
+		m_nextStep = nullptr;
+	}
+}
+
 void RenameExisting1::on_buttonContinue_clicked()
 {
 	ui->buttonContinue->setEnabled(false);
@@ -82,98 +186,146 @@ void RenameExisting1::on_buttonContinue_clicked()
 		suffix = suffix.trimmed();
 	}
 
-	// Get all files from the destination directory
-	auto files = listFilesFromDirectory(dir, suffixes);
+	// Show an indeterminate progress bar during the scan
+	ui->progressBar->setValue(0);
+	ui->progressBar->setMaximum(0);
+	ui->progressBar->show();
 
-	// Parse all files
-	for (const auto &file : files) {
-		const QString fileName = file.first;
-		const QString path = dir.absoluteFilePath(fileName);
-
-		QString key;
-		if (m_useIdKey) {
-			key = getFilenameId(fileName, ui->lineFilenameOrigin->text());
-		} else {
-			key = ui->radioForceMd5->isChecked()
-				? getFileMd5(path)
-				: getFilenameMd5(fileName, ui->lineFilenameOrigin->text());
-		}
+	// Get all files from the destination directory and parse them in the background
+	const RenameExistingKey keyType = m_useIdKey
+		? RenameExistingKey::FilenameId
+		: (ui->radioForceMd5->isChecked() ? RenameExistingKey::FileMd5 : RenameExistingKey::FilenameMd5);
+	m_scanWatcher.setFuture(QtConcurrent::run(scanDirectory, dir.absolutePath(), suffixes, keyType, ui->lineFilenameOrigin->text()));
+}
 
-		if (!key.isEmpty()) {
-			RenameExistingFile det;
-			det.key = key;
-			det.path = QDir::toNativeSeparators(path);
-			if (!file.second.isEmpty()) {
-				QStringList children;
-				children.reserve(file.second.count());
-				for (const QString &child : file.second) {
-					children.append(QDir::toNativeSeparators(dir.absoluteFilePath(child)));
-				}
-				det.children = children;
-			}
-			m_details.append(det);
-		}
-	}
+void RenameExisting1::scanFinished()
+{
+	m_details = m_scanWatcher.result();
+	ui->progressBar->hide();
 
 	// Check if filename requires details
 	m_filename.setFormat(ui->lineFilenameDestination->text());
 	m_needDetails = m_filename.needExactTags(m_sites.value(ui->comboSource->currentText()), m_profile->getSettings());
 
 	const int response = QMessageBox::question(this, tr("Rename existing images"), tr("You are about to download information from %n image(s). Are you sure you want to continue?", "", m_details.size()), QMessageBox::Yes | QMessageBox::No);
-	if (response == QMessageBox::Yes) {
-		// Show progress bar
-		ui->progressBar->setValue(0);
-		ui->progressBar->setMaximum(m_details.size());
-		ui->progressBar->show();
-
-		loadNext();
-	} else {
+	if (response != QMessageBox::Yes) {
+		m_details.clear();
 		ui->buttonContinue->setEnabled(true);
+		return;
 	}
+
+	// Show progress bar
+	ui->progressBar->setValue(0);
+	ui->progressBar->setMaximum(m_details.size());
+	ui->progressBar->show();
+
+	// The next step is shown right away, and filled as results arrive
+	m_nextStep = new RenameExisting2(QDir::toNativeSeparators(ui->lineFolder->text()), parentWidget());
+	connect(m_nextStep, &RenameExisting2::rejected, this, &RenameExisting1::on_buttonCancel_clicked);
+	m_nextStep->show();
+
+	loadNext();
 }
 
 void RenameExisting1::getAll(Page *p)
 {
+	const QString key = m_pages.take(p);
+	p->deleteLater();
+	if (m_cancelled) {
+		return;
+	}
+
 	if (p->images().isEmpty()) {
 		log(tr("No image found when renaming image '%1'").arg(p->search().join(' ')), Logger::Warning);
-		ui->progressBar->setValue(ui->progressBar->value() + 1);
-		loadNext();
+		fileFinished(key);
+	} else {
+		handleImage(p->images().at(0), key);
+	}
+
+	requestFinished();
+}
+
+void RenameExisting1::batchFinished(PageApi *pageApi, PageApi::LoadResult status)
+{
+	const Batch batch = m_batches.take(pageApi);
+	batch.page->deleteLater();
+	if (m_cancelled) {
 		return;
 	}
 
-	const QSharedPointer<Image> img = p->images().at(0);
+	QHash<QString, QSharedPointer<Image>> results;
+	if (status == PageApi::LoadResult::Ok) {
+		for (const QSharedPointer<Image> &img : pageApi->images()) {
+			results.insert(QString::number(img->id()), img);
+		}
+	}
+
+	int missing = 0;
+	for (const QString &key : batch.keys) {
+		const QSharedPointer<Image> img = results.value(key);
+		if (img.isNull()) {
+			missing++;
+			fileFinished(key);
+		} else {
+			handleImage(img, key);
+		}
+	}
+	if (missing > 0) {
+		log(tr("No image found for %n image(s) when renaming images", "", missing), Logger::Warning);
+	}
+
+	requestFinished();
+}
+
+void RenameExisting1::handleImage(const QSharedPointer<Image> &img, const QString &key)
+{
 	if (m_needDetails == 2 || (m_needDetails == 1 && img->hasUnknownTag())) {
+		m_running++;
+		m_images.insert(img.data(), qMakePair(img, key));
 		connect(img.data(), &Image::finishedLoadingTags, this, &RenameExisting1::getTags);
-		img->loadDetails();
+		img->parentSite()->detailsBatcher()->loadDetails(img);
 	} else {
-		setImageResult(img.data());
+		setImageResult(img.data(), key);
 	}
 }
 
 void RenameExisting1::getTags()
 {
 	auto *img = dynamic_cast<Image*>(sender());
-	setImageResult(img);
+	disconnect(img, &Image::finishedLoadingTags, this, &RenameExisting1::getTags);
+
+	// Keep the image alive until we're done with it
+	const auto loading = m_images.take(img);
+	if (m_cancelled) {
+		return;
+	}
+
+	setImageResult(loading.first.data(), loading.second);
+	requestFinished();
 }
 
 void RenameExisting1::fullDetailsFinished()
 {
 	auto *reply = qobject_cast<NetworkReply*>(sender());
+	const QString key = m_replies.take(reply);
+	reply->deleteLater();
+	if (m_cancelled) {
+		return;
+	}
 
 	// Network error
 	if (reply->error()) {
 		if (reply->error() != NetworkReply::NetworkError::OperationCanceledError) {
 			log(QStringLiteral("Error loading full image details for '%1': %2").arg(reply->url().toString(), reply->errorString()), Logger::Error);
 		}
-		reply->deleteLater();
-		loadNext();
+		fileFinished(key);
+		requestFinished();
 		return;
 	}
 
-	// Extract data from reply and clean it up
+	// Extract data from reply
 	const QString source = QString::fromUtf8(reply->readAll());
 	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-	reply->deleteLater();
 
 	// Parse response
 	Site *site = m_sites.value(ui->comboSource->currentText());
@@ -183,63 +335,134 @@ void RenameExisting1::fullDetailsFinished()
 	// Parsing error
 	if (!parsed.error.isEmpty()) {
 		log(QStringLiteral("Error loading full image details: %1").arg(parsed.error), Logger::Error);
-		loadNext();
-		return;
+		fileFinished(key);
+	} else {
+		setImageResult(parsed.image.data(), key);
 	}
 
-	setImageResult(parsed.image.data());
+	requestFinished();
 }
 
-void RenameExisting1::setImageResult(Image *img)
+void RenameExisting1::setImageResult(Image *img, const QString &key)
 {
-	const QString &key = m_useIdKey ? QString::number(img->id()) : img->md5();
 	const QString &dir = ui->lineFolder->text();
 
-	if (!key.isEmpty()) {
-		QFileInfo fi(m_getAll[key].path);
+	if (m_loading.contains(key)) {
+		QFileInfo fi(m_loading[key].path);
 		auto tokens = img->tokens(m_profile);
 		tokens.insert("old_directory", Token(fi.absolutePath().mid(dir.count() + (dir.endsWith("/") || dir.endsWith("\\") ? 0 : 1))));
 		tokens.insert("old_filename", Token(fi.fileName()));
 
-		Filename fn(ui->lineFilenameDestination->text());
-		QStringList paths = fn.path(tokens, m_profile, dir, 0, Filename::Complex | Filename::Path);
-		m_getAll[key].newPath = paths.first();
+		QStringList paths = m_filename.path(tokens, m_profile, dir, 0, Filename::Complex | Filename::Path);
+		m_loading[key].newPath = paths.first();
 	} else {
 		log(QStringLiteral("No key found for image, skipping"), Logger::Warning);
 	}
 
+	fileFinished(key);
+}
+
+/**
+ * Send a file to the next step, whether its new path could be found or not.
+ */
+void RenameExisting1::fileFinished(const QString &key)
+{
+	const auto it = m_loading.find(key);
+	if (it != m_loading.end()) {
+		m_results.append(it.value());
+		m_loading.erase(it);
+	}
+
 	ui->progressBar->setValue(ui->progressBar->value() + 1);
+	if (m_results.count() >= RESULTS_CHUNK_SIZE) {
+		flushResults();
+	}
+}
+
+void RenameExisting1::flushResults()
+{
+	m_nextStep->addDetails(m_results);
+	m_results.clear();
+}
+
+void RenameExisting1::requestFinished()
+{
+	m_running--;
 	loadNext();
 }
 
-void RenameExisting1::loadNext()
+void RenameExisting1::loadBatch(Site *site, Api *api)
 {
-	if (!m_details.isEmpty()) {
+	Batch batch;
+	QList<qulonglong> ids;
+	const int max = api->batchIdsMax();
+	while (ids.count() < max && !m_details.isEmpty()) {
 		const RenameExistingFile det = m_details.takeFirst();
-		m_getAll.insert(det.key, det);
+		m_loading.insert(det.key, det);
+		batch.keys.append(det.key);
+		ids.append(det.key.toULongLong());
+	}
+
+	const QString search = api->batchIdsSearch(ids);
+	log(QStringLiteral("Loading details of %1 images at once").arg(ids.count()), Logger::Info);
+
+	batch.page = new Page(m_profile, site, { site }, QStringList { search }, 1, ids.count(), QStringList(), false, this);
+	auto *pageApi = new PageApi(batch.page, m_profile, site, api, batch.page->query(), 1, ids.count(), PostFilter(), false, batch.page);
+	m_batches.insert(pageApi, batch);
+
+	connect(pageApi, &PageApi::finishedLoading, this, &RenameExisting1::batchFinished);
+	pageApi->load();
+}
 
-		Site *site = m_sites.value(ui->comboSource->currentText());
+void RenameExisting1::loadNext()
+{
+	if (m_cancelled || m_nextStep == nullptr) {
+		return;
+	}
+
+	Site *site = m_sites.value(ui->comboSource->currentText());
+	Api *fullDetailsApi = site->fullDetailsApi();
+	Api *batchApi = m_useIdKey && fullDetailsApi == nullptr ? site->detailsBatcher()->batchApi() : nullptr;
+
+	// Keep a few requests running at the same time, the site's throttling taking care of its rate limits
+	while (m_running < SIMULTANEOUS_REQUESTS && !m_details.isEmpty()) {
+		m_running++;
+
+		// Search many images at once if possible
+		if (batchApi != nullptr) {
+			loadBatch(site, batchApi);
+			continue;
+		}
+
+		const RenameExistingFile det = m_details.takeFirst();
+		m_loading.insert(det.key, det);
 
 		// Try to load the image details from the full details API if available
-		Api *api = site->fullDetailsApi();
-		if (api != nullptr) {
-			QString url = api->detailsUrl(m_useIdKey ? det.key.toLongLong() : 0, !m_useIdKey ? det.key : "", site).url;
+		if (fullDetailsApi != nullptr) {
+			QString url = fullDetailsApi->detailsUrl(m_useIdKey ? det.key.toLongLong() : 0, !m_useIdKey ? det.key : "", site).url;
 			log(QStringLiteral("Loading full image details from `%1`").arg(url), Logger::Info);
 			NetworkReply *reply = site->get(url, Site::QueryType::Details);
+			m_replies.insert(reply, det.key);
 			connect(reply, &NetworkReply::finished, this, &RenameExisting1::fullDetailsFinished);
-			return;
+			continue;
 		}
 
 		// Otherwise, try a "key:VAL" search using the listing API
 		QStringList query(QString(m_useIdKey ? "id" : "md5") + ":" + det.key);
 		Page *page = new Page(m_profile, site, m_sites.values(), query, 1, 1);
+		m_pages.insert(page, det.key);
 		connect(page, &Page::finishedLoading, this, &RenameExisting1::getAll);
 		page->load();
+	}
 
+	if (m_running > 0 || !m_details.isEmpty()) {
 		return;
 	}
 
-	auto *nextStep = new RenameExisting2(m_getAll.values(), QDir::toNativeSeparators(ui->lineFolder->text()), parentWidget());
+	// Everything was loaded
+	flushResults();
+	disconnect(m_nextStep, nullptr, this, nullptr);
+	m_nextStep->loadingFinished();
+	m_nextStep = nullptr;
 	close();
-	nextStep->show();
 }
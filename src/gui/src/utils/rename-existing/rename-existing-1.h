@@ -2,8 +2,13 @@
 #define RENAME_EXISTING_1_H
 
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
 #include <QMap>
+#include <QSharedPointer>
 #include "models/filename.h"
+#include "models/page-api.h"
 #include "rename-existing-file.h"
 
 
@@ -13,9 +18,20 @@ namespace Ui
 }
 
 
-class Site;
+class Api;
+class Image;
+class NetworkReply;
 class Page;
+class RenameExisting2;
+class Site;
 
+/**
+ * First step of the "rename existing images" tool, finding the new path of each file.
+ *
+ * The directory is scanned and the files' keys are extracted in the background, the latter in parallel. Then, the
+ * details of several images are loaded at the same time (many at once if the site supports searching by IDs), and
+ * the results are streamed to the second step in chunks, so that only the files being loaded are kept here.
+ */
 class RenameExisting1 : public QDialog
 {
 	Q_OBJECT
@@ -25,25 +41,48 @@ class RenameExisting1 : public QDialog
 		~RenameExisting1() override;
 
 	private slots:
+		void scanFinished();
 		void getAll(Page *p);
+		void batchFinished(PageApi *pageApi, PageApi::LoadResult status);
 		void getTags();
 		void fullDetailsFinished();
 		void loadNext();
+		void cancel();
 		void on_buttonCancel_clicked();
 		void on_buttonContinue_clicked();
 
 	private:
-		void setImageResult(Image *img);
+		void loadBatch(Site *site, Api *api);
+		void handleImage(const QSharedPointer<Image> &img, const QString &key);
+		void setImageResult(Image *img, const QString &key);
+		void fileFinished(const QString &key);
+		void requestFinished();
+		void flushResults();
 
 	private:
+		struct Batch
+		{
+			Page *page;
+			QStringList keys;
+		};
+
 		Ui::RenameExisting1 *ui;
 		Profile *m_profile;
 		QMap<QString, Site*> m_sites;
 		Filename m_filename;
 		int m_needDetails;
 		bool m_useIdKey;
+		bool m_cancelled = false;
+		int m_running = 0;
+		QFutureWatcher<QList<RenameExistingFile>> m_scanWatcher;
 		QList<RenameExistingFile> m_details;
-		QMap<QString, RenameExistingFile> m_getAll;
+		QHash<QString, RenameExistingFile> m_loading;
+		QList<RenameExistingFile> m_results;
+		QHash<NetworkReply*, QString> m_replies;
+		QHash<Page*, QString> m_pages;
+		QHash<PageApi*, Batch> m_batches;
+		QHash<Image*, QPair<QSharedPointer<Image>, QString>> m_images;
+		RenameExisting2 *m_nextStep = nullptr;
 };
 
 #endif // RENAME_EXISTING_1_H
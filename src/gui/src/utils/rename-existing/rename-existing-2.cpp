@@ -7,12 +7,15 @@
 #include "rename-existing-table-model.h"
 
 
-RenameExisting2::RenameExisting2(QList<RenameExistingFile> details, QString folder, QWidget *parent)
-	: QDialog(parent), ui(new Ui::RenameExisting2), m_details(std::move(details)), m_folder(std::move(folder))
+RenameExisting2::RenameExisting2(QString folder, QWidget *parent)
+	: QDialog(parent), ui(new Ui::RenameExisting2), m_folder(std::move(folder))
 {
 	ui->setupUi(this);
 
-	m_model = new RenameExistingTableModel(m_details, m_folder, this);
+	// Files are added as their new path is computed, so renaming must wait for all of them
+	ui->buttonOk->setEnabled(false);
+
+	m_model = new RenameExistingTableModel(m_folder, this);
 	ui->tableView->setModel(m_model);
 
 	QHeaderView *verticalHeader = ui->tableView->verticalHeader();
@@ -31,6 +34,16 @@ RenameExisting2::~RenameExisting2()
 	delete ui;
 }
 
+void RenameExisting2::addDetails(const QList<RenameExistingFile> &details)
+{
+	m_model->addFiles(details);
+}
+
+void RenameExisting2::loadingFinished()
+{
+	ui->buttonOk->setEnabled(true);
+}
+
 void RenameExisting2::on_buttonCancel_clicked()
 {
 	emit rejected();
@@ -55,7 +68,7 @@ void RenameExisting2::deleteDir(const QString &path)
 void RenameExisting2::on_buttonOk_clicked()
 {
 	// Move all images
-	for (const RenameExistingFile &image : qAsConst(m_details)) {
+	for (const RenameExistingFile &image : m_model->files()) {
 		// Ignore images with no change in path
 		if (image.newPath.isEmpty() || image.newPath == image.path) {
 			continue;
@@ -19,17 +19,20 @@ class RenameExisting2 : public QDialog
 	Q_OBJECT
 
 	public:
-		explicit RenameExisting2(QList<RenameExistingFile> details, QString folder, QWidget *parent = nullptr);
+		explicit RenameExisting2(QString folder, QWidget *parent = nullptr);
 		~RenameExisting2() override;
 		void deleteDir(const QString &path);
 
+	public slots:
+		void addDetails(const QList<RenameExistingFile> &details);
+		void loadingFinished();
+
 	private slots:
 		void on_buttonCancel_clicked();
 		void on_buttonOk_clicked();
 
 	private:
 		Ui::RenameExisting2 *ui;
-		QList<RenameExistingFile> m_details;
 		QList<QLabel*> m_previews;
 		QString m_folder;
 		RenameExistingTableModel *m_model;
@@ -2,12 +2,29 @@
 #include <QColor>
 #include <QPixmap>
 #include <QVariant>
+#include <utility>
 
 
-RenameExistingTableModel::RenameExistingTableModel(const QList<RenameExistingFile> &files, QString folder, QObject *parent)
-	: QAbstractTableModel(parent), m_files(files), m_folder(folder)
+RenameExistingTableModel::RenameExistingTableModel(QString folder, QObject *parent)
+	: QAbstractTableModel(parent), m_folder(std::move(folder))
 {}
 
+const QList<RenameExistingFile> &RenameExistingTableModel::files() const
+{
+	return m_files;
+}
+
+void RenameExistingTableModel::addFiles(const QList<RenameExistingFile> &files)
+{
+	if (files.isEmpty()) {
+		return;
+	}
+
+	beginInsertRows(QModelIndex(), m_files.count(), m_files.count() + files.count() - 1);
+	m_files.append(files);
+	endInsertRows();
+}
+
 int RenameExistingTableModel::rowCount(const QModelIndex &parent) const
 {
 	Q_UNUSED(parent);
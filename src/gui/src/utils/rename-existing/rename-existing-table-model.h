@@ -12,7 +12,9 @@ class RenameExistingTableModel : public QAbstractTableModel
 	Q_OBJECT
 
 	public:
-		explicit RenameExistingTableModel(const QList<RenameExistingFile> &files, QString folder, QObject *parent = nullptr);
+		explicit RenameExistingTableModel(QString folder, QObject *parent = nullptr);
+		const QList<RenameExistingFile> &files() const;
+		void addFiles(const QList<RenameExistingFile> &files);
 
 		// Data
 		int rowCount(const QModelIndex &parent = {}) const override;
@@ -21,7 +23,7 @@ class RenameExistingTableModel : public QAbstractTableModel
 		QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 	private:
-		const QList<RenameExistingFile> &m_files;
+		QList<RenameExistingFile> m_files;
 		const QString m_folder;
 };
 
@@ -0,0 +1,67 @@
+#include "utils/statistics/statistics-window.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QTimer>
+#include <ui_statistics-window.h>
+#include "metrics.h"
+#include "utils/memory-budget.h"
+
+#define REFRESH_INTERVAL 1000
+
+
+StatisticsWindow::StatisticsWindow(QWidget *parent)
+	: QDialog(parent), ui(new Ui::StatisticsWindow)
+{
+	setAttribute(Qt::WA_DeleteOnClose);
+	ui->setupUi(this);
+
+	connect(ui->buttonCopy, &QPushButton::clicked, this, &StatisticsWindow::copy);
+	connect(ui->buttonReset, &QPushButton::clicked, this, &StatisticsWindow::reset);
+	connect(ui->buttonClose, &QPushButton::clicked, this, &StatisticsWindow::close);
+
+	m_refreshTimer = new QTimer(this);
+	m_refreshTimer->setInterval(REFRESH_INTERVAL);
+	connect(m_refreshTimer, &QTimer::timeout, this, &StatisticsWindow::refresh);
+	m_refreshTimer->start();
+
+	refresh();
+}
+
+StatisticsWindow::~StatisticsWindow()
+{
+	delete ui;
+}
+
+void StatisticsWindow::refresh()
+{
+	MemoryBudget::getInstance().updateMetrics();
+	const QList<Metrics::Series> allSeries = Metrics::getInstance().series();
+
+	ui->treeMetrics->setSortingEnabled(false);
+	ui->treeMetrics->clear();
+	for (const Metrics::Series &series : allSeries) {
+		auto *item = new QTreeWidgetItem(ui->treeMetrics);
+		item->setText(0, series.name);
+		item->setText(1, series.labels);
+
+		// Histograms are summarized by their average
+		if (series.type == Metrics::Histogram) {
+			item->setText(2, QString::number(series.count));
+			item->setText(3, series.count > 0 ? tr("%1 ms on average").arg(series.sum / series.count, 0, 'f', 1) : QString());
+		} else {
+			item->setText(3, QString::number(series.value, 'f', 0));
+		}
+	}
+	ui->treeMetrics->setSortingEnabled(true);
+}
+
+void StatisticsWindow::copy()
+{
+	QApplication::clipboard()->setText(Metrics::getInstance().toPrometheus());
+}
+
+void StatisticsWindow::reset()
+{
+	Metrics::getInstance().clear();
+	refresh();
+}
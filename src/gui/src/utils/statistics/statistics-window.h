@@ -0,0 +1,36 @@
+#ifndef STATISTICS_WINDOW_H
+#define STATISTICS_WINDOW_H
+
+#include <QDialog>
+
+
+namespace Ui
+{
+	class StatisticsWindow;
+}
+
+
+class QTimer;
+
+/**
+ * Window displaying the performance metrics of the application, refreshed every second.
+ */
+class StatisticsWindow : public QDialog
+{
+	Q_OBJECT
+
+	public:
+		explicit StatisticsWindow(QWidget *parent = nullptr);
+		~StatisticsWindow() override;
+
+	private slots:
+		void refresh();
+		void copy();
+		void reset();
+
+	private:
+		Ui::StatisticsWindow *ui;
+		QTimer *m_refreshTimer;
+};
+
+#endif // STATISTICS_WINDOW_H
@@ -45,6 +45,15 @@ void TagLoader::resetOptions()
 	if (index >= 0) {
 		ui->comboSource->setCurrentIndex(index);
 	}
+	sourceChanged();
+}
+
+void TagLoader::sourceChanged()
+{
+	const int index = ui->comboSource->currentIndex();
+	const bool canUpdate = index >= 0 && index < m_options.count() && TagListLoader::canLoadIncrementally(m_sites.value(m_options[index]));
+	ui->checkIncremental->setEnabled(canUpdate);
+	ui->checkIncremental->setChecked(canUpdate);
 }
 
 void TagLoader::cancel()
@@ -72,6 +81,7 @@ void TagLoader::start()
 
 	// Start loader
 	m_loader = new TagListLoader(m_profile, site, MIN_TAG_COUNT, this);
+	m_loader->setIncremental(ui->checkIncremental->isChecked());
 	connect(m_loader, &TagListLoader::progress, ui->labelProgress, &QLabel::setText);
 	connect(m_loader, &TagListLoader::finished, this, &TagLoader::finishedLoading);
 	m_loader->start();
@@ -88,7 +98,7 @@ void TagLoader::finishedLoading()
 	if (!m_loader->error().isEmpty()) {
 		error(this, m_loader->error());
 	} else {
-		QMessageBox::information(this, tr("Finished"), tr("%n tag(s) loaded", "", m_loader->results().count()));
+		QMessageBox::information(this, tr("Finished"), tr("%n tag(s) loaded", "", m_loader->tagCount()));
 	}
 
 	// Clean-up
@@ -30,6 +30,7 @@ class TagLoader : public QDialog
 		void cancel();
 		void finishedLoading();
 		void resetOptions();
+		void sourceChanged();
 
 	private:
 		Ui::TagLoader *ui;
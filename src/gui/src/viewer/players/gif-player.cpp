@@ -1,12 +1,17 @@
 #include "gif-player.h"
 #include <QFileInfo>
 #include <QMovie>
+#include <QPixmap>
 #include <QStyle>
 #include "ui_gif-player.h"
+#include "utils/animation-decoder.h"
+
+#define FRAME_CACHE_SIZE 8
+#define DEFAULT_FRAME_DELAY 100
 
 
 GifPlayer::GifPlayer(bool showControls, Qt::Alignment alignment, QWidget *parent)
-	: Player(parent), ui(new Ui::GifPlayer)
+	: Player(parent), ui(new Ui::GifPlayer), m_decoder(new AnimationDecoder(FRAME_CACHE_SIZE, this))
 {
 	ui->setupUi(this);
 
@@ -17,6 +22,15 @@ GifPlayer::GifPlayer(bool showControls, Qt::Alignment alignment, QWidget *parent
 
 	ui->label->setAlignment(alignment);
 
+	// Frames are decoded in the background, so playback may have to wait for the next one
+	m_frameTimer.setSingleShot(true);
+	connect(&m_frameTimer, &QTimer::timeout, this, &GifPlayer::nextFrame);
+	connect(m_decoder, &AnimationDecoder::frameReady, this, [this]() {
+		if (m_waitingFrame) {
+			nextFrame();
+		}
+	});
+
 	if (showControls) {
 		ui->buttonPlayPause->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
 		connect(ui->buttonPlayPause, &QToolButton::clicked, this, &GifPlayer::playPause);
@@ -41,48 +55,82 @@ bool GifPlayer::supports(const QString &file)
 
 void GifPlayer::load(const QString &file)
 {
-	m_movie = new QMovie(file);
-	m_movie->start();
-
-	const QSize &movieSize = m_movie->currentPixmap().size();
-	const QSize &imageSize = ui->label->size();
-	if (imageSize.width() < movieSize.width() || imageSize.height() < movieSize.height()) {
-		m_movie->setScaledSize(movieSize.scaled(imageSize, Qt::KeepAspectRatio));
-	}
-
+	// Frames are decoded at the size they are displayed at, only a few at a time
+	m_loaded = m_decoder->open(file, ui->label->size());
+	m_paused = false;
+	m_waitingFrame = true;
+	m_frameDelay = 0;
+	ui->buttonPlayPause->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
+
+	m_noSeek = true;
 	ui->sliderPosition->setValue(0);
-	ui->sliderPosition->setMaximum(m_movie->frameCount());
-	connect(m_movie, &QMovie::frameChanged, this, &GifPlayer::positionChanged);
+	ui->sliderPosition->setMaximum(qMax(0, m_decoder->frameCount() - 1));
+	m_noSeek = false;
 	positionChanged(0);
 
-	ui->label->setMovie(m_movie);
+	if (m_decoder->hasFrame()) {
+		nextFrame();
+	}
 }
 
 void GifPlayer::unload()
 {
-	ui->label->setMovie(nullptr);
-	delete m_movie;
-	m_movie = nullptr;
+	m_frameTimer.stop();
+	m_decoder->close();
+	m_loaded = false;
+	m_waitingFrame = false;
+	ui->label->clear();
 }
 
 int GifPlayer::duration()
 {
-	return m_movie->nextFrameDelay() * m_movie->frameCount();
+	return (m_frameDelay > 0 ? m_frameDelay : DEFAULT_FRAME_DELAY) * m_decoder->frameCount();
 }
 
 
 void GifPlayer::playPause()
 {
-	if (m_movie == nullptr) {
+	if (!m_loaded) {
 		return;
 	}
 
-	if (m_movie->state() == QMovie::Running) {
-		m_movie->setPaused(true);
+	m_paused = !m_paused;
+	if (m_paused) {
+		m_frameTimer.stop();
 		ui->buttonPlayPause->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
 	} else {
-		m_movie->setPaused(false);
 		ui->buttonPlayPause->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
+
+		// Animations that don't loop are played again from their beginning
+		if (m_decoder->atEnd()) {
+			m_decoder->seek(0);
+		}
+		nextFrame();
+	}
+}
+
+void GifPlayer::nextFrame()
+{
+	if (!m_loaded) {
+		return;
+	}
+
+	const AnimationDecoder::Frame frame = m_decoder->takeFrame();
+	if (frame.image.isNull()) {
+		m_waitingFrame = !m_decoder->atEnd();
+		return;
+	}
+	m_waitingFrame = false;
+
+	ui->label->setPixmap(QPixmap::fromImage(frame.image));
+	positionChanged(frame.number);
+
+	const int delay = frame.delay > 0 ? frame.delay : DEFAULT_FRAME_DELAY;
+	if (m_frameDelay == 0) {
+		m_frameDelay = delay;
+	}
+	if (!m_paused) {
+		m_frameTimer.start(delay);
 	}
 }
 
@@ -94,26 +142,18 @@ void GifPlayer::positionChanged(int frame)
 		m_noSeek = false;
 	}
 
-	QString tStr = QString::number(frame) + " / " + QString::number(m_movie->frameCount());
+	QString tStr = QString::number(frame + 1) + " / " + QString::number(m_decoder->frameCount());
 	ui->labelDuration->setText(tStr);
 }
 
 void GifPlayer::seek(int frame)
 {
-	if (m_movie == nullptr || m_noSeek || true) {
+	if (!m_loaded || m_noSeek) {
 		return;
 	}
 
-	// Go back to first frame first if we want to seek back
-	if (m_movie->currentFrameNumber() > frame) {
-		m_movie->stop();
-		m_movie->start();
-	}
-
-	// We need to go through each frame for seeking
-	m_movie->setPaused(true);
-	while (m_movie->currentFrameNumber() < frame) {
-		m_movie->jumpToNextFrame();
-	}
-	m_movie->setPaused(false);
+	// The decoder goes through the previous frames itself, the player only has to wait for the new one
+	m_frameTimer.stop();
+	m_decoder->seek(frame);
+	m_waitingFrame = true;
 }
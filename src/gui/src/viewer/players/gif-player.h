@@ -4,6 +4,7 @@
 #include "player.h"
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 
 
 namespace Ui
@@ -12,6 +13,7 @@ namespace Ui
 }
 
 
+class AnimationDecoder;
 class QWidget;
 
 class GifPlayer : public Player
@@ -29,13 +31,19 @@ class GifPlayer : public Player
 
 	protected slots:
 		void playPause();
+		void nextFrame();
 		void positionChanged(int frame);
 		void seek(int frame);
 
 	private:
 		Ui::GifPlayer *ui;
 		QStringList m_supportedFormats;
-		QMovie *m_movie = nullptr;
+		AnimationDecoder *m_decoder;
+		QTimer m_frameTimer;
+		bool m_loaded = false;
+		bool m_paused = false;
+		bool m_waitingFrame = false;
+		int m_frameDelay = 0;
 		bool m_noSeek = false;
 };
 
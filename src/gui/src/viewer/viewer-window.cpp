@@ -8,6 +8,7 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QImage>
 #include <QMediaPlayer>
 #include <QMediaPlaylist>
 #include <QMenu>
@@ -18,6 +19,7 @@
 #include <QScreen>
 #include <QScrollBar>
 #include <QShortcut>
+#include <QtConcurrent>
 #include <QUrl>
 #include <QVideoWidget>
 #include <QWheelEvent>
@@ -35,6 +37,7 @@
 #include "models/pool.h"
 #include "models/profile.h"
 #include "models/site.h"
+#include "network/throughput-estimator.h"
 #include "settings/options-window.h"
 #include "tabs/search-tab.h"
 #include "tag-context-menu.h"
@@ -43,13 +46,17 @@
 #include "threads/image-loader.h"
 #include "threads/image-loader-queue.h"
 #include "ui/QAffiche.h"
+#include "utils/memory-budget.h"
 #include "viewer/details-window.h"
 #include "viewer/players/gif-player.h"
 #include "viewer/players/video-player.h"
 
+#define SCALED_IMAGES_CACHE_SIZE 4
+#define IMAGE_LOADER_THREADS 2
+
 
 ViewerWindow::ViewerWindow(QList<QSharedPointer<Image>> images, const QSharedPointer<Image> &image, Site *site, Profile *profile, MainWindow *parent, SearchTab *tab)
-	: QWidget(nullptr, Qt::Window), m_parent(parent), m_tab(tab), m_profile(profile), m_favorites(profile->getFavorites()), m_viewItLater(profile->getKeptForLater()), m_ignore(profile->getIgnored()), m_settings(profile->getSettings()), ui(new Ui::ViewerWindow), m_site(site), m_timeout(300), m_tooBig(false), m_loadedImage(false), m_loadedDetails(false), m_finished(false), m_size(0), m_isFullscreen(false), m_isSlideshowRunning(false), m_images(std::move(images)), m_displayImage(QPixmap()), m_labelImageScaled(false)
+	: QWidget(nullptr, Qt::Window), m_parent(parent), m_tab(tab), m_profile(profile), m_favorites(profile->getFavorites()), m_viewItLater(profile->getKeptForLater()), m_ignore(profile->getIgnored()), m_settings(profile->getSettings()), ui(new Ui::ViewerWindow), m_site(site), m_timeout(300), m_tooBig(false), m_loadedImage(false), m_loadedDetails(false), m_finished(false), m_isFullscreen(false), m_isSlideshowRunning(false), m_images(std::move(images)), m_displayImage(QPixmap()), m_labelImageScaled(false)
 {
 	setAttribute(Qt::WA_DeleteOnClose);
 	connect(parent, &MainWindow::destroyed, this, &QWidget::deleteLater);
@@ -154,20 +161,12 @@ ViewerWindow::ViewerWindow(QList<QSharedPointer<Image>> images, const QSharedPoi
 	ui->overlayLayout->addWidget(ui->progressBarDownload, 0, 0, Qt::AlignBottom);
 	ui->progressBarDownload->raise();
 
-	// Threads
-	m_imageLoaderThread.setObjectName("Image loader thread");
-	m_imageLoader = new ImageLoader();
-	m_imageLoader->moveToThread(&m_imageLoaderThread);
-	m_imageLoaderQueueThread.setObjectName("Image loader queue thread");
-	m_imageLoaderQueue = new ImageLoaderQueue(m_imageLoader);
-	m_imageLoaderQueue->moveToThread(&m_imageLoaderQueueThread);
-	connect(&m_imageLoaderThread, &QThread::finished, m_imageLoader, &QObject::deleteLater);
-	connect(&m_imageLoaderQueueThread, &QThread::finished, m_imageLoaderQueue, &QObject::deleteLater);
-	connect(this, &ViewerWindow::loadImage, m_imageLoaderQueue, &ImageLoaderQueue::load);
-	connect(this, &ViewerWindow::clearLoadQueue, m_imageLoaderQueue, &ImageLoaderQueue::clear);
-	connect(m_imageLoaderQueue, &ImageLoaderQueue::finished, this, &ViewerWindow::display);
-	m_imageLoaderQueueThread.start();
-	m_imageLoaderThread.start();
+	// Decoding
+	m_imageLoaderQueue = new ImageLoaderQueue(IMAGE_LOADER_THREADS, true, this);
+	connect(m_imageLoaderQueue, &ImageLoaderQueue::loaded, this, &ViewerWindow::imageFileLoaded);
+	connect(m_imageLoaderQueue, &ImageLoaderQueue::failed, this, &ViewerWindow::imageFileFailed);
+	m_scaledImages.setMaxCost(SCALED_IMAGES_CACHE_SIZE);
+	m_preloadedImages.setMaxCost(qMax(1, m_settings->value("preload", 0).toInt() * 2));
 
 	// Background color
 	QString bg = m_settings->value("imageBackgroundColor", "").toString();
@@ -238,6 +237,10 @@ void ViewerWindow::go()
  */
 ViewerWindow::~ViewerWindow()
 {
+	if (m_memoryId != 0) {
+		MemoryBudget::getInstance().remove(m_memoryId);
+	}
+
 	m_labelTagsTop->deleteLater();
 	m_labelTagsLeft->deleteLater();
 	m_detailsWindow->deleteLater();
@@ -245,12 +248,6 @@ ViewerWindow::~ViewerWindow()
 	m_gifPlayer->deleteLater();
 	m_videoPlayer->deleteLater();
 
-	// Quit threads
-	m_imageLoaderQueueThread.quit();
-	m_imageLoaderQueueThread.wait(1000);
-	m_imageLoaderThread.quit();
-	m_imageLoaderThread.wait(1000);
-
 	delete ui;
 }
 
@@ -475,7 +472,12 @@ void ViewerWindow::copyImageFileToClipboard()
 }
 void ViewerWindow::copyImageDataToClipboard()
 {
-	QApplication::clipboard()->setPixmap(m_displayImage);
+	// The displayed image might have been decoded at a lower resolution
+	if (!m_imagePath.isEmpty() && m_isAnimated.isEmpty() && !m_image->isVideo()) {
+		QApplication::clipboard()->setImage(QImage(m_imagePath));
+	} else {
+		QApplication::clipboard()->setPixmap(m_displayImage);
+	}
 }
 void ViewerWindow::copyImageLinkToClipboard()
 {
@@ -512,7 +514,6 @@ void ViewerWindow::openPoolId(Page *p)
 	m_loadedDetails = false;
 	m_loadedImage = false;
 	m_finished = false;
-	m_size = 0;
 	m_labelImage->hide();
 	ui->verticalLayout->removeWidget(m_labelImage);
 
@@ -584,9 +585,83 @@ void ViewerWindow::setfavorite()
 	m_profile->emitFavorite();
 }
 
+/**
+ * On slow connections, show the sample first instead of waiting for a big full image that should take too long.
+ */
+Image::Size ViewerWindow::displaySize(const QSharedPointer<Image> &img) const
+{
+	const Image::Size size = img->preferredDisplaySize();
+	if (size != Image::Size::Full || !m_settings->value("Viewer/adaptiveSize", true).toBool()) {
+		return size;
+	}
+
+	const QUrl sampleUrl = img->url(Image::Size::Sample);
+	if (sampleUrl.isEmpty() || sampleUrl == img->url(Image::Size::Full) || img->isVideo() || !img->isAnimated().isEmpty()) {
+		return size;
+	}
+
+	const qint64 estimated = ThroughputEstimator::getInstance().estimatedMs(img->fileSize());
+	const qint64 budget = m_settings->value("Viewer/adaptiveSizeBudget", 5).toInt() * 1000;
+	return estimated >= 0 && estimated <= budget ? Image::Size::Full : Image::Size::Sample;
+}
+
+/**
+ * Download the full image in the background once its sample is shown, unless it is expected to take too long.
+ */
+void ViewerWindow::upgradeToFull()
+{
+	abortUpgrade();
+
+	const qint64 estimated = ThroughputEstimator::getInstance().estimatedMs(m_image->fileSize());
+	const qint64 budget = m_settings->value("Viewer/adaptiveSizeBudget", 5).toInt() * 1000;
+	if (estimated > budget) {
+		log(QStringLiteral("Keeping the sample, as the full image should take %1 ms to load").arg(estimated), Logger::Debug);
+		return;
+	}
+
+	log(QStringLiteral("Upgrading to the full image from `%1`").arg(m_image->url(Image::Size::Full).toString()));
+
+	const Filename fn = Filename(QUuid::createUuid().toString().mid(1, 36) + ".%ext%");
+	const QStringList paths = fn.path(*m_image.data(), m_profile, m_profile->tempPath(), 1, Filename::ExpandConditionals | Filename::Path);
+	m_upgradeDownloader = new ImageDownloader(m_profile, m_image, paths, 1, false, false, this, true, false, Image::Size::Full, false, true);
+	connect(m_upgradeDownloader, &ImageDownloader::saved, this, &ViewerWindow::upgradeFinished);
+	m_upgradeDownloader->save();
+}
+
+void ViewerWindow::abortUpgrade()
+{
+	if (m_upgradeDownloader != nullptr) {
+		m_upgradeDownloader->abort();
+		m_upgradeDownloader->deleteLater();
+		m_upgradeDownloader = nullptr;
+	}
+}
+
+void ViewerWindow::upgradeFinished(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result)
+{
+	if (m_upgradeDownloader != nullptr) {
+		m_upgradeDownloader->deleteLater();
+		m_upgradeDownloader = nullptr;
+	}
+
+	// The sample stays displayed if anything went wrong
+	if (img != m_image || result.isEmpty() || !QFile::exists(result.first().path)) {
+		return;
+	}
+
+	const ImageSaveResult &res = result.first();
+	log(QStringLiteral("Full image received from `%1`").arg(img->url(res.size).toString()));
+
+	m_imagePath = res.path;
+	img->setTemporaryPath(m_imagePath, res.size);
+
+	updateWindowTitle();
+	draw();
+}
+
 void ViewerWindow::load(bool force)
 {
-	const Image::Size size = m_image->preferredDisplaySize();
+	const Image::Size size = displaySize(m_image);
 	log(QStringLiteral("Loading image from `%1`").arg(m_image->url(size).toString()));
 
 	m_source.clear();
@@ -624,21 +699,9 @@ void ViewerWindow::downloadProgress(QSharedPointer<Image> img, qint64 bytesRecei
 	const bool isAnimated = m_image->isVideo() || !m_isAnimated.isEmpty();
 	if (!isAnimated && (m_imageTime.elapsed() > TIME || (bytesTotal > 0 && static_cast<double>(bytesReceived) / bytesTotal > PERCENT))) {
 		m_imageTime.restart();
-		// FIXME: should read the file contents now that the image is not loaded in RAM anymore
-		// emit loadImage(m_image->data());
-	}
-}
-void ViewerWindow::display(const QPixmap &pix, int size)
-{
-	if (!pix.size().isEmpty() && size >= m_size) {
-		m_size = size;
-		m_displayImage = pix;
-		update(!m_finished);
-
-		updateWindowTitle();
+		// FIXME: should decode the partial file now that the image is not loaded in RAM anymore
 	}
 }
-
 void ViewerWindow::replyFinishedDetails()
 {
 	disconnect(m_image.data(), &Image::finishedLoadingTags, this, &ViewerWindow::replyFinishedDetails);
@@ -723,7 +786,7 @@ void ViewerWindow::replyFinishedDetails()
 }
 void ViewerWindow::colore()
 {
-	const QStringList t = TagStylist(m_profile).stylished(m_image->tags(), m_settings->value("Viewer/showTagCount", false).toBool(), false, m_settings->value("Viewer/tagOrder", "type").toString());
+	const QStringList t = m_profile->tagStylist()->stylished(m_image->tags(), m_settings->value("Viewer/showTagCount", false).toBool(), false, m_settings->value("Viewer/tagOrder", "type").toString());
 	const QString tags = t.join(' ');
 
 	if (ui->widgetLeft->isHidden()) {
@@ -810,6 +873,11 @@ void ViewerWindow::replyFinishedImage(const QSharedPointer<Image> &img, const QL
 		updateWindowTitle();
 		pendingUpdate();
 		draw();
+
+		// The sample may only have been shown first because the connection is slow
+		if (res.size == Image::Size::Sample && img->preferredDisplaySize() == Image::Size::Full && m_settings->value("Viewer/adaptiveSize", true).toBool()) {
+			upgradeToFull();
+		}
 	}
 }
 
@@ -885,13 +953,120 @@ void ViewerWindow::draw()
 		m_stackedWidget->setCurrentWidget(m_videoPlayer);
 		m_videoPlayer->load(m_imagePath);
 	}
-	// Images
+	// Images (decoded in the background, the thumbnail staying visible in the meantime)
 	else {
-		m_displayImage.load(m_imagePath);
+		const PreloadedImage *preloaded = m_preloadedImages.object(m_image.data());
+		if (preloaded != nullptr && preloaded->path == m_imagePath) {
+			m_fullImageSize = preloaded->fullSize;
+			m_displayImage = preloaded->pixmap;
+			m_displayImagePreview = false;
+			m_scaledImages.clear();
+
+			updateWindowTitle();
+			update(false, true);
+		} else {
+			m_fullImageSize = QSize();
+			decodeImage();
+		}
+	}
+}
+
+/**
+ * Decode preloaded images as soon as they are downloaded, so that they can be displayed directly when navigating.
+ */
+void ViewerWindow::preloadFinished(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result)
+{
+	// The current image is handled by replyFinishedImage(), and only static images are drawn from a pixmap
+	if (img == m_image || img->isVideo() || !img->isAnimated().isEmpty() || result.isEmpty()) {
+		return;
+	}
+
+	const QString path = result.first().path;
+	if (!QFile::exists(path)) {
+		return;
+	}
+
+	const QSize maxSize = m_labelImage->size();
+	auto *watcher = new QFutureWatcher<QPair<QImage, QSize>>(this);
+	connect(watcher, &QFutureWatcher<QPair<QImage, QSize>>::finished, this, [this, watcher, img, path]() {
+		const QPair<QImage, QSize> decoded = watcher->result();
+		watcher->deleteLater();
+
+		if (!decoded.first.isNull() && m_images.contains(img)) {
+			m_preloadedImages.insert(img.data(), new PreloadedImage { path, QPixmap::fromImage(decoded.first), decoded.second });
+			updateMemoryUsage();
+		}
+	});
+	watcher->setFuture(QtConcurrent::run([path, maxSize]() {
+		QSize fullSize;
+		const QImage image = ImageLoader::decodeFile(path, maxSize, &fullSize);
+		return qMakePair(image, fullSize);
+	}));
+}
+
+/**
+ * Report the pixmaps kept by this window to the memory budget, which can drop them all when they were not used for a
+ * while, as they can be decoded again from the files.
+ */
+void ViewerWindow::updateMemoryUsage()
+{
+	const auto pixmapBytes = [](const QPixmap &pixmap) {
+		return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+	};
+
+	qint64 bytes = 0;
+	for (Image *key : m_preloadedImages.keys()) {
+		bytes += pixmapBytes(m_preloadedImages.object(key)->pixmap);
+	}
+	for (const QString &key : m_scaledImages.keys()) {
+		bytes += pixmapBytes(*m_scaledImages.object(key));
+	}
 
+	MemoryBudget &budget = MemoryBudget::getInstance();
+	if (m_memoryId != 0) {
+		budget.resize(m_memoryId, bytes);
+	} else if (bytes > 0) {
+		const quint64 id = budget.add(QStringLiteral("viewer"), bytes, [this]() {
+			m_preloadedImages.clear();
+			m_scaledImages.clear();
+			m_memoryId = 0;
+		});
+		m_memoryId = m_preloadedImages.isEmpty() && m_scaledImages.isEmpty() ? 0 : id;
+	}
+}
+
+/**
+ * Decode the image file in the image loader threads, at the size of the image label.
+ */
+void ViewerWindow::decodeImage()
+{
+	m_decodeId = m_imageLoaderQueue->load(m_imagePath, m_labelImage->size());
+}
+
+void ViewerWindow::imageFileLoaded(int id, const QImage &image, QSize fullSize, bool preview)
+{
+	if (id != m_decodeId) {
+		return;
+	}
+
+	m_fullImageSize = fullSize;
+	m_displayImage = QPixmap::fromImage(image);
+	m_displayImagePreview = preview;
+	m_scaledImages.clear();
+
+	if (!preview) {
 		updateWindowTitle();
-		update();
 	}
+	update(preview, true);
+}
+
+void ViewerWindow::imageFileFailed(int id)
+{
+	if (id != m_decodeId) {
+		return;
+	}
+
+	log(QStringLiteral("Could not decode the image file `%1`").arg(m_imagePath), Logger::Error);
 }
 
 
@@ -907,12 +1082,31 @@ void ViewerWindow::update(bool onlySize, bool force)
 		return;
 	}
 
+	// If the image was decoded for a smaller window, decode it again at the new size
+	const QSize labelSize = m_labelImage->size();
+	const bool downscaled = m_fullImageSize.isValid() && m_displayImage.size() != m_fullImageSize;
+	if (!onlySize && !m_displayImagePreview && downscaled && !m_imagePath.isEmpty() && m_displayImage.size().scaled(labelSize, Qt::KeepAspectRatio).width() > m_displayImage.width()) {
+		decodeImage();
+	}
+
 	const bool needScaling = m_settings->value("Viewer/scaleUp", false).toBool()
-		|| m_displayImage.width() > m_labelImage->width()
-		|| m_displayImage.height() > m_labelImage->height();
+		|| m_displayImagePreview
+		|| m_displayImage.width() > labelSize.width()
+		|| m_displayImage.height() > labelSize.height();
 	if (needScaling && (onlySize || m_loadedImage || force)) {
-		const Qt::TransformationMode mode = onlySize ? Qt::FastTransformation : Qt::SmoothTransformation;
-		m_labelImage->setImage(m_displayImage.scaled(m_labelImage->width(), m_labelImage->height(), Qt::KeepAspectRatio, mode));
+		if (onlySize) {
+			m_labelImage->setImage(m_displayImage.scaled(labelSize, Qt::KeepAspectRatio, Qt::FastTransformation));
+		} else {
+			// Keep the smoothly scaled images, for example when going back and forth from fullscreen
+			const QString key = QStringLiteral("%1-%2x%3").arg(m_displayImage.cacheKey()).arg(labelSize.width()).arg(labelSize.height());
+			QPixmap *scaled = m_scaledImages.object(key);
+			if (scaled == nullptr) {
+				scaled = new QPixmap(m_displayImage.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+				m_scaledImages.insert(key, scaled);
+			}
+			m_labelImage->setImage(*scaled);
+			updateMemoryUsage();
+		}
 		m_labelImageScaled = true;
 	} else if (m_loadedImage || force || (m_labelImageScaled && !needScaling)) {
 		m_labelImage->setImage(m_displayImage);
@@ -1061,6 +1255,7 @@ void ViewerWindow::saveImageNowSaved(QSharedPointer<Image> img, const QList<Imag
 				break;
 
 			case Image::SaveResult::AlreadyExistsDeletedMd5:
+			case Image::SaveResult::AlreadyExistsSimilar:
 				setButtonState(fav, SaveButtonState::ExistsMd5);
 				break;
 
@@ -1214,6 +1409,7 @@ void ViewerWindow::closeEvent(QCloseEvent *e)
 
 	m_image->abortTags();
 
+	abortUpgrade();
 	for (auto it = m_imageDownloaders.constBegin(); it != m_imageDownloaders.constEnd(); ++it) {
 		it.value()->abort();
 		it.value()->deleteLater();
@@ -1278,15 +1474,19 @@ void ViewerWindow::reuse(const QList<QSharedPointer<Image>> &images, const QShar
 
 void ViewerWindow::load(const QSharedPointer<Image> &image)
 {
-	emit clearLoadQueue();
+	abortUpgrade();
+	m_imageLoaderQueue->clear();
+	m_decodeId = 0;
 
 	m_displayImage = QPixmap();
+	m_displayImagePreview = false;
+	m_fullImageSize = QSize();
+	m_scaledImages.clear();
 	m_loadedImage = false;
 	m_source = "";
 	m_imagePath = "";
 	m_image = image;
 	m_isAnimated = image->isAnimated();
-	m_size = 0;
 	ui->labelLoadingError->hide();
 
 	// Show the thumbnail if the image was not already preloaded
@@ -1320,8 +1520,9 @@ void ViewerWindow::load(const QSharedPointer<Image> &image)
 
 		const Filename fn = Filename(QUuid::createUuid().toString().mid(1, 36) + ".%ext%");
 		const QStringList paths = fn.path(*img.data(), m_profile, m_profile->tempPath(), 1, Filename::ExpandConditionals | Filename::Path);
-		const Image::Size size = img->preferredDisplaySize();
+		const Image::Size size = displaySize(img);
 		auto dwl = new ImageDownloader(m_profile, img, paths, 1, false, false, this, true, false, size, false, true);
+		connect(dwl, &ImageDownloader::saved, this, &ViewerWindow::preloadFinished);
 		m_imageDownloaders.insert(img, dwl);
 		dwl->save();
 	}
@@ -1372,7 +1573,7 @@ int ViewerWindow::firstNonBlacklisted(int direction)
 	index = (index + m_images.count() + direction) % m_images.count();
 
 	// Skip blacklisted images
-	while (!m_profile->getBlacklist().match(m_images[index]->tokens(m_profile)).isEmpty() && index != first) {
+	while (m_profile->getBlacklist().matches(m_images[index]->tokens(m_profile)) && index != first) {
 		index = (index + m_images.count() + direction) % m_images.count();
 	}
 
@@ -1,6 +1,7 @@
 #ifndef VIEWER_WINDOW_H
 #define VIEWER_WINDOW_H
 
+#include <QCache>
 #include <QElapsedTimer>
 #include <QPointer>
 #include <QPushButton>
@@ -29,7 +30,6 @@ class Profile;
 class MainWindow;
 class DetailsWindow;
 class ImageDownloader;
-class ImageLoader;
 class ImageLoaderQueue;
 class SearchTab;
 class VideoPlayer;
@@ -57,7 +57,10 @@ class ViewerWindow : public QWidget
 		void update(bool onlySize = false, bool force = false);
 		void replyFinishedDetails();
 		void replyFinishedImage(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result);
-		void display(const QPixmap &, int);
+		void imageFileLoaded(int id, const QImage &image, QSize fullSize, bool preview);
+		void imageFileFailed(int id);
+		void preloadFinished(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result);
+		void upgradeFinished(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result);
 		void saveNQuit(bool fav = false);
 		void saveImage(bool fav = false);
 		void saveImageNow();
@@ -108,6 +111,11 @@ class ViewerWindow : public QWidget
 		void mouseReleaseEvent(QMouseEvent *) override;
 		void wheelEvent(QWheelEvent *) override;
 		void draw();
+		void decodeImage();
+		Image::Size displaySize(const QSharedPointer<Image> &img) const;
+		void upgradeToFull();
+		void abortUpgrade();
+		void updateMemoryUsage();
 
 	private:
 		void configureButtons();
@@ -119,8 +127,6 @@ class ViewerWindow : public QWidget
 		void linkClicked(const QString &);
 		void poolClicked(int, const QString &);
 		void linkMiddleClicked(const QString &);
-		void loadImage(const QByteArray &);
-		void clearLoadQueue();
 
 	private:
 		MainWindow *m_parent;
@@ -143,7 +149,6 @@ class ViewerWindow : public QWidget
 		QElapsedTimer m_imageTime;
 		QString m_link;
 		bool m_finished;
-		int m_size;
 		QString m_source;
 		QString m_imagePath;
 		QElapsedTimer m_lastWheelEvent;
@@ -160,11 +165,26 @@ class ViewerWindow : public QWidget
 		SaveButtonState m_saveButtonState, m_saveButtonStateFav;
 
 		QMap<QSharedPointer<Image>, ImageDownloader*> m_imageDownloaders;
+		ImageDownloader *m_upgradeDownloader = nullptr;
 
 		// Display
 		QString m_isAnimated;
 		QPixmap m_displayImage;
 		bool m_labelImageScaled;
+		QSize m_fullImageSize;
+		bool m_displayImagePreview = false;
+		int m_decodeId = 0;
+		QCache<QString, QPixmap> m_scaledImages;
+
+		// Preloaded images, already decoded at the window size
+		struct PreloadedImage
+		{
+			QString path;
+			QPixmap pixmap;
+			QSize fullSize;
+		};
+		QCache<Image*, PreloadedImage> m_preloadedImages;
+		quint64 m_memoryId = 0;
 		GifPlayer *m_gifPlayer = nullptr;
 		VideoPlayer *m_videoPlayer = nullptr;
 
@@ -172,10 +192,7 @@ class ViewerWindow : public QWidget
 		std::unordered_map<QString, ButtonInstance> m_buttons;
 		std::vector<QPushButton*> m_drawerButtons;
 
-		// Threads
-		QThread m_imageLoaderThread;
-		QThread m_imageLoaderQueueThread;
-		ImageLoader *m_imageLoader;
+		// Decoding
 		ImageLoaderQueue *m_imageLoaderQueue;
 };
 
@@ -1,9 +1,30 @@
 #include "analytics.h"
+#include <QDataStream>
+#include <QFile>
+#include "functions.h"
+#include "logger.h"
+#include "network/network-manager.h"
+
+#define ANALYTICS_QUEUE_FILE "analytics.dat"
+#define ANALYTICS_CHECK_INTERVAL (30 * 1000)
+#define ANALYTICS_IDLE_DELAY (60 * 1000)
 
 class QString;
 class QVariant;
 
 
+Analytics::Analytics()
+{
+	// Messages are only sent when the network is idle, instead of every 30 seconds
+	m_googleAnalytics.setAutoSend(false);
+
+	m_idleTimer.setInterval(ANALYTICS_CHECK_INTERVAL);
+	QObject::connect(&m_idleTimer, &QTimer::timeout, [this]() { idleCheck(); });
+
+	load();
+}
+
+
 void Analytics::setTrackingID(const QString& trackingId)
 {
 	m_googleAnalytics.setTrackingID(trackingId);
@@ -14,10 +35,73 @@ void Analytics::setEnabled(bool enabled)
 	m_enabled = enabled;
 	if (!enabled) {
 		m_googleAnalytics.stopSending();
+		m_idleTimer.stop();
+		QFile::remove(savePath(ANALYTICS_QUEUE_FILE));
+		m_savedMessages = 0;
+	} else {
+		m_idleTimer.start();
+	}
+}
+
+
+/**
+ * Load the messages that could not be sent during the previous runs.
+ */
+void Analytics::load()
+{
+	QFile file(savePath(ANALYTICS_QUEUE_FILE));
+	if (!file.open(QFile::ReadOnly)) {
+		return;
 	}
+
+	QDataStream stream(&file);
+	stream >> m_googleAnalytics;
+	m_savedMessages = m_googleAnalytics.pendingMessages();
 }
 
+void Analytics::save()
+{
+	if (!m_enabled) {
+		return;
+	}
 
+	const int pending = m_googleAnalytics.pendingMessages();
+	if (pending == 0) {
+		QFile::remove(savePath(ANALYTICS_QUEUE_FILE));
+		m_savedMessages = 0;
+		return;
+	}
+
+	QFile file(savePath(ANALYTICS_QUEUE_FILE));
+	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not save usage data queue to `%1`").arg(file.fileName()), Logger::Warning);
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream << m_googleAnalytics;
+	m_savedMessages = pending;
+}
+
+/**
+ * Only send the queued messages once no request was running for a while, and save them otherwise.
+ */
+void Analytics::idleCheck()
+{
+	const int pending = m_googleAnalytics.pendingMessages();
+	if (pending != m_savedMessages) {
+		save();
+	}
+
+	if (pending > 0 && !m_googleAnalytics.isSending() && NetworkManager::activeRequests() == 0 && NetworkManager::msSinceLastActivity() >= ANALYTICS_IDLE_DELAY) {
+		m_googleAnalytics.startSending();
+	}
+}
+
+
+/**
+ * Immediately send all queued messages, no matter the network activity.
+ */
 void Analytics::startSending()
 {
 	if (!m_enabled) {
@@ -43,6 +127,7 @@ void Analytics::endSession()
 	}
 
 	m_googleAnalytics.endSession();
+	save();
 }
 
 void Analytics::sendScreenView(const QString& screenName, const QVariantMap& customValues)
@@ -52,7 +137,6 @@ void Analytics::sendScreenView(const QString& screenName, const QVariantMap& cus
 	}
 
 	m_googleAnalytics.sendScreenView(screenName, customValues);
-	m_googleAnalytics.startSending();
 }
 
 void Analytics::sendEvent(const QString& category, const QString& action, const QString &label, const QVariant &value, const QVariantMap &customValues)
@@ -62,5 +146,4 @@ void Analytics::sendEvent(const QString& category, const QString& action, const
 	}
 
 	m_googleAnalytics.sendEvent(category, action, label, value, customValues);
-	m_googleAnalytics.startSending();
 }
@@ -1,6 +1,7 @@
 #ifndef ANALYTICS_H
 #define ANALYTICS_H
 
+#include <QTimer>
 #include <QVariantMap>
 #include "vendor/ganalytics.h"
 
@@ -8,6 +9,10 @@
 class QString;
 class QVariant;
 
+/**
+ * Usage data is queued in memory, saved to disk periodically so that it survives restarts, and only sent in batched
+ * requests once no network request was started for a while, so that it never competes with downloads.
+ */
 class Analytics
 {
 	public:
@@ -26,16 +31,23 @@ class Analytics
 
 		// API
 		void startSending();
+		void save();
 		void startSession();
 		void endSession();
 		void sendScreenView(const QString& screenName, const QVariantMap &customValues = {});
 		void sendEvent(const QString& category, const QString &action, const QString &label = {}, const QVariant &value = {}, const QVariantMap &customValues = {});
 
+	protected:
+		void load();
+		void idleCheck();
+
 	private:
-		Analytics() = default;
+		Analytics();
 
 		bool m_enabled = false;
 		GAnalytics m_googleAnalytics;
+		QTimer m_idleTimer;
+		int m_savedMessages = 0;
 };
 
 #endif // ANALYTICS_H
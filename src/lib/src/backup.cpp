@@ -1,19 +1,23 @@
 #include "backup.h"
 #include <QFile>
-#include <QHash>
 #include "functions.h"
+#include "logger.h"
 #include "models/favorite.h"
 #include "models/profile.h"
-#include "utils/zip.h"
+#include "utils/zip-writer.h"
 
 
-bool saveBackup(Profile *profile, const QString &filePath)
+QList<QPair<QString, QString>> listBackupFiles(Profile *profile)
 {
-	// Common files
+	QList<QPair<QString, QString>> ret;
+
+	// Common files, some of which might not exist if the feature was never used
 	static const QStringList backupFiles { "settings.ini", "favorites.json", "viewitlater.txt", "ignore.txt", "wordsc.txt", "blacklist.txt", "monitors.json", "restore.igl" };
-	QHash<QString, QString> zipFiles;
 	for (const QString &file : backupFiles) {
-		zipFiles.insert(profile->getPath() + "/" + file, file);
+		const QString path = profile->getPath() + "/" + file;
+		if (QFile::exists(path)) {
+			ret.append(qMakePair(path, file));
+		}
 	}
 
 	// Favorite thumbnails
@@ -21,10 +25,39 @@ bool saveBackup(Profile *profile, const QString &filePath)
 		const QString relPath = "thumbs/" + fav.getName(true) + ".png";
 		const QString favPath = savePath(relPath);
 		if (QFile::exists(favPath)) {
-			zipFiles.insert(favPath, relPath);
+			ret.append(qMakePair(favPath, relPath));
 		}
 	}
 
-	// Create backup ZIP
-	return createZip(filePath, zipFiles);
+	return ret;
+}
+
+bool writeBackup(const QList<QPair<QString, QString>> &files, const QString &filePath, const std::function<void(int current, int total)> &progress)
+{
+	ZipWriter zip(filePath);
+	if (!zip.open()) {
+		return false;
+	}
+
+	// Files are streamed to the archive, and thumbnails are stored as-is since PNG files are already compressed
+	for (int i = 0; i < files.count(); ++i) {
+		const auto &file = files[i];
+		if (!zip.addFile(file.second, file.first, ZipWriter::shouldCompress(file.second))) {
+			log(QStringLiteral("Could not add `%1` to the backup").arg(file.first), Logger::Error);
+			zip.close();
+			QFile::remove(filePath);
+			return false;
+		}
+
+		if (progress) {
+			progress(i + 1, files.count());
+		}
+	}
+
+	return zip.close();
+}
+
+bool saveBackup(Profile *profile, const QString &filePath)
+{
+	return writeBackup(listBackupFiles(profile), filePath);
 }
@@ -1,11 +1,25 @@
 #ifndef BACKUP_H
 #define BACKUP_H
 
+#include <QList>
+#include <QPair>
 #include <QString>
+#include <functional>
 
 
 class Profile;
 
+/**
+ * The files to back up, as pairs of absolute path and path in the backup. Only existing files are returned.
+ * Must be called from the profile's thread, unlike writeBackup() which only reads files and can run in a worker thread.
+ */
+QList<QPair<QString, QString>> listBackupFiles(Profile *profile);
+
+/**
+ * Write the given files to a ZIP archive, calling the progress callback after each file.
+ */
+bool writeBackup(const QList<QPair<QString, QString>> &files, const QString &filePath, const std::function<void(int current, int total)> &progress = nullptr);
+
 bool saveBackup(Profile *profile, const QString &filePath);
 
 #endif // BACKUP_H
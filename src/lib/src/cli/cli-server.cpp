@@ -0,0 +1,196 @@
+#include "cli/cli-server.h"
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSettings>
+#include <QStringList>
+#include <QTimer>
+#include "cli/commands/download-images-cli-command.h"
+#include "cli/commands/get-images-cli-command.h"
+#include "cli/commands/get-page-count-cli-command.h"
+#include "cli/commands/get-page-tags-cli-command.h"
+#include "downloader/printers/json-printer.h"
+#include "logger.h"
+#include "metrics.h"
+#include "models/filtering/blacklist.h"
+#include "models/profile.h"
+
+
+CliServer::CliServer(Profile *profile, QObject *parent)
+	: QObject(parent), m_profile(profile)
+{
+	m_server = new QLocalServer(this);
+	connect(m_server, &QLocalServer::newConnection, this, &CliServer::newConnection);
+}
+
+bool CliServer::listen(const QString &name)
+{
+	// Remove leftovers from a previous server that crashed
+	QLocalServer::removeServer(name);
+
+	if (!m_server->listen(name)) {
+		log(QStringLiteral("Could not start the server on `%1`: %2").arg(name, m_server->errorString()), Logger::Error);
+		return false;
+	}
+
+	log(QStringLiteral("Server listening on `%1`").arg(m_server->fullServerName()), Logger::Info);
+	return true;
+}
+
+QString CliServer::fullServerName() const
+{
+	return m_server->fullServerName();
+}
+
+
+void CliServer::newConnection()
+{
+	while (m_server->hasPendingConnections()) {
+		QLocalSocket *socket = m_server->nextPendingConnection();
+		connect(socket, &QLocalSocket::readyRead, this, &CliServer::readyRead);
+		connect(socket, &QLocalSocket::disconnected, this, &CliServer::disconnected);
+	}
+}
+
+void CliServer::readyRead()
+{
+	auto *socket = qobject_cast<QLocalSocket*>(sender());
+
+	while (socket->canReadLine()) {
+		const QByteArray line = socket->readLine().trimmed();
+		if (line.isEmpty()) {
+			continue;
+		}
+
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+			reply(socket, {}, QJsonObject { { "error", "Invalid job: " + error.errorString() } });
+			continue;
+		}
+
+		m_jobs.enqueue(Job { socket, doc.object() });
+	}
+
+	runNext();
+}
+
+void CliServer::disconnected()
+{
+	auto *socket = qobject_cast<QLocalSocket*>(sender());
+
+	// The socket of the running job is deleted once the job is finished
+	if (socket != m_currentSocket) {
+		socket->deleteLater();
+	}
+}
+
+void CliServer::reply(QLocalSocket *socket, const QJsonObject &params, QJsonObject response)
+{
+	if (socket == nullptr || socket->state() != QLocalSocket::ConnectedState) {
+		return;
+	}
+
+	// Allow clients to match responses with their jobs
+	if (params.contains("id")) {
+		response.insert("id", params.value("id"));
+	}
+
+	socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + "\n");
+	socket->flush();
+}
+
+
+void CliServer::runNext()
+{
+	if (m_currentSocket != nullptr || m_jobs.isEmpty()) {
+		return;
+	}
+
+	const Job job = m_jobs.dequeue();
+	if (job.socket.isNull() || job.socket->state() != QLocalSocket::ConnectedState) {
+		QTimer::singleShot(0, this, SLOT(runNext()));
+		return;
+	}
+
+	// Metrics are returned right away in the Prometheus text format
+	if (job.params.value("command").toString() == QLatin1String("metrics")) {
+		reply(job.socket, job.params, QJsonObject { { "metrics", Metrics::getInstance().toPrometheus() }, { "finished", true }, { "code", 0 } });
+		QTimer::singleShot(0, this, SLOT(runNext()));
+		return;
+	}
+
+	if (job.params.value("command").toString() == QLatin1String("quit")) {
+		reply(job.socket, job.params, QJsonObject { { "finished", true }, { "code", 0 } });
+		emit quit();
+		return;
+	}
+
+	QString error;
+	auto *printer = new JsonPrinter(m_profile, true, job.socket);
+	CliCommand *cmd = createCommand(job.params, printer, error);
+	if (cmd == nullptr || !cmd->validate()) {
+		reply(job.socket, job.params, QJsonObject { { "error", error.isEmpty() ? QStringLiteral("Invalid parameters") : error } });
+		delete printer;
+		if (cmd != nullptr) {
+			cmd->deleteLater();
+		}
+		QTimer::singleShot(0, this, SLOT(runNext()));
+		return;
+	}
+
+	m_currentSocket = job.socket;
+	const QJsonObject params = job.params;
+	connect(cmd, &CliCommand::finished, this, [this, cmd, printer, params](int code) {
+		reply(m_currentSocket, params, QJsonObject { { "finished", true }, { "code", code } });
+
+		cmd->deleteLater();
+		delete printer;
+		if (m_currentSocket->state() != QLocalSocket::ConnectedState) {
+			m_currentSocket->deleteLater();
+		}
+		m_currentSocket = nullptr;
+
+		QTimer::singleShot(0, this, SLOT(runNext()));
+	});
+	QTimer::singleShot(0, cmd, [cmd]() { cmd->run(); });
+}
+
+CliCommand *CliServer::createCommand(const QJsonObject &params, Printer *printer, QString &error)
+{
+	QSettings *settings = m_profile->getSettings();
+
+	const QString command = params.value("command").toString();
+	const QStringList tags = params.value("tags").toString().split(" ", Qt::SkipEmptyParts);
+	const QStringList postFiltering = params.value("postfilter").toString().split(" ", Qt::SkipEmptyParts);
+	const QList<Site*> sites = m_profile->getFilteredSites(params.value("sources").toString().split(" ", Qt::SkipEmptyParts));
+	const int page = params.value("page").toInt(1);
+	const int perPage = params.value("perpage").toInt(20);
+	const int max = params.value("max").toInt(0);
+	const QString filename = params.value("filename").toString(settings->value("Save/filename").toString());
+	const QString folder = params.value("location").toString(settings->value("Save/path").toString());
+	const bool login = !params.value("no-login").toBool(false);
+	const bool noDuplicates = params.value("no-duplicates").toBool(false);
+	const bool getBlacklisted = params.value("blacklist").toBool(false);
+
+	if (command == QLatin1String("count")) {
+		return new GetPageCountCliCommand(m_profile, printer, tags, postFiltering, sites, page, perPage, this);
+	}
+	if (command == QLatin1String("tags")) {
+		const int tagsMin = params.value("tags-min").toInt(0);
+		return new GetPageTagsCliCommand(m_profile, printer, tags, postFiltering, sites, page, perPage, tagsMin, this);
+	}
+	if (command == QLatin1String("images")) {
+		const bool loadMoreDetails = params.value("load-details").toBool(false);
+		return new GetImagesCliCommand(m_profile, printer, tags, postFiltering, sites, page, perPage, filename, folder, max, login, noDuplicates, getBlacklisted, loadMoreDetails, this);
+	}
+	if (command == QLatin1String("download")) {
+		const QString blacklistOverride = params.value("tags-blacklist").toString();
+		const Blacklist blacklist = blacklistOverride.isEmpty() ? m_profile->getBlacklist() : Blacklist(blacklistOverride.split(' '));
+		return new DownloadImagesCliCommand(m_profile, printer, tags, postFiltering, sites, page, perPage, filename, folder, max, login, noDuplicates, getBlacklisted, blacklist, this);
+	}
+
+	error = QStringLiteral("Unknown command: %1").arg(command);
+	return nullptr;
+}
@@ -0,0 +1,59 @@
+#ifndef CLI_SERVER_H
+#define CLI_SERVER_H
+
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+
+
+class CliCommand;
+class Printer;
+class Profile;
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * Long-running server keeping the profile and sources loaded, and running CLI jobs received on a local socket.
+ *
+ * Clients send one JSON object per line with a "command" ("count", "tags", "images", "download", "metrics" or "quit") and the
+ * same parameters as the command line options (e.g. "tags", "sources", "max"). Results are streamed back as NDJSON,
+ * with a final {"finished": true, "code": 0} line for each job. Jobs are run one at a time, in the order received.
+ */
+class CliServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit CliServer(Profile *profile, QObject *parent = nullptr);
+		bool listen(const QString &name);
+		QString fullServerName() const;
+
+	protected:
+		struct Job
+		{
+			QPointer<QLocalSocket> socket;
+			QJsonObject params;
+		};
+
+		CliCommand *createCommand(const QJsonObject &params, Printer *printer, QString &error);
+		void reply(QLocalSocket *socket, const QJsonObject &params, QJsonObject response);
+
+	protected slots:
+		void newConnection();
+		void readyRead();
+		void disconnected();
+		void runNext();
+
+	signals:
+		void quit();
+
+	private:
+		Profile *m_profile;
+		QLocalServer *m_server;
+		QQueue<Job> m_jobs;
+		QLocalSocket *m_currentSocket = nullptr;
+};
+
+#endif // CLI_SERVER_H
@@ -1,4 +1,7 @@
 #include <QCommandLineParser>
+#include <QEventLoop>
+#include <QFile>
+#include <QHostAddress>
 #include <QNetworkProxy>
 #include <QSettings>
 #include <QString>
@@ -6,6 +9,7 @@
 #include <QTimer>
 #include <QUrl>
 #include "cli/cli.h"
+#include "cli/cli-server.h"
 #include "cli/commands/download-images-cli-command.h"
 #include "cli/commands/get-details-cli-command.h"
 #include "cli/commands/get-images-cli-command.h"
@@ -13,14 +17,31 @@
 #include "cli/commands/get-page-tags-cli-command.h"
 #include "cli/commands/get-tags-cli-command.h"
 #include "cli/commands/load-tag-database-cli-command.h"
+#include "cli/commands/search-local-cli-command.h"
+#include "downloader/batch-coordinator.h"
+#include "downloader/batch-worker.h"
+#include "downloader/download-query-group.h"
+#include "downloader/download-query-manager.h"
 #include "downloader/printers/json-printer.h"
 #include "downloader/printers/simple-printer.h"
 #include "logger.h"
+#include "metrics.h"
 #include "models/filtering/blacklist.h"
 #include "models/profile.h"
 #include "models/site.h"
+#include "tracer.h"
 
 
+static void writeMetrics(const QString &path)
+{
+	QFile file(path);
+	if (!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
+		log(QStringLiteral("Could not write metrics to `%1`: %2").arg(path, file.errorString()), Logger::Warning);
+		return;
+	}
+	file.write(Metrics::getInstance().toPrometheus().toUtf8());
+}
+
 int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGui, QMap<QString, QString> &params, QStringList &positionalArgs)
 {
 	QSettings *settings = profile->getSettings();
@@ -57,9 +78,16 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 	const QCommandLineOption proxyOption(QStringList() << "proxy", "Use given proxy.", "[user:password]@host:port", "");
 	const QCommandLineOption noLoginOption(QStringList() << "no-login", "disable auto login.");
 	const QCommandLineOption jsonOption(QStringList() << "j" << "json", "output results as json.");
+	const QCommandLineOption ndjsonOption(QStringList() << "ndjson", "output results as newline-delimited json, as soon as they are loaded.");
 	const QCommandLineOption loadDetailsOption(QStringList() << "load-details", "request (more) details on found items.");
 	const QCommandLineOption getDetailsOption(QStringList() << "get-details", "parse details from given link.", "url-page");
+	const QCommandLineOption getDetailsListOption(QStringList() << "get-details-list", "parse details of the post IDs or links listed in the given file, one per line (\"-\" for stdin).", "file");
 	const QCommandLineOption loadTagDatabaseOption(QStringList() << "load-tag-database", "load the tag database of the given sources.");
+	const QCommandLineOption serverOption(QStringList() << "server", "keep running and accept JSON jobs on the given local socket.", "name");
+	const QCommandLineOption coordinatorOption(QStringList() << "coordinator", "distribute the saved batch downloads to the workers connecting on the given TCP port.", "port");
+	const QCommandLineOption workerOption(QStringList() << "worker", "download the batches given by the coordinator at the given address.", "host:port");
+	const QCommandLineOption metricsOption(QStringList() << "metrics", "write performance metrics in the Prometheus text format to the given file when done.", "file");
+	const QCommandLineOption traceOption(QStringList() << "trace", "record a trace of page loads and downloads to the given file, viewable in chrome://tracing or Perfetto.", "file");
 	parser.addOption(tagsOption);
 	parser.addOption(sourceOption);
 	parser.addOption(pageOption);
@@ -80,19 +108,28 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 	parser.addOption(proxyOption);
 	parser.addOption(noLoginOption);
 	parser.addOption(jsonOption);
+	parser.addOption(ndjsonOption);
 	parser.addOption(loadDetailsOption);
 	parser.addOption(getDetailsOption);
+	parser.addOption(getDetailsListOption);
 	parser.addOption(loadTagDatabaseOption);
+	parser.addOption(serverOption);
+	parser.addOption(coordinatorOption);
+	parser.addOption(workerOption);
+	parser.addOption(metricsOption);
+	parser.addOption(traceOption);
 	const QCommandLineOption returnCountOption(QStringList() << "rc" << "return-count", "Return total image count.");
 	const QCommandLineOption returnTagsOption(QStringList() << "rt" << "return-tags", "Return tags for a search.");
 	const QCommandLineOption returnPureTagsOption(QStringList() << "rp" << "return-pure-tags", "Return tags.");
 	const QCommandLineOption returnImagesOption(QStringList() << "ri" << "return-images", "Return images.");
 	const QCommandLineOption downloadOption(QStringList() << "download", "Download found images.");
+	const QCommandLineOption searchLocalOption(QStringList() << "search-local", "Return the saved files matching the tags, from the local index.");
 	parser.addOption(returnCountOption);
 	parser.addOption(returnTagsOption);
 	parser.addOption(returnPureTagsOption);
 	parser.addOption(returnImagesOption);
 	parser.addOption(downloadOption);
+	parser.addOption(searchLocalOption);
 
 	parser.process(*app);
 
@@ -107,6 +144,16 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 		Logger::getInstance().setLogLevel(Logger::Debug);
 	}
 
+	// Tracing, written to the trace file when the application quits
+	const bool trace = parser.isSet(traceOption) || settings->value("Tracing/enabled", false).toBool();
+	if (trace) {
+		const QString tracePath = parser.isSet(traceOption)
+			? parser.value(traceOption)
+			: settings->value("Tracing/file", savePath("trace.json")).toString();
+		Tracer::getInstance().start(tracePath);
+		QObject::connect(app, &QCoreApplication::aboutToQuit, []() { Tracer::getInstance().stop(); });
+	}
+
 	// Stop here for GUI, but pass some information to the main window from the parser later
 	if (gui) {
 		// TODO(Bionus): get rid of this
@@ -125,8 +172,8 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 		return -1;
 	}
 
-	// Generate a runtime error when an error log arrives
-	if (!parser.isSet(ignoreErrorOption)) {
+	// Generate a runtime error when an error log arrives (except for servers, where errors only fail the current job)
+	if (!parser.isSet(ignoreErrorOption) && !parser.isSet(serverOption) && !parser.isSet(coordinatorOption) && !parser.isSet(workerOption)) {
 		Logger::getInstance().setExitOnError(true);
 	}
 
@@ -164,8 +211,91 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 		}
 	}
 
-	Printer *printer = parser.isSet(jsonOption)
-		? (Printer*) new JsonPrinter(profile)
+	// Keep the profile loaded and wait for jobs
+	if (parser.isSet(serverOption)) {
+		CliServer server(profile);
+		if (!server.listen(parser.value(serverOption))) {
+			return 1;
+		}
+
+		QEventLoop loop;
+		QObject::connect(&server, &CliServer::quit, &loop, &QEventLoop::quit);
+		loop.exec();
+
+		if (parser.isSet(metricsOption)) {
+			writeMetrics(parser.value(metricsOption));
+		}
+		Tracer::getInstance().stop();
+		return 0;
+	}
+
+	if (parser.isSet(coordinatorOption)) {
+		QSettings *settings = profile->getSettings();
+		BatchCoordinator coordinator(settings->value("Coordinator/leaseTimeout", 60).toInt() * 1000);
+
+		DownloadQueryManager *manager = profile->downloadQueryManager();
+		manager->load();
+		const int pagesPerLease = settings->value("Coordinator/pagesPerLease", 0).toInt();
+		for (const DownloadQueryGroup &group : manager->groups()) {
+			if (!group.progressFinished) {
+				coordinator.addGroup(group, pagesPerLease);
+			}
+		}
+
+		if (!coordinator.listen(QHostAddress::Any, parser.value(coordinatorOption).toUShort())) {
+			return 1;
+		}
+		QObject::connect(&coordinator, &BatchCoordinator::progress, [](int done, int total) {
+			log(QStringLiteral("Batch progress: %1/%2").arg(done).arg(total), Logger::Info);
+		});
+
+		if (!coordinator.isFinished()) {
+			QEventLoop loop;
+			QObject::connect(&coordinator, &BatchCoordinator::finished, &loop, &QEventLoop::quit);
+			loop.exec();
+		}
+
+		int failed = 0;
+		for (const BatchCoordinator::Lease &lease : coordinator.leases()) {
+			if (lease.state == BatchCoordinator::Failed) {
+				failed++;
+			}
+		}
+
+		if (parser.isSet(metricsOption)) {
+			writeMetrics(parser.value(metricsOption));
+		}
+		Tracer::getInstance().stop();
+		return failed > 0 ? 1 : 0;
+	}
+
+	if (parser.isSet(workerOption)) {
+		const QString address = parser.value(workerOption);
+		const int sep = address.lastIndexOf(':');
+		const int heartbeatInterval = profile->getSettings()->value("Coordinator/heartbeatInterval", 10).toInt() * 1000;
+
+		BatchWorker worker(profile, heartbeatInterval);
+		if (sep < 0 || !worker.start(address.left(sep), address.mid(sep + 1).toUShort())) {
+			return 1;
+		}
+
+		int code = 0;
+		QEventLoop loop;
+		QObject::connect(&worker, &BatchWorker::finished, &loop, [&loop, &code](int ret) {
+			code = ret;
+			loop.quit();
+		});
+		loop.exec();
+
+		if (parser.isSet(metricsOption)) {
+			writeMetrics(parser.value(metricsOption));
+		}
+		Tracer::getInstance().stop();
+		return code;
+	}
+
+	Printer *printer = parser.isSet(jsonOption) || parser.isSet(ndjsonOption)
+		? (Printer*) new JsonPrinter(profile, parser.isSet(ndjsonOption))
 		: (Printer*) new SimplePrinter(parser.value(tagsFormatOption));
 
 	CliCommand *cmd = nullptr;
@@ -179,6 +309,24 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 		const QString detailsUrl = parser.value(getDetailsOption);
 
 		cmd = new GetDetailsCliCommand(profile, printer, sites, detailsUrl);
+	} else if (parser.isSet(getDetailsListOption)) {
+		const QString listPath = parser.value(getDetailsListOption);
+		QFile listFile(listPath);
+		const bool opened = listPath == "-"
+			? listFile.open(stdin, QIODevice::ReadOnly | QIODevice::Text)
+			: listFile.open(QIODevice::ReadOnly | QIODevice::Text);
+		if (!opened) {
+			log(QStringLiteral("Could not open details list `%1`").arg(listPath), Logger::Error);
+			return 1;
+		}
+		const QStringList entries = GetDetailsCliCommand::readEntries(&listFile);
+
+		cmd = new GetDetailsCliCommand(profile, printer, sites, entries);
+	} else if (parser.isSet(searchLocalOption)) {
+		const QStringList tags = parser.value(tagsOption).split(" ", Qt::SkipEmptyParts);
+		const int max = parser.value(limitOption).toInt();
+
+		cmd = new SearchLocalCliCommand(profile, printer, tags, max);
 	} else if (parser.isSet(returnCountOption)) {
 		const QStringList tags = parser.value(tagsOption).split(" ", Qt::SkipEmptyParts);
 		const QStringList postFiltering = parser.value(postFilteringOption).split(" ", Qt::SkipEmptyParts);
@@ -243,6 +391,11 @@ int parseAndRunCliArgs(QCoreApplication *app, Profile *profile, bool defaultToGu
 	QTimer::singleShot(0, [cmd]() { cmd->run(); });
 	loop.exec();
 
+	if (parser.isSet(metricsOption)) {
+		writeMetrics(parser.value(metricsOption));
+	}
+	Tracer::getInstance().stop();
+
 	cmd->deleteLater();
 	return 0;
 }
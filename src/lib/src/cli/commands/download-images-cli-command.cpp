@@ -27,19 +27,20 @@ bool DownloadImagesCliCommand::validate()
 
 void DownloadImagesCliCommand::run()
 {
-	const QList<QSharedPointer<Image>> images = getAllImages();
-
-	for (const auto &image : images) {
-		ImageDownloader dwl(m_profile, image, m_filename, m_folder, 0, true, false, this);
-		if (!m_getBlacklisted) {
-			dwl.setBlacklist(&m_blacklistedTags);
+	// Download each pack as soon as it's loaded
+	loadImages([this](const QList<QSharedPointer<Image>> &images) {
+		for (const auto &image : images) {
+			ImageDownloader dwl(m_profile, image, m_filename, m_folder, 0, true, false, this);
+			if (!m_getBlacklisted) {
+				dwl.setBlacklist(&m_blacklistedTags);
+			}
+
+			QEventLoop loop;
+			QObject::connect(&dwl, &ImageDownloader::saved, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+			dwl.save();
+			loop.exec();
 		}
-
-		QEventLoop loop;
-		QObject::connect(&dwl, &ImageDownloader::saved, &loop, &QEventLoop::quit, Qt::QueuedConnection);
-		dwl.save();
-		loop.exec();
-	}
+	});
 
 	m_printer->print(QStringLiteral("Downloaded images successfully."));
 
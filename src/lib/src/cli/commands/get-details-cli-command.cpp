@@ -1,15 +1,34 @@
 #include "get-details-cli-command.h"
+#include <QIODevice>
 #include <QList>
+#include <QRegularExpression>
 #include "cli-command.h"
+#include "downloader/details-batcher.h"
+#include "downloader/printers/printer.h"
 #include "logger.h"
 #include "models/image.h"
-#include "downloader/printers/printer.h"
 
 
 GetDetailsCliCommand::GetDetailsCliCommand(Profile *profile, Printer *printer, const QList<Site*> &sites, const QString &pageUrl, QObject *parent)
-	: CliCommand(parent), m_profile(profile), m_printer(printer), m_sites(sites), m_pageUrl(pageUrl)
+	: GetDetailsCliCommand(profile, printer, sites, pageUrl.isEmpty() ? QStringList() : QStringList { pageUrl }, parent)
 {}
 
+GetDetailsCliCommand::GetDetailsCliCommand(Profile *profile, Printer *printer, const QList<Site*> &sites, const QStringList &entries, QObject *parent)
+	: CliCommand(parent), m_profile(profile), m_printer(printer), m_sites(sites), m_entries(entries)
+{}
+
+QStringList GetDetailsCliCommand::readEntries(QIODevice *device)
+{
+	QStringList entries;
+	while (!device->atEnd()) {
+		const QString line = QString::fromUtf8(device->readLine()).trimmed();
+		if (!line.isEmpty() && !line.startsWith('#')) {
+			entries.append(line);
+		}
+	}
+	return entries;
+}
+
 bool GetDetailsCliCommand::validate()
 {
 	if (m_sites.count() != 1) {
@@ -17,7 +36,7 @@ bool GetDetailsCliCommand::validate()
 		return false;
 	}
 
-	if (m_pageUrl.isEmpty()) {
+	if (m_entries.isEmpty()) {
 		log("You must pass a page URL to load the details", Logger::Error);
 		return false;
 	}
@@ -27,19 +46,50 @@ bool GetDetailsCliCommand::validate()
 
 void GetDetailsCliCommand::run()
 {
-	QMap<QString, QString> details = {{ "page_url", m_pageUrl }};
+	static const QRegularExpression rxId("^\\d+$");
 
-	m_image = new Image(m_sites[0], details, m_profile);
-	m_image->setPromoteDetailParsWarn(true);
+	Site *site = m_sites[0];
+	m_batcher = new DetailsBatcher(site, this);
+	m_stream = m_entries.count() == 1 || m_printer->canStream();
 
-	connect(m_image, &Image::finishedLoadingTags, this, &GetDetailsCliCommand::finishedLoading);
-	m_image->loadDetails();
+	for (const QString &entry : qAsConst(m_entries)) {
+		const QString key = rxId.match(entry).hasMatch() ? QStringLiteral("id") : QStringLiteral("page_url");
+		QMap<QString, QString> details = {{ key, entry }};
+
+		QSharedPointer<Image> img(new Image(site, details, m_profile));
+		img->setPromoteDetailParsWarn(true);
+		m_images.append(img);
+	}
+
+	// All the details are requested at once, the site's network manager taking care of the throttling
+	m_remaining = m_images.count();
+	for (int i = 0; i < m_images.count(); ++i) {
+		connect(m_images[i].data(), &Image::finishedLoadingTags, this, [this, i]() { finishedLoading(i); });
+	}
+	for (const QSharedPointer<Image> &img : qAsConst(m_images)) {
+		m_batcher->loadDetails(img);
+	}
 }
 
-void GetDetailsCliCommand::finishedLoading()
+/**
+ * Results are printed as soon as they are received when the printer supports it, or all at once in the input order.
+ */
+void GetDetailsCliCommand::finishedLoading(int index)
 {
-	m_printer->print(*m_image);
-	m_image->deleteLater();
+	const QSharedPointer<Image> &img = m_images[index];
+	disconnect(img.data(), &Image::finishedLoadingTags, this, nullptr);
+
+	if (m_stream) {
+		m_printer->print(*img);
+	}
+
+	if (--m_remaining > 0) {
+		return;
+	}
+
+	if (!m_stream) {
+		m_printer->print(m_images);
+	}
 
 	emit finished(0);
 }
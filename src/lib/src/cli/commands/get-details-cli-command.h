@@ -2,13 +2,17 @@
 #define GET_DETAILS_CLI_COMMAND_H
 
 #include <QList>
+#include <QSharedPointer>
 #include <QString>
+#include <QStringList>
 #include "cli-command.h"
 
 
+class DetailsBatcher;
 class Image;
 class Printer;
 class Profile;
+class QIODevice;
 class QObject;
 class Site;
 
@@ -19,18 +23,32 @@ class GetDetailsCliCommand : public CliCommand
 	public:
 		explicit GetDetailsCliCommand(Profile *profile, Printer *printer, const QList<Site*> &sites, const QString &pageUrl, QObject *parent = nullptr);
 
+		/**
+		 * Load the details of several posts at once, each entry being either a post ID or a page URL.
+		 * Posts given by ID are fetched using batch searches when the source supports them.
+		 */
+		explicit GetDetailsCliCommand(Profile *profile, Printer *printer, const QList<Site*> &sites, const QStringList &entries, QObject *parent = nullptr);
+
+		/**
+		 * Read a list of entries, one per line, ignoring empty lines and lines starting with "#".
+		 */
+		static QStringList readEntries(QIODevice *device);
+
 		bool validate() override;
 		void run() override;
 
-	protected slots:
-		void finishedLoading();
+	protected:
+		void finishedLoading(int index);
 
 	private:
 		Profile *m_profile;
 		Printer *m_printer;
 		QList<Site*> m_sites;
-		QString m_pageUrl;
-		Image *m_image;
+		QStringList m_entries;
+		QList<QSharedPointer<Image>> m_images;
+		DetailsBatcher *m_batcher = nullptr;
+		bool m_stream = false;
+		int m_remaining = 0;
 };
 
-#endif // LOAD_TAG_DATABASE_CLI_COMMAND_H
+#endif // GET_DETAILS_CLI_COMMAND_H
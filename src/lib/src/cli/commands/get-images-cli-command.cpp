@@ -21,6 +21,19 @@ bool GetImagesCliCommand::validate()
 
 void GetImagesCliCommand::run()
 {
+	// Print each pack as soon as it's loaded, without keeping the images in memory
+	if (m_printer->canStream()) {
+		loadImages([this](const QList<QSharedPointer<Image>> &images) {
+			if (m_loadMoreDetails) {
+				loadMoreDetails(images);
+			}
+			m_printer->print(images);
+		});
+
+		emit finished(0);
+		return;
+	}
+
 	const QList<QSharedPointer<Image>> images = getAllImages();
 
 	if (m_loadMoreDetails) {
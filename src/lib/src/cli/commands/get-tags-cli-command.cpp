@@ -1,6 +1,7 @@
 #include "get-tags-cli-command.h"
 #include <QEventLoop>
 #include <QList>
+#include <QVector>
 #include <QtMath>
 #include "cli-command.h"
 #include "downloader/printers/printer.h"
@@ -23,46 +24,77 @@ bool GetTagsCliCommand::validate()
 	return true;
 }
 
+/**
+ * All the pages of all sites are loaded at the same time, each site still being throttled by its own network manager.
+ * When the printer supports it, each page's tags are printed as soon as they are received.
+ */
 void GetTagsCliCommand::run()
 {
-	QList<Tag> results;
+	int pages = qCeil(static_cast<qreal>(m_max) / m_perPage);
+	if (pages <= 0 || m_perPage <= 0 || m_max <= 0) {
+		pages = 1;
+	}
 
+	QList<TagApi*> tagApis;
 	for (Site *site : qAsConst(m_sites)) {
 		Api *api = site->tagsApi();
 		if (api == nullptr) {
 			log(QStringLiteral("No valid API for loading tags for source: %1").arg(site->url()), Logger::Error);
+			qDeleteAll(tagApis);
 			return;
 		}
 
-		int pages = qCeil(static_cast<qreal>(m_max) / m_perPage);
-		if (pages <= 0 || m_perPage <= 0 || m_max <= 0) {
-			pages = 1;
-		}
-
 		for (int p = 0; p < pages; ++p) {
-			auto *tagApi = new TagApi(m_profile, site, api, m_page + p, m_perPage, "count", this);
+			tagApis.append(new TagApi(m_profile, site, api, m_page + p, m_perPage, "count", this));
+		}
+	}
 
-			QEventLoop loop;
-			QObject::connect(tagApi, &TagApi::finishedLoading, &loop, &QEventLoop::quit, Qt::QueuedConnection);
-			tagApi->load();
-			loop.exec();
+	const bool stream = m_printer->canStream();
+	QVector<QList<Tag>> results(tagApis.count());
 
-			const QList<Tag> tags = tagApi->tags();
+	QEventLoop loop;
+	int remaining = tagApis.count();
+	for (int index = 0; index < tagApis.count(); ++index) {
+		TagApi *tagApi = tagApis[index];
+		connect(tagApi, &TagApi::finishedLoading, &loop, [this, &loop, &remaining, &results, stream, tagApi, index]() {
+			QList<Tag> tags = tagApi->tags();
 			log(QStringLiteral("Received pure tags (%1)").arg(tags.count()));
 			tagApi->deleteLater();
 
-			results.append(tags);
-		}
+			QMutableListIterator<Tag> i(tags);
+			while (i.hasNext()) {
+				if (i.next().count() < m_tagsMin) {
+					i.remove();
+				}
+			}
+
+			if (stream) {
+				if (!tags.isEmpty()) {
+					m_printer->print(tags, nullptr);
+				}
+			} else {
+				results[index] = tags;
+			}
+
+			if (--remaining == 0) {
+				loop.quit();
+			}
+		}, Qt::QueuedConnection);
 	}
 
-	QMutableListIterator<Tag> i(results);
-	while (i.hasNext()) {
-		if (i.next().count() < m_tagsMin) {
-			i.remove();
-		}
+	for (TagApi *tagApi : qAsConst(tagApis)) {
+		tagApi->load();
 	}
+	loop.exec();
 
-	m_printer->print(results, nullptr);
+	// Keep the order of the sites and pages when printing everything at once
+	if (!stream) {
+		QList<Tag> all;
+		for (const QList<Tag> &tags : qAsConst(results)) {
+			all.append(tags);
+		}
+		m_printer->print(all, nullptr);
+	}
 
 	emit finished(0);
 }
@@ -8,19 +8,31 @@ SearchCliCommand::SearchCliCommand(Profile *profile, QStringList tags, QStringLi
 	: CliCommand(parent), m_profile(profile), m_tags(std::move(tags)), m_postFiltering(std::move(postFiltering)), m_sites(std::move(sites)), m_page(page), m_perPage(perPage)
 {}
 
+/**
+ * All sites are loaded at the same time, each one still being throttled by its own network manager.
+ */
 QList<Page*> SearchCliCommand::getTagsForAllPages()
 {
 	QList<Page*> pages;
-
 	for (auto *site : m_sites) {
-		auto *page = new Page(m_profile, site, m_sites, m_tags, m_page, m_perPage, m_postFiltering, true, this);
+		pages.append(new Page(m_profile, site, m_sites, m_tags, m_page, m_perPage, m_postFiltering, true, this));
+	}
+
+	QEventLoop loop;
+	int remaining = pages.count();
+	for (Page *page : qAsConst(pages)) {
+		connect(page, &Page::finishedLoadingTags, &loop, [&loop, &remaining]() {
+			if (--remaining == 0) {
+				loop.quit();
+			}
+		}, Qt::QueuedConnection);
+	}
 
-		QEventLoop loop;
-		connect(page, &Page::finishedLoadingTags, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+	for (Page *page : qAsConst(pages)) {
 		page->loadTags();
+	}
+	if (remaining > 0) {
 		loop.exec();
-
-		pages.append(page);
 	}
 
 	return pages;
@@ -36,14 +36,13 @@ bool SearchImagesCliCommand::validate()
 	return true;
 }
 
-QList<QSharedPointer<Image>> SearchImagesCliCommand::getAllImages()
+void SearchImagesCliCommand::loadImages(const std::function<void(const QList<QSharedPointer<Image>> &)> &callback)
 {
 	const bool usePacking = m_profile->getSettings()->value("packing_enable", true).toBool();
 	const int imagesPerPack = m_profile->getSettings()->value("packing_size", 1000).toInt();
 	const int packSize = usePacking ? imagesPerPack : -1;
 
 	QSet<QString> md5s;
-	QList<QSharedPointer<Image>> images;
 
 	for (auto *site : m_sites) {
 		DownloadQueryGroup query(m_tags, m_page, m_perPage, m_max, m_postFiltering, m_getBlacklisted, site, m_filename, m_folder);
@@ -52,6 +51,8 @@ QList<QSharedPointer<Image>> SearchImagesCliCommand::getAllImages()
 		loader.start(m_login);
 		while (loader.hasNext()) {
 			const auto next = loader.next();
+
+			QList<QSharedPointer<Image>> images;
 			for (const auto &img : next) {
 				if (m_noDuplicates) {
 					if (md5s.contains(img->md5())) {
@@ -61,9 +62,20 @@ QList<QSharedPointer<Image>> SearchImagesCliCommand::getAllImages()
 				}
 				images.append(img);
 			}
+
+			if (!images.isEmpty()) {
+				callback(images);
+			}
 		}
 	}
+}
 
+QList<QSharedPointer<Image>> SearchImagesCliCommand::getAllImages()
+{
+	QList<QSharedPointer<Image>> images;
+	loadImages([&images](const QList<QSharedPointer<Image>> &pack) {
+		images.append(pack);
+	});
 	return images;
 }
 
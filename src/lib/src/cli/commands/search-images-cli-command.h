@@ -4,6 +4,7 @@
 #include <QList>
 #include <QSharedPointer>
 #include <QStringList>
+#include <functional>
 #include "search-cli-command.h"
 
 
@@ -21,6 +22,10 @@ class SearchImagesCliCommand : public SearchCliCommand
 		bool validate() override;
 
 	protected:
+		/**
+		 * Load all the images from the search, calling the callback with each pack as soon as it is loaded.
+		 */
+		void loadImages(const std::function<void(const QList<QSharedPointer<Image>> &)> &callback);
 		QList<QSharedPointer<Image>> getAllImages();
 		void loadMoreDetails(const QList<QSharedPointer<Image>> &images);
 
@@ -0,0 +1,35 @@
+#include "search-local-cli-command.h"
+#include <QList>
+#include "cli-command.h"
+#include "downloader/printers/printer.h"
+#include "logger.h"
+#include "models/local-index.h"
+#include "models/profile.h"
+
+
+SearchLocalCliCommand::SearchLocalCliCommand(Profile *profile, Printer *printer, const QStringList &tags, int max, QObject *parent)
+	: CliCommand(parent), m_profile(profile), m_printer(printer), m_tags(tags), m_max(max)
+{}
+
+bool SearchLocalCliCommand::validate()
+{
+	if (m_profile->localIndex()->count() == 0) {
+		log("The local index is empty, enable \"Save/localIndex\" to index the files as they are saved", Logger::Error);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Print the path of the saved files matching the tags, without any network request.
+ */
+void SearchLocalCliCommand::run()
+{
+	const QList<LocalIndex::Entry> entries = m_profile->localIndex()->search(m_tags, m_max > 0 ? m_max : -1);
+	for (const LocalIndex::Entry &entry : entries) {
+		m_printer->print(entry.path);
+	}
+
+	emit finished(0);
+}
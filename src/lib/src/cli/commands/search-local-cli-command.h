@@ -0,0 +1,29 @@
+#ifndef SEARCH_LOCAL_CLI_COMMAND_H
+#define SEARCH_LOCAL_CLI_COMMAND_H
+
+#include <QStringList>
+#include "cli-command.h"
+
+
+class Printer;
+class Profile;
+class QObject;
+
+class SearchLocalCliCommand : public CliCommand
+{
+	Q_OBJECT
+
+	public:
+		explicit SearchLocalCliCommand(Profile *profile, Printer *printer, const QStringList &tags, int max, QObject *parent = nullptr);
+
+		bool validate() override;
+		void run() override;
+
+	private:
+		Profile *m_profile;
+		Printer *m_printer;
+		QStringList m_tags;
+		int m_max;
+};
+
+#endif // SEARCH_LOCAL_CLI_COMMAND_H
@@ -0,0 +1,133 @@
+#include "commands/command-runner.h"
+#include <QMutexLocker>
+#include <QProcess>
+#include <QtConcurrent>
+#include "functions.h"
+#include "logger.h"
+#include "tracer.h"
+
+
+CommandRunner::CommandRunner(int maxProcesses, int timeout)
+	: m_timeout(timeout)
+{
+	m_pool.setMaxThreadCount(qMax(1, maxProcesses));
+}
+
+CommandRunner::~CommandRunner()
+{
+	m_pool.waitForDone();
+}
+
+void CommandRunner::run(const QString &key, const QString &command)
+{
+	QMutexLocker locker(&m_mutex);
+
+	// If a chain is already running for this key, it will pick up the command when it's its turn
+	const bool running = m_chains.contains(key);
+	m_chains[key].enqueue(command);
+	if (running) {
+		return;
+	}
+
+	QtConcurrent::run(&m_pool, [this, key]() {
+		runChain(key);
+	});
+}
+
+void CommandRunner::runChain(const QString &key)
+{
+	for (;;) {
+		QString command;
+		bool done = false;
+		QList<std::function<void()>> callbacks;
+		{
+			QMutexLocker locker(&m_mutex);
+			QQueue<QString> &chain = m_chains[key];
+			if (!chain.isEmpty()) {
+				command = chain.dequeue();
+			} else {
+				done = true;
+				m_chains.remove(key);
+				if (m_chains.isEmpty()) {
+					callbacks.swap(m_callbacks);
+				}
+			}
+		}
+
+		if (done) {
+			for (const auto &callback : callbacks) {
+				callback();
+			}
+			return;
+		}
+
+		execute(command, m_timeout);
+	}
+}
+
+void CommandRunner::whenDone(const std::function<void()> &callback)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		if (!m_chains.isEmpty()) {
+			m_callbacks.append(callback);
+			return;
+		}
+	}
+
+	callback();
+}
+
+bool CommandRunner::waitForDone(int msecs)
+{
+	return m_pool.waitForDone(msecs);
+}
+
+bool CommandRunner::execute(const QString &command, int timeout)
+{
+	#if defined(QT_NO_PROCESS)
+		Q_UNUSED(command);
+		Q_UNUSED(timeout);
+		log(QStringLiteral("Cannot run commands on this platform (no QProcess"), Logger::Error);
+		return false;
+	#else
+		TraceSpan span(QStringLiteral("command"), QStringLiteral("commands"), QVariantMap { { "command", command } });
+		log(QStringLiteral("Execution of \"%1\"").arg(command));
+		Logger::getInstance().logCommand(command);
+
+		QStringList args = splitCommand(command);
+		if (args.isEmpty()) {
+			return false;
+		}
+		QString program = args.takeFirst();
+
+		QProcess proc;
+
+		// Connect command output to logs
+		QObject::connect(&proc, &QProcess::readyReadStandardOutput, [&proc]() { log(QStringLiteral("[Command stdout] %1").arg(QString(proc.readAllStandardOutput())), Logger::Debug); });
+		QObject::connect(&proc, &QProcess::readyReadStandardError, [&proc]() { log(QStringLiteral("[Command stderr] %1").arg(QString(proc.readAllStandardError())), Logger::Error); });
+
+		proc.start(program, args);
+		if (!proc.waitForStarted()) {
+			log(QStringLiteral("Error starting command: %1").arg(proc.errorString()), Logger::Error);
+			return false;
+		}
+
+		// Wait for the command to finish, killing it if it takes too long
+		if (!proc.waitForFinished(timeout)) {
+			log(QStringLiteral("Command execution timeout"), Logger::Error);
+			proc.kill();
+			proc.waitForFinished();
+			return false;
+		}
+
+		// Check the return code for error codes (stderr output does not cause a "false" return)
+		const int code = proc.exitCode();
+		if (code != 0) {
+			log(QStringLiteral("Error executing command (return code: %1)").arg(code), Logger::Error);
+			return false;
+		}
+
+		return true;
+	#endif
+}
@@ -0,0 +1,50 @@
+#ifndef COMMAND_RUNNER_H
+#define COMMAND_RUNNER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+
+
+/**
+ * Runs external commands in a bounded pool of threads, each one waiting for its process to finish.
+ *
+ * Commands sharing the same key (for example the commands of the same image) are run one after the other in the
+ * order they were added, while commands with different keys run concurrently.
+ */
+class CommandRunner
+{
+	public:
+		explicit CommandRunner(int maxProcesses, int timeout);
+		~CommandRunner();
+
+		/**
+		 * Queue a command, to be run after all the previous commands with the same key finished.
+		 */
+		void run(const QString &key, const QString &command);
+
+		/**
+		 * Call the callback once all the queued commands finished, or right away if there are none.
+		 */
+		void whenDone(const std::function<void()> &callback);
+
+		bool waitForDone(int msecs = -1);
+		static bool execute(const QString &command, int timeout);
+
+	protected:
+		void runChain(const QString &key);
+
+	private:
+		QThreadPool m_pool;
+		int m_timeout;
+
+		QMutex m_mutex;
+		QHash<QString, QQueue<QString>> m_chains;
+		QList<std::function<void()>> m_callbacks;
+};
+
+#endif // COMMAND_RUNNER_H
@@ -1,7 +1,8 @@
 #include "commands/commands.h"
 #include <QDir>
-#include <QProcess>
 #include <QSettings>
+#include <QThread>
+#include "commands/command-runner.h"
 #include "commands/sql-worker.h"
 #include "functions.h"
 #include "logger.h"
@@ -20,6 +21,8 @@ Commands::Commands(Profile *profile)
 	m_commandTagBefore = settings->value("Exec/tag_before").toString();
 	m_commandImage = settings->value("Exec/image").toString();
 	m_commandTagAfter = settings->value("Exec/tag_after", settings->value("Exec/tag").toString()).toString();
+	m_commandTimeout = settings->value("Exec/timeout", 30).toInt() * 1000;
+	m_commandRunner = new CommandRunner(settings->value("Exec/maxProcesses", 4).toInt(), m_commandTimeout);
 
 	m_mysqlSettings.before = settings->value("Exec/SQL/before").toString();
 	m_mysqlSettings.tagBefore = settings->value("Exec/SQL/tag_before").toString();
@@ -33,17 +36,48 @@ Commands::Commands(Profile *profile)
 		settings->value("Exec/SQL/user").toString(),
 		settings->value("Exec/SQL/password").toString(),
 		settings->value("Exec/SQL/database").toString());
-	m_sqlWorker->setObjectName("SqlThread");
+	m_sqlWorker->setBatching(
+		settings->value("Exec/SQL/batchSize", 100).toInt(),
+		settings->value("Exec/SQL/batchDelay", 500).toInt());
+	m_sqlStarted = false;
+
+	// Run the SQL commands in their own thread, so that a slow database never blocks downloads or the UI
+	m_sqlThread = nullptr;
+	if (m_sqlWorker->isEnabled()) {
+		m_sqlThread = new QThread();
+		m_sqlThread->setObjectName("SqlThread");
+		m_sqlWorker->moveToThread(m_sqlThread);
+		QObject::connect(m_sqlThread, &QThread::finished, m_sqlWorker, &QObject::deleteLater);
+		m_sqlThread->start();
+	}
 }
 
 Commands::~Commands()
 {
-	m_sqlWorker->deleteLater();
+	// Wait for the running commands first, as they can still queue SQL statements
+	delete m_commandRunner;
+
+	if (m_sqlThread != nullptr) {
+		// The worker is deleted in its thread on exit, which commits its pending statements
+		m_sqlThread->quit();
+		m_sqlThread->wait();
+		delete m_sqlThread;
+	} else {
+		m_sqlWorker->deleteLater();
+	}
 }
 
 bool Commands::start() const
 {
-	return m_sqlWorker->connect();
+	if (m_sqlThread == nullptr || m_sqlStarted) {
+		return true;
+	}
+
+	// The connection can only be used in the thread that created it
+	bool ok = false;
+	QMetaObject::invokeMethod(m_sqlWorker, "connect", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, ok));
+	m_sqlStarted = ok;
+	return ok;
 }
 
 bool Commands::before() const
@@ -57,7 +91,7 @@ bool Commands::before() const
 
 bool Commands::image(const Image &img, const QString &path)
 {
-	// Normal commands
+	// Normal commands, run in the background but in order for the same image
 	if (!m_commandImage.isEmpty()) {
 		Filename fn(m_commandImage);
 		QStringList execs = fn.path(img, m_profile, QString(), 0, Filename::None);
@@ -66,9 +100,7 @@ bool Commands::image(const Image &img, const QString &path)
 			exec.replace("%path:nobackslash%", QDir::toNativeSeparators(path).replace("\\", "/"))
 				.replace("%path%", QDir::toNativeSeparators(path));
 
-			if (!execute(exec)) {
-				return false;
-			}
+			m_commandRunner->run(img.fileUrl().toString(), exec);
 		}
 	}
 
@@ -78,11 +110,15 @@ bool Commands::image(const Image &img, const QString &path)
 		fn.setEscapeMethod(&SqlWorker::escape);
 		QStringList execs = fn.path(img, m_profile, QString(), 0, Filename::None);
 
-		for (QString exec : execs) {
-			exec.replace("%path:nobackslash%", m_sqlWorker->escape(QDir::toNativeSeparators(path).replace("\\", "/")))
-				.replace("%path%", m_sqlWorker->escape(QDir::toNativeSeparators(path)));
+		const QList<QPair<QString, QVariant>> tokens {
+			{ "%path:nobackslash%", QDir::toNativeSeparators(path).replace("\\", "/") },
+			{ "%path%", QDir::toNativeSeparators(path) },
+		};
+		for (const QString &exec : execs) {
+			QVariantList values;
+			const QString sql = bindTokens(exec, tokens, values);
 
-			if (!sqlExec(exec)) {
+			if (!sqlExec(sql, values)) {
 				return false;
 			}
 		}
@@ -107,9 +143,7 @@ bool Commands::tag(const Image &img, const Tag &tag, bool after)
 				.replace("%type%", tag.type().name())
 				.replace("%number%", QString::number(tag.type().number(img.parentSite())));
 
-			if (!execute(exec)) {
-				return false;
-			}
+			m_commandRunner->run(img.fileUrl().toString(), exec);
 		}
 	}
 
@@ -120,13 +154,17 @@ bool Commands::tag(const Image &img, const Tag &tag, bool after)
 		Filename fn(commandSql);
 		QStringList execs = fn.path(img, m_profile, QString(), 0, Filename::KeepInvalidTokens);
 
-		for (QString exec : execs) {
-			exec.replace("%tag%", m_sqlWorker->escape(original))
-				.replace("%original%", m_sqlWorker->escape(tag.text()))
-				.replace("%type%", m_sqlWorker->escape(tag.type().name()))
-				.replace("%number%", QString::number(tag.type().number(img.parentSite())));
-
-			if (!sqlExec(exec)) {
+		const QList<QPair<QString, QVariant>> tokens {
+			{ "%tag%", original },
+			{ "%original%", tag.text() },
+			{ "%type%", tag.type().name() },
+			{ "%number%", tag.type().number(img.parentSite()) },
+		};
+		for (const QString &exec : execs) {
+			QVariantList values;
+			const QString sql = bindTokens(exec, tokens, values);
+
+			if (!sqlExec(sql, values)) {
 				return false;
 			}
 		}
@@ -137,8 +175,12 @@ bool Commands::tag(const Image &img, const Tag &tag, bool after)
 
 bool Commands::after() const
 {
+	// The "after" command must only run once all the image commands are finished
 	if (!m_mysqlSettings.after.isEmpty()) {
-		return sqlExec(m_mysqlSettings.after);
+		const QString sql = m_mysqlSettings.after;
+		m_commandRunner->whenDone([this, sql]() {
+			sqlExec(sql);
+		});
 	}
 
 	return true;
@@ -146,41 +188,46 @@ bool Commands::after() const
 
 bool Commands::execute(const QString &command) const
 {
-	#if defined(QT_NO_PROCESS)
-		log(QStringLiteral("Cannot run commands on this platform (no QProcess"), Logger::Error);
-		return false;
-	#else
-		log(QStringLiteral("Execution of \"%1\"").arg(command));
-		Logger::getInstance().logCommand(command);
-
-		QStringList args = splitCommand(command);
-		QString program = args.takeFirst();
-
-		QProcess proc;
-		proc.start(program, args);
-
-		// Connect command output to logs
-		QObject::connect(&proc, &QProcess::readyReadStandardOutput, [&proc]() { log(QStringLiteral("[Command stdout] %1").arg(QString(proc.readAllStandardOutput())), Logger::Debug); });
-		QObject::connect(&proc, &QProcess::readyReadStandardError, [&proc]() { log(QStringLiteral("[Command stderr] %1").arg(QString(proc.readAllStandardError())), Logger::Error); });
-
-		// Wait for  the command to finish 30s
-		if (!proc.waitForFinished()) {
-			log(QStringLiteral("Command execution timeout"), Logger::Error);
-		}
-
-		// Check the return code for error codes (stderr output does not cause a "false" return)
-		const int code = proc.exitCode();
-		if (code != 0) {
-			log(QStringLiteral("Error executing command (return code: %1)").arg(code), Logger::Error);
-			return false;
-		}
+	return CommandRunner::execute(command, m_commandTimeout);
+}
 
+bool Commands::sqlExec(const QString &sql, const QVariantList &values) const
+{
+	if (m_sqlThread == nullptr) {
 		return true;
-	#endif
+	}
+
+	QMetaObject::invokeMethod(m_sqlWorker, "queue", Qt::QueuedConnection, Q_ARG(QString, sql), Q_ARG(QVariantList, values));
+	return true;
 }
 
-bool Commands::sqlExec(const QString &sql) const
+/**
+ * Replace the given tokens by "?" placeholders, appending their values in order of appearance.
+ * Using bound values instead of escaping them in place allows the same prepared statement to be re-used for each tag.
+ */
+QString Commands::bindTokens(const QString &sql, const QList<QPair<QString, QVariant>> &tokens, QVariantList &values)
 {
-	QMetaObject::invokeMethod(m_sqlWorker, "execute", Qt::QueuedConnection, Q_ARG(QString, sql));
-	return true;
+	QString ret;
+	int pos = 0;
+	for (;;) {
+		int next = -1;
+		int token = -1;
+		for (int i = 0; i < tokens.count(); ++i) {
+			const int index = sql.indexOf(tokens[i].first, pos);
+			if (index >= 0 && (next < 0 || index < next)) {
+				next = index;
+				token = i;
+			}
+		}
+		if (next < 0) {
+			break;
+		}
+
+		ret += sql.midRef(pos, next - pos);
+		ret += '?';
+		values.append(tokens[token].second);
+		pos = next + tokens[token].first.length();
+	}
+	ret += sql.midRef(pos);
+	return ret;
 }
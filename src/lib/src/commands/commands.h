@@ -1,7 +1,10 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
+#include <QList>
+#include <QPair>
 #include <QString>
+#include <QVariant>
 
 
 struct MysqlSettings
@@ -14,8 +17,10 @@ struct MysqlSettings
 };
 
 
+class CommandRunner;
 class Image;
 class Profile;
+class QThread;
 class SqlWorker;
 class Tag;
 
@@ -30,7 +35,10 @@ class Commands
 		bool tag(const Image &img, const Tag &tag, bool after);
 		bool after() const;
 		bool execute(const QString &command) const;
-		bool sqlExec(const QString &sql) const;
+		bool sqlExec(const QString &sql, const QVariantList &values = QVariantList()) const;
+
+	protected:
+		static QString bindTokens(const QString &sql, const QList<QPair<QString, QVariant>> &tokens, QVariantList &values);
 
 	private:
 		Profile *m_profile;
@@ -38,9 +46,13 @@ class Commands
 		QString m_commandTagBefore;
 		QString m_commandImage;
 		QString m_commandTagAfter;
+		int m_commandTimeout;
+		CommandRunner *m_commandRunner;
 
 		MysqlSettings m_mysqlSettings;
 		SqlWorker *m_sqlWorker;
+		QThread *m_sqlThread;
+		mutable bool m_sqlStarted;
 };
 
 #endif // COMMANDS_H
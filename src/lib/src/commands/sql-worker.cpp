@@ -1,4 +1,5 @@
 #include "commands/sql-worker.h"
+#include <QTimer>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlDriver>
 #include <QtSql/QSqlError>
@@ -7,14 +8,41 @@
 #include <utility>
 #include "logger.h"
 
+#define SQL_BATCH_SIZE 100
+#define SQL_BATCH_DELAY 500
+#define SQL_MAX_PREPARED_QUERIES 32
+
 
 SqlWorker::SqlWorker(QString driver, QString host, QString user, QString password, QString database, QObject *parent)
-	: QThread(parent), m_driver(std::move(driver)), m_host(std::move(host)), m_user(std::move(user)), m_password(std::move(password)), m_database(std::move(database))
+	: QObject(parent), m_driver(std::move(driver)), m_host(std::move(host)), m_user(std::move(user)), m_password(std::move(password)), m_database(std::move(database))
 {
 	m_enabled = (m_driver == QLatin1String("QSQLITE") && !m_database.isEmpty())
 		|| (!m_host.isEmpty() && !m_user.isEmpty() && !m_database.isEmpty());
 
 	m_started = false;
+	m_batchSize = SQL_BATCH_SIZE;
+
+	// The timer being a child of the worker, it follows it when moved to another thread
+	m_flushTimer = new QTimer(this);
+	m_flushTimer->setSingleShot(true);
+	m_flushTimer->setInterval(SQL_BATCH_DELAY);
+	QObject::connect(m_flushTimer, &QTimer::timeout, this, &SqlWorker::flush);
+}
+
+SqlWorker::~SqlWorker()
+{
+	flush();
+}
+
+bool SqlWorker::isEnabled() const
+{
+	return m_enabled;
+}
+
+void SqlWorker::setBatching(int size, int delay)
+{
+	m_batchSize = qMax(1, size);
+	m_flushTimer->setInterval(qMax(0, delay));
 }
 
 bool SqlWorker::connect()
@@ -59,7 +87,7 @@ QString SqlWorker::escape(const QVariant &val)
 	return driver->formatValue(f);
 }
 
-bool SqlWorker::execute(const QString &sql)
+bool SqlWorker::execute(const QString &sql, const QVariantList &values)
 {
 	if (!m_enabled || !connect()) {
 		return false;
@@ -68,6 +96,84 @@ bool SqlWorker::execute(const QString &sql)
 	log(QStringLiteral("SQL execution of \"%1\"").arg(sql));
 	Logger::getInstance().logCommandSql(sql);
 
-	QSqlQuery query(m_db);
-	return query.exec(sql);
+	// Statements without bound values are usually all different, so there is no point in preparing them
+	if (values.isEmpty()) {
+		QSqlQuery query(m_db);
+		if (!query.exec(sql)) {
+			log(QStringLiteral("SQL error: %1").arg(query.lastError().text()), Logger::Error);
+			return false;
+		}
+		return true;
+	}
+
+	auto it = m_queries.find(sql);
+	if (it == m_queries.end()) {
+		QSqlQuery query(m_db);
+		if (!query.prepare(sql)) {
+			log(QStringLiteral("SQL error preparing statement: %1").arg(query.lastError().text()), Logger::Error);
+			return false;
+		}
+		if (m_queries.count() >= SQL_MAX_PREPARED_QUERIES) {
+			m_queries.clear();
+		}
+		it = m_queries.insert(sql, query);
+	}
+
+	QSqlQuery &query = it.value();
+	for (int i = 0; i < values.count(); ++i) {
+		query.bindValue(i, values[i]);
+	}
+	if (!query.exec()) {
+		log(QStringLiteral("SQL error: %1").arg(query.lastError().text()), Logger::Error);
+		return false;
+	}
+	query.finish();
+	return true;
+}
+
+void SqlWorker::queue(const QString &sql, const QVariantList &values)
+{
+	m_pending.append(Statement { sql, values });
+
+	if (m_pending.count() >= m_batchSize) {
+		flush();
+	} else if (!m_flushTimer->isActive()) {
+		m_flushTimer->start();
+	}
+}
+
+void SqlWorker::flush()
+{
+	m_flushTimer->stop();
+	if (m_pending.isEmpty()) {
+		return;
+	}
+
+	const QList<Statement> pending = std::move(m_pending);
+	m_pending.clear();
+	if (!m_enabled || !connect()) {
+		return;
+	}
+
+	// Running all statements in a single transaction saves a round-trip and a disk sync for each of them
+	if (m_db.driver()->hasFeature(QSqlDriver::Transactions) && m_db.transaction()) {
+		bool ok = true;
+		for (const Statement &statement : pending) {
+			if (!execute(statement.sql, statement.values)) {
+				ok = false;
+				break;
+			}
+		}
+		if (ok && m_db.commit()) {
+			return;
+		}
+
+		// Some databases abort the whole transaction on error, so the batch is run again one statement at a time
+		log(QStringLiteral("SQL batch of %1 statements failed, running them separately").arg(pending.count()), Logger::Warning);
+		m_db.rollback();
+	}
+
+	for (const Statement &statement : pending) {
+		execute(statement.sql, statement.values);
+	}
 }
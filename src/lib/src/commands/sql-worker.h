@@ -1,26 +1,47 @@
 #ifndef SQL_WORKER_H
 #define SQL_WORKER_H
 
+#include <QHash>
+#include <QList>
+#include <QObject>
 #include <QString>
-#include <QThread>
+#include <QVariant>
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 
 
-class QVariant;
+class QTimer;
 
-class SqlWorker : public QThread
+/**
+ * Runs the SQL commands, meant to live in its own thread.
+ *
+ * Queued statements are executed in batches in a single transaction, either once enough of them are waiting or
+ * after a short delay. Statements with bound values are prepared once and re-used for the following ones.
+ */
+class SqlWorker : public QObject
 {
 	Q_OBJECT
 
 	public:
 		SqlWorker(QString driver, QString host, QString user, QString password, QString database, QObject *parent = nullptr);
-		bool connect();
+		~SqlWorker() override;
+		bool isEnabled() const;
+		void setBatching(int size, int delay);
 		static QString escape(const QVariant &val);
 
 	public slots:
-		bool execute(const QString &sql);
+		bool connect();
+		bool execute(const QString &sql, const QVariantList &values = QVariantList());
+		void queue(const QString &sql, const QVariantList &values = QVariantList());
+		void flush();
 
 	private:
+		struct Statement
+		{
+			QString sql;
+			QVariantList values;
+		};
+
 		QString m_driver;
 		QString m_host;
 		QString m_user;
@@ -30,6 +51,11 @@ class SqlWorker : public QThread
 		QSqlDatabase m_db;
 		bool m_enabled;
 		bool m_started;
+
+		int m_batchSize;
+		QTimer *m_flushTimer;
+		QList<Statement> m_pending;
+		QHash<QString, QSqlQuery> m_queries;
 };
 
 #endif // SQL_WORKER_H
@@ -17,22 +17,62 @@ void ConcurrentMultiQueue::setGlobalConcurrency(int globalConcurrency)
 	m_globalConcurrency = globalConcurrency;
 }
 
+/**
+ * The maximum number of items of a given key handled at the same time, 0 meaning only the global limit applies.
+ */
+int ConcurrentMultiQueue::keyConcurrency(const QString &key) const
+{
+	return m_keyConcurrencies.value(key, m_keyConcurrency);
+}
 
-void ConcurrentMultiQueue::append(int queue, QVariant item)
+void ConcurrentMultiQueue::setKeyConcurrency(int keyConcurrency)
+{
+	m_keyConcurrency = keyConcurrency;
+}
+
+void ConcurrentMultiQueue::setKeyConcurrency(const QString &key, int keyConcurrency)
+{
+	const int previous = this->keyConcurrency(key);
+	m_keyConcurrencies.insert(key, keyConcurrency);
+
+	// A higher limit can allow waiting items to start right away
+	if (keyConcurrency != previous) {
+		schedule();
+	}
+}
+
+
+void ConcurrentMultiQueue::append(int queue, QVariant item, const QString &key)
 {
 	if (queue >= m_queues.count()) {
 		m_queues.resize(queue + 1);
 	}
 
-	m_queues[queue].append(item);
+	KeyedQueue &keyedQueue = m_queues[queue];
+	auto it = keyedQueue.items.find(key);
+	if (it == keyedQueue.items.end()) {
+		it = keyedQueue.items.insert(key, QQueue<QVariant>());
+		keyedQueue.keys.append(key);
+	}
+	it->append(item);
 
-	if (m_activeWorkers.loadRelaxed() < m_globalConcurrency) {
-		m_activeWorkers.fetchAndAddRelaxed(1);
-		next();
+	schedule();
+}
+
+void ConcurrentMultiQueue::next(const QString &key)
+{
+	m_activeWorkers.fetchAndAddRelaxed(-1);
+	const int keyActiveWorkers = m_keyActiveWorkers.value(key) - 1;
+	if (keyActiveWorkers > 0) {
+		m_keyActiveWorkers.insert(key, keyActiveWorkers);
+	} else {
+		m_keyActiveWorkers.remove(key);
 	}
+
+	schedule();
 }
 
-void ConcurrentMultiQueue::next()
+void ConcurrentMultiQueue::schedule()
 {
 	// Avoid a stack overflow if the call to "dequeue" directly calls "next"
 	QTimer::singleShot(0, this, SLOT(nextInternal()));
@@ -40,19 +80,50 @@ void ConcurrentMultiQueue::next()
 
 void ConcurrentMultiQueue::nextInternal()
 {
-	int index = 0;
-	while (index < m_queues.count() && m_queues[index].isEmpty()) {
-		index++;
+	// Start as many workers as possible
+	QVariant next;
+	QString key;
+	while (m_activeWorkers.loadRelaxed() < m_globalConcurrency && dequeue(next, key)) {
+		m_activeWorkers.fetchAndAddRelaxed(1);
+		m_keyActiveWorkers[key]++;
+		m_running = true;
+		emit dequeued(next);
+	}
+
+	// Nothing left to do, either in the queues or in the workers
+	if (m_running && m_activeWorkers.loadRelaxed() == 0) {
+		m_running = false;
+		emit finished();
 	}
+}
+
+/**
+ * Get the next item from the highest priority queue, rotating between its keys and skipping the ones at capacity.
+ */
+bool ConcurrentMultiQueue::dequeue(QVariant &item, QString &key)
+{
+	for (KeyedQueue &keyedQueue : m_queues) {
+		for (int i = 0; i < keyedQueue.keys.count(); ++i) {
+			const QString &candidate = keyedQueue.keys[i];
+			const int limit = keyConcurrency(candidate);
+			if (limit > 0 && m_keyActiveWorkers.value(candidate) >= limit) {
+				continue;
+			}
+
+			key = candidate;
+			keyedQueue.keys.removeAt(i);
+
+			QQueue<QVariant> &items = keyedQueue.items[key];
+			item = items.dequeue();
+			if (items.isEmpty()) {
+				keyedQueue.items.remove(key);
+			} else {
+				keyedQueue.keys.append(key);
+			}
 
-	if (index >= m_queues.count()) {
-		int activeWorkers = m_activeWorkers.fetchAndAddRelaxed(-1);
-		if (activeWorkers == 1) { // Compare to 1 because the returned value is the one BEFORE the modification
-			emit finished();
+			return true;
 		}
-		return;
 	}
 
-	QVariant next = m_queues[index].dequeue();
-	emit dequeued(next);
+	return false;
 }
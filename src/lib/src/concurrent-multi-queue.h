@@ -2,11 +2,21 @@
 #define CONCURRENT_MULTI_QUEUE_H
 
 #include <QAtomicInt>
+#include <QHash>
 #include <QQueue>
+#include <QString>
+#include <QStringList>
 #include <QVariant>
 #include <QVector>
 
 
+/**
+ * Set of prioritized queues, dequeued by a limited number of concurrent workers.
+ *
+ * Inside each queue, items are split into sub-queues by key (i.e. the host they are downloaded from), which are
+ * dequeued in a round-robin fashion. Each key can also have its own concurrency limit, in which case workers skip
+ * its items until one of them is done.
+ */
 class ConcurrentMultiQueue : public QObject
 {
 	Q_OBJECT
@@ -15,21 +25,41 @@ class ConcurrentMultiQueue : public QObject
 		ConcurrentMultiQueue(QObject *parent = nullptr);
 		int globalConcurrency() const;
 		void setGlobalConcurrency(int globalConcurrency);
-		void append(int queue, QVariant item);
+		int keyConcurrency(const QString &key = {}) const;
+		void setKeyConcurrency(int keyConcurrency);
+		void setKeyConcurrency(const QString &key, int keyConcurrency);
+		void append(int queue, QVariant item, const QString &key = {});
 
 	public slots:
-		void next();
+		/**
+		 * Signal that the worker handling an item of the given key is done, and can handle the next item.
+		 */
+		void next(const QString &key = {});
 
 	protected slots:
 		void nextInternal();
 
+	protected:
+		struct KeyedQueue
+		{
+			QHash<QString, QQueue<QVariant>> items;
+			QStringList keys; // Round-robin order, the next key to dequeue being first
+		};
+
+		void schedule();
+		bool dequeue(QVariant &item, QString &key);
+
 	signals:
 		void dequeued(QVariant next);
 		void finished();
 
 	private:
 		int m_globalConcurrency = 1;
-		QVector<QQueue<QVariant>> m_queues;
+		int m_keyConcurrency = 0;
+		QHash<QString, int> m_keyConcurrencies;
+		QVector<KeyedQueue> m_queues;
+		QHash<QString, int> m_keyActiveWorkers;
+		bool m_running = false;
 
 		QAtomicInt m_activeWorkers;
 };
@@ -2,13 +2,23 @@
 #include <QDebug>
 #include <QFile>
 #include <QNetworkCookie>
-#include <QNetworkCookieJar>
 #include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QSslConfiguration>
+#include <QUrl>
 #include "functions.h"
 #include "logger.h"
+#include "network/network-archive.h"
 #include "vendor/qcustomnetworkreply.h"
 
 QQueue<QString> CustomNetworkAccessManager::NextFiles;
+int CustomNetworkAccessManager::TestLatency = 0;
+
+
+static int testDelay()
+{
+	return CustomNetworkAccessManager::TestLatency > 0 ? QRandomGenerator::global()->bounded(CustomNetworkAccessManager::TestLatency + 1) : 0;
+}
 
 
 CustomNetworkAccessManager::CustomNetworkAccessManager(QObject *parent)
@@ -20,6 +30,7 @@ CustomNetworkAccessManager::CustomNetworkAccessManager(QObject *parent)
 QNetworkReply *CustomNetworkAccessManager::makeErrorReply(const QNetworkRequest &request, const QString &code)
 {
 	auto *reply = new QCustomNetworkReply(this);
+	reply->setDelay(testDelay());
 
 	if (code != QLatin1String("cookie")) {
 		reply->setUrl(request.url());
@@ -29,7 +40,7 @@ QNetworkReply *CustomNetworkAccessManager::makeErrorReply(const QNetworkRequest
 		reply->setHttpStatusCode(404, "Not Found");
 		reply->setNetworkError(QNetworkReply::ContentNotFoundError, QStringLiteral("Not Found"));
 	} else if (code == QLatin1String("cookie")) {
-		cookieJar()->insertCookie(QNetworkCookie("test_cookie", "test_value"));
+		reply->setHeader(QNetworkRequest::SetCookieHeader, QVariant::fromValue(QList<QNetworkCookie> { QNetworkCookie("test_cookie", "test_value") }));
 		reply->setHttpStatusCode(200, "OK");
 	} else if (code == QLatin1String("redirect")) {
 		reply->setAttribute(QNetworkRequest::RedirectionTargetAttribute, QUrl("https://www.test-redirect.com"));
@@ -97,6 +108,7 @@ QNetworkReply *CustomNetworkAccessManager::makeTestReply(const QNetworkRequest &
 	const QByteArray content = f.readAll();
 
 	auto *reply = new QCustomNetworkReply(this);
+	reply->setDelay(testDelay());
 	reply->setUrl(request.url());
 	reply->setHttpStatusCode(200, "OK");
 	reply->setContentType("text/html");
@@ -105,14 +117,43 @@ QNetworkReply *CustomNetworkAccessManager::makeTestReply(const QNetworkRequest &
 	return reply;
 }
 
+/**
+ * Replay a response from the network archive, or a 404 error if it was not recorded.
+ */
+QNetworkReply *CustomNetworkAccessManager::makeArchiveReply(const QNetworkRequest &request, const QByteArray &method)
+{
+	NetworkArchive::Response response;
+	if (!NetworkArchive::getInstance().find(method, request.url(), &response)) {
+		log(QStringLiteral("No recorded response for `%1`").arg(request.url().toString().toHtmlEscaped()), Logger::Warning);
+		return makeErrorReply(request, "404");
+	}
+
+	auto *reply = new QCustomNetworkReply(this);
+	reply->setUrl(request.url());
+	reply->setHttpStatusCode(response.statusCode, response.reasonPhrase);
+	if (response.statusCode >= 400) {
+		reply->setNetworkError(response.statusCode == 404 ? QNetworkReply::ContentNotFoundError : QNetworkReply::UnknownContentError, QString(response.reasonPhrase));
+	}
+	if (!response.redirection.isEmpty()) {
+		reply->setAttribute(QNetworkRequest::RedirectionTargetAttribute, response.redirection);
+	}
+	reply->setContentType(response.contentType);
+	reply->setContent(response.content);
+
+	return reply;
+}
+
 QNetworkReply *CustomNetworkAccessManager::get(const QNetworkRequest &request)
 {
 	if (isTestModeEnabled()) {
 		return makeTestReply(request);
 	}
+	if (NetworkArchive::getInstance().isReplaying()) {
+		return makeArchiveReply(request, "GET");
+	}
 
 	log(QStringLiteral("Loading `%1`").arg(request.url().toString().toHtmlEscaped()), Logger::Debug);
-	return QNetworkAccessManager::get(request);
+	return QNetworkAccessManager::get(allowHttp2(request));
 }
 
 QNetworkReply *CustomNetworkAccessManager::post(const QNetworkRequest &request, const QByteArray &data)
@@ -120,9 +161,53 @@ QNetworkReply *CustomNetworkAccessManager::post(const QNetworkRequest &request,
 	if (isTestModeEnabled()) {
 		return makeTestReply(request);
 	}
+	if (NetworkArchive::getInstance().isReplaying()) {
+		return makeArchiveReply(request, "POST");
+	}
 
 	log(QStringLiteral("Posting to `%1`").arg(request.url().toString().toHtmlEscaped()), Logger::Debug);
-	return QNetworkAccessManager::post(request, data);
+	return QNetworkAccessManager::post(allowHttp2(request), data);
+}
+
+/**
+ * Open a connection to the host of an URL ahead of time, so that the first request to it can skip the DNS lookup
+ * and the TCP and TLS handshakes. HTTP/2 is offered like for actual requests, so that they can use that connection.
+ */
+void CustomNetworkAccessManager::preconnect(const QUrl &url)
+{
+	if (isTestModeEnabled() || NetworkArchive::getInstance().isReplaying()) {
+		return;
+	}
+
+	if (url.scheme() == QLatin1String("https")) {
+		QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+		config.setAllowedNextProtocols({ QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1 });
+		connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)), config);
+	} else if (url.scheme() == QLatin1String("http")) {
+		connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+	}
+}
+
+/**
+ * Allow HTTP/2 by default, so that requests to the same host are multiplexed on a single connection.
+ * Qt falls back to HTTP/1.1 if the server does not support it.
+ *
+ * @param request The original request
+ * @return The request, with HTTP/2 allowed unless it was explicitly disabled
+ */
+QNetworkRequest CustomNetworkAccessManager::allowHttp2(const QNetworkRequest &request)
+{
+	#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+		const auto attribute = QNetworkRequest::Http2AllowedAttribute;
+	#else
+		const auto attribute = QNetworkRequest::HTTP2AllowedAttribute;
+	#endif
+
+	QNetworkRequest req(request);
+	if (!req.attribute(attribute).isValid()) {
+		req.setAttribute(attribute, true);
+	}
+	return req;
 }
 
 /**
@@ -2,13 +2,14 @@
 #define CUSTOMNETWORKACCESSMANAGER_H
 
 #include <QNetworkAccessManager>
+#include <QNetworkRequest>
 #include <QQueue>
 #include <QString>
 
 
 class QNetworkReply;
-class QNetworkRequest;
 class QSslError;
+class QUrl;
 
 class CustomNetworkAccessManager : public QNetworkAccessManager
 {
@@ -18,13 +19,21 @@ class CustomNetworkAccessManager : public QNetworkAccessManager
 		explicit CustomNetworkAccessManager(QObject *parent = nullptr);
 		QNetworkReply *get(const QNetworkRequest &request);
 		QNetworkReply *post(const QNetworkRequest &request, const QByteArray &data);
+		void preconnect(const QUrl &url);
 		void sslErrorHandler(QNetworkReply *reply, const QList<QSslError> &errors);
 
 		static QQueue<QString> NextFiles;
 
+		/**
+		 * Maximum random delay before test replies finish, in milliseconds, to simulate a real network in stress tests.
+		 */
+		static int TestLatency;
+
 	protected:
+		static QNetworkRequest allowHttp2(const QNetworkRequest &request);
 		QNetworkReply *makeErrorReply(const QNetworkRequest &request, const QString &code = QString());
 		QNetworkReply *makeTestReply(const QNetworkRequest &request);
+		QNetworkReply *makeArchiveReply(const QNetworkRequest &request, const QByteArray &method);
 };
 
 #endif // CUSTOMNETWORKACCESSMANAGER_H
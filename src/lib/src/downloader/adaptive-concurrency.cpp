@@ -0,0 +1,115 @@
+#include "downloader/adaptive-concurrency.h"
+#include "logger.h"
+
+#define MIN_WINDOW 4
+#define MAX_ERROR_RATE 0.25
+#define MAX_LATENCY_FACTOR 3
+#define THROUGHPUT_TOLERANCE 0.05
+
+
+AdaptiveConcurrency::AdaptiveConcurrency(int minConcurrency, int maxConcurrency, QObject *parent)
+	: QObject(parent), m_minConcurrency(qMax(1, minConcurrency)), m_maxConcurrency(qMax(m_minConcurrency, maxConcurrency))
+{
+	m_clock.start();
+}
+
+int AdaptiveConcurrency::minConcurrency() const
+{
+	return m_minConcurrency;
+}
+
+int AdaptiveConcurrency::maxConcurrency() const
+{
+	return m_maxConcurrency;
+}
+
+int AdaptiveConcurrency::concurrency(const QString &key) const
+{
+	auto it = m_hosts.constFind(key);
+	return it != m_hosts.constEnd() ? it->concurrency : m_minConcurrency;
+}
+
+QHash<QString, int> AdaptiveConcurrency::concurrencies() const
+{
+	QHash<QString, int> ret;
+	for (auto it = m_hosts.constBegin(); it != m_hosts.constEnd(); ++it) {
+		ret.insert(it.key(), it->concurrency);
+	}
+	return ret;
+}
+
+
+void AdaptiveConcurrency::addResult(const QString &key, bool success, qint64 bytes, qint64 latency, qint64 now)
+{
+	if (now < 0) {
+		now = m_clock.elapsed();
+	}
+
+	auto it = m_hosts.find(key);
+	if (it == m_hosts.end()) {
+		Host host;
+		host.concurrency = m_minConcurrency;
+		it = m_hosts.insert(key, host);
+	}
+	Host &host = it.value();
+
+	host.errorRate.addValue(success ? 0 : 1);
+	if (success) {
+		const double slotLatency = static_cast<double>(latency) / host.concurrency;
+		host.latency.addValue(slotLatency);
+		if (host.minLatency < 0 || slotLatency < host.minLatency) {
+			host.minLatency = slotLatency;
+		}
+	}
+
+	// Windows follow each other, unless nothing was downloaded for a while
+	if (host.windowCount == 0) {
+		host.windowStart = qMax(host.windowStart, now - latency);
+	}
+	host.windowCount++;
+	host.windowBytes += bytes;
+
+	// Only take a decision once every slot was used, to not react to a single download
+	if (host.windowCount < qMax(host.concurrency, MIN_WINDOW)) {
+		return;
+	}
+
+	const double throughput = host.windowBytes * 1000.0 / qMax<qint64>(1, now - host.windowStart);
+	host.windowStart = now;
+	host.windowCount = 0;
+	host.windowBytes = 0;
+
+	const bool tooManyErrors = host.errorRate.average() > MAX_ERROR_RATE;
+	const bool tooSlow = host.minLatency > 0 && host.latency.average() > MAX_LATENCY_FACTOR * host.minLatency;
+	if (tooManyErrors || tooSlow) {
+		// Multiplicative decrease, and start measuring again from there
+		setConcurrency(key, host, host.concurrency / 2, throughput);
+		host.errorRate.clear();
+		host.latency.clear();
+		host.increased = false;
+	} else if (host.windows == 0 || throughput >= host.throughput.average() * (1 - THROUGHPUT_TOLERANCE)) {
+		// Additive increase as long as the throughput doesn't get worse
+		host.increased = host.concurrency < m_maxConcurrency;
+		setConcurrency(key, host, host.concurrency + 1, throughput);
+	} else if (host.increased) {
+		// The last increase made things worse, so we go back
+		host.increased = false;
+		setConcurrency(key, host, host.concurrency - 1, throughput);
+	}
+
+	host.throughput.addValue(throughput);
+	host.windows++;
+}
+
+void AdaptiveConcurrency::setConcurrency(const QString &key, Host &host, int concurrency, double throughput)
+{
+	concurrency = qBound(m_minConcurrency, concurrency, m_maxConcurrency);
+	if (concurrency == host.concurrency) {
+		return;
+	}
+
+	log(QStringLiteral("Simultaneous downloads for `%1` changed from %2 to %3 (%4 KB/s, %5% errors, %6 ms)").arg(key).arg(host.concurrency).arg(concurrency).arg(qRound(throughput / 1024)).arg(qRound(host.errorRate.average() * 100)).arg(qRound(host.latency.average())), Logger::Info);
+
+	host.concurrency = concurrency;
+	emit concurrencyChanged(key, concurrency);
+}
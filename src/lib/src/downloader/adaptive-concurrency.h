@@ -0,0 +1,69 @@
+#ifndef ADAPTIVE_CONCURRENCY_H
+#define ADAPTIVE_CONCURRENCY_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include "exponential-moving-average.h"
+
+
+/**
+ * Finds the best number of simultaneous downloads for each host, using an AIMD strategy.
+ *
+ * Every time as many downloads as allowed finished for a host, the throughput of that window is compared to the
+ * previous ones: the limit is increased by one as long as it gets better, and halved when errors or latency go up.
+ */
+class AdaptiveConcurrency : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit AdaptiveConcurrency(int minConcurrency, int maxConcurrency, QObject *parent = nullptr);
+		int minConcurrency() const;
+		int maxConcurrency() const;
+
+		int concurrency(const QString &key) const;
+		QHash<QString, int> concurrencies() const;
+
+		/**
+		 * Record the result of a download.
+		 *
+		 * @param key The host the download was made from.
+		 * @param success Whether the download succeeded, or failed because of the host (network or server error).
+		 * @param bytes The number of bytes received.
+		 * @param latency The time the download took, in milliseconds.
+		 * @param now A monotonic timestamp in milliseconds, -1 to use the internal clock.
+		 */
+		void addResult(const QString &key, bool success, qint64 bytes, qint64 latency, qint64 now = -1);
+
+	signals:
+		void concurrencyChanged(const QString &key, int concurrency);
+
+	protected:
+		struct Host
+		{
+			int concurrency = 1;
+			ExponentialMovingAverage errorRate { 0.1 };
+			ExponentialMovingAverage latency { 0.2 }; // Per slot, so that sharing the bandwidth doesn't count as slower
+			ExponentialMovingAverage throughput { 0.5 };
+			double minLatency = -1;
+			int windows = 0;
+			bool increased = false;
+
+			// Current window
+			qint64 windowStart = -1;
+			int windowCount = 0;
+			qint64 windowBytes = 0;
+		};
+
+		void setConcurrency(const QString &key, Host &host, int concurrency, double throughput);
+
+	private:
+		int m_minConcurrency;
+		int m_maxConcurrency;
+		QHash<QString, Host> m_hosts;
+		QElapsedTimer m_clock;
+};
+
+#endif // ADAPTIVE_CONCURRENCY_H
@@ -0,0 +1,264 @@
+#include "downloader/batch-coordinator.h"
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "downloader/download-query-group.h"
+#include "logger.h"
+
+#define MAX_LEASE_ATTEMPTS 3
+
+
+BatchCoordinator::BatchCoordinator(int leaseTimeout, QObject *parent)
+	: QObject(parent), m_leaseTimeout(leaseTimeout), m_checkTimer(this)
+{
+	m_server = new QTcpServer(this);
+	connect(m_server, &QTcpServer::newConnection, this, &BatchCoordinator::newConnection);
+
+	m_checkTimer.setInterval(qMax(1000, m_leaseTimeout / 4));
+	connect(&m_checkTimer, &QTimer::timeout, this, &BatchCoordinator::checkLeases);
+	m_checkTimer.start();
+}
+
+void BatchCoordinator::addGroup(const DownloadQueryGroup &group, int pagesPerLease)
+{
+	QJsonObject json;
+	group.write(json, false);
+
+	Lease lease;
+	if (pagesPerLease <= 0 || group.total < 0 || !group.postFiltering.isEmpty()) {
+		lease.id = m_leases.count();
+		lease.group = json;
+		lease.total = qMax(0, group.total);
+		m_leases.append(lease);
+		return;
+	}
+
+	const int imagesPerLease = pagesPerLease * group.perpage;
+	for (int start = 0; start < group.total; start += imagesPerLease) {
+		lease.id = m_leases.count();
+		lease.group = json;
+		lease.group["page"] = group.page + start / group.perpage;
+		lease.total = qMin(imagesPerLease, group.total - start);
+		lease.group["total"] = lease.total;
+		m_leases.append(lease);
+	}
+}
+
+bool BatchCoordinator::listen(const QHostAddress &address, quint16 port)
+{
+	if (!m_server->listen(address, port)) {
+		log(QStringLiteral("Could not start the coordinator on port %1: %2").arg(port).arg(m_server->errorString()), Logger::Error);
+		return false;
+	}
+
+	log(QStringLiteral("Coordinator listening on port %1 with %2 leases").arg(m_server->serverPort()).arg(m_leases.count()), Logger::Info);
+	return true;
+}
+
+quint16 BatchCoordinator::serverPort() const
+{
+	return m_server->serverPort();
+}
+
+const QList<BatchCoordinator::Lease> &BatchCoordinator::leases() const
+{
+	return m_leases;
+}
+
+bool BatchCoordinator::isFinished() const
+{
+	for (const Lease &lease : m_leases) {
+		if (lease.state == Pending || lease.state == Running) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void BatchCoordinator::newConnection()
+{
+	while (m_server->hasPendingConnections()) {
+		QTcpSocket *socket = m_server->nextPendingConnection();
+		m_workers.insert(socket, QStringLiteral("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort()));
+		connect(socket, &QTcpSocket::readyRead, this, &BatchCoordinator::readyRead);
+		connect(socket, &QTcpSocket::disconnected, this, &BatchCoordinator::disconnected);
+	}
+}
+
+void BatchCoordinator::readyRead()
+{
+	auto *socket = qobject_cast<QTcpSocket*>(sender());
+	const QString worker = m_workers.value(socket);
+
+	while (socket->canReadLine()) {
+		const QByteArray line = socket->readLine().trimmed();
+		if (line.isEmpty()) {
+			continue;
+		}
+
+		QJsonObject response;
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+			response = QJsonObject { { "type", "error" }, { "error", "Invalid message: " + error.errorString() } };
+		} else {
+			response = handleMessage(worker, doc.object());
+		}
+
+		if (!response.isEmpty()) {
+			socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + "\n");
+		}
+	}
+}
+
+void BatchCoordinator::disconnected()
+{
+	auto *socket = qobject_cast<QTcpSocket*>(sender());
+
+	releaseWorker(m_workers.take(socket));
+	socket->deleteLater();
+}
+
+
+QJsonObject BatchCoordinator::handleMessage(const QString &worker, const QJsonObject &message)
+{
+	const QString type = message.value("type").toString();
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+	if (type == QLatin1String("status")) {
+		return status();
+	}
+
+	if (type == QLatin1String("lease")) {
+		for (Lease &lease : m_leases) {
+			if (lease.state == Pending) {
+				lease.state = Running;
+				lease.worker = worker;
+				lease.lastHeartbeat = now;
+				lease.attempts++;
+				lease.done = 0;
+
+				log(QStringLiteral("Lease %1 given to worker %2 (attempt %3)").arg(lease.id).arg(worker).arg(lease.attempts), Logger::Info);
+				return QJsonObject { { "type", "lease" }, { "lease", lease.id }, { "group", lease.group } };
+			}
+		}
+		return QJsonObject { { "type", isFinished() ? "finished" : "wait" } };
+	}
+
+	// Other messages are about a lease held by the worker
+	const int id = message.value("lease").toInt(-1);
+	if (id < 0 || id >= m_leases.count() || m_leases[id].state != Running || m_leases[id].worker != worker) {
+		return QJsonObject { { "type", "cancel" }, { "lease", id } };
+	}
+
+	Lease &lease = m_leases[id];
+	lease.lastHeartbeat = now;
+	lease.done = message.value("done").toInt(lease.done);
+	if (message.value("total").toInt() > 0) {
+		lease.total = message.value("total").toInt();
+	}
+
+	if (type == QLatin1String("heartbeat")) {
+		updateProgress();
+		return {};
+	}
+	if (type == QLatin1String("done")) {
+		lease.state = Done;
+		lease.worker.clear();
+		log(QStringLiteral("Lease %1 finished by worker %2 (%3 images)").arg(id).arg(worker).arg(lease.done), Logger::Info);
+		updateProgress();
+		return {};
+	}
+	if (type == QLatin1String("failed")) {
+		requeue(lease, message.value("error").toString());
+		return {};
+	}
+
+	return QJsonObject { { "type", "error" }, { "error", "Unknown message type: " + type } };
+}
+
+void BatchCoordinator::checkLeases()
+{
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	for (Lease &lease : m_leases) {
+		if (lease.state == Running && now - lease.lastHeartbeat > m_leaseTimeout) {
+			requeue(lease, QStringLiteral("no heartbeat from worker %1").arg(lease.worker));
+		}
+	}
+}
+
+void BatchCoordinator::releaseWorker(const QString &worker)
+{
+	for (Lease &lease : m_leases) {
+		if (lease.state == Running && lease.worker == worker) {
+			requeue(lease, QStringLiteral("worker %1 disconnected").arg(worker));
+		}
+	}
+}
+
+void BatchCoordinator::requeue(Lease &lease, const QString &reason)
+{
+	lease.worker.clear();
+	lease.done = 0;
+
+	if (lease.attempts >= MAX_LEASE_ATTEMPTS) {
+		lease.state = Failed;
+		log(QStringLiteral("Lease %1 failed %2 times, giving up: %3").arg(lease.id).arg(lease.attempts).arg(reason), Logger::Error);
+	} else {
+		lease.state = Pending;
+		log(QStringLiteral("Lease %1 will be given to another worker: %2").arg(lease.id).arg(reason), Logger::Warning);
+	}
+
+	updateProgress();
+}
+
+void BatchCoordinator::updateProgress()
+{
+	int done = 0;
+	int total = 0;
+	for (const Lease &lease : qAsConst(m_leases)) {
+		done += lease.done;
+		total += lease.total;
+	}
+	emit progress(done, total);
+
+	if (!m_finishedEmitted && isFinished()) {
+		m_finishedEmitted = true;
+
+		// Let the workers waiting for a lease stop as well
+		const QByteArray message = QJsonDocument(QJsonObject { { "type", "finished" } }).toJson(QJsonDocument::Compact) + "\n";
+		for (auto it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+			it.key()->write(message);
+			it.key()->flush();
+		}
+
+		emit finished();
+	}
+}
+
+QJsonObject BatchCoordinator::status() const
+{
+	int counts[4] = { 0, 0, 0, 0 };
+	int done = 0;
+	int total = 0;
+	for (const Lease &lease : m_leases) {
+		counts[lease.state]++;
+		done += lease.done;
+		total += lease.total;
+	}
+
+	return QJsonObject {
+		{ "type", "status" },
+		{ "leases", m_leases.count() },
+		{ "pending", counts[Pending] },
+		{ "running", counts[Running] },
+		{ "done", counts[Done] },
+		{ "failed", counts[Failed] },
+		{ "images", done },
+		{ "total", total },
+		{ "workers", m_workers.count() },
+	};
+}
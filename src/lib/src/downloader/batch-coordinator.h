@@ -0,0 +1,96 @@
+#ifndef BATCH_COORDINATOR_H
+#define BATCH_COORDINATOR_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+
+class DownloadQueryGroup;
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * Distributes batch downloads to workers running on other instances, so that they can be spread across machines.
+ *
+ * Groups are split into leases, either whole or by page ranges, given to the workers connecting to the coordinator.
+ * Workers send one JSON object per line with a "type":
+ *   - "lease" to get a new lease, answered by a "lease" (with its "lease" ID and "group"), "wait" or "finished" message.
+ *   - "heartbeat" with the "lease" ID and its "done" and "total" counts, to report progress.
+ *   - "done" or "failed" once a lease is finished.
+ *   - "status" to get the aggregated progress of the whole batch.
+ * Leases whose worker disconnects or stops sending heartbeats are given to another worker. Messages about a lease
+ * that the worker does not hold anymore are answered by a "cancel" message.
+ */
+class BatchCoordinator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		enum LeaseState
+		{
+			Pending,
+			Running,
+			Done,
+			Failed,
+		};
+
+		struct Lease
+		{
+			int id = 0;
+			QJsonObject group;
+			LeaseState state = Pending;
+			QString worker;
+			qint64 lastHeartbeat = 0;
+			int attempts = 0;
+			int done = 0;
+			int total = 0;
+		};
+
+		explicit BatchCoordinator(int leaseTimeout = 60000, QObject *parent = nullptr);
+
+		/**
+		 * Add a group to distribute, split in leases of the given number of pages (0 to keep it whole).
+		 * Groups with no total or with post-filtering are always kept whole, as their pages don't map to image counts.
+		 */
+		void addGroup(const DownloadQueryGroup &group, int pagesPerLease = 0);
+
+		bool listen(const QHostAddress &address, quint16 port);
+		quint16 serverPort() const;
+
+		QJsonObject handleMessage(const QString &worker, const QJsonObject &message);
+		QJsonObject status() const;
+		const QList<Lease> &leases() const;
+		bool isFinished() const;
+
+	public slots:
+		void checkLeases();
+		void releaseWorker(const QString &worker);
+
+	protected slots:
+		void newConnection();
+		void readyRead();
+		void disconnected();
+
+	protected:
+		void requeue(Lease &lease, const QString &reason);
+		void updateProgress();
+
+	signals:
+		void progress(int done, int total);
+		void finished();
+
+	private:
+		int m_leaseTimeout;
+		QTimer m_checkTimer;
+		QTcpServer *m_server;
+		QHash<QTcpSocket*, QString> m_workers;
+		QList<Lease> m_leases;
+		bool m_finishedEmitted = false;
+};
+
+#endif // BATCH_COORDINATOR_H
@@ -1,19 +1,90 @@
 #include "batch-downloader.h"
 #include <QCoreApplication>
+#include <QFile>
 #include <QSettings>
 #include <QTimer>
+#include <QtConcurrentMap>
 #include "commands/commands.h"
+#include "downloader/details-batcher.h"
 #include "downloader/download-query-group.h"
 #include "downloader/download-query-image.h"
 #include "downloader/image-downloader.h"
+#include "downloader/progress-aggregator.h"
+#include "functions.h"
 #include "loader/pack-loader.h"
+#include "logger.h"
+#include "login/session-manager.h"
+#include "models/api/api.h"
+#include "models/filename.h"
+#include "models/filtering/blacklist.h"
 #include "models/profile.h"
 #include "models/site.h"
+#include "utils/directory-index.h"
+
+
+/**
+ * Resolve the filenames of an image and check whether they already exist on disk.
+ * Only uses thread-safe operations, as it is run in worker threads.
+ */
+struct PreResolver
+{
+	typedef BatchDownloader::PreResolvedImage result_type;
+
+	Profile *profile;
+	Filename filename;
+	QString folder;
+	const Blacklist *blacklist;
+	QSharedPointer<DirectoryIndex> directoryIndex;
+
+	result_type operator()(const result_type &input) const
+	{
+		result_type item = input;
+		const QSharedPointer<Image> &img = item.image;
+
+		// If we need a temporary file or have no path at all, we let the image downloader handle it
+		item.paths = img->paths(filename, folder, item.count);
+		if (item.paths.isEmpty() || filename.needTemporaryFile(img->tokens(profile))) {
+			item.paths.clear();
+			return item;
+		}
+
+		// Check if the image is blacklisted
+		if (blacklist != nullptr) {
+			item.detected = blacklist->match(img->tokens(profile));
+			if (!item.detected.isEmpty()) {
+				item.result = Image::SaveResult::Blacklisted;
+				return item;
+			}
+		}
+
+		// Check if the destination files already exist
+		for (const QString &path : qAsConst(item.paths)) {
+			const bool exists = !directoryIndex.isNull() ? directoryIndex->exists(path) : QFile::exists(path);
+			if (!exists) {
+				return item;
+			}
+		}
+
+		// Existing files are added to the MD5 database, so we compute their hash here too
+		item.result = Image::SaveResult::AlreadyExistsDisk;
+		for (const QString &path : qAsConst(item.paths)) {
+			item.md5s.append(getFileMd5(path));
+		}
+		return item;
+	}
+};
 
 
 BatchDownloader::BatchDownloader(DownloadQuery *query, Profile *profile, QObject *parent)
 	: QObject(parent), m_query(query), m_profile(profile), m_settings(profile->getSettings()), m_step(BatchDownloadStep::NotStarted)
-{}
+{
+	// Progress is reported at a fixed rate instead of on every network chunk
+	m_progressAggregator = new ProgressAggregator(m_settings->value("progress_interval", 100).toInt(), this);
+	connect(m_progressAggregator, &ProgressAggregator::imageProgress, this, &BatchDownloader::imageDownloadProgress);
+
+	m_sessionManager = new SessionManager(this);
+	connect(m_sessionManager, &SessionManager::finished, this, &BatchDownloader::loginFinished);
+}
 
 
 void BatchDownloader::setCurrentStep(BatchDownloadStep step)
@@ -53,11 +124,19 @@ void BatchDownloader::start()
 	// Resume download
 	if (m_step == BatchDownloadStep::Aborted) {
 		if (!m_imageDownloaders.isEmpty()) {
-			setCurrentStep(BatchDownloadStep::ImageDownload);
-			for (auto it = m_imageDownloaders.constBegin(); it != m_imageDownloaders.constEnd(); ++it) {
-				it.value()->save();
+			// Restart the interrupted downloads, and replace the ones that stopped in the meantime
+			const QList<ImageDownloader*> downloaders = m_imageDownloaders.values();
+			nextImages();
+			for (ImageDownloader *downloader : downloaders) {
+				downloader->save();
 			}
 			return;
+		} else if (m_preResolveWatcher != nullptr) {
+			setCurrentStep(BatchDownloadStep::PageDownload);
+			return;
+		} else if (!m_pendingDownloads.isEmpty()) {
+			nextImages();
+			return;
 		} else if (m_packLoader != nullptr) {
 			nextPack();
 			return;
@@ -97,21 +176,26 @@ void BatchDownloader::login()
 {
 	setCurrentStep(BatchDownloadStep::Login);
 
-	Site *site = m_query->site;
-	connect(site, &Site::loggedIn, this, &BatchDownloader::loginFinished, Qt::QueuedConnection);
-	site->login();
+	// Sites with a still valid session are not logged in again
+	m_sessionManager->login({ m_query->site });
 }
 
 void BatchDownloader::loginFinished()
 {
-	disconnect(m_query->site, &Site::loggedIn, this, &BatchDownloader::loginFinished);
-
 	auto *group = dynamic_cast<DownloadQueryGroup*>(m_query);
 	if (group != nullptr) {
 		bool usePacking = m_settings->value("packing_enable", true).toBool();
 		int imagesPerPack = m_settings->value("packing_size", 1000).toInt();
+		// Existence checks can be answered from a single scan of the destination, useful for network drives
+		if (m_settings->value("Save/directoryIndex", false).toBool() && !m_query->path.isEmpty()) {
+			m_directoryIndex = QSharedPointer<DirectoryIndex>::create(m_query->path);
+		}
+
 		m_packLoader = new PackLoader(m_profile, *group, usePacking ? imagesPerPack : -1, this);
-		m_packLoader->start();
+		m_packLoader->setPrefetch(m_settings->value("packing_prefetch", 1).toInt(), m_settings->value("packing_prefetch_images", 1000).toInt());
+		m_packLoader->setGalleryPrefetch(m_settings->value("packing_prefetch_galleries", 4).toInt());
+		m_packLoader->setUseMaxLimit(m_settings->value("packing_max_limit", true).toBool());
+		m_packLoader->start(false);
 		nextPack();
 	} else {
 		auto *img = dynamic_cast<DownloadQueryImage*>(m_query);
@@ -138,7 +222,171 @@ void BatchDownloader::nextPack()
 	// Check missing images from the pack (if we expected 1000 but only got 900, we should consider 100 missing)
 	m_counters[Counter::Missing] += packSize - images.count();
 
-	m_pendingDownloads.append(images);
+	if (!images.isEmpty()) {
+		qint64 memory = 0;
+		for (const QSharedPointer<Image> &img : images) {
+			memory += img->memoryUsage();
+		}
+		log(QStringLiteral("Loaded pack of %1 images using about %2 KiB (%3 bytes per image)").arg(images.count()).arg(memory / 1024).arg(memory / images.count()), Logger::Debug);
+	}
+
+	rejectMd5Duplicates(images);
+
+	if (m_settings->value("packing_preresolve", true).toBool()) {
+		preResolve(images);
+	} else {
+		m_pendingDownloads.append(images);
+		nextImages();
+	}
+}
+
+/**
+ * Remove the images whose MD5 from the listing is already known and should be ignored, checking the whole pack in a
+ * single database lookup so that they never take a download slot or a details request.
+ */
+void BatchDownloader::rejectMd5Duplicates(QList<QSharedPointer<Image>> &images)
+{
+	const QString sameDirSetting = m_settings->value("Save/md5DuplicatesSameDir", "save").toString();
+	const QString otherDirSetting = m_settings->value("Save/md5Duplicates", "save").toString();
+	if (sameDirSetting != "ignore" && otherDirSetting != "ignore") {
+		return;
+	}
+
+	QStringList md5s;
+	md5s.reserve(images.count());
+	for (const QSharedPointer<Image> &img : qAsConst(images)) {
+		const QString md5 = img->md5();
+		if (!md5.isEmpty()) {
+			md5s.append(md5);
+		}
+	}
+	if (md5s.isEmpty()) {
+		return;
+	}
+
+	const QSet<QString> known = m_profile->md5sKnown(md5s);
+	if (known.isEmpty()) {
+		return;
+	}
+
+	// The destination is only needed to tell duplicates in the same directory apart from the others
+	const Filename filename(m_query->filename);
+	for (auto it = images.begin(); it != images.end();) {
+		const QSharedPointer<Image> &img = *it;
+		const QString md5 = img->md5();
+		if (md5.isEmpty() || !known.contains(md5)) {
+			++it;
+			continue;
+		}
+
+		QString target;
+		if (sameDirSetting != otherDirSetting) {
+			const QStringList paths = img->paths(filename, m_query->path, m_counterSum + 1);
+			if (!paths.isEmpty()) {
+				target = paths.first();
+			}
+		}
+
+		const QPair<QString, QString> md5action = m_profile->md5Action(md5, target);
+		if (md5action.first != "ignore") {
+			++it;
+			continue;
+		}
+
+		log(QStringLiteral("MD5 \"%1\" of the image `%2` already found in file `%3`").arg(md5, img->url().toString(), md5action.second));
+		m_counters[Counter::Ignored]++;
+		m_counterSum++;
+		it = images.erase(it);
+	}
+}
+
+void BatchDownloader::preResolve(const QList<QSharedPointer<Image>> &images)
+{
+	auto *group = dynamic_cast<DownloadQueryGroup*>(m_query);
+	const bool getBlacklisted = group == nullptr || group->getBlacklisted;
+
+	PreResolver resolver;
+	resolver.profile = m_profile;
+	resolver.filename = Filename(m_query->filename);
+	resolver.folder = m_query->path;
+	resolver.blacklist = getBlacklisted ? nullptr : &m_profile->getBlacklist();
+	resolver.directoryIndex = m_directoryIndex;
+
+	// Images requiring their details to be loaded first can't be resolved in advance
+	const QStringList forcedTokens = m_query->site->getApis().first()->forcedTokens();
+	const bool needFileUrl = forcedTokens.contains("*") || forcedTokens.contains("file_url");
+	const int needTags = qMax(ImageDownloader::needExactTags(m_settings), resolver.filename.needExactTags(m_query->site, m_settings));
+
+	QList<PreResolvedImage> items;
+	QList<QSharedPointer<Image>> needDetails;
+	int count = m_counterSum;
+	for (const QSharedPointer<Image> &img : images) {
+		const bool filenameNeedTags = needTags == 2 || (needTags == 1 && img->hasUnknownTag());
+		const bool blacklistNeedTags = resolver.blacklist != nullptr && img->tags().isEmpty();
+		if (needFileUrl || filenameNeedTags || blacklistNeedTags) {
+			m_pendingDownloads.append(img);
+			needDetails.append(img);
+			continue;
+		}
+
+		PreResolvedImage item;
+		item.image = img;
+		item.count = ++count;
+		items.append(item);
+	}
+
+	// Their details can be loaded together with the first ones
+	m_query->site->detailsBatcher()->prefetch(needDetails);
+
+	if (items.isEmpty()) {
+		nextImages();
+		return;
+	}
+
+	m_preResolveWatcher = new QFutureWatcher<PreResolvedImage>(this);
+	connect(m_preResolveWatcher, &QFutureWatcher<PreResolvedImage>::finished, this, &BatchDownloader::preResolveFinished);
+	m_preResolveWatcher->setFuture(QtConcurrent::mapped(items, resolver));
+}
+
+void BatchDownloader::preResolveFinished()
+{
+	const QList<PreResolvedImage> results = m_preResolveWatcher->future().results();
+	m_preResolveWatcher->deleteLater();
+	m_preResolveWatcher = nullptr;
+
+	for (const PreResolvedImage &item : results) {
+		// Blacklisted images
+		if (item.result == Image::SaveResult::Blacklisted) {
+			log(QStringLiteral("Image contains blacklisted tags: '%1'").arg(item.detected.join("', '")), Logger::Info);
+			m_counters[Counter::Ignored]++;
+			m_counterSum++;
+			continue;
+		}
+
+		// Files already existing on disk
+		if (item.result == Image::SaveResult::AlreadyExistsDisk) {
+			log(QStringLiteral("File already exists: `%1`").arg(item.paths.first()), Logger::Info);
+			for (int i = 0; i < item.paths.count(); ++i) {
+				m_profile->addMd5(item.md5s[i], item.paths[i]);
+			}
+			m_counters[Counter::AlreadyExists]++;
+			m_counterSum++;
+			continue;
+		}
+
+		// Images already in the MD5 database were rejected before, so we can use the resolved paths directly
+		if (!item.paths.isEmpty()) {
+			m_preResolvedPaths.insert(item.image, item.paths);
+		}
+
+		m_pendingDownloads.append(item.image);
+	}
+
+	// If the user paused the download in the meantime, images will be downloaded once resumed
+	if (m_step == BatchDownloadStep::Aborted) {
+		return;
+	}
+
 	nextImages();
 }
 
@@ -146,18 +394,20 @@ void BatchDownloader::nextImages()
 {
 	setCurrentStep(BatchDownloadStep::ImageDownload);
 
-	// Start the simultaneous downloads
+	// Start the simultaneous downloads, on top of the ones still running if resuming
 	int count = qMax(1, qMin(m_settings->value("Save/simultaneous").toInt(), 10));
-	m_currentlyProcessing.storeRelaxed(count); // TODO: this should be shared amongst instances
-	for (int i = 0; i < count; ++i) {
+	const int missing = count - m_currentlyProcessing.loadRelaxed(); // TODO: this should be shared amongst instances
+	m_currentlyProcessing.fetchAndAddRelaxed(qMax(0, missing));
+	for (int i = 0; i < missing; ++i) {
 		nextImage();
 	}
 }
 
 void BatchDownloader::nextImage()
 {
-	// We quit as soon as the user cancels
+	// We quit as soon as the user cancels, the download being started again by nextImages() when resuming
 	if (m_step != BatchDownloadStep::ImageDownload) {
+		m_currentlyProcessing.fetchAndAddRelaxed(-1);
 		return;
 	}
 
@@ -190,11 +440,20 @@ void BatchDownloader::loadImage(QSharedPointer<Image> img)
 	// Start loading and saving image
 	int count = m_counterSum + 1;
 	bool getBlacklisted = group == nullptr || group->getBlacklisted;
-	auto imgDownloader = new ImageDownloader(m_profile, img, filename, path, count, true, false, this);
-	if (!getBlacklisted) {
-		imgDownloader->setBlacklist(&m_profile->getBlacklist());
+	ImageDownloader *imgDownloader;
+	auto preResolved = m_preResolvedPaths.constFind(img);
+	if (preResolved != m_preResolvedPaths.constEnd()) {
+		// Filenames and the blacklist were already checked during the pre-resolution
+		imgDownloader = new ImageDownloader(m_profile, img, preResolved.value(), count, true, false, this);
+	} else {
+		imgDownloader = new ImageDownloader(m_profile, img, filename, path, count, true, false, this);
+		if (!getBlacklisted) {
+			imgDownloader->setBlacklist(&m_profile->getBlacklist());
+		}
 	}
+	imgDownloader->setDirectoryIndex(m_directoryIndex.data());
 	connect(imgDownloader, &ImageDownloader::saved, this, &BatchDownloader::loadImageFinished, Qt::UniqueConnection);
+	connect(imgDownloader, &ImageDownloader::downloadProgress, m_progressAggregator, &ProgressAggregator::update, Qt::UniqueConnection);
 	m_imageDownloaders[img] = imgDownloader;
 	imgDownloader->save();
 }
@@ -204,6 +463,8 @@ void BatchDownloader::loadImageFinished(const QSharedPointer<Image> &img, QList<
 	// Delete ImageDownloader to prevent leaks
 	m_imageDownloaders[img]->deleteLater();
 	m_imageDownloaders.remove(img);
+	m_preResolvedPaths.remove(img);
+	m_progressAggregator->remove(img);
 
 	// Save error count to compare it later on
 	bool diskError = false;
@@ -225,7 +486,7 @@ void BatchDownloader::loadImageFinished(const QSharedPointer<Image> &img, QList<
 		m_counters[Counter::NotFound]++;
 	} else if (res == Image::SaveResult::AlreadyExistsDisk) {
 		m_counters[Counter::AlreadyExists]++;
-	} else if (res == Image::SaveResult::Blacklisted || res == Image::SaveResult::AlreadyExistsMd5 || res == Image::SaveResult::AlreadyExistsDeletedMd5) {
+	} else if (res == Image::SaveResult::Blacklisted || res == Image::SaveResult::AlreadyExistsMd5 || res == Image::SaveResult::AlreadyExistsDeletedMd5 || res == Image::SaveResult::AlreadyExistsSimilar) {
 		m_counters[Counter::Ignored]++;
 	} else if (!diskError) {
 		m_counters[Counter::Downloaded]++;
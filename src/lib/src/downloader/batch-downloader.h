@@ -1,19 +1,25 @@
 #ifndef BATCH_DOWNLOADER_H
 #define BATCH_DOWNLOADER_H
 
+#include <QFutureWatcher>
+#include <QList>
 #include <QMap>
 #include <QObject>
 #include <QQueue>
 #include <QSharedPointer>
+#include <QStringList>
 #include "downloader/image-save-result.h"
 
 
+class DirectoryIndex;
 class DownloadQuery;
 class Image;
 class ImageDownloader;
 class PackLoader;
 class Profile;
+class ProgressAggregator;
 class QSettings;
+class SessionManager;
 
 class BatchDownloader : public QObject
 {
@@ -41,6 +47,20 @@ class BatchDownloader : public QObject
 			Missing,
 		};
 
+		/**
+		 * Result of the pre-resolution of an image, done in a worker thread.
+		 * If the paths are empty, the image could not be pre-resolved and will go through the normal download process.
+		 */
+		struct PreResolvedImage
+		{
+			QSharedPointer<Image> image;
+			int count = 0;
+			QStringList paths;
+			Image::SaveResult result = Image::SaveResult::NotLoaded;
+			QStringList detected; // Blacklisted tags
+			QStringList md5s; // MD5 of the paths, if they exist
+		};
+
 		BatchDownloader(DownloadQuery *query, Profile *profile, QObject *parent = nullptr);
 		BatchDownloadStep currentStep() const;
 		int totalCount() const;
@@ -56,6 +76,7 @@ class BatchDownloader : public QObject
 		void login();
 		void loginFinished();
 		void nextPack();
+		void preResolveFinished();
 		void nextImages();
 		void nextImage();
 		void loadImage(QSharedPointer<Image> img);
@@ -64,6 +85,8 @@ class BatchDownloader : public QObject
 
 	protected:
 		void setCurrentStep(BatchDownloadStep step);
+		void rejectMd5Duplicates(QList<QSharedPointer<Image>> &images);
+		void preResolve(const QList<QSharedPointer<Image>> &images);
 
 	signals:
 		void stepChanged(BatchDownloadStep step);
@@ -77,10 +100,15 @@ class BatchDownloader : public QObject
 		QSettings *m_settings;
 		BatchDownloadStep m_step;
 		PackLoader *m_packLoader = nullptr;
+		SessionManager *m_sessionManager;
 		QAtomicInt m_currentlyProcessing;
 		QQueue<QSharedPointer<Image>> m_pendingDownloads;
 		QQueue<QSharedPointer<Image>> m_failedDownloads;
+		QFutureWatcher<PreResolvedImage> *m_preResolveWatcher = nullptr;
+		QMap<QSharedPointer<Image>, QStringList> m_preResolvedPaths;
+		QSharedPointer<DirectoryIndex> m_directoryIndex;
 		QMap<QSharedPointer<Image>, ImageDownloader*> m_imageDownloaders;
+		ProgressAggregator *m_progressAggregator;
 		int m_totalCount = 0;
 
 		// Counters
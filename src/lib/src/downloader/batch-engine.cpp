@@ -0,0 +1,60 @@
+#include "downloader/batch-engine.h"
+#include <QSharedPointer>
+#include "downloader/batch-downloader.h"
+#include "models/image.h"
+
+
+BatchEngine::BatchEngine(QObject *parent)
+	: QObject(parent)
+{
+	// Types used by the downloaders' signals, which are now delivered across threads
+	qRegisterMetaType<BatchDownloader::BatchDownloadStep>("BatchDownloadStep");
+	qRegisterMetaType<QSharedPointer<Image>>("QSharedPointer<Image>");
+	qRegisterMetaType<Image::SaveResult>("Image::SaveResult");
+
+	m_thread.setObjectName(QStringLiteral("Batch engine"));
+	m_thread.start();
+}
+
+BatchEngine::~BatchEngine()
+{
+	// Downloaders are deleted by the engine thread, which processes pending deletions before finishing
+	for (BatchDownloader *downloader : qAsConst(m_downloaders)) {
+		QMetaObject::invokeMethod(downloader, "abort", Qt::QueuedConnection);
+		downloader->deleteLater();
+	}
+	m_downloaders.clear();
+
+	m_thread.quit();
+	m_thread.wait();
+}
+
+
+/**
+ * Create a new downloader living on the engine thread.
+ * It is owned by the engine, and must be released using remove() when not needed anymore.
+ */
+BatchDownloader *BatchEngine::createDownloader(DownloadQuery *query, Profile *profile)
+{
+	auto *downloader = new BatchDownloader(query, profile);
+	downloader->moveToThread(&m_thread);
+	m_downloaders.append(downloader);
+	return downloader;
+}
+
+void BatchEngine::start(BatchDownloader *downloader)
+{
+	QMetaObject::invokeMethod(downloader, "start", Qt::QueuedConnection);
+}
+
+void BatchEngine::abort(BatchDownloader *downloader)
+{
+	QMetaObject::invokeMethod(downloader, "abort", Qt::QueuedConnection);
+}
+
+void BatchEngine::remove(BatchDownloader *downloader)
+{
+	if (m_downloaders.removeOne(downloader)) {
+		downloader->deleteLater();
+	}
+}
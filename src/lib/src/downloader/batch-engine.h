@@ -0,0 +1,39 @@
+#ifndef BATCH_ENGINE_H
+#define BATCH_ENGINE_H
+
+#include <QList>
+#include <QObject>
+#include <QThread>
+
+
+class BatchDownloader;
+class DownloadQuery;
+class Profile;
+
+/**
+ * Runs batch downloads on a dedicated thread, so that page loading, parsing and file post-processing don't compete
+ * with the UI for its event loop.
+ *
+ * The downloaders are only driven through queued calls, and their signals can be connected to as usual, the
+ * connections to objects of the calling thread being queued automatically. Their queries and profile must outlive
+ * them, and are shared with the calling thread, so they should not be modified while downloading.
+ */
+class BatchEngine : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit BatchEngine(QObject *parent = nullptr);
+		~BatchEngine() override;
+
+		BatchDownloader *createDownloader(DownloadQuery *query, Profile *profile);
+		void start(BatchDownloader *downloader);
+		void abort(BatchDownloader *downloader);
+		void remove(BatchDownloader *downloader);
+
+	private:
+		QThread m_thread;
+		QList<BatchDownloader*> m_downloaders;
+};
+
+#endif // BATCH_ENGINE_H
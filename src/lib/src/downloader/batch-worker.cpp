@@ -0,0 +1,160 @@
+#include "downloader/batch-worker.h"
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include "downloader/batch-downloader.h"
+#include "logger.h"
+
+#define CONNECT_TIMEOUT 10000
+#define WAIT_DELAY 5000
+
+
+BatchWorker::BatchWorker(Profile *profile, int heartbeatInterval, QObject *parent)
+	: QObject(parent), m_profile(profile), m_heartbeatTimer(this)
+{
+	m_socket = new QTcpSocket(this);
+	connect(m_socket, &QTcpSocket::readyRead, this, &BatchWorker::readyRead);
+	connect(m_socket, &QTcpSocket::disconnected, this, &BatchWorker::disconnected);
+
+	m_heartbeatTimer.setInterval(heartbeatInterval);
+	connect(&m_heartbeatTimer, &QTimer::timeout, this, &BatchWorker::sendHeartbeat);
+}
+
+BatchWorker::~BatchWorker()
+{
+	stopLease();
+}
+
+bool BatchWorker::start(const QString &host, quint16 port)
+{
+	m_socket->connectToHost(host, port);
+	if (!m_socket->waitForConnected(CONNECT_TIMEOUT)) {
+		log(QStringLiteral("Could not connect to the coordinator at %1:%2: %3").arg(host).arg(port).arg(m_socket->errorString()), Logger::Error);
+		return false;
+	}
+
+	log(QStringLiteral("Connected to the coordinator at %1:%2").arg(host).arg(port), Logger::Info);
+	requestLease();
+	return true;
+}
+
+
+void BatchWorker::send(const QJsonObject &message)
+{
+	if (m_socket->state() != QTcpSocket::ConnectedState) {
+		return;
+	}
+
+	m_socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + "\n");
+	m_socket->flush();
+}
+
+void BatchWorker::requestLease()
+{
+	send(QJsonObject { { "type", "lease" } });
+}
+
+void BatchWorker::readyRead()
+{
+	while (m_socket->canReadLine()) {
+		const QJsonObject message = QJsonDocument::fromJson(m_socket->readLine()).object();
+		const QString type = message.value("type").toString();
+
+		if (type == QLatin1String("lease")) {
+			startLease(message.value("lease").toInt(), message.value("group").toObject());
+		} else if (type == QLatin1String("wait")) {
+			QTimer::singleShot(WAIT_DELAY, this, SLOT(requestLease()));
+		} else if (type == QLatin1String("cancel")) {
+			if (message.value("lease").toInt() == m_lease) {
+				log(QStringLiteral("Lease %1 was given to another worker").arg(m_lease), Logger::Warning);
+				stopLease();
+				requestLease();
+			}
+		} else if (type == QLatin1String("finished")) {
+			log(QStringLiteral("No more leases to download"), Logger::Info);
+			m_finished = true;
+			m_socket->disconnectFromHost();
+			emit finished(0);
+		} else if (type == QLatin1String("error")) {
+			log(QStringLiteral("Coordinator error: %1").arg(message.value("error").toString()), Logger::Error);
+		}
+	}
+}
+
+void BatchWorker::disconnected()
+{
+	if (m_finished) {
+		return;
+	}
+
+	// The coordinator gives our lease to another worker when we disconnect anyway
+	log(QStringLiteral("Disconnected from the coordinator"), Logger::Error);
+	stopLease();
+	m_finished = true;
+	emit finished(1);
+}
+
+
+void BatchWorker::startLease(int id, const QJsonObject &group)
+{
+	stopLease();
+
+	m_group = DownloadQueryGroup();
+	if (!m_group.read(group, m_profile)) {
+		send(QJsonObject { { "type", "failed" }, { "lease", id }, { "error", "Invalid group" } });
+		requestLease();
+		return;
+	}
+
+	log(QStringLiteral("Starting lease %1 (`%2` on %3, page %4)").arg(id).arg(m_group.query.toString(), m_group.site->url()).arg(m_group.page), Logger::Info);
+
+	m_lease = id;
+	m_downloader = new BatchDownloader(&m_group, m_profile, this);
+	connect(m_downloader, &BatchDownloader::finished, this, &BatchWorker::downloaderFinished);
+	m_heartbeatTimer.start();
+	m_downloader->start();
+}
+
+void BatchWorker::stopLease()
+{
+	m_heartbeatTimer.stop();
+	m_lease = -1;
+
+	if (m_downloader != nullptr) {
+		m_downloader->disconnect(this);
+		m_downloader->abort();
+		m_downloader->deleteLater();
+		m_downloader = nullptr;
+	}
+}
+
+void BatchWorker::sendHeartbeat()
+{
+	if (m_downloader == nullptr) {
+		return;
+	}
+
+	send(QJsonObject {
+		{ "type", "heartbeat" },
+		{ "lease", m_lease },
+		{ "done", m_downloader->downloadedCount() },
+		{ "total", m_downloader->totalCount() },
+	});
+}
+
+void BatchWorker::downloaderFinished()
+{
+	send(QJsonObject {
+		{ "type", "done" },
+		{ "lease", m_lease },
+		{ "done", m_downloader->downloadedCount() },
+		{ "total", m_downloader->totalCount() },
+		{ "errors", m_downloader->downloadedCount(BatchDownloader::Errors) },
+	});
+
+	m_heartbeatTimer.stop();
+	m_lease = -1;
+	m_downloader->deleteLater();
+	m_downloader = nullptr;
+
+	requestLease();
+}
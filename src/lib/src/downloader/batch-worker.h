@@ -0,0 +1,54 @@
+#ifndef BATCH_WORKER_H
+#define BATCH_WORKER_H
+
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "downloader/download-query-group.h"
+
+
+class BatchDownloader;
+class Profile;
+class QTcpSocket;
+
+/**
+ * Downloads the leases given by a batch coordinator, one at a time, until it has none left.
+ *
+ * @see BatchCoordinator for the protocol.
+ */
+class BatchWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit BatchWorker(Profile *profile, int heartbeatInterval = 10000, QObject *parent = nullptr);
+		~BatchWorker() override;
+		bool start(const QString &host, quint16 port);
+
+	protected slots:
+		void readyRead();
+		void disconnected();
+		void requestLease();
+		void sendHeartbeat();
+		void downloaderFinished();
+
+	protected:
+		void send(const QJsonObject &message);
+		void startLease(int id, const QJsonObject &group);
+		void stopLease();
+
+	signals:
+		void finished(int code);
+
+	private:
+		Profile *m_profile;
+		QTcpSocket *m_socket;
+		QTimer m_heartbeatTimer;
+		int m_lease = -1;
+		DownloadQueryGroup m_group;
+		BatchDownloader *m_downloader = nullptr;
+		bool m_finished = false;
+};
+
+#endif // BATCH_WORKER_H
@@ -0,0 +1,193 @@
+#include "downloader/details-batcher.h"
+#include <QSettings>
+#include "logger.h"
+#include "models/api/api.h"
+#include "models/image.h"
+#include "models/page.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "models/source.h"
+
+#define DEFAULT_BATCH_DELAY 200
+
+
+DetailsBatcher::DetailsBatcher(Site *site, QObject *parent)
+	: QObject(parent), m_site(site), m_timer(this)
+{
+	m_timer.setSingleShot(true);
+	connect(&m_timer, &QTimer::timeout, this, &DetailsBatcher::flush);
+}
+
+DetailsBatcher::~DetailsBatcher()
+{
+	for (const Batch &batch : qAsConst(m_batches)) {
+		delete batch.page;
+	}
+}
+
+Api *DetailsBatcher::batchApi() const
+{
+	for (Api *api : m_site->getLoggedInApis()) {
+		if (api->batchIdsMax() <= 0) {
+			continue;
+		}
+
+		// The listing must contain everything we would have gotten from the details page
+		const QStringList forcedTokens = api->forcedTokens();
+		if (forcedTokens.contains("*") || forcedTokens.contains("file_url") || forcedTokens.contains("tags")) {
+			continue;
+		}
+
+		return api;
+	}
+	return nullptr;
+}
+
+
+void DetailsBatcher::loadDetails(const QSharedPointer<Image> &img)
+{
+	// Already waiting for a batch
+	if (m_queued.contains(img.data())) {
+		return;
+	}
+
+	Api *api = img->hasLoadedDetails() ? nullptr : batchApi();
+	if (api == nullptr || !enqueue(img)) {
+		img->loadDetails();
+		return;
+	}
+
+	scheduleFlush(api->batchIdsMax());
+}
+
+void DetailsBatcher::prefetch(const QList<QSharedPointer<Image>> &images)
+{
+	if (batchApi() == nullptr) {
+		return;
+	}
+
+	for (const QSharedPointer<Image> &img : images) {
+		if (img->id() != 0 && !img->hasLoadedDetails()) {
+			m_prefetch.append(img);
+		}
+	}
+}
+
+bool DetailsBatcher::enqueue(const QSharedPointer<Image> &img)
+{
+	if (img->id() == 0) {
+		return false;
+	}
+
+	m_pending.append(img);
+	m_queued.insert(img.data());
+	return true;
+}
+
+void DetailsBatcher::scheduleFlush(int max)
+{
+	// Full batches can be sent right away
+	while (m_pending.count() >= max) {
+		flush();
+	}
+
+	if (!m_pending.isEmpty() && !m_timer.isActive()) {
+		const int delay = m_site->getSource()->getProfile()->getSettings()->value("details_batch_delay", DEFAULT_BATCH_DELAY).toInt();
+		m_timer.start(delay);
+	}
+}
+
+void DetailsBatcher::flush()
+{
+	m_timer.stop();
+	if (m_pending.isEmpty()) {
+		return;
+	}
+
+	// The site settings might have changed since the images were queued
+	Api *api = batchApi();
+	if (api == nullptr) {
+		const QList<QSharedPointer<Image>> pending = m_pending;
+		m_pending.clear();
+		for (const QSharedPointer<Image> &img : pending) {
+			m_queued.remove(img.data());
+			img->loadDetails();
+		}
+		return;
+	}
+
+	const int max = api->batchIdsMax();
+	Batch batch;
+	batch.images = m_pending.mid(0, max);
+	m_pending = m_pending.mid(batch.images.count());
+	batch.requested = batch.images.count();
+
+	// Fill the rest of the batch with images that will be needed later
+	while (batch.images.count() < max && !m_prefetch.isEmpty()) {
+		QSharedPointer<Image> img = m_prefetch.takeFirst();
+		if (!img->hasLoadedDetails() && !m_queued.contains(img.data())) {
+			m_queued.insert(img.data());
+			batch.images.append(img);
+		}
+	}
+
+	QList<qulonglong> ids;
+	ids.reserve(batch.images.count());
+	for (const QSharedPointer<Image> &img : qAsConst(batch.images)) {
+		ids.append(img->id());
+	}
+	const QString search = api->batchIdsSearch(ids);
+
+	log(QStringLiteral("[%1] Loading details of %2 images at once").arg(m_site->url()).arg(ids.count()), Logger::Info);
+
+	Profile *profile = m_site->getSource()->getProfile();
+	const int count = batch.images.count();
+	batch.page = new Page(profile, m_site, { m_site }, QStringList { search }, 1, count, QStringList(), false, this);
+	auto *pageApi = new PageApi(batch.page, profile, m_site, api, batch.page->query(), 1, count, PostFilter(), false, batch.page);
+	m_batches.insert(pageApi, batch);
+
+	connect(pageApi, &PageApi::finishedLoading, this, &DetailsBatcher::batchFinished);
+	pageApi->load();
+}
+
+void DetailsBatcher::batchFinished(PageApi *pageApi, PageApi::LoadResult status)
+{
+	const auto it = m_batches.find(pageApi);
+	if (it == m_batches.end()) {
+		return;
+	}
+	const Batch batch = it.value();
+	m_batches.erase(it);
+
+	QHash<qulonglong, QSharedPointer<Image>> results;
+	if (status == PageApi::LoadResult::Ok) {
+		for (const QSharedPointer<Image> &result : pageApi->images()) {
+			results.insert(result->id(), result);
+		}
+	} else {
+		log(QStringLiteral("[%1] Error loading details of %2 images at once, loading them one by one").arg(m_site->url()).arg(batch.images.count()), Logger::Warning);
+	}
+
+	for (int i = 0; i < batch.images.count(); ++i) {
+		const QSharedPointer<Image> &img = batch.images[i];
+		m_queued.remove(img.data());
+
+		// Prefetched images will go through the normal process again when they are actually needed
+		const QSharedPointer<Image> result = results.value(img->id());
+		if (result.isNull()) {
+			if (i < batch.requested) {
+				img->loadDetails();
+			}
+			continue;
+		}
+
+		ParsedDetails details;
+		details.tags = result->tags();
+		details.pools = result->pools();
+		details.imageUrl = result->fileUrl().toString();
+		details.createdAt = result->createdAt();
+		img->setDetails(details);
+	}
+
+	batch.page->deleteLater();
+}
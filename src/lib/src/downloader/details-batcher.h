@@ -0,0 +1,75 @@
+#ifndef DETAILS_BATCHER_H
+#define DETAILS_BATCHER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+#include "models/page-api.h"
+
+
+class Api;
+class Image;
+class Page;
+class Site;
+
+/**
+ * Loads the details of many images of the same site in a single request.
+ *
+ * If one of the site's APIs supports searching for several posts by ID at once (see "batchIds" in the source models),
+ * pending detail requests are collected for a short time and fetched using a single search. Images missing from the
+ * results, or from sites without such a search, fall back to Image::loadDetails(). Images registered using prefetch()
+ * are used to fill the remaining room of each batch, so that later images don't require any new request.
+ */
+class DetailsBatcher : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit DetailsBatcher(Site *site, QObject *parent = nullptr);
+		~DetailsBatcher() override;
+
+		/**
+		 * The API used for batch searches, or nullptr if the site doesn't support them.
+		 */
+		Api *batchApi() const;
+
+	public slots:
+		/**
+		 * Load the details of an image, emitting its finishedLoadingTags() signal when done.
+		 */
+		void loadDetails(const QSharedPointer<Image> &img);
+
+		/**
+		 * Register images whose details will be needed soon, so that they can be fetched along the next batches.
+		 */
+		void prefetch(const QList<QSharedPointer<Image>> &images);
+
+		void flush();
+
+	protected slots:
+		void batchFinished(PageApi *pageApi, PageApi::LoadResult status);
+
+	protected:
+		bool enqueue(const QSharedPointer<Image> &img);
+		void scheduleFlush(int max);
+
+	private:
+		struct Batch
+		{
+			Page *page;
+			QList<QSharedPointer<Image>> images;
+			int requested; // The first images were actually requested, the others are prefetched
+		};
+
+		Site *m_site;
+		QTimer m_timer;
+		QList<QSharedPointer<Image>> m_pending;
+		QList<QSharedPointer<Image>> m_prefetch;
+		QSet<Image*> m_queued;
+		QHash<PageApi*, Batch> m_batches;
+};
+
+#endif // DETAILS_BATCHER_H
@@ -46,6 +46,22 @@ void DownloadQueryGroup::write(QJsonObject &json, bool saveProgress) const
 	if (saveProgress) {
 		json["progressVal"] = progressVal;
 		json["progressFinished"] = progressFinished;
+
+		if (checkpoint.page > 0) {
+			QJsonObject jsonCheckpoint;
+			jsonCheckpoint["page"] = checkpoint.page;
+			jsonCheckpoint["total"] = checkpoint.total;
+			jsonCheckpoint["skip"] = checkpoint.skip;
+			if (checkpoint.perPage > 0) {
+				jsonCheckpoint["perPage"] = checkpoint.perPage;
+			}
+			jsonCheckpoint["lastPage"] = checkpoint.lastPage;
+			jsonCheckpoint["lastPageMinId"] = QString::number(checkpoint.lastPageMinId);
+			jsonCheckpoint["lastPageMaxId"] = QString::number(checkpoint.lastPageMaxId);
+			jsonCheckpoint["lastPageMinDate"] = checkpoint.lastPageMinDate;
+			jsonCheckpoint["lastPageMaxDate"] = checkpoint.lastPageMaxDate;
+			json["checkpoint"] = jsonCheckpoint;
+		}
 	}
 }
 
@@ -66,6 +82,20 @@ bool DownloadQueryGroup::read(const QJsonObject &json, Profile *profile)
 	progressVal = json["progressVal"].toInt();
 	progressFinished = json["progressFinished"].toBool();
 
+	checkpoint = Checkpoint();
+	if (json.contains("checkpoint")) {
+		const QJsonObject jsonCheckpoint = json["checkpoint"].toObject();
+		checkpoint.page = jsonCheckpoint["page"].toInt();
+		checkpoint.total = jsonCheckpoint["total"].toInt();
+		checkpoint.skip = jsonCheckpoint["skip"].toInt();
+		checkpoint.perPage = jsonCheckpoint["perPage"].toInt();
+		checkpoint.lastPage = jsonCheckpoint["lastPage"].toInt();
+		checkpoint.lastPageMinId = jsonCheckpoint["lastPageMinId"].toString().toULongLong();
+		checkpoint.lastPageMaxId = jsonCheckpoint["lastPageMaxId"].toString().toULongLong();
+		checkpoint.lastPageMinDate = jsonCheckpoint["lastPageMinDate"].toString();
+		checkpoint.lastPageMaxDate = jsonCheckpoint["lastPageMaxDate"].toString();
+	}
+
 	// Post filtering
 	postFiltering.clear();
 	QJsonArray jsonPostFilters = json["postFiltering"].toArray();
@@ -16,6 +16,25 @@ class Site;
 class DownloadQueryGroup : public DownloadQuery
 {
 	public:
+		/**
+		 * Where the loading of the group stopped, to resume it directly from there instead of guessing the page to
+		 * resume from using the number of downloaded images.
+		 */
+		struct Checkpoint
+		{
+			int page = 0; // Page to resume from, 0 if there is no checkpoint
+			int total = 0; // Images already counted when resuming from that page
+			int skip = 0; // Images at the start of that page that were already counted
+			int perPage = 0; // Images per page the page number is counted in, 0 for the group's own
+
+			// Cursor of the previous page, allowing ID-based pagination to keep working after a resume
+			int lastPage = 0;
+			qulonglong lastPageMinId = 0;
+			qulonglong lastPageMaxId = 0;
+			QString lastPageMinDate;
+			QString lastPageMaxDate;
+		};
+
 		// Constructors
 		DownloadQueryGroup() = default;
 		explicit DownloadQueryGroup(QSettings *settings, SearchQuery query, int page, int perPage, int total, QStringList postFiltering, Site *site);
@@ -36,6 +55,7 @@ class DownloadQueryGroup : public DownloadQuery
 		bool galleriesCountAsOne = true;
 		int progressVal = 0;
 		bool progressFinished = false;
+		Checkpoint checkpoint;
 };
 
 bool operator==(const DownloadQueryGroup &lhs, const DownloadQueryGroup &rhs);
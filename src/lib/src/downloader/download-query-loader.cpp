@@ -5,11 +5,23 @@
 #include <QJsonObject>
 #include "downloader/download-query-group.h"
 #include "downloader/download-query-image.h"
+#include "downloader/download-query-snapshot.h"
 #include "logger.h"
 
 
 bool DownloadQueryLoader::load(const QString &path, QList<DownloadQueryImage> &uniques, QList<DownloadQueryGroup> &groups, Profile *profile)
 {
+	// Binary snapshots used to restore downloads
+	if (DownloadQuerySnapshot::isSnapshot(path)) {
+		DownloadQuerySnapshot snapshot(path);
+		if (!snapshot.open()) {
+			return false;
+		}
+		groups.append(snapshot.readGroups(profile));
+		uniques.append(snapshot.readUniques(profile));
+		return true;
+	}
+
 	QFile f(path);
 	if (!f.open(QFile::ReadOnly)) {
 		return false;
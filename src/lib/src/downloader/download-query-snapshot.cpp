@@ -0,0 +1,298 @@
+#include "downloader/download-query-snapshot.h"
+#include <QCborArray>
+#include <QCborMap>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+#include <utility>
+#include "logger.h"
+
+#define SNAPSHOT_MAGIC "IGLS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 8
+#define COMPACT_RATIO 2
+#define COMPACT_MIN_SIZE (1024 * 1024)
+
+
+DownloadQuerySnapshot::DownloadQuerySnapshot(QString path)
+	: m_path(std::move(path))
+{}
+
+bool DownloadQuerySnapshot::isSnapshot(const QString &path)
+{
+	QFile f(path);
+	if (!f.open(QFile::ReadOnly)) {
+		return false;
+	}
+	return f.read(4) == SNAPSHOT_MAGIC;
+}
+
+
+bool DownloadQuerySnapshot::open()
+{
+	QFile f(m_path);
+	if (!f.open(QFile::ReadOnly)) {
+		return false;
+	}
+
+	const QByteArray data = f.readAll();
+	if (data.size() < SNAPSHOT_HEADER_SIZE || !data.startsWith(SNAPSHOT_MAGIC)) {
+		log(QStringLiteral("Invalid download snapshot: `%1`").arg(m_path), Logger::Warning);
+		return false;
+	}
+	const quint32 version = qFromLittleEndian<quint32>(data.constData() + 4);
+	if (version != SNAPSHOT_VERSION) {
+		log(QStringLiteral("Unknown download snapshot version: %1").arg(version), Logger::Warning);
+		return false;
+	}
+
+	m_groupValues.clear();
+	m_uniqueValues.clear();
+	m_nextUnique = 0;
+
+	// Replay all the records of the log
+	int pos = SNAPSHOT_HEADER_SIZE;
+	while (pos + 4 <= data.size()) {
+		const int length = static_cast<int>(qFromLittleEndian<quint32>(data.constData() + pos));
+		if (length < 0 || pos + 4 + length > data.size()) {
+			log(QStringLiteral("Download snapshot truncated at position %1").arg(pos), Logger::Warning);
+			break;
+		}
+
+		QCborParserError error;
+		const QCborValue record = QCborValue::fromCbor(data.mid(pos + 4, length), &error);
+		pos += 4 + length;
+		if (error.error != QCborError::NoError || !record.isArray()) {
+			log(QStringLiteral("Invalid record in download snapshot: %1").arg(error.errorString()), Logger::Warning);
+			continue;
+		}
+
+		const QCborArray arr = record.toArray();
+		const int index = static_cast<int>(arr[1].toInteger());
+		if (index < 0) {
+			continue;
+		}
+
+		switch (arr[0].toInteger())
+		{
+			case GroupRecord:
+				if (index >= m_groupValues.count()) {
+					m_groupValues.resize(index + 1);
+				}
+				m_groupValues[index] = arr[2];
+				break;
+
+			case UniqueRecord:
+				if (index >= m_uniqueValues.count()) {
+					m_uniqueValues.resize(index + 1);
+				}
+				m_uniqueValues[index] = arr[2];
+				break;
+
+			case SizeRecord:
+				m_groupValues.resize(index);
+				m_uniqueValues.resize(static_cast<int>(arr[2].toInteger()));
+				break;
+		}
+	}
+
+	return true;
+}
+
+int DownloadQuerySnapshot::groupCount() const
+{
+	return m_groupValues.count();
+}
+
+int DownloadQuerySnapshot::uniqueCount() const
+{
+	return m_uniqueValues.count();
+}
+
+bool DownloadQuerySnapshot::atEnd() const
+{
+	return m_nextUnique >= m_uniqueValues.count();
+}
+
+QList<DownloadQueryGroup> DownloadQuerySnapshot::readGroups(Profile *profile)
+{
+	QList<DownloadQueryGroup> ret;
+	ret.reserve(m_groupValues.count());
+
+	for (const QCborValue &value : qAsConst(m_groupValues)) {
+		if (!value.isMap()) {
+			continue;
+		}
+
+		DownloadQueryGroup group;
+		if (group.read(value.toMap().toJsonObject(), profile)) {
+			ret.append(group);
+		}
+	}
+
+	m_groupValues.clear();
+	return ret;
+}
+
+QList<DownloadQueryImage> DownloadQuerySnapshot::readUniques(Profile *profile, int max)
+{
+	QList<DownloadQueryImage> ret;
+
+	const int end = max < 0 ? m_uniqueValues.count() : qMin(m_uniqueValues.count(), m_nextUnique + max);
+	for (; m_nextUnique < end; ++m_nextUnique) {
+		QCborValue &value = m_uniqueValues[m_nextUnique];
+		if (value.isMap()) {
+			DownloadQueryImage unique;
+			if (unique.read(value.toMap().toJsonObject(), profile)) {
+				ret.append(unique);
+			}
+		}
+		value = QCborValue(); // Release the raw data as soon as possible
+	}
+
+	if (atEnd()) {
+		m_uniqueValues.clear();
+		m_nextUnique = 0;
+	}
+
+	return ret;
+}
+
+
+QByteArray DownloadQuerySnapshot::encodeGroup(const DownloadQueryGroup &group)
+{
+	QJsonObject json;
+	group.write(json, true);
+	return QCborMap::fromJsonObject(json).toCborValue().toCbor();
+}
+
+QByteArray DownloadQuerySnapshot::encodeUnique(const DownloadQueryImage &unique)
+{
+	QJsonObject json;
+	unique.write(json);
+	return QCborMap::fromJsonObject(json).toCborValue().toCbor();
+}
+
+void DownloadQuerySnapshot::appendRecord(QByteArray &out, RecordType type, int index, const QByteArray &value)
+{
+	// The value is already encoded, so the record array is built by hand to avoid decoding it again
+	QByteArray record;
+	record.append(static_cast<char>(0x83)); // Array of 3 items
+	record.append(QCborValue(static_cast<qint64>(type)).toCbor());
+	record.append(QCborValue(static_cast<qint64>(index)).toCbor());
+	record.append(value);
+
+	char length[4];
+	qToLittleEndian<quint32>(static_cast<quint32>(record.size()), length);
+	out.append(length, 4);
+	out.append(record);
+}
+
+bool DownloadQuerySnapshot::save(const QList<DownloadQueryImage> &uniques, const QList<DownloadQueryGroup> &groups)
+{
+	// The first save, or a file that was changed by someone else, requires to write everything
+	if (!m_file.isOpen() || QFileInfo(m_path).size() != m_fileSize) {
+		return compact(uniques, groups);
+	}
+
+	const qint64 maxSize = COMPACT_RATIO * m_compactedSize + COMPACT_MIN_SIZE;
+	QByteArray out;
+
+	QVector<QByteArray> newGroups;
+	newGroups.reserve(groups.count());
+	for (int i = 0; i < groups.count(); ++i) {
+		const QByteArray value = encodeGroup(groups[i]);
+		if (i >= m_groups.count() || m_groups[i] != value) {
+			appendRecord(out, GroupRecord, i, value);
+		}
+		newGroups.append(value);
+	}
+
+	for (int i = 0; i < uniques.count(); ++i) {
+		if (i >= m_uniques.count() || m_uniques[i] != uniques[i]) {
+			appendRecord(out, UniqueRecord, i, encodeUnique(uniques[i]));
+
+			// No need to keep appending if the file is going to be rewritten anyway
+			if (m_fileSize + out.size() > maxSize) {
+				return compact(uniques, groups);
+			}
+		}
+	}
+
+	if (groups.count() != m_groups.count() || uniques.count() != m_uniques.count()) {
+		appendRecord(out, SizeRecord, groups.count(), QCborValue(static_cast<qint64>(uniques.count())).toCbor());
+	}
+
+	if (out.isEmpty()) {
+		return true;
+	}
+	if (m_fileSize + out.size() > maxSize) {
+		return compact(uniques, groups);
+	}
+
+	if (m_file.write(out) != out.size() || !m_file.flush()) {
+		log(QStringLiteral("Error writing download snapshot: %1").arg(m_file.errorString()), Logger::Error);
+		m_file.close();
+		return false;
+	}
+
+	m_fileSize += out.size();
+	m_groups = newGroups;
+	m_uniques = uniques;
+	return true;
+}
+
+bool DownloadQuerySnapshot::compact(const QList<DownloadQueryImage> &uniques, const QList<DownloadQueryGroup> &groups)
+{
+	m_file.close();
+
+	QSaveFile file(m_path);
+	if (!file.open(QFile::WriteOnly)) {
+		log(QStringLiteral("Error opening download snapshot: %1").arg(file.errorString()), Logger::Error);
+		return false;
+	}
+
+	char header[SNAPSHOT_HEADER_SIZE];
+	memcpy(header, SNAPSHOT_MAGIC, 4);
+	qToLittleEndian<quint32>(SNAPSHOT_VERSION, header + 4);
+	file.write(header, SNAPSHOT_HEADER_SIZE);
+
+	QVector<QByteArray> newGroups;
+	newGroups.reserve(groups.count());
+	QByteArray out;
+	for (int i = 0; i < groups.count(); ++i) {
+		const QByteArray value = encodeGroup(groups[i]);
+		appendRecord(out, GroupRecord, i, value);
+		newGroups.append(value);
+	}
+	file.write(out);
+
+	for (int i = 0; i < uniques.count(); ++i) {
+		out.clear();
+		appendRecord(out, UniqueRecord, i, encodeUnique(uniques[i]));
+		file.write(out);
+	}
+
+	out.clear();
+	appendRecord(out, SizeRecord, groups.count(), QCborValue(static_cast<qint64>(uniques.count())).toCbor());
+	file.write(out);
+
+	if (!file.commit()) {
+		log(QStringLiteral("Error writing download snapshot: %1").arg(file.errorString()), Logger::Error);
+		return false;
+	}
+
+	m_groups = newGroups;
+	m_uniques = uniques;
+
+	m_file.setFileName(m_path);
+	if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+		log(QStringLiteral("Error opening download snapshot: %1").arg(m_file.errorString()), Logger::Error);
+	}
+	m_compactedSize = m_file.size();
+	m_fileSize = m_compactedSize;
+
+	return true;
+}
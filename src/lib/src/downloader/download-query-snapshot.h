@@ -0,0 +1,69 @@
+#ifndef DOWNLOAD_QUERY_SNAPSHOT_H
+#define DOWNLOAD_QUERY_SNAPSHOT_H
+
+#include <QByteArray>
+#include <QCborValue>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "downloader/download-query-group.h"
+#include "downloader/download-query-image.h"
+
+
+class Profile;
+
+/**
+ * Binary snapshot of the download lists, used to restore them on startup.
+ *
+ * The file is a log of CBOR records, each one replacing a single group or unique image. Saving only appends the
+ * entries that changed since the previous save, and the log is rewritten from scratch once it gets too big.
+ * When loading, the records are only parsed, and the entries are built on demand using readGroups() and readUniques().
+ */
+class DownloadQuerySnapshot
+{
+	public:
+		explicit DownloadQuerySnapshot(QString path);
+		static bool isSnapshot(const QString &path);
+
+		// Loading
+		bool open();
+		int groupCount() const;
+		int uniqueCount() const;
+		bool atEnd() const;
+		QList<DownloadQueryGroup> readGroups(Profile *profile);
+		QList<DownloadQueryImage> readUniques(Profile *profile, int max = -1);
+
+		// Saving
+		bool save(const QList<DownloadQueryImage> &uniques, const QList<DownloadQueryGroup> &groups);
+
+	protected:
+		enum RecordType
+		{
+			GroupRecord = 0,
+			UniqueRecord = 1,
+			SizeRecord = 2,
+		};
+
+		static QByteArray encodeGroup(const DownloadQueryGroup &group);
+		static QByteArray encodeUnique(const DownloadQueryImage &unique);
+		static void appendRecord(QByteArray &out, RecordType type, int index, const QByteArray &value);
+		bool compact(const QList<DownloadQueryImage> &uniques, const QList<DownloadQueryGroup> &groups);
+
+	private:
+		QString m_path;
+		QFile m_file;
+		qint64 m_fileSize = 0;
+		qint64 m_compactedSize = 0;
+
+		// Raw entries loaded from the file
+		QVector<QCborValue> m_groupValues;
+		QVector<QCborValue> m_uniqueValues;
+		int m_nextUnique = 0;
+
+		// State of the file, to only write what changed
+		QVector<QByteArray> m_groups;
+		QList<DownloadQueryImage> m_uniques;
+};
+
+#endif // DOWNLOAD_QUERY_SNAPSHOT_H
@@ -1,29 +1,130 @@
 #include "downloader/download-queue.h"
+#include <QElapsedTimer>
+#include <QSharedPointer>
 #include "concurrent-multi-queue.h"
+#include "downloader/adaptive-concurrency.h"
 #include "downloader/image-downloader.h"
+#include "downloader/image-save-result.h"
+#include "models/site.h"
+#include "network/bandwidth-limiter.h"
 
 
-DownloadQueue::DownloadQueue(int maxConcurrency, QObject *parent)
+DownloadQueue::DownloadQueue(int maxConcurrency, QObject *parent, int maxConcurrencyPerSite)
 	: QObject(parent)
 {
 	m_queue = new ConcurrentMultiQueue(this);
 	m_queue->setGlobalConcurrency(maxConcurrency);
+	m_queue->setKeyConcurrency(maxConcurrencyPerSite);
 
 	connect(m_queue, &ConcurrentMultiQueue::dequeued, this, &DownloadQueue::dequeued);
 	connect(m_queue, &ConcurrentMultiQueue::finished, this, &DownloadQueue::finished);
 }
 
+DownloadQueue::~DownloadQueue()
+{
+	qDeleteAll(m_bandwidthLimiters);
+}
+
 
 void DownloadQueue::add(Queue queue, ImageDownloader *downloader)
 {
-	QVariant variant = QVariant::fromValue(downloader);
-	m_queue->append(static_cast<int>(queue), variant);
+	const QString key = siteKey(downloader);
+	if (m_adaptiveConcurrency != nullptr) {
+		m_queue->setKeyConcurrency(key, m_adaptiveConcurrency->concurrency(key));
+	}
+
+	downloader->setBandwidthLimiter(m_bandwidthLimiters.value(queue));
+
+	Item item;
+	item.downloader = downloader;
+	item.key = key;
+	m_queue->append(static_cast<int>(queue), QVariant::fromValue(item), key);
+}
+
+void DownloadQueue::setAdaptiveConcurrency(int minConcurrency, int maxConcurrency)
+{
+	delete m_adaptiveConcurrency;
+	m_adaptiveConcurrency = new AdaptiveConcurrency(minConcurrency, maxConcurrency, this);
+	connect(m_adaptiveConcurrency, &AdaptiveConcurrency::concurrencyChanged, m_queue, [this](const QString &key, int concurrency) {
+		m_queue->setKeyConcurrency(key, concurrency);
+	});
+}
+
+AdaptiveConcurrency *DownloadQueue::adaptiveConcurrency() const
+{
+	return m_adaptiveConcurrency;
 }
 
-void DownloadQueue::dequeued(const QVariant &item)
+/**
+ * The limiter of a queue is shared by all its downloads, and is kept even when disabled as downloads still use it.
+ */
+void DownloadQueue::setBandwidthLimit(Queue queue, qint64 bytesPerSecond)
 {
-	ImageDownloader *downloader = item.value<ImageDownloader*>();
-	connect(downloader, &ImageDownloader::saved, m_queue, &ConcurrentMultiQueue::next);
+	BandwidthLimiter *limiter = m_bandwidthLimiters.value(queue);
+	if (limiter == nullptr) {
+		limiter = new BandwidthLimiter(bytesPerSecond);
+		m_bandwidthLimiters.insert(queue, limiter);
+	} else {
+		limiter->setRate(bytesPerSecond);
+	}
+}
+
+qint64 DownloadQueue::bandwidthLimit(Queue queue) const
+{
+	BandwidthLimiter *limiter = m_bandwidthLimiters.value(queue);
+	return limiter != nullptr ? limiter->rate() : 0;
+}
+
+/**
+ * Downloads are scheduled fairly between sites, so that a slow one doesn't use all the slots.
+ */
+QString DownloadQueue::siteKey(ImageDownloader *downloader)
+{
+	Site *site = downloader->image()->parentSite();
+	return site != nullptr ? site->url() : QString();
+}
+
+void DownloadQueue::dequeued(const QVariant &variant)
+{
+	const auto item = variant.value<Item>();
+	const QString key = item.key;
+
+	// Downloads deleted while queued are skipped
+	ImageDownloader *downloader = item.downloader.data();
+	if (downloader == nullptr) {
+		m_queue->next(key);
+		return;
+	}
+
+	// The slot is released only once, whether the download is saved or deleted first
+	auto released = QSharedPointer<bool>::create(false);
+	const auto release = [this, key, released]() {
+		if (!*released) {
+			*released = true;
+			m_queue->next(key);
+		}
+	};
+	connect(downloader, &ImageDownloader::saved, m_queue, release);
+	connect(downloader, &QObject::destroyed, m_queue, release);
+
+	// Measure the download to adapt the number of simultaneous downloads of this site
+	if (m_adaptiveConcurrency != nullptr) {
+		QElapsedTimer timer;
+		timer.start();
+		auto bytes = QSharedPointer<qint64>::create(0);
+		connect(downloader, &ImageDownloader::downloadProgress, this, [bytes](const QSharedPointer<Image> &img, qint64 received, qint64 total) {
+			Q_UNUSED(img);
+			Q_UNUSED(total);
+			*bytes = received;
+		});
+		connect(downloader, &ImageDownloader::saved, this, [this, key, timer, bytes](const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result) {
+			Q_UNUSED(img);
+			const bool networkError = !result.isEmpty() && result.first().result == Image::SaveResult::NetworkError;
+			if (networkError || *bytes > 0) { // Ignore images that did not need downloading
+				m_adaptiveConcurrency->addResult(key, !networkError, *bytes, timer.elapsed());
+			}
+		});
+	}
 	connect(downloader, &ImageDownloader::saved, downloader, &ImageDownloader::deleteLater);
 	downloader->save();
 }
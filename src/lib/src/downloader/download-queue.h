@@ -1,9 +1,15 @@
 #ifndef DOWNLOAD_QUEUE_H
 #define DOWNLOAD_QUEUE_H
 
+#include <QMap>
+#include <QMetaType>
 #include <QObject>
+#include <QPointer>
+#include <QString>
 
 
+class AdaptiveConcurrency;
+class BandwidthLimiter;
 class ConcurrentMultiQueue;
 class ImageDownloader;
 
@@ -19,17 +25,54 @@ class DownloadQueue : public QObject
 			Background = 2,
 		};
 
-		explicit DownloadQueue(int maxConcurrency, QObject *parent = nullptr);
+		/**
+		 * @param maxConcurrency The maximum number of simultaneous downloads.
+		 * @param maxConcurrencyPerSite The maximum number of simultaneous downloads from the same source, 0 for no limit.
+		 */
+		explicit DownloadQueue(int maxConcurrency, QObject *parent = nullptr, int maxConcurrencyPerSite = 0);
+		~DownloadQueue() override;
+
+		/**
+		 * Queue a download, which is deleted once saved. Deleting it earlier cancels it and frees its slot.
+		 */
 		void add(Queue queue, ImageDownloader *downloader);
 
+		/**
+		 * Automatically adjust the number of simultaneous downloads of each site between the given bounds.
+		 */
+		void setAdaptiveConcurrency(int minConcurrency, int maxConcurrency);
+		AdaptiveConcurrency *adaptiveConcurrency() const;
+
+		/**
+		 * Limit the total download rate of the images of a queue, in bytes per second, 0 meaning no limit.
+		 */
+		void setBandwidthLimit(Queue queue, qint64 bytesPerSecond);
+		qint64 bandwidthLimit(Queue queue) const;
+
+		/**
+		 * The key is kept separately as it can't be computed anymore if the downloader is deleted while queued.
+		 */
+		struct Item
+		{
+			QPointer<ImageDownloader> downloader;
+			QString key;
+		};
+
 	signals:
 		void finished();
 
+	protected:
+		static QString siteKey(ImageDownloader *downloader);
+
 	protected slots:
-		void dequeued(const QVariant &item);
+		void dequeued(const QVariant &variant);
 
 	private:
 		ConcurrentMultiQueue *m_queue;
+		AdaptiveConcurrency *m_adaptiveConcurrency = nullptr;
+		QMap<Queue, BandwidthLimiter*> m_bandwidthLimiters;
 };
 
+Q_DECLARE_METATYPE(DownloadQueue::Item)
+
 #endif // DOWNLOAD_QUEUE_H
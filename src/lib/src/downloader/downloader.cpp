@@ -3,6 +3,7 @@
 #include <QEventLoop>
 #include <QObject>
 #include <QSettings>
+#include <QVector>
 #include <qmath.h>
 #include <iostream>
 #include <utility>
@@ -54,19 +55,31 @@ void Downloader::setQuit(bool quit)
 }
 
 
+/**
+ * All sites are loaded at the same time, each one still being throttled by its own network manager.
+ */
 QList<Page*> Downloader::getAllPagesTags()
 {
 	QList<Page*> pages;
-
 	for (auto *site : m_sites) {
-		auto *page = new Page(m_profile, site, m_sites, m_tags, m_page, m_perPage, m_postFiltering, true, this);
+		pages.append(new Page(m_profile, site, m_sites, m_tags, m_page, m_perPage, m_postFiltering, true, this));
+	}
 
-		QEventLoop loop;
-		QObject::connect(page, &Page::finishedLoadingTags, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+	QEventLoop loop;
+	int remaining = pages.count();
+	for (Page *page : qAsConst(pages)) {
+		QObject::connect(page, &Page::finishedLoadingTags, &loop, [&loop, &remaining]() {
+			if (--remaining == 0) {
+				loop.quit();
+			}
+		}, Qt::QueuedConnection);
+	}
+
+	for (Page *page : qAsConst(pages)) {
 		page->loadTags();
+	}
+	if (remaining > 0) {
 		loop.exec();
-
-		pages.append(page);
 	}
 
 	return pages;
@@ -139,6 +152,10 @@ void Downloader::getPageTags()
 	}
 }
 
+/**
+ * All the pages of all sites are loaded at the same time, each site still being throttled by its own network manager.
+ * When the printer supports it, each page's tags are printed as soon as they are received.
+ */
 void Downloader::getTags()
 {
 	if (m_sites.empty()) {
@@ -146,59 +163,89 @@ void Downloader::getTags()
 		return;
 	}
 
-	QList<Tag> results;
+	int pages = qCeil(static_cast<qreal>(m_max) / m_perPage);
+	if (pages <= 0 || m_perPage <= 0 || m_max <= 0) {
+		pages = 1;
+	}
 
+	QList<TagApi*> tagApis;
 	for (Site *site : qAsConst(m_sites)) {
 		Api *api = site->tagsApi();
 		if (api == nullptr) {
 			log(QStringLiteral("No valid API for loading tags for source: %1").arg(site->url()), Logger::Error);
+			qDeleteAll(tagApis);
 			return;
 		}
 
-		int pages = qCeil(static_cast<qreal>(m_max) / m_perPage);
-		if (pages <= 0 || m_perPage <= 0 || m_max <= 0) {
-			pages = 1;
-		}
-
 		for (int p = 0; p < pages; ++p) {
-			auto *tagApi = new TagApi(m_profile, site, api, m_page + p, m_perPage, "count", this);
+			tagApis.append(new TagApi(m_profile, site, api, m_page + p, m_perPage, "count", this));
+		}
+	}
 
-			QEventLoop loop;
-			QObject::connect(tagApi, &TagApi::finishedLoading, &loop, &QEventLoop::quit, Qt::QueuedConnection);
-			tagApi->load();
-			loop.exec();
+	const bool stream = m_quit && m_printer->canStream();
+	QVector<QList<Tag>> results(tagApis.count());
 
-			const QList<Tag> tags = tagApi->tags();
+	QEventLoop loop;
+	int remaining = tagApis.count();
+	for (int index = 0; index < tagApis.count(); ++index) {
+		TagApi *tagApi = tagApis[index];
+		QObject::connect(tagApi, &TagApi::finishedLoading, &loop, [this, &loop, &remaining, &results, stream, tagApi, index]() {
+			QList<Tag> tags = tagApi->tags();
 			log(QStringLiteral("Received pure tags (%1)").arg(tags.count()));
 			tagApi->deleteLater();
 
-			results.append(tags);
-		}
+			QMutableListIterator<Tag> i(tags);
+			while (i.hasNext()) {
+				if (i.next().count() < m_tagsMin) {
+					i.remove();
+				}
+			}
+
+			if (stream) {
+				if (!tags.isEmpty()) {
+					m_printer->print(tags, nullptr);
+				}
+			} else {
+				results[index] = tags;
+			}
+
+			if (--remaining == 0) {
+				loop.quit();
+			}
+		}, Qt::QueuedConnection);
 	}
 
-	QMutableListIterator<Tag> i(results);
-	while (i.hasNext()) {
-		if (i.next().count() < m_tagsMin) {
-			i.remove();
-		}
+	for (TagApi *tagApi : qAsConst(tagApis)) {
+		tagApi->load();
+	}
+	loop.exec();
+
+	if (stream) {
+		emit quit();
+		return;
+	}
+
+	// Keep the order of the sites and pages
+	QList<Tag> all;
+	for (const QList<Tag> &tags : qAsConst(results)) {
+		all.append(tags);
 	}
 
 	if (m_quit) {
-		m_printer->print(results, nullptr);
+		m_printer->print(all, nullptr);
 		emit quit();
 	} else {
-		emit finishedTags(results);
+		emit finishedTags(all);
 	}
 }
 
-QList<QSharedPointer<Image>> Downloader::getAllImages()
+void Downloader::loadImages(const std::function<void(const QList<QSharedPointer<Image>> &)> &callback)
 {
 	const bool usePacking = m_profile->getSettings()->value("packing_enable", true).toBool();
 	const int imagesPerPack = m_profile->getSettings()->value("packing_size", 1000).toInt();
 	const int packSize = usePacking ? imagesPerPack : -1;
 
 	QSet<QString> md5s;
-	QList<QSharedPointer<Image>> images;
 
 	for (auto *site : m_sites) {
 		DownloadQueryGroup query(m_tags, m_page, m_perPage, m_max, m_postFiltering, m_blacklist, site, m_filename, m_location);
@@ -207,6 +254,8 @@ QList<QSharedPointer<Image>> Downloader::getAllImages()
 		loader.start(m_login);
 		while (loader.hasNext()) {
 			const auto next = loader.next();
+
+			QList<QSharedPointer<Image>> images;
 			for (const auto &img : next) {
 				if (m_noDuplicates) {
 					if (md5s.contains(img->md5())) {
@@ -216,9 +265,20 @@ QList<QSharedPointer<Image>> Downloader::getAllImages()
 				}
 				images.append(img);
 			}
+
+			if (!images.isEmpty()) {
+				callback(images);
+			}
 		}
 	}
+}
 
+QList<QSharedPointer<Image>> Downloader::getAllImages()
+{
+	QList<QSharedPointer<Image>> images;
+	loadImages([&images](const QList<QSharedPointer<Image>> &pack) {
+		images.append(pack);
+	});
 	return images;
 }
 
@@ -260,6 +320,18 @@ void Downloader::getUrls()
 		return;
 	}
 
+	// Print each pack as soon as it's loaded, without keeping the images in memory
+	if (m_quit && m_printer->canStream()) {
+		loadImages([this](const QList<QSharedPointer<Image>> &images) {
+			if (m_loadMoreDetails) {
+				loadMoreDetails(images);
+			}
+			m_printer->print(images);
+		});
+		emit quit();
+		return;
+	}
+
 	const auto images = getAllImages();
 
 	if (m_loadMoreDetails) {
@@ -6,6 +6,7 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <functional>
 #include "models/filtering/blacklist.h"
 #include "models/image.h"
 #include "tags/tag.h"
@@ -40,6 +41,7 @@ class Downloader : public QObject
 		void quit();
 
 	protected:
+		void loadImages(const std::function<void(const QList<QSharedPointer<Image>> &)> &callback);
 		QList<QSharedPointer<Image>> getAllImages();
 		QList<Page*> getAllPagesTags();
 
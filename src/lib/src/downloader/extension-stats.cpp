@@ -0,0 +1,117 @@
+#include "downloader/extension-stats.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <utility>
+#include "logger.h"
+
+#define ID_RANGE_SIZE 100000
+
+
+ExtensionStats::ExtensionStats(QString file)
+	: m_file(std::move(file))
+{
+	load();
+}
+
+ExtensionStats::~ExtensionStats()
+{
+	save();
+}
+
+qulonglong ExtensionStats::range(qulonglong id)
+{
+	return id / ID_RANGE_SIZE;
+}
+
+
+void ExtensionStats::add(qulonglong id, const QString &extension)
+{
+	if (extension.isEmpty()) {
+		return;
+	}
+
+	m_ranges[range(id)][extension]++;
+	m_total[extension]++;
+	m_changed = true;
+}
+
+int ExtensionStats::count(qulonglong id, const QString &extension) const
+{
+	return m_ranges.value(range(id)).value(extension);
+}
+
+QStringList ExtensionStats::sort(qulonglong id, const QStringList &extensions) const
+{
+	if (m_total.isEmpty()) {
+		return extensions;
+	}
+
+	// Use the counts of nearby images first, and the ones of the whole site for ties
+	const QHash<QString, int> counts = m_ranges.value(range(id));
+	QStringList ret = extensions;
+	std::stable_sort(ret.begin(), ret.end(), [&counts, this](const QString &a, const QString &b) {
+		const int countA = counts.value(a);
+		const int countB = counts.value(b);
+		if (countA != countB) {
+			return countA > countB;
+		}
+		return m_total.value(a) > m_total.value(b);
+	});
+	return ret;
+}
+
+
+void ExtensionStats::load()
+{
+	if (m_file.isEmpty()) {
+		return;
+	}
+
+	QFile f(m_file);
+	if (!f.exists() || !f.open(QFile::ReadOnly)) {
+		return;
+	}
+
+	const QJsonObject ranges = QJsonDocument::fromJson(f.readAll()).object()["ranges"].toObject();
+	for (auto it = ranges.constBegin(); it != ranges.constEnd(); ++it) {
+		const qulonglong key = it.key().toULongLong();
+		const QJsonObject counts = it.value().toObject();
+		for (auto cit = counts.constBegin(); cit != counts.constEnd(); ++cit) {
+			const int count = cit.value().toInt();
+			m_ranges[key][cit.key()] += count;
+			m_total[cit.key()] += count;
+		}
+	}
+}
+
+bool ExtensionStats::save()
+{
+	if (m_file.isEmpty() || !m_changed) {
+		return true;
+	}
+
+	QJsonObject ranges;
+	for (auto it = m_ranges.constBegin(); it != m_ranges.constEnd(); ++it) {
+		QJsonObject counts;
+		for (auto cit = it.value().constBegin(); cit != it.value().constEnd(); ++cit) {
+			counts[cit.key()] = cit.value();
+		}
+		ranges[QString::number(it.key())] = counts;
+	}
+
+	QJsonObject json;
+	json["ranges"] = ranges;
+
+	QFile f(m_file);
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not save extension statistics to `%1`").arg(m_file), Logger::Warning);
+		return false;
+	}
+	f.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+	f.close();
+
+	m_changed = false;
+	return true;
+}
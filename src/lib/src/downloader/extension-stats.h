@@ -0,0 +1,42 @@
+#ifndef EXTENSION_STATS_H
+#define EXTENSION_STATS_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+
+/**
+ * Learns which file extensions a site actually uses, so that the most likely ones are tried first when the real
+ * extension of an image is unknown.
+ *
+ * Extensions are counted per range of image IDs, as sites tend to change their preferred formats over time.
+ */
+class ExtensionStats
+{
+	public:
+		explicit ExtensionStats(QString file = QString());
+		~ExtensionStats();
+
+		void add(qulonglong id, const QString &extension);
+		int count(qulonglong id, const QString &extension) const;
+
+		/**
+		 * Sort the given extensions from the most to the least likely for this ID, keeping the original order for ties.
+		 */
+		QStringList sort(qulonglong id, const QStringList &extensions) const;
+
+		bool save();
+
+	protected:
+		void load();
+		static qulonglong range(qulonglong id);
+
+	private:
+		QString m_file;
+		QHash<qulonglong, QHash<QString, int>> m_ranges;
+		QHash<QString, int> m_total;
+		bool m_changed = false;
+};
+
+#endif // EXTENSION_STATS_H
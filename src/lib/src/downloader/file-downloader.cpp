@@ -3,26 +3,50 @@
 #include "functions.h"
 #include "logger.h"
 #include "network/network-reply.h"
+#include "utils/zip-writer.h"
+#ifdef Q_OS_LINUX
+	#include <fcntl.h>
+#endif
 
-#define WRITE_BUFFER_SIZE (200 * 1024)
+#define WRITE_BUFFER_SIZE (512 * 1024)
+#define HEAD_SIZE 100
 
 
 FileDownloader::FileDownloader(bool allowHtmlResponses, QObject *parent)
-	: QObject(parent), m_allowHtmlResponses(allowHtmlResponses), m_reply(nullptr), m_readSize(0), m_writeError(false)
+	: QObject(parent), m_allowHtmlResponses(allowHtmlResponses), m_reply(nullptr), m_hash(QCryptographicHash::Md5), m_hashValid(false), m_offset(0), m_readSize(0), m_expectedSize(-1), m_uncachedThreshold(-1), m_syncedSize(0), m_droppedSize(0), m_resumable(false), m_initialized(false), m_rangeError(false), m_writeError(false)
 {}
 
-bool FileDownloader::start(NetworkReply *reply, const QString &path)
+/**
+ * Start writing the reply's data to a file.
+ *
+ * @param reply The reply to read from
+ * @param path The destination file
+ * @param offset If positive, the position in the existing file at which the reply's data starts, when resuming a download using a "Range" request
+ * @return Whether the file could be opened
+ */
+bool FileDownloader::start(NetworkReply *reply, const QString &path, qint64 offset)
 {
+	// We do our own buffering, so there is no need for QFile to copy the data once more
 	m_file.setFileName(path);
-	const bool ok = m_file.open(QFile::WriteOnly | QFile::Truncate);
+	const QIODevice::OpenMode mode = offset > 0 ? QFile::WriteOnly : QFile::WriteOnly | QFile::Truncate;
+	const bool ok = m_file.open(mode | QFile::Unbuffered);
 
+	m_offset = qMax(static_cast<qint64>(0), offset);
 	m_readSize = 0;
+	m_expectedSize = -1;
+	m_initialized = false;
+	m_rangeError = false;
+	m_syncedSize = 0;
+	m_droppedSize = 0;
+	m_head.clear();
+	m_hash.reset();
+	m_hashValid = true;
 	m_writeError = false;
 	m_reply = reply;
+	m_zip = nullptr;
 
 	if (ok) {
-		connect(reply, &NetworkReply::readyRead, this, &FileDownloader::replyReadyRead);
-		connect(reply, &NetworkReply::finished, this, &FileDownloader::replyFinished);
+		connectReply(reply);
 	} else {
 		log(QStringLiteral("Unable to open file '%1': %2 (%3)").arg(path, m_file.errorString(), QString::number(m_file.error())), Logger::Error);
 	}
@@ -30,48 +54,280 @@ bool FileDownloader::start(NetworkReply *reply, const QString &path)
 	return ok;
 }
 
+/**
+ * Start writing the reply's data directly into a ZIP archive, without any intermediate file.
+ * The file is removed from the archive if the download fails. Downloads written to archives cannot be resumed.
+ *
+ * @param reply The reply to read from
+ * @param zip The archive to write to, which must stay open until the download finishes
+ * @param name The path of the file in the archive
+ * @return Whether the file could be added to the archive
+ */
+bool FileDownloader::start(NetworkReply *reply, ZipWriter *zip, const QString &name)
+{
+	const bool ok = zip->beginFile(name, ZipWriter::shouldCompress(name));
+
+	m_offset = 0;
+	m_readSize = 0;
+	m_expectedSize = -1;
+	m_initialized = false;
+	m_rangeError = false;
+	m_syncedSize = 0;
+	m_droppedSize = 0;
+	m_head.clear();
+	m_hash.reset();
+	m_hashValid = true;
+	m_writeError = false;
+	m_reply = reply;
+	m_zip = zip;
+
+	if (ok) {
+		connectReply(reply);
+	} else {
+		log(QStringLiteral("Unable to add file '%1' to zip: %2").arg(name, zip->errorString()), Logger::Error);
+	}
+
+	return ok;
+}
+
+void FileDownloader::connectReply(NetworkReply *reply)
+{
+	connect(reply, &NetworkReply::readyRead, this, &FileDownloader::replyReadyRead);
+	connect(reply, &NetworkReply::finished, this, &FileDownloader::replyFinished);
+}
+
+/**
+ * Files bigger than this size (in bytes) are written without keeping them in the system's page cache.
+ * A negative value disables this behavior.
+ */
+void FileDownloader::setUncachedThreshold(qint64 threshold)
+{
+	m_uncachedThreshold = threshold;
+}
+
+/**
+ * Keep the partially downloaded file on network errors, so that the download can be resumed later.
+ */
+void FileDownloader::setResumable(bool resumable)
+{
+	m_resumable = resumable;
+}
+
+/**
+ * The position in the file at which the current reply's data is written.
+ * Will be reset to zero if the server does not support "Range" requests.
+ */
+qint64 FileDownloader::offset() const
+{
+	return m_offset;
+}
+
+/**
+ * The MD5 of the whole file, computed while writing it, so that it does not need to be read again afterwards.
+ * Only available once the download succeeded, empty otherwise.
+ */
+QString FileDownloader::md5() const
+{
+	if (!m_hashValid) {
+		return QString();
+	}
+	return m_hash.result().toHex();
+}
+
+
+/**
+ * Called once before writing any data, when the reply's headers are available.
+ *
+ * @return False if the server returned an unexpected range
+ */
+bool FileDownloader::init()
+{
+	m_initialized = true;
+
+	if (m_offset > 0) {
+		const int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+		// The server ignored our range request and sent the whole file
+		if (statusCode != 206) {
+			m_offset = 0;
+			m_file.resize(0);
+		} else {
+			// Content-Range: bytes <start>-<end>/<total>
+			const QByteArray contentRange = m_reply->rawHeader("Content-Range");
+			const int space = contentRange.indexOf(' ');
+			const int dash = contentRange.indexOf('-');
+			const qint64 start = space >= 0 && dash > space ? contentRange.mid(space + 1, dash - space - 1).toLongLong() : -1;
+			if (start != m_offset) {
+				log(QStringLiteral("Invalid range returned for url '%1': %2").arg(m_reply->url().toString(), QString(contentRange)), Logger::Warning);
+				m_rangeError = true;
+				return false;
+			}
+			m_file.seek(m_offset);
+			m_hashValid = hashExistingData();
+		}
+	}
+
+	preallocate();
+	return true;
+}
+
+/**
+ * When resuming a download, add the part of the file that was already downloaded to the hash.
+ *
+ * @return Whether the existing data could be read
+ */
+bool FileDownloader::hashExistingData()
+{
+	QFile existing(m_file.fileName());
+	if (!existing.open(QFile::ReadOnly) || existing.size() != m_offset) {
+		return false;
+	}
+
+	const bool ok = m_hash.addData(&existing);
+	existing.close();
+	return ok;
+}
+
+
+/**
+ * Write the available data to the file in chunks of at least "minSize" bytes, using a reusable buffer.
+ *
+ * @return Whether all writes succeeded
+ */
+bool FileDownloader::writeAvailable(qint64 minSize)
+{
+	if (m_buffer.size() < WRITE_BUFFER_SIZE) {
+		m_buffer.resize(WRITE_BUFFER_SIZE);
+	}
+
+	while (m_reply->bytesAvailable() > 0 && m_reply->bytesAvailable() >= minSize) {
+		const qint64 size = m_reply->read(m_buffer.data(), m_buffer.size());
+		if (size <= 0) {
+			break;
+		}
+
+		// Keep the first bytes to detect HTML responses
+		if (m_head.size() < HEAD_SIZE) {
+			m_head.append(m_buffer.constData(), static_cast<int>(qMin(static_cast<qint64>(HEAD_SIZE - m_head.size()), size)));
+		}
+
+		m_readSize += size;
+		if (!writeData(m_buffer.constData(), size)) {
+			return false;
+		}
+		m_hash.addData(m_buffer.constData(), static_cast<int>(size));
+		dropWrittenPages();
+	}
+
+	return true;
+}
+
+bool FileDownloader::writeData(const char *data, qint64 size)
+{
+	if (m_zip != nullptr) {
+		return m_zip->write(data, size);
+	}
+	return m_file.write(data, size) >= 0;
+}
+
+/**
+ * Reserve the space for the whole file on disk, to prevent fragmentation.
+ * The file's size is not changed so that partial downloads are still detected.
+ */
+void FileDownloader::preallocate()
+{
+	const QByteArray contentLength = m_reply->rawHeader("Content-Length");
+	if (contentLength.isEmpty()) {
+		m_expectedSize = 0;
+		return;
+	}
+	m_expectedSize = m_offset + contentLength.toLongLong();
+
+	#ifdef Q_OS_LINUX
+		if (m_expectedSize > WRITE_BUFFER_SIZE && m_zip == nullptr) {
+			// Failures are ignored as this is only an optimization (the file system might not support it)
+			fallocate(m_file.handle(), FALLOC_FL_KEEP_SIZE, 0, m_expectedSize);
+		}
+	#endif
+}
+
+/**
+ * For big files, write the data to the disk as it comes and drop it from the page cache.
+ */
+void FileDownloader::dropWrittenPages()
+{
+	if (m_uncachedThreshold < 0 || m_expectedSize < m_uncachedThreshold || m_zip != nullptr) {
+		return;
+	}
+
+	#ifdef Q_OS_LINUX
+		// Start the write-back of the new data, and drop the previous chunk which should be written by now
+		const int fd = m_file.handle();
+		sync_file_range(fd, m_syncedSize, m_readSize - m_syncedSize, SYNC_FILE_RANGE_WRITE);
+		if (m_syncedSize > m_droppedSize) {
+			sync_file_range(fd, m_droppedSize, m_syncedSize - m_droppedSize, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+			posix_fadvise(fd, m_droppedSize, m_syncedSize - m_droppedSize, POSIX_FADV_DONTNEED);
+			m_droppedSize = m_syncedSize;
+		}
+		m_syncedSize = m_readSize;
+	#endif
+}
+
 
 void FileDownloader::replyReadyRead()
 {
-	if (m_reply->bytesAvailable() < WRITE_BUFFER_SIZE) {
+	if (m_rangeError) {
+		return;
+	}
+	if (!m_initialized && !init()) {
+		m_reply->abort();
 		return;
 	}
 
-	const QByteArray data = m_reply->readAll();
-	m_readSize += data.size();
+	if (m_reply->bytesAvailable() < WRITE_BUFFER_SIZE) {
+		return;
+	}
 
-	if (m_file.write(data) < 0) {
+	if (!writeAvailable(WRITE_BUFFER_SIZE)) {
 		m_writeError = true;
 		m_reply->abort();
-	} else {
-		m_file.flush();
 	}
 }
 
 void FileDownloader::replyFinished()
 {
-	const QByteArray data = m_reply->readAll();
-	m_readSize += data.size();
-
-	const qint64 written = m_file.write(data);
+	if (!m_initialized && !m_rangeError && m_reply->bytesAvailable() > 0) {
+		init();
+	}
+	const bool failedLastWrite = !m_writeError && !m_rangeError && !writeAvailable(0);
 	m_file.close();
 
-	const auto error = m_reply->error();
-	const auto msg = m_reply->errorString();
+	const auto error = m_rangeError ? NetworkReply::NetworkError::UnknownContentError : m_reply->error();
+	const auto msg = m_rangeError ? QStringLiteral("Invalid range returned") : m_reply->errorString();
 	const QUrl redirectUrl = m_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
-	const bool failedLastWrite = data.length() > 0 && written < 0;
-	const bool invalidHtml = !m_allowHtmlResponses && QString(data.left(100)).trimmed().startsWith("<!DOCTYPE", Qt::CaseInsensitive);
-	const bool emptyFile = m_readSize == 0 && redirectUrl.isEmpty();
+	const bool invalidHtml = !m_allowHtmlResponses && m_offset == 0 && QString(m_head).trimmed().startsWith("<!DOCTYPE", Qt::CaseInsensitive);
+	const bool emptyFile = m_offset + m_readSize == 0 && redirectUrl.isEmpty();
 
 	if (error != NetworkReply::NetworkError::NoError || failedLastWrite || invalidHtml || emptyFile) {
 		// Ignore those errors as they are caused by a bug in Qt
 		if (error != NetworkReply::NetworkError::NoError && msg.contains("140E0197")) {
 			log(QStringLiteral("Ignored network error '140E0197' for the image: `%1`: %2 (%3)").arg(m_reply->url().toString().toHtmlEscaped()).arg(error).arg(msg), Logger::Info);
+			if (m_zip != nullptr) {
+				m_zip->endFile();
+			}
 			emit success();
 			return;
 		}
 
-		m_file.remove();
+		// Keep partial downloads after network errors so that they can be resumed
+		m_hashValid = false;
+		const bool partial = m_resumable && !failedLastWrite && !m_writeError && !m_rangeError && !invalidHtml && m_offset + m_readSize > 0;
+		if (m_zip != nullptr) {
+			m_zip->abortFile();
+		} else if (!partial) {
+			m_file.remove();
+		}
+
 		if (failedLastWrite || m_writeError) {
 			emit writeError();
 		} else if (invalidHtml) {
@@ -86,5 +342,12 @@ void FileDownloader::replyFinished()
 		return;
 	}
 
+	// The archive's file is only complete once its data descriptor is written
+	if (m_zip != nullptr && !m_zip->endFile()) {
+		m_hashValid = false;
+		emit writeError();
+		return;
+	}
+
 	emit success();
 }
@@ -1,12 +1,15 @@
 #ifndef FILE_DOWNLOADER_H
 #define FILE_DOWNLOADER_H
 
+#include <QByteArray>
+#include <QCryptographicHash>
 #include <QFile>
 #include <QObject>
 #include "network/network-reply.h"
 
 
 class QString;
+class ZipWriter;
 
 class FileDownloader : public QObject
 {
@@ -14,13 +17,27 @@ class FileDownloader : public QObject
 
 	public:
 		explicit FileDownloader(bool allowHtmlResponses, QObject *parent = nullptr);
-		bool start(NetworkReply *reply, const QString &path);
+		bool start(NetworkReply *reply, const QString &path, qint64 offset = 0);
+		bool start(NetworkReply *reply, ZipWriter *zip, const QString &name);
+		void setUncachedThreshold(qint64 threshold);
+		void setResumable(bool resumable);
+		qint64 offset() const;
+		QString md5() const;
 
 	signals:
 		void writeError();
 		void networkError(NetworkReply::NetworkError error, const QString &errorString);
 		void success();
 
+	protected:
+		bool init();
+		bool writeAvailable(qint64 minSize);
+		bool writeData(const char *data, qint64 size);
+		void connectReply(NetworkReply *reply);
+		void preallocate();
+		bool hashExistingData();
+		void dropWrittenPages();
+
 	private slots:
 		void replyReadyRead();
 		void replyFinished();
@@ -29,7 +46,20 @@ class FileDownloader : public QObject
 		bool m_allowHtmlResponses;
 		NetworkReply *m_reply;
 		QFile m_file;
-		int m_readSize;
+		ZipWriter *m_zip = nullptr;
+		QByteArray m_buffer;
+		QByteArray m_head;
+		QCryptographicHash m_hash;
+		bool m_hashValid;
+		qint64 m_offset;
+		qint64 m_readSize;
+		qint64 m_expectedSize;
+		qint64 m_uncachedThreshold;
+		qint64 m_syncedSize;
+		qint64 m_droppedSize;
+		bool m_resumable;
+		bool m_initialized;
+		bool m_rangeError;
 		bool m_writeError;
 };
 
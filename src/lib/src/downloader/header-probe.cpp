@@ -0,0 +1,159 @@
+#include "downloader/header-probe.h"
+#include <QBuffer>
+#include <QCache>
+#include <QImageReader>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkRequest>
+#include "functions.h"
+#include "logger.h"
+#include "models/image.h"
+#include "models/site.h"
+#include "network/network-reply.h"
+
+// Enough for the headers of most images, JPEG files with a big EXIF thumbnail being the exception
+#define PROBE_SIZE (16 * 1024)
+#define PROBE_CACHE_SIZE 10000
+
+
+static QMutex cacheMutex;
+static QCache<QString, HeaderProbe::Result> cache(PROBE_CACHE_SIZE);
+
+
+HeaderProbe::HeaderProbe(Site *site, QObject *parent)
+	: QObject(parent), m_site(site)
+{}
+
+HeaderProbe::~HeaderProbe()
+{
+	for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+		it.key()->disconnect(this);
+		it.key()->abort();
+		it.key()->deleteLater();
+	}
+}
+
+
+void HeaderProbe::probe(const QList<QSharedPointer<Image>> &images)
+{
+	const QMap<QString, QString> headers { { "Range", "bytes=0-" + QString::number(PROBE_SIZE - 1) } };
+
+	for (const QSharedPointer<Image> &img : images) {
+		const QString url = img->url(Image::Size::Full).toString();
+		if (url.isEmpty()) {
+			continue;
+		}
+
+		{
+			QMutexLocker locker(&cacheMutex);
+			const Result *cached = cache.object(url);
+			if (cached != nullptr) {
+				apply(img.data(), *cached);
+				continue;
+			}
+		}
+
+		NetworkReply *reply = m_site->get(m_site->fixUrl(url), Site::QueryType::Details, img->parentUrl(), QStringLiteral("image"), img.data(), headers);
+		Pending pending;
+		pending.image = img;
+		pending.url = url;
+		m_pending.insert(reply, pending);
+
+		connect(reply, &NetworkReply::readyRead, this, [this, reply]() { readyRead(reply); });
+		connect(reply, &NetworkReply::finished, this, [this, reply]() { done(reply); });
+	}
+
+	if (m_pending.isEmpty()) {
+		emit finished();
+	}
+}
+
+void HeaderProbe::readyRead(NetworkReply *reply)
+{
+	auto it = m_pending.find(reply);
+	if (it == m_pending.end()) {
+		return;
+	}
+
+	it->data.append(reply->readAll());
+
+	// Servers not supporting ranges send the whole file, which we don't need
+	if (it->data.size() >= PROBE_SIZE) {
+		done(reply);
+	}
+}
+
+void HeaderProbe::done(NetworkReply *reply)
+{
+	auto it = m_pending.find(reply);
+	if (it == m_pending.end()) {
+		return;
+	}
+	Pending pending = it.value();
+	m_pending.erase(it);
+
+	pending.data.append(reply->readAll());
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (statusCode == 200 || statusCode == 206) {
+		const qint64 contentLength = statusCode == 200 && reply->rawHeader("Content-Length").toLongLong() > 0
+			? reply->rawHeader("Content-Length").toLongLong()
+			: -1;
+		const Result result = parse(pending.data, reply->rawHeader("Content-Range"), contentLength);
+		log(QStringLiteral("Probed `%1`: %2x%3, %4 bytes").arg(pending.url).arg(result.size.width()).arg(result.size.height()).arg(result.fileSize), Logger::Debug);
+		apply(pending.image.data(), result);
+
+		QMutexLocker locker(&cacheMutex);
+		cache.insert(pending.url, new Result(result));
+	} else {
+		log(QStringLiteral("Could not probe `%1` (status %2)").arg(pending.url).arg(statusCode), Logger::Debug);
+	}
+
+	reply->disconnect(this);
+	if (reply->isRunning()) {
+		reply->abort();
+	}
+	reply->deleteLater();
+
+	if (m_pending.isEmpty()) {
+		emit finished();
+	}
+}
+
+
+HeaderProbe::Result HeaderProbe::parse(const QByteArray &data, const QByteArray &contentRange, qint64 contentLength)
+{
+	Result ret;
+
+	// Content-Range: bytes <start>-<end>/<total>, the total being "*" if unknown
+	const int slash = contentRange.lastIndexOf('/');
+	if (slash >= 0) {
+		bool ok;
+		const qint64 total = contentRange.mid(slash + 1).trimmed().toLongLong(&ok);
+		if (ok && total > 0) {
+			ret.fileSize = total;
+		}
+	} else if (contentLength > 0) {
+		ret.fileSize = contentLength;
+	}
+
+	// Image readers only need the header to get the dimensions, even if the rest of the file is missing
+	QByteArray header = data;
+	QBuffer buffer(&header);
+	buffer.open(QIODevice::ReadOnly);
+	QImageReader reader(&buffer);
+	ret.size = reader.size();
+	ret.format = getExtensionFromHeader(data.left(12));
+
+	return ret;
+}
+
+void HeaderProbe::apply(Image *img, const Result &result)
+{
+	if (result.size.isValid() && !result.size.isEmpty() && img->size().isEmpty()) {
+		img->setSize(result.size, Image::Size::Full);
+	}
+	if (result.fileSize > 0 && img->fileSize() <= 0) {
+		img->setFileSize(static_cast<int>(result.fileSize), Image::Size::Full);
+	}
+}
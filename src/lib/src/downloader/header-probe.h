@@ -0,0 +1,73 @@
+#ifndef HEADER_PROBE_H
+#define HEADER_PROBE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QSize>
+#include <QString>
+
+
+class Image;
+class NetworkReply;
+class Site;
+
+/**
+ * Reads the dimensions and size of image files without downloading them.
+ *
+ * Only the first kilobytes of each file are requested using a "Range" request, which is enough to read the header of
+ * most image formats, and the size of the whole file is read from the "Content-Range" header of the same response.
+ * Results are cached by file URL, so that the same post is only probed once.
+ */
+class HeaderProbe : public QObject
+{
+	Q_OBJECT
+
+	public:
+		struct Result
+		{
+			QSize size;
+			qint64 fileSize = -1;
+			QString format;
+		};
+
+		explicit HeaderProbe(Site *site, QObject *parent = nullptr);
+		~HeaderProbe() override;
+
+		/**
+		 * Probe the full size files of the given images, setting their missing dimensions and file size.
+		 * Emits finished() once all of them are done, possibly synchronously if they were all cached.
+		 */
+		void probe(const QList<QSharedPointer<Image>> &images);
+
+		/**
+		 * Read the first bytes of a file and its response headers.
+		 *
+		 * @param contentRange The "Content-Range" header of a partial response
+		 * @param contentLength The "Content-Length" header of a full response, or -1 for partial ones
+		 */
+		static Result parse(const QByteArray &data, const QByteArray &contentRange, qint64 contentLength);
+
+	protected:
+		static void apply(Image *img, const Result &result);
+		void readyRead(NetworkReply *reply);
+		void done(NetworkReply *reply);
+
+	signals:
+		void finished();
+
+	private:
+		struct Pending
+		{
+			QSharedPointer<Image> image;
+			QString url;
+			QByteArray data;
+		};
+
+		Site *m_site;
+		QHash<NetworkReply*, Pending> m_pending;
+};
+
+#endif // HEADER_PROBE_H
@@ -1,22 +1,39 @@
 #include "downloader/image-downloader.h"
+#include <QBuffer>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QImageReader>
+#include <QMetaEnum>
 #include <QSettings>
 #include <QSize>
 #include <QUuid>
 #include <utility>
+#include "details-batcher.h"
 #include "extension-rotator.h"
+#include "extension-stats.h"
 #include "file-downloader.h"
+#include "filename/conditional-filename.h"
+#include "filename/filename-requirements.h"
 #include "functions.h"
 #include "logger.h"
+#include "metrics.h"
 #include "models/api/api.h"
 #include "models/filename.h"
 #include "models/image.h"
 #include "models/profile.h"
+#include "models/profile-settings-snapshot.h"
 #include "models/site.h"
 #include "models/source.h"
+#include "network/mirror-selector.h"
 #include "network/network-reply.h"
+#include "network/throughput-estimator.h"
+#include "tracer.h"
+#include "transcoder.h"
+#include "utils/directory-index.h"
+#include "utils/disk-scheduler.h"
+#include "utils/file-utils.h"
 
 
 static void addMd5(Profile *profile, const QString &path)
@@ -32,16 +49,27 @@ static void addMd5(Profile *profile, const QString &path)
 }
 
 
+/**
+ * Get the path of the hidden file a download is written to before being renamed to its destination.
+ */
+static QString partPath(const QString &path)
+{
+	const int sep = path.lastIndexOf(QDir::separator());
+	return path.left(sep + 1) + QLatin1Char('.') + path.mid(sep + 1) + QStringLiteral(".part");
+}
+
 ImageDownloader::ImageDownloader(Profile *profile, QSharedPointer<Image> img, QString filename, QString path, int count, bool addMd5, bool startCommands, QObject *parent, bool loadTags, bool rotate, bool force, Image::Size size, bool postSave, bool forceExisting)
 	: QObject(parent), m_profile(profile), m_image(std::move(img)), m_fileDownloader(false, this), m_filename(std::move(filename)), m_path(std::move(path)), m_loadTags(loadTags), m_count(count), m_addMd5(addMd5), m_startCommands(startCommands), m_writeError(false), m_rotate(rotate), m_force(force), m_postSave(postSave), m_forceExisting(forceExisting)
 {
 	setSize(size);
+	connect(this, &ImageDownloader::saved, this, &ImageDownloader::recordMetrics);
 }
 
 ImageDownloader::ImageDownloader(Profile *profile, QSharedPointer<Image> img, QStringList paths, int count, bool addMd5, bool startCommands, QObject *parent, bool rotate, bool force, Image::Size size, bool postSave, bool forceExisting)
 	: QObject(parent), m_profile(profile), m_image(std::move(img)), m_fileDownloader(false, this), m_loadTags(false), m_paths(std::move(paths)), m_count(count), m_addMd5(addMd5), m_startCommands(startCommands), m_writeError(false), m_rotate(rotate), m_force(force), m_postSave(postSave), m_forceExisting(forceExisting)
 {
 	setSize(size);
+	connect(this, &ImageDownloader::saved, this, &ImageDownloader::recordMetrics);
 }
 
 ImageDownloader::~ImageDownloader()
@@ -56,10 +84,15 @@ bool ImageDownloader::isRunning() const
 	return m_reply != nullptr && m_reply->isRunning();
 }
 
+QSharedPointer<Image> ImageDownloader::image() const
+{
+	return m_image;
+}
+
 void ImageDownloader::setSize(Image::Size size)
 {
 	if (size == Image::Size::Unknown) {
-		const bool getOriginals = m_profile->getSettings()->value("Save/downloadoriginals", true).toBool();
+		const bool getOriginals = m_profile->settingsSnapshot()->downloadOriginals;
 		const bool hasSample = m_image->url(Image::Size::Sample).isEmpty();
 		if (getOriginals || !hasSample) {
 			m_size = Image::Size::Full;
@@ -76,17 +109,34 @@ void ImageDownloader::setBlacklist(Blacklist *blacklist)
 	m_blacklist = blacklist;
 }
 
+void ImageDownloader::setDirectoryIndex(DirectoryIndex *directoryIndex)
+{
+	m_directoryIndex = directoryIndex;
+}
+
+/**
+ * Limit the download rate of the image file, for example to the share of bandwidth of its download queue.
+ */
+void ImageDownloader::setBandwidthLimiter(BandwidthLimiter *limiter)
+{
+	m_bandwidthLimiter = limiter;
+}
+
 void ImageDownloader::save()
 {
+	Tracer::getInstance().asyncBegin(QStringLiteral("download"), QStringLiteral("download"), reinterpret_cast<quintptr>(this), QVariantMap { { "url", m_image->url().toString() } });
+
 	// Always load details if the API doesn't provide the file URL in the listing page
 	const QStringList forcedTokens = m_image->parentSite()->getApis().first()->forcedTokens();
 	const bool needFileUrl = forcedTokens.contains("*") || forcedTokens.contains("file_url");
 
 	// If we use direct saving or don't want to load tags, we directly save the image
-	const int globalNeedTags = needExactTags(m_profile->getSettings());
-	const int localNeedTags = m_filename.needExactTags(m_image->parentSite(), m_profile->getSettings());
-	const int needTags = qMax(globalNeedTags, localNeedTags);
-	const bool filenameNeedTags = needTags == 2 || (needTags == 1 && m_image->hasUnknownTag());
+	QSettings *settings = m_profile->getSettings();
+	const QStringList customTokens = getCustoms(settings).keys();
+	FilenameRequirements requirements = ImageDownloader::requirements(settings);
+	requirements.add(m_filename.requirements());
+	const int needTags = requirements.needExactTags(forcedTokens, customTokens);
+	const bool filenameNeedTags = needTags > 0 && requirements.needDetails(*m_image, forcedTokens, customTokens);
 	const bool blacklistNeedTags = m_blacklist != nullptr && m_image->tags().isEmpty();
 	if (!blacklistNeedTags && !needFileUrl && (!m_loadTags || !m_paths.isEmpty() || !filenameNeedTags)) {
 		loadedSave(Image::LoadTagsResult::Ok);
@@ -95,20 +145,27 @@ void ImageDownloader::save()
 
 	log(QStringLiteral("Not enough information to directly load the image (from blacklist: %1 / from file url: %2 / from filename tags: %3/%4)").arg(blacklistNeedTags).arg(needFileUrl).arg(filenameNeedTags).arg(needTags), Logger::Info);
 	connect(m_image.data(), &Image::finishedLoadingTags, this, &ImageDownloader::loadedSave);
-	m_image->loadDetails();
+	m_image->parentSite()->detailsBatcher()->loadDetails(m_image);
+}
+
+int ImageDownloader::needExactTags(QSettings *settings)
+{
+	return requirements(settings).needExactTags({}, getCustoms(settings).keys());
 }
 
-int ImageDownloader::needExactTags(QSettings *settings) const
+FilenameRequirements ImageDownloader::requirements(QSettings *settings)
 {
-	int need = 0;
+	FilenameRequirements ret;
+
+	// Check conditional filenames
+	for (const ConditionalFilename &filename : getFilenames(settings)) {
+		ret.add(filename.requirements());
+	}
 
 	// Check external log files
 	const auto logFiles = getExternalLogFiles(settings);
 	for (auto it = logFiles.constBegin(); it != logFiles.constEnd(); ++it) {
-		need = qMax(need, Filename(it.value().value("content").toString()).needExactTags(nullptr, settings));
-		if (need == 2) {
-			return need;
-		}
+		ret.add(Filename(it.value().value("content").toString()).requirements());
 	}
 
 	// Check commands
@@ -124,35 +181,24 @@ int ImageDownloader::needExactTags(QSettings *settings) const
 	};
 	for (const QString &setting : settingNames) {
 		const QString value = settings->value(setting, "").toString();
-		if (value.isEmpty()) {
-			continue;
-		}
-
-		need = qMax(need, Filename(value).needExactTags(nullptr, settings));
-		if (need == 2) {
-			return need;
+		if (!value.isEmpty()) {
+			ret.add(Filename(value).requirements());
 		}
 	}
 
 	// Check Exiftool metadata
 	for (const auto &pair : getMetadataExiftool(settings)) {
-		need = qMax(need, Filename(pair.second).needExactTags(nullptr, settings));
-		if (need == 2) {
-			return need;
-		}
+		ret.add(Filename(pair.second).requirements());
 	}
 
 	#ifdef WIN_FILE_PROPS
 		// Check Windows Property System
 		for (const auto &pair : getMetadataPropsys(settings)) {
-			need = qMax(need, Filename(pair.second).needExactTags(nullptr, settings));
-			if (need == 2) {
-				return need;
-			}
+			ret.add(Filename(pair.second).requirements());
 		}
 	#endif
 
-	return need;
+	return ret;
 }
 
 void ImageDownloader::abort()
@@ -165,6 +211,7 @@ void ImageDownloader::abort()
 
 void ImageDownloader::loadedSave(Image::LoadTagsResult result)
 {
+	TraceSpan span(QStringLiteral("loadedSave"), QStringLiteral("download"));
 	disconnect(m_image.data(), &Image::finishedLoadingTags, this, &ImageDownloader::loadedSave);
 
 	// Detect error when loading an image's tags
@@ -184,16 +231,16 @@ void ImageDownloader::loadedSave(Image::LoadTagsResult result)
 			return;
 		}
 
-		// Use a random temporary file if we need the MD5 or equivalent
+		// Use a random temporary file if we need the MD5 or equivalent, in the destination root so that it can still be renamed
 		if (m_filename.needTemporaryFile(m_image->tokens(m_profile))) {
 			const QString tmpDir = !m_path.isEmpty() ? m_path : m_profile->tempPath();
-			m_temporaryPath = tmpDir + QDir::separator() + QUuid::createUuid().toString().mid(1, 36) + ".tmp";
+			m_temporaryPath = partPath(tmpDir + QDir::separator() + QUuid::createUuid().toString().mid(1, 36));
 		}
 	}
 
-	// Directly use the image path as temporary file  if possible
+	// Directly download next to the destination if possible, so that finishing the download is a simple rename
 	if (m_temporaryPath.isEmpty()) {
-		m_temporaryPath = m_paths.first() + ".tmp";
+		m_temporaryPath = partPath(m_paths.first());
 	}
 
 	// Check if the image is blacklisted
@@ -211,7 +258,8 @@ void ImageDownloader::loadedSave(Image::LoadTagsResult result)
 		// Check if the destination files already exist
 		bool allExists = true;
 		for (const QString &path : qAsConst(m_paths)) {
-			if (!QFile::exists(path)) {
+			const bool exists = m_directoryIndex != nullptr ? m_directoryIndex->exists(path) : QFile::exists(path);
+			if (!exists) {
 				allExists = false;
 				break;
 			}
@@ -227,21 +275,22 @@ void ImageDownloader::loadedSave(Image::LoadTagsResult result)
 			return;
 		}
 
-		// If we don't need any loading, we can return already
+		// If we don't need any loading, we can return already (similar images are only skipped when actually saving, not when viewing)
 		Image::SaveResult res = m_image->preSave(m_temporaryPath, m_size);
-		if (res != Image::SaveResult::NotLoaded && (res != Image::SaveResult::AlreadyExistsDeletedMd5 || !m_forceExisting)) {
-			QList<ImageSaveResult> preResult {{ m_temporaryPath, m_size, res }};
-
+		if (res != Image::SaveResult::NotLoaded && (res != Image::SaveResult::AlreadyExistsDeletedMd5 || !m_forceExisting) && (res != Image::SaveResult::AlreadyExistsSimilar || m_addMd5)) {
 			if (res == Image::SaveResult::Saved || res == Image::SaveResult::Copied || res == Image::SaveResult::Moved || res == Image::SaveResult::Shortcut || res == Image::SaveResult::Linked) {
-				preResult = afterTemporarySave(res);
+				afterTemporarySave(res);
+				return;
 			}
 
+			const QList<ImageSaveResult> preResult {{ m_temporaryPath, m_size, res }};
 			emit saved(m_image, preResult);
 			return;
 		}
 	}
 
 	m_url = m_image->url(m_size);
+	m_skipMirror = false;
 
 	if (m_url.isEmpty()) {
 		log(QStringLiteral("Image without URL found for '%1'").arg(m_paths.first()), Logger::Warning);
@@ -255,6 +304,7 @@ void ImageDownloader::loadedSave(Image::LoadTagsResult result)
 
 void ImageDownloader::loadImage()
 {
+	TraceSpan span(QStringLiteral("loadImage"), QStringLiteral("download"));
 	connect(&m_fileDownloader, &FileDownloader::success, this, &ImageDownloader::success, Qt::UniqueConnection);
 	connect(&m_fileDownloader, &FileDownloader::networkError, this, &ImageDownloader::networkError, Qt::UniqueConnection);
 	connect(&m_fileDownloader, &FileDownloader::writeError, this, &ImageDownloader::writeError, Qt::UniqueConnection);
@@ -264,10 +314,32 @@ void ImageDownloader::loadImage()
 		m_reply->deleteLater();
 	}
 
+	// When resuming, only ask for the missing part, as long as the file did not change on the server
+	QMap<QString, QString> headers;
+	if (m_resumeOffset > 0) {
+		headers["Range"] = "bytes=" + QString::number(m_resumeOffset) + "-";
+		if (!m_resumeValidator.isEmpty()) {
+			headers["If-Range"] = QString::fromLatin1(m_resumeValidator);
+		}
+	}
+
 	// Load the image directly on the disk
 	Site *site = m_image->parentSite();
-	m_reply = site->get(site->fixUrl(m_url.toString()), Site::QueryType::Img, m_image->parentUrl(), QStringLiteral("image"), m_image.data());
+	QUrl url = site->fixUrl(m_url.toString());
+
+	// Use the fastest equivalent host, and measure it to keep the choice up to date
+	m_mirrorHost.clear();
+	MirrorSelector *mirrors = site->mirrorSelector();
+	if (!m_skipMirror && mirrors != nullptr && mirrors->isMirror(url.host())) {
+		url = mirrors->rewrite(url);
+		m_mirrorHost = url.host();
+		m_mirrorLatency = -1;
+	}
+	m_transferTimer.start();
+
+	m_reply = site->get(url, Site::QueryType::Img, m_image->parentUrl(), QStringLiteral("image"), m_image.data(), headers);
 	m_reply->setParent(this);
+	m_reply->setBandwidthLimiter(m_bandwidthLimiter);
 	connect(m_reply, &NetworkReply::downloadProgress, this, &ImageDownloader::downloadProgressImage);
 
 	// Create download root directory
@@ -278,15 +350,32 @@ void ImageDownloader::loadImage()
 		return;
 	}
 
+	// Very big files (usually videos) should not fill the page cache
+	const auto snapshot = m_profile->settingsSnapshot();
+	m_fileDownloader.setUncachedThreshold(snapshot->uncachedThreshold > 0 ? snapshot->uncachedThreshold : -1);
+
 	// If we can't start writing for some reason, return an error
-	if (!m_fileDownloader.start(m_reply, m_temporaryPath)) {
+	m_fileDownloader.setResumable(m_resumeRetries < snapshot->resumeRetries);
+	if (!m_fileDownloader.start(m_reply, m_temporaryPath, m_resumeOffset)) {
 		emit saved(m_image, makeResult(m_paths, Image::SaveResult::Error));
 		return;
 	}
+	Tracer::getInstance().asyncBegin(QStringLiteral("network"), QStringLiteral("download"), reinterpret_cast<quintptr>(this), QVariantMap { { "url", m_url.toString() } });
 }
 
 void ImageDownloader::downloadProgressImage(qint64 v1, qint64 v2)
 {
+	// Take into account the part that was already downloaded when resuming
+	const qint64 offset = m_fileDownloader.offset();
+	if (offset > 0 && v2 > 0) {
+		v1 += offset;
+		v2 += offset;
+	}
+
+	if (!m_mirrorHost.isEmpty() && m_mirrorLatency < 0 && v1 > 0) {
+		m_mirrorLatency = m_transferTimer.elapsed();
+	}
+
 	if (m_image->fileSize() == 0 || m_image->fileSize() < v2 / 2) {
 		m_image->setFileSize(v2, currentSize());
 	}
@@ -317,11 +406,53 @@ void ImageDownloader::writeError()
 
 void ImageDownloader::networkError(NetworkReply::NetworkError error, const QString &msg)
 {
+	Tracer::getInstance().asyncEnd(QStringLiteral("network"), QStringLiteral("download"), reinterpret_cast<quintptr>(this), QVariantMap { { "error", msg } });
+
+	// A mirror that fails is avoided for a while, and one missing the file is not trusted for this image anymore
+	if (!m_mirrorHost.isEmpty() && error != NetworkReply::NetworkError::OperationCanceledError) {
+		Site *site = m_image->parentSite();
+		site->mirrorSelector()->reportFailure(m_mirrorHost);
+
+		const bool rewritten = m_mirrorHost != site->fixUrl(m_url.toString()).host();
+		if (rewritten && (error == NetworkReply::NetworkError::ContentNotFoundError || error == NetworkReply::NetworkError::HostNotFoundError)) {
+			log(QStringLiteral("Mirror '%1' failed for the image: `%2`: %3. New try with the original host...").arg(m_mirrorHost, m_url.toString().toHtmlEscaped(), msg), Logger::Warning);
+			QFile::remove(m_temporaryPath);
+			m_resumeOffset = 0;
+			m_resumeValidator.clear();
+			m_skipMirror = true;
+			loadImage();
+			return;
+		}
+	}
+
+	// Resume interrupted downloads where they stopped instead of starting over
+	const qint64 partialSize = QFileInfo(m_temporaryPath).size();
+	if (partialSize > 0 && error != NetworkReply::NetworkError::OperationCanceledError && error != NetworkReply::NetworkError::ContentNotFoundError) {
+		const int maxResumeRetries = m_profile->settingsSnapshot()->resumeRetries;
+		if (m_resumeRetries < maxResumeRetries) {
+			// Send an "If-Range" header when possible, so that the server sends the whole file again if it changed
+			const QByteArray etag = m_reply->rawHeader("ETag");
+			const QByteArray validator = !etag.isEmpty() && !etag.startsWith("W/") ? etag : m_reply->rawHeader("Last-Modified");
+			if (!validator.isEmpty()) {
+				m_resumeValidator = validator;
+			}
+
+			m_resumeRetries++;
+			m_resumeOffset = partialSize;
+			log(QStringLiteral("Network error for the image: `%1`: %2 (%3). Resuming from byte %4 (try %5/%6)...").arg(m_image->url().toString().toHtmlEscaped()).arg(error).arg(msg).arg(partialSize).arg(m_resumeRetries).arg(maxResumeRetries), Logger::Warning);
+			loadImage();
+			return;
+		}
+	}
+	QFile::remove(m_temporaryPath);
+	m_resumeRetries = 0;
+	m_resumeOffset = 0;
+	m_resumeValidator.clear();
+
 	if (error == NetworkReply::NetworkError::ContentNotFoundError) {
-		QSettings *settings = m_profile->getSettings();
 		ExtensionRotator *extensionRotator = m_image->extensionRotator();
 
-		const bool sampleFallback = settings->value("Save/samplefallback", true).toBool();
+		const bool sampleFallback = m_profile->settingsSnapshot()->sampleFallback;
 		const bool shouldFallback = m_size == Image::Size::Full && sampleFallback && !m_image->url(Image::Size::Sample).isEmpty();
 		const QString newExt = extensionRotator != nullptr ? extensionRotator->next() : QString();
 
@@ -356,22 +487,60 @@ void ImageDownloader::networkError(NetworkReply::NetworkError error, const QStri
 
 void ImageDownloader::success()
 {
+	Tracer::getInstance().asyncEnd(QStringLiteral("network"), QStringLiteral("download"), reinterpret_cast<quintptr>(this));
+
 	// Handle network redirects
 	const QUrl redirect = m_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
 	if (!redirect.isEmpty()) {
 		m_url = redirect;
+		m_resumeOffset = 0;
 		loadImage();
 		return;
 	}
 
-	emit saved(m_image, afterTemporarySave(Image::SaveResult::Saved));
+	// Replies from the cache say nothing about the network
+	if (!m_reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool()) {
+		const qint64 duration = m_transferTimer.elapsed();
+		const qint64 bytes = QFileInfo(m_temporaryPath).size() - m_fileDownloader.offset();
+		ThroughputEstimator::getInstance().addTransfer(bytes, duration);
+		if (!m_mirrorHost.isEmpty()) {
+			m_image->parentSite()->mirrorSelector()->reportSuccess(m_mirrorHost, m_mirrorLatency >= 0 ? m_mirrorLatency : duration, bytes, duration);
+		}
+	}
+
+	// Remember which extensions this site uses, to guess them better next time
+	if (m_rotate && !m_tryingSample && currentSize() == Image::Size::Full) {
+		m_image->parentSite()->extensionStats()->add(m_image->id(), getExtension(m_url));
+	}
+
+	// The MD5 was computed while writing the file, so there is no need to read it again later
+	m_image->setFileMd5(m_fileDownloader.md5(), currentSize());
+
+	Metrics::getInstance().increment("grabber_download_bytes_total", Metrics::label("host", m_url.host()), QFileInfo(m_temporaryPath).size());
+
+	afterTemporarySave(Image::SaveResult::Saved);
 }
 
-QList<ImageSaveResult> ImageDownloader::afterTemporarySave(Image::SaveResult saveResult)
+void ImageDownloader::recordMetrics(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result)
 {
-	QSettings *settings = m_profile->getSettings();
+	Q_UNUSED(img);
+	if (result.isEmpty()) {
+		return;
+	}
 
-	const QString multipleFiles = settings->value("Save/multiple_files", "copy").toString();
+	static const QMetaEnum saveResults = Image::staticMetaObject.enumerator(Image::staticMetaObject.indexOfEnumerator("SaveResult"));
+	const QString resultName = saveResults.valueToKey(result.first().result);
+	Metrics::getInstance().increment("grabber_downloads_total", Metrics::label("result", resultName));
+	Tracer::getInstance().asyncEnd(QStringLiteral("download"), QStringLiteral("download"), reinterpret_cast<quintptr>(this), QVariantMap { { "result", resultName } });
+}
+
+/**
+ * Resize and transcode the temporary file if necessary, then move it to its destinations.
+ */
+void ImageDownloader::afterTemporarySave(Image::SaveResult saveResult)
+{
+	TraceSpan span(QStringLiteral("afterTemporarySave"), QStringLiteral("download"));
+	const auto snapshot = m_profile->settingsSnapshot();
 	const Image::Size size = currentSize();
 
 	m_image->setSavePath(m_temporaryPath, size);
@@ -386,29 +555,74 @@ QList<ImageSaveResult> ImageDownloader::afterTemporarySave(Image::SaveResult sav
 	}
 
 	// Resize image if necessary
-	bool maxWidthEnabled = settings->value("ImageSize/maxWidthEnabled", false).toBool();
-	bool maxHeightEnabled = settings->value("ImageSize/maxHeightEnabled", false).toBool();
 	QSize resizeBox = m_image->size(size);
-	if (!resizeBox.isEmpty() && (maxWidthEnabled || maxHeightEnabled)) {
-		int maxWidth = settings->value("ImageSize/maxWidth", 1000).toInt();
-		if (maxWidthEnabled && resizeBox.width() > maxWidth) {
-			resizeBox.setWidth(maxWidth);
+	if (!resizeBox.isEmpty() && (snapshot->maxWidthEnabled || snapshot->maxHeightEnabled)) {
+		if (snapshot->maxWidthEnabled && resizeBox.width() > snapshot->maxWidth) {
+			resizeBox.setWidth(snapshot->maxWidth);
 		}
-		int maxHeight = settings->value("ImageSize/maxHeight", 1000).toInt();
-		if (maxHeightEnabled && resizeBox.height() > maxHeight) {
-			resizeBox.setWidth(maxHeight);
+		if (snapshot->maxHeightEnabled && resizeBox.height() > snapshot->maxHeight) {
+			resizeBox.setWidth(snapshot->maxHeight);
 		}
 		if (resizeBox != m_image->size(size)) {
 			QImage img(m_temporaryPath);
 			img = img.scaled(resizeBox, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-			img.save(m_temporaryPath, m_image->extension().toStdString().c_str());
+
+			// Encode the resized image in memory, so that its MD5 can be computed without reading the file back
+			QByteArray data;
+			QBuffer buffer(&data);
+			buffer.open(QIODevice::WriteOnly);
+			if (img.save(&buffer, m_image->extension().toStdString().c_str()) && writeFile(m_temporaryPath, data)) {
+				m_image->setFileMd5(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex(), size);
+			} else {
+				m_image->setFileMd5(QString(), size);
+			}
 		}
 	}
 
+	// Transcode freshly downloaded files before moving them, so that they are saved with their final extension
+	m_transcodedExtension.clear();
+	m_transcodedMd5.clear();
+	if (saveResult == Image::SaveResult::Saved && !snapshot->transcodeRules.isEmpty()) {
+		const QString site = m_image->parentSite() != nullptr ? m_image->parentSite()->url() : QString();
+		const int rule = TranscodeRule::find(snapshot->transcodeRules, m_image->extension(), QFileInfo(m_temporaryPath).size(), site);
+		if (rule >= 0) {
+			m_profile->getTranscoder().runAsync(m_temporaryPath, snapshot->transcodeRules[rule], this, [this, saveResult](const Transcoder::Result &res) {
+				if (res.transcoded) {
+					m_transcodedExtension = res.extension;
+					m_transcodedMd5 = res.md5;
+					m_image->setFileSize(res.size, currentSize());
+				}
+				moveTemporaryFile(saveResult);
+			});
+			return;
+		}
+	}
+
+	moveTemporaryFile(saveResult);
+}
+
+/**
+ * Move the temporary file to its destinations, then emit saved().
+ */
+void ImageDownloader::moveTemporaryFile(Image::SaveResult saveResult)
+{
+	const QString multipleFiles = m_profile->settingsSnapshot()->multipleFiles;
+	const Image::Size size = currentSize();
+
 	if (!m_filename.format().isEmpty()) {
 		m_paths = m_image->paths(m_filename, m_path, m_count);
 	}
 
+	// Transcoded files keep their original name, but with the extension of their new format
+	if (!m_transcodedExtension.isEmpty()) {
+		const QString oldSuffix = "." + m_image->extension();
+		for (QString &path : m_paths) {
+			if (path.endsWith(oldSuffix, Qt::CaseInsensitive)) {
+				path = path.left(path.length() - oldSuffix.length()) + "." + m_transcodedExtension;
+			}
+		}
+	}
+
 	QString suffix;
 	#ifdef Q_OS_WIN
 		if (saveResult == Image::SaveResult::Shortcut) {
@@ -416,66 +630,99 @@ QList<ImageSaveResult> ImageDownloader::afterTemporarySave(Image::SaveResult sav
 		}
 	#endif
 
-	QFile tmp(m_temporaryPath + suffix);
-	bool moved = false;
-
-	QList<ImageSaveResult> result;
+	// Already existing files are detected here, as the directory index and the MD5 database are not thread-safe
+	auto result = QSharedPointer<QList<ImageSaveResult>>::create();
+	QList<int> pending;
 	for (const QString &file : qAsConst(m_paths)) {
 		const QString path = file + suffix;
 
 		// Don't overwrite already existing files
 		if (QFile::exists(file) || (!suffix.isEmpty() && QFile::exists(path))) {
 			log(QStringLiteral("File already exists: `%1`").arg(file), Logger::Info);
+			if (m_directoryIndex != nullptr) {
+				m_directoryIndex->add(file);
+			}
 			if (suffix.isEmpty() && m_addMd5) {
 				addMd5(m_profile, file);
 			}
-			result.append({ path, size, Image::SaveResult::AlreadyExistsDisk });
+			result->append({ path, size, Image::SaveResult::AlreadyExistsDisk });
 			continue;
 		}
 
-		const QString dir = path.section(QDir::separator(), 0, -2);
-		if (!QDir(dir).exists() && !QDir().mkpath(dir)) {
-			log(QStringLiteral("Impossible to create the destination folder: %1.").arg(dir), Logger::Error);
-			result.append({ path, size, Image::SaveResult::Error });
-			continue;
-		}
+		pending.append(result->count());
+		result->append({ path, size, saveResult });
+	}
 
-		if (!moved) {
-			if (!tmp.rename(path)) {
-				log(QStringLiteral("Error renaming from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
-				result.append({ path, size, Image::SaveResult::Error });
+	// The file operations wait for a free slot on the destination device, without blocking this thread
+	const QString temporaryPath = m_temporaryPath + suffix;
+	const QString firstPath = pending.isEmpty() ? temporaryPath : result->at(pending.first()).path;
+	m_profile->getDiskScheduler().runAsync(firstPath, [result, pending, temporaryPath, multipleFiles]() {
+		QFile tmp(temporaryPath);
+		bool moved = false;
+
+		for (int index : pending) {
+			ImageSaveResult &res = (*result)[index];
+			const QString &path = res.path;
+
+			const QString dir = path.section(QDir::separator(), 0, -2);
+			if (!QDir(dir).exists() && !QDir().mkpath(dir)) {
+				log(QStringLiteral("Impossible to create the destination folder: %1.").arg(dir), Logger::Error);
+				res.result = Image::SaveResult::Error;
 				continue;
+			}
+
+			if (!moved) {
+				if (!tmp.rename(path)) {
+					log(QStringLiteral("Error renaming from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
+					res.result = Image::SaveResult::Error;
+					continue;
+				} else {
+					moved = true;
+				}
+			} else if (multipleFiles == "link") {
+				#ifdef Q_OS_WIN
+					bool ok = tmp.link(path + ".lnk");
+				#else
+					bool ok = tmp.link(path);
+				#endif
+				if (!ok) {
+					log(QStringLiteral("Error creating link from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
+					res.result = Image::SaveResult::Error;
+					continue;
+				}
 			} else {
-				moved = true;
+				if (!copyFile(tmp.fileName(), path)) {
+					log(QStringLiteral("Error copying from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
+					res.result = Image::SaveResult::Error;
+					continue;
+				}
 			}
-		} else if (multipleFiles == "link") {
-			#ifdef Q_OS_WIN
-				bool ok = tmp.link(path + ".lnk");
-			#else
-				bool ok = tmp.link(path);
-			#endif
-			if (!ok) {
-				log(QStringLiteral("Error creating link from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
-				result.append({ path, size, Image::SaveResult::Error });
+		}
+
+		if (!moved) {
+			tmp.remove();
+		}
+	}, this, [this, result, pending, size, saveResult]() {
+		for (int index : pending) {
+			const ImageSaveResult &res = result->at(index);
+			if (res.result == Image::SaveResult::Error) {
 				continue;
 			}
-		} else {
-			if (!tmp.copy(path)) {
-				log(QStringLiteral("Error copying from `%1` to `%2`").arg(tmp.fileName(), path), Logger::Error);
-				result.append({ path, size, Image::SaveResult::Error });
-				continue;
+
+			if (m_directoryIndex != nullptr) {
+				m_directoryIndex->add(res.path);
+			}
+			if (m_postSave) {
+				TraceSpan postSaveSpan(QStringLiteral("postSave"), QStringLiteral("download"));
+				m_image->postSave(res.path, size, saveResult, m_addMd5, m_startCommands, m_count);
 			}
-		}
 
-		result.append({ path, size, saveResult });
-		if (m_postSave) {
-			m_image->postSave(path, size, saveResult, m_addMd5, m_startCommands, m_count);
+			// Both the original and the transcoded files are known, so that either is detected as a duplicate later
+			if (m_addMd5 && !m_transcodedMd5.isEmpty() && m_transcodedMd5 != m_image->md5()) {
+				m_profile->addMd5(m_transcodedMd5, res.path);
+			}
 		}
-	}
-
-	if (!moved) {
-		tmp.remove();
-	}
 
-	return result;
+		emit saved(m_image, *result);
+	});
 }
@@ -1,6 +1,7 @@
 #ifndef IMAGE_DOWNLOADER_H
 #define IMAGE_DOWNLOADER_H
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QObject>
 #include <QSharedPointer>
@@ -14,7 +15,10 @@
 #include "network/network-reply.h"
 
 
+class BandwidthLimiter;
 class Blacklist;
+class DirectoryIndex;
+struct FilenameRequirements;
 class Profile;
 
 class ImageDownloader : public QObject
@@ -26,18 +30,31 @@ class ImageDownloader : public QObject
 		ImageDownloader(Profile *profile, QSharedPointer<Image> img, QStringList paths, int count, bool addMd5, bool startCommands, QObject *parent = nullptr, bool rotate = true, bool force = false, Image::Size size = Image::Size::Unknown, bool postSave = true, bool forceExisting = false);
 		~ImageDownloader();
 		bool isRunning() const;
+		QSharedPointer<Image> image() const;
 		void setSize(Image::Size size);
 		void setBlacklist(Blacklist *blacklist);
+		void setDirectoryIndex(DirectoryIndex *directoryIndex);
+		void setBandwidthLimiter(BandwidthLimiter *limiter);
+
+		/**
+		 * Whether conditional filenames, commands, logs or metadata require exact tags (0: no, 1: if there are unknown tags, 2: always).
+		 */
+		static int needExactTags(QSettings *settings);
+
+		/**
+		 * The tokens needed by conditional filenames, commands, logs and metadata, on top of the filename itself.
+		 */
+		static FilenameRequirements requirements(QSettings *settings);
 
 	public slots:
 		void save();
 		void abort();
 
 	protected:
-		int needExactTags(QSettings *settings) const;
 		Image::Size currentSize() const;
 		QList<ImageSaveResult> makeResult(const QStringList &paths, Image::SaveResult result) const;
-		QList<ImageSaveResult> afterTemporarySave(Image::SaveResult saveResult);
+		void afterTemporarySave(Image::SaveResult saveResult);
+		void moveTemporaryFile(Image::SaveResult saveResult);
 
 	signals:
 		void downloadProgress(QSharedPointer<Image> img, qint64 v1, qint64 v2);
@@ -50,10 +67,13 @@ class ImageDownloader : public QObject
 		void writeError();
 		void networkError(NetworkReply::NetworkError error, const QString &msg);
 		void success();
+		void recordMetrics(const QSharedPointer<Image> &img, const QList<ImageSaveResult> &result);
 
 	private:
 		Profile *m_profile;
 		Blacklist *m_blacklist = nullptr;
+		DirectoryIndex *m_directoryIndex = nullptr;
+		BandwidthLimiter *m_bandwidthLimiter = nullptr;
 		QSharedPointer<Image> m_image;
 		FileDownloader m_fileDownloader;
 		Filename m_filename;
@@ -61,6 +81,8 @@ class ImageDownloader : public QObject
 		bool m_loadTags;
 		QStringList m_paths;
 		QString m_temporaryPath;
+		QString m_transcodedExtension;
+		QString m_transcodedMd5;
 		int m_count;
 		bool m_addMd5;
 		bool m_startCommands;
@@ -74,6 +96,15 @@ class ImageDownloader : public QObject
 		NetworkReply *m_reply = nullptr;
 		QUrl m_url;
 		bool m_tryingSample = false;
+		int m_resumeRetries = 0;
+		qint64 m_resumeOffset = 0;
+		QByteArray m_resumeValidator;
+
+		// Transfer measures
+		QElapsedTimer m_transferTimer;
+		QString m_mirrorHost;
+		qint64 m_mirrorLatency = -1;
+		bool m_skipMirror = false;
 };
 
 #endif // IMAGE_DOWNLOADER_H
@@ -1,98 +1,137 @@
 #include "json-printer.h"
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QDateTime>
+#include <QIODevice>
 #include <QList>
 #include <QSharedPointer>
-#include <QTextStream>
+#include <QStringList>
 #include "logger.h"
 #include "models/image.h"
 #include "models/profile.h"
 #include "tags/tag.h"
 
 
-JsonPrinter::JsonPrinter(Profile *profile)
-	: m_profile(profile)
-{}
+JsonPrinter::JsonPrinter(Profile *profile, bool lines, QIODevice *device)
+	: m_profile(profile), m_lines(lines), m_writer(device != nullptr ? device : &m_stdout, !lines)
+{
+	if (device == nullptr) {
+		m_stdout.open(stdout, QIODevice::WriteOnly);
+	}
+}
 
 
 void JsonPrinter::print(int val) const
 {
-	print(QString::number(val));
+	if (m_lines) {
+		m_writer.value(val);
+	} else {
+		m_writer.raw(QByteArray::number(val));
+	}
+	m_writer.flush();
 }
 
 void JsonPrinter::print(const QString &val) const
 {
-	QTextStream(stdout) << qPrintable(val);
+	// Print strings as JSON values
+	if (m_lines) {
+		m_writer.value(val);
+	} else {
+		m_writer.raw(val.toUtf8());
+	}
+	m_writer.flush();
 }
 
 
 void JsonPrinter::print(const Image &image) const
 {
-	const QJsonObject jsonImage = serializeImage(image);
-	printObject(jsonImage);
+	writeImage(image);
+	m_writer.flush();
 }
 
+/**
+ * In NDJSON mode, each image is written as its own top-level value instead of an array item.
+ */
 void JsonPrinter::print(const QList<QSharedPointer<Image>> &images) const
 {
-	QJsonArray jsonArray;
+	if (!m_lines) {
+		m_writer.beginArray();
+	}
 	for (const QSharedPointer<Image> &image : images) {
-		jsonArray.append(serializeImage(*image.data()));
+		writeImage(*image.data());
+	}
+	if (!m_lines) {
+		m_writer.endArray();
 	}
-	printArray(jsonArray);
+	m_writer.flush();
 }
 
 void JsonPrinter::print(const Tag &tag, Site *site) const
 {
 	Q_UNUSED(site);
 
-	QJsonObject jsonTag;
-	tag.write(jsonTag);
-	printObject(jsonTag);
+	writeTag(tag);
+	m_writer.flush();
 }
 
 void JsonPrinter::print(const QList<Tag> &tags, Site *site) const
 {
 	Q_UNUSED(site);
 
-	QJsonArray jsonArray;
+	if (!m_lines) {
+		m_writer.beginArray();
+	}
 	for (const Tag &tag : tags) {
-		QJsonObject jsonObj;
-		tag.write(jsonObj);
-		jsonArray.append(jsonObj);
+		writeTag(tag);
+	}
+	if (!m_lines) {
+		m_writer.endArray();
 	}
-	printArray(jsonArray);
+	m_writer.flush();
 }
 
 
-void JsonPrinter::printArray(const QJsonArray &array) const
+bool JsonPrinter::canStream() const
 {
-	QJsonDocument jsonDoc;
-	jsonDoc.setArray(array);
-
-	const QByteArray jsonResult = jsonDoc.toJson(QJsonDocument::Indented);
-	QTextStream(stdout) << qPrintable(jsonResult);
+	return m_lines;
 }
 
-void JsonPrinter::printObject(const QJsonObject &object) const
-{
-	QJsonDocument jsonDoc;
-	jsonDoc.setObject(object);
 
-	const QByteArray jsonResult = jsonDoc.toJson(QJsonDocument::Indented);
-	QTextStream(stdout) << qPrintable(jsonResult);
+/**
+ * Same fields as Tag::write(), written directly.
+ */
+void JsonPrinter::writeTag(const Tag &tag) const
+{
+	m_writer.beginObject();
+	if (tag.count() > 0) {
+		m_writer.key(QStringLiteral("count"));
+		m_writer.value(tag.count());
+	}
+	if (tag.id() > 0) {
+		m_writer.key(QStringLiteral("id"));
+		m_writer.value(tag.id());
+	}
+	if (!tag.related().isEmpty()) {
+		m_writer.key(QStringLiteral("related"));
+		m_writer.value(tag.related());
+	}
+	m_writer.key(QStringLiteral("text"));
+	m_writer.value(tag.text());
+	if (!tag.type().isUnknown()) {
+		m_writer.key(QStringLiteral("type"));
+		m_writer.value(tag.type().name());
+	}
+	m_writer.endObject();
 }
 
-
-QJsonObject JsonPrinter::serializeImage(const Image &image) const
+void JsonPrinter::writeImage(const Image &image) const
 {
 	static const QStringList ignoreKeys = {"all", "allo", "allos", "all_namespaces", };
 
-	QJsonObject jsObject;
+	m_writer.beginObject();
 
 	const auto tokens = image.tokens(m_profile);
-	for (auto& key : tokens.keys()) {
+	for (auto it = tokens.constBegin(); it != tokens.constEnd(); ++it) {
 		typedef QVariant::Type Type;
+		const QString &key = it.key();
 		if (ignoreKeys.contains(key)) {
 			continue;
 		}
@@ -100,7 +139,7 @@ QJsonObject JsonPrinter::serializeImage(const Image &image) const
 			continue;
 		}
 
-		const QVariant& qvalue = tokens.value(key).value();
+		const QVariant& qvalue = it.value().value();
 		auto type = qvalue.type();
 
 		if (type == QVariant::Type::StringList) {
@@ -108,28 +147,39 @@ QJsonObject JsonPrinter::serializeImage(const Image &image) const
 			if (l.isEmpty()) {
 				continue;
 			}
-			jsObject.insert(key, QJsonArray::fromStringList(l));
+			m_writer.key(key);
+			m_writer.value(l);
 		} else if (type == QVariant::Type::String) {
 			QString s = qvalue.toString();
 			if (s.isEmpty()) {
 				continue;
 			}
-			jsObject.insert(key, s);
+			m_writer.key(key);
+			m_writer.value(s);
 		} else if (type == Type::Url || type == Type::ULongLong || type == Type::LongLong) {
-			jsObject.insert(key, qvalue.toString());
+			m_writer.key(key);
+			m_writer.value(qvalue.toString());
 		} else if (type == Type::Int) {
-			jsObject.insert(key, qvalue.value<int>());
+			m_writer.key(key);
+			m_writer.value(qvalue.value<int>());
 		} else if (type == Type::Bool) {
-			jsObject.insert(key, qvalue.value<bool>());
+			m_writer.key(key);
+			m_writer.value(qvalue.value<bool>());
 		} else if (type == Type::DateTime) {
-			jsObject.insert(key, static_cast<int>(qvalue.value<QDateTime>().toSecsSinceEpoch()));
+			m_writer.key(key);
+			m_writer.value(static_cast<int>(qvalue.value<QDateTime>().toSecsSinceEpoch()));
 		} else {
 			log(QStringLiteral("using generic QVariant::toString for key: %1").arg(key), Logger::Warning);
-			jsObject.insert(key, qvalue.toString());
+			m_writer.key(key);
+			m_writer.value(qvalue.toString());
 		}
 	}
-	jsObject.insert("isVideo", image.isVideo());
-	jsObject.insert("isGallery", image.isGallery());
-	jsObject.insert("isAnimated", image.isAnimated());
-	return jsObject;
+	m_writer.key(QStringLiteral("isVideo"));
+	m_writer.value(image.isVideo());
+	m_writer.key(QStringLiteral("isGallery"));
+	m_writer.value(image.isGallery());
+	m_writer.key(QStringLiteral("isAnimated"));
+	m_writer.value(image.isAnimated());
+
+	m_writer.endObject();
 }
@@ -1,22 +1,28 @@
 #ifndef JSON_PRINTER_H
 #define JSON_PRINTER_H
 
+#include <QFile>
 #include <QList>
 #include <QSharedPointer>
 #include "printer.h"
+#include "utils/json-writer.h"
 
 
 class Image;
 class Profile;
-class QJsonArray;
-class QJsonObject;
+class QIODevice;
 class Site;
 class Tag;
 
 class JsonPrinter : public Printer
 {
 	public:
-		explicit JsonPrinter(Profile *profile);
+		/**
+		 * @param profile The profile used to generate the image tokens.
+		 * @param lines Print each item as a compact JSON object on its own line (NDJSON) instead of an indented array.
+		 * @param device Where to write the output, the standard output if null.
+		 */
+		explicit JsonPrinter(Profile *profile, bool lines = false, QIODevice *device = nullptr);
 
 		void print(int val) const override;
 		void print(const QString &val) const override;
@@ -25,14 +31,19 @@ class JsonPrinter : public Printer
 		void print(const QList<QSharedPointer<Image>> &images) const override;
 		void print(const Tag &tag, Site *site) const override;
 		void print(const QList<Tag> &tags, Site *site) const override;
+		bool canStream() const override;
 
 	protected:
-		void printArray(const QJsonArray &array) const;
-		void printObject(const QJsonObject &object) const;
-		QJsonObject serializeImage(const Image &image) const;
+		void writeImage(const Image &image) const;
+		void writeTag(const Tag &tag) const;
 
 	private:
 		Profile *m_profile;
+		bool m_lines;
+		QFile m_stdout;
+
+		// Output is buffered during each print() call, and written at its end
+		mutable JsonWriter m_writer;
 };
 
 #endif // JSON_PRINTER_H
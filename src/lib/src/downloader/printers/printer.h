@@ -19,6 +19,11 @@ class Printer
 		virtual void print(const QList<QSharedPointer<Image>> &images) const = 0;
 		virtual void print(const Tag &tag, Site *site) const = 0;
 		virtual void print(const QList<Tag> &tags, Site *site) const = 0;
+
+		/**
+		 * Whether printing a list in several calls gives the same output as printing it at once.
+		 */
+		virtual bool canStream() const = 0;
 };
 
 #endif // PRINTER_H
@@ -12,17 +12,24 @@
 
 SimplePrinter::SimplePrinter(QString tagsFormat)
 	: m_tagsFormat(std::move(tagsFormat))
-{}
+{
+	// Escape sequences are only replaced once, instead of for every tag
+	m_tagsFormat.replace("\\t", "\t");
+	m_tagsFormat.replace("\\n", "\n");
+	m_tagsFormat.replace("\\r", "\r");
+}
 
 
 void SimplePrinter::print(int val) const
 {
-	std::cout << val << std::endl;
+	std::cout << val << '\n';
+	std::cout.flush();
 }
 
 void SimplePrinter::print(const QString &val) const
 {
-	std::cout << val.toStdString() << std::endl;
+	writeLine(val);
+	std::cout.flush();
 }
 
 
@@ -31,29 +38,51 @@ void SimplePrinter::print(const Image &image) const
 	print(image.url().toString());
 }
 
+/**
+ * Lists are only flushed once fully written, instead of after each line.
+ */
 void SimplePrinter::print(const QList<QSharedPointer<Image>> &images) const
 {
 	for (const QSharedPointer<Image> &image : images) {
-		print(*image.data());
+		writeLine(image->url().toString());
 	}
+	std::cout.flush();
 }
 
 void SimplePrinter::print(const Tag &tag, Site *site) const
+{
+	writeLine(formatTag(tag, site));
+	std::cout.flush();
+}
+
+void SimplePrinter::print(const QList<Tag> &tags, Site *site) const
+{
+	for (const Tag &tag : tags) {
+		writeLine(formatTag(tag, site));
+	}
+	std::cout.flush();
+}
+
+
+QString SimplePrinter::formatTag(const Tag &tag, Site *site) const
 {
 	QString ret = m_tagsFormat;
-	ret.replace("\\t", "\t");
-	ret.replace("\\n", "\n");
-	ret.replace("\\r", "\r");
 	ret.replace("%tag", tag.text());
 	ret.replace("%count", QString::number(tag.count()));
 	ret.replace("%type", tag.type().name());
 	ret.replace("%stype", QString::number(tag.type().number(site)));
-	print(ret);
+	return ret;
 }
 
-void SimplePrinter::print(const QList<Tag> &tags, Site *site) const
+void SimplePrinter::writeLine(const QString &val) const
 {
-	for (const Tag &tag : tags) {
-		print(tag, site);
-	}
+	const QByteArray utf8 = val.toUtf8();
+	std::cout.write(utf8.constData(), utf8.size());
+	std::cout.put('\n');
+}
+
+
+bool SimplePrinter::canStream() const
+{
+	return true;
 }
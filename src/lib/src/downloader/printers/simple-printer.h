@@ -24,6 +24,11 @@ class SimplePrinter : public Printer
 		void print(const QList<QSharedPointer<Image>> &images) const override;
 		void print(const Tag &tag, Site *site) const override;
 		void print(const QList<Tag> &tags, Site *site) const override;
+		bool canStream() const override;
+
+	protected:
+		QString formatTag(const Tag &tag, Site *site) const;
+		void writeLine(const QString &val) const;
 
 	private:
 		QString m_tagsFormat;
@@ -0,0 +1,65 @@
+#include "downloader/progress-aggregator.h"
+#include "models/image.h"
+
+
+ProgressAggregator::ProgressAggregator(int interval, QObject *parent)
+	: QObject(parent), m_timer(this)
+{
+	m_timer.setSingleShot(true);
+	m_timer.setInterval(interval);
+	connect(&m_timer, &QTimer::timeout, this, &ProgressAggregator::flush);
+}
+
+qint64 ProgressAggregator::bytesReceived() const
+{
+	qint64 ret = 0;
+	for (const Progress &progress : m_progress) {
+		ret += progress.received;
+	}
+	return ret;
+}
+
+qint64 ProgressAggregator::bytesTotal() const
+{
+	qint64 ret = 0;
+	for (const Progress &progress : m_progress) {
+		ret += progress.total;
+	}
+	return ret;
+}
+
+
+void ProgressAggregator::update(const QSharedPointer<Image> &img, qint64 bytesReceived, qint64 bytesTotal)
+{
+	m_progress.insert(img, Progress { bytesReceived, bytesTotal });
+	m_changed.insert(img);
+
+	// The timer is not restarted, so that continuous updates are still emitted every interval
+	if (!m_timer.isActive()) {
+		m_timer.start();
+	}
+}
+
+void ProgressAggregator::remove(const QSharedPointer<Image> &img)
+{
+	m_progress.remove(img);
+	m_changed.remove(img);
+}
+
+void ProgressAggregator::flush()
+{
+	m_timer.stop();
+	if (m_changed.isEmpty()) {
+		return;
+	}
+
+	const QSet<QSharedPointer<Image>> changed = m_changed;
+	m_changed.clear();
+
+	for (const QSharedPointer<Image> &img : changed) {
+		const Progress progress = m_progress.value(img);
+		emit imageProgress(img, progress.received, progress.total);
+	}
+
+	emit progress(bytesReceived(), bytesTotal());
+}
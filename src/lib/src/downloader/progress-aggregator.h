@@ -0,0 +1,48 @@
+#ifndef PROGRESS_AGGREGATOR_H
+#define PROGRESS_AGGREGATOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+
+
+class Image;
+
+/**
+ * Coalesces the download progress of many images, to update the UI at a fixed rate instead of on every network chunk.
+ *
+ * Only the latest progress of each image is kept, and emitted at most once per interval.
+ */
+class ProgressAggregator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit ProgressAggregator(int interval = 100, QObject *parent = nullptr);
+		qint64 bytesReceived() const;
+		qint64 bytesTotal() const;
+
+	public slots:
+		void update(const QSharedPointer<Image> &img, qint64 bytesReceived, qint64 bytesTotal);
+		void remove(const QSharedPointer<Image> &img);
+		void flush();
+
+	signals:
+		void imageProgress(const QSharedPointer<Image> &img, qint64 bytesReceived, qint64 bytesTotal);
+		void progress(qint64 bytesReceived, qint64 bytesTotal);
+
+	private:
+		struct Progress
+		{
+			qint64 received;
+			qint64 total;
+		};
+
+		QTimer m_timer;
+		QHash<QSharedPointer<Image>, Progress> m_progress;
+		QSet<QSharedPointer<Image>> m_changed;
+};
+
+#endif // PROGRESS_AGGREGATOR_H
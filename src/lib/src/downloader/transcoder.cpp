@@ -0,0 +1,149 @@
+#include "downloader/transcoder.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QSettings>
+#include <QtConcurrent>
+#include "logger.h"
+
+
+bool TranscodeRule::matches(const QString &extension, qint64 size, const QString &site) const
+{
+	return (extensions.isEmpty() || extensions.contains(extension, Qt::CaseInsensitive))
+		&& size >= minimumSize
+		&& (sites.isEmpty() || sites.contains(site, Qt::CaseInsensitive));
+}
+
+QList<TranscodeRule> TranscodeRule::fromSettings(QSettings *settings)
+{
+	QList<TranscodeRule> ret;
+
+	settings->beginGroup(QStringLiteral("Transcoding"));
+	for (int i = 0; settings->contains(QString::number(i) + "_format"); ++i) {
+		const QString strI = QString::number(i);
+
+		TranscodeRule rule;
+		rule.extensions = settings->value(strI + "_extensions").toString().split(' ', Qt::SkipEmptyParts);
+		rule.minimumSize = settings->value(strI + "_minimumSize", 0).toLongLong() * 1024;
+		rule.sites = settings->value(strI + "_sites").toString().split(' ', Qt::SkipEmptyParts);
+		rule.format = settings->value(strI + "_format").toString().toLower();
+		rule.quality = settings->value(strI + "_quality", -1).toInt();
+		ret.append(rule);
+	}
+	settings->endGroup();
+
+	return ret;
+}
+
+int TranscodeRule::find(const QList<TranscodeRule> &rules, const QString &extension, qint64 size, const QString &site)
+{
+	for (int i = 0; i < rules.count(); ++i) {
+		if (rules[i].matches(extension, size, site)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+Transcoder::Transcoder(int maxWorkers)
+{
+	m_pool.setMaxThreadCount(qMax(1, maxWorkers));
+}
+
+Transcoder::~Transcoder()
+{
+	m_pool.waitForDone();
+}
+
+Transcoder::Result Transcoder::transcode(const QString &path, const TranscodeRule &rule)
+{
+	Result ret;
+
+	// JPEG XL and WebP are only available if the matching Qt image plugins are installed
+	const QByteArray format = rule.format.toLatin1();
+	if (!QImageWriter::supportedImageFormats().contains(format)) {
+		log(QStringLiteral("Unsupported transcoding format: %1").arg(rule.format), Logger::Warning);
+		return ret;
+	}
+
+	// Don't load files that are not images at all (videos, archives...)
+	if (QImageReader::imageFormat(path).isEmpty()) {
+		return ret;
+	}
+
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly)) {
+		log(QStringLiteral("Impossible to open the file to transcode: `%1`").arg(path), Logger::Error);
+		return ret;
+	}
+	QByteArray original = file.readAll();
+	file.close();
+
+	// Animated PNG files can be read by Qt, but only their first frame
+	QBuffer input(&original);
+	input.open(QIODevice::ReadOnly);
+	QImageReader reader(&input);
+	const bool animatedPng = reader.format() == "png" && original.contains("acTL");
+	if (animatedPng || reader.imageCount() > 1) {
+		return ret;
+	}
+
+	const QImage img = reader.read();
+	if (img.isNull()) {
+		log(QStringLiteral("Impossible to read the image to transcode `%1`: %2").arg(path, reader.errorString()), Logger::Warning);
+		return ret;
+	}
+
+	QByteArray data;
+	QBuffer output(&data);
+	output.open(QIODevice::WriteOnly);
+	QImageWriter writer(&output, format);
+	writer.setQuality(rule.quality);
+	if (!writer.write(img)) {
+		log(QStringLiteral("Error transcoding `%1` to %2: %3").arg(path, rule.format, writer.errorString()), Logger::Error);
+		return ret;
+	}
+
+	// Keep the original file if the transcoding did not help
+	if (data.size() >= original.size()) {
+		log(QStringLiteral("Transcoding `%1` to %2 did not make it smaller (%3 bytes instead of %4)").arg(path, rule.format).arg(data.size()).arg(original.size()), Logger::Debug);
+		return ret;
+	}
+
+	QSaveFile out(path);
+	if (!out.open(QFile::WriteOnly | QFile::Truncate) || out.write(data) != data.size() || !out.commit()) {
+		log(QStringLiteral("Error writing the transcoded file `%1`").arg(path), Logger::Error);
+		return ret;
+	}
+
+	log(QStringLiteral("Transcoded `%1` to %2 (%3 bytes instead of %4)").arg(path, rule.format).arg(data.size()).arg(original.size()), Logger::Debug);
+
+	ret.transcoded = true;
+	ret.extension = rule.format == QLatin1String("jpeg") ? QStringLiteral("jpg") : rule.format;
+	ret.md5 = QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+	ret.size = data.size();
+	return ret;
+}
+
+void Transcoder::runAsync(const QString &path, const TranscodeRule &rule, QObject *context, const std::function<void(const Result &)> &callback)
+{
+	auto *watcher = new QFutureWatcher<Result>(context);
+	QObject::connect(watcher, &QFutureWatcher<Result>::finished, watcher, [watcher, callback]() {
+		watcher->deleteLater();
+		callback(watcher->result());
+	});
+	watcher->setFuture(QtConcurrent::run(&m_pool, [path, rule]() {
+		return Transcoder::transcode(path, rule);
+	}));
+}
+
+bool Transcoder::waitForDone(int msecs)
+{
+	return m_pool.waitForDone(msecs);
+}
@@ -0,0 +1,76 @@
+#ifndef TRANSCODER_H
+#define TRANSCODER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+
+class QObject;
+class QSettings;
+
+/**
+ * Condition on the downloaded files to transcode, and the format to transcode them to.
+ */
+struct TranscodeRule
+{
+	QStringList extensions; // Empty for all extensions
+	qint64 minimumSize = 0; // In bytes
+	QStringList sites; // Empty for all sites
+	QString format = "png";
+	int quality = -1; // Passed as-is to QImageWriter, for PNG 0 is the smallest file
+
+	bool matches(const QString &extension, qint64 size, const QString &site) const;
+
+	/**
+	 * Load the rules from the "Transcoding" settings group.
+	 */
+	static QList<TranscodeRule> fromSettings(QSettings *settings);
+
+	/**
+	 * Index of the first rule matching a file, or -1 if none does.
+	 */
+	static int find(const QList<TranscodeRule> &rules, const QString &extension, qint64 size, const QString &site);
+};
+
+/**
+ * Re-encodes downloaded images (for example PNG files with a better compression, or to WebP or JPEG XL) on a bounded
+ * pool of background threads, as encoding is CPU-heavy and should neither block the UI nor starve the downloads.
+ *
+ * Files are only replaced when the new encoding is smaller, and animated images are never transcoded, as Qt can only
+ * write their first frame.
+ */
+class Transcoder
+{
+	public:
+		struct Result
+		{
+			bool transcoded = false;
+			QString extension;
+			QString md5;
+			qint64 size = 0;
+		};
+
+		explicit Transcoder(int maxWorkers);
+		~Transcoder();
+
+		/**
+		 * Transcode a file in place, in the calling thread.
+		 */
+		static Result transcode(const QString &path, const TranscodeRule &rule);
+
+		/**
+		 * Transcode a file in place in the background, then run the callback in the calling thread. The callback is not
+		 * called if the context object is destroyed in the meantime.
+		 */
+		void runAsync(const QString &path, const TranscodeRule &rule, QObject *context, const std::function<void(const Result &)> &callback);
+
+		bool waitForDone(int msecs = -1);
+
+	private:
+		QThreadPool m_pool;
+};
+
+#endif // TRANSCODER_H
@@ -0,0 +1,110 @@
+#include "exiftool-queue.h"
+#include <QList>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include "exiftool.h"
+
+#define EXIFTOOL_IDLE_TIMEOUT 10000
+
+
+ExiftoolQueue::ExiftoolQueue(int maxWorkers, int batchSize)
+	: m_maxWorkers(qMax(1, maxWorkers)), m_batchSize(qMax(1, batchSize))
+{
+	m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+ExiftoolQueue::~ExiftoolQueue()
+{
+	// Write all the remaining metadata before stopping
+	{
+		QMutexLocker locker(&m_mutex);
+		m_stopping = true;
+		m_holds = 0;
+		startWorkers();
+		m_condition.wakeAll();
+	}
+
+	m_pool.waitForDone();
+}
+
+void ExiftoolQueue::add(const QString &file, const QMap<QString, QString> &metadata)
+{
+	QMutexLocker locker(&m_mutex);
+	m_pending.enqueue(qMakePair(file, metadata));
+	startWorkers();
+}
+
+void ExiftoolQueue::hold()
+{
+	QMutexLocker locker(&m_mutex);
+	m_holds++;
+}
+
+void ExiftoolQueue::release()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_holds > 0) {
+		m_holds--;
+	}
+	startWorkers();
+}
+
+bool ExiftoolQueue::waitForDone(int msecs)
+{
+	return m_pool.waitForDone(msecs);
+}
+
+/**
+ * Start enough workers for the pending files, and wake up the idle ones. Must be called with the mutex locked.
+ */
+void ExiftoolQueue::startWorkers()
+{
+	if (m_holds > 0 || m_pending.isEmpty()) {
+		return;
+	}
+
+	const int wanted = qMin(m_maxWorkers, (m_pending.count() + m_batchSize - 1) / m_batchSize);
+	while (m_workers < wanted) {
+		m_workers++;
+		QtConcurrent::run(&m_pool, [this]() {
+			work();
+		});
+	}
+
+	m_condition.wakeAll();
+}
+
+void ExiftoolQueue::work()
+{
+	Exiftool exiftool;
+	const auto idle = [this]() {
+		return m_pending.isEmpty() || m_holds > 0;
+	};
+
+	QMutexLocker locker(&m_mutex);
+	for (;;) {
+		// Wait for files to process, stopping once there have been none for a while
+		bool timeout = false;
+		while (idle() && !m_stopping && !timeout) {
+			timeout = !m_condition.wait(&m_mutex, EXIFTOOL_IDLE_TIMEOUT);
+		}
+		if (idle()) {
+			break;
+		}
+
+		QList<QPair<QString, QMap<QString, QString>>> batch;
+		while (!m_pending.isEmpty() && batch.count() < m_batchSize) {
+			batch.append(m_pending.dequeue());
+		}
+
+		locker.unlock();
+		if (exiftool.start()) {
+			exiftool.setMetadata(batch);
+		}
+		locker.relock();
+	}
+
+	m_workers--;
+	locker.unlock();
+	exiftool.stop();
+}
@@ -0,0 +1,51 @@
+#ifndef EXIFTOOL_QUEUE_H
+#define EXIFTOOL_QUEUE_H
+
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+
+/**
+ * Writes metadata using exiftool in the background.
+ *
+ * Files are sent to exiftool in batches, all the commands of a batch being written at once to the same process.
+ * When many files are waiting, several exiftool processes are run in parallel. Each worker keeps its process open
+ * for a short while once the queue is empty, so that the next files don't pay for its startup again.
+ *
+ * Writes can also be held, for example until all the downloads of a batch are finished, to keep them out of the way
+ * of network transfers.
+ */
+class ExiftoolQueue
+{
+	public:
+		explicit ExiftoolQueue(int maxWorkers, int batchSize);
+		~ExiftoolQueue();
+
+		void add(const QString &file, const QMap<QString, QString> &metadata);
+		void hold();
+		void release();
+		bool waitForDone(int msecs = -1);
+
+	protected:
+		void startWorkers();
+		void work();
+
+	private:
+		QThreadPool m_pool;
+		int m_maxWorkers;
+		int m_batchSize;
+
+		QMutex m_mutex;
+		QWaitCondition m_condition;
+		QQueue<QPair<QString, QMap<QString, QString>>> m_pending;
+		int m_workers = 0;
+		int m_holds = 0;
+		bool m_stopping = false;
+};
+
+#endif // EXIFTOOL_QUEUE_H
@@ -49,7 +49,7 @@ bool Exiftool::start(int msecs)
 	return ok;
 }
 
-bool Exiftool::setMetadata(const QString &file, const QMap<QString, QString> &metadata, int msecs)
+QString Exiftool::metadataCommand(const QMap<QString, QString> &metadata)
 {
 	QStringList commands;
 	commands.append({ "-sep", ";" });
@@ -58,25 +58,63 @@ bool Exiftool::setMetadata(const QString &file, const QMap<QString, QString> &me
 	}
 	commands.append("-overwrite_original");
 
-	return execute(file, commands.join("\n"), msecs);
+	return commands.join("\n");
+}
+
+bool Exiftool::setMetadata(const QString &file, const QMap<QString, QString> &metadata, int msecs)
+{
+	return execute(file, metadataCommand(metadata), msecs);
+}
+
+bool Exiftool::setMetadata(const QList<QPair<QString, QMap<QString, QString>>> &files, int msecs)
+{
+	QStringList paths;
+	QStringList commands;
+	paths.reserve(files.count());
+	commands.reserve(files.count());
+	for (const auto &file : files) {
+		paths.append(file.first);
+		commands.append(metadataCommand(file.second));
+	}
+
+	return executeBatch(paths, commands, msecs);
 }
 
 bool Exiftool::execute(const QString &file, const QString &command, int msecs)
+{
+	return executeBatch({ file }, { command }, msecs);
+}
+
+/**
+ * Send all the commands at once, and only then wait for all of them to finish, to avoid a round-trip for each file.
+ */
+bool Exiftool::executeBatch(const QStringList &files, const QStringList &commands, int msecs)
 {
 	if (m_process.state() != QProcess::Running) {
 		log(QStringLiteral("Cannot execute command since Exiftool is not running"));
 		return false;
 	}
+	if (files.isEmpty()) {
+		return true;
+	}
 
-	QString toWrite = (command.isEmpty() ? "" : command + "\n") + file + "\n-execute\n";
+	QString toWrite;
+	for (int i = 0; i < files.count(); ++i) {
+		const QString &command = commands[i];
+		toWrite += (command.isEmpty() ? "" : command + "\n") + files[i] + "\n-execute\n";
+	}
 	m_process.write(toWrite.toLocal8Bit());
 
 	m_process.setReadChannel(QProcess::StandardOutput);
 
+	// Each command ends with a "{ready}" line, which can be split between two reads
+	QString output;
 	while (m_process.waitForReadyRead(msecs)) {
-		QString output = QString::fromLocal8Bit(m_process.readAllStandardOutput()).trimmed();
-		log(QString("[Exiftool] %1").arg(output), Logger::Debug);
-		if (output.endsWith("{ready}")) {
+		const QString chunk = QString::fromLocal8Bit(m_process.readAllStandardOutput());
+		log(QString("[Exiftool] %1").arg(chunk.trimmed()), Logger::Debug);
+
+		output += chunk;
+		if (output.count("{ready}") >= files.count()) {
 			return true;
 		}
 	}
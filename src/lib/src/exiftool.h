@@ -1,10 +1,13 @@
 #ifndef EXIFTOOL_H
 #define EXIFTOOL_H
 
+#include <QList>
 #include <QMap>
 #include <QObject>
+#include <QPair>
 #include <QProcess>
 #include <QString>
+#include <QStringList>
 
 
 class Exiftool : public QObject
@@ -19,12 +22,17 @@ class Exiftool : public QObject
 	public slots:
 		bool start(int msecs = 30000);
 		bool setMetadata(const QString &file, const QMap<QString, QString> &metadata, int msecs = 30000);
+		bool setMetadata(const QList<QPair<QString, QMap<QString, QString>>> &files, int msecs = 30000);
 		bool execute(const QString &file, const QString &command, int msecs = 30000);
+		bool executeBatch(const QStringList &files, const QStringList &commands, int msecs = 30000);
 		bool stop(int msecs = 30000);
 
 	protected slots:
 		void onError();
 
+	protected:
+		static QString metadataCommand(const QMap<QString, QString> &metadata);
+
 	private:
 		QProcess m_process;
 };
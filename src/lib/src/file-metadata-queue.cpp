@@ -0,0 +1,84 @@
+#include "file-metadata-queue.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+#include "functions.h"
+#include "post-save-queue.h"
+#ifdef WIN_FILE_PROPS
+	#include "windows-file-property.h"
+#endif
+
+
+FileMetadataQueue::FileMetadataQueue(PostSaveQueue *queue)
+	: m_queue(queue)
+{}
+
+FileMetadataQueue::~FileMetadataQueue()
+{
+	// Jobs still being run use this object
+	m_queue->waitForDone();
+}
+
+void FileMetadataQueue::add(const QString &path, const QDateTime &creationDate, const QList<QPair<QString, QString>> &properties)
+{
+	if (!creationDate.isValid() && properties.isEmpty()) {
+		return;
+	}
+
+	Entry entry;
+	entry.path = path;
+	entry.creationDate = creationDate;
+	entry.properties = properties;
+
+	// If a job is already waiting for this directory, it will also handle this file
+	const QString dir = QFileInfo(path).absolutePath();
+	{
+		QMutexLocker locker(&m_mutex);
+		const bool scheduled = m_pending.contains(dir);
+		m_pending[dir].append(entry);
+		if (scheduled) {
+			return;
+		}
+	}
+
+	m_queue->run(dir, [this, dir]() {
+		write(dir);
+	});
+}
+
+void FileMetadataQueue::write(const QString &dir)
+{
+	QList<Entry> entries;
+	{
+		QMutexLocker locker(&m_mutex);
+		entries = m_pending.take(dir);
+	}
+
+	#ifdef WIN_FILE_PROPS
+		bool hasProperties = false;
+		for (const Entry &entry : qAsConst(entries)) {
+			hasProperties = hasProperties || !entry.properties.isEmpty();
+		}
+		if (hasProperties) {
+			initializeWindowsProperties();
+		}
+	#endif
+
+	for (const Entry &entry : qAsConst(entries)) {
+		#ifdef WIN_FILE_PROPS
+			if (!entry.properties.isEmpty()) {
+				setWindowsProperties(entry.path, entry.properties);
+			}
+		#endif
+
+		// Committing properties rewrites the file, so the dates are set last
+		if (entry.creationDate.isValid()) {
+			setFileCreationDate(entry.path, entry.creationDate);
+		}
+	}
+
+	#ifdef WIN_FILE_PROPS
+		if (hasProperties) {
+			uninitializeWindowsProperties();
+		}
+	#endif
+}
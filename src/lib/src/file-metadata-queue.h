@@ -0,0 +1,44 @@
+#ifndef FILE_METADATA_QUEUE_H
+#define FILE_METADATA_QUEUE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+
+class PostSaveQueue;
+
+/**
+ * Writes the file system metadata of saved files (creation date, Windows properties) in the post-save queue.
+ *
+ * Files are batched per directory: all the files of a directory waiting to be written are handled by the same job,
+ * which only initializes COM once for the whole batch and opens the property store of each file a single time.
+ */
+class FileMetadataQueue
+{
+	public:
+		explicit FileMetadataQueue(PostSaveQueue *queue);
+		~FileMetadataQueue();
+
+		void add(const QString &path, const QDateTime &creationDate, const QList<QPair<QString, QString>> &properties = {});
+
+	protected:
+		struct Entry
+		{
+			QString path;
+			QDateTime creationDate;
+			QList<QPair<QString, QString>> properties;
+		};
+
+		void write(const QString &dir);
+
+	private:
+		PostSaveQueue *m_queue;
+		QMutex m_mutex;
+		QHash<QString, QList<Entry>> m_pending;
+};
+
+#endif // FILE_METADATA_QUEUE_H
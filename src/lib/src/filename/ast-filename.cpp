@@ -1,6 +1,8 @@
 #include "filename/ast-filename.h"
+#include <QMutexLocker>
 #include "filename/ast/filename-node-root.h"
 #include "filename/filename-parser.h"
+#include "filename/filename-program.h"
 #include "filename/filename-resolution-visitor.h"
 #if DEBUG
 	#include "filename/filename-print-visitor.h"
@@ -14,18 +16,28 @@ AstFilename::AstFilename(const QString &str)
 
 AstFilename::~AstFilename()
 {
+	delete m_program;
 	delete m_ast;
 }
 
 
 void AstFilename::parse()
 {
+	// Instances are shared between threads through the FilenameCache
+	QMutexLocker locker(&m_mutex);
+	if (m_parsed.loadAcquire()) {
+		return;
+	}
+
 	auto ast = m_parser.parseRoot();
 	if (m_parser.error().isEmpty()) {
 		m_ast = ast;
 
 		FilenameResolutionVisitor resolutionVisitor;
 		m_tokens = resolutionVisitor.run(*m_ast);
+		m_requirements = FilenameRequirements::fromVisitor(m_tokens, resolutionVisitor);
+
+		m_program = new FilenameProgram(*m_ast);
 
 		#if DEBUG
 			FilenamePrintVisitor printVisitor;
@@ -34,12 +46,12 @@ void AstFilename::parse()
 		#endif
 	}
 
-	m_parsed = true;
+	m_parsed.storeRelease(1);
 }
 
 const QString &AstFilename::error()
 {
-	if (!m_parsed) {
+	if (!m_parsed.loadAcquire()) {
 		parse();
 	}
 
@@ -48,18 +60,36 @@ const QString &AstFilename::error()
 
 FilenameNodeRoot *AstFilename::ast()
 {
-	if (!m_parsed) {
+	if (!m_parsed.loadAcquire()) {
 		parse();
 	}
 
 	return m_ast;
 }
 
+const FilenameProgram *AstFilename::program()
+{
+	if (!m_parsed.loadAcquire()) {
+		parse();
+	}
+
+	return m_program;
+}
+
 const QSet<QString> &AstFilename::tokens()
 {
-	if (!m_parsed) {
+	if (!m_parsed.loadAcquire()) {
 		parse();
 	}
 
 	return m_tokens;
 }
+
+const FilenameRequirements &AstFilename::requirements()
+{
+	if (!m_parsed.loadAcquire()) {
+		parse();
+	}
+
+	return m_requirements;
+}
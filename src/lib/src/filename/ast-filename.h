@@ -1,11 +1,15 @@
 #ifndef AST_FILENAME_H
 #define AST_FILENAME_H
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QSet>
 #include <QString>
 #include "filename/filename-parser.h"
+#include "filename/filename-requirements.h"
 
 
+class FilenameProgram;
 struct FilenameNodeRoot;
 
 class AstFilename
@@ -16,17 +20,22 @@ class AstFilename
 
 		const QString &error();
 		FilenameNodeRoot *ast();
+		const FilenameProgram *program();
 		const QSet<QString> &tokens();
+		const FilenameRequirements &requirements();
 
 	protected:
 		void parse();
 
 	private:
 		FilenameParser m_parser;
-		bool m_parsed = false;
+		QMutex m_mutex;
+		QAtomicInt m_parsed { 0 };
 
 		FilenameNodeRoot *m_ast = nullptr;
+		FilenameProgram *m_program = nullptr;
 		QSet<QString> m_tokens;
+		FilenameRequirements m_requirements;
 };
 
 #endif // AST_FILENAME_H
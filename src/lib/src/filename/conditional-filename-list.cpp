@@ -0,0 +1,84 @@
+#include "filename/conditional-filename-list.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSettings>
+#include <algorithm>
+#include <utility>
+#include "loader/token.h"
+
+
+ConditionalFilenameList::ConditionalFilenameList(QList<ConditionalFilename> filenames)
+	: m_filenames(std::move(filenames))
+{
+	for (int i = 0; i < m_filenames.count(); ++i) {
+		const QSet<QString> tags = m_filenames[i].requiredTags();
+		if (tags.isEmpty()) {
+			m_unindexed.append(i);
+		} else {
+			for (const QString &tag : tags) {
+				m_index[tag].append(i);
+			}
+		}
+	}
+}
+
+QSharedPointer<const ConditionalFilenameList> ConditionalFilenameList::fromSettings(QSettings *settings)
+{
+	// Flat list of condition, filename and folder triplets
+	QStringList raw;
+	settings->beginGroup(QStringLiteral("Filenames"));
+	const int count = settings->childKeys().count() / 3;
+	for (int i = 0; i < count; i++) {
+		const QString strI = QString::number(i);
+		if (settings->contains(strI + "_cond")) {
+			raw.append(settings->value(strI + "_cond").toString());
+			raw.append(settings->value(strI + "_fn").toString());
+			raw.append(settings->value(strI + "_dir").toString());
+		}
+	}
+	settings->endGroup();
+
+	static QMutex mutex;
+	static QStringList lastRaw;
+	static QSharedPointer<const ConditionalFilenameList> last;
+
+	QMutexLocker locker(&mutex);
+	if (last.isNull() || raw != lastRaw) {
+		QList<ConditionalFilename> filenames;
+		filenames.reserve(raw.count() / 3);
+		for (int i = 0; i + 2 < raw.count(); i += 3) {
+			filenames.append(ConditionalFilename(raw[i], raw[i + 1], raw[i + 2]));
+		}
+
+		last.reset(new ConditionalFilenameList(filenames));
+		lastRaw = raw;
+	}
+	return last;
+}
+
+const QList<ConditionalFilename> &ConditionalFilenameList::filenames() const
+{
+	return m_filenames;
+}
+
+QList<int> ConditionalFilenameList::candidates(const QMap<QString, Token> &tokens) const
+{
+	QList<int> ret = m_unindexed;
+
+	if (!m_index.isEmpty()) {
+		const auto it = tokens.constFind(QStringLiteral("allos"));
+		if (it != tokens.constEnd()) {
+			const QStringList tags = it.value().value().toStringList();
+			for (const QString &tag : tags) {
+				const auto filenames = m_index.constFind(tag);
+				if (filenames != m_index.constEnd()) {
+					ret.append(filenames.value());
+				}
+			}
+		}
+	}
+
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
@@ -0,0 +1,46 @@
+#ifndef CONDITIONAL_FILENAME_LIST_H
+#define CONDITIONAL_FILENAME_LIST_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include "filename/conditional-filename.h"
+
+
+class QSettings;
+class Token;
+
+/**
+ * Compiled list of conditional filenames, with their conditions indexed by the tags they require.
+ *
+ * Most conditions are based on the image's tags, so instead of evaluating all of them in order for every image, only
+ * the ones requiring one of the image's tags, and the ones that can't be indexed, are evaluated.
+ */
+class ConditionalFilenameList
+{
+	public:
+		ConditionalFilenameList() = default;
+		explicit ConditionalFilenameList(QList<ConditionalFilename> filenames);
+
+		/**
+		 * Get the conditional filenames from the settings, only parsing them again if they changed since last time.
+		 */
+		static QSharedPointer<const ConditionalFilenameList> fromSettings(QSettings *settings);
+
+		const QList<ConditionalFilename> &filenames() const;
+
+		/**
+		 * The indexes of the conditional filenames that can possibly match the given tokens, in their original order.
+		 */
+		QList<int> candidates(const QMap<QString, Token> &tokens) const;
+
+	private:
+		QList<ConditionalFilename> m_filenames;
+		QHash<QString, QList<int>> m_index;
+		QList<int> m_unindexed;
+};
+
+#endif // CONDITIONAL_FILENAME_LIST_H
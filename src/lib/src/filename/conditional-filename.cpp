@@ -2,9 +2,55 @@
 #include <QSettings>
 #include <utility>
 #include "filename/ast/filename-node-condition.h"
+#include "filename/ast/filename-node-condition-ignore.h"
+#include "filename/ast/filename-node-condition-op.h"
+#include "filename/ast/filename-node-condition-tag.h"
 #include "filename/filename-condition-visitor.h"
 #include "filename/filename-parser.h"
+#include "filename/filename-resolution-visitor.h"
 #include "logger.h"
+#include "models/filtering/tag-filter.h"
+
+
+/**
+ * Tags of which at least one must be present for the condition to be true, or an empty set if there are none.
+ */
+static QSet<QString> conditionRequiredTags(const FilenameNodeCondition *node)
+{
+	if (const auto *tag = dynamic_cast<const FilenameNodeConditionTag*>(node)) {
+		const auto *filter = dynamic_cast<const TagFilter*>(tag->filter);
+		if (filter != nullptr && !filter->plainTag().isEmpty() && filter->plainTag() == tag->tag.text()) {
+			return QSet<QString> { tag->tag.text() };
+		}
+		return {};
+	}
+
+	if (const auto *ignore = dynamic_cast<const FilenameNodeConditionIgnore*>(node)) {
+		return conditionRequiredTags(ignore->node);
+	}
+
+	if (const auto *op = dynamic_cast<const FilenameNodeConditionOp*>(node)) {
+		const QSet<QString> left = conditionRequiredTags(op->left);
+		const QSet<QString> right = conditionRequiredTags(op->right);
+
+		// For "and", requiring either side is enough, so use the most specific one
+		if (op->op == FilenameNodeConditionOp::And) {
+			if (left.isEmpty() || right.isEmpty()) {
+				return left.isEmpty() ? right : left;
+			}
+			return left.count() <= right.count() ? left : right;
+		}
+
+		// For "or", both sides need to require a tag
+		if (left.isEmpty() || right.isEmpty()) {
+			return {};
+		}
+		return left + right;
+	}
+
+	// Tokens, inverted conditions and JavaScript can match without any tag
+	return {};
+}
 
 
 ConditionalFilename::ConditionalFilename(QString condition, const QString &filename, QString path)
@@ -19,6 +65,10 @@ ConditionalFilename::ConditionalFilename(QString condition, const QString &filen
 		}
 
 		m_ast = ast;
+
+		FilenameResolutionVisitor resolutionVisitor;
+		const QSet<QString> tokens = resolutionVisitor.run(*m_ast);
+		m_conditionRequirements = FilenameRequirements::fromVisitor(tokens, resolutionVisitor);
 	}
 }
 
@@ -32,3 +82,27 @@ bool ConditionalFilename::matches(const QMap<QString, Token> &tokens, QSettings
 	FilenameConditionVisitor conditionVisitor(tokens, settings);
 	return conditionVisitor.run(*m_ast);
 }
+
+FilenameRequirements ConditionalFilename::requirements() const
+{
+	// Invalid conditions never match, so they don't need anything
+	if (m_ast == nullptr) {
+		return {};
+	}
+
+	FilenameRequirements ret = m_conditionRequirements;
+	ret.add(filename.requirements());
+	if (!path.isEmpty()) {
+		ret.add(Filename(path).requirements());
+	}
+	return ret;
+}
+
+QSet<QString> ConditionalFilename::requiredTags() const
+{
+	if (m_ast == nullptr) {
+		return {};
+	}
+
+	return conditionRequiredTags(m_ast);
+}
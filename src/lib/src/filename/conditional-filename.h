@@ -2,7 +2,9 @@
 #define CONDITIONAL_FILENAME_H
 
 #include <QMap>
+#include <QSet>
 #include <QString>
+#include "filename/filename-requirements.h"
 #include "models/filename.h"
 
 
@@ -16,12 +18,24 @@ class ConditionalFilename
 		ConditionalFilename(QString condition, const QString &filename, QString path);
 		bool matches(const QMap<QString, Token> &tokens, QSettings *settings) const;
 
+		/**
+		 * The tokens needed to evaluate the condition, and to generate the filename and folder if it matches.
+		 */
+		FilenameRequirements requirements() const;
+
+		/**
+		 * Tags of which at least one must be present in the image for the condition to match.
+		 * Empty if the condition can match without any specific tag.
+		 */
+		QSet<QString> requiredTags() const;
+
 		QString condition;
 		Filename filename;
 		QString path;
 
 	private:
 		FilenameNodeCondition *m_ast = nullptr;
+		FilenameRequirements m_conditionRequirements;
 };
 
 #endif // CONDITIONAL_FILENAME_H
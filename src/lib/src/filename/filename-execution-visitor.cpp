@@ -9,6 +9,7 @@
 #include <QTimeZone>
 #include <QVariant>
 #include <algorithm>
+#include <utility>
 #include "filename/ast/filename-node-condition-ignore.h"
 #include "filename/ast/filename-node-condition-tag.h"
 #include "filename/ast/filename-node-condition-token.h"
@@ -296,14 +297,20 @@ QString FilenameExecutionVisitor::variableToString(const QString &name, QStringL
 
 
 QString FilenameExecutionVisitor::cleanVariable(QString res, const QMap<QString, QString> &options) const
+{
+	const bool replaceBlanks = !options.contains("underscores") && (!m_settings->value("Save/replaceblanks", false).toBool() || options.contains("spaces"));
+	return cleanValue(std::move(res), !options.contains("unsafe"), replaceBlanks);
+}
+
+QString FilenameExecutionVisitor::cleanValue(QString res, bool removeForbidden, bool replaceBlanks)
 {
 	// Forbidden characters
-	if (!options.contains("unsafe")) {
+	if (removeForbidden) {
 		res = res.replace("\\", "_").replace("%", "_").replace("/", "_").replace(":", "_").replace("|", "_").replace("*", "_").replace("?", "_").replace("\"", "_").replace("<", "_").replace(">", "_").replace("__", "_").replace("__", "_").replace("__", "_").trimmed();
 	}
 
 	// Replace underscores by spaces
-	if (!options.contains("underscores") && (!m_settings->value("Save/replaceblanks", false).toBool() || options.contains("spaces"))) {
+	if (replaceBlanks) {
 		res = res.replace("_", " ");
 	}
 
@@ -36,6 +36,14 @@ class FilenameExecutionVisitor : public FilenameVisitorJavaScript
 		template <typename T>
 		QString variableToString(const QString &name, T val, const QMap<QString, QString> &options);
 
+		/**
+		 * Replace forbidden characters and/or underscores in a value.
+		 *
+		 * @param removeForbidden Whether to replace characters forbidden in filenames by underscores.
+		 * @param replaceBlanks Whether to replace underscores by spaces.
+		 */
+		static QString cleanValue(QString val, bool removeForbidden, bool replaceBlanks);
+
 	protected:
 		void visitVariable(const QString &name, const QMap<QString, QString> &options = {});
 		QString cleanVariable(QString val, const QMap<QString, QString> &options = {}) const;
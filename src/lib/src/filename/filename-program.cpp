@@ -0,0 +1,374 @@
+#include "filename/filename-program.h"
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QSettings>
+#include <QVariant>
+#include <algorithm>
+#include "filename/ast/filename-node-condition-ignore.h"
+#include "filename/ast/filename-node-condition-tag.h"
+#include "filename/ast/filename-node-condition-token.h"
+#include "filename/ast/filename-node-conditional.h"
+#include "filename/ast/filename-node-javascript.h"
+#include "filename/ast/filename-node-root.h"
+#include "filename/ast/filename-node-text.h"
+#include "filename/ast/filename-node-variable.h"
+#include "filename/ast/filename-visitor-base.h"
+#include "filename/filename-condition-visitor.h"
+#include "filename/filename-execution-visitor.h"
+#include "loader/token.h"
+
+
+enum NameFlag
+{
+	CleanValue = 1 << 0,
+	CleanList = 1 << 1,
+	Score = 1 << 2,
+	Kept = 1 << 3,
+};
+
+static int nameFlags(const QString &name)
+{
+	static const QSet<QString> unclean { "allo", "filename", "directory", "old_filename", "old_directory" };
+	static const QSet<QString> kept { "path", "num" };
+
+	int flags = 0;
+	if (!unclean.contains(name) && !name.startsWith("url_")) {
+		flags |= CleanValue;
+	}
+	if (!name.startsWith("source")) {
+		flags |= CleanList;
+	}
+	if (name == "score") {
+		flags |= Score;
+	}
+	if (kept.contains(name)) {
+		flags |= Kept;
+	}
+	return flags;
+}
+
+
+class FilenameProgramCompiler : public FilenameVisitorBase
+{
+	public:
+		explicit FilenameProgramCompiler(FilenameProgram &program)
+			: m_program(program)
+		{}
+
+		void visit(const FilenameNodeConditional &node) override
+		{
+			const int condition = emit(FilenameProgram::OpCode::Condition, m_program.m_conditions.count());
+			m_program.m_conditions.append(node.condition);
+
+			if (node.ifTrue != nullptr) {
+				node.ifTrue->accept(*this);
+			}
+
+			if (node.ifFalse != nullptr) {
+				const int jump = emit(FilenameProgram::OpCode::Jump, 0);
+				label(condition);
+				node.ifFalse->accept(*this);
+				label(jump);
+			} else {
+				label(condition);
+			}
+		}
+
+		void visit(const FilenameNodeConditionIgnore &node) override
+		{
+			Q_UNUSED(node); // No-op
+		}
+
+		void visit(const FilenameNodeConditionTag &node) override
+		{
+			// Both possible results are computed here, only the "Save/replaceblanks" setting is checked at runtime
+			const QString cleaned = FilenameExecutionVisitor::cleanValue(node.tag.text(), true, false);
+			emit(FilenameProgram::OpCode::CleanText, m_program.m_strings.count());
+			m_program.m_strings.append(cleaned);
+			m_program.m_strings.append(QString(cleaned).replace("_", " "));
+		}
+
+		void visit(const FilenameNodeConditionToken &node) override
+		{
+			variable(node.token, {});
+		}
+
+		void visit(const FilenameNodeJavaScript &node) override
+		{
+			emit(FilenameProgram::OpCode::Visit, m_program.m_nodes.count());
+			m_program.m_nodes.append(QSharedPointer<FilenameNodeRoot>::create(QList<FilenameNode*> { const_cast<FilenameNodeJavaScript*>(&node) }));
+		}
+
+		void visit(const FilenameNodeText &node) override
+		{
+			if (node.text.isEmpty()) {
+				return;
+			}
+			m_program.m_textLength += node.text.length();
+
+			// Merge consecutive literals, unless a jump lands between them
+			const int count = m_program.m_instructions.count();
+			if (count > m_barrier && m_program.m_instructions.last().op == FilenameProgram::OpCode::Text) {
+				m_program.m_strings[m_program.m_instructions.last().arg] += node.text;
+				return;
+			}
+
+			emit(FilenameProgram::OpCode::Text, m_program.m_strings.count());
+			m_program.m_strings.append(node.text);
+		}
+
+		void visit(const FilenameNodeVariable &node) override
+		{
+			variable(node.name, node.opts);
+		}
+
+	protected:
+		int emit(FilenameProgram::OpCode op, int arg)
+		{
+			m_program.m_instructions.append({ op, arg, -1 });
+			return m_program.m_instructions.count() - 1;
+		}
+
+		void label(int instruction)
+		{
+			m_barrier = m_program.m_instructions.count();
+			m_program.m_instructions[instruction].target = m_barrier;
+		}
+
+		void variable(const QString &fullName, const QMap<QString, QString> &options)
+		{
+			FilenameProgram::Variable var;
+			var.path = fullName.split('.');
+			var.name = var.path.last();
+			var.options = options;
+			var.nameFlags = nameFlags(var.name);
+
+			for (auto it = options.constBegin(); it != options.constEnd(); ++it) {
+				var.invalidOptions += it.key();
+				if (!it.value().isEmpty()) {
+					var.invalidOptions += "=" + it.value();
+				}
+			}
+
+			static const QHash<QString, int> flags {
+				{ "maxlength", FilenameProgram::MaxLength },
+				{ "htmlescape", FilenameProgram::HtmlEscape },
+				{ "escape", FilenameProgram::Escape },
+				{ "unsafe", FilenameProgram::Unsafe },
+				{ "underscores", FilenameProgram::Underscores },
+				{ "spaces", FilenameProgram::Spaces },
+				{ "sort", FilenameProgram::Sort },
+				{ "separator", FilenameProgram::Separator },
+				{ "count", FilenameProgram::Complex },
+				{ "ignorenamespace", FilenameProgram::Complex },
+				{ "includenamespace", FilenameProgram::Complex },
+			};
+			for (auto it = options.constBegin(); it != options.constEnd(); ++it) {
+				var.flags |= flags.value(it.key(), 0);
+			}
+			if (var.flags & FilenameProgram::MaxLength) {
+				var.maxLength = options["maxlength"].toInt();
+			}
+			if (var.flags & FilenameProgram::Separator) {
+				var.separator = options["separator"];
+				var.separator.replace("\\n", "\n").replace("\\r", "\r");
+			}
+
+			emit(FilenameProgram::OpCode::Variable, m_program.m_variables.count());
+			m_program.m_variables.append(var);
+		}
+
+	private:
+		FilenameProgram &m_program;
+		int m_barrier = 0;
+};
+
+
+struct FilenameProgram::Context
+{
+	Context(const QMap<QString, Token> &tokens, QSettings *settings)
+		: tokens(tokens), settings(settings), visitor(tokens, settings)
+	{}
+
+	const QString &separator(const QString &name)
+	{
+		auto it = separators.constFind(name);
+		if (it == separators.constEnd()) {
+			if (mainSeparator.isNull()) {
+				mainSeparator = settings->value("Save/separator", " ").toString();
+			}
+			QString separator = settings->value("Save/" + name + "_sep", mainSeparator).toString();
+			separator.replace("\\n", "\n").replace("\\r", "\r");
+			it = separators.insert(name, separator);
+		}
+		return it.value();
+	}
+
+	const QMap<QString, Token> &tokens;
+	QSettings *settings;
+	FilenameExecutionVisitor visitor;
+	QString (*escapeMethod)(const QVariant &) = nullptr;
+	bool keepInvalidTokens = false;
+	bool replaceBlanks = false;
+	QString mainSeparator;
+	QHash<QString, QString> separators;
+	QString result;
+};
+
+
+FilenameProgram::FilenameProgram(const FilenameNodeRoot &root)
+{
+	FilenameProgramCompiler compiler(*this);
+	root.accept(compiler);
+
+	m_instructions.squeeze();
+	m_variables.squeeze();
+}
+
+int FilenameProgram::size() const
+{
+	return m_instructions.count();
+}
+
+QString FilenameProgram::run(const QMap<QString, Token> &tokens, QSettings *settings, QString (*escapeMethod)(const QVariant &), bool keepInvalidTokens) const
+{
+	Context ctx(tokens, settings);
+	ctx.escapeMethod = escapeMethod;
+	ctx.keepInvalidTokens = keepInvalidTokens;
+	ctx.replaceBlanks = settings->value("Save/replaceblanks", false).toBool();
+	ctx.result.reserve(m_textLength + 32 * m_variables.count());
+
+	const int count = m_instructions.count();
+	int pc = 0;
+	while (pc < count) {
+		const Instruction &ins = m_instructions[pc++];
+		switch (ins.op) {
+			case OpCode::Text:
+				ctx.result += m_strings[ins.arg];
+				break;
+
+			case OpCode::CleanText:
+				ctx.result += m_strings[ins.arg + (ctx.replaceBlanks ? 0 : 1)];
+				break;
+
+			case OpCode::Variable:
+				runVariable(ctx, m_variables[ins.arg]);
+				break;
+
+			case OpCode::Condition: {
+				FilenameConditionVisitor conditionVisitor(tokens, settings);
+				if (!conditionVisitor.run(*m_conditions[ins.arg])) {
+					pc = ins.target;
+				}
+				break;
+			}
+
+			case OpCode::Jump:
+				pc = ins.target;
+				break;
+
+			case OpCode::Visit:
+				ctx.result += ctx.visitor.run(*m_nodes[ins.arg]);
+				break;
+		}
+	}
+
+	return ctx.result;
+}
+
+void FilenameProgram::runVariable(Context &ctx, const Variable &var) const
+{
+	// Contexts "obj.var"
+	bool found = true;
+	int index = 0;
+	QString name = var.path[index++];
+	const QMap<QString, Token> *context = &ctx.tokens;
+	QMap<QString, Token> subContext;
+	while (found && index < var.path.count()) {
+		auto it = context->constFind(name);
+		if (it != context->constEnd()) {
+			const QVariant val = it.value().value();
+			if (val.canConvert<QMap<QString, Token>>()) {
+				subContext = val.value<QMap<QString, Token>>();
+				context = &subContext;
+				name = var.path[index++];
+				continue;
+			}
+			break;
+		}
+		found = false;
+	}
+
+	// The name only differs from the compiled one when a context could not be resolved
+	const int flags = index == var.path.count() ? var.nameFlags : nameFlags(name);
+
+	// Variable not found
+	auto it = found ? context->constFind(name) : context->constEnd();
+	if (it == context->constEnd()) {
+		if (ctx.keepInvalidTokens || (flags & Kept)) {
+			ctx.result += "%" + name + (!var.invalidOptions.isEmpty() ? ":" + var.invalidOptions : QString()) + "%";
+		}
+		return;
+	}
+
+	const QVariant val = it.value().value();
+	const bool removeForbidden = !(var.flags & Unsafe);
+	const bool replaceBlanks = !(var.flags & Underscores) && (!ctx.replaceBlanks || (var.flags & Spaces));
+	QString res;
+	bool clean = false;
+
+	// Convert value to a basic string using the given options
+	const QVariant::Type type = val.type();
+	if (type == QVariant::DateTime) {
+		res = ctx.visitor.variableToString(name, val.toDateTime(), var.options);
+	} else if (type == QVariant::ULongLong) {
+		res = ctx.visitor.variableToString(name, val.toULongLong(), var.options);
+	} else if (type == QVariant::LongLong) {
+		res = ctx.visitor.variableToString(name, val.toLongLong(), var.options);
+	} else if (type == QVariant::UInt) {
+		res = ctx.visitor.variableToString(name, val.toUInt(), var.options);
+	} else if (type == QVariant::Int) {
+		res = ctx.visitor.variableToString(name, val.toInt(), var.options);
+	} else if (type == QVariant::StringList) {
+		if (var.flags & Complex) {
+			res = ctx.visitor.variableToString(name, val.toStringList(), var.options);
+		} else {
+			QStringList list = val.toStringList();
+			if (var.flags & Sort) {
+				std::sort(list.begin(), list.end());
+			}
+			if (flags & CleanList) {
+				for (QString &t : list) {
+					t = FilenameExecutionVisitor::cleanValue(t, removeForbidden, replaceBlanks);
+				}
+			}
+			res = list.join((var.flags & Separator) ? var.separator : ctx.separator(name));
+		}
+		clean = true;
+	} else if (flags & Score) {
+		res = ctx.visitor.variableToString(name, val.toString(), var.options);
+	} else {
+		res = val.toString();
+	}
+
+	// String options
+	if (var.flags & MaxLength) {
+		res = res.left(var.maxLength);
+	}
+	if (var.flags & HtmlEscape) {
+		res = res.toHtmlEscaped();
+	}
+
+	// Forbidden characters and spaces replacement settings
+	if ((flags & CleanValue) && !clean) {
+		res = FilenameExecutionVisitor::cleanValue(res, removeForbidden, replaceBlanks);
+	}
+
+	// Escape if necessary
+	if (ctx.escapeMethod != nullptr && (var.flags & Escape)) {
+		res = ctx.escapeMethod(res);
+	}
+
+	ctx.result += res;
+}
@@ -0,0 +1,96 @@
+#ifndef FILENAME_PROGRAM_H
+#define FILENAME_PROGRAM_H
+
+#include <QList>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+struct FilenameNode;
+struct FilenameNodeCondition;
+struct FilenameNodeRoot;
+class FilenameProgramCompiler;
+class QSettings;
+class QVariant;
+class Token;
+
+/**
+ * Flat representation of a filename AST.
+ *
+ * The tree is compiled once into a linear list of instructions, with variable paths split and options
+ * pre-parsed, so that rendering a filename for each image does not have to walk the tree again.
+ * The program keeps pointers to the AST nodes it was compiled from, so it must not outlive it.
+ */
+class FilenameProgram
+{
+	public:
+		explicit FilenameProgram(const FilenameNodeRoot &root);
+
+		/**
+		 * Render the program using the given tokens.
+		 * Behaves exactly like running a FilenameExecutionVisitor on the original AST.
+		 */
+		QString run(const QMap<QString, Token> &tokens, QSettings *settings, QString (*escapeMethod)(const QVariant &) = nullptr, bool keepInvalidTokens = false) const;
+
+		int size() const;
+
+	private:
+		enum class OpCode
+		{
+			Text, // Append a literal string
+			CleanText, // Append a literal string, cleaned using the current settings
+			Variable, // Append the value of a variable
+			Condition, // Jump to the target if the condition is false
+			Jump, // Jump to the target unconditionally
+			Visit, // Run the execution visitor on an AST node (JavaScript)
+		};
+
+		struct Instruction
+		{
+			OpCode op;
+			int arg;
+			int target;
+		};
+
+		enum VariableOption
+		{
+			MaxLength = 1 << 0,
+			HtmlEscape = 1 << 1,
+			Escape = 1 << 2,
+			Unsafe = 1 << 3,
+			Underscores = 1 << 4,
+			Spaces = 1 << 5,
+			Sort = 1 << 6,
+			Separator = 1 << 7,
+			Complex = 1 << 8, // Options only handled by the generic conversion (count, namespaces)
+		};
+
+		struct Variable
+		{
+			QStringList path; // Object contexts leading to the variable ("gallery.name")
+			QString name;
+			QMap<QString, QString> options;
+			QString invalidOptions; // Options as written in the format, used when keeping invalid tokens
+			int flags = 0;
+			int maxLength = 0;
+			QString separator;
+			int nameFlags = 0; // Behaviors depending only on the variable name
+		};
+
+		struct Context;
+		void runVariable(Context &ctx, const Variable &var) const;
+
+		QVector<Instruction> m_instructions;
+		QStringList m_strings;
+		QVector<Variable> m_variables;
+		QVector<const FilenameNodeCondition*> m_conditions;
+		QList<QSharedPointer<FilenameNodeRoot>> m_nodes;
+		int m_textLength = 0;
+
+		friend class FilenameProgramCompiler;
+};
+
+#endif // FILENAME_PROGRAM_H
@@ -0,0 +1,108 @@
+#include "filename/filename-requirements.h"
+#include <utility>
+#include "filename/filename-resolution-visitor.h"
+#include "models/image.h"
+
+
+static const QStringList tagTokens { "tags", "all", "allo", "artist", "copyright", "character", "model", "photo_set", "species", "meta", "general" };
+static const QStringList typedTagTokens { "artist", "copyright", "character", "model", "photo_set", "species", "meta", "general" };
+
+
+FilenameRequirements::FilenameRequirements(QSet<QString> tokens, bool tagTypes)
+	: tokens(std::move(tokens)), tagTypes(tagTypes)
+{}
+
+FilenameRequirements FilenameRequirements::fromVisitor(const QSet<QString> &tokens, const FilenameResolutionVisitor &visitor)
+{
+	FilenameRequirements ret(tokens, visitor.hasNamespaces());
+	if (visitor.hasTagConditions()) {
+		ret.tokens.insert("tags");
+	}
+	if (visitor.hasJavaScript()) {
+		ret.tokens.insert("*");
+	}
+	return ret;
+}
+
+void FilenameRequirements::add(const FilenameRequirements &other)
+{
+	tokens.unite(other.tokens);
+	tagTypes = tagTypes || other.tagTypes;
+}
+
+
+bool FilenameRequirements::needTags(const QStringList &customTokens) const
+{
+	for (const QString &token : tagTokens) {
+		if (tokens.contains(token)) {
+			return true;
+		}
+	}
+	for (const QString &token : customTokens) {
+		if (tokens.contains(token)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FilenameRequirements::needTagTypes() const
+{
+	if (tagTypes) {
+		return true;
+	}
+	for (const QString &token : typedTagTokens) {
+		if (tokens.contains(token)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int FilenameRequirements::needExactTags(const QStringList &forcedTokens, const QStringList &customTokens) const
+{
+	// JavaScript can use any token, so we can't know what's needed
+	if (tokens.contains("*") || forcedTokens.contains("*")) {
+		return 2;
+	}
+
+	// Some tokens are only returned by the details page
+	for (const QString &token : forcedTokens) {
+		if (tokens.contains(token)) {
+			return 2;
+		}
+	}
+
+	// Some sources require loading to get the tag list
+	if (forcedTokens.contains("tags") && needTags(customTokens)) {
+		return 2;
+	}
+
+	// Tag types come from detailed tags
+	if (needTagTypes()) {
+		return 1;
+	}
+
+	return 0;
+}
+
+bool FilenameRequirements::needDetails(const Image &image, const QStringList &forcedTokens, const QStringList &customTokens) const
+{
+	if (tokens.contains("*") || forcedTokens.contains("*")) {
+		return true;
+	}
+
+	// Forced tokens other than tags can't be detected as missing, since the listing can return a different value
+	for (const QString &token : forcedTokens) {
+		if (token != "tags" && tokens.contains(token)) {
+			return true;
+		}
+	}
+
+	// If the tags are only returned by the details page, but we already have them, there is no need to load them again
+	if (forcedTokens.contains("tags") && needTags(customTokens) && image.tags().isEmpty()) {
+		return true;
+	}
+
+	return needTagTypes() && image.hasUnknownTag();
+}
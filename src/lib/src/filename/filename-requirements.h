@@ -0,0 +1,53 @@
+#ifndef FILENAME_REQUIREMENTS_H
+#define FILENAME_REQUIREMENTS_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+
+class FilenameResolutionVisitor;
+class Image;
+
+/**
+ * The tokens a set of filenames, conditions and commands needs to be generated, as found by a static analysis of
+ * their ASTs. Tag conditions are stored as the "tags" token, and JavaScript, which can access anything, as "*".
+ *
+ * Comparing these tokens with the ones only returned by an image's details page allows to only load these details
+ * when the listing data is not enough.
+ */
+struct FilenameRequirements
+{
+	QSet<QString> tokens;
+	bool tagTypes = false;
+
+	FilenameRequirements() = default;
+	explicit FilenameRequirements(QSet<QString> tokens, bool tagTypes = false);
+	static FilenameRequirements fromVisitor(const QSet<QString> &tokens, const FilenameResolutionVisitor &visitor);
+
+	void add(const FilenameRequirements &other);
+
+	/**
+	 * Whether the tags are needed, either directly or through a custom token.
+	 */
+	bool needTags(const QStringList &customTokens) const;
+
+	/**
+	 * Whether the tags need to have their types, either to be split by type or to include namespaces.
+	 */
+	bool needTagTypes() const;
+
+	/**
+	 * Backward-compatible summary of these requirements.
+	 * @return 0 if the details are not needed, 1 if they are only needed if some tags have an unknown type, and 2 if they are always needed.
+	 */
+	int needExactTags(const QStringList &forcedTokens, const QStringList &customTokens) const;
+
+	/**
+	 * Whether the details of this image must be loaded, i.e. if some of the tokens are only returned by the details
+	 * page and are not already known from the listing.
+	 */
+	bool needDetails(const Image &image, const QStringList &forcedTokens, const QStringList &customTokens) const;
+};
+
+#endif // FILENAME_REQUIREMENTS_H
@@ -1,4 +1,5 @@
 #include "filename/filename-resolution-visitor.h"
+#include "filename/ast/filename-node-condition.h"
 #include "filename/ast/filename-node-condition-token.h"
 #include "filename/ast/filename-node-root.h"
 #include "filename/ast/filename-node-variable.h"
@@ -6,20 +7,75 @@
 
 QSet<QString> FilenameResolutionVisitor::run(const FilenameNodeRoot &node)
 {
-	m_results.clear();
+	reset();
+
+	node.accept(*this);
+
+	return m_results;
+}
+
+QSet<QString> FilenameResolutionVisitor::run(const FilenameNodeCondition &node)
+{
+	reset();
 
 	node.accept(*this);
 
 	return m_results;
 }
 
+void FilenameResolutionVisitor::reset()
+{
+	m_results.clear();
+	m_tagConditions = false;
+	m_javaScript = false;
+	m_namespaces = false;
+}
+
+
+bool FilenameResolutionVisitor::hasTagConditions() const
+{
+	return m_tagConditions;
+}
+
+bool FilenameResolutionVisitor::hasJavaScript() const
+{
+	return m_javaScript;
+}
+
+bool FilenameResolutionVisitor::hasNamespaces() const
+{
+	return m_namespaces;
+}
+
+
+void FilenameResolutionVisitor::visit(const FilenameNodeConditionJavaScript &node)
+{
+	Q_UNUSED(node);
+	m_javaScript = true;
+}
+
+void FilenameResolutionVisitor::visit(const FilenameNodeConditionTag &node)
+{
+	Q_UNUSED(node);
+	m_tagConditions = true;
+}
 
 void FilenameResolutionVisitor::visit(const FilenameNodeConditionToken &node)
 {
 	m_results.insert(node.token);
 }
 
+void FilenameResolutionVisitor::visit(const FilenameNodeJavaScript &node)
+{
+	Q_UNUSED(node);
+	m_javaScript = true;
+}
+
 void FilenameResolutionVisitor::visit(const FilenameNodeVariable &node)
 {
 	m_results.insert(node.name);
+
+	if (node.opts.contains("includenamespace")) {
+		m_namespaces = true;
+	}
 }
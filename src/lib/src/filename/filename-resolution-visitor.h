@@ -6,16 +6,43 @@
 #include "filename/ast/filename-visitor-base.h"
 
 
+struct FilenameNodeCondition;
+
 class FilenameResolutionVisitor : public FilenameVisitorBase
 {
 	public:
 		QSet<QString> run(const FilenameNodeRoot &node);
+		QSet<QString> run(const FilenameNodeCondition &node);
+
+		/**
+		 * Whether the visited AST contains tag conditions, which need the image's tags to be evaluated.
+		 */
+		bool hasTagConditions() const;
+
+		/**
+		 * Whether the visited AST contains JavaScript, which can access any token.
+		 */
+		bool hasJavaScript() const;
 
+		/**
+		 * Whether the visited AST contains variables with the "includenamespace" option, which need typed tags.
+		 */
+		bool hasNamespaces() const;
+
+		void visit(const FilenameNodeConditionJavaScript &node) override;
+		void visit(const FilenameNodeConditionTag &node) override;
 		void visit(const FilenameNodeConditionToken &node) override;
+		void visit(const FilenameNodeJavaScript &node) override;
 		void visit(const FilenameNodeVariable &node) override;
 
+	protected:
+		void reset();
+
 	private:
 		QSet<QString> m_results;
+		bool m_tagConditions = false;
+		bool m_javaScript = false;
+		bool m_namespaces = false;
 };
 
 #endif // FILENAME_RESOLUTION_VISITOR_H
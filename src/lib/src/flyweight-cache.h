@@ -1,38 +1,135 @@
 #ifndef FLYWEIGHT_CACHE_H
 #define FLYWEIGHT_CACHE_H
 
-#include <QMap>
+#include <QHash>
+#include <QReadWriteLock>
 #include <QSharedPointer>
 #include <QWeakPointer>
 
 
-template <class K, class T>
+/**
+ * Thread-safe cache of shared immutable objects, built from their key.
+ *
+ * Only weak references are kept, so objects are destroyed once nobody uses them anymore. Entries are split
+ * into shards each protected by a read-write lock, and entries of dead objects are swept every few insertions.
+ */
+template <class K, class T, int ShardCount = 16, int SweepInterval = 64>
 class FlyweightCache
 {
 	public:
 		static QSharedPointer<T> Get(const K &key);
 
+		/**
+		 * Remove the entries of all objects that were destroyed.
+		 */
+		static void Sweep();
+
+		/**
+		 * The number of entries in the cache, including the ones of destroyed objects not swept yet.
+		 */
+		static int Count();
+
 	private:
-		static QMap<K, QWeakPointer<T>> Map;
+		struct Shard
+		{
+			QReadWriteLock lock;
+			QHash<K, QWeakPointer<T>> map;
+			int insertions = 0;
+		};
+
+		static Shard &shard(const K &key);
+		static Shard *shards();
+		static void sweep(Shard &shard);
 };
 
 
-template <class K, class T>
-QMap<K, QWeakPointer<T>> FlyweightCache<K, T>::Map;
+template <class K, class T, int ShardCount, int SweepInterval>
+typename FlyweightCache<K, T, ShardCount, SweepInterval>::Shard *FlyweightCache<K, T, ShardCount, SweepInterval>::shards()
+{
+	static Shard shards[ShardCount];
+	return shards;
+}
 
-template <class K, class T>
-QSharedPointer<T> FlyweightCache<K, T>::Get(const K &key)
+template <class K, class T, int ShardCount, int SweepInterval>
+typename FlyweightCache<K, T, ShardCount, SweepInterval>::Shard &FlyweightCache<K, T, ShardCount, SweepInterval>::shard(const K &key)
 {
-	auto it = Map.find(key);
-	if (it != Map.end() && !it.value().isNull()) {
-		return QSharedPointer<T>(it.value());
+	return shards()[qHash(key) % ShardCount];
+}
+
+template <class K, class T, int ShardCount, int SweepInterval>
+QSharedPointer<T> FlyweightCache<K, T, ShardCount, SweepInterval>::Get(const K &key)
+{
+	Shard &s = shard(key);
+
+	// Fast path, when the object is already alive
+	{
+		QReadLocker locker(&s.lock);
+		auto it = s.map.constFind(key);
+		if (it != s.map.constEnd()) {
+			QSharedPointer<T> shared = it.value().toStrongRef();
+			if (!shared.isNull()) {
+				return shared;
+			}
+		}
+	}
+
+	QWriteLocker locker(&s.lock);
+
+	// Another thread might have created it while we were waiting for the lock
+	auto it = s.map.find(key);
+	if (it != s.map.end()) {
+		QSharedPointer<T> shared = it.value().toStrongRef();
+		if (!shared.isNull()) {
+			return shared;
+		}
 	}
 
 	const QSharedPointer<T> shared(new T(key));
-	const QWeakPointer<T> weak(shared);
-	Map.insert(key, weak);
+	if (it != s.map.end()) {
+		it.value() = shared;
+	} else {
+		s.map.insert(key, shared);
+		if (++s.insertions >= SweepInterval) {
+			sweep(s);
+		}
+	}
 
 	return shared;
 }
 
+template <class K, class T, int ShardCount, int SweepInterval>
+void FlyweightCache<K, T, ShardCount, SweepInterval>::sweep(Shard &shard)
+{
+	shard.insertions = 0;
+	for (auto it = shard.map.begin(); it != shard.map.end();) {
+		if (it.value().isNull()) {
+			it = shard.map.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+template <class K, class T, int ShardCount, int SweepInterval>
+void FlyweightCache<K, T, ShardCount, SweepInterval>::Sweep()
+{
+	Shard *all = shards();
+	for (int i = 0; i < ShardCount; ++i) {
+		QWriteLocker locker(&all[i].lock);
+		sweep(all[i]);
+	}
+}
+
+template <class K, class T, int ShardCount, int SweepInterval>
+int FlyweightCache<K, T, ShardCount, SweepInterval>::Count()
+{
+	int count = 0;
+	Shard *all = shards();
+	for (int i = 0; i < ShardCount; ++i) {
+		QReadLocker locker(&all[i].lock);
+		count += all[i].map.count();
+	}
+	return count;
+}
+
 #endif // FLYWEIGHT_CACHE_H
@@ -4,7 +4,6 @@
 #include <QDate>
 #include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QFont>
@@ -18,6 +17,7 @@
 #include <QTime>
 #include <QtMath>
 #include <QUrl>
+#include <QVarLengthArray>
 #include <QVector>
 #ifdef Q_OS_WIN
 	#include <Windows.h>
@@ -31,9 +31,14 @@
 	#include <QDebug>
 #endif
 #include "filename/conditional-filename.h"
+#include "filename/conditional-filename-list.h"
 #include "logger.h"
+#include "utils/file-utils.h"
+#include "utils/wildcard-matcher.h"
 #include "vendor/html-entities.h"
 
+#define MD5_READ_BUFFER_SIZE (1024 * 1024)
+
 
 int lastError()
 {
@@ -171,23 +176,7 @@ QMap<QString, QStringList> getCustoms(QSettings *settings)
  */
 QList<ConditionalFilename> getFilenames(QSettings *settings)
 {
-	QList<ConditionalFilename> ret;
-
-	settings->beginGroup(QStringLiteral("Filenames"));
-	const int count = settings->childKeys().count() / 3;
-	for (int i = 0; i < count; i++) {
-		const QString strI = QString::number(i);
-		if (settings->contains(strI + "_cond")) {
-			ret.append(ConditionalFilename(
-				settings->value(strI + "_cond").toString(),
-				settings->value(strI + "_fn").toString(),
-				settings->value(strI + "_dir").toString()
-			));
-		}
-	}
-	settings->endGroup();
-
-	return ret;
+	return ConditionalFilenameList::fromSettings(settings)->filenames();
 }
 
 QMap<int, QMap<QString, QVariant>> getExternalLogFiles(QSettings *settings)
@@ -249,22 +238,14 @@ QList<QPair<QString, QString>> getMetadataExiftool(QSettings *settings)
 
 QStringList removeWildards(const QStringList &elements, const QStringList &remove)
 {
-	QStringList tags;
+	WildcardMatcher matcher;
+	for (const QString &rem : remove) {
+		matcher.add(rem);
+	}
 
-	QRegExp reg;
-	reg.setCaseSensitivity(Qt::CaseInsensitive);
-	reg.setPatternSyntax(QRegExp::Wildcard);
+	QStringList tags;
 	for (const QString &tag : elements) {
-		bool removed = false;
-		for (const QString &rem : remove) {
-			reg.setPattern(rem);
-			if (reg.exactMatch(tag)) {
-				removed = true;
-				break;
-			}
-		}
-
-		if (!removed) {
+		if (!matcher.matches(tag)) {
 			tags.append(tag);
 		}
 	}
@@ -448,33 +429,130 @@ QString savePath(const QString &file, bool exists, bool writable)
 }
 
 /**
- * Return the levenshtein distance between two strings.
- * @param	s1	First string.
- * @param	s2	Second string.
- * @return		The levenshtein distance between s1 and s2.
+ * Myers' bit-parallel levenshtein distance, for patterns of at most 64 characters.
+ * Each bit of the vectors is a row of the DP matrix, so a whole column is computed at once.
  */
-int levenshtein(QString s1, QString s2)
+static int levenshteinBitParallel(const QString &pattern, const QString &text, int maxDistance)
 {
-	const int len1 = s1.size(), len2 = s2.size();
-	QVector<QVector<int>> d(len1 + 1, QVector<int>(len2 + 1));
+	const int m = pattern.length();
+	const int n = text.length();
+
+	// Positions of each character in the pattern
+	quint64 ascii[128] = {};
+	QVarLengthArray<QPair<ushort, quint64>, 16> others;
+	for (int i = 0; i < m; ++i) {
+		const ushort c = pattern[i].unicode();
+		if (c < 128) {
+			ascii[c] |= 1ull << i;
+			continue;
+		}
+		int k = 0;
+		while (k < others.count() && others[k].first != c) {
+			k++;
+		}
+		if (k == others.count()) {
+			others.append(qMakePair(c, quint64(0)));
+		}
+		others[k].second |= 1ull << i;
+	}
+
+	const quint64 last = 1ull << (m - 1);
+	quint64 pv = ~0ull;
+	quint64 mv = 0;
+	int score = m;
+	for (int j = 0; j < n; ++j) {
+		const ushort c = text[j].unicode();
+		quint64 eq = 0;
+		if (c < 128) {
+			eq = ascii[c];
+		} else {
+			for (const auto &other : others) {
+				if (other.first == c) {
+					eq = other.second;
+					break;
+				}
+			}
+		}
 
-	d[0][0] = 0;
-	for (int i = 1; i <= len1; ++i) {
-		d[i][0] = i;
+		const quint64 xv = eq | mv;
+		const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+		quint64 ph = mv | ~(xh | pv);
+		quint64 mh = pv & xh;
+		if (ph & last) {
+			score++;
+		} else if (mh & last) {
+			score--;
+		}
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+
+		// Each remaining character can lower the distance by one at most
+		if (maxDistance >= 0 && score - (n - j - 1) > maxDistance) {
+			return maxDistance + 1;
+		}
 	}
-	for (int i = 1; i <= len2; ++i) {
-		d[0][i] = i;
+
+	return score;
+}
+
+/**
+ * Classic DP levenshtein distance, only keeping two rows of the matrix.
+ */
+static int levenshteinDp(const QString &s1, const QString &s2, int maxDistance)
+{
+	const int len1 = s1.size(), len2 = s2.size();
+	QVector<int> previous(len2 + 1), current(len2 + 1);
+	for (int j = 0; j <= len2; ++j) {
+		previous[j] = j;
 	}
 
 	for (int i = 1; i <= len1; ++i) {
+		current[0] = i;
+		int rowMin = current[0];
 		for (int j = 1; j <= len2; ++j) {
-			const int a = qMin(d[i - 1][j] + 1, d[i][j - 1] + 1);
-			const int b = d[i - 1][j - 1] + (s1[i - 1] == s2[j - 1] ? 0 : 1);
-			d[i][j] = qMin(a, b);
+			const int a = qMin(previous[j] + 1, current[j - 1] + 1);
+			const int b = previous[j - 1] + (s1[i - 1] == s2[j - 1] ? 0 : 1);
+			current[j] = qMin(a, b);
+			rowMin = qMin(rowMin, current[j]);
 		}
+
+		// The distance can never go below the minimum of a row
+		if (maxDistance >= 0 && rowMin > maxDistance) {
+			return maxDistance + 1;
+		}
+		previous.swap(current);
 	}
 
-	return d[len1][len2];
+	return maxDistance >= 0 ? qMin(previous[len2], maxDistance + 1) : previous[len2];
+}
+
+/**
+ * Return the levenshtein distance between two strings.
+ * @param	s1			First string.
+ * @param	s2			Second string.
+ * @param	maxDistance	If positive, stop as soon as the distance is known to be greater than this value.
+ * @return				The levenshtein distance between s1 and s2, or maxDistance + 1 if it is greater than maxDistance.
+ */
+int levenshtein(const QString &s1, const QString &s2, int maxDistance)
+{
+	// The distance is symmetric, so use the shortest string as the pattern
+	const QString &pattern = s1.length() <= s2.length() ? s1 : s2;
+	const QString &text = s1.length() <= s2.length() ? s2 : s1;
+
+	// The distance is at least the difference of lengths
+	if (maxDistance >= 0 && text.length() - pattern.length() > maxDistance) {
+		return maxDistance + 1;
+	}
+	if (pattern.isEmpty()) {
+		return text.length();
+	}
+
+	if (pattern.length() <= 64) {
+		return levenshteinBitParallel(pattern, text, maxDistance);
+	}
+	return levenshteinDp(pattern, text, maxDistance);
 }
 
 #ifdef Q_OS_WIN
@@ -628,9 +706,37 @@ QString fixFilename(QString filename, QString path, int maxLength, bool invalidC
 	#endif
 }
 
+/**
+ * Number of bytes of a string once converted to UTF-8, without converting it.
+ */
+static int utf8Length(const QString &str)
+{
+	int length = 0;
+	const int count = str.length();
+	for (int i = 0; i < count; ++i) {
+		const QChar c = str[i];
+		if (c.unicode() < 0x80) {
+			length += 1;
+		} else if (c.unicode() < 0x800) {
+			length += 2;
+		} else if (c.isHighSurrogate() && i + 1 < count && str[i + 1].isLowSurrogate()) {
+			length += 4;
+			i++;
+		} else {
+			length += 3;
+		}
+	}
+	return length;
+}
+
 // https://stackoverflow.com/questions/26629382/how-to-shorten-qstring-in-a-way-that-when-converted-to-utf-8-it-is-shorter-than
 bool cutStringToUtf8Bytes(QString &str, int limit)
 {
+	// A UTF-16 code unit is never more than 3 bytes in UTF-8, so most strings don't need to be converted at all
+	if (str.length() * 3 <= limit || utf8Length(str) <= limit) {
+		return false;
+	}
+
 	QByteArray output = str.toUtf8();
 	if (output.size() > limit) {
 		int truncateAt = 0;
@@ -705,6 +811,47 @@ QString fixFilenameLinux(const QString &fn, const QString &path, int maxLength,
 	#define MAX_PATH 260
 #endif
 
+/**
+ * Replace by an underscore or remove the characters forbidden in Windows filenames, in a single pass.
+ */
+static void fixWindowsInvalidChars(QString &str)
+{
+	// 1 to replace the character, 2 to remove it
+	static const QVector<char> actions = []() {
+		QVector<char> ret(128, 0);
+		for (char c : { '<', '>', ':', '/', '|', '*' }) {
+			ret[c] = 1;
+		}
+		for (char c : { '"', '?' }) {
+			ret[c] = 2;
+		}
+		return ret;
+	}();
+
+	// Don't detach the string if there is nothing to fix, which is the most common case
+	const int length = str.length();
+	int first = 0;
+	while (first < length && (str[first].unicode() >= 128 || actions[str[first].unicode()] == 0)) {
+		first++;
+	}
+	if (first == length) {
+		return;
+	}
+
+	QChar *data = str.data();
+	int out = first;
+	for (int i = first; i < length; ++i) {
+		const ushort c = data[i].unicode();
+		const char action = c < 128 ? actions[c] : 0;
+		if (action == 0) {
+			data[out++] = data[i];
+		} else if (action == 1) {
+			data[out++] = QLatin1Char('_');
+		}
+	}
+	str.truncate(out);
+}
+
 QString fixFilenameWindows(const QString &fn, const QString &path, int maxLength, bool invalidChars)
 {
 	// Fix parameters
@@ -721,7 +868,7 @@ QString fixFilenameWindows(const QString &fn, const QString &path, int maxLength
 
 	// Forbidden characters
 	if (invalidChars) {
-		filename.replace('<', '_').replace('>', '_').replace(':', '_').remove('"').replace('/', '_').replace('|', '_').remove('?').replace('*', '_');
+		fixWindowsInvalidChars(filename);
 	}
 
 	// Fobidden directories or filenames
@@ -742,7 +889,7 @@ QString fixFilenameWindows(const QString &fn, const QString &path, int maxLength
 	// Fix directories
 	for (QString &part : parts) {
 		// A part cannot be one in the forbidden list
-		if (invalidChars && forbidden.contains(part, Qt::CaseInsensitive)) {
+		if (invalidChars && (part.length() == 3 || part.length() == 4) && forbidden.contains(part, Qt::CaseInsensitive)) {
 			part = part + "!";
 		}
 
@@ -871,6 +1018,11 @@ QString fixCloudflareEmail(const QString &a)
 }
 QString fixCloudflareEmails(QString html)
 {
+	// Most pages don't contain any protected email, so the regex doesn't need to run over them
+	if (!html.contains(QLatin1String("__cf_email__"))) {
+		return html;
+	}
+
 	static const QRegularExpression rx("<span class=\"__cf_email__\" data-cfemail=\"([^\"]+)\">\\[[^<]+\\]<\\/span>");
 	auto matches = rx.globalMatch(html);
 	while (matches.hasNext()) {
@@ -885,10 +1037,22 @@ QString fixCloudflareEmails(QString html)
 QString getFileMd5(const QString &path)
 {
 	QFile file(path);
-	if (!file.open(QFile::ReadOnly)) {
+	if (!file.open(QFile::ReadOnly | QFile::Unbuffered)) {
+		return QString();
+	}
+
+	// Read the file in large blocks, to keep reads sequential even when many files are hashed at the same time
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	QByteArray buffer(MD5_READ_BUFFER_SIZE, Qt::Uninitialized);
+	qint64 read;
+	while ((read = file.read(buffer.data(), buffer.size())) > 0) {
+		hash.addData(buffer.constData(), static_cast<int>(read));
+	}
+	if (read < 0) {
 		return QString();
 	}
-	return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5).toHex();
+
+	return hash.result().toHex();
 }
 
 QString getFilenameToken(const QString &fileName, const QString &format, const QString &token, const QString &regex = ".+")
@@ -998,41 +1162,13 @@ QFont qFontFromString(const QString &str)
 	return font;
 }
 
-bool isFileParentWithSuffix(const QString &fileName, const QString &parent, const QStringList &suffixes)
-{
-	for (const QString &suffix : suffixes) {
-		if (fileName == parent + suffix) {
-			return true;
-		}
-	}
-	return false;
-}
 QList<QPair<QString, QStringList>> listFilesFromDirectory(const QDir &dir, const QStringList &suffixes)
 {
-	auto files = QList<QPair<QString, QStringList>>();
-
-	QDirIterator it(dir, QDirIterator::Subdirectories);
-	while (it.hasNext()) {
-		it.next();
-
-		if (it.fileInfo().isDir()) {
-			continue;
-		}
-
-		QString path = it.filePath();
-		const QString fileName = path.right(path.length() - dir.absolutePath().length() - 1);
-
-		if (!files.isEmpty()) {
-			const QString &previous = files.last().first;
-			if (isFileParentWithSuffix(fileName, previous, suffixes)) {
-				files.last().second.append(fileName);
-				continue;
-			}
-		}
-
-		files.append(QPair<QString, QStringList>(fileName, QStringList()));
-	}
-
+	QList<QPair<QString, QStringList>> files;
+	walkFilesFromDirectory(dir, suffixes, [&files](const QString &fileName, const QStringList &children) {
+		files.append(qMakePair(fileName, children));
+		return true;
+	});
 	return files;
 }
 
@@ -1068,11 +1204,16 @@ bool isVariantEmpty(const QVariant &value)
 
 QString decodeHtmlEntities(const QString &html)
 {
+	// Most strings have no entity at all, in which case they are returned as-is without any allocation
+	if (!html.contains(QLatin1Char('&'))) {
+		return html;
+	}
+
+	// Decoded entities are never longer than the entities themselves, so it can be done in-place
 	QByteArray data = html.toUtf8();
-	const char *src = data.constData();
-	auto *dest = new char[strlen(src) + 1];
-	decode_html_entities_utf8(dest, src);
-	return QString::fromUtf8(dest);
+	const size_t length = decode_html_entities_utf8(data.data(), nullptr);
+	data.truncate(static_cast<int>(length));
+	return QString::fromUtf8(data);
 }
 
 bool canCreateLinkType(const QString &type, const QString &dir)
@@ -42,7 +42,7 @@ QStringList splitStringMulti(const QList<QChar> &seps, const QString &str, bool
 
 QDateTime qDateTimeFromString(const QString &str);
 QString savePath(const QString &file = "", bool exists = false, bool writable = true);
-int levenshtein(QString, QString);
+int levenshtein(const QString &s1, const QString &s2, int maxDistance = -1);
 QString stripTags(QString);
 QString getUnit(double *size);
 QString formatFilesize(double size);
@@ -1,6 +1,7 @@
 #include "loader/downloadable.h"
 #include <QFile>
 #include <QSettings>
+#include <QSharedPointer>
 #include <QStringList>
 #include "functions.h"
 #include "loader/token.h"
@@ -26,24 +27,27 @@ const QMap<QString, Token> &Downloadable::tokens(Profile *profile) const
 	if (m_tokens.isEmpty()) {
 		auto tokens = generateTokens(profile);
 
-		// Custom tokens (if the tokens contain tags)
-		if (tokens.contains("tags")) {
-			const QList<Tag> &tags = tokens["tags"].value<QList<Tag>>();
-			QMap<QString, QStringList> scustom = getCustoms(profile->getSettings());
-			QMap<QString, QStringList> custom;
-			for (const Tag &tag : tags) {
+		// Custom tokens (if the tokens contain tags), computed lazily as they require the tags
+		const QMap<QString, QStringList> scustom = getCustoms(profile->getSettings());
+		if (tokens.contains("tags") && !scustom.isEmpty()) {
+			const Token tagsToken = tokens["tags"];
+			const auto custom = QSharedPointer<Token>::create([tagsToken, scustom]() -> QVariant {
+				const QList<Tag> &tags = tagsToken.value<QList<Tag>>();
+				QVariantMap ret;
 				for (auto it = scustom.constBegin(); it != scustom.constEnd(); ++it) {
-					const QString &key = it.key();
-					if (!custom.contains(key)) {
-						custom.insert(key, QStringList());
-					}
-					if (it.value().contains(tag.text(), Qt::CaseInsensitive)) {
-						custom[key].append(tag.text());
+					QStringList matches;
+					for (const Tag &tag : tags) {
+						if (it.value().contains(tag.text(), Qt::CaseInsensitive)) {
+							matches.append(tag.text());
+						}
 					}
+					ret.insert(it.key(), matches);
 				}
-			}
-			for (auto it = custom.constBegin(); it != custom.constEnd(); ++it) {
-				tokens.insert(it.key(), Token(it.value()));
+				return ret;
+			});
+			for (auto it = scustom.constBegin(); it != scustom.constEnd(); ++it) {
+				const QString key = it.key();
+				tokens.insert(key, Token([custom, key]() -> QVariant { return custom->value().toMap().value(key); }));
 			}
 		}
 
@@ -94,4 +98,10 @@ const QMap<QString, Token> &Downloadable::tokens(Profile *profile) const
 void Downloadable::refreshTokens()
 {
 	m_tokens.clear();
+	m_tokensGeneration++;
+}
+
+int Downloadable::tokensGeneration() const
+{
+	return m_tokensGeneration;
 }
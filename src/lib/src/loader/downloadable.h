@@ -24,6 +24,7 @@ class Downloadable
 			AlreadyExistsDisk,
 			AlreadyExistsMd5,
 			AlreadyExistsDeletedMd5,
+			AlreadyExistsSimilar,
 			Blacklisted,
 			Moved,
 			Copied,
@@ -63,8 +64,14 @@ class Downloadable
 	protected:
 		virtual QMap<QString, Token> generateTokens(Profile *profile) const = 0;
 
+		/**
+		 * Incremented each time the tokens are refreshed, to know when other values computed from them are outdated.
+		 */
+		int tokensGeneration() const;
+
 	private:
 		mutable QMap<QString, Token> m_tokens;
+		int m_tokensGeneration = 0;
 };
 
 #endif // DOWNLOADABLE_H
@@ -2,6 +2,7 @@
 #include <QEventLoop>
 #include <QtMath>
 #include <utility>
+#include "models/api/api.h"
 #include "models/image.h"
 #include "models/page.h"
 #include "models/site.h"
@@ -9,36 +10,116 @@
 
 
 PackLoader::PackLoader(Profile *profile, DownloadQueryGroup query, int packSize, QObject *parent)
-	: QObject(parent), m_profile(profile), m_site(query.site), m_query(std::move(query)), m_packSize(packSize)
+	: QObject(parent), m_profile(profile), m_site(query.site), m_query(std::move(query)), m_packSize(packSize), m_pageSize(m_query.perpage)
 {}
 
+PackLoader::~PackLoader()
+{
+	// Pending pages might still be loading if they were prefetched
+	for (Page *page : qAsConst(m_pendingPages)) {
+		page->deleteLater();
+	}
+	for (Page *page : qAsConst(m_pendingGalleries)) {
+		page->deleteLater();
+	}
+}
+
 const DownloadQueryGroup &PackLoader::query() const { return m_query; }
+const DownloadQueryGroup::Checkpoint &PackLoader::checkpoint() const { return m_checkpoint; }
 int PackLoader::nextPackSize() const { return qMin(m_packSize, m_query.total - m_total); }
 
 bool PackLoader::start(bool login)
 {
-	// Login to the site
-	if (login) {
+	// Login to the site, unless it was already done for the whole batch
+	if (login && !m_site->hasValidSession()) {
 		QEventLoop loop;
 		QObject::connect(m_site, &Site::loggedIn, &loop, &QEventLoop::quit, Qt::QueuedConnection);
 		m_site->login();
 		loop.exec();
 	}
 
-	// Resume stopped downloads
-	int page = m_query.page;
-	if (m_query.progressVal > 0) {
+	// Resume stopped downloads, directly from where they stopped if possible
+	DownloadQueryGroup::Checkpoint checkpoint;
+	checkpoint.page = m_query.page;
+	m_pageSize = m_query.perpage;
+	if (m_query.progressVal > 0 && m_query.checkpoint.page > 0) {
+		checkpoint = m_query.checkpoint;
+		m_total = checkpoint.total;
+		m_skip = checkpoint.skip;
+		if (checkpoint.perPage > 0) {
+			m_pageSize = checkpoint.perPage;
+		}
+	} else if (m_query.progressVal > 0) {
 		const int pagesToSkip = qFloor(m_query.progressVal / m_query.perpage);
-		page += pagesToSkip;
+		checkpoint.page += pagesToSkip;
 		m_total = pagesToSkip * m_query.perpage;
+	} else if (m_useMaxLimit) {
+		// Larger pages can only be used if the first one still starts at the same image
+		const int pageSize = maxPageSize();
+		const int offset = (m_query.page - 1) * m_query.perpage;
+		if (pageSize > m_pageSize && offset % pageSize == 0) {
+			m_pageSize = pageSize;
+			checkpoint.page = offset / pageSize + 1;
+		}
 	}
+	checkpoint.perPage = m_pageSize != m_query.perpage ? m_pageSize : 0;
 
-	// Add the first results page
-	m_pendingPages.enqueue(new Page(m_profile, m_site, { m_site }, m_query.query, page, m_query.perpage, m_query.postFiltering, false, nullptr));
+	// Add the first results page, using the cursor of the page before it if we have one
+	Page *first = new Page(m_profile, m_site, { m_site }, m_query.query, checkpoint.page, m_pageSize, m_query.postFiltering, false, nullptr);
+	if (checkpoint.lastPage > 0) {
+		first->setLastPage(checkpoint.lastPage, checkpoint.lastPageMinId, checkpoint.lastPageMaxId, checkpoint.lastPageMinDate, checkpoint.lastPageMaxDate, true);
+	}
+	m_pageCheckpoints.insert(first, checkpoint);
+	m_pendingPages.enqueue(first);
+
+	// Allow loaders to load their first pages in parallel
+	prefetch();
 
 	return true;
 }
 
+void PackLoader::setPrefetch(int depth, int maxImages)
+{
+	m_prefetchDepth = depth;
+	m_prefetchMaxImages = maxImages;
+}
+
+void PackLoader::setGalleryPrefetch(int depth)
+{
+	m_galleryPrefetchDepth = depth;
+}
+
+void PackLoader::setUseMaxLimit(bool useMaxLimit)
+{
+	m_useMaxLimit = useMaxLimit;
+}
+
+/**
+ * The API used for a page is only known once it is loaded, so the limit has to be supported by all of them.
+ * APIs with a forced limit ignore the one requested anyway.
+ */
+int PackLoader::maxPageSize() const
+{
+	int maxLimit = -1;
+	for (Api *api : m_site->getApis()) {
+		if (api->forcedLimit() > 0) {
+			continue;
+		}
+		const int limit = api->maxLimit();
+		if (limit <= 0) {
+			return m_query.perpage;
+		}
+		maxLimit = maxLimit < 0 ? limit : qMin(maxLimit, limit);
+	}
+
+	// No need to load more images than the group needs
+	if (m_query.total > 0) {
+		maxLimit = qMin(maxLimit, m_query.total);
+	}
+
+	return qMax(m_query.perpage, maxLimit);
+}
+
 void PackLoader::abort()
 {
 	m_abort = true;
@@ -51,12 +132,14 @@ bool PackLoader::hasNext() const
 
 QList<QSharedPointer<Image>> PackLoader::next()
 {
-	const int maxPages = qMax(1, qCeil(static_cast<qreal>(m_packSize) / m_query.perpage));
+	const int maxPages = qMax(1, qCeil(static_cast<qreal>(m_packSize) / m_pageSize));
 	const int already = m_total;
 
 	QList<QSharedPointer<Image>> results;
 	int pageCount = 0;
 
+	m_checkpoint = currentCheckpoint();
+
 	if (!m_overflow.isEmpty()) {
 		while (!m_overflow.isEmpty() && (results.isEmpty() || results.count() < m_packSize || m_packSize < 0) && (already + results.count() != m_query.total || (m_overflowGallery && m_query.galleriesCountAsOne))) {
 			results.append(m_overflow.takeFirst());
@@ -80,15 +163,27 @@ QList<QSharedPointer<Image>> PackLoader::next()
 
 		bool gallery = !m_pendingGalleries.isEmpty();
 
-		// Load next page/gallery
-		QEventLoop loop;
+		// Load next page/gallery, unless it was already prefetched
 		Page *page = gallery ? m_pendingGalleries.dequeue() : m_pendingPages.dequeue();
-		QObject::connect(page, &Page::finishedLoading, &loop, &QEventLoop::quit);
-		QObject::connect(page, &Page::failedLoading, &loop, &QEventLoop::quit);
-		page->load(false);
-		loop.exec();
+		if (m_prefetched.value(page, -1) < 0) {
+			QEventLoop loop;
+			QObject::connect(page, &Page::finishedLoading, &loop, &QEventLoop::quit);
+			QObject::connect(page, &Page::failedLoading, &loop, &QEventLoop::quit);
+			if (!m_prefetched.contains(page)) {
+				page->load(false);
+			}
+			loop.exec();
+		}
+		m_prefetched.remove(page);
 		emit finishedPage(page);
 
+		// Images skipped when resuming were already counted
+		if (!gallery) {
+			m_lastPageCheckpoint = m_pageCheckpoints.take(page);
+			m_lastPageCheckpoint.total = m_total - m_skip;
+			m_lastPageCheckpoint.skip = 0;
+		}
+
 		// Add results to the data object
 		for (const QSharedPointer<Image> &img : page->images()) {
 			// If this result is a gallery, add it to the beginning of the pending galleries
@@ -101,6 +196,12 @@ QList<QSharedPointer<Image>> PackLoader::next()
 				continue;
 			}
 
+			// Skip images already downloaded before resuming
+			if (!gallery && m_skip > 0) {
+				m_skip--;
+				continue;
+			}
+
 			// If it's an image, add it to the results
 			if (results.count() >= m_packSize) {
 				m_overflow.append(img);
@@ -120,10 +221,9 @@ QList<QSharedPointer<Image>> PackLoader::next()
 			}
 		}
 
-		// Add next page to the pending queue
-		if (page->hasNext()) {
-			Page *next = new Page(m_profile, m_site, { m_site }, page->query(), page->page() + 1, m_query.perpage, m_query.postFiltering, false, nullptr);
-			next->setLastPage(page);
+		// Add next page to the pending queue (if it was not already done when prefetching)
+		if (page->hasNext() && !m_nextPageCreated.remove(page)) {
+			Page *next = createNextPage(page);
 			if (gallery) {
 				m_pendingGalleries.enqueue(next);
 			} else {
@@ -138,10 +238,163 @@ QList<QSharedPointer<Image>> PackLoader::next()
 
 		if (!gallery) {
 			pageCount++;
+			m_skip = 0;
 		}
 
+		m_galleryPagesCount.remove(page);
+		m_pageCheckpoints.remove(page);
 		page->deleteLater();
 	}
 
+	// Keep the network busy while the images of this pack are downloaded
+	prefetch();
+
 	return results;
 }
+
+Page *PackLoader::createNextPage(Page *page)
+{
+	const int perPage = page->query().gallery.isNull() ? m_pageSize : m_query.perpage;
+	Page *next = new Page(m_profile, m_site, { m_site }, page->query(), page->page() + 1, perPage, m_query.postFiltering, false, nullptr);
+	next->setLastPage(page, true);
+
+	// Results pages can be resumed from, using the previous page as a cursor
+	if (page->query().gallery.isNull()) {
+		DownloadQueryGroup::Checkpoint checkpoint;
+		checkpoint.page = next->page();
+		checkpoint.perPage = m_pageSize != m_query.perpage ? m_pageSize : 0;
+		checkpoint.lastPage = page->page();
+		checkpoint.lastPageMinId = page->minId();
+		checkpoint.lastPageMaxId = page->maxId();
+		checkpoint.lastPageMinDate = page->minDate();
+		checkpoint.lastPageMaxDate = page->maxDate();
+		m_pageCheckpoints.insert(next, checkpoint);
+	}
+
+	// Remember the gallery's page count, so that its next page can also be created before this one is loaded
+	if (!page->query().gallery.isNull()) {
+		const int count = galleryPagesCount(page);
+		if (count > 0) {
+			m_galleryPagesCount.insert(next, count);
+		}
+	}
+
+	return next;
+}
+
+/**
+ * Images are only counted once returned by next(), so the safest place to resume from is the page the next images
+ * will come from. Images of that page already returned are skipped, unless galleries make them too hard to count.
+ */
+DownloadQueryGroup::Checkpoint PackLoader::currentCheckpoint() const
+{
+	// The next images come from the overflow of the last results page
+	if (!m_overflow.isEmpty() && !m_overflowGallery && m_pendingGalleries.isEmpty()) {
+		DownloadQueryGroup::Checkpoint checkpoint = m_lastPageCheckpoint;
+		checkpoint.skip = m_total - checkpoint.total;
+		checkpoint.total = m_total;
+		return checkpoint;
+	}
+
+	// The next images come from the galleries of the last results page, so it has to be loaded again entirely
+	if (!m_overflow.isEmpty() || !m_pendingGalleries.isEmpty()) {
+		return m_lastPageCheckpoint;
+	}
+
+	// The next images come from the next results page
+	if (!m_pendingPages.isEmpty()) {
+		DownloadQueryGroup::Checkpoint checkpoint = m_pageCheckpoints.value(m_pendingPages.head());
+		checkpoint.total = m_total;
+		return checkpoint;
+	}
+
+	return DownloadQueryGroup::Checkpoint();
+}
+
+/**
+ * Start loading the pages next() will need, in the same order, until the prefetch depth or image limit is reached.
+ */
+void PackLoader::prefetch()
+{
+	if (m_prefetchDepth <= 0 && m_galleryPrefetchDepth <= 0) {
+		return;
+	}
+
+	queueGalleryPages();
+
+	// Pages still loading are counted as full pages
+	int buffered = m_overflow.count();
+	for (auto it = m_prefetched.constBegin(); it != m_prefetched.constEnd(); ++it) {
+		buffered += it.value() < 0 ? m_pageSize : it.value();
+	}
+
+	// Galleries are handled before the next results pages, so they share the same depth unless they have their own
+	const int galleriesDepth = qMax(m_prefetchDepth, m_galleryPrefetchDepth);
+	prefetchPages(m_pendingGalleries, galleriesDepth, buffered);
+	prefetchPages(m_pendingPages, m_prefetchDepth - qMin(m_pendingGalleries.count(), m_prefetchDepth), buffered);
+}
+
+void PackLoader::prefetchPages(const QQueue<Page*> &pages, int depth, int &buffered)
+{
+	for (int i = 0; i < pages.count() && i < depth; ++i) {
+		if (m_prefetched.contains(pages[i])) {
+			continue;
+		}
+
+		// Don't buffer too many images, or more than the images we still need to download
+		if ((m_prefetchMaxImages >= 0 && buffered >= m_prefetchMaxImages) || (m_query.total >= 0 && m_total + buffered >= m_query.total)) {
+			break;
+		}
+
+		prefetchPage(pages[i]);
+		buffered += pages[i]->query().gallery.isNull() ? m_pageSize : m_query.perpage;
+	}
+}
+
+/**
+ * The URL of each gallery page only depends on its number, so once a gallery's page count is known, its next pages
+ * are created right away, allowing them to be loaded in parallel instead of waiting for each previous page.
+ */
+void PackLoader::queueGalleryPages()
+{
+	for (int i = 0; i < m_pendingGalleries.count() && i + 1 < m_galleryPrefetchDepth; ++i) {
+		Page *page = m_pendingGalleries[i];
+		if (m_nextPageCreated.contains(page) || galleryPagesCount(page) <= page->page()) {
+			continue;
+		}
+
+		m_pendingGalleries.insert(i + 1, createNextPage(page));
+		m_nextPageCreated.insert(page);
+	}
+}
+
+int PackLoader::galleryPagesCount(Page *page) const
+{
+	const int count = page->isLoaded() ? page->pagesCount(false) : -1;
+	return count > 0 ? count : m_galleryPagesCount.value(page, -1);
+}
+
+void PackLoader::prefetchPage(Page *page)
+{
+	m_prefetched.insert(page, -1);
+
+	connect(page, &Page::finishedLoading, this, &PackLoader::prefetchFinished);
+	connect(page, &Page::failedLoading, this, &PackLoader::prefetchFinished);
+	page->load(false);
+}
+
+void PackLoader::prefetchFinished(Page *page)
+{
+	if (!m_prefetched.contains(page)) {
+		return;
+	}
+	m_prefetched[page] = page->images().count();
+
+	// Results pages are loaded sequentially, so we can directly queue the next one to prefetch it too
+	if (page->query().gallery.isNull() && page->hasNext() && m_pendingPages.contains(page)) {
+		m_pendingPages.enqueue(createNextPage(page));
+		m_nextPageCreated.insert(page);
+	}
+
+	prefetch();
+}
@@ -1,9 +1,11 @@
 #ifndef PACK_LOADER_H
 #define PACK_LOADER_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QQueue>
+#include <QSet>
 #include <QSharedPointer>
 #include "downloader/download-query-group.h"
 
@@ -19,13 +21,52 @@ class PackLoader : public QObject
 
 	public:
 		explicit PackLoader(Profile *profile, DownloadQueryGroup query, int packSize = 1000, QObject *parent = nullptr);
+		~PackLoader() override;
 		const DownloadQueryGroup &query() const;
+
+		/**
+		 * Keep loading pages in the background between calls to next().
+		 *
+		 * @param depth The maximum number of pages loaded in advance, 0 to disable prefetching.
+		 * @param maxImages The maximum number of images buffered from these pages, -1 for no limit.
+		 */
+		void setPrefetch(int depth, int maxImages = -1);
+
+		/**
+		 * Load the pages of galleries in parallel, once their first page gave their page count.
+		 *
+		 * @param depth The maximum number of gallery pages loaded in advance, 0 to load them one at a time.
+		 */
+		void setGalleryPrefetch(int depth);
+
+		/**
+		 * Request results pages with the largest limit the site's APIs support, instead of the group's own.
+		 * Images are still returned in packs of the same size, only the number of listing requests changes.
+		 */
+		void setUseMaxLimit(bool useMaxLimit);
+
 		int nextPackSize() const;
 		bool start(bool login = true);
 		void abort();
 		bool hasNext() const;
 		QList<QSharedPointer<Image>> next();
 
+		/**
+		 * Where to resume loading from if the images returned by the last call to next() were not all downloaded.
+		 */
+		const DownloadQueryGroup::Checkpoint &checkpoint() const;
+
+	protected:
+		void prefetch();
+		void prefetchPages(const QQueue<Page*> &pages, int depth, int &buffered);
+		void prefetchPage(Page *page);
+		void queueGalleryPages();
+		int galleryPagesCount(Page *page) const;
+		void prefetchFinished(Page *page);
+		Page *createNextPage(Page *page);
+		int maxPageSize() const;
+		DownloadQueryGroup::Checkpoint currentCheckpoint() const;
+
 	signals:
 		void finishedPage(Page *page);
 
@@ -41,6 +82,18 @@ class PackLoader : public QObject
 		bool m_overflowGallery = false;
 		bool m_overflowHasNext = false;
 		bool m_abort = false;
+		int m_prefetchDepth = 0;
+		int m_prefetchMaxImages = -1;
+		int m_galleryPrefetchDepth = 0;
+		bool m_useMaxLimit = false;
+		int m_pageSize; // Images requested per results page
+		QHash<Page*, int> m_galleryPagesCount; // Known page count of the gallery of not loaded gallery pages
+		QHash<Page*, int> m_prefetched; // Image count of prefetched pages, -1 while loading
+		QSet<Page*> m_nextPageCreated;
+		QHash<Page*, DownloadQueryGroup::Checkpoint> m_pageCheckpoints; // Checkpoint of results pages, to resume from them
+		DownloadQueryGroup::Checkpoint m_lastPageCheckpoint; // Checkpoint of the last loaded results page, with the total before it
+		DownloadQueryGroup::Checkpoint m_checkpoint;
+		int m_skip = 0; // Images of the first results page already downloaded before resuming
 };
 
 #endif // PACK_LOADER_H
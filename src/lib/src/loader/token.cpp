@@ -15,6 +15,10 @@ Token::Token(std::function<QVariant()> func, bool cacheResult)
 	: m_func(std::move(func)), m_cacheResult(cacheResult)
 {}
 
+Token::Token(std::function<QVariant()> func, QString whatToDoDefault, QString emptyDefault, QString multipleDefault)
+	: m_whatToDoDefault(std::move(whatToDoDefault)), m_emptyDefault(std::move(emptyDefault)), m_multipleDefault(std::move(multipleDefault)), m_func(std::move(func)), m_cacheResult(true)
+{}
+
 
 QVariant Token::value() const
 {
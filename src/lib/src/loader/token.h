@@ -13,6 +13,7 @@ class Token
 		explicit Token(const QVariant &value, const QVariant &def = QVariant());
 		explicit Token(QVariant value, QString whatToDoDefault, QString emptyDefault, QString multipleDefault);
 		explicit Token(std::function<QVariant()> func, bool cacheResult = true);
+		explicit Token(std::function<QVariant()> func, QString whatToDoDefault, QString emptyDefault, QString multipleDefault);
 
 		QVariant value() const;
 		QString toString() const;
@@ -0,0 +1,85 @@
+#include "log-file-queue.h"
+#include <QFile>
+#include <QMutexLocker>
+#include "logger.h"
+#include "post-save-queue.h"
+
+
+LogFileQueue::LogFileQueue(PostSaveQueue *queue, int maxOpenFiles)
+	: m_queue(queue), m_maxOpenFiles(maxOpenFiles)
+{}
+
+LogFileQueue::~LogFileQueue()
+{
+	// Jobs still being run use this object
+	m_queue->waitForDone();
+	qDeleteAll(m_files);
+}
+
+void LogFileQueue::add(const QString &path, const QString &contents)
+{
+	// If a job is already waiting for this file, it will also write these contents
+	{
+		QMutexLocker locker(&m_mutex);
+		const bool scheduled = m_pending.contains(path);
+		m_pending[path].append(contents);
+		if (scheduled) {
+			return;
+		}
+	}
+
+	m_queue->run(path, [this, path]() {
+		write(path);
+	});
+}
+
+void LogFileQueue::write(const QString &path)
+{
+	QStringList contents;
+	QFile *file;
+	{
+		QMutexLocker locker(&m_mutex);
+		contents = m_pending.take(path);
+		file = m_files.take(path);
+		m_recent.removeOne(path);
+	}
+
+	// The file might have been moved or deleted since it was opened
+	if (file != nullptr && !file->exists()) {
+		delete file;
+		file = nullptr;
+	}
+
+	bool separator = file != nullptr || QFile::exists(path);
+	if (file == nullptr) {
+		file = new QFile(path);
+		if (!file->open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+			log(QStringLiteral("Could not open log file `%1`: %2").arg(path, file->errorString()), Logger::Warning);
+			delete file;
+			return;
+		}
+	}
+
+	QByteArray data;
+	for (const QString &content : qAsConst(contents)) {
+		if (separator) {
+			data.append('\n');
+		}
+		data.append(content.toUtf8());
+		separator = true;
+	}
+	file->write(data);
+	file->flush();
+
+	if (m_maxOpenFiles <= 0) {
+		delete file;
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	while (m_files.count() >= m_maxOpenFiles && !m_recent.isEmpty()) {
+		delete m_files.take(m_recent.takeFirst());
+	}
+	m_files.insert(path, file);
+	m_recent.append(path);
+}
@@ -0,0 +1,40 @@
+#ifndef LOG_FILE_QUEUE_H
+#define LOG_FILE_QUEUE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+
+class PostSaveQueue;
+class QFile;
+
+/**
+ * Appends the contents of the external log files of saved images in the post-save queue.
+ *
+ * Contents are batched per file: all the lines waiting to be appended to a file are written by the same job, with a
+ * single flush at the end. The most recently used files are also kept open between jobs, so that logging each saved
+ * image to the same file doesn't open and close it every time.
+ */
+class LogFileQueue
+{
+	public:
+		explicit LogFileQueue(PostSaveQueue *queue, int maxOpenFiles = 16);
+		~LogFileQueue();
+
+		void add(const QString &path, const QString &contents);
+
+	protected:
+		void write(const QString &path);
+
+	private:
+		PostSaveQueue *m_queue;
+		int m_maxOpenFiles;
+		QMutex m_mutex;
+		QHash<QString, QStringList> m_pending;
+		QHash<QString, QFile*> m_files; // Open files not being written to
+		QStringList m_recent; // Paths of the open files, least recently used first
+};
+
+#endif // LOG_FILE_QUEUE_H
@@ -1,7 +1,9 @@
 #include "logger.h"
 #include <QDateTime>
 #include <QFile>
+#include <QMutexLocker>
 #include <QStringList>
+#include <QThread>
 #include <stdexcept>
 #include "functions.h"
 
@@ -9,8 +11,21 @@
 	#include <QDebug>
 #endif
 
+// How long the writer waits for more messages before writing a batch
+#define LOG_BATCH_DELAY 100
+
+// Maximum number of lines sent to the UI per batch, the others only being in the log file
+#define LOG_MAX_UI_LINES 500
+
+
+Logger::~Logger()
+{
+	stopWriter();
+}
+
 void Logger::logToConsole()
 {
+	QMutexLocker locker(&m_fileMutex);
 	if (m_logFile.isOpen()) {
 		m_logFile.close();
 	}
@@ -20,6 +35,7 @@ void Logger::logToConsole()
 
 void Logger::setLogFile(const QString &path)
 {
+	QMutexLocker locker(&m_fileMutex);
 	if (m_logFile.isOpen()) {
 		m_logFile.close();
 	}
@@ -27,8 +43,14 @@ void Logger::setLogFile(const QString &path)
 	m_logFile.setFileName(path);
 	m_logFile.open(QFile::Append | QFile::Text | QFile::Truncate);
 }
-QString Logger::logFile() const
-{ return m_logFile.fileName(); }
+QString Logger::logFile()
+{
+	// The caller usually wants to read the file, so it should contain all messages logged so far
+	flush();
+
+	QMutexLocker locker(&m_fileMutex);
+	return m_logFile.fileName();
+}
 
 void Logger::setLogLevel(LogLevel level)
 {
@@ -94,34 +116,158 @@ void Logger::log(const QString &l, LogLevel level)
 		return;
 	}
 
-	if (!m_logFile.isOpen()) {
-		setLogFile(savePath(QStringLiteral("main.log"), false, true));
+	const qint64 time = QDateTime::currentMSecsSinceEpoch();
+
+	#ifdef QT_DEBUG
+		qDebug() << QDateTime::fromMSecsSinceEpoch(time).toString(QStringLiteral("hh:mm:ss.zzz")) << level << l;
+	#endif
+
+	{
+		QMutexLocker locker(&m_mutex);
+
+		// Messages logged while the application exits are written directly
+		if (m_stopping) {
+			locker.unlock();
+			writeRecords(QVector<Record> { Record { time, level, l } });
+			return;
+		}
+
+		if (m_writer == nullptr) {
+			startWriter();
+		}
+
+		// The writer is only woken up for the first message of a batch, or errors which should be written right away
+		const bool wasEmpty = m_pending.isEmpty();
+		m_pending.append(Record { time, level, l });
+		if (level == Logger::Error) {
+			m_flushRequested = true;
+			m_wakeWriter.wakeAll();
+		} else if (wasEmpty) {
+			m_wakeWriter.wakeAll();
+		}
+	}
+
+	if (m_exitOnError && level == Logger::LogLevel::Error) {
+		flush();
+		throw std::runtime_error(l.toStdString());
+	}
+}
+
+void Logger::flush()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_writer == nullptr) {
+		return;
+	}
+
+	while (!m_pending.isEmpty() || m_writing) {
+		m_flushRequested = true;
+		m_wakeWriter.wakeAll();
+		m_drained.wait(&m_mutex);
+	}
+}
+
+/**
+ * Must be called with the buffer mutex locked.
+ */
+void Logger::startWriter()
+{
+	m_writer = QThread::create([this]() { writerLoop(); });
+	m_writer->setObjectName("LoggerThread");
+	m_writer->start(QThread::LowPriority);
+}
+
+void Logger::stopWriter()
+{
+	QThread *writer;
+	{
+		QMutexLocker locker(&m_mutex);
+		writer = m_writer;
+		m_stopping = true;
+		m_wakeWriter.wakeAll();
+	}
+
+	if (writer != nullptr) {
+		writer->wait();
+		delete writer;
+		m_writer = nullptr;
+	}
+}
+
+void Logger::writerLoop()
+{
+	QVector<Record> batch;
+
+	QMutexLocker locker(&m_mutex);
+	forever {
+		while (m_pending.isEmpty() && !m_stopping) {
+			m_flushRequested = false;
+			m_drained.wakeAll();
+			m_wakeWriter.wait(&m_mutex);
+		}
+		if (m_pending.isEmpty()) {
+			break;
+		}
+
+		// Give some time for other messages to arrive, to write them all at once
+		if (!m_flushRequested && !m_stopping) {
+			m_wakeWriter.wait(&m_mutex, LOG_BATCH_DELAY);
+		}
+
+		batch.swap(m_pending);
+		m_writing = true;
+		locker.unlock();
+
+		writeRecords(batch);
+		batch.clear();
+
+		locker.relock();
+		m_writing = false;
 	}
 
+	m_drained.wakeAll();
+}
+
+void Logger::writeRecords(const QVector<Record> &records)
+{
 	static const QString timeFormat = QStringLiteral("hh:mm:ss.zzz");
 	static const QStringList levels = QStringList()
 		<< QStringLiteral("Debug")
 		<< QStringLiteral("Info")
 		<< QStringLiteral("Warning")
 		<< QStringLiteral("Error");
-	const QString &levelStr = levels[level];
-	QDateTime time = QDateTime::currentDateTime();
 
-	// Write ASCII log to file
-	m_logFile.write(QString("[" + time.toString(timeFormat) + "][" + levelStr + "] " + stripTags(l) + "\n").toUtf8());
-	m_logFile.flush();
+	QByteArray data;
+	QStringList messages;
+	messages.reserve(qMin(records.count(), LOG_MAX_UI_LINES + 1));
 
-	// Emit colored HTML log
-	const QString msg = "[" + time.toString(timeFormat) + "][" + levelStr + "] " + l;
-	emit newLog(msg);
+	const int firstUiLine = records.count() - LOG_MAX_UI_LINES;
+	for (int i = 0; i < records.count(); ++i) {
+		const Record &record = records[i];
+		const QString prefix = "[" + QDateTime::fromMSecsSinceEpoch(record.time).toString(timeFormat) + "][" + levels[record.level] + "] ";
 
-	#ifdef QT_DEBUG
-		qDebug() << time.toString(timeFormat) << levelStr << l;
-	#endif
+		// Write ASCII log to file
+		data += QString(prefix + stripTags(record.message) + "\n").toUtf8();
 
-	if (m_exitOnError && level == Logger::LogLevel::Error) {
-		throw std::runtime_error(l.toStdString());
+		// Colored HTML log for the UI, only keeping the last lines of big batches
+		if (i == firstUiLine - 1) {
+			messages.append(prefix + QStringLiteral("%1 messages skipped, see the log file for details").arg(firstUiLine));
+		} else if (i >= firstUiLine) {
+			messages.append(prefix + record.message);
+		}
 	}
+
+	{
+		QMutexLocker locker(&m_fileMutex);
+		if (!m_logFile.isOpen()) {
+			m_logFile.setFileName(savePath(QStringLiteral("main.log"), false, true));
+			m_logFile.open(QFile::Append | QFile::Text | QFile::Truncate);
+		}
+		m_logFile.write(data);
+		m_logFile.flush();
+	}
+
+	emit newLogs(messages);
 }
 
 void Logger::logCommand(const QString &l)
@@ -5,11 +5,22 @@
 #define DONE() Logger::getInstance().logUpdate(" Done")
 
 #include <QFile>
+#include <QMutex>
 #include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
 
 
 class QString;
+class QThread;
 
+/**
+ * Application logger.
+ *
+ * Logging a message only appends it to a buffer: a writer thread formats the buffered messages, writes them to the
+ * log file with a single flush, and notifies the UI once per batch. Errors are written right away.
+ */
 class Logger : public QObject
 {
 	Q_OBJECT
@@ -46,16 +57,46 @@ class Logger : public QObject
 		void logUpdate(const QString &);
 		void logToConsole();
 
-		QString logFile() const;
+		/**
+		 * Wait for all the buffered messages to be written to the log file.
+		 */
+		void flush();
+
+		QString logFile();
 
 	signals:
-		void newLog(const QString &message);
+		void newLogs(const QStringList &messages);
+
+	protected:
+		struct Record
+		{
+			qint64 time;
+			LogLevel level;
+			QString message;
+		};
+
+		void startWriter();
+		void stopWriter();
+		void writerLoop();
+		void writeRecords(const QVector<Record> &records);
 
 	private:
 		Logger() = default;
+		~Logger() override;
 		QFile m_logFile, m_fCommandsLog, m_fCommandsSqlLog;
+		QMutex m_fileMutex;
 		LogLevel m_level = LogLevel::Info;
 		bool m_exitOnError = false;
+
+		// Buffer shared with the writer thread
+		QMutex m_mutex;
+		QWaitCondition m_wakeWriter;
+		QWaitCondition m_drained;
+		QVector<Record> m_pending;
+		QThread *m_writer = nullptr;
+		bool m_writing = false;
+		bool m_flushRequested = false;
+		bool m_stopping = false;
 };
 
 
@@ -1,5 +1,4 @@
 #include "login/http-login.h"
-#include <QEventLoop>
 #include <QNetworkCookie>
 #include <QNetworkCookieJar>
 #include <QUrlQuery>
@@ -15,7 +14,7 @@
 
 
 HttpLogin::HttpLogin(QString type, HttpAuth *auth, Site *site, NetworkManager *manager, MixedSettings *settings)
-	: m_type(std::move(type)), m_auth(auth), m_site(site), m_loginReply(nullptr), m_manager(manager), m_settings(settings)
+	: m_type(std::move(type)), m_auth(auth), m_site(site), m_loginReply(nullptr), m_csrfReply(nullptr), m_manager(manager), m_settings(settings)
 {}
 
 bool HttpLogin::isTestable() const
@@ -32,46 +31,77 @@ void HttpLogin::login()
 		return;
 	}
 
-	if (m_loginReply != nullptr) {
-		m_loginReply->abort();
-		m_loginReply->deleteLater();
-	}
+	cancel();
 
-	QUrlQuery query;
+	m_query.clear();
 	for (AuthField *field : m_auth->fields()) {
 		if (!field->key().isEmpty()) {
-			query.addQueryItem(field->key(), field->value(m_settings));
+			m_query.addQueryItem(field->key(), field->value(m_settings));
 		}
 	}
 
+	// The CSRF page must be loaded first to get the tokens to send with the login request
 	if (!m_auth->csrfUrl().isEmpty()) {
-		QEventLoop loop;
-		NetworkReply *reply = m_site->get(m_site->fixUrl(m_auth->csrfUrl()), Site::QueryType::UnknownType);
-		QObject::connect(reply, &NetworkReply::finished, &loop, &QEventLoop::quit);
-		loop.exec();
-
-		// Loading error
-		if (reply->error() != NetworkReply::NetworkError::NoError) {
-			log(QStringLiteral("Error loading CSRF information (%1)").arg(reply->errorString()), Logger::Error);
-			emit loggedIn(Result::Failure);
-			return;
-		}
+		m_csrfReply = m_site->get(m_site->fixUrl(m_auth->csrfUrl()), Site::QueryType::UnknownType);
+		connect(m_csrfReply, &NetworkReply::finished, this, &HttpLogin::csrfFinished);
+		return;
+	}
 
-		const QString src = reply->readAll();
-		const QStringList fields = m_auth->csrfFields();
-		HtmlNode *document = HtmlNode::fromString(src);
-		for (const QString &field : fields) {
-			const QList<HtmlNode> input = document->find("input[name=" + field + "]");
-			if (input.isEmpty()) {
-				log(QStringLiteral("Could not find HTML field '%1'").arg(field), Logger::Warning);
-				continue;
-			}
-			query.addQueryItem(field, input.first().attr("value"));
+	sendLogin();
+}
+
+/**
+ * Abort the pending login requests, if any.
+ */
+void HttpLogin::cancel()
+{
+	if (m_csrfReply != nullptr) {
+		m_csrfReply->disconnect(this);
+		m_csrfReply->abort();
+		m_csrfReply->deleteLater();
+		m_csrfReply = nullptr;
+	}
+	if (m_loginReply != nullptr) {
+		m_loginReply->disconnect(this);
+		m_loginReply->abort();
+		m_loginReply->deleteLater();
+		m_loginReply = nullptr;
+	}
+}
+
+void HttpLogin::csrfFinished()
+{
+	NetworkReply *reply = m_csrfReply;
+	m_csrfReply = nullptr;
+	reply->deleteLater();
+
+	// Loading error
+	if (reply->error() != NetworkReply::NetworkError::NoError) {
+		log(QStringLiteral("Error loading CSRF information (%1)").arg(reply->errorString()), Logger::Error);
+		emit loggedIn(Result::Failure);
+		return;
+	}
+
+	const QString src = reply->readAll();
+	const QStringList fields = m_auth->csrfFields();
+	HtmlNode *document = HtmlNode::fromString(src);
+	for (const QString &field : fields) {
+		const QList<HtmlNode> input = document->find("input[name=" + field + "]");
+		if (input.isEmpty()) {
+			log(QStringLiteral("Could not find HTML field '%1'").arg(field), Logger::Warning);
+			continue;
 		}
-		delete document;
+		m_query.addQueryItem(field, input.first().attr("value"));
 	}
+	delete document;
+
+	sendLogin();
+}
 
-	NetworkReply *reply = getReply(url, query);
+void HttpLogin::sendLogin()
+{
+	const QUrl url = m_site->fixUrl(m_auth->url());
+	NetworkReply *reply = getReply(url, m_query);
 	if (reply == nullptr) {
 		emit loggedIn(Result::Failure);
 		return;
@@ -2,6 +2,7 @@
 #define HTTP_LOGIN_H
 
 #include <QString>
+#include <QUrlQuery>
 #include "login/login.h"
 
 
@@ -10,7 +11,6 @@ class MixedSettings;
 class NetworkManager;
 class NetworkReply;
 class QUrl;
-class QUrlQuery;
 class Site;
 
 class HttpLogin : public Login
@@ -27,11 +27,14 @@ class HttpLogin : public Login
 
 	private:
 		bool hasCookie(const QUrl &url) const;
+		void sendLogin();
 
 	public slots:
 		void login() override;
+		void cancel();
 
 	protected slots:
+		void csrfFinished();
 		void loginFinished();
 
 	protected:
@@ -39,6 +42,8 @@ class HttpLogin : public Login
 		HttpAuth *m_auth;
 		Site *m_site;
 		NetworkReply *m_loginReply;
+		NetworkReply *m_csrfReply;
+		QUrlQuery m_query;
 		NetworkManager *m_manager;
 		MixedSettings *m_settings;
 };
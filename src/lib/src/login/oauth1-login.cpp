@@ -1,6 +1,5 @@
 #include "login/oauth1-login.h"
 #include <QDesktopServices>
-#include <QEventLoop>
 #include <QOAuthHttpServerReplyHandler>
 #include "auth/oauth1-auth.h"
 #include "logger.h"
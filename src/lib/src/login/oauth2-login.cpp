@@ -21,12 +21,23 @@
 	#include "windows-url-protocol.h"
 #endif
 
+#define REFRESH_MARGIN (5 * 60)
+#define MAX_TIMER_INTERVAL (24 * 60 * 60)
+
 
 OAuth2Login::OAuth2Login(OAuth2Auth *auth, Site *site, NetworkManager *manager, MixedSettings *settings)
 	: m_auth(auth), m_site(site), m_manager(manager), m_settings(settings)
 {
 	m_accessToken = m_settings->value("auth/accessToken").toString();
 	m_refreshToken = m_settings->value("auth/refreshToken").toString();
+
+	// Tokens are kept between runs, so there is no need to refresh them on startup if they are still valid
+	if (!m_refreshToken.isEmpty()) {
+		m_expires = m_settings->value("auth/expires").toDateTime();
+	}
+
+	m_refreshTimer.setSingleShot(true);
+	connect(&m_refreshTimer, &QTimer::timeout, this, &OAuth2Login::basicRefresh);
 }
 
 bool OAuth2Login::isTestable() const
@@ -261,6 +272,7 @@ void OAuth2Login::login()
 	}
 
 	if (!m_accessToken.isEmpty()) {
+		scheduleRefresh();
 		emit loggedIn(Result::Success);
 		return;
 	}
@@ -292,6 +304,12 @@ void OAuth2Login::basicRefresh()
 
 void OAuth2Login::refresh(bool login)
 {
+	// Only refresh once at a time, the login waiting for the current refresh if there is one
+	if (m_refreshReply != nullptr) {
+		m_refreshLogin = m_refreshLogin || login;
+		return;
+	}
+
 	log(QStringLiteral("[%1] Refreshing OAuth2 token...").arg(m_site->url()), Logger::Info);
 
 	const QString consumerKey = m_settings->value("auth/consumerKey").toString();
@@ -335,17 +353,25 @@ void OAuth2Login::refresh(bool login)
 	}
 
 	// Post request and wait for a reply
+	m_refreshLogin = login;
 	m_refreshReply = m_manager->post(request, data);
-	if (login) {
-		connect(m_refreshReply, &NetworkReply::finished, this, &OAuth2Login::refreshLoginFinished);
-	} else {
-		connect(m_refreshReply, &NetworkReply::finished, this, &OAuth2Login::refreshFinished);
-	}
+	connect(m_refreshReply, &NetworkReply::finished, this, &OAuth2Login::refreshFinished);
 }
 
-void OAuth2Login::refreshLoginFinished()
+void OAuth2Login::refreshFinished()
 {
 	const bool ok = readResponse(m_refreshReply);
+	m_refreshReply->deleteLater();
+	m_refreshReply = nullptr;
+
+	if (m_refreshLogin) {
+		m_refreshLogin = false;
+		refreshLoginFinished(ok);
+	}
+}
+
+void OAuth2Login::refreshLoginFinished(bool ok)
+{
 	if (!ok) {
 		if (m_auth->authType() == "refresh_token") {
 			log(QStringLiteral("[%1] Refresh failed").arg(m_site->url()), Logger::Warning);
@@ -358,14 +384,26 @@ void OAuth2Login::refreshLoginFinished()
 		m_settings->remove("auth/accessToken");
 		m_refreshToken.clear();
 		m_settings->remove("auth/refreshToken");
+		m_expires = QDateTime();
+		m_settings->remove("auth/expires");
 		login();
 	} else {
 		emit loggedIn(Result::Success);
 	}
 }
-void OAuth2Login::refreshFinished()
+
+/**
+ * Refresh the token in the background shortly before it expires, so that requests never have to wait for it.
+ */
+void OAuth2Login::scheduleRefresh()
 {
-	readResponse(m_refreshReply);
+	if (m_refreshToken.isEmpty() || !m_expires.isValid()) {
+		return;
+	}
+
+	const qint64 lifetime = QDateTime::currentDateTime().secsTo(m_expires);
+	const qint64 delay = qBound(static_cast<qint64>(0), qMax(lifetime / 2, lifetime - REFRESH_MARGIN), static_cast<qint64>(MAX_TIMER_INTERVAL));
+	m_refreshTimer.start(static_cast<int>(delay * 1000));
 }
 
 bool OAuth2Login::readResponse(NetworkReply *reply)
@@ -430,8 +468,8 @@ bool OAuth2Login::readResponse(NetworkReply *reply)
 		}
 
 		if (!m_expires.isNull()) {
-			const int expiresSecond = QDateTime::currentDateTime().secsTo(m_expires);
-			QTimer::singleShot((expiresSecond / 2) * 1000, this, SIGNAL(basicRefresh()));
+			m_settings->setValue("auth/expires", m_expires);
+			scheduleRefresh();
 			log(QStringLiteral("[%1] Token will expire at '%2'").arg(m_site->url(), m_expires.toString("yyyy-MM-dd HH:mm:ss")), Logger::Debug);
 		}
 	}
@@ -5,6 +5,7 @@
 #include <QList>
 #include <QMap>
 #include <QString>
+#include <QTimer>
 #include "login/login.h"
 
 using QStrP = QPair<QString, QString>;
@@ -31,12 +32,13 @@ class OAuth2Login : public Login
 
 	protected slots:
 		void loginFinished();
-		void refreshLoginFinished();
 		void refreshFinished();
 		void basicRefresh();
 
 	protected:
 		void refresh(bool login = false);
+		void refreshLoginFinished(bool ok);
+		void scheduleRefresh();
 		bool readResponse(NetworkReply *reply);
 		void loginClientCredentials();
 		void loginPassword();
@@ -51,6 +53,8 @@ class OAuth2Login : public Login
 		MixedSettings *m_settings;
 		NetworkReply *m_tokenReply = nullptr;
 		NetworkReply *m_refreshReply = nullptr;
+		bool m_refreshLogin = false;
+		QTimer m_refreshTimer;
 		QString m_accessToken;
 		QString m_refreshToken;
 		QDateTime m_expires;
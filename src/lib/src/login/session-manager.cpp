@@ -0,0 +1,78 @@
+#include "login/session-manager.h"
+#include <QThread>
+#include <QTimer>
+
+
+SessionManager::SessionManager(QObject *parent)
+	: QObject(parent)
+{}
+
+bool SessionManager::isRunning() const
+{
+	return !m_pending.isEmpty();
+}
+
+void SessionManager::login(const QList<Site*> &sites)
+{
+	cancel();
+
+	for (Site *site : sites) {
+		if (!m_pending.contains(site) && !site->hasValidSession()) {
+			m_pending.append(site);
+		}
+	}
+	m_total = m_pending.count();
+
+	// Nothing to do, but still notify asynchronously so that callers always get the signal the same way
+	if (m_pending.isEmpty()) {
+		QTimer::singleShot(0, this, &SessionManager::finish);
+		return;
+	}
+
+	emit progress(0, m_total);
+
+	// Connect to all sites first, as some of them emit their result synchronously
+	const QList<Site*> pending = m_pending;
+	for (Site *site : pending) {
+		connect(site, &Site::loggedIn, this, &SessionManager::siteLoggedIn, Qt::QueuedConnection);
+	}
+	for (Site *site : pending) {
+		// Sites log in on their own thread, for example when this is used by the batch engine
+		if (site->thread() != QThread::currentThread()) {
+			QMetaObject::invokeMethod(site, "login", Qt::QueuedConnection);
+		} else {
+			site->login();
+		}
+	}
+}
+
+void SessionManager::cancel()
+{
+	for (Site *site : qAsConst(m_pending)) {
+		disconnect(site, &Site::loggedIn, this, &SessionManager::siteLoggedIn);
+	}
+	m_pending.clear();
+	m_total = 0;
+}
+
+void SessionManager::siteLoggedIn(Site *site, Site::LoginResult result)
+{
+	Q_UNUSED(result);
+
+	if (!m_pending.removeOne(site)) {
+		return;
+	}
+	disconnect(site, &Site::loggedIn, this, &SessionManager::siteLoggedIn);
+
+	emit progress(m_total - m_pending.count(), m_total);
+
+	if (m_pending.isEmpty()) {
+		finish();
+	}
+}
+
+void SessionManager::finish()
+{
+	m_total = 0;
+	emit finished();
+}
@@ -0,0 +1,42 @@
+#ifndef SESSION_MANAGER_H
+#define SESSION_MANAGER_H
+
+#include <QList>
+#include <QObject>
+#include "models/site.h"
+
+
+/**
+ * Log into several sites at the same time, for example all the sites needed by a batch download before starting it.
+ *
+ * Sites whose session is still valid are not logged in again, and since the session cookies are kept in each site's
+ * persistent cookie jar, they are also re-used after a restart until they expire.
+ */
+class SessionManager : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit SessionManager(QObject *parent = nullptr);
+		bool isRunning() const;
+
+	public slots:
+		void login(const QList<Site*> &sites);
+		void cancel();
+
+	protected slots:
+		void siteLoggedIn(Site *site, Site::LoginResult result);
+
+	protected:
+		void finish();
+
+	signals:
+		void progress(int current, int max);
+		void finished();
+
+	private:
+		QList<Site*> m_pending;
+		int m_total = 0;
+};
+
+#endif // SESSION_MANAGER_H
@@ -0,0 +1,183 @@
+#include "metrics.h"
+#include <QMutexLocker>
+#include <QStringList>
+
+
+static QString formatNumber(double value)
+{
+	return QString::number(value, 'g', 15);
+}
+
+
+static void describeMetrics(Metrics &metrics)
+{
+	metrics.describe("grabber_page_parse_duration_ms", Metrics::Histogram, "Time spent parsing a page of results, per site.");
+	metrics.describe("grabber_js_parse_duration_ms", Metrics::Histogram, "Time spent in the Javascript parser of a source, per source.");
+	metrics.describe("grabber_js_engine_gcs_total", Metrics::Counter, "Explicit garbage collections of Javascript engines.");
+	metrics.describe("grabber_js_engine_recycles_total", Metrics::Counter, "Javascript engines replaced by a new one to release their memory.");
+	metrics.describe("grabber_network_queue_wait_ms", Metrics::Histogram, "Time requests waited for a free slot in the network manager, per priority.");
+	metrics.describe("grabber_network_throttle_delay_ms", Metrics::Histogram, "Delay added to requests by throttling, per host.");
+	metrics.describe("grabber_download_bytes_total", Metrics::Counter, "Bytes of downloaded images, per host.");
+	metrics.describe("grabber_downloads_total", Metrics::Counter, "Image downloads, per result.");
+	metrics.describe("grabber_memory_bytes", Metrics::Gauge, "Estimated memory used by the in-memory caches, per cache.");
+	metrics.describe("grabber_memory_evictions_total", Metrics::Counter, "Cache entries freed to stay within the memory budget.");
+}
+
+/**
+ * It is never deleted, as metrics can be recorded until the very end of the application.
+ */
+Metrics &Metrics::getInstance()
+{
+	static Metrics *instance = []() {
+		auto *metrics = new Metrics();
+		describeMetrics(*metrics);
+		return metrics;
+	}();
+	return *instance;
+}
+
+QString Metrics::label(const QString &name, const QString &value)
+{
+	QString escaped = value;
+	escaped.replace('\\', QLatin1String("\\\\"));
+	escaped.replace('"', QLatin1String("\\\""));
+	escaped.replace('\n', QLatin1String("\\n"));
+	return name + "=\"" + escaped + "\"";
+}
+
+const QVector<double> &Metrics::histogramBuckets()
+{
+	static const QVector<double> buckets { 1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000 };
+	return buckets;
+}
+
+
+/**
+ * Must be called with the mutex locked.
+ */
+Metrics::Series &Metrics::findSeries(const QString &name, const QString &labels, Type type)
+{
+	auto familyIt = m_families.find(name);
+	if (familyIt == m_families.end()) {
+		Family family;
+		family.type = type;
+		familyIt = m_families.insert(name, family);
+	}
+
+	QMap<QString, Series> &allSeries = familyIt->series;
+	auto it = allSeries.find(labels);
+	if (it == allSeries.end()) {
+		Series created;
+		created.name = name;
+		created.labels = labels;
+		created.type = type;
+		if (type == Histogram) {
+			created.buckets.fill(0, histogramBuckets().count());
+		}
+		it = allSeries.insert(labels, created);
+	}
+
+	return it.value();
+}
+
+void Metrics::describe(const QString &name, Type type, const QString &help)
+{
+	QMutexLocker locker(&m_mutex);
+	Family &family = m_families[name];
+	family.type = type;
+	family.help = help;
+}
+
+void Metrics::increment(const QString &name, const QString &labels, double value)
+{
+	QMutexLocker locker(&m_mutex);
+	findSeries(name, labels, Counter).value += value;
+}
+
+void Metrics::setGauge(const QString &name, const QString &labels, double value)
+{
+	QMutexLocker locker(&m_mutex);
+	findSeries(name, labels, Gauge).value = value;
+}
+
+void Metrics::observe(const QString &name, const QString &labels, double value)
+{
+	const QVector<double> &bounds = histogramBuckets();
+
+	QMutexLocker locker(&m_mutex);
+	Series &s = findSeries(name, labels, Histogram);
+	s.count++;
+	s.sum += value;
+	for (int i = 0; i < bounds.count(); ++i) {
+		if (value <= bounds[i]) {
+			s.buckets[i]++;
+			break;
+		}
+	}
+}
+
+
+QList<Metrics::Series> Metrics::series() const
+{
+	QMutexLocker locker(&m_mutex);
+
+	QList<Series> ret;
+	for (const Family &family : m_families) {
+		for (const Series &s : family.series) {
+			ret.append(s);
+		}
+	}
+	return ret;
+}
+
+QString Metrics::toPrometheus() const
+{
+	static const QStringList typeNames { "counter", "gauge", "histogram" };
+	const QVector<double> &bounds = histogramBuckets();
+
+	QMutexLocker locker(&m_mutex);
+
+	QString ret;
+	for (auto it = m_families.constBegin(); it != m_families.constEnd(); ++it) {
+		const QString &name = it.key();
+		const Family &family = it.value();
+		if (family.series.isEmpty()) {
+			continue;
+		}
+
+		if (!family.help.isEmpty()) {
+			ret += "# HELP " + name + " " + family.help + "\n";
+		}
+		ret += "# TYPE " + name + " " + typeNames[family.type] + "\n";
+
+		for (const Series &s : family.series) {
+			if (s.type != Histogram) {
+				ret += name + (s.labels.isEmpty() ? QString() : "{" + s.labels + "}") + " " + formatNumber(s.value) + "\n";
+				continue;
+			}
+
+			// Prometheus buckets are cumulative
+			const QString prefix = s.labels.isEmpty() ? QString() : s.labels + ",";
+			quint64 cumulative = 0;
+			for (int i = 0; i < bounds.count(); ++i) {
+				cumulative += s.buckets[i];
+				ret += name + "_bucket{" + prefix + "le=\"" + formatNumber(bounds[i]) + "\"} " + QString::number(cumulative) + "\n";
+			}
+			ret += name + "_bucket{" + prefix + "le=\"+Inf\"} " + QString::number(s.count) + "\n";
+
+			const QString labels = s.labels.isEmpty() ? QString() : "{" + s.labels + "}";
+			ret += name + "_sum" + labels + " " + formatNumber(s.sum) + "\n";
+			ret += name + "_count" + labels + " " + QString::number(s.count) + "\n";
+		}
+	}
+
+	return ret;
+}
+
+void Metrics::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	for (Family &family : m_families) {
+		family.series.clear();
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+
+/**
+ * Registry of performance metrics: counters, gauges and histograms.
+ *
+ * Each metric has a name and any number of series identified by their labels (e.g. `site="danbooru.donmai.us"`).
+ * Recording a value only takes a short lock, so metrics can be updated from any thread. They can be listed to be
+ * displayed, or exported in the Prometheus text format.
+ */
+class Metrics
+{
+	public:
+		enum Type
+		{
+			Counter,
+			Gauge,
+			Histogram
+		};
+
+		struct Series
+		{
+			QString name;
+			QString labels;
+			Type type;
+			double value = 0;
+			quint64 count = 0;
+			double sum = 0;
+			QVector<quint64> buckets;
+		};
+
+		Metrics() = default;
+		static Metrics &getInstance();
+
+		/**
+		 * Build a label to identify a series, escaping the value as needed.
+		 */
+		static QString label(const QString &name, const QString &value);
+
+		/**
+		 * The upper bounds of the histogram buckets, in milliseconds.
+		 */
+		static const QVector<double> &histogramBuckets();
+
+		void describe(const QString &name, Type type, const QString &help);
+		void increment(const QString &name, const QString &labels = QString(), double value = 1);
+		void setGauge(const QString &name, const QString &labels, double value);
+		void observe(const QString &name, const QString &labels, double value);
+
+		QList<Series> series() const;
+		QString toPrometheus() const;
+		void clear();
+
+	protected:
+		struct Family
+		{
+			Type type = Counter;
+			QString help;
+			QMap<QString, Series> series;
+		};
+
+		Series &findSeries(const QString &name, const QString &labels, Type type);
+
+	private:
+		mutable QMutex m_mutex;
+		QMap<QString, Family> m_families;
+};
+
+#endif // METRICS_H
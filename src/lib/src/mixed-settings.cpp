@@ -1,4 +1,5 @@
 #include "mixed-settings.h"
+#include <QMutexLocker>
 #include <QSettings>
 #include <QStringList>
 #include <utility>
@@ -19,13 +20,29 @@ MixedSettings::~MixedSettings()
 
 QVariant MixedSettings::value(const QString &key, const QVariant &defaultValue) const
 {
-	for (QSettings *setting : qAsConst(m_settings)) {
-		QVariant val = setting->value(key);
-		if (val.isValid()) {
-			return val;
+	const QString fullKey = m_group.isEmpty() ? key : m_group + "/" + key;
+
+	QMutexLocker locker(&m_cacheMutex);
+	auto it = m_cache.constFind(fullKey);
+	if (it == m_cache.constEnd()) {
+		QVariant resolved;
+		for (QSettings *setting : qAsConst(m_settings)) {
+			QVariant val = setting->value(key);
+			if (val.isValid()) {
+				resolved = val;
+				break;
+			}
 		}
+		it = m_cache.insert(fullKey, resolved);
 	}
-	return defaultValue;
+
+	return it->isValid() ? it.value() : defaultValue;
+}
+
+void MixedSettings::clearCache()
+{
+	QMutexLocker locker(&m_cacheMutex);
+	m_cache.clear();
 }
 
 void MixedSettings::setValue(const QString &key, const QVariant &value, const QVariant &defaultValue)
@@ -33,6 +50,7 @@ void MixedSettings::setValue(const QString &key, const QVariant &value, const QV
 	if (m_settings.isEmpty()) {
 		return;
 	}
+	clearCache();
 
 	// If the parent setting already have this value set
 	if (m_settings.count() > 1) {
@@ -61,6 +79,7 @@ void MixedSettings::setValue(const QString &key, const QVariant &value, const QV
 
 void MixedSettings::remove(const QString &key)
 {
+	clearCache();
 	for (QSettings *setting : qAsConst(m_settings)) {
 		setting->remove(key);
 	}
@@ -77,6 +96,7 @@ QStringList MixedSettings::childKeys() const
 
 void MixedSettings::beginGroup(const QString &prefix)
 {
+	m_group = m_group.isEmpty() ? prefix : m_group + "/" + prefix;
 	for (QSettings *setting : qAsConst(m_settings)) {
 		setting->beginGroup(prefix);
 	}
@@ -84,6 +104,8 @@ void MixedSettings::beginGroup(const QString &prefix)
 
 void MixedSettings::endGroup()
 {
+	const int sep = m_group.lastIndexOf('/');
+	m_group = sep < 0 ? QString() : m_group.left(sep);
 	for (QSettings *setting : qAsConst(m_settings)) {
 		setting->endGroup();
 	}
@@ -91,6 +113,8 @@ void MixedSettings::endGroup()
 
 void MixedSettings::sync()
 {
+	// Other processes might have changed the files, so values are resolved again after a sync
+	clearCache();
 	for (QSettings *setting : qAsConst(m_settings)) {
 		setting->sync();
 	}
@@ -1,14 +1,22 @@
 #ifndef MIXED_SETTINGS_H
 #define MIXED_SETTINGS_H
 
+#include <QHash>
 #include <QList>
+#include <QMutex>
+#include <QString>
 #include <QVariant>
 
 
 class QSettings;
-class QString;
 class QStringList;
 
+/**
+ * Settings read from a list of QSettings, the first one that has a value for a key having priority.
+ *
+ * Resolved values are cached, so that repeated reads are a single hash lookup. The cache is cleared every time the
+ * settings are modified or synced through this class, so the underlying QSettings should not be modified directly.
+ */
 class MixedSettings : public QObject
 {
 	Q_OBJECT
@@ -25,8 +33,16 @@ class MixedSettings : public QObject
 		void endGroup();
 		void sync();
 
+	protected:
+		void clearCache();
+
 	private:
 		QList<QSettings*> m_settings;
+		QString m_group;
+
+		// Resolved values, an invalid value meaning that no setting has this key
+		mutable QMutex m_cacheMutex;
+		mutable QHash<QString, QVariant> m_cache;
 };
 
 #endif // MIXED_SETTINGS_H
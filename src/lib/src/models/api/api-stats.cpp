@@ -0,0 +1,158 @@
+#include "models/api/api-stats.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "logger.h"
+
+#define MOVING_AVERAGE_WEIGHT 0.2
+#define MIN_SAMPLES 3
+#define FAILING_SUCCESS_RATE 0.5
+#define BASE_LATENCY 250
+
+
+ApiStats::ApiStats(QString file, int probeInterval)
+	: m_file(std::move(file)), m_probeInterval(probeInterval)
+{
+	load();
+}
+
+ApiStats::~ApiStats()
+{
+	save();
+}
+
+
+void ApiStats::add(const QString &api, bool success, qint64 msLatency, const QDateTime &date)
+{
+	Stats &stats = m_stats[api];
+
+	// The first results are simply averaged, so that a single early failure does not weigh too much
+	const double weight = qMax(MOVING_AVERAGE_WEIGHT, 1.0 / (stats.count + 1));
+	stats.successRate += weight * ((success ? 1.0 : 0.0) - stats.successRate);
+	if (success) {
+		stats.latency += (stats.latency <= 0 ? 1.0 : weight) * (static_cast<double>(msLatency) - stats.latency);
+	}
+	stats.count++;
+	stats.lastTry = date;
+
+	m_changed = true;
+}
+
+double ApiStats::successRate(const QString &api) const
+{
+	return m_stats.value(api).successRate;
+}
+
+qint64 ApiStats::latency(const QString &api) const
+{
+	return qRound64(m_stats.value(api).latency);
+}
+
+/**
+ * An API is considered failing if most of its recent requests failed, unless it has not been tried for a while, in
+ * which case it is given another chance.
+ */
+bool ApiStats::isFailing(const QString &api, const QDateTime &now) const
+{
+	const auto it = m_stats.constFind(api);
+	if (it == m_stats.constEnd() || it->count < MIN_SAMPLES || it->successRate >= FAILING_SUCCESS_RATE) {
+		return false;
+	}
+	return !it->lastTry.isValid() || it->lastTry.secsTo(now) < m_probeInterval;
+}
+
+QStringList ApiStats::sort(const QStringList &apis, const QDateTime &now) const
+{
+	if (m_stats.isEmpty()) {
+		return apis;
+	}
+
+	// Failing APIs go last, by success rate, and others are only reordered by order of magnitude of their latency
+	struct Key
+	{
+		bool failing;
+		int successRate;
+		int latency;
+	};
+	QHash<QString, Key> keys;
+	for (const QString &api : apis) {
+		const Stats stats = m_stats.value(api);
+		const bool known = stats.count >= MIN_SAMPLES;
+		const bool failing = isFailing(api, now);
+		const int successRate = failing ? qRound(stats.successRate * 10) : 10;
+		const int latency = known && stats.latency > BASE_LATENCY ? static_cast<int>(std::log2(stats.latency / BASE_LATENCY)) : 0;
+		keys.insert(api, Key { failing, successRate, latency });
+	}
+
+	QStringList ret = apis;
+	std::stable_sort(ret.begin(), ret.end(), [&keys](const QString &a, const QString &b) {
+		const Key &keyA = keys[a];
+		const Key &keyB = keys[b];
+		if (keyA.failing != keyB.failing) {
+			return !keyA.failing;
+		}
+		if (keyA.successRate != keyB.successRate) {
+			return keyA.successRate > keyB.successRate;
+		}
+		return keyA.latency < keyB.latency;
+	});
+	return ret;
+}
+
+
+void ApiStats::load()
+{
+	if (m_file.isEmpty()) {
+		return;
+	}
+
+	QFile f(m_file);
+	if (!f.exists() || !f.open(QFile::ReadOnly)) {
+		return;
+	}
+
+	const QJsonObject apis = QJsonDocument::fromJson(f.readAll()).object()["apis"].toObject();
+	for (auto it = apis.constBegin(); it != apis.constEnd(); ++it) {
+		const QJsonObject json = it.value().toObject();
+		Stats stats;
+		stats.successRate = json["successRate"].toDouble(1);
+		stats.latency = json["latency"].toDouble();
+		stats.count = json["count"].toInt();
+		stats.lastTry = QDateTime::fromString(json["lastTry"].toString(), Qt::ISODate);
+		m_stats.insert(it.key(), stats);
+	}
+}
+
+bool ApiStats::save()
+{
+	if (m_file.isEmpty() || !m_changed) {
+		return true;
+	}
+
+	QJsonObject apis;
+	for (auto it = m_stats.constBegin(); it != m_stats.constEnd(); ++it) {
+		QJsonObject json;
+		json["successRate"] = it->successRate;
+		json["latency"] = it->latency;
+		json["count"] = it->count;
+		json["lastTry"] = it->lastTry.toString(Qt::ISODate);
+		apis[it.key()] = json;
+	}
+
+	QJsonObject json;
+	json["apis"] = apis;
+
+	QFile f(m_file);
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not save API statistics to `%1`").arg(m_file), Logger::Warning);
+		return false;
+	}
+	f.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+	f.close();
+
+	m_changed = false;
+	return true;
+}
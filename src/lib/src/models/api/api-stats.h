@@ -0,0 +1,53 @@
+#ifndef API_STATS_H
+#define API_STATS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+
+/**
+ * Learns how well each API of a site works, so that the ones that have been failing or are much slower are not
+ * tried first anymore.
+ *
+ * Success rates and latencies are exponential moving averages, so that recent results matter most. A failing API
+ * is tried again at its original position once in a while, so that it gets promoted back once it recovered.
+ */
+class ApiStats
+{
+	public:
+		explicit ApiStats(QString file = QString(), int probeInterval = 3600);
+		~ApiStats();
+
+		void add(const QString &api, bool success, qint64 msLatency, const QDateTime &date = QDateTime::currentDateTimeUtc());
+		double successRate(const QString &api) const;
+		qint64 latency(const QString &api) const;
+		bool isFailing(const QString &api, const QDateTime &now = QDateTime::currentDateTimeUtc()) const;
+
+		/**
+		 * Sort the given APIs from the most to the least reliable, keeping the original order for ties.
+		 */
+		QStringList sort(const QStringList &apis, const QDateTime &now = QDateTime::currentDateTimeUtc()) const;
+
+		bool save();
+
+	protected:
+		struct Stats
+		{
+			double successRate = 1;
+			double latency = 0;
+			int count = 0;
+			QDateTime lastTry;
+		};
+
+		void load();
+
+	private:
+		QString m_file;
+		int m_probeInterval;
+		QHash<QString, Stats> m_stats;
+		bool m_changed = false;
+};
+
+#endif // API_STATS_H
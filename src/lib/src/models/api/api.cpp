@@ -1,6 +1,8 @@
 #include "models/api/api.h"
 #include <utility>
+#include "loader/token.h"
 #include "logger.h"
+#include "models/filtering/post-filter.h"
 #include "models/image.h"
 #include "models/image-factory.h"
 #include "models/page.h"
@@ -16,7 +18,7 @@ Api::Api(QString name)
 QString Api::getName() const { return m_name; }
 
 
-QSharedPointer<Image> Api::parseImage(Site *site, Page *parentPage, QMap<QString, QString> d, QVariantMap data, int position, const QList<Tag> &tags) const
+QSharedPointer<Image> Api::parseImage(Site *site, Page *parentPage, QMap<QString, QString> d, QVariantMap data, int position, QList<Tag> tags, const PostFilter *postFilter, bool *filtered) const
 {
 	d["position"] = QString::number(position + 1);
 
@@ -43,8 +45,21 @@ QSharedPointer<Image> Api::parseImage(Site *site, Page *parentPage, QMap<QString
 		d["sample_url"] = d["file_url"];
 	}
 
-	if (!tags.isEmpty()) {
-		data.insert("tags", QVariant::fromValue(tags));
+	// Use the preferred thumbnail format among the variants given by the source
+	const QStringList thumbnailFormats = site->thumbnailFormats();
+	for (const QString &format : thumbnailFormats) {
+		const QString variant = d.value("preview_url_" + format);
+		if (!variant.isEmpty()) {
+			d["preview_url"] = variant;
+			break;
+		}
+	}
+	for (auto it = d.begin(); it != d.end();) {
+		if (it.key().startsWith(QLatin1String("preview_url_"))) {
+			it = d.erase(it);
+		} else {
+			++it;
+		}
 	}
 
 	QStringList errors;
@@ -59,9 +74,23 @@ QSharedPointer<Image> Api::parseImage(Site *site, Page *parentPage, QMap<QString
 		return QSharedPointer<Image>();
 	}
 
+	// Reject the image on the listing values alone when possible, so that it never needs to be built
+	ImageFactoryData parsed = ImageFactory::parse(d, std::move(data), std::move(tags));
+	if (postFilter != nullptr && postFilter->count() > 0) {
+		const QStringList filters = postFilter->matchAvailable(ImageFactory::listingTokens(d, parsed));
+		if (!filters.isEmpty()) {
+			log(QStringLiteral("[%1][%2] Image #%3 filtered early. Reason: %4.").arg(site->url(), m_name, QString::number(position + 1), filters.join(", ")), Logger::Info);
+			if (filtered != nullptr) {
+				*filtered = true;
+			}
+			return QSharedPointer<Image>();
+		}
+	}
+
 	// Generate image
-	auto img = ImageFactory::build(site, d, std::move(data), site->getSource()->getProfile(), parentPage);
-	img->moveToThread(this->thread());
+	// Images can be built in a parser thread, so we move them to the thread of the page that will use them
+	auto img = ImageFactory::build(site, d, std::move(parsed), site->getSource()->getProfile(), parentPage);
+	img->moveToThread(parentPage != nullptr ? parentPage->thread() : this->thread());
 
 	return img;
 }
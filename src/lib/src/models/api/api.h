@@ -1,11 +1,13 @@
 #ifndef API_H
 #define API_H
 
+#include <QByteArray>
 #include <QDateTime>
 #include <QList>
 #include <QMap>
 #include <QSharedPointer>
 #include <QUrl>
+#include "search/search-format.h"
 #include "tags/tag.h"
 #include "tags/tag-type-with-id.h"
 
@@ -13,6 +15,7 @@
 class Image;
 class Page;
 class Pool;
+class PostFilter;
 class Site;
 
 
@@ -30,6 +33,7 @@ struct ParsedPage
 	int imageCount = -1;
 	QList<Tag> tags;
 	QList<QSharedPointer<Image>> images;
+	int filteredImageCount = 0; // Images rejected by the post-filters before being built
 	QUrl urlNextPage;
 	QUrl urlPrevPage;
 	QString wiki;
@@ -71,6 +75,7 @@ struct LastPageInformation
 	QString minDate;
 	qulonglong maxId;
 	QString maxDate;
+	bool preferCursor = false; // Use the IDs of the previous page instead of its number when possible
 };
 
 
@@ -89,12 +94,16 @@ class Api : public QObject
 		// Normal search
 		virtual PageUrl pageUrl(const QString &search, int page, int limit, LastPageInformation lastPage, Site *site) const = 0;
 		virtual bool parsePageErrors() const = 0;
-		virtual ParsedPage parsePage(Page *parentPage, const QString &source, int statusCode, int first) const = 0;
+		virtual ParsedPage parsePage(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter = nullptr) const = 0;
+		virtual int batchIdsMax() const = 0;
+		virtual QString batchIdsSearch(const QList<qulonglong> &ids) const = 0;
+		virtual int batchMd5sMax() const = 0;
+		virtual QString batchMd5sSearch(const QStringList &md5s) const = 0;
 
 		// Gallery
 		virtual PageUrl galleryUrl(const QSharedPointer<Image> &gallery, int page, int limit, Site *site) const = 0;
 		virtual bool parseGalleryErrors() const = 0;
-		virtual ParsedPage parseGallery(Page *parentPage, const QString &source, int statusCode, int first) const = 0;
+		virtual ParsedPage parseGallery(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter = nullptr) const = 0;
 
 		// Tag types
 		virtual PageUrl tagTypesUrl(Site *site) const = 0;
@@ -126,9 +135,10 @@ class Api : public QObject
 		virtual int maxLimit() const = 0;
 		virtual QStringList modifiers() const = 0;
 		virtual QStringList forcedTokens() const = 0;
+		virtual SearchFormat searchFormat() const = 0;
 
 	protected:
-		QSharedPointer<Image> parseImage(Site *site, Page *parentPage, QMap<QString, QString> d, QVariantMap data, int position, const QList<Tag> &tags = QList<Tag>()) const;
+		QSharedPointer<Image> parseImage(Site *site, Page *parentPage, QMap<QString, QString> d, QVariantMap data, int position, QList<Tag> tags = QList<Tag>(), const PostFilter *postFilter = nullptr, bool *filtered = nullptr) const;
 
 	private:
 		QString m_name;
@@ -1,19 +1,26 @@
 #include "models/api/javascript-api.h"
+#include <QElapsedTimer>
 #include <QJSEngine>
 #include <QJSValueIterator>
 #include <QMap>
-// #include <QMutexLocker>
+#include <QMutexLocker>
+#include <utility>
 #include "functions.h"
 #include "js-helpers.h"
 #include "logger.h"
+#include "metrics.h"
 #include "mixed-settings.h"
 #include "models/image.h"
 #include "models/page.h"
 #include "models/pool.h"
 #include "models/site.h"
+#include "models/source.h"
 #include "tags/tag.h"
 #include "tags/tag-database.h"
 #include "tags/tag-type-with-id.h"
+#include "tracer.h"
+
+#define PARSED_SEARCH_CACHE_SIZE 200
 
 
 QString normalize(QString key)
@@ -23,9 +30,25 @@ QString normalize(QString key)
 	return key;
 }
 
-JavascriptApi::JavascriptApi(QJSEngine *engine, const QJSValue &source, QMutex *jsEngineMutex, const QString &key)
-	: Api(normalize(key)), m_engine(engine), m_source(source), m_key(key), m_engineMutex(jsEngineMutex)
-{}
+JavascriptApi::JavascriptApi(Source *source, const QString &key)
+	: Api(normalize(key)), m_source(source), m_key(key), m_apiPath(QStringLiteral("apis.") + key + QLatin1Char('.'))
+{
+	m_parsedSearches.setMaxCost(PARSED_SEARCH_CACHE_SIZE);
+}
+
+
+QJSEngine *JavascriptApi::jsEngine() const
+{
+	return m_source->jsEngine();
+}
+
+/**
+ * Get a property of this API from its dotted path, such as "search.url".
+ */
+QJSValue JavascriptApi::jsApiProperty(const QString &path) const
+{
+	return m_source->jsProperty(m_apiPath + path);
+}
 
 
 void JavascriptApi::fillUrlObject(const QJSValue &result, Site *site, PageUrl &ret) const
@@ -88,13 +111,46 @@ QJSValue buildParsedSearchOperator(QJSEngine *engine, const QString &op, const Q
 	return ret;
 }
 
+/**
+ * Split a search into its tags along with their IDs in the site's tag database, re-using the previous results for
+ * the same search. Searches containing unknown tags are not cached, the tag database possibly being updated later.
+ */
+QList<QPair<QString, int>> JavascriptApi::parseSearch(const QString &search, Site *site) const
+{
+	const QStringList operands = search.split(" ", Qt::SkipEmptyParts);
+	const QString key = site->url() + "\n" + operands.join(' ');
+
+	QMutexLocker locker(&m_cacheMutex);
+	if (m_parsedSearches.contains(key)) {
+		return *m_parsedSearches[key];
+	}
+	locker.unlock();
+
+	const auto tagIds = site->tagDatabase()->getTagIds(operands);
+	auto *ret = new QList<QPair<QString, int>>();
+	bool allKnown = true;
+	for (const QString &operand : operands) {
+		const int id = tagIds.value(operand);
+		ret->append(qMakePair(operand, id));
+		allKnown = allKnown && id > 0;
+	}
+
+	const QList<QPair<QString, int>> copy = *ret;
+	if (allKnown) {
+		locker.relock();
+		m_parsedSearches.insert(key, ret);
+	} else {
+		delete ret;
+	}
+	return copy;
+}
+
 PageUrl JavascriptApi::pageUrl(const QString &search, int page, int limit, LastPageInformation lastPage, Site *site) const
 {
+	TraceSpan span(QStringLiteral("js pageUrl"), QStringLiteral("javascript"));
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("search").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("search.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support search";
 		return ret;
@@ -104,40 +160,27 @@ PageUrl JavascriptApi::pageUrl(const QString &search, int page, int limit, LastP
 	QJSValue parsedSearch;
 	const bool parseInput = getJsConst("search.parseInput", false).toBool();
 	if (parseInput && !search.trimmed().isEmpty()) {
-		QStringList operands = search.split(" ", Qt::SkipEmptyParts);
-		const auto tagIds = site->tagDatabase()->getTagIds(operands);
-
-		const QString firstTag = operands.takeFirst();
-		const auto first = buildParsedSearchTag(m_engine, firstTag, tagIds[firstTag]);
-
-		if (operands.isEmpty()) {
-			parsedSearch = first;
-		} else {
-			const QString secondTag = operands.takeFirst();
-			const auto second = buildParsedSearchTag(m_engine, secondTag, tagIds[secondTag]);
-			parsedSearch = buildParsedSearchOperator(m_engine, "and", first, second);
-
-			while (!operands.isEmpty()) {
-				const QString nextTag = operands.takeFirst();
-				const auto next = buildParsedSearchTag(m_engine, nextTag, tagIds[nextTag]);
-				parsedSearch = buildParsedSearchOperator(m_engine, "and", parsedSearch, next);
-			}
+		const QList<QPair<QString, int>> operands = parseSearch(search, site);
+		parsedSearch = buildParsedSearchTag(jsEngine(), operands[0].first, operands[0].second);
+		for (int i = 1; i < operands.count(); ++i) {
+			const auto next = buildParsedSearchTag(jsEngine(), operands[i].first, operands[i].second);
+			parsedSearch = buildParsedSearchOperator(jsEngine(), "and", parsedSearch, next);
 		}
 	}
 
-	QJSValue query = m_engine->newObject();
+	QJSValue query = jsEngine()->newObject();
 	query.setProperty("search", search);
 	query.setProperty("parsedSearch", parsedSearch);
 	query.setProperty("page", page);
 
-	QJSValue opts = m_engine->newObject();
+	QJSValue opts = jsEngine()->newObject();
 	opts.setProperty("limit", limit);
 	opts.setProperty("baseUrl", site->baseUrl());
 	opts.setProperty("loggedIn", site->isLoggedIn(false, true));
 
 	QJSValue previous = QJSValue(QJSValue::UndefinedValue);
 	if (lastPage.page > 0) {
-		previous = m_engine->newObject();
+		previous = jsEngine()->newObject();
 		previous.setProperty("page", lastPage.page);
 		previous.setProperty("minIdM1", QString::number(lastPage.minId - 1));
 		previous.setProperty("minId", QString::number(lastPage.minId));
@@ -145,6 +188,7 @@ PageUrl JavascriptApi::pageUrl(const QString &search, int page, int limit, LastP
 		previous.setProperty("maxIdP1", QString::number(lastPage.maxId + 1));
 		previous.setProperty("minDate", lastPage.minDate);
 		previous.setProperty("maxDate", lastPage.maxDate);
+		previous.setProperty("preferCursor", lastPage.preferCursor);
 	}
 
 	const QJSValue result = urlFunction.call(QList<QJSValue> { query, opts, previous });
@@ -200,7 +244,7 @@ QList<Tag> JavascriptApi::makeTags(const QJSValue &tags, Site *site) const
 	return ret;
 }
 
-QSharedPointer<Image> JavascriptApi::makeImage(const QJSValue &raw, Site *site, Page *parentPage, int index, int first) const
+QSharedPointer<Image> JavascriptApi::makeImage(const QJSValue &raw, Site *site, Page *parentPage, int index, int first, const PostFilter *postFilter, bool *filtered) const
 {
 	QList<Tag> tags;
 	QVariantMap data;
@@ -236,6 +280,12 @@ QSharedPointer<Image> JavascriptApi::makeImage(const QJSValue &raw, Site *site,
 				}
 				data[dit.name()] = dval;
 			}
+		} else if (key == QLatin1String("preview_variants") && val.isObject()) {
+			QJSValueIterator vit(val);
+			while (vit.hasNext()) {
+				vit.next();
+				d["preview_url_" + vit.name().toLower()] = vit.value().toString();
+			}
 		} else if (val.isArray()) {
 			d[key] = jsToStringList(val).join(key == QLatin1String("sources") ? '\n' : ' ');
 		} else {
@@ -245,7 +295,7 @@ QSharedPointer<Image> JavascriptApi::makeImage(const QJSValue &raw, Site *site,
 
 	if (!d.isEmpty()) {
 		const int pos = first + (d.contains("position") ? d["position"].toInt() : static_cast<int>(index));
-		QSharedPointer<Image> img = parseImage(site, parentPage, d, data, pos, tags);
+		QSharedPointer<Image> img = parseImage(site, parentPage, std::move(d), std::move(data), pos, std::move(tags), postFilter, filtered);
 		if (!img.isNull()) {
 			return img;
 		}
@@ -254,15 +304,87 @@ QSharedPointer<Image> JavascriptApi::makeImage(const QJSValue &raw, Site *site,
 	return nullptr;
 }
 
-ParsedPage JavascriptApi::parsePageInternal(const QString &type, Page *parentPage, const QString &source, int statusCode, int first) const
+/**
+ * Get the native extractor declared by the source for an endpoint, if any, parsing its JS declaration only once.
+ */
+ResponseExtractor JavascriptApi::responseExtractor(const QString &type) const
+{
+	{
+		QMutexLocker locker(&m_cacheMutex);
+		const auto it = m_extractors.constFind(type);
+		if (it != m_extractors.constEnd()) {
+			return it.value();
+		}
+	}
+
+	ResponseExtractor ret;
+	const QJSValue extract = jsApiProperty(type + QStringLiteral(".extract"));
+	if (extract.isObject()) {
+		const ResponseExtractor::Format format = extract.property("format").toString() == QLatin1String("xml")
+			? ResponseExtractor::Xml
+			: ResponseExtractor::Json;
+
+		QMap<QString, QString> fields;
+		QJSValueIterator it(extract.property("fields"));
+		while (it.hasNext()) {
+			it.next();
+			fields.insert(it.name(), it.value().toString());
+		}
+
+		const QJSValue imageCount = extract.property("imageCount");
+		const QJSValue pageCount = extract.property("pageCount");
+		ret = ResponseExtractor(
+			format,
+			extract.property("images").toString(),
+			fields,
+			imageCount.isString() ? imageCount.toString() : QString(),
+			pageCount.isString() ? pageCount.toString() : QString()
+		);
+	}
+
+	QMutexLocker locker(&m_cacheMutex);
+	m_extractors.insert(type, ret);
+	return ret;
+}
+
+ParsedPage JavascriptApi::parsePageInternal(const QString &type, Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter) const
 {
 	ParsedPage ret;
 
-	// QMutexLocker locker(m_engineMutex);
 	Site *site = parentPage->site();
-	const QJSValue &api = m_source.property("apis").property(m_key);
-	QJSValue parseFunction = api.property(type).property("parse");
-	const QJSValue &results = parseFunction.call(QList<QJSValue> { source, statusCode });
+	QJSValue parseFunction = jsApiProperty(type + QStringLiteral(".parse"));
+
+	// Extract the images natively when possible, only falling back to the JS parser on error
+	const ResponseExtractor extractor = responseExtractor(type);
+	if (extractor.isValid()) {
+		ResponseExtractor::Result extracted = extractor.extract(source);
+		if (extracted.error.isEmpty() || !parseFunction.isCallable()) {
+			ret.error = extracted.error;
+			ret.imageCount = extracted.imageCount;
+			ret.pageCount = extracted.pageCount;
+			ret.images.reserve(extracted.images.count());
+			for (int i = 0; i < extracted.images.count(); ++i) {
+				const int pos = first + (extracted.images[i].contains("position") ? extracted.images[i]["position"].toInt() : i);
+				bool filtered = false;
+
+				// Moving the record avoids a deep copy of the map when parseImage() modifies it
+				auto img = parseImage(site, parentPage, std::move(extracted.images[i]), QVariantMap(), pos, QList<Tag>(), postFilter, &filtered);
+				if (!img.isNull()) {
+					ret.images.append(img);
+				} else if (filtered) {
+					ret.filteredImageCount++;
+				}
+			}
+			return ret;
+		}
+	}
+
+	TraceSpan span(QStringLiteral("js parse"), QStringLiteral("javascript"), QVariantMap { { "source", m_source->getName() }, { "type", type } });
+	QElapsedTimer timer;
+	timer.start();
+	// Only the JS parser needs the whole response decoded to a string
+	const QJSValue &results = parseFunction.call(QList<QJSValue> { QString::fromUtf8(source), statusCode });
+	Metrics::getInstance().observe("grabber_js_parse_duration_ms", Metrics::label("source", m_source->getName()), timer.elapsed());
 
 	// Script errors and exceptions
 	if (results.isError()) {
@@ -282,9 +404,12 @@ ParsedPage JavascriptApi::parsePageInternal(const QString &type, Page *parentPag
 		const QJSValue images = results.property("images");
 		const quint32 length = images.property("length").toUInt();
 		for (quint32 i = 0; i < length; ++i) {
-			auto img = makeImage(images.property(i), site, parentPage, i, first);
+			bool filtered = false;
+			auto img = makeImage(images.property(i), site, parentPage, i, first, postFilter, &filtered);
 			if (!img.isNull()) {
 				ret.images.append(img);
+			} else if (filtered) {
+				ret.filteredImageCount++;
 			}
 		}
 	}
@@ -307,9 +432,49 @@ bool JavascriptApi::parsePageErrors() const
 	return getJsConst("search.parseErrors").toBool();
 }
 
-ParsedPage JavascriptApi::parsePage(Page *parentPage, const QString &source, int statusCode, int first) const
+ParsedPage JavascriptApi::parsePage(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter) const
+{
+	return parsePageInternal("search", parentPage, source, statusCode, first, postFilter);
+}
+
+int JavascriptApi::batchIdsMax() const
+{
+	if (getJsConst("search.batchIds").isUndefined()) {
+		return 0;
+	}
+
+	const int max = getJsConst("search.batchIds.max", 0).toInt();
+	return max > 0 ? max : maxLimit();
+}
+
+QString JavascriptApi::batchIdsSearch(const QList<qulonglong> &ids) const
+{
+	QStringList parts;
+	parts.reserve(ids.count());
+	for (qulonglong id : ids) {
+		parts.append(QString::number(id));
+	}
+
+	const QString prefix = getJsConst("search.batchIds.prefix").toString();
+	const QString separator = getJsConst("search.batchIds.separator").toString();
+	return prefix + parts.join(separator);
+}
+
+int JavascriptApi::batchMd5sMax() const
+{
+	if (getJsConst("search.batchMd5s").isUndefined()) {
+		return 0;
+	}
+
+	const int max = getJsConst("search.batchMd5s.max", 0).toInt();
+	return max > 0 ? max : maxLimit();
+}
+
+QString JavascriptApi::batchMd5sSearch(const QStringList &md5s) const
 {
-	return parsePageInternal("search", parentPage, source, statusCode, first);
+	const QString prefix = getJsConst("search.batchMd5s.prefix").toString();
+	const QString separator = getJsConst("search.batchMd5s.separator").toString();
+	return prefix + md5s.join(separator);
 }
 
 
@@ -317,20 +482,18 @@ PageUrl JavascriptApi::galleryUrl(const QSharedPointer<Image> &gallery, int page
 {
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("gallery").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("gallery.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support galleries";
 		return ret;
 	}
 
-	QJSValue query = m_engine->newObject();
+	QJSValue query = jsEngine()->newObject();
 	query.setProperty("id", QString::number(gallery->id()));
 	query.setProperty("md5", gallery->md5());
 	query.setProperty("page", page);
 
-	QJSValue opts = m_engine->newObject();
+	QJSValue opts = jsEngine()->newObject();
 	opts.setProperty("limit", limit);
 	opts.setProperty("baseUrl", site->baseUrl());
 	opts.setProperty("loggedIn", site->isLoggedIn(false, true));
@@ -346,25 +509,21 @@ bool JavascriptApi::parseGalleryErrors() const
 	return getJsConst("gallery.parseErrors").toBool();
 }
 
-ParsedPage JavascriptApi::parseGallery(Page *parentPage, const QString &source, int statusCode, int first) const
+ParsedPage JavascriptApi::parseGallery(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter) const
 {
-	return parsePageInternal("gallery", parentPage, source, statusCode, first);
+	return parsePageInternal("gallery", parentPage, source, statusCode, first, postFilter);
 }
 
 
 bool JavascriptApi::mustLoadTagTypes() const
 {
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue tagTypes = api.property("tagTypes");
+	QJSValue tagTypes = jsApiProperty(QStringLiteral("tagTypes"));
 	return tagTypes.isUndefined() || !tagTypes.isBool();
 }
 
 bool JavascriptApi::canLoadTagTypes() const
 {
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("tagTypes").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("tagTypes.url"));
 	return !urlFunction.isUndefined() && urlFunction.isCallable();
 }
 
@@ -372,9 +531,7 @@ PageUrl JavascriptApi::tagTypesUrl(Site *site) const
 {
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("tagTypes").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("tagTypes.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support tag type loading";
 		return ret;
@@ -397,9 +554,7 @@ ParsedTagTypes JavascriptApi::parseTagTypes(const QString &source, int statusCod
 
 	ParsedTagTypes ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue parseFunction = api.property("tagTypes").property("parse");
+	QJSValue parseFunction = jsApiProperty(QStringLiteral("tagTypes.parse"));
 	QJSValue results = parseFunction.call(QList<QJSValue> { source, statusCode });
 
 	// Script errors and exceptions
@@ -432,9 +587,7 @@ ParsedTagTypes JavascriptApi::parseTagTypes(const QString &source, int statusCod
 
 bool JavascriptApi::canLoadTags() const
 {
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("tags").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("tags.url"));
 	return !urlFunction.isUndefined();
 }
 
@@ -442,19 +595,17 @@ PageUrl JavascriptApi::tagsUrl(int page, int limit, const QString &order, Site *
 {
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("tags").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("tags.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support tag loading";
 		return ret;
 	}
 
-	QJSValue query = m_engine->newObject();
+	QJSValue query = jsEngine()->newObject();
 	query.setProperty("page", page);
 	query.setProperty("order", order);
 
-	QJSValue opts = m_engine->newObject();
+	QJSValue opts = jsEngine()->newObject();
 	opts.setProperty("limit", limit);
 	opts.setProperty("baseUrl", site->baseUrl());
 	opts.setProperty("loggedIn", site->isLoggedIn(false, true));
@@ -474,9 +625,7 @@ ParsedTags JavascriptApi::parseTags(const QString &source, int statusCode, Site
 {
 	ParsedTags ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue parseFunction = api.property("tags").property("parse");
+	QJSValue parseFunction = jsApiProperty(QStringLiteral("tags.parse"));
 	QJSValue results = parseFunction.call(QList<QJSValue> { source, statusCode });
 
 	// Script errors and exceptions
@@ -498,9 +647,7 @@ ParsedTags JavascriptApi::parseTags(const QString &source, int statusCode, Site
 
 bool JavascriptApi::canLoadDetails() const
 {
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("details").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("details.url"));
 	return !urlFunction.isUndefined();
 }
 bool JavascriptApi::canLoadFullDetails() const
@@ -513,15 +660,13 @@ PageUrl JavascriptApi::detailsUrl(qulonglong id, const QString &md5, Site *site)
 {
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("details").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("details.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support details loading";
 		return ret;
 	}
 
-	QJSValue opts = m_engine->newObject();
+	QJSValue opts = jsEngine()->newObject();
 	opts.setProperty("baseUrl", site->baseUrl());
 	opts.setProperty("loggedIn", site->isLoggedIn(false, true));
 
@@ -540,9 +685,7 @@ ParsedDetails JavascriptApi::parseDetails(const QString &source, int statusCode,
 {
 	ParsedDetails ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue parseFunction = api.property("details").property("parse");
+	QJSValue parseFunction = jsApiProperty(QStringLiteral("details.parse"));
 	QJSValue results = parseFunction.call(QList<QJSValue> { source, statusCode });
 
 	// Script errors and exceptions
@@ -606,9 +749,7 @@ ParsedDetails JavascriptApi::parseDetails(const QString &source, int statusCode,
 
 bool JavascriptApi::canLoadCheck() const
 {
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("check").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("check.url"));
 	return !urlFunction.isUndefined();
 }
 
@@ -616,9 +757,7 @@ PageUrl JavascriptApi::checkUrl() const
 {
 	PageUrl ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue urlFunction = api.property("check").property("url");
+	QJSValue urlFunction = jsApiProperty(QStringLiteral("check.url"));
 	if (urlFunction.isUndefined()) {
 		ret.error = "This API does not support checking";
 		return ret;
@@ -639,9 +778,7 @@ ParsedCheck JavascriptApi::parseCheck(const QString &source, int statusCode) con
 {
 	ParsedCheck ret;
 
-	// QMutexLocker locker(m_engineMutex);
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue parseFunction = api.property("check").property("parse");
+	QJSValue parseFunction = jsApiProperty(QStringLiteral("check.parse"));
 	QJSValue result = parseFunction.call(QList<QJSValue> { source, statusCode });
 
 	// Script errors and exceptions
@@ -657,27 +794,14 @@ ParsedCheck JavascriptApi::parseCheck(const QString &source, int statusCode) con
 }
 
 
-static QJSValue tryGetValue(QJSValue api, const QStringList &properties)
-{
-	for (int i = 0; !api.isUndefined() && i < properties.length(); ++i) {
-		api = api.property(properties[i]);
-	}
-	return api;
-}
-
 QJSValue JavascriptApi::getJsConst(const QString &fullKey, const QJSValue &def) const
 {
-	// QMutexLocker locker(m_engineMutex);
-
-	const QStringList properties = fullKey.split('.');
-
-	QJSValue api = m_source.property("apis").property(m_key);
-	QJSValue fromApi = tryGetValue(api, properties);
+	const QJSValue fromApi = jsApiProperty(fullKey);
 	if (!fromApi.isUndefined()) {
 		return fromApi;
 	}
 
-	QJSValue fromSource = tryGetValue(m_source, properties);
+	const QJSValue fromSource = m_source->jsProperty(fullKey);
 	if (!fromSource.isUndefined()) {
 		return fromSource;
 	}
@@ -700,3 +824,40 @@ QStringList JavascriptApi::modifiers() const
 { return jsToStringList(getJsConst("modifiers")); }
 QStringList JavascriptApi::forcedTokens() const
 { return jsToStringList(getJsConst("forcedTokens")); }
+
+static SearchFormatType jsToSearchFormatType(const QJSValue &val)
+{
+	if (val.isString()) {
+		return SearchFormatType { val.toString(), QString() };
+	}
+	if (val.isObject()) {
+		const QJSValue prefix = val.property("prefix");
+		return SearchFormatType { val.property("separator").toString(), prefix.isString() ? prefix.toString() : QString() };
+	}
+	return SearchFormatType();
+}
+
+SearchFormat JavascriptApi::searchFormat() const
+{
+	{
+		QMutexLocker locker(&m_cacheMutex);
+		if (m_searchFormatLoaded) {
+			return m_searchFormat;
+		}
+	}
+
+	SearchFormat ret({ " ", "" }, {}, false, SearchFormat::And);
+	const QJSValue format = getJsConst("searchFormat");
+	if (format.isObject()) {
+		const SearchFormatType andOp = format.hasProperty("and") ? jsToSearchFormatType(format.property("and")) : SearchFormatType { " ", "" };
+		const SearchFormatType orOp = jsToSearchFormatType(format.property("or"));
+		const bool parenthesis = format.property("parenthesis").toBool();
+		const SearchFormat::Precedence precedence = format.property("precedence").toString() == "or" ? SearchFormat::Or : SearchFormat::And;
+		ret = SearchFormat(andOp, orOp, parenthesis, precedence);
+	}
+
+	QMutexLocker locker(&m_cacheMutex);
+	m_searchFormat = ret;
+	m_searchFormatLoaded = true;
+	return ret;
+}
@@ -1,15 +1,21 @@
 #ifndef JAVASCRIPT_API_H
 #define JAVASCRIPT_API_H
 
+#include <QCache>
+#include <QHash>
 #include <QJSValue>
+#include <QList>
+#include <QMutex>
+#include <QPair>
 #include <QString>
 #include "models/api/api.h"
+#include "models/api/response-extractor.h"
 
 
 class Page;
 class QJSEngine;
-class QMutex;
 class Site;
+class Source;
 class Tag;
 
 class JavascriptApi : public Api
@@ -17,17 +23,21 @@ class JavascriptApi : public Api
 	Q_OBJECT
 
 	public:
-		explicit JavascriptApi(QJSEngine *engine, const QJSValue &source, QMutex *jsEngineMutex, const QString &key);
+		explicit JavascriptApi(Source *source, const QString &key);
 
 		// Normal search
 		PageUrl pageUrl(const QString &search, int page, int limit, LastPageInformation lastPage, Site *site) const override;
 		bool parsePageErrors() const override;
-		ParsedPage parsePage(Page *parentPage, const QString &source, int statusCode, int first) const override;
+		ParsedPage parsePage(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter = nullptr) const override;
+		int batchIdsMax() const override;
+		QString batchIdsSearch(const QList<qulonglong> &ids) const override;
+		int batchMd5sMax() const override;
+		QString batchMd5sSearch(const QStringList &md5s) const override;
 
 		// Gallery
 		PageUrl galleryUrl(const QSharedPointer<Image> &gallery, int page, int limit, Site *site) const override;
 		bool parseGalleryErrors() const override;
-		ParsedPage parseGallery(Page *parentPage, const QString &source, int statusCode, int first) const override;
+		ParsedPage parseGallery(Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter = nullptr) const override;
 
 		// Tag types
 		PageUrl tagTypesUrl(Site *site) const override;
@@ -60,19 +70,30 @@ class JavascriptApi : public Api
 		int maxLimit() const override;
 		QStringList modifiers() const override;
 		QStringList forcedTokens() const override;
+		SearchFormat searchFormat() const override;
 
 	protected:
 		void fillUrlObject(const QJSValue &result, Site *site, PageUrl &ret) const;
 		QList<Tag> makeTags(const QJSValue &tags, Site *site) const;
-		QSharedPointer<Image> makeImage(const QJSValue &raw, Site *site, Page *parentPage = nullptr, int index = 0, int first = 1) const;
+		QSharedPointer<Image> makeImage(const QJSValue &raw, Site *site, Page *parentPage = nullptr, int index = 0, int first = 1, const PostFilter *postFilter = nullptr, bool *filtered = nullptr) const;
 		QJSValue getJsConst(const QString &key, const QJSValue &def = QJSValue(QJSValue::UndefinedValue)) const;
-		ParsedPage parsePageInternal(const QString &type, Page *parentPage, const QString &source, int statusCode, int first) const;
+		QList<QPair<QString, int>> parseSearch(const QString &search, Site *site) const;
+		ResponseExtractor responseExtractor(const QString &type) const;
+		QJSEngine *jsEngine() const;
+		QJSValue jsApiProperty(const QString &path) const;
+		ParsedPage parsePageInternal(const QString &type, Page *parentPage, const QByteArray &source, int statusCode, int first, const PostFilter *postFilter) const;
 
 	private:
-		QJSEngine *m_engine;
-		const QJSValue &m_source;
+		Source *m_source;
 		QString m_key;
-		mutable QMutex *m_engineMutex;
+		QString m_apiPath;
+
+		// JS values can only be used in the thread of their engine, so only plain values are cached
+		mutable QMutex m_cacheMutex;
+		mutable bool m_searchFormatLoaded = false;
+		mutable SearchFormat m_searchFormat;
+		mutable QCache<QString, QList<QPair<QString, int>>> m_parsedSearches;
+		mutable QHash<QString, ResponseExtractor> m_extractors;
 };
 
 #endif // JAVASCRIPT_API_H
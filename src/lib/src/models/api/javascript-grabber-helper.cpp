@@ -6,6 +6,8 @@
 #include "functions.h"
 #include "javascript-html-document.h"
 #include "logger.h"
+#include "utils/html-node.h"
+#include "utils/regex-cache.h"
 
 
 JavascriptGrabberHelper::JavascriptGrabberHelper(QJSEngine &engine)
@@ -22,7 +24,7 @@ QJSValue JavascriptGrabberHelper::regexMatches(const QString &regex, const QStri
 {
 	QJSValue ret = m_engine.newArray();
 
-	const QRegularExpression reg(regex, QRegularExpression::DotMatchesEverythingOption);
+	const QRegularExpression reg = RegexCache::global().get(regex, QRegularExpression::DotMatchesEverythingOption);
 	const QStringList &groups = reg.namedCaptureGroups();
 	auto matches = reg.globalMatch(txt);
 
@@ -128,9 +130,16 @@ QJSValue JavascriptGrabberHelper::parseXML(const QString &txt) const
 
 QJSValue JavascriptGrabberHelper::parseHTML(const QString &html, bool fragment) const
 {
-	const JavascriptHtmlDocument *doc = JavascriptHtmlDocument::fromString(m_engine, html, fragment);
-	if (doc == nullptr) {
+	if (m_lastHtmlNode.isNull() || fragment != m_lastHtmlFragment || html != m_lastHtml) {
+		m_lastHtmlNode.reset(HtmlNode::fromString(html, fragment));
+		m_lastHtml = html;
+		m_lastHtmlFragment = fragment;
+	}
+	if (m_lastHtmlNode.isNull()) {
 		return QJSValue(QJSValue::UndefinedValue);
 	}
-	return m_engine.newQObject((QObject*) doc);
+
+	// The wrapper has no parent so that it gets garbage collected with the rest of the JS objects
+	auto *doc = new JavascriptHtmlDocument(m_engine, *m_lastHtmlNode);
+	return m_engine.newQObject(doc);
 }
@@ -3,8 +3,11 @@
 
 #include <QJSValue>
 #include <QObject>
+#include <QSharedPointer>
+#include <QString>
 
 
+class HtmlNode;
 class QDomNode;
 class QJSEngine;
 
@@ -23,6 +26,11 @@ class JavascriptGrabberHelper : public QObject
 	private:
 		QJSValue _parseXMLRec(const QDomNode &node) const;
 		QJSEngine &m_engine;
+
+		// The same page is often parsed several times by the different parts of a source, so the last one is kept
+		mutable QString m_lastHtml;
+		mutable bool m_lastHtmlFragment = false;
+		mutable QSharedPointer<HtmlNode> m_lastHtmlNode;
 };
 
 #endif // JAVASCRIPT_GRABBER_HELPER_H
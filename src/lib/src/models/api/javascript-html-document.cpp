@@ -1,6 +1,7 @@
 #include "models/api/javascript-html-document.h"
 #include <QJSEngine>
 #include <QJSValue>
+#include <QScopedPointer>
 #include "lexbor/css/css.h"
 #include "lexbor/html/html.h"
 #include "lexbor/selectors/selectors.h"
@@ -8,13 +9,13 @@
 
 
 JavascriptHtmlDocument::JavascriptHtmlDocument(QJSEngine &engine, const HtmlNode &node)
-	: QObject(&engine), m_engine(engine), m_node(node)
+	: m_engine(engine), m_node(node)
 {}
 
 JavascriptHtmlDocument *JavascriptHtmlDocument::fromString(QJSEngine &engine, const QString &html, bool fragment)
 {
-	HtmlNode *node = HtmlNode::fromString(html, fragment);
-	if (node == nullptr) {
+	QScopedPointer<HtmlNode> node(HtmlNode::fromString(html, fragment));
+	if (node.isNull()) {
 		return nullptr;
 	}
 	return new JavascriptHtmlDocument(engine, *node);
@@ -69,7 +70,7 @@ QJSValue JavascriptHtmlDocument::find(const QString &css) const
 {
 	const QList<HtmlNode> nodes = m_node.find(css);
 
-	// Convert result to QJSValue
+	// Convert result to QJSValue, the wrappers having no parent to be garbage collected by the JS engine
 	QJSValue js = m_engine.newArray(nodes.length());
 	for (int i = 0; i < nodes.length(); ++i) {
 		auto *obj = new JavascriptHtmlDocument(m_engine, nodes[i]);
@@ -77,3 +78,13 @@ QJSValue JavascriptHtmlDocument::find(const QString &css) const
 	}
 	return js;
 }
+
+QJSValue JavascriptHtmlDocument::findAttr(const QString &css, const QString &attr) const
+{
+	return listToJsValue(&m_engine, m_node.findAttr(css, attr));
+}
+
+QJSValue JavascriptHtmlDocument::findText(const QString &css) const
+{
+	return listToJsValue(&m_engine, m_node.findText(css));
+}
@@ -8,6 +8,10 @@
 
 class QJSEngine;
 
+/**
+ * JS wrapper of an HTML node. Wrappers are owned by the JS engine, and keep their document alive as long as they are
+ * reachable from JS.
+ */
 class JavascriptHtmlDocument : public QObject
 {
 	Q_OBJECT
@@ -26,6 +30,8 @@ class JavascriptHtmlDocument : public QObject
 		Q_INVOKABLE QJSValue pathIds() const;
 
 		Q_INVOKABLE QJSValue find(const QString &css) const;
+		Q_INVOKABLE QJSValue findAttr(const QString &css, const QString &attr) const;
+		Q_INVOKABLE QJSValue findText(const QString &css) const;
 
 	private:
 		QJSEngine &m_engine;
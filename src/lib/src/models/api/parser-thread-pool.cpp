@@ -0,0 +1,65 @@
+#include "models/api/parser-thread-pool.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <QWaitCondition>
+
+
+QThreadPool *parserThreadPool()
+{
+	static QThreadPool *pool = nullptr;
+
+	if (pool == nullptr) {
+		pool = new QThreadPool();
+		pool->setExpiryTimeout(-1); // Threads own warmed-up engines, so we don't want them to expire
+	}
+
+	return pool;
+}
+
+void setParserThreadCount(int count)
+{
+	parserThreadPool()->setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+
+struct ParserThreadBarrier
+{
+	QMutex mutex;
+	QWaitCondition condition;
+	int arrived = 0;
+};
+
+QList<QFuture<void>> runOnEachParserThread(const std::function<void()> &job)
+{
+	QThreadPool *pool = parserThreadPool();
+	const int count = pool->maxThreadCount();
+
+	// Each job waits for all the others to start, which forces the pool to dispatch them on different threads
+	auto barrier = QSharedPointer<ParserThreadBarrier>::create();
+
+	QList<QFuture<void>> futures;
+	futures.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		futures.append(QtConcurrent::run(pool, [barrier, count, job]() {
+			{
+				QMutexLocker locker(&barrier->mutex);
+				barrier->arrived++;
+				if (barrier->arrived >= count) {
+					barrier->condition.wakeAll();
+				}
+				while (barrier->arrived < count) {
+					if (!barrier->condition.wait(&barrier->mutex, 5000)) {
+						break; // Give up if the pool is too busy, warm-up is only a best effort
+					}
+				}
+			}
+			job();
+		}));
+	}
+
+	return futures;
+}
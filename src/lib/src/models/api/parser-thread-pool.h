@@ -0,0 +1,23 @@
+#ifndef PARSER_THREAD_POOL_H
+#define PARSER_THREAD_POOL_H
+
+#include <functional>
+#include <QFuture>
+#include <QList>
+
+
+class QThreadPool;
+
+/**
+ * Shared pool of threads used to parse API results outside of their owner's thread.
+ * Each thread keeps its own JavaScript engine, so the pool size is also the number of engines per source.
+ */
+QThreadPool *parserThreadPool();
+void setParserThreadCount(int count);
+
+/**
+ * Run a job once in every thread of the parser pool, i.e. to warm up their JavaScript engines.
+ */
+QList<QFuture<void>> runOnEachParserThread(const std::function<void()> &job);
+
+#endif // PARSER_THREAD_POOL_H
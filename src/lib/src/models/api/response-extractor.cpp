@@ -0,0 +1,271 @@
+#include "models/api/response-extractor.h"
+#include <QDomDocument>
+#include <QDomElement>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPair>
+#include <QStringList>
+#include <QVariant>
+#include <utility>
+
+
+ResponseExtractor::ResponseExtractor(Format format, QString images, QMap<QString, QString> fields, QString imageCount, QString pageCount)
+	: m_format(format), m_images(std::move(images)), m_fields(std::move(fields)), m_imageCount(std::move(imageCount)), m_pageCount(std::move(pageCount))
+{
+	m_valid = !m_fields.isEmpty();
+}
+
+bool ResponseExtractor::isValid() const
+{
+	return m_valid;
+}
+
+/**
+ * Responses are parsed straight from their raw bytes, only the extracted values being decoded to strings.
+ */
+ResponseExtractor::Result ResponseExtractor::extract(const QByteArray &source) const
+{
+	return m_format == Xml
+		? extractXml(source)
+		: extractJson(source);
+}
+
+
+QJsonValue ResponseExtractor::jsonPointer(const QJsonValue &root, const QString &pointer)
+{
+	if (pointer.isEmpty()) {
+		return root;
+	}
+	if (!pointer.startsWith('/')) {
+		return QJsonValue(QJsonValue::Undefined);
+	}
+
+	return jsonPointer(root, jsonPointerParts(pointer));
+}
+
+/**
+ * Split and unescape a JSON pointer once, so that it can be resolved for all the images of a page.
+ */
+QStringList ResponseExtractor::jsonPointerParts(const QString &pointer)
+{
+	QStringList parts = pointer.mid(1).split('/');
+	for (QString &part : parts) {
+		part.replace("~1", "/").replace("~0", "~");
+	}
+	return parts;
+}
+
+QJsonValue ResponseExtractor::jsonPointer(const QJsonValue &root, const QStringList &parts)
+{
+	QJsonValue val = root;
+	for (const QString &part : parts) {
+		if (val.isObject()) {
+			val = val.toObject().value(part);
+		} else if (val.isArray()) {
+			bool ok;
+			const int index = part.toInt(&ok);
+			val = ok ? val.toArray().at(index) : QJsonValue(QJsonValue::Undefined);
+		} else {
+			return QJsonValue(QJsonValue::Undefined);
+		}
+	}
+
+	return val;
+}
+
+/**
+ * Convert a JSON value the same way the JS results are converted, arrays being joined.
+ */
+QString ResponseExtractor::jsonToString(const QJsonValue &val, const QString &key)
+{
+	if (val.isString()) {
+		return val.toString();
+	}
+	if (val.isDouble() || val.isBool()) {
+		return val.toVariant().toString();
+	}
+	if (val.isArray()) {
+		QStringList parts;
+		for (const QJsonValue &part : val.toArray()) {
+			const QString str = jsonToString(part, QString());
+			if (!str.isNull()) {
+				parts.append(str);
+			}
+		}
+		return parts.join(key == QLatin1String("sources") ? '\n' : ' ');
+	}
+	return QString();
+}
+
+static int jsonToInt(const QJsonValue &val)
+{
+	if (val.isDouble()) {
+		return val.toInt(-1);
+	}
+	bool ok;
+	const int ret = val.toString().toInt(&ok);
+	return ok ? ret : -1;
+}
+
+ResponseExtractor::Result ResponseExtractor::extractJson(const QByteArray &source) const
+{
+	Result ret;
+
+	QJsonParseError error;
+	const QJsonDocument doc = QJsonDocument::fromJson(source, &error);
+	if (doc.isNull()) {
+		ret.error = QStringLiteral("Error parsing JSON: %1").arg(error.errorString());
+		return ret;
+	}
+
+	const QJsonValue root = doc.isArray() ? QJsonValue(doc.array()) : QJsonValue(doc.object());
+	const QJsonValue images = jsonPointer(root, m_images);
+	if (!images.isArray()) {
+		ret.error = QStringLiteral("No image list found at \"%1\"").arg(m_images);
+		return ret;
+	}
+
+	// Field pointers are the same for all images
+	QList<QPair<QString, QStringList>> fields;
+	fields.reserve(m_fields.count());
+	for (auto it = m_fields.constBegin(); it != m_fields.constEnd(); ++it) {
+		if (it.value().isEmpty() || it.value().startsWith('/')) {
+			fields.append(qMakePair(it.key(), it.value().isEmpty() ? QStringList() : jsonPointerParts(it.value())));
+		}
+	}
+
+	const QJsonArray array = images.toArray();
+	ret.images.reserve(array.count());
+	for (const QJsonValue &image : array) {
+		QMap<QString, QString> d;
+		for (const auto &field : qAsConst(fields)) {
+			const QString val = jsonToString(jsonPointer(image, field.second), field.first);
+			if (!val.isNull()) {
+				d.insert(field.first, val);
+			}
+		}
+		if (!d.isEmpty()) {
+			ret.images.append(std::move(d));
+		}
+	}
+
+	if (!m_imageCount.isEmpty()) {
+		ret.imageCount = jsonToInt(jsonPointer(root, m_imageCount));
+	}
+	if (!m_pageCount.isEmpty()) {
+		ret.pageCount = jsonToInt(jsonPointer(root, m_pageCount));
+	}
+
+	return ret;
+}
+
+
+QString ResponseExtractor::xmlPath(const QDomElement &root, const QString &path)
+{
+	if (path.isEmpty()) {
+		return root.text();
+	}
+
+	return xmlPath(root, path.split('/'));
+}
+
+QString ResponseExtractor::xmlPath(const QDomElement &root, const QStringList &parts)
+{
+	if (parts.isEmpty()) {
+		return root.text();
+	}
+
+	QDomElement element = root;
+	for (int i = 0; i < parts.count() - 1; ++i) {
+		element = element.firstChildElement(parts[i]);
+		if (element.isNull()) {
+			return QString();
+		}
+	}
+
+	const QString &last = parts.last();
+	if (last.startsWith('@')) {
+		const QString attr = last.mid(1);
+		return element.hasAttribute(attr) ? element.attribute(attr) : QString();
+	}
+
+	const QDomElement child = element.firstChildElement(last);
+	return child.isNull() ? QString() : child.text();
+}
+
+/**
+ * Get all the elements matching a path, the first part being the root element itself.
+ */
+static QList<QDomElement> xmlElements(const QDomElement &root, const QString &path)
+{
+	const QStringList parts = path.split('/', Qt::SkipEmptyParts);
+	if (parts.isEmpty() || root.tagName() != parts.first()) {
+		return {};
+	}
+
+	QList<QDomElement> ret { root };
+	for (int i = 1; i < parts.count(); ++i) {
+		QList<QDomElement> children;
+		for (const QDomElement &element : qAsConst(ret)) {
+			for (QDomElement child = element.firstChildElement(parts[i]); !child.isNull(); child = child.nextSiblingElement(parts[i])) {
+				children.append(child);
+			}
+		}
+		ret = children;
+	}
+	return ret;
+}
+
+ResponseExtractor::Result ResponseExtractor::extractXml(const QByteArray &source) const
+{
+	Result ret;
+
+	QDomDocument doc;
+	QString errorMsg;
+	int errorLine, errorColumn;
+	if (!doc.setContent(source, false, &errorMsg, &errorLine, &errorColumn)) {
+		ret.error = QStringLiteral("Error parsing XML: %1 (%2 - %3)").arg(errorMsg, QString::number(errorLine), QString::number(errorColumn));
+		return ret;
+	}
+
+	const QDomElement root = doc.documentElement();
+	const QList<QDomElement> images = xmlElements(root, m_images);
+	if (images.isEmpty() && root.tagName() != m_images.section('/', 0, 0, QString::SectionSkipEmpty)) {
+		ret.error = QStringLiteral("No image list found at \"%1\"").arg(m_images);
+		return ret;
+	}
+
+	// Field paths are the same for all images
+	QList<QPair<QString, QStringList>> fields;
+	fields.reserve(m_fields.count());
+	for (auto it = m_fields.constBegin(); it != m_fields.constEnd(); ++it) {
+		fields.append(qMakePair(it.key(), it.value().isEmpty() ? QStringList() : it.value().split('/')));
+	}
+
+	ret.images.reserve(images.count());
+	for (const QDomElement &image : images) {
+		QMap<QString, QString> d;
+		for (const auto &field : qAsConst(fields)) {
+			const QString val = xmlPath(image, field.second);
+			if (!val.isNull()) {
+				d.insert(field.first, val);
+			}
+		}
+		if (!d.isEmpty()) {
+			ret.images.append(std::move(d));
+		}
+	}
+
+	bool ok;
+	if (!m_imageCount.isEmpty()) {
+		const int count = xmlPath(root, m_imageCount).toInt(&ok);
+		ret.imageCount = ok ? count : -1;
+	}
+	if (!m_pageCount.isEmpty()) {
+		const int count = xmlPath(root, m_pageCount).toInt(&ok);
+		ret.pageCount = ok ? count : -1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,65 @@
+#ifndef RESPONSE_EXTRACTOR_H
+#define RESPONSE_EXTRACTOR_H
+
+#include <QByteArray>
+#include <QJsonValue>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+
+class QDomElement;
+
+/**
+ * Extracts images from a JSON or XML response natively, following field mappings declared by a source.
+ *
+ * For JSON, paths are JSON pointers (RFC 6901), such as "/posts" or "/file/url".
+ * For XML, paths are element names separated by slashes, starting from the root element for the list of images and
+ * from the image's element for its fields. The last part can be an attribute, such as "file/@url".
+ */
+class ResponseExtractor
+{
+	public:
+		enum Format
+		{
+			Json,
+			Xml,
+		};
+
+		struct Result
+		{
+			QString error;
+			QList<QMap<QString, QString>> images;
+			int imageCount = -1;
+			int pageCount = -1;
+		};
+
+		ResponseExtractor() = default;
+		ResponseExtractor(Format format, QString images, QMap<QString, QString> fields, QString imageCount = QString(), QString pageCount = QString());
+
+		bool isValid() const;
+		Result extract(const QByteArray &source) const;
+
+		static QJsonValue jsonPointer(const QJsonValue &root, const QString &pointer);
+		static QString xmlPath(const QDomElement &root, const QString &path);
+
+	protected:
+		static QStringList jsonPointerParts(const QString &pointer);
+		static QJsonValue jsonPointer(const QJsonValue &root, const QStringList &parts);
+		static QString xmlPath(const QDomElement &root, const QStringList &parts);
+
+		Result extractJson(const QByteArray &source) const;
+		Result extractXml(const QByteArray &source) const;
+		static QString jsonToString(const QJsonValue &val, const QString &key);
+
+	private:
+		Format m_format = Json;
+		QString m_images;
+		QMap<QString, QString> m_fields;
+		QString m_imageCount;
+		QString m_pageCount;
+		bool m_valid = false;
+};
+
+#endif // RESPONSE_EXTRACTOR_H
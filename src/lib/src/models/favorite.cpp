@@ -1,6 +1,7 @@
 #include "models/favorite.h"
 #include <QDir>
 #include <QFile>
+#include <QImage>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QPixmap>
@@ -65,7 +66,11 @@ bool Favorite::setImage(const QPixmap &img)
 }
 QPixmap Favorite::getImage() const
 {
-	QPixmap img(m_imagePath);
+	return QPixmap::fromImage(getThumbnail());
+}
+QImage Favorite::getThumbnail() const
+{
+	QImage img(m_imagePath);
 	if (img.width() > 150 || img.height() > 150) {
 		img = img.scaled(QSize(150, 150), Qt::KeepAspectRatio, Qt::SmoothTransformation);
 		img.save(savePath("thumbs/" + getName(true) + ".png"), "PNG");
@@ -7,6 +7,7 @@
 #include "models/monitor.h"
 
 
+class QImage;
 class QPixmap;
 class Site;
 
@@ -40,6 +41,11 @@ class Favorite
 		bool setImage(const QPixmap &img);
 		QPixmap getImage() const;
 
+		/**
+		 * Same as getImage(), but can be called from any thread.
+		 */
+		QImage getThumbnail() const;
+
 		QString toString() const;
 		static Favorite fromString(const QString &path, const QString &text);
 		void toJson(QJsonObject &json) const;
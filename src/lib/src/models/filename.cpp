@@ -11,8 +11,10 @@
 #include "filename/ast/filename-node-variable.h"
 #include "filename/ast-filename.h"
 #include "filename/conditional-filename.h"
+#include "filename/conditional-filename-list.h"
 #include "filename/filename-cache.h"
-#include "filename/filename-execution-visitor.h"
+#include "filename/filename-program.h"
+#include "filename/filename-requirements.h"
 #include "filename/filename-text-extraction-visitor.h"
 #include "functions.h"
 #include "loader/token.h"
@@ -136,8 +138,9 @@ QStringList Filename::path(QMap<QString, Token> tokens, Profile *profile, QStrin
 
 	// Conditional filenames
 	if (flags.testFlag(PathFlag::ConditionalFilenames)) {
-		QList<ConditionalFilename> filenames = getFilenames(settings);
-		for (const auto &fn : filenames) {
+		const auto filenames = ConditionalFilenameList::fromSettings(settings);
+		for (int i : filenames->candidates(tokens)) {
+			const ConditionalFilename &fn = filenames->filenames()[i];
 			if (fn.matches(tokens, settings)) {
 				if (!fn.path.isEmpty()) {
 					folder = fn.path;
@@ -159,11 +162,8 @@ QStringList Filename::path(QMap<QString, Token> tokens, Profile *profile, QStrin
 	QList<QMap<QString, Token>> replacesList = expandTokens(tokens, settings);
 
 	for (const auto &replaces : replacesList) {
-		FilenameExecutionVisitor executionVisitor(replaces, settings);
-		executionVisitor.setEscapeMethod(m_escapeMethod);
-		executionVisitor.setKeepInvalidTokens(flags.testFlag(PathFlag::KeepInvalidTokens));
 		// TODO(Bionus): PathFlag::ExpandConditionals
-		QString cFilename = executionVisitor.run(*m_ast->ast());
+		QString cFilename = m_ast->program()->run(replaces, settings, m_escapeMethod, flags.testFlag(PathFlag::KeepInvalidTokens));
 
 		// Something wrong happened (JavaScript error...)
 		if (cFilename.isEmpty()) {
@@ -195,7 +195,7 @@ QStringList Filename::path(QMap<QString, Token> tokens, Profile *profile, QStrin
 
 			QFileInfoList files;
 			for (const auto &file : allFiles) {
-				if (!file.fileName().endsWith(".tmp")) {
+				if (!file.fileName().endsWith(".tmp") && !file.fileName().endsWith(".part")) {
 					files.append(file);
 				}
 			}
@@ -403,54 +403,16 @@ int Filename::needExactTags(Site *site, QSettings *settings, const QString &api)
 	return needExactTags(forcedTokens, customTokens);
 }
 int Filename::needExactTags(const QStringList &forcedTokens, const QStringList &customTokens) const
+{
+	return requirements().needExactTags(forcedTokens, customTokens);
+}
+
+FilenameRequirements Filename::requirements() const
 {
 	// Javascript filenames always need tags as we don't know what they might do
 	if (m_format.startsWith("javascript:")) {
-		return 2;
-	}
-
-	const auto &toks = m_ast->tokens();
-
-	// If we need the filename and it is returned from the details page
-	if (toks.contains("filename") && forcedTokens.contains("filename")) {
-		return 2;
-	}
-
-	// If we need the date and it is returned from the details page
-	if (toks.contains("date") && forcedTokens.contains("date")) {
-		return 2;
-	}
-
-	// Some sources require loading to get the tag list
-	if (forcedTokens.contains("tags")) {
-		// The filename use tags
-		static const QStringList forbidden { "tags", "all", "allo", "artist", "copyright", "character", "model", "photo_set", "species", "meta", "general" };
-		for (const QString &token : forbidden) {
-			if (toks.contains(token)) {
-				return 2;
-			}
-		}
-
-		// The filename use custom tokens
-		for (const QString &token : customTokens) {
-			if (toks.contains(token)) {
-				return 2;
-			}
-		}
-	}
-
-	// The filename contains one of the special tags
-	static const QStringList forbidden { "artist", "copyright", "character", "model", "photo_set", "species", "meta", "general" };
-	for (const QString &token : forbidden) {
-		if (toks.contains(token)) {
-			return 1;
-		}
-	}
-
-	// Namespaces come from detailed tags
-	if (m_format.contains("includenamespace")) {
-		return 1;
+		return FilenameRequirements(QSet<QString> { "*" });
 	}
 
-	return 0;
+	return m_ast->requirements();
 }
@@ -10,6 +10,7 @@
 
 
 class AstFilename;
+struct FilenameRequirements;
 class Image;
 class Profile;
 class QSettings;
@@ -52,6 +53,11 @@ class Filename
 
 		int needExactTags(Site *site, QSettings *settings, const QString &api = "") const;
 
+		/**
+		 * The tokens this filename needs to be generated, from a static analysis of its AST.
+		 */
+		FilenameRequirements requirements() const;
+
 		QList<QMap<QString, Token>> expandTokens(QMap<QString, Token> tokens, QSettings *settings) const;
 		int needExactTags(const QStringList &forcedTokens = {}, const QStringList &customTokens = {}) const;
 
@@ -1,8 +1,11 @@
 #include "blacklist.h"
 #include <QStringList>
+#include <algorithm>
 #include "filter.h"
 #include "filter-factory.h"
 #include "functions.h"
+#include "loader/token.h"
+#include "tag-filter.h"
 
 
 Blacklist::Blacklist(const QStringList &tags)
@@ -33,6 +36,7 @@ void Blacklist::add(const QString &tag)
 	auto filter = QSharedPointer<Filter>(FilterFactory::build(tag));
 	if (!filter.isNull()) {
 		m_filters.append({ filter });
+		index(m_filters.count() - 1);
 	}
 }
 
@@ -48,6 +52,7 @@ void Blacklist::add(const QStringList &tags)
 
 	if (!filters.isEmpty()) {
 		m_filters.append(filters);
+		index(m_filters.count() - 1);
 	}
 }
 
@@ -59,9 +64,117 @@ bool Blacklist::remove(const QString &tag)
 	}
 
 	m_filters.removeAt(index);
+	reindex();
 	return true;
 }
 
+/**
+ * Add the rule at the given position to the index, using the first plain tag it requires if any.
+ * Otherwise, it is indexed by the first wildcard pattern one of the image's tags must match.
+ */
+void Blacklist::index(int i)
+{
+	QString wildcard;
+	for (const QSharedPointer<Filter> &filter : qAsConst(m_filters[i])) {
+		const auto *tagFilter = dynamic_cast<const TagFilter*>(filter.data());
+		if (tagFilter != nullptr) {
+			const QString tag = tagFilter->plainTag();
+			if (!tag.isEmpty()) {
+				m_index[tag].append(i);
+				return;
+			}
+			if (wildcard.isEmpty()) {
+				wildcard = tagFilter->wildcardTag();
+			}
+		}
+	}
+
+	if (!wildcard.isEmpty()) {
+		m_wildcardIndex.add(wildcard, i);
+	} else {
+		m_unindexed.append(i);
+	}
+}
+
+void Blacklist::reindex()
+{
+	m_index.clear();
+	m_wildcardIndex.clear();
+	m_unindexed.clear();
+	for (int i = 0; i < m_filters.count(); ++i) {
+		index(i);
+	}
+}
+
+/**
+ * The list of rules that can possibly match the given tokens, in their original order.
+ */
+QList<int> Blacklist::candidates(const QMap<QString, Token> &tokens, bool invert) const
+{
+	// The index is only valid when looking for images containing the tags
+	if (!invert) {
+		QList<int> all;
+		all.reserve(m_filters.count());
+		for (int i = 0; i < m_filters.count(); ++i) {
+			all.append(i);
+		}
+		return all;
+	}
+
+	QList<int> ret = m_unindexed;
+	if (!m_index.isEmpty() || !m_wildcardIndex.isEmpty()) {
+		const auto it = tokens.constFind(QStringLiteral("allos"));
+		if (it != tokens.constEnd()) {
+			const QStringList tags = it.value().value().toStringList();
+			for (const QString &tag : tags) {
+				const auto rules = m_index.constFind(tag);
+				if (rules != m_index.constEnd()) {
+					ret.append(rules.value());
+				}
+				if (!m_wildcardIndex.isEmpty()) {
+					ret.append(m_wildcardIndex.match(tag));
+				}
+			}
+		}
+	}
+
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+/**
+ * A rule is detected when none of its filters match.
+ */
+bool Blacklist::isDetected(const QList<QSharedPointer<Filter>> &filters, const QMap<QString, Token> &tokens, bool invert) const
+{
+	for (const QSharedPointer<Filter> &filter : filters) {
+		if (filter->matches(tokens, invert)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+QStringList Blacklist::plainTags() const
+{
+	QStringList ret;
+	for (const auto &filters : qAsConst(m_filters)) {
+		if (filters.count() != 1) {
+			continue;
+		}
+
+		const auto *tagFilter = dynamic_cast<const TagFilter*>(filters[0].data());
+		if (tagFilter != nullptr) {
+			const QString tag = tagFilter->plainTag();
+			if (!tag.isEmpty() && !tag.contains(':')) {
+				ret.append(tag);
+			}
+		}
+	}
+	return ret;
+}
+
 QString Blacklist::toString() const
 {
 	QString ret;
@@ -82,19 +195,30 @@ QString Blacklist::toString() const
 QStringList Blacklist::match(const QMap<QString, Token> &tokens, bool invert) const
 {
 	QStringList detected;
-	for (const auto &filters : qAsConst(m_filters)) {
-		bool allDetected = true;
+	for (int i : candidates(tokens, invert)) {
+		const auto &filters = m_filters[i];
+		if (!isDetected(filters, tokens, invert)) {
+			continue;
+		}
+
 		QStringList res;
 		for (const QSharedPointer<Filter> &filter : filters) {
-			if (filter->match(tokens, invert).isEmpty()) {
-				allDetected = false;
-				break;
-			}
 			res.append(filter->toString(false));
 		}
-		if (allDetected) {
-			detected.append(res.join(' '));
-		}
+		detected.append(res.join(' '));
 	}
 	return detected;
 }
+
+/**
+ * Faster version of "!match(tokens).isEmpty()", stopping at the first matching rule.
+ */
+bool Blacklist::matches(const QMap<QString, Token> &tokens, bool invert) const
+{
+	for (int i : candidates(tokens, invert)) {
+		if (isDetected(m_filters[i], tokens, invert)) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -1,13 +1,15 @@
 #ifndef BLACKLIST_H
 #define BLACKLIST_H
 
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QSharedPointer>
+#include <QString>
+#include "utils/wildcard-matcher.h"
 
 
 class Filter;
-class QString;
 class QStringList;
 class Token;
 
@@ -23,13 +25,28 @@ class Blacklist
 		bool remove(const QString &tag);
 
 		QString toString() const;
+
+		/**
+		 * The tags of the rules only made of a single plain tag, that can be excluded from searches directly.
+		 */
+		QStringList plainTags() const;
 		QStringList match(const QMap<QString, Token> &tokens, bool invert = true) const;
+		bool matches(const QMap<QString, Token> &tokens, bool invert = true) const;
 
 	protected:
 		int indexOf(const QString &tag) const;
+		void index(int i);
+		void reindex();
+		QList<int> candidates(const QMap<QString, Token> &tokens, bool invert) const;
+		bool isDetected(const QList<QSharedPointer<Filter>> &filters, const QMap<QString, Token> &tokens, bool invert) const;
 
 	private:
 		QList<QList<QSharedPointer<Filter>>> m_filters;
+
+		// Rules indexed by a tag they require, so that only relevant rules are checked for each image
+		QHash<QString, QList<int>> m_index;
+		WildcardMatcher m_wildcardIndex;
+		QList<int> m_unindexed;
 };
 
 #endif // BLACKLIST_H
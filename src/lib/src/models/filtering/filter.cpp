@@ -1,10 +1,27 @@
 #include "filter.h"
+#include <QString>
 
 
 Filter::Filter(bool invert)
 	: m_invert(invert)
 {}
 
+/**
+ * Boolean version of match(), which subclasses can override to avoid building an error message.
+ *
+ * @return Whether match() would return an empty string
+ */
+bool Filter::matches(const QMap<QString, Token> &tokens, bool invert) const
+{
+	return match(tokens, invert).isEmpty();
+}
+
+QString Filter::searchTerm(const QStringList &modifiers) const
+{
+	Q_UNUSED(modifiers);
+	return QString();
+}
+
 
 bool Filter::operator==(const Filter &rhs) const
 {
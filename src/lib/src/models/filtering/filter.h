@@ -5,6 +5,7 @@
 
 
 class QString;
+class QStringList;
 class Token;
 
 class Filter
@@ -15,8 +16,21 @@ class Filter
 	public:
 		virtual ~Filter() = default;
 		virtual QString match(const QMap<QString, Token> &tokens, bool invert = false) const = 0;
+		virtual bool matches(const QMap<QString, Token> &tokens, bool invert = false) const;
 		virtual QString toString(bool escape = true) const = 0;
 
+		/**
+		 * The search term the site can use to do this filtering itself, or an empty string if it can't.
+		 *
+		 * @param modifiers The meta-tags supported by the site's API
+		 */
+		virtual QString searchTerm(const QStringList &modifiers) const;
+
+		/**
+		 * Whether the given tokens contain everything needed to evaluate this filter.
+		 */
+		virtual bool canMatch(const QMap<QString, Token> &tokens) const = 0;
+
 		bool operator==(const Filter &rhs) const;
 		bool operator!=(const Filter &rhs) const;
 		virtual bool compare(const Filter &rhs) const = 0;
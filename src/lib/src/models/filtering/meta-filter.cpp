@@ -1,17 +1,95 @@
 #include "meta-filter.h"
 #include <QDateTime>
-#include <QRegExp>
 #include <QRegularExpression>
 #include <QStringBuilder>
+#include <QStringList>
 #include <QTimeZone>
+#include <limits>
 #include <utility>
 #include "functions.h"
 #include "loader/token.h"
 
 
+static QDateTime stringToDate(const QString &text)
+{
+	QDateTime date = QDateTime::fromString(text, "yyyy-MM-dd");
+	if (date.isValid()) {
+		return date;
+	}
+	date = QDateTime::fromString(text, "MM/dd/yyyy");
+	if (date.isValid()) {
+		return date;
+	}
+	return QDateTime();
+}
+
+/**
+ * Invalid dates are mapped to the lowest value, as QDateTime considers them lower than any valid one.
+ */
+static qint64 dateToEpoch(const QDateTime &date)
+{
+	return date.isValid() ? date.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+}
+
+static qint64 stringToInt(const QString &text)
+{ return text.toLongLong(); }
+static qint64 stringToFloat(const QString &text)
+{ return qRound64(text.toFloat() * 1000); }
+static qint64 stringToFileSize(const QString &text)
+{ return text.isEmpty() ? 0 : parseFileSize(text); }
+
+
 MetaFilter::MetaFilter(QString type, QString val, bool invert)
 	: Filter(invert), m_type(std::move(type)), m_val(std::move(val))
-{}
+{
+	if (m_type == "source") {
+		m_matcher.add(m_val + "*");
+	}
+
+	// Parse the range syntax and convert its bounds once, instead of for every image
+	QString min;
+	QString max;
+	if (m_val.startsWith("..") || m_val.startsWith("<=")) {
+		m_op = RangeOp::LessOrEqual;
+		max = m_val.mid(2);
+	} else if (m_val.endsWith("..")) {
+		m_op = RangeOp::GreaterOrEqual;
+		min = m_val.left(m_val.size() - 2);
+	} else if (m_val.startsWith(">=")) {
+		m_op = RangeOp::GreaterOrEqual;
+		min = m_val.mid(2);
+	} else if (m_val.startsWith("<")) {
+		m_op = RangeOp::Less;
+		max = m_val.mid(1);
+	} else if (m_val.startsWith(">")) {
+		m_op = RangeOp::Greater;
+		min = m_val.mid(1);
+	} else if (m_val.contains("..")) {
+		const int index = m_val.indexOf("..");
+		m_op = RangeOp::Between;
+		min = m_val.left(index);
+		max = m_val.mid(index + 2);
+	} else {
+		m_op = RangeOp::Equal;
+		min = m_val;
+	}
+
+	m_int = Range<qint64> { stringToInt(min), stringToInt(max) };
+	m_score = Range<qint64> { stringToFloat(min), stringToFloat(max) };
+	m_fileSize = Range<qint64> { stringToFileSize(min), stringToFileSize(max) };
+	m_date = Range<qint64> { dateToEpoch(stringToDate(min)), dateToEpoch(stringToDate(max)) };
+	if (m_type == "age") {
+		m_age = Range<Age> { stringToAge(min), stringToAge(max) };
+	}
+
+	static const QMap<QString, QString> ratings
+	{
+		{ "s", "safe" },
+		{ "q", "questionable" },
+		{ "e", "explicit" }
+	};
+	m_rating = ratings.value(m_val, m_val);
+}
 
 QString MetaFilter::toString(bool escape) const
 {
@@ -19,6 +97,23 @@ QString MetaFilter::toString(bool escape) const
 	return QString(m_invert ? "-" : "") % m_type % ":" % m_val;
 }
 
+/**
+ * Only the meta-tags whose values are compared the same way by Grabber and the sites can be done by them.
+ */
+QString MetaFilter::searchTerm(const QStringList &modifiers) const
+{
+	static const QStringList types { "id", "width", "height", "score", "rating", "md5" };
+	if (m_invert || !types.contains(m_type) || m_val.contains(' ')) {
+		return QString();
+	}
+
+	const QString term = toString(false);
+	if (!modifiers.contains(m_type + ":") && !modifiers.contains(term)) {
+		return QString();
+	}
+	return term;
+}
+
 bool MetaFilter::compare(const Filter& rhs) const
 {
 	const auto other = dynamic_cast<const MetaFilter*>(&rhs);
@@ -29,96 +124,73 @@ bool MetaFilter::compare(const Filter& rhs) const
 	return m_type == other->m_type && m_val == other->m_val;
 }
 
-static QDateTime stringToDate(const QString &text)
-{
-	QDateTime date = QDateTime::fromString(text, "yyyy-MM-dd");
-	if (date.isValid()) {
-		return date;
-	}
-	date = QDateTime::fromString(text, "MM/dd/yyyy");
-	if (date.isValid()) {
-		return date;
-	}
-	return QDateTime();
-}
-
-static int stringToInt(const QString &text)
-{ return text.toInt(); }
-static int stringToFloat(const QString &text)
-{ return qRound(text.toFloat() * 1000); }
-static qint64 stringToFileSize(const QString &text)
-{ return parseFileSize(text); }
-
-// FIXME(Bionus): remove globals
-static QDateTime ageToDateImage;
-static QDateTime ageToDateTestNow;
-static QDateTime ageToDate(const QString &text)
+MetaFilter::Age MetaFilter::stringToAge(const QString &text)
 {
 	static const QRegularExpression rx("^(\\d+)(\\w+)$");
 	auto match = rx.match(text);
 	if (!match.hasMatch()) {
-		return QDateTime();
+		return Age();
 	}
 
-	const int count = match.captured(1).toInt();
-	const QString type = match.captured(2);
-
-	// Define "now" with the correct timezone
-	QDateTime base;
-	if (ageToDateTestNow.isValid()) {
-		base = ageToDateTestNow;
-	} else {
-		base = QDateTime::currentDateTimeUtc();
-		base.setTimeZone(ageToDateImage.timeZone());
-	}
+	Age ret;
+	ret.count = match.captured(1).toInt();
 
+	const QString type = match.captured(2);
 	if (type.startsWith("y")) {
-		return base.addYears(-count);
-	}
-	if (type.startsWith("mo")) {
-		return base.addMonths(-count);
-	}
-	if (type.startsWith("w")) {
-		return base.addDays(-(count * 7));
-	}
-	if (type.startsWith("d")) {
-		return base.addDays(-count);
-	}
-	if (type.startsWith("h")) {
-		return base.addSecs(-(count * 60 * 60));
-	}
-	if (type.startsWith("mi")) {
-		return base.addSecs(-(count * 60));
-	}
-	if (type.startsWith("s")) {
-		return base.addSecs(-count);
+		ret.unit = 'y';
+	} else if (type.startsWith("mo")) {
+		ret.unit = 'M';
+	} else if (type.startsWith("w")) {
+		ret.unit = 'w';
+	} else if (type.startsWith("d")) {
+		ret.unit = 'd';
+	} else if (type.startsWith("h")) {
+		ret.unit = 'h';
+	} else if (type.startsWith("mi")) {
+		ret.unit = 'm';
+	} else if (type.startsWith("s")) {
+		ret.unit = 's';
 	}
 
-	return QDateTime();
+	return ret;
 }
 
-template <typename T>
-static bool rangeCheck(T (*converter)(const QString &), T input, const QString &val)
+static QDateTime ageToDate(char unit, int count, const QDateTime &base)
 {
-	if (val.startsWith("..") || val.startsWith("<=")) {
-		return input <= converter(val.right(val.size() - 2));
-	}
-	if (val.endsWith("..")) {
-		return input >= converter(val.left(val.size() - 2));
-	}
-	if (val.startsWith(">=")) {
-		return input >= converter(val.right(val.size() - 2));
-	}
-	if (val.startsWith("<")) {
-		return input < converter(val.right(val.size() - 1));
+	switch (unit) {
+		case 'y': return base.addYears(-count);
+		case 'M': return base.addMonths(-count);
+		case 'w': return base.addDays(-(count * 7));
+		case 'd': return base.addDays(-count);
+		case 'h': return base.addSecs(-(count * 60 * 60));
+		case 'm': return base.addSecs(-(count * 60));
+		case 's': return base.addSecs(-count);
+		default: return QDateTime();
 	}
-	if (val.startsWith(">")) {
-		return input > converter(val.right(val.size() - 1));
+}
+
+template <typename T>
+bool MetaFilter::inRange(const Range<T> &range, T input) const
+{
+	switch (m_op) {
+		case RangeOp::Less: return input < range.max;
+		case RangeOp::LessOrEqual: return input <= range.max;
+		case RangeOp::Greater: return input > range.min;
+		case RangeOp::GreaterOrEqual: return input >= range.min;
+		case RangeOp::Between: return input >= range.min && input <= range.max;
+		default: return input == range.min;
 	}
-	if (val.contains("..")) {
-		return input >= converter(val.left(val.indexOf(".."))) && input <= converter(val.right(val.size() - val.indexOf("..") - 2));
+}
+
+/**
+ * Grabber specials and ages depend on more than the token of the filter's type.
+ */
+bool MetaFilter::canMatch(const QMap<QString, Token> &tokens) const
+{
+	if (m_type == QLatin1String("grabber") || m_type == QLatin1String("age")) {
+		return false;
 	}
-	return input == converter(val);
+	return tokens.contains(m_type);
 }
 
 QString MetaFilter::match(const QMap<QString, Token> &tokens, bool invert) const
@@ -149,9 +221,19 @@ QString MetaFilter::match(const QMap<QString, Token> &tokens, bool invert) const
 		}
 
 		const QDateTime &date = tokens["date"].value().toDateTime();
-		ageToDateImage = date;
-		ageToDateTestNow = tokens["TESTS_now"].value().toDateTime();
-		const bool cond = rangeCheck(ageToDate, date, m_val);
+
+		// Define "now" with the correct timezone
+		QDateTime base = tokens.value("TESTS_now").value().toDateTime();
+		if (!base.isValid()) {
+			base = QDateTime::currentDateTimeUtc();
+			base.setTimeZone(date.timeZone());
+		}
+
+		const Range<qint64> range {
+			dateToEpoch(ageToDate(m_age.min.unit, m_age.min.count, base)),
+			dateToEpoch(ageToDate(m_age.max.unit, m_age.max.count, base))
+		};
+		const bool cond = inRange(range, dateToEpoch(date));
 
 		if (cond && !invert) {
 			return QObject::tr("image's %1 does not match").arg(m_type);
@@ -171,26 +253,15 @@ QString MetaFilter::match(const QMap<QString, Token> &tokens, bool invert) const
 
 	const QVariant &token = tokens[m_type].value();
 	if (token.type() == QVariant::Int || token.type() == QVariant::UInt || token.type() == QVariant::DateTime || token.type() == QVariant::LongLong || token.type() == QVariant::ULongLong || m_type == "score") {
-		int input = 0;
-		if (token.type() == QVariant::Int) {
-			input = token.toInt();
-		} else if (token.type() == QVariant::UInt) {
-			input = token.toUInt();
-		} else if (token.type() == QVariant::LongLong) {
-			input = token.toLongLong();
-		} else if (token.type() == QVariant::ULongLong) {
-			input = token.toULongLong();
-		}
-
 		bool cond;
 		if (token.type() == QVariant::DateTime) {
-			cond = rangeCheck(stringToDate, token.toDateTime(), m_val);
+			cond = inRange(m_date, dateToEpoch(token.toDateTime()));
 		} else if (m_type == "score") {
-			cond = rangeCheck(stringToFloat, qRound(token.toFloat() * 1000), m_val);
+			cond = inRange(m_score, qRound64(token.toFloat() * 1000));
 		} else if (m_type == "filesize") {
-			cond = rangeCheck(stringToFileSize, token.toLongLong(), m_val);
+			cond = inRange(m_fileSize, token.toLongLong());
 		} else {
-			cond = rangeCheck(stringToInt, input, m_val);
+			cond = inRange(m_int, token.toLongLong());
 		}
 
 		if (!cond && !invert) {
@@ -201,23 +272,15 @@ QString MetaFilter::match(const QMap<QString, Token> &tokens, bool invert) const
 		}
 	} else {
 		if (m_type == "rating") {
-			QMap<QString, QString> assoc;
-			assoc["s"] = "safe";
-			assoc["q"] = "questionable";
-			assoc["e"] = "explicit";
-
-			const QString val = assoc.contains(m_val) ? assoc[m_val] : m_val;
-
-			const bool cond = !val.isEmpty() && token.toString().toLower().startsWith(val.at(0));
+			const bool cond = !m_rating.isEmpty() && token.toString().toLower().startsWith(m_rating.at(0));
 			if (!cond && !invert) {
-				return QObject::tr("image is not \"%1\"").arg(val);
+				return QObject::tr("image is not \"%1\"").arg(m_rating);
 			}
 			if (cond && invert) {
-				return QObject::tr("image is \"%1\"").arg(val);
+				return QObject::tr("image is \"%1\"").arg(m_rating);
 			}
 		} else if (m_type == "source") {
-			QRegExp rx(m_val + "*", Qt::CaseInsensitive, QRegExp::Wildcard);
-			const bool cond = rx.exactMatch(token.toString());
+			const bool cond = m_matcher.matches(token.toString());
 			if (!cond && !invert) {
 				return QObject::tr("image's source does not starts with \"%1\"").arg(m_val);
 			}
@@ -4,6 +4,7 @@
 #include <QMap>
 #include <QString>
 #include "filter.h"
+#include "utils/wildcard-matcher.h"
 
 
 class Token;
@@ -14,11 +15,54 @@ class MetaFilter : public Filter
 		MetaFilter(QString type, QString val, bool invert = false);
 		QString match(const QMap<QString, Token> &tokens, bool invert = false) const override;
 		QString toString(bool escape = true) const override;
+		QString searchTerm(const QStringList &modifiers) const override;
 		bool compare(const Filter &rhs) const override;
+		bool canMatch(const QMap<QString, Token> &tokens) const override;
+
+	protected:
+		enum class RangeOp
+		{
+			Equal,
+			Less,
+			LessOrEqual,
+			Greater,
+			GreaterOrEqual,
+			Between,
+		};
+
+		template <typename T>
+		struct Range
+		{
+			T min;
+			T max;
+		};
+
+		/**
+		 * An age operand such as "3days", the unit being one of "yMwdhms" (0 if invalid).
+		 */
+		struct Age
+		{
+			int count = 0;
+			char unit = 0;
+		};
+
+		static Age stringToAge(const QString &text);
+		template <typename T>
+		bool inRange(const Range<T> &range, T input) const;
 
 	private:
 		QString m_type;
 		QString m_val;
+		WildcardMatcher m_matcher;
+
+		// Operands parsed once at construction, dates being stored as milliseconds since epoch
+		RangeOp m_op = RangeOp::Equal;
+		Range<qint64> m_int;
+		Range<qint64> m_score;
+		Range<qint64> m_fileSize;
+		Range<qint64> m_date;
+		Range<Age> m_age;
+		QString m_rating;
 };
 
 #endif // META_FILTER_H
@@ -2,6 +2,7 @@
 #include <QStringList>
 #include "filter.h"
 #include "filter-factory.h"
+#include "loader/token.h"
 
 
 PostFilter::PostFilter(const QStringList &filters)
@@ -30,3 +31,51 @@ QStringList PostFilter::match(const QMap<QString, Token> &tokens) const
 	}
 	return ret;
 }
+
+QStringList PostFilter::matchAvailable(const QMap<QString, Token> &tokens) const
+{
+	QStringList ret;
+	for (const auto &filter : m_filters) {
+		if (!filter->canMatch(tokens)) {
+			continue;
+		}
+		QString err = filter->match(tokens);
+		if (!err.isEmpty()) {
+			ret.append(err);
+		}
+	}
+	return ret;
+}
+
+bool PostFilter::needs(const QMap<QString, Token> &tokens, const QStringList &names) const
+{
+	QMap<QString, Token> without = tokens;
+	for (const QString &name : names) {
+		without.remove(name);
+	}
+
+	for (const auto &filter : m_filters) {
+		if (filter->canMatch(tokens) && !filter->canMatch(without)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+PostFilter PostFilter::pushDown(QStringList &search, const QStringList &modifiers, int tagLimit) const
+{
+	PostFilter ret;
+	for (const auto &filter : m_filters) {
+		const QString term = filter->searchTerm(modifiers);
+		if (term.isEmpty()) {
+			ret.m_filters.append(filter);
+		} else if (!search.contains(term, Qt::CaseInsensitive)) {
+			if (tagLimit > 0 && search.count() >= tagLimit) {
+				ret.m_filters.append(filter);
+			} else {
+				search.append(term);
+			}
+		}
+	}
+	return ret;
+}
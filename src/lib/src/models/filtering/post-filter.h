@@ -18,6 +18,26 @@ class PostFilter
 		int count() const;
 		QStringList match(const QMap<QString, Token> &tokens) const;
 
+		/**
+		 * Same as match(), but only using the filters that can be evaluated with the given partial tokens.
+		 */
+		QStringList matchAvailable(const QMap<QString, Token> &tokens) const;
+
+		/**
+		 * Whether some of the filters can't be evaluated anymore once the given tokens are removed.
+		 */
+		bool needs(const QMap<QString, Token> &tokens, const QStringList &names) const;
+
+		/**
+		 * Move the filters that the site can do itself into the search, so that they don't waste results.
+		 *
+		 * @param search The search terms, to which the filters' equivalent terms are appended
+		 * @param modifiers The meta-tags supported by the site's API
+		 * @param tagLimit The maximum number of terms in the search, or 0 for no limit
+		 * @return The filters that still need to be applied after loading the results
+		 */
+		PostFilter pushDown(QStringList &search, const QStringList &modifiers, int tagLimit = 0) const;
+
 	private:
 		QList<QSharedPointer<Filter>> m_filters;
 };
@@ -1,14 +1,13 @@
 #include "tag-filter-list.h"
-#include <QRegExp>
 #include "tags/tag.h"
 
 
 void TagFilterList::add(const QString &word)
 {
 	if (word.contains('*')) {
-		m_starTags.append(QRegExp(word, Qt::CaseInsensitive, QRegExp::Wildcard));
+		m_starTags.add(word);
 	} else {
-		m_rawTags.append(word);
+		m_rawTags.insert(word);
 	}
 }
 
@@ -30,18 +29,7 @@ QList<Tag> TagFilterList::filterTags(const QList<Tag> &tags) const
 	QList<Tag> ret;
 
 	for (const Tag &tag : tags) {
-		if (m_rawTags.contains(tag.text())) {
-			continue;
-		}
-
-		bool removed = false;
-		for (const QRegExp &reg : m_starTags) {
-			if (reg.exactMatch(tag.text())) {
-				removed = true;
-				break;
-			}
-		}
-		if (!removed) {
+		if (!m_rawTags.contains(tag.text()) && !m_starTags.matches(tag.text())) {
 			ret.append(tag);
 		}
 	}
@@ -2,11 +2,12 @@
 #define TAG_FILTER_LIST_H
 
 #include <QList>
+#include <QSet>
+#include <QString>
 #include <QStringList>
+#include "utils/wildcard-matcher.h"
 
 
-class QRegExp;
-class QString;
 class Tag;
 
 class TagFilterList
@@ -19,8 +20,8 @@ class TagFilterList
 		QList<Tag> filterTags(const QList<Tag> &tags) const;
 
 	private:
-		QStringList m_rawTags;
-		QList<QRegExp> m_starTags;
+		QSet<QString> m_rawTags;
+		WildcardMatcher m_starTags;
 };
 
 #endif // TAG_FILTER_LIST_H
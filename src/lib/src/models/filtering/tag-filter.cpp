@@ -1,15 +1,15 @@
 #include "tag-filter.h"
-#include <QRegExp>
 #include <QStringBuilder>
+#include <QStringList>
 #include <utility>
 #include "loader/token.h"
 
 
 TagFilter::TagFilter(QString tag, bool invert)
-	: Filter(invert), m_tag(std::move(tag))
+	: Filter(invert), m_tag(std::move(tag)), m_wildcard(m_tag.contains('*'))
 {
-	if (m_tag.contains('*')) {
-		m_regexp.reset(new QRegExp(m_tag, Qt::CaseInsensitive, QRegExp::Wildcard));
+	if (m_wildcard) {
+		m_matcher.add(m_tag);
 	}
 }
 
@@ -18,6 +18,17 @@ QString TagFilter::toString(bool escape) const
 	return QString(m_invert ? "-" : "") % (escape ? QString(m_tag).replace(":", "::") : m_tag);
 }
 
+/**
+ * Plain tags are supported by all sites, but the tag must not be mistaken for a meta-tag.
+ */
+QString TagFilter::searchTerm(const QStringList &modifiers) const
+{
+	if (m_wildcard || m_tag.contains(':') || m_tag.contains(' ') || modifiers.isEmpty()) {
+		return QString();
+	}
+	return toString(false);
+}
+
 bool TagFilter::compare(const Filter& rhs) const
 {
 	const auto other = dynamic_cast<const TagFilter*>(&rhs);
@@ -28,23 +39,60 @@ bool TagFilter::compare(const Filter& rhs) const
 	return m_tag == other->m_tag;
 }
 
-QString TagFilter::match(const QMap<QString, Token> &tokens, bool invert) const
+/**
+ * The tag that an image must have to match this filter, if it is a non-inverted filter without wildcards.
+ */
+QString TagFilter::plainTag() const
 {
-	if (m_invert) {
-		invert = !invert;
+	if (m_invert || m_wildcard) {
+		return QString();
 	}
+	return m_tag;
+}
 
-	const QStringList &tags = tokens["allos"].value().toStringList();
+/**
+ * The wildcard pattern that one of the image's tags must match to match this filter, if it is a non-inverted wildcard filter.
+ */
+QString TagFilter::wildcardTag() const
+{
+	if (m_invert || !m_wildcard) {
+		return QString();
+	}
+	return m_tag;
+}
+
+bool TagFilter::imageContains(const QMap<QString, Token> &tokens) const
+{
+	const auto it = tokens.constFind(QStringLiteral("allos"));
+	if (it == tokens.constEnd()) {
+		return false;
+	}
+	const QStringList tags = it.value().value().toStringList();
 
 	// Check if any tag match the filter (case insensitive plain text with wildcards allowed)
-	bool cond = false;
+	if (!m_wildcard) {
+		return tags.contains(m_tag);
+	}
 	for (const QString &tag : tags) {
-		const bool match = m_regexp.isNull() ? tag == m_tag : m_regexp->exactMatch(tag);
-		if (match) {
-			cond = true;
-			break;
+		if (m_matcher.matches(tag)) {
+			return true;
 		}
 	}
+	return false;
+}
+
+bool TagFilter::canMatch(const QMap<QString, Token> &tokens) const
+{
+	return tokens.contains(QStringLiteral("allos"));
+}
+
+QString TagFilter::match(const QMap<QString, Token> &tokens, bool invert) const
+{
+	if (m_invert) {
+		invert = !invert;
+	}
+
+	const bool cond = imageContains(tokens);
 
 	if (!cond && !invert) {
 		return QObject::tr("image does not contains \"%1\"").arg(m_tag);
@@ -55,3 +103,12 @@ QString TagFilter::match(const QMap<QString, Token> &tokens, bool invert) const
 
 	return QString();
 }
+
+bool TagFilter::matches(const QMap<QString, Token> &tokens, bool invert) const
+{
+	if (m_invert) {
+		invert = !invert;
+	}
+
+	return imageContains(tokens) != invert;
+}
@@ -2,24 +2,31 @@
 #define TAG_FILTER_H
 
 #include <QMap>
-#include <QScopedPointer>
 #include <QString>
 #include "filter.h"
+#include "utils/wildcard-matcher.h"
 
 
-class QRegExp;
-
 class TagFilter : public Filter
 {
 	public:
 		explicit TagFilter(QString tag, bool invert = false);
 		QString match(const QMap<QString, Token> &tokens, bool invert = false) const override;
+		bool matches(const QMap<QString, Token> &tokens, bool invert = false) const override;
 		QString toString(bool escape = true) const override;
+		QString searchTerm(const QStringList &modifiers) const override;
 		bool compare(const Filter &rhs) const override;
+		bool canMatch(const QMap<QString, Token> &tokens) const override;
+		QString plainTag() const;
+		QString wildcardTag() const;
+
+	protected:
+		bool imageContains(const QMap<QString, Token> &tokens) const;
 
 	private:
 		QString m_tag;
-		QScopedPointer<QRegExp> m_regexp;
+		bool m_wildcard;
+		WildcardMatcher m_matcher;
 };
 
 #endif // TAG_FILTER_H
@@ -25,6 +25,11 @@ bool TokenFilter::compare(const Filter &rhs) const
 	return m_token == other->m_token;
 }
 
+bool TokenFilter::canMatch(const QMap<QString, Token> &tokens) const
+{
+	return tokens.contains(m_token);
+}
+
 QString TokenFilter::match(const QMap<QString, Token> &tokens, bool invert) const
 {
 	if (m_invert) {
@@ -42,3 +47,15 @@ QString TokenFilter::match(const QMap<QString, Token> &tokens, bool invert) cons
 
 	return QString();
 }
+
+bool TokenFilter::matches(const QMap<QString, Token> &tokens, bool invert) const
+{
+	if (m_invert) {
+		invert = !invert;
+	}
+
+	const auto it = tokens.constFind(m_token);
+	const bool cond = it != tokens.constEnd() && !isVariantEmpty(it.value().value());
+
+	return cond != invert;
+}
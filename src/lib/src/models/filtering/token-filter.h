@@ -13,8 +13,10 @@ class TokenFilter : public Filter
 	public:
 		explicit TokenFilter(QString token, bool invert = false);
 		QString match(const QMap<QString, Token> &tokens, bool invert = false) const override;
+		bool matches(const QMap<QString, Token> &tokens, bool invert = false) const override;
 		QString toString(bool escape = true) const override;
 		bool compare(const Filter &rhs) const override;
+		bool canMatch(const QMap<QString, Token> &tokens) const override;
 
 	private:
 		QString m_token;
@@ -9,6 +9,7 @@
 #include <QVariantMap>
 #include <utility>
 #include "functions.h"
+#include "loader/token.h"
 #include "models/image.h"
 #include "models/page.h"
 #include "models/profile.h"
@@ -19,12 +20,32 @@
 
 QSharedPointer<Image> ImageFactory::build(Site *site, QMap<QString, QString> details, Profile *profile, Page *parent)
 {
-	return ImageFactory::build(site, std::move(details), QVariantMap(), profile, parent);
+	return ImageFactory::build(site, std::move(details), QVariantMap(), QList<Tag>(), profile, parent);
 }
 
 QSharedPointer<Image> ImageFactory::build(Site *site, QMap<QString, QString> details, QVariantMap data, Profile *profile, Page *parent)
 {
-	static QList<QPair<QString, vTransformToken>> transforms
+	return ImageFactory::build(site, std::move(details), std::move(data), QList<Tag>(), profile, parent);
+}
+
+QSharedPointer<Image> ImageFactory::build(Site *site, QMap<QString, QString> details, QVariantMap data, QList<Tag> tags, Profile *profile, Page *parent)
+{
+	ImageFactoryData parsed = parse(details, std::move(data), std::move(tags));
+	return build(site, details, std::move(parsed), profile, parent);
+}
+
+QSharedPointer<Image> ImageFactory::build(Site *site, const QMap<QString, QString> &details, ImageFactoryData parsed, Profile *profile, Page *parent)
+{
+	if (parsed.hasTags) {
+		parsed.data.insert("tags", QVariant::fromValue(parsed.tags));
+	}
+
+	return QSharedPointer<Image>(new Image(site, details, parsed.data, profile, parent));
+}
+
+ImageFactoryData ImageFactory::parse(QMap<QString, QString> &details, QVariantMap data, QList<Tag> tags)
+{
+	static const QList<QPair<QString, vTransformToken>> transforms
 	{
 		{ "parent_id", ImageFactory::parseInt("parentid") },
 		{ "creator_id", ImageFactory::parseInt("authorid") },
@@ -47,54 +68,112 @@ QSharedPointer<Image> ImageFactory::build(Site *site, QMap<QString, QString> det
 		{ "date", &ImageFactory::parseDate },
 	};
 
+	ImageFactoryData parsed;
+	parsed.data = std::move(data);
+	parsed.tags = std::move(tags);
+	parsed.hasTags = !parsed.tags.isEmpty();
+
+	// Tags given in the data are only converted from a QVariant once
+	const auto dataTags = parsed.data.find("tags");
+	if (dataTags != parsed.data.end()) {
+		if (!parsed.hasTags) {
+			parsed.tags = dataTags.value().value<QList<Tag>>();
+			parsed.hasTags = true;
+		}
+		parsed.data.erase(dataTags);
+	}
+
 	for (const auto &transform : transforms) {
 		const auto &key = transform.first;
-		if (details.contains(key) && !data.contains(key) && !details[key].isEmpty()) {
-			const auto &f = transform.second;
-			f(details[key], data);
-			details.remove(key);
+		const auto it = details.find(key);
+		if (it == details.end() || it.value().isEmpty()) {
+			continue;
 		}
+		if (key == QLatin1String("tags") ? parsed.hasTags : parsed.data.contains(key)) {
+			continue;
+		}
+
+		transform.second(it.value(), parsed);
+		details.erase(it);
 	}
 
-	return QSharedPointer<Image>(new Image(site, details, data, profile, parent));
+	return parsed;
+}
+
+/**
+ * Only the values actually returned by the listing are set, so that filters on missing ones are not evaluated.
+ */
+QMap<QString, Token> ImageFactory::listingTokens(const QMap<QString, QString> &details, const ImageFactoryData &parsed)
+{
+	QMap<QString, Token> ret;
+
+	static const QStringList detailsKeys { "md5", "width", "height" };
+	for (const QString &key : detailsKeys) {
+		const QString val = details.value(key);
+		if (!val.isEmpty()) {
+			ret.insert(key, key == QLatin1String("md5") ? Token(val) : Token(val.toInt()));
+		}
+	}
+	if (!details.value("id").isEmpty()) {
+		ret.insert("id", Token(details.value("id").toULongLong()));
+	}
+
+	static const QStringList dataKeys { "rating", "score" };
+	for (const QString &key : dataKeys) {
+		const auto it = parsed.data.constFind(key);
+		if (it != parsed.data.constEnd() && !it.value().toString().isEmpty()) {
+			ret.insert(key, Token(it.value()));
+		}
+	}
+
+	if (parsed.hasTags) {
+		QStringList allos;
+		allos.reserve(parsed.tags.count());
+		for (const Tag &tag : parsed.tags) {
+			allos.append(QString(tag.text()).replace(' ', '_'));
+		}
+		ret.insert("allos", Token(allos));
+	}
+
+	return ret;
 }
 
 
 vTransformToken ImageFactory::parseString(const QString &key)
 {
-	return [key](const QString &val, QVariantMap &data) {
-		data[key] = val;
+	return [key](const QString &val, ImageFactoryData &data) {
+		data.data[key] = val;
 	};
 }
 
 vTransformToken ImageFactory::parseInt(const QString &key)
 {
-	return [key](const QString &val, QVariantMap &data) {
-		data[key] = val.toInt();
+	return [key](const QString &val, ImageFactoryData &data) {
+		data.data[key] = val.toInt();
 	};
 }
 
 vTransformToken ImageFactory::parseBool(const QString &key)
 {
-	return [key](const QString &val, QVariantMap &data) {
-		data[key] = val == "true";
+	return [key](const QString &val, ImageFactoryData &data) {
+		data.data[key] = val == "true";
 	};
 }
 
 
-void ImageFactory::parseCreatedAt(const QString &val, QVariantMap &data)
+void ImageFactory::parseCreatedAt(const QString &val, ImageFactoryData &data)
 {
-	data["date"] = qDateTimeFromString(val);
-	data["date_raw"] = val;
+	data.data["date"] = qDateTimeFromString(val);
+	data.data["date_raw"] = val;
 }
 
-void ImageFactory::parseDate(const QString &val, QVariantMap &data)
+void ImageFactory::parseDate(const QString &val, ImageFactoryData &data)
 {
-	data["date"] = QDateTime::fromString(val, Qt::ISODate);
-	data["date_raw"] = val;
+	data.data["date"] = QDateTime::fromString(val, Qt::ISODate);
+	data.data["date_raw"] = val;
 }
 
-void ImageFactory::parseRating(const QString &val, QVariantMap &data)
+void ImageFactory::parseRating(const QString &val, ImageFactoryData &data)
 {
 	static const QMap<QString, QString> assoc
 	{
@@ -103,43 +182,36 @@ void ImageFactory::parseRating(const QString &val, QVariantMap &data)
 		{ "e", "explicit" }
 	};
 
-	data["rating"] = assoc.contains(val)
+	data.data["rating"] = assoc.contains(val)
 		? assoc[val]
 		: val.toLower();
 }
 
 vTransformToken ImageFactory::parseTypedTags(const QString &type)
 {
-	return [type](const QString &val, QVariantMap &data) {
-		if (!data.contains("tags")) {
-			data.insert("tags", QVariant::fromValue(QList<Tag>()));
-		}
-		QList<Tag> tagList = data["tags"].value<QList<Tag>>();
+	const TagType tagType(type);
+	return [tagType](const QString &val, ImageFactoryData &data) {
+		data.hasTags = true;
 
-		const TagType tagType(type);
-		QStringList tags = val.split(' ', Qt::SkipEmptyParts);
+		const QStringList tags = val.split(' ', Qt::SkipEmptyParts);
+		data.tags.reserve(data.tags.count() + tags.count());
 		for (QString tag : tags) {
 			tag.replace("&amp;", "&");
-			tagList.append(Tag(tag, tagType));
+			data.tags.append(Tag(tag, tagType));
 		}
-
-		data.insert("tags", QVariant::fromValue(tagList));
 	};
 }
 
-void ImageFactory::parseTags(const QString &val, QVariantMap &data)
+void ImageFactory::parseTags(const QString &val, ImageFactoryData &data)
 {
-	if (!data.contains("tags")) {
-		data.insert("tags", QVariant::fromValue(QList<Tag>()));
-	}
-	QList<Tag> tagList = data["tags"].value<QList<Tag>>();
-
-	if (!tagList.isEmpty()) {
+	data.hasTags = true;
+	if (!data.tags.isEmpty()) {
 		return;
 	}
 
+	static const QRegularExpression rxWhitespace("[\r\n\t]+");
 	QString raw = val;
-	raw.replace(QRegularExpression("[\r\n\t]+"), " ");
+	raw.replace(rxWhitespace, " ");
 
 	// Automatically find tag separator and split the list
 	const int commas = raw.count(", ");
@@ -148,6 +220,7 @@ void ImageFactory::parseTags(const QString &val, QVariantMap &data)
 		? raw.split(", ", Qt::SkipEmptyParts)
 		: raw.split(" ", Qt::SkipEmptyParts);
 
+	data.tags.reserve(tags.count());
 	for (QString tg : tags) {
 		tg.replace("&amp;", "&");
 
@@ -155,9 +228,9 @@ void ImageFactory::parseTags(const QString &val, QVariantMap &data)
 		if (colon != -1) {
 			const QString tp = tg.left(colon).toLower();
 			if (tp == "user") {
-				data["author"] = tg.mid(colon + 1);
+				data.data["author"] = tg.mid(colon + 1);
 			} else if (tp == "score") {
-				data["score"] = tg.mid(colon + 1).toInt();
+				data.data["score"] = tg.mid(colon + 1).toInt();
 			} else if (tp == "size") {
 				/*QStringList size = tg.mid(colon + 1).split('x');
 				if (size.size() == 2) {
@@ -166,12 +239,10 @@ void ImageFactory::parseTags(const QString &val, QVariantMap &data)
 			} else if (tp == "rating") {
 				parseRating(tg.mid(colon + 1), data);
 			} else {
-				tagList.append(Tag(tg));
+				data.tags.append(Tag(tg));
 			}
 		} else {
-			tagList.append(Tag(tg));
+			data.tags.append(Tag(tg));
 		}
 	}
-
-	data.insert("tags", QVariant::fromValue(tagList));
 }
@@ -2,35 +2,61 @@
 #define IMAGE_FACTORY_H
 
 #include <functional>
+#include <QList>
 #include <QMap>
 #include <QSharedPointer>
 #include <QString>
 #include <QVariantMap>
+#include "tags/tag.h"
 
 
 class Image;
 class Page;
 class Profile;
 class Site;
+class Token;
 
-typedef std::function<void (const QString &val, QVariantMap &data)> vTransformToken;
+/**
+ * Values parsed from an image's details, the tags being kept typed until the image is built instead of being
+ * converted to and from a QVariant for each tag field.
+ */
+struct ImageFactoryData
+{
+	QVariantMap data;
+	QList<Tag> tags;
+	bool hasTags = false;
+};
+
+typedef std::function<void (const QString &val, ImageFactoryData &data)> vTransformToken;
 
 class ImageFactory
 {
 	public:
 		static QSharedPointer<Image> build(Site *site, QMap<QString, QString> details, Profile *profile, Page *parent = nullptr);
 		static QSharedPointer<Image> build(Site *site, QMap<QString, QString> details, QVariantMap data, Profile *profile, Page *parent = nullptr);
+		static QSharedPointer<Image> build(Site *site, QMap<QString, QString> details, QVariantMap data, QList<Tag> tags, Profile *profile, Page *parent = nullptr);
+		static QSharedPointer<Image> build(Site *site, const QMap<QString, QString> &details, ImageFactoryData parsed, Profile *profile, Page *parent = nullptr);
+
+		/**
+		 * Parse the listing values of an image, the details used being removed from the map.
+		 */
+		static ImageFactoryData parse(QMap<QString, QString> &details, QVariantMap data, QList<Tag> tags);
+
+		/**
+		 * The tokens that can be known from the listing values alone, before building the image.
+		 */
+		static QMap<QString, Token> listingTokens(const QMap<QString, QString> &details, const ImageFactoryData &parsed);
 
 	private:
 		static vTransformToken parseString(const QString &key);
 		static vTransformToken parseInt(const QString &key);
 		static vTransformToken parseBool(const QString &key);
 
-		static void parseCreatedAt(const QString &val, QVariantMap &data);
-		static void parseDate(const QString &val, QVariantMap &data);
-		static void parseRating(const QString &val, QVariantMap &data);
+		static void parseCreatedAt(const QString &val, ImageFactoryData &data);
+		static void parseDate(const QString &val, ImageFactoryData &data);
+		static void parseRating(const QString &val, ImageFactoryData &data);
 		static vTransformToken parseTypedTags(const QString &type);
-		static void parseTags(const QString &val, QVariantMap &data);
+		static void parseTags(const QString &val, ImageFactoryData &data);
 };
 
 #endif // IMAGE_FACTORY_H
@@ -1,13 +1,19 @@
 #include "image-size.h"
-#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonObject>
+#include "functions.h"
 #include "logger.h"
+#include "utils/file-utils.h"
+#include "utils/memory-budget.h"
 
 
 ImageSize::~ImageSize()
 {
+	if (m_memoryId != 0) {
+		MemoryBudget::getInstance().remove(m_memoryId);
+	}
+
 	if (!m_temporaryPath.isEmpty()) {
 		log(QStringLiteral("Deleting temporary file `%1`").arg(m_temporaryPath));
 		QFile::remove(m_temporaryPath);
@@ -30,7 +36,7 @@ QString ImageSize::save(const QString &path)
 
 		// Try to rename, otherwise fallback to a copy
 		if (!file.rename(path)) {
-			file.copy(path);
+			copyFile(m_temporaryPath, path);
 		} else {
 			m_temporaryPath.clear();
 		}
@@ -41,7 +47,7 @@ QString ImageSize::save(const QString &path)
 
 	// If we already saved this image somewhere, simply make a copy of this file
 	if (!m_savePath.isEmpty() && QFile::exists(m_savePath)) {
-		QFile(m_savePath).copy(path);
+		copyFile(m_savePath, path);
 		return m_savePath;
 	}
 
@@ -88,11 +94,17 @@ bool ImageSize::setSavePath(const QString &path)
 
 QPixmap ImageSize::pixmap() const
 {
+	if (m_memoryId != 0) {
+		MemoryBudget::getInstance().touch(m_memoryId);
+	}
 	return m_pixmap;
 }
 
 const QPixmap &ImageSize::pixmap()
 {
+	if (m_memoryId != 0) {
+		MemoryBudget::getInstance().touch(m_memoryId);
+	}
 	return m_pixmap;
 }
 
@@ -101,28 +113,54 @@ void ImageSize::setPixmap(const QPixmap &pixmap)
 	m_pixmap = !rect.isNull()
 		? pixmap.copy(rect)
 		: pixmap;
+
+	// Register the pixmap in the memory budget, so that it can be freed when it was not used for a while
+	MemoryBudget &budget = MemoryBudget::getInstance();
+	if (m_pixmap.isNull()) {
+		if (m_memoryId != 0) {
+			budget.remove(m_memoryId);
+			m_memoryId = 0;
+		}
+		return;
+	}
+
+	const qint64 bytes = static_cast<qint64>(m_pixmap.width()) * m_pixmap.height() * m_pixmap.depth() / 8;
+	if (m_memoryId != 0) {
+		budget.resize(m_memoryId, bytes);
+	} else {
+		const quint64 id = budget.add(QStringLiteral("pixmaps"), bytes, [this]() {
+			m_pixmap = QPixmap();
+			m_memoryId = 0;
+		});
+
+		// It might have been evicted right away if it is bigger than the whole budget
+		m_memoryId = m_pixmap.isNull() ? 0 : id;
+	}
 }
 
 
 QString ImageSize::md5() const
 {
+	// Files that can't be read are not given the MD5 of an empty file, so that it can be computed again later
 	if (m_md5.isEmpty()) {
 		const QString path = !m_savePath.isEmpty() ? m_savePath : m_temporaryPath;
 		if (!path.isEmpty()) {
-			QCryptographicHash hash(QCryptographicHash::Md5);
-
-			QFile f(path);
-			f.open(QFile::ReadOnly);
-			hash.addData(&f);
-			f.close();
-
-			m_md5 = hash.result().toHex();
+			m_md5 = getFileMd5(path);
 		}
 	}
 
 	return m_md5;
 }
 
+/**
+ * Set the MD5 of the file when it is already known, to prevent having to read the file again to compute it.
+ * An empty MD5 means that it will be computed from the file the next time it is needed.
+ */
+void ImageSize::setMd5(const QString &md5)
+{
+	m_md5 = md5;
+}
+
 
 void ImageSize::read(const QJsonObject &json)
 {
@@ -31,6 +31,7 @@ struct ImageSize
 
 	// MD5 calculation
 	QString md5() const;
+	void setMd5(const QString &md5);
 
 	// Serialization
 	void read(const QJsonObject &json);
@@ -41,6 +42,7 @@ struct ImageSize
 		QString m_savePath;
 		QPixmap m_pixmap;
 		QString mutable m_md5;
+		quint64 m_memoryId = 0;
 };
 
 #endif // IMAGE_SIZE_H
@@ -2,6 +2,7 @@
 #include <QDir>
 #include <QEventLoop>
 #include <QFile>
+#include <QImage>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QNetworkRequest>
@@ -11,27 +12,37 @@
 #include <utility>
 #include "commands/commands.h"
 #include "downloader/extension-rotator.h"
-#include "exiftool.h"
+#include "downloader/extension-stats.h"
+#include "exiftool-queue.h"
 #include "favorite.h"
+#include "file-metadata-queue.h"
+#include "filename/conditional-filename.h"
+#include "filename/filename-requirements.h"
 #include "filtering/tag-filter-list.h"
 #include "functions.h"
 #include "loader/token.h"
+#include "log-file-queue.h"
 #include "logger.h"
 #include "models/api/api.h"
 #include "models/filename.h"
 #include "models/image.h"
+#include "models/local-index.h"
 #include "models/page.h"
+#include "models/perceptual-hash-database.h"
 #include "models/pool.h"
 #include "models/profile.h"
+#include "models/profile-settings-snapshot.h"
 #include "models/site.h"
 #include "network/network-reply.h"
+#include "post-save-queue.h"
 #include "tags/tag.h"
 #include "tags/tag-database.h"
 #include "tags/tag-stylist.h"
 #include "tags/tag-type.h"
-#ifdef WIN_FILE_PROPS
-	#include "windows-file-property.h"
-#endif
+#include "utils/disk-scheduler.h"
+#include "utils/file-utils.h"
+#include "utils/perceptual-hash.h"
+#include "utils/thumbnail-cache.h"
 
 #define MAX_LOAD_FILESIZE (1024 * 1024 * 50)
 
@@ -73,6 +84,7 @@ Image::Image(const Image &other)
 	m_parentSite = other.m_parentSite;
 
 	m_extensionRotator = other.m_extensionRotator;
+	m_canRotateExtension = other.m_canRotateExtension;
 	m_loadingDetails = other.m_loadingDetails;
 }
 
@@ -151,15 +163,19 @@ Image::Image(Site *site, QMap<QString, QString> details, QVariantMap data, Profi
 		m_data.remove("tags");
 	}
 
-	// Complete missing tag type information
-	m_parentSite->tagDatabase()->load();
+	// Complete missing tag type information, and remember the known ones for other images
+	TagDatabase *tagDatabase = m_parentSite->tagDatabase();
+	tagDatabase->load();
 	QStringList unknownTags;
 	for (const Tag &tag : qAsConst(m_tags)) {
 		if (tag.type().isUnknown()) {
 			unknownTags.append(tag.text());
 		}
 	}
-	QMap<QString, TagType> dbTypes = m_parentSite->tagDatabase()->getTagTypes(unknownTags);
+	if (unknownTags.count() < m_tags.count()) {
+		tagDatabase->cacheTags(m_tags);
+	}
+	QMap<QString, TagType> dbTypes = tagDatabase->getTagTypes(unknownTags);
 	for (Tag &tag : m_tags) {
 		if (dbTypes.contains(tag.text())) {
 			tag.setType(dbTypes[tag.text()]);
@@ -210,7 +226,7 @@ Image::Image(Site *site, QMap<QString, QString> details, QVariantMap data, Profi
 	m_url = removeCacheBuster(m_url);
 
 	// We use the sample URL as the URL for zip files (ugoira) or if the setting is set
-	const bool downloadOriginals = m_settings->value("Save/downloadoriginals", true).toBool();
+	const bool downloadOriginals = m_profile->settingsSnapshot()->downloadOriginals;
 	if (!url(Size::Sample).isEmpty() && (getExtension(m_url) == "zip" || !downloadOriginals)) {
 		m_url = url(Size::Sample).toString();
 	}
@@ -228,13 +244,6 @@ void Image::init()
 		}
 	}
 	m_pageUrl = m_parentSite->fixUrl(m_pageUrl).toString();
-
-	// Setup extension rotator
-	const bool animated = hasTag("gif") || hasTag("animated_gif") || hasTag("mp4") || hasTag("animated_png") || hasTag("webm") || hasTag("animated") || hasTag("video");
-	const QStringList extensions = animated
-		? QStringList { "mp4", "webm", "gif", "jpg", "png", "jpeg", "swf" }
-		: QStringList { "jpg", "png", "gif", "jpeg", "webm", "swf", "mp4" };
-	m_extensionRotator = new ExtensionRotator(getExtension(m_url), extensions, this);
 }
 
 
@@ -439,8 +448,7 @@ void Image::parseDetails()
 	}
 
 	// Detect Cloudflare
-	if ((statusCode == 403 || statusCode == 429 || statusCode == 503) && m_loadDetails->rawHeader("server") == "cloudflare") {
-		log(QStringLiteral("Cloudflare wall for '%1'").arg(m_pageUrl.toString()), Logger::Error);
+	if (m_parentSite->checkChallenge(m_loadDetails)) {
 		m_loadDetails->deleteLater();
 		m_loadDetails = nullptr;
 		emit finishedLoadingTags(LoadTagsResult::CloudflareError);
@@ -477,30 +485,39 @@ void Image::parseDetails()
 		return;
 	}
 
+	m_loadDetails->deleteLater();
+	m_loadDetails = nullptr;
+
+	setDetails(ret);
+}
+void Image::setDetails(const ParsedDetails &details)
+{
 	// Fill data from parsing result
-	if (!ret.pools.isEmpty()) {
-		m_pools = ret.pools;
+	if (!details.pools.isEmpty()) {
+		m_pools = details.pools;
 	}
-	if (!ret.tags.isEmpty()) {
-		m_tags = ret.tags;
+	if (!details.tags.isEmpty()) {
+		m_tags = details.tags;
+		m_parentSite->tagDatabase()->cacheTags(m_tags);
 	}
-	if (ret.createdAt.isValid()) {
-		m_data["date"] = ret.createdAt;
+	if (details.createdAt.isValid()) {
+		m_data["date"] = details.createdAt;
 	}
-	if (!ret.sources.isEmpty()) {
-		m_sources = ret.sources;
+	if (!details.sources.isEmpty()) {
+		m_sources = details.sources;
 	}
 
 	// Image url
-	if (!ret.imageUrl.isEmpty()) {
+	if (!details.imageUrl.isEmpty()) {
 		const QUrl before = m_url;
-		const QUrl newUrl = m_parentSite->fixUrl(ret.imageUrl, before);
+		const QUrl newUrl = m_parentSite->fixUrl(details.imageUrl, before);
 
 		m_url = newUrl;
 		m_sizes[Size::Full]->url = newUrl;
 
 		delete m_extensionRotator;
 		m_extensionRotator = nullptr;
+		m_canRotateExtension = false;
 
 		if (before != m_url) {
 			if (getExtension(before) != getExtension(m_url)) {
@@ -510,8 +527,6 @@ void Image::parseDetails()
 		}
 	}
 
-	m_loadDetails->deleteLater();
-	m_loadDetails = nullptr;
 	m_loadedDetails = true;
 
 	refreshTokens();
@@ -549,6 +564,29 @@ int Image::value() const
 	return 1200 * 900;
 }
 
+/**
+ * Compute the perceptual hash of the thumbnail, if it is already loaded in memory or in the thumbnail cache.
+ */
+bool Image::thumbnailHash(quint64 *hash)
+{
+	QImage thumbnail = previewImage().toImage();
+	if (thumbnail.isNull()) {
+		const QString siteUrl = m_parentSite != nullptr ? m_parentSite->url() : QString();
+		const QString key = ThumbnailCache::key(siteUrl, !md5().isEmpty() ? md5() : url(Size::Thumbnail).toString());
+		ThumbnailCache *cache = m_profile->thumbnailCache();
+		thumbnail = cache->image(key);
+		if (thumbnail.isNull()) {
+			thumbnail = QImage::fromData(cache->data(key));
+		}
+	}
+	if (thumbnail.isNull()) {
+		return false;
+	}
+
+	*hash = perceptualHash(thumbnail);
+	return true;
+}
+
 Image::SaveResult Image::preSave(const QString &path, Size size)
 {
 	bool force = false;
@@ -577,6 +615,21 @@ Image::SaveResult Image::preSave(const QString &path, Size size)
 		}
 	}
 
+	// Skip images that look like an already saved one, which the MD5 can't detect if it was resized or re-encoded
+	if (whatToDo == "save" && size != Size::Thumbnail && !force && m_settings->value("Save/perceptualHash", false).toBool()) {
+		quint64 hash;
+		if ((md5().isEmpty() || m_profile->md5Exists(md5()).isEmpty()) && thumbnailHash(&hash)) {
+			const int threshold = m_settings->value("Save/perceptualHashThreshold", 4).toInt();
+			const QStringList similar = m_profile->perceptualHashDatabase()->find(hash, threshold);
+			for (const QString &similarPath : similar) {
+				if (QFile::exists(similarPath)) {
+					log(QStringLiteral("The image `%1` looks like the file `%2`").arg(m_url.toString(), similarPath));
+					return SaveResult::AlreadyExistsSimilar;
+				}
+			}
+		}
+	}
+
 	// Create the destination directory since we're going to put a file there
 	const QString p = path.section(QDir::separator(), 0, -2);
 	QDir pathToFile(p), dir;
@@ -587,7 +640,10 @@ Image::SaveResult Image::preSave(const QString &path, Size size)
 
 	// Basic save action
 	if (whatToDo == "save" || force) {
-		const QString savePath = m_sizes[size]->save(path);
+		QString savePath;
+		m_profile->getDiskScheduler().run(path, [this, &savePath, size, &path]() {
+			savePath = m_sizes[size]->save(path);
+		});
 		if (savePath.isEmpty()) {
 			return SaveResult::NotLoaded;
 		}
@@ -598,7 +654,9 @@ Image::SaveResult Image::preSave(const QString &path, Size size)
 	// Copy already existing file to the new path
 	if (whatToDo == "copy") {
 		log(QStringLiteral("Copy from `%1` to `%2`").arg(md5Duplicate, path));
-		QFile(md5Duplicate).copy(path);
+		m_profile->getDiskScheduler().run(path, [&md5Duplicate, &path]() {
+			copyFile(md5Duplicate, path);
+		});
 		return SaveResult::Copied;
 	}
 
@@ -607,6 +665,9 @@ Image::SaveResult Image::preSave(const QString &path, Size size)
 		log(QStringLiteral("Moving from `%1` to `%2`").arg(md5Duplicate, path));
 		QFile::rename(md5Duplicate, path);
 		m_profile->removeMd5(md5(), md5Duplicate);
+		if (m_settings->value("Save/localIndex", false).toBool()) {
+			m_profile->localIndex()->remove(md5Duplicate);
+		}
 		return SaveResult::Moved;
 	}
 
@@ -636,8 +697,38 @@ QString &pathTokens(QString &filename, const QString &path)
 }
 void Image::postSaving(const QString &path, Size size, bool addMd5, bool startCommands, int count, bool basic)
 {
+	// The tokens are computed here, and only the file work is done by the post-save queue
+	PostSaveQueue &postSaveQueue = m_profile->getPostSaveQueue();
+
 	if (addMd5) {
 		m_profile->addMd5(md5(), path);
+
+		// Prefer hashing the thumbnail, as it is what will be compared to the next images before downloading them
+		if (size != Size::Thumbnail && m_settings->value("Save/perceptualHash", false).toBool()) {
+			quint64 hash;
+			if (thumbnailHash(&hash)) {
+				m_profile->perceptualHashDatabase()->add(hash, path);
+			} else {
+				Profile *profile = m_profile;
+				postSaveQueue.run(path, [profile, path]() {
+					quint64 fileHash;
+					if (perceptualHashFile(path, &fileHash)) {
+						QMetaObject::invokeMethod(profile, [profile, fileHash, path]() {
+							profile->perceptualHashDatabase()->add(fileHash, path);
+						}, Qt::QueuedConnection);
+					}
+				});
+			}
+		}
+
+		if (m_settings->value("Save/localIndex", false).toBool()) {
+			QStringList tags;
+			tags.reserve(m_tags.count());
+			for (const Tag &tag : qAsConst(m_tags)) {
+				tags.append(tag.text());
+			}
+			m_profile->localIndex()->add(path, md5(), m_parentSite->url(), tags);
+		}
 	}
 
 	// Save info to a text file
@@ -666,24 +757,11 @@ void Image::postSaving(const QString &path, Size size, bool addMd5, bool startCo
 				pathTokens(contents, path);
 
 				// Append to file if necessary
-				QFile fileTags(fileTagsPath);
-				const bool append = fileTags.exists();
-				if (fileTags.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
-					if (append) {
-						fileTags.write("\n");
-					}
-					fileTags.write(contents.toUtf8());
-					fileTags.close();
-				}
+				m_profile->getLogFileQueue().add(fileTagsPath, contents);
 			}
 		}
 	}
 
-	// Keep original date
-	if (m_settings->value("Save/keepDate", true).toBool()) {
-		setFileCreationDate(path, createdAt());
-	}
-
 	// Commands
 	Commands &commands = m_profile->getCommands();
 	if (startCommands) {
@@ -701,20 +779,26 @@ void Image::postSaving(const QString &path, Size size, bool addMd5, bool startCo
 	}
 
 	// Metadata
+	const auto snapshot = m_profile->settingsSnapshot();
 	const QString &ext = extension();
+	QList<QPair<QString, QString>> properties;
 	#ifdef WIN_FILE_PROPS
-		const QStringList exts = m_settings->value("Save/MetadataPropsysExtensions", "jpg jpeg mp4").toString().split(' ', Qt::SkipEmptyParts);
+		const QStringList &exts = snapshot->metadataPropsysExtensions;
 		if (exts.isEmpty() || exts.contains(ext)) {
 			const auto metadataPropsys = getMetadataPropsys(m_settings);
 			for (const auto &pair : metadataPropsys) {
 				const QStringList values = Filename(pair.second).path(*this, m_profile, "", 0, Filename::Complex);
 				if (!values.isEmpty()) {
-					setWindowsProperty(path, pair.first, values.first());
+					properties.append({ pair.first, values.first() });
 				}
 			}
 		}
 	#endif
-	const QStringList exiftoolExts = m_settings->value("Save/MetadataExiftoolExtensions", "jpg jpeg png gif mp4").toString().split(' ', Qt::SkipEmptyParts);
+
+	// Keep original date, and write Windows properties, batched with the other files of the same directory
+	m_profile->getFileMetadataQueue().add(path, snapshot->keepDate ? createdAt() : QDateTime(), properties);
+
+	const QStringList &exiftoolExts = snapshot->metadataExiftoolExtensions;
 	if (exiftoolExts.isEmpty() || exiftoolExts.contains(ext)) {
 		QMap<QString, QString> metadata;
 		const auto metadataExiftool = getMetadataExiftool(m_settings);
@@ -726,9 +810,7 @@ void Image::postSaving(const QString &path, Size size, bool addMd5, bool startCo
 		}
 
 		if (!metadata.isEmpty()) {
-			Exiftool &exiftool = m_profile->getExiftool();
-			exiftool.start();
-			exiftool.setMetadata(path, metadata);
+			m_profile->getExiftool().add(path, metadata);
 		}
 	}
 
@@ -754,9 +836,74 @@ const QString &Image::name() const { return m_name; }
 QPixmap Image::previewImage() const { return m_sizes[Image::Size::Thumbnail]->pixmap(); }
 const QPixmap &Image::previewImage() { return m_sizes[Image::Size::Thumbnail]->pixmap(); }
 Page *Image::page() const { return m_parent; }
+bool Image::hasLoadedDetails() const { return m_loadedDetails; }
 const QUrl &Image::parentUrl() const { return m_parentUrl; }
 bool Image::isGallery() const { return m_isGallery; }
-ExtensionRotator *Image::extensionRotator() const { return m_extensionRotator; }
+/**
+ * The extension rotator is only needed when the file is not found, so it is only created then to keep images light.
+ */
+ExtensionRotator *Image::extensionRotator() const
+{
+	if (m_extensionRotator == nullptr && m_canRotateExtension && m_parentSite != nullptr) {
+		const bool animated = hasTag("gif") || hasTag("animated_gif") || hasTag("mp4") || hasTag("animated_png") || hasTag("webm") || hasTag("animated") || hasTag("video");
+		const QStringList extensions = animated
+			? QStringList { "mp4", "webm", "gif", "jpg", "png", "jpeg", "swf" }
+			: QStringList { "jpg", "png", "gif", "jpeg", "webm", "swf", "mp4" };
+		m_extensionRotator = new ExtensionRotator(getExtension(m_url), m_parentSite->extensionStats()->sort(m_id, extensions), const_cast<Image*>(this));
+	}
+	return m_extensionRotator;
+}
+
+static qint64 stringMemoryUsage(const QString &str)
+{
+	return str.isNull() ? 0 : static_cast<qint64>(str.capacity()) * sizeof(QChar) + 24;
+}
+
+static qint64 stringListMemoryUsage(const QStringList &list)
+{
+	qint64 ret = static_cast<qint64>(list.count()) * sizeof(void*);
+	for (const QString &str : list) {
+		ret += stringMemoryUsage(str);
+	}
+	return ret;
+}
+
+/**
+ * Rough estimate of the memory used by this image, in bytes, ignoring the data shared with other objects.
+ */
+qint64 Image::memoryUsage() const
+{
+	qint64 ret = sizeof(Image);
+
+	ret += stringMemoryUsage(m_url.toString()) + stringMemoryUsage(m_pageUrl.toString());
+	ret += stringMemoryUsage(m_md5) + stringMemoryUsage(m_name);
+	ret += stringListMemoryUsage(m_sources);
+
+	for (auto it = m_data.constBegin(); it != m_data.constEnd(); ++it) {
+		ret += stringMemoryUsage(it.key()) + sizeof(QVariant) + 32;
+		if (it.value().type() == QVariant::String) {
+			ret += stringMemoryUsage(it.value().toString());
+		}
+	}
+
+	for (const Tag &tag : m_tags) {
+		ret += sizeof(void*) + sizeof(Tag) + stringMemoryUsage(tag.text()) + stringListMemoryUsage(tag.related());
+	}
+
+	for (const auto &size : m_sizes) {
+		ret += sizeof(ImageSize) + 32 + stringMemoryUsage(size->url.toString());
+		const QPixmap pixmap = size->pixmap();
+		if (!pixmap.isNull()) {
+			ret += static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+		}
+	}
+
+	if (m_extensionRotator != nullptr) {
+		ret += sizeof(ExtensionRotator);
+	}
+
+	return ret;
+}
 QString Image::extension() const { return getExtension(m_url).toLower(); }
 
 void Image::setPromoteDetailParsWarn(bool val) { m_detailsParsWarnAsErr = val; }
@@ -776,13 +923,18 @@ void Image::setSavePath(const QString &path, Size size)
 		refreshTokens();
 	}
 }
+void Image::setFileMd5(const QString &md5, Size size)
+{
+	m_sizes[size]->setMd5(md5);
+}
 QString Image::savePath(Size size) const
 { return m_sizes[size]->savePath(); }
 
 Image::Size Image::preferredDisplaySize() const
 {
-	const bool getOriginals = m_settings->value("Save/downloadoriginals", true).toBool();
-	const bool viewSample = m_settings->value("Viewer/viewSamples", false).toBool();
+	const auto snapshot = m_profile->settingsSnapshot();
+	const bool getOriginals = snapshot->downloadOriginals;
+	const bool viewSample = snapshot->viewSamples;
 
 	return !url(Size::Sample).isEmpty() && (!getOriginals || viewSample)
 		? Size::Sample
@@ -827,7 +979,21 @@ void Image::setParentGallery(const QSharedPointer<Image> &parentGallery)
 	refreshTokens();
 }
 
+/**
+ * The color is kept until the tokens of the image or the lists of the profile change, as it is needed for each paint.
+ */
 QColor Image::color() const
+{
+	const int listsVersion = m_profile->listsVersion();
+	if (m_colorListsVersion != listsVersion || m_colorTokensGeneration != tokensGeneration()) {
+		m_color = computeColor();
+		m_colorListsVersion = listsVersion;
+		m_colorTokensGeneration = tokensGeneration();
+	}
+	return m_color;
+}
+
+QColor Image::computeColor() const
 {
 	// Blacklisted
 	QStringList detected = m_profile->getBlacklist().match(tokens(m_profile));
@@ -836,14 +1002,9 @@ QColor Image::color() const
 	}
 
 	// Favorited (except for exact favorite search)
-	auto favorites = m_profile->getFavorites();
 	for (const Tag &tag : m_tags) {
-		if (!m_parent->search().contains(tag.text())) {
-			for (const Favorite &fav : favorites) {
-				if (fav.getName() == tag.text()) {
-					return { 255, 192, 203 };
-				}
-			}
+		if (m_profile->isFavorite(tag.text()) && (m_parent == nullptr || !m_parent->search().contains(tag.text()))) {
+			return { 255, 192, 203 };
 		}
 	}
 
@@ -866,6 +1027,19 @@ QColor Image::color() const
 }
 
 QString Image::tooltip() const
+{
+	const int listsVersion = m_profile->listsVersion();
+	const QString tagOrder = m_settings->value("Viewer/tagOrder", "type").toString();
+	if (m_tooltipListsVersion != listsVersion || m_tooltipTokensGeneration != tokensGeneration() || m_tooltipTagOrder != tagOrder) {
+		m_tooltip = computeTooltip(tagOrder);
+		m_tooltipListsVersion = listsVersion;
+		m_tooltipTokensGeneration = tokensGeneration();
+		m_tooltipTagOrder = tagOrder;
+	}
+	return m_tooltip;
+}
+
+QString Image::computeTooltip(const QString &tagOrder) const
 {
 	if (m_isGallery) {
 		return QStringLiteral("%1%2")
@@ -882,7 +1056,7 @@ QString Image::tooltip() const
 	const QString &score = token<QString>("score");
 
 	return QStringLiteral("%1%2%3%4%5%6%7%8")
-		.arg(m_tags.isEmpty() ? " " : tr("<b>Tags:</b> %1<br/><br/>").arg(TagStylist(m_profile).stylished(m_tags, false, false, m_settings->value("Viewer/tagOrder", "type").toString()).join(' ')))
+		.arg(m_tags.isEmpty() ? " " : tr("<b>Tags:</b> %1<br/><br/>").arg(m_profile->tagStylist()->stylished(m_tags, false, false, tagOrder).join(' ')))
 		.arg(m_id == 0 ? " " : tr("<b>ID:</b> %1<br/>").arg(m_id))
 		.arg(rating.isEmpty() ? " " : tr("<b>Rating:</b> %1<br/>").arg(rating))
 		.arg(!score.isEmpty() ? tr("<b>Score:</b> %1<br/>").arg(score) : " ")
@@ -914,7 +1088,7 @@ QList<QStrP> Image::detailsData() const
 	int parentId = token<int>("parentid");
 
 	return {
-		QStrP(tr("Tags"), TagStylist(m_profile).stylished(m_tags, false, false, m_settings->value("Viewer/tagOrder", "type").toString()).join(' ')),
+		QStrP(tr("Tags"), m_profile->tagStylist()->stylished(m_tags, false, false, m_settings->value("Viewer/tagOrder", "type").toString()).join(' ')),
 		QStrP(),
 		QStrP(tr("ID"), m_id != 0 ? QString::number(m_id) : unknown),
 		QStrP(tr("MD5"), !m_md5.isEmpty() ? m_md5 : unknown),
@@ -1012,7 +1186,14 @@ QUrl Image::url(Size size) const
 
 void Image::preload(const Filename &filename)
 {
-	if (filename.needExactTags(m_parentSite, m_settings) == 0) {
+	// Paths are generated using conditional filenames, so their requirements need to be checked too
+	FilenameRequirements requirements = filename.requirements();
+	for (const ConditionalFilename &fn : getFilenames(m_settings)) {
+		requirements.add(fn.requirements());
+	}
+
+	const QStringList forcedTokens = m_parentSite->getApis().first()->forcedTokens();
+	if (!requirements.needDetails(*this, forcedTokens, getCustoms(m_settings).keys())) {
 		return;
 	}
 
@@ -1034,11 +1215,8 @@ QStringList Image::paths(const Filename &filename, const QString &folder, int co
 QMap<QString, Token> Image::generateTokens(Profile *profile) const
 {
 	const QSettings *settings = profile->getSettings();
-	const QStringList &ignore = profile->getIgnored();
-	const TagFilterList &remove = profile->getRemovedTags();
 
 	QMap<QString, Token> tokens;
-	QMap<QString, QStringList> details;
 
 	// Pool
 	static const QRegularExpression poolRegexp("pool:(\\d+)");
@@ -1075,55 +1253,80 @@ QMap<QString, Token> Image::generateTokens(Profile *profile) const
 	}
 	tokens.insert("search", Token(m_search.join(' ')));
 
-	// Raw untouched tags (with underscores)
+	// Raw untouched tags (with underscores), used by filters so always computed
+	QStringList allos;
+	allos.reserve(m_tags.count());
 	for (const Tag &tag : m_tags) {
-		details["allos"].append(QString(tag.text()).replace(' ', '_'));
+		allos.append(QString(tag.text()).replace(' ', '_'));
 	}
+	tokens.insert("allos", Token(allos));
+	tokens.insert("allo", Token(allos.join(' ')));
 
-	// Tags
-	const auto tags = remove.filterTags(m_tags);
-	for (const Tag &tag : tags) {
-		const QString &t = tag.text();
-
-		details[ignore.contains(t, Qt::CaseInsensitive) ? "general" : tag.type().name()].append(t);
-		details["alls"].append(t);
-		details["alls_namespaces"].append(tag.type().name());
-	}
-
-	// Shorten copyrights
-	if (settings->value("Save/copyright_useshorter", true).toBool()) {
-		QStringList copyrights;
-		for (const QString &cop : details["copyright"]) {
-			bool found = false;
-			for (QString &copyright : copyrights) {
-				if (copyright.left(cop.size()) == cop.left(copyright.size())) {
-					if (cop.size() < copyright.size()) {
-						copyright = cop;
+	// Other tag tokens are only computed when one of them is first needed, as they are mostly used for filenames
+	const QList<Tag> rawTags = m_tags;
+	const auto details = QSharedPointer<Token>::create([rawTags, profile]() -> QVariant {
+		const QSettings *settings = profile->getSettings();
+		const QStringList &ignore = profile->getIgnored();
+		const TagFilterList &remove = profile->getRemovedTags();
+
+		QMap<QString, QStringList> lists;
+
+		const auto tags = remove.filterTags(rawTags);
+		for (const Tag &tag : tags) {
+			const QString &t = tag.text();
+
+			lists[ignore.contains(t, Qt::CaseInsensitive) ? "general" : tag.type().name()].append(t);
+			lists["alls"].append(t);
+			lists["alls_namespaces"].append(tag.type().name());
+		}
+
+		// Shorten copyrights
+		if (settings->value("Save/copyright_useshorter", true).toBool()) {
+			QStringList copyrights;
+			for (const QString &cop : lists["copyright"]) {
+				bool found = false;
+				for (QString &copyright : copyrights) {
+					if (copyright.left(cop.size()) == cop.left(copyright.size())) {
+						if (cop.size() < copyright.size()) {
+							copyright = cop;
+						}
+						found = true;
 					}
-					found = true;
+				}
+				if (!found) {
+					copyrights.append(cop);
 				}
 			}
-			if (!found) {
-				copyrights.append(cop);
-			}
+			lists["copyright"] = copyrights;
 		}
-		details["copyright"] = copyrights;
-	}
+
+		QVariantMap ret;
+		for (auto it = lists.constBegin(); it != lists.constEnd(); ++it) {
+			ret.insert(it.key(), it.value());
+		}
+		ret.insert("model", lists["model"] + lists["idol"]);
+		ret.insert("tags", QVariant::fromValue(tags));
+		return QVariant(ret);
+	});
+	const auto detail = [details](const QString &key) -> std::function<QVariant()> {
+		return [details, key]() -> QVariant {
+			const QVariant val = details->value().toMap().value(key);
+			return val.isValid() ? val : QVariant(QStringList());
+		};
+	};
 
 	// Tags
-	tokens.insert("general", Token(details["general"]));
-	tokens.insert("artist", Token(details["artist"], "keepAll", "anonymous", "multiple artists"));
-	tokens.insert("copyright", Token(details["copyright"], "keepAll", "misc", "crossover"));
-	tokens.insert("character", Token(details["character"], "keepAll", "unknown", "group"));
-	tokens.insert("model", Token(details["model"] + details["idol"], "keepAll", "unknown", "multiple"));
-	tokens.insert("photo_set", Token(details["photo_set"], "keepAll", "unknown", "multiple"));
-	tokens.insert("species", Token(details["species"], "keepAll", "unknown", "multiple"));
-	tokens.insert("meta", Token(details["meta"], "keepAll", "none", "multiple"));
-	tokens.insert("allos", Token(details["allos"]));
-	tokens.insert("allo", Token(details["allos"].join(' ')));
-	tokens.insert("tags", Token(QVariant::fromValue(tags)));
-	tokens.insert("all", Token(details["alls"]));
-	tokens.insert("all_namespaces", Token(details["alls_namespaces"]));
+	tokens.insert("general", Token(detail("general")));
+	tokens.insert("artist", Token(detail("artist"), "keepAll", "anonymous", "multiple artists"));
+	tokens.insert("copyright", Token(detail("copyright"), "keepAll", "misc", "crossover"));
+	tokens.insert("character", Token(detail("character"), "keepAll", "unknown", "group"));
+	tokens.insert("model", Token(detail("model"), "keepAll", "unknown", "multiple"));
+	tokens.insert("photo_set", Token(detail("photo_set"), "keepAll", "unknown", "multiple"));
+	tokens.insert("species", Token(detail("species"), "keepAll", "unknown", "multiple"));
+	tokens.insert("meta", Token(detail("meta"), "keepAll", "none", "multiple"));
+	tokens.insert("tags", Token([details]() -> QVariant { return details->value().toMap().value("tags"); }));
+	tokens.insert("all", Token(detail("alls")));
+	tokens.insert("all_namespaces", Token(detail("alls_namespaces")));
 
 	// Extension
 	QString ext = extension();
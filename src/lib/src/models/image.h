@@ -15,6 +15,7 @@
 class ExtensionRotator;
 class NetworkReply;
 class Page;
+struct ParsedDetails;
 class Profile;
 class QDateTime;
 class QPixmap;
@@ -69,6 +70,7 @@ class Image : public QObject, public Downloadable
 		const QUrl &parentUrl() const;
 		Site *parentSite() const;
 		ExtensionRotator *extensionRotator() const;
+		qint64 memoryUsage() const;
 		bool hasTag(QString tag) const;
 		bool hasUnknownTag() const;
 		void setUrl(const QUrl &url);
@@ -77,6 +79,7 @@ class Image : public QObject, public Downloadable
 		void setFileExtension(const QString &ext);
 		void setTemporaryPath(const QString &path, Size size = Size::Full);
 		void setSavePath(const QString &path, Size size = Size::Full);
+		void setFileMd5(const QString &md5, Size size = Size::Full);
 		QString savePath(Size size = Size::Full) const;
 		Size preferredDisplaySize() const;
 		bool isVideo() const;
@@ -87,6 +90,8 @@ class Image : public QObject, public Downloadable
 		void setParentGallery(const QSharedPointer<Image> &parentGallery);
 		void setPromoteDetailParsWarn(bool);
 		bool isValid() const;
+		bool hasLoadedDetails() const;
+		void setDetails(const ParsedDetails &details);
 		Profile *getProfile() const { return m_profile; }
 
 		// Preview pixmap store
@@ -114,15 +119,19 @@ class Image : public QObject, public Downloadable
 		T token(const QString &name, const T &defaultValue = T()) const
 		{
 			const QMap<QString, Token> &toks = tokens(m_profile);
-			if (!toks.contains(name)) {
+			const auto it = toks.constFind(name);
+			if (it == toks.constEnd()) {
 				return defaultValue;
 			}
-			return toks[name].value<T>();
+			return it.value().value<T>();
 		}
 
 	protected:
 		void init();
 		QString md5forced() const;
+		bool thumbnailHash(quint64 *hash);
+		QColor computeColor() const;
+		QString computeTooltip(const QString &tagOrder) const;
 		void postSaving(const QString &path, Size size, bool addMd5 = true, bool startCommands = false, int count = 1, bool basic = false);
 
 	public slots:
@@ -158,7 +167,8 @@ class Image : public QObject, public Downloadable
 
 		// Image
 		// - Technical
-		ExtensionRotator *m_extensionRotator;
+		mutable ExtensionRotator *m_extensionRotator;
+		bool m_canRotateExtension = true;
 		NetworkReply *m_loadDetails = nullptr;
 		// - Data
 		QString mutable m_md5;
@@ -167,6 +177,14 @@ class Image : public QObject, public Downloadable
 		QList<Tag> m_tags;
 		QList<Pool> m_pools;
 		QStringList m_sources;
+		// - Display cache
+		mutable QColor m_color;
+		mutable int m_colorListsVersion = -1;
+		mutable int m_colorTokensGeneration = -1;
+		mutable QString m_tooltip;
+		mutable QString m_tooltipTagOrder;
+		mutable int m_tooltipListsVersion = -1;
+		mutable int m_tooltipTokensGeneration = -1;
 
 		// Gallery
 		// - Data
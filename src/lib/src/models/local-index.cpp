@@ -0,0 +1,263 @@
+#include "models/local-index.h"
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <utility>
+#include "logger.h"
+
+#define MIN_OBSOLETE_LINES_REWRITE 1000
+
+
+LocalIndex::LocalIndex(QString path)
+	: m_path(std::move(path))
+{
+	int lines = 0;
+
+	QFile file(m_path);
+	if (file.open(QFile::ReadOnly | QFile::Text)) {
+		QByteArray line;
+		while (!(line = file.readLine()).isEmpty()) {
+			const QStringList parts = QString::fromUtf8(line).trimmed().split('\t');
+			if (parts.count() == 5 && parts[0] == QLatin1String("+")) {
+				insert(parts[3], parts[1], parts[2], parts[4].split(' ', Qt::SkipEmptyParts));
+				lines++;
+			} else if (parts.count() == 2 && parts[0] == QLatin1String("-")) {
+				erase(parts[1]);
+				lines++;
+			}
+		}
+		file.close();
+	}
+	log(QStringLiteral("Local index loaded (%1 files, %2 tags)").arg(m_count).arg(m_tagNames.count()));
+
+	// Files saved several times to the same path add a line each time
+	const int obsolete = lines - m_count;
+	if (obsolete > m_count && obsolete > MIN_OBSOLETE_LINES_REWRITE) {
+		rewrite();
+	}
+}
+
+
+int LocalIndex::count() const
+{
+	return m_count;
+}
+
+bool LocalIndex::containsMd5(const QString &md5) const
+{
+	return m_md5s.contains(md5);
+}
+
+void LocalIndex::add(const QString &path, const QString &md5, const QString &site, const QStringList &tags)
+{
+	QStringList normalized;
+	normalized.reserve(tags.count());
+	for (const QString &tag : tags) {
+		normalized.append(normalize(tag));
+	}
+
+	insert(path, md5, site, normalized);
+	append(QStringList { "+", md5, site, path, normalized.join(' ') }.join('\t'));
+}
+
+void LocalIndex::remove(const QString &path)
+{
+	if (erase(path)) {
+		append(QStringLiteral("-\t") + path);
+	}
+}
+
+QString LocalIndex::normalize(const QString &tag)
+{
+	return tag.trimmed().toLower().replace(' ', '_');
+}
+
+
+void LocalIndex::insert(const QString &path, const QString &md5, const QString &site, const QStringList &tags)
+{
+	erase(path);
+
+	const int id = m_records.count();
+	Record record;
+	record.path = path;
+	record.md5 = md5;
+	record.site = site;
+	record.tags.reserve(tags.count());
+
+	for (const QString &tag : tags) {
+		if (tag.isEmpty()) {
+			continue;
+		}
+
+		auto it = m_tagIds.find(tag);
+		if (it == m_tagIds.end()) {
+			it = m_tagIds.insert(tag, m_tagNames.count());
+			m_tagNames.append(tag);
+			m_postings.append(QVector<int>());
+		}
+
+		// Records are only appended, so their postings stay sorted
+		QVector<int> &postings = m_postings[it.value()];
+		if (postings.isEmpty() || postings.last() != id) {
+			postings.append(id);
+			record.tags.append(it.value());
+		}
+	}
+
+	m_records.append(record);
+	m_paths.insert(path, id);
+	if (!md5.isEmpty()) {
+		m_md5s[md5]++;
+	}
+	m_count++;
+}
+
+bool LocalIndex::erase(const QString &path)
+{
+	const auto it = m_paths.find(path);
+	if (it == m_paths.end()) {
+		return false;
+	}
+
+	// The postings of removed records are only skipped when searching
+	Record &record = m_records[it.value()];
+	record.removed = true;
+	m_paths.erase(it);
+	if (!record.md5.isEmpty()) {
+		auto md5 = m_md5s.find(record.md5);
+		if (md5 != m_md5s.end() && --md5.value() <= 0) {
+			m_md5s.erase(md5);
+		}
+	}
+	m_count--;
+
+	return true;
+}
+
+/**
+ * Get the sorted records having a tag, or one of the tags starting with the given prefix for "prefix*".
+ */
+QVector<int> LocalIndex::postings(const QString &tag) const
+{
+	if (!tag.endsWith('*')) {
+		const auto it = m_tagIds.constFind(tag);
+		return it != m_tagIds.constEnd() ? m_postings[it.value()] : QVector<int>();
+	}
+
+	const QString prefix = tag.left(tag.length() - 1);
+	QVector<int> ret;
+	for (int i = 0; i < m_tagNames.count(); ++i) {
+		if (m_tagNames[i].startsWith(prefix)) {
+			ret += m_postings[i];
+		}
+	}
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+QList<LocalIndex::Entry> LocalIndex::search(const QStringList &query, int limit) const
+{
+	QList<QVector<int>> includes;
+	QVector<int> excludes;
+	for (const QString &raw : query) {
+		const bool exclude = raw.startsWith('-');
+		const QString tag = normalize(exclude ? raw.mid(1) : raw);
+		if (tag.isEmpty()) {
+			continue;
+		}
+
+		QVector<int> records = postings(tag);
+		if (exclude) {
+			excludes += records;
+		} else if (records.isEmpty()) {
+			return {};
+		} else {
+			includes.append(std::move(records));
+		}
+	}
+	std::sort(excludes.begin(), excludes.end());
+
+	// Intersect the lists starting from the shortest one, so that the intermediate results stay as small as possible
+	QVector<int> matches;
+	if (includes.isEmpty()) {
+		matches.reserve(m_records.count());
+		for (int i = 0; i < m_records.count(); ++i) {
+			matches.append(i);
+		}
+	} else {
+		std::sort(includes.begin(), includes.end(), [](const QVector<int> &a, const QVector<int> &b) {
+			return a.count() < b.count();
+		});
+		matches = includes.takeFirst();
+		for (const QVector<int> &records : qAsConst(includes)) {
+			QVector<int> intersection;
+			std::set_intersection(matches.constBegin(), matches.constEnd(), records.constBegin(), records.constEnd(), std::back_inserter(intersection));
+			matches = std::move(intersection);
+			if (matches.isEmpty()) {
+				return {};
+			}
+		}
+	}
+
+	QList<Entry> ret;
+	for (int i = matches.count() - 1; i >= 0 && (limit < 0 || ret.count() < limit); --i) {
+		const Record &record = m_records[matches[i]];
+		if (record.removed || std::binary_search(excludes.constBegin(), excludes.constEnd(), matches[i])) {
+			continue;
+		}
+
+		Entry entry;
+		entry.path = record.path;
+		entry.md5 = record.md5;
+		entry.site = record.site;
+		entry.tags.reserve(record.tags.count());
+		for (int tag : record.tags) {
+			entry.tags.append(m_tagNames[tag]);
+		}
+		ret.append(entry);
+	}
+	return ret;
+}
+
+
+bool LocalIndex::append(const QString &line)
+{
+	QFile file(m_path);
+	if (!file.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+		log(QStringLiteral("Could not write to the local index `%1`").arg(m_path), Logger::Error);
+		return false;
+	}
+
+	file.write(line.toUtf8() + '\n');
+	file.close();
+	return true;
+}
+
+void LocalIndex::rewrite()
+{
+	QSaveFile file(m_path);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+		log(QStringLiteral("Could not rewrite the local index `%1`").arg(m_path), Logger::Error);
+		return;
+	}
+
+	for (const Record &record : qAsConst(m_records)) {
+		if (record.removed) {
+			continue;
+		}
+
+		QStringList tags;
+		tags.reserve(record.tags.count());
+		for (int tag : record.tags) {
+			tags.append(m_tagNames[tag]);
+		}
+		file.write(QStringList { "+", record.md5, record.site, record.path, tags.join(' ') }.join('\t').toUtf8() + '\n');
+	}
+
+	if (!file.commit()) {
+		log(QStringLiteral("Could not rewrite the local index `%1`").arg(m_path), Logger::Error);
+		return;
+	}
+	log(QStringLiteral("Local index rewritten (%1 files)").arg(m_count), Logger::Debug);
+}
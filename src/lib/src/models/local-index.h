@@ -0,0 +1,79 @@
+#ifndef LOCAL_INDEX_H
+#define LOCAL_INDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * Index of the tags of the saved files, to search the downloaded collection without querying the sites again.
+ *
+ * Tag names are interned to integer IDs, each tag keeping the sorted list of the files it appears in, so that a query
+ * only intersects the lists of its tags. Files are appended to a text file as they are saved, one tab-separated
+ * "+ <md5> <site> <path> <tags>" line each, files removed or saved again to the same path being marked with a
+ * "- <path>" line. The file is rewritten when it is loaded if most of its lines are obsolete.
+ */
+class LocalIndex
+{
+	public:
+		struct Entry
+		{
+			QString path;
+			QString md5;
+			QString site;
+			QStringList tags;
+		};
+
+		explicit LocalIndex(QString path);
+
+		int count() const;
+		bool containsMd5(const QString &md5) const;
+		void add(const QString &path, const QString &md5, const QString &site, const QStringList &tags);
+		void remove(const QString &path);
+
+		/**
+		 * Get the files matching all the tags of a query, most recently saved first.
+		 *
+		 * Tags starting with "-" exclude the files having them, and tags ending with "*" match all the tags starting
+		 * with the same prefix.
+		 *
+		 * @param limit The maximum number of files returned, -1 for no limit.
+		 */
+		QList<Entry> search(const QStringList &query, int limit = -1) const;
+
+		/**
+		 * Normalize a tag name the same way they were indexed, e.g. "Tag Name" to "tag_name".
+		 */
+		static QString normalize(const QString &tag);
+
+	protected:
+		void insert(const QString &path, const QString &md5, const QString &site, const QStringList &tags);
+		bool erase(const QString &path);
+		QVector<int> postings(const QString &tag) const;
+		bool append(const QString &line);
+		void rewrite();
+
+	private:
+		struct Record
+		{
+			QString path;
+			QString md5;
+			QString site;
+			QVector<int> tags;
+			bool removed = false;
+		};
+
+		QString m_path;
+		QVector<Record> m_records;
+		QHash<QString, int> m_paths; // Index of the live record of each path
+		QHash<QString, int> m_md5s; // Number of live records of each MD5
+		QHash<QString, int> m_tagIds;
+		QStringList m_tagNames;
+		QVector<QVector<int>> m_postings; // Records of each tag, in increasing order
+		int m_count = 0;
+};
+
+#endif // LOCAL_INDEX_H
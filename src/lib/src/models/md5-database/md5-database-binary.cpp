@@ -0,0 +1,517 @@
+#include "models/md5-database/md5-database-binary.h"
+#include <QSettings>
+#include <QtConcurrentRun>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "logger.h"
+
+#define FILE_MAGIC "GBMD5BIN"
+#define FILE_VERSION 1
+#define HEADER_SIZE 24
+#define ENTRY_SIZE 24
+#define DIGEST_SIZE 16
+
+
+static QByteArray toDigest(const QString &md5)
+{
+	if (md5.length() != DIGEST_SIZE * 2) {
+		return QByteArray();
+	}
+	QByteArray digest = QByteArray::fromHex(md5.toLatin1());
+	return digest.length() == DIGEST_SIZE ? digest : QByteArray();
+}
+
+
+quint32 Md5DatabaseBinary::View::lowerBound(const QByteArray &digest) const
+{
+	quint32 lo = 0;
+	quint32 hi = count;
+	while (lo < hi) {
+		const quint32 mid = lo + (hi - lo) / 2;
+		if (memcmp(data + HEADER_SIZE + quint64(mid) * ENTRY_SIZE, digest.constData(), DIGEST_SIZE) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+bool Md5DatabaseBinary::View::hasDigest(quint32 i, const QByteArray &digest) const
+{
+	return i < count && memcmp(data + HEADER_SIZE + quint64(i) * ENTRY_SIZE, digest.constData(), DIGEST_SIZE) == 0;
+}
+
+QByteArray Md5DatabaseBinary::View::digest(quint32 i) const
+{
+	return QByteArray(reinterpret_cast<const char*>(data + HEADER_SIZE + quint64(i) * ENTRY_SIZE), DIGEST_SIZE);
+}
+
+QString Md5DatabaseBinary::View::path(quint32 i) const
+{
+	const uchar *entry = data + HEADER_SIZE + quint64(i) * ENTRY_SIZE;
+	const quint32 offset = qFromLittleEndian<quint32>(entry + DIGEST_SIZE);
+	const quint32 length = qFromLittleEndian<quint32>(entry + DIGEST_SIZE + 4);
+	return QString::fromUtf8(reinterpret_cast<const char*>(data + stringsOffset + offset), int(length));
+}
+
+
+bool Md5DatabaseBinary::Overlay::isEmpty() const
+{
+	return added.isEmpty() && removed.isEmpty() && removedAll.isEmpty();
+}
+
+void Md5DatabaseBinary::Overlay::append(const Overlay &next)
+{
+	for (const QString &md5 : next.removedAll) {
+		added.remove(md5);
+		removedAll.insert(md5);
+	}
+	for (const QString &key : next.removed) {
+		added.remove(key.left(DIGEST_SIZE * 2), key.mid(DIGEST_SIZE * 2));
+		removed.insert(key);
+	}
+	for (auto it = next.added.constBegin(); it != next.added.constEnd(); ++it) {
+		if (!added.contains(it.key(), it.value())) {
+			added.insert(it.key(), it.value());
+		}
+	}
+}
+
+void Md5DatabaseBinary::Overlay::apply(const QString &md5, QStringList &paths) const
+{
+	if (removedAll.contains(md5)) {
+		paths.clear();
+	} else if (!removed.isEmpty()) {
+		for (int i = paths.count() - 1; i >= 0; --i) {
+			if (removed.contains(md5 + paths[i])) {
+				paths.removeAt(i);
+			}
+		}
+	}
+
+	for (auto it = added.constFind(md5); it != added.constEnd() && it.key() == md5; ++it) {
+		if (!paths.contains(it.value())) {
+			paths.append(it.value());
+		}
+	}
+}
+
+
+Md5DatabaseBinary::Md5DatabaseBinary(QString path, QSettings *settings)
+	: Md5Database(settings), m_path(std::move(path))
+{
+	m_mergeThreshold = m_settings->value("md5_log_threshold", 10000).toInt();
+
+	// A merge might have been interrupted after replacing the file but before clearing the log, which is fine
+	QFile::remove(m_path + ".new");
+
+	// Keep invalid files aside instead of overwriting them on the next merge
+	if (!openFile()) {
+		QFile::remove(m_path + ".bak");
+		QFile::rename(m_path, m_path + ".bak");
+	}
+	m_count = int(m_view.count);
+	loadLog();
+
+	log(QStringLiteral("MD5 database loaded (%1 entries, %2 pending changes)").arg(m_count).arg(m_logCount));
+}
+
+Md5DatabaseBinary::~Md5DatabaseBinary()
+{
+	waitForMerge();
+	m_log.close();
+	closeFile();
+}
+
+
+bool Md5DatabaseBinary::openFile()
+{
+	m_view = View();
+
+	m_file.setFileName(m_path);
+	if (!m_file.exists() || m_file.size() == 0) {
+		return true;
+	}
+	if (!m_file.open(QFile::ReadOnly)) {
+		log(QStringLiteral("Could not open MD5 database `%1`: %2").arg(m_path, m_file.errorString()), Logger::Error);
+		return false;
+	}
+
+	const qint64 size = m_file.size();
+	const uchar *data = size >= HEADER_SIZE ? m_file.map(0, size) : nullptr;
+	if (data == nullptr || memcmp(data, FILE_MAGIC, 8) != 0 || qFromLittleEndian<quint32>(data + 8) != FILE_VERSION) {
+		log(QStringLiteral("Invalid MD5 database `%1`").arg(m_path), Logger::Error);
+		closeFile();
+		return false;
+	}
+
+	const quint32 count = qFromLittleEndian<quint32>(data + 12);
+	const quint64 stringsOffset = qFromLittleEndian<quint64>(data + 16);
+	if (stringsOffset != HEADER_SIZE + quint64(count) * ENTRY_SIZE || stringsOffset > quint64(size)) {
+		log(QStringLiteral("Corrupted MD5 database `%1`").arg(m_path), Logger::Error);
+		closeFile();
+		return false;
+	}
+
+	m_view.data = data;
+	m_view.count = count;
+	m_view.stringsOffset = stringsOffset;
+	return true;
+}
+
+void Md5DatabaseBinary::closeFile()
+{
+	if (m_view.data != nullptr) {
+		m_file.unmap(const_cast<uchar*>(m_view.data));
+	}
+	m_view = View();
+	m_file.close();
+}
+
+bool Md5DatabaseBinary::replaceFile(const QString &newPath)
+{
+	closeFile();
+
+	QFile::remove(m_path);
+	const bool ok = QFile::rename(newPath, m_path);
+	if (!ok) {
+		log(QStringLiteral("Could not replace MD5 database `%1`").arg(m_path), Logger::Error);
+	}
+
+	openFile();
+	return ok;
+}
+
+
+void Md5DatabaseBinary::loadLog()
+{
+	m_log.setFileName(m_path + ".log");
+	if (m_log.open(QFile::ReadOnly | QFile::Text)) {
+		QString line;
+		while (!(line = QString::fromUtf8(m_log.readLine())).isEmpty()) {
+			line = line.trimmed();
+			if (line.length() < 1 + DIGEST_SIZE * 2) {
+				continue;
+			}
+
+			const QString md5 = line.mid(1, DIGEST_SIZE * 2);
+			const QString path = line.mid(1 + DIGEST_SIZE * 2);
+			if (line[0] == '+') {
+				addEntry(md5, path);
+			} else if (line[0] == '-') {
+				removeEntry(md5, path);
+			}
+			m_logCount++;
+		}
+		m_log.close();
+	}
+
+	if (!m_log.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+		log(QStringLiteral("Could not open MD5 database log `%1`: %2").arg(m_log.fileName(), m_log.errorString()), Logger::Error);
+	}
+}
+
+void Md5DatabaseBinary::writeLog()
+{
+	m_log.close();
+	if (!m_log.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+		log(QStringLiteral("Could not open MD5 database log `%1`: %2").arg(m_log.fileName(), m_log.errorString()), Logger::Error);
+		return;
+	}
+
+	m_logCount = 0;
+	for (const QString &md5 : qAsConst(m_current.removedAll)) {
+		appendLog('-', md5, QString());
+	}
+	for (const QString &key : qAsConst(m_current.removed)) {
+		appendLog('-', key.left(DIGEST_SIZE * 2), key.mid(DIGEST_SIZE * 2));
+	}
+	for (auto it = m_current.added.constBegin(); it != m_current.added.constEnd(); ++it) {
+		appendLog('+', it.key(), it.value());
+	}
+	m_log.flush();
+}
+
+void Md5DatabaseBinary::appendLog(char op, const QString &md5, const QString &path)
+{
+	m_log.write(QString(QLatin1Char(op) + md5 + path + "\n").toUtf8());
+	m_logCount++;
+}
+
+
+void Md5DatabaseBinary::sync()
+{
+	waitForMerge();
+	if (m_current.isEmpty()) {
+		return;
+	}
+
+	startMerge(true);
+	waitForMerge();
+}
+
+void Md5DatabaseBinary::add(const QString &md5, const QString &path)
+{
+	if (toDigest(md5).isEmpty()) {
+		log(QStringLiteral("Invalid MD5 \"%1\" ignored").arg(md5), Logger::Warning);
+		return;
+	}
+
+	if (!addEntry(md5, path)) {
+		return;
+	}
+	log(QStringLiteral("Added MD5: %1").arg(md5), Logger::Debug);
+
+	appendLog('+', md5, path);
+	m_log.flush();
+	startMerge();
+}
+
+void Md5DatabaseBinary::remove(const QString &md5, const QString &path)
+{
+	if (!removeEntry(md5, path)) {
+		return;
+	}
+
+	appendLog('-', md5, path);
+	m_log.flush();
+	startMerge();
+}
+
+int Md5DatabaseBinary::count() const
+{
+	return m_count;
+}
+
+QStringList Md5DatabaseBinary::paths(const QString &md5)
+{
+	QStringList ret;
+
+	const QByteArray digest = toDigest(md5);
+	if (!digest.isEmpty()) {
+		for (quint32 i = m_view.lowerBound(digest); m_view.hasDigest(i, digest); ++i) {
+			ret.append(m_view.path(i));
+		}
+	}
+
+	m_merging.apply(md5, ret);
+	m_current.apply(md5, ret);
+
+	return ret;
+}
+
+void Md5DatabaseBinary::listMd5s(const std::function<void(const QString &md5)> &callback)
+{
+	for (quint32 i = 0; i < m_view.count; ++i) {
+		callback(QString::fromLatin1(m_view.digest(i).toHex()));
+	}
+	for (const Overlay *overlay : { &m_merging, &m_current }) {
+		for (auto it = overlay->added.constBegin(); it != overlay->added.constEnd(); ++it) {
+			callback(it.key());
+		}
+	}
+}
+
+
+bool Md5DatabaseBinary::addEntry(const QString &md5, const QString &path)
+{
+	if (lookup(md5).contains(path)) {
+		return false;
+	}
+
+	m_current.removed.remove(md5 + path);
+	m_current.added.insert(md5, path);
+	m_count++;
+	addToFilter(md5);
+	return true;
+}
+
+bool Md5DatabaseBinary::removeEntry(const QString &md5, const QString &path)
+{
+	const QStringList existing = paths(md5);
+
+	if (path.isEmpty()) {
+		if (existing.isEmpty()) {
+			return false;
+		}
+		m_current.added.remove(md5);
+		m_current.removedAll.insert(md5);
+		m_count -= existing.count();
+		return true;
+	}
+
+	if (!existing.contains(path)) {
+		return false;
+	}
+	m_current.added.remove(md5, path);
+	m_current.removed.insert(md5 + path);
+	m_count--;
+	return true;
+}
+
+
+void Md5DatabaseBinary::startMerge(bool force)
+{
+	if (m_mergeWatcher != nullptr || m_current.isEmpty() || (!force && (m_mergeFailed || m_logCount < m_mergeThreshold))) {
+		return;
+	}
+
+	// Changes made during the merge go to a new overlay, and will be written to the log once it's finished
+	m_merging = m_current;
+	m_current = Overlay();
+
+	const View view = m_view;
+	const Overlay overlay = m_merging;
+	const QString target = m_path + ".new";
+
+	m_mergeWatcher = new QFutureWatcher<bool>(this);
+	connect(m_mergeWatcher, &QFutureWatcher<bool>::finished, this, &Md5DatabaseBinary::mergeFinished);
+	m_mergeWatcher->setFuture(QtConcurrent::run([view, overlay, target]() {
+		return merge(view, overlay, target);
+	}));
+}
+
+void Md5DatabaseBinary::waitForMerge()
+{
+	if (m_mergeWatcher == nullptr) {
+		return;
+	}
+
+	m_mergeWatcher->waitForFinished();
+	mergeFinished();
+}
+
+void Md5DatabaseBinary::mergeFinished()
+{
+	const bool ok = m_mergeWatcher->result();
+	m_mergeWatcher->disconnect(this);
+	m_mergeWatcher->deleteLater();
+	m_mergeWatcher = nullptr;
+
+	// On error, keep the changes in memory and in the log
+	if (!ok || !replaceFile(m_path + ".new")) {
+		log(QStringLiteral("Could not merge the MD5 database log into `%1`").arg(m_path), Logger::Error);
+		m_merging.append(m_current);
+		m_current = m_merging;
+		m_merging = Overlay();
+		m_mergeFailed = true;
+		return;
+	}
+
+	m_merging = Overlay();
+	writeLog();
+
+	emit merged();
+}
+
+bool Md5DatabaseBinary::merge(View view, Overlay overlay, const QString &target)
+{
+	QVector<Entry> entries;
+	entries.reserve(int(view.count) + overlay.added.count());
+
+	// Existing entries, with the changes applied
+	quint32 i = 0;
+	while (i < view.count) {
+		const QByteArray digest = view.digest(i);
+		QStringList paths;
+		for (; view.hasDigest(i, digest); ++i) {
+			paths.append(view.path(i));
+		}
+
+		const QString md5 = QString::fromLatin1(digest.toHex());
+		overlay.apply(md5, paths);
+		overlay.added.remove(md5);
+
+		for (const QString &path : qAsConst(paths)) {
+			entries.append({ digest, path });
+		}
+	}
+
+	// New MD5s
+	for (auto it = overlay.added.constBegin(); it != overlay.added.constEnd(); ++it) {
+		entries.append({ toDigest(it.key()), it.value() });
+	}
+
+	return writeFile(target, entries);
+}
+
+bool Md5DatabaseBinary::writeFile(const QString &target, QVector<Entry> &entries)
+{
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return a.digest < b.digest;
+	});
+
+	QFile file(target);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+		return false;
+	}
+
+	const quint32 count = quint32(entries.count());
+	const quint64 stringsOffset = HEADER_SIZE + quint64(count) * ENTRY_SIZE;
+
+	// Header
+	uchar header[HEADER_SIZE];
+	memcpy(header, FILE_MAGIC, 8);
+	qToLittleEndian<quint32>(FILE_VERSION, header + 8);
+	qToLittleEndian<quint32>(count, header + 12);
+	qToLittleEndian<quint64>(stringsOffset, header + 16);
+	bool ok = file.write(reinterpret_cast<const char*>(header), HEADER_SIZE) == HEADER_SIZE;
+
+	// Entries, with their paths stored in the string table
+	QByteArray strings;
+	QByteArray buffer;
+	buffer.reserve(ENTRY_SIZE * 4096);
+	for (const Entry &entry : qAsConst(entries)) {
+		const QByteArray path = entry.path.toUtf8();
+
+		uchar raw[ENTRY_SIZE];
+		memcpy(raw, entry.digest.constData(), DIGEST_SIZE);
+		qToLittleEndian<quint32>(quint32(strings.length()), raw + DIGEST_SIZE);
+		qToLittleEndian<quint32>(quint32(path.length()), raw + DIGEST_SIZE + 4);
+		buffer.append(reinterpret_cast<const char*>(raw), ENTRY_SIZE);
+		strings.append(path);
+
+		if (buffer.length() >= ENTRY_SIZE * 4096) {
+			ok = ok && file.write(buffer) == buffer.length();
+			buffer.clear();
+		}
+	}
+	ok = ok && file.write(buffer) == buffer.length();
+	ok = ok && file.write(strings) == strings.length();
+
+	file.close();
+	if (!ok) {
+		file.remove();
+	}
+	return ok;
+}
+
+
+void Md5DatabaseBinary::setMd5s(const QMultiHash<QString, QString> &md5s)
+{
+	waitForMerge();
+
+	QVector<Entry> entries;
+	entries.reserve(md5s.count());
+	for (auto it = md5s.constBegin(); it != md5s.constEnd(); ++it) {
+		const QByteArray digest = toDigest(it.key());
+		if (!digest.isEmpty()) {
+			entries.append({ digest, it.value() });
+		}
+	}
+
+	if (!writeFile(m_path + ".new", entries) || !replaceFile(m_path + ".new")) {
+		log(QStringLiteral("Could not write MD5 database `%1`").arg(m_path), Logger::Error);
+		return;
+	}
+
+	m_merging = Overlay();
+	m_current = Overlay();
+	m_count = int(m_view.count);
+	resetFilter();
+	m_mergeFailed = false;
+	writeLog();
+}
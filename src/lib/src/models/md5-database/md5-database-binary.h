@@ -0,0 +1,113 @@
+#ifndef MD5_DATABASE_BINARY_H
+#define MD5_DATABASE_BINARY_H
+
+#include "models/md5-database/md5-database.h"
+#include <QByteArray>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QMultiHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+class QSettings;
+
+/**
+ * Compact MD5 database, made of a memory-mapped file of sorted 16-byte digests pointing into a string table of paths.
+ *
+ * Changes are kept in memory and appended to a text log next to the file, which is merged into a new binary file in
+ * a worker thread once it gets big enough (or on sync()).
+ */
+class Md5DatabaseBinary : public Md5Database
+{
+	Q_OBJECT
+
+	public:
+		explicit Md5DatabaseBinary(QString path, QSettings *settings);
+		~Md5DatabaseBinary() override;
+
+		void sync() override;
+		void add(const QString &md5, const QString &path) override;
+		void remove(const QString &md5, const QString &path = {}) override;
+		int count() const override;
+
+		void setMd5s(const QMultiHash<QString, QString> &md5s);
+
+	protected:
+		QStringList paths(const QString &md5) override;
+		void listMd5s(const std::function<void(const QString &md5)> &callback) override;
+
+		/**
+		 * Read-only view of the memory-mapped file.
+		 */
+		struct View
+		{
+			const uchar *data = nullptr;
+			quint32 count = 0;
+			quint64 stringsOffset = 0;
+
+			quint32 lowerBound(const QByteArray &digest) const;
+			bool hasDigest(quint32 i, const QByteArray &digest) const;
+			QByteArray digest(quint32 i) const;
+			QString path(quint32 i) const;
+		};
+
+		/**
+		 * Changes applied on top of the binary file (or of a previous overlay).
+		 */
+		struct Overlay
+		{
+			QMultiHash<QString, QString> added;
+			QSet<QString> removed; // MD5 followed by the path
+			QSet<QString> removedAll;
+
+			bool isEmpty() const;
+			void append(const Overlay &next);
+			void apply(const QString &md5, QStringList &paths) const;
+		};
+
+		struct Entry
+		{
+			QByteArray digest;
+			QString path;
+		};
+
+		bool openFile();
+		void closeFile();
+		void loadLog();
+		void writeLog();
+		void appendLog(char op, const QString &md5, const QString &path);
+
+		bool addEntry(const QString &md5, const QString &path);
+		bool removeEntry(const QString &md5, const QString &path);
+
+		void startMerge(bool force = false);
+		void waitForMerge();
+		bool replaceFile(const QString &newPath);
+
+		static bool merge(View view, Overlay overlay, const QString &target);
+		static bool writeFile(const QString &target, QVector<Entry> &entries);
+
+	protected slots:
+		void mergeFinished();
+
+	signals:
+		void merged();
+
+	private:
+		QString m_path;
+		QFile m_file;
+		View m_view;
+		QFile m_log;
+		int m_logCount = 0;
+		int m_mergeThreshold;
+		Overlay m_merging;
+		Overlay m_current;
+		int m_count = 0;
+		QFutureWatcher<bool> *m_mergeWatcher = nullptr;
+		bool m_mergeFailed = false;
+};
+
+#endif // MD5_DATABASE_BINARY_H
@@ -0,0 +1,413 @@
+#include "models/md5-database/md5-database-postgres.h"
+#include <QDateTime>
+#include <QSet>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include "logger.h"
+
+#define KNOWN_CHUNK_SIZE 500
+#define INSERT_CHUNK_SIZE 500
+#define FLUSH_MAX_PENDING 100
+#define RECONNECT_DELAY 30000
+#define MISSING_MAX_SIZE 100000
+
+
+Md5DatabasePostgres::Md5DatabasePostgres(QSettings *settings)
+	: Md5Database(settings), m_flushTimer(this)
+{
+	const QString host = m_settings->value("md5_database_server/host", "localhost").toString();
+	const int port = m_settings->value("md5_database_server/port", 5432).toInt();
+	const QString name = m_settings->value("md5_database_server/name", "grabber").toString();
+
+	m_database = QSqlDatabase::addDatabase(QStringLiteral("QPSQL"), QStringLiteral("MD5 database - postgresql://%1:%2/%3").arg(host).arg(port).arg(name));
+	m_database.setHostName(host);
+	m_database.setPort(port);
+	m_database.setDatabaseName(name);
+	m_database.setUserName(m_settings->value("md5_database_server/user").toString());
+	m_database.setPassword(m_settings->value("md5_database_server/password").toString());
+	m_database.setConnectOptions(m_settings->value("md5_database_server/options", "connect_timeout=5").toString());
+
+	// MD5s the server did not know, in seconds
+	m_missingTtl = m_settings->value("md5_database_server/negative_cache_ttl", 60).toInt();
+
+	// Writes are sent together, in a single transaction
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(m_settings->value("md5_flush_interval", 1000).toInt());
+	connect(&m_flushTimer, &QTimer::timeout, this, &Md5DatabasePostgres::flush);
+
+	connectToServer();
+}
+
+Md5DatabasePostgres::~Md5DatabasePostgres()
+{
+	sync();
+	if (!m_pending.isEmpty()) {
+		log(QStringLiteral("%1 MD5 operations could not be sent to the server").arg(m_pending.count()), Logger::Warning);
+	}
+	m_database.close();
+}
+
+
+/**
+ * Opens the connection and creates the schema if necessary. After a failure, the server is left alone for a while, so
+ * that every operation does not wait for the connection to time out.
+ */
+bool Md5DatabasePostgres::connectToServer()
+{
+	if (m_database.isOpen() && m_schemaReady) {
+		return true;
+	}
+	if (QDateTime::currentMSecsSinceEpoch() < m_nextRetry) {
+		return false;
+	}
+
+	if (!m_database.isOpen() && !m_database.open()) {
+		log(QStringLiteral("Could not connect to the MD5 database server: %1").arg(m_database.lastError().text()), Logger::Error);
+		m_nextRetry = QDateTime::currentMSecsSinceEpoch() + RECONNECT_DELAY;
+		return false;
+	}
+
+	// The primary key also serves as index for lookups by MD5, and allows to ignore paths added twice
+	QSqlQuery createQuery(m_database);
+	if (!createQuery.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS md5s (md5 TEXT NOT NULL, path TEXT NOT NULL, PRIMARY KEY (md5, path))"))) {
+		log(QStringLiteral("Could not create MD5 database schema: %1").arg(createQuery.lastError().text()), Logger::Error);
+		m_database.close();
+		m_nextRetry = QDateTime::currentMSecsSinceEpoch() + RECONNECT_DELAY;
+		return false;
+	}
+
+	m_schemaReady = true;
+	return true;
+}
+
+/**
+ * Sends all the pending operations to the server in a single transaction, consecutive additions being grouped in
+ * multi-row inserts. If anything fails, the operations are kept to be sent again later.
+ */
+void Md5DatabasePostgres::flush()
+{
+	m_flushTimer.stop();
+	if (m_pending.isEmpty()) {
+		return;
+	}
+	if (!connectToServer()) {
+		m_flushTimer.start();
+		return;
+	}
+
+	bool ok = m_database.transaction();
+	if (!ok) {
+		log(QStringLiteral("Could not create transaction: %1").arg(m_database.lastError().text()), Logger::Warning);
+	}
+
+	QVector<PendingOperation> additions;
+	for (int i = 0; ok && i <= m_pending.count(); ++i) {
+		const bool end = i == m_pending.count();
+		if (!end && m_pending[i].add) {
+			additions.append(m_pending[i]);
+			if (additions.count() < INSERT_CHUNK_SIZE) {
+				continue;
+			}
+		}
+		if (!additions.isEmpty()) {
+			ok = insertAll(additions);
+			additions.clear();
+		}
+		if (end || !ok || m_pending[i].add) {
+			continue;
+		}
+
+		const PendingOperation &op = m_pending[i];
+		QSqlQuery query(m_database);
+		if (op.path.isEmpty()) {
+			query.prepare(QStringLiteral("DELETE FROM md5s WHERE md5 = ?"));
+			query.addBindValue(op.md5);
+		} else {
+			query.prepare(QStringLiteral("DELETE FROM md5s WHERE md5 = ? AND path = ?"));
+			query.addBindValue(op.md5);
+			query.addBindValue(op.path);
+		}
+		if (!query.exec()) {
+			log(QStringLiteral("Error removing MD5 from the database: %1").arg(query.lastError().text()), Logger::Error);
+			ok = false;
+		}
+	}
+
+	if (ok && !m_database.commit()) {
+		log(QStringLiteral("Could not commit transaction: %1").arg(m_database.lastError().text()), Logger::Error);
+		ok = false;
+	}
+
+	// The connection may have been lost, so we start again from scratch the next time
+	if (!ok) {
+		m_database.rollback();
+		m_database.close();
+		m_schemaReady = false;
+		m_nextRetry = QDateTime::currentMSecsSinceEpoch() + RECONNECT_DELAY;
+		m_flushTimer.start();
+		return;
+	}
+
+	m_pending.clear();
+	emit flushed();
+}
+
+bool Md5DatabasePostgres::insertAll(const QVector<PendingOperation> &ops)
+{
+	QStringList placeholders;
+	placeholders.reserve(ops.count());
+	for (int i = 0; i < ops.count(); ++i) {
+		placeholders.append(QStringLiteral("(?, ?)"));
+	}
+
+	QSqlQuery query(m_database);
+	query.prepare(QStringLiteral("INSERT INTO md5s (md5, path) VALUES %1 ON CONFLICT DO NOTHING").arg(placeholders.join(',')));
+	for (const PendingOperation &op : ops) {
+		query.addBindValue(op.md5);
+		query.addBindValue(op.path);
+	}
+	if (!query.exec()) {
+		log(QStringLiteral("Error adding MD5s to the database: %1").arg(query.lastError().text()), Logger::Error);
+		return false;
+	}
+
+	return true;
+}
+
+void Md5DatabasePostgres::sync()
+{
+	flush();
+}
+
+/**
+ * Unlike local databases, it is not sent every time a new operation is queued, so that a busy instance still sends its
+ * additions in time for the others to see them.
+ */
+void Md5DatabasePostgres::queue(bool add, const QString &md5, const QString &path)
+{
+	m_pending.append(PendingOperation { add, md5, path });
+	if (m_pending.count() >= FLUSH_MAX_PENDING) {
+		flush();
+	} else if (!m_flushTimer.isActive()) {
+		m_flushTimer.start();
+	}
+}
+
+/**
+ * There is no lookup before adding the MD5, as the server ignores the paths it already has.
+ */
+void Md5DatabasePostgres::add(const QString &md5, const QString &path)
+{
+	if (md5.isEmpty()) {
+		return;
+	}
+
+	m_missing.remove(md5);
+	queue(true, md5, path);
+	log(QString("Added MD5: %1").arg(md5), Logger::Debug);
+}
+
+void Md5DatabasePostgres::addAll(const QList<QPair<QString, QString>> &md5s)
+{
+	for (const auto &md5 : md5s) {
+		if (!md5.first.isEmpty()) {
+			m_missing.remove(md5.first);
+			m_pending.append(PendingOperation { true, md5.first, md5.second });
+		}
+	}
+
+	flush();
+	log(QStringLiteral("Added %1 MD5s").arg(md5s.count()), Logger::Debug);
+}
+
+void Md5DatabasePostgres::remove(const QString &md5, const QString &path)
+{
+	queue(false, md5, path);
+}
+
+/**
+ * Applies the operations not yet sent to the server to a list of paths of an MD5.
+ */
+void Md5DatabasePostgres::applyPending(const QString &md5, QStringList &paths) const
+{
+	for (const PendingOperation &op : m_pending) {
+		if (op.md5 != md5) {
+			continue;
+		}
+		if (op.add) {
+			if (!paths.contains(op.path)) {
+				paths.append(op.path);
+			}
+		} else if (op.path.isEmpty()) {
+			paths.clear();
+		} else {
+			paths.removeAll(op.path);
+		}
+	}
+}
+
+bool Md5DatabasePostgres::mayContain(const QString &md5)
+{
+	auto it = m_missing.find(md5);
+	if (it == m_missing.end()) {
+		return true;
+	}
+	if (it.value() > QDateTime::currentMSecsSinceEpoch()) {
+		return false;
+	}
+
+	m_missing.erase(it);
+	return true;
+}
+
+/**
+ * Remembers that the server did not know this MD5, expired entries only being removed when there are too many.
+ */
+void Md5DatabasePostgres::setMissing(const QString &md5)
+{
+	if (m_missingTtl <= 0) {
+		return;
+	}
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	if (m_missing.count() >= MISSING_MAX_SIZE) {
+		for (auto it = m_missing.begin(); it != m_missing.end();) {
+			if (it.value() <= now) {
+				it = m_missing.erase(it);
+			} else {
+				++it;
+			}
+		}
+		if (m_missing.count() >= MISSING_MAX_SIZE) {
+			m_missing.clear();
+		}
+	}
+
+	m_missing.insert(md5, now + m_missingTtl * 1000);
+}
+
+QStringList Md5DatabasePostgres::paths(const QString &md5)
+{
+	QStringList ret;
+	bool ok = false;
+
+	if (connectToServer()) {
+		QSqlQuery query(m_database);
+		query.prepare(QStringLiteral("SELECT path FROM md5s WHERE md5 = ?"));
+		query.addBindValue(md5);
+		ok = query.exec();
+		if (!ok) {
+			log(QStringLiteral("Error getting MD5 from the database: %1").arg(query.lastError().text()), Logger::Error);
+		}
+		while (ok && query.next()) {
+			ret.append(query.value(0).toString());
+		}
+	}
+
+	applyPending(md5, ret);
+	if (ok && ret.isEmpty()) {
+		setMissing(md5);
+	}
+
+	return ret;
+}
+
+void Md5DatabasePostgres::listMd5s(const std::function<void(const QString &md5)> &callback)
+{
+	if (connectToServer()) {
+		QSqlQuery query(m_database);
+		query.setForwardOnly(true);
+		if (!query.exec(QStringLiteral("SELECT md5 FROM md5s"))) {
+			log(QStringLiteral("Error listing MD5s from the database: %1").arg(query.lastError().text()), Logger::Error);
+		}
+		while (query.next()) {
+			callback(query.value(0).toString());
+		}
+	}
+
+	for (const PendingOperation &op : qAsConst(m_pending)) {
+		if (op.add) {
+			callback(op.md5);
+		}
+	}
+}
+
+/**
+ * Look for all the MD5s in a few queries, and remember the ones the server did not know.
+ */
+QSet<QString> Md5DatabasePostgres::known(const QStringList &input)
+{
+	QSet<QString> ret;
+
+	// Skip the MD5s recently found missing
+	QStringList md5s;
+	for (const QString &md5 : input) {
+		if (!md5.isEmpty() && mayContain(md5)) {
+			md5s.append(md5);
+		}
+	}
+
+	bool ok = connectToServer();
+	for (int start = 0; ok && start < md5s.count(); start += KNOWN_CHUNK_SIZE) {
+		const QStringList chunk = md5s.mid(start, KNOWN_CHUNK_SIZE);
+
+		QStringList placeholders;
+		placeholders.reserve(chunk.count());
+		for (int i = 0; i < chunk.count(); ++i) {
+			placeholders.append(QStringLiteral("?"));
+		}
+
+		QSqlQuery query(m_database);
+		query.prepare(QStringLiteral("SELECT DISTINCT md5 FROM md5s WHERE md5 IN (%1)").arg(placeholders.join(',')));
+		for (const QString &md5 : chunk) {
+			query.addBindValue(md5);
+		}
+		ok = query.exec();
+		if (!ok) {
+			log(QStringLiteral("Error getting MD5s from the database: %1").arg(query.lastError().text()), Logger::Error);
+		}
+		while (ok && query.next()) {
+			ret.insert(query.value(0).toString());
+		}
+	}
+
+	// Account for the operations not sent yet
+	QSet<QString> changed;
+	for (const PendingOperation &op : qAsConst(m_pending)) {
+		changed.insert(op.md5);
+	}
+	for (const QString &md5 : md5s) {
+		if (changed.contains(md5)) {
+			if (paths(md5).isEmpty()) {
+				ret.remove(md5);
+			} else {
+				ret.insert(md5);
+			}
+		} else if (ok && !ret.contains(md5)) {
+			setMissing(md5);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Only counts the MD5s already sent to the server, as other instances may have added the pending ones too.
+ */
+int Md5DatabasePostgres::count() const
+{
+	if (!m_database.isOpen() || !m_schemaReady) {
+		return -1;
+	}
+
+	QSqlQuery query(m_database);
+	if (!query.exec(QStringLiteral("SELECT COUNT(*) FROM md5s")) || !query.next()) {
+		log(QStringLiteral("Error counting MD5s in the database: %1").arg(query.lastError().text()), Logger::Error);
+		return -1;
+	}
+
+	return query.value(0).toInt();
+}
@@ -0,0 +1,75 @@
+#ifndef MD5_DATABASE_POSTGRES_H
+#define MD5_DATABASE_POSTGRES_H
+
+#include "models/md5-database/md5-database.h"
+#include <QHash>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+
+class QSettings;
+
+/**
+ * MD5 database stored on a PostgreSQL server, so that several instances saving to the same place share it.
+ *
+ * As other instances can add MD5s at any time, the local filter can't be used. Instead, the MD5s the server did not
+ * know are remembered for a short time, and lookups of many MD5s are done in a few queries.
+ */
+class Md5DatabasePostgres : public Md5Database
+{
+	Q_OBJECT
+
+	public:
+		explicit Md5DatabasePostgres(QSettings *settings);
+		~Md5DatabasePostgres() override;
+
+		void sync() override;
+		void add(const QString &md5, const QString &path) override;
+		void addAll(const QList<QPair<QString, QString>> &md5s) override;
+		void remove(const QString &md5, const QString &path = {}) override;
+		int count() const override;
+		QSet<QString> known(const QStringList &md5s) override;
+
+	protected:
+		QStringList paths(const QString &md5) override;
+		void listMd5s(const std::function<void(const QString &md5)> &callback) override;
+		bool mayContain(const QString &md5) override;
+
+		/**
+		 * Write operation waiting to be sent to the server.
+		 */
+		struct PendingOperation
+		{
+			bool add;
+			QString md5;
+			QString path; // Empty to remove all the paths of an MD5
+		};
+
+		bool connectToServer();
+		void applyPending(const QString &md5, QStringList &paths) const;
+		void queue(bool add, const QString &md5, const QString &path);
+		void setMissing(const QString &md5);
+		bool insertAll(const QVector<PendingOperation> &ops);
+
+	protected slots:
+		void flush();
+
+	signals:
+		void flushed();
+
+	private:
+		QSqlDatabase m_database;
+		bool m_schemaReady = false;
+		qint64 m_nextRetry = 0;
+		QTimer m_flushTimer;
+		QVector<PendingOperation> m_pending;
+
+		// Negative cache
+		int m_missingTtl;
+		QHash<QString, qint64> m_missing;
+};
+
+#endif // MD5_DATABASE_POSTGRES_H
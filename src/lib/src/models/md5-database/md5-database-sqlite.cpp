@@ -1,4 +1,6 @@
 #include "models/md5-database/md5-database-sqlite.h"
+#include <QSet>
+#include <QSettings>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
@@ -7,9 +9,11 @@
 #include <utility>
 #include "logger.h"
 
+#define KNOWN_CHUNK_SIZE 500
+
 
 Md5DatabaseSqlite::Md5DatabaseSqlite(QString path, QSettings *settings)
-	: Md5Database(settings), m_path(std::move(path))
+	: Md5Database(settings), m_path(std::move(path)), m_flushTimer(this)
 {
 	// Use SQLite database for tests
 	m_database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), "MD5 database - " + m_path);
@@ -19,6 +23,16 @@ Md5DatabaseSqlite::Md5DatabaseSqlite(QString path, QSettings *settings)
 		return;
 	}
 
+	// Write-ahead logging allows reads during writes and needs less fsync calls per transaction
+	QSqlQuery walQuery(m_database);
+	if (!walQuery.exec(QStringLiteral("PRAGMA journal_mode=WAL"))) {
+		log(QStringLiteral("Could not enable WAL mode for the MD5 database: %1").arg(walQuery.lastError().text()), Logger::Warning);
+	}
+	QSqlQuery syncQuery(m_database);
+	if (!syncQuery.exec(QStringLiteral("PRAGMA synchronous=NORMAL"))) {
+		log(QStringLiteral("Could not set the synchronous mode of the MD5 database: %1").arg(syncQuery.lastError().text()), Logger::Warning);
+	}
+
 	// Create schema if necessary
 	QSqlQuery createQuery(QStringLiteral("CREATE TABLE IF NOT EXISTS md5s (md5 CHAR(32), path TEXT)"), m_database);
 	if (!createQuery.exec()) {
@@ -44,50 +58,154 @@ Md5DatabaseSqlite::Md5DatabaseSqlite(QString path, QSettings *settings)
 	m_deleteAllQuery.prepare(QStringLiteral("DELETE FROM md5s WHERE md5 = :md5"));
 	m_countQuery = QSqlQuery(m_database);
 	m_countQuery.prepare(QStringLiteral("SELECT COUNT(*) AS cnt FROM md5s"));
+
+	// Writes are grouped in a single transaction
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(m_settings->value("md5_flush_interval", 1000).toInt());
+	connect(&m_flushTimer, &QTimer::timeout, this, &Md5DatabaseSqlite::flush);
 }
 
 Md5DatabaseSqlite::~Md5DatabaseSqlite()
 {
+	sync();
 	m_database.close();
 }
 
 
+/**
+ * Commits all the pending operations to the database in a single transaction.
+ */
+void Md5DatabaseSqlite::flush()
+{
+	m_flushTimer.stop();
+	if (m_pending.isEmpty() || !m_database.isOpen()) {
+		return;
+	}
+
+	const bool transaction = m_database.transaction();
+	if (!transaction) {
+		log(QStringLiteral("Could not create transaction: %1").arg(m_database.lastError().text()), Logger::Warning);
+	}
+
+	for (const PendingOperation &op : qAsConst(m_pending)) {
+		if (op.add) {
+			m_addQuery.bindValue(":md5", op.md5);
+			m_addQuery.bindValue(":path", op.path);
+			if (!m_addQuery.exec()) {
+				log(QStringLiteral("Error adding MD5 to the database: %1").arg(m_addQuery.lastError().text()), Logger::Error);
+			}
+		} else {
+			QSqlQuery &query = op.path.isEmpty() ? m_deleteAllQuery : m_deleteQuery;
+			query.bindValue(":md5", op.md5);
+			if (!op.path.isEmpty()) {
+				query.bindValue(":path", op.path);
+			}
+			if (!query.exec()) {
+				log(QStringLiteral("Error removing MD5 from the database: %1").arg(query.lastError().text()), Logger::Error);
+			}
+		}
+	}
+
+	if (transaction && !m_database.commit()) {
+		log(QStringLiteral("Could not commit transaction: %1").arg(m_database.lastError().text()), Logger::Error);
+	}
+
+	m_pending.clear();
+	emit flushed();
+}
+
 void Md5DatabaseSqlite::sync()
 {
-	// No-op
+	flush();
+}
+
+void Md5DatabaseSqlite::queue(bool add, const QString &md5, const QString &path)
+{
+	m_pending.append(PendingOperation { add, md5, path });
+	if (m_pending.count() >= 100) {
+		flush();
+	} else {
+		m_flushTimer.start();
+	}
 }
 
 void Md5DatabaseSqlite::add(const QString &md5, const QString &path)
 {
-	if (md5.isEmpty() || paths(md5).contains(path)) {
+	if (md5.isEmpty() || lookup(md5).contains(path)) {
 		return;
 	}
 
-	m_addQuery.bindValue(":md5", md5);
-	m_addQuery.bindValue(":path", path);
+	queue(true, md5, path);
+	addToFilter(md5);
+	log(QString("Added MD5: %1").arg(md5), Logger::Debug);
+}
 
-	if (!m_addQuery.exec()) {
-		log(QStringLiteral("Error adding MD5 to the database: %1").arg(m_addQuery.lastError().text()), Logger::Error);
-	} else {
-		log(QString("Added MD5: %1").arg(md5), Logger::Debug);
+/**
+ * Commits all the MD5s in a single transaction, instead of one every 100 operations.
+ */
+void Md5DatabaseSqlite::addAll(const QList<QPair<QString, QString>> &md5s)
+{
+	for (const auto &md5 : md5s) {
+		if (!md5.first.isEmpty() && !lookup(md5.first).contains(md5.second)) {
+			m_pending.append(PendingOperation { true, md5.first, md5.second });
+			addToFilter(md5.first);
+		}
 	}
+
+	flush();
+	log(QStringLiteral("Added %1 MD5s").arg(md5s.count()), Logger::Debug);
 }
 
 void Md5DatabaseSqlite::remove(const QString &md5, const QString &path)
 {
-	QSqlQuery &query = path.isEmpty() ? m_deleteAllQuery : m_deleteQuery;
+	queue(false, md5, path);
+}
+
+/**
+ * Applies the operations not yet committed to the database to a list of paths of an MD5.
+ */
+void Md5DatabaseSqlite::applyPending(const QString &md5, QStringList &paths) const
+{
+	for (const PendingOperation &op : m_pending) {
+		if (op.md5 != md5) {
+			continue;
+		}
+		if (op.add) {
+			paths.append(op.path);
+		} else if (op.path.isEmpty()) {
+			paths.clear();
+		} else {
+			paths.removeAll(op.path);
+		}
+	}
+}
+
+QStringList Md5DatabaseSqlite::paths(const QString &md5)
+{
+	QStringList ret = storedPaths(md5);
+	applyPending(md5, ret);
+	return ret;
+}
 
-	query.bindValue(":md5", md5);
-	if (!path.isEmpty()) {
-		query.bindValue(":path", path);
+void Md5DatabaseSqlite::listMd5s(const std::function<void(const QString &md5)> &callback)
+{
+	QSqlQuery query(m_database);
+	query.setForwardOnly(true);
+	if (!query.exec(QStringLiteral("SELECT md5 FROM md5s"))) {
+		log(QStringLiteral("Error listing MD5s from the database: %1").arg(query.lastError().text()), Logger::Error);
+	}
+	while (query.next()) {
+		callback(query.value(0).toString());
 	}
 
-	if (!query.exec()) {
-		log(QStringLiteral("Error removing MD5 from the database: %1").arg(query.lastError().text()), Logger::Error);
+	for (const PendingOperation &op : qAsConst(m_pending)) {
+		if (op.add) {
+			callback(op.md5);
+		}
 	}
 }
 
-QStringList Md5DatabaseSqlite::paths(const QString &md5)
+QStringList Md5DatabaseSqlite::storedPaths(const QString &md5) const
 {
 	QStringList ret;
 
@@ -105,6 +223,64 @@ QStringList Md5DatabaseSqlite::paths(const QString &md5)
 	return ret;
 }
 
+/**
+ * Look for all the MD5s in a few queries, instead of one for each MD5.
+ */
+QSet<QString> Md5DatabaseSqlite::known(const QStringList &input)
+{
+	QSet<QString> ret;
+
+	// Only look for the MD5s that may be in the database
+	QStringList md5s;
+	for (const QString &md5 : input) {
+		if (!md5.isEmpty() && mayContain(md5)) {
+			md5s.append(md5);
+		}
+	}
+
+	// SQLite limits the number of bound parameters of a query, so we split large lists
+	for (int start = 0; start < md5s.count(); start += KNOWN_CHUNK_SIZE) {
+		const QStringList chunk = md5s.mid(start, KNOWN_CHUNK_SIZE);
+
+		QStringList placeholders;
+		placeholders.reserve(chunk.count());
+		for (int i = 0; i < chunk.count(); ++i) {
+			placeholders.append(QStringLiteral("?"));
+		}
+
+		QSqlQuery query(m_database);
+		query.prepare(QStringLiteral("SELECT DISTINCT md5 FROM md5s WHERE md5 IN (%1)").arg(placeholders.join(',')));
+		for (const QString &md5 : chunk) {
+			query.addBindValue(md5);
+		}
+		if (!query.exec()) {
+			log(QStringLiteral("Error getting MD5s from the database: %1").arg(query.lastError().text()), Logger::Error);
+			return Md5Database::known(md5s);
+		}
+		while (query.next()) {
+			ret.insert(query.value(0).toString());
+		}
+	}
+
+	// Account for the operations not committed yet
+	QSet<QString> changed;
+	for (const PendingOperation &op : qAsConst(m_pending)) {
+		changed.insert(op.md5);
+	}
+	for (const QString &md5 : md5s) {
+		if (changed.contains(md5)) {
+			if (paths(md5).isEmpty()) {
+				ret.remove(md5);
+			} else {
+				ret.insert(md5);
+			}
+		}
+	}
+	ret.remove(QString());
+
+	return ret;
+}
+
 int Md5DatabaseSqlite::count() const
 {
 	if (!m_countQuery.exec()) {
@@ -114,11 +290,30 @@ int Md5DatabaseSqlite::count() const
 
 	int idVal = m_countQuery.record().indexOf("cnt");
 	m_countQuery.next();
-	return m_countQuery.value(idVal).toInt();
+	int count = m_countQuery.value(idVal).toInt();
+
+	// Account for the operations not committed yet
+	QSet<QString> changed;
+	for (const PendingOperation &op : m_pending) {
+		changed.insert(op.md5);
+	}
+	for (const QString &md5 : changed) {
+		const QStringList stored = storedPaths(md5);
+		QStringList current = stored;
+		applyPending(md5, current);
+		count += current.count() - stored.count();
+	}
+
+	return count;
 }
 
 void Md5DatabaseSqlite::setMd5s(const QMultiHash<QString, QString> &md5s)
 {
+	// Pending operations would be overridden anyway
+	m_pending.clear();
+	m_flushTimer.stop();
+	resetFilter();
+
 	// Empty the database first
 	QSqlQuery clearQuery(m_database);
 	clearQuery.prepare(QStringLiteral("DELETE FROM md5s"));
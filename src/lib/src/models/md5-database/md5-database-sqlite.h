@@ -7,6 +7,8 @@
 #include <QSqlQuery>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
+#include <QVector>
 
 
 class QSettings;
@@ -21,13 +23,36 @@ class Md5DatabaseSqlite : public Md5Database
 
 		void sync() override;
 		void add(const QString &md5, const QString &path) override;
+		void addAll(const QList<QPair<QString, QString>> &md5s) override;
 		void remove(const QString &md5, const QString &path = {}) override;
 		int count() const override;
+		QSet<QString> known(const QStringList &md5s) override;
 
 		void setMd5s(const QMultiHash<QString, QString> &md5s);
 
 	protected:
 		QStringList paths(const QString &md5) override;
+		void listMd5s(const std::function<void(const QString &md5)> &callback) override;
+
+		/**
+		 * Write operation waiting to be committed to the database.
+		 */
+		struct PendingOperation
+		{
+			bool add;
+			QString md5;
+			QString path; // Empty to remove all the paths of an MD5
+		};
+
+		QStringList storedPaths(const QString &md5) const;
+		void applyPending(const QString &md5, QStringList &paths) const;
+		void queue(bool add, const QString &md5, const QString &path);
+
+	protected slots:
+		void flush();
+
+	signals:
+		void flushed();
 
 	private:
 		QString m_path;
@@ -37,6 +62,8 @@ class Md5DatabaseSqlite : public Md5Database
 		mutable QSqlQuery m_deleteQuery;
 		mutable QSqlQuery m_deleteAllQuery;
 		mutable QSqlQuery m_countQuery;
+		QTimer m_flushTimer;
+		QVector<PendingOperation> m_pending;
 };
 
 #endif // MD5_DATABASE_SQLITE_H
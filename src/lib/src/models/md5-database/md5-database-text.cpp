@@ -2,31 +2,42 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QSettings>
+#include <QtConcurrentRun>
 #include <utility>
 #include "logger.h"
 
+#define MD5_LENGTH 32
+
 
 Md5DatabaseText::Md5DatabaseText(QString path, QSettings *settings)
 	: Md5Database(settings), m_path(std::move(path)), m_flushTimer(this)
 {
+	m_compactRatio = m_settings->value("md5_compact_ratio", 0.5).toDouble();
+	m_compactMinLines = m_settings->value("md5_compact_min_lines", 10000).toInt();
+
 	// Read all MD5 from the database and load them in memory
 	log("Start loading MD5 database");
 	QFile fileMD5(m_path);
 	if (fileMD5.open(QFile::ReadOnly | QFile::Text)) {
 		QString line;
 		while (!(line = fileMD5.readLine()).isEmpty()) {
-			m_md5s.insert(line.left(32), line.mid(32).trimmed());
+			applyLine(m_md5s, line);
+			m_fileLines++;
 		}
 
 		fileMD5.close();
 	}
-	log(QString("MD5 database loaded (%1 entries)").arg(m_md5s.count()));
+	log(QString("MD5 database loaded (%1 entries, %2 lines)").arg(m_md5s.count()).arg(m_fileLines));
 
 	// Connect the timer to the flush slot
 	m_flushTimer.setSingleShot(true);
 	m_flushTimer.setInterval(m_settings->value("md5_flush_interval", 1000).toInt());
 	connect(&m_flushTimer, &QTimer::timeout, this, &Md5DatabaseText::flush);
+
+	// The file might have accumulated garbage during the previous runs
+	startCompaction();
 }
 
 Md5DatabaseText::~Md5DatabaseText()
@@ -36,7 +47,27 @@ Md5DatabaseText::~Md5DatabaseText()
 
 
 /**
- * Appends the newly-added MD5s to the MD5 file.
+ * Apply a line of the MD5 file, which is either an addition or a "-" prefixed removal.
+ * Removals without a path remove all the paths of the MD5.
+ */
+void Md5DatabaseText::applyLine(QMultiHash<QString, QString> &md5s, const QString &line)
+{
+	if (line.startsWith('-')) {
+		const QString md5 = line.mid(1, MD5_LENGTH);
+		const QString path = line.mid(1 + MD5_LENGTH).trimmed();
+		if (path.isEmpty()) {
+			md5s.remove(md5);
+		} else {
+			md5s.remove(md5, path);
+		}
+		return;
+	}
+
+	md5s.insert(line.left(MD5_LENGTH), line.mid(MD5_LENGTH).trimmed());
+}
+
+/**
+ * Appends the pending changes to the MD5 file.
  */
 void Md5DatabaseText::flush()
 {
@@ -46,37 +77,43 @@ void Md5DatabaseText::flush()
 
 	QFile fileMD5(m_path);
 	if (fileMD5.open(QFile::Text | QFile::WriteOnly | QFile::Append)) {
-		for (auto it = m_pendingAdd.begin(); it != m_pendingAdd.end(); ++it) {
-			fileMD5.write(QString(it.key() + it.value() + "\n").toUtf8());
+		for (const QString &line : qAsConst(m_pendingLines)) {
+			fileMD5.write(QString(line + "\n").toUtf8());
 		}
+		m_fileLines += m_pendingLines.count();
 
 		fileMD5.close();
 	}
 
-	m_pendingAdd.clear();
+	m_pendingLines.clear();
 	emit flushed();
+
+	startCompaction();
 }
 
 /**
- * Rewrites the whole contents of the MD5 file with the current database.
+ * Writes all pending changes to the MD5 file, waiting for any running compaction to finish first.
  */
 void Md5DatabaseText::sync()
 {
-	if (m_path.isEmpty()) {
-		return;
-	}
+	waitForCompaction();
 
-	QFile fileMD5(m_path);
-	if (fileMD5.open(QFile::Text | QFile::WriteOnly | QFile::Truncate)) {
-		for (auto it = m_md5s.begin(); it != m_md5s.end(); ++it) {
-			fileMD5.write(QString(it.key() + it.value() + "\n").toUtf8());
-		}
-
-		fileMD5.close();
+	m_flushTimer.stop();
+	if (!m_pendingLines.isEmpty()) {
+		flush();
+		waitForCompaction();
 	}
+}
 
-	m_pendingAdd.clear();
-	m_flushTimer.stop();
+void Md5DatabaseText::queueLine(const QString &line)
+{
+	m_pendingLines.append(line);
+	if (m_pendingLines.count() >= 100) {
+		m_flushTimer.stop();
+		flush();
+	} else {
+		m_flushTimer.start();
+	}
 }
 
 /**
@@ -91,31 +128,155 @@ void Md5DatabaseText::add(const QString &md5, const QString &path)
 	}
 
 	m_md5s.insert(md5, path);
+	addToFilter(md5);
 	log(QString("Added MD5: %1").arg(md5), Logger::Debug);
 
 	// Add MD5 to the "waiting to be saved" list
-	m_pendingAdd.insert(md5, path);
-	if (m_pendingAdd.count() >= 100) {
-		m_flushTimer.stop();
-		flush();
-	} else {
-		m_flushTimer.start();
-	}
+	queueLine(md5 + path);
 }
 
 /**
- * Removes a md5 from the _md5 map and removes it from the md5 file.
+ * Removes a md5 from the _md5 map, and appends a tombstone to the md5 file.
  * @param	md5		The md5 to remove.
+ * @param	path	The path to remove, or an empty string to remove all the paths of this md5.
  */
 void Md5DatabaseText::remove(const QString &md5, const QString &path)
 {
-	if (path.isEmpty()) {
-		m_md5s.remove(md5);
+	const int removed = path.isEmpty()
+		? m_md5s.remove(md5)
+		: m_md5s.remove(md5, path);
+
+	if (removed > 0) {
+		queueLine("-" + md5 + path);
+	}
+}
+
+
+void Md5DatabaseText::compact()
+{
+	startCompaction(true);
+}
+
+/**
+ * Rewrite the file without its garbage in a worker thread, if it contains too much of it.
+ *
+ * The worker only reads the part of the file written so far, so the main thread can keep appending changes to it in
+ * the meantime. Once the worker is done, these changes are copied to the end of the new file, which then atomically
+ * replaces the current one.
+ */
+void Md5DatabaseText::startCompaction(bool force)
+{
+	if (m_path.isEmpty() || m_compactWatcher != nullptr) {
+		return;
+	}
+
+	const int garbage = m_fileLines - m_md5s.count();
+	if (!force && (m_fileLines < m_compactMinLines || garbage <= 0 || garbage < m_compactRatio * m_fileLines)) {
+		return;
+	}
+
+	m_compactOffset = QFileInfo(m_path).size();
+	m_compactFileLines = m_fileLines;
+
+	m_compactTarget = new QSaveFile(m_path);
+	if (!m_compactTarget->open(QFile::WriteOnly)) {
+		log(QStringLiteral("Could not open the file to compact the MD5 database into: %1").arg(m_compactTarget->errorString()), Logger::Error);
+		delete m_compactTarget;
+		m_compactTarget = nullptr;
+		return;
+	}
+
+	log(QStringLiteral("Compacting MD5 database (%1 entries, %2 lines)").arg(m_md5s.count()).arg(m_fileLines), Logger::Debug);
+
+	const QString source = m_path;
+	const qint64 size = m_compactOffset;
+	QSaveFile *target = m_compactTarget;
+	m_compactWatcher = new QFutureWatcher<int>(this);
+	connect(m_compactWatcher, &QFutureWatcher<int>::finished, this, &Md5DatabaseText::compactionFinished);
+	m_compactWatcher->setFuture(QtConcurrent::run([source, size, target]() {
+		return compactFile(source, size, target);
+	}));
+}
+
+void Md5DatabaseText::waitForCompaction()
+{
+	if (m_compactWatcher == nullptr) {
+		return;
+	}
+
+	m_compactWatcher->waitForFinished();
+	compactionFinished();
+}
+
+void Md5DatabaseText::compactionFinished()
+{
+	const int lines = m_compactWatcher->result();
+	m_compactWatcher->disconnect(this);
+	m_compactWatcher->deleteLater();
+	m_compactWatcher = nullptr;
+
+	// Copy the changes appended since the compaction started
+	bool ok = lines >= 0;
+	if (ok) {
+		QFile fileMD5(m_path);
+		if (fileMD5.open(QFile::ReadOnly) && fileMD5.seek(m_compactOffset)) {
+			const QByteArray tail = fileMD5.readAll();
+			ok = m_compactTarget->write(tail) == tail.size();
+		} else {
+			ok = false;
+		}
+	}
+
+	if (ok && m_compactTarget->commit()) {
+		log(QStringLiteral("MD5 database compacted (%1 lines instead of %2)").arg(lines + m_fileLines - m_compactFileLines).arg(m_fileLines), Logger::Debug);
+		m_fileLines = lines + (m_fileLines - m_compactFileLines);
 	} else {
-		m_md5s.remove(md5, path);
+		log(QStringLiteral("Could not compact the MD5 database `%1`").arg(m_path), Logger::Error);
+		m_compactTarget->cancelWriting();
+
+		// Don't retry on every flush
+		m_compactMinLines = qMax(m_compactMinLines, m_fileLines * 2);
+	}
+
+	delete m_compactTarget;
+	m_compactTarget = nullptr;
+
+	emit compacted();
+}
+
+/**
+ * Write the live entries of the first bytes of an MD5 file to another file.
+ * @return The number of lines written, or -1 on error.
+ */
+int Md5DatabaseText::compactFile(const QString &source, qint64 size, QIODevice *target)
+{
+	QFile file(source);
+	if (!file.open(QFile::ReadOnly)) {
+		return -1;
+	}
+
+	QMultiHash<QString, QString> md5s;
+	while (file.pos() < size) {
+		const QByteArray line = file.readLine();
+		if (line.isEmpty()) {
+			break;
+		}
+		applyLine(md5s, QString::fromUtf8(line));
+	}
+
+	int lines = 0;
+	for (auto it = md5s.constBegin(); it != md5s.constEnd(); ++it) {
+		const QByteArray line = QString(it.key() + it.value() + "\n").toUtf8();
+		if (target->write(line) != line.size()) {
+			return -1;
+		}
+		lines++;
 	}
+
+	return lines;
 }
 
+
 /**
  * Returns all file paths associated to a given md5.
  * @param	md5		The md5 to look for.
@@ -125,6 +286,13 @@ QStringList Md5DatabaseText::paths(const QString &md5)
 	return m_md5s.values(md5);
 }
 
+void Md5DatabaseText::listMd5s(const std::function<void(const QString &md5)> &callback)
+{
+	for (auto it = m_md5s.constBegin(); it != m_md5s.constEnd(); ++it) {
+		callback(it.key());
+	}
+}
+
 int Md5DatabaseText::count() const
 {
 	return m_md5s.count();
@@ -2,14 +2,24 @@
 #define MD5_DATABASE_TEXT_H
 
 #include "models/md5-database/md5-database.h"
+#include <QFutureWatcher>
 #include <QMultiHash>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
 
 
+class QIODevice;
+class QSaveFile;
 class QSettings;
 
+/**
+ * MD5 database stored as a text file of "md5path" lines, all loaded in memory.
+ *
+ * The file is an append-only log: additions are appended as is, and removals are appended as "-md5path" tombstones.
+ * Once the ratio of lines that don't match a live entry gets too high, the file is compacted in a worker thread and
+ * atomically replaced.
+ */
 class Md5DatabaseText : public Md5Database
 {
 	Q_OBJECT
@@ -25,20 +35,43 @@ class Md5DatabaseText : public Md5Database
 
 		const QMultiHash<QString, QString> &getAll() const;
 
+		/**
+		 * Start compacting the file in the background, even if it doesn't contain much garbage.
+		 */
+		void compact();
+
 	protected:
 		QStringList paths(const QString &md5) override;
+		void listMd5s(const std::function<void(const QString &md5)> &callback) override;
+		void queueLine(const QString &line);
+		void startCompaction(bool force = false);
+		void waitForCompaction();
+
+		static void applyLine(QMultiHash<QString, QString> &md5s, const QString &line);
+		static int compactFile(const QString &source, qint64 size, QIODevice *target);
 
 	protected slots:
 		void flush();
+		void compactionFinished();
 
 	signals:
 		void flushed();
+		void compacted();
 
 	private:
 		QString m_path;
 		QMultiHash<QString, QString> m_md5s;
 		QTimer m_flushTimer;
-		QMultiHash<QString, QString> m_pendingAdd;
+		QStringList m_pendingLines;
+		int m_fileLines = 0;
+
+		// Compaction
+		double m_compactRatio;
+		int m_compactMinLines;
+		QFutureWatcher<int> *m_compactWatcher = nullptr;
+		QSaveFile *m_compactTarget = nullptr;
+		qint64 m_compactOffset = 0;
+		int m_compactFileLines = 0;
 };
 
 #endif // MD5_DATABASE_TEXT_H
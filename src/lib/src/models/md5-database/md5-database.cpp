@@ -3,6 +3,9 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QSettings>
+#include "logger.h"
+
+#define FILTER_MIN_CAPACITY 10000
 
 
 Md5Database::Md5Database(QSettings *settings)
@@ -10,16 +13,95 @@ Md5Database::Md5Database(QSettings *settings)
 {}
 
 
+/**
+ * MD5s are already uniformly distributed, so the two halves of the digest can be used directly as hash.
+ */
+static quint64 filterHash(const QString &md5)
+{
+	if (md5.length() == 32) {
+		bool okLeft, okRight;
+		const quint64 left = md5.leftRef(16).toULongLong(&okLeft, 16);
+		const quint64 right = md5.midRef(16).toULongLong(&okRight, 16);
+		if (okLeft && okRight) {
+			return left ^ right;
+		}
+	}
+
+	const QString key = md5.toLower();
+	return (static_cast<quint64>(qHash(key, 0x9e3779b9)) << 32) | qHash(key, 0);
+}
+
+/**
+ * The filter is built on the first lookup, with enough capacity for the database to double in size, after which it
+ * is built again.
+ */
+bool Md5Database::mayContain(const QString &md5)
+{
+	if (!m_filterBuilt) {
+		m_filter = BloomFilter(qMax(count() * 2, FILTER_MIN_CAPACITY));
+		m_filterBuilt = true;
+		listMd5s([this](const QString &known) {
+			m_filter.add(filterHash(known));
+		});
+		log(QStringLiteral("MD5 filter built (%1 entries)").arg(m_filter.count()), Logger::Debug);
+	}
+
+	return m_filter.mayContain(filterHash(md5));
+}
+
+QStringList Md5Database::lookup(const QString &md5)
+{
+	if (!mayContain(md5)) {
+		return {};
+	}
+	return paths(md5);
+}
+
+void Md5Database::addToFilter(const QString &md5)
+{
+	if (!m_filterBuilt) {
+		return;
+	}
+
+	m_filter.add(filterHash(md5));
+	if (m_filter.count() > m_filter.capacity()) {
+		resetFilter();
+	}
+}
+
+void Md5Database::resetFilter()
+{
+	m_filter = BloomFilter();
+	m_filterBuilt = false;
+}
+
+
+void Md5Database::addAll(const QList<QPair<QString, QString>> &md5s)
+{
+	for (const auto &md5 : md5s) {
+		add(md5.first, md5.second);
+	}
+}
+
+QSet<QString> Md5Database::known(const QStringList &md5s)
+{
+	QSet<QString> ret;
+	for (const QString &md5 : md5s) {
+		if (!md5.isEmpty() && !lookup(md5).isEmpty()) {
+			ret.insert(md5);
+		}
+	}
+	return ret;
+}
+
 QPair<QString, QString> Md5Database::action(const QString &md5, const QString &target)
 {
-	// If the MD5 is not found, just save the image
-	if (md5.isEmpty() || paths(md5).isEmpty()) {
+	// Get all existing paths for this MD5, and if it is not found, just save the image
+	const QStringList pths = !md5.isEmpty() ? lookup(md5) : QStringList();
+	if (pths.isEmpty()) {
 		return { "save", "" };
 	}
 
-	// Get all existing paths for this MD5
-	const QStringList pths = paths(md5);
-
 	// Split paths into "same dir" and "not same dir"
 	QStringList sameDirPaths, notSameDirPaths;
 	const QDir targetDir = QFileInfo(target).dir();
@@ -92,7 +174,7 @@ QStringList Md5Database::exists(const QString &md5)
 
 	const bool keepDeleted = m_settings->value("Save/keepDeletedMd5", false).toBool();
 
-	const QStringList pths = paths(md5);
+	const QStringList pths = lookup(md5);
 	for (const QString &path : pths) {
 		if (QFile::exists(path) || keepDeleted) {
 			ret.append(path);
@@ -1,9 +1,13 @@
 #ifndef MD5_DATABASE_H
 #define MD5_DATABASE_H
 
+#include <QList>
 #include <QObject>
 #include <QPair>
+#include <QSet>
 #include <QString>
+#include <functional>
+#include "utils/bloom-filter.h"
 
 
 class QSettings;
@@ -18,8 +22,19 @@ class Md5Database : public QObject
 		QPair<QString, QString> action(const QString &md5, const QString &target);
 		QStringList exists(const QString &md5);
 
+		/**
+		 * Get which of the given MD5s are in the database at all, without checking that their files still exist.
+		 */
+		virtual QSet<QString> known(const QStringList &md5s);
+
 		virtual void sync() = 0;
 		virtual void add(const QString &md5, const QString &path) = 0;
+
+		/**
+		 * Add many MD5/path pairs at once, allowing the database to write them in a single batch.
+		 */
+		virtual void addAll(const QList<QPair<QString, QString>> &md5s);
+
 		virtual void remove(const QString &md5, const QString &path = {}) = 0;
 		virtual int count() const = 0;
 
@@ -27,8 +42,29 @@ class Md5Database : public QObject
 		QPair<QString, QString> action(const QString &md5, const QStringList &paths, QString action);
 		virtual QStringList paths(const QString &md5) = 0;
 
+		/**
+		 * Call the given function once or more for each MD5 in the database, to build the filter.
+		 */
+		virtual void listMd5s(const std::function<void(const QString &md5)> &callback) = 0;
+
+		/**
+		 * Same as paths(), but without querying the backend at all for MD5s the filter knows are not in the database.
+		 */
+		QStringList lookup(const QString &md5);
+
+		/**
+		 * Whether the MD5 can be in the database. Backends shared with other processes can't rely on a local filter.
+		 */
+		virtual bool mayContain(const QString &md5);
+		void addToFilter(const QString &md5);
+		void resetFilter();
+
 	protected:
 		QSettings *m_settings;
+
+	private:
+		BloomFilter m_filter;
+		bool m_filterBuilt = false;
 };
 
 #endif // MD5_DATABASE_H
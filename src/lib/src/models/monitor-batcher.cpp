@@ -0,0 +1,68 @@
+#include "models/monitor-batcher.h"
+#include "models/api/api.h"
+#include "models/search-query/search-query.h"
+#include "models/site.h"
+#include "search/ast/search-node-op.h"
+#include "search/ast/search-node-tag.h"
+#include "search/search-format.h"
+#include "search/search-format-visitor.h"
+#include "tags/tag.h"
+
+
+QString MonitorBatcher::batchTag(const SearchQuery &query, const QStringList &postFiltering)
+{
+	if (!query.gallery.isNull() || query.tags.count() != 1 || !postFiltering.isEmpty()) {
+		return QString();
+	}
+
+	// Only plain tags can be combined and found back in the images' tags
+	const QString &tag = query.tags.first();
+	if (tag.isEmpty() || tag.startsWith('-') || tag.startsWith('~') || tag.contains(':') || tag.contains('*')) {
+		return QString();
+	}
+
+	return tag;
+}
+
+QString MonitorBatcher::orSearch(const SearchFormat &format, const QStringList &tags)
+{
+	if (tags.isEmpty() || (format.orOp().separator.isEmpty() && format.orOp().prefix.isEmpty())) {
+		return QString();
+	}
+
+	SearchNode *search = new SearchNodeTag(Tag(tags.first()));
+	for (int i = 1; i < tags.count(); ++i) {
+		search = new SearchNodeOp(SearchNodeOp::Or, search, new SearchNodeTag(Tag(tags[i])));
+	}
+
+	// A single tag is not an "OR" operation and would not get the operator's prefix
+	const QString ret = tags.count() > 1
+		? SearchFormatVisitor(format).run(*search)
+		: QString();
+
+	delete search;
+	return ret;
+}
+
+QString MonitorBatcher::orSearch(Site *site, const QStringList &tags)
+{
+	for (Api *api : site->getApis()) {
+		const QString search = orSearch(api->searchFormat(), tags);
+		if (!search.isEmpty()) {
+			return search;
+		}
+	}
+	return QString();
+}
+
+bool MonitorBatcher::hasTag(const QList<Tag> &tags, const QString &tag)
+{
+	// Tags are stored with underscores instead of spaces
+	const QString normalized = QString(tag).replace(' ', '_');
+	for (const Tag &t : tags) {
+		if (QString::compare(t.text(), normalized, Qt::CaseInsensitive) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
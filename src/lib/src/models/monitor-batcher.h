@@ -0,0 +1,40 @@
+#ifndef MONITOR_BATCHER_H
+#define MONITOR_BATCHER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+class SearchFormat;
+class SearchQuery;
+class Site;
+class Tag;
+
+/**
+ * Helpers to check several monitors of the same site using a single search.
+ *
+ * Monitors watching a single plain tag can be grouped into one "OR" search on sites supporting it (for example
+ * "~tag1 ~tag2" on Danbooru). The images returned are then dispatched back to each monitor using their tags.
+ */
+class MonitorBatcher
+{
+	public:
+		/**
+		 * The tag watched by a monitor if it can be checked along others, or an empty string if it must be checked alone.
+		 */
+		static QString batchTag(const SearchQuery &query, const QStringList &postFiltering);
+
+		/**
+		 * Build a search returning the images having any of the given tags, or an empty string if not supported.
+		 */
+		static QString orSearch(const SearchFormat &format, const QStringList &tags);
+		static QString orSearch(Site *site, const QStringList &tags);
+
+		/**
+		 * Whether a tag watched by a monitor is in an image's tag list.
+		 */
+		static bool hasTag(const QList<Tag> &tags, const QString &tag);
+};
+
+#endif // MONITOR_BATCHER_H
@@ -1,64 +1,49 @@
 #include "models/monitor-manager.h"
-#include <QByteArray>
-#include <QFile>
-#include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <utility>
 #include "models/monitor.h"
 
 
 MonitorManager::MonitorManager(QString file, Profile *profile)
-	: m_file(std::move(file)), m_profile(profile)
-{
-	load();
-}
+	: m_profile(profile), m_file(std::move(file), "monitors")
+{}
 
 void MonitorManager::load()
 {
-	QFile file(m_file);
-	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+	if (m_loaded) {
 		return;
 	}
+	m_loaded = true;
 
-	const QByteArray data = file.readAll();
-	QJsonDocument loadDoc = QJsonDocument::fromJson(data);
-	QJsonObject object = loadDoc.object();
-
-	QJsonArray monitors = object["monitors"].toArray();
-	for (const auto &monitorJson : monitors) {
-		m_monitors.append(Monitor::fromJson(monitorJson.toObject(), m_profile));
+	const QList<QJsonObject> monitors = m_file.load();
+	m_monitors.reserve(monitors.count());
+	for (const QJsonObject &monitorJson : monitors) {
+		m_monitors.append(Monitor::fromJson(monitorJson, m_profile));
 	}
 }
 
 void MonitorManager::save() const
 {
-	QFile file(m_file);
-	if (!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
+	// Nothing can have changed if the monitors were never loaded
+	if (!m_loaded) {
 		return;
 	}
 
-	// Generate JSON array
-	QJsonArray monitorsJson;
+	QList<QJsonObject> monitorsJson;
+	monitorsJson.reserve(m_monitors.count());
 	for (const Monitor &monitor : m_monitors) {
 		QJsonObject unique;
 		monitor.toJson(unique);
 		monitorsJson.append(unique);
 	}
 
-	// Generate result
-	QJsonObject full;
-	full["version"] = 1;
-	full["monitors"] = monitorsJson;
-
-	// Write result
-	QJsonDocument saveDoc(full);
-	file.write(saveDoc.toJson());
-	file.close();
+	m_file.save(monitorsJson);
 }
 
 void MonitorManager::add(const Monitor &monitor, int index)
 {
+	load();
+
 	if (index < 0) {
 		index = m_monitors.count();
 	}
@@ -70,6 +55,8 @@ void MonitorManager::add(const Monitor &monitor, int index)
 
 int MonitorManager::remove(const Monitor &monitor)
 {
+	load();
+
 	int index = m_monitors.indexOf(monitor);
 	if (index != -1) {
 		emit removed(index);
@@ -82,5 +69,6 @@ int MonitorManager::remove(const Monitor &monitor)
 
 QList<Monitor> &MonitorManager::monitors()
 {
+	load();
 	return m_monitors;
 }
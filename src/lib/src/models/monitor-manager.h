@@ -4,11 +4,18 @@
 #include <QList>
 #include <QObject>
 #include <QString>
+#include "utils/json-record-file.h"
 
 
 class Monitor;
 class Profile;
 
+/**
+ * List of the monitors of a profile.
+ *
+ * They are only loaded when first needed, and saving only writes the monitors that changed since the last save,
+ * so that updating their state after each check does not rewrite the whole list.
+ */
 class MonitorManager : public QObject
 {
 	Q_OBJECT
@@ -27,8 +34,9 @@ class MonitorManager : public QObject
 		void removed(int index);
 
 	private:
-		QString m_file;
 		Profile *m_profile;
+		mutable JsonRecordFile m_file;
+		bool m_loaded = false;
 		QList<Monitor> m_monitors;
 };
 
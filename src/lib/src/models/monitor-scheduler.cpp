@@ -0,0 +1,87 @@
+#include "models/monitor-scheduler.h"
+#include <QCryptographicHash>
+#include <QString>
+#include <algorithm>
+
+
+qint64 MonitorScheduler::jitter(const QString &seed, int interval, double ratio)
+{
+	const qint64 max = static_cast<qint64>(interval * ratio);
+	if (max <= 0) {
+		return 0;
+	}
+
+	// qHash() is seeded differently on each run, so use a real hash to keep the jitter stable across restarts
+	const QByteArray hash = QCryptographicHash::hash(seed.toUtf8(), QCryptographicHash::Md5);
+	quint32 value = 0;
+	for (int i = 0; i < 4; ++i) {
+		value = (value << 8) | static_cast<quint8>(hash[i]);
+	}
+	return static_cast<qint64>(value % static_cast<quint64>(max + 1));
+}
+
+/**
+ * Ordering of the heap, so that the soonest monitor is first, then the lowest key when equal.
+ */
+bool MonitorScheduler::later(const Entry &a, const Entry &b)
+{
+	return a.secs > b.secs || (a.secs == b.secs && a.key > b.key);
+}
+
+void MonitorScheduler::add(int key, qint64 secsToNextCheck)
+{
+	m_heap.append(Entry { secsToNextCheck, key });
+	std::push_heap(m_heap.begin(), m_heap.end(), later);
+}
+
+void MonitorScheduler::clear()
+{
+	m_heap.clear();
+}
+
+bool MonitorScheduler::isEmpty() const
+{
+	return m_heap.isEmpty();
+}
+
+int MonitorScheduler::count() const
+{
+	return m_heap.count();
+}
+
+QList<int> MonitorScheduler::takeDue(int max)
+{
+	QList<int> ret;
+	while (!m_heap.isEmpty() && m_heap.first().secs <= 0 && (max < 0 || ret.count() < max)) {
+		ret.append(m_heap.first().key);
+		std::pop_heap(m_heap.begin(), m_heap.end(), later);
+		m_heap.removeLast();
+	}
+	return ret;
+}
+
+qint64 MonitorScheduler::secsToNext() const
+{
+	return m_heap.isEmpty() ? 0 : m_heap.first().secs;
+}
+
+int MonitorScheduler::dueCount() const
+{
+	return dueCount(0);
+}
+
+/**
+ * Only the sub-trees whose root is due can contain due monitors, so this is proportional to the number of due ones.
+ */
+int MonitorScheduler::dueCount(int index) const
+{
+	if (index >= m_heap.count() || m_heap[index].secs > 0) {
+		return 0;
+	}
+	return 1 + dueCount(2 * index + 1) + dueCount(2 * index + 2);
+}
+
+qint64 MonitorScheduler::lag() const
+{
+	return m_heap.isEmpty() || m_heap.first().secs > 0 ? 0 : -m_heap.first().secs;
+}
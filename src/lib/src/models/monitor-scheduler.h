@@ -0,0 +1,71 @@
+#ifndef MONITOR_SCHEDULER_H
+#define MONITOR_SCHEDULER_H
+
+#include <QList>
+#include <QVector>
+
+
+class QString;
+
+/**
+ * Min-heap of monitors keyed on their next check time, giving the due ones without having to sort all of them.
+ *
+ * Monitors are identified by a key chosen by the caller, such as their index in a list. A stable random delay (the "jitter") can be added to each
+ * monitor's check time, so that monitors created or checked at the same time are spread instead of all hitting the
+ * sites at once.
+ */
+class MonitorScheduler
+{
+	public:
+		/**
+		 * Get the stable jitter of a monitor, between zero and the given ratio of its interval.
+		 *
+		 * @param seed A string identifying the monitor, such as its search
+		 */
+		static qint64 jitter(const QString &seed, int interval, double ratio);
+
+		/**
+		 * Add a monitor to the schedule.
+		 *
+		 * @param secsToNextCheck The time before the monitor's next check, in seconds. Negative if already due.
+		 */
+		void add(int key, qint64 secsToNextCheck);
+		void clear();
+		bool isEmpty() const;
+		int count() const;
+
+		/**
+		 * Remove and return the keys of the monitors due now, the most late first.
+		 */
+		QList<int> takeDue(int max = -1);
+
+		/**
+		 * The time before the next monitor expires, in seconds. Negative if one is already due.
+		 */
+		qint64 secsToNext() const;
+
+		/**
+		 * The number of monitors due now.
+		 */
+		int dueCount() const;
+
+		/**
+		 * How late the most late due monitor is, in seconds.
+		 */
+		qint64 lag() const;
+
+	protected:
+		struct Entry
+		{
+			qint64 secs;
+			int key;
+		};
+
+		static bool later(const Entry &a, const Entry &b);
+		int dueCount(int index) const;
+
+	private:
+		QVector<Entry> m_heap;
+};
+
+#endif // MONITOR_SCHEDULER_H
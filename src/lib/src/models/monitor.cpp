@@ -12,14 +12,17 @@ Monitor::Monitor(QList<Site *> sites, int interval, QDateTime lastCheck, bool do
 	: m_sites(std::move(sites)), m_interval(interval), m_delay(delay), m_lastCheck(std::move(lastCheck)), m_cumulated(cumulated), m_preciseCumulated(preciseCumulated), m_download(download), m_pathOverride(std::move(pathOverride)), m_filenameOverride(std::move(filenameOverride)), m_query(std::move(query)), m_postFilters(std::move(postFilters)), m_notify(notify), m_getBlacklisted(getBlacklisted), m_lastState(std::move(lastState)), m_lastStateSince(std::move(lastStateSince)), m_lastStateCount(lastStateCount)
 {}
 
-qint64 Monitor::secsToNextCheck() const
+/**
+ * @param jitter An additional delay in seconds, ignored when the monitor is forced to run
+ */
+qint64 Monitor::secsToNextCheck(qint64 jitter) const
 {
 	if (m_forceRun) {
 		return -1;
 	}
 
 	auto now = QDateTime::currentDateTimeUtc();
-	return now.secsTo(m_lastCheck.addSecs(m_interval));
+	return now.secsTo(m_lastCheck.addSecs(m_interval + jitter));
 }
 
 
@@ -49,6 +52,19 @@ void Monitor::setLastCheck(const QDateTime &lastCheck)
 	m_forceRun = false;
 }
 
+/**
+ * The highest post ID already checked on a site, so that checks can stop as soon as they reach it.
+ * Zero if unknown, in which case images are compared using their date instead.
+ */
+qulonglong Monitor::lastId(Site *site) const
+{
+	return m_lastIds.value(site->url(), 0);
+}
+void Monitor::setLastId(Site *site, qulonglong lastId)
+{
+	m_lastIds[site->url()] = lastId;
+}
+
 int Monitor::cumulated() const
 {
 	return m_cumulated;
@@ -135,6 +151,13 @@ void Monitor::toJson(QJsonObject &json) const
 	json["interval"] = m_interval;
 	json["delay"] = m_delay;
 	json["lastCheck"] = m_lastCheck.toString(Qt::ISODate);
+	if (!m_lastIds.isEmpty()) {
+		QJsonObject lastIds;
+		for (auto it = m_lastIds.constBegin(); it != m_lastIds.constEnd(); ++it) {
+			lastIds[it.key()] = QString::number(it.value());
+		}
+		json["lastIds"] = lastIds;
+	}
 	json["cumulated"] = m_cumulated;
 	json["preciseCumulated"] = m_preciseCumulated;
 	json["download"] = m_download;
@@ -197,7 +220,14 @@ Monitor Monitor::fromJson(const QJsonObject &json, Profile *profile)
 	SearchQuery query;
 	query.read(json["query"].toObject(), profile);
 
-	return Monitor(sites, interval, lastCheck, download, pathOverride, filenameOverride, cumulated, preciseCumulated, query, postFilters, notify, delay, getBlacklisted, lastState, lastStateSince, lastStateCount);
+	Monitor monitor(sites, interval, lastCheck, download, pathOverride, filenameOverride, cumulated, preciseCumulated, query, postFilters, notify, delay, getBlacklisted, lastState, lastStateSince, lastStateCount);
+
+	const QJsonObject lastIds = json["lastIds"].toObject();
+	for (auto it = lastIds.constBegin(); it != lastIds.constEnd(); ++it) {
+		monitor.m_lastIds.insert(it.key(), it.value().toString().toULongLong());
+	}
+
+	return monitor;
 }
 
 
@@ -3,6 +3,7 @@
 
 #include <QDateTime>
 #include <QList>
+#include <QMap>
 #include "models/search-query/search-query.h"
 
 
@@ -13,7 +14,7 @@ class Monitor
 {
 	public:
 		Monitor(QList<Site*> sites, int interval, QDateTime lastCheck, bool download, QString pathOverride, QString filenameOverride, int cumulated = 0, bool preciseCumulated = true, SearchQuery query = {}, QStringList postFilters = {}, bool notify = true, int delay = 0, bool getBlacklisted = false, QString lastState = {}, QDateTime lastStateSince = {}, int lastStateCount = 0);
-		qint64 secsToNextCheck() const;
+		qint64 secsToNextCheck(qint64 jitter = 0) const;
 
 		// Getters and setters
 		QList<Site*> sites() const;
@@ -21,6 +22,8 @@ class Monitor
 		int delay() const;
 		const QDateTime &lastCheck() const;
 		void setLastCheck(const QDateTime &lastCheck);
+		qulonglong lastId(Site *site) const;
+		void setLastId(Site *site, qulonglong lastId);
 		int cumulated() const;
 		bool preciseCumulated() const;
 		void setCumulated(int cumulated, bool isPrecise);
@@ -46,6 +49,7 @@ class Monitor
 		int m_interval; // In seconds
 		int m_delay; // In seconds
 		QDateTime m_lastCheck;
+		QMap<QString, qulonglong> m_lastIds; // Highest post ID already checked, by site URL
 		int m_cumulated;
 		bool m_preciseCumulated;
 		bool m_download;
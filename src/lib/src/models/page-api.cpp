@@ -1,18 +1,29 @@
 #include "models/page-api.h"
-// #include <QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QSet>
 #include <QTimer>
+#include <QtConcurrentRun>
 #include <QtMath>
 #include <utility>
+#include "downloader/header-probe.h"
 #include "functions.h"
 #include "image.h"
 #include "logger.h"
+#include "metrics.h"
 #include "models/api/api.h"
+#include "models/api/parser-thread-pool.h"
 #include "models/filtering/post-filter.h"
 #include "models/page.h"
 #include "models/search-query/search-query.h"
 #include "models/site.h"
+#include "models/source.h"
 #include "network/network-reply.h"
 #include "tags/tag.h"
+#include "tags/tag-counter.h"
+#include "tags/tag-database.h"
+#include "tracer.h"
+
+#define MAX_PRECONNECT_HOSTS 4
 
 
 PageApi::PageApi(Page *parentPage, Profile *profile, Site *site, Api *api, SearchQuery query, int page, int limit, PostFilter postFiltering, bool smart, QObject *parent, int pool, int lastPage, qulonglong lastPageMinId, qulonglong lastPageMaxId, QString lastPageMinDate, QString lastPageMaxDate)
@@ -31,27 +42,59 @@ PageApi::PageApi(Page *parentPage, Profile *profile, Site *site, Api *api, Searc
 	updateUrls();
 }
 
-void PageApi::setLastPage(Page *page)
+PageApi::~PageApi()
+{
+	// The parsing thread still references this page and its parent
+	if (m_parseWatcher != nullptr) {
+		m_parseWatcher->waitForFinished();
+	}
+}
+
+void PageApi::setLastPage(Page *page, bool preferCursor)
 {
 	if (!page->isValid()) {
 		return;
 	}
 
-	m_lastPage = page->page();
-	m_lastPageMaxId = page->maxId();
-	m_lastPageMinId = page->minId();
-	m_lastPageMaxDate = page->maxDate();
-	m_lastPageMinDate = page->minDate();
-
 	if (!page->nextPage().isEmpty() && page->page() == m_page - 1) {
 		m_url = page->nextPage();
 	} else if (!page->prevPage().isEmpty() && page->page() == m_page + 1) {
 		m_url = page->prevPage();
 	}
 
+	setLastPage(page->page(), page->minId(), page->maxId(), page->minDate(), page->maxDate(), preferCursor);
+}
+
+void PageApi::setLastPage(int page, qulonglong minId, qulonglong maxId, const QString &minDate, const QString &maxDate, bool preferCursor)
+{
+	m_preferCursor = preferCursor;
+	m_lastPage = page;
+	m_lastPageMaxId = maxId;
+	m_lastPageMinId = minId;
+	m_lastPageMaxDate = maxDate;
+	m_lastPageMinDate = minDate;
+
 	updateUrls();
 }
 
+/**
+ * ID cursors only give the same results as page numbers when the search is sorted by ID, and the previous page
+ * actually had IDs.
+ */
+bool PageApi::canUseCursor() const
+{
+	if (m_lastPage != m_page - 1 || m_lastPageMinId == 0 || !m_site->setting("search/cursor_pagination", true).toBool()) {
+		return false;
+	}
+
+	for (const QString &tag : m_query.tags) {
+		if (tag.startsWith(QLatin1String("order:"), Qt::CaseInsensitive) || tag.startsWith(QLatin1String("sort:"), Qt::CaseInsensitive)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void PageApi::updateUrls()
 {
 	QString url;
@@ -75,6 +118,7 @@ void PageApi::updateUrls()
 			lastPage.minDate = m_lastPageMinDate;
 			lastPage.maxId = m_lastPageMaxId;
 			lastPage.maxDate = m_lastPageMaxDate;
+			lastPage.preferCursor = m_preferCursor && canUseCursor();
 			ret = m_api->pageUrl(m_query.tags.join(' '), m_page, m_imagesPerPage, lastPage, m_site);
 		}
 
@@ -116,6 +160,13 @@ void PageApi::load(bool rateLimit, bool force)
 		setReply(nullptr);
 	}
 
+	// Discard the results of any parsing still running
+	if (m_parseWatcher != nullptr) {
+		m_parseWatcher->waitForFinished();
+		delete m_parseWatcher;
+		m_parseWatcher = nullptr;
+	}
+
 	if (m_url.isEmpty() && !m_errors.isEmpty()) {
 		for (const QString &err : qAsConst(m_errors)) {
 			log(QStringLiteral("[%1][%2] %3").arg(m_site->url(), m_format, err), Logger::Warning);
@@ -139,6 +190,7 @@ void PageApi::load(bool rateLimit, bool force)
 	Site::QueryType type = rateLimit ? Site::QueryType::Retry : Site::QueryType::List;
 	setReply(m_site->get(m_url, type, QUrl(), "", nullptr, m_headers));
 	connect(m_reply, &NetworkReply::finished, this, &PageApi::parse);
+	Tracer::getInstance().asyncBegin(QStringLiteral("load page"), QStringLiteral("page"), reinterpret_cast<quintptr>(this), QVariantMap { { "url", m_url.toString() } });
 }
 void PageApi::abort()
 {
@@ -172,6 +224,7 @@ void PageApi::parse()
 	if (m_reply == nullptr) {
 		return;
 	}
+	Tracer::getInstance().asyncEnd(QStringLiteral("load page"), QStringLiteral("page"), reinterpret_cast<quintptr>(this));
 
 	log(QStringLiteral("[%1][%2] Receiving page `%3`").arg(m_site->url(), m_format, m_reply->url().toString().toHtmlEscaped()), Logger::Info);
 
@@ -203,21 +256,13 @@ void PageApi::parse()
 		return;
 	}
 
-	// QtConcurrent::run(this, &PageApi::parseActual);
-	parseActual();
-}
-
-void PageApi::parseActual()
-{
 	const bool isGallery = !m_query.gallery.isNull();
 	const bool parseErrors = isGallery ? m_api->parseGalleryErrors() : m_api->parsePageErrors();
-	const int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 	const int offset = (m_page - 1) * m_imagesPerPage;
 
 	// Detect Cloudflare
-	if ((statusCode == 403 || statusCode == 429 || statusCode == 503) && m_reply->rawHeader("server") == "cloudflare") {
+	if (m_site->checkChallenge(m_reply)) {
 		m_errors.append("Cloudflare wall");
-		log(QStringLiteral("[%1][%2] Cloudflare wall for '%3'").arg(m_site->url(), m_format, m_reply->url().toString()), Logger::Error);
 		setReply(nullptr);
 		m_loaded = true;
 		m_loading = false;
@@ -226,11 +271,12 @@ void PageApi::parseActual()
 	}
 
 	// Try to read the reply
-	m_source = m_reply->readAll();
-	if (m_source.isEmpty() || (m_reply->error() != NetworkReply::NetworkError::NoError && !parseErrors)) {
+	const QByteArray data = m_reply->readAll();
+	if (data.isEmpty() || (m_reply->error() != NetworkReply::NetworkError::NoError && !parseErrors)) {
 		if (m_reply->error() != NetworkReply::NetworkError::OperationCanceledError) {
 			log(QStringLiteral("[%1][%2] Loading error: %3 (%4)").arg(m_site->url(), m_format, m_reply->errorString()).arg(m_reply->error()), Logger::Error);
 		}
+		m_source = data;
 		setReply(nullptr);
 		m_loaded = true;
 		m_loading = false;
@@ -238,14 +284,85 @@ void PageApi::parseActual()
 		return;
 	}
 
+	// Lazy-loading the tag database is not thread-safe, so we make sure it is done beforehand
+	m_site->tagDatabase()->load();
+	m_site->getSource()->warmUpEngines();
+
+	// The actual parsing is done in a worker thread, and the results are handled back in this one
+	m_parseWatcher = new QFutureWatcher<ParseResult>(this);
+	connect(m_parseWatcher, &QFutureWatcher<ParseResult>::finished, this, &PageApi::parseFinished);
+	m_parseWatcher->setFuture(QtConcurrent::run(parserThreadPool(), [this, data, statusCode, offset, isGallery]() {
+		return parseActual(data, statusCode, offset, isGallery);
+	}));
+}
+
+PageApi::ParseResult PageApi::parseActual(const QByteArray &data, int statusCode, int offset, bool isGallery) const
+{
+	ParseResult ret;
+	ret.source = data;
+
 	// Parse source
-	ParsedPage page;
+	TraceSpan span(QStringLiteral("parse page"), QStringLiteral("page"), QVariantMap { { "site", m_site->url() } });
+	QElapsedTimer timer;
+	timer.start();
 	if (isGallery) {
-		page = m_api->parseGallery(m_parentPage, m_source, statusCode, offset);
+		ret.page = m_api->parseGallery(m_parentPage, ret.source, statusCode, offset, &m_postFiltering);
 	} else {
-		page = m_api->parsePage(m_parentPage, m_source, statusCode, offset);
+		ret.page = m_api->parsePage(m_parentPage, ret.source, statusCode, offset, &m_postFiltering);
+	}
+	Metrics::getInstance().observe("grabber_page_parse_duration_ms", Metrics::label("site", m_site->url()), timer.elapsed());
+
+	// No value of the Javascript engine is used anymore at this point, so it can safely be cleaned up
+	Source::jsWorkDone(data.size());
+
+	// Remember the tag types given by the page for the next ones
+	m_site->tagDatabase()->cacheTags(ret.page.tags);
+
+	// Generating tokens is the most expensive part of post-filtering, so we do it here
+	if (m_postFiltering.count() > 0) {
+		for (const QSharedPointer<Image> &img : qAsConst(ret.page.images)) {
+			img->tokens(m_profile);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Warm up the connections to the hosts of the thumbnails and files of a page, which are often CDNs that were not
+ * contacted yet, so that the first requests to them don't have to wait for the DNS lookup and handshakes.
+ */
+void PageApi::preconnect(const QList<QSharedPointer<Image>> &images)
+{
+	QSet<QString> hosts;
+	QList<QUrl> urls;
+	for (const QSharedPointer<Image> &img : images) {
+		for (Image::Size size : { Image::Size::Thumbnail, Image::Size::Sample, Image::Size::Full }) {
+			const QUrl &url = img->url(size);
+			if (!url.isEmpty() && !url.host().isEmpty() && !hosts.contains(url.host())) {
+				hosts.insert(url.host());
+				urls.append(url);
+			}
+		}
+		if (urls.count() >= MAX_PRECONNECT_HOSTS) {
+			break;
+		}
 	}
 
+	if (!urls.isEmpty()) {
+		m_site->preconnect(urls);
+	}
+}
+
+void PageApi::parseFinished()
+{
+	const ParseResult result = m_parseWatcher->result();
+	m_parseWatcher->deleteLater();
+	m_parseWatcher = nullptr;
+
+	const ParsedPage &page = result.page;
+	m_source = result.source;
+
 	// Handle errors
 	if (!page.error.isEmpty()) {
 		m_errors.append(page.error);
@@ -267,9 +384,58 @@ void PageApi::parseActual()
 	for (const Tag &tag : qAsConst(page.tags)) {
 		m_tags.append(tag);
 	}
+	m_pageImageCount += page.filteredImageCount;
+	m_filteredImageCount += page.filteredImageCount;
+
+	// Post-filters on file information missing from the listing can use the files' headers instead of their details
+	const QList<QSharedPointer<Image>> toProbe = imagesToProbe(page.images);
+	if (!toProbe.isEmpty()) {
+		auto *probe = new HeaderProbe(m_site, this);
+		connect(probe, &HeaderProbe::finished, this, [this, probe, page]() {
+			probe->deleteLater();
+			addImages(page);
+		}, Qt::QueuedConnection);
+		probe->probe(toProbe);
+		return;
+	}
+
+	addImages(page);
+}
+
+/**
+ * Images whose post-filtering depends on their dimensions or file size, when they are not in the listing.
+ */
+QList<QSharedPointer<Image>> PageApi::imagesToProbe(const QList<QSharedPointer<Image>> &images) const
+{
+	QList<QSharedPointer<Image>> ret;
+	if (m_postFiltering.count() == 0 || !m_site->setting("download/probe_headers", false).toBool()) {
+		return ret;
+	}
+
+	for (const QSharedPointer<Image> &img : images) {
+		QStringList missing;
+		if (img->size().isEmpty()) {
+			missing << "width" << "height";
+		}
+		if (img->fileSize() <= 0) {
+			missing << "filesize";
+		}
+		if (!missing.isEmpty() && !img->url(Image::Size::Full).isEmpty() && m_postFiltering.needs(img->tokens(m_profile), missing)) {
+			ret.append(img);
+		}
+	}
+
+	return ret;
+}
+
+void PageApi::addImages(const ParsedPage &page)
+{
+	const bool isGallery = !m_query.gallery.isNull();
+
 	for (const QSharedPointer<Image> &img : qAsConst(page.images)) {
 		addImage(img);
 	}
+	preconnect(page.images);
 	if (page.urlNextPage.isValid()) {
 		m_urlNextPage = page.urlNextPage;
 	}
@@ -324,18 +490,13 @@ void PageApi::parseActual()
 
 	// Complete missing tag information from images' tags if necessary
 	if (m_tags.isEmpty()) {
-		QStringList tagsGot;
+		TagCounter counter;
 		for (const QSharedPointer<Image> &img : qAsConst(m_images)) {
 			for (const Tag &tag : img->tags()) {
-				if (tagsGot.contains(tag.text())) {
-					const int index = tagsGot.indexOf(tag.text());
-					m_tags[index].setCount(m_tags[index].count() + 1);
-				} else {
-					m_tags.append(tag);
-					tagsGot.append(tag.text());
-				}
+				counter.add(tag, 1);
 			}
 		}
+		m_tags = counter.tags();
 	}
 
 	// Remove first n images (according to site settings)
@@ -390,7 +551,7 @@ void PageApi::clear()
 
 const QList<QSharedPointer<Image>> &PageApi::images() const { return m_images; }
 const QUrl &PageApi::url() const { return m_url; }
-const QString &PageApi::source() const { return m_source; }
+const QByteArray &PageApi::source() const { return m_source; }
 const QString &PageApi::wiki() const { return m_wiki; }
 const QList<Tag> &PageApi::tags() const { return m_tags; }
 const QStringList &PageApi::errors() const { return m_errors; }
@@ -1,12 +1,15 @@
 #ifndef PAGE_API_H
 #define PAGE_API_H
 
+#include <QByteArray>
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QList>
 #include <QMap>
 #include <QObject>
 #include <QSharedPointer>
 #include <QUrl>
+#include "models/api/api.h"
 #include "models/filtering/post-filter.h"
 #include "models/search-query/search-query.h"
 #include "tags/tag.h"
@@ -34,7 +37,9 @@ class PageApi : public QObject
 		};
 
 		explicit PageApi(Page *parentPage, Profile *profile, Site *site, Api *api, SearchQuery query, int page = 1, int limit = 25, PostFilter postFiltering = PostFilter(), bool smart = false, QObject *parent = nullptr, int pool = 0, int lastPage = 0, qulonglong lastPageMinId = 0, qulonglong lastPageMaxId = 0, QString lastPageMinDate = "", QString lastPageMaxDate = "");
-		void setLastPage(Page *page);
+		~PageApi() override;
+		void setLastPage(Page *page, bool preferCursor = false);
+		void setLastPage(int page, qulonglong minId, qulonglong maxId, const QString &minDate, const QString &maxDate, bool preferCursor = false);
 		const QList<QSharedPointer<Image>> &images() const;
 		bool isImageCountSure() const;
 		bool isPageCountSure() const;
@@ -43,7 +48,7 @@ class PageApi : public QObject
 		int pagesCount(bool guess = true) const;
 		int maxPagesCount() const;
 		const QUrl &url() const;
-		const QString &source() const;
+		const QByteArray &source() const;
 		const QString &wiki() const;
 		const QList<Tag> &tags() const;
 		const QStringList &errors() const;
@@ -72,10 +77,23 @@ class PageApi : public QObject
 		void finishedLoadingTags(PageApi*);
 		void httpsRedirect();
 
+	protected slots:
+		void parseFinished();
+
 	protected:
+		struct ParseResult
+		{
+			QByteArray source;
+			ParsedPage page;
+		};
+
 		bool addImage(const QSharedPointer<Image> &img);
+		void addImages(const ParsedPage &page);
+		QList<QSharedPointer<Image>> imagesToProbe(const QList<QSharedPointer<Image>> &images) const;
+		void preconnect(const QList<QSharedPointer<Image>> &images);
 		void updateUrls();
-		void parseActual();
+		bool canUseCursor() const;
+		ParseResult parseActual(const QByteArray &data, int statusCode, int offset, bool isGallery) const;
 		void setImageCount(int count, bool sure);
 		void setImageMaxCount(int maxCount);
 		void setPageCount(int count, bool sure);
@@ -93,16 +111,19 @@ class PageApi : public QObject
 		qulonglong m_lastPageMinId, m_lastPageMaxId;
 		QString m_lastPageMinDate, m_lastPageMaxDate;
 		bool m_smart, m_isAltPage;
-		QString m_format, m_source, m_wiki, m_originalUrl;
+		QString m_format, m_wiki, m_originalUrl;
+		QByteArray m_source;
 		QUrl m_url, m_urlNextPage, m_urlPrevPage;
 		QMap<QString, QString> m_headers;
 		QList<QSharedPointer<Image>> m_images;
 		QList<Tag> m_tags;
 		NetworkReply *m_reply;
+		QFutureWatcher<ParseResult> *m_parseWatcher = nullptr;
 		int m_imagesCount, m_maxImagesCount, m_pagesCount, m_pageImageCount, m_filteredImageCount;
 		bool m_imagesCountSafe, m_pagesCountSafe;
 		bool m_loading = false;
 		bool m_loaded = false;
+		bool m_preferCursor = false;
 };
 
 Q_DECLARE_METATYPE(PageApi::LoadResult)
@@ -0,0 +1,45 @@
+#include "models/page-cache.h"
+#include <QDateTime>
+#include "models/page.h"
+#include "models/search-query/search-query.h"
+
+
+PageCache::PageCache(int maxAge, int maxEntries)
+	: m_maxAge(static_cast<qint64>(maxAge) * 1000), m_entries(qMax(0, maxEntries))
+{}
+
+QString PageCache::key(const QString &website, const SearchQuery &query, int page, int limit, const QStringList &postFiltering)
+{
+	return website + '|' + query.toString() + '|' + QString::number(page) + '|' + QString::number(limit) + '|' + postFiltering.join(' ');
+}
+
+/**
+ * Pages can be inserted before they are loaded, they are only returned once they are.
+ */
+void PageCache::insert(const QString &key, const QSharedPointer<Page> &page)
+{
+	m_entries.insert(key, new Entry { page, QDateTime::currentMSecsSinceEpoch() });
+}
+
+QSharedPointer<Page> PageCache::get(const QString &key)
+{
+	const Entry *entry = m_entries.object(key);
+	if (entry == nullptr) {
+		return {};
+	}
+
+	// Pages that are still loading or that failed are not worth keeping
+	const QSharedPointer<Page> &page = entry->page;
+	const bool expired = QDateTime::currentMSecsSinceEpoch() - entry->added > m_maxAge;
+	if (expired || !page->isValid() || !page->errors().isEmpty() || !page->isLoaded()) {
+		m_entries.remove(key);
+		return {};
+	}
+
+	return page;
+}
+
+void PageCache::clear()
+{
+	m_entries.clear();
+}
@@ -0,0 +1,50 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <QCache>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+
+class Page;
+class SearchQuery;
+
+/**
+ * Keeps the last loaded pages of results, so that going back to them (using the history or the pagination) displays
+ * them right away, without loading and parsing them again.
+ *
+ * Entries are kept for a limited time, as results change when new images are posted.
+ */
+class PageCache
+{
+	public:
+		/**
+		 * @param maxAge The maximum age of an entry in seconds.
+		 * @param maxEntries The maximum number of pages to remember.
+		 */
+		explicit PageCache(int maxAge = 5 * 60, int maxEntries = 20);
+
+		static QString key(const QString &website, const SearchQuery &query, int page, int limit, const QStringList &postFiltering);
+
+		void insert(const QString &key, const QSharedPointer<Page> &page);
+
+		/**
+		 * Get a page if it was successfully loaded recently enough, or a null pointer.
+		 */
+		QSharedPointer<Page> get(const QString &key);
+
+		void clear();
+
+	private:
+		struct Entry
+		{
+			QSharedPointer<Page> page;
+			qint64 added; // Milliseconds since epoch
+		};
+
+		qint64 m_maxAge;
+		QCache<QString, Entry> m_entries;
+};
+
+#endif // PAGE_CACHE_H
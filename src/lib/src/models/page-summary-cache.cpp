@@ -0,0 +1,49 @@
+#include "models/page-summary-cache.h"
+#include <QDateTime>
+
+
+PageSummaryCache::PageSummaryCache(int maxAge, int maxEntries)
+	: m_maxAge(static_cast<qint64>(maxAge) * 1000), m_entries(maxEntries)
+{}
+
+/**
+ * The order of tags doesn't change the results, so it doesn't change the key either.
+ */
+QString PageSummaryCache::key(const QStringList &search, int page)
+{
+	QStringList sorted = search;
+	sorted.sort();
+	return sorted.join(' ') + '|' + QString::number(page);
+}
+
+void PageSummaryCache::insert(const QStringList &search, int page, const Summary &summary)
+{
+	// Nothing to show anyway
+	if (summary.wiki.isEmpty() && summary.tags.isEmpty()) {
+		return;
+	}
+
+	m_entries.insert(key(search, page), new Entry { summary, QDateTime::currentMSecsSinceEpoch() });
+}
+
+bool PageSummaryCache::get(const QStringList &search, int page, Summary *summary)
+{
+	const QString k = key(search, page);
+	const Entry *entry = m_entries.object(k);
+	if (entry == nullptr) {
+		return false;
+	}
+
+	if (QDateTime::currentMSecsSinceEpoch() - entry->added > m_maxAge) {
+		m_entries.remove(k);
+		return false;
+	}
+
+	*summary = entry->summary;
+	return true;
+}
+
+void PageSummaryCache::clear()
+{
+	m_entries.clear();
+}
@@ -0,0 +1,50 @@
+#ifndef PAGE_SUMMARY_CACHE_H
+#define PAGE_SUMMARY_CACHE_H
+
+#include <QCache>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "tags/tag.h"
+
+
+/**
+ * Remembers the wiki and related tags returned by a site for recent searches, so that they can be displayed right away
+ * when the same search is made again, instead of once its results are loaded.
+ *
+ * Entries are kept for a limited time, as both can change when new images are posted.
+ */
+class PageSummaryCache
+{
+	public:
+		struct Summary
+		{
+			QString wiki;
+			QList<Tag> tags;
+		};
+
+		/**
+		 * @param maxAge The maximum age of an entry in seconds.
+		 * @param maxEntries The maximum number of searches to remember.
+		 */
+		explicit PageSummaryCache(int maxAge = 10 * 60, int maxEntries = 50);
+
+		void insert(const QStringList &search, int page, const Summary &summary);
+		bool get(const QStringList &search, int page, Summary *summary);
+		void clear();
+
+	protected:
+		static QString key(const QStringList &search, int page);
+
+	private:
+		struct Entry
+		{
+			Summary summary;
+			qint64 added; // Milliseconds since epoch
+		};
+
+		qint64 m_maxAge;
+		QCache<QString, Entry> m_entries;
+};
+
+#endif // PAGE_SUMMARY_CACHE_H
@@ -1,4 +1,5 @@
 #include "models/page.h"
+#include <QSettings>
 #include <QUrl>
 #include <algorithm>
 #include <utility>
@@ -6,6 +7,10 @@
 #include "functions.h"
 #include "logger.h"
 #include "models/api/api.h"
+#include "models/api/api-stats.h"
+#include "models/filtering/blacklist.h"
+#include "models/filtering/post-filter.h"
+#include "models/profile.h"
 #include "models/search-query/search-query.h"
 #include "models/site.h"
 
@@ -49,12 +54,30 @@ Page::Page(Profile *profile, Site *site, const QList<Site*> &sites, SearchQuery
 		m_query.tags = m_search;
 	}
 
-	// Generate pages
+	// Filters that the sites can do themselves are added to the search instead of wasting results
 	PostFilter postFilter(postFiltering);
+	const bool isTagSearch = m_query.gallery.isNull() && m_query.urls.isEmpty() && !(m_query.tags.count() == 1 && isUrl(m_query.tags.first()));
+	const bool pushFilters = isTagSearch && m_site->setting("search/push_filters", true).toBool();
+	const int tagLimit = m_site->setting("search/tag_limit", 0).toInt();
+	QStringList blacklisted;
+	if (pushFilters && profile->getSettings()->value("hideblacklisted", false).toBool()) {
+		blacklisted = profile->getBlacklist().plainTags();
+	}
+
+	// Generate pages
 	m_siteApis = m_site->getLoggedInApis();
+	if (m_site->setting("download/learn_api_order", true).toBool()) {
+		sortApis();
+	}
 	m_pageApis.reserve(m_siteApis.count());
 	for (Api *api : qAsConst(m_siteApis)) {
-		auto *pageApi = new PageApi(this, profile, m_site, api, m_query, page, limit, postFilter, smart, parent, pool, lastPage, lastPageMinId, lastPageMaxId, lastPageMinDate, lastPageMaxDate);
+		SearchQuery apiQuery = m_query;
+		PostFilter apiPostFilter = postFilter;
+		if (pushFilters) {
+			apiPostFilter = pushDown(api, apiQuery.tags, postFilter, blacklisted, tagLimit);
+		}
+
+		auto *pageApi = new PageApi(this, profile, m_site, api, apiQuery, page, limit, apiPostFilter, smart, parent, pool, lastPage, lastPageMinId, lastPageMaxId, lastPageMinDate, lastPageMaxDate);
 		if (m_pageApis.count() == 0) {
 			connect(pageApi, &PageApi::httpsRedirect, this, &Page::httpsRedirectSlot);
 		}
@@ -69,7 +92,65 @@ Page::Page(Profile *profile, Site *site, const QList<Site*> &sites, SearchQuery
 	m_page = page;
 	m_pool = pool;
 	fallback(false);
+
+	// Hedging: start the next API in parallel if the current one is too slow to answer
+	m_hedgeTimer.setSingleShot(true);
+	connect(&m_hedgeTimer, &QTimer::timeout, this, &Page::startHedge);
+}
+/**
+ * Add the post-filters and blacklisted tags that the API supports to the search, returning the remaining post-filters.
+ * Post-filters come first, since they remove results for sure while blacklisted tags might not even be present.
+ */
+PostFilter Page::pushDown(Api *api, QStringList &search, const PostFilter &postFilter, const QStringList &blacklisted, int tagLimit) const
+{
+	const QStringList modifiers = api->modifiers();
+	if (modifiers.isEmpty()) {
+		return postFilter;
+	}
+
+	const int before = search.count();
+	PostFilter ret = postFilter.pushDown(search, modifiers, tagLimit);
+
+	for (const QString &tag : blacklisted) {
+		if (tagLimit > 0 && search.count() >= tagLimit) {
+			break;
+		}
+		if (!search.contains(tag, Qt::CaseInsensitive) && !search.contains("-" + tag, Qt::CaseInsensitive)) {
+			search.append("-" + tag);
+		}
+	}
+
+	if (search.count() > before) {
+		log(QStringLiteral("[%1][%2] Filters added to the search: %3").arg(m_site->url(), api->getName(), search.mid(before).join(' ')), Logger::Debug);
+	}
+	return ret;
+}
+
+/**
+ * Try the APIs that worked best recently first, the original order being kept for the others.
+ */
+void Page::sortApis()
+{
+	QStringList names;
+	names.reserve(m_siteApis.count());
+	for (Api *api : qAsConst(m_siteApis)) {
+		names.append(api->getName());
+	}
+
+	const QStringList sorted = m_site->apiStats()->sort(names);
+	if (sorted == names) {
+		return;
+	}
+
+	QList<Api*> apis;
+	apis.reserve(m_siteApis.count());
+	for (const QString &name : sorted) {
+		apis.append(m_siteApis[names.indexOf(name)]);
+	}
+	log(QStringLiteral("[%1] Using learned API order: %2").arg(m_site->url(), sorted.join(", ")), Logger::Debug);
+	m_siteApis = apis;
 }
+
 Page::~Page()
 {
 	qDeleteAll(m_pageApis);
@@ -79,6 +160,12 @@ void Page::fallback(bool loadIfPossible)
 {
 	m_errors.clear();
 
+	// APIs that already failed while loading in parallel don't need to be tried again
+	if (m_skippedApi > m_currentApi) {
+		m_currentApi = m_skippedApi;
+	}
+	m_skippedApi = -1;
+
 	if (m_currentApi >= m_siteApis.count() - 1) {
 		log(QStringLiteral("[%1] No valid source of the site returned result.").arg(m_site->url()), Logger::Warning);
 		m_errors.append(tr("No valid source of the site returned result."));
@@ -96,10 +183,20 @@ void Page::fallback(bool loadIfPossible)
 	}
 }
 
-void Page::setLastPage(Page *page)
+void Page::setLastPage(Page *page, bool preferCursor)
 {
 	for (PageApi *api : qAsConst(m_pageApis)) {
-		api->setLastPage(page);
+		api->setLastPage(page, preferCursor);
+	}
+
+	m_currentApi--;
+	fallback(false);
+}
+
+void Page::setLastPage(int page, qulonglong minId, qulonglong maxId, const QString &minDate, const QString &maxDate, bool preferCursor)
+{
+	for (PageApi *api : qAsConst(m_pageApis)) {
+		api->setLastPage(page, minId, maxId, minDate, maxDate, preferCursor);
 	}
 
 	m_currentApi--;
@@ -115,25 +212,79 @@ void Page::load(bool rateLimit)
 		return;
 	}
 
-	connect(m_pageApis[m_currentApi], &PageApi::finishedLoading, this, &Page::loadFinished);
+	connect(m_pageApis[m_currentApi], &PageApi::finishedLoading, this, &Page::loadFinished, Qt::UniqueConnection);
+	m_loadTimers[m_currentApi].start();
 	m_pageApis[m_currentApi]->load(rateLimit);
+
+	const int hedgeDelay = m_site->setting("download/hedge_delay", 0).toInt();
+	if (hedgeDelay > 0 && m_hedgeApi < 0) {
+		m_hedgeTimer.start(hedgeDelay);
+	}
 }
+
+/**
+ * Start loading the next API in parallel when the current one did not answer within the hedging delay.
+ * The first one to return results is kept, and the other one is cancelled.
+ */
+void Page::startHedge()
+{
+	const int next = qMax(m_currentApi, m_skippedApi) + 1;
+	if (m_hedgeApi >= 0 || m_currentApi < 0 || next >= m_pageApis.count()) {
+		return;
+	}
+
+	log(QStringLiteral("[%1] %2 is slow to answer, also trying %3.").arg(m_site->url(), m_siteApis[m_currentApi]->getName(), m_siteApis[next]->getName()), Logger::Info);
+	m_hedgeApi = next;
+	connect(m_pageApis[m_hedgeApi], &PageApi::finishedLoading, this, &Page::loadFinished, Qt::UniqueConnection);
+	m_loadTimers[m_hedgeApi].start();
+	m_pageApis[m_hedgeApi]->load();
+}
+
 void Page::loadFinished(PageApi *api, PageApi::LoadResult status)
 {
-	if (api != m_pageApis[m_currentApi]) {
+	const bool isHedge = m_hedgeApi >= 0 && api == m_pageApis[m_hedgeApi];
+	if (api != m_pageApis[m_currentApi] && !isHedge) {
 		return;
 	}
 
-	QString eventLabel = QStringLiteral("%1 (%2)").arg(m_site->url(), m_siteApis[m_currentApi]->getName());
+	const int index = isHedge ? m_hedgeApi : m_currentApi;
+	QString eventLabel = QStringLiteral("%1 (%2)").arg(m_site->url(), m_siteApis[index]->getName());
+	const qint64 elapsed = m_loadTimers[index].elapsed();
 	if (status == PageApi::LoadResult::Ok) {
 		Analytics::getInstance().sendEvent("Page load", "Success", eventLabel);
+		m_site->apiStats()->add(m_siteApis[index]->getName(), true, elapsed);
+
+		// Cancel the other API still loading in parallel, if any
+		m_hedgeTimer.stop();
+		m_skippedApi = -1;
+		if (m_hedgeApi >= 0) {
+			const int loser = isHedge ? m_currentApi : m_hedgeApi;
+			m_currentApi = index;
+			m_hedgeApi = -1;
+			m_pageApis[loser]->abort();
+		}
+
 		emit finishedLoading(this);
 	} else {
 		const QStringList &errors = api->errors();
 		if (errors.isEmpty() || !errors.first().contains("impossible")) {
 			Analytics::getInstance().sendEvent("Page load", "Error", eventLabel);
+			m_site->apiStats()->add(m_siteApis[index]->getName(), false, elapsed);
 		}
 		m_errors.append(errors);
+
+		// If another API is still loading in parallel, wait for it instead of falling back
+		if (m_hedgeApi >= 0) {
+			if (isHedge) {
+				m_skippedApi = m_hedgeApi;
+			} else {
+				m_currentApi = m_hedgeApi;
+			}
+			m_hedgeApi = -1;
+			return;
+		}
+
+		m_hedgeTimer.stop();
 		fallback();
 	}
 }
@@ -142,6 +293,13 @@ void Page::abort()
 	if (m_currentApi < 0 || m_currentApi >= m_pageApis.count()) {
 		return;
 	}
+
+	m_hedgeTimer.stop();
+	if (m_hedgeApi >= 0) {
+		const int hedge = m_hedgeApi;
+		m_hedgeApi = -1;
+		m_pageApis[hedge]->abort();
+	}
 	m_pageApis[m_currentApi]->abort();
 }
 
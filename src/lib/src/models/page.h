@@ -1,11 +1,14 @@
 #ifndef PAGE_H
 #define PAGE_H
 
+#include <QElapsedTimer>
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 #include "models/page-api.h"
 
 
@@ -24,7 +27,13 @@ class Page : public QObject
 	public:
 		explicit Page(Profile *profile, Site *site, const QList<Site*> &sites, SearchQuery query, int page = 1, int limit = 25, const QStringList &postFiltering = QStringList(), bool smart = false, QObject *parent = nullptr, int pool = 0, int lastPage = 0, qulonglong lastPageMinId = 0, qulonglong lastPageMaxId = 0, const QString& lastPageMinDate = "", const QString& lastPageMaxDate = "");
 		~Page() override;
-		void setLastPage(Page *page);
+
+		/**
+		 * Continue from the given page, using its IDs as a cursor instead of the page number if preferCursor is set and
+		 * the source supports it.
+		 */
+		void setLastPage(Page *page, bool preferCursor = false);
+		void setLastPage(int page, qulonglong minId, qulonglong maxId, const QString &minDate, const QString &maxDate, bool preferCursor = false);
 		void fallback(bool loadIfPossible = true);
 		void load(bool rateLimit = false);
 		void loadTags();
@@ -68,6 +77,11 @@ class Page : public QObject
 		void loadFinished(PageApi *api, PageApi::LoadResult status);
 		void loadTagsFinished(PageApi *api, PageApi::LoadResult status);
 		void httpsRedirectSlot();
+		void startHedge();
+
+	protected:
+		void sortApis();
+		PostFilter pushDown(Api *api, QStringList &search, const PostFilter &postFilter, const QStringList &blacklisted, int tagLimit) const;
 
 	signals:
 		void finishedLoading(Page*);
@@ -78,6 +92,10 @@ class Page : public QObject
 	private:
 		Site *m_site;
 		int m_currentApi;
+		int m_hedgeApi = -1;
+		int m_skippedApi = -1;
+		QTimer m_hedgeTimer;
+		QMap<int, QElapsedTimer> m_loadTimers;
 		QList<Api*> m_siteApis;
 		QList<PageApi*> m_pageApis;
 		int m_regexApi;
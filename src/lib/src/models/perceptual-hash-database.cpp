@@ -0,0 +1,111 @@
+#include "models/perceptual-hash-database.h"
+#include <QFile>
+#include <algorithm>
+#include <utility>
+#include "logger.h"
+#include "utils/perceptual-hash.h"
+
+
+PerceptualHashDatabase::PerceptualHashDatabase(QString path)
+	: m_path(std::move(path))
+{
+	QFile file(m_path);
+	if (file.open(QFile::ReadOnly | QFile::Text)) {
+		QByteArray line;
+		while (!(line = file.readLine()).isEmpty()) {
+			bool ok;
+			const quint64 hash = line.left(16).toULongLong(&ok, 16);
+			const QString path = QString::fromUtf8(line.mid(17)).trimmed();
+			if (ok && !path.isEmpty()) {
+				insert(hash, path);
+			}
+		}
+		file.close();
+	}
+	log(QStringLiteral("Perceptual hash database loaded (%1 entries)").arg(m_count));
+}
+
+
+int PerceptualHashDatabase::count() const
+{
+	return m_count;
+}
+
+void PerceptualHashDatabase::add(quint64 hash, const QString &path)
+{
+	insert(hash, path);
+
+	QFile file(m_path);
+	if (file.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+		file.write(QString::number(hash, 16).rightJustified(16, '0').toLatin1() + ' ' + path.toUtf8() + '\n');
+		file.close();
+	} else {
+		log(QStringLiteral("Could not write to the perceptual hash database `%1`").arg(m_path), Logger::Error);
+	}
+}
+
+void PerceptualHashDatabase::insert(quint64 hash, const QString &path)
+{
+	m_count++;
+
+	if (m_nodes.isEmpty()) {
+		m_nodes.append(Node { hash, { path }, {} });
+		return;
+	}
+
+	int node = 0;
+	for (;;) {
+		const int distance = hammingDistance(hash, m_nodes[node].hash);
+		if (distance == 0) {
+			m_nodes[node].paths.append(path);
+			return;
+		}
+
+		int next = -1;
+		for (const auto &child : qAsConst(m_nodes[node].children)) {
+			if (child.first == distance) {
+				next = child.second;
+				break;
+			}
+		}
+
+		if (next < 0) {
+			m_nodes[node].children.append(qMakePair(distance, m_nodes.count()));
+			m_nodes.append(Node { hash, { path }, {} });
+			return;
+		}
+		node = next;
+	}
+}
+
+QStringList PerceptualHashDatabase::find(quint64 hash, int maxDistance) const
+{
+	if (m_nodes.isEmpty() || maxDistance < 0) {
+		return {};
+	}
+
+	// Only visit the children whose distance is within maxDistance of the node's own distance to the hash
+	QVector<QPair<int, int>> found;
+	QVector<int> stack { 0 };
+	while (!stack.isEmpty()) {
+		const int index = stack.takeLast();
+		const Node &node = m_nodes[index];
+		const int distance = hammingDistance(hash, node.hash);
+		if (distance <= maxDistance) {
+			found.append(qMakePair(distance, index));
+		}
+		for (const auto &child : node.children) {
+			if (qAbs(child.first - distance) <= maxDistance) {
+				stack.append(child.second);
+			}
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+
+	QStringList ret;
+	for (const auto &match : qAsConst(found)) {
+		ret.append(m_nodes[match.second].paths);
+	}
+	return ret;
+}
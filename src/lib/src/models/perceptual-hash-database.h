@@ -0,0 +1,46 @@
+#ifndef PERCEPTUAL_HASH_DATABASE_H
+#define PERCEPTUAL_HASH_DATABASE_H
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * Database of the perceptual hashes of saved images, to find the files that look like a given image.
+ *
+ * Hashes are kept in a BK-tree using their Hamming distance, so that finding the hashes a few bits away from a given
+ * one only visits a small part of the tree. New hashes are appended to a text file as they are added, one
+ * "<hash> <path>" line each.
+ */
+class PerceptualHashDatabase
+{
+	public:
+		explicit PerceptualHashDatabase(QString path);
+
+		int count() const;
+		void add(quint64 hash, const QString &path);
+
+		/**
+		 * Get the paths of the images whose hash is at most maxDistance away from the given one, closest first.
+		 */
+		QStringList find(quint64 hash, int maxDistance) const;
+
+	protected:
+		void insert(quint64 hash, const QString &path);
+
+		struct Node
+		{
+			quint64 hash;
+			QStringList paths;
+			QVector<QPair<int, int>> children; // Distance to this node, and index of the child node
+		};
+
+	private:
+		QString m_path;
+		QVector<Node> m_nodes;
+		int m_count = 0;
+};
+
+#endif // PERCEPTUAL_HASH_DATABASE_H
@@ -0,0 +1,32 @@
+#include "models/profile-settings-snapshot.h"
+#include <QSettings>
+
+
+ProfileSettingsSnapshot ProfileSettingsSnapshot::load(QSettings *settings)
+{
+	ProfileSettingsSnapshot ret;
+	if (settings == nullptr) {
+		return ret;
+	}
+
+	ret.downloadOriginals = settings->value("Save/downloadoriginals", ret.downloadOriginals).toBool();
+	ret.sampleFallback = settings->value("Save/samplefallback", ret.sampleFallback).toBool();
+	ret.uncachedThreshold = settings->value("Save/uncachedThreshold", 0).toLongLong() * 1024 * 1024;
+	ret.resumeRetries = settings->value("Save/resumeRetries", ret.resumeRetries).toInt();
+	ret.multipleFiles = settings->value("Save/multiple_files", ret.multipleFiles).toString();
+
+	ret.keepDate = settings->value("Save/keepDate", ret.keepDate).toBool();
+	ret.metadataPropsysExtensions = settings->value("Save/MetadataPropsysExtensions", "jpg jpeg mp4").toString().split(' ', Qt::SkipEmptyParts);
+	ret.metadataExiftoolExtensions = settings->value("Save/MetadataExiftoolExtensions", "jpg jpeg png gif mp4").toString().split(' ', Qt::SkipEmptyParts);
+
+	ret.maxWidthEnabled = settings->value("ImageSize/maxWidthEnabled", ret.maxWidthEnabled).toBool();
+	ret.maxWidth = settings->value("ImageSize/maxWidth", ret.maxWidth).toInt();
+	ret.maxHeightEnabled = settings->value("ImageSize/maxHeightEnabled", ret.maxHeightEnabled).toBool();
+	ret.maxHeight = settings->value("ImageSize/maxHeight", ret.maxHeight).toInt();
+
+	ret.transcodeRules = TranscodeRule::fromSettings(settings);
+
+	ret.viewSamples = settings->value("Viewer/viewSamples", ret.viewSamples).toBool();
+
+	return ret;
+}
@@ -0,0 +1,47 @@
+#ifndef PROFILE_SETTINGS_SNAPSHOT_H
+#define PROFILE_SETTINGS_SNAPSHOT_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "downloader/transcoder.h"
+
+
+class QSettings;
+
+/**
+ * Immutable copy of the profile settings read for every downloaded image.
+ *
+ * It is loaded once and replaced as a whole when the settings are saved, so that hot paths don't need to go through
+ * QSettings, and so that threads always see a consistent set of values.
+ */
+struct ProfileSettingsSnapshot
+{
+	static ProfileSettingsSnapshot load(QSettings *settings);
+
+	// Download
+	bool downloadOriginals = true;
+	bool sampleFallback = true;
+	qint64 uncachedThreshold = 0;
+	int resumeRetries = 3;
+	QString multipleFiles = "copy";
+
+	// Metadata
+	bool keepDate = true;
+	QStringList metadataPropsysExtensions { "jpg", "jpeg", "mp4" };
+	QStringList metadataExiftoolExtensions { "jpg", "jpeg", "png", "gif", "mp4" };
+
+	// Resizing
+	bool maxWidthEnabled = false;
+	int maxWidth = 1000;
+	bool maxHeightEnabled = false;
+	int maxHeight = 1000;
+
+	// Transcoding
+	QList<TranscodeRule> transcodeRules;
+
+	// Viewer
+	bool viewSamples = false;
+};
+
+#endif // PROFILE_SETTINGS_SNAPSHOT_H
@@ -1,46 +1,70 @@
 #include "models/profile.h"
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QFileInfoList>
-#include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutexLocker>
 #include <QSet>
 #include <QSettings>
+#include <algorithm>
 #include <utility>
 #include "commands/commands.h"
 #include "downloader/download-query-manager.h"
-#include "exiftool.h"
+#include "downloader/transcoder.h"
+#include "exiftool-queue.h"
+#include "file-metadata-queue.h"
 #include "functions.h"
+#include "log-file-queue.h"
 #include "logger.h"
+#include "models/api/parser-thread-pool.h"
 #include "models/favorite.h"
+#include "models/local-index.h"
+#include "models/md5-database/md5-database-binary.h"
+#include "models/md5-database/md5-database-postgres.h"
 #include "models/md5-database/md5-database-sqlite.h"
 #include "models/md5-database/md5-database-text.h"
 #include "models/monitor-manager.h"
+#include "models/perceptual-hash-database.h"
+#include "models/profile-settings-snapshot.h"
 #include "models/site.h"
 #include "models/source.h"
 #include "models/source-registry.h"
 #include "models/url-downloader/url-downloader-manager.h"
+#include "post-save-queue.h"
+#include "tags/tag-stylist.h"
+#include "utils/disk-scheduler.h"
 #include "utils/file-utils.h"
+#include "utils/json-record-file.h"
 #include "utils/read-write-path.h"
+#include "utils/thumbnail-cache.h"
 
 
 Profile::Profile()
 	: m_settings(nullptr), m_commands(nullptr), m_exiftool(nullptr), m_md5s(nullptr), m_monitorManager(nullptr), m_downloadQueryManager(nullptr), m_urlDownloaderManager(nullptr)
-{}
+{
+	connectLists();
+}
 Profile::Profile(QSettings *settings, QList<Favorite> favorites, QStringList keptForLater, QString path)
 	: m_path(std::move(path)), m_settings(settings), m_favorites(std::move(favorites)), m_keptForLater(std::move(keptForLater)), m_commands(nullptr), m_exiftool(nullptr), m_md5s(nullptr), m_monitorManager(nullptr), m_downloadQueryManager(nullptr), m_urlDownloaderManager(nullptr)
-{}
+{
+	connectLists();
+}
 Profile::Profile(QString path)
 	: m_path(std::move(path)), m_urlDownloaderManager(nullptr)
 {
+	connectLists();
 	m_settings = new QSettings(m_path + "/settings.ini", QSettings::IniFormat);
 
 	// Rename deprecated settings keys
 	renameSettingsGroup(m_settings, "Zoom", "Viewer");
 
+	// Number of threads, and therefore of JavaScript engines per source, used to parse results
+	setParserThreadCount(m_settings->value("Parsing/threads", 0).toInt());
+	Source::setJsEngineLimits(m_settings->value("Parsing/jsGcThreshold", 64).toInt(), m_settings->value("Parsing/jsRecycleThreshold", 1024).toInt());
+
 	// Load sources
 	const QString defaultPath = savePath("sites/", true, false);
 	const QString customPath = m_path + "/sites/";
@@ -49,7 +73,13 @@ Profile::Profile(QString path)
 		sites += QDir(defaultPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
 		sites.removeDuplicates();
 	}
+	QElapsedTimer sourcesTimer;
+	sourcesTimer.start();
+	QList<QPair<qint64, QString>> sourceTimings;
 	for (const QString &dir : sites) {
+		QElapsedTimer sourceTimer;
+		sourceTimer.start();
+
 		const QString readDir = defaultPath + dir;
 		const QString writeDir = customPath + dir;
 		auto *source = new Source(this, ReadWritePath(readDir, writeDir));
@@ -59,19 +89,29 @@ Profile::Profile(QString path)
 		}
 
 		addSource(source);
+
+		const qint64 elapsed = sourceTimer.elapsed();
+		sourceTimings.append({ elapsed, dir });
+		log(QStringLiteral("Source '%1' loaded in %2 ms (%3 sites)").arg(dir).arg(elapsed).arg(source->getSites().count()), Logger::Debug);
+	}
+
+	// Startup timing breakdown, with the most expensive sources first
+	std::sort(sourceTimings.begin(), sourceTimings.end(), [](const QPair<qint64, QString> &a, const QPair<qint64, QString> &b) {
+		return a.first > b.first;
+	});
+	QStringList slowest;
+	for (int i = 0; i < qMin(5, sourceTimings.count()); ++i) {
+		slowest.append(QStringLiteral("%1 (%2 ms)").arg(sourceTimings[i].second).arg(sourceTimings[i].first));
 	}
+	log(QStringLiteral("%1 sources loaded in %2 ms. Slowest: %3").arg(sourceTimings.count()).arg(sourcesTimer.elapsed()).arg(slowest.join(", ")), Logger::Info);
 
 	// Load favorites
 	QSet<QString> unique;
-	QFile fileFavoritesJson(m_path + "/favorites.json");
-	if (fileFavoritesJson.open(QFile::ReadOnly | QFile::Text)) {
-		const QByteArray data = fileFavoritesJson.readAll();
-		QJsonDocument loadDoc = QJsonDocument::fromJson(data);
-		QJsonObject object = loadDoc.object();
-
-		QJsonArray favorites = object["favorites"].toArray();
-		for (auto favoriteJson : favorites) {
-			Favorite fav = Favorite::fromJson(m_path, favoriteJson.toObject(), this);
+	m_favoritesFile = new JsonRecordFile(m_path + "/favorites.json", "favorites");
+	if (QFile::exists(m_path + "/favorites.json")) {
+		const QList<QJsonObject> favorites = m_favoritesFile->load();
+		for (const QJsonObject &favoriteJson : favorites) {
+			Favorite fav = Favorite::fromJson(m_path, favoriteJson, this);
 			if (!unique.contains(fav.getName())) {
 				unique.insert(fav.getName());
 				m_favorites.append(fav);
@@ -121,10 +161,17 @@ Profile::Profile(QString path)
 		QFile::copy(m_path + "/md5s.txt", m_path + "/md5s.txt.bak");
 	}
 
-	// Load MD5s
-	m_md5s = QFile::exists(m_path + "/md5s.sqlite") || !QFile::exists(m_path + "/md5s.txt")
-		? (Md5Database*) new Md5DatabaseSqlite(m_path + "/md5s.sqlite", m_settings)
-		: (Md5Database*) new Md5DatabaseText(m_path + "/md5s.txt", m_settings);
+	// Load MD5s, using the backend from the settings or guessing it from the existing files
+	const QString md5Backend = m_settings->value("md5_database").toString();
+	if (md5Backend == "postgresql") {
+		m_md5s = new Md5DatabasePostgres(m_settings);
+	} else if (md5Backend == "binary" || (md5Backend.isEmpty() && QFile::exists(m_path + "/md5s.bin"))) {
+		m_md5s = new Md5DatabaseBinary(m_path + "/md5s.bin", m_settings);
+	} else if (md5Backend == "sqlite" || (md5Backend != "text" && (QFile::exists(m_path + "/md5s.sqlite") || !QFile::exists(m_path + "/md5s.txt")))) {
+		m_md5s = new Md5DatabaseSqlite(m_path + "/md5s.sqlite", m_settings);
+	} else {
+		m_md5s = new Md5DatabaseText(m_path + "/md5s.txt", m_settings);
+	}
 
 	// Load auto-complete
 	QFile fileAutoComplete(savePath("words.txt", true, false));
@@ -149,7 +196,16 @@ Profile::Profile(QString path)
 	}
 
 	m_commands = new Commands(this);
-	m_exiftool = new Exiftool(this);
+	m_exiftool = new ExiftoolQueue(
+		m_settings->value("Save/MetadataExiftoolWorkers", 2).toInt(),
+		m_settings->value("Save/MetadataExiftoolBatchSize", 20).toInt());
+	m_postSaveQueue = new PostSaveQueue(
+		m_settings->value("Save/postSaveWorkers", 2).toInt(),
+		m_settings->value("Save/postSaveMaxPending", 200).toInt());
+	m_fileMetadataQueue = new FileMetadataQueue(m_postSaveQueue);
+	m_logFileQueue = new LogFileQueue(m_postSaveQueue, m_settings->value("Save/logFilesMaxOpen", 16).toInt());
+	m_diskScheduler = new DiskScheduler(m_settings->value("Save/diskConcurrency", 2).toInt());
+	m_transcoder = new Transcoder(m_settings->value("Save/transcodeWorkers", 1).toInt());
 
 	// Blacklisted tags
 	const QStringList &blacklist = m_settings->value("blacklistedtags").toString().split(' ', Qt::SkipEmptyParts);
@@ -188,11 +244,12 @@ Profile::Profile(QString path)
 	m_autoComplete.append(specialCompletes);
 	m_autoComplete.removeDuplicates();
 	m_autoComplete.sort();
+	m_autoCompleteIndex.add(m_autoComplete);
 
-	// Load source registries
+	// Load source registries, all at the same time
 	const QStringList sourceRegistries = m_settings->value("sourceRegistries").toStringList();
 	for (const QString &url : sourceRegistries) {
-		auto *sourceRegistry = new SourceRegistry(url);
+		auto *sourceRegistry = new SourceRegistry(url, m_path + "/cache/");
 		auto receiver = new QObject(this);
 		connect(sourceRegistry, &SourceRegistry::loaded, receiver, [=](bool ok) {
 			receiver->deleteLater();
@@ -219,18 +276,26 @@ Profile::~Profile()
 	qDeleteAll(m_sources);
 	delete m_commands;
 	delete m_monitorManager;
+	delete m_favoritesFile;
 	delete m_downloadQueryManager;
 	delete m_urlDownloaderManager;
+	delete m_perceptualHashes;
+	delete m_localIndex;
 	qDeleteAll(m_sourceRegistries);
 
-	if (m_exiftool != nullptr) {
-		m_exiftool->stop();
-	}
+	delete m_transcoder;
+	delete m_fileMetadataQueue;
+	delete m_logFileQueue;
+	delete m_postSaveQueue;
+	delete m_diskScheduler;
+	delete m_exiftool;
 }
 
 
 void Profile::sync()
 {
+	reloadSettingsSnapshot();
+
 	if (m_path.isEmpty()) {
 		return;
 	}
@@ -263,22 +328,19 @@ void Profile::sync()
 }
 void Profile::syncFavorites() const
 {
-	// Generate JSON array
-	QJsonArray favoritesJson;
+	QList<QJsonObject> favoritesJson;
+	favoritesJson.reserve(m_favorites.count());
 	for (const Favorite &fav : qAsConst(m_favorites)) {
 		QJsonObject unique;
 		fav.toJson(unique);
 		favoritesJson.append(unique);
 	}
 
-	// Generate result
-	QJsonObject full;
-	full["version"] = 1;
-	full["favorites"] = favoritesJson;
-
-	// Write result
-	QJsonDocument saveDoc(full);
-	safeWriteFile(m_path + "/favorites.json", saveDoc.toJson());
+	// Only the favorites that changed are written, unless some were added or removed
+	if (m_favoritesFile == nullptr) {
+		m_favoritesFile = new JsonRecordFile(m_path + "/favorites.json", "favorites");
+	}
+	m_favoritesFile->save(favoritesJson);
 }
 void Profile::syncKeptForLater() const
 {
@@ -336,6 +398,10 @@ void Profile::addFavorite(const Favorite &fav)
 
 	if (already == 0) {
 		m_autoComplete.append(fav.getName());
+		m_autoCompleteIndex.add(fav.getName());
+		if (m_autoCompleteTree.count() > 0) {
+			m_autoCompleteTree.add(fav.getName());
+		}
 	}
 
 	syncFavorites();
@@ -397,6 +463,72 @@ void Profile::removeIgnored(const QString &tag)
 	emit ignoredChanged();
 }
 
+/**
+ * The lists can also be edited through their getters, which is always followed by one of their signals.
+ */
+void Profile::connectLists()
+{
+	connect(this, &Profile::favoritesChanged, this, &Profile::listsChanged, Qt::DirectConnection);
+	connect(this, &Profile::keptForLaterChanged, this, &Profile::listsChanged, Qt::DirectConnection);
+	connect(this, &Profile::ignoredChanged, this, &Profile::listsChanged, Qt::DirectConnection);
+	connect(this, &Profile::blacklistChanged, this, &Profile::listsChanged, Qt::DirectConnection);
+}
+
+void Profile::listsChanged()
+{
+	m_listsVersion.ref();
+}
+
+int Profile::listsVersion() const
+{
+	return m_listsVersion.loadAcquire();
+}
+
+void Profile::updateIndexes() const
+{
+	const int version = m_listsVersion.loadAcquire();
+	if (version == m_indexesVersion) {
+		return;
+	}
+
+	m_favoritesIndex.clear();
+	m_favoritesIndex.reserve(m_favorites.count());
+	for (const Favorite &fav : m_favorites) {
+		m_favoritesIndex.insert(fav.getName());
+	}
+
+	m_keptForLaterIndex = QSet<QString>(m_keptForLater.constBegin(), m_keptForLater.constEnd());
+
+	m_ignoredIndex.clear();
+	m_ignoredIndex.reserve(m_ignored.count());
+	for (const QString &tag : m_ignored) {
+		m_ignoredIndex.insert(tag.toLower());
+	}
+
+	m_indexesVersion = version;
+}
+
+bool Profile::isFavorite(const QString &tag) const
+{
+	QMutexLocker locker(&m_indexesMutex);
+	updateIndexes();
+	return m_favoritesIndex.contains(tag);
+}
+
+bool Profile::isKeptForLater(const QString &tag) const
+{
+	QMutexLocker locker(&m_indexesMutex);
+	updateIndexes();
+	return m_keptForLaterIndex.contains(tag);
+}
+
+bool Profile::isIgnored(const QString &tag) const
+{
+	QMutexLocker locker(&m_indexesMutex);
+	updateIndexes();
+	return m_ignoredIndex.contains(tag.toLower());
+}
+
 void Profile::setRemovedTags(const QString &raw)
 {
 	m_removedTags.clear();
@@ -420,6 +552,16 @@ QStringList Profile::md5Exists(const QString &md5)
 	return m_md5s->exists(md5);
 }
 
+/**
+ * Check many md5s at once, for example all the images of a page.
+ * @param	md5s	The md5s that need to be checked.
+ * @return			The md5s that are in the database, whether or not their files still exist.
+ */
+QSet<QString> Profile::md5sKnown(const QStringList &md5s)
+{
+	return m_md5s->known(md5s);
+}
+
 /**
  * Adds a md5 to the _md5 map and adds it to the md5 file.
  * @param	md5		The md5 to add.
@@ -430,6 +572,15 @@ void Profile::addMd5(const QString &md5, const QString &path)
 	m_md5s->add(md5, path);
 }
 
+/**
+ * Adds many md5s at once to the md5 file.
+ * @param	md5s	The list of md5 and path pairs to add.
+ */
+void Profile::addMd5s(const QList<QPair<QString, QString>> &md5s)
+{
+	m_md5s->addAll(md5s);
+}
+
 /**
  * Removes a md5 from the _md5 map and removes it from the md5 file.
  * @param	md5		The md5 to remove.
@@ -440,9 +591,13 @@ void Profile::removeMd5(const QString &md5, const QString &path)
 }
 
 
-void Profile::addAutoComplete(const QString &tag)
+void Profile::addAutoComplete(const QString &tag, int count)
 {
 	m_customAutoComplete.append(tag);
+	m_autoCompleteIndex.add(tag, count);
+	if (m_autoCompleteTree.count() > 0) {
+		m_autoCompleteTree.add(tag);
+	}
 }
 
 
@@ -529,13 +684,37 @@ void Profile::syncSourceRegistries()
 
 QString Profile::getPath() const { return m_path; }
 QSettings *Profile::getSettings() const { return m_settings; }
+
+QSharedPointer<const ProfileSettingsSnapshot> Profile::settingsSnapshot() const
+{
+	QMutexLocker locker(&m_settingsSnapshotMutex);
+	if (m_settingsSnapshot.isNull()) {
+		m_settingsSnapshot.reset(new ProfileSettingsSnapshot(ProfileSettingsSnapshot::load(m_settings)));
+	}
+	return m_settingsSnapshot;
+}
+
+void Profile::reloadSettingsSnapshot()
+{
+	// Load outside of the lock, readers keep using the previous snapshot in the meantime
+	QSharedPointer<const ProfileSettingsSnapshot> snapshot(new ProfileSettingsSnapshot(ProfileSettingsSnapshot::load(m_settings)));
+
+	QMutexLocker locker(&m_settingsSnapshotMutex);
+	m_settingsSnapshot = snapshot;
+}
 QList<Favorite> &Profile::getFavorites() { return m_favorites; }
 QStringList &Profile::getKeptForLater() { return m_keptForLater; }
 QStringList &Profile::getIgnored() { return m_ignored; }
 TagFilterList &Profile::getRemovedTags() { return m_removedTags; }
 Commands &Profile::getCommands() { return *m_commands; }
-Exiftool &Profile::getExiftool() { return *m_exiftool; }
+ExiftoolQueue &Profile::getExiftool() { return *m_exiftool; }
+PostSaveQueue &Profile::getPostSaveQueue() { return *m_postSaveQueue; }
+FileMetadataQueue &Profile::getFileMetadataQueue() { return *m_fileMetadataQueue; }
+LogFileQueue &Profile::getLogFileQueue() { return *m_logFileQueue; }
+DiskScheduler &Profile::getDiskScheduler() { return *m_diskScheduler; }
+Transcoder &Profile::getTranscoder() { return *m_transcoder; }
 QStringList &Profile::getAutoComplete() { return m_autoComplete; }
+AutoCompleteIndex &Profile::getAutoCompleteIndex() { return m_autoCompleteIndex; }
 Blacklist &Profile::getBlacklist() { return m_blacklist; }
 const QMap<QString, Source*> &Profile::getSources() const { return m_sources; }
 const QMap<QString, Site*> &Profile::getSites() const { return m_sites; }
@@ -545,6 +724,63 @@ DownloadQueryManager *Profile::downloadQueryManager() const { return m_downloadQ
 UrlDownloaderManager *Profile::urlDownloaderManager() const { return m_urlDownloaderManager; }
 Md5Database *Profile::md5Database() const { return m_md5s; }
 
+/**
+ * The tree is only built the first time it is needed, as it is only used to suggest corrections to searches
+ * without results. It is then kept up to date as words are added to the auto-complete list.
+ */
+const BkTree &Profile::getAutoCompleteTree()
+{
+	if (m_autoCompleteTree.count() == 0) {
+		m_autoCompleteTree.add(m_autoComplete);
+		m_autoCompleteTree.add(m_customAutoComplete);
+	}
+	return m_autoCompleteTree;
+}
+
+TagStylist *Profile::tagStylist()
+{
+	if (m_tagStylist == nullptr) {
+		m_tagStylist = new TagStylist(this, this);
+	}
+	return m_tagStylist;
+}
+
+PerceptualHashDatabase *Profile::perceptualHashDatabase()
+{
+	if (m_perceptualHashes == nullptr) {
+		m_perceptualHashes = new PerceptualHashDatabase(m_path + "/phashes.txt");
+	}
+	return m_perceptualHashes;
+}
+
+LocalIndex *Profile::localIndex()
+{
+	if (m_localIndex == nullptr) {
+		m_localIndex = new LocalIndex(m_path + "/local-index.txt");
+	}
+	return m_localIndex;
+}
+
+/**
+ * Directory of the caches that don't depend on the profile settings (thumbnails, tag databases), allowing several
+ * profiles to share them. Defaults to the profile directory.
+ */
+QString Profile::sharedCachePath() const
+{
+	const QString path = m_settings->value("Cache/sharedDirectory").toString();
+	return path.isEmpty() ? m_path : path;
+}
+
+ThumbnailCache *Profile::thumbnailCache()
+{
+	if (m_thumbnailCache.isNull()) {
+		const qint64 memorySize = m_settings->value("Cache/thumbnailsMemorySize", 32).toLongLong() * 1024 * 1024;
+		const qint64 diskSize = m_settings->value("Cache/thumbnailsDiskSize", 200).toLongLong() * 1024 * 1024;
+		m_thumbnailCache = ThumbnailCache::shared(sharedCachePath() + "/thumbnails", memorySize, diskSize);
+	}
+	return m_thumbnailCache.data();
+}
+
 QList<Site*> Profile::getFilteredSites(const QStringList &urls) const
 {
 	QList<Site*> ret;
@@ -1,25 +1,42 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <QAtomicInt>
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
+#include <QSet>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include "models/favorite.h"
 #include "models/filtering/blacklist.h"
 #include "models/filtering/tag-filter-list.h"
+#include "utils/auto-complete-index.h"
+#include "utils/bk-tree.h"
 
 
 class Commands;
+class DiskScheduler;
 class DownloadQueryManager;
-class Exiftool;
+class ExiftoolQueue;
+class FileMetadataQueue;
+class JsonRecordFile;
+class LocalIndex;
+class LogFileQueue;
 class Md5Database;
 class MonitorManager;
+class PerceptualHashDatabase;
+class PostSaveQueue;
+struct ProfileSettingsSnapshot;
 class QSettings;
 class Site;
 class Source;
 class SourceRegistry;
+class TagStylist;
+class Transcoder;
+class ThumbnailCache;
 class UrlDownloaderManager;
 
 class Profile : public QObject
@@ -57,17 +74,30 @@ class Profile : public QObject
 		void addIgnored(const QString &tag);
 		void removeIgnored(const QString &tag);
 
+		// Fast membership tests, using indexes rebuilt when the lists change
+		bool isFavorite(const QString &tag) const;
+		bool isKeptForLater(const QString &tag) const;
+		bool isIgnored(const QString &tag) const;
+
+		/**
+		 * Incremented each time the favorites, kept for later, ignored or blacklisted tags change, so that the values
+		 * computed from them can be cached until then.
+		 */
+		int listsVersion() const;
+
 		// Removed tags management
 		void setRemovedTags(const QString &raw);
 
 		// MD5 management
 		QPair<QString, QString> md5Action(const QString &md5, const QString &target);
 		QStringList md5Exists(const QString &md5);
+		QSet<QString> md5sKnown(const QStringList &md5s);
 		void addMd5(const QString &md5, const QString &path);
+		void addMd5s(const QList<QPair<QString, QString>> &md5s);
 		void removeMd5(const QString &md5, const QString &path = {});
 
 		// Auto-completion
-		void addAutoComplete(const QString &tag);
+		void addAutoComplete(const QString &tag, int count = 0);
 
 		// Sites management
 		void addSource(Source *source);
@@ -87,14 +117,29 @@ class Profile : public QObject
 
 		// Getters
 		QString getPath() const;
+		QString sharedCachePath() const;
 		QSettings *getSettings() const;
+
+		/**
+		 * Typed copy of the settings used in hot paths, safe to read from any thread.
+		 * It is only updated when the profile is synced, or calling `reloadSettingsSnapshot()`.
+		 */
+		QSharedPointer<const ProfileSettingsSnapshot> settingsSnapshot() const;
+		void reloadSettingsSnapshot();
 		QList<Favorite> &getFavorites();
 		QStringList &getKeptForLater();
 		QStringList &getIgnored();
 		TagFilterList &getRemovedTags();
 		Commands &getCommands();
-		Exiftool &getExiftool();
+		ExiftoolQueue &getExiftool();
+		PostSaveQueue &getPostSaveQueue();
+		FileMetadataQueue &getFileMetadataQueue();
+		LogFileQueue &getLogFileQueue();
+		DiskScheduler &getDiskScheduler();
+		Transcoder &getTranscoder();
 		QStringList &getAutoComplete();
+		AutoCompleteIndex &getAutoCompleteIndex();
+		const BkTree &getAutoCompleteTree();
 		Blacklist &getBlacklist();
 		const QMap<QString, Source*> &getSources() const;
 		const QMap<QString, Site*> &getSites() const;
@@ -104,6 +149,15 @@ class Profile : public QObject
 		DownloadQueryManager *downloadQueryManager() const;
 		UrlDownloaderManager *urlDownloaderManager() const;
 		Md5Database *md5Database() const;
+		TagStylist *tagStylist();
+		PerceptualHashDatabase *perceptualHashDatabase();
+		LocalIndex *localIndex();
+		ThumbnailCache *thumbnailCache();
+
+	protected:
+		void connectLists();
+		void listsChanged();
+		void updateIndexes() const;
 
 	signals:
 		void favoritesChanged();
@@ -118,13 +172,27 @@ class Profile : public QObject
 		QString m_path;
 		QSettings *m_settings;
 		QList<Favorite> m_favorites;
+		mutable JsonRecordFile *m_favoritesFile = nullptr;
 		QStringList m_keptForLater;
 		QStringList m_ignored;
+		QAtomicInt m_listsVersion;
+		mutable QMutex m_indexesMutex;
+		mutable int m_indexesVersion = -1;
+		mutable QSet<QString> m_favoritesIndex;
+		mutable QSet<QString> m_keptForLaterIndex;
+		mutable QSet<QString> m_ignoredIndex; // Lower case
 		TagFilterList m_removedTags;
 		Commands *m_commands;
-		Exiftool *m_exiftool;
+		ExiftoolQueue *m_exiftool;
+		PostSaveQueue *m_postSaveQueue = nullptr;
+		FileMetadataQueue *m_fileMetadataQueue = nullptr;
+		LogFileQueue *m_logFileQueue = nullptr;
+		DiskScheduler *m_diskScheduler = nullptr;
+		Transcoder *m_transcoder = nullptr;
 		QStringList m_autoComplete;
 		QStringList m_customAutoComplete;
+		AutoCompleteIndex m_autoCompleteIndex;
+		BkTree m_autoCompleteTree;
 		Blacklist m_blacklist;
 		Md5Database *m_md5s;
 		QMap<QString, Source*> m_sources;
@@ -133,7 +201,13 @@ class Profile : public QObject
 		MonitorManager *m_monitorManager;
 		DownloadQueryManager *m_downloadQueryManager;
 		UrlDownloaderManager *m_urlDownloaderManager;
+		PerceptualHashDatabase *m_perceptualHashes = nullptr;
+		LocalIndex *m_localIndex = nullptr;
+		TagStylist *m_tagStylist = nullptr;
+		QSharedPointer<ThumbnailCache> m_thumbnailCache;
 		QList<SourceRegistry*> m_sourceRegistries;
+		mutable QMutex m_settingsSnapshotMutex;
+		mutable QSharedPointer<const ProfileSettingsSnapshot> m_settingsSnapshot;
 };
 
 #endif // PROFILE_H
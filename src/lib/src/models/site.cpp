@@ -1,19 +1,25 @@
 #include "models/site.h"
 #include <QCryptographicHash>
 #include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutexLocker>
 #include <QNetworkCookie>
-#include <QNetworkDiskCache>
 #include <QSettings>
 #include <QStringList>
+#include <QThread>
+#include <QTimer>
 #include <utility>
 #include "auth/http-auth.h"
 #include "auth/http-basic-auth.h"
 #include "auth/oauth1-auth.h"
 #include "auth/oauth2-auth.h"
 #include "auth/url-auth.h"
+#include "downloader/details-batcher.h"
+#include "downloader/extension-stats.h"
 #include "functions.h"
 #include "logger.h"
 #include "login/http-basic-login.h"
@@ -24,11 +30,17 @@
 #include "login/url-login.h"
 #include "mixed-settings.h"
 #include "models/api/api.h"
+#include "models/api/api-stats.h"
 #include "models/image.h"
+#include "models/page-summary-cache.h"
 #include "models/page.h"
 #include "models/profile.h"
 #include "models/source.h"
+#include "network/mirror-selector.h"
+#include "network/network-archive.h"
+#include "network/network-disk-cache.h"
 #include "network/network-manager.h"
+#include "network/network-reply.h"
 #include "network/persistent-cookie-jar.h"
 #include "tags/tag.h"
 #include "tags/tag-database.h"
@@ -40,21 +52,13 @@
 #else
 	#define CACHE_POLICY QNetworkRequest::PreferNetwork
 #endif
+#define CHALLENGE_RETRY_DELAY 300
 
 
 
 Site::Site(QString url, Source *source)
-	: m_type(source->getName()), m_url(std::move(url)), m_source(source), m_settings(nullptr), m_manager(nullptr), m_cookieJar(nullptr), m_tagDatabase(nullptr), m_login(nullptr), m_loggedIn(LoginStatus::Unknown), m_autoLogin(true)
+	: m_type(source->getName()), m_url(std::move(url)), m_source(source), m_settings(nullptr), m_manager(nullptr), m_cookieJar(nullptr), m_login(nullptr), m_loggedIn(LoginStatus::Unknown), m_autoLogin(true)
 {
-	// Create the access manager and get its slots
-	m_manager = new NetworkManager(this);
-
-	// Cache
-	auto *diskCache = new QNetworkDiskCache(m_manager);
-	diskCache->setCacheDirectory(m_source->getProfile()->getPath() + "/cache/");
-	diskCache->setMaximumCacheSize(50 * 1024 * 1024);
-	m_manager->setCache(diskCache);
-
 	loadConfig();
 }
 
@@ -70,12 +74,6 @@ void Site::loadConfig()
 	m_settings = new MixedSettings(QList<QSettings*> { settingsCustom, settingsDefaults });
 	m_name = m_settings->value("name", m_url).toString();
 
-	// Cookies
-	if (m_cookieJar == nullptr) {
-		m_cookieJar = new PersistentCookieJar(siteDir.writePath("cookies.txt"), m_manager);
-		m_manager->setCookieJar(m_cookieJar);
-	}
-
 	// Get default source order
 	QSettings *pSettings = m_source->getProfile()->getSettings();
 	QStringList defaults {
@@ -126,6 +124,80 @@ void Site::loadConfig()
 		} else if (!auths.isEmpty()) {
 			m_auth = auths.first();
 		}
+	}
+
+	// Cookies
+	m_cookies.clear();
+	QList<QVariant> settingsCookies = m_settings->value("cookies").toList();
+	for (const QVariant &variant : settingsCookies) {
+		QByteArray byteArray = variant.type() == QVariant::ByteArray ? variant.toByteArray() : variant.toString().toUtf8();
+		QList<QNetworkCookie> cookies = QNetworkCookie::parseCookies(byteArray);
+		for (QNetworkCookie cookie : cookies) {
+			cookie.setDomain(m_url);
+			cookie.setPath("/");
+			m_cookies.append(cookie);
+		}
+	}
+
+	// Equivalent hosts for the files, shared by all the threads downloading from this site
+	if (m_mirrorSelector == nullptr) {
+		m_mirrorSelector = new MirrorSelector();
+	}
+	m_mirrorSelector->setMirrors(m_settings->value("download/mirrors").toStringList());
+
+	// Preferred thumbnail formats, skipping the ones that can't be displayed
+	m_thumbnailFormats.clear();
+	const QList<QByteArray> supportedFormats = QImageReader::supportedImageFormats();
+	const QStringList thumbnailFormats = m_settings->value("download/thumbnail_formats", m_source->getThumbnailFormats()).toStringList();
+	for (const QString &format : thumbnailFormats) {
+		const QString fmt = format.trimmed().toLower();
+		if (supportedFormats.contains(fmt.toLatin1())) {
+			m_thumbnailFormats.append(fmt);
+		}
+	}
+
+	// The network stack and the tag database are only created when first needed
+	if (m_manager != nullptr) {
+		loadNetworkConfig();
+	}
+	m_tagDatabase.clear();
+}
+
+/**
+ * Create the network manager, cookie jar and login handler of this site if they don't exist yet.
+ */
+void Site::initNetwork()
+{
+	if (m_manager != nullptr) {
+		return;
+	}
+
+	// Create the access manager and get its slots
+	m_manager = new NetworkManager(this);
+
+	// Cache (shared by all sites using the same access manager)
+	if (m_manager->cache() == nullptr) {
+		QSettings *pSettings = m_source->getProfile()->getSettings();
+		auto *diskCache = new NetworkDiskCache();
+		diskCache->setCacheDirectory(m_source->getProfile()->getPath() + "/cache/");
+		diskCache->setMaximumCacheSize(pSettings->value("Cache/size", 50).toLongLong() * 1024 * 1024);
+		diskCache->setMaximumItemSize(pSettings->value("Cache/maxItemSize", 2).toLongLong() * 1024 * 1024);
+		m_manager->setCache(diskCache);
+	}
+
+	// Cookies
+	const ReadWritePath siteDir = m_source->getPath().readWritePath(m_url);
+	m_cookieJar = new PersistentCookieJar(siteDir.writePath("cookies.txt"), m_manager);
+	m_manager->setCookieJar(m_cookieJar);
+
+	loadNetworkConfig();
+}
+
+void Site::loadNetworkConfig()
+{
+	// Login
+	const QString defType = m_settings->value("login/type", "url").toString();
+	if (defType != "disabled") {
 		if (m_login != nullptr) {
 			m_login->deleteLater();
 		}
@@ -153,38 +225,54 @@ void Site::loadConfig()
 	}
 
 	// Cookies
-	m_cookies.clear();
-	QList<QVariant> settingsCookies = m_settings->value("cookies").toList();
-	for (const QVariant &variant : settingsCookies) {
-		QByteArray byteArray = variant.type() == QVariant::ByteArray ? variant.toByteArray() : variant.toString().toUtf8();
-		QList<QNetworkCookie> cookies = QNetworkCookie::parseCookies(byteArray);
-		for (QNetworkCookie cookie : cookies) {
-			cookie.setDomain(m_url);
-			cookie.setPath("/");
-			m_cookies.append(cookie);
-		}
-	}
 	m_cookieJar->insertCookies(m_cookies);
 
-	// Tag database
-	delete m_tagDatabase;
-	m_tagDatabase = TagDatabaseFactory::Create(siteDir);
-	m_tagDatabase->loadTypes();
-	m_tagDatabase->open();
-
-	// Setup throttling
-	m_manager->setMaxConcurrency(setting("download/simultaneous", 10).toInt());
-	m_manager->setInterval(QueryType::List, setting("download/throttle_page", 0).toInt() * 1000);
-	m_manager->setInterval(QueryType::Img, setting("download/throttle_image", 0).toInt() * 1000);
-	m_manager->setInterval(QueryType::Thumbnail, setting("download/throttle_thumbnail", 0).toInt() * 1000);
-	m_manager->setInterval(QueryType::Details, setting("download/throttle_details", 0).toInt() * 1000);
-	m_manager->setInterval(QueryType::Retry, setting("download/throttle_retry", 60).toInt() * 1000);
+	// New cookies might be what was needed to get past a challenge
+	resumeRequests();
+
+	// Setup throttling, which is useless when replaying recorded responses as no server is involved
+	const int simultaneous = setting("download/simultaneous", 10).toInt();
+	const int throttle = NetworkArchive::getInstance().isReplaying() ? 0 : 1000;
+	m_manager->setMaxConcurrency(simultaneous);
+	m_manager->setInterval(QueryType::List, setting("download/throttle_page", 0).toInt() * throttle);
+	m_manager->setInterval(QueryType::Img, setting("download/throttle_image", 0).toInt() * throttle);
+	m_manager->setInterval(QueryType::Thumbnail, setting("download/throttle_thumbnail", 0).toInt() * throttle);
+	m_manager->setInterval(QueryType::Details, setting("download/throttle_details", 0).toInt() * throttle);
+	m_manager->setInterval(QueryType::Retry, setting("download/throttle_retry", 60).toInt() * throttle);
+	m_manager->setBurst(QueryType::List, setting("download/burst_page", 1).toInt());
+	m_manager->setBurst(QueryType::Img, setting("download/burst_image", 1).toInt());
+	m_manager->setBurst(QueryType::Thumbnail, setting("download/burst_thumbnail", 1).toInt());
+	m_manager->setBurst(QueryType::Details, setting("download/burst_details", 1).toInt());
+
+	// Setup priorities, keeping some slots available for thumbnails and details when batch downloading
+	m_manager->setPriority(QueryType::Thumbnail, NetworkManager::Interactive);
+	m_manager->setPriority(QueryType::Details, NetworkManager::Details);
+	m_manager->setPriority(QueryType::List, NetworkManager::BatchPage);
+	m_manager->setPriority(QueryType::Retry, NetworkManager::BatchPage);
+	m_manager->setPriority(QueryType::Img, NetworkManager::BatchFile);
+	m_manager->setMaxConcurrency(NetworkManager::BatchPage, setting("download/simultaneous_page", qMax(1, simultaneous - 2)).toInt());
+	m_manager->setMaxConcurrency(NetworkManager::BatchFile, setting("download/simultaneous_image", qMax(1, simultaneous - 2)).toInt());
 }
 
 Site::~Site()
 {
 	m_settings->deleteLater();
-	delete m_tagDatabase;
+	delete m_extensionStats;
+	delete m_apiStats;
+	delete m_pageSummaryCache;
+	delete m_mirrorSelector;
+	delete m_detailsBatcher;
+
+	// Objects of other threads can only be deleted by these threads
+	QMutexLocker locker(&m_threadNetworksMutex);
+	for (const ThreadNetwork &network : qAsConst(m_threadNetworks)) {
+		disconnect(network.finishedConnection);
+		if (network.detailsBatcher != nullptr) {
+			network.detailsBatcher->deleteLater();
+		}
+		network.manager->deleteLater();
+	}
+	m_threadNetworks.clear();
 }
 
 
@@ -195,6 +283,8 @@ Site::~Site()
  */
 void Site::login(bool force)
 {
+	checkSessionExpiry();
+
 	if (!force && m_loggedIn == LoginStatus::Pending) {
 		return;
 	}
@@ -225,7 +315,12 @@ void Site::login(bool force)
 
 bool Site::canTestLogin() const
 {
-	return m_auth != nullptr && m_login != nullptr && m_login->isTestable();
+	if (m_auth == nullptr) {
+		return false;
+	}
+
+	const_cast<Site*>(this)->initNetwork();
+	return m_login != nullptr && m_login->isTestable();
 }
 
 /**
@@ -235,16 +330,117 @@ void Site::loginFinished(Login::Result result)
 {
 	const bool ok = result == Login::Result::Success;
 	m_loggedIn = ok ? LoginStatus::LoggedIn : LoginStatus::LoggedOut;
+	m_sessionExpiry = ok ? computeSessionExpiry() : QDateTime();
+
+	// Save the session cookies right away, so that they can be re-used on the next start even after a crash
+	if (ok) {
+		m_cookieJar->save();
+	}
 
 	log(QStringLiteral("[%1] Login finished: %2.").arg(m_url, ok ? "success" : "failure"));
 	emit loggedIn(this, ok ? LoginResult::Success : LoginResult::Error);
+
+	if (ok) {
+		resumeRequests();
+	}
+}
+
+
+/**
+ * Check if a reply is a challenge page (such as Cloudflare's) instead of the actual content.
+ *
+ * On the first detection, the site's queue is paused instead of letting all pending requests hit the same wall, and
+ * challengeDetected() is emitted once. Queued requests are kept, and are started again by resumeRequests(), which is
+ * called when the cookies or login change, or automatically after a while to check if the challenge went away.
+ */
+bool Site::checkChallenge(NetworkReply *reply)
+{
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if ((statusCode != 403 && statusCode != 429 && statusCode != 503) || reply->rawHeader("server") != "cloudflare") {
+		return false;
+	}
+
+	// The challenge state belongs to the site's thread
+	const QString url = reply->url().toString();
+	if (QThread::currentThread() != thread()) {
+		QMetaObject::invokeMethod(this, [this, url]() { pauseForChallenge(url); }, Qt::QueuedConnection);
+	} else {
+		pauseForChallenge(url);
+	}
+	return true;
+}
+
+void Site::pauseForChallenge(const QString &url)
+{
+	// Other requests already running when the challenge appeared will also fail, but don't need to do anything
+	if (m_challenged) {
+		return;
+	}
+
+	m_challenged = true;
+	m_manager->pause();
+	{
+		QMutexLocker locker(&m_threadNetworksMutex);
+		for (const ThreadNetwork &network : qAsConst(m_threadNetworks)) {
+			NetworkManager *manager = network.manager;
+			QMetaObject::invokeMethod(manager, [manager]() { manager->pause(); }, Qt::QueuedConnection);
+		}
+	}
+
+	if (m_challengeTimer == nullptr) {
+		m_challengeTimer = new QTimer(this);
+		m_challengeTimer->setSingleShot(true);
+		connect(m_challengeTimer, &QTimer::timeout, this, &Site::resumeRequests);
+	}
+	const int delay = setting("download/challenge_retry_delay", CHALLENGE_RETRY_DELAY).toInt();
+	if (delay > 0) {
+		m_challengeTimer->start(delay * 1000);
+	}
+
+	log(QStringLiteral("[%1] Cloudflare wall for '%2', pausing requests to this source").arg(m_url, url), Logger::Warning);
+	emit challengeDetected(this);
+}
+
+bool Site::isChallenged() const
+{
+	return m_challenged;
+}
+
+/**
+ * Start the requests paused by a challenge again.
+ * If the challenge is still there, the first reply will pause them again.
+ */
+void Site::resumeRequests()
+{
+	if (!m_challenged) {
+		return;
+	}
+
+	m_challenged = false;
+	m_challengeTimer->stop();
+
+	log(QStringLiteral("[%1] Resuming requests to this source").arg(m_url), Logger::Info);
+	emit challengeCleared(this);
+
+	m_manager->resume();
+
+	QMutexLocker locker(&m_threadNetworksMutex);
+	for (const ThreadNetwork &network : qAsConst(m_threadNetworks)) {
+		NetworkManager *manager = network.manager;
+		QMetaObject::invokeMethod(manager, [manager]() { manager->resume(); }, Qt::QueuedConnection);
+	}
 }
 
 
 QNetworkRequest Site::makeRequest(QUrl url, const QUrl &pageUrl, const QString &ref, Image *img, const QMap<QString, QString> &cHeaders, bool autoLogin)
 {
-	if (m_autoLogin && autoLogin && m_loggedIn == LoginStatus::Unknown) {
-		login();
+	initNetwork();
+
+	if (m_autoLogin && autoLogin) {
+		checkSessionExpiry();
+		if (m_loggedIn == LoginStatus::Unknown) {
+			login();
+		}
 	}
 
 	// Force HTTPS if set so in the settings (no mixed content allowed)
@@ -288,7 +484,13 @@ QNetworkRequest Site::makeRequest(QUrl url, const QUrl &pageUrl, const QString &
 		request.setRawHeader(name.toLatin1(), val);
 	}
 
-	request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, CACHE_POLICY);
+	// Responses are revalidated using their ETag or Last-Modified headers, unless the cache is disabled for this site
+	if (m_settings->value("cache/enabled", true).toBool()) {
+		request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, CACHE_POLICY);
+	} else {
+		request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+		request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+	}
 	return request;
 }
 
@@ -297,6 +499,10 @@ void Site::setRequestHeaders(QNetworkRequest &request) const
 	// Custom headers
 	QMap<QString, QString> headers = settingsHeaders();
 	for (auto it = headers.constBegin(); it != headers.constEnd(); ++it) {
+		// Setting this header disables the transparent decompression of the responses
+		if (it.key().compare(QLatin1String("Accept-Encoding"), Qt::CaseInsensitive) == 0) {
+			continue;
+		}
 		request.setRawHeader(it.key().toLatin1(), it.value().toLatin1());
 	}
 
@@ -330,7 +536,69 @@ QMap<QString, QString> Site::settingsHeaders() const
 NetworkReply *Site::get(const QUrl &url, Site::QueryType type, const QUrl &pageUrl, const QString &ref, Image *img, const QMap<QString, QString> &headers)
 {
 	const QNetworkRequest request = this->makeRequest(url, pageUrl, ref, img, headers);
-	return m_manager->get(request, static_cast<int>(type));
+	return networkManager()->get(request, static_cast<int>(type));
+}
+
+/**
+ * Open connections to the hosts of URLs that will probably be requested soon, such as the thumbnails of a page.
+ */
+void Site::preconnect(const QList<QUrl> &urls)
+{
+	if (!setting("download/preconnect", true).toBool()) {
+		return;
+	}
+
+	NetworkManager *manager = networkManager();
+	for (const QUrl &url : urls) {
+		manager->preconnect(fixUrl(url));
+	}
+}
+
+/**
+ * The network manager to use for requests made from the calling thread.
+ *
+ * Network managers can only be used from their own thread, so other threads get their own, created on first use and
+ * deleted when the thread finishes. They share the throttling and cookies of the site's main manager.
+ */
+NetworkManager *Site::networkManager()
+{
+	QThread *current = QThread::currentThread();
+	if (current == thread()) {
+		return m_manager;
+	}
+
+	QMutexLocker locker(&m_threadNetworksMutex);
+	return threadNetwork(current).manager;
+}
+
+Site::ThreadNetwork &Site::threadNetwork(QThread *thread)
+{
+	auto it = m_threadNetworks.find(thread);
+	if (it != m_threadNetworks.end()) {
+		return it.value();
+	}
+
+	ThreadNetwork network;
+	network.manager = new NetworkManager(m_manager, nullptr);
+	network.finishedConnection = connect(thread, &QThread::finished, network.manager, [this, thread]() {
+		releaseThreadNetwork(thread);
+	}, Qt::DirectConnection);
+	return m_threadNetworks.insert(thread, network).value();
+}
+
+/**
+ * Called from a finishing thread, whose pending deletions are processed right after.
+ */
+void Site::releaseThreadNetwork(QThread *thread)
+{
+	QMutexLocker locker(&m_threadNetworksMutex);
+	const ThreadNetwork network = m_threadNetworks.take(thread);
+	if (network.detailsBatcher != nullptr) {
+		network.detailsBatcher->deleteLater();
+	}
+	if (network.manager != nullptr) {
+		network.manager->deleteLater();
+	}
 }
 
 
@@ -338,7 +606,75 @@ QVariant Site::setting(const QString &key, const QVariant &def) const { return m
 void Site::setSetting(const QString &key, const QVariant &value, const QVariant &def) const { m_settings->setValue(key, value, def); }
 void Site::syncSettings() const { m_settings->sync(); }
 MixedSettings *Site::settings() const { return m_settings; }
-TagDatabase *Site::tagDatabase() const { return m_tagDatabase; }
+TagDatabase *Site::tagDatabase() const
+{
+	if (m_tagDatabase.isNull()) {
+		// The tag database can be stored out of the profile, to be shared with other profiles
+		ReadWritePath directory = m_source->getPath().readWritePath(m_url);
+		const Profile *profile = m_source->getProfile();
+		if (profile != nullptr && profile->sharedCachePath() != profile->getPath()) {
+			const QString sourceDir = QFileInfo(m_source->getPath().readPath()).fileName();
+			directory = ReadWritePath(directory.readPath(), profile->sharedCachePath() + "/sites/" + sourceDir + "/" + m_url);
+		}
+
+		m_tagDatabase = TagDatabaseFactory::Shared(directory, setting("tag_database").toString());
+	}
+	return m_tagDatabase.data();
+}
+
+ExtensionStats *Site::extensionStats() const
+{
+	if (m_extensionStats == nullptr) {
+		m_extensionStats = new ExtensionStats(m_source->getPath().readWritePath(m_url).writePath("extensions.json", true));
+	}
+	return m_extensionStats;
+}
+
+MirrorSelector *Site::mirrorSelector() const
+{
+	return m_mirrorSelector;
+}
+
+QStringList Site::thumbnailFormats() const
+{
+	return m_thumbnailFormats;
+}
+
+ApiStats *Site::apiStats() const
+{
+	if (m_apiStats == nullptr) {
+		const int probeInterval = setting("download/api_probe_interval", 3600).toInt();
+		m_apiStats = new ApiStats(m_source->getPath().readWritePath(m_url).writePath("apis.json", true), probeInterval);
+	}
+	return m_apiStats;
+}
+
+PageSummaryCache *Site::pageSummaryCache() const
+{
+	if (m_pageSummaryCache == nullptr) {
+		m_pageSummaryCache = new PageSummaryCache(setting("summary_cache_age", 10 * 60).toInt());
+	}
+	return m_pageSummaryCache;
+}
+
+DetailsBatcher *Site::detailsBatcher()
+{
+	// Batchers use the network manager and timers of their thread
+	QThread *current = QThread::currentThread();
+	if (current != thread()) {
+		QMutexLocker locker(&m_threadNetworksMutex);
+		ThreadNetwork &network = threadNetwork(current);
+		if (network.detailsBatcher == nullptr) {
+			network.detailsBatcher = new DetailsBatcher(this);
+		}
+		return network.detailsBatcher;
+	}
+
+	if (m_detailsBatcher == nullptr) {
+		m_detailsBatcher = new DetailsBatcher(this);
+	}
+	return m_detailsBatcher;
+}
 
 QString Site::baseUrl() const
 {
@@ -408,7 +744,12 @@ void Site::setAutoLogin(bool autoLogin) { m_autoLogin = autoLogin; }
 
 QString Site::fixLoginUrl(QString url) const
 {
-	if (m_auth == nullptr || m_login == nullptr) {
+	if (m_auth == nullptr) {
+		return url;
+	}
+
+	const_cast<Site*>(this)->initNetwork();
+	if (m_login == nullptr) {
 		return url;
 	}
 
@@ -465,6 +806,53 @@ bool Site::isLoggedIn(bool unknown, bool pending) const
 	return m_loggedIn == LoginStatus::LoggedIn;
 }
 
+/**
+ * Whether the site is logged in and the session cookie did not expire yet, in which case there is no need to login.
+ */
+bool Site::hasValidSession() const
+{
+	if (m_loggedIn != LoginStatus::LoggedIn) {
+		return false;
+	}
+	return !m_sessionExpiry.isValid() || m_sessionExpiry > QDateTime::currentDateTimeUtc();
+}
+
+/**
+ * The expiration date of the current session, or an invalid date if it is not known or never expires.
+ */
+const QDateTime &Site::sessionExpiry() const
+{
+	return m_sessionExpiry;
+}
+
+/**
+ * Forget the login status once the session cookie expired, so that the next requests log in again.
+ */
+void Site::checkSessionExpiry()
+{
+	if (m_loggedIn == LoginStatus::LoggedIn && m_sessionExpiry.isValid() && m_sessionExpiry <= QDateTime::currentDateTimeUtc()) {
+		log(QStringLiteral("[%1] Session expired").arg(m_url), Logger::Info);
+		m_loggedIn = LoginStatus::Unknown;
+		m_sessionExpiry = QDateTime();
+	}
+}
+
+QDateTime Site::computeSessionExpiry() const
+{
+	auto *httpAuth = dynamic_cast<HttpAuth*>(m_auth);
+	if (httpAuth == nullptr || httpAuth->cookie().isEmpty()) {
+		return QDateTime();
+	}
+
+	const QList<QNetworkCookie> cookies = m_cookieJar->cookiesForUrl(fixUrl(httpAuth->url()));
+	for (const QNetworkCookie &cookie : cookies) {
+		if (cookie.name() == httpAuth->cookie() && !cookie.isSessionCookie()) {
+			return cookie.expirationDate().toUTC();
+		}
+	}
+	return QDateTime();
+}
+
 bool Site::remove()
 {
 	const bool ret = m_source->removeSite(this);
@@ -1,22 +1,34 @@
 #ifndef SITE_H
 #define SITE_H
 
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
 #include <QString>
+#include <QStringList>
 #include <QUrl>
 #include <QVariant>
 #include "login/login.h"
 
 
 class Api;
+class ApiStats;
 class Auth;
+class DetailsBatcher;
+class ExtensionStats;
 class Image;
+class MirrorSelector;
 class MixedSettings;
 class NetworkManager;
 class NetworkReply;
 class Page;
+class PageSummaryCache;
 class PersistentCookieJar;
 class QNetworkCookie;
 class QNetworkRequest;
+class QThread;
+class QTimer;
 class Source;
 class Tag;
 class TagDatabase;
@@ -66,8 +78,15 @@ class Site : public QObject
 		MixedSettings *settings() const;
 		QMap<QString, QString> settingsHeaders() const;
 		TagDatabase *tagDatabase() const;
+		ExtensionStats *extensionStats() const;
+		ApiStats *apiStats() const;
+		MirrorSelector *mirrorSelector() const;
+		PageSummaryCache *pageSummaryCache() const;
+		QStringList thumbnailFormats() const;
+		DetailsBatcher *detailsBatcher();
 		QNetworkRequest makeRequest(QUrl url, const QUrl &pageUrl = {}, const QString &ref = "", Image *img = nullptr, const QMap<QString, QString>& headers = {}, bool login = true);
 		NetworkReply *get(const QUrl &url, Site::QueryType type, const QUrl &pageUrl = {}, const QString &ref = "", Image *img = nullptr, const QMap<QString, QString>& headers = {});
+		void preconnect(const QList<QUrl> &urls);
 		QUrl fixUrl(const QUrl &url) const { return fixUrl(url.toString()); }
 		QUrl fixUrl(const QString &url, const QUrl &old = QUrl()) const;
 		void setRequestHeaders(QNetworkRequest &request) const;
@@ -87,15 +106,33 @@ class Site : public QObject
 		void setAutoLogin(bool autoLogin);
 		bool autoLogin() const;
 		bool isLoggedIn(bool unknown = false, bool pending = false) const;
+		bool hasValidSession() const;
+		const QDateTime &sessionExpiry() const;
 		bool canTestLogin() const;
 		QString fixLoginUrl(QString url) const;
 
+		// Challenges
+		bool checkChallenge(NetworkReply *reply);
+		bool isChallenged() const;
+
 	public slots:
 		void login(bool force = false);
 		void loginFinished(Login::Result result);
+		void resumeRequests();
+
+	protected:
+		void initNetwork();
+		void loadNetworkConfig();
+		NetworkManager *networkManager();
+		void releaseThreadNetwork(QThread *thread);
+		void pauseForChallenge(const QString &url);
+		void checkSessionExpiry();
+		QDateTime computeSessionExpiry() const;
 
 	signals:
 		void loggedIn(Site *site, Site::LoginResult result);
+		void challengeDetected(Site *site);
+		void challengeCleared(Site *site);
 		void finishedLoadingTags(const QList<Tag> &tags);
 		void removed();
 
@@ -109,13 +146,35 @@ class Site : public QObject
 		NetworkManager *m_manager;
 		PersistentCookieJar *m_cookieJar;
 		QList<Api*> m_apis;
-		TagDatabase *m_tagDatabase;
+		mutable QSharedPointer<TagDatabase> m_tagDatabase;
+		mutable ExtensionStats *m_extensionStats = nullptr;
+		mutable ApiStats *m_apiStats = nullptr;
+		mutable PageSummaryCache *m_pageSummaryCache = nullptr;
+		MirrorSelector *m_mirrorSelector = nullptr;
+		QStringList m_thumbnailFormats;
+		DetailsBatcher *m_detailsBatcher = nullptr;
+
+		// Network objects for the other threads using this site, such as the batch engine's
+		struct ThreadNetwork
+		{
+			NetworkManager *manager = nullptr;
+			DetailsBatcher *detailsBatcher = nullptr;
+			QMetaObject::Connection finishedConnection;
+		};
+		ThreadNetwork &threadNetwork(QThread *thread);
+		QMutex m_threadNetworksMutex;
+		QHash<QThread*, ThreadNetwork> m_threadNetworks;
 
 		// Login
 		Login *m_login;
 		Auth *m_auth;
 		LoginStatus m_loggedIn = LoginStatus::Unknown;
+		QDateTime m_sessionExpiry;
 		bool m_autoLogin;
+
+		// Challenges
+		bool m_challenged = false;
+		QTimer *m_challengeTimer = nullptr;
 };
 
 Q_DECLARE_METATYPE(Site::LoginResult)
@@ -1,6 +1,6 @@
 #include "models/source-guesser.h"
-#include <QEventLoop>
 #include <QNetworkRequest>
+#include <QUrl>
 #include <utility>
 #include "functions.h"
 #include "logger.h"
@@ -16,52 +16,109 @@ SourceGuesser::SourceGuesser(QString url, QList<Source*> sources, QObject *paren
 	m_manager = new NetworkManager(this);
 }
 
-Source *SourceGuesser::start()
+SourceGuesser::~SourceGuesser()
 {
-	m_cache.clear();
-	int current = 0;
+	cancel();
+}
+
+bool SourceGuesser::isRunning() const
+{
+	return m_running;
+}
+
+void SourceGuesser::start()
+{
+	cancel();
+	m_candidates.clear();
+	m_done = 0;
+	m_running = true;
 
 	for (Source *source : qAsConst(m_sources)) {
-		Api *api = nullptr;
-		for (Api *a : source->getApis()) {
-			if (a->canLoadCheck()) {
-				api = a;
+		for (Api *api : source->getApis()) {
+			if (api->canLoadCheck()) {
+				m_candidates.append(Candidate { source, api, api->checkUrl().url, Pending });
 				break;
 			}
 		}
+	}
 
-		if (api != nullptr) {
-			const QString checkUrl = api->checkUrl().url;
-			if (!m_cache.contains(checkUrl)) {
-				QUrl getUrl(m_url + checkUrl);
-				NetworkReply *reply;
-				do {
-					reply = m_manager->get(QNetworkRequest(getUrl));
-					QEventLoop loop;
-					connect(reply, &NetworkReply::finished, &loop, &QEventLoop::quit);
-					loop.exec();
-
-					getUrl = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
-				} while (!getUrl.isEmpty());
-
-				if (reply->error() != 0) {
-					log(QStringLiteral("Error getting the test page: %1.").arg(reply->errorString()), Logger::Error);
-					emit progress(++current);
-					continue;
-				}
-
-				m_cache[checkUrl] = reply->readAll();
-			}
+	// Sources sharing the same check page only need to load it once
+	for (const Candidate &candidate : qAsConst(m_candidates)) {
+		if (!m_replies.contains(candidate.checkUrl)) {
+			load(candidate.checkUrl, QUrl(m_url + candidate.checkUrl));
+		}
+	}
 
-			if (api->parseCheck(m_cache[checkUrl], 200).ok) {
-				emit finished(source);
-				return source;
-			}
+	resolve();
+}
+
+void SourceGuesser::cancel()
+{
+	m_running = false;
 
-			emit progress(++current);
+	for (NetworkReply *reply : qAsConst(m_replies)) {
+		reply->disconnect(this);
+		reply->abort();
+		reply->deleteLater();
+	}
+	m_replies.clear();
+}
+
+void SourceGuesser::load(const QString &checkUrl, const QUrl &url)
+{
+	NetworkReply *reply = m_manager->get(QNetworkRequest(url));
+	m_replies.insert(checkUrl, reply);
+	connect(reply, &NetworkReply::finished, this, [this, checkUrl, reply]() { loaded(checkUrl, reply); });
+}
+
+void SourceGuesser::loaded(const QString &checkUrl, NetworkReply *reply)
+{
+	m_replies.remove(checkUrl);
+	reply->deleteLater();
+
+	// Follow redirections
+	const QUrl redirection = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+	if (!redirection.isEmpty()) {
+		load(checkUrl, redirection);
+		return;
+	}
+
+	const bool error = reply->error() != 0;
+	if (error) {
+		log(QStringLiteral("Error getting the test page: %1.").arg(reply->errorString()), Logger::Error);
+	}
+
+	const QString content = error ? QString() : QString(reply->readAll());
+	for (Candidate &candidate : m_candidates) {
+		if (candidate.checkUrl == checkUrl && candidate.state == Pending) {
+			candidate.state = !error && candidate.api->parseCheck(content, 200).ok ? Matched : Failed;
+			emit progress(++m_done);
+		}
+	}
+
+	resolve();
+}
+
+/**
+ * Finish as soon as the result is known, that is when a source matched and all the sources before it failed.
+ */
+void SourceGuesser::resolve()
+{
+	if (!m_running) {
+		return;
+	}
+
+	Source *result = nullptr;
+	for (const Candidate &candidate : qAsConst(m_candidates)) {
+		if (candidate.state == Pending) {
+			return;
+		}
+		if (candidate.state == Matched) {
+			result = candidate.source;
+			break;
 		}
 	}
 
-	emit finished(nullptr);
-	return nullptr;
+	cancel();
+	emit finished(result);
 }
@@ -7,16 +7,50 @@
 #include <QString>
 
 
+class Api;
 class NetworkManager;
+class NetworkReply;
+class QUrl;
 class Source;
 
+/**
+ * Guess the source of a website by loading the check page of each source and checking whether it can parse it.
+ *
+ * All check pages are loaded at the same time, so that guessing takes as long as the slowest page instead of
+ * all of them. The first matching source in the list order is returned, as soon as all sources before it failed.
+ */
 class SourceGuesser : public QObject
 {
 	Q_OBJECT
 
 	public:
 		SourceGuesser(QString url, QList<Source*> sources, QObject *parent = nullptr);
-		Source *start();
+		~SourceGuesser() override;
+		bool isRunning() const;
+
+	public slots:
+		void start();
+		void cancel();
+
+	protected:
+		enum State
+		{
+			Pending,
+			Failed,
+			Matched,
+		};
+
+		struct Candidate
+		{
+			Source *source;
+			Api *api;
+			QString checkUrl;
+			State state;
+		};
+
+		void load(const QString &checkUrl, const QUrl &url);
+		void loaded(const QString &checkUrl, NetworkReply *reply);
+		void resolve();
 
 	signals:
 		void progress(int current);
@@ -26,7 +60,10 @@ class SourceGuesser : public QObject
 		QString m_url;
 		QList<Source*> m_sources;
 		NetworkManager *m_manager;
-		QMap<QString, QString> m_cache;
+		QList<Candidate> m_candidates;
+		QMap<QString, NetworkReply*> m_replies;
+		int m_done = 0;
+		bool m_running = false;
 };
 
 #endif // SOURCE_GUESSER_H
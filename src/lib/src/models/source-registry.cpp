@@ -6,20 +6,28 @@
 #include <utility>
 #include "js-helpers.h"
 #include "logger.h"
+#include "network/network-disk-cache.h"
 #include "network/network-manager.h"
 #include "network/network-reply.h"
 
 
-SourceRegistry::SourceRegistry(QString jsonUrl, QObject *parent)
+SourceRegistry::SourceRegistry(QString jsonUrl, const QString &cacheDirectory, QObject *parent)
 	: QObject(parent), m_jsonUrl(std::move(jsonUrl))
 {
 	m_manager = new NetworkManager(this);
+
+	if (!cacheDirectory.isEmpty() && m_manager->cache() == nullptr) {
+		auto *diskCache = new NetworkDiskCache();
+		diskCache->setCacheDirectory(cacheDirectory);
+		m_manager->setCache(diskCache);
+	}
 }
 
 void SourceRegistry::load()
 {
 	QNetworkRequest request(m_jsonUrl);
 	request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+	request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork);
 
 	NetworkReply *reply = m_manager->get(request);
 	connect(reply, &NetworkReply::finished, this, &SourceRegistry::jsonLoaded);
@@ -28,6 +36,7 @@ void SourceRegistry::load()
 void SourceRegistry::jsonLoaded()
 {
 	auto *reply = qobject_cast<NetworkReply*>(sender());
+	reply->deleteLater();
 
 	// Loading error
 	if (reply->error() != NetworkReply::NetworkError::NoError) {
@@ -28,12 +28,18 @@ struct SourceRegistrySource
 
 class NetworkManager;
 
+/**
+ * Loads the JSON manifest of a source registry, listing its sources and their hashes.
+ *
+ * When given a cache directory, the manifest is kept in a disk cache, so that it is revalidated using its ETag
+ * instead of being downloaded again at each startup if it didn't change.
+ */
 class SourceRegistry : public QObject
 {
 	Q_OBJECT
 
 	public:
-		explicit SourceRegistry(QString jsonUrl, QObject *parent = nullptr);
+		explicit SourceRegistry(QString jsonUrl, const QString &cacheDirectory = QString(), QObject *parent = nullptr);
 		void load();
 
 		const QString &jsonUrl() const { return m_jsonUrl; }
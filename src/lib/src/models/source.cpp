@@ -1,11 +1,17 @@
 #include "models/source.h"
+#include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QJSEngine>
 #include <QJSValue>
 #include <QJSValueIterator>
-#include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
 #include "auth/auth-const-field.h"
 #include "auth/auth-field.h"
 #include "auth/auth-hash-field.h"
@@ -16,44 +22,248 @@
 #include "auth/url-auth.h"
 #include "functions.h"
 #include "logger.h"
+#include "metrics.h"
 #include "models/api/api.h"
 #include "models/api/javascript-api.h"
+#include "models/api/parser-thread-pool.h"
 #include "models/site.h"
 #include "js-helpers.h"
+#include "utils/file-utils.h"
 
+#define MODEL_CACHE_VERSION 2
+#define JS_GC_THRESHOLD 64
+#define JS_RECYCLE_THRESHOLD 1024
 
-QString getUpdaterBaseUrl()
+
+// A QJSEngine can only be used from the thread it was created in, so worker threads (i.e. page parsers) get their own
+// Evaluated models are keyed by their hash, to be shared by the sources of all the profiles using the same model
+struct JavascriptThreadContext
+{
+	~JavascriptThreadContext()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		properties.clear();
+		sources.clear();
+		delete engine;
+		engine = nullptr;
+	}
+
+	QString helperFile;
+	QJSEngine *engine = nullptr;
+	QHash<QString, QJSValue> sources;
+	QHash<QString, QHash<QString, QJSValue>> properties;
+	qint64 workSinceGc = 0;
+	qint64 workSinceCreation = 0;
+};
+static QThreadStorage<JavascriptThreadContext*> jsThreadContexts;
+
+static JavascriptThreadContext *jsThreadContext(const QString &helperFile)
 {
-	#if defined NIGHTLY || defined QT_DEBUG
-		return QStringLiteral("https://raw.githubusercontent.com/Bionus/imgbrd-grabber/develop/src/sites");
-	#else
-		return QStringLiteral("https://raw.githubusercontent.com/Bionus/imgbrd-grabber/master/src/sites");
-	#endif
+	if (!jsThreadContexts.hasLocalData()) {
+		auto *context = new JavascriptThreadContext();
+		context->helperFile = helperFile;
+		context->engine = buildJsEngine(helperFile);
+		jsThreadContexts.setLocalData(context);
+	}
+	return jsThreadContexts.localData();
 }
 
+// The main thread's engine is shared by all sources and never recycled, as sources keep values from it
+static QJSEngine *mainJsEngine = nullptr;
+static QHash<QString, QJSValue> mainJsSources;
+static QHash<QString, QHash<QString, QJSValue>> mainJsProperties;
+static qint64 mainJsWorkSinceGc = 0;
+static QAtomicInt jsGcThreshold(JS_GC_THRESHOLD);
+static QAtomicInt jsRecycleThreshold(JS_RECYCLE_THRESHOLD);
+
 QJSEngine *Source::jsEngine()
 {
-	static QJSEngine *engine = nullptr;
+	if (QThread::currentThread() != thread()) {
+		return jsThreadContext(m_dir.readPath("../helper.js"))->engine;
+	}
+
+	if (mainJsEngine == nullptr) {
+		mainJsEngine = buildJsEngine(m_dir.readPath("../helper.js"));
+	}
+
+	return mainJsEngine;
+}
+
+/**
+ * Set how many MB of responses can be handled by an engine before collecting its garbage, and before replacing it
+ * by a new one altogether. A value of 0 disables them.
+ */
+void Source::setJsEngineLimits(int gcThreshold, int recycleThreshold)
+{
+	jsGcThreshold.storeRelaxed(gcThreshold);
+	jsRecycleThreshold.storeRelaxed(recycleThreshold);
+}
+
+/**
+ * Account for the Javascript work done to handle a response of the given size in the engine of the calling thread.
+ *
+ * Qt does not expose the heap usage of an engine, so the amount of data handled is used instead, most of the heap
+ * being made of the strings and objects built from it. Garbage is explicitly collected once enough data was
+ * handled, and engines of parser threads are recycled after a while to release the memory that the garbage
+ * collector never gives back. Their models are then evaluated again on first use.
+ *
+ * This must only be called when no value of the engine is still in use, for example between two pages.
+ */
+void Source::jsWorkDone(qint64 bytes)
+{
+	const qint64 gcThreshold = static_cast<qint64>(jsGcThreshold.loadRelaxed()) * 1024 * 1024;
+	const qint64 recycleThreshold = static_cast<qint64>(jsRecycleThreshold.loadRelaxed()) * 1024 * 1024;
+
+	if (jsThreadContexts.hasLocalData()) {
+		JavascriptThreadContext *context = jsThreadContexts.localData();
+		context->workSinceGc += bytes;
+		context->workSinceCreation += bytes;
+
+		if (recycleThreshold > 0 && context->workSinceCreation >= recycleThreshold) {
+			log(QStringLiteral("Recycling Javascript engine after %1 MB of data").arg(context->workSinceCreation / 1024 / 1024), Logger::Info);
+			context->clear();
+			context->engine = buildJsEngine(context->helperFile);
+			context->workSinceGc = 0;
+			context->workSinceCreation = 0;
+			Metrics::getInstance().increment("grabber_js_engine_recycles_total");
+		} else if (gcThreshold > 0 && context->workSinceGc >= gcThreshold) {
+			context->engine->collectGarbage();
+			context->workSinceGc = 0;
+			Metrics::getInstance().increment("grabber_js_engine_gcs_total");
+		}
+		return;
+	}
+
+	const QCoreApplication *app = QCoreApplication::instance();
+	if (mainJsEngine == nullptr || app == nullptr || QThread::currentThread() != app->thread()) {
+		return;
+	}
+
+	mainJsWorkSinceGc += bytes;
+	if (gcThreshold > 0 && mainJsWorkSinceGc >= gcThreshold) {
+		mainJsEngine->collectGarbage();
+		mainJsWorkSinceGc = 0;
+		Metrics::getInstance().increment("grabber_js_engine_gcs_total");
+	}
+}
+
+QJSValue Source::jsSource()
+{
+	if (QThread::currentThread() == thread()) {
+		if (m_jsModel.isEmpty()) {
+			return QJSValue();
+		}
+		auto it = mainJsSources.find(m_modelHash);
+		if (it == mainJsSources.end()) {
+			it = mainJsSources.insert(m_modelHash, evaluateModel(jsEngine()));
+		}
+		return it.value();
+	}
+
+	auto *context = jsThreadContext(m_dir.readPath("../helper.js"));
+	auto it = context->sources.find(m_modelHash);
+	if (it == context->sources.end()) {
+		it = context->sources.insert(m_modelHash, evaluateModel(context->engine));
+	}
+	return it.value();
+}
+
+/**
+ * Get a property of the model from its dotted path (e.g. "apis.json.search.url"), or undefined if it doesn't exist.
+ * The result is cached per thread, so that the hot paths (URL building, parsing) don't walk the model each time.
+ */
+QJSValue Source::jsProperty(const QString &path)
+{
+	const QJSValue source = jsSource();
+	QHash<QString, QJSValue> &properties = QThread::currentThread() == thread()
+		? mainJsProperties[m_modelHash]
+		: jsThreadContext(m_dir.readPath("../helper.js"))->properties[m_modelHash];
+
+	auto it = properties.constFind(path);
+	if (it != properties.constEnd()) {
+		return it.value();
+	}
 
-	if (engine == nullptr) {
-		engine = buildJsEngine(m_dir.readPath("../helper.js"));
+	QJSValue value = source;
+	const QStringList parts = path.split('.');
+	for (int i = 0; !value.isUndefined() && i < parts.count(); ++i) {
+		value = value.property(parts[i]);
 	}
 
-	return engine;
+	properties.insert(path, value);
+	return value;
 }
-QMutex *Source::jsEngineMutex()
+
+/**
+ * Evaluate the model in the engines of all parser threads, so that the first pages don't pay for it.
+ */
+void Source::warmUpEngines()
+{
+	if (m_jsModel.isEmpty() || !m_enginesWarmedUp.testAndSetRelaxed(0, 1)) {
+		return;
+	}
+
+	m_warmUpFutures = runOnEachParserThread([this]() {
+		jsSource();
+	});
+}
+
+QJSValue Source::evaluateModel(QJSEngine *engine) const
 {
-	static QMutex *mutex = nullptr;
+	return engine->evaluate(m_jsModel, m_jsModelFile);
+}
 
-	if (mutex == nullptr) {
-		mutex = new QMutex();
+/**
+ * Load the static information of the model (name, APIs, auth, etc.) from the cache, if it was built from the same file.
+ * This allows us to delay the actual evaluation of the model until it is really used.
+ */
+QJSValue Source::loadCachedMetadata(const QString &hash)
+{
+	QFile f(m_dir.writePath("model.cache.json"));
+	if (!f.open(QFile::ReadOnly)) {
+		return QJSValue(QJSValue::UndefinedValue);
 	}
 
-	return mutex;
+	const QJsonObject cache = QJsonDocument::fromJson(f.readAll()).object();
+	if (cache["version"].toInt() != MODEL_CACHE_VERSION || cache["hash"].toString() != hash) {
+		return QJSValue(QJSValue::UndefinedValue);
+	}
+
+	return jsEngine()->toScriptValue(cache["source"].toObject().toVariantMap());
+}
+
+void Source::saveCachedMetadata(const QString &hash, const QJSValue &source) const
+{
+	// Only keep the API names, as their actual contents are only needed when evaluating the model
+	QJsonObject apis;
+	QJSValueIterator it(source.property("apis"));
+	while (it.hasNext()) {
+		it.next();
+		apis.insert(it.name(), QJsonObject());
+	}
+
+	QJsonObject metadata;
+	metadata["name"] = source.property("name").toString();
+	metadata["tokens"] = QJsonArray::fromStringList(jsToStringList(source.property("tokens")));
+	metadata["thumbnailFormats"] = QJsonArray::fromStringList(jsToStringList(source.property("thumbnailFormats")));
+	metadata["tagFormat"] = QJsonValue::fromVariant(source.property("tagFormat").toVariant());
+	metadata["auth"] = QJsonValue::fromVariant(source.property("auth").toVariant());
+	metadata["apis"] = apis;
+
+	QJsonObject cache;
+	cache["version"] = MODEL_CACHE_VERSION;
+	cache["hash"] = hash;
+	cache["source"] = metadata;
+
+	writeFile(m_dir.writePath("model.cache.json"), QJsonDocument(cache).toJson(QJsonDocument::Compact));
 }
 
 Source::Source(Profile *profile, const ReadWritePath &dir)
-	: m_dir(dir), m_diskName(QFileInfo(dir.readPath()).fileName()), m_profile(profile), m_updater(m_diskName, m_dir, getUpdaterBaseUrl())
+	: m_dir(dir), m_diskName(QFileInfo(dir.readPath()).fileName()), m_profile(profile)
 {
 	// Tag format mapper
 	static const QMap<QString, TagNameFormat::CaseFormat> caseAssoc
@@ -69,36 +279,50 @@ Source::Source(Profile *profile, const ReadWritePath &dir)
 	if (js.exists() && js.open(QIODevice::ReadOnly | QIODevice::Text)) {
 		log(QStringLiteral("Using Javascript model for %1").arg(m_diskName), Logger::Debug);
 
-		const QString src = "(function() { var window = {}; " + js.readAll().replace("export var source = ", "return ") + " })()";
+		const QByteArray model = js.readAll();
+		m_jsModel = "(function() { var window = {}; " + QByteArray(model).replace("export var source = ", "return ") + " })()";
+		m_jsModelFile = js.fileName();
+
+		// Same hash as the one of the source registries, used to check for updates without downloading the model
+		m_modelHash = QCryptographicHash::hash(model, QCryptographicHash::Sha256).toHex();
 
-		auto *engine = jsEngine();
-		m_jsSource = engine->evaluate(src, js.fileName());
-		if (m_jsSource.isError()) {
-			log(QStringLiteral("Uncaught exception at line %1: %2").arg(m_jsSource.property("lineNumber").toInt()).arg(m_jsSource.toString()), Logger::Error);
+		// Only evaluate the model right away if we don't have its metadata in cache
+		const QString hash = QCryptographicHash::hash(model, QCryptographicHash::Sha1).toHex();
+		QJSValue metadata = loadCachedMetadata(hash);
+		if (metadata.isUndefined()) {
+			metadata = jsSource();
+			if (!metadata.isError()) {
+				saveCachedMetadata(hash, metadata);
+			}
+		}
+
+		if (metadata.isError()) {
+			log(QStringLiteral("Uncaught exception at line %1: %2").arg(metadata.property("lineNumber").toInt()).arg(metadata.toString()), Logger::Error);
 		} else {
-			m_name = m_jsSource.property("name").toString();
-			m_additionalTokens = jsToStringList(m_jsSource.property("tokens"));
+			m_name = metadata.property("name").toString();
+			m_additionalTokens = jsToStringList(metadata.property("tokens"));
+			m_thumbnailFormats = jsToStringList(metadata.property("thumbnailFormats"));
 
 			// Get the list of APIs for this Source
-			const QJSValue apis = m_jsSource.property("apis");
+			const QJSValue apis = metadata.property("apis");
 			QJSValueIterator it(apis);
 			while (it.hasNext()) {
 				it.next();
-				m_apis.append(new JavascriptApi(engine, m_jsSource, jsEngineMutex(), it.name()));
+				m_apis.append(new JavascriptApi(this, it.name()));
 			}
 			if (m_apis.isEmpty()) {
 				log(QStringLiteral("No valid source has been found in the model.js file from %1.").arg(m_name));
 			}
 
 			// Read tag naming format
-			const QJSValue &tagFormat = m_jsSource.property("tagFormat");
+			const QJSValue &tagFormat = metadata.property("tagFormat");
 			if (!tagFormat.isUndefined()) {
 				const auto caseFormat = caseAssoc.value(tagFormat.property("case").toString(), TagNameFormat::Lower);
 				m_tagNameFormat = TagNameFormat(caseFormat, tagFormat.property("wordSeparator").toString());
 			}
 
 			// Read auth information
-			const QJSValue auths = m_jsSource.property("auth");
+			const QJSValue auths = metadata.property("auth");
 			QJSValueIterator authIt(auths);
 			while (authIt.hasNext()) {
 				authIt.next();
@@ -203,6 +427,10 @@ Source::Source(Profile *profile, const ReadWritePath &dir)
 
 Source::~Source()
 {
+	for (QFuture<void> &future : m_warmUpFutures) {
+		future.waitForFinished();
+	}
+
 	qDeleteAll(m_apis);
 	qDeleteAll(m_sites);
 	qDeleteAll(m_auths);
@@ -254,8 +482,9 @@ const QList<Site*> &Source::getSites() const { return m_sites; }
 const QStringList &Source::getSupportedSites() const { return m_supportedSites; }
 const QList<Api*> &Source::getApis() const { return m_apis; }
 Profile *Source::getProfile() const { return m_profile; }
-const SourceUpdater &Source::getUpdater() const { return m_updater; }
+const QString &Source::getModelHash() const { return m_modelHash; }
 const QStringList &Source::getAdditionalTokens() const { return m_additionalTokens; }
+const QStringList &Source::getThumbnailFormats() const { return m_thumbnailFormats; }
 const QMap<QString, Auth*> &Source::getAuths() const { return m_auths; }
 
 Api *Source::getApi(const QString &name) const
@@ -1,6 +1,8 @@
 #ifndef SOURCE_H
 #define SOURCE_H
 
+#include <QAtomicInt>
+#include <QFuture>
 #include <QJSValue>
 #include <QList>
 #include <QMap>
@@ -8,7 +10,6 @@
 #include <QString>
 #include <QStringList>
 #include "tags/tag-name-format.h"
-#include "updater/source-updater.h"
 #include "utils/read-write-path.h"
 
 
@@ -16,7 +17,6 @@ class Api;
 class Auth;
 class Profile;
 class QJSEngine;
-class QMutex;
 class Site;
 
 class Source : public QObject
@@ -36,16 +36,26 @@ class Source : public QObject
 		Api *getApi(const QString &name) const;
 		const QMap<QString, Auth*> &getAuths() const;
 		Profile *getProfile() const;
-		const SourceUpdater &getUpdater() const;
+		const QString &getModelHash() const;
 		const QStringList &getAdditionalTokens() const;
+		const QStringList &getThumbnailFormats() const;
 
 		// Site management
 		bool addSite(Site *site);
 		bool removeSite(Site *site);
 
-	protected:
+		// Javascript model, evaluated in the engine of the calling thread
 		QJSEngine *jsEngine();
-		QMutex *jsEngineMutex();
+		QJSValue jsSource();
+		QJSValue jsProperty(const QString &path);
+		void warmUpEngines();
+		static void setJsEngineLimits(int gcThreshold, int recycleThreshold);
+		static void jsWorkDone(qint64 bytes);
+
+	protected:
+		QJSValue evaluateModel(QJSEngine *engine) const;
+		QJSValue loadCachedMetadata(const QString &hash);
+		void saveCachedMetadata(const QString &hash, const QJSValue &source) const;
 
 	private:
 		ReadWritePath m_dir;
@@ -56,10 +66,14 @@ class Source : public QObject
 		QList<Api*> m_apis;
 		QMap<QString, Auth*> m_auths;
 		QStringList m_additionalTokens;
+		QStringList m_thumbnailFormats;
 		Profile *m_profile;
-		SourceUpdater m_updater;
 		TagNameFormat m_tagNameFormat;
-		QJSValue m_jsSource;
+		QString m_jsModel;
+		QString m_jsModelFile;
+		QString m_modelHash;
+		QAtomicInt m_enginesWarmedUp;
+		QList<QFuture<void>> m_warmUpFutures;
 };
 
 #endif // SOURCE_H
@@ -3,10 +3,16 @@
 #include <QFile>
 #include <QJSEngine>
 #include <QJSValue>
+#include <QtConcurrent>
+#include <QUrl>
+#include <algorithm>
+#include <functional>
 #include "url-downloader.h"
 #include "js-helpers.h"
 #include "logger.h"
 
+#define PARALLEL_MIN_URLS 100
+
 
 UrlDownloaderManager::UrlDownloaderManager(const QString &root, QObject *parent)
 	: QObject(parent)
@@ -48,18 +54,65 @@ bool UrlDownloaderManager::load(const QString &file)
 
 	const quint32 length = result.property("handlers").property("length").toUInt();
 	for (quint32 i = 0; i < length; ++i) {
-		m_downloaders.append(new UrlDownloader(result, i, this));
+		addDownloader(new UrlDownloader(result, i, this));
 	}
 
 	return true;
 }
 
+void UrlDownloaderManager::addDownloader(UrlDownloader *downloader)
+{
+	const int index = m_downloaders.count();
+	m_downloaders.append(downloader);
+
+	const QStringList &hosts = downloader->hosts();
+	if (hosts.isEmpty()) {
+		m_anyHostDownloaders.append(index);
+	}
+	for (const QString &host : hosts) {
+		m_hostDownloaders[host].append(index);
+	}
+}
+
 UrlDownloader *UrlDownloaderManager::canDownload(const QUrl &url) const
 {
-	for (UrlDownloader *downloader : m_downloaders) {
+	// Only check the downloaders of this host or one of its parent domains, and those that can handle any host
+	QList<int> candidates = m_anyHostDownloaders;
+	QString host = url.host().toLower();
+	while (!host.isEmpty()) {
+		const auto it = m_hostDownloaders.constFind(host);
+		if (it != m_hostDownloaders.constEnd()) {
+			candidates.append(it.value());
+		}
+
+		const int dot = host.indexOf('.');
+		host = dot >= 0 ? host.mid(dot + 1) : QString();
+	}
+
+	// Keep the loading order, so that the same downloader is returned as when checking all of them
+	std::sort(candidates.begin(), candidates.end());
+	for (int index : qAsConst(candidates)) {
+		UrlDownloader *downloader = m_downloaders[index];
 		if (downloader->canDownload(url)) {
 			return downloader;
 		}
 	}
 	return nullptr;
 }
+
+QList<UrlDownloader*> UrlDownloaderManager::canDownload(const QList<QUrl> &urls) const
+{
+	// Regexes can be matched from several threads, but starting them is only worth it for big lists
+	std::function<UrlDownloader*(const QUrl &)> find = [this](const QUrl &url) {
+		return canDownload(url);
+	};
+	if (urls.count() < PARALLEL_MIN_URLS) {
+		QList<UrlDownloader*> ret;
+		ret.reserve(urls.count());
+		for (const QUrl &url : urls) {
+			ret.append(find(url));
+		}
+		return ret;
+	}
+	return QtConcurrent::blockingMapped<QList<UrlDownloader*>>(urls, find);
+}
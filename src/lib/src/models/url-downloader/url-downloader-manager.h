@@ -1,6 +1,7 @@
 #ifndef URL_DOWNLOADER_MANAGER_H
 #define URL_DOWNLOADER_MANAGER_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QString>
@@ -20,9 +21,22 @@ class UrlDownloaderManager : public QObject
 		bool load(const QString &file);
 		UrlDownloader *canDownload(const QUrl &url) const;
 
+		/**
+		 * Find the downloader of many URLs at once, checking them in parallel.
+		 * @return The downloader of each URL, in the same order, or nullptr for URLs no downloader can handle.
+		 */
+		QList<UrlDownloader*> canDownload(const QList<QUrl> &urls) const;
+
+	protected:
+		void addDownloader(UrlDownloader *downloader);
+
 	private:
 		QJSEngine *m_engine;
 		QList<UrlDownloader*> m_downloaders;
+
+		// Indexes of the downloaders in m_downloaders, by host or for downloaders that can handle any host
+		QHash<QString, QList<int>> m_hostDownloaders;
+		QList<int> m_anyHostDownloaders;
 };
 
 #endif // URL_DOWNLOADER_MANAGER_H
@@ -11,11 +11,79 @@ UrlDownloader::UrlDownloader(QJSValue downloader, int index, QObject *parent)
 {
 	m_name = m_downloader.property("name").toString();
 
-	const QStringList regexes = jsToStringList(m_downloader.property("handlers").property(m_index).property("regexes"));
+	const QJSValue handler = m_downloader.property("handlers").property(m_index);
+	const QStringList regexes = jsToStringList(handler.property("regexes"));
 	m_regexes.reserve(regexes.count());
 	for (const QString &regex : regexes) {
 		m_regexes.append(QRegularExpression(regex));
 	}
+
+	// Hosts, used to only check the URLs of these hosts against this downloader's regexes
+	if (handler.hasProperty("hosts")) {
+		for (const QString &host : jsToStringList(handler.property("hosts"))) {
+			m_hosts.append(host.toLower());
+		}
+	} else {
+		for (const QString &regex : regexes) {
+			const QString host = hostFromRegex(regex);
+			if (host.isEmpty()) {
+				m_hosts.clear();
+				break;
+			}
+			if (!m_hosts.contains(host)) {
+				m_hosts.append(host);
+			}
+		}
+	}
+}
+
+/**
+ * Get the literal host of a regex matching URLs, such as "^https?://(?:www\.)?example\.com/", or an empty string
+ * if URLs of other hosts could match it.
+ */
+QString UrlDownloader::hostFromRegex(const QString &regex)
+{
+	static const QStringList prefixes { "^https?://", "^https://", "^http://" };
+	int i = -1;
+	for (const QString &prefix : prefixes) {
+		if (regex.startsWith(prefix)) {
+			i = prefix.length();
+			break;
+		}
+	}
+	if (i < 0) {
+		return QString();
+	}
+
+	// Skip an optional subdomain group, since subdomains are matched anyway
+	if (i < regex.length() && regex[i] == '(') {
+		const int end = regex.indexOf(QLatin1String(")?"), i);
+		if (end < 0) {
+			return QString();
+		}
+		i = end + 2;
+	}
+
+	// Only keep hosts made of literal characters, ending with a path, a port or the end of the URL
+	QString host;
+	for (; i < regex.length(); ++i) {
+		const QChar c = regex[i];
+		if (c == '\\' && i + 1 < regex.length() && regex[i + 1] == '.') {
+			host.append('.');
+			++i;
+		} else if (c.isLetterOrNumber() || c == '-') {
+			host.append(c.toLower());
+		} else if (c == '/' || c == ':' || c == '$') {
+			break;
+		} else {
+			return QString();
+		}
+	}
+
+	if (!host.contains('.') || host.startsWith('.') || host.endsWith('.')) {
+		return QString();
+	}
+	return host;
 }
 
 const QString &UrlDownloader::name() const
@@ -24,6 +92,11 @@ const QString &UrlDownloader::name() const
 }
 
 
+const QStringList &UrlDownloader::hosts() const
+{
+	return m_hosts;
+}
+
 bool UrlDownloader::canDownload(const QUrl &url) const
 {
 	const QString str = url.toString();
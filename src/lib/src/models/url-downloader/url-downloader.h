@@ -7,6 +7,7 @@
 #include <QObject>
 #include <QRegularExpression>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 
 
@@ -44,6 +45,14 @@ class UrlDownloader : public QObject
 		UrlDownloader(QJSValue downloader, int index, QObject *parent = nullptr);
 		const QString &name() const;
 		bool canDownload(const QUrl &url) const;
+
+		/**
+		 * The hosts this downloader can handle (including their subdomains), or an empty list if it can handle any.
+		 * They are either declared by the handler, or guessed from its regexes when they all start with a literal host.
+		 */
+		const QStringList &hosts() const;
+		static QString hostFromRegex(const QString &regex);
+
 		UrlDownloaderUrl url(const QUrl &url) const;
 		UrlDownloaderResult parse(const QString &source, int statusCode) const;
 
@@ -52,6 +61,7 @@ class UrlDownloader : public QObject
 		int m_index;
 		QString m_name;
 		QList<QRegularExpression> m_regexes;
+		QStringList m_hosts;
 };
 
 #endif // URL_DOWNLOADER_H
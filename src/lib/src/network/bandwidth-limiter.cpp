@@ -0,0 +1,115 @@
+#include "bandwidth-limiter.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QtMath>
+
+// Minimum number of bytes worth waiting for, to avoid waking up for every few bytes
+#define MIN_CHUNK 4096
+
+
+BandwidthLimiter::BandwidthLimiter(qint64 bytesPerSecond)
+	: m_rate(qMax(static_cast<qint64>(0), bytesPerSecond))
+{}
+
+BandwidthLimiter &BandwidthLimiter::global()
+{
+	static auto *instance = new BandwidthLimiter();
+	return *instance;
+}
+
+
+qint64 BandwidthLimiter::rate() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_rate;
+}
+
+/**
+ * Change the maximum rate, 0 meaning no limit.
+ */
+void BandwidthLimiter::setRate(qint64 bytesPerSecond)
+{
+	QMutexLocker locker(&m_mutex);
+	m_rate = qMax(static_cast<qint64>(0), bytesPerSecond);
+	m_tokens = 0;
+	m_lastRefill = 0;
+}
+
+bool BandwidthLimiter::isLimited() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_rate > 0;
+}
+
+
+void BandwidthLimiter::refill(qint64 now)
+{
+	const double burst = qMax(static_cast<double>(MIN_CHUNK), m_rate / 4.0);
+	if (m_lastRefill == 0) {
+		m_tokens = burst;
+	} else if (now > m_lastRefill) {
+		m_tokens = qMin(burst, m_tokens + static_cast<double>(now - m_lastRefill) * m_rate / 1000.0);
+	}
+	m_lastRefill = now;
+}
+
+qint64 BandwidthLimiter::available(qint64 wanted)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_rate <= 0) {
+		return wanted;
+	}
+
+	refill(QDateTime::currentMSecsSinceEpoch());
+	return qBound(static_cast<qint64>(0), static_cast<qint64>(m_tokens), wanted);
+}
+
+void BandwidthLimiter::consume(qint64 bytes)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_rate <= 0) {
+		return;
+	}
+
+	refill(QDateTime::currentMSecsSinceEpoch());
+	m_tokens -= bytes;
+}
+
+int BandwidthLimiter::msToRead(qint64 bytes)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_rate <= 0) {
+		return 0;
+	}
+
+	refill(QDateTime::currentMSecsSinceEpoch());
+	const double chunk = qMin(static_cast<double>(qMax(static_cast<qint64>(1), bytes)), qMax(static_cast<double>(MIN_CHUNK), m_rate / 4.0));
+	if (m_tokens >= chunk) {
+		return 0;
+	}
+	return qCeil((chunk - m_tokens) * 1000.0 / m_rate);
+}
+
+
+qint64 BandwidthLimiter::acquire(const QList<BandwidthLimiter*> &limiters, qint64 wanted)
+{
+	qint64 allowed = wanted;
+	for (BandwidthLimiter *limiter : limiters) {
+		allowed = limiter->available(allowed);
+	}
+	if (allowed > 0) {
+		for (BandwidthLimiter *limiter : limiters) {
+			limiter->consume(allowed);
+		}
+	}
+	return allowed;
+}
+
+int BandwidthLimiter::msToRead(const QList<BandwidthLimiter*> &limiters, qint64 bytes)
+{
+	int ms = 0;
+	for (BandwidthLimiter *limiter : limiters) {
+		ms = qMax(ms, limiter->msToRead(bytes));
+	}
+	return ms;
+}
@@ -0,0 +1,53 @@
+#ifndef BANDWIDTH_LIMITER_H
+#define BANDWIDTH_LIMITER_H
+
+#include <QList>
+#include <QMutex>
+
+
+/**
+ * Token-bucket limit of the number of bytes per second read from the network.
+ *
+ * The bucket is refilled continuously at the configured rate, up to a quarter of a second of data, and each read
+ * consumes as many tokens as bytes. Limiters can be shared by replies living on different threads.
+ *
+ * The global limiter applies to all the replies, while others can be given to some replies, for example to the ones
+ * of a download queue. A reply then reads at the rate of its slowest limiter.
+ */
+class BandwidthLimiter
+{
+	public:
+		explicit BandwidthLimiter(qint64 bytesPerSecond = 0);
+		static BandwidthLimiter &global();
+
+		qint64 rate() const;
+		void setRate(qint64 bytesPerSecond);
+		bool isLimited() const;
+
+		qint64 available(qint64 wanted);
+		void consume(qint64 bytes);
+		int msToRead(qint64 bytes);
+
+		/**
+		 * Reserve up to `wanted` bytes on all the given limiters.
+		 *
+		 * @return The number of bytes that can be read right away
+		 */
+		static qint64 acquire(const QList<BandwidthLimiter*> &limiters, qint64 wanted);
+
+		/**
+		 * The time to wait before the given limiters allow reading at least one more chunk of data.
+		 */
+		static int msToRead(const QList<BandwidthLimiter*> &limiters, qint64 bytes);
+
+	protected:
+		void refill(qint64 now);
+
+	private:
+		mutable QMutex m_mutex;
+		qint64 m_rate;
+		double m_tokens = 0;
+		qint64 m_lastRefill = 0;
+};
+
+#endif // BANDWIDTH_LIMITER_H
@@ -0,0 +1,183 @@
+#include "mirror-selector.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+// Weight of the last measure in the moving averages
+#define MIRROR_SMOOTHING 0.3
+// Typical size of a file, used to compare hosts with different latencies and throughputs
+#define MIRROR_TYPICAL_SIZE (1024 * 1024)
+// Every how many picks a mirror that was not measured recently is chosen instead of the best one
+#define MIRROR_EXPLORE_INTERVAL 20
+#define MIRROR_BACKOFF_BASE (30 * 1000)
+#define MIRROR_BACKOFF_MAX (10 * 60 * 1000)
+
+
+MirrorSelector::MirrorSelector(const QStringList &mirrors)
+{
+	setMirrors(mirrors);
+}
+
+QStringList MirrorSelector::mirrors() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_mirrors;
+}
+
+void MirrorSelector::setMirrors(const QStringList &mirrors)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_mirrors.clear();
+	for (const QString &mirror : mirrors) {
+		const QString host = mirror.trimmed().toLower();
+		if (!host.isEmpty() && !m_mirrors.contains(host)) {
+			m_mirrors.append(host);
+		}
+	}
+
+	// Keep the measures of the hosts that are still mirrors
+	for (auto it = m_stats.begin(); it != m_stats.end();) {
+		if (m_mirrors.contains(it.key())) {
+			++it;
+		} else {
+			it = m_stats.erase(it);
+		}
+	}
+}
+
+bool MirrorSelector::isMirror(const QString &host) const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_mirrors.contains(host.toLower());
+}
+
+QUrl MirrorSelector::rewrite(const QUrl &url)
+{
+	QMutexLocker locker(&m_mutex);
+
+	const QString host = url.host().toLower();
+	if (m_mirrors.count() < 2 || !m_mirrors.contains(host)) {
+		return url;
+	}
+
+	const QString mirror = best(host, QDateTime::currentMSecsSinceEpoch());
+	if (mirror == host) {
+		return url;
+	}
+
+	QUrl ret(url);
+	ret.setHost(mirror);
+	return ret;
+}
+
+QString MirrorSelector::best(const QString &current, qint64 now)
+{
+	QStringList healthy;
+	for (const QString &mirror : qAsConst(m_mirrors)) {
+		if (isHealthy(m_stats.value(mirror), now)) {
+			healthy.append(mirror);
+		}
+	}
+
+	// If all mirrors failed recently, there is no reason to change the original host
+	if (healthy.isEmpty()) {
+		return current;
+	}
+
+	// Measure the mirrors that were never used first, then the oldest measure from time to time
+	QString ret;
+	m_picks++;
+	for (const QString &mirror : qAsConst(healthy)) {
+		if (m_stats.value(mirror).samples == 0) {
+			ret = mirror;
+			break;
+		}
+	}
+	if (ret.isEmpty() && m_picks % MIRROR_EXPLORE_INTERVAL == 0) {
+		qint64 oldest = now;
+		for (const QString &mirror : qAsConst(healthy)) {
+			const qint64 lastUse = m_stats.value(mirror).lastUse;
+			if (lastUse < oldest) {
+				oldest = lastUse;
+				ret = mirror;
+			}
+		}
+	}
+	if (ret.isEmpty()) {
+		double bestTime = -1;
+		for (const QString &mirror : qAsConst(healthy)) {
+			const double time = expectedTime(m_stats.value(mirror));
+			if (bestTime < 0 || time < bestTime) {
+				bestTime = time;
+				ret = mirror;
+			}
+		}
+	}
+
+	m_stats[ret].lastUse = now;
+	return ret;
+}
+
+double MirrorSelector::expectedTime(const Stats &stats) const
+{
+	const double transfer = stats.throughput > 0 ? MIRROR_TYPICAL_SIZE / stats.throughput : 0;
+	return stats.latency + transfer;
+}
+
+bool MirrorSelector::isHealthy(const Stats &stats, qint64 now) const
+{
+	return stats.unhealthyUntil <= now;
+}
+
+bool MirrorSelector::isHealthy(const QString &host) const
+{
+	QMutexLocker locker(&m_mutex);
+	return isHealthy(m_stats.value(host.toLower()), QDateTime::currentMSecsSinceEpoch());
+}
+
+void MirrorSelector::reportSuccess(const QString &host, qint64 latency, qint64 bytes, qint64 duration)
+{
+	QMutexLocker locker(&m_mutex);
+
+	const QString key = host.toLower();
+	if (!m_mirrors.contains(key)) {
+		return;
+	}
+
+	Stats &stats = m_stats[key];
+	const double throughput = duration > 0 ? static_cast<double>(bytes) / duration : 0;
+	if (stats.samples == 0) {
+		stats.latency = latency;
+		stats.throughput = throughput;
+	} else {
+		stats.latency += MIRROR_SMOOTHING * (latency - stats.latency);
+		if (throughput > 0) {
+			stats.throughput += MIRROR_SMOOTHING * (throughput - stats.throughput);
+		}
+	}
+	stats.samples++;
+	stats.failures = 0;
+	stats.unhealthyUntil = 0;
+	stats.lastUse = QDateTime::currentMSecsSinceEpoch();
+}
+
+void MirrorSelector::reportFailure(const QString &host)
+{
+	QMutexLocker locker(&m_mutex);
+
+	const QString key = host.toLower();
+	if (!m_mirrors.contains(key)) {
+		return;
+	}
+
+	Stats &stats = m_stats[key];
+	stats.failures++;
+	const qint64 backoff = qMin<qint64>(static_cast<qint64>(MIRROR_BACKOFF_BASE) << qMin(stats.failures - 1, 10), MIRROR_BACKOFF_MAX);
+	stats.unhealthyUntil = QDateTime::currentMSecsSinceEpoch() + backoff;
+}
+
+MirrorSelector::Stats MirrorSelector::stats(const QString &host) const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_stats.value(host.toLower());
+}
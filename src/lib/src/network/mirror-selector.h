@@ -0,0 +1,63 @@
+#ifndef MIRROR_SELECTOR_H
+#define MIRROR_SELECTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+
+/**
+ * Choose the fastest of a list of equivalent hosts for the files of a site.
+ *
+ * Each finished download reports its latency (time to the first byte) and throughput for the host it used, which are
+ * kept as moving averages. URLs pointing to one of the mirrors are then rewritten to the one with the lowest expected
+ * download time. Hosts that fail are skipped for a while, longer after each consecutive failure, and a mirror that was
+ * not measured recently is regularly chosen instead so that the measures stay up to date.
+ *
+ * It can be shared by downloaders living on different threads.
+ */
+class MirrorSelector
+{
+	public:
+		struct Stats
+		{
+			double latency = 0; // ms
+			double throughput = 0; // bytes per ms
+			int samples = 0;
+			int failures = 0;
+			qint64 lastUse = 0;
+			qint64 unhealthyUntil = 0;
+		};
+
+		explicit MirrorSelector(const QStringList &mirrors = QStringList());
+
+		QStringList mirrors() const;
+		void setMirrors(const QStringList &mirrors);
+		bool isMirror(const QString &host) const;
+
+		/**
+		 * Rewrite an URL to the best mirror if its host is one of them.
+		 */
+		QUrl rewrite(const QUrl &url);
+
+		void reportSuccess(const QString &host, qint64 latency, qint64 bytes, qint64 duration);
+		void reportFailure(const QString &host);
+
+		Stats stats(const QString &host) const;
+		bool isHealthy(const QString &host) const;
+
+	protected:
+		QString best(const QString &current, qint64 now);
+		double expectedTime(const Stats &stats) const;
+		bool isHealthy(const Stats &stats, qint64 now) const;
+
+	private:
+		mutable QMutex m_mutex;
+		QStringList m_mirrors;
+		QHash<QString, Stats> m_stats;
+		int m_picks = 0;
+};
+
+#endif // MIRROR_SELECTOR_H
@@ -0,0 +1,151 @@
+#include "network-archive.h"
+#include <QDataStream>
+#include <QFile>
+#include <QMutexLocker>
+#include "logger.h"
+
+#define ARCHIVE_MAGIC 0x47524152 // "GRAR"
+#define ARCHIVE_VERSION 1
+
+
+/**
+ * It is never deleted, as replies can still be created while the application is quitting.
+ */
+NetworkArchive &NetworkArchive::getInstance()
+{
+	static auto *instance = new NetworkArchive();
+	return *instance;
+}
+
+bool NetworkArchive::open(const QString &path, Mode mode)
+{
+	close();
+
+	QMutexLocker locker(&m_mutex);
+	m_path = path;
+	m_responses.clear();
+
+	if (mode == Replay && !load()) {
+		return false;
+	}
+
+	m_mode = mode;
+	return true;
+}
+
+bool NetworkArchive::close()
+{
+	QMutexLocker locker(&m_mutex);
+
+	const bool ok = m_mode != Record || save();
+	m_mode = Disabled;
+	m_responses.clear();
+
+	return ok;
+}
+
+NetworkArchive::Mode NetworkArchive::mode() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_mode;
+}
+
+int NetworkArchive::count() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_responses.count();
+}
+
+
+QString NetworkArchive::key(const QByteArray &method, const QUrl &url)
+{
+	return QString::fromLatin1(method) + ' ' + url.toString(QUrl::FullyEncoded);
+}
+
+void NetworkArchive::record(const QByteArray &method, const QUrl &url, const Response &response)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_mode != Record) {
+		return;
+	}
+
+	m_responses.insert(key(method, url), response);
+}
+
+bool NetworkArchive::find(const QByteArray &method, const QUrl &url, Response *response) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	const auto it = m_responses.constFind(key(method, url));
+	if (it == m_responses.constEnd()) {
+		return false;
+	}
+
+	*response = it.value();
+	return true;
+}
+
+
+/**
+ * Must be called with the mutex locked.
+ */
+bool NetworkArchive::load()
+{
+	QFile file(m_path);
+	if (!file.open(QFile::ReadOnly)) {
+		log(QStringLiteral("Could not open network archive `%1`: %2").arg(m_path, file.errorString()), Logger::Error);
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	quint32 magic, version, count;
+	stream >> magic >> version >> count;
+	if (magic != ARCHIVE_MAGIC || version != ARCHIVE_VERSION) {
+		log(QStringLiteral("Invalid network archive `%1`").arg(m_path), Logger::Error);
+		return false;
+	}
+
+	m_responses.reserve(static_cast<int>(count));
+	for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+		QString k;
+		Response response;
+		qint32 statusCode;
+		stream >> k >> statusCode >> response.reasonPhrase >> response.contentType >> response.redirection >> response.content;
+		response.statusCode = statusCode;
+		m_responses.insert(k, response);
+	}
+
+	if (stream.status() != QDataStream::Ok) {
+		log(QStringLiteral("Network archive `%1` is truncated").arg(m_path), Logger::Error);
+		return false;
+	}
+
+	log(QStringLiteral("Replaying %1 responses from network archive `%2`").arg(m_responses.count()).arg(m_path), Logger::Info);
+	return true;
+}
+
+/**
+ * Must be called with the mutex locked.
+ */
+bool NetworkArchive::save() const
+{
+	QFile file(m_path);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not write network archive `%1`: %2").arg(m_path, file.errorString()), Logger::Error);
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	stream << static_cast<quint32>(ARCHIVE_MAGIC) << static_cast<quint32>(ARCHIVE_VERSION) << static_cast<quint32>(m_responses.count());
+	for (auto it = m_responses.constBegin(); it != m_responses.constEnd(); ++it) {
+		const Response &response = it.value();
+		stream << it.key() << static_cast<qint32>(response.statusCode) << response.reasonPhrase << response.contentType << response.redirection << response.content;
+	}
+
+	log(QStringLiteral("Recorded %1 responses to network archive `%2`").arg(m_responses.count()).arg(m_path), Logger::Info);
+	return true;
+}
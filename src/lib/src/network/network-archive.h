@@ -0,0 +1,70 @@
+#ifndef NETWORK_ARCHIVE_H
+#define NETWORK_ARCHIVE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+
+
+/**
+ * Archive of HTTP responses, used to record the replies of real sites and replay them later without any network
+ * access, for example to measure the parsing performance of sources without depending on the sites themselves.
+ *
+ * Responses are identified by their method and URL. When the same request is made several times while recording,
+ * only the last response is kept.
+ */
+class NetworkArchive
+{
+	public:
+		enum Mode
+		{
+			Disabled,
+			Record,
+			Replay,
+		};
+
+		struct Response
+		{
+			int statusCode;
+			QByteArray reasonPhrase;
+			QByteArray contentType;
+			QUrl redirection;
+			QByteArray content;
+		};
+
+		NetworkArchive() = default;
+		static NetworkArchive &getInstance();
+
+		/**
+		 * Start recording responses to the given file, or replaying the responses it contains.
+		 */
+		bool open(const QString &path, Mode mode);
+
+		/**
+		 * Stop recording or replaying, writing the recorded responses to the archive file.
+		 */
+		bool close();
+
+		Mode mode() const;
+		bool isRecording() const { return mode() == Record; }
+		bool isReplaying() const { return mode() == Replay; }
+		int count() const;
+
+		void record(const QByteArray &method, const QUrl &url, const Response &response);
+		bool find(const QByteArray &method, const QUrl &url, Response *response) const;
+
+	protected:
+		static QString key(const QByteArray &method, const QUrl &url);
+		bool load();
+		bool save() const;
+
+	private:
+		Mode m_mode = Disabled;
+		QString m_path;
+		QHash<QString, Response> m_responses;
+		mutable QMutex m_mutex;
+};
+
+#endif // NETWORK_ARCHIVE_H
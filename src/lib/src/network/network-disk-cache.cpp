@@ -0,0 +1,35 @@
+#include "network-disk-cache.h"
+#include <QNetworkCacheMetaData>
+
+
+NetworkDiskCache::NetworkDiskCache(QObject *parent)
+	: QNetworkDiskCache(parent)
+{}
+
+
+/**
+ * The maximum size of a single response to be stored in the cache, or a negative value for no limit.
+ */
+qint64 NetworkDiskCache::maximumItemSize() const
+{
+	return m_maximumItemSize;
+}
+
+void NetworkDiskCache::setMaximumItemSize(qint64 size)
+{
+	m_maximumItemSize = size;
+}
+
+
+QIODevice *NetworkDiskCache::prepare(const QNetworkCacheMetaData &metaData)
+{
+	if (m_maximumItemSize >= 0) {
+		for (const auto &header : metaData.rawHeaders()) {
+			if (header.first.compare("Content-Length", Qt::CaseInsensitive) == 0 && header.second.toLongLong() > m_maximumItemSize) {
+				return nullptr;
+			}
+		}
+	}
+
+	return QNetworkDiskCache::prepare(metaData);
+}
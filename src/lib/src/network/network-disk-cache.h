@@ -0,0 +1,30 @@
+#ifndef NETWORK_DISK_CACHE_H
+#define NETWORK_DISK_CACHE_H
+
+#include <QNetworkDiskCache>
+
+
+class QIODevice;
+class QNetworkCacheMetaData;
+class QObject;
+
+/**
+ * Disk cache refusing to store big responses (usually full images), to keep space for API responses.
+ */
+class NetworkDiskCache : public QNetworkDiskCache
+{
+	Q_OBJECT
+
+	public:
+		explicit NetworkDiskCache(QObject *parent = nullptr);
+
+		qint64 maximumItemSize() const;
+		void setMaximumItemSize(qint64 size);
+
+		QIODevice *prepare(const QNetworkCacheMetaData &metaData) override;
+
+	private:
+		qint64 m_maximumItemSize = -1;
+};
+
+#endif // NETWORK_DISK_CACHE_H
@@ -1,13 +1,62 @@
 #include "network-manager.h"
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QNetworkCookieJar>
+#include <QThread>
+#include <QUrl>
+#include <algorithm>
 #include <utility>
 #include "custom-network-access-manager.h"
+#include "metrics.h"
 #include "network-reply.h"
+#include "network-thread.h"
+
+// Idle connections are closed by Qt after two minutes, so there's no need to warm them up more often
+#define PRECONNECT_TTL (60 * 1000)
+
+static QAtomicInt activeRequestsCount;
+static QAtomicInteger<qint64> lastActivity;
+
+
+/**
+ * Process-wide access manager, so that all managers share the same connection pool, DNS and TLS session caches.
+ * It is never deleted as it must outlive all the managers using it.
+ */
+static CustomNetworkAccessManager *sharedAccessManager()
+{
+	static auto *manager = new CustomNetworkAccessManager();
+	return manager;
+}
 
 
 NetworkManager::NetworkManager(QObject *parent)
 	: QObject(parent)
 {
-	m_manager = new CustomNetworkAccessManager(this);
+	// The network thread's access manager can be used from any thread, while the shared one only from the main thread
+	QCoreApplication *app = QCoreApplication::instance();
+	CustomNetworkAccessManager *threadManager = NetworkThread::getInstance().accessManager();
+	if (threadManager != nullptr) {
+		m_manager = threadManager;
+	} else if (app != nullptr && QThread::currentThread() == app->thread()) {
+		m_manager = sharedAccessManager();
+	} else {
+		m_manager = new CustomNetworkAccessManager(this);
+	}
+}
+
+/**
+ * Manager for another thread than the one of the main manager, sharing its throttling and cookies.
+ * The concurrency and priority settings are copied, so each thread has its own request slots.
+ */
+NetworkManager::NetworkManager(NetworkManager *main, QObject *parent)
+	: NetworkManager(parent)
+{
+	m_cookieJar = main->cookieJar();
+	m_throttlingManager = main->m_throttlingManager;
+	m_maxConcurrency = main->m_maxConcurrency;
+	m_priorityMaxConcurrency = main->m_priorityMaxConcurrency;
+	m_priorities = main->m_priorities;
 }
 
 
@@ -21,37 +70,116 @@ void NetworkManager::setMaxConcurrency(int maxConcurrency)
 	m_maxConcurrency = maxConcurrency;
 }
 
+/**
+ * The maximum number of simultaneous requests for a given priority class.
+ * A negative value means that this class is only limited by the global maximum.
+ */
+int NetworkManager::maxConcurrency(Priority priority) const
+{
+	return m_priorityMaxConcurrency.value(priority, -1);
+}
+
+void NetworkManager::setMaxConcurrency(Priority priority, int maxConcurrency)
+{
+	m_priorityMaxConcurrency[priority] = maxConcurrency;
+}
+
+NetworkManager::Priority NetworkManager::priority(int type) const
+{
+	return m_priorities.value(type, Priority::Interactive);
+}
+
+void NetworkManager::setPriority(int type, Priority priority)
+{
+	m_priorities[type] = priority;
+}
+
 int NetworkManager::interval(int key) const
 {
-	return m_throttlingManager.interval(key);
+	return m_throttlingManager->interval(key);
 }
 
 void NetworkManager::setInterval(int key, int msInterval)
 {
-	m_throttlingManager.setInterval(key, msInterval);
+	m_throttlingManager->setInterval(key, msInterval);
 }
 
+int NetworkManager::burst(int key) const
+{
+	return m_throttlingManager->burst(key);
+}
 
+void NetworkManager::setBurst(int key, int burst)
+{
+	m_throttlingManager->setBurst(key, burst);
+}
+
+double NetworkManager::rate(int key) const
+{
+	return m_throttlingManager->rate(key);
+}
+
+
+QAbstractNetworkCache *NetworkManager::cache() const
+{
+	return m_manager->cache();
+}
+
+/**
+ * Set the HTTP cache of the underlying access manager, which takes its ownership.
+ * As this manager might be shared, callers should check that no cache is set yet using cache().
+ */
 void NetworkManager::setCache(QAbstractNetworkCache *cache)
 {
-	return m_manager->setCache(cache);
+	// The cache becomes a child of the access manager, so it must live on the same thread
+	if (m_manager->thread() != QThread::currentThread()) {
+		cache->moveToThread(m_manager->thread());
+		CustomNetworkAccessManager *manager = m_manager;
+		QMetaObject::invokeMethod(m_manager, [manager, cache]() {
+			manager->setCache(cache);
+		}, Qt::BlockingQueuedConnection);
+		return;
+	}
+
+	m_manager->setCache(cache);
 }
 
 QNetworkCookieJar *NetworkManager::cookieJar() const
 {
-	return m_manager->cookieJar();
+	if (m_cookieJar == nullptr) {
+		const_cast<NetworkManager*>(this)->setCookieJar(new QNetworkCookieJar());
+	}
+	return m_cookieJar;
 }
 
+/**
+ * Cookies are handled per manager rather than by the (possibly shared) access manager.
+ * Like QNetworkAccessManager, this takes ownership of the cookie jar.
+ */
 void NetworkManager::setCookieJar(QNetworkCookieJar *cookieJar)
 {
-	return m_manager->setCookieJar(cookieJar);
+	if (m_cookieJar != nullptr && m_cookieJar->parent() == this) {
+		m_cookieJar->deleteLater();
+	}
+
+	m_cookieJar = cookieJar;
+	if (m_cookieJar != nullptr) {
+		m_cookieJar->setParent(this);
+	}
 }
 
 
+/**
+ * Identical GET requests running at the same time share the same transfer.
+ */
 NetworkReply *NetworkManager::get(QNetworkRequest request, int type)
 {
+	const QString key = requestKey(request);
 	auto *reply = new NetworkReply(std::move(request), m_manager, this);
-	append(reply, type);
+	reply->setCookieJar(cookieJar());
+	if (!share(reply, key)) {
+		append(reply, type, key);
+	}
 
 	return reply;
 }
@@ -59,42 +187,191 @@ NetworkReply *NetworkManager::get(QNetworkRequest request, int type)
 NetworkReply *NetworkManager::post(QNetworkRequest request, QByteArray data, int type)
 {
 	auto *reply = new NetworkReply(std::move(request), std::move(data), m_manager, this);
+	reply->setCookieJar(cookieJar());
 	append(reply, type);
 
 	return reply;
 }
 
-void NetworkManager::append(NetworkReply *reply, int type)
+/**
+ * Warm up a connection to the host of an URL, unless it was already done recently.
+ */
+void NetworkManager::preconnect(const QUrl &url)
+{
+	const QString key = url.scheme() + QStringLiteral("://") + url.authority();
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	const auto it = m_preconnected.constFind(key);
+	if (it != m_preconnected.constEnd() && now - it.value() < PRECONNECT_TTL) {
+		return;
+	}
+	m_preconnected.insert(key, now);
+
+	CustomNetworkAccessManager *manager = m_manager;
+	if (manager->thread() != QThread::currentThread()) {
+		QMetaObject::invokeMethod(manager, [manager, url]() { manager->preconnect(url); }, Qt::QueuedConnection);
+	} else {
+		manager->preconnect(url);
+	}
+}
+
+/**
+ * Two requests are considered identical if they have the same URL and headers.
+ */
+QString NetworkManager::requestKey(const QNetworkRequest &request)
 {
-	m_queue.append({ type, reply });
+	QString key = request.url().toString();
+
+	QList<QByteArray> headers = request.rawHeaderList();
+	std::sort(headers.begin(), headers.end());
+	for (const QByteArray &header : headers) {
+		key += QLatin1Char('\n') + QString::fromLatin1(header) + QLatin1Char(':') + QString::fromLatin1(request.rawHeader(header));
+	}
+
+	return key;
+}
 
-	int activeQueries = m_activeQueries.fetchAndStoreRelaxed(m_maxConcurrency);
-	for (int i = activeQueries; i < m_maxConcurrency; ++i) {
+/**
+ * Make a reply use the transfer of an identical running request if there is one.
+ */
+bool NetworkManager::share(NetworkReply *reply, const QString &key)
+{
+	NetworkReply *leader = m_transfers.value(key);
+	if (leader == nullptr || !leader->canShare()) {
+		return false;
+	}
+
+	reply->share(leader);
+	return true;
+}
+
+void NetworkManager::append(NetworkReply *reply, int type, const QString &key)
+{
+	QueuedReply queued { type, reply, QElapsedTimer(), key };
+	queued.queued.start();
+	m_queues[priority(type)].append(queued);
+
+	// Requests are started asynchronously, so that callers can connect to the reply's signals first
+	if (!m_nextScheduled) {
+		m_nextScheduled = true;
 		QTimer::singleShot(0, this, SLOT(next()));
 	}
 }
 
 void NetworkManager::clear()
 {
-	m_queue.clear();
+	m_queues.clear();
 }
 
 
 void NetworkManager::next()
 {
-	if (m_queue.isEmpty()) {
-		m_activeQueries.fetchAndAddRelaxed(-1);
+	m_nextScheduled = false;
+	if (m_paused) {
 		return;
 	}
 
-	auto pair = m_queue.dequeue();
-	int type = pair.first;
-	NetworkReply *reply = pair.second;
+	while (m_totalActiveQueries < m_maxConcurrency) {
+		bool started = false;
 
-	if (reply->isRunning()) {
-		connect(reply, &NetworkReply::finished, this, &NetworkManager::next);
-		m_throttlingManager.start(type, reply);
-	} else {
-		next();
+		// Start the first pending request of the highest priority class that still has available slots
+		for (auto it = m_queues.begin(); it != m_queues.end() && !started; ++it) {
+			const Priority priority = it.key();
+			QQueue<QueuedReply> &queue = it.value();
+
+			const int max = maxConcurrency(priority);
+			if (max >= 0 && m_activeQueries.value(priority) >= max) {
+				continue;
+			}
+
+			while (!queue.isEmpty() && !started) {
+				const QueuedReply queued = queue.dequeue();
+				NetworkReply *reply = queued.reply.data();
+
+				// Skip requests that were aborted or deleted while queued
+				if (reply == nullptr || !reply->isRunning()) {
+					continue;
+				}
+
+				Metrics::getInstance().observe("grabber_network_queue_wait_ms", Metrics::label("priority", QString::number(priority)), queued.queued.elapsed());
+
+				// An identical request might have been started while this one was queued
+				const QString key = queued.key;
+				if (!key.isEmpty() && share(reply, key)) {
+					continue;
+				}
+
+				const int type = queued.type;
+				connect(reply, &NetworkReply::finished, this, [this, reply, type, priority, key]() { finished(reply, type, priority, key); });
+				connect(reply, &NetworkReply::aborted, this, [this, reply, type, priority, key]() { finished(reply, type, priority, key); });
+				connect(reply, &QObject::destroyed, this, [this, priority]() { release(priority); });
+				m_activeQueries[priority]++;
+				m_totalActiveQueries++;
+				activeRequestsCount.ref();
+				lastActivity.storeRelaxed(QDateTime::currentMSecsSinceEpoch());
+				m_throttlingManager->start(type, reply);
+				if (!key.isEmpty()) {
+					m_transfers.insert(key, reply);
+				}
+				started = true;
+			}
+		}
+
+		if (!started) {
+			break;
+		}
 	}
 }
+
+void NetworkManager::pause()
+{
+	m_paused = true;
+}
+
+void NetworkManager::resume()
+{
+	if (!m_paused) {
+		return;
+	}
+
+	m_paused = false;
+	next();
+}
+
+bool NetworkManager::isPaused() const
+{
+	return m_paused;
+}
+
+int NetworkManager::activeRequests()
+{
+	return activeRequestsCount.loadRelaxed();
+}
+
+qint64 NetworkManager::msSinceLastActivity()
+{
+	return QDateTime::currentMSecsSinceEpoch() - lastActivity.loadRelaxed();
+}
+
+/**
+ * Free the slot used by a request as soon as it finished or was cancelled.
+ */
+void NetworkManager::finished(NetworkReply *reply, int type, Priority priority, const QString &key)
+{
+	disconnect(reply, nullptr, this, nullptr);
+	if (!key.isEmpty() && m_transfers.value(key) == reply) {
+		m_transfers.remove(key);
+	}
+
+	m_throttlingManager->finished(type, reply);
+	release(priority);
+}
+
+void NetworkManager::release(Priority priority)
+{
+	m_activeQueries[priority]--;
+	m_totalActiveQueries--;
+	activeRequestsCount.deref();
+	lastActivity.storeRelaxed(QDateTime::currentMSecsSinceEpoch());
+
+	next();
+}
@@ -1,9 +1,11 @@
 #ifndef NETWORK_MANAGER_H
 #define NETWORK_MANAGER_H
 
-#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
 #include <QObject>
-#include <QPair>
+#include <QPointer>
 #include <QQueue>
 #include "throttling-manager.h"
 
@@ -14,39 +16,97 @@ class QAbstractNetworkCache;
 class QByteArray;
 class QNetworkCookieJar;
 class QNetworkRequest;
+class QUrl;
 
 class NetworkManager : public QObject
 {
 	Q_OBJECT
 
 	public:
+		/**
+		 * Requests of a higher priority class are always started first.
+		 */
+		enum Priority
+		{
+			Interactive = 0,
+			Details = 1,
+			BatchPage = 2,
+			BatchFile = 3
+		};
+
 		explicit NetworkManager(QObject *parent = nullptr);
+		NetworkManager(NetworkManager *main, QObject *parent);
 
 		int maxConcurrency() const;
 		void setMaxConcurrency(int maxConcurrency);
+		int maxConcurrency(Priority priority) const;
+		void setMaxConcurrency(Priority priority, int maxConcurrency);
+		Priority priority(int type) const;
+		void setPriority(int type, Priority priority);
 		int interval(int key) const;
 		void setInterval(int key, int msInterval);
+		int burst(int key) const;
+		void setBurst(int key, int burst);
+		double rate(int key) const;
 
+		QAbstractNetworkCache *cache() const;
 		void setCache(QAbstractNetworkCache *cache);
 		QNetworkCookieJar *cookieJar() const;
 		void setCookieJar(QNetworkCookieJar *cookieJar);
 
 		NetworkReply *get(QNetworkRequest request, int type = -1);
 		NetworkReply *post(QNetworkRequest request, QByteArray data, int type = -1);
+		void preconnect(const QUrl &url);
 		void clear();
 
+		/**
+		 * Stop starting queued requests, without failing them, until resume() is called.
+		 * Requests already running are not affected.
+		 */
+		void pause();
+		void resume();
+		bool isPaused() const;
+
+		/**
+		 * Number of requests running in all the managers of the process, and time since one last started or finished.
+		 * Used to defer background work, such as sending usage data, until the network is idle.
+		 */
+		static int activeRequests();
+		static qint64 msSinceLastActivity();
+
 	protected:
-		void append(NetworkReply *reply, int type = -1);
+		struct QueuedReply
+		{
+			int type;
+			QPointer<NetworkReply> reply;
+			QElapsedTimer queued;
+			QString key;
+		};
+
+		static QString requestKey(const QNetworkRequest &request);
+		bool share(NetworkReply *reply, const QString &key);
+		void append(NetworkReply *reply, int type = -1, const QString &key = QString());
+		void finished(NetworkReply *reply, int type, Priority priority, const QString &key);
+		void release(Priority priority);
 
 	protected slots:
 		void next();
 
 	private:
 		CustomNetworkAccessManager *m_manager;
-		ThrottlingManager m_throttlingManager;
+		QNetworkCookieJar *m_cookieJar = nullptr;
+		ThrottlingManager m_ownThrottlingManager;
+		ThrottlingManager *m_throttlingManager = &m_ownThrottlingManager;
 		int m_maxConcurrency = 6;
-		QQueue<QPair<int, NetworkReply*>> m_queue;
-		QAtomicInt m_activeQueries;
+		QMap<Priority, int> m_priorityMaxConcurrency;
+		QMap<int, Priority> m_priorities;
+		QMap<Priority, QQueue<QueuedReply>> m_queues;
+		QMap<Priority, int> m_activeQueries;
+		int m_totalActiveQueries = 0;
+		QHash<QString, QPointer<NetworkReply>> m_transfers;
+		bool m_nextScheduled = false;
+		bool m_paused = false;
+		QHash<QString, qint64> m_preconnected;
 };
 
 #endif // NETWORK_MANAGER_H
@@ -1,6 +1,14 @@
 #include "network-reply.h"
+#include <QNetworkCookie>
+#include <QNetworkCookieJar>
+#include <QPointer>
+#include <cstring>
 #include <utility>
+#include "bandwidth-limiter.h"
 #include "custom-network-access-manager.h"
+#include "network-archive.h"
+
+#define LIMITED_READ_BUFFER_SIZE (64 * 1024)
 
 
 NetworkReply::NetworkReply(QNetworkRequest request, CustomNetworkAccessManager *manager, QObject *parent)
@@ -15,18 +23,49 @@ NetworkReply::NetworkReply(QNetworkRequest request, QByteArray data, CustomNetwo
 	init();
 }
 
+/**
+ * If other replies still use the transfer of this one, it is handed over to them instead of being destroyed.
+ */
+NetworkReply::~NetworkReply()
+{
+	detach();
+
+	if (m_transfer != nullptr) {
+		QMetaObject::invokeMethod(m_transfer, "abort", Qt::QueuedConnection);
+		m_transfer->deleteLater();
+	}
+}
+
 void NetworkReply::init()
 {
 	timer.setSingleShot(true);
 	connect(&timer, &QTimer::timeout, this, &NetworkReply::startNow);
+
+	m_limitTimer.setSingleShot(true);
+	connect(&m_limitTimer, &QTimer::timeout, this, &NetworkReply::readLimited);
 }
 
 
+/**
+ * The last metadata received from the network thread, if the transfer runs there.
+ */
+const NetworkTransfer::MetaData *NetworkReply::transferMetaData() const
+{
+	if (!m_remote) {
+		return nullptr;
+	}
+	return m_leader != nullptr ? &m_leader->m_meta : &m_meta;
+}
+
 QUrl NetworkReply::url() const
 {
 	if (m_reply != nullptr) {
 		return m_reply->url();
 	}
+	const auto *meta = transferMetaData();
+	if (meta != nullptr && !meta->url.isEmpty()) {
+		return meta->url;
+	}
 	return m_request.url();
 }
 
@@ -35,19 +74,69 @@ QVariant NetworkReply::attribute(QNetworkRequest::Attribute code) const
 	if (m_reply != nullptr) {
 		return m_reply->attribute(code);
 	}
+	const auto *meta = transferMetaData();
+	if (meta != nullptr) {
+		return meta->attributes.value(code);
+	}
 	return QVariant();
 }
 
 QByteArray NetworkReply::readAll()
 {
+	if (m_buffered) {
+		QByteArray data;
+		data.swap(m_buffer);
+		if (NetworkArchive::getInstance().isRecording() && m_remote && !isTransferRunning()) {
+			record(data);
+		}
+		return data;
+	}
+	if (m_reply == nullptr) {
+		return {};
+	}
+
+	const QByteArray data = m_reply->readAll();
+	if (NetworkArchive::getInstance().isRecording() && m_reply->isFinished()) {
+		record(data);
+	}
+	return data;
+}
+
+/**
+ * Save a finished response to the network archive, so that it can be replayed later.
+ * Only the responses read at once are recorded, which excludes file downloads.
+ */
+void NetworkReply::record(const QByteArray &data)
+{
+	NetworkArchive::Response response;
+	response.statusCode = attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	response.reasonPhrase = attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+	response.contentType = rawHeader("Content-Type");
+	response.redirection = attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+	response.content = data;
+
+	NetworkArchive::getInstance().record(m_post ? "POST" : "GET", m_request.url(), response);
+}
+
+qint64 NetworkReply::read(char *data, qint64 maxSize)
+{
+	if (m_buffered) {
+		const int size = static_cast<int>(qMin(maxSize, static_cast<qint64>(m_buffer.size())));
+		memcpy(data, m_buffer.constData(), static_cast<size_t>(size));
+		m_buffer.remove(0, size);
+		return size;
+	}
 	if (m_reply != nullptr) {
-		return m_reply->readAll();
+		return m_reply->read(data, maxSize);
 	}
-	return {};
+	return 0;
 }
 
 qint64 NetworkReply::bytesAvailable() const
 {
+	if (m_buffered) {
+		return m_buffer.size();
+	}
 	if (m_reply != nullptr) {
 		return m_reply->bytesAvailable();
 	}
@@ -56,17 +145,31 @@ qint64 NetworkReply::bytesAvailable() const
 
 QNetworkReply::NetworkError NetworkReply::error() const
 {
+	if (m_canceled) {
+		return QNetworkReply::NetworkError::OperationCanceledError;
+	}
 	if (m_reply != nullptr) {
 		return m_reply->error();
 	}
+	const auto *meta = transferMetaData();
+	if (meta != nullptr) {
+		return meta->error;
+	}
 	return QNetworkReply::NetworkError::NoError;
 }
 
 QString NetworkReply::errorString() const
 {
+	if (m_canceled) {
+		return QStringLiteral("Operation canceled");
+	}
 	if (m_reply != nullptr) {
 		return m_reply->errorString();
 	}
+	const auto *meta = transferMetaData();
+	if (meta != nullptr) {
+		return meta->errorString;
+	}
 	return QString();
 }
 
@@ -80,6 +183,14 @@ QByteArray NetworkReply::rawHeader(const QByteArray &headerName) const
 	if (m_reply != nullptr) {
 		return m_reply->rawHeader(headerName);
 	}
+	const auto *meta = transferMetaData();
+	if (meta != nullptr) {
+		for (const auto &header : meta->rawHeaders) {
+			if (header.first.compare(headerName, Qt::CaseInsensitive) == 0) {
+				return header.second;
+			}
+		}
+	}
 	return {};
 }
 
@@ -89,10 +200,49 @@ bool NetworkReply::isRunning() const
 	if (!m_started && !m_aborted) {
 		return true;
 	}
+	return isTransferRunning();
+}
+
+bool NetworkReply::isTransferRunning() const
+{
+	const auto *meta = transferMetaData();
+	if (meta != nullptr) {
+		return !meta->finished;
+	}
 	return m_reply != nullptr && m_reply->isRunning();
 }
 
 
+/**
+ * Use a specific cookie jar for this request instead of the one of the access manager.
+ * This allows to share the same access manager between sites while keeping their cookies separate.
+ */
+void NetworkReply::setCookieJar(QNetworkCookieJar *cookieJar)
+{
+	m_cookieJar = cookieJar;
+}
+
+void NetworkReply::setBandwidthLimiter(BandwidthLimiter *limiter)
+{
+	m_bandwidthLimiter = limiter;
+}
+
+/**
+ * The limiters whose rate is currently limited, which are fixed when the transfer starts.
+ */
+QList<BandwidthLimiter*> NetworkReply::bandwidthLimiters() const
+{
+	QList<BandwidthLimiter*> ret;
+	if (BandwidthLimiter::global().isLimited()) {
+		ret.append(&BandwidthLimiter::global());
+	}
+	if (m_bandwidthLimiter != nullptr && m_bandwidthLimiter->isLimited()) {
+		ret.append(m_bandwidthLimiter);
+	}
+	return ret;
+}
+
+
 void NetworkReply::start(int msDelay)
 {
 	if (m_started) {
@@ -110,26 +260,327 @@ void NetworkReply::start(int msDelay)
 
 void NetworkReply::startNow()
 {
+	// Cookies are loaded at the last moment, as they can change while the request is queued (login, etc.)
+	if (m_cookieJar != nullptr) {
+		m_request.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+		m_request.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+
+		const QList<QNetworkCookie> cookies = m_cookieJar->cookiesForUrl(m_request.url());
+		if (!cookies.isEmpty() && !m_request.hasRawHeader("Cookie")) {
+			m_request.setHeader(QNetworkRequest::CookieHeader, QVariant::fromValue(cookies));
+		}
+	}
+
+	if (m_manager->thread() != thread()) {
+		startTransfer();
+		return;
+	}
+
 	if (m_post) {
 		m_reply = m_manager->post(m_request, m_data);
 	} else {
 		m_reply = m_manager->get(m_request);
 	}
 
-	connect(m_reply, &QNetworkReply::readyRead, this, &NetworkReply::readyRead);
-	connect(m_reply, &QNetworkReply::downloadProgress, this, &NetworkReply::downloadProgress);
-	connect(m_reply, &QNetworkReply::finished, this, &NetworkReply::finished);
+	// Limited replies only read what they are allowed to, so their read buffer must be bounded for the socket to wait
+	m_limiters = bandwidthLimiters();
+	if (!m_limiters.isEmpty()) {
+		m_buffered = true;
+		m_reply->setReadBufferSize(LIMITED_READ_BUFFER_SIZE);
+	}
 
+	connectReply();
 	m_reply->setParent(this);
+
+	for (NetworkReply *follower : m_followers) {
+		follower->m_reply = m_reply;
+	}
+}
+
+/**
+ * Start the transfer on the thread of the access manager. Its data is always buffered, as it is received as copies.
+ */
+void NetworkReply::startTransfer()
+{
+	m_remote = true;
+	m_buffered = true;
+
+	m_transfer = new NetworkTransfer(m_request, m_data, m_post, m_manager);
+	m_transfer->setBandwidthLimiters(bandwidthLimiters());
+	m_transfer->moveToThread(m_manager->thread());
+	connectTransfer();
+	QMetaObject::invokeMethod(m_transfer, "start", Qt::QueuedConnection);
+
+	for (NetworkReply *follower : m_followers) {
+		follower->m_remote = true;
+	}
+}
+
+void NetworkReply::connectTransfer()
+{
+	connect(m_transfer, &NetworkTransfer::metaDataChanged, this, &NetworkReply::transferMetaDataChanged);
+	connect(m_transfer, &NetworkTransfer::readyRead, this, &NetworkReply::transferReadyRead);
+	connect(m_transfer, &NetworkTransfer::downloadProgress, this, &NetworkReply::replyDownloadProgress);
+	connect(m_transfer, &NetworkTransfer::finished, this, &NetworkReply::transferFinished);
+}
+
+void NetworkReply::connectReply()
+{
+	// Must be connected first so that cookies are saved before anybody handles the reply
+	if (m_cookieJar != nullptr) {
+		connect(m_reply, &QNetworkReply::metaDataChanged, this, &NetworkReply::saveCookies);
+		connect(m_reply, &QNetworkReply::finished, this, &NetworkReply::saveCookies);
+	}
+	connect(m_reply, &QNetworkReply::readyRead, this, &NetworkReply::replyReadyRead);
+	connect(m_reply, &QNetworkReply::downloadProgress, this, &NetworkReply::replyDownloadProgress);
+	connect(m_reply, &QNetworkReply::finished, this, &NetworkReply::replyFinished);
+}
+
+/**
+ * Only the reply owning the transfer is connected to it, and forwards its signals to the replies sharing it.
+ * Since any of them can read the data, it is then buffered separately for each one.
+ */
+void NetworkReply::replyReadyRead()
+{
+	m_dataReceived = true;
+
+	if (!m_limiters.isEmpty()) {
+		readLimited();
+		return;
+	}
+
+	if (m_buffered) {
+		appendData(m_reply->readAll());
+	}
+
+	notifyReadyRead();
+}
+
+/**
+ * Read as much data as the bandwidth limiters allow, and try again later for the rest.
+ */
+void NetworkReply::readLimited()
+{
+	if (m_reply == nullptr) {
+		return;
+	}
+
+	const qint64 available = m_reply->bytesAvailable();
+	if (available > 0) {
+		const qint64 allowed = BandwidthLimiter::acquire(m_limiters, available);
+		if (allowed > 0) {
+			appendData(m_reply->read(allowed));
+			notifyReadyRead();
+		}
+		if (allowed < available) {
+			m_limitTimer.start(qMax(1, BandwidthLimiter::msToRead(m_limiters, available - allowed)));
+			return;
+		}
+	}
+
+	if (m_finishPending && m_reply->bytesAvailable() == 0) {
+		m_finishPending = false;
+		notifyFinished();
+	}
+}
+
+void NetworkReply::notifyReadyRead()
+{
+	const QList<QPointer<NetworkReply>> followers(m_followers.constBegin(), m_followers.constEnd());
+	emit readyRead();
+	for (const QPointer<NetworkReply> &follower : followers) {
+		if (!follower.isNull()) {
+			emit follower->readyRead();
+		}
+	}
+}
+
+void NetworkReply::notifyFinished()
+{
+	const QList<QPointer<NetworkReply>> followers(m_followers.constBegin(), m_followers.constEnd());
+	emit finished();
+	for (const QPointer<NetworkReply> &follower : followers) {
+		if (!follower.isNull()) {
+			emit follower->finished();
+		}
+	}
+}
+
+void NetworkReply::transferMetaDataChanged(const NetworkTransfer::MetaData &meta)
+{
+	m_meta = meta;
+
+	// Cookies are saved before anybody handles the reply
+	if (m_cookieJar != nullptr) {
+		saveCookies();
+	}
+}
+
+void NetworkReply::transferReadyRead(const QByteArray &data)
+{
+	m_dataReceived = true;
+	appendData(data);
+	notifyReadyRead();
+}
+
+void NetworkReply::transferFinished(const NetworkTransfer::MetaData &meta)
+{
+	transferMetaDataChanged(meta);
+	notifyFinished();
+}
+
+void NetworkReply::appendData(const QByteArray &data)
+{
+	m_buffer.append(data);
+	for (NetworkReply *follower : m_followers) {
+		follower->m_buffer.append(data);
+	}
+}
+
+void NetworkReply::replyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+{
+	const QList<QPointer<NetworkReply>> followers(m_followers.constBegin(), m_followers.constEnd());
+	emit downloadProgress(bytesReceived, bytesTotal);
+	for (const QPointer<NetworkReply> &follower : followers) {
+		if (!follower.isNull()) {
+			emit follower->downloadProgress(bytesReceived, bytesTotal);
+		}
+	}
+}
+
+void NetworkReply::replyFinished()
+{
+	// Limited replies only finish once all their data was read
+	if (!m_limiters.isEmpty() && m_reply->bytesAvailable() > 0) {
+		m_finishPending = true;
+		readLimited();
+		return;
+	}
+
+	// Data can still be pending without a last readyRead signal
+	if (m_buffered && m_reply->bytesAvailable() > 0) {
+		appendData(m_reply->readAll());
+	}
+
+	notifyFinished();
+}
+
+
+bool NetworkReply::canShare() const
+{
+	return m_started && !m_post && !m_aborted && m_leader == nullptr && !m_dataReceived && ((m_reply == nullptr && m_transfer == nullptr) || isTransferRunning());
+}
+
+void NetworkReply::share(NetworkReply *leader)
+{
+	m_started = true;
+	m_buffered = true;
+	m_reply = leader->m_reply;
+	m_remote = leader->m_remote;
+	m_leader = leader;
+
+	leader->m_buffered = true;
+	leader->m_followers.append(this);
+}
+
+/**
+ * Stop sharing the transfer with other replies.
+ * If this reply owns the transfer, it is handed over to the first reply sharing it, which keeps it going for the others.
+ */
+void NetworkReply::detach()
+{
+	if (m_leader != nullptr) {
+		m_leader->m_followers.removeAll(this);
+		m_leader = nullptr;
+		return;
+	}
+	if (m_followers.isEmpty()) {
+		return;
+	}
+
+	NetworkReply *heir = m_followers.takeFirst();
+	heir->m_leader = nullptr;
+	heir->m_followers = m_followers;
+	heir->m_dataReceived = m_dataReceived;
+	for (NetworkReply *follower : m_followers) {
+		follower->m_leader = heir;
+	}
+	m_followers.clear();
+
+	// The transfer might not be started yet if this reply was being throttled
+	if (m_reply == nullptr && m_transfer == nullptr) {
+		heir->timer.setInterval(qMax(0, timer.remainingTime()));
+		heir->timer.start();
+		return;
+	}
+
+	if (m_transfer != nullptr) {
+		disconnect(m_transfer, nullptr, this, nullptr);
+		heir->m_meta = m_meta;
+		heir->m_transfer = m_transfer;
+		heir->connectTransfer();
+		m_transfer = nullptr;
+		return;
+	}
+
+	disconnect(m_reply, nullptr, this, nullptr);
+	heir->connectReply();
+	m_reply->setParent(heir);
+	m_reply = nullptr;
+
+	// The heir also takes over the data not read yet because of the bandwidth limit
+	heir->m_limiters = m_limiters;
+	heir->m_finishPending = m_finishPending;
+	if (m_limitTimer.isActive()) {
+		m_limitTimer.stop();
+		heir->m_limitTimer.start(0);
+	}
+}
+
+void NetworkReply::saveCookies()
+{
+	const auto cookies = m_remote ? m_meta.cookies : m_reply->header(QNetworkRequest::SetCookieHeader).value<QList<QNetworkCookie>>();
+	if (!cookies.isEmpty()) {
+		const QUrl url = m_remote ? m_meta.url : m_reply->url();
+		m_cookieJar->setCookiesFromUrl(cookies, url.isEmpty() ? m_request.url() : url);
+	}
 }
 
 void NetworkReply::abort()
 {
 	m_aborted = true;
+
+	// A shared transfer keeps going for the other replies, this one simply stops following it
+	if (m_leader != nullptr || !m_followers.isEmpty()) {
+		const bool transferStarted = m_reply != nullptr || m_transfer != nullptr || (m_leader != nullptr && m_leader->m_transfer != nullptr);
+		if (transferStarted && !isTransferRunning()) {
+			return;
+		}
+
+		detach();
+		timer.stop();
+		m_reply = nullptr;
+		m_remote = false;
+		m_buffer.clear();
+
+		if (transferStarted) {
+			m_canceled = true;
+			emit finished();
+		} else {
+			emit aborted();
+		}
+		return;
+	}
 	if (m_reply != nullptr) {
+		m_limitTimer.stop();
+		m_finishPending = false;
 		m_reply->abort();
 	}
+	if (m_transfer != nullptr) {
+		QMetaObject::invokeMethod(m_transfer, "abort", Qt::QueuedConnection);
+	}
 	if (timer.isActive()) {
 		timer.stop();
+		emit aborted();
 	}
 }
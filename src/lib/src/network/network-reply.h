@@ -2,13 +2,17 @@
 #define NETWORK_REPLY_H
 
 #include <QByteArray>
+#include <QList>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QObject>
 #include <QTimer>
+#include "network/network-transfer.h"
 
 
+class BandwidthLimiter;
 class CustomNetworkAccessManager;
+class QNetworkCookieJar;
 class QUrl;
 class QVariant;
 
@@ -21,15 +25,36 @@ class NetworkReply : public QObject
 
 		NetworkReply(QNetworkRequest request, CustomNetworkAccessManager *manager, QObject *parent = nullptr);
 		NetworkReply(QNetworkRequest request, QByteArray data, CustomNetworkAccessManager *manager, QObject *parent = nullptr);
+		~NetworkReply() override;
 		QUrl url() const;
 		QVariant attribute(QNetworkRequest::Attribute code) const;
 		QByteArray readAll();
+		qint64 read(char *data, qint64 maxSize);
 		qint64 bytesAvailable() const;
 		NetworkError error() const;
 		QString errorString() const;
 		QNetworkReply *networkReply() const;
 		QByteArray rawHeader(const QByteArray &headerName) const;
 		bool isRunning() const;
+		void setCookieJar(QNetworkCookieJar *cookieJar);
+
+		/**
+		 * Limit the download rate of this reply, on top of the global limit.
+		 * The limiter must outlive the reply, and be set before it is started.
+		 */
+		void setBandwidthLimiter(BandwidthLimiter *limiter);
+
+		/**
+		 * Whether another identical request can use the transfer of this one instead of starting its own.
+		 * This is only possible for started GET requests that did not receive any data yet.
+		 */
+		bool canShare() const;
+
+		/**
+		 * Use the transfer of another reply instead of starting a new one.
+		 * The data is then copied to all the replies sharing it, which can each be read, aborted or deleted separately.
+		 */
+		void share(NetworkReply *leader);
 
 	public slots:
 		void start(int msDelay = 0);
@@ -38,21 +63,63 @@ class NetworkReply : public QObject
 	protected slots:
 		void init();
 		void startNow();
+		void saveCookies();
+		void replyReadyRead();
+		void replyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+		void replyFinished();
+		void transferMetaDataChanged(const NetworkTransfer::MetaData &meta);
+		void transferReadyRead(const QByteArray &data);
+		void transferFinished(const NetworkTransfer::MetaData &meta);
+		void readLimited();
+
+	protected:
+		void record(const QByteArray &data);
+		void connectReply();
+		void startTransfer();
+		void connectTransfer();
+		const NetworkTransfer::MetaData *transferMetaData() const;
+		bool isTransferRunning() const;
+		void appendData(const QByteArray &data);
+		void notifyReadyRead();
+		void notifyFinished();
+		QList<BandwidthLimiter*> bandwidthLimiters() const;
+		void detach();
 
 	signals:
 		void readyRead();
 		void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 		void finished();
+		void aborted();
 
 	private:
 		QNetworkRequest m_request;
 		QByteArray m_data;
 		CustomNetworkAccessManager *m_manager;
+		QNetworkCookieJar *m_cookieJar = nullptr;
 		bool m_post = false;
 		bool m_started = false;
 		bool m_aborted = false;
 		QNetworkReply *m_reply = nullptr;
 		QTimer timer;
+
+		// Shared transfers
+		NetworkReply *m_leader = nullptr;
+		QList<NetworkReply*> m_followers;
+		QByteArray m_buffer;
+		bool m_buffered = false;
+		bool m_dataReceived = false;
+		bool m_canceled = false;
+
+		// Bandwidth limiting
+		BandwidthLimiter *m_bandwidthLimiter = nullptr;
+		QList<BandwidthLimiter*> m_limiters;
+		QTimer m_limitTimer;
+		bool m_finishPending = false;
+
+		// Transfers running on the network thread
+		NetworkTransfer *m_transfer = nullptr;
+		NetworkTransfer::MetaData m_meta;
+		bool m_remote = false;
 };
 
 #endif // NETWORK_REPLY_H
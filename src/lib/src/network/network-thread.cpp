@@ -0,0 +1,59 @@
+#include "network-thread.h"
+#include <QMutexLocker>
+#include <QThread>
+#include "custom-network-access-manager.h"
+#include "network/network-transfer.h"
+
+
+NetworkThread &NetworkThread::getInstance()
+{
+	static auto *instance = new NetworkThread();
+	return *instance;
+}
+
+void NetworkThread::start()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_thread != nullptr) {
+		return;
+	}
+
+	qRegisterMetaType<NetworkTransfer::MetaData>("NetworkTransfer::MetaData");
+
+	m_thread = new QThread();
+	m_thread->setObjectName(QStringLiteral("Network"));
+
+	m_manager = new CustomNetworkAccessManager();
+	m_manager->moveToThread(m_thread);
+
+	m_thread->start();
+}
+
+void NetworkThread::stop()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_thread == nullptr) {
+		return;
+	}
+
+	// Objects waiting for deletion are deleted when their thread finishes
+	m_manager->deleteLater();
+	m_manager = nullptr;
+
+	m_thread->quit();
+	m_thread->wait();
+	delete m_thread;
+	m_thread = nullptr;
+}
+
+bool NetworkThread::isRunning() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_thread != nullptr;
+}
+
+CustomNetworkAccessManager *NetworkThread::accessManager() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_manager;
+}
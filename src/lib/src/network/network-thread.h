@@ -0,0 +1,38 @@
+#ifndef NETWORK_THREAD_H
+#define NETWORK_THREAD_H
+
+#include <QMutex>
+
+
+class CustomNetworkAccessManager;
+class QThread;
+
+/**
+ * Dedicated thread for the network stack, so that transfers keep going while the GUI thread is busy.
+ *
+ * When it is running, the network managers created afterwards use an access manager living on that thread, their
+ * replies receiving the data through queued signals. It must therefore be started before any network manager is
+ * created, and only stopped when none is used anymore.
+ */
+class NetworkThread
+{
+	public:
+		NetworkThread() = default;
+		static NetworkThread &getInstance();
+
+		void start();
+		void stop();
+		bool isRunning() const;
+
+		/**
+		 * The access manager living on the network thread, or nullptr if it is not running.
+		 */
+		CustomNetworkAccessManager *accessManager() const;
+
+	private:
+		mutable QMutex m_mutex;
+		QThread *m_thread = nullptr;
+		CustomNetworkAccessManager *m_manager = nullptr;
+};
+
+#endif // NETWORK_THREAD_H
@@ -0,0 +1,119 @@
+#include "network-transfer.h"
+#include <utility>
+#include "bandwidth-limiter.h"
+#include "custom-network-access-manager.h"
+
+#define LIMITED_READ_BUFFER_SIZE (64 * 1024)
+
+
+NetworkTransfer::NetworkTransfer(QNetworkRequest request, QByteArray data, bool post, CustomNetworkAccessManager *manager)
+	: QObject(), m_request(std::move(request)), m_data(std::move(data)), m_post(post), m_manager(manager), m_limitTimer(this)
+{
+	m_limitTimer.setSingleShot(true);
+	connect(&m_limitTimer, &QTimer::timeout, this, &NetworkTransfer::readLimited);
+}
+
+/**
+ * The limiters are applied here rather than by the reply, so that the socket itself waits.
+ */
+void NetworkTransfer::setBandwidthLimiters(const QList<BandwidthLimiter*> &limiters)
+{
+	m_limiters = limiters;
+}
+
+void NetworkTransfer::start()
+{
+	if (m_post) {
+		m_reply = m_manager->post(m_request, m_data);
+	} else {
+		m_reply = m_manager->get(m_request);
+	}
+	m_reply->setParent(this);
+	if (!m_limiters.isEmpty()) {
+		m_reply->setReadBufferSize(LIMITED_READ_BUFFER_SIZE);
+	}
+
+	connect(m_reply, &QNetworkReply::metaDataChanged, this, &NetworkTransfer::replyMetaDataChanged);
+	connect(m_reply, &QNetworkReply::readyRead, this, &NetworkTransfer::replyReadyRead);
+	connect(m_reply, &QNetworkReply::downloadProgress, this, &NetworkTransfer::downloadProgress);
+	connect(m_reply, &QNetworkReply::finished, this, &NetworkTransfer::replyFinished);
+}
+
+void NetworkTransfer::abort()
+{
+	if (m_reply != nullptr && m_reply->isRunning()) {
+		m_limitTimer.stop();
+		m_finishPending = false;
+		m_reply->abort();
+	}
+}
+
+void NetworkTransfer::replyMetaDataChanged()
+{
+	emit metaDataChanged(metaData());
+}
+
+void NetworkTransfer::replyReadyRead()
+{
+	if (!m_limiters.isEmpty()) {
+		readLimited();
+		return;
+	}
+
+	emit readyRead(m_reply->readAll());
+}
+
+void NetworkTransfer::readLimited()
+{
+	const qint64 available = m_reply->bytesAvailable();
+	if (available > 0) {
+		const qint64 allowed = BandwidthLimiter::acquire(m_limiters, available);
+		if (allowed > 0) {
+			emit readyRead(m_reply->read(allowed));
+		}
+		if (allowed < available) {
+			m_limitTimer.start(qMax(1, BandwidthLimiter::msToRead(m_limiters, available - allowed)));
+			return;
+		}
+	}
+
+	if (m_finishPending && m_reply->bytesAvailable() == 0) {
+		m_finishPending = false;
+		emit finished(metaData());
+	}
+}
+
+void NetworkTransfer::replyFinished()
+{
+	// Limited transfers only finish once all their data was read
+	if (!m_limiters.isEmpty() && m_reply->bytesAvailable() > 0) {
+		m_finishPending = true;
+		readLimited();
+		return;
+	}
+
+	// Data can still be pending without a last readyRead signal
+	if (m_reply->bytesAvailable() > 0) {
+		emit readyRead(m_reply->readAll());
+	}
+
+	emit finished(metaData());
+}
+
+NetworkTransfer::MetaData NetworkTransfer::metaData() const
+{
+	MetaData ret;
+	ret.url = m_reply->url();
+	for (int code = QNetworkRequest::HttpStatusCodeAttribute; code < QNetworkRequest::User; ++code) {
+		const QVariant val = m_reply->attribute(static_cast<QNetworkRequest::Attribute>(code));
+		if (val.isValid()) {
+			ret.attributes.insert(code, val);
+		}
+	}
+	ret.rawHeaders = m_reply->rawHeaderPairs();
+	ret.cookies = m_reply->header(QNetworkRequest::SetCookieHeader).value<QList<QNetworkCookie>>();
+	ret.error = m_reply->error();
+	ret.errorString = m_reply->errorString();
+	ret.finished = m_reply->isFinished();
+	return ret;
+}
@@ -0,0 +1,80 @@
+#ifndef NETWORK_TRANSFER_H
+#define NETWORK_TRANSFER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QNetworkCookie>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+#include <QVariant>
+
+
+class BandwidthLimiter;
+class CustomNetworkAccessManager;
+
+/**
+ * Transfer running on the thread of its access manager, for a NetworkReply living on another thread.
+ *
+ * A QNetworkReply can't safely be read from another thread than its own, so the transfer reads its data as soon as
+ * it arrives and sends it through queued signals, along with copies of the reply's metadata.
+ */
+class NetworkTransfer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		struct MetaData
+		{
+			QUrl url;
+			QHash<int, QVariant> attributes;
+			QList<QNetworkReply::RawHeaderPair> rawHeaders;
+			QList<QNetworkCookie> cookies;
+			QNetworkReply::NetworkError error = QNetworkReply::NoError;
+			QString errorString;
+			bool finished = false;
+		};
+
+		NetworkTransfer(QNetworkRequest request, QByteArray data, bool post, CustomNetworkAccessManager *manager);
+		void setBandwidthLimiters(const QList<BandwidthLimiter*> &limiters);
+
+	public slots:
+		void start();
+		void abort();
+
+	protected slots:
+		void replyMetaDataChanged();
+		void replyReadyRead();
+		void replyFinished();
+		void readLimited();
+
+	protected:
+		MetaData metaData() const;
+
+	signals:
+		void metaDataChanged(const NetworkTransfer::MetaData &meta);
+		void readyRead(const QByteArray &data);
+		void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+		void finished(const NetworkTransfer::MetaData &meta);
+
+	private:
+		QNetworkRequest m_request;
+		QByteArray m_data;
+		bool m_post;
+		CustomNetworkAccessManager *m_manager;
+		QNetworkReply *m_reply = nullptr;
+
+		// Bandwidth limiting
+		QList<BandwidthLimiter*> m_limiters;
+		QTimer m_limitTimer;
+		bool m_finishPending = false;
+};
+
+Q_DECLARE_METATYPE(NetworkTransfer::MetaData)
+
+#endif // NETWORK_TRANSFER_H
@@ -1,19 +1,37 @@
 #include "persistent-cookie-jar.h"
 #include <utility>
 #include <QFile>
+#include <QMetaObject>
 #include <QMutexLocker>
 #include <QNetworkCookie>
+#include <QTimer>
+#include <QtConcurrentRun>
+#include "logger.h"
 #include "utils/file-utils.h"
 
 
-PersistentCookieJar::PersistentCookieJar(QString filename, QObject *parent)
+static void writeCookieFile(const QString &filename, const QByteArray &data)
+{
+	if (!ensureFileParent(filename) || !safeWriteFile(filename, data)) {
+		log(QStringLiteral("Could not save cookies to `%1`").arg(filename), Logger::Warning);
+	}
+}
+
+
+PersistentCookieJar::PersistentCookieJar(QString filename, QObject *parent, int saveInterval)
 	: QNetworkCookieJar(parent), m_filename(std::move(filename))
 {
+	m_saveTimer = new QTimer(this);
+	m_saveTimer->setSingleShot(true);
+	m_saveTimer->setInterval(saveInterval);
+	connect(m_saveTimer, &QTimer::timeout, this, &PersistentCookieJar::saveInBackground);
+
 	load();
 }
 
 PersistentCookieJar::~PersistentCookieJar()
 {
+	m_saveTimer->stop();
 	save();
 }
 
@@ -44,29 +62,78 @@ QList<QNetworkCookie> PersistentCookieJar::cookiesForUrl(const QUrl &url) const
 bool PersistentCookieJar::setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url)
 {
 	QMutexLocker lock(&m_mutex);
-	return QNetworkCookieJar::setCookiesFromUrl(cookieList, url);
+	const bool changed = QNetworkCookieJar::setCookiesFromUrl(cookieList, url);
+
+	// Session cookies are not saved, so only changes to the others require a write
+	if (changed) {
+		for (const QNetworkCookie &cookie : cookieList) {
+			if (!cookie.isSessionCookie()) {
+				QMetaObject::invokeMethod(this, "scheduleSave", Qt::AutoConnection);
+				break;
+			}
+		}
+	}
+
+	return changed;
 }
 
 
-void PersistentCookieJar::save()
+/**
+ * Must be called with the mutex locked.
+ */
+QByteArray PersistentCookieJar::serialize() const
 {
-	QMutexLocker lock(&m_mutex);
-	QList<QNetworkCookie> list = allCookies();
-	if (list.isEmpty()) {
-		return;
-	}
-
 	QByteArray data;
+	const QList<QNetworkCookie> list = allCookies();
 	for (const QNetworkCookie &cookie : list) {
 		if (!cookie.isSessionCookie()) {
 			data.append(cookie.toRawForm());
 			data.append("\n");
 		}
 	}
+	return data;
+}
+
+/**
+ * The timer is not restarted when already running, so that sites changing their cookies on every request still
+ * get them saved regularly.
+ */
+void PersistentCookieJar::scheduleSave()
+{
+	if (!m_saveTimer->isActive()) {
+		m_saveTimer->start();
+	}
+}
+
+void PersistentCookieJar::saveInBackground()
+{
+	QByteArray data;
+	{
+		QMutexLocker lock(&m_mutex);
+		data = serialize();
+		if (data.isEmpty() || data == m_savedData) {
+			return;
+		}
+		m_savedData = data;
+	}
 
-	if (!data.isEmpty()) {
-		writeFile(m_filename, data);
+	// Writes must not be done out of order
+	m_saveFuture.waitForFinished();
+	m_saveFuture = QtConcurrent::run(writeCookieFile, m_filename, data);
+}
+
+void PersistentCookieJar::save()
+{
+	m_saveFuture.waitForFinished();
+
+	QMutexLocker lock(&m_mutex);
+	const QByteArray data = serialize();
+	if (data.isEmpty() || data == m_savedData) {
+		return;
 	}
+
+	m_savedData = data;
+	writeCookieFile(m_filename, data);
 }
 
 void PersistentCookieJar::load()
@@ -75,9 +142,10 @@ void PersistentCookieJar::load()
 
 	QFile f(m_filename);
 	if (f.exists() && f.open(QFile::ReadOnly | QFile::Text)) {
-		QByteArray data = f.readAll();
+		const QByteArray data = f.readAll();
 		f.close();
 
 		setAllCookies(QNetworkCookie::parseCookies(data));
+		m_savedData = serialize();
 	}
 }
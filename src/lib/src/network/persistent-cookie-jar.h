@@ -1,6 +1,8 @@
 #ifndef PERSISTENT_COOKIE_JAR_H
 #define PERSISTENT_COOKIE_JAR_H
 
+#include <QByteArray>
+#include <QFuture>
 #include <QMutex>
 #include <QNetworkCookieJar>
 #include <QList>
@@ -8,29 +10,49 @@
 
 class QNetworkCookie;
 class QObject;
+class QTimer;
 class QUrl;
 
+/**
+ * Cookie jar saving its persistent cookies to a file.
+ *
+ * As some sites rotate their cookies on every response, changes are not written immediately but at most once per
+ * save interval, in a background thread. The file is only rewritten if its content actually changed, and is
+ * replaced atomically so that it can't be left half-written.
+ */
 class PersistentCookieJar : public QNetworkCookieJar
 {
 	Q_OBJECT
 
 	public:
-		explicit PersistentCookieJar(QString filename, QObject *parent = nullptr);
+		explicit PersistentCookieJar(QString filename, QObject *parent = nullptr, int saveInterval = 5000);
 		~PersistentCookieJar();
 
 		void clear();
 		bool insertCookies(const QList<QNetworkCookie> &cookies);
 
+		/**
+		 * Write the cookies to the disk right away, waiting for any background write to finish.
+		 */
+		void save();
+
 		virtual QList<QNetworkCookie> cookiesForUrl(const QUrl &url) const override;
 		virtual bool setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url) override;
 
+	protected slots:
+		void scheduleSave();
+		void saveInBackground();
+
 	protected:
-		void save();
 		void load();
+		QByteArray serialize() const;
 
 	private:
 		QString m_filename;
 		mutable QMutex m_mutex;
+		QTimer *m_saveTimer;
+		QByteArray m_savedData;
+		QFuture<void> m_saveFuture;
 };
 
 #endif // PERSISTENT_COOKIE_JAR_H
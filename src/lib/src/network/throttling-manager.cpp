@@ -1,37 +1,184 @@
 #include "throttling-manager.h"
-#include <QTimer>
+#include <QDateTime>
+#include <QLocale>
+#include <QMutexLocker>
+#include <QtMath>
+#include "metrics.h"
 #include "network-reply.h"
 
+#define PENALTY_MIN 500
+#define PENALTY_MAX (5 * 60 * 1000)
+
 
 int ThrottlingManager::interval(int key) const
 {
-	return m_intervals[key];
+	QMutexLocker locker(&m_mutex);
+	return m_buckets.value(key).interval;
 }
 
 void ThrottlingManager::setInterval(int key, int msInterval)
 {
-	m_intervals[key] = msInterval;
+	QMutexLocker locker(&m_mutex);
+	m_buckets[key].interval = qMax(0, msInterval);
+}
+
+int ThrottlingManager::burst(int key) const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_buckets.value(key).burst;
+}
+
+void ThrottlingManager::setBurst(int key, int burst)
+{
+	QMutexLocker locker(&m_mutex);
+	Bucket &bucket = m_buckets[key];
+	bucket.burst = qMax(1, burst);
+	bucket.tokens = qMin(bucket.tokens, static_cast<double>(bucket.burst));
 }
 
 void ThrottlingManager::clear()
 {
-	m_intervals.clear();
+	QMutexLocker locker(&m_mutex);
+	m_buckets.clear();
+}
+
+
+/**
+ * The interval between two requests, taking into account the penalty caused by server errors.
+ */
+int ThrottlingManager::currentInterval(int key) const
+{
+	QMutexLocker locker(&m_mutex);
+	const Bucket bucket = m_buckets.value(key);
+	return bucket.interval + bucket.penalty;
 }
 
+/**
+ * The current sustained rate, in requests per second, or 0 if requests are not throttled.
+ */
+double ThrottlingManager::rate(int key) const
+{
+	const int interval = currentInterval(key);
+	if (interval <= 0) {
+		return 0;
+	}
+	return 1000.0 / interval;
+}
+
+void ThrottlingManager::refill(Bucket &bucket, qint64 now)
+{
+	const int interval = bucket.interval + bucket.penalty;
+	if (interval <= 0 || bucket.lastRefill == 0) {
+		bucket.tokens = qMax(bucket.tokens, static_cast<double>(bucket.burst));
+	} else if (now > bucket.lastRefill) {
+		bucket.tokens = qMin(static_cast<double>(bucket.burst), bucket.tokens + static_cast<double>(now - bucket.lastRefill) / interval);
+	}
+	bucket.lastRefill = now;
+}
+
+int ThrottlingManager::msToRequest(const Bucket &bucket, qint64 now)
+{
+	Bucket copy = bucket;
+	refill(copy, now);
+
+	const int interval = copy.interval + copy.penalty;
+	const qint64 blocked = qMax(static_cast<qint64>(0), copy.blockedUntil - now);
+	const qint64 missing = copy.tokens >= 1 ? 0 : static_cast<qint64>(qCeil((1 - copy.tokens) * interval));
+	return static_cast<int>(qMax(blocked, missing));
+}
 
 int ThrottlingManager::msToRequest(int key) const
 {
-	if (!m_lastRequests.contains(key) || !m_lastRequests[key].isValid()) {
+	QMutexLocker locker(&m_mutex);
+	if (!m_buckets.contains(key)) {
 		return 0;
 	}
+	return msToRequest(m_buckets[key], QDateTime::currentMSecsSinceEpoch());
+}
+
+/**
+ * Consume a token for a new request.
+ *
+ * @param key The request type
+ * @return The time in milliseconds to wait before starting the request
+ */
+int ThrottlingManager::reserve(int key)
+{
+	QMutexLocker locker(&m_mutex);
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	Bucket &bucket = m_buckets[key];
+
+	const int msWait = msToRequest(bucket, now);
+	refill(bucket, now);
+	bucket.tokens -= 1;
 
-	const qint64 sinceLastRequest = m_lastRequests[key].msecsTo(QDateTime::currentDateTime());
-	return qMax(0, interval(key) - static_cast<int>(sinceLastRequest));
+	return msWait;
 }
 
 void ThrottlingManager::start(int key, NetworkReply *reply)
 {
-	int msWait = msToRequest(key);
-	m_lastRequests[key] = QDateTime::currentDateTime().addMSecs(msWait);
+	const int msWait = reserve(key);
+	Metrics::getInstance().observe("grabber_network_throttle_delay_ms", Metrics::label("host", reply->url().host()), msWait);
+
 	reply->start(msWait);
 }
+
+void ThrottlingManager::finished(int key, NetworkReply *reply)
+{
+	const QVariant statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+	if (!statusCode.isValid()) {
+		return;
+	}
+
+	report(key, statusCode.toInt(), reply->rawHeader("Retry-After"));
+}
+
+/**
+ * Adapt the throttling of a request type to a server response.
+ *
+ * @param key The request type
+ * @param statusCode The HTTP status code of the response
+ * @param retryAfter The value of the "Retry-After" header, either in seconds or as an HTTP date
+ */
+void ThrottlingManager::report(int key, int statusCode, const QByteArray &retryAfter)
+{
+	QMutexLocker locker(&m_mutex);
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	Bucket &bucket = m_buckets[key];
+	refill(bucket, now);
+
+	// Successful responses slowly remove the penalty
+	if (statusCode < 400) {
+		bucket.penalty = bucket.penalty * 3 / 4;
+		if (bucket.penalty < PENALTY_MIN / 10) {
+			bucket.penalty = 0;
+		}
+		return;
+	}
+
+	// Only rate limiting and server errors should slow us down
+	if (statusCode != 429 && statusCode < 500) {
+		return;
+	}
+	bucket.penalty = qMin(PENALTY_MAX, qMax(PENALTY_MIN, bucket.penalty * 2));
+	bucket.tokens = qMin(bucket.tokens, 0.0);
+
+	if (!retryAfter.isEmpty()) {
+		const QString value = QString::fromLatin1(retryAfter).trimmed();
+
+		bool ok;
+		const int seconds = value.toInt(&ok);
+		qint64 until = 0;
+		if (ok) {
+			until = now + qMax(0, seconds) * 1000LL;
+		} else {
+			QDateTime date = QLocale::c().toDateTime(value, QStringLiteral("ddd, dd MMM yyyy HH:mm:ss 'GMT'"));
+			if (date.isValid()) {
+				date.setTimeSpec(Qt::UTC);
+				until = date.toMSecsSinceEpoch();
+			}
+		}
+
+		bucket.blockedUntil = qMax(bucket.blockedUntil, qMin(until, now + PENALTY_MAX));
+	}
+}
@@ -1,12 +1,20 @@
 #ifndef THROTTLING_MANAGER_H
 #define THROTTLING_MANAGER_H
 
-#include <QDateTime>
+#include <QByteArray>
 #include <QMap>
+#include <QMutex>
 
 
 class NetworkReply;
 
+/**
+ * Token-bucket throttling for each request type.
+ *
+ * Each bucket is refilled with one token per interval, up to its burst size, and each request consumes one token.
+ * Server errors (429, 503, etc.) add a penalty to the interval, which is slowly removed on successful responses.
+ * The buckets can be shared by network managers living on different threads.
+ */
 class ThrottlingManager
 {
 	public:
@@ -14,14 +22,35 @@ class ThrottlingManager
 
 		int interval(int key) const;
 		void setInterval(int key, int msInterval);
+		int burst(int key) const;
+		void setBurst(int key, int burst);
 		void clear();
 
+		int currentInterval(int key) const;
+		double rate(int key) const;
 		int msToRequest(int key) const;
+		int reserve(int key);
 		void start(int key, NetworkReply *reply);
+		void finished(int key, NetworkReply *reply);
+		void report(int key, int statusCode, const QByteArray &retryAfter = QByteArray());
+
+	protected:
+		struct Bucket
+		{
+			int interval = 0;
+			int burst = 1;
+			int penalty = 0;
+			double tokens = 1;
+			qint64 lastRefill = 0;
+			qint64 blockedUntil = 0;
+		};
+
+		static void refill(Bucket &bucket, qint64 now);
+		static int msToRequest(const Bucket &bucket, qint64 now);
 
 	private:
-		QMap<int, int> m_intervals;
-		QMap<int, QDateTime> m_lastRequests;
+		mutable QMutex m_mutex;
+		QMap<int, Bucket> m_buckets;
 };
 
 #endif // THROTTLING_MANAGER_H
@@ -0,0 +1,53 @@
+#include "throughput-estimator.h"
+#include <QMutexLocker>
+#include <cmath>
+
+
+ThroughputEstimator::ThroughputEstimator(double smoothingFactor, qint64 minBytes)
+	: m_average(smoothingFactor), m_minBytes(minBytes)
+{}
+
+ThroughputEstimator &ThroughputEstimator::getInstance()
+{
+	static auto *instance = new ThroughputEstimator();
+	return *instance;
+}
+
+void ThroughputEstimator::addTransfer(qint64 bytes, qint64 ms)
+{
+	if (bytes < m_minBytes || ms <= 0) {
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	m_average.addValue(static_cast<double>(bytes) * 1000 / ms);
+	m_samples++;
+}
+
+void ThroughputEstimator::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_average.clear();
+	m_samples = 0;
+}
+
+bool ThroughputEstimator::hasEstimate() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_samples > 0;
+}
+
+double ThroughputEstimator::bytesPerSecond() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_samples > 0 ? m_average.average() : 0;
+}
+
+qint64 ThroughputEstimator::estimatedMs(qint64 bytes) const
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_samples == 0 || bytes <= 0 || m_average.average() <= 0) {
+		return -1;
+	}
+	return static_cast<qint64>(std::ceil(bytes * 1000 / m_average.average()));
+}
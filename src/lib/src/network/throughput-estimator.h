@@ -0,0 +1,37 @@
+#ifndef THROUGHPUT_ESTIMATOR_H
+#define THROUGHPUT_ESTIMATOR_H
+
+#include <QMutex>
+#include "exponential-moving-average.h"
+
+
+/**
+ * Moving average of the throughput of the recent file downloads, used to predict how long the next ones will take.
+ *
+ * Small transfers are ignored, as their duration mostly depends on the latency rather than on the bandwidth.
+ */
+class ThroughputEstimator
+{
+	public:
+		explicit ThroughputEstimator(double smoothingFactor = 0.3, qint64 minBytes = 64 * 1024);
+		static ThroughputEstimator &getInstance();
+
+		void addTransfer(qint64 bytes, qint64 ms);
+		void clear();
+
+		bool hasEstimate() const;
+		double bytesPerSecond() const;
+
+		/**
+		 * The expected download time of a file, or -1 if it can't be estimated.
+		 */
+		qint64 estimatedMs(qint64 bytes) const;
+
+	private:
+		mutable QMutex m_mutex;
+		ExponentialMovingAverage m_average;
+		qint64 m_minBytes;
+		int m_samples = 0;
+};
+
+#endif // THROUGHPUT_ESTIMATOR_H
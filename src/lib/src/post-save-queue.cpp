@@ -0,0 +1,77 @@
+#include "post-save-queue.h"
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+
+PostSaveQueue::PostSaveQueue(int maxWorkers, int maxPending)
+	: m_maxPending(maxPending)
+{
+	m_pool.setMaxThreadCount(qMax(1, maxWorkers));
+}
+
+PostSaveQueue::~PostSaveQueue()
+{
+	m_pool.waitForDone();
+}
+
+/**
+ * Queue a job, to be run after all the previous jobs with the same key finished.
+ * A maximum number of pending jobs of 0 or less runs jobs right away in the calling thread.
+ */
+void PostSaveQueue::run(const QString &key, const std::function<void()> &job)
+{
+	if (m_maxPending <= 0) {
+		job();
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	while (m_pending >= m_maxPending) {
+		m_condition.wait(&m_mutex);
+	}
+	m_pending++;
+
+	// If a chain is already running for this key, it will pick up the job when it's its turn
+	const bool running = m_chains.contains(key);
+	m_chains[key].enqueue(job);
+	if (running) {
+		return;
+	}
+
+	QtConcurrent::run(&m_pool, [this, key]() {
+		runChain(key);
+	});
+}
+
+void PostSaveQueue::runChain(const QString &key)
+{
+	for (;;) {
+		std::function<void()> job;
+		{
+			QMutexLocker locker(&m_mutex);
+			QQueue<std::function<void()>> &chain = m_chains[key];
+			if (chain.isEmpty()) {
+				m_chains.remove(key);
+				return;
+			}
+			job = chain.dequeue();
+		}
+
+		job();
+
+		QMutexLocker locker(&m_mutex);
+		m_pending--;
+		m_condition.wakeOne();
+	}
+}
+
+int PostSaveQueue::pendingCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_pending;
+}
+
+bool PostSaveQueue::waitForDone(int msecs)
+{
+	return m_pool.waitForDone(msecs);
+}
@@ -0,0 +1,46 @@
+#ifndef POST_SAVE_QUEUE_H
+#define POST_SAVE_QUEUE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <functional>
+
+
+/**
+ * Runs the file work done after an image is saved (log files, file dates, hashes, file properties) in the background.
+ *
+ * This way, the download slot of an image is freed as soon as its file is written, instead of waiting for all that
+ * work to be done. Jobs sharing the same key (usually the file they write to) are run one after the other in the
+ * order they were added, while jobs with different keys run concurrently.
+ *
+ * The number of pending jobs is bounded: once it is reached, adding a job blocks until one of them finishes, so that
+ * slow disks slow down downloads instead of piling up work in memory.
+ */
+class PostSaveQueue
+{
+	public:
+		explicit PostSaveQueue(int maxWorkers, int maxPending);
+		~PostSaveQueue();
+
+		void run(const QString &key, const std::function<void()> &job);
+		int pendingCount() const;
+		bool waitForDone(int msecs = -1);
+
+	protected:
+		void runChain(const QString &key);
+
+	private:
+		QThreadPool m_pool;
+		int m_maxPending;
+
+		mutable QMutex m_mutex;
+		QWaitCondition m_condition;
+		QHash<QString, QQueue<std::function<void()>>> m_chains;
+		int m_pending = 0;
+};
+
+#endif // POST_SAVE_QUEUE_H
@@ -0,0 +1,121 @@
+#include "reverse-search/reverse-search-batch.h"
+#include <QNetworkRequest>
+#include <QSet>
+#include <utility>
+#include "logger.h"
+#include "network/network-manager.h"
+#include "network/network-reply.h"
+
+
+int ReverseSearchCache::count() const
+{
+	return m_results.count();
+}
+
+void ReverseSearchCache::clear()
+{
+	m_results.clear();
+}
+
+QString ReverseSearchCache::key(const QString &md5, int engineId)
+{
+	return md5 + "|" + QString::number(engineId);
+}
+
+bool ReverseSearchCache::contains(const QString &md5, int engineId) const
+{
+	return m_results.contains(key(md5, engineId));
+}
+
+ReverseSearchResult ReverseSearchCache::value(const QString &md5, int engineId) const
+{
+	return m_results.value(key(md5, engineId));
+}
+
+void ReverseSearchCache::insert(const ReverseSearchResult &result)
+{
+	m_results.insert(key(result.md5, result.engineId), result);
+}
+
+
+ReverseSearchBatch::ReverseSearchBatch(NetworkManager *manager, QList<ReverseSearchEngine> engines, ReverseSearchCache *cache, QObject *parent)
+	: QObject(parent), m_manager(manager), m_engines(std::move(engines)), m_cache(cache)
+{}
+
+void ReverseSearchBatch::start(const QList<QPair<QString, QUrl>> &images)
+{
+	QList<ReverseSearchResult> cached;
+	QSet<QString> requested;
+
+	for (const auto &image : images) {
+		for (const ReverseSearchEngine &engine : qAsConst(m_engines)) {
+			const QString key = image.first + "|" + QString::number(engine.id());
+			if (requested.contains(key)) {
+				continue;
+			}
+			requested.insert(key);
+
+			if (m_cache->contains(image.first, engine.id())) {
+				cached.append(m_cache->value(image.first, engine.id()));
+				continue;
+			}
+
+			ReverseSearchResult result;
+			result.engineId = engine.id();
+			result.md5 = image.first;
+
+			NetworkReply *reply = m_manager->get(QNetworkRequest(engine.searchUrl(image.second)));
+			connect(reply, &NetworkReply::finished, this, [this, reply]() { replyFinished(reply); });
+			m_running.insert(reply, result);
+		}
+	}
+
+	log(QStringLiteral("Reverse search of %1 images on %2 engines: %3 requests, %4 cached").arg(images.count()).arg(m_engines.count()).arg(m_running.count()).arg(cached.count()), Logger::Info);
+
+	for (const ReverseSearchResult &result : qAsConst(cached)) {
+		emit resultLoaded(result);
+	}
+	if (m_running.isEmpty()) {
+		emit finished();
+	}
+}
+
+void ReverseSearchBatch::replyFinished(NetworkReply *reply)
+{
+	if (!m_running.contains(reply)) {
+		return;
+	}
+
+	ReverseSearchResult result = m_running.take(reply);
+	result.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	result.url = reply->url();
+	if (reply->error() != NetworkReply::NetworkError::NoError) {
+		result.error = reply->errorString();
+	} else {
+		result.content = reply->readAll();
+
+		// Network errors might be temporary, so only successful lookups are cached
+		m_cache->insert(result);
+	}
+	reply->deleteLater();
+
+	emit resultLoaded(result);
+	if (m_running.isEmpty()) {
+		emit finished();
+	}
+}
+
+void ReverseSearchBatch::abort()
+{
+	const QList<NetworkReply*> replies = m_running.keys();
+	m_running.clear();
+	for (NetworkReply *reply : replies) {
+		reply->abort();
+		reply->deleteLater();
+	}
+}
+
+bool ReverseSearchBatch::isRunning() const
+{
+	return !m_running.isEmpty();
+}
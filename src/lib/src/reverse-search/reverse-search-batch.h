@@ -0,0 +1,85 @@
+#ifndef REVERSE_SEARCH_BATCH_H
+#define REVERSE_SEARCH_BATCH_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QUrl>
+#include "reverse-search/reverse-search-engine.h"
+
+
+class NetworkManager;
+class NetworkReply;
+
+struct ReverseSearchResult
+{
+	int engineId = 0;
+	QString md5;
+	int statusCode = 0;
+	QUrl url; // The results page, after redirections
+	QByteArray content;
+	QString error;
+};
+
+Q_DECLARE_METATYPE(ReverseSearchResult)
+
+/**
+ * Reverse-search results by image MD5 and engine, so that the same image is never looked up twice on an engine.
+ * Can be shared by several batches.
+ */
+class ReverseSearchCache
+{
+	public:
+		int count() const;
+		void clear();
+		bool contains(const QString &md5, int engineId) const;
+		ReverseSearchResult value(const QString &md5, int engineId) const;
+		void insert(const ReverseSearchResult &result);
+
+	protected:
+		static QString key(const QString &md5, int engineId);
+
+	private:
+		QHash<QString, ReverseSearchResult> m_results;
+};
+
+/**
+ * Queries all the given reverse-search engines for a list of images at the same time.
+ *
+ * All the requests are given to the network manager at once, which limits how many run at the same time. Each image
+ * is looked up once per engine, even if it appears several times in the list, and results already in the cache are
+ * emitted right away without any request.
+ */
+class ReverseSearchBatch : public QObject
+{
+	Q_OBJECT
+
+	public:
+		ReverseSearchBatch(NetworkManager *manager, QList<ReverseSearchEngine> engines, ReverseSearchCache *cache, QObject *parent = nullptr);
+
+		/**
+		 * Look up images, by MD5 and URL.
+		 */
+		void start(const QList<QPair<QString, QUrl>> &images);
+		void abort();
+		bool isRunning() const;
+
+	signals:
+		void resultLoaded(const ReverseSearchResult &result);
+		void finished();
+
+	protected:
+		void replyFinished(NetworkReply *reply);
+
+	private:
+		NetworkManager *m_manager;
+		QList<ReverseSearchEngine> m_engines;
+		ReverseSearchCache *m_cache;
+		QHash<NetworkReply*, ReverseSearchResult> m_running;
+};
+
+#endif // REVERSE_SEARCH_BATCH_H
@@ -33,11 +33,19 @@ QIcon ReverseSearchEngine::loadIcon(const QString &path) const
 }
 
 void ReverseSearchEngine::searchByUrl(const QUrl &url) const
+{
+	QDesktopServices::openUrl(searchUrl(url));
+}
+
+/**
+ * The URL of the results page of this engine for the given image URL.
+ */
+QUrl ReverseSearchEngine::searchUrl(const QUrl &url) const
 {
 	QString tpl = QString(m_tpl);
 	tpl.replace("{url}", url.toEncoded());
 
-	QDesktopServices::openUrl(QUrl(tpl));
+	return QUrl(tpl);
 }
 
 
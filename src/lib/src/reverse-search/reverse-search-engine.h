@@ -13,6 +13,7 @@ class ReverseSearchEngine
 		ReverseSearchEngine() = default;
 		ReverseSearchEngine(int id, const QString &icon, QString name, QString tpl, int order);
 		void searchByUrl(const QUrl &url) const;
+		QUrl searchUrl(const QUrl &url) const;
 
 		int id() const;
 		QIcon icon() const;
@@ -2,6 +2,10 @@
 #include <QColor>
 #include <QRegularExpression>
 
+#define TOKEN_CACHE_SIZE 10000
+#define FAVORITES_RULE -2
+#define KEPT_FOR_LATER_RULE -3
+
 
 SearchSyntaxHighlighter::SearchSyntaxHighlighter(bool full, QTextDocument *parent)
 	: QSyntaxHighlighter(parent)
@@ -9,54 +13,130 @@ SearchSyntaxHighlighter::SearchSyntaxHighlighter(bool full, QTextDocument *paren
 	favoritesFormat.setForeground(QColor("#ffc0cb"));
 	keptForLaterFormat.setForeground(QColor("#000000"));
 
+	// Rules are matched against whole tokens, the first matching one giving the token's format
 	HighlightingRule rule;
 
-	// Or format "~tag"
-	orFormat.setForeground(Qt::green);
-	rule.pattern = QRegularExpression("(?: |^)~([^ ]+)");
-	rule.format = orFormat;
-	highlightingRules.append(rule);
-
-	// Exclusion format "-tag"
-	excludeFormat.setForeground(Qt::red);
-	rule.pattern = QRegularExpression("(?: |^)-([^ ]+)");
-	rule.format = excludeFormat;
+	// Meta format "meta:value"
+	metaFormat.setForeground(QColor("#a52a2a"));
+	rule.pattern = QRegularExpression("^(user|fav|md5|pool|rating|source|status|approver|unlocked|sub|id|width|height|score|mpixels|filesize|filetype|date|gentags|arttags|chartags|copytags|status|status|approver|order|parent|sort|grabber):([^: ][^ ]*)?$", QRegularExpression::CaseInsensitiveOption);
+	rule.format = metaFormat;
 	highlightingRules.append(rule);
 
 	if (!full) {
 		// Meta other format "unknown_meta:value"
 		metaOtherFormat.setForeground(QColor("#ff0000"));
-		rule.pattern = QRegularExpression("(?: |^)([^:]+):([^: ][^ ]*)?(?: |$)");
+		rule.pattern = QRegularExpression("^([^:]+):([^: ][^ ]*)?$");
 		rule.format = metaOtherFormat;
 		highlightingRules.append(rule);
 	} else {
-		// MD5 format "qdrg15sdfgs1d2f1gs3dfg"
-		md5Format.setForeground(QColor("#800080"));
-		rule.pattern = QRegularExpression("(?: |^)([0-9A-F]{32})", QRegularExpression::CaseInsensitiveOption);
-		rule.format = md5Format;
-		highlightingRules.append(rule);
-
 		// URL format "http://..."
 		urlFormat.setForeground(Qt::blue);
-		rule.pattern = QRegularExpression("(?: |^)(https?://[^\\s/$.?#].[^\\s]*)(?: |$)");
+		rule.pattern = QRegularExpression("^(https?://[^\\s/$.?#].[^\\s]*)$");
 		rule.format = urlFormat;
 		highlightingRules.append(rule);
+
+		// MD5 format "qdrg15sdfgs1d2f1gs3dfg"
+		md5Format.setForeground(QColor("#800080"));
+		rule.pattern = QRegularExpression("^([0-9A-F]{32})", QRegularExpression::CaseInsensitiveOption);
+		rule.format = md5Format;
+		highlightingRules.append(rule);
 	}
 
-	// Meta format "meta:value"
-	metaFormat.setForeground(QColor("#a52a2a"));
-	rule.pattern = QRegularExpression("(?: |^)(user|fav|md5|pool|rating|source|status|approver|unlocked|sub|id|width|height|score|mpixels|filesize|filetype|date|gentags|arttags|chartags|copytags|status|status|approver|order|parent|sort|grabber):([^: ][^ ]*)?(?: |$)", QRegularExpression::CaseInsensitiveOption);
-	rule.format = metaFormat;
+	// Exclusion format "-tag"
+	excludeFormat.setForeground(Qt::red);
+	rule.pattern = QRegularExpression("^-([^ ]+)");
+	rule.format = excludeFormat;
+	highlightingRules.append(rule);
+
+	// Or format "~tag"
+	orFormat.setForeground(Qt::green);
+	rule.pattern = QRegularExpression("^~([^ ]+)");
+	rule.format = orFormat;
 	highlightingRules.append(rule);
 }
 
+void SearchSyntaxHighlighter::setFavorites(const QStringList &tags, const QTextCharFormat &format)
+{
+	QSet<QString> set = QSet<QString>::fromList(tags);
+	if (set == favorites && format == favoritesFormat) {
+		return;
+	}
+
+	favorites = set;
+	favoritesFormat = format;
+	clearCache();
+	rehighlight();
+}
+
+void SearchSyntaxHighlighter::setKeptForLater(const QStringList &tags, const QTextCharFormat &format)
+{
+	QSet<QString> set = QSet<QString>::fromList(tags);
+	if (set == keptForLater && format == keptForLaterFormat) {
+		return;
+	}
+
+	keptForLater = set;
+	keptForLaterFormat = format;
+	clearCache();
+	rehighlight();
+}
+
+void SearchSyntaxHighlighter::clearCache()
+{
+	tokenFormats.clear();
+}
+
+const QTextCharFormat *SearchSyntaxHighlighter::tokenFormat(const QString &token)
+{
+	auto it = tokenFormats.constFind(token);
+	if (it == tokenFormats.constEnd()) {
+		// Prevent the cache from growing indefinitely when editing huge texts
+		if (tokenFormats.count() >= TOKEN_CACHE_SIZE) {
+			clearCache();
+		}
+
+		int index = -1;
+		if (favorites.contains(token)) {
+			index = FAVORITES_RULE;
+		} else if (keptForLater.contains(token)) {
+			index = KEPT_FOR_LATER_RULE;
+		} else {
+			for (int i = 0; i < highlightingRules.count(); ++i) {
+				if (highlightingRules[i].pattern.match(token).hasMatch()) {
+					index = i;
+					break;
+				}
+			}
+		}
+		it = tokenFormats.insert(token, index);
+	}
+
+	const int index = it.value();
+	if (index == FAVORITES_RULE) {
+		return &favoritesFormat;
+	}
+	if (index == KEPT_FOR_LATER_RULE) {
+		return &keptForLaterFormat;
+	}
+	return index >= 0 ? &highlightingRules[index].format : nullptr;
+}
+
 void SearchSyntaxHighlighter::highlightBlock(const QString &text)
 {
-	for (const HighlightingRule &rule : highlightingRules) {
-		QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-		while (matchIterator.hasNext()) {
-			QRegularExpressionMatch match = matchIterator.next();
-			setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+	const int length = text.length();
+	int start = 0;
+	while (start < length) {
+		int end = text.indexOf(' ', start);
+		if (end < 0) {
+			end = length;
+		}
+
+		if (end > start) {
+			const QTextCharFormat *format = tokenFormat(text.mid(start, end - start));
+			if (format != nullptr) {
+				setFormat(start, end - start, *format);
+			}
 		}
+		start = end + 1;
 	}
 }
@@ -1,8 +1,11 @@
 #ifndef SEARCH_SYNTAX_HIGHLIGHTER_H
 #define SEARCH_SYNTAX_HIGHLIGHTER_H
 
+#include <QHash>
 #include <QRegularExpression>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <QVector>
@@ -10,6 +13,12 @@
 
 class QTextDocument;
 
+/**
+ * Colors the tags of a search query depending on their type (meta-tags, exclusions, favorites, etc.).
+ *
+ * Texts are highlighted token by token, each token being classified once and its format cached, so that editing a
+ * query only needs to classify the tokens that were modified. Qt itself only re-highlights the edited blocks.
+ */
 class SearchSyntaxHighlighter : public QSyntaxHighlighter
 {
 	Q_OBJECT
@@ -17,8 +26,16 @@ class SearchSyntaxHighlighter : public QSyntaxHighlighter
 	public:
 		explicit SearchSyntaxHighlighter(bool full, QTextDocument *parent = nullptr);
 
+		/**
+		 * Set the tags colored as favorites or kept for later, and how, re-highlighting the document if necessary.
+		 */
+		void setFavorites(const QStringList &tags, const QTextCharFormat &format);
+		void setKeptForLater(const QStringList &tags, const QTextCharFormat &format);
+
 	protected:
 		void highlightBlock(const QString &text) override;
+		const QTextCharFormat *tokenFormat(const QString &token);
+		void clearCache();
 
 	private:
 		struct HighlightingRule
@@ -27,6 +44,9 @@ class SearchSyntaxHighlighter : public QSyntaxHighlighter
 			QTextCharFormat format;
 		};
 		QVector<HighlightingRule> highlightingRules;
+		QHash<QString, int> tokenFormats; // Index of the rule matching each token, or -1
+		QSet<QString> favorites;
+		QSet<QString> keptForLater;
 
 		QTextCharFormat favoritesFormat;
 		QTextCharFormat keptForLaterFormat;
@@ -49,12 +49,19 @@ void SearchFormatVisitor::visit(const SearchNodeOp &node)
 		m_result.append("(");
 	}
 
-	m_result.append(format.prefix);
+	// Nested operations of the same type already prefix their own operands
+	const auto *leftOp = dynamic_cast<const SearchNodeOp*>(node.left);
+	if (leftOp == nullptr || leftOp->op != node.op) {
+		m_result.append(format.prefix);
+	}
 	node.left->accept(*this);
 
 	m_result.append(format.separator);
 
-	m_result.append(format.prefix);
+	const auto *rightOp = dynamic_cast<const SearchNodeOp*>(node.right);
+	if (rightOp == nullptr || rightOp->op != node.op) {
+		m_result.append(format.prefix);
+	}
 	node.right->accept(*this);
 
 	if (needParen) {
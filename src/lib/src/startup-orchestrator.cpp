@@ -0,0 +1,96 @@
+#include "startup-orchestrator.h"
+#include <QStringList>
+#include <QTimer>
+#include <utility>
+#include "logger.h"
+
+
+StartupOrchestrator::StartupOrchestrator(QObject *parent)
+	: QObject(parent)
+{
+	m_timer.start();
+}
+
+/**
+ * It is never deleted, as tasks can be deferred until the very end of the startup.
+ */
+StartupOrchestrator &StartupOrchestrator::getInstance()
+{
+	static auto *instance = new StartupOrchestrator();
+	return *instance;
+}
+
+void StartupOrchestrator::phase(const QString &name)
+{
+	const qint64 now = m_timer.elapsed();
+	m_phases.append(qMakePair(name, now - m_lastPhase));
+	m_lastPhase = now;
+}
+
+void StartupOrchestrator::defer(const QString &name, std::function<void()> task, Priority priority)
+{
+	// Keep the tasks sorted by priority, in the order they were added
+	int index = m_tasks.count();
+	while (index > 0 && m_tasks[index - 1].priority > priority) {
+		index--;
+	}
+	m_tasks.insert(index, Task { name, std::move(task), priority });
+
+	if (m_ready && !m_running) {
+		m_running = true;
+		QTimer::singleShot(0, this, &StartupOrchestrator::runNextTask);
+	}
+}
+
+void StartupOrchestrator::ready()
+{
+	if (m_ready) {
+		return;
+	}
+
+	m_readyTime = m_timer.elapsed();
+	m_ready = true;
+	m_running = true;
+
+	// Give the window the time to be painted before running anything else
+	QTimer::singleShot(0, this, &StartupOrchestrator::runNextTask);
+}
+
+void StartupOrchestrator::runNextTask()
+{
+	if (m_tasks.isEmpty()) {
+		m_running = false;
+		log(report(), Logger::Info);
+		emit finished();
+		return;
+	}
+
+	const Task task = m_tasks.takeFirst();
+	QElapsedTimer timer;
+	timer.start();
+	task.run();
+	m_taskTimes.append(qMakePair(task.name, timer.elapsed()));
+
+	QTimer::singleShot(0, this, &StartupOrchestrator::runNextTask);
+}
+
+QString StartupOrchestrator::report() const
+{
+	QStringList phases;
+	for (const auto &phase : m_phases) {
+		phases.append(QStringLiteral("%1: %2 ms").arg(phase.first).arg(phase.second));
+	}
+
+	qint64 tasksTotal = 0;
+	QStringList tasks;
+	for (const auto &task : m_taskTimes) {
+		tasks.append(QStringLiteral("%1: %2 ms").arg(task.first).arg(task.second));
+		tasksTotal += task.second;
+	}
+
+	QString ret = QStringLiteral("Startup took %1 ms until the window was ready (%2)").arg(m_readyTime).arg(phases.join(", "));
+	if (!tasks.isEmpty()) {
+		ret += QStringLiteral(", then %1 ms for %2 deferred tasks (%3)").arg(tasksTotal).arg(tasks.count()).arg(tasks.join(", "));
+	}
+	return ret;
+}
@@ -0,0 +1,78 @@
+#ifndef STARTUP_ORCHESTRATOR_H
+#define STARTUP_ORCHESTRATOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <functional>
+
+
+/**
+ * Orders the application startup, so that the main window can be shown as soon as only the essentials are loaded.
+ *
+ * The startup is split in named phases, timed until the window is ready. Non-critical initialization is deferred
+ * as tasks, which are run by priority once the window is ready, one per event loop iteration so that the window
+ * stays responsive. A report of the time spent in each phase and task is logged once all tasks are done.
+ */
+class StartupOrchestrator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		enum Priority
+		{
+			High = 0,
+			Normal = 1,
+			Low = 2,
+		};
+
+		explicit StartupOrchestrator(QObject *parent = nullptr);
+
+		static StartupOrchestrator &getInstance();
+
+		/**
+		 * Mark the end of a startup phase, timed from the end of the previous one.
+		 */
+		void phase(const QString &name);
+
+		/**
+		 * Run a task once the window is ready. If it already is, the task is run on the next event loop iteration.
+		 */
+		void defer(const QString &name, std::function<void()> task, Priority priority = Normal);
+
+		/**
+		 * Mark the window as ready to use, and start running the deferred tasks.
+		 */
+		void ready();
+
+		bool isReady() const { return m_ready; }
+		QString report() const;
+
+	signals:
+		void finished();
+
+	protected slots:
+		void runNextTask();
+
+	protected:
+		struct Task
+		{
+			QString name;
+			std::function<void()> run;
+			Priority priority;
+		};
+
+	private:
+		QElapsedTimer m_timer;
+		qint64 m_lastPhase = 0;
+		qint64 m_readyTime = 0;
+		bool m_ready = false;
+		bool m_running = false;
+		QList<Task> m_tasks;
+		QList<QPair<QString, qint64>> m_phases;
+		QList<QPair<QString, qint64>> m_taskTimes;
+};
+
+#endif // STARTUP_ORCHESTRATOR_H
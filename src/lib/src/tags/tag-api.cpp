@@ -2,6 +2,7 @@
 #include "logger.h"
 #include "models/api/api.h"
 #include "models/site.h"
+#include "tags/tag-database.h"
 
 
 TagApi::TagApi(Profile *profile, Site *site, Api *api, int page, int limit, const QString &order, QObject *parent)
@@ -24,6 +25,7 @@ void TagApi::parse(const QString &source, int statusCode, Site *site)
 
 	m_tags.clear();
 	m_tags.append(ret.tags);
+	m_site->tagDatabase()->cacheTags(m_tags);
 
 	emit finishedLoading(this, LoadResult::Ok);
 }
@@ -0,0 +1,53 @@
+#include "tags/tag-counter.h"
+#include <algorithm>
+
+
+int TagCounter::count() const
+{
+	return m_tags.count();
+}
+
+bool TagCounter::isEmpty() const
+{
+	return m_tags.isEmpty();
+}
+
+int TagCounter::add(const Tag &tag, int count)
+{
+	const auto it = m_ids.constFind(tag.text());
+	if (it != m_ids.constEnd()) {
+		Tag &existing = m_tags[it.value()];
+		existing.setCount(existing.count() + count);
+		return it.value();
+	}
+
+	const int id = m_tags.count();
+	m_ids.insert(tag.text(), id);
+	m_tags.append(tag);
+	return id;
+}
+
+void TagCounter::add(const QList<Tag> &tags)
+{
+	m_ids.reserve(m_ids.count() + tags.count());
+	for (const Tag &tag : tags) {
+		add(tag, tag.count());
+	}
+}
+
+const QList<Tag> &TagCounter::tags() const
+{
+	return m_tags;
+}
+
+QList<Tag> TagCounter::sortedTags(int limit) const
+{
+	QList<Tag> ret = m_tags;
+	if (limit >= 0 && limit < ret.count()) {
+		std::partial_sort(ret.begin(), ret.begin() + limit, ret.end(), sortTagsByCount);
+		ret.erase(ret.begin() + limit, ret.end());
+	} else {
+		std::sort(ret.begin(), ret.end(), sortTagsByCount);
+	}
+	return ret;
+}
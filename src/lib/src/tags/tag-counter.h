@@ -0,0 +1,48 @@
+#ifndef TAG_COUNTER_H
+#define TAG_COUNTER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "tags/tag.h"
+
+
+/**
+ * Merges the counts of tags coming from many images or pages.
+ *
+ * Each tag name is given an ID the first time it is seen, its index in the tag list, so that adding a tag is a single
+ * hash lookup and merging N tags is linear.
+ */
+class TagCounter
+{
+	public:
+		int count() const;
+		bool isEmpty() const;
+
+		/**
+		 * Add a tag, or add the given count to it if it was already added before.
+		 * @return The ID of the tag.
+		 */
+		int add(const Tag &tag, int count);
+
+		/**
+		 * Add a list of tags, using their own counts.
+		 */
+		void add(const QList<Tag> &tags);
+
+		/**
+		 * The merged tags, in the order they were first added.
+		 */
+		const QList<Tag> &tags() const;
+
+		/**
+		 * The merged tags sorted by decreasing count. If a limit is given, only the most frequent ones are sorted.
+		 */
+		QList<Tag> sortedTags(int limit = -1) const;
+
+	private:
+		QHash<QString, int> m_ids;
+		QList<Tag> m_tags;
+};
+
+#endif // TAG_COUNTER_H
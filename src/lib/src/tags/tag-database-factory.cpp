@@ -1,17 +1,54 @@
 #include "tags/tag-database-factory.h"
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWeakPointer>
 #include "tags/tag-database-in-memory.h"
+#include "tags/tag-database-mapped.h"
 #include "tags/tag-database-sqlite.h"
 #include "utils/read-write-path.h"
 
 
-TagDatabase *TagDatabaseFactory::Create(const ReadWritePath &directory)
+TagDatabase *TagDatabaseFactory::Create(const ReadWritePath &directory, const QString &format)
 {
 	const ReadWritePath typesFile = directory.readWritePath("tag-types.txt");
 
-	if (QFile::exists(directory.writePath("tags.txt"))) {
-		return new TagDatabaseInMemory(typesFile, directory.writePath("tags.txt"));
+	// Mapped databases can also be read from the read-only directory, to be shared by all the profiles
+	TagDatabase *database;
+	if (format == "mapped" || (format.isEmpty() && QFile::exists(directory.readPath("tags.idx")))) {
+		database = new TagDatabaseMapped(typesFile, directory.readWritePath("tags.idx"));
+	} else if (format == "text" || (format != "sqlite" && QFile::exists(directory.writePath("tags.txt")))) {
+		database = new TagDatabaseInMemory(typesFile, directory.writePath("tags.txt"));
+	} else {
+		database = new TagDatabaseSqlite(typesFile, directory.writePath("tags.db"));
 	}
 
-	return new TagDatabaseSqlite(typesFile, directory.writePath("tags.db"));
+	// Types of the tags returned by the site, kept between sessions
+	database->setTypeCacheFile(directory.readWritePath("tag-types-cache.txt"));
+
+	return database;
+}
+
+QSharedPointer<TagDatabase> TagDatabaseFactory::Shared(const ReadWritePath &directory, const QString &format)
+{
+	static QMutex mutex;
+	static QHash<QString, QWeakPointer<TagDatabase>> databases;
+
+	const auto absolute = [](const QString &path) {
+		return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+	};
+	const QString key = absolute(directory.readPath()) + "\n" + absolute(directory.writePath()) + "\n" + format;
+
+	QMutexLocker locker(&mutex);
+	QSharedPointer<TagDatabase> database = databases.value(key).toStrongRef();
+	if (database.isNull()) {
+		database = QSharedPointer<TagDatabase>(Create(directory, format));
+		database->loadTypes();
+		database->open();
+		databases.insert(key, database);
+	}
+	return database;
 }
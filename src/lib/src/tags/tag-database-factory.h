@@ -1,7 +1,10 @@
 #ifndef TAG_DATABASE_FACTORY_H
 #define TAG_DATABASE_FACTORY_H
 
-class QString;
+#include <QSharedPointer>
+#include <QString>
+
+
 class ReadWritePath;
 class TagDatabase;
 
@@ -9,7 +12,16 @@ class TagDatabase;
 class TagDatabaseFactory
 {
 	public:
-		static TagDatabase *Create(const ReadWritePath &directory);
+		/**
+		 * Create the tag database of a site, using the given format ("text", "sqlite" or "mapped") or guessing it from
+		 * the existing files.
+		 */
+		static TagDatabase *Create(const ReadWritePath &directory, const QString &format = QString());
+
+		/**
+		 * Get the opened tag database of a directory, shared by all the sites of this process using the same one.
+		 */
+		static QSharedPointer<TagDatabase> Shared(const ReadWritePath &directory, const QString &format = QString());
 };
 
 #endif // TAG_DATABASE_FACTORY_H
@@ -1,13 +1,19 @@
 #include "tags/tag-database-in-memory.h"
 #include <QFile>
+#include <QHash>
 #include <QStringList>
 #include <QTextStream>
+#include <algorithm>
+#include <cstring>
 #include <utility>
 #include "logger.h"
 #include "tags/tag.h"
 #include "utils/file-utils.h"
 #include "utils/read-write-path.h"
 
+#define MAX_TAG_LENGTH 65535
+#define WRITE_BUFFER_SIZE (1024 * 1024)
+
 
 TagDatabaseInMemory::TagDatabaseInMemory(const ReadWritePath &typeFile, QString tagFile)
 	: TagDatabase(typeFile), m_tagFile(std::move(tagFile)), m_count(-1)
@@ -16,7 +22,7 @@ TagDatabaseInMemory::TagDatabaseInMemory(const ReadWritePath &typeFile, QString
 bool TagDatabaseInMemory::load()
 {
 	// Don't reload databases
-	if (!m_database.isEmpty()) {
+	if (!m_entries.isEmpty()) {
 		return true;
 	}
 
@@ -29,87 +35,223 @@ bool TagDatabaseInMemory::load()
 	if (!file.exists()) {
 		return true;
 	}
-	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+	if (!file.open(QFile::ReadOnly)) {
 		return false;
 	}
 
-	QTextStream in(&file);
-	while (!in.atEnd()) {
-		QString line = in.readLine();
+	// The file content is directly used as the name buffer, the entries only pointing to the tag part of each line
+	m_names = file.readAll();
+	file.close();
+	m_unsaved.clear();
+	m_mustRewrite = !m_names.isEmpty() && !m_names.endsWith('\n');
 
-		QStringList data = line.split(',');
-		if (data.count() != 2) {
-			continue;
+	const char *data = m_names.constData();
+	const int size = m_names.size();
+	QHash<int, int> typeIndexes;
+
+	int pos = 0;
+	while (pos < size) {
+		const char *newLine = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+		const int lineStart = pos;
+		int lineEnd = newLine != nullptr ? static_cast<int>(newLine - data) : size;
+		pos = lineEnd + 1;
+		if (lineEnd > lineStart && data[lineEnd - 1] == '\r') {
+			lineEnd--;
 		}
 
-		int tId = data[1].toInt();
-		if (!m_tagTypeDatabase.contains(tId)) {
+		// Lines must be exactly "tag,typeId"
+		const char *comma = static_cast<const char*>(memchr(data + lineStart, ',', lineEnd - lineStart));
+		if (comma == nullptr) {
+			continue;
+		}
+		const int commaPos = static_cast<int>(comma - data);
+		if (memchr(comma + 1, ',', lineEnd - commaPos - 1) != nullptr) {
 			continue;
 		}
 
-		QString tag = data[0];
-		if (tag.isEmpty()) {
+		const int length = commaPos - lineStart;
+		if (length == 0 || length > MAX_TAG_LENGTH) {
 			continue;
 		}
-		tag.squeeze();
 
-		m_database.insert(tag, m_tagTypeDatabase.get(tId));
+		const int tId = QByteArray::fromRawData(comma + 1, lineEnd - commaPos - 1).toInt();
+		auto typeIndex = typeIndexes.constFind(tId);
+		if (typeIndex == typeIndexes.constEnd()) {
+			if (!m_tagTypeDatabase.contains(tId)) {
+				continue;
+			}
+			typeIndex = typeIndexes.insert(tId, m_types.count());
+			m_types.append(m_tagTypeDatabase.get(tId));
+		}
+
+		m_entries.append(Entry { static_cast<quint32>(lineStart), static_cast<quint16>(length), static_cast<quint16>(typeIndex.value()) });
 	}
-	file.close();
-	m_database.squeeze();
 
+	sortEntries(0);
+	m_entries.squeeze();
 	return true;
 }
 
 bool TagDatabaseInMemory::save()
 {
-	if (m_database.isEmpty()) {
+	if (m_entries.isEmpty()) {
 		return TagDatabase::save();
 	}
 
-	if (!ensureFileParent(m_tagFile)) {
-		return false;
-	}
+	// Since loading keeps the last line of each tag, changes can be appended as long as the file doesn't get too bloated
+	const bool append = !m_mustRewrite && m_unsaved.count() < m_entries.count() / 2;
+	if (!append || !m_unsaved.isEmpty()) {
+		if (!ensureFileParent(m_tagFile)) {
+			return false;
+		}
 
-	QFile file(m_tagFile);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
-		return false;
+		QFile file(m_tagFile);
+		const QIODevice::OpenMode mode = append ? QFile::Append : QFile::Truncate;
+		if (!file.open(QFile::WriteOnly | mode | QFile::Text)) {
+			return false;
+		}
+
+		if (!writeEntries(file, append ? m_unsaved : m_entries)) {
+			return false;
+		}
+
+		m_unsaved.clear();
+		m_mustRewrite = false;
 	}
 
-	QHashIterator<QString, TagType> i(m_database);
-	while (i.hasNext()) {
-		i.next();
+	return TagDatabase::save();
+}
 
-		TagType tagType = i.value();
-		const int tagTypeId = m_tagTypeDatabase.get(tagType);
-		if (tagTypeId == -1) {
+bool TagDatabaseInMemory::writeEntries(QFile &file, const QVector<Entry> &entries)
+{
+	QVector<QByteArray> typeIds;
+	typeIds.reserve(m_types.count());
+	for (const TagType &type : qAsConst(m_types)) {
+		const int tagTypeId = m_tagTypeDatabase.get(type);
+		typeIds.append(tagTypeId == -1 ? QByteArray() : "," + QByteArray::number(tagTypeId) + "\n");
+	}
+
+	QByteArray out;
+	for (const Entry &entry : entries) {
+		const QByteArray &typeId = typeIds[entry.type];
+		if (typeId.isEmpty()) {
 			continue;
 		}
 
-		file.write(QString(i.key() + "," + QString::number(tagTypeId) + "\n").toUtf8());
+		out.append(m_names.constData() + entry.offset, entry.length);
+		out.append(typeId);
+		if (out.size() > WRITE_BUFFER_SIZE) {
+			if (file.write(out) < 0) {
+				return false;
+			}
+			out.clear();
+		}
 	}
-	file.close();
 
-	return TagDatabase::save();
+	return file.write(out) >= 0;
 }
 
 void TagDatabaseInMemory::setTags(const QList<Tag> &tags, bool createTagTypes)
 {
-	m_database.clear();
+	m_names.clear();
+	m_entries.clear();
+	m_types.clear();
+	m_unsaved.clear();
+	m_mustRewrite = true;
+
+	addTags(tags, createTagTypes);
+	m_names.squeeze();
+}
+
+void TagDatabaseInMemory::addTags(const QList<Tag> &tags, bool createTagTypes)
+{
+	const int sortedCount = m_entries.count();
+	m_entries.reserve(sortedCount + tags.count());
+
 	for (const Tag &tag : tags) {
-		m_database.insert(tag.text(), tag.type());
+		const QByteArray name = tag.text().toUtf8();
+		if (name.size() > MAX_TAG_LENGTH) {
+			continue;
+		}
+
+		const Entry entry { static_cast<quint32>(m_names.size()), static_cast<quint16>(name.size()), static_cast<quint16>(typeIndex(tag.type())) };
+		m_entries.append(entry);
+		m_names.append(name);
+		if (!m_mustRewrite) {
+			m_unsaved.append(entry);
+		}
+
 		if (createTagTypes) {
 			m_tagTypeDatabase.get(tag.type(), true);
 		}
 	}
+
+	sortEntries(sortedCount);
+}
+
+int TagDatabaseInMemory::typeIndex(const TagType &type)
+{
+	for (int i = 0; i < m_types.count(); ++i) {
+		if (m_types[i] == type) {
+			return i;
+		}
+	}
+
+	m_types.append(type);
+	return m_types.count() - 1;
+}
+
+static int compareNames(const char *a, int aLength, const char *b, int bLength)
+{
+	const int ret = memcmp(a, b, static_cast<size_t>(qMin(aLength, bLength)));
+	return ret != 0 ? ret : aLength - bLength;
+}
+
+/**
+ * Sort entries by name, only keeping the last one for duplicate tags.
+ * The first "sortedCount" entries are already sorted, so they only need to be merged with the new ones.
+ */
+void TagDatabaseInMemory::sortEntries(int sortedCount)
+{
+	const char *names = m_names.constData();
+	const auto lessThan = [names](const Entry &a, const Entry &b) {
+		return compareNames(names + a.offset, a.length, names + b.offset, b.length) < 0;
+	};
+	std::stable_sort(m_entries.begin() + sortedCount, m_entries.end(), lessThan);
+	if (sortedCount > 0) {
+		std::inplace_merge(m_entries.begin(), m_entries.begin() + sortedCount, m_entries.end(), lessThan);
+	}
+
+	int count = 0;
+	for (int i = 0; i < m_entries.count(); ++i) {
+		const bool isLast = i + 1 == m_entries.count() || compareNames(names + m_entries[i].offset, m_entries[i].length, names + m_entries[i + 1].offset, m_entries[i + 1].length) != 0;
+		if (isLast) {
+			m_entries[count++] = m_entries[i];
+		}
+	}
+	m_entries.resize(count);
+}
+
+const TagDatabaseInMemory::Entry *TagDatabaseInMemory::find(const QByteArray &tag) const
+{
+	const char *names = m_names.constData();
+	const auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), tag, [names](const Entry &entry, const QByteArray &name) {
+		return compareNames(names + entry.offset, entry.length, name.constData(), name.size()) < 0;
+	});
+
+	if (it == m_entries.constEnd() || compareNames(names + it->offset, it->length, tag.constData(), tag.size()) != 0) {
+		return nullptr;
+	}
+	return it;
 }
 
-QMap<QString, TagType> TagDatabaseInMemory::getTagTypes(const QStringList &tags) const
+QMap<QString, TagType> TagDatabaseInMemory::getTagTypesFromDatabase(const QStringList &tags) const
 {
 	QMap<QString, TagType> ret;
 	for (const QString &tag : tags) {
-		if (m_database.contains(tag)) {
-			ret.insert(tag, m_database[tag]);
+		const Entry *entry = find(tag.toUtf8());
+		if (entry != nullptr) {
+			ret.insert(tag, m_types[entry->type]);
 		}
 	}
 
@@ -125,8 +267,8 @@ QMap<QString, int> TagDatabaseInMemory::getTagIds(const QStringList &tags) const
 
 int TagDatabaseInMemory::count() const
 {
-	if (!m_database.isEmpty()) {
-		return m_database.count();
+	if (!m_entries.isEmpty()) {
+		return m_entries.count();
 	}
 
 	if (m_count != -1) {
@@ -1,17 +1,28 @@
 #ifndef TAG_DATABASE_IN_MEMORY_H
 #define TAG_DATABASE_IN_MEMORY_H
 
-#include <QHash>
+#include <QByteArray>
 #include <QList>
 #include <QString>
+#include <QVector>
 #include "tags/tag-database.h"
+#include "tags/tag-type.h"
 
 
+class QFile;
 class QStringList;
 class ReadWritePath;
 class Tag;
-class TagType;
 
+/**
+ * Tag database fully loaded in memory.
+ *
+ * To keep the memory usage low with millions of tags, all tag names are stored as UTF-8 in a single buffer, and
+ * each tag is only an offset in this buffer and the index of its type. Entries are sorted by name, so lookups are
+ * a binary search.
+ *
+ * When only a few tags were added since the file was loaded, they are appended to it instead of rewriting it fully.
+ */
 class TagDatabaseInMemory : public TagDatabase
 {
 	public:
@@ -20,14 +31,32 @@ class TagDatabaseInMemory : public TagDatabase
 		bool load() override;
 		bool save() override;
 		void setTags(const QList<Tag> &tags, bool createTagTypes = false) override;
-		QMap<QString, TagType> getTagTypes(const QStringList &tags) const override;
+		void addTags(const QList<Tag> &tags, bool createTagTypes = false) override;
 		QMap<QString, int> getTagIds(const QStringList &tags) const override;
 		int count() const override;
 
+	protected:
+		struct Entry
+		{
+			quint32 offset;
+			quint16 length;
+			quint16 type;
+		};
+
+		QMap<QString, TagType> getTagTypesFromDatabase(const QStringList &tags) const override;
+		int typeIndex(const TagType &type);
+		void sortEntries(int sortedCount);
+		bool writeEntries(QFile &file, const QVector<Entry> &entries);
+		const Entry *find(const QByteArray &tag) const;
+
 	private:
 		QString m_tagFile;
-		QHash<QString, TagType> m_database;
+		QByteArray m_names;
+		QVector<Entry> m_entries;
+		QVector<TagType> m_types;
 		mutable int m_count;
+		QVector<Entry> m_unsaved;
+		bool m_mustRewrite = false;
 };
 
 #endif // TAG_DATABASE_IN_MEMORY_H
@@ -0,0 +1,332 @@
+#include "tags/tag-database-mapped.h"
+#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "logger.h"
+#include "tags/tag.h"
+
+#define MAGIC "GTDB"
+#define VERSION 1
+#define MAX_TAG_LENGTH 65535
+#define MAX_TYPE_COUNT 65535
+
+
+TagDatabaseMapped::TagDatabaseMapped(const ReadWritePath &typeFile, ReadWritePath tagFile)
+	: TagDatabase(typeFile), m_tagFile(std::move(tagFile))
+{}
+
+TagDatabaseMapped::~TagDatabaseMapped()
+{
+	unmap();
+}
+
+bool TagDatabaseMapped::load()
+{
+	// Don't map the file again
+	if (m_data != nullptr) {
+		return true;
+	}
+
+	if (!TagDatabase::load()) {
+		return false;
+	}
+
+	// A file saved by this profile takes precedence over the shared one
+	const QString path = QFile::exists(m_tagFile.writePath()) ? m_tagFile.writePath() : m_tagFile.readPath();
+	return map(path);
+}
+
+bool TagDatabaseMapped::close()
+{
+	unmap();
+	return TagDatabase::close();
+}
+
+/**
+ * Only the header and the type names are read here, the rest of the file being read by the OS as it is used.
+ */
+bool TagDatabaseMapped::map(const QString &path)
+{
+	unmap();
+
+	m_file.setFileName(path);
+	if (!m_file.exists()) {
+		return true;
+	}
+	if (!m_file.open(QFile::ReadOnly)) {
+		log(QStringLiteral("Could not open tag database `%1`: %2").arg(path, m_file.errorString()), Logger::Error);
+		return false;
+	}
+
+	const qint64 size = m_file.size();
+	const uchar *data = size >= static_cast<qint64>(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+	if (data == nullptr) {
+		log(QStringLiteral("Could not map tag database `%1`").arg(path), Logger::Error);
+		m_file.close();
+		return false;
+	}
+
+	// Validate the header, which also rejects files written with another byte order
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	const bool valid = memcmp(header.magic, MAGIC, 4) == 0
+		&& header.version == VERSION
+		&& header.entriesOffset % alignof(Entry) == 0
+		&& header.entriesOffset + static_cast<qint64>(header.count) * sizeof(Entry) <= size
+		&& header.typesOffset <= size
+		&& static_cast<qint64>(header.namesOffset) + header.namesSize <= size;
+
+	// Load type names
+	QVector<TagType> types;
+	qint64 pos = header.typesOffset;
+	for (quint32 i = 0; valid && i < header.typeCount && i < MAX_TYPE_COUNT; ++i) {
+		quint16 length = 0;
+		if (pos + 2 > size) {
+			break;
+		}
+		memcpy(&length, data + pos, 2);
+		if (pos + 2 + length > size) {
+			break;
+		}
+		types.append(TagType(QString::fromUtf8(reinterpret_cast<const char*>(data + pos + 2), length)));
+		pos += 2 + length;
+	}
+
+	if (!valid || static_cast<quint32>(types.count()) != header.typeCount) {
+		log(QStringLiteral("Invalid tag database `%1`").arg(path), Logger::Error);
+		m_file.unmap(const_cast<uchar*>(data));
+		m_file.close();
+		return false;
+	}
+
+	m_data = data;
+	m_entries = reinterpret_cast<const Entry*>(data + header.entriesOffset);
+	m_names = reinterpret_cast<const char*>(data + header.namesOffset);
+	m_count = header.count;
+	m_namesSize = header.namesSize;
+	m_types = types;
+
+	log(QStringLiteral("Tag database `%1` mapped (%2 tags)").arg(path).arg(m_count), Logger::Debug);
+	return true;
+}
+
+void TagDatabaseMapped::unmap()
+{
+	if (m_data != nullptr) {
+		m_file.unmap(const_cast<uchar*>(m_data));
+		m_data = nullptr;
+	}
+	if (m_file.isOpen()) {
+		m_file.close();
+	}
+
+	m_entries = nullptr;
+	m_names = nullptr;
+	m_count = 0;
+	m_namesSize = 0;
+	m_types.clear();
+}
+
+static int compareNames(const char *a, int aLength, const char *b, int bLength)
+{
+	const int ret = memcmp(a, b, static_cast<size_t>(qMin(aLength, bLength)));
+	return ret != 0 ? ret : aLength - bLength;
+}
+
+const TagDatabaseMapped::Entry *TagDatabaseMapped::find(const QByteArray &tag) const
+{
+	// Entries pointing outside of the names are considered empty, to not crash on corrupted files
+	const char *names = m_names;
+	const quint32 namesSize = m_namesSize;
+	const auto length = [namesSize](const Entry &entry) {
+		return static_cast<quint64>(entry.offset) + entry.length <= namesSize ? static_cast<int>(entry.length) : 0;
+	};
+
+	const Entry *end = m_entries + m_count;
+	const Entry *it = std::lower_bound(m_entries, end, tag, [names, &length](const Entry &entry, const QByteArray &name) {
+		return compareNames(names + entry.offset, length(entry), name.constData(), name.size()) < 0;
+	});
+
+	if (it == end || compareNames(names + it->offset, length(*it), tag.constData(), tag.size()) != 0) {
+		return nullptr;
+	}
+	return it;
+}
+
+
+/**
+ * The whole file is written again, and atomically replaces the previous one.
+ */
+bool TagDatabaseMapped::save()
+{
+	if (m_added.isEmpty() && !m_replaced) {
+		return TagDatabase::save();
+	}
+
+	struct Row
+	{
+		QByteArray name;
+		quint16 type;
+	};
+	QVector<Row> rows;
+	QVector<TagType> types;
+	QHash<QString, quint16> typeIndexes;
+	const auto typeIndex = [&types, &typeIndexes](const TagType &type) {
+		auto it = typeIndexes.constFind(type.name());
+		if (it == typeIndexes.constEnd()) {
+			it = typeIndexes.insert(type.name(), static_cast<quint16>(types.count()));
+			types.append(type);
+		}
+		return it.value();
+	};
+
+	// Tags added since the file was mapped replace the ones it contains
+	QSet<QByteArray> added;
+	for (auto it = m_added.constBegin(); it != m_added.constEnd(); ++it) {
+		const QByteArray name = it.key().toUtf8();
+		if (!name.isEmpty() && name.size() <= MAX_TAG_LENGTH && types.count() < MAX_TYPE_COUNT) {
+			rows.append(Row { name, typeIndex(it.value()) });
+			added.insert(name);
+		}
+	}
+	if (!m_replaced) {
+		rows.reserve(rows.count() + static_cast<int>(m_count));
+		for (quint32 i = 0; i < m_count; ++i) {
+			const Entry &entry = m_entries[i];
+			if (static_cast<quint64>(entry.offset) + entry.length > m_namesSize || entry.type >= m_types.count()) {
+				continue;
+			}
+			const QByteArray name(m_names + entry.offset, entry.length);
+			if (!added.contains(name)) {
+				rows.append(Row { name, typeIndex(m_types[entry.type]) });
+			}
+		}
+	}
+	std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+		return compareNames(a.name.constData(), a.name.size(), b.name.constData(), b.name.size()) < 0;
+	});
+
+	// Build the file sections
+	QByteArray typesData;
+	for (const TagType &type : qAsConst(types)) {
+		const QByteArray name = type.name().toUtf8().left(MAX_TAG_LENGTH);
+		const quint16 length = static_cast<quint16>(name.size());
+		typesData.append(reinterpret_cast<const char*>(&length), 2);
+		typesData.append(name);
+	}
+	QByteArray entriesData;
+	QByteArray namesData;
+	entriesData.reserve(rows.count() * static_cast<int>(sizeof(Entry)));
+	for (const Row &row : qAsConst(rows)) {
+		const Entry entry { static_cast<quint32>(namesData.size()), static_cast<quint16>(row.name.size()), row.type };
+		entriesData.append(reinterpret_cast<const char*>(&entry), sizeof(Entry));
+		namesData.append(row.name);
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	header.count = static_cast<quint32>(rows.count());
+	header.typeCount = static_cast<quint32>(types.count());
+	header.typesOffset = sizeof(Header);
+	header.entriesOffset = (header.typesOffset + typesData.size() + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+	header.namesOffset = header.entriesOffset + entriesData.size();
+	header.namesSize = namesData.size();
+
+	// Write everything in a temporary file first, so that the processes reading the previous one are not affected
+	const QString path = m_tagFile.writePath(QString(), true);
+	QSaveFile file(path);
+	if (!file.open(QFile::WriteOnly)) {
+		log(QStringLiteral("Could not write tag database `%1`: %2").arg(path, file.errorString()), Logger::Error);
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	file.write(typesData);
+	file.write(QByteArray(static_cast<int>(header.entriesOffset - header.typesOffset) - typesData.size(), '\0'));
+	file.write(entriesData);
+	file.write(namesData);
+
+	// Our own mapping would prevent replacing the file on some systems
+	const QString previousPath = m_file.fileName();
+	unmap();
+	if (!file.commit()) {
+		log(QStringLiteral("Could not write tag database `%1`: %2").arg(path, file.errorString()), Logger::Error);
+		map(previousPath);
+		return false;
+	}
+
+	m_added.clear();
+	m_replaced = false;
+	if (!map(path)) {
+		return false;
+	}
+
+	return TagDatabase::save();
+}
+
+void TagDatabaseMapped::setTags(const QList<Tag> &tags, bool createTagTypes)
+{
+	m_added.clear();
+	m_replaced = true;
+
+	addTags(tags, createTagTypes);
+}
+
+void TagDatabaseMapped::addTags(const QList<Tag> &tags, bool createTagTypes)
+{
+	m_added.reserve(m_added.count() + tags.count());
+	for (const Tag &tag : tags) {
+		m_added.insert(tag.text(), tag.type());
+
+		if (createTagTypes) {
+			m_tagTypeDatabase.get(tag.type(), true);
+		}
+	}
+}
+
+QMap<QString, TagType> TagDatabaseMapped::getTagTypesFromDatabase(const QStringList &tags) const
+{
+	QMap<QString, TagType> ret;
+	for (const QString &tag : tags) {
+		const auto added = m_added.constFind(tag);
+		if (added != m_added.constEnd()) {
+			ret.insert(tag, added.value());
+			continue;
+		}
+		if (m_replaced) {
+			continue;
+		}
+
+		const Entry *entry = find(tag.toUtf8());
+		if (entry != nullptr && entry->type < m_types.count()) {
+			ret.insert(tag, m_types[entry->type]);
+		}
+	}
+
+	return ret;
+}
+
+QMap<QString, int> TagDatabaseMapped::getTagIds(const QStringList &tags) const
+{
+	Q_UNUSED(tags);
+	log("Tag IDs are not supported with memory-mapped tag databases.");
+	return QMap<QString, int>();
+}
+
+int TagDatabaseMapped::count() const
+{
+	if (m_replaced) {
+		return m_added.count();
+	}
+
+	int count = static_cast<int>(m_count);
+	for (auto it = m_added.constBegin(); it != m_added.constEnd(); ++it) {
+		if (find(it.key().toUtf8()) == nullptr) {
+			count++;
+		}
+	}
+	return count;
+}
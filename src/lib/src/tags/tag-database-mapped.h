@@ -0,0 +1,78 @@
+#ifndef TAG_DATABASE_MAPPED_H
+#define TAG_DATABASE_MAPPED_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "tags/tag-database.h"
+#include "tags/tag-type.h"
+#include "utils/read-write-path.h"
+
+
+class QStringList;
+class Tag;
+
+/**
+ * Tag database read directly from a memory-mapped index file, so that all the processes and sites using the same
+ * file share a single copy of it in the OS page cache, only the pages actually looked up being read from disk.
+ *
+ * The file contains a header, the names of the tag types, an array of fixed-size entries sorted by tag name, and the
+ * UTF-8 names of all the tags. It is never modified in place: added tags are kept in memory until saved, which writes
+ * a new file replacing the previous one, without affecting the processes still mapping it.
+ */
+class TagDatabaseMapped : public TagDatabase
+{
+	public:
+		TagDatabaseMapped(const ReadWritePath &typeFile, ReadWritePath tagFile);
+		~TagDatabaseMapped() override;
+		bool load() override;
+		bool save() override;
+		bool close() override;
+		void setTags(const QList<Tag> &tags, bool createTagTypes = false) override;
+		void addTags(const QList<Tag> &tags, bool createTagTypes = false) override;
+		QMap<QString, int> getTagIds(const QStringList &tags) const override;
+		int count() const override;
+
+	protected:
+		struct Header
+		{
+			char magic[4];
+			quint32 version;
+			quint32 count;
+			quint32 typeCount;
+			quint32 typesOffset;
+			quint32 entriesOffset;
+			quint32 namesOffset;
+			quint32 namesSize;
+		};
+		struct Entry
+		{
+			quint32 offset;
+			quint16 length;
+			quint16 type;
+		};
+
+		QMap<QString, TagType> getTagTypesFromDatabase(const QStringList &tags) const override;
+		bool map(const QString &path);
+		void unmap();
+		const Entry *find(const QByteArray &tag) const;
+
+	private:
+		ReadWritePath m_tagFile;
+		QFile m_file;
+		const uchar *m_data = nullptr;
+		const Entry *m_entries = nullptr;
+		const char *m_names = nullptr;
+		quint32 m_count = 0;
+		quint32 m_namesSize = 0;
+		QVector<TagType> m_types;
+
+		// Changes not saved yet
+		QHash<QString, TagType> m_added;
+		bool m_replaced = false;
+};
+
+#endif // TAG_DATABASE_MAPPED_H
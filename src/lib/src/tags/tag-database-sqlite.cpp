@@ -1,9 +1,12 @@
 #include "tags/tag-database-sqlite.h"
 #include <QDir>
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSet>
+#include <QThread>
 #include <QtSql/QSqlDriver>
 #include <QtSql/QSqlError>
-#include <QtSql/QSqlField>
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlRecord>
 #include <QVariant>
@@ -12,9 +15,13 @@
 #include "tags/tag.h"
 #include "utils/file-utils.h"
 
+// Lower than SQLITE_MAX_VARIABLE_NUMBER, which defaults to 999 on older SQLite versions
+#define LOOKUP_CHUNK_SIZE 500
+#define LOOKUP_CACHE_SIZE 100000
+
 
 TagDatabaseSqlite::TagDatabaseSqlite(const ReadWritePath &typeFile, QString tagFile)
-	: TagDatabase(typeFile), m_tagFile(std::move(tagFile)), m_count(-1)
+	: TagDatabase(typeFile), m_tagFile(std::move(tagFile)), m_cache(LOOKUP_CACHE_SIZE), m_count(-1)
 {}
 
 TagDatabaseSqlite::~TagDatabaseSqlite()
@@ -66,9 +73,42 @@ bool TagDatabaseSqlite::init()
 		return false;
 	}
 
+	// Add a unique index for fast lookups, removing duplicates from older databases if necessary
+	const QString indexSql = QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS tags_tag ON tags(tag);");
+	QSqlQuery indexQuery(m_database);
+	if (!indexQuery.exec(indexSql)) {
+		log(QStringLiteral("Removing duplicate tags from the tag database: %1").arg(indexQuery.lastError().text()), Logger::Warning);
+		QSqlQuery dedupeQuery(m_database);
+		if (!dedupeQuery.exec(QStringLiteral("DELETE FROM tags WHERE rowid NOT IN (SELECT MIN(rowid) FROM tags GROUP BY tag);")) || !indexQuery.exec(indexSql)) {
+			log(QStringLiteral("Could not create tag database index: %1").arg(indexQuery.lastError().text()), Logger::Error);
+		}
+	}
+
 	return true;
 }
 
+/**
+ * SQL connections can only be used from the thread that created them, so lookups made from
+ * other threads (i.e. when parsing pages in worker threads) use their own connection.
+ */
+QSqlDatabase TagDatabaseSqlite::database() const
+{
+	if (!m_database.isOpen() || QThread::currentThread() == m_database.driver()->thread()) {
+		return m_database;
+	}
+
+	const QString connectionName = m_database.connectionName() + " - " + QString::number(reinterpret_cast<quintptr>(QThread::currentThread()));
+	if (QSqlDatabase::contains(connectionName)) {
+		return QSqlDatabase::database(connectionName);
+	}
+
+	QSqlDatabase db = QSqlDatabase::cloneDatabase(m_database.connectionName(), connectionName);
+	if (!db.open()) {
+		log(QStringLiteral("Could not open tag database '%1' for thread: %2").arg(m_tagFile, db.lastError().text()), Logger::Error);
+	}
+	return db;
+}
+
 bool TagDatabaseSqlite::close()
 {
 	if (m_database.isOpen()) {
@@ -102,12 +142,28 @@ void TagDatabaseSqlite::setTags(const QList<Tag> &tags, bool createTagTypes)
 		return;
 	}
 
+	{
+		QMutexLocker locker(&m_mutex);
+		m_cache.clear();
+		m_count = -1;
+	}
+
+	addTags(tags, createTagTypes);
+}
+
+void TagDatabaseSqlite::addTags(const QList<Tag> &tags, bool createTagTypes)
+{
+	// Ensure the database is initialized
+	if (!init() || !m_database.isOpen()) {
+		return;
+	}
+
 	if (!m_database.transaction()) {
 		return;
 	}
 
 	QSqlQuery addQuery(m_database);
-	addQuery.prepare(QStringLiteral("INSERT INTO tags (id, tag, ttype) VALUES (:id, :tag, :ttype)"));
+	addQuery.prepare(QStringLiteral("INSERT OR REPLACE INTO tags (id, tag, ttype) VALUES (:id, :tag, :ttype)"));
 
 	for (const Tag &tag : tags) {
 		addQuery.bindValue(":id", tag.id());
@@ -115,6 +171,7 @@ void TagDatabaseSqlite::setTags(const QList<Tag> &tags, bool createTagTypes)
 		addQuery.bindValue(":ttype", m_tagTypeDatabase.get(tag.type(), createTagTypes));
 		if (!addQuery.exec()) {
 			log(QStringLiteral("SQL error when adding tag: %1").arg(addQuery.lastError().text()), Logger::Error);
+			m_database.rollback();
 			return;
 		}
 	}
@@ -123,104 +180,115 @@ void TagDatabaseSqlite::setTags(const QList<Tag> &tags, bool createTagTypes)
 		return;
 	}
 
+	// Only forget the lookups of the tags that changed
+	QMutexLocker locker(&m_mutex);
+	for (const Tag &tag : tags) {
+		m_cache.remove(tag.text());
+	}
 	m_count = -1;
 }
 
-QMap<QString, TagType> TagDatabaseSqlite::getTagTypes(const QStringList &tags) const
+/**
+ * Get information about a list of tags, from the cache of recent lookups or from the database.
+ * Must be called with the mutex locked.
+ */
+QList<QPair<QString, TagDatabaseSqlite::CachedTag>> TagDatabaseSqlite::lookup(const QStringList &tags) const
 {
-	QMap<QString, TagType> ret;
-
-	if (!m_database.isOpen()) {
-		return ret;
-	}
+	QList<QPair<QString, CachedTag>> ret;
 
-	// Escape values
-	QStringList formatted;
-	QSqlDriver *driver = m_database.driver();
+	QStringList missing;
 	for (const QString &tag : tags) {
-		if (m_cache.contains(tag)) {
-			ret.insert(tag, m_cache[tag]);
-		} else {
-			QSqlField f;
-			f.setType(QVariant::String);
-			f.setValue(tag);
-			formatted.append(driver->formatValue(f));
+		const CachedTag *cached = m_cache.object(tag);
+		if (cached != nullptr) {
+			ret.append(QPair<QString, CachedTag>(tag, *cached));
+		} else if (!missing.contains(tag)) {
+			missing.append(tag);
 		}
 	}
 
 	// If all values have already been loaded from the memory cache
-	if (formatted.isEmpty()) {
+	if (missing.isEmpty()) {
 		return ret;
 	}
 
-	// Execute query
-	const QString sql = "SELECT tag, ttype FROM tags WHERE tag IN (" + formatted.join(",") + ")";
-	QSqlQuery query(m_database);
-	query.setForwardOnly(true);
-	if (!query.exec(sql)) {
-		log(QStringLiteral("SQL error when getting tags: %1").arg(query.lastError().text()), Logger::Error);
-		return ret;
-	}
+	QSqlDatabase db = database();
+	for (int start = 0; start < missing.count(); start += LOOKUP_CHUNK_SIZE) {
+		const QStringList chunk = missing.mid(start, LOOKUP_CHUNK_SIZE);
 
-	const int idTag = query.record().indexOf("tag");
-	const int idTtype = query.record().indexOf("ttype");
-	while (query.next()) {
-		const QString tag = query.value(idTag).toString();
-		const int typeId = query.value(idTtype).toInt();
-		if (!m_tagTypeDatabase.contains(typeId)) {
-			continue;
+		QStringList placeholders;
+		placeholders.reserve(chunk.count());
+		for (int i = 0; i < chunk.count(); ++i) {
+			placeholders.append(QStringLiteral("?"));
+		}
+
+		QSqlQuery query(db);
+		query.setForwardOnly(true);
+		query.prepare("SELECT tag, id, ttype FROM tags WHERE tag IN (" + placeholders.join(",") + ")");
+		for (const QString &tag : chunk) {
+			query.addBindValue(tag);
+		}
+		if (!query.exec()) {
+			log(QStringLiteral("SQL error when getting tags: %1").arg(query.lastError().text()), Logger::Error);
+			return ret;
+		}
+
+		QSet<QString> found;
+		const int idTag = query.record().indexOf("tag");
+		const int idId = query.record().indexOf("id");
+		const int idTtype = query.record().indexOf("ttype");
+		while (query.next()) {
+			const QString tag = query.value(idTag).toString();
+			const CachedTag result { true, query.value(idId).toInt(), query.value(idTtype).toInt() };
+			ret.append(QPair<QString, CachedTag>(tag, result));
+			m_cache.insert(tag, new CachedTag(result));
+			found.insert(tag);
+		}
+
+		// Also remember the tags that are not in the database
+		for (const QString &tag : chunk) {
+			if (!found.contains(tag)) {
+				m_cache.insert(tag, new CachedTag { false, 0, 0 });
+			}
 		}
-		const TagType type = m_tagTypeDatabase.get(typeId);
-		ret.insert(tag, type);
-		m_cache.insert(tag, type);
 	}
 
 	return ret;
 }
 
-QMap<QString, int> TagDatabaseSqlite::getTagIds(const QStringList &tags) const
+QMap<QString, TagType> TagDatabaseSqlite::getTagTypesFromDatabase(const QStringList &tags) const
 {
-	QMap<QString, int> ret;
+	QMap<QString, TagType> ret;
 
 	if (!m_database.isOpen()) {
 		return ret;
 	}
 
-	// Escape values
-	QStringList formatted;
-	QSqlDriver *driver = m_database.driver();
-	for (const QString &tag : tags) {
-		if (m_cacheIds.contains(tag)) {
-			ret.insert(tag, m_cacheIds[tag]);
-		} else {
-			QSqlField f;
-			f.setType(QVariant::String);
-			f.setValue(tag);
-			formatted.append(driver->formatValue(f));
+	QMutexLocker locker(&m_mutex);
+	const auto results = lookup(tags);
+	for (const auto &result : results) {
+		if (!result.second.found || !m_tagTypeDatabase.contains(result.second.typeId)) {
+			continue;
 		}
+		ret.insert(result.first, m_tagTypeDatabase.get(result.second.typeId));
 	}
 
-	// If all values have already been loaded from the memory cache
-	if (formatted.isEmpty()) {
-		return ret;
-	}
+	return ret;
+}
 
-	// Execute query
-	const QString sql = "SELECT tag, id FROM tags WHERE tag IN (" + formatted.join(",") + ")";
-	QSqlQuery query(m_database);
-	query.setForwardOnly(true);
-	if (!query.exec(sql)) {
-		log(QStringLiteral("SQL error when getting tags: %1").arg(query.lastError().text()), Logger::Error);
+QMap<QString, int> TagDatabaseSqlite::getTagIds(const QStringList &tags) const
+{
+	QMap<QString, int> ret;
+
+	if (!m_database.isOpen()) {
 		return ret;
 	}
 
-	const int idTag = query.record().indexOf("tag");
-	const int idId = query.record().indexOf("id");
-	while (query.next()) {
-		const QString tag = query.value(idTag).toString();
-		const int id = query.value(idId).toInt();
-		ret.insert(tag, id);
-		m_cacheIds.insert(tag, id);
+	QMutexLocker locker(&m_mutex);
+	const auto results = lookup(tags);
+	for (const auto &result : results) {
+		if (result.second.found) {
+			ret.insert(result.first, result.second.id);
+		}
 	}
 
 	return ret;
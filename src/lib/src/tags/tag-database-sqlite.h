@@ -1,10 +1,12 @@
 #ifndef TAG_DATABASE_SQLITE_H
 #define TAG_DATABASE_SQLITE_H
 
-#include <QHash>
+#include <QCache>
 #include <QMap>
+#include <QMutex>
 #include <QSqlDatabase>
 #include <QString>
+#include <QStringList>
 #include "tags/tag-database.h"
 
 
@@ -21,18 +23,31 @@ class TagDatabaseSqlite : public TagDatabase
 		bool load() override;
 		bool save() override;
 		void setTags(const QList<Tag> &tags, bool createTagTypes = false) override;
-		QMap<QString, TagType> getTagTypes(const QStringList &tags) const override;
+		void addTags(const QList<Tag> &tags, bool createTagTypes = false) override;
 		QMap<QString, int> getTagIds(const QStringList &tags) const override;
 		int count() const override;
 
 	protected:
+		/**
+		 * Result of a tag lookup, also kept for tags not in the database to avoid querying them again.
+		 */
+		struct CachedTag
+		{
+			bool found;
+			int id;
+			int typeId;
+		};
+
 		bool init();
+		QSqlDatabase database() const;
+		QList<QPair<QString, CachedTag>> lookup(const QStringList &tags) const;
+		QMap<QString, TagType> getTagTypesFromDatabase(const QStringList &tags) const override;
 
 	private:
 		QString m_tagFile;
 		QSqlDatabase m_database;
-		mutable QHash<QString, TagType> m_cache;
-		mutable QHash<QString, int> m_cacheIds;
+		mutable QMutex m_mutex;
+		mutable QCache<QString, CachedTag> m_cache;
 		mutable int m_count;
 };
 
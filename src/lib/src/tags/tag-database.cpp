@@ -1,13 +1,30 @@
 #include "tag-database.h"
+#include <QDateTime>
+#include <QFile>
+#include <QMutexLocker>
+#include <QStringList>
 #include <utility>
+#include "logger.h"
+#include "tag.h"
 #include "tag-type.h"
 #include "tag-type-with-id.h"
 
+#define TAG_CACHE_SIZE 100000
+#define TYPE_CACHE_EXPIRY (30 * 24 * 60 * 60)
+#define TYPE_CACHE_REFRESH (24 * 60 * 60)
+#define TYPE_CACHE_SAVE_EVERY 5000
+#define TAG_TYPES_EXPIRY (30 * 24 * 60 * 60)
+
 
 TagDatabase::TagDatabase(ReadWritePath typeFile)
-	: m_tagTypeDatabase(std::move(typeFile))
+	: m_tagTypeDatabase(std::move(typeFile)), m_cache(TAG_CACHE_SIZE), m_typeCacheFile(QString())
 {}
 
+TagDatabase::~TagDatabase()
+{
+	saveTypeCache();
+}
+
 bool TagDatabase::open()
 {
 	m_isOpen = true;
@@ -54,3 +71,138 @@ int TagDatabase::getTagTypeNumber(const TagType &type)
 {
 	return m_tagTypeDatabase.get(type, false);
 }
+
+void TagDatabase::cacheTags(const QList<Tag> &tags)
+{
+	const qint64 now = QDateTime::currentSecsSinceEpoch();
+	bool save = false;
+
+	{
+		QMutexLocker locker(&m_cacheMutex);
+		for (const Tag &tag : tags) {
+			if (tag.type().isUnknown()) {
+				continue;
+			}
+
+			// Avoid re-inserting the same value, which would needlessly allocate a new entry
+			CachedType *cached = m_cache.object(tag.text());
+			if (cached != nullptr && cached->type.name() == tag.type().name()) {
+				if (now - cached->seen > TYPE_CACHE_REFRESH) {
+					cached->seen = now;
+					m_unsavedCacheEntries++;
+				}
+				continue;
+			}
+
+			m_cache.insert(tag.text(), new CachedType { tag.type(), now });
+			m_unsavedCacheEntries++;
+		}
+		save = m_unsavedCacheEntries >= TYPE_CACHE_SAVE_EVERY;
+	}
+
+	if (save) {
+		saveTypeCache();
+	}
+}
+
+void TagDatabase::setTypeCacheFile(const ReadWritePath &file)
+{
+	m_typeCacheFile = file;
+	loadTypeCache();
+}
+
+/**
+ * Each line contains a tag, its type and when it was last returned by the site, separated by tabs.
+ */
+void TagDatabase::loadTypeCache()
+{
+	QFile f(m_typeCacheFile.readPath());
+	if (m_typeCacheFile.readPath().isEmpty() || !f.open(QFile::ReadOnly)) {
+		return;
+	}
+
+	const qint64 minSeen = QDateTime::currentSecsSinceEpoch() - TYPE_CACHE_EXPIRY;
+
+	QMutexLocker locker(&m_cacheMutex);
+	while (!f.atEnd()) {
+		const QList<QByteArray> parts = f.readLine().trimmed().split('\t');
+		if (parts.count() != 3) {
+			continue;
+		}
+
+		const qint64 seen = parts[2].toLongLong();
+		if (seen < minSeen) {
+			continue;
+		}
+
+		const QString tag = QString::fromUtf8(parts[0]);
+		if (!m_cache.contains(tag)) {
+			m_cache.insert(tag, new CachedType { TagType(QString::fromUtf8(parts[1])), seen });
+		}
+	}
+}
+
+bool TagDatabase::saveTypeCache()
+{
+	const QString path = m_typeCacheFile.writePath();
+	if (path.isEmpty()) {
+		return false;
+	}
+
+	QMutexLocker locker(&m_cacheMutex);
+	if (m_unsavedCacheEntries == 0 && QFile::exists(path)) {
+		return true;
+	}
+
+	QFile f(m_typeCacheFile.writePath("", true));
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not save the tag type cache to `%1`").arg(f.fileName()), Logger::Warning);
+		return false;
+	}
+
+	QByteArray data;
+	const QList<QString> keys = m_cache.keys();
+	for (const QString &key : keys) {
+		const CachedType *cached = m_cache.object(key);
+		data += key.toUtf8() + '\t' + cached->type.name().toUtf8() + '\t' + QByteArray::number(cached->seen) + '\n';
+	}
+	f.write(data);
+	f.close();
+
+	m_unsavedCacheEntries = 0;
+	return true;
+}
+
+bool TagDatabase::tagTypesExpired() const
+{
+	const QDateTime lastUpdate = m_tagTypeDatabase.lastUpdate();
+	return !lastUpdate.isValid() || lastUpdate.secsTo(QDateTime::currentDateTime()) > TAG_TYPES_EXPIRY;
+}
+
+QMap<QString, TagType> TagDatabase::getTagTypes(const QStringList &tags) const
+{
+	QMap<QString, TagType> ret;
+	QStringList missing;
+
+	{
+		QMutexLocker locker(&m_cacheMutex);
+		for (const QString &tag : tags) {
+			const CachedType *cached = m_cache.object(tag);
+			if (cached != nullptr) {
+				ret.insert(tag, cached->type);
+			} else {
+				missing.append(tag);
+			}
+		}
+	}
+
+	// Only query the actual database for tags that were never seen before
+	if (!missing.isEmpty()) {
+		const QMap<QString, TagType> fromDatabase = getTagTypesFromDatabase(missing);
+		for (auto it = fromDatabase.constBegin(); it != fromDatabase.constEnd(); ++it) {
+			ret.insert(it.key(), it.value());
+		}
+	}
+
+	return ret;
+}
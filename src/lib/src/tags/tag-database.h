@@ -1,20 +1,22 @@
 #ifndef TAG_DATABASE_H
 #define TAG_DATABASE_H
 
+#include <QCache>
 #include <QMap>
+#include <QMutex>
+#include "tags/tag-type.h"
 #include "tags/tag-type-database.h"
 #include "utils/read-write-path.h"
 
 
 class QString;
 class Tag;
-class TagType;
 struct TagTypeWithId;
 
 class TagDatabase
 {
 	public:
-		virtual ~TagDatabase() = default;
+		virtual ~TagDatabase();
 		bool loadTypes();
 		virtual bool open();
 		bool isOpen() const;
@@ -22,19 +24,57 @@ class TagDatabase
 		virtual bool load();
 		virtual bool save();
 		virtual void setTags(const QList<Tag> &tags, bool createTagTypes = false) = 0;
+
+		/**
+		 * Add tags to the database, replacing the existing ones with the same name.
+		 */
+		virtual void addTags(const QList<Tag> &tags, bool createTagTypes = false) = 0;
+
 		virtual void setTagTypes(const QList<TagTypeWithId> &tagTypes);
-		virtual QMap<QString, TagType> getTagTypes(const QStringList &tags) const = 0;
+		QMap<QString, TagType> getTagTypes(const QStringList &tags) const;
 		virtual QMap<QString, int> getTagIds(const QStringList &tags) const = 0;
 		virtual int count() const = 0;
 		const QMap<int, TagType> &tagTypes() const;
 		int getTagTypeNumber(const TagType &type);
 
+		/**
+		 * Remember the types of tags returned by the site (in listings, details or tag APIs), so that looking
+		 * them up again later doesn't need to query the database. Tags with an unknown type are ignored.
+		 */
+		void cacheTags(const QList<Tag> &tags);
+
+		/**
+		 * Persist the cached tag types in the given file, so that they are still known after a restart.
+		 * Entries that were not seen by the site for a month are not loaded back.
+		 */
+		void setTypeCacheFile(const ReadWritePath &file);
+		bool saveTypeCache();
+
+		/**
+		 * Whether the tag types loaded from the site's tag type API should be refreshed.
+		 */
+		bool tagTypesExpired() const;
+
 	protected:
 		explicit TagDatabase(ReadWritePath typeFile);
+		virtual QMap<QString, TagType> getTagTypesFromDatabase(const QStringList &tags) const = 0;
+		void loadTypeCache();
 
 	protected:
 		TagTypeDatabase m_tagTypeDatabase;
 		bool m_isOpen = false;
+
+	private:
+		struct CachedType
+		{
+			TagType type;
+			qint64 seen; // Seconds since epoch
+		};
+
+		mutable QMutex m_cacheMutex;
+		QCache<QString, CachedType> m_cache;
+		ReadWritePath m_typeCacheFile;
+		int m_unsavedCacheEntries = 0;
 };
 
 #endif // TAG_DATABASE_H
@@ -1,6 +1,36 @@
 #include "tags/tag-name-format.h"
 #include <QStringList>
+#include <QVector>
 #include <utility>
+#include "flyweight-cache.h"
+
+
+struct TagNameFormatKey
+{
+	TagNameFormat from;
+	TagNameFormat to;
+	QString name;
+};
+
+static bool operator==(const TagNameFormatKey &a, const TagNameFormatKey &b)
+{
+	return a.name == b.name && a.from == b.from && a.to == b.to;
+}
+
+static uint qHash(const TagNameFormatKey &key, uint seed = 0)
+{
+	return qHash(key.name, seed) ^ qHash(key.from, seed) ^ (qHash(key.to, seed) << 1);
+}
+
+// Subclass of QString so that the cache can build it from its key, while handles only expose the QString
+struct FormattedTagName : public QString
+{
+	explicit FormattedTagName(const TagNameFormatKey &key)
+		: QString(key.to.isFormatted(key.name, key.from) ? key.name : key.to.formatted(key.name.split(key.from.wordSeparator())))
+	{}
+};
+
+using FormattedTagNameCache = FlyweightCache<TagNameFormatKey, FormattedTagName>;
 
 
 TagNameFormat::TagNameFormat(CaseFormat caseFormat, QString wordSeparator)
@@ -58,7 +88,74 @@ QString TagNameFormat::formatted(const QString &word, int index) const
 	return word;
 }
 
+QString TagNameFormat::formatted(const QString &name, const TagNameFormat &from) const
+{
+	if (isFormatted(name, from)) {
+		return name;
+	}
+	return *interned(name, from);
+}
+
+QSharedPointer<const QString> TagNameFormat::interned(const QString &name, const TagNameFormat &from) const
+{
+	TagNameFormatKey key;
+	key.from = from;
+	key.to = *this;
+	key.name = name;
+	return FormattedTagNameCache::Get(key);
+}
+
+/**
+ * Check the name character by character instead of building the converted name. Non-ASCII characters and empty
+ * words are left to the actual conversion, as their case conversion rules are not that simple.
+ */
+bool TagNameFormat::isFormatted(const QString &name, const TagNameFormat &from) const
+{
+	if (from == *this) {
+		return true;
+	}
+	if (from.m_wordSeparator.isEmpty() || (from.m_wordSeparator != m_wordSeparator && name.contains(from.m_wordSeparator))) {
+		return false;
+	}
+
+	// Unknown case formats keep the words as they are
+	if (m_caseFormat != Lower && m_caseFormat != UpperFirst && m_caseFormat != Upper && m_caseFormat != Caps) {
+		return true;
+	}
+
+	const QVector<QStringRef> words = name.splitRef(from.m_wordSeparator);
+	for (int i = 0; i < words.count(); ++i) {
+		const QStringRef &word = words[i];
+		if (word.isEmpty() && m_caseFormat != Lower && m_caseFormat != Caps) {
+			return false;
+		}
+
+		for (int j = 0; j < word.length(); ++j) {
+			const QChar c = word[j];
+			if (c.unicode() >= 0x80) {
+				return false;
+			}
+
+			const bool upper = m_caseFormat == Caps || (j == 0 && (m_caseFormat == Upper || (m_caseFormat == UpperFirst && i == 0)));
+			if (upper ? c.isLower() : c.isUpper()) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 bool operator==(const TagNameFormat &a, const TagNameFormat &b)
 {
 	return a.caseFormat() == b.caseFormat() && a.wordSeparator() == b.wordSeparator();
 }
+bool operator!=(const TagNameFormat &a, const TagNameFormat &b)
+{
+	return !(a == b);
+}
+
+uint qHash(const TagNameFormat &format, uint seed)
+{
+	return qHash(format.wordSeparator(), seed) ^ uint(format.caseFormat());
+}
@@ -2,6 +2,7 @@
 #define TAG_NAME_FORMAT_H
 
 #include <QMetaType>
+#include <QSharedPointer>
 #include <QString>
 
 
@@ -25,6 +26,23 @@ class TagNameFormat
 		QString wordSeparator() const;
 		QString formatted(const QStringList &words) const;
 
+		/**
+		 * Convert a tag name from another format. Names that are already in this format are returned unchanged,
+		 * without allocating a new string.
+		 */
+		QString formatted(const QString &name, const TagNameFormat &from) const;
+
+		/**
+		 * Same as formatted(), but returning a handle shared by all the conversions of the same name, so that the
+		 * conversion is only done once as long as the handle is kept.
+		 */
+		QSharedPointer<const QString> interned(const QString &name, const TagNameFormat &from) const;
+
+		/**
+		 * Whether converting a tag name from another format would give it back unchanged.
+		 */
+		bool isFormatted(const QString &name, const TagNameFormat &from) const;
+
 	protected:
 		QString formatted(const QString &word, int index) const;
 
@@ -34,6 +52,8 @@ class TagNameFormat
 };
 
 bool operator==(const TagNameFormat &a, const TagNameFormat &b);
+bool operator!=(const TagNameFormat &a, const TagNameFormat &b);
+uint qHash(const TagNameFormat &format, uint seed = 0);
 
 Q_DECLARE_METATYPE(TagNameFormat)
 
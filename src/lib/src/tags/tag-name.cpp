@@ -5,26 +5,22 @@
 TagName::TagName(QString name, TagNameFormat format)
 	: m_name(std::move(name)), m_format(std::move(format))
 {
-	m_normalized = normalized();
+	// Tags with the same name share the same normalized string
+	m_normalized = TagNameFormat::Normalized().interned(m_name, m_format);
 }
 
 
 QString TagName::normalized() const
 {
-	return formatted(TagNameFormat::Normalized());
+	return m_normalized.isNull() ? QString() : *m_normalized;
 }
 
 QString TagName::formatted(const TagNameFormat &format) const
 {
-	if (format == m_format) {
-		return m_name;
+	if (format == TagNameFormat::Normalized() && !m_normalized.isNull()) {
+		return *m_normalized;
 	}
-
-	if (m_words.isEmpty()) {
-		m_words = m_name.split(m_format.wordSeparator());
-	}
-
-	return format.formatted(m_words);
+	return format.formatted(m_name, m_format);
 }
 
 
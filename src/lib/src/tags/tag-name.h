@@ -2,8 +2,8 @@
 #define TAG_NAME_H
 
 #include <QMetaType>
+#include <QSharedPointer>
 #include <QString>
-#include <QStringList>
 #include "tags/tag-name-format.h"
 
 
@@ -16,10 +16,9 @@ class TagName
 		QString formatted(const TagNameFormat &format) const;
 
 	private:
-		QString m_normalized;
+		QSharedPointer<const QString> m_normalized;
 		QString m_name;
 		TagNameFormat m_format;
-		mutable QStringList m_words;
 };
 
 bool operator==(const TagName &a, const TagName &b);
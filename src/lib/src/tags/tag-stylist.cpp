@@ -9,48 +9,88 @@
 #include "models/profile.h"
 #include "tags/tag.h"
 
+#define TAG_CACHE_SIZE 20000
 
-TagStylist::TagStylist(Profile *profile)
-	: m_profile(profile)
-{}
 
-QStringList TagStylist::stylished(QList<Tag> tags, bool count, bool noUnderscores, const QString &sort, bool dark) const
+TagStylist::TagStylist(Profile *profile, QObject *parent)
+	: QObject(parent), m_profile(profile), m_cache(TAG_CACHE_SIZE)
 {
-	// Sort tag list
-	if (sort == QLatin1String("type")) {
-		std::sort(tags.begin(), tags.end(), sortTagsByType);
-	} else if (sort == QLatin1String("name")) {
-		std::sort(tags.begin(), tags.end(), sortTagsByName);
-	} else if (sort == QLatin1String("count")) {
-		std::sort(tags.begin(), tags.end(), sortTagsByCount);
-	}
+	connect(m_profile, &Profile::favoritesChanged, this, &TagStylist::clearCache);
+	connect(m_profile, &Profile::keptForLaterChanged, this, &TagStylist::clearCache);
+	connect(m_profile, &Profile::ignoredChanged, this, &TagStylist::clearCache);
+	connect(m_profile, &Profile::blacklistChanged, this, &TagStylist::clearCache);
+}
 
-	// Generate style map
+void TagStylist::clearCache()
+{
+	m_cache.clear();
+}
+
+QMap<QString, QString> TagStylist::styles(bool dark) const
+{
 	static const QStringList tlist { "artists", "circles", "copyrights", "characters", "species", "metas", "models", "generals", "favorites", "keptForLater", "blacklisteds", "ignoreds", "favorites" };
 	static const QStringList defaults { "#aa0000", "#55bbff", "#aa00aa", "#00aa00", "#ee6600", "#ee6600", "#0000ee", "#000000", "#ffc0cb", "#000000", "#000000", "#999999", "#ffcccc" };
 	static const QStringList defaultsDark { "#ff8888", "#55bbff", "#cc66cc", "#66cc66", "#ee6600", "#ee6600", "#0000ee", "#ffffff", "#ffc0cb", "#ffffff", "#000000", "#999999", "#ffcccc" };
+	static QMap<QString, QString> fontCssCache;
+
 	QMap<QString, QString> styles;
 	for (const QString &key : tlist) {
 		const QString color = m_profile->getSettings()->value("Coloring/Colors/" + key, (dark ? defaultsDark : defaults).at(tlist.indexOf(key))).toString();
 		const QString font = m_profile->getSettings()->value("Coloring/Fonts/" + key).toString();
 
 		QString fontCss;
-		static QMap<QString, QString> fontCssCache;
 		if (fontCssCache.contains(font)) {
 			fontCss = fontCssCache[font];
 		} else {
 			QFont qFont;
-			qFont.fromString(m_profile->getSettings()->value("Coloring/Fonts/" + key).toString());
+			qFont.fromString(font);
 			fontCss = qFontToCss(qFont);
+			fontCssCache.insert(font, fontCss);
 		}
 
 		styles.insert(key, "color:" + color + "; " + fontCss);
 	}
 
+	return styles;
+}
+
+QStringList TagStylist::stylished(QList<Tag> tags, bool count, bool noUnderscores, const QString &sort, bool dark) const
+{
+	// Sort tag list
+	if (sort == QLatin1String("type")) {
+		std::sort(tags.begin(), tags.end(), sortTagsByType);
+	} else if (sort == QLatin1String("name")) {
+		std::sort(tags.begin(), tags.end(), sortTagsByName);
+	} else if (sort == QLatin1String("count")) {
+		std::sort(tags.begin(), tags.end(), sortTagsByCount);
+	}
+
+	// Generate style map, the cached tags being outdated if it changed
+	const QMap<QString, QString> styles = this->styles(dark);
+	QMap<QString, QString> &cacheStyles = dark ? m_cacheStylesDark : m_cacheStyles;
+	if (styles != cacheStyles) {
+		m_cache.clear();
+		cacheStyles = styles;
+	}
+
+	const QString options = QString::number((count ? 1 : 0) | (noUnderscores ? 2 : 0) | (dark ? 4 : 0));
+
 	QStringList t;
 	t.reserve(tags.count());
 	for (const Tag &tag : tags) {
-		t.append(stylished(tag, styles, count, noUnderscores));
+		QString key = options + tag.type().name() + "," + tag.text();
+		if (count) {
+			key += "," + QString::number(tag.count());
+		}
+
+		const QString *cached = m_cache.object(key);
+		if (cached != nullptr) {
+			t.append(*cached);
+		} else {
+			const QString html = stylished(tag, styles, count, noUnderscores);
+			m_cache.insert(key, new QString(html));
+			t.append(html);
+		}
 	}
 
 	return t;
@@ -66,18 +106,14 @@ QString TagStylist::stylished(const Tag &tag, const QMap<QString, QString> &styl
 	if (m_profile->getBlacklist().contains(txt)) {
 		key = "blacklisteds";
 	}
-	if (m_profile->getIgnored().contains(txt, Qt::CaseInsensitive)) {
+	if (m_profile->isIgnored(txt)) {
 		key = "ignoreds";
 	}
-	for (const QString &t : qAsConst(m_profile->getKeptForLater())) {
-		if (t == txt) {
-			key = "keptForLater";
-		}
+	if (m_profile->isKeptForLater(txt)) {
+		key = "keptForLater";
 	}
-	for (const Favorite &fav : qAsConst(m_profile->getFavorites())) {
-		if (fav.getName() == txt) {
-			key = "favorites";
-		}
+	if (m_profile->isFavorite(txt)) {
+		key = "favorites";
 	}
 
 	QString escaped = txt.toHtmlEscaped();
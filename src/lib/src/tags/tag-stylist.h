@@ -1,23 +1,43 @@
 #ifndef TAG_STYLIST_H
 #define TAG_STYLIST_H
 
+#include <QCache>
 #include <QList>
 #include <QMap>
+#include <QObject>
 #include <QString>
 
 
 class Profile;
 class Tag;
 
-class TagStylist
+/**
+ * Generates the HTML of tag lists, colored depending on the tag types and their state in the profile.
+ *
+ * The HTML of each tag is cached, so that rendering the same tags again, or a list only differing by a few tags,
+ * only needs to style the new ones. The cache is cleared when the colors and fonts settings change, or when the
+ * favorites, kept for later, ignored or blacklisted tags of the profile change.
+ */
+class TagStylist : public QObject
 {
+	Q_OBJECT
+
 	public:
-		explicit TagStylist(Profile *profile);
+		explicit TagStylist(Profile *profile, QObject *parent = nullptr);
 		QStringList stylished(QList<Tag> tags, bool count = false, bool noUnderscores = false, const QString &sort = "", bool dark = false) const;
 		QString stylished(const Tag &tag, const QMap<QString, QString> &styles, bool count = false, bool noUnderscores = false) const;
 
+	public slots:
+		void clearCache();
+
+	protected:
+		QMap<QString, QString> styles(bool dark) const;
+
 	private:
 		Profile *m_profile;
+		mutable QMap<QString, QString> m_cacheStyles;
+		mutable QMap<QString, QString> m_cacheStylesDark;
+		mutable QCache<QString, QString> m_cache;
 };
 
 #endif // TAG_STYLIST_H
@@ -1,5 +1,6 @@
 #include "tag-type-database.h"
 #include <QFile>
+#include <QFileInfo>
 #include <QStringList>
 #include <QTextStream>
 #include <QtMath>
@@ -39,6 +40,8 @@ bool TagTypeDatabase::load()
 	}
 	f.close();
 
+	m_lastUpdate = QFileInfo(f).lastModified();
+
 	return true;
 }
 
@@ -78,6 +81,12 @@ void TagTypeDatabase::setAll(const QList<TagTypeWithId> &tagTypes)
 		m_invertedTagTypes.insert(tagType.name, tagType.id);
 	}
 	m_pendingFlush = true;
+	m_lastUpdate = QDateTime::currentDateTime();
+}
+
+QDateTime TagTypeDatabase::lastUpdate() const
+{
+	return m_lastUpdate;
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef TAG_TYPE_DATABASE_H
 #define TAG_TYPE_DATABASE_H
 
+#include <QDateTime>
 #include <QMap>
 #include <QString>
 #include "tags/tag-type.h"
@@ -18,6 +19,11 @@ class TagTypeDatabase
 		const QMap<int, TagType> &getAll() const;
 		void setAll(const QList<TagTypeWithId> &tagTypes);
 
+		/**
+		 * When the types were last set using setAll(), or the modification date of the loaded file.
+		 */
+		QDateTime lastUpdate() const;
+
 		bool contains(int id) const;
 		TagType get(int id) const;
 		int get(const TagType &tagType, bool create = false);
@@ -32,6 +38,7 @@ class TagTypeDatabase
 		QMap<QString, int> m_invertedTagTypes;
 		int m_maxTagTypeId = -1;
 		bool m_pendingFlush = false;
+		QDateTime m_lastUpdate;
 };
 
 #endif // TAG_TYPE_DATABASE_H
@@ -3,37 +3,59 @@
 #include <QJsonObject>
 #include <QStringList>
 #include <utility>
+#include "flyweight-cache.h"
 #include "functions.h"
 #include "tag-type.h"
 
 
-Tag::Tag()
-	: m_id(0), m_type(TagType()), m_count(0)
-{}
+struct TagKey
+{
+	int id;
+	QString text;
+	TagType type;
+	int count;
+};
 
-Tag::Tag(const QString &text, const QString &type, int count, const QStringList &related)
-	: Tag(text, TagType(type), count, related)
-{}
+bool operator==(const TagKey &a, const TagKey &b)
+{
+	return a.id == b.id && a.count == b.count && a.text == b.text && a.type == b.type;
+}
 
-Tag::Tag(const QString &text, const TagType &type, int count, const QStringList &related)
-	: Tag(0, text, type, count, related)
-{}
+uint qHash(const TagKey &key, uint seed = 0)
+{
+	return qHash(key.text, seed) ^ qHash(key.type.name(), seed) ^ uint(key.id) ^ (uint(key.count) << 8);
+}
 
-Tag::Tag(int id, const QString &text, TagType type, int count, QStringList related)
-	: m_id(id), m_type(std::move(type)), m_count(count), m_related(std::move(related))
+struct TagData
+{
+	explicit TagData(const TagKey &key);
+
+	int id;
+	QString text;
+	TagType type;
+	int count;
+	QStringList related;
+};
+
+class TagFactory : public FlyweightCache<TagKey, TagData>
+{};
+
+
+TagData::TagData(const TagKey &key)
+	: id(key.id), type(key.type), count(key.count)
 {
 	static const QStringList weakTypes { QStringLiteral("origin") };
 
 	// Decode HTML entities in the tag text
-	m_text = decodeHtmlEntities(text).replace(' ', '_');
+	text = decodeHtmlEntities(key.text).replace(' ', '_');
 
-	if (m_type.isUnknown() || weakTypes.contains(m_type.name())) {
+	if (type.isUnknown() || weakTypes.contains(type.name())) {
 		// Some artist names end with " (artist)" so we can guess their type
-		if (m_text.endsWith(QLatin1String("(artist)"))) {
-			m_type = TagType(QStringLiteral("artist"));
+		if (text.endsWith(QLatin1String("(artist)"))) {
+			type = TagType(QStringLiteral("artist"));
 		}
 
-		const int sepPos = m_text.indexOf(':');
+		const int sepPos = text.indexOf(':');
 		if (sepPos != -1) {
 			static const QMap<int, QString> prep
 			{
@@ -47,21 +69,55 @@ Tag::Tag(int id, const QString &text, TagType type, int count, QStringList relat
 				{ 7, QStringLiteral("oc") }
 			};
 
-			const QString pre = Tag::GetType(m_text.left(sepPos));
+			const QString pre = Tag::GetType(text.left(sepPos));
 			const int prepIndex = prep.key(pre, -1);
 			if (prepIndex != -1) {
-				m_type = TagType(Tag::GetType(prep[prepIndex], prep));
-				m_text = m_text.mid(sepPos + 1);
+				type = TagType(Tag::GetType(prep[prepIndex], prep));
+				text = text.mid(sepPos + 1);
 			}
 		}
 	}
+}
 
-	// Remove suffixes to turn "name_(artist)" into "name"
-	if (false && m_text.endsWith(QStringLiteral("_(%1)").arg(m_type.name()))) {
-		m_text = m_text.left(m_text.length() - m_type.name().length() - 3);
+
+Tag::Tag()
+{
+	static const QSharedPointer<const TagData> empty(new TagData(TagKey { 0, QString(), TagType(), 0 }));
+	m_d = empty;
+}
+
+Tag::Tag(const QString &text, const QString &type, int count, const QStringList &related)
+	: Tag(text, TagType(type), count, related)
+{}
+
+Tag::Tag(const QString &text, const TagType &type, int count, const QStringList &related)
+	: Tag(0, text, type, count, related)
+{}
+
+Tag::Tag(int id, const QString &text, TagType type, int count, QStringList related)
+{
+	const TagKey key { id, text, std::move(type), count };
+
+	// Related tags are only set by tag APIs and are rarely shared, so such records are not interned
+	if (related.isEmpty()) {
+		m_d = TagFactory::Get(key);
+	} else {
+		auto *d = new TagData(key);
+		d->related = std::move(related);
+		m_d.reset(d);
 	}
 }
 
+/**
+ * Replace the record of this tag by a copy that can be modified without affecting the other handles.
+ */
+TagData *Tag::detach()
+{
+	auto *d = new TagData(*m_d);
+	m_d.reset(d);
+	return d;
+}
+
 QString Tag::GetType(QString type, QMap<int, QString> ids)
 {
 	type = type.toLower().trimmed();
@@ -116,42 +172,43 @@ QString Tag::GetType(QString type, QMap<int, QString> ids)
 
 void Tag::write(QJsonObject &json) const
 {
-	json["text"] = m_text;
+	json["text"] = m_d->text;
 
-	if (m_id > 0) {
-		json["id"] = m_id;
+	if (m_d->id > 0) {
+		json["id"] = m_d->id;
 	}
-	if (!m_type.isUnknown()) {
-		json["type"] = m_type.name();
+	if (!m_d->type.isUnknown()) {
+		json["type"] = m_d->type.name();
 	}
-	if (m_count > 0) {
-		json["count"] = m_count;
+	if (m_d->count > 0) {
+		json["count"] = m_d->count;
 	}
-	if (!m_related.isEmpty()) {
-		json["related"] = QJsonArray::fromStringList(m_related);
+	if (!m_d->related.isEmpty()) {
+		json["related"] = QJsonArray::fromStringList(m_d->related);
 	}
 }
 
 bool Tag::read(const QJsonObject &json)
 {
-	m_text = json["text"].toString();
+	TagData *d = detach();
+	d->text = json["text"].toString();
 
 	if (json.contains("id")) {
-		m_id = json["id"].toInt();
+		d->id = json["id"].toInt();
 	}
 	if (json.contains("type")) {
-		m_type = TagType(json["type"].toString());
+		d->type = TagType(json["type"].toString());
 	}
 	if (json.contains("count")) {
-		m_count = json["count"].toInt();
+		d->count = json["count"].toInt();
 	}
 
 	// Related
 	if (json.contains("related")) {
 		QJsonArray related = json["related"].toArray();
-		m_related.reserve(related.count());
+		d->related.reserve(related.count());
 		for (auto tag : related) {
-			m_related.append(tag.toString());
+			d->related.append(tag.toString());
 		}
 	}
 
@@ -159,17 +216,17 @@ bool Tag::read(const QJsonObject &json)
 }
 
 
-void Tag::setId(int id) { m_id = id; }
-void Tag::setText(const QString &text) { m_text = text; }
-void Tag::setType(const TagType &type) { m_type = type; }
-void Tag::setCount(int count) { m_count = count; }
-void Tag::setRelated(const QStringList &related) { m_related = related; }
+void Tag::setId(int id) { detach()->id = id; }
+void Tag::setText(const QString &text) { detach()->text = text; }
+void Tag::setType(const TagType &type) { detach()->type = type; }
+void Tag::setCount(int count) { detach()->count = count; }
+void Tag::setRelated(const QStringList &related) { detach()->related = related; }
 
-int Tag::id() const { return m_id; }
-const QString &Tag::text() const { return m_text; }
-const TagType &Tag::type() const { return m_type; }
-int Tag::count() const { return m_count; }
-const QStringList &Tag::related() const { return m_related; }
+int Tag::id() const { return m_d->id; }
+const QString &Tag::text() const { return m_d->text; }
+const TagType &Tag::type() const { return m_d->type; }
+int Tag::count() const { return m_d->count; }
+const QStringList &Tag::related() const { return m_d->related; }
 
 bool sortTagsByType(const Tag &s1, const Tag &s2)
 {
@@ -193,6 +250,9 @@ bool sortTagsByCount(const Tag &s1, const Tag &s2)
 
 bool operator==(const Tag &t1, const Tag &t2)
 {
+	if (t1.isSameRecord(t2)) {
+		return true;
+	}
 	return QString::compare(t1.text(), t2.text(), Qt::CaseInsensitive) == 0
 		&& (t1.type() == t2.type() || t1.type().isUnknown() || t2.type().isUnknown());
 }
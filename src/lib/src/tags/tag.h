@@ -3,13 +3,22 @@
 
 #include <QMap>
 #include <QMetaType>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include "tags/tag-type.h"
 
 
 class QJsonObject;
+struct TagData;
 
+/**
+ * Handle to a shared immutable tag record.
+ *
+ * The same tags appear in thousands of images, so records are interned: building a tag with the same text, type,
+ * ID and count as an existing one returns a handle to the same record. Setters only copy the record of the modified
+ * tag, and comparing two handles to the same record does not need to compare their text.
+ */
 class Tag
 {
 	public:
@@ -37,12 +46,16 @@ class Tag
 		int count() const;
 		const QStringList &related() const;
 
+		/**
+		 * Whether both tags are handles to the same record.
+		 */
+		bool isSameRecord(const Tag &other) const { return m_d == other.m_d; }
+
+	protected:
+		TagData *detach();
+
 	private:
-		int m_id;
-		QString m_text;
-		TagType m_type;
-		int m_count;
-		QStringList m_related;
+		QSharedPointer<const TagData> m_d;
 };
 
 bool sortTagsByType(const Tag &, const Tag &);
@@ -1,6 +1,7 @@
 #include "tools/tag-list-loader.h"
 #include <QEventLoop>
 #include <QObject>
+#include <QSettings>
 #include "logger.h"
 #include "models/api/api.h"
 #include "models/profile.h"
@@ -10,6 +11,9 @@
 #include "tags/tag-database.h"
 #include "tags/tag-type-api.h"
 
+#define TAGS_PER_PAGE 500
+#define FLUSH_SIZE 10000
+#define DEFAULT_SIMULTANEOUS 3
 
 TagListLoader::TagListLoader(Profile *profile, Site *site, int minTagCount, QObject *parent)
 	: QObject(parent), m_profile(profile), m_site(site), m_minTagCount(minTagCount)
@@ -23,6 +27,21 @@ bool TagListLoader::canLoadTags(Site *site)
 	return hasApiForTags;
 }
 
+bool TagListLoader::canLoadIncrementally(Site *site)
+{
+	// An interrupted full load must be resumed first
+	if (site->setting("tagLoader/page", 0).toInt() > 0) {
+		return false;
+	}
+
+	return site->setting("tagLoader/lastId", 0).toInt() > 0 && site->tagDatabase()->count() > 0;
+}
+
+void TagListLoader::setIncremental(bool incremental)
+{
+	m_incremental = incremental;
+}
+
 
 QList<Api*> TagListLoader::getApisToLoadTagTypes(Site *site)
 {
@@ -52,14 +71,33 @@ QList<Api*> TagListLoader::getApisToLoadTags(Site *site, bool needTagTypes)
 void TagListLoader::start()
 {
 	m_error.clear();
-	m_results.clear();
 	m_cancelled = false;
+	m_lastPageReached = false;
+	m_firstTag.clear();
+	m_loadedPages.clear();
+	m_pending.clear();
+
+	// Resume the previous load if it was interrupted
+	m_savedPage = 0;
+	m_tagCount = 0;
+	m_lastId = 0;
+	m_maxId = 0;
+	if (m_incremental && canLoadIncrementally(m_site)) {
+		m_lastId = m_site->setting("tagLoader/lastId", 0).toInt();
+	} else {
+		m_incremental = false;
+		if (m_site->setting("tagLoader/minTagCount", -1).toInt() == m_minTagCount) {
+			m_savedPage = m_site->setting("tagLoader/page", 0).toInt();
+			m_tagCount = m_site->setting("tagLoader/count", 0).toInt();
+			m_maxId = m_site->setting("tagLoader/maxId", 0).toInt();
+		}
+	}
 
 	m_needTagTypes = m_site->tagDatabase()->tagTypes().isEmpty();
 	QList<Api*> apisTypes = getApisToLoadTagTypes(m_site);
 
-	// Load tag types first if necessary (and possible)
-	if (m_needTagTypes && !apisTypes.isEmpty()) {
+	// Load tag types first if necessary (and possible), or refresh them if they are too old
+	if ((m_needTagTypes || m_site->tagDatabase()->tagTypesExpired()) && !apisTypes.isEmpty()) {
 		loadTagTypes(apisTypes.first());
 	} else {
 		loadTags();
@@ -78,6 +116,13 @@ void TagListLoader::loadTagTypes(Api *apiTypes)
 
 	auto tagTypes = tagTypeApi->tagTypes();
 	if (tagTypes.isEmpty()) {
+		// Outdated types are still better than none
+		if (!m_needTagTypes) {
+			log(QStringLiteral("[%1] Could not refresh tag types, using the saved ones").arg(m_site->url()), Logger::Warning);
+			loadTags();
+			return;
+		}
+
 		m_error = tr("Error loading tag types.");
 		emit finished();
 		return;
@@ -98,54 +143,160 @@ void TagListLoader::loadTags()
 	QList<Api*> apis = getApisToLoadTags(m_site, m_needTagTypes);
 	m_api = apis.first();
 
-	m_oldCount = -1;
-	m_currentPage = 1;
+	// Tags are now added as they arrive, so a new full load must start from an empty database
+	if (m_incremental) {
+		log(QStringLiteral("[%1] Loading tags created after ID %2").arg(m_site->url()).arg(m_lastId), Logger::Info);
+	} else if (m_savedPage > 0) {
+		log(QStringLiteral("[%1] Resuming tag list loading after page %2 (%3 tags)").arg(m_site->url()).arg(m_savedPage).arg(m_tagCount), Logger::Info);
+	} else {
+		m_site->tagDatabase()->setTags(QList<Tag>());
+	}
+
+	m_processedPage = m_savedPage;
+	m_nextPage = m_savedPage + 1;
+	m_simultaneous = qMax(1, m_profile->getSettings()->value("tag_loader_simultaneous", DEFAULT_SIMULTANEOUS).toInt());
 
-	emit progress("0 - 0");
-	loadNextPage();
+	emit progress(QString("%1 - %2").arg(m_processedPage).arg(m_tagCount));
+	loadNextPages();
 }
 
-void TagListLoader::loadNextPage()
+void TagListLoader::loadNextPages()
 {
-	m_currentTagApi = new TagApi(m_profile, m_site, m_api, m_currentPage, 500, "count", this);
-	connect(m_currentTagApi, &TagApi::finishedLoading, this, &TagListLoader::tagsLoaded);
-	m_currentTagApi->load();
+	// Pages finished out of order are kept until the previous ones arrive, so we don't want to get too far ahead
+	while (!m_lastPageReached && !m_cancelled && m_running.count() < m_simultaneous && m_running.count() + m_loadedPages.count() < 2 * m_simultaneous) {
+		auto *tagApi = new TagApi(m_profile, m_site, m_api, m_nextPage, TAGS_PER_PAGE, m_incremental ? "date" : "count", this);
+		connect(tagApi, &TagApi::finishedLoading, this, &TagListLoader::tagsLoaded);
+		m_running.insert(tagApi, m_nextPage);
+		tagApi->load();
+		m_nextPage++;
+	}
 }
 
-void TagListLoader::tagsLoaded()
+void TagListLoader::tagsLoaded(TagApiBase *api, TagApiBase::LoadResult status)
 {
+	const auto it = m_running.find(api);
+	if (it == m_running.end()) {
+		return;
+	}
+	const int page = it.value();
+	m_running.erase(it);
+	api->deleteLater();
+
 	if (m_cancelled) {
 		return;
 	}
 
-	bool newTag = false;
-	QList<Tag> tags = m_currentTagApi->tags();
-	if (!m_results.isEmpty() && !tags.isEmpty() && tags.first() == m_results.first()) {
-		log(QStringLiteral("Loop detected, stopping here."), Logger::Warning);
+	// Errors are considered to be the end of the list, as many sites return an error past their last page
+	if (status == TagApiBase::LoadResult::Ok) {
+		m_loadedPages.insert(page, static_cast<TagApi*>(api)->tags());
+	} else {
+		log(QStringLiteral("[%1] Error loading tags page %2, stopping here.").arg(m_site->url()).arg(page), Logger::Warning);
+		m_loadedPages.insert(page, QList<Tag>());
+	}
+
+	processPages();
+	if (m_lastPageReached) {
+		finish();
 	} else {
-		for (const auto &tag: tags) {
-			if (tag.count() == 0 || tag.count() >= m_minTagCount) {
-				m_results.append(tag);
-				newTag = true;
+		loadNextPages();
+	}
+}
+
+/**
+ * Handle loaded pages in order, as long as there are no gaps.
+ */
+void TagListLoader::processPages()
+{
+	while (!m_lastPageReached && m_loadedPages.contains(m_processedPage + 1)) {
+		const QList<Tag> tags = m_loadedPages.take(m_processedPage + 1);
+		m_processedPage++;
+
+		bool newTag = false;
+		bool oldTagReached = false;
+		if (!tags.isEmpty() && tags.first().text() == m_firstTag) {
+			log(QStringLiteral("Loop detected, stopping here."), Logger::Warning);
+		} else {
+			if (m_firstTag.isEmpty() && !tags.isEmpty()) {
+				m_firstTag = tags.first().text();
+			}
+			for (const auto &tag: tags) {
+				m_maxId = qMax(m_maxId, tag.id());
+
+				// Incremental loads get the newest tags first, which have barely been used yet, so they are all kept
+				if (m_incremental) {
+					if (tag.id() <= m_lastId) {
+						oldTagReached = true;
+						break;
+					}
+					m_pending.append(tag);
+					newTag = true;
+				} else if (tag.count() == 0 || tag.count() >= m_minTagCount) {
+					m_pending.append(tag);
+					newTag = true;
+				}
 			}
 		}
-	}
 
-	emit progress(QString("%1 - %2").arg(m_currentPage).arg(m_results.count()));
+		emit progress(QString("%1 - %2").arg(m_processedPage).arg(m_tagCount + m_pending.count()));
 
-	m_currentTagApi->deleteLater();
-	m_currentTagApi = nullptr;
+		// As long as we keep finding new tags, we continue loading
+		if (!newTag || oldTagReached) {
+			m_lastPageReached = true;
+		} else if (m_pending.count() >= FLUSH_SIZE) {
+			flush();
+		}
+	}
+}
 
-	// As long as we keep finding new tags, we continue loading
-	if (newTag) {
-		m_currentPage++;
-		loadNextPage();
+/**
+ * Add the tags of the pages handled so far to the database, and remember where we are in case we get interrupted.
+ */
+void TagListLoader::flush()
+{
+	if (m_pending.isEmpty()) {
 		return;
 	}
 
-	// Otherwise, that means we finished
-	m_site->tagDatabase()->setTags(m_results, !m_api->mustLoadTagTypes());
-	m_site->tagDatabase()->save();
+	TagDatabase *database = m_site->tagDatabase();
+	database->addTags(m_pending, !m_api->mustLoadTagTypes());
+	database->save();
+	m_tagCount += m_pending.count();
+	m_pending.clear();
+
+	// Incremental loads are short enough to simply be started again
+	m_savedPage = m_processedPage;
+	if (!m_incremental) {
+		m_site->setSetting("tagLoader/page", m_savedPage, 0);
+		m_site->setSetting("tagLoader/minTagCount", m_minTagCount, -1);
+		m_site->setSetting("tagLoader/count", m_tagCount, 0);
+		m_site->setSetting("tagLoader/maxId", m_maxId, 0);
+		m_site->syncSettings();
+	}
+}
+
+void TagListLoader::stopRunning()
+{
+	for (auto it = m_running.constBegin(); it != m_running.constEnd(); ++it) {
+		disconnect(it.key(), &TagApi::finishedLoading, this, &TagListLoader::tagsLoaded);
+		it.key()->abort();
+		it.key()->deleteLater();
+	}
+	m_running.clear();
+	m_loadedPages.clear();
+}
+
+void TagListLoader::finish()
+{
+	stopRunning();
+	flush();
+
+	// The load is complete, so there is nothing to resume anymore
+	m_site->setSetting("tagLoader/page", 0, 0);
+	m_site->setSetting("tagLoader/minTagCount", -1, -1);
+	m_site->setSetting("tagLoader/count", 0, 0);
+	m_site->setSetting("tagLoader/maxId", 0, 0);
+	m_site->setSetting("tagLoader/lastId", qMax(m_lastId, m_maxId), 0);
+	m_site->syncSettings();
 
 	emit finished();
 }
@@ -153,4 +304,8 @@ void TagListLoader::tagsLoaded()
 void TagListLoader::cancel()
 {
 	m_cancelled = true;
+
+	// Save what was already loaded so that the next load can resume from there
+	stopRunning();
+	flush();
 }
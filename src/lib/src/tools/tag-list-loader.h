@@ -1,8 +1,11 @@
 #ifndef TAG_LIST_LOADER_H
 #define TAG_LIST_LOADER_H
 
-#include <QObject>
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QObject>
+#include "tags/tag-api-base.h"
 
 
 class Api;
@@ -11,6 +14,16 @@ class Site;
 class Tag;
 class TagApi;
 
+/**
+ * Loads the full tag list of a site into its tag database.
+ *
+ * Several pages are loaded at the same time, and their tags are added to the database in order as they arrive,
+ * so that the full list never needs to be kept in memory. The last saved page is remembered in the site settings,
+ * so that an interrupted load can be resumed later instead of starting over.
+ *
+ * Once a full load completed, the highest tag ID seen is remembered, so that the next loads can be incremental: only
+ * tags created since then are fetched and added to the existing database.
+ */
 class TagListLoader : public QObject
 {
 	Q_OBJECT
@@ -18,9 +31,11 @@ class TagListLoader : public QObject
 	public:
 		explicit TagListLoader(Profile *profile, Site *site, int minTagCount = 20, QObject *parent = nullptr);
 		static bool canLoadTags(Site *site);
+		static bool canLoadIncrementally(Site *site);
+		void setIncremental(bool incremental);
 
 		const QString &error() const { return m_error; }
-		const QList<Tag> &results() const { return m_results; }
+		int tagCount() const { return m_tagCount; }
 
 	public slots:
 		void start();
@@ -29,12 +44,16 @@ class TagListLoader : public QObject
 	protected slots:
 		void loadTagTypes(Api *apiTypes);
 		void loadTags();
-		void loadNextPage();
-		void tagsLoaded();
+		void loadNextPages();
+		void tagsLoaded(TagApiBase *api, TagApiBase::LoadResult status);
 
 	protected:
 		static QList<Api*> getApisToLoadTagTypes(Site *site);
 		static QList<Api*> getApisToLoadTags(Site *site, bool needTagTypes);
+		void processPages();
+		void flush();
+		void stopRunning();
+		void finish();
 
 	signals:
 		void progress(const QString &status);
@@ -48,11 +67,20 @@ class TagListLoader : public QObject
 		QString m_error;
 		bool m_cancelled = false;
 		bool m_needTagTypes = false;
-		int m_oldCount = -1;
-		int m_currentPage = 1;
+		bool m_lastPageReached = false;
+		bool m_incremental = false;
+		int m_lastId = 0;
+		int m_maxId = 0;
+		int m_simultaneous = 1;
+		int m_nextPage = 1;
+		int m_processedPage = 0;
+		int m_savedPage = 0;
+		int m_tagCount = 0;
+		QString m_firstTag;
 		Api *m_api = nullptr;
-		TagApi *m_currentTagApi = nullptr;
-		QList<Tag> m_results;
+		QHash<TagApiBase*, int> m_running;
+		QMap<int, QList<Tag>> m_loadedPages;
+		QList<Tag> m_pending;
 };
 
 #endif // TAG_LIST_LOADER_H
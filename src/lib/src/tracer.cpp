@@ -0,0 +1,183 @@
+#include "tracer.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+#include <utility>
+#include "logger.h"
+
+
+/**
+ * It is never deleted, as events can be recorded until the very end of the application.
+ */
+Tracer &Tracer::getInstance()
+{
+	static auto *instance = new Tracer();
+	return *instance;
+}
+
+void Tracer::start(const QString &path, int maxEvents)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_path = path;
+	m_maxEvents = maxEvents;
+	m_dropped = 0;
+	m_events.clear();
+	m_timer.start();
+	m_enabled.storeRelease(1);
+
+	log(QStringLiteral("Tracing enabled, events will be written to `%1`").arg(path), Logger::Info);
+}
+
+bool Tracer::stop()
+{
+	if (!m_enabled.testAndSetOrdered(1, 0)) {
+		return false;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	QJsonArray events;
+
+	// Name threads so that they are easier to identify in the timeline
+	for (auto it = m_threadNames.constBegin(); it != m_threadNames.constEnd(); ++it) {
+		events.append(QJsonObject {
+			{ "name", "thread_name" },
+			{ "ph", "M" },
+			{ "pid", 1 },
+			{ "tid", it.key() },
+			{ "args", QJsonObject { { "name", it.value() } } },
+		});
+	}
+
+	for (const Event &event : qAsConst(m_events)) {
+		QJsonObject obj {
+			{ "name", event.name },
+			{ "cat", event.category },
+			{ "ph", QString(QChar(event.phase)) },
+			{ "ts", event.timestamp },
+			{ "pid", 1 },
+			{ "tid", event.thread },
+		};
+		if (event.phase == 'X') {
+			obj.insert("dur", event.duration);
+		} else {
+			obj.insert("id", QString::number(event.id, 16));
+		}
+		if (!event.args.isEmpty()) {
+			obj.insert("args", QJsonObject::fromVariantMap(event.args));
+		}
+		events.append(obj);
+	}
+	m_events.clear();
+
+	QJsonObject root { { "traceEvents", events } };
+	if (m_dropped > 0) {
+		root.insert("otherData", QJsonObject { { "droppedEvents", m_dropped } });
+	}
+
+	QFile file(m_path);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+		log(QStringLiteral("Could not write trace file `%1`: %2").arg(m_path, file.errorString()), Logger::Warning);
+		return false;
+	}
+	file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+	log(QStringLiteral("Trace written to `%1`").arg(m_path), Logger::Info);
+	return true;
+}
+
+qint64 Tracer::now() const
+{
+	return m_timer.isValid() ? m_timer.nsecsElapsed() / 1000 : 0;
+}
+
+
+/**
+ * Must be called with the mutex locked.
+ */
+int Tracer::currentThread()
+{
+	const auto key = reinterpret_cast<quintptr>(QThread::currentThreadId());
+	auto it = m_threads.constFind(key);
+	if (it != m_threads.constEnd()) {
+		return it.value();
+	}
+
+	const int id = m_threads.count() + 1;
+	m_threads.insert(key, id);
+
+	const QString name = QThread::currentThread()->objectName();
+	m_threadNames.insert(id, name.isEmpty() ? QStringLiteral("Thread %1").arg(id) : name);
+
+	return id;
+}
+
+void Tracer::add(Event event)
+{
+	QMutexLocker locker(&m_mutex);
+	if (!isEnabled()) {
+		return;
+	}
+	if (m_events.count() >= m_maxEvents) {
+		m_dropped++;
+		return;
+	}
+
+	event.thread = currentThread();
+	m_events.append(std::move(event));
+}
+
+void Tracer::complete(const QString &name, const QString &category, qint64 start, qint64 duration, const QVariantMap &args)
+{
+	if (!isEnabled()) {
+		return;
+	}
+	add(Event { name, category, 'X', start, duration, 0, 0, args });
+}
+
+void Tracer::asyncBegin(const QString &name, const QString &category, quintptr id, const QVariantMap &args)
+{
+	if (!isEnabled()) {
+		return;
+	}
+	add(Event { name, category, 'b', now(), 0, id, 0, args });
+}
+
+void Tracer::asyncEnd(const QString &name, const QString &category, quintptr id, const QVariantMap &args)
+{
+	if (!isEnabled()) {
+		return;
+	}
+	add(Event { name, category, 'e', now(), 0, id, 0, args });
+}
+
+
+TraceSpan::TraceSpan(const QString &name, const QString &category, QVariantMap args)
+	: m_start(-1)
+{
+	if (Tracer::getInstance().isEnabled()) {
+		m_name = name;
+		m_category = category;
+		m_args = std::move(args);
+		m_start = Tracer::getInstance().now();
+	}
+}
+
+TraceSpan::~TraceSpan()
+{
+	if (m_start >= 0) {
+		Tracer &tracer = Tracer::getInstance();
+		tracer.complete(m_name, m_category, m_start, tracer.now() - m_start, m_args);
+	}
+}
+
+void TraceSpan::setArg(const QString &key, const QVariant &value)
+{
+	if (m_start >= 0) {
+		m_args.insert(key, value);
+	}
+}
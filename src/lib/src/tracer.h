@@ -0,0 +1,90 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+
+/**
+ * Opt-in recorder of trace events, written in the Chrome trace JSON format so that they can be opened in
+ * chrome://tracing or Perfetto to see on a timeline which stages of the loading and downloading are slow.
+ *
+ * When tracing is disabled, recording an event is only an atomic read. Events are kept in memory until tracing
+ * is stopped, up to a maximum count to keep memory usage in check during long sessions.
+ */
+class Tracer
+{
+	public:
+		Tracer() = default;
+		static Tracer &getInstance();
+
+		bool isEnabled() const { return m_enabled.loadAcquire() != 0; }
+		void start(const QString &path, int maxEvents = 1000000);
+
+		/**
+		 * Stop tracing and write all the recorded events to the trace file.
+		 */
+		bool stop();
+
+		/**
+		 * The current timestamp of the trace, in microseconds.
+		 */
+		qint64 now() const;
+
+		// Events
+		void complete(const QString &name, const QString &category, qint64 start, qint64 duration, const QVariantMap &args = QVariantMap());
+		void asyncBegin(const QString &name, const QString &category, quintptr id, const QVariantMap &args = QVariantMap());
+		void asyncEnd(const QString &name, const QString &category, quintptr id, const QVariantMap &args = QVariantMap());
+
+	protected:
+		struct Event
+		{
+			QString name;
+			QString category;
+			char phase;
+			qint64 timestamp;
+			qint64 duration;
+			quintptr id;
+			int thread;
+			QVariantMap args;
+		};
+
+		void add(Event event);
+		int currentThread();
+
+	private:
+		QAtomicInt m_enabled;
+		QElapsedTimer m_timer;
+		QString m_path;
+		int m_maxEvents = 0;
+		int m_dropped = 0;
+		QMutex m_mutex;
+		QVector<Event> m_events;
+		QHash<quintptr, int> m_threads;
+		QHash<int, QString> m_threadNames;
+};
+
+
+/**
+ * Trace the time spent in a scope, if tracing is enabled.
+ */
+class TraceSpan
+{
+	public:
+		TraceSpan(const QString &name, const QString &category, QVariantMap args = QVariantMap());
+		~TraceSpan();
+		void setArg(const QString &key, const QVariant &value);
+
+	private:
+		QString m_name;
+		QString m_category;
+		QVariantMap m_args;
+		qint64 m_start;
+};
+
+#endif // TRACER_H
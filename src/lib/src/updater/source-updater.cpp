@@ -1,24 +1,42 @@
 #include "updater/source-updater.h"
-#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
 #include <QNetworkRequest>
 #include <utility>
+#include "logger.h"
+#include "models/source.h"
+#include "network/network-disk-cache.h"
 #include "network/network-manager.h"
 #include "network/network-reply.h"
 
 
-SourceUpdater::SourceUpdater(QString source, ReadWritePath directory, QString baseUrl)
-	: m_source(std::move(source)), m_directory(std::move(directory)), m_baseUrl(std::move(baseUrl))
+SourceUpdater::SourceUpdater(QList<Source*> sources, QString cacheDirectory, QString manifestUrl)
+	: m_sources(std::move(sources)), m_manifestUrl(std::move(manifestUrl))
 {
-	if (!m_baseUrl.endsWith("/")) {
-		m_baseUrl += "/";
+	if (!cacheDirectory.isEmpty() && m_networkAccessManager->cache() == nullptr) {
+		auto *diskCache = new NetworkDiskCache();
+		diskCache->setCacheDirectory(cacheDirectory);
+		m_networkAccessManager->setCache(diskCache);
 	}
 }
 
+QString SourceUpdater::defaultManifestUrl()
+{
+	#if defined NIGHTLY || defined QT_DEBUG
+		return QStringLiteral("https://github.com/Bionus/imgbrd-grabber/releases/download/sources-develop/sources.json");
+	#else
+		return QStringLiteral("https://github.com/Bionus/imgbrd-grabber/releases/download/sources-master/sources.json");
+	#endif
+}
+
 
 void SourceUpdater::checkForUpdates() const
 {
-	const QUrl url(m_baseUrl + m_source + "/model.xml");
-	const QNetworkRequest request(url);
+	QNetworkRequest request(QUrl(m_manifestUrl));
+	request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+	request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork);
 
 	auto *reply = m_networkAccessManager->get(request);
 	connect(reply, &NetworkReply::finished, this, &SourceUpdater::checkForUpdatesDone);
@@ -26,27 +44,26 @@ void SourceUpdater::checkForUpdates() const
 
 void SourceUpdater::checkForUpdatesDone()
 {
-	auto *reply = dynamic_cast<NetworkReply*>(sender());
-	bool isNew = false;
-
-	// TODO(Bionus): source check for updates is broken since switch to JS model files
-	const QString source = reply->readAll();
-	isNew = source.contains("Not the same");
-	/*if (source.startsWith("<?xml")) {
-		QFile current(m_directory + "/model.xml");
-		if (current.open(QFile::ReadOnly)) {
-			QString compare = current.readAll();
-			current.close();
-
-			compare.replace("\r\n", "\n");
-			source.replace("\r\n", "\n");
-
-			if (compare != source) {
-				isNew = true;
-			}
-		}
-	}*/
-
-	emit finished(m_source, isNew);
+	auto *reply = qobject_cast<NetworkReply*>(sender());
 	reply->deleteLater();
+
+	if (reply->error() != NetworkReply::NetworkError::NoError) {
+		log(QStringLiteral("Error loading the sources manifest (%1)").arg(reply->errorString()), Logger::Warning);
+		return;
+	}
+
+	// Get the hash of all sources in the manifest
+	const QJsonArray sources = QJsonDocument::fromJson(reply->readAll()).object()["sources"].toArray();
+	QMap<QString, QString> hashes;
+	for (const auto &source : sources) {
+		const QJsonObject sourceObj = source.toObject();
+		hashes.insert(sourceObj["name"].toString(), sourceObj["hash"].toString());
+	}
+
+	// Sources not in the manifest (i.e. custom ones) can't be updated
+	for (Source *source : qAsConst(m_sources)) {
+		const QString hash = hashes.value(source->getName());
+		const bool isNew = !hash.isEmpty() && !source->getModelHash().isEmpty() && hash != source->getModelHash();
+		emit finished(source->getName(), isNew);
+	}
 }
@@ -1,17 +1,27 @@
 #ifndef SOURCE_UPDATER_H
 #define SOURCE_UPDATER_H
 
+#include <QList>
 #include <QString>
 #include "updater/updater.h"
-#include "utils/read-write-path.h"
 
 
+class Source;
+
+/**
+ * Checks if updates are available for a list of sources.
+ *
+ * A single manifest listing the hashes of all sources' models (i.e. a source registry's JSON) is loaded, and
+ * compared against the hashes of the local models, so no model ever needs to be downloaded. The manifest is kept in a
+ * disk cache, so that later checks revalidate it using its ETag instead of downloading it again when unchanged.
+ */
 class SourceUpdater : public Updater
 {
 	Q_OBJECT
 
 	public:
-		SourceUpdater(QString source, ReadWritePath directory, QString baseUrl);
+		explicit SourceUpdater(QList<Source*> sources, QString cacheDirectory = QString(), QString manifestUrl = defaultManifestUrl());
+		static QString defaultManifestUrl();
 
 	public slots:
 		void checkForUpdates() const override;
@@ -23,9 +33,8 @@ class SourceUpdater : public Updater
 		void finished(const QString &source, bool isNew);
 
 	private:
-		QString m_source;
-		ReadWritePath m_directory;
-		QString m_baseUrl;
+		QList<Source*> m_sources;
+		QString m_manifestUrl;
 };
 
 #endif // SOURCE_UPDATER_H
@@ -0,0 +1,239 @@
+#include "utils/animation-decoder.h"
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+
+AnimationDecoder::AnimationDecoder(int cacheSize, QObject *parent)
+	: QObject(parent), m_cacheSize(qMax(1, cacheSize))
+{
+	// Frames can only be decoded one after the other anyway
+	m_pool.setMaxThreadCount(1);
+}
+
+AnimationDecoder::~AnimationDecoder()
+{
+	close();
+	m_pool.waitForDone();
+	delete m_reader;
+}
+
+
+bool AnimationDecoder::open(const QString &path, const QSize &maxSize)
+{
+	close();
+
+	// Only the header is read here, the frames being decoded in the background
+	QImageReader reader(path);
+	if (!reader.canRead()) {
+		return false;
+	}
+
+	const QSize size = reader.size();
+	QSize scaledSize = size;
+	if (size.isValid() && !maxSize.isEmpty() && (size.width() > maxSize.width() || size.height() > maxSize.height())) {
+		scaledSize = size.scaled(maxSize, Qt::KeepAspectRatio);
+	}
+
+	QMutexLocker locker(&m_mutex);
+	m_path = path;
+	m_size = size;
+	m_scaledSize = scaledSize;
+	m_frameCount = qMax(0, reader.imageCount());
+	m_loopCount = reader.loopCount();
+	m_reset = true;
+	m_seekTo = -1;
+	m_atEnd = false;
+	locker.unlock();
+
+	schedule();
+	return true;
+}
+
+void AnimationDecoder::close()
+{
+	QMutexLocker locker(&m_mutex);
+	m_path.clear();
+	m_frames.clear();
+	m_generation++;
+	m_atEnd = false;
+}
+
+
+QSize AnimationDecoder::size() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_size;
+}
+
+QSize AnimationDecoder::scaledSize() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_scaledSize;
+}
+
+int AnimationDecoder::frameCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_frameCount;
+}
+
+int AnimationDecoder::loopCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_loopCount;
+}
+
+bool AnimationDecoder::hasFrame() const
+{
+	QMutexLocker locker(&m_mutex);
+	return !m_frames.isEmpty();
+}
+
+int AnimationDecoder::cachedCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_frames.count();
+}
+
+bool AnimationDecoder::atEnd() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_atEnd && m_frames.isEmpty();
+}
+
+
+AnimationDecoder::Frame AnimationDecoder::takeFrame()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_frames.isEmpty()) {
+		return Frame();
+	}
+	const Frame frame = m_frames.dequeue();
+	locker.unlock();
+
+	// Decode the next frames while this one is displayed
+	schedule();
+	return frame;
+}
+
+void AnimationDecoder::seek(int frame)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_path.isEmpty()) {
+		return;
+	}
+	m_frames.clear();
+	m_generation++;
+	m_seekTo = qMax(0, frame);
+	m_atEnd = false;
+	locker.unlock();
+
+	schedule();
+}
+
+
+void AnimationDecoder::schedule()
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_decoding || m_path.isEmpty() || m_atEnd || m_frames.count() >= m_cacheSize) {
+		return;
+	}
+	m_decoding = true;
+	locker.unlock();
+
+	QtConcurrent::run(&m_pool, [this]() {
+		decodeAhead();
+	});
+}
+
+/**
+ * Fill the cache of decoded frames, in the decoding thread.
+ */
+void AnimationDecoder::decodeAhead()
+{
+	forever {
+		QMutexLocker locker(&m_mutex);
+		if (m_path.isEmpty() || m_atEnd || m_frames.count() >= m_cacheSize) {
+			m_decoding = false;
+			return;
+		}
+		const int generation = m_generation;
+		const QString path = m_path;
+		const QSize scaledSize = m_scaledSize != m_size ? m_scaledSize : QSize();
+		const int loopCount = m_loopCount;
+		const bool reset = m_reset;
+		const int seekTo = m_seekTo;
+		m_reset = false;
+		m_seekTo = -1;
+		locker.unlock();
+
+		// Most formats can only be decoded from their beginning
+		if (reset || m_reader == nullptr || (seekTo >= 0 && seekTo < m_readerFrame)) {
+			delete m_reader;
+			m_reader = new QImageReader(path);
+			if (scaledSize.isValid()) {
+				m_reader->setScaledSize(scaledSize);
+			}
+			m_readerFrame = 0;
+			if (reset) {
+				m_loops = 0;
+			}
+		}
+
+		// Frames usually depend on the previous ones, so they need to be decoded even when skipped
+		while (seekTo > m_readerFrame && !m_reader->read().isNull()) {
+			m_readerFrame++;
+		}
+
+		Frame frame;
+		frame.image = m_reader->read();
+		frame.delay = m_reader->nextImageDelay();
+		frame.number = m_readerFrame;
+
+		if (frame.image.isNull()) {
+			locker.relock();
+			if (generation != m_generation) {
+				continue;
+			}
+
+			// Not even a single frame could be decoded
+			if (m_readerFrame == 0) {
+				const QString message = m_reader->errorString();
+				m_atEnd = true;
+				m_decoding = false;
+				locker.unlock();
+
+				QMetaObject::invokeMethod(this, [this, message]() {
+					emit error(message);
+				}, Qt::QueuedConnection);
+				return;
+			}
+
+			// End of the animation, start over as long as it loops
+			m_loops++;
+			if (loopCount >= 0 && m_loops > loopCount) {
+				m_atEnd = true;
+			} else {
+				delete m_reader;
+				m_reader = nullptr;
+			}
+			continue;
+		}
+		m_readerFrame++;
+
+		locker.relock();
+		if (generation != m_generation) {
+			continue;
+		}
+		const bool wasEmpty = m_frames.isEmpty();
+		m_frames.enqueue(frame);
+		locker.unlock();
+
+		if (wasEmpty) {
+			QMetaObject::invokeMethod(this, [this]() {
+				emit frameReady();
+			}, Qt::QueuedConnection);
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef ANIMATION_DECODER_H
+#define ANIMATION_DECODER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+
+class QImageReader;
+
+/**
+ * Decodes the frames of an animated image (GIF, APNG, animated WebP...) on demand, straight from its file.
+ *
+ * Only a few frames ahead of the one being displayed are kept in memory, decoded in the background at the size they
+ * will be displayed at. This way, memory usage doesn't depend on the size of the file nor on its number of frames,
+ * and playback can start as soon as the first frame is decoded.
+ */
+class AnimationDecoder : public QObject
+{
+	Q_OBJECT
+
+	public:
+		struct Frame
+		{
+			QImage image;
+			int delay = 0; // In milliseconds
+			int number = -1;
+		};
+
+		explicit AnimationDecoder(int cacheSize = 8, QObject *parent = nullptr);
+		~AnimationDecoder() override;
+
+		/**
+		 * Start decoding a file, its frames being downscaled to fit in the given size if they are bigger.
+		 */
+		bool open(const QString &path, const QSize &maxSize = {});
+		void close();
+
+		QSize size() const; // Before scaling
+		QSize scaledSize() const;
+		int frameCount() const; // 0 if unknown
+		int loopCount() const; // -1 if the animation loops forever
+
+		bool hasFrame() const;
+		int cachedCount() const;
+		bool atEnd() const;
+
+		/**
+		 * Get the next decoded frame, or an invalid frame if it is not decoded yet.
+		 */
+		Frame takeFrame();
+
+		/**
+		 * Restart decoding from the given frame. Going back restarts from the beginning of the file, as most formats
+		 * can only be decoded in order.
+		 */
+		void seek(int frame);
+
+	signals:
+		/**
+		 * Emitted when a frame becomes available while none was.
+		 */
+		void frameReady();
+		void error(const QString &message);
+
+	protected:
+		void schedule();
+		void decodeAhead();
+
+	private:
+		int m_cacheSize;
+		QThreadPool m_pool;
+		QSize m_size;
+		QSize m_scaledSize;
+		int m_frameCount = 0;
+		int m_loopCount = -1;
+
+		mutable QMutex m_mutex;
+		QString m_path;
+		QQueue<Frame> m_frames;
+		int m_generation = 0;
+		int m_seekTo = -1;
+		bool m_reset = false;
+		bool m_decoding = false;
+		bool m_atEnd = false;
+
+		// Only used by the decoding thread
+		QImageReader *m_reader = nullptr;
+		int m_readerFrame = 0;
+		int m_loops = 0;
+};
+
+#endif // ANIMATION_DECODER_H
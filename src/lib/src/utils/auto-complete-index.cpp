@@ -0,0 +1,209 @@
+#include "utils/auto-complete-index.h"
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+
+static bool entryLessThan(const QString &aKey, const QString &aWord, const QString &bKey, const QString &bWord)
+{
+	const int cmp = aKey.compare(bKey);
+	return cmp < 0 || (cmp == 0 && aWord < bWord);
+}
+
+
+int AutoCompleteIndex::count() const
+{
+	build();
+	return m_entries.count();
+}
+
+void AutoCompleteIndex::clear()
+{
+	m_entries.clear();
+	m_tree.clear();
+	m_dirty = false;
+}
+
+AutoCompleteIndex::Entry AutoCompleteIndex::makeEntry(const QString &word, int popularity)
+{
+	// Most tags are already lowercase, in which case the key simply shares the word's data
+	const QString key = word.toLower();
+	return Entry { key == word ? word : key, word, popularity };
+}
+
+void AutoCompleteIndex::add(const QString &word, int popularity)
+{
+	Entry entry = makeEntry(word, popularity);
+
+	// No need to keep the index sorted if it's going to be sorted again anyway
+	if (m_dirty) {
+		m_entries.append(entry);
+		return;
+	}
+
+	const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry, [](const Entry &a, const Entry &b) {
+		return entryLessThan(a.key, a.word, b.key, b.word);
+	});
+	if (it != m_entries.end() && it->word == word) {
+		if (popularity > it->popularity) {
+			it->popularity = popularity;
+			updateTree(static_cast<int>(it - m_entries.begin()));
+		}
+		return;
+	}
+
+	m_entries.insert(it, entry);
+	buildTree();
+}
+
+void AutoCompleteIndex::add(const QStringList &words, int popularity)
+{
+	if (words.isEmpty()) {
+		return;
+	}
+
+	m_entries.reserve(m_entries.count() + words.count());
+	for (const QString &word : words) {
+		m_entries.append(makeEntry(word, popularity));
+	}
+	m_dirty = true;
+}
+
+void AutoCompleteIndex::build() const
+{
+	if (!m_dirty) {
+		return;
+	}
+
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+		return entryLessThan(a.key, a.word, b.key, b.word);
+	});
+
+	// Remove duplicates, keeping the highest popularity
+	int count = 0;
+	for (int i = 0; i < m_entries.count(); ++i) {
+		if (count > 0 && m_entries[count - 1].word == m_entries[i].word) {
+			m_entries[count - 1].popularity = qMax(m_entries[count - 1].popularity, m_entries[i].popularity);
+		} else {
+			if (count != i) {
+				m_entries[count] = m_entries[i];
+			}
+			count++;
+		}
+	}
+	m_entries.resize(count);
+	m_entries.squeeze();
+
+	buildTree();
+	m_dirty = false;
+}
+
+/**
+ * Return the index of the most popular entry between the two, or the first one alphabetically if they are equal.
+ */
+int AutoCompleteIndex::best(int a, int b) const
+{
+	if (a < 0 || b < 0) {
+		return a < 0 ? b : a;
+	}
+
+	const int popA = m_entries[a].popularity;
+	const int popB = m_entries[b].popularity;
+	if (popA != popB) {
+		return popA > popB ? a : b;
+	}
+	return qMin(a, b);
+}
+
+/**
+ * Build the segment tree, the leaves being the entries themselves and each node the best entry of its two children.
+ */
+void AutoCompleteIndex::buildTree() const
+{
+	const int n = m_entries.count();
+	m_tree.resize(2 * n);
+	for (int i = 0; i < n; ++i) {
+		m_tree[n + i] = i;
+	}
+	for (int i = n - 1; i > 0; --i) {
+		m_tree[i] = best(m_tree[2 * i], m_tree[2 * i + 1]);
+	}
+}
+
+void AutoCompleteIndex::updateTree(int index) const
+{
+	for (int pos = (index + m_entries.count()) / 2; pos > 0; pos /= 2) {
+		m_tree[pos] = best(m_tree[2 * pos], m_tree[2 * pos + 1]);
+	}
+}
+
+/**
+ * Get the index of the best entry in the range [from, to).
+ */
+int AutoCompleteIndex::rangeBest(int from, int to) const
+{
+	const int n = m_entries.count();
+	int ret = -1;
+	for (from += n, to += n; from < to; from /= 2, to /= 2) {
+		if (from & 1) {
+			ret = best(ret, m_tree[from++]);
+		}
+		if (to & 1) {
+			ret = best(ret, m_tree[--to]);
+		}
+	}
+	return ret;
+}
+
+QStringList AutoCompleteIndex::complete(const QString &prefix, int limit) const
+{
+	build();
+
+	QStringList ret;
+	if (limit <= 0 || m_entries.isEmpty()) {
+		return ret;
+	}
+
+	// Find the range of entries starting with the prefix
+	const QString key = prefix.toLower();
+	const auto first = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), key, [](const Entry &entry, const QString &k) {
+		return entry.key < k;
+	});
+	const auto last = std::upper_bound(first, m_entries.constEnd(), key, [](const QString &k, const Entry &entry) {
+		return k.compare(entry.key.leftRef(k.length())) < 0;
+	});
+	const int from = static_cast<int>(first - m_entries.constBegin());
+	const int to = static_cast<int>(last - m_entries.constBegin());
+	if (from >= to) {
+		return ret;
+	}
+
+	// Each time the best entry of a range is taken, the two remaining halves become candidates for the next one
+	struct Range
+	{
+		int best;
+		int from;
+		int to;
+	};
+	const auto worse = [this](const Range &a, const Range &b) {
+		return best(a.best, b.best) == b.best;
+	};
+	std::priority_queue<Range, std::vector<Range>, decltype(worse)> queue(worse);
+	queue.push(Range { rangeBest(from, to), from, to });
+
+	ret.reserve(qMin(limit, to - from));
+	while (!queue.empty() && ret.count() < limit) {
+		const Range range = queue.top();
+		queue.pop();
+		ret.append(m_entries[range.best].word);
+
+		if (range.from < range.best) {
+			queue.push(Range { rangeBest(range.from, range.best), range.from, range.best });
+		}
+		if (range.best + 1 < range.to) {
+			queue.push(Range { rangeBest(range.best + 1, range.to), range.best + 1, range.to });
+		}
+	}
+
+	return ret;
+}
@@ -0,0 +1,58 @@
+#ifndef AUTO_COMPLETE_INDEX_H
+#define AUTO_COMPLETE_INDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * Index of auto-completion words, returning the most popular ones starting with a given prefix.
+ *
+ * Words are kept sorted case-insensitively, so that all the words matching a prefix are a contiguous range, and a
+ * segment tree gives the most popular word of any range. Getting the top suggestions is then O(limit * log(n)),
+ * however many words match the prefix. Words with the same popularity are returned in alphabetical order.
+ */
+class AutoCompleteIndex
+{
+	public:
+		int count() const;
+		void clear();
+
+		/**
+		 * Add a word to the index, or raise its popularity if it is already in it.
+		 */
+		void add(const QString &word, int popularity = 0);
+
+		/**
+		 * Add many words at once, the index only being sorted again on the next completion.
+		 */
+		void add(const QStringList &words, int popularity = 0);
+
+		/**
+		 * Get the most popular words starting with the given prefix (ignoring case), by decreasing popularity.
+		 */
+		QStringList complete(const QString &prefix, int limit) const;
+
+	protected:
+		struct Entry
+		{
+			QString key;
+			QString word;
+			int popularity;
+		};
+
+		static Entry makeEntry(const QString &word, int popularity);
+		void build() const;
+		void buildTree() const;
+		void updateTree(int index) const;
+		int best(int a, int b) const;
+		int rangeBest(int from, int to) const;
+
+	private:
+		mutable QVector<Entry> m_entries;
+		mutable QVector<int> m_tree;
+		mutable bool m_dirty = false;
+};
+
+#endif // AUTO_COMPLETE_INDEX_H
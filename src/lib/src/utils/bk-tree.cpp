@@ -0,0 +1,122 @@
+#include "utils/bk-tree.h"
+#include <algorithm>
+#include "functions.h"
+
+
+int BkTree::count() const
+{
+	return m_nodes.count();
+}
+
+void BkTree::clear()
+{
+	m_nodes.clear();
+}
+
+void BkTree::add(const QString &word)
+{
+	if (m_nodes.isEmpty()) {
+		m_nodes.append(Node { word, {} });
+		return;
+	}
+
+	int node = 0;
+	for (;;) {
+		const int distance = levenshtein(word, m_nodes[node].word);
+		if (distance == 0) {
+			return;
+		}
+
+		int next = -1;
+		for (const auto &child : qAsConst(m_nodes[node].children)) {
+			if (child.first == distance) {
+				next = child.second;
+				break;
+			}
+		}
+
+		if (next < 0) {
+			m_nodes[node].children.append(qMakePair(distance, m_nodes.count()));
+			m_nodes.append(Node { word, {} });
+			return;
+		}
+		node = next;
+	}
+}
+
+void BkTree::add(const QStringList &words)
+{
+	m_nodes.reserve(m_nodes.count() + words.count());
+	for (const QString &word : words) {
+		add(word);
+	}
+}
+
+QStringList BkTree::find(const QString &word, int maxDistance) const
+{
+	QVector<int> found;
+	if (m_nodes.isEmpty() || maxDistance < 0) {
+		return {};
+	}
+
+	QVector<int> stack { 0 };
+	while (!stack.isEmpty()) {
+		const int index = stack.takeLast();
+		const Node &node = m_nodes[index];
+		const int distance = levenshtein(word, node.word);
+		if (distance <= maxDistance) {
+			found.append(index);
+		}
+
+		for (const auto &child : node.children) {
+			if (qAbs(child.first - distance) <= maxDistance) {
+				stack.append(child.second);
+			}
+		}
+	}
+
+	// Nodes are stored in insertion order
+	std::sort(found.begin(), found.end());
+	QStringList ret;
+	ret.reserve(found.count());
+	for (int index : qAsConst(found)) {
+		ret.append(m_nodes[index].word);
+	}
+	return ret;
+}
+
+QString BkTree::closest(const QString &word, int maxDistance, int *distance) const
+{
+	int best = -1;
+	int bestDistance = maxDistance + 1;
+	if (m_nodes.isEmpty() || maxDistance < 0) {
+		return {};
+	}
+
+	QVector<int> stack { 0 };
+	while (!stack.isEmpty()) {
+		const int index = stack.takeLast();
+		const Node &node = m_nodes[index];
+		const int d = levenshtein(word, node.word);
+		if (d < bestDistance || (d == bestDistance && index < best)) {
+			best = index;
+			bestDistance = d;
+		}
+
+		// Once a word was found, only words at the same distance or closer are still of interest
+		const int radius = best < 0 ? maxDistance : bestDistance;
+		for (const auto &child : node.children) {
+			if (qAbs(child.first - d) <= radius) {
+				stack.append(child.second);
+			}
+		}
+	}
+
+	if (best < 0) {
+		return {};
+	}
+	if (distance != nullptr) {
+		*distance = bestDistance;
+	}
+	return m_nodes[best].word;
+}
@@ -0,0 +1,51 @@
+#ifndef BK_TREE_H
+#define BK_TREE_H
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * BK-tree of words, to find the words close to a given one in Levenshtein distance.
+ *
+ * Each child of a node is stored with its distance to it, so thanks to the triangle inequality, looking for words
+ * at most k away from the query only needs to visit the children whose distance is within k of the node's own
+ * distance to the query. For small values of k, this only visits a small part of the tree.
+ */
+class BkTree
+{
+	public:
+		int count() const;
+		void clear();
+
+		/**
+		 * Add a word to the tree, doing nothing if it is already in it.
+		 */
+		void add(const QString &word);
+		void add(const QStringList &words);
+
+		/**
+		 * Get all the words at most maxDistance away from the given one, in the order they were added.
+		 */
+		QStringList find(const QString &word, int maxDistance) const;
+
+		/**
+		 * Get the closest word at most maxDistance away from the given one, or an empty string if there is none.
+		 * When several words are as close, the one added first is returned.
+		 */
+		QString closest(const QString &word, int maxDistance, int *distance = nullptr) const;
+
+	protected:
+		struct Node
+		{
+			QString word;
+			QVector<QPair<int, int>> children; // Distance to this node, and index of the child node
+		};
+
+	private:
+		QVector<Node> m_nodes;
+};
+
+#endif // BK_TREE_H
@@ -0,0 +1,59 @@
+#include "utils/bloom-filter.h"
+#include <QtMath>
+
+
+BloomFilter::BloomFilter(int capacity, double falsePositiveRate)
+	: m_capacity(qMax(capacity, 1))
+{
+	// Optimal sizes for the given capacity: m = -n.ln(p) / ln(2)^2 bits and k = m/n.ln(2) hashes
+	const double ln2 = qLn(2.0);
+	const double bits = -m_capacity * qLn(falsePositiveRate) / (ln2 * ln2);
+	const int words = qMax(1, static_cast<int>(qCeil(bits / 64)));
+	m_bits.fill(0, words);
+	m_bitCount = static_cast<quint64>(words) * 64;
+	m_hashCount = qBound(1, qRound(bits / m_capacity * ln2), 16);
+}
+
+
+int BloomFilter::count() const
+{
+	return m_count;
+}
+
+int BloomFilter::capacity() const
+{
+	return m_capacity;
+}
+
+void BloomFilter::clear()
+{
+	m_bits.fill(0);
+	m_count = 0;
+}
+
+/**
+ * The bits of a hash are "h1 + i * h2" for i from 0 to k, which is as good as k independent hash functions.
+ */
+void BloomFilter::add(quint64 hash)
+{
+	const quint64 h1 = hash & 0xffffffffULL;
+	const quint64 h2 = (hash >> 32) | 1;
+	for (int i = 0; i < m_hashCount; ++i) {
+		const quint64 bit = (h1 + i * h2) % m_bitCount;
+		m_bits[static_cast<int>(bit / 64)] |= 1ULL << (bit % 64);
+	}
+	m_count++;
+}
+
+bool BloomFilter::mayContain(quint64 hash) const
+{
+	const quint64 h1 = hash & 0xffffffffULL;
+	const quint64 h2 = (hash >> 32) | 1;
+	for (int i = 0; i < m_hashCount; ++i) {
+		const quint64 bit = (h1 + i * h2) % m_bitCount;
+		if ((m_bits[static_cast<int>(bit / 64)] & (1ULL << (bit % 64))) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
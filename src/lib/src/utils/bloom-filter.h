@@ -0,0 +1,34 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <QVector>
+
+
+/**
+ * Set of 64-bit hashes that can tell for sure that a hash was never added, using about 10 bits per element.
+ *
+ * Each hash sets a few bits of a bit array, derived from its two halves. A lookup is negative if any of these bits is
+ * not set, and "maybe" otherwise, with a false positive rate staying around the requested one as long as no more
+ * elements than the capacity are added. Elements can't be removed, which only keeps the answer at "maybe".
+ */
+class BloomFilter
+{
+	public:
+		explicit BloomFilter(int capacity = 0, double falsePositiveRate = 0.01);
+
+		int count() const;
+		int capacity() const;
+		void clear();
+
+		void add(quint64 hash);
+		bool mayContain(quint64 hash) const;
+
+	private:
+		QVector<quint64> m_bits;
+		quint64 m_bitCount;
+		int m_hashCount;
+		int m_capacity;
+		int m_count = 0;
+};
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,120 @@
+#include "utils/directory-index.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include "logger.h"
+
+
+static QString normalizePath(const QString &path)
+{
+	QString normalized = QDir::cleanPath(QFileInfo(QDir::fromNativeSeparators(path)).absoluteFilePath());
+	#ifdef Q_OS_WIN
+		normalized = normalized.toLower();
+	#endif
+	return normalized;
+}
+
+
+DirectoryIndex::DirectoryIndex(const QString &root)
+	: m_root(normalizePath(root))
+{
+	if (!m_root.endsWith('/')) {
+		m_root += '/';
+	}
+}
+
+const QString &DirectoryIndex::root() const
+{
+	return m_root;
+}
+
+bool DirectoryIndex::isBuilt() const
+{
+	QReadLocker locker(&m_lock);
+	return m_built;
+}
+
+int DirectoryIndex::count() const
+{
+	QReadLocker locker(&m_lock);
+	return m_files.count();
+}
+
+
+void DirectoryIndex::build()
+{
+	// Only one scan can happen at a time, other threads wait until it's finished
+	QMutexLocker buildLocker(&m_buildMutex);
+	if (isBuilt()) {
+		return;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QSet<QString> files;
+	QDirIterator it(m_root, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (it.hasNext()) {
+		it.next();
+		QString relative;
+		if (relativePath(it.filePath(), relative)) {
+			files.insert(relative);
+		}
+	}
+
+	log(QStringLiteral("Directory index of `%1` built in %2 ms (%3 files)").arg(m_root).arg(timer.elapsed()).arg(files.count()), Logger::Debug);
+
+	QWriteLocker locker(&m_lock);
+	m_files.unite(files); // Files added during the scan are kept
+	m_built = true;
+}
+
+bool DirectoryIndex::relativePath(const QString &path, QString &relative) const
+{
+	const QString normalized = normalizePath(path);
+	if (!normalized.startsWith(m_root)) {
+		return false;
+	}
+
+	relative = normalized.mid(m_root.length());
+	return true;
+}
+
+
+bool DirectoryIndex::exists(const QString &path)
+{
+	QString relative;
+	if (!relativePath(path, relative)) {
+		return QFile::exists(path);
+	}
+
+	build();
+
+	QReadLocker locker(&m_lock);
+	return m_files.contains(relative);
+}
+
+void DirectoryIndex::add(const QString &path)
+{
+	QString relative;
+	if (!relativePath(path, relative)) {
+		return;
+	}
+
+	QWriteLocker locker(&m_lock);
+	m_files.insert(relative);
+}
+
+void DirectoryIndex::remove(const QString &path)
+{
+	QString relative;
+	if (!relativePath(path, relative)) {
+		return;
+	}
+
+	QWriteLocker locker(&m_lock);
+	m_files.remove(relative);
+}
@@ -0,0 +1,45 @@
+#ifndef DIRECTORY_INDEX_H
+#define DIRECTORY_INDEX_H
+
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+
+
+/**
+ * In-memory index of all the files in a directory tree, to answer existence queries without touching the disk.
+ *
+ * The tree is scanned once, the first time the index is used, and then kept up to date using add() and remove().
+ * Paths outside of the root directory are checked on the disk. All the methods are thread-safe.
+ */
+class DirectoryIndex
+{
+	public:
+		explicit DirectoryIndex(const QString &root);
+
+		const QString &root() const;
+		bool isBuilt() const;
+		int count() const;
+
+		/**
+		 * Scan the root directory recursively, if it was not done yet.
+		 */
+		void build();
+
+		bool exists(const QString &path);
+		void add(const QString &path);
+		void remove(const QString &path);
+
+	protected:
+		bool relativePath(const QString &path, QString &relative) const;
+
+	private:
+		QString m_root;
+		QMutex m_buildMutex;
+		bool m_built = false;
+		mutable QReadWriteLock m_lock;
+		QSet<QString> m_files;
+};
+
+#endif // DIRECTORY_INDEX_H
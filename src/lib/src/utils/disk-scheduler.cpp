@@ -0,0 +1,129 @@
+#include "utils/disk-scheduler.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QStorageInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+
+DiskScheduler::DiskScheduler(int concurrency)
+	: m_concurrency(qMax(1, concurrency))
+{}
+
+DiskScheduler::~DiskScheduler()
+{
+	for (const Device &device : qAsConst(m_devices)) {
+		device.pool->waitForDone();
+		delete device.pool;
+		delete device.semaphore;
+	}
+}
+
+int DiskScheduler::concurrency() const
+{
+	return m_concurrency;
+}
+
+
+/**
+ * Devices are identified by the device file of their file system (like "/dev/sda1"), or their root path if there is
+ * none. The result is cached per directory, as finding it requires listing the mounted file systems.
+ */
+QString DiskScheduler::deviceKey(const QString &path)
+{
+	QString dir = QFileInfo(path).absolutePath();
+
+	QMutexLocker locker(&m_mutex);
+	const auto it = m_deviceKeys.constFind(dir);
+	if (it != m_deviceKeys.constEnd()) {
+		return it.value();
+	}
+	locker.unlock();
+
+	// Files are usually created in directories that don't exist yet
+	QString existing = dir;
+	while (!QFileInfo::exists(existing)) {
+		const QString parent = QFileInfo(existing).absolutePath();
+		if (parent == existing) {
+			break;
+		}
+		existing = parent;
+	}
+
+	const QStorageInfo storage(existing);
+	QString key;
+	if (storage.isValid()) {
+		key = !storage.device().isEmpty() ? QString::fromLocal8Bit(storage.device()) : storage.rootPath();
+	}
+
+	locker.relock();
+	m_deviceKeys.insert(dir, key);
+	return key;
+}
+
+DiskScheduler::Device DiskScheduler::device(const QString &path)
+{
+	const QString key = deviceKey(path);
+
+	QMutexLocker locker(&m_mutex);
+	auto it = m_devices.find(key);
+	if (it == m_devices.end()) {
+		Device device;
+		device.semaphore = new QSemaphore(m_concurrency);
+		device.pool = new QThreadPool();
+		device.pool->setMaxThreadCount(m_concurrency);
+		it = m_devices.insert(key, device);
+	}
+	return it.value();
+}
+
+
+void DiskScheduler::run(const QString &path, const std::function<void()> &job)
+{
+	QSemaphore *semaphore = device(path).semaphore;
+	semaphore->acquire();
+	job();
+	semaphore->release();
+}
+
+/**
+ * The callback is called through a watcher owned by the context, which must then live in the calling thread.
+ */
+void DiskScheduler::runAsync(const QString &path, const std::function<void()> &job, QObject *context, const std::function<void()> &callback)
+{
+	const Device dev = device(path);
+	QSemaphore *semaphore = dev.semaphore;
+
+	auto *watcher = new QFutureWatcher<void>(context);
+	QObject::connect(watcher, &QFutureWatcher<void>::finished, watcher, [watcher, callback]() {
+		watcher->deleteLater();
+		callback();
+	});
+	watcher->setFuture(QtConcurrent::run(dev.pool, [semaphore, job]() {
+		semaphore->acquire();
+		job();
+		semaphore->release();
+	}));
+}
+
+bool DiskScheduler::waitForDone(int msecs)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QMutexLocker locker(&m_mutex);
+	const QList<Device> devices = m_devices.values();
+	locker.unlock();
+
+	for (const Device &device : devices) {
+		const int remaining = msecs < 0 ? -1 : qMax(0, msecs - static_cast<int>(timer.elapsed()));
+		if (!device.pool->waitForDone(remaining)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#ifndef DISK_SCHEDULER_H
+#define DISK_SCHEDULER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <functional>
+
+
+class QObject;
+class QSemaphore;
+class QThreadPool;
+
+/**
+ * Limits the number of simultaneous file operations (moves, copies, links) on each storage device.
+ *
+ * Spinning disks lose most of their throughput when many files are written at once, as their heads keep going back
+ * and forth between them. Operations on the same device therefore wait for a free slot, while operations on different
+ * devices don't block each other. This is independent from the number of simultaneous downloads.
+ */
+class DiskScheduler
+{
+	public:
+		explicit DiskScheduler(int concurrency = 2);
+		~DiskScheduler();
+
+		int concurrency() const;
+
+		/**
+		 * Identifier of the device storing a path, or of the device it would be created on if it doesn't exist.
+		 */
+		QString deviceKey(const QString &path);
+
+		/**
+		 * Run a job in the calling thread once the device of the path has a free slot.
+		 */
+		void run(const QString &path, const std::function<void()> &job);
+
+		/**
+		 * Run a job in the background once the device of the path has a free slot, then the callback in the calling
+		 * thread. The callback is not called if the context object is destroyed in the meantime.
+		 */
+		void runAsync(const QString &path, const std::function<void()> &job, QObject *context, const std::function<void()> &callback);
+
+		bool waitForDone(int msecs = -1);
+
+	protected:
+		struct Device
+		{
+			QSemaphore *semaphore;
+			QThreadPool *pool;
+		};
+		Device device(const QString &path);
+
+	private:
+		int m_concurrency;
+		QMutex m_mutex;
+		QHash<QString, Device> m_devices;
+		QHash<QString, QString> m_deviceKeys;
+};
+
+#endif // DISK_SCHEDULER_H
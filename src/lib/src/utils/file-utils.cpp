@@ -1,10 +1,28 @@
 #include "file-utils.h"
 #include "logger.h"
 #include <QDir>
+#include <QDirIterator>
 #include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QPair>
+#include <QQueue>
 #include <QSaveFile>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#if defined(Q_OS_LINUX)
+	#include <fcntl.h>
+	#include <linux/fs.h>
+	#include <sys/ioctl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+	#include <sys/clonefile.h>
+#endif
 
 
 bool copyRecursively(QString srcFilePath, QString tgtFilePath, bool overwrite)
@@ -49,6 +67,74 @@ bool copyRecursively(QString srcFilePath, QString tgtFilePath, bool overwrite)
 	return true;
 }
 
+/**
+ * Copy a file without reading its data in user space, sharing its blocks with the copy when possible.
+ * Returns false without leaving anything behind if the file system does not support it.
+ */
+static bool cloneFile(const QString &from, const QString &to)
+{
+	#if defined(Q_OS_LINUX)
+		const int in = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+		if (in < 0) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(in, &st) < 0) {
+			::close(in);
+			return false;
+		}
+		const QByteArray target = QFile::encodeName(to);
+		const int out = ::open(target.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+		if (out < 0) {
+			::close(in);
+			return false;
+		}
+
+		// Try a reflink first, then an in-kernel copy which some file systems also turn into shared blocks
+		bool ok = false;
+		#ifdef FICLONE
+			ok = ioctl(out, FICLONE, in) == 0;
+		#endif
+		#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+			if (!ok) {
+				ok = true;
+				off_t remaining = st.st_size;
+				while (remaining > 0) {
+					const ssize_t copied = copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(remaining), 0);
+					if (copied <= 0) {
+						ok = false;
+						break;
+					}
+					remaining -= copied;
+				}
+			}
+		#endif
+
+		::close(in);
+		if (::close(out) < 0) {
+			ok = false;
+		}
+		if (!ok) {
+			::unlink(target.constData());
+		}
+		return ok;
+	#elif defined(Q_OS_MACOS)
+		return clonefile(QFile::encodeName(from).constData(), QFile::encodeName(to).constData(), 0) == 0;
+	#else
+		Q_UNUSED(from)
+		Q_UNUSED(to)
+		return false;
+	#endif
+}
+
+bool copyFile(const QString &from, const QString &to)
+{
+	if (cloneFile(from, to)) {
+		return true;
+	}
+	return QFile::copy(from, to);
+}
+
 bool safeWriteFile(const QString &filePath, const QByteArray &data, bool backup)
 {
 	// Copy the file to a "bak" file to ensure no data is lost
@@ -99,3 +185,97 @@ bool writeFile(const QString &filePath, const QByteArray &data)
 
 	return true;
 }
+
+
+struct DirectoryListing
+{
+	QList<QPair<QString, QStringList>> files;
+	QStringList directories;
+};
+
+/**
+ * List the files and sub-directories of a single directory, grouping the files with a suffix with their parent.
+ */
+static DirectoryListing listDirectory(const QString &root, const QString &relative, const QStringList &suffixes)
+{
+	DirectoryListing ret;
+	const QString prefix = relative.isEmpty() ? QString() : relative + QLatin1Char('/');
+
+	// The entry types come from the directory listing itself on most file systems, so files are not stat'ed
+	QStringList fileNames;
+	QDirIterator it(root + QLatin1Char('/') + relative, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+	while (it.hasNext()) {
+		it.next();
+		const QFileInfo info = it.fileInfo();
+		if (!info.isDir()) {
+			fileNames.append(it.fileName());
+		} else if (!info.isSymLink()) {
+			ret.directories.append(prefix + it.fileName());
+		}
+	}
+	std::sort(fileNames.begin(), fileNames.end());
+	std::sort(ret.directories.begin(), ret.directories.end());
+
+	// Files with a suffix are grouped with their parent when it is in the same directory
+	const QSet<QString> names(fileNames.constBegin(), fileNames.constEnd());
+	QHash<QString, QStringList> children;
+	QStringList parents;
+	for (const QString &fileName : qAsConst(fileNames)) {
+		bool isChild = false;
+		for (const QString &suffix : suffixes) {
+			if (fileName.length() > suffix.length() && fileName.endsWith(suffix)) {
+				const QString parent = fileName.left(fileName.length() - suffix.length());
+				if (names.contains(parent)) {
+					children[parent].append(prefix + fileName);
+					isChild = true;
+					break;
+				}
+			}
+		}
+		if (!isChild) {
+			parents.append(fileName);
+		}
+	}
+
+	ret.files.reserve(parents.count());
+	for (const QString &parent : qAsConst(parents)) {
+		ret.files.append(qMakePair(prefix + parent, children.value(parent)));
+	}
+
+	return ret;
+}
+
+bool walkFilesFromDirectory(const QDir &dir, const QStringList &suffixes, const std::function<bool(const QString &, const QStringList &)> &callback)
+{
+	const QString root = dir.absolutePath();
+	const int maxRunning = qMax(2, QThread::idealThreadCount());
+
+	QQueue<QString> toList;
+	QQueue<QFuture<DirectoryListing>> running;
+	toList.enqueue(QString());
+
+	// Keep a few directories being listed ahead of the callback
+	const auto startListings = [&]() {
+		while (!toList.isEmpty() && running.count() < maxRunning) {
+			running.enqueue(QtConcurrent::run(listDirectory, root, toList.dequeue(), suffixes));
+		}
+	};
+
+	startListings();
+	while (!running.isEmpty()) {
+		const DirectoryListing listing = running.dequeue().result();
+		for (const QString &directory : listing.directories) {
+			toList.enqueue(directory);
+		}
+		startListings();
+
+		for (const auto &file : listing.files) {
+			if (!callback(file.first, file.second)) {
+				// The listings still running only use their own copies of their arguments, so they can be left to finish
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
@@ -3,12 +3,34 @@
 
 #include <QByteArray>
 #include <QString>
+#include <QStringList>
+#include <functional>
+
+
+class QDir;
 
 
 bool copyRecursively(QString srcFilePath, QString tgtFilePath, bool overwrite = false);
+
+/**
+ * Copy a file, first trying to share its data with the copy on file systems that support it (reflinks on Btrfs or
+ * XFS, clones on APFS), so that the copy is instant and takes no space. Like QFile::copy(), it fails if the
+ * destination already exists.
+ */
+bool copyFile(const QString &from, const QString &to);
 bool safeWriteFile(const QString &filePath, const QByteArray &data, bool backup = false);
 
 bool ensureFileParent(const QString &filePath);
 bool writeFile(const QString &filePath, const QByteArray &data);
 
+/**
+ * Walk a directory recursively, calling the callback for each file as soon as its directory has been listed.
+ *
+ * The callback gets the path of the file relative to the directory, and the relative paths of the files next to it
+ * whose name is its own followed by one of the suffixes (for example log files), which are not reported on their
+ * own. It is always called from the calling thread, while the next directories are listed in parallel. Returning
+ * false from the callback stops the walk, in which case this function returns false too.
+ */
+bool walkFilesFromDirectory(const QDir &dir, const QStringList &suffixes, const std::function<bool(const QString &, const QStringList &)> &callback);
+
 #endif // FILE_UTILS_H
@@ -1,23 +1,75 @@
 #include "html-node.h"
+#include <QByteArray>
+#include <utility>
 #include "lexbor/css/css.h"
 #include "lexbor/html/html.h"
 #include "lexbor/selectors/selectors.h"
 #include "logger.h"
 
 
-HtmlNode::HtmlNode(lxb_dom_node_t *node)
-	: m_node(node)
+/**
+ * The CSS parser and selectors engine can be re-used for all searches, but not shared between threads.
+ */
+struct CssEngine
+{
+	lxb_css_parser_t *parser = nullptr;
+	lxb_selectors_t *selectors = nullptr;
+
+	CssEngine()
+	{
+		parser = lxb_css_parser_create();
+		auto parser_status = lxb_css_parser_init(parser, NULL, NULL);
+		if (parser_status != LXB_STATUS_OK) {
+			log(QStringLiteral("Error creating CSS parser: %1.").arg(parser_status), Logger::Error);
+			parser = lxb_css_parser_destroy(parser, true);
+			return;
+		}
+
+		selectors = lxb_selectors_create();
+		auto selectors_status = lxb_selectors_init(selectors);
+		if (selectors_status != LXB_STATUS_OK) {
+			log(QStringLiteral("Error creating CSS selectors: %1.").arg(selectors_status), Logger::Error);
+			selectors = lxb_selectors_destroy(selectors, true);
+		}
+	}
+
+	~CssEngine()
+	{
+		if (selectors != nullptr) {
+			lxb_selectors_destroy(selectors, true);
+		}
+		if (parser != nullptr) {
+			lxb_css_parser_destroy(parser, true);
+		}
+	}
+};
+
+static CssEngine &cssEngine()
+{
+	static thread_local CssEngine engine;
+	return engine;
+}
+
+static void destroyDocument(lxb_html_document_t *document)
+{
+	lxb_html_document_destroy(document);
+}
+
+
+HtmlNode::HtmlNode(lxb_dom_node_t *node, QSharedPointer<lxb_html_document_t> document)
+	: m_node(node), m_document(std::move(document))
 {}
 
 HtmlNode *HtmlNode::fromString(const QString &html, bool fragment)
 {
-	auto *document = lxb_html_document_create();
+	QSharedPointer<lxb_html_document_t> document(lxb_html_document_create(), destroyDocument);
+	const QByteArray data = html.toUtf8();
 
 	// Parse an HTML fragment
 	if (fragment) {
-		const QString fragmentWrapper = "p";
-		auto *root = lxb_html_document_create_element(document, reinterpret_cast<const lxb_char_t *>(fragmentWrapper.toStdString().c_str()), fragmentWrapper.length(), NULL);
-		auto *node = lxb_html_document_parse_fragment(document, &root->element, reinterpret_cast<const lxb_char_t *>(html.toStdString().c_str()), html.length());
+		static const QByteArray fragmentWrapper = "p";
+		auto *root = lxb_html_document_create_element(document.data(), reinterpret_cast<const lxb_char_t *>(fragmentWrapper.constData()), fragmentWrapper.length(), NULL);
+		auto *node = lxb_html_document_parse_fragment(document.data(), &root->element, reinterpret_cast<const lxb_char_t *>(data.constData()), data.length());
 		if (node == NULL) {
 			log(QStringLiteral("Error parsing HTML fragment."), Logger::Error);
 			return nullptr;
@@ -28,25 +80,17 @@ HtmlNode *HtmlNode::fromString(const QString &html, bool fragment)
 			node = node->first_child;
 		}
 
-		return new HtmlNode(node);
+		return new HtmlNode(node, document);
 	}
 
 	// Parse a whole HTML document
-	auto status = lxb_html_document_parse(document, reinterpret_cast<const lxb_char_t *>(html.toStdString().c_str()), html.length());
+	auto status = lxb_html_document_parse(document.data(), reinterpret_cast<const lxb_char_t *>(data.constData()), data.length());
 	if (status != LXB_STATUS_OK) {
 		log(QStringLiteral("Error parsing HTML: %1.").arg(status), Logger::Error);
 		return nullptr;
 	}
-	const auto *body = lxb_html_document_body_element(document);
-	return new HtmlNode(lxb_dom_interface_node(body));
-}
-
-HtmlNode::~HtmlNode()
-{
-	if (m_node->type == LXB_DOM_NODE_TYPE_DOCUMENT) {
-		auto *doc = lxb_dom_interface_document(m_node);
-		lxb_dom_document_destroy(doc);
-	}
+	auto *body = lxb_html_document_body_element(document.data());
+	return new HtmlNode(lxb_dom_interface_node(body), document);
 }
 
 
@@ -58,7 +102,7 @@ QString HtmlNode::outerHTML() const
 		log(QStringLiteral("Error serializing HTML node: %1.").arg(status), Logger::Error);
 		return {};
 	}
-	return QString(reinterpret_cast<const char *>(str.data));
+	return QString::fromUtf8(reinterpret_cast<const char *>(str.data), static_cast<int>(str.length));
 }
 
 QString HtmlNode::innerHTML() const
@@ -69,13 +113,25 @@ QString HtmlNode::innerHTML() const
 		log(QStringLiteral("Error serializing HTML node: %1.").arg(status), Logger::Error);
 		return {};
 	}
-	return QString(reinterpret_cast<const char *>(str.data));
+	return QString::fromUtf8(reinterpret_cast<const char *>(str.data), static_cast<int>(str.length));
 }
 
 QString HtmlNode::innerText() const
 {
-	lxb_char_t *str = lxb_dom_node_text_content(m_node, NULL);
-	return QString(reinterpret_cast<const char *>(str));
+	return innerText(m_node);
+}
+
+QString HtmlNode::innerText(lxb_dom_node_t *node)
+{
+	size_t len = 0;
+	lxb_char_t *str = lxb_dom_node_text_content(node, &len);
+	if (str == NULL) {
+		return {};
+	}
+
+	const QString ret = QString::fromUtf8(reinterpret_cast<const char *>(str), static_cast<int>(len));
+	lxb_dom_document_destroy_text(node->owner_document, str);
+	return ret;
 }
 
 
@@ -87,22 +143,29 @@ QString HtmlNode::tag() const
 
 QString HtmlNode::attr(const QString &attr) const
 {
-	auto *element = lxb_dom_interface_element(m_node);
+	return HtmlNode::attr(m_node, attr.toUtf8());
+}
+
+QString HtmlNode::attr(lxb_dom_node_t *node, const QByteArray &attr)
+{
+	auto *element = lxb_dom_interface_element(node);
+	const auto *name = reinterpret_cast<const lxb_char_t *>(attr.constData());
 
 	// Check that attribute exists
-	bool is_exist = lxb_dom_element_has_attribute(element, reinterpret_cast<const lxb_char_t *>(attr.toStdString().c_str()), attr.length());
+	bool is_exist = lxb_dom_element_has_attribute(element, name, attr.length());
 	if (!is_exist) {
 		return {};
 	}
 
 	// Get attribute value from DOM
-	const lxb_char_t *value = lxb_dom_element_get_attribute(element, reinterpret_cast<const lxb_char_t *>(attr.toStdString().c_str()), attr.length(), NULL);
+	size_t len = 0;
+	const lxb_char_t *value = lxb_dom_element_get_attribute(element, name, attr.length(), &len);
 	if (value == NULL) {
-		log(QStringLiteral("Error getting attribute: %1.").arg(attr), Logger::Error);
+		log(QStringLiteral("Error getting attribute: %1.").arg(QString(attr)), Logger::Error);
 		return {};
 	}
 
-	return QString(reinterpret_cast<const char *>(value));
+	return QString::fromUtf8(reinterpret_cast<const char *>(value), static_cast<int>(len));
 }
 
 QStringList HtmlNode::path() const
@@ -136,39 +199,35 @@ QStringList HtmlNode::pathIds() const
 
 lxb_status_t find_callback(lxb_dom_node_t *node, lxb_css_selector_specificity_t *spec, void *ctx)
 {
-	auto *ret = static_cast<QList<HtmlNode>*>(ctx);
-	ret->append(HtmlNode(node));
+	Q_UNUSED(spec);
+
+	auto *ret = static_cast<QList<lxb_dom_node_t*>*>(ctx);
+	ret->append(node);
 	return LXB_STATUS_OK;
 }
 
-QList<HtmlNode> HtmlNode::find(const QString &css) const
+QList<lxb_dom_node_t*> HtmlNode::select(const QString &css) const
 {
-	// Create CSS parser
-	auto *parser = lxb_css_parser_create();
-	auto parser_status = lxb_css_parser_init(parser, NULL, NULL);
-	if (parser_status != LXB_STATUS_OK) {
-		log(QStringLiteral("Error creating CSS parser: %1.").arg(parser_status), Logger::Error);
-		return {};
-	}
-
-	// Create CSS selectors
-	auto *selectors = lxb_selectors_create();
-	auto selectors_status = lxb_selectors_init(selectors);
-	if (selectors_status != LXB_STATUS_OK) {
-		log(QStringLiteral("Error creating CSS selectors: %1.").arg(selectors_status), Logger::Error);
+	CssEngine &engine = cssEngine();
+	if (engine.parser == nullptr || engine.selectors == nullptr) {
 		return {};
 	}
 
 	// Parse CSS selectors
-	auto *list = lxb_css_selectors_parse(parser, reinterpret_cast<const lxb_char_t *>(css.toStdString().c_str()), css.length());
-	if (parser->status != LXB_STATUS_OK) {
-		log(QStringLiteral("Error parsing CSS selectors: %1.").arg(selectors_status), Logger::Error);
+	const QByteArray data = css.toUtf8();
+	auto *list = lxb_css_selectors_parse(engine.parser, reinterpret_cast<const lxb_char_t *>(data.constData()), data.length());
+	if (engine.parser->status != LXB_STATUS_OK) {
+		log(QStringLiteral("Error parsing CSS selectors: %1.").arg(engine.parser->status), Logger::Error);
+		if (list != NULL) {
+			lxb_css_selector_list_destroy_memory(list);
+		}
 		return {};
 	}
 
 	// Find matching HTML nodes
-	QList<HtmlNode> nodes;
-	auto status_find = lxb_selectors_find(selectors, m_node, list, find_callback, &nodes);
+	QList<lxb_dom_node_t*> nodes;
+	auto status_find = lxb_selectors_find(engine.selectors, m_node, list, find_callback, &nodes);
+	lxb_css_selector_list_destroy_memory(list);
 	if (status_find != LXB_STATUS_OK) {
 		log(QStringLiteral("Error finding nodes via CSS selectors: %1.").arg(status_find), Logger::Error);
 		return {};
@@ -176,3 +235,32 @@ QList<HtmlNode> HtmlNode::find(const QString &css) const
 
 	return nodes;
 }
+
+QList<HtmlNode> HtmlNode::find(const QString &css) const
+{
+	QList<HtmlNode> ret;
+	for (lxb_dom_node_t *node : select(css)) {
+		ret.append(HtmlNode(node, m_document));
+	}
+	return ret;
+}
+
+QStringList HtmlNode::findAttr(const QString &css, const QString &attr) const
+{
+	const QByteArray name = attr.toUtf8();
+
+	QStringList ret;
+	for (lxb_dom_node_t *node : select(css)) {
+		ret.append(HtmlNode::attr(node, name));
+	}
+	return ret;
+}
+
+QStringList HtmlNode::findText(const QString &css) const
+{
+	QStringList ret;
+	for (lxb_dom_node_t *node : select(css)) {
+		ret.append(innerText(node));
+	}
+	return ret;
+}
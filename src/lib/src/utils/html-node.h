@@ -2,16 +2,22 @@
 #define HTML_NODE_H
 
 #include <QList>
+#include <QSharedPointer>
 #include <QString>
+#include <QStringList>
 #include "lexbor/html/html.h"
 
 
+/**
+ * A node of a parsed HTML document.
+ *
+ * All the nodes of a document share its ownership, so that it is only destroyed once none of them remain.
+ */
 class HtmlNode
 {
 	public:
-		HtmlNode(lxb_dom_node_t *node);
+		explicit HtmlNode(lxb_dom_node_t *node, QSharedPointer<lxb_html_document_t> document = QSharedPointer<lxb_html_document_t>());
 		static HtmlNode *fromString(const QString &html, bool fragment = false);
-		~HtmlNode();
 
 		QString outerHTML() const;
 		QString innerHTML() const;
@@ -24,8 +30,24 @@ class HtmlNode
 
 		QList<HtmlNode> find(const QString &css) const;
 
+		/**
+		 * Get an attribute of all the nodes matching a CSS selector, without building their nodes.
+		 */
+		QStringList findAttr(const QString &css, const QString &attr) const;
+
+		/**
+		 * Get the inner text of all the nodes matching a CSS selector, without building their nodes.
+		 */
+		QStringList findText(const QString &css) const;
+
+	protected:
+		static QString attr(lxb_dom_node_t *node, const QByteArray &attr);
+		static QString innerText(lxb_dom_node_t *node);
+		QList<lxb_dom_node_t*> select(const QString &css) const;
+
 	private:
 		lxb_dom_node_t *m_node;
+		QSharedPointer<lxb_html_document_t> m_document;
 };
 
 #endif // HTML_NODE_H
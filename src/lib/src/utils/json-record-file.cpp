@@ -0,0 +1,160 @@
+#include "utils/json-record-file.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <utility>
+#include "logger.h"
+#include "utils/file-utils.h"
+
+#define JOURNAL_MIN_ENTRIES 100
+
+
+JsonRecordFile::JsonRecordFile(QString path, QString key, int version)
+	: m_path(std::move(path)), m_key(std::move(key)), m_version(version)
+{}
+
+QString JsonRecordFile::journalPath() const
+{
+	return m_path + ".journal";
+}
+
+int JsonRecordFile::journalEntries() const
+{
+	return m_journalEntries;
+}
+
+
+QList<QJsonObject> JsonRecordFile::load()
+{
+	QList<QJsonObject> records;
+	m_loaded = true;
+	m_revision = 0;
+	m_journalEntries = 0;
+	m_saved.clear();
+
+	QFile file(m_path);
+	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+		return records;
+	}
+
+	const QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
+	file.close();
+	m_revision = object["revision"].toInt();
+
+	const QJsonArray array = object[m_key].toArray();
+	records.reserve(array.count());
+	for (const auto &record : array) {
+		records.append(record.toObject());
+	}
+
+	// Replay the journal, the last line being possibly truncated if the program was interrupted while writing it
+	QFile journal(journalPath());
+	if (journal.open(QFile::ReadOnly | QFile::Text)) {
+		while (!journal.atEnd()) {
+			const QByteArray line = journal.readLine().trimmed();
+			if (line.isEmpty()) {
+				continue;
+			}
+
+			QJsonParseError error;
+			const QJsonObject entry = QJsonDocument::fromJson(line, &error).object();
+			if (error.error != QJsonParseError::NoError) {
+				log(QStringLiteral("Invalid line in journal `%1`: %2").arg(journalPath(), error.errorString()), Logger::Warning);
+				continue;
+			}
+
+			const int index = entry["index"].toInt(-1);
+			if (entry["revision"].toInt() != m_revision || index < 0 || index >= records.count()) {
+				continue;
+			}
+
+			records[index] = entry["record"].toObject();
+			m_journalEntries++;
+		}
+	}
+
+	m_saved.reserve(records.count());
+	for (const QJsonObject &record : qAsConst(records)) {
+		m_saved.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+	}
+
+	return records;
+}
+
+bool JsonRecordFile::save(const QList<QJsonObject> &records)
+{
+	QList<QByteArray> serialized;
+	serialized.reserve(records.count());
+	for (const QJsonObject &record : records) {
+		serialized.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+	}
+
+	// The journal can only be used to update records in place
+	if (!m_loaded || serialized.count() != m_saved.count()) {
+		return rewrite(records, serialized);
+	}
+
+	QList<int> changed;
+	for (int i = 0; i < serialized.count(); ++i) {
+		if (serialized[i] != m_saved[i]) {
+			changed.append(i);
+		}
+	}
+	if (changed.isEmpty()) {
+		return true;
+	}
+
+	// Merge the journal back once it becomes bigger than the file itself
+	if (m_journalEntries + changed.count() > qMax(JOURNAL_MIN_ENTRIES, records.count())) {
+		return rewrite(records, serialized);
+	}
+
+	QByteArray data;
+	for (int i : changed) {
+		data += "{\"revision\":" + QByteArray::number(m_revision) + ",\"index\":" + QByteArray::number(i) + ",\"record\":" + serialized[i] + "}\n";
+	}
+
+	QFile journal(journalPath());
+	if (!journal.open(QFile::WriteOnly | QFile::Append | QFile::Text) || journal.write(data) != data.size()) {
+		log(QStringLiteral("Could not write to journal `%1`, rewriting the full file").arg(journalPath()), Logger::Warning);
+		journal.close();
+		return rewrite(records, serialized);
+	}
+	journal.close();
+
+	for (int i : changed) {
+		m_saved[i] = serialized[i];
+	}
+	m_journalEntries += changed.count();
+
+	return true;
+}
+
+bool JsonRecordFile::rewrite(const QList<QJsonObject> &records, const QList<QByteArray> &serialized)
+{
+	QJsonArray array;
+	for (const QJsonObject &record : records) {
+		array.append(record);
+	}
+
+	QJsonObject full;
+	full["version"] = m_version;
+	full["revision"] = m_revision + 1;
+	full[m_key] = array;
+
+	if (!safeWriteFile(m_path, QJsonDocument(full).toJson())) {
+		log(QStringLiteral("Could not write file `%1`").arg(m_path), Logger::Error);
+		return false;
+	}
+
+	// Entries left in the journal have an older revision, so they are ignored even if it can't be removed
+	QFile::remove(journalPath());
+
+	m_loaded = true;
+	m_revision++;
+	m_journalEntries = 0;
+	m_saved = serialized;
+
+	return true;
+}
@@ -0,0 +1,43 @@
+#ifndef JSON_RECORD_FILE_H
+#define JSON_RECORD_FILE_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+
+/**
+ * JSON file storing a list of records, such as {"version": 1, "monitors": [...]}, with a journal of record updates.
+ *
+ * When only some records changed since the last save, they are appended to a journal file next to it instead of
+ * rewriting the whole file. The journal is replayed on load, and merged back into the main file once it has more
+ * entries than there are records. Adding, removing or moving records always rewrites the main file.
+ *
+ * Both files share a revision number, increased on each full rewrite, so that a journal left behind by an
+ * interrupted rewrite is never applied to the wrong records.
+ */
+class JsonRecordFile
+{
+	public:
+		JsonRecordFile(QString path, QString key, int version = 1);
+
+		QList<QJsonObject> load();
+		bool save(const QList<QJsonObject> &records);
+		int journalEntries() const;
+
+	protected:
+		QString journalPath() const;
+		bool rewrite(const QList<QJsonObject> &records, const QList<QByteArray> &serialized);
+
+	private:
+		QString m_path;
+		QString m_key;
+		int m_version;
+		int m_revision = 0;
+		int m_journalEntries = 0;
+		bool m_loaded = false;
+		QList<QByteArray> m_saved;
+};
+
+#endif // JSON_RECORD_FILE_H
@@ -0,0 +1,248 @@
+#include "utils/json-writer.h"
+#include <QIODevice>
+
+#define INDENT_SIZE 4
+
+
+JsonWriter::JsonWriter(QIODevice *device, bool indented, int bufferSize)
+	: m_device(device), m_indented(indented), m_bufferSize(bufferSize)
+{
+	m_buffer.reserve(m_bufferSize);
+}
+
+JsonWriter::~JsonWriter()
+{
+	flush();
+}
+
+void JsonWriter::setIndented(bool indented)
+{
+	m_indented = indented;
+}
+
+bool JsonWriter::isIndented() const
+{
+	return m_indented;
+}
+
+
+void JsonWriter::beginObject()
+{
+	beforeValue();
+	write('{');
+	m_levels.append(Level { true, 0 });
+}
+
+void JsonWriter::endObject()
+{
+	const Level level = m_levels.takeLast();
+	if (level.count > 0) {
+		newLine();
+	}
+	write('}');
+	afterValue();
+}
+
+void JsonWriter::beginArray()
+{
+	beforeValue();
+	write('[');
+	m_levels.append(Level { false, 0 });
+}
+
+void JsonWriter::endArray()
+{
+	const Level level = m_levels.takeLast();
+	if (level.count > 0) {
+		newLine();
+	}
+	write(']');
+	afterValue();
+}
+
+void JsonWriter::key(const QString &key)
+{
+	Level &level = m_levels.last();
+	if (level.count++ > 0) {
+		write(',');
+	}
+	newLine();
+	writeString(key);
+	if (m_indented) {
+		write(": ", 2);
+	} else {
+		write(':');
+	}
+	m_afterKey = true;
+}
+
+
+void JsonWriter::value(const QString &val)
+{
+	beforeValue();
+	writeString(val);
+	afterValue();
+}
+
+void JsonWriter::value(const char *val)
+{
+	value(QString::fromUtf8(val));
+}
+
+void JsonWriter::value(const QStringList &val)
+{
+	beginArray();
+	for (const QString &item : val) {
+		value(item);
+	}
+	endArray();
+}
+
+void JsonWriter::value(int val)
+{
+	value(static_cast<qint64>(val));
+}
+
+void JsonWriter::value(qint64 val)
+{
+	beforeValue();
+	write(QByteArray::number(val));
+	afterValue();
+}
+
+void JsonWriter::value(bool val)
+{
+	beforeValue();
+	if (val) {
+		write("true", 4);
+	} else {
+		write("false", 5);
+	}
+	afterValue();
+}
+
+void JsonWriter::null()
+{
+	beforeValue();
+	write("null", 4);
+	afterValue();
+}
+
+void JsonWriter::raw(const QByteArray &data)
+{
+	write(data);
+}
+
+
+void JsonWriter::flush()
+{
+	if (m_buffer.isEmpty() || m_device == nullptr) {
+		return;
+	}
+
+	m_device->write(m_buffer);
+	m_buffer.clear();
+}
+
+
+/**
+ * Values in objects are already preceded by their key, which takes care of the separators.
+ */
+void JsonWriter::beforeValue()
+{
+	if (m_afterKey) {
+		m_afterKey = false;
+		return;
+	}
+	if (m_levels.isEmpty()) {
+		return;
+	}
+
+	Level &level = m_levels.last();
+	if (level.count++ > 0) {
+		write(',');
+	}
+	newLine();
+}
+
+void JsonWriter::afterValue()
+{
+	if (m_levels.isEmpty()) {
+		write('\n');
+	}
+}
+
+void JsonWriter::newLine()
+{
+	if (!m_indented) {
+		return;
+	}
+
+	write('\n');
+	const int spaces = m_levels.count() * INDENT_SIZE;
+	if (m_buffer.size() + spaces > m_bufferSize) {
+		flush();
+	}
+	m_buffer.append(spaces, ' ');
+}
+
+/**
+ * Strings are escaped after their conversion to UTF-8, as multi-byte sequences never need to be escaped.
+ */
+void JsonWriter::writeString(const QString &val)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	const QByteArray utf8 = val.toUtf8();
+	const char *data = utf8.constData();
+	const int size = utf8.size();
+
+	write('"');
+	int start = 0;
+	for (int i = 0; i < size; ++i) {
+		const auto c = static_cast<unsigned char>(data[i]);
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		write(data + start, i - start);
+		start = i + 1;
+
+		switch (c) {
+			case '"': write("\\\"", 2); break;
+			case '\\': write("\\\\", 2); break;
+			case '\b': write("\\b", 2); break;
+			case '\f': write("\\f", 2); break;
+			case '\n': write("\\n", 2); break;
+			case '\r': write("\\r", 2); break;
+			case '\t': write("\\t", 2); break;
+			default: {
+				const char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+				write(escaped, 6);
+			}
+		}
+	}
+	write(data + start, size - start);
+	write('"');
+}
+
+void JsonWriter::write(const char *data, int size)
+{
+	if (m_buffer.size() + size > m_bufferSize) {
+		flush();
+	}
+	m_buffer.append(data, size);
+}
+
+void JsonWriter::write(const QByteArray &data)
+{
+	write(data.constData(), data.size());
+}
+
+void JsonWriter::write(char c)
+{
+	if (m_buffer.size() >= m_bufferSize) {
+		flush();
+	}
+	m_buffer.append(c);
+}
@@ -0,0 +1,77 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+class QIODevice;
+
+/**
+ * Writes JSON directly to a buffered device, without building intermediate QJsonObject or QJsonDocument instances.
+ *
+ * Values are written in the order they are given, and commas, indentation and string escaping are handled by the
+ * writer. Each top-level value is followed by a new line, so that a compact writer outputs newline-delimited JSON.
+ * The buffer is written to the device when it is full, when flush() is called, and when the writer is destroyed.
+ */
+class JsonWriter
+{
+	public:
+		explicit JsonWriter(QIODevice *device, bool indented = false, int bufferSize = 64 * 1024);
+		~JsonWriter();
+
+		void setIndented(bool indented);
+		bool isIndented() const;
+
+		void beginObject();
+		void endObject();
+		void beginArray();
+		void endArray();
+
+		/**
+		 * Set the key of the next value, inside an object.
+		 */
+		void key(const QString &key);
+
+		void value(const QString &val);
+		void value(const char *val);
+		void value(const QStringList &val);
+		void value(int val);
+		void value(qint64 val);
+		void value(bool val);
+		void null();
+
+		/**
+		 * Write data as-is, outside of any JSON value.
+		 */
+		void raw(const QByteArray &data);
+
+		void flush();
+
+	protected:
+		void beforeValue();
+		void afterValue();
+		void newLine();
+		void writeString(const QString &val);
+		void write(const char *data, int size);
+		void write(const QByteArray &data);
+		void write(char c);
+
+	private:
+		struct Level
+		{
+			bool object;
+			int count;
+		};
+
+		QIODevice *m_device;
+		bool m_indented;
+		int m_bufferSize;
+		QByteArray m_buffer;
+		QVector<Level> m_levels;
+		bool m_afterKey = false;
+};
+
+#endif // JSON_WRITER_H
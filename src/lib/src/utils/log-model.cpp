@@ -0,0 +1,224 @@
+#include "utils/log-model.h"
+#include <QColor>
+#include <QModelIndex>
+#include <QRegularExpression>
+#include <QVariant>
+#include <utility>
+
+
+static Logger::LogLevel parseLevel(const QString &message, Logger::LogLevel def)
+{
+	static const QStringList levels { "Debug", "Info", "Warning", "Error" };
+
+	// Messages start with "[time][level] "
+	const int timeEnd = message.indexOf(']');
+	if (!message.startsWith('[') || timeEnd < 0 || message.length() <= timeEnd + 1 || message[timeEnd + 1] != '[') {
+		return def;
+	}
+	const int levelEnd = message.indexOf(']', timeEnd + 1);
+	const int index = levels.indexOf(message.mid(timeEnd + 2, levelEnd - timeEnd - 2));
+	return index >= 0 ? static_cast<Logger::LogLevel>(index) : def;
+}
+
+
+LogModel::LogModel(int capacity, QObject *parent)
+	: QAbstractListModel(parent), m_capacity(qMax(1, capacity))
+{
+	m_entries.reserve(m_capacity);
+}
+
+int LogModel::capacity() const
+{
+	return m_capacity;
+}
+
+int LogModel::totalCount() const
+{
+	return m_entries.count();
+}
+
+Logger::LogLevel LogModel::minimumLevel() const
+{
+	return m_minimumLevel;
+}
+
+QString LogModel::search() const
+{
+	return m_search;
+}
+
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid()) {
+		return 0;
+	}
+	return m_visible.count();
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_visible.count()) {
+		return {};
+	}
+
+	const Entry &entry = this->entry(m_visible[index.row()]);
+	switch (role)
+	{
+		case Qt::DisplayRole:
+		case Qt::ToolTipRole:
+			return entry.message;
+
+		case Qt::ForegroundRole:
+			switch (entry.level)
+			{
+				case Logger::Debug: return QColor("#999");
+				case Logger::Warning: return QColor("orange");
+				case Logger::Error: return QColor("red");
+				default: return {};
+			}
+
+		case LevelRole:
+			return static_cast<int>(entry.level);
+
+		// First link or local path of the message, like the ones made clickable by logToHtml()
+		case LinkRole: {
+			static const QRegularExpression rxLinks("`(http[^`]+)`");
+			#ifdef Q_OS_WIN
+				static const QRegularExpression rxPaths(R"(`(\w:[\\/][^`]+)`)");
+			#else
+				static const QRegularExpression rxPaths("`(/[^`]+)`");
+			#endif
+			const auto link = rxLinks.match(entry.message);
+			if (link.hasMatch()) {
+				return link.captured(1);
+			}
+			const auto path = rxPaths.match(entry.message);
+			if (path.hasMatch()) {
+				return QStringLiteral("file:///") + path.captured(1);
+			}
+			return {};
+		}
+
+		default:
+			return {};
+	}
+}
+
+
+const LogModel::Entry &LogModel::entry(qint64 id) const
+{
+	const int offset = static_cast<int>(id - m_firstId);
+	return m_entries[(m_start + offset) % m_entries.count()];
+}
+
+bool LogModel::matches(const Entry &entry) const
+{
+	return entry.level >= m_minimumLevel
+		&& (m_search.isEmpty() || entry.message.contains(m_search, Qt::CaseInsensitive));
+}
+
+/**
+ * Adding a batch of messages costs the same whatever the number of messages already in the buffer.
+ */
+void LogModel::add(const QStringList &messages)
+{
+	// Messages that would be dropped right away are skipped
+	const int skipped = qMax(0, messages.count() - m_capacity);
+	const int count = messages.count() - skipped;
+	if (count == 0) {
+		return;
+	}
+
+	// Remove the rows of the messages that will be dropped from the buffer
+	const int dropped = qMax(0, m_entries.count() + count - m_capacity);
+	const qint64 newFirstId = m_firstId + dropped;
+	int removed = 0;
+	while (removed < m_visible.count() && m_visible[removed] < newFirstId) {
+		removed++;
+	}
+	if (removed > 0) {
+		beginRemoveRows(QModelIndex(), 0, removed - 1);
+		m_visible.erase(m_visible.begin(), m_visible.begin() + removed);
+		endRemoveRows();
+	}
+
+	// Add the new messages to the buffer
+	QList<qint64> visible;
+	for (int i = skipped; i < messages.count(); ++i) {
+		QString message = messages[i];
+		while (message.endsWith('\n') || message.endsWith('\r')) {
+			message.chop(1);
+		}
+
+		// Messages spanning multiple lines keep the level of their first line
+		m_lastLevel = parseLevel(message, m_lastLevel);
+		Entry entry { message, m_lastLevel };
+		const bool match = matches(entry);
+
+		qint64 id;
+		if (m_entries.count() < m_capacity) {
+			id = m_firstId + m_entries.count();
+			m_entries.append(std::move(entry));
+		} else {
+			id = m_firstId + m_capacity;
+			m_entries[m_start] = std::move(entry);
+			m_start = (m_start + 1) % m_capacity;
+			m_firstId++;
+		}
+
+		if (match) {
+			visible.append(id);
+		}
+	}
+
+	if (!visible.isEmpty()) {
+		beginInsertRows(QModelIndex(), m_visible.count(), m_visible.count() + visible.count() - 1);
+		m_visible.append(visible);
+		endInsertRows();
+	}
+}
+
+void LogModel::clear()
+{
+	beginResetModel();
+	m_entries.clear();
+	m_visible.clear();
+	m_start = 0;
+	m_firstId = 0;
+	m_lastLevel = Logger::Info;
+	endResetModel();
+}
+
+void LogModel::setMinimumLevel(Logger::LogLevel level)
+{
+	if (level == m_minimumLevel) {
+		return;
+	}
+
+	m_minimumLevel = level;
+	refilter();
+}
+
+void LogModel::setSearch(const QString &search)
+{
+	if (search == m_search) {
+		return;
+	}
+
+	m_search = search;
+	refilter();
+}
+
+void LogModel::refilter()
+{
+	beginResetModel();
+	m_visible.clear();
+	for (int i = 0; i < m_entries.count(); ++i) {
+		const qint64 id = m_firstId + i;
+		if (matches(entry(id))) {
+			m_visible.append(id);
+		}
+	}
+	endResetModel();
+}
@@ -0,0 +1,71 @@
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "logger.h"
+
+
+class QModelIndex;
+class QVariant;
+
+/**
+ * List model over the last log messages, kept in a fixed-size ring buffer.
+ *
+ * Only the messages matching the current level and search filters are exposed as rows. Adding messages only
+ * inserts the new rows and removes the ones that were dropped from the buffer, so that views don't need to be
+ * laid out again, whatever the number of messages logged so far.
+ */
+class LogModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+	public:
+		enum Role
+		{
+			LevelRole = Qt::UserRole,
+			LinkRole,
+		};
+
+		explicit LogModel(int capacity, QObject *parent = nullptr);
+
+		int capacity() const;
+		int totalCount() const;
+		Logger::LogLevel minimumLevel() const;
+		QString search() const;
+
+		int rowCount(const QModelIndex &parent = {}) const override;
+		QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+	public slots:
+		void add(const QStringList &messages);
+		void clear();
+		void setMinimumLevel(Logger::LogLevel level);
+		void setSearch(const QString &search);
+
+	protected:
+		struct Entry
+		{
+			QString message;
+			Logger::LogLevel level;
+		};
+
+		const Entry &entry(qint64 id) const;
+		bool matches(const Entry &entry) const;
+		void refilter();
+
+	private:
+		int m_capacity;
+		QVector<Entry> m_entries; // Ring buffer
+		int m_start = 0;
+		qint64 m_firstId = 0; // ID of the oldest message of the buffer, IDs being their position since the beginning
+		QList<qint64> m_visible; // IDs of the messages matching the filters
+		Logger::LogLevel m_minimumLevel = Logger::Debug;
+		QString m_search;
+		Logger::LogLevel m_lastLevel = Logger::Info;
+};
+
+#endif // LOG_MODEL_H
@@ -0,0 +1,274 @@
+#include "utils/md5-multi-buffer.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+#define MD5_READ_SIZE (64 * 1024)
+#define MD5_LANES Md5MultiBuffer::Lanes
+
+
+static const quint32 md5K[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const int md5S[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static const quint32 md5Init[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+
+/**
+ * Run the 16 steps of a round on all lanes. The inner loop has no branches and only depends on its own lane, so it
+ * can be vectorized.
+ */
+template <typename F, typename G>
+static inline void md5Round(int from, quint32 *a, quint32 *b, quint32 *c, quint32 *d, const quint32 words[16][MD5_LANES], F f, G g)
+{
+	for (int i = from; i < from + 16; ++i) {
+		const quint32 *m = words[g(i)];
+		const quint32 k = md5K[i];
+		const int s = md5S[i];
+		for (int l = 0; l < MD5_LANES; ++l) {
+			const quint32 x = a[l] + f(b[l], c[l], d[l]) + k + m[l];
+			a[l] = d[l];
+			d[l] = c[l];
+			c[l] = b[l];
+			b[l] = b[l] + ((x << s) | (x >> (32 - s)));
+		}
+	}
+}
+
+static void md5Compress(quint32 state[4][MD5_LANES], const quint32 words[16][MD5_LANES])
+{
+	quint32 a[MD5_LANES], b[MD5_LANES], c[MD5_LANES], d[MD5_LANES];
+	std::memcpy(a, state[0], sizeof(a));
+	std::memcpy(b, state[1], sizeof(b));
+	std::memcpy(c, state[2], sizeof(c));
+	std::memcpy(d, state[3], sizeof(d));
+
+	md5Round(0, a, b, c, d, words, [](quint32 x, quint32 y, quint32 z) { return z ^ (x & (y ^ z)); }, [](int i) { return i; });
+	md5Round(16, a, b, c, d, words, [](quint32 x, quint32 y, quint32 z) { return y ^ (z & (x ^ y)); }, [](int i) { return (5 * i + 1) % 16; });
+	md5Round(32, a, b, c, d, words, [](quint32 x, quint32 y, quint32 z) { return x ^ y ^ z; }, [](int i) { return (3 * i + 5) % 16; });
+	md5Round(48, a, b, c, d, words, [](quint32 x, quint32 y, quint32 z) { return y ^ (x | ~z); }, [](int i) { return (7 * i) % 16; });
+
+	for (int l = 0; l < MD5_LANES; ++l) {
+		state[0][l] += a[l];
+		state[1][l] += b[l];
+		state[2][l] += c[l];
+		state[3][l] += d[l];
+	}
+}
+
+
+struct Md5MultiBuffer::Lane
+{
+	QIODevice *device = nullptr;
+	int index = -1;
+	QByteArray buffer;
+	int pos = 0;
+	int len = 0;
+	quint64 size = 0;
+	bool eof = false;
+	bool lengthPending = false;
+};
+
+/**
+ * Get the next 64 bytes block of a lane, padding included.
+ * @return -1 on read errors, 1 for the last block of the message, 0 otherwise.
+ */
+int Md5MultiBuffer::nextBlock(Lane &lane, uchar *block)
+{
+	if (lane.lengthPending) {
+		std::memset(block, 0, 56);
+		qToLittleEndian<quint64>(lane.size * 8, block + 56);
+		lane.lengthPending = false;
+		return 1;
+	}
+
+	// Refill the buffer with large reads, keeping what was not used yet
+	if (lane.len - lane.pos < 64 && !lane.eof) {
+		const int rest = lane.len - lane.pos;
+		std::memmove(lane.buffer.data(), lane.buffer.constData() + lane.pos, rest);
+		lane.pos = 0;
+		lane.len = rest;
+		while (!lane.eof && lane.len < lane.buffer.size()) {
+			const qint64 read = lane.device->read(lane.buffer.data() + lane.len, lane.buffer.size() - lane.len);
+			if (read < 0) {
+				return -1;
+			}
+			if (read == 0) {
+				lane.eof = true;
+			}
+			lane.len += static_cast<int>(read);
+		}
+	}
+
+	const int rest = lane.len - lane.pos;
+	if (rest >= 64) {
+		std::memcpy(block, lane.buffer.constData() + lane.pos, 64);
+		lane.pos += 64;
+		lane.size += 64;
+		return 0;
+	}
+
+	// End of the message: 0x80 byte, zeroes, then the message size in bits, possibly in an extra block
+	std::memcpy(block, lane.buffer.constData() + lane.pos, rest);
+	lane.pos = lane.len;
+	lane.size += rest;
+	block[rest] = 0x80;
+	std::memset(block + rest + 1, 0, 63 - rest);
+	if (rest < 56) {
+		qToLittleEndian<quint64>(lane.size * 8, block + 56);
+		return 1;
+	}
+	lane.lengthPending = true;
+	return 0;
+}
+
+
+QList<QByteArray> Md5MultiBuffer::hash(const QList<QByteArray> &messages)
+{
+	return hashDevices(messages.count(), [&messages](int i) -> QIODevice* {
+		auto *buffer = new QBuffer();
+		buffer->setData(messages[i]);
+		buffer->open(QIODevice::ReadOnly);
+		return buffer;
+	});
+}
+
+QStringList Md5MultiBuffer::hashFiles(const QStringList &paths)
+{
+	const QList<QByteArray> md5s = hashDevices(paths.count(), [&paths](int i) -> QIODevice* {
+		if (paths[i].isEmpty()) {
+			return nullptr;
+		}
+		auto *file = new QFile(paths[i]);
+		if (!file->open(QFile::ReadOnly | QFile::Unbuffered)) {
+			delete file;
+			return nullptr;
+		}
+		return file;
+	});
+
+	QStringList ret;
+	ret.reserve(md5s.count());
+	for (const QByteArray &md5 : md5s) {
+		ret.append(QString::fromLatin1(md5));
+	}
+	return ret;
+}
+
+QList<QByteArray> Md5MultiBuffer::hashDevices(int count, const std::function<QIODevice*(int)> &open)
+{
+	QList<QByteArray> ret;
+	ret.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		ret.append(QByteArray());
+	}
+
+	// A single message would only use one lane, so the scalar implementation is faster
+	if (count == 1) {
+		QIODevice *device = open(0);
+		if (device != nullptr) {
+			QCryptographicHash hash(QCryptographicHash::Md5);
+			if (hash.addData(device)) {
+				ret[0] = hash.result().toHex();
+			}
+			delete device;
+		}
+		return ret;
+	}
+
+	Lane lanes[MD5_LANES];
+	quint32 state[4][MD5_LANES];
+	quint32 words[16][MD5_LANES];
+	bool last[MD5_LANES];
+	uchar block[64];
+	int next = 0;
+
+	// Give the next message that can be opened to a lane, or leave it empty if there is none
+	const auto assign = [&](int l) {
+		Lane &lane = lanes[l];
+		delete lane.device;
+		lane.device = nullptr;
+		lane.index = -1;
+		while (next < count) {
+			const int index = next++;
+			QIODevice *device = open(index);
+			if (device == nullptr) {
+				continue;
+			}
+
+			lane.device = device;
+			lane.index = index;
+			if (lane.buffer.isEmpty()) {
+				lane.buffer = QByteArray(MD5_READ_SIZE, Qt::Uninitialized);
+			}
+			lane.pos = 0;
+			lane.len = 0;
+			lane.size = 0;
+			lane.eof = false;
+			lane.lengthPending = false;
+			for (int j = 0; j < 4; ++j) {
+				state[j][l] = md5Init[j];
+			}
+			return;
+		}
+	};
+	for (int l = 0; l < MD5_LANES; ++l) {
+		assign(l);
+	}
+
+	forever {
+		bool any = false;
+		for (int l = 0; l < MD5_LANES; ++l) {
+			int res = -1;
+			while (lanes[l].device != nullptr && (res = nextBlock(lanes[l], block)) < 0) {
+				assign(l);
+			}
+
+			// Empty lanes are still computed with the others, their result being ignored
+			if (lanes[l].device == nullptr) {
+				std::memset(block, 0, sizeof(block));
+				last[l] = false;
+			} else {
+				any = true;
+				last[l] = res == 1;
+			}
+			for (int w = 0; w < 16; ++w) {
+				words[w][l] = qFromLittleEndian<quint32>(block + 4 * w);
+			}
+		}
+		if (!any) {
+			break;
+		}
+
+		md5Compress(state, words);
+
+		for (int l = 0; l < MD5_LANES; ++l) {
+			if (last[l]) {
+				uchar digest[16];
+				for (int j = 0; j < 4; ++j) {
+					qToLittleEndian<quint32>(state[j][l], digest + 4 * j);
+				}
+				ret[lanes[l].index] = QByteArray(reinterpret_cast<const char*>(digest), 16).toHex();
+				assign(l);
+			}
+		}
+	}
+
+	return ret;
+}
@@ -0,0 +1,44 @@
+#ifndef MD5_MULTI_BUFFER_H
+#define MD5_MULTI_BUFFER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+
+class QIODevice;
+
+/**
+ * Computes the MD5 of several independent messages at the same time.
+ *
+ * MD5 can't be parallelized within a single message, as each block depends on the previous one, so hashing many
+ * small files is bound by the latency of the compression function. Here, up to `Lanes` messages are hashed together:
+ * the state of each lane is stored in its own array slot and all lanes go through the same operations, which lets
+ * the compiler map them to vector instructions (SSE2/AVX2 on x86, NEON on ARM). When a message ends, its lane is
+ * refilled with the next one, so lanes stay busy even with messages of different sizes.
+ */
+class Md5MultiBuffer
+{
+	public:
+		static const int Lanes = 8;
+
+		/**
+		 * Hex MD5 of each message, in the same order.
+		 */
+		static QList<QByteArray> hash(const QList<QByteArray> &messages);
+
+		/**
+		 * Hex MD5 of the contents of each file, in the same order. Files that can't be read get an empty string, like
+		 * with getFileMd5().
+		 */
+		static QStringList hashFiles(const QStringList &paths);
+
+	protected:
+		struct Lane;
+		static int nextBlock(Lane &lane, uchar *block);
+		static QList<QByteArray> hashDevices(int count, const std::function<QIODevice*(int)> &open);
+};
+
+#endif // MD5_MULTI_BUFFER_H
@@ -0,0 +1,170 @@
+#include "utils/memory-budget.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <utility>
+#include "metrics.h"
+
+
+MemoryBudget::MemoryBudget(qint64 budget)
+	: m_budget(budget)
+{}
+
+MemoryBudget &MemoryBudget::getInstance()
+{
+	static auto *instance = new MemoryBudget();
+	return *instance;
+}
+
+
+qint64 MemoryBudget::budget() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_budget;
+}
+
+void MemoryBudget::setBudget(qint64 bytes)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_budget = bytes;
+	}
+	trim();
+}
+
+
+quint64 MemoryBudget::add(const QString &category, qint64 bytes, std::function<void()> evict, bool threadSafe)
+{
+	quint64 id;
+	{
+		QMutexLocker locker(&m_mutex);
+
+		id = m_nextId++;
+		Entry entry { category, bytes, std::move(evict), threadSafe ? nullptr : QThread::currentThread(), m_lru.insert(m_lru.end(), id) };
+		m_entries.insert(id, std::move(entry));
+		m_usage += bytes;
+
+		Usage &usage = m_categories[category];
+		usage.category = category;
+		usage.bytes += bytes;
+		usage.entries++;
+	}
+
+	trim();
+	return id;
+}
+
+void MemoryBudget::resize(quint64 id, qint64 bytes)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+
+		auto it = m_entries.find(id);
+		if (it == m_entries.end()) {
+			return;
+		}
+
+		m_usage += bytes - it->bytes;
+		m_categories[it->category].bytes += bytes - it->bytes;
+		it->bytes = bytes;
+		m_lru.splice(m_lru.end(), m_lru, it->lru);
+	}
+
+	trim();
+}
+
+void MemoryBudget::touch(quint64 id)
+{
+	QMutexLocker locker(&m_mutex);
+
+	auto it = m_entries.constFind(id);
+	if (it != m_entries.constEnd()) {
+		m_lru.splice(m_lru.end(), m_lru, it->lru);
+	}
+}
+
+void MemoryBudget::remove(quint64 id)
+{
+	QMutexLocker locker(&m_mutex);
+
+	auto it = m_entries.find(id);
+	if (it == m_entries.end()) {
+		return;
+	}
+
+	m_usage -= it->bytes;
+	Usage &usage = m_categories[it->category];
+	usage.bytes -= it->bytes;
+	usage.entries--;
+	m_lru.erase(it->lru);
+	m_entries.erase(it);
+}
+
+
+qint64 MemoryBudget::usage() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_usage;
+}
+
+QList<MemoryBudget::Usage> MemoryBudget::breakdown() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_categories.values();
+}
+
+void MemoryBudget::updateMetrics() const
+{
+	Metrics &metrics = Metrics::getInstance();
+	for (const Usage &usage : breakdown()) {
+		metrics.setGauge("grabber_memory_bytes", Metrics::label("cache", usage.category), usage.bytes);
+	}
+	metrics.setGauge("grabber_memory_bytes", Metrics::label("cache", "total"), usage());
+}
+
+
+int MemoryBudget::trim()
+{
+	int evicted = 0;
+	QThread *thread = QThread::currentThread();
+
+	while (true) {
+		std::function<void()> evict;
+		{
+			QMutexLocker locker(&m_mutex);
+			if (m_budget <= 0 || m_usage <= m_budget) {
+				break;
+			}
+
+			// Find the least recently used entry that can be evicted from this thread
+			auto lru = m_lru.begin();
+			for (; lru != m_lru.end(); ++lru) {
+				const auto entry = m_entries.constFind(*lru);
+				if (entry->thread == nullptr || entry->thread == thread) {
+					break;
+				}
+			}
+			if (lru == m_lru.end()) {
+				break;
+			}
+
+			auto it = m_entries.find(*lru);
+			evict = std::move(it->evict);
+			m_usage -= it->bytes;
+			Usage &usage = m_categories[it->category];
+			usage.bytes -= it->bytes;
+			usage.entries--;
+			m_lru.erase(lru);
+			m_entries.erase(it);
+		}
+
+		if (evict) {
+			evict();
+		}
+		evicted++;
+	}
+
+	if (evicted > 0) {
+		Metrics::getInstance().increment("grabber_memory_evictions_total", QString(), evicted);
+	}
+	return evicted;
+}
@@ -0,0 +1,83 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <list>
+
+
+class QThread;
+
+/**
+ * Global budget for the memory used by the in-memory caches, with a least-recently-used eviction across all of them.
+ *
+ * Caches register their entries with an estimate of their size and a callback freeing them. Each use of an entry
+ * marks it as recently used, and when the total goes over the budget, the least recently used entries are evicted
+ * until it fits again. The callback is called without any lock held, after the entry was unregistered.
+ *
+ * Entries are only evicted from the thread that registered them, unless they are marked as thread-safe, so that for
+ * example pixmaps are only ever freed on the GUI thread.
+ */
+class MemoryBudget
+{
+	public:
+		struct Usage
+		{
+			QString category;
+			qint64 bytes = 0;
+			int entries = 0;
+		};
+
+		explicit MemoryBudget(qint64 budget = 0);
+		static MemoryBudget &getInstance();
+
+		/**
+		 * The maximum number of bytes, or 0 to never evict anything.
+		 */
+		qint64 budget() const;
+		void setBudget(qint64 bytes);
+
+		quint64 add(const QString &category, qint64 bytes, std::function<void()> evict, bool threadSafe = false);
+		void resize(quint64 id, qint64 bytes);
+		void touch(quint64 id);
+		void remove(quint64 id);
+
+		qint64 usage() const;
+		QList<Usage> breakdown() const;
+
+		/**
+		 * Set the "grabber_memory_bytes" gauges, to be able to display the breakdown along the other metrics.
+		 */
+		void updateMetrics() const;
+
+		/**
+		 * Evict the least recently used entries until the usage fits in the budget.
+		 *
+		 * @return The number of entries evicted
+		 */
+		int trim();
+
+	private:
+		struct Entry
+		{
+			QString category;
+			qint64 bytes;
+			std::function<void()> evict;
+			QThread *thread;
+			std::list<quint64>::iterator lru;
+		};
+
+		mutable QMutex m_mutex;
+		qint64 m_budget;
+		qint64 m_usage = 0;
+		quint64 m_nextId = 1;
+		QHash<quint64, Entry> m_entries;
+		QMap<QString, Usage> m_categories; // Kept when empty, so that their usage can be reported as 0
+		std::list<quint64> m_lru; // Least recently used first
+};
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,54 @@
+#include "utils/perceptual-hash.h"
+#include <QImage>
+#include <QImageReader>
+#include <QString>
+#include <QtAlgorithms>
+
+#define HASH_WIDTH 9
+#define HASH_HEIGHT 8
+
+
+quint64 perceptualHash(const QImage &image)
+{
+	if (image.isNull()) {
+		return 0;
+	}
+
+	const QImage small = image
+		.convertToFormat(QImage::Format_Grayscale8)
+		.scaled(HASH_WIDTH, HASH_HEIGHT, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+	quint64 hash = 0;
+	for (int y = 0; y < HASH_HEIGHT; ++y) {
+		const uchar *line = small.constScanLine(y);
+		for (int x = 0; x < HASH_WIDTH - 1; ++x) {
+			hash = (hash << 1) | (line[x] > line[x + 1] ? 1 : 0);
+		}
+	}
+	return hash;
+}
+
+bool perceptualHashFile(const QString &path, quint64 *hash)
+{
+	QImageReader reader(path);
+	reader.setAutoTransform(true);
+
+	// JPEG files can be decoded directly at a fraction of their size, which is much faster for big files
+	const QSize size = reader.size();
+	if (size.isValid()) {
+		reader.setScaledSize(size.scaled(64, 64, Qt::KeepAspectRatioByExpanding).boundedTo(size));
+	}
+
+	const QImage image = reader.read();
+	if (image.isNull()) {
+		return false;
+	}
+
+	*hash = perceptualHash(image);
+	return true;
+}
+
+int hammingDistance(quint64 a, quint64 b)
+{
+	return static_cast<int>(qPopulationCount(a ^ b));
+}
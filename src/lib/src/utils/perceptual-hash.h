@@ -0,0 +1,25 @@
+#ifndef PERCEPTUAL_HASH_H
+#define PERCEPTUAL_HASH_H
+
+#include <QtGlobal>
+
+
+class QImage;
+class QString;
+
+/**
+ * Compute the difference hash ("dHash") of an image: its grayscale version is shrunk to 9x8 pixels, and each bit
+ * tells whether a pixel is brighter than its right neighbour. Resized or re-encoded versions of the same image only
+ * differ by a few bits, so the Hamming distance between two hashes tells how similar the images look.
+ */
+quint64 perceptualHash(const QImage &image);
+
+/**
+ * Compute the perceptual hash of an image file, letting the decoder shrink it while reading when it can.
+ * @return Whether the file could be decoded.
+ */
+bool perceptualHashFile(const QString &path, quint64 *hash);
+
+int hammingDistance(quint64 a, quint64 b);
+
+#endif // PERCEPTUAL_HASH_H
@@ -0,0 +1,69 @@
+#include "utils/regex-cache.h"
+#include <QMutexLocker>
+
+
+RegexCache::RegexCache(int maxCount)
+	: m_cache(maxCount)
+{}
+
+RegexCache &RegexCache::global()
+{
+	static RegexCache instance;
+	return instance;
+}
+
+QRegularExpression RegexCache::get(const QString &pattern, QRegularExpression::PatternOptions options)
+{
+	const QPair<QString, int> key(pattern, static_cast<int>(options));
+
+	{
+		QMutexLocker locker(&m_mutex);
+		QRegularExpression *cached = m_cache.object(key);
+		if (cached != nullptr) {
+			m_hits++;
+			return *cached;
+		}
+		m_misses++;
+	}
+
+	// Compile outside of the lock so that other threads are not blocked during compilation
+	QRegularExpression regex(pattern, options);
+	regex.optimize();
+
+	QMutexLocker locker(&m_mutex);
+	m_cache.insert(key, new QRegularExpression(regex));
+	return regex;
+}
+
+int RegexCache::count() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_cache.count();
+}
+
+void RegexCache::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_cache.clear();
+	m_hits = 0;
+	m_misses = 0;
+}
+
+int RegexCache::hits() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_hits;
+}
+
+int RegexCache::misses() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_misses;
+}
+
+double RegexCache::hitRate() const
+{
+	QMutexLocker locker(&m_mutex);
+	const int total = m_hits + m_misses;
+	return total > 0 ? static_cast<double>(m_hits) / total : 0;
+}
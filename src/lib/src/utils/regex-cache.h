@@ -0,0 +1,47 @@
+#ifndef REGEX_CACHE_H
+#define REGEX_CACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QPair>
+#include <QRegularExpression>
+#include <QString>
+
+
+/**
+ * Bounded cache of compiled regular expressions, keyed by pattern and options.
+ *
+ * Sources often use the same few patterns for every image of every page, so compiling them once and sharing them
+ * between all the Javascript engines saves a lot of time. All the methods are thread-safe.
+ */
+class RegexCache
+{
+	public:
+		explicit RegexCache(int maxCount = 256);
+
+		/**
+		 * The cache shared by the whole application.
+		 */
+		static RegexCache &global();
+
+		/**
+		 * Get the compiled and optimized regular expression for this pattern, compiling it on the first call.
+		 */
+		QRegularExpression get(const QString &pattern, QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption);
+
+		int count() const;
+		void clear();
+
+		// Statistics
+		int hits() const;
+		int misses() const;
+		double hitRate() const;
+
+	private:
+		mutable QMutex m_mutex;
+		QCache<QPair<QString, int>, QRegularExpression> m_cache;
+		int m_hits = 0;
+		int m_misses = 0;
+};
+
+#endif // REGEX_CACHE_H
@@ -0,0 +1,184 @@
+#include "utils/thumbnail-cache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+#include "logger.h"
+
+#define PRUNE_INTERVAL 500
+
+
+ThumbnailCache::ThumbnailCache(QString directory, qint64 memorySize, qint64 diskSize)
+	: m_directory(std::move(directory)), m_diskSize(diskSize)
+{
+	// QCache costs are integers, so we count in kilobytes
+	m_images.setMaxCost(static_cast<int>(qMin<qint64>(memorySize / 1024, std::numeric_limits<int>::max())));
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	m_pruneFuture.waitForFinished();
+}
+
+QSharedPointer<ThumbnailCache> ThumbnailCache::shared(const QString &directory, qint64 memorySize, qint64 diskSize)
+{
+	static QMutex mutex;
+	static QHash<QString, QWeakPointer<ThumbnailCache>> caches;
+
+	const QString key = QDir::cleanPath(QFileInfo(directory).absoluteFilePath());
+
+	QMutexLocker locker(&mutex);
+	QSharedPointer<ThumbnailCache> cache = caches.value(key).toStrongRef();
+	if (cache.isNull()) {
+		cache = QSharedPointer<ThumbnailCache>::create(directory, memorySize, diskSize);
+		caches.insert(key, cache);
+	}
+	return cache;
+}
+
+
+QString ThumbnailCache::key(const QString &site, const QString &id)
+{
+	return QCryptographicHash::hash((site + "/" + id).toUtf8(), QCryptographicHash::Sha1).toHex();
+}
+
+QString ThumbnailCache::filePath(const QString &key) const
+{
+	// Split files in sub-directories to avoid having too many files in a single one
+	return m_directory + "/" + key.left(2) + "/" + key;
+}
+
+
+QImage ThumbnailCache::image(const QString &key)
+{
+	QMutexLocker locker(&m_mutex);
+
+	QImage *image = m_images.object(key);
+	return image != nullptr ? *image : QImage();
+}
+
+void ThumbnailCache::setImage(const QString &key, const QImage &image)
+{
+	if (image.isNull()) {
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	const int cost = qMax(1, static_cast<int>(image.sizeInBytes() / 1024));
+	m_images.insert(key, new QImage(image), cost);
+}
+
+
+QByteArray ThumbnailCache::data(const QString &key) const
+{
+	const QString path = filePath(key);
+
+	// Opening a file in read-write mode creates it if it doesn't exist
+	QFile file(path);
+	if (!file.exists() || !file.open(QFile::ReadWrite)) {
+		return QByteArray();
+	}
+
+	// Touch the file so that pruning removes the least recently used ones first
+	const QByteArray data = file.readAll();
+	file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+	return data;
+}
+
+void ThumbnailCache::setData(const QString &key, const QByteArray &data)
+{
+	if (data.isEmpty() || m_diskSize <= 0) {
+		return;
+	}
+
+	const QString path = filePath(key);
+	QDir().mkpath(QFileInfo(path).absolutePath());
+
+	// Use a QSaveFile so that other threads never read a partially written file
+	QSaveFile file(path);
+	if (!file.open(QFile::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+		log(QStringLiteral("Could not write thumbnail to the cache: %1").arg(file.errorString()), Logger::Warning);
+		return;
+	}
+
+	// Prune the cache from time to time in the background
+	QMutexLocker locker(&m_mutex);
+	if (++m_writesSincePrune >= PRUNE_INTERVAL) {
+		m_writesSincePrune = 0;
+		m_pruneFuture = QtConcurrent::run([this]() { prune(); });
+	}
+}
+
+
+void ThumbnailCache::remove(const QString &key)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_images.remove(key);
+	}
+
+	QFile::remove(filePath(key));
+}
+
+void ThumbnailCache::clear()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_images.clear();
+	}
+
+	QDir(m_directory).removeRecursively();
+}
+
+void ThumbnailCache::prune()
+{
+	QMutexLocker locker(&m_pruneMutex);
+
+	struct CacheFile
+	{
+		QString path;
+		qint64 size;
+		QDateTime lastModified;
+	};
+
+	QList<CacheFile> files;
+	qint64 total = 0;
+	QDirIterator it(m_directory, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext()) {
+		it.next();
+		const QFileInfo info = it.fileInfo();
+		files.append(CacheFile { info.absoluteFilePath(), info.size(), info.lastModified() });
+		total += info.size();
+	}
+	if (total <= m_diskSize) {
+		return;
+	}
+
+	// Remove the oldest files first
+	std::sort(files.begin(), files.end(), [](const CacheFile &a, const CacheFile &b) {
+		return a.lastModified < b.lastModified;
+	});
+
+	int removed = 0;
+	for (const CacheFile &file : qAsConst(files)) {
+		if (total <= m_diskSize) {
+			break;
+		}
+		if (QFile::remove(file.path)) {
+			total -= file.size;
+			removed++;
+		}
+	}
+
+	log(QStringLiteral("Removed %1 thumbnails from the cache").arg(removed), Logger::Debug);
+}
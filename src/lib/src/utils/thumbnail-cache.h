@@ -0,0 +1,64 @@
+#ifndef THUMBNAIL_CACHE_H
+#define THUMBNAIL_CACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+
+/**
+ * Two-level cache of thumbnails, to avoid loading them again from the network.
+ *
+ * Decoded images are kept in a memory LRU cache limited to a given number of bytes, while the compressed data is
+ * stored on the disk so that it survives restarts. The disk cache is pruned from time to time, removing the least
+ * recently used files until it fits in its own size limit. All the methods are thread-safe.
+ */
+class ThumbnailCache
+{
+	public:
+		ThumbnailCache(QString directory, qint64 memorySize, qint64 diskSize);
+		~ThumbnailCache();
+
+		/**
+		 * Get the cache of a directory, shared by all the profiles of this process using the same directory.
+		 * The sizes are only used when the cache is not already in use.
+		 */
+		static QSharedPointer<ThumbnailCache> shared(const QString &directory, qint64 memorySize, qint64 diskSize);
+
+		/**
+		 * Build a cache key for a thumbnail, using the image MD5 if available or the thumbnail URL otherwise.
+		 */
+		static QString key(const QString &site, const QString &id);
+
+		QImage image(const QString &key);
+		void setImage(const QString &key, const QImage &image);
+
+		QByteArray data(const QString &key) const;
+		void setData(const QString &key, const QByteArray &data);
+
+		void remove(const QString &key);
+		void clear();
+
+		/**
+		 * Remove the least recently used files from the disk cache until it fits in its maximum size.
+		 */
+		void prune();
+
+	protected:
+		QString filePath(const QString &key) const;
+
+	private:
+		QString m_directory;
+		qint64 m_diskSize;
+		QMutex m_mutex;
+		QCache<QString, QImage> m_images;
+		QMutex m_pruneMutex;
+		QFuture<void> m_pruneFuture;
+		int m_writesSincePrune = 0;
+};
+
+#endif // THUMBNAIL_CACHE_H
@@ -0,0 +1,196 @@
+#include "utils/wildcard-matcher.h"
+#include <algorithm>
+
+
+WildcardMatcher::WildcardMatcher()
+{
+	clear();
+}
+
+/**
+ * Add a new pattern to the matcher.
+ *
+ * @param pattern The pattern, where "*" can match any sequence of characters
+ * @param value The value that match() will return for texts matching this pattern
+ */
+void WildcardMatcher::add(const QString &pattern, int value)
+{
+	const QString lower = pattern.toLower();
+	const int stars = lower.count('*');
+	m_count++;
+
+	if (stars == 0) {
+		m_exact[lower].append(value);
+	} else if (stars == 1 && lower.endsWith('*')) {
+		addToTrie(m_prefixes, lower.left(lower.length() - 1), value);
+	} else if (stars == 1 && lower.startsWith('*')) {
+		QString reversed = lower.mid(1);
+		std::reverse(reversed.begin(), reversed.end());
+		addToTrie(m_suffixes, reversed, value);
+	} else {
+		GenericPattern generic;
+		generic.parts = lower.split('*', Qt::SkipEmptyParts);
+		generic.startsWithWildcard = lower.startsWith('*');
+		generic.endsWithWildcard = lower.endsWith('*');
+		generic.value = value;
+		m_generic.append(generic);
+	}
+}
+
+void WildcardMatcher::clear()
+{
+	m_count = 0;
+	m_exact.clear();
+	m_generic.clear();
+	m_prefixes = { TrieNode() };
+	m_suffixes = { TrieNode() };
+}
+
+bool WildcardMatcher::isEmpty() const
+{
+	return m_count == 0;
+}
+
+
+void WildcardMatcher::addToTrie(QVector<TrieNode> &trie, const QString &key, int value)
+{
+	int node = 0;
+	for (const QChar &c : key) {
+		const auto it = trie[node].children.constFind(c);
+		if (it != trie[node].children.constEnd()) {
+			node = it.value();
+		} else {
+			trie.append(TrieNode());
+			const int child = trie.count() - 1;
+			trie[node].children.insert(c, child);
+			node = child;
+		}
+	}
+	trie[node].values.append(value);
+}
+
+bool WildcardMatcher::matchTrie(const QVector<TrieNode> &trie, const QString &text, bool reverse, QList<int> *values)
+{
+	bool found = false;
+	int node = 0;
+	const int length = text.length();
+
+	for (int i = 0; i <= length; ++i) {
+		const TrieNode &current = trie[node];
+		if (!current.values.isEmpty()) {
+			found = true;
+			if (values == nullptr) {
+				return true;
+			}
+			values->append(current.values);
+		}
+
+		if (i == length) {
+			break;
+		}
+
+		const auto it = current.children.constFind(text[reverse ? length - 1 - i : i]);
+		if (it == current.children.constEnd()) {
+			break;
+		}
+		node = it.value();
+	}
+
+	return found;
+}
+
+bool WildcardMatcher::matchGeneric(const GenericPattern &pattern, const QString &text)
+{
+	const QStringList &parts = pattern.parts;
+	if (parts.isEmpty()) {
+		return true;
+	}
+
+	int pos = 0;
+	for (int i = 0; i < parts.count(); ++i) {
+		const QString &part = parts[i];
+		const bool first = i == 0;
+		const bool last = i == parts.count() - 1;
+
+		// The first part must be at the start of the text, and the last part at its end
+		if (first && !pattern.startsWithWildcard) {
+			if (!text.startsWith(part)) {
+				return false;
+			}
+			pos = part.length();
+		} else if (last && !pattern.endsWithWildcard) {
+			const int start = text.length() - part.length();
+			return start >= pos && text.midRef(start) == part;
+		} else {
+			const int index = text.indexOf(part, pos);
+			if (index < 0) {
+				return false;
+			}
+			pos = index + part.length();
+		}
+	}
+
+	return pattern.endsWithWildcard || pos == text.length();
+}
+
+bool WildcardMatcher::match(const QString &text, QList<int> *values) const
+{
+	if (m_count == 0) {
+		return false;
+	}
+
+	const QString lower = text.toLower();
+	bool found = false;
+
+	const auto exact = m_exact.constFind(lower);
+	if (exact != m_exact.constEnd()) {
+		found = true;
+		if (values == nullptr) {
+			return true;
+		}
+		values->append(exact.value());
+	}
+
+	if (matchTrie(m_prefixes, lower, false, values)) {
+		found = true;
+		if (values == nullptr) {
+			return true;
+		}
+	}
+	if (matchTrie(m_suffixes, lower, true, values)) {
+		found = true;
+		if (values == nullptr) {
+			return true;
+		}
+	}
+
+	for (const GenericPattern &generic : m_generic) {
+		if (matchGeneric(generic, lower)) {
+			found = true;
+			if (values == nullptr) {
+				return true;
+			}
+			values->append(generic.value);
+		}
+	}
+
+	return found;
+}
+
+/**
+ * Whether the text matches any of the patterns.
+ */
+bool WildcardMatcher::matches(const QString &text) const
+{
+	return match(text, nullptr);
+}
+
+/**
+ * The values of all the patterns matching the text (possibly with duplicates).
+ */
+QList<int> WildcardMatcher::match(const QString &text) const
+{
+	QList<int> values;
+	match(text, &values);
+	return values;
+}
@@ -0,0 +1,57 @@
+#ifndef WILDCARD_MATCHER_H
+#define WILDCARD_MATCHER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * Case-insensitive matcher for many wildcard patterns at once, where "*" matches any sequence of characters.
+ *
+ * Patterns are sorted by shape: exact patterns are stored in a hash, "foo*" in a prefix trie, "*foo" in a suffix trie,
+ * and others (such as "*foo*" or "a*b") are matched one by one with a linear-time greedy algorithm.
+ */
+class WildcardMatcher
+{
+	public:
+		WildcardMatcher();
+
+		void add(const QString &pattern, int value = 0);
+		void clear();
+		bool isEmpty() const;
+
+		bool matches(const QString &text) const;
+		QList<int> match(const QString &text) const;
+
+	protected:
+		struct TrieNode
+		{
+			QHash<QChar, int> children;
+			QList<int> values;
+		};
+
+		struct GenericPattern
+		{
+			QStringList parts;
+			bool startsWithWildcard;
+			bool endsWithWildcard;
+			int value;
+		};
+
+		static void addToTrie(QVector<TrieNode> &trie, const QString &key, int value);
+		static bool matchTrie(const QVector<TrieNode> &trie, const QString &text, bool reverse, QList<int> *values);
+		static bool matchGeneric(const GenericPattern &pattern, const QString &text);
+		bool match(const QString &text, QList<int> *values) const;
+
+	private:
+		int m_count = 0;
+		QHash<QString, QList<int>> m_exact;
+		QVector<TrieNode> m_prefixes;
+		QVector<TrieNode> m_suffixes;
+		QList<GenericPattern> m_generic;
+};
+
+#endif // WILDCARD_MATCHER_H
@@ -0,0 +1,335 @@
+#include "utils/zip-writer.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QStringList>
+#include <QtEndian>
+#include <cstring>
+#include <vendor/miniz.h>
+#include "logger.h"
+
+#define CHUNK_SIZE (256 * 1024)
+#define MAX_ENTRIES 0xFFFF
+#define MAX_SIZE Q_UINT64_C(0xFFFFFFFF)
+#define ZIP_VERSION 20
+#define FLAG_DATA_DESCRIPTOR 0x0008
+#define FLAG_UTF8 0x0800
+
+
+static void put16(QByteArray &out, quint16 value)
+{
+	const quint16 le = qToLittleEndian(value);
+	out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+static void put32(QByteArray &out, quint32 value)
+{
+	const quint32 le = qToLittleEndian(value);
+	out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+
+ZipWriter::ZipWriter(const QString &filePath)
+	: m_file(filePath)
+{}
+
+ZipWriter::~ZipWriter()
+{
+	if (m_file.isOpen()) {
+		close();
+	}
+	if (m_stream != nullptr) {
+		mz_deflateEnd(m_stream);
+		delete m_stream;
+	}
+}
+
+bool ZipWriter::open()
+{
+	log(QStringLiteral("Write zip to `%1`").arg(m_file.fileName()), Logger::Info);
+	if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+		fail(QStringLiteral("Could not open file: %1").arg(m_file.errorString()));
+		return false;
+	}
+
+	m_entries.clear();
+	m_inFile = false;
+	return true;
+}
+
+bool ZipWriter::isOpen() const
+{
+	return m_file.isOpen();
+}
+
+QString ZipWriter::errorString() const
+{
+	return m_error;
+}
+
+void ZipWriter::fail(const QString &error)
+{
+	m_error = error;
+	log(QStringLiteral("Error writing zip `%1`: %2").arg(m_file.fileName(), error), Logger::Error);
+}
+
+bool ZipWriter::writeRaw(const char *data, qint64 size)
+{
+	if (m_file.write(data, size) != size) {
+		fail(QStringLiteral("Write failed: %1").arg(m_file.errorString()));
+		return false;
+	}
+	return true;
+}
+
+bool ZipWriter::beginFile(const QString &name, bool compress)
+{
+	if (!m_file.isOpen() || (m_inFile && !endFile())) {
+		return false;
+	}
+	if (m_entries.count() >= MAX_ENTRIES || static_cast<quint64>(m_file.pos()) > MAX_SIZE) {
+		fail(QStringLiteral("Too many files in the archive"));
+		return false;
+	}
+
+	// MS-DOS date and time, with a precision of two seconds
+	const QDateTime now = QDateTime::currentDateTime();
+	const QDate date = now.date();
+	const QTime time = now.time();
+
+	m_current.name = name.toUtf8();
+	m_current.method = compress ? MZ_DEFLATED : 0;
+	m_current.time = static_cast<quint16>((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+	m_current.date = static_cast<quint16>(((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day());
+	m_current.crc = 0;
+	m_current.offset = static_cast<quint32>(m_file.pos());
+	m_currentSize = 0;
+	m_currentCompressedSize = 0;
+
+	if (compress) {
+		if (m_stream == nullptr) {
+			m_stream = new mz_stream;
+		}
+		memset(m_stream, 0, sizeof(mz_stream));
+		if (mz_deflateInit2(m_stream, MZ_DEFAULT_LEVEL, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9, MZ_DEFAULT_STRATEGY) != MZ_OK) {
+			fail(QStringLiteral("mz_deflateInit2 failed"));
+			return false;
+		}
+	}
+
+	// The CRC and sizes are not known yet, so they will be written in a data descriptor after the contents
+	QByteArray header;
+	put32(header, 0x04034b50);
+	put16(header, ZIP_VERSION);
+	put16(header, FLAG_DATA_DESCRIPTOR | FLAG_UTF8);
+	put16(header, m_current.method);
+	put16(header, m_current.time);
+	put16(header, m_current.date);
+	put32(header, 0);
+	put32(header, 0);
+	put32(header, 0);
+	put16(header, static_cast<quint16>(m_current.name.size()));
+	put16(header, 0);
+	header.append(m_current.name);
+
+	m_inFile = true;
+	return writeRaw(header.constData(), header.size());
+}
+
+bool ZipWriter::deflate(const char *data, qint64 size, bool finish)
+{
+	if (m_deflateBuffer.size() < CHUNK_SIZE) {
+		m_deflateBuffer.resize(CHUNK_SIZE);
+	}
+
+	m_stream->next_in = reinterpret_cast<const unsigned char*>(data);
+	m_stream->avail_in = static_cast<unsigned int>(size);
+	for (;;) {
+		m_stream->next_out = reinterpret_cast<unsigned char*>(m_deflateBuffer.data());
+		m_stream->avail_out = static_cast<unsigned int>(m_deflateBuffer.size());
+
+		const int status = mz_deflate(m_stream, finish ? MZ_FINISH : MZ_NO_FLUSH);
+		if (status != MZ_OK && status != MZ_STREAM_END && status != MZ_BUF_ERROR) {
+			fail(QStringLiteral("mz_deflate failed"));
+			return false;
+		}
+
+		const qint64 written = m_deflateBuffer.size() - m_stream->avail_out;
+		if (written > 0 && !writeRaw(m_deflateBuffer.constData(), written)) {
+			return false;
+		}
+		m_currentCompressedSize += written;
+
+		// Without finishing, the compressor only needs to be called until it consumed its whole input
+		if (finish ? status == MZ_STREAM_END : (m_stream->avail_in == 0 && m_stream->avail_out > 0)) {
+			return true;
+		}
+	}
+}
+
+bool ZipWriter::write(const char *data, qint64 size)
+{
+	if (!m_inFile) {
+		return false;
+	}
+	if (size <= 0) {
+		return true;
+	}
+
+	m_currentSize += size;
+	if (m_currentSize > MAX_SIZE) {
+		fail(QStringLiteral("File too big for the archive"));
+		return false;
+	}
+	m_current.crc = static_cast<quint32>(mz_crc32(m_current.crc, reinterpret_cast<const unsigned char*>(data), static_cast<size_t>(size)));
+
+	if (m_current.method == MZ_DEFLATED) {
+		return deflate(data, size, false);
+	}
+
+	m_currentCompressedSize += size;
+	return writeRaw(data, size);
+}
+
+bool ZipWriter::write(const QByteArray &data)
+{
+	return write(data.constData(), data.size());
+}
+
+bool ZipWriter::endFile()
+{
+	if (!m_inFile) {
+		return false;
+	}
+	m_inFile = false;
+
+	if (m_current.method == MZ_DEFLATED) {
+		const bool ok = deflate(nullptr, 0, true);
+		mz_deflateEnd(m_stream);
+		if (!ok) {
+			return false;
+		}
+	}
+	if (m_currentCompressedSize > MAX_SIZE) {
+		fail(QStringLiteral("File too big for the archive"));
+		return false;
+	}
+
+	m_current.size = static_cast<quint32>(m_currentSize);
+	m_current.compressedSize = static_cast<quint32>(m_currentCompressedSize);
+	m_entries.append(m_current);
+
+	QByteArray descriptor;
+	put32(descriptor, 0x08074b50);
+	put32(descriptor, m_current.crc);
+	put32(descriptor, m_current.compressedSize);
+	put32(descriptor, m_current.size);
+	return writeRaw(descriptor.constData(), descriptor.size());
+}
+
+bool ZipWriter::abortFile()
+{
+	if (!m_inFile) {
+		return false;
+	}
+	m_inFile = false;
+
+	if (m_current.method == MZ_DEFLATED) {
+		mz_deflateEnd(m_stream);
+	}
+
+	// Nothing was written after this file, so we can simply truncate the archive back to its start
+	if (!m_file.flush() || !m_file.resize(m_current.offset) || !m_file.seek(m_current.offset)) {
+		fail(QStringLiteral("Could not remove file from the archive: %1").arg(m_file.errorString()));
+		return false;
+	}
+	return true;
+}
+
+bool ZipWriter::addFile(const QString &name, const QString &path, bool compress)
+{
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly)) {
+		fail(QStringLiteral("Could not open `%1`: %2").arg(path, file.errorString()));
+		return false;
+	}
+
+	if (!beginFile(name, compress)) {
+		return false;
+	}
+
+	QByteArray buffer(CHUNK_SIZE, Qt::Uninitialized);
+	qint64 read;
+	while ((read = file.read(buffer.data(), buffer.size())) > 0) {
+		if (!write(buffer.constData(), read)) {
+			abortFile();
+			return false;
+		}
+	}
+	if (read < 0) {
+		fail(QStringLiteral("Could not read `%1`: %2").arg(path, file.errorString()));
+		abortFile();
+		return false;
+	}
+
+	return endFile();
+}
+
+bool ZipWriter::close()
+{
+	if (!m_file.isOpen()) {
+		return false;
+	}
+	if (m_inFile && !endFile()) {
+		m_file.close();
+		return false;
+	}
+
+	const quint64 directoryOffset = static_cast<quint64>(m_file.pos());
+	QByteArray directory;
+	for (const Entry &entry : qAsConst(m_entries)) {
+		put32(directory, 0x02014b50);
+		put16(directory, ZIP_VERSION);
+		put16(directory, ZIP_VERSION);
+		put16(directory, FLAG_DATA_DESCRIPTOR | FLAG_UTF8);
+		put16(directory, entry.method);
+		put16(directory, entry.time);
+		put16(directory, entry.date);
+		put32(directory, entry.crc);
+		put32(directory, entry.compressedSize);
+		put32(directory, entry.size);
+		put16(directory, static_cast<quint16>(entry.name.size()));
+		put16(directory, 0); // Extra field length
+		put16(directory, 0); // Comment length
+		put16(directory, 0); // Disk number
+		put16(directory, 0); // Internal attributes
+		put32(directory, 0); // External attributes
+		put32(directory, entry.offset);
+		directory.append(entry.name);
+	}
+	if (directoryOffset + directory.size() > MAX_SIZE) {
+		fail(QStringLiteral("Archive too big"));
+		m_file.close();
+		return false;
+	}
+
+	// End of central directory record
+	const quint32 directorySize = static_cast<quint32>(directory.size());
+	put32(directory, 0x06054b50);
+	put16(directory, 0);
+	put16(directory, 0);
+	put16(directory, static_cast<quint16>(m_entries.count()));
+	put16(directory, static_cast<quint16>(m_entries.count()));
+	put32(directory, directorySize);
+	put32(directory, static_cast<quint32>(directoryOffset));
+	put16(directory, 0);
+
+	const bool ok = writeRaw(directory.constData(), directory.size());
+	m_file.close();
+	return ok;
+}
+
+bool ZipWriter::shouldCompress(const QString &name)
+{
+	static const QStringList compressed { "jpg", "jpeg", "png", "gif", "webp", "avif", "jxl", "mp4", "webm", "mkv", "mov", "avi", "zip", "rar", "7z", "gz", "swf" };
+	return !compressed.contains(QFileInfo(name).suffix().toLower());
+}
@@ -0,0 +1,83 @@
+#ifndef ZIP_WRITER_H
+#define ZIP_WRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+
+struct mz_stream_s;
+
+/**
+ * Writes a ZIP archive one chunk at a time, so that files can be added while they are being downloaded, without
+ * needing to be written to the disk first.
+ *
+ * Since the size and CRC of a file are only known once it has been fully written, they are put in a data descriptor
+ * after its contents instead of its local header. Archives are limited to 65535 files of 4 GiB (no ZIP64 support).
+ */
+class ZipWriter
+{
+	public:
+		explicit ZipWriter(const QString &filePath);
+		~ZipWriter();
+		bool open();
+		bool isOpen() const;
+		bool close();
+		QString errorString() const;
+
+		/**
+		 * Start a new file in the archive, ending the current one if any.
+		 * @param name The path of the file in the archive.
+		 * @param compress Whether to deflate the file, or simply store it.
+		 */
+		bool beginFile(const QString &name, bool compress);
+		bool write(const char *data, qint64 size);
+		bool write(const QByteArray &data);
+		bool endFile();
+
+		/**
+		 * Remove the current file from the archive, for example if its download failed.
+		 */
+		bool abortFile();
+
+		/**
+		 * Add a file from the disk, reading it in chunks.
+		 */
+		bool addFile(const QString &name, const QString &path, bool compress);
+
+		/**
+		 * Most image and video formats are already compressed, so deflating them would only waste time.
+		 */
+		static bool shouldCompress(const QString &name);
+
+	protected:
+		struct Entry
+		{
+			QByteArray name;
+			quint16 method;
+			quint16 time;
+			quint16 date;
+			quint32 crc;
+			quint32 compressedSize;
+			quint32 size;
+			quint32 offset;
+		};
+
+		bool writeRaw(const char *data, qint64 size);
+		bool deflate(const char *data, qint64 size, bool finish);
+		void fail(const QString &error);
+
+	private:
+		QFile m_file;
+		QString m_error;
+		QList<Entry> m_entries;
+		bool m_inFile = false;
+		Entry m_current;
+		quint64 m_currentSize = 0;
+		quint64 m_currentCompressedSize = 0;
+		mz_stream_s *m_stream = nullptr;
+		QByteArray m_deflateBuffer;
+};
+
+#endif // ZIP_WRITER_H
@@ -103,7 +103,7 @@ bool getAllWindowsProperties(const QString &filename, QMap<QString, QString> &ou
 
 	delete pszFilename;
 
-	return SUCCEEDED(hr);
+	return SUCCEEDED(hr) && changed == properties.count();
 }
 
 bool getWindowsProperty(const QString &filename, const QString &property, QString &out)
@@ -137,7 +137,11 @@ bool getWindowsProperty(const QString &filename, const QString &property, QStrin
 
 bool setWindowsProperty(const QString &filename, const QString &property, const QString &value)
 {
-	PCWSTR pszFilename = toWCharT2(filename);
+	return setWindowsProperties(filename, { qMakePair(property, value) });
+}
+
+bool SetProperty(IPropertyStore *pps, const QString &filename, const QString &property, const QString &value)
+{
 	PCWSTR pszCanonicalName = toWCharT2(property);
 	PCWSTR pszValue = toWCharT2(value);
 
@@ -145,42 +149,58 @@ bool setWindowsProperty(const QString &filename, const QString &property, const
 	PROPERTYKEY key;
 	HRESULT hr = PSGetPropertyKeyFromName(pszCanonicalName, &key);
 	if (SUCCEEDED(hr)) {
-		IPropertyStore* pps = NULL;
-
-		// Call the helper to get the property store for the
-		// initialized item
-		hr = GetPropertyStore(pszFilename, GPS_READWRITE, &pps);
+		PROPVARIANT propvarValue = {0};
+		hr = InitPropVariantFromString(pszValue, &propvarValue);
 		if (SUCCEEDED(hr)) {
-			PROPVARIANT propvarValue = {0};
-			hr = InitPropVariantFromString(pszValue, &propvarValue);
+			hr = PSCoerceToCanonicalValue(key, &propvarValue);
 			if (SUCCEEDED(hr)) {
-				hr = PSCoerceToCanonicalValue(key, &propvarValue);
-				if (SUCCEEDED(hr)) {
-					// Set the value to the property store of the item.
-					hr = pps->SetValue(key, propvarValue);
-					if (SUCCEEDED(hr)) {
-						// Commit does the actual writing back to the file stream.
-						hr = pps->Commit();
-						if (!SUCCEEDED(hr)) {
-							log(QString("Error %1 committing to the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
-						}
-					} else {
-						log(QString("Error %1 setting value to the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
-					}
+				// Set the value to the property store of the item.
+				hr = pps->SetValue(key, propvarValue);
+				if (!SUCCEEDED(hr)) {
+					log(QString("Error %1 setting value to the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
 				}
-				PropVariantClear(&propvarValue);
 			}
-			pps->Release();
-		} else {
-			log(QString("Error %1 getting the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
+			PropVariantClear(&propvarValue);
 		}
 	} else {
 		log(QString("Invalid property specified: %1").arg(property), Logger::Error);
 	}
 
-	delete pszFilename;
 	delete pszCanonicalName;
 	delete pszValue;
 
 	return SUCCEEDED(hr);
 }
+
+bool setWindowsProperties(const QString &filename, const QList<QPair<QString, QString>> &properties)
+{
+	PCWSTR pszFilename = toWCharT2(filename);
+	IPropertyStore* pps = NULL;
+	int changed = 0;
+
+	// Call the helper to get the property store for the initialized item
+	// Opening it and committing it are the slow parts, so they are only done once for all the properties
+	HRESULT hr = GetPropertyStore(pszFilename, GPS_READWRITE, &pps);
+	if (SUCCEEDED(hr)) {
+		for (const auto &property : properties) {
+			if (SetProperty(pps, filename, property.first, property.second)) {
+				changed++;
+			}
+		}
+
+		// Commit does the actual writing back to the file stream.
+		if (changed > 0) {
+			hr = pps->Commit();
+			if (!SUCCEEDED(hr)) {
+				log(QString("Error %1 committing to the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
+			}
+		}
+		pps->Release();
+	} else {
+		log(QString("Error %1 getting the propertystore for `%2`").arg(hr).arg(filename), Logger::Error);
+	}
+
+	delete pszFilename;
+
+	return SUCCEEDED(hr) && changed == properties.count();
+}
@@ -2,7 +2,9 @@
 #define WINDOWS_FILE_PROPERTY_H
 
 #include <Windows.h>
+#include <QList>
 #include <QMap>
+#include <QPair>
 #include <QString>
 
 
@@ -12,5 +14,6 @@ void uninitializeWindowsProperties();
 bool getAllWindowsProperties(const QString &filename, QMap<QString, QString> &out);
 bool getWindowsProperty(const QString &filename, const QString &property, QString &out);
 bool setWindowsProperty(const QString &filename, const QString &property, const QString &value);
+bool setWindowsProperties(const QString &filename, const QList<QPair<QString, QString>> &properties);
 
 #endif // WINDOWS_FILE_PROPERTY_H
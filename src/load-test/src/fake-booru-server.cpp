@@ -0,0 +1,238 @@
+#include "fake-booru-server.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+#include <utility>
+
+#define MAX_LIMIT 200
+#define MAX_HEADER_SIZE (64 * 1024)
+
+
+static QString postMd5(int id)
+{
+	return QCryptographicHash::hash(QByteArray::number(id), QCryptographicHash::Md5).toHex();
+}
+
+static QByteArray statusText(int status)
+{
+	switch (status) {
+		case 200: return "OK";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 429: return "Too Many Requests";
+		default: return "Internal Server Error";
+	}
+}
+
+
+FakeBooruServer::FakeBooruServer(Config config, QObject *parent)
+	: QObject(parent), m_config(std::move(config))
+{
+	m_server = new QTcpServer(this);
+	connect(m_server, &QTcpServer::newConnection, this, &FakeBooruServer::newConnection);
+
+	// Same content for all files, with the JPEG markers so that it is detected as such
+	m_file = QByteArray(qMax(4, m_config.fileSize), '\0');
+	m_file[0] = '\xFF';
+	m_file[1] = '\xD8';
+	m_file[2] = '\xFF';
+	m_file[3] = '\xE0';
+	m_file[m_file.size() - 2] = '\xFF';
+	m_file[m_file.size() - 1] = '\xD9';
+}
+
+bool FakeBooruServer::listen(quint16 port)
+{
+	return m_server->listen(QHostAddress::LocalHost, port);
+}
+
+quint16 FakeBooruServer::serverPort() const
+{
+	return m_server->serverPort();
+}
+
+const FakeBooruServer::Stats &FakeBooruServer::stats() const
+{
+	return m_stats;
+}
+
+void FakeBooruServer::resetStats()
+{
+	m_stats = Stats();
+}
+
+
+void FakeBooruServer::newConnection()
+{
+	while (m_server->hasPendingConnections()) {
+		QTcpSocket *socket = m_server->nextPendingConnection();
+		m_buffers.insert(socket, QByteArray());
+		connect(socket, &QTcpSocket::readyRead, this, &FakeBooruServer::readyRead);
+		connect(socket, &QTcpSocket::disconnected, this, &FakeBooruServer::disconnected);
+	}
+}
+
+void FakeBooruServer::disconnected()
+{
+	auto *socket = qobject_cast<QTcpSocket*>(sender());
+	m_buffers.remove(socket);
+	socket->deleteLater();
+}
+
+/**
+ * Requests have no body since they are all GET, so each one ends with the first empty line.
+ */
+void FakeBooruServer::readyRead()
+{
+	auto *socket = qobject_cast<QTcpSocket*>(sender());
+	QByteArray &buffer = m_buffers[socket];
+	buffer.append(socket->readAll());
+
+	int end;
+	while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+		const QByteArray head = buffer.left(end);
+		buffer.remove(0, end + 4);
+
+		const QList<QByteArray> requestLine = head.left(head.indexOf("\r\n")).split(' ');
+		if (requestLine.count() < 2) {
+			socket->disconnectFromHost();
+			return;
+		}
+
+		handle(socket, requestLine[0], QUrl::fromEncoded(requestLine[1]));
+	}
+
+	if (buffer.size() > MAX_HEADER_SIZE) {
+		socket->disconnectFromHost();
+	}
+}
+
+/**
+ * Fixed-window limit over all the connections, like most sites do per IP.
+ */
+bool FakeBooruServer::rateLimited()
+{
+	if (m_config.rateLimit <= 0) {
+		return false;
+	}
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	if (now - m_windowStart >= 1000) {
+		m_windowStart = now;
+		m_windowRequests = 0;
+	}
+	return ++m_windowRequests > m_config.rateLimit;
+}
+
+void FakeBooruServer::handle(QTcpSocket *socket, const QByteArray &method, const QUrl &url)
+{
+	const QString path = url.path();
+	const bool isFile = path.startsWith("/data/");
+	const int latency = isFile ? m_config.fileLatency : m_config.pageLatency;
+
+	if (method != "GET") {
+		respond(socket, 0, 405, "text/plain", "Only GET requests are supported");
+		return;
+	}
+	if (rateLimited()) {
+		m_stats.rateLimited++;
+		respond(socket, 0, 429, "text/plain", "Rate limit exceeded", "Retry-After: 1\r\n");
+		return;
+	}
+	if (m_config.errorRate > 0 && QRandomGenerator::global()->generateDouble() < m_config.errorRate) {
+		m_stats.errors++;
+		respond(socket, latency, 500, "text/plain", "Random error");
+		return;
+	}
+
+	if (path == "/posts.json") {
+		m_stats.pages++;
+		respond(socket, latency, 200, "application/json", posts(url));
+	} else if (isFile) {
+		m_stats.files++;
+		respond(socket, latency, 200, "image/jpeg", m_file);
+	} else {
+		respond(socket, latency, 404, "text/plain", "Not found");
+	}
+}
+
+void FakeBooruServer::respond(QTcpSocket *socket, int latency, int status, const QByteArray &contentType, const QByteArray &body, const QByteArray &extraHeaders)
+{
+	QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n"
+		+ "Content-Type: " + contentType + "\r\n"
+		+ "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+		+ "Connection: keep-alive\r\n"
+		+ extraHeaders
+		+ "\r\n";
+	response.append(body);
+
+	m_stats.bytes += response.size();
+
+	QPointer<QTcpSocket> ptr(socket);
+	const auto write = [ptr, response]() {
+		if (!ptr.isNull() && ptr->state() == QTcpSocket::ConnectedState) {
+			ptr->write(response);
+		}
+	};
+	if (latency > 0) {
+		QTimer::singleShot(latency, this, write);
+	} else {
+		write();
+	}
+}
+
+/**
+ * Supports both page numbers and the "b<id>" / "a<id>" pages used by Danbooru to browse from a known ID.
+ */
+QByteArray FakeBooruServer::posts(const QUrl &url) const
+{
+	const QUrlQuery query(url);
+	const int limit = qBound(1, query.queryItemValue("limit").toInt(), MAX_LIMIT);
+	const QString page = query.queryItemValue("page");
+
+	int first;
+	if (page.startsWith('b')) {
+		first = page.mid(1).toInt() - 1;
+	} else if (page.startsWith('a')) {
+		first = qMin(m_config.posts, page.mid(1).toInt() + limit);
+	} else {
+		first = m_config.posts - (qMax(1, page.toInt()) - 1) * limit;
+	}
+
+	QJsonArray ret;
+	for (int id = first; id > 0 && id > first - limit; --id) {
+		const QString md5 = postMd5(id);
+		ret.append(QJsonObject {
+			{ "id", id },
+			{ "md5", md5 },
+			{ "created_at", QDateTime::fromSecsSinceEpoch(1600000000 + id * 60).toString(Qt::ISODate) },
+			{ "rating", "s" },
+			{ "score", id % 100 },
+			{ "uploader_id", 1 },
+			{ "source", "" },
+			{ "image_width", 1000 },
+			{ "image_height", 1000 },
+			{ "file_ext", "jpg" },
+			{ "file_size", m_config.fileSize },
+			{ "file_url", "/data/" + md5 + ".jpg" },
+			{ "large_file_url", "/data/" + md5 + ".jpg" },
+			{ "preview_file_url", "/data/preview/" + md5 + ".jpg" },
+			{ "tag_string", QStringLiteral("artist%1 character%2 tag%3 tag%4").arg(id % 50).arg(id % 200).arg(id % 1000).arg(id % 7) },
+			{ "tag_string_artist", QStringLiteral("artist%1").arg(id % 50) },
+			{ "tag_string_character", QStringLiteral("character%1").arg(id % 200) },
+			{ "tag_string_copyright", "" },
+			{ "tag_string_general", QStringLiteral("tag%1 tag%2").arg(id % 1000).arg(id % 7) },
+			{ "tag_string_meta", "" },
+		});
+	}
+
+	return QJsonDocument(ret).toJson(QJsonDocument::Compact);
+}
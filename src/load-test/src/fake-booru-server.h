@@ -0,0 +1,75 @@
+#ifndef FAKE_BOORU_SERVER_H
+#define FAKE_BOORU_SERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * Minimal HTTP server imitating the JSON API of a Danbooru 2 site, with controllable latency, rate limits and errors.
+ *
+ * It is meant to be used as the HTTP proxy of the application, so that any host name can be pointed to it: requests
+ * are accepted both in origin-form ("/posts.json") and in absolute-form ("http://host/posts.json").
+ *   - "/posts.json?limit=&page=" returns generated posts, from the newest ID down to 1.
+ *   - "/data/<md5>.jpg" returns a file of the configured size.
+ */
+class FakeBooruServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		struct Config
+		{
+			int posts = 10000; // Total number of posts
+			int pageLatency = 0; // ms
+			int fileLatency = 0; // ms
+			int fileSize = 100 * 1024; // bytes
+			int rateLimit = 0; // Requests per second before answering 429, 0 for none
+			double errorRate = 0; // Ratio of requests answered with a 500 error
+		};
+
+		struct Stats
+		{
+			int pages = 0;
+			int files = 0;
+			int rateLimited = 0;
+			int errors = 0;
+			qint64 bytes = 0;
+		};
+
+		explicit FakeBooruServer(Config config, QObject *parent = nullptr);
+		bool listen(quint16 port = 0);
+		quint16 serverPort() const;
+		const Stats &stats() const;
+		void resetStats();
+
+	protected slots:
+		void newConnection();
+		void readyRead();
+		void disconnected();
+
+	protected:
+		void handle(QTcpSocket *socket, const QByteArray &method, const QUrl &url);
+		void respond(QTcpSocket *socket, int latency, int status, const QByteArray &contentType, const QByteArray &body, const QByteArray &extraHeaders = QByteArray());
+		QByteArray posts(const QUrl &url) const;
+		bool rateLimited();
+
+	private:
+		Config m_config;
+		Stats m_stats;
+		QTcpServer *m_server;
+		QHash<QTcpSocket*, QByteArray> m_buffers;
+		QByteArray m_file;
+
+		// Rate limiting
+		qint64 m_windowStart = 0;
+		int m_windowRequests = 0;
+};
+
+#endif // FAKE_BOORU_SERVER_H
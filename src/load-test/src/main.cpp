@@ -0,0 +1,226 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkProxy>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "downloader/batch-downloader.h"
+#include "downloader/batch-engine.h"
+#include "downloader/download-query-group.h"
+#include "fake-booru-server.h"
+#include "logger.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "models/source.h"
+
+#if defined(Q_OS_WIN)
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#define SOURCE_NAME "Danbooru (2.0)"
+#define SITE_URL "danbooru.load-test"
+
+
+struct ProcessUsage
+{
+	qint64 cpuTime = 0; // ms
+	qint64 peakMemory = 0; // bytes
+};
+
+/**
+ * The peak memory usage is the one of the whole process so far, as it can't be reset between runs.
+ */
+static ProcessUsage processUsage()
+{
+	ProcessUsage ret;
+
+	#if defined(Q_OS_WIN)
+		FILETIME creation, exit, kernel, user;
+		if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+			const auto toMs = [](const FILETIME &time) {
+				return ((static_cast<qint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000;
+			};
+			ret.cpuTime = toMs(kernel) + toMs(user);
+		}
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			ret.peakMemory = static_cast<qint64>(counters.PeakWorkingSetSize);
+		}
+	#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) == 0) {
+			ret.cpuTime = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+			#if defined(Q_OS_MACOS)
+				ret.peakMemory = usage.ru_maxrss;
+			#else
+				ret.peakMemory = static_cast<qint64>(usage.ru_maxrss) * 1024;
+			#endif
+		}
+	#endif
+
+	return ret;
+}
+
+static Site *makeSite(Profile *profile)
+{
+	Source *source = profile->getSources().value(SOURCE_NAME);
+	if (source == nullptr) {
+		return nullptr;
+	}
+
+	auto *site = new Site(SITE_URL, source);
+	site->setSetting("ssl", false, false);
+	site->setSetting("sources/usedefault", false, true);
+	site->setSetting("sources/source_1", "json", "");
+	site->syncSettings();
+	site->loadConfig();
+
+	profile->addSite(site);
+	return site;
+}
+
+static QJsonObject run(Profile *profile, Site *site, FakeBooruServer &server, int concurrency, int images, int perPage, const QString &path)
+{
+	profile->getSettings()->setValue("Save/simultaneous", concurrency);
+	site->setSetting("download/simultaneous", concurrency, 10);
+	site->loadConfig();
+	server.resetStats();
+
+	DownloadQueryGroup group(QStringList(), 1, perPage, images, QStringList(), true, site, "%md5%.%ext%", path);
+
+	BatchEngine engine;
+	BatchDownloader *downloader = engine.createDownloader(&group, profile);
+
+	QEventLoop loop;
+	QObject::connect(downloader, &BatchDownloader::finished, &loop, &QEventLoop::quit);
+
+	const ProcessUsage before = processUsage();
+	QElapsedTimer timer;
+	timer.start();
+	engine.start(downloader);
+	loop.exec();
+	const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+	const ProcessUsage after = processUsage();
+
+	const int downloaded = downloader->downloadedCount(BatchDownloader::Downloaded);
+	const int errors = downloader->downloadedCount(BatchDownloader::Errors);
+	const FakeBooruServer::Stats &stats = server.stats();
+	engine.remove(downloader);
+
+	return QJsonObject {
+		{ "concurrency", concurrency },
+		{ "images", downloaded },
+		{ "errors", errors },
+		{ "elapsed", elapsed },
+		{ "imagesPerSecond", downloaded * 1000.0 / elapsed },
+		{ "cpuPerImage", downloaded > 0 ? static_cast<double>(after.cpuTime - before.cpuTime) / downloaded : 0.0 },
+		{ "peakMemory", after.peakMemory },
+		{ "pageRequests", stats.pages },
+		{ "fileRequests", stats.files },
+		{ "rateLimited", stats.rateLimited },
+		{ "serverErrors", stats.errors },
+	};
+}
+
+int main(int argc, char *argv[])
+{
+	const QCoreApplication app(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+
+	const QCommandLineOption imagesOption(QStringList() << "images", "Number of images downloaded by each run", "count", "1000");
+	const QCommandLineOption perPageOption(QStringList() << "perpage", "Number of images per page", "count", "100");
+	const QCommandLineOption concurrencyOption(QStringList() << "concurrency", "Comma-separated list of simultaneous downloads to run with", "list", "1,2,4,8");
+	const QCommandLineOption pageLatencyOption(QStringList() << "page-latency", "Latency of the server for result pages", "ms", "0");
+	const QCommandLineOption fileLatencyOption(QStringList() << "file-latency", "Latency of the server for files", "ms", "0");
+	const QCommandLineOption fileSizeOption(QStringList() << "file-size", "Size of the downloaded files", "bytes", "102400");
+	const QCommandLineOption rateLimitOption(QStringList() << "rate-limit", "Requests per second accepted by the server before answering 429 errors (0 for none)", "count", "0");
+	const QCommandLineOption errorRateOption(QStringList() << "error-rate", "Ratio of the requests answered with a 500 error", "ratio", "0");
+	const QCommandLineOption outputOption(QStringList() << "o" << "output", "Write the results as JSON to the given file", "output");
+	parser.addOption(imagesOption);
+	parser.addOption(perPageOption);
+	parser.addOption(concurrencyOption);
+	parser.addOption(pageLatencyOption);
+	parser.addOption(fileLatencyOption);
+	parser.addOption(fileSizeOption);
+	parser.addOption(rateLimitOption);
+	parser.addOption(errorRateOption);
+	parser.addOption(outputOption);
+	parser.process(app);
+
+	Logger::getInstance().setLogLevel(Logger::Warning);
+
+	const int images = qMax(1, parser.value(imagesOption).toInt());
+	const int perPage = qMax(1, parser.value(perPageOption).toInt());
+
+	FakeBooruServer::Config config;
+	config.posts = images;
+	config.pageLatency = parser.value(pageLatencyOption).toInt();
+	config.fileLatency = parser.value(fileLatencyOption).toInt();
+	config.fileSize = parser.value(fileSizeOption).toInt();
+	config.rateLimit = parser.value(rateLimitOption).toInt();
+	config.errorRate = parser.value(errorRateOption).toDouble();
+
+	FakeBooruServer server(config);
+	if (!server.listen()) {
+		qCritical() << "Could not start the server";
+		return 1;
+	}
+
+	// All requests go through the server, whatever their host
+	QNetworkProxy::setApplicationProxy(QNetworkProxy(QNetworkProxy::HttpProxy, "127.0.0.1", server.serverPort()));
+
+	QTemporaryDir dir;
+	auto *profile = new Profile(dir.path());
+	profile->getSettings()->setValue("Save/md5Duplicates", "save");
+	profile->getSettings()->setValue("Save/md5DuplicatesSameDir", "save");
+
+	Site *site = makeSite(profile);
+	if (site == nullptr) {
+		qCritical() << "Source not found:" << SOURCE_NAME;
+		return 1;
+	}
+
+	QTextStream out(stdout);
+	out << QString("%1 %2 %3 %4 %5 %6 %7")
+		.arg("Concurrency", 12).arg("Images", 8).arg("Images/s", 10).arg("CPU/image", 10).arg("Peak MB", 8).arg("429", 6).arg("500", 6) << endl;
+
+	QJsonArray results;
+	for (const QString &value : parser.value(concurrencyOption).split(',', Qt::SkipEmptyParts)) {
+		const int concurrency = qMax(1, value.toInt());
+		const QJsonObject result = run(profile, site, server, concurrency, images, perPage, dir.path() + "/images-" + QString::number(concurrency));
+		results.append(result);
+
+		out << QString("%1 %2 %3 %4 %5 %6 %7")
+			.arg(concurrency, 12)
+			.arg(result["images"].toInt(), 8)
+			.arg(result["imagesPerSecond"].toDouble(), 10, 'f', 1)
+			.arg(QString::number(result["cpuPerImage"].toDouble(), 'f', 2) + "ms", 10)
+			.arg(result["peakMemory"].toDouble() / (1024 * 1024), 8, 'f', 1)
+			.arg(result["rateLimited"].toInt(), 6)
+			.arg(result["serverErrors"].toInt(), 6) << endl;
+	}
+
+	if (parser.isSet(outputOption)) {
+		QFile f(parser.value(outputOption));
+		if (f.open(QFile::WriteOnly | QFile::Truncate)) {
+			f.write(QJsonDocument(results).toJson());
+			f.close();
+		}
+	}
+
+	delete profile;
+	return 0;
+}
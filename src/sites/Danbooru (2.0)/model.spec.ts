@@ -11,6 +11,14 @@ describe("Danbooru (2.0)", () => {
                 expect(search(source.apis.json, "tag1", 2)).toEqual("/posts.json?limit=10&page=2&tags=tag1");
             });
 
+            it("uses the previous page's IDs when preferred", () => {
+                const previous: IPreviousSearch = { page: 1, minIdM1: "99", minId: "100", minDate: "", maxId: "200", maxIdP1: "201", maxDate: "" };
+                const opts = { limit: 10, loggedIn: false, baseUrl: "/" };
+                expect(source.apis.json.search.url({ search: "tag1", page: 2 }, opts, previous)).toEqual("/posts.json?limit=10&page=2&tags=tag1");
+                expect(source.apis.json.search.url({ search: "tag1", page: 2 }, opts, { ...previous, preferCursor: true })).toEqual("/posts.json?limit=10&page=b100&tags=tag1");
+                expect(source.apis.json.search.url({ search: "tag1", page: 3 }, opts, { ...previous, preferCursor: true })).toEqual("/posts.json?limit=10&page=3&tags=tag1");
+            });
+
             it("parses the response correctly", () => {
                 const src = readFileSync(__dirname + "/resources/search.json", "utf8");
                 const res = source.apis.json.search.parse(src, 200) as IParsedSearch;
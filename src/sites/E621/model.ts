@@ -43,6 +43,8 @@ export const source: ISource = {
             maxLimit: 200,
             search: {
                 parseErrors: true,
+                batchIds: { prefix: "id:", separator: ",", max: 100 },
+                batchMd5s: { prefix: "md5:", separator: ",", max: 100 },
                 url: (query: ISearchQuery, opts: IUrlOptions, previous: IPreviousSearch | undefined): string | IError => {
                     try {
                         const pagePart = Grabber.pageUrl(query.page, previous, 750, "{page}", "a{max}", "b{min}");
@@ -134,6 +134,9 @@ addHelper("fixPageUrl", (url: string, page: number, previous: IPreviousSearch |
 
 addHelper("pageUrl", (page: number, previous: IPreviousSearch | undefined, limit: number, ifBelow: string, ifPrev: string, ifNext: string, pageTransformer?: (page: number) => number): string => {
     const pageLimit = pageTransformer ? pageTransformer(page) : page;
+    if (ifNext && previous && previous.preferCursor && previous.page === page - 1) {
+        return Grabber.fixPageUrl(ifNext, page, previous, pageTransformer);
+    }
     if (pageLimit <= limit || limit < 0) {
         return Grabber.fixPageUrl(ifBelow, page, previous, pageTransformer);
     }
@@ -102,6 +102,16 @@ interface IImage {
     preview_file_size?: number;
     preview_rect?: string;
 
+    /**
+     * Other formats of the thumbnail, by format name. Used instead of "preview_url" when one of them matches the
+     * preferred thumbnail formats of the source.
+     *
+     * @example { "webp": "https://example.com/thumbnails/123.webp" }
+     */
+    preview_variants?: {
+        [format: string]: string;
+    };
+
     // Additional raw tokens to pass to the filename
     tokens?: {
         [key: string]: any;
@@ -646,6 +656,36 @@ interface IPreviousSearch {
      * The biggest date in the results.
      */
     maxDate: string;
+
+    /**
+     * Whether the next page should be loaded from the previous page's IDs even when its number is below the limit,
+     * as server-side offsets get slower for deep pages.
+     */
+    preferCursor?: boolean;
+}
+
+/**
+ * Field mappings to extract images natively from a response, without going through the "parse" function.
+ *
+ * For JSON, paths are JSON pointers, such as "/posts" or "/file/url".
+ * For XML, paths are element names separated by slashes, the list of images starting from the root element (such as
+ * "posts/post") and fields from the image's element. The last part can be an attribute, such as "@file_url".
+ */
+interface IExtract {
+    format?: "json" | "xml";
+
+    /**
+     * Path to the list of images.
+     */
+    images: string;
+
+    /**
+     * Path of each image field, relative to the image. Arrays are joined the same way as in "parse" results.
+     */
+    fields: { [field: string]: string };
+
+    imageCount?: string;
+    pageCount?: string;
 }
 
 /**
@@ -690,7 +730,40 @@ interface IApi {
          */
         parseInput?: boolean;
         parseErrors?: boolean;
+
+        /**
+         * How to search for several posts at once using their ID, used to load the details of many images in a single
+         * request. For example, `{ prefix: "id:", separator: "," }` will search for "id:1,2,3".
+         */
+        batchIds?: {
+            prefix: string;
+            separator: string;
+
+            /**
+             * The maximum number of IDs in a single search. Defaults to the API's "maxLimit".
+             */
+            max?: number;
+        };
+
+        /**
+         * How to search for several posts at once using their MD5, used to get the tags of many local files in a
+         * single request. For example, `{ prefix: "md5:", separator: "," }` will search for "md5:abc,def".
+         */
+        batchMd5s?: {
+            prefix: string;
+            separator: string;
+
+            /**
+             * The maximum number of MD5s in a single search. Defaults to the API's "maxLimit".
+             */
+            max?: number;
+        };
         url: (query: ISearchQuery, opts: IUrlOptions, previous: IPreviousSearch | undefined) => IUrl | IError | string;
+
+        /**
+         * Faster native extraction for simple responses. The "parse" function is only used if it fails.
+         */
+        extract?: IExtract;
         parse: (src: string, statusCode: number) => IParsedSearch | IError;
     };
 
@@ -710,6 +783,7 @@ interface IApi {
     gallery?: {
         parseErrors?: boolean;
         url: (query: IGalleryQuery, opts: IUrlOptions) => IUrl | IError | string;
+        extract?: IExtract;
         parse: (src: string, statusCode: number) => IParsedGallery | IError;
     };
 
@@ -789,6 +863,14 @@ interface ISource {
      */
     searchFormat?: SearchFormat;
 
+    /**
+     * Thumbnail formats to use when the images give "preview_variants", by order of preference. Formats that can't be
+     * displayed are skipped.
+     *
+     * @example ["avif", "webp"]
+     */
+    thumbnailFormats?: string[];
+
     /**
      * Meta fields that can be used to search.
      *
@@ -0,0 +1,68 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include "cli/cli-server.h"
+#include "models/profile.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+static QJsonObject sendJob(QLocalSocket &socket, const QByteArray &job)
+{
+	// The server is in the same thread, so we need to run the event loop while waiting
+	QSignalSpy spy(&socket, SIGNAL(readyRead()));
+	socket.write(job + "\n");
+	socket.flush();
+
+	while (!socket.canReadLine()) {
+		if (!spy.wait(5000)) {
+			return QJsonObject();
+		}
+	}
+
+	return QJsonDocument::fromJson(socket.readLine()).object();
+}
+
+
+TEST_CASE("CliServer")
+{
+	const QScopedPointer<Profile> profile(makeProfile());
+
+	CliServer server(profile.data());
+	REQUIRE(server.listen("grabber-cli-server-test"));
+
+	QLocalSocket socket;
+	socket.connectToServer("grabber-cli-server-test");
+	REQUIRE(socket.waitForConnected(5000));
+
+	SECTION("Rejects invalid JSON")
+	{
+		const QJsonObject response = sendJob(socket, "not json");
+		REQUIRE(response.contains("error"));
+	}
+
+	SECTION("Rejects unknown commands")
+	{
+		const QJsonObject response = sendJob(socket, R"({"id": 1, "command": "unknown"})");
+		REQUIRE(response.value("error").toString() == QString("Unknown command: unknown"));
+		REQUIRE(response.value("id").toInt() == 1);
+	}
+
+	SECTION("Rejects invalid parameters")
+	{
+		const QJsonObject response = sendJob(socket, R"({"id": 2, "command": "images", "tags": "test", "max": 0})");
+		REQUIRE(response.contains("error"));
+		REQUIRE(response.value("id").toInt() == 2);
+	}
+
+	SECTION("Quit")
+	{
+		QSignalSpy spy(&server, SIGNAL(quit()));
+		const QJsonObject response = sendJob(socket, R"({"command": "quit"})");
+		REQUIRE(response.value("finished").toBool() == true);
+		REQUIRE(response.value("code").toInt() == 0);
+		REQUIRE(spy.count() == 1);
+	}
+}
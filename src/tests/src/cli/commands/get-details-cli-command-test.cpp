@@ -1,3 +1,4 @@
+#include <QBuffer>
 #include "catch.h"
 #include "cli/commands/get-details-cli-command.h"
 
@@ -16,4 +17,20 @@ TEST_CASE("GetDetailsCliCommand")
 		REQUIRE(GetDetailsCliCommand(nullptr, nullptr, {}, "pageUrl").validate() == false);
 		REQUIRE(GetDetailsCliCommand(nullptr, nullptr, { nullptr, nullptr }, "pageUrl").validate() == false);
 	}
+
+	SECTION("Validate lists")
+	{
+		REQUIRE(GetDetailsCliCommand(nullptr, nullptr, { nullptr }, QStringList { "1", "pageUrl" }).validate() == true);
+		REQUIRE(GetDetailsCliCommand(nullptr, nullptr, { nullptr }, QStringList()).validate() == false);
+	}
+
+	SECTION("Read entries")
+	{
+		QByteArray data("123\n\n  https://example.com/post/456  \n# comment\n789");
+		QBuffer buffer(&data);
+		buffer.open(QIODevice::ReadOnly);
+
+		const QStringList entries = GetDetailsCliCommand::readEntries(&buffer);
+		REQUIRE(entries == QStringList { "123", "https://example.com/post/456", "789" });
+	}
 }
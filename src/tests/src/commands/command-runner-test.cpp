@@ -0,0 +1,37 @@
+#include <QAtomicInt>
+#include "commands/command-runner.h"
+#include "catch.h"
+
+
+TEST_CASE("CommandRunner")
+{
+	SECTION("Callback called right away when idle")
+	{
+		CommandRunner runner(2, 1000);
+
+		bool called = false;
+		runner.whenDone([&called]() { called = true; });
+
+		REQUIRE(called);
+	}
+
+	SECTION("Callback called once all commands finished")
+	{
+		CommandRunner runner(2, 1000);
+		runner.run("a", "not_existing_program_for_tests 1");
+		runner.run("a", "not_existing_program_for_tests 2");
+		runner.run("b", "not_existing_program_for_tests 3");
+
+		QAtomicInt called = 0;
+		runner.whenDone([&called]() { called.ref(); });
+		REQUIRE(runner.waitForDone(10000));
+
+		REQUIRE(called.load() == 1);
+	}
+
+	SECTION("Execute non-existing program")
+	{
+		REQUIRE(!CommandRunner::execute("not_existing_program_for_tests", 1000));
+		REQUIRE(!CommandRunner::execute("", 1000));
+	}
+}
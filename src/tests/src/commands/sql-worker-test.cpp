@@ -2,6 +2,7 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QStringList>
 #include <QVariant>
 #include "commands/sql-worker.h"
 #include "catch.h"
@@ -76,4 +77,50 @@ TEST_CASE("SqlWorkerTest")
 
 		REQUIRE(values == QList<int>() << 1 << 3 << 21);
 	}
+
+	SECTION("Exec with bound values")
+	{
+		SqlWorker worker("QSQLITE", "", "", "", "test_sql_worker.db", nullptr);
+
+		REQUIRE(worker.execute("CREATE TABLE IF NOT EXISTS test_table (some_value INT, some_text TEXT);"));
+		REQUIRE(worker.execute("INSERT INTO test_table (some_value, some_text) VALUES (?, ?);", QVariantList() << 1 << "it's"));
+		REQUIRE(worker.execute("INSERT INTO test_table (some_value, some_text) VALUES (?, ?);", QVariantList() << 2 << "test"));
+
+		QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "SQL worker test database");
+		db.setDatabaseName("test_sql_worker.db");
+		REQUIRE(db.open());
+
+		QSqlQuery query = db.exec("SELECT some_value, some_text FROM test_table");
+		QStringList values;
+		while (query.next()) {
+			values.append(query.value(0).toString() + ":" + query.value(1).toString());
+		}
+
+		REQUIRE(values == QStringList() << "1:it's" << "2:test");
+	}
+
+	SECTION("Queued statements are run on flush")
+	{
+		SqlWorker worker("QSQLITE", "", "", "", "test_sql_worker.db", nullptr);
+		worker.setBatching(100, 60000);
+
+		worker.queue("CREATE TABLE IF NOT EXISTS test_table (some_value INT);");
+		worker.queue("INSERT INTO test_table (some_value) VALUES (?);", QVariantList() << 1);
+		worker.queue("INSERT INTO test_table (some_value) VALUES (?);", QVariantList() << 3);
+
+		QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "SQL worker test database");
+		db.setDatabaseName("test_sql_worker.db");
+		REQUIRE(db.open());
+		REQUIRE(!db.tables().contains("test_table"));
+
+		worker.flush();
+
+		QSqlQuery query = db.exec("SELECT some_value FROM test_table");
+		QList<int> values;
+		while (query.next()) {
+			values.append(query.value(0).toInt());
+		}
+
+		REQUIRE(values == QList<int>() << 1 << 3);
+	}
 }
@@ -43,6 +43,7 @@ void setupSite(const QString &source, const QString &site, QString dir)
 	QFile::remove(dir + "/defaults.ini");
 	QFile::remove(dir + "/settings.ini");
 	QFile::remove(dir + "/tag-types.txt");
+	QFile::remove(dir + "/apis.json");
 	if (QFile::exists("sites/" + source + "/" + site + "/defaults.ini")) {
 		QFile("sites/" + source + "/" + site + "/defaults.ini").copy(dir + "/defaults.ini");
 	}
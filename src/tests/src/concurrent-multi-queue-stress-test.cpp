@@ -0,0 +1,96 @@
+#include <QHash>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTimer>
+#include "concurrent-multi-queue.h"
+#include "catch.h"
+
+#define STRESS_ITEMS 5000
+#define STRESS_KEYS 10
+
+
+TEST_CASE("ConcurrentMultiQueue stress", "[stress]")
+{
+	QRandomGenerator random(1337);
+
+	ConcurrentMultiQueue multiQueue;
+	multiQueue.setGlobalConcurrency(8);
+	multiQueue.setKeyConcurrency(2);
+	multiQueue.setKeyConcurrency("key0", 1);
+
+	// Violations are only counted in the callbacks, as Catch assertions can't be thrown through the event loop
+	int active = 0;
+	int maxActive = 0;
+	int violations = 0;
+	QHash<QString, int> keyActive;
+	QSet<int> seen;
+	int duplicates = 0;
+
+	const auto keyOf = [](int item) {
+		return QStringLiteral("key%1").arg(item % STRESS_KEYS);
+	};
+
+	QObject::connect(&multiQueue, &ConcurrentMultiQueue::dequeued, [&](const QVariant &next) {
+		const int item = next.toInt();
+		const QString key = keyOf(item);
+
+		if (seen.contains(item)) {
+			duplicates++;
+		}
+		seen.insert(item);
+
+		active++;
+		maxActive = qMax(maxActive, active);
+		if (active > multiQueue.globalConcurrency() || ++keyActive[key] > multiQueue.keyConcurrency(key)) {
+			violations++;
+		}
+
+		// Items finish in a random order, some of them synchronously
+		const int latency = static_cast<int>(random.bounded(3)) - 1;
+		const auto done = [&, key]() {
+			active--;
+			keyActive[key]--;
+			multiQueue.next(key);
+		};
+		if (latency < 0) {
+			done();
+		} else {
+			QTimer::singleShot(latency, &multiQueue, done);
+		}
+	});
+
+	QSignalSpy spy(&multiQueue, SIGNAL(finished()));
+
+	// Half of the items are added upfront, the rest while the first ones are running
+	for (int i = 0; i < STRESS_ITEMS / 2; ++i) {
+		multiQueue.append(static_cast<int>(random.bounded(3)), i, keyOf(i));
+	}
+	for (int i = STRESS_ITEMS / 2; i < STRESS_ITEMS; ++i) {
+		QTimer::singleShot(static_cast<int>(random.bounded(20)), &multiQueue, [&multiQueue, &random, keyOf, i]() {
+			multiQueue.append(static_cast<int>(random.bounded(3)), i, keyOf(i));
+		});
+	}
+
+	// The queue might be momentarily empty before the delayed items are added
+	while (seen.count() < STRESS_ITEMS || active > 0) {
+		if (!spy.wait(10000)) {
+			break;
+		}
+	}
+
+	REQUIRE(seen.count() == STRESS_ITEMS);
+	REQUIRE(duplicates == 0);
+	REQUIRE(violations == 0);
+	REQUIRE(maxActive <= 8);
+	REQUIRE(active == 0);
+
+	// All the slots were released, so the queue still processes new items at full concurrency
+	const int before = seen.count();
+	for (int i = 0; i < 8; ++i) {
+		multiQueue.append(0, STRESS_ITEMS + i * STRESS_KEYS + 1, keyOf(1));
+	}
+	REQUIRE(spy.wait());
+	REQUIRE(seen.count() == before + 8);
+	REQUIRE(violations == 0);
+}
@@ -54,4 +54,67 @@ TEST_CASE("ConcurrentMultiQueue")
 
 		REQUIRE(results == QList<int>() << 4 << 5 << 2 << 6 << 1 << 3);
 	}
+
+	SECTION("Round-robin between keys")
+	{
+		QList<int> results;
+		ConcurrentMultiQueue multiQueue;
+		QObject::connect(&multiQueue, &ConcurrentMultiQueue::dequeued, [&](QVariant item) {
+			results.append(item.toInt());
+			multiQueue.next(item.toInt() < 10 ? "a" : "b");
+		});
+
+		QSignalSpy spy(&multiQueue, SIGNAL(finished()));
+		multiQueue.append(0, 1, "a");
+		multiQueue.append(0, 2, "a");
+		multiQueue.append(0, 3, "a");
+		multiQueue.append(0, 11, "b");
+		multiQueue.append(0, 12, "b");
+		REQUIRE(spy.wait());
+
+		REQUIRE(results == QList<int>() << 1 << 11 << 2 << 12 << 3);
+	}
+
+	SECTION("Key concurrency")
+	{
+		QList<int> results;
+		ConcurrentMultiQueue multiQueue;
+		multiQueue.setGlobalConcurrency(3);
+		multiQueue.setKeyConcurrency(1);
+		multiQueue.setKeyConcurrency("b", 2);
+		REQUIRE(multiQueue.keyConcurrency("a") == 1);
+		REQUIRE(multiQueue.keyConcurrency("b") == 2);
+
+		QObject::connect(&multiQueue, &ConcurrentMultiQueue::dequeued, [&](QVariant item) {
+			results.append(item.toInt());
+		});
+
+		QSignalSpy dequeuedSpy(&multiQueue, SIGNAL(dequeued(QVariant)));
+		QSignalSpy finishedSpy(&multiQueue, SIGNAL(finished()));
+		multiQueue.append(0, 1, "a");
+		multiQueue.append(0, 2, "a");
+		multiQueue.append(0, 11, "b");
+		multiQueue.append(0, 12, "b");
+		multiQueue.append(0, 13, "b");
+
+		// Only one "a" and two "b" can run at the same time
+		REQUIRE(dequeuedSpy.wait());
+		REQUIRE(!dequeuedSpy.wait(100));
+		REQUIRE(results == QList<int>() << 1 << 11 << 12);
+
+		// Finishing an "a" item lets the next "a" start, even if there are still "b" items waiting
+		multiQueue.next("a");
+		REQUIRE(dequeuedSpy.wait());
+		REQUIRE(results == QList<int>() << 1 << 11 << 12 << 2);
+
+		multiQueue.next("b");
+		REQUIRE(dequeuedSpy.wait());
+		REQUIRE(results == QList<int>() << 1 << 11 << 12 << 2 << 13);
+
+		multiQueue.next("a");
+		multiQueue.next("b");
+		multiQueue.next("b");
+		REQUIRE(finishedSpy.wait());
+		REQUIRE(finishedSpy.count() == 1);
+	}
 }
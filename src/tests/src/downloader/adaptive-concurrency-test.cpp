@@ -0,0 +1,94 @@
+#include <QSignalSpy>
+#include "downloader/adaptive-concurrency.h"
+#include "catch.h"
+
+
+// Simulate a full window of downloads of 1 MB, finishing one after another every "interval" milliseconds
+static qint64 runWindow(AdaptiveConcurrency &adaptive, const QString &key, qint64 now, qint64 interval, qint64 latency, bool success = true)
+{
+	const int count = qMax(adaptive.concurrency(key), 4);
+	for (int i = 0; i < count; ++i) {
+		now += interval;
+		adaptive.addResult(key, success, success ? 1024 * 1024 : 0, latency, now);
+	}
+	return now;
+}
+
+// Each download takes one second, so more slots means more downloads per second
+static qint64 runServerBoundWindow(AdaptiveConcurrency &adaptive, const QString &key, qint64 now, bool success = true)
+{
+	return runWindow(adaptive, key, now, 1000 / adaptive.concurrency(key), 1000, success);
+}
+
+
+TEST_CASE("AdaptiveConcurrency")
+{
+	SECTION("Starts at the minimum")
+	{
+		AdaptiveConcurrency adaptive(2, 8);
+		REQUIRE(adaptive.concurrency("site") == 2);
+		REQUIRE(adaptive.concurrencies().isEmpty());
+	}
+
+	SECTION("Increases up to the maximum while the throughput gets better")
+	{
+		AdaptiveConcurrency adaptive(1, 6);
+		QSignalSpy spy(&adaptive, SIGNAL(concurrencyChanged(QString, int)));
+
+		qint64 now = 0;
+		for (int i = 0; i < 20; ++i) {
+			now = runServerBoundWindow(adaptive, "site", now);
+		}
+
+		REQUIRE(adaptive.concurrency("site") == 6);
+		REQUIRE(adaptive.concurrencies().value("site") == 6);
+		REQUIRE(spy.count() == 5);
+		REQUIRE(spy.last()[0].toString() == QString("site"));
+		REQUIRE(spy.last()[1].toInt() == 6);
+	}
+
+	SECTION("Sharing the bandwidth does not count as a slower host")
+	{
+		AdaptiveConcurrency adaptive(1, 10);
+
+		// The download time grows with the number of slots, but the total throughput doesn't drop
+		qint64 now = 0;
+		for (int i = 0; i < 20; ++i) {
+			now = runWindow(adaptive, "site", now, 1000, 1000 * adaptive.concurrency("site"));
+		}
+
+		REQUIRE(adaptive.concurrency("site") > 1);
+	}
+
+	SECTION("Halves on errors")
+	{
+		AdaptiveConcurrency adaptive(1, 8);
+
+		qint64 now = 0;
+		for (int i = 0; i < 20; ++i) {
+			now = runServerBoundWindow(adaptive, "site", now);
+		}
+		REQUIRE(adaptive.concurrency("site") == 8);
+
+		now = runServerBoundWindow(adaptive, "site", now, false);
+		REQUIRE(adaptive.concurrency("site") == 4);
+
+		for (int i = 0; i < 10; ++i) {
+			now = runServerBoundWindow(adaptive, "site", now, false);
+		}
+		REQUIRE(adaptive.concurrency("site") == 1);
+	}
+
+	SECTION("Hosts are independent")
+	{
+		AdaptiveConcurrency adaptive(1, 8);
+
+		qint64 now = 0;
+		for (int i = 0; i < 20; ++i) {
+			now = runServerBoundWindow(adaptive, "fast", now);
+		}
+
+		REQUIRE(adaptive.concurrency("fast") == 8);
+		REQUIRE(adaptive.concurrency("other") == 1);
+	}
+}
@@ -0,0 +1,122 @@
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include <QThread>
+#include "catch.h"
+#include "downloader/batch-coordinator.h"
+#include "downloader/download-query-group.h"
+#include "models/profile.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("BatchCoordinator")
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	const QScopedPointer<Profile> pProfile(makeProfile());
+	Site *site = pProfile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	const DownloadQueryGroup group(QStringList() << "rating:safe", 1, 20, 50, QStringList(), false, site, "%md5%.%ext%", "tests/resources/tmp");
+
+	SECTION("Split groups in page ranges")
+	{
+		BatchCoordinator coordinator;
+		coordinator.addGroup(group, 1);
+
+		const QList<BatchCoordinator::Lease> &leases = coordinator.leases();
+		REQUIRE(leases.count() == 3);
+		REQUIRE(leases[0].group["page"].toInt() == 1);
+		REQUIRE(leases[0].group["total"].toInt() == 20);
+		REQUIRE(leases[1].group["page"].toInt() == 2);
+		REQUIRE(leases[1].group["total"].toInt() == 20);
+		REQUIRE(leases[2].group["page"].toInt() == 3);
+		REQUIRE(leases[2].group["total"].toInt() == 10);
+	}
+
+	SECTION("Keep groups with post-filtering whole")
+	{
+		DownloadQueryGroup filtered = group;
+		filtered.postFiltering = QStringList() << "rating:safe";
+
+		BatchCoordinator coordinator;
+		coordinator.addGroup(filtered, 1);
+		coordinator.addGroup(group);
+
+		REQUIRE(coordinator.leases().count() == 2);
+		REQUIRE(coordinator.leases()[0].group["total"].toInt() == 50);
+	}
+
+	SECTION("Lease lifecycle")
+	{
+		BatchCoordinator coordinator;
+		coordinator.addGroup(group);
+		QSignalSpy progressSpy(&coordinator, SIGNAL(progress(int, int)));
+		QSignalSpy finishedSpy(&coordinator, SIGNAL(finished()));
+
+		const QJsonObject lease = coordinator.handleMessage("a", QJsonObject { { "type", "lease" } });
+		REQUIRE(lease["type"].toString() == QString("lease"));
+		REQUIRE(lease["lease"].toInt() == 0);
+		REQUIRE(lease["group"].toObject()["site"].toString() == QString("danbooru.donmai.us"));
+
+		// Other workers have to wait until the lease is done
+		REQUIRE(coordinator.handleMessage("b", QJsonObject { { "type", "lease" } })["type"].toString() == QString("wait"));
+
+		REQUIRE(coordinator.handleMessage("a", QJsonObject { { "type", "heartbeat" }, { "lease", 0 }, { "done", 10 } }).isEmpty());
+		REQUIRE(progressSpy.count() == 1);
+		REQUIRE(progressSpy.last()[0].toInt() == 10);
+		REQUIRE(progressSpy.last()[1].toInt() == 50);
+
+		REQUIRE(coordinator.handleMessage("a", QJsonObject { { "type", "done" }, { "lease", 0 }, { "done", 50 } }).isEmpty());
+		REQUIRE(finishedSpy.count() == 1);
+		REQUIRE(coordinator.isFinished());
+		REQUIRE(coordinator.status()["images"].toInt() == 50);
+		REQUIRE(coordinator.handleMessage("b", QJsonObject { { "type", "lease" } })["type"].toString() == QString("finished"));
+	}
+
+	SECTION("Re-lease when the worker stops sending heartbeats")
+	{
+		BatchCoordinator coordinator(0);
+		coordinator.addGroup(group);
+
+		coordinator.handleMessage("a", QJsonObject { { "type", "lease" } });
+		QThread::msleep(10);
+		coordinator.checkLeases();
+		REQUIRE(coordinator.leases()[0].state == BatchCoordinator::Pending);
+
+		// The first worker is told to stop
+		const QJsonObject cancel = coordinator.handleMessage("a", QJsonObject { { "type", "heartbeat" }, { "lease", 0 } });
+		REQUIRE(cancel["type"].toString() == QString("cancel"));
+
+		const QJsonObject lease = coordinator.handleMessage("b", QJsonObject { { "type", "lease" } });
+		REQUIRE(lease["lease"].toInt() == 0);
+		REQUIRE(coordinator.leases()[0].attempts == 2);
+	}
+
+	SECTION("Re-lease when the worker disconnects")
+	{
+		BatchCoordinator coordinator;
+		coordinator.addGroup(group);
+
+		coordinator.handleMessage("a", QJsonObject { { "type", "lease" } });
+		coordinator.releaseWorker("a");
+
+		REQUIRE(coordinator.leases()[0].state == BatchCoordinator::Pending);
+	}
+
+	SECTION("Give up after too many failures")
+	{
+		BatchCoordinator coordinator;
+		coordinator.addGroup(group);
+
+		for (int i = 0; i < 3; ++i) {
+			REQUIRE(coordinator.handleMessage("a", QJsonObject { { "type", "lease" } })["type"].toString() == QString("lease"));
+			coordinator.handleMessage("a", QJsonObject { { "type", "failed" }, { "lease", 0 } });
+		}
+
+		REQUIRE(coordinator.leases()[0].state == BatchCoordinator::Failed);
+		REQUIRE(coordinator.isFinished());
+		REQUIRE(coordinator.status()["failed"].toInt() == 1);
+	}
+}
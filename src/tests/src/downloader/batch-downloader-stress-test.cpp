@@ -0,0 +1,74 @@
+#include <QDir>
+#include <QRandomGenerator>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTimer>
+#include "custom-network-access-manager.h"
+#include "downloader/batch-downloader.h"
+#include "downloader/download-query-group.h"
+#include "models/profile.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+#define STRESS_ITERATIONS 20
+
+
+TEST_CASE("BatchDownloader stress", "[stress]")
+{
+	QDir("tests/resources/tmp/stress").removeRecursively();
+
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	// Force HTML source
+	QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/settings.ini", QSettings::IniFormat);
+	siteSettings.clear();
+	siteSettings.setValue("sources/usedefault", false);
+	siteSettings.setValue("sources/source_1", "html");
+	siteSettings.sync();
+
+	const QScopedPointer<Profile> pProfile(makeProfile());
+	auto profile = pProfile.data();
+	profile->getSettings()->setValue("Save/simultaneous", 5);
+
+	Site *site = profile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	QRandomGenerator random(1337);
+	CustomNetworkAccessManager::TestLatency = 5;
+
+	// Pausing and resuming at random times, while images are downloading or between two of them
+	for (int i = 0; i < STRESS_ITERATIONS; ++i) {
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/results.html");
+
+		const int total = 20;
+		const QString path = "tests/resources/tmp/stress/" + QString::number(i);
+		DownloadQueryGroup query(QStringList() << "rating:safe", 1, 20, total, QStringList(), true, site, "%count%.%ext%", path);
+
+		BatchDownloader downloader(&query, profile);
+		QSignalSpy spy(&downloader, SIGNAL(finished()));
+		downloader.start();
+
+		for (int j = 0; j < 3; ++j) {
+			QTimer::singleShot(static_cast<int>(random.bounded(30)), &downloader, [&downloader]() {
+				if (downloader.currentStep() == BatchDownloader::BatchDownloadStep::ImageDownload) {
+					downloader.abort();
+					QTimer::singleShot(0, &downloader, &BatchDownloader::start);
+				}
+			});
+		}
+
+		REQUIRE(spy.wait(10000));
+		REQUIRE(downloader.downloadedCount() == total);
+		REQUIRE(downloader.totalCount() == total);
+
+		// The downloads interrupted by the pauses must not finish the batch a second time
+		REQUIRE(!spy.wait(50));
+		REQUIRE(spy.count() == 1);
+	}
+
+	CustomNetworkAccessManager::TestLatency = 0;
+	CustomNetworkAccessManager::NextFiles.clear();
+	QDir("tests/resources/tmp/stress").removeRecursively();
+}
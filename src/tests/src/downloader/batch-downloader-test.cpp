@@ -103,6 +103,27 @@ TEST_CASE("BatchDownloader")
 			REQUIRE(downloader.totalCount() == total);
 		}
 
+		SECTION("Already existing files")
+		{
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/results.html");
+
+			query.total = 2;
+			query.filename = "%count%.jpg";
+			for (const QString &name : { "1.jpg", "2.jpg" }) {
+				QFile f("tests/resources/tmp/" + name);
+				REQUIRE(f.open(QFile::WriteOnly));
+				f.write("test");
+				f.close();
+			}
+
+			BatchDownloader downloader(&query, profile);
+			waitForFinished(&downloader);
+
+			REQUIRE(downloader.downloadedCount() == 2);
+			REQUIRE(downloader.downloadedCount(BatchDownloader::AlreadyExists) == 2);
+			REQUIRE(downloader.downloadedCount(BatchDownloader::Downloaded) == 0);
+		}
+
 		SECTION("No results")
 		{
 			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/results.xml"); // Will cause a parsing error
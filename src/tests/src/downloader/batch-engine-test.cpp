@@ -0,0 +1,70 @@
+#include <QDir>
+#include <QEventLoop>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+#include "catch.h"
+#include "custom-network-access-manager.h"
+#include "downloader/batch-downloader.h"
+#include "downloader/batch-engine.h"
+#include "downloader/download-query-group.h"
+#include "models/profile.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("BatchEngine")
+{
+	QDir("tests/resources/").mkdir("tmp");
+
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	// Force HTML source
+	QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/settings.ini", QSettings::IniFormat);
+	siteSettings.clear();
+	siteSettings.setValue("sources/usedefault", false);
+	siteSettings.setValue("sources/source_1", "html");
+	siteSettings.sync();
+
+	const QScopedPointer<Profile> pProfile(makeProfile());
+	auto profile = pProfile.data();
+	profile->getSettings()->setValue("packing_size", 2);
+
+	Site *site = profile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	QDir dir("tests/resources/tmp/");
+	for (const QString &file : dir.entryList(QDir::Files)) {
+		dir.remove(file);
+	}
+
+	SECTION("Group download on the engine thread")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/results.html");
+
+		DownloadQueryGroup query(QStringList() << "rating:safe", 1, 20, 3, QStringList(), true, site, "%count%.%ext%", "tests/resources/tmp");
+
+		BatchEngine engine;
+		BatchDownloader *downloader = engine.createDownloader(&query, profile);
+		REQUIRE(downloader->thread() != QThread::currentThread());
+
+		// Signals are received on this thread through queued connections
+		bool finished = false;
+		QEventLoop loop;
+		QObject::connect(downloader, &BatchDownloader::finished, &loop, [&finished, &loop]() {
+			finished = true;
+			loop.quit();
+		});
+		QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+
+		engine.start(downloader);
+		loop.exec();
+
+		REQUIRE(finished);
+		REQUIRE(downloader->downloadedCount() == 3);
+		REQUIRE(downloader->downloadedCount(BatchDownloader::Downloaded) == 3);
+
+		engine.remove(downloader);
+	}
+}
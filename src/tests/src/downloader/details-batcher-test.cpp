@@ -0,0 +1,102 @@
+#include "downloader/details-batcher.h"
+#include <QScopedPointer>
+#include <QSettings>
+#include <QSharedPointer>
+#include <QSignalSpy>
+#include "custom-network-access-manager.h"
+#include "models/image.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+QSharedPointer<Image> makeDetailsImage(Site *site, Profile *profile, int id)
+{
+	return QSharedPointer<Image>(new Image(site, {
+		{ "id", QString::number(id) },
+		{ "md5", "md5_" + QString::number(id) },
+		{ "page_url", "/posts/" + QString::number(id) },
+		{ "file_url", "https://test.com/" + QString::number(id) + ".jpg" },
+	}, profile));
+}
+
+TEST_CASE("DetailsBatcher")
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	SECTION("Unsupported API")
+	{
+		QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/settings.ini", QSettings::IniFormat);
+		siteSettings.clear();
+		siteSettings.setValue("sources/usedefault", false);
+		siteSettings.setValue("sources/source_1", "html");
+		siteSettings.sync();
+
+		const QScopedPointer<Profile> pProfile(makeProfile());
+		auto profile = pProfile.data();
+		profile->getSettings()->setValue("details_batch_delay", 0);
+
+		Site *site = profile->getSites().value("danbooru.donmai.us");
+		REQUIRE(site != nullptr);
+
+		DetailsBatcher batcher(site);
+		REQUIRE(batcher.batchApi() == nullptr);
+	}
+
+	SECTION("Load details in a single request")
+	{
+		QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/settings.ini", QSettings::IniFormat);
+		siteSettings.clear();
+		siteSettings.setValue("sources/usedefault", false);
+		siteSettings.setValue("sources/source_1", "json");
+		siteSettings.sync();
+
+		const QScopedPointer<Profile> pProfile(makeProfile());
+		auto profile = pProfile.data();
+		profile->getSettings()->setValue("details_batch_delay", 0);
+
+		Site *site = profile->getSites().value("danbooru.donmai.us");
+		REQUIRE(site != nullptr);
+
+		DetailsBatcher batcher(site);
+		REQUIRE(batcher.batchApi() != nullptr);
+
+		auto img1 = makeDetailsImage(site, profile, 1);
+		auto img2 = makeDetailsImage(site, profile, 2);
+		auto img3 = makeDetailsImage(site, profile, 3);
+		QSignalSpy spy1(img1.data(), SIGNAL(finishedLoadingTags(Image::LoadTagsResult)));
+		QSignalSpy spy2(img2.data(), SIGNAL(finishedLoadingTags(Image::LoadTagsResult)));
+		QSignalSpy spy3(img3.data(), SIGNAL(finishedLoadingTags(Image::LoadTagsResult)));
+
+		// Image 3 is missing from the results so will fallback to its details page
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/batch-ids.json");
+		CustomNetworkAccessManager::NextFiles.enqueue("404");
+
+		batcher.prefetch({ img2 });
+		batcher.loadDetails(img1);
+		batcher.loadDetails(img3);
+		REQUIRE(spy1.wait());
+
+		REQUIRE(img1->hasLoadedDetails());
+		REQUIRE(img1->tagsString().contains("artist1"));
+		REQUIRE(img1->fileUrl().toString() == QString("https://cdn.donmai.us/original/c4/ca/c4ca4238a0b923820dcc509a6f75849b.jpg"));
+
+		// The prefetched image got its details along the others
+		REQUIRE(spy2.count() == 1);
+		REQUIRE(img2->hasLoadedDetails());
+		REQUIRE(img2->tagsString().contains("tag2"));
+
+		// Already loaded images don't require any new request
+		batcher.loadDetails(img2);
+		REQUIRE(spy2.count() == 2);
+
+		if (spy3.isEmpty()) {
+			REQUIRE(spy3.wait());
+		}
+		REQUIRE(!img3->hasLoadedDetails());
+		REQUIRE(spy3.first().at(0).value<Image::LoadTagsResult>() == Image::LoadTagsResult::NetworkError);
+		REQUIRE(CustomNetworkAccessManager::NextFiles.isEmpty());
+	}
+}
@@ -60,6 +60,36 @@ TEST_CASE("DownloadQueryGroup")
 			REQUIRE(!dest.progressFinished);
 		}
 
+		SECTION("With checkpoint")
+		{
+			DownloadQueryGroup original(QStringList() << "tags", 1, 2, 3, QStringList(), true, site, "filename", "path");
+			original.progressVal = 37;
+			original.checkpoint.page = 19;
+			original.checkpoint.total = 37;
+			original.checkpoint.skip = 1;
+			original.checkpoint.lastPage = 18;
+			original.checkpoint.lastPageMinId = 9876543210ULL;
+			original.checkpoint.lastPageMaxId = 9876543220ULL;
+
+			QJsonObject json;
+			original.write(json);
+
+			DownloadQueryGroup dest;
+			REQUIRE(dest.read(json, &profile));
+
+			REQUIRE(dest.checkpoint.page == 19);
+			REQUIRE(dest.checkpoint.total == 37);
+			REQUIRE(dest.checkpoint.skip == 1);
+			REQUIRE(dest.checkpoint.lastPage == 18);
+			REQUIRE(dest.checkpoint.lastPageMinId == 9876543210ULL);
+			REQUIRE(dest.checkpoint.lastPageMaxId == 9876543220ULL);
+
+			// Not saved without the progress
+			QJsonObject withoutProgress;
+			original.write(withoutProgress, false);
+			REQUIRE(!withoutProgress.contains("checkpoint"));
+		}
+
 		SECTION("With -1 total")
 		{
 			DownloadQueryGroup original(QStringList() << "tags", 1, 20, -1, QStringList(), true, site, "filename", "path");
@@ -0,0 +1,132 @@
+#include "downloader/download-query-snapshot.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include "downloader/download-query-group.h"
+#include "downloader/download-query-image.h"
+#include "downloader/download-query-loader.h"
+#include "models/image.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("DownloadQuerySnapshot")
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	Profile profile("tests/resources/");
+	Site *site = profile.getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	QTemporaryDir dir;
+	REQUIRE(dir.isValid());
+	const QString path = dir.filePath("restore.igl");
+
+	QList<DownloadQueryGroup> groups;
+	for (int i = 0; i < 3; ++i) {
+		groups.append(DownloadQueryGroup(QStringList() << "tag" + QString::number(i), 1, 20, 100, QStringList(), false, site, "filename", "path"));
+	}
+
+	QList<DownloadQueryImage> uniques;
+	for (int i = 0; i < 10; ++i) {
+		auto img = QSharedPointer<Image>(new Image(site, {{ "id", QString::number(i + 1) }, { "md5", "md5" }, { "file_url", "https://test.com/file.jpg" }}, &profile));
+		uniques.append(DownloadQueryImage(img, site, "filename", "path"));
+	}
+
+	SECTION("Save and load")
+	{
+		DownloadQuerySnapshot snapshot(path);
+		REQUIRE(snapshot.save(uniques, groups));
+		REQUIRE(DownloadQuerySnapshot::isSnapshot(path));
+
+		DownloadQuerySnapshot loader(path);
+		REQUIRE(loader.open());
+		REQUIRE(loader.groupCount() == 3);
+		REQUIRE(loader.uniqueCount() == 10);
+
+		const QList<DownloadQueryGroup> loadedGroups = loader.readGroups(&profile);
+		REQUIRE(loadedGroups == groups);
+
+		const QList<DownloadQueryImage> loadedUniques = loader.readUniques(&profile);
+		REQUIRE(loadedUniques.count() == 10);
+		REQUIRE(static_cast<int>(loadedUniques[4].image->id()) == 5);
+		REQUIRE(loader.atEnd());
+	}
+
+	SECTION("Load unique images in chunks")
+	{
+		DownloadQuerySnapshot snapshot(path);
+		REQUIRE(snapshot.save(uniques, groups));
+
+		DownloadQuerySnapshot loader(path);
+		REQUIRE(loader.open());
+
+		QList<int> ids;
+		while (!loader.atEnd()) {
+			const QList<DownloadQueryImage> chunk = loader.readUniques(&profile, 4);
+			REQUIRE(chunk.count() <= 4);
+			for (const DownloadQueryImage &unique : chunk) {
+				ids.append(static_cast<int>(unique.image->id()));
+			}
+		}
+		REQUIRE(ids == QList<int> { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 });
+	}
+
+	SECTION("Only append changes")
+	{
+		DownloadQuerySnapshot snapshot(path);
+		REQUIRE(snapshot.save(uniques, groups));
+		const qint64 fullSize = QFileInfo(path).size();
+
+		// Saving the same lists does not write anything
+		REQUIRE(snapshot.save(uniques, groups));
+		REQUIRE(QFileInfo(path).size() == fullSize);
+
+		// Changing the progress of a single group only appends this group
+		groups[1].progressVal = 37;
+		REQUIRE(snapshot.save(uniques, groups));
+		const qint64 newSize = QFileInfo(path).size();
+		REQUIRE(newSize > fullSize);
+		REQUIRE(newSize - fullSize < fullSize / 4);
+
+		// Removing entries is also supported
+		groups.removeLast();
+		uniques = uniques.mid(0, 5);
+		REQUIRE(snapshot.save(uniques, groups));
+
+		DownloadQuerySnapshot loader(path);
+		REQUIRE(loader.open());
+		const QList<DownloadQueryGroup> loadedGroups = loader.readGroups(&profile);
+		REQUIRE(loadedGroups.count() == 2);
+		REQUIRE(loadedGroups[1].progressVal == 37);
+		REQUIRE(loader.readUniques(&profile).count() == 5);
+	}
+
+	SECTION("Rewrite the file if it was changed by someone else")
+	{
+		DownloadQuerySnapshot snapshot(path);
+		REQUIRE(snapshot.save(uniques, groups));
+		REQUIRE(DownloadQueryLoader::save(path, uniques, groups));
+		REQUIRE(!DownloadQuerySnapshot::isSnapshot(path));
+
+		REQUIRE(snapshot.save(uniques, groups));
+		REQUIRE(DownloadQuerySnapshot::isSnapshot(path));
+	}
+
+	SECTION("Can be loaded as a normal link list")
+	{
+		DownloadQuerySnapshot snapshot(path);
+		REQUIRE(snapshot.save(uniques, groups));
+
+		QList<DownloadQueryImage> loadedUniques;
+		QList<DownloadQueryGroup> loadedGroups;
+		REQUIRE(DownloadQueryLoader::load(path, loadedUniques, loadedGroups, &profile));
+		REQUIRE(loadedGroups.count() == 3);
+		REQUIRE(loadedUniques.count() == 10);
+	}
+}
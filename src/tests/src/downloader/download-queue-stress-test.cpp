@@ -0,0 +1,84 @@
+#include <QDir>
+#include <QRandomGenerator>
+#include <QScopedPointer>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTimer>
+#include "custom-network-access-manager.h"
+#include "downloader/download-queue.h"
+#include "downloader/image-downloader.h"
+#include "models/image-factory.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+#define STRESS_DOWNLOADS 200
+
+
+static ImageDownloader *makeDownloader(Profile *profile, Site *site, int id)
+{
+	QMap<QString, QString> details;
+	details["id"] = QString::number(id);
+	details["md5"] = QString::number(id).rightJustified(32, '0');
+	details["ext"] = "jpg";
+	details["file_url"] = "http://test.com/img/stress_" + QString::number(id) + ".jpg";
+	details["tags"] = "tag1 tag2 tag3";
+
+	// Always the same file, to not look for a test file matching the URL of each image
+	CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/image_1x1.png");
+
+	const auto img = ImageFactory::build(site, details, profile);
+	return new ImageDownloader(profile, img, "%id%.%ext%", "tests/resources/tmp/stress", 1, false, false, nullptr, false, false);
+}
+
+TEST_CASE("DownloadQueue stress", "[stress]")
+{
+	QDir("tests/resources/tmp/stress").removeRecursively();
+	QDir().mkpath("tests/resources/tmp/stress");
+
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	const QScopedPointer<Profile> pProfile(makeProfile());
+	auto profile = pProfile.data();
+
+	Site *site = profile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	QRandomGenerator random(1337);
+	CustomNetworkAccessManager::TestLatency = 5;
+
+	// A single slot per site, so that any leaked slot blocks all the following downloads
+	DownloadQueue queue(4, nullptr, 1);
+	QSignalSpy spy(&queue, SIGNAL(finished()));
+
+	QSet<int> destroyed;
+	for (int i = 0; i < STRESS_DOWNLOADS; ++i) {
+		ImageDownloader *downloader = makeDownloader(profile, site, i + 1);
+		QObject::connect(downloader, &QObject::destroyed, &queue, [&destroyed, i]() { destroyed.insert(i); });
+		queue.add(static_cast<DownloadQueue::Queue>(random.bounded(3)), downloader);
+
+		// Cancel some downloads at a random time, while queued or running
+		if (random.bounded(5) == 0) {
+			QTimer::singleShot(static_cast<int>(random.bounded(200)), downloader, &QObject::deleteLater);
+		}
+	}
+
+	// The last downloads are deleted after the queue finished, so its signal is not enough to know when they are all done
+	for (int i = 0; i < 100 && destroyed.count() < STRESS_DOWNLOADS; ++i) {
+		spy.wait(100);
+	}
+	REQUIRE(destroyed.count() == STRESS_DOWNLOADS);
+
+	// All the slots were released, so new downloads can still be started
+	CustomNetworkAccessManager::TestLatency = 0;
+	CustomNetworkAccessManager::NextFiles.clear();
+	ImageDownloader *last = makeDownloader(profile, site, STRESS_DOWNLOADS + 1);
+	QSignalSpy lastSpy(last, SIGNAL(destroyed()));
+	queue.add(DownloadQueue::Manual, last);
+	REQUIRE(lastSpy.wait());
+
+	CustomNetworkAccessManager::NextFiles.clear();
+	QDir("tests/resources/tmp/stress").removeRecursively();
+}
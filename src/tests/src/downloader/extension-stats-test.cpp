@@ -0,0 +1,57 @@
+#include <QStringList>
+#include <QTemporaryDir>
+#include "downloader/extension-stats.h"
+#include "catch.h"
+
+
+TEST_CASE("ExtensionStats")
+{
+	const QStringList extensions { "jpg", "png", "gif", "webm" };
+
+	SECTION("Keep the original order without data")
+	{
+		ExtensionStats stats;
+		REQUIRE(stats.sort(123, extensions) == extensions);
+	}
+
+	SECTION("Sort the most used extensions first")
+	{
+		ExtensionStats stats;
+		stats.add(100, "png");
+		stats.add(200, "png");
+		stats.add(300, "webm");
+
+		REQUIRE(stats.count(150, "png") == 2);
+		REQUIRE(stats.sort(150, extensions) == QStringList { "png", "webm", "jpg", "gif" });
+	}
+
+	SECTION("Nearby IDs come first")
+	{
+		ExtensionStats stats;
+		for (int i = 0; i < 10; ++i) {
+			stats.add(100 + i, "jpg");
+		}
+		stats.add(5000000, "webm");
+
+		REQUIRE(stats.sort(5000100, extensions) == QStringList { "webm", "jpg", "png", "gif" });
+		REQUIRE(stats.sort(200, extensions) == QStringList { "jpg", "webm", "png", "gif" });
+	}
+
+	SECTION("Persistence")
+	{
+		QTemporaryDir dir;
+		REQUIRE(dir.isValid());
+		const QString file = dir.filePath("extensions.json");
+
+		{
+			ExtensionStats stats(file);
+			stats.add(100, "gif");
+			stats.add(100, "gif");
+			REQUIRE(stats.save());
+		}
+
+		ExtensionStats stats(file);
+		REQUIRE(stats.count(100, "gif") == 2);
+		REQUIRE(stats.sort(100, extensions).first() == QString("gif"));
+	}
+}
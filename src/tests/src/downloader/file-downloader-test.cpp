@@ -3,7 +3,10 @@
 #include "custom-network-access-manager.h"
 #include "downloader/file-downloader.h"
 #include "network/network-manager.h"
+#include "utils/zip-writer.h"
+#include "utils/zip.h"
 #include "catch.h"
+#include "raii-helpers.h"
 
 
 QString fileMd5(const QString &path)
@@ -40,6 +43,7 @@ TEST_CASE("FileDownloader")
 		REQUIRE(spy.wait());
 
 		REQUIRE(fileMd5(dest) == successMd5);
+		REQUIRE(downloader.md5() == successMd5);
 		QFile::remove(dest);
 	}
 
@@ -95,4 +99,35 @@ TEST_CASE("FileDownloader")
 		REQUIRE(error == QString("Invalid HTML content returned"));
 		REQUIRE(!QFile::exists(dest));
 	}
+
+	SECTION("Zip")
+	{
+		FileDeleter removeFile("single.zip", true);
+		DirectoryDeleter removeDir("single-unzip");
+		ZipWriter zip("single.zip");
+		REQUIRE(zip.open());
+
+		// Successful downloads are written directly in the archive
+		CustomNetworkAccessManager::NextFiles.enqueue("gui/resources/images/icon.png");
+		NetworkReply *reply = accessManager.get(QNetworkRequest(QUrl(successUrl)));
+		FileDownloader downloader(false);
+		QSignalSpy spy(&downloader, SIGNAL(success()));
+		REQUIRE(downloader.start(reply, &zip, "icon.png"));
+		REQUIRE(spy.wait());
+		REQUIRE(downloader.md5() == successMd5);
+
+		// Failed ones are removed from it
+		CustomNetworkAccessManager::NextFiles.enqueue("404");
+		NetworkReply *failedReply = accessManager.get(QNetworkRequest(QUrl("testNetworkError")));
+		FileDownloader failedDownloader(false);
+		qRegisterMetaType<NetworkReply::NetworkError>("NetworkReply::NetworkError");
+		QSignalSpy failedSpy(&failedDownloader, SIGNAL(networkError(NetworkReply::NetworkError, QString)));
+		REQUIRE(failedDownloader.start(failedReply, &zip, "failed.png"));
+		REQUIRE(failedSpy.wait());
+
+		REQUIRE(zip.close());
+		REQUIRE(unzipFile("single.zip", "single-unzip"));
+		REQUIRE(fileMd5("single-unzip/icon.png") == successMd5);
+		REQUIRE(!QFile::exists("single-unzip/failed.png"));
+	}
 }
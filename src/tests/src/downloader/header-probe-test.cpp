@@ -0,0 +1,55 @@
+#include <QBuffer>
+#include <QByteArray>
+#include <QImage>
+#include "downloader/header-probe.h"
+#include "catch.h"
+
+
+static QByteArray makeImage(const char *format, const QSize &size)
+{
+	QImage img(size, QImage::Format_RGB32);
+	img.fill(Qt::red);
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	img.save(&buffer, format);
+	return data;
+}
+
+
+TEST_CASE("HeaderProbe")
+{
+	SECTION("Dimensions from truncated files")
+	{
+		for (const char *format : { "png", "jpg", "bmp" }) {
+			const QByteArray data = makeImage(format, QSize(640, 480));
+			const HeaderProbe::Result result = HeaderProbe::parse(data.left(1024), "bytes 0-1023/" + QByteArray::number(data.size()), -1);
+
+			REQUIRE(result.size == QSize(640, 480));
+			REQUIRE(result.fileSize == data.size());
+			REQUIRE(result.format == QString(format));
+		}
+	}
+
+	SECTION("File size")
+	{
+		const QByteArray data = makeImage("png", QSize(10, 10));
+
+		// Partial response
+		REQUIRE(HeaderProbe::parse(data, "bytes 0-16383/123456", -1).fileSize == 123456);
+		REQUIRE(HeaderProbe::parse(data, "bytes 0-16383/*", -1).fileSize == -1);
+
+		// Full response when the server doesn't support ranges
+		REQUIRE(HeaderProbe::parse(data, "", 4567).fileSize == 4567);
+		REQUIRE(HeaderProbe::parse(data, "", -1).fileSize == -1);
+	}
+
+	SECTION("Unknown formats")
+	{
+		const HeaderProbe::Result result = HeaderProbe::parse("not an image", "bytes 0-11/12", -1);
+		REQUIRE(!result.size.isValid());
+		REQUIRE(result.format.isEmpty());
+		REQUIRE(result.fileSize == 12);
+	}
+}
@@ -10,6 +10,7 @@
 #include "models/profile.h"
 #include "models/site.h"
 #include "models/source.h"
+#include "post-save-queue.h"
 #include "catch.h"
 #include "source-helpers.h"
 
@@ -35,6 +36,7 @@ void assertDownload(Profile *profile, QSharedPointer<Image> img, ImageDownloader
 {
 	const bool oldSampleFallback = profile->getSettings()->value("Save/samplefallback", true).toBool();
 	profile->getSettings()->setValue("Save/samplefallback", sampleFallback);
+	profile->reloadSettingsSnapshot();
 
 	qRegisterMetaType<QList<ImageSaveResult>>();
 	QSignalSpy spy(downloader, SIGNAL(saved(QSharedPointer<Image>, QList<ImageSaveResult>)));
@@ -46,6 +48,7 @@ void assertDownload(Profile *profile, QSharedPointer<Image> img, ImageDownloader
 	auto result = arguments[1].value<QList<ImageSaveResult>>();
 
 	profile->getSettings()->setValue("Save/samplefallback", oldSampleFallback);
+	profile->reloadSettingsSnapshot();
 
 	REQUIRE(out == img);
 	REQUIRE(result.count() == expected.count());
@@ -129,6 +132,8 @@ TEST_CASE("ImageDownloader")
 
 		assertDownload(profile, img, &downloader, expected, true);
 
+		// Log files are written in the background once the image is saved
+		REQUIRE(profile->getPostSaveQueue().waitForDone(5000));
 		REQUIRE(logFile.exists());
 		REQUIRE(logFile.open(QFile::ReadOnly | QFile::Text));
 		REQUIRE(QString(logFile.readAll()) == QString("to heart 2"));
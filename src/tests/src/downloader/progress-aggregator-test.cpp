@@ -0,0 +1,53 @@
+#include <QSharedPointer>
+#include <QSignalSpy>
+#include "downloader/progress-aggregator.h"
+#include "models/image.h"
+#include "catch.h"
+
+
+TEST_CASE("ProgressAggregator")
+{
+	qRegisterMetaType<QSharedPointer<Image>>();
+
+	auto img1 = QSharedPointer<Image>(new Image());
+	auto img2 = QSharedPointer<Image>(new Image());
+
+	SECTION("Coalesces updates into a single emission")
+	{
+		ProgressAggregator aggregator(50);
+		QSignalSpy imageSpy(&aggregator, SIGNAL(imageProgress(QSharedPointer<Image>, qint64, qint64)));
+		QSignalSpy spy(&aggregator, SIGNAL(progress(qint64, qint64)));
+
+		for (int i = 1; i <= 100; ++i) {
+			aggregator.update(img1, i, 100);
+		}
+		aggregator.update(img2, 10, 200);
+
+		REQUIRE(imageSpy.count() == 0);
+		REQUIRE(spy.wait());
+
+		REQUIRE(spy.count() == 1);
+		REQUIRE(spy[0][0].toLongLong() == 110);
+		REQUIRE(spy[0][1].toLongLong() == 300);
+
+		REQUIRE(imageSpy.count() == 2);
+		for (const QList<QVariant> &args : imageSpy) {
+			const auto img = args[0].value<QSharedPointer<Image>>();
+			REQUIRE(args[1].toLongLong() == (img == img1 ? 100 : 10));
+		}
+	}
+
+	SECTION("Removed images are not emitted")
+	{
+		ProgressAggregator aggregator(50);
+		QSignalSpy imageSpy(&aggregator, SIGNAL(imageProgress(QSharedPointer<Image>, qint64, qint64)));
+
+		aggregator.update(img1, 50, 100);
+		aggregator.update(img2, 50, 100);
+		aggregator.remove(img1);
+		aggregator.flush();
+
+		REQUIRE(imageSpy.count() == 1);
+		REQUIRE(aggregator.bytesTotal() == 100);
+	}
+}
@@ -0,0 +1,163 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QObject>
+#include <QSettings>
+#include <QSignalSpy>
+#include "downloader/transcoder.h"
+#include "catch.h"
+
+
+static QByteArray fileMd5(const QString &path)
+{
+	QFile file(path);
+	file.open(QFile::ReadOnly);
+	return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5).toHex();
+}
+
+// Easy to compress image, saved without any compression
+static void makeImage(const QString &path)
+{
+	QImage img(256, 256, QImage::Format_RGB32);
+	for (int y = 0; y < img.height(); ++y) {
+		for (int x = 0; x < img.width(); ++x) {
+			img.setPixel(x, y, qRgb(x, y, (x + y) / 2));
+		}
+	}
+	img.save(path, "png", 100);
+}
+
+
+TEST_CASE("Transcoder")
+{
+	QDir().mkpath("tests/resources/tmp");
+	const QString path = "tests/resources/tmp/transcode.png";
+
+	SECTION("Rules matching")
+	{
+		TranscodeRule rule;
+		rule.extensions = QStringList { "png", "bmp" };
+		rule.minimumSize = 1024;
+		rule.sites = QStringList { "danbooru.donmai.us" };
+
+		REQUIRE(rule.matches("png", 2048, "danbooru.donmai.us"));
+		REQUIRE(rule.matches("PNG", 2048, "danbooru.donmai.us"));
+		REQUIRE(!rule.matches("jpg", 2048, "danbooru.donmai.us"));
+		REQUIRE(!rule.matches("png", 512, "danbooru.donmai.us"));
+		REQUIRE(!rule.matches("png", 2048, "gelbooru.com"));
+
+		TranscodeRule any;
+		REQUIRE(any.matches("jpg", 0, "gelbooru.com"));
+
+		const QList<TranscodeRule> rules { rule, any };
+		REQUIRE(TranscodeRule::find(rules, "png", 2048, "danbooru.donmai.us") == 0);
+		REQUIRE(TranscodeRule::find(rules, "png", 2048, "gelbooru.com") == 1);
+		REQUIRE(TranscodeRule::find({ rule }, "png", 2048, "gelbooru.com") == -1);
+	}
+
+	SECTION("Rules from settings")
+	{
+		QSettings settings("tests/resources/tmp/transcode.ini", QSettings::IniFormat);
+		settings.clear();
+		settings.setValue("Transcoding/0_extensions", "png bmp");
+		settings.setValue("Transcoding/0_minimumSize", 100);
+		settings.setValue("Transcoding/0_sites", "danbooru.donmai.us");
+		settings.setValue("Transcoding/0_format", "PNG");
+		settings.setValue("Transcoding/0_quality", 0);
+		settings.setValue("Transcoding/1_format", "webp");
+
+		const QList<TranscodeRule> rules = TranscodeRule::fromSettings(&settings);
+		REQUIRE(rules.count() == 2);
+		REQUIRE(rules[0].extensions == QStringList { "png", "bmp" });
+		REQUIRE(rules[0].minimumSize == 100 * 1024);
+		REQUIRE(rules[0].sites == QStringList { "danbooru.donmai.us" });
+		REQUIRE(rules[0].format == QString("png"));
+		REQUIRE(rules[0].quality == 0);
+		REQUIRE(rules[1].extensions.isEmpty());
+		REQUIRE(rules[1].format == QString("webp"));
+		REQUIRE(rules[1].quality == -1);
+
+		settings.clear();
+		QFile::remove("tests/resources/tmp/transcode.ini");
+	}
+
+	SECTION("Lossless PNG recompression")
+	{
+		makeImage(path);
+		const QImage before(path);
+		const qint64 sizeBefore = QFileInfo(path).size();
+
+		TranscodeRule rule;
+		rule.quality = 0;
+		const Transcoder::Result res = Transcoder::transcode(path, rule);
+
+		REQUIRE(res.transcoded);
+		REQUIRE(res.extension == QString("png"));
+		REQUIRE(res.size == QFileInfo(path).size());
+		REQUIRE(res.size < sizeBefore);
+		REQUIRE(res.md5 == QString(fileMd5(path)));
+		REQUIRE(QImage(path) == before);
+
+		QFile::remove(path);
+	}
+
+	SECTION("Files that can't be made smaller are kept")
+	{
+		makeImage(path);
+		TranscodeRule rule;
+		rule.quality = 0;
+		REQUIRE(Transcoder::transcode(path, rule).transcoded);
+
+		const QByteArray md5 = fileMd5(path);
+		REQUIRE(!Transcoder::transcode(path, rule).transcoded);
+		REQUIRE(fileMd5(path) == md5);
+
+		QFile::remove(path);
+	}
+
+	SECTION("Unsupported formats and files are ignored")
+	{
+		makeImage(path);
+		const QByteArray md5 = fileMd5(path);
+
+		TranscodeRule rule;
+		rule.format = "unknown";
+		REQUIRE(!Transcoder::transcode(path, rule).transcoded);
+		REQUIRE(fileMd5(path) == md5);
+
+		TranscodeRule png;
+		REQUIRE(!Transcoder::transcode("tests/resources/tmp/not_found.png", png).transcoded);
+
+		QFile::remove(path);
+	}
+
+	SECTION("Asynchronous transcoding")
+	{
+		makeImage(path);
+
+		QObject context;
+		Transcoder transcoder(2);
+		TranscodeRule rule;
+		rule.quality = 0;
+
+		bool called = false;
+		Transcoder::Result result;
+		transcoder.runAsync(path, rule, &context, [&called, &result](const Transcoder::Result &res) {
+			called = true;
+			result = res;
+		});
+
+		REQUIRE(transcoder.waitForDone(5000));
+		QSignalSpy spy(&context, SIGNAL(destroyed()));
+		for (int i = 0; i < 50 && !called; ++i) {
+			spy.wait(10);
+		}
+		REQUIRE(called);
+		REQUIRE(result.transcoded);
+		REQUIRE(result.md5 == QString(fileMd5(path)));
+
+		QFile::remove(path);
+	}
+}
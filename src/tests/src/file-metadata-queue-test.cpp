@@ -0,0 +1,63 @@
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include "file-metadata-queue.h"
+#include "post-save-queue.h"
+#include "catch.h"
+
+
+static void touch(const QString &path)
+{
+	QFile file(path);
+	file.open(QFile::WriteOnly | QFile::Truncate);
+	file.write("test");
+	file.close();
+}
+
+
+TEST_CASE("FileMetadataQueue")
+{
+	QDir().mkpath("tests/resources/tmp/metadata/a");
+	QDir().mkpath("tests/resources/tmp/metadata/b");
+
+	SECTION("Dates are set in the background for all directories")
+	{
+		const QDateTime date = QDateTime::fromString("2016-07-02T16:35:12+00:00", Qt::ISODate);
+		QStringList paths;
+		for (int i = 0; i < 10; ++i) {
+			const QString path = QString("tests/resources/tmp/metadata/%1/%2.txt").arg(i % 2 == 0 ? "a" : "b").arg(i);
+			touch(path);
+			paths.append(path);
+		}
+
+		PostSaveQueue postSaveQueue(2, 100);
+		FileMetadataQueue queue(&postSaveQueue);
+		for (const QString &path : paths) {
+			queue.add(path, date.addSecs(paths.indexOf(path)));
+		}
+		REQUIRE(postSaveQueue.waitForDone(5000));
+
+		for (int i = 0; i < paths.count(); ++i) {
+			REQUIRE(QFileInfo(paths[i]).lastModified().toUTC() == date.addSecs(i));
+			QFile::remove(paths[i]);
+		}
+	}
+
+	SECTION("Files without any metadata are ignored")
+	{
+		const QString path = "tests/resources/tmp/metadata/a/none.txt";
+		touch(path);
+		const QDateTime before = QFileInfo(path).lastModified();
+
+		PostSaveQueue postSaveQueue(1, 100);
+		FileMetadataQueue queue(&postSaveQueue);
+		queue.add(path, QDateTime());
+		REQUIRE(postSaveQueue.pendingCount() == 0);
+		REQUIRE(postSaveQueue.waitForDone(5000));
+		REQUIRE(QFileInfo(path).lastModified() == before);
+
+		QFile::remove(path);
+	}
+}
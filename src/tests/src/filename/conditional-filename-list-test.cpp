@@ -0,0 +1,74 @@
+#include <QList>
+#include <QMap>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+#include "filename/conditional-filename.h"
+#include "filename/conditional-filename-list.h"
+#include "loader/token.h"
+#include "catch.h"
+#include "raii-helpers.h"
+
+
+static QMap<QString, Token> makeTokens(const QStringList &tags)
+{
+	return {
+		{ "allos", Token(tags) },
+		{ "test", Token("yes") },
+	};
+}
+
+
+TEST_CASE("ConditionalFilenameList")
+{
+	ConditionalFilenameList list({
+		ConditionalFilename("\"tag1\"", "a", ""),
+		ConditionalFilename("%test%", "b", ""),
+		ConditionalFilename("\"tag2\" | \"tag3\"", "c", ""),
+		ConditionalFilename("\"tag1\" & \"tag3\"", "d", ""),
+		ConditionalFilename("-tag4", "e", ""),
+	});
+
+	SECTION("Unindexed conditions are always candidates")
+	{
+		REQUIRE(list.candidates({}) == QList<int> { 1, 4 });
+		REQUIRE(list.candidates(makeTokens({ "tag5" })) == QList<int> { 1, 4 });
+	}
+
+	SECTION("Candidates keep their original order")
+	{
+		REQUIRE(list.candidates(makeTokens({ "tag1" })) == QList<int> { 0, 1, 3, 4 });
+		REQUIRE(list.candidates(makeTokens({ "tag3", "tag1" })) == QList<int> { 0, 1, 2, 3, 4 });
+		REQUIRE(list.candidates(makeTokens({ "tag2" })) == QList<int> { 1, 2, 4 });
+	}
+
+	SECTION("Candidates contain all matching conditions")
+	{
+		const QMap<QString, Token> tokens = makeTokens({ "tag1", "tag2" });
+		const QList<int> candidates = list.candidates(tokens);
+
+		for (int i = 0; i < list.filenames().count(); ++i) {
+			if (list.filenames()[i].matches(tokens, nullptr)) {
+				REQUIRE(candidates.contains(i));
+			}
+		}
+	}
+
+	SECTION("From settings")
+	{
+		FileDeleter settingsDeleter("tests/resources/conditional-filenames.ini", true);
+		QSettings settings("tests/resources/conditional-filenames.ini", QSettings::IniFormat);
+		settings.setValue("Filenames/0_cond", "\"tag1\"");
+		settings.setValue("Filenames/0_fn", "%md5%.%ext%");
+		settings.setValue("Filenames/0_dir", "");
+
+		auto first = ConditionalFilenameList::fromSettings(&settings);
+		REQUIRE(first->filenames().count() == 1);
+		REQUIRE(ConditionalFilenameList::fromSettings(&settings) == first);
+
+		settings.setValue("Filenames/0_fn", "%id%.%ext%");
+		auto second = ConditionalFilenameList::fromSettings(&settings);
+		REQUIRE(second != first);
+		REQUIRE(second->filenames()[0].filename.format() == QString("%id%.%ext%"));
+	}
+}
@@ -1,4 +1,5 @@
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include "catch.h"
 #include "filename/conditional-filename.h"
@@ -28,4 +29,17 @@ TEST_CASE("ConditionalFilename")
 		REQUIRE(!filename.matches({{ "test", Token("") }}, nullptr));
 		REQUIRE(filename.matches({{ "test", Token("yes") }}, nullptr));
 	}
+
+	SECTION("Required tags")
+	{
+		REQUIRE(ConditionalFilename("", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("%test%", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("-tag1", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("tag*", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("rating:safe", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("\"tag1\"", "yes", "/").requiredTags() == QSet<QString> { "tag1" });
+		REQUIRE(ConditionalFilename("\"tag1\" & %test%", "yes", "/").requiredTags() == QSet<QString> { "tag1" });
+		REQUIRE(ConditionalFilename("\"tag1\" | %test%", "yes", "/").requiredTags().isEmpty());
+		REQUIRE(ConditionalFilename("\"tag1\" | \"tag2\"", "yes", "/").requiredTags() == QSet<QString> { "tag1", "tag2" });
+	}
 }
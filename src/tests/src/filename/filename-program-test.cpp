@@ -0,0 +1,125 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QString>
+#include "filename/ast/filename-node-root.h"
+#include "filename/filename-execution-visitor.h"
+#include "filename/filename-parser.h"
+#include "filename/filename-program.h"
+#include "loader/token.h"
+#include "catch.h"
+
+
+static QString executeVisitor(FilenameNodeRoot *ast, const QMap<QString, Token> &tokens, QSettings *settings, bool keepInvalidTokens = false)
+{
+	FilenameExecutionVisitor executionVisitor(tokens, settings);
+	executionVisitor.setKeepInvalidTokens(keepInvalidTokens);
+	return executionVisitor.run(*ast);
+}
+
+static void compareWithVisitor(const QString &filename, const QMap<QString, Token> &tokens, bool keepInvalidTokens = false)
+{
+	FilenameParser parser(filename);
+	auto ast = parser.parseRoot();
+
+	REQUIRE(parser.error() == QString());
+	REQUIRE(ast != nullptr);
+
+	QSettings settings("tests/resources/settings.ini", QSettings::IniFormat);
+	FilenameProgram program(*ast);
+
+	REQUIRE(program.run(tokens, &settings, nullptr, keepInvalidTokens) == executeVisitor(ast, tokens, &settings, keepInvalidTokens));
+}
+
+TEST_CASE("FilenameProgram")
+{
+	const QMap<QString, Token> gallery {{ "name", Token("some gallery") }};
+	const QMap<QString, Token> tokens {
+		{ "md5", Token("1bc29b36f623ba82aaf6724fd3b16718") },
+		{ "ext", Token("jpg") },
+		{ "id", Token(7331) },
+		{ "score", Token("12.3") },
+		{ "artist", Token(QStringList() << "ar_tist1" << "artist2") },
+		{ "general", Token(QStringList() << "tag:1" << "tag/2" << "tag_3") },
+		{ "all", Token(QStringList() << "ar_tist1" << "artist2") },
+		{ "all_namespaces", Token(QStringList() << "artist" << "artist") },
+		{ "date", Token(QDateTime(QDate(2016, 8, 18), QTime(10, 30))) },
+		{ "url_file", Token("https://test.com/path/file.jpg") },
+		{ "gallery", Token(QVariant::fromValue(gallery)) },
+	};
+
+	SECTION("Empty")
+	{
+		FilenameParser parser("");
+		auto ast = parser.parseRoot();
+		FilenameProgram program(*ast);
+
+		QSettings settings("tests/resources/settings.ini", QSettings::IniFormat);
+		REQUIRE(program.run(tokens, &settings) == QString());
+	}
+
+	SECTION("Merges consecutive text")
+	{
+		FilenameParser parser("out/%md5%.%ext%");
+		auto ast = parser.parseRoot();
+		FilenameProgram program(*ast);
+
+		REQUIRE(program.size() == 4);
+	}
+
+	SECTION("Same result as the execution visitor")
+	{
+		compareWithVisitor("image.jpg", tokens);
+		compareWithVisitor("out/%md5%.%ext%", tokens);
+		compareWithVisitor("%id:length=6%-%score:length=5%", tokens);
+		compareWithVisitor("%artist% - %general%", tokens);
+		compareWithVisitor("%general:unsafe,separator=+%", tokens);
+		compareWithVisitor("%general:underscores,sort%", tokens);
+		compareWithVisitor("%artist:maxlength=6,htmlescape%", tokens);
+		compareWithVisitor("%all:includenamespace%", tokens);
+		compareWithVisitor("%artist:count%", tokens);
+		compareWithVisitor("%date:format=yyyy-MM-dd%", tokens);
+		compareWithVisitor("%url_file%", tokens);
+		compareWithVisitor("<galleries/%gallery.name%/>%md5%.%ext%", tokens);
+		compareWithVisitor("<galleries/%gallery.id%/>%md5%.%ext%", tokens);
+		compareWithVisitor("<%copyright%/><\"tag_3\"-%md5%.%ext%>", tokens);
+		compareWithVisitor("<%copyright%/><%artist%/>%md5%", tokens);
+		compareWithVisitor("%md5%<!%artist%-no artist>", tokens);
+		compareWithVisitor("<\"tag_3\"?has tag:%artist%>/<%missing%?yes:no>", tokens);
+	}
+
+	SECTION("Invalid tokens")
+	{
+		compareWithVisitor("%missing:opt=1,flag%/%num%.%ext%", tokens);
+		compareWithVisitor("%missing:opt=1,flag%/%num%.%ext%", tokens, true);
+		compareWithVisitor("%gallery.missing%/%md5%", tokens, true);
+	}
+
+	SECTION("Benchmark against the execution visitor")
+	{
+		FilenameParser parser("<%artist%/>%copyright%/%general:maxlength=50% - %id:length=8% (%score%)<\"tag_3\"-ok>.%ext%");
+		auto ast = parser.parseRoot();
+		REQUIRE(ast != nullptr);
+
+		QSettings settings("tests/resources/settings.ini", QSettings::IniFormat);
+		FilenameProgram program(*ast);
+		const int iterations = 2000;
+
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < iterations; ++i) {
+			executeVisitor(ast, tokens, &settings);
+		}
+		const qint64 visitorElapsed = timer.elapsed();
+
+		timer.restart();
+		for (int i = 0; i < iterations; ++i) {
+			program.run(tokens, &settings);
+		}
+		const qint64 programElapsed = timer.elapsed();
+
+		qDebug() << "Visitor" << visitorElapsed << "ms, program" << programElapsed << "ms for" << iterations << "renders";
+		REQUIRE(program.run(tokens, &settings) == executeVisitor(ast, tokens, &settings));
+	}
+}
@@ -0,0 +1,105 @@
+#include <QMap>
+#include <QScopedPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "filename/conditional-filename.h"
+#include "filename/filename-requirements.h"
+#include "models/filename.h"
+#include "models/image.h"
+#include "models/image-factory.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("FilenameRequirements")
+{
+	SECTION("Filename tokens")
+	{
+		auto requirements = Filename("%artist%/%md5:opt%.%ext%").requirements();
+
+		REQUIRE(requirements.tokens == QSet<QString>() << "artist" << "md5" << "ext");
+		REQUIRE(!requirements.tagTypes);
+	}
+
+	SECTION("Tag conditions, JavaScript and namespaces")
+	{
+		REQUIRE(Filename("<\"tag1\"?yes:no>.%ext%").requirements().tokens == QSet<QString>() << "tags" << "ext");
+		REQUIRE(Filename("javascript:md5 + '.' + ext").requirements().tokens == QSet<QString>() << "*");
+		REQUIRE(Filename("%all:includenamespace%.%ext%").requirements().tagTypes);
+	}
+
+	SECTION("Conditional filenames")
+	{
+		REQUIRE(ConditionalFilename("%rating%", "%id%.%ext%", "").requirements().tokens == QSet<QString>() << "rating" << "id" << "ext");
+		REQUIRE(ConditionalFilename("%rating%", "%id%.%ext%", "/%artist%").requirements().tokens == QSet<QString>() << "rating" << "id" << "ext" << "artist");
+		REQUIRE(ConditionalFilename("\"tag1\"", "", "").requirements().tokens == QSet<QString>() << "tags");
+		REQUIRE(ConditionalFilename("%rating", "%id%.%ext%", "").requirements().tokens.isEmpty());
+	}
+
+	SECTION("Merge")
+	{
+		FilenameRequirements requirements = Filename("%md5%.%ext%").requirements();
+		requirements.add(Filename("%all:includenamespace%").requirements());
+
+		REQUIRE(requirements.tokens == QSet<QString>() << "md5" << "ext" << "all");
+		REQUIRE(requirements.tagTypes);
+	}
+
+	SECTION("NeedExactTags")
+	{
+		REQUIRE(FilenameRequirements(QSet<QString> { "md5", "ext" }).needExactTags({}, {}) == 0);
+		REQUIRE(FilenameRequirements(QSet<QString> { "md5", "ext" }).needExactTags({ "*" }, {}) == 2);
+		REQUIRE(FilenameRequirements(QSet<QString> { "*" }).needExactTags({}, {}) == 2);
+		REQUIRE(FilenameRequirements(QSet<QString> { "character" }).needExactTags({}, {}) == 1);
+		REQUIRE(FilenameRequirements(QSet<QString> { "all" }, true).needExactTags({}, {}) == 1);
+		REQUIRE(FilenameRequirements(QSet<QString> { "date" }).needExactTags({ "date" }, {}) == 2);
+		REQUIRE(FilenameRequirements(QSet<QString> { "source" }).needExactTags({ "source" }, {}) == 2);
+		REQUIRE(FilenameRequirements(QSet<QString> { "all" }).needExactTags({ "tags" }, {}) == 2);
+		REQUIRE(FilenameRequirements(QSet<QString> { "custom" }).needExactTags({ "tags" }, {}) == 0);
+		REQUIRE(FilenameRequirements(QSet<QString> { "custom" }).needExactTags({ "tags" }, { "custom" }) == 2);
+	}
+
+	SECTION("NeedDetails")
+	{
+		setupSource("Danbooru (2.0)");
+		setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+		const QScopedPointer<Profile> profile(makeProfile());
+		Site *site = profile->getSites().value("danbooru.donmai.us");
+		REQUIRE(site != nullptr);
+
+		QMap<QString, QString> details;
+		details["id"] = "7331";
+		details["md5"] = "1bc29b36f623ba82aaf6724fd3b16718";
+		details["file_url"] = "http://test.com/img/oldfilename.jpg";
+		auto noTags = ImageFactory::build(site, details, profile.data());
+		details["tags"] = "tag1 tag2";
+		auto untypedTags = ImageFactory::build(site, details, profile.data());
+		details.remove("tags");
+		details["tags_general"] = "tag1 tag2";
+		details["tags_artist"] = "artist1";
+		auto typedTags = ImageFactory::build(site, details, profile.data());
+
+		// The tags returned by the listing are enough
+		const FilenameRequirements all(QSet<QString> { "all" });
+		REQUIRE(all.needDetails(*noTags, { "tags" }, {}));
+		REQUIRE(!all.needDetails(*untypedTags, { "tags" }, {}));
+		REQUIRE(!all.needDetails(*noTags, {}, {}));
+
+		// Typed tags are needed
+		const FilenameRequirements artist(QSet<QString> { "artist" });
+		REQUIRE(artist.needDetails(*noTags, { "tags" }, {}));
+		REQUIRE(artist.needDetails(*untypedTags, { "tags" }, {}));
+		REQUIRE(!artist.needDetails(*typedTags, { "tags" }, {}));
+		REQUIRE(!artist.needDetails(*typedTags, {}, {}));
+
+		// Other forced tokens are always needed
+		const FilenameRequirements date(QSet<QString> { "date" });
+		REQUIRE(date.needDetails(*typedTags, { "date" }, {}));
+		REQUIRE(!date.needDetails(*typedTags, { "filename" }, {}));
+		REQUIRE(FilenameRequirements(QSet<QString> { "md5" }).needDetails(*typedTags, { "*" }, {}));
+	}
+}
@@ -50,4 +50,30 @@ TEST_CASE("FilenameResolutionVisitor")
 
 		REQUIRE(results == QSet<QString>() << "md5" << "ext");
 	}
+
+	SECTION("Flags")
+	{
+		FilenameParser parser("<\"tag\"?%all:includenamespace%:%md5%>.%ext%");
+		auto ast = parser.parseRoot();
+
+		FilenameResolutionVisitor resolutionVisitor;
+		auto results = resolutionVisitor.run(*ast);
+
+		REQUIRE(results == QSet<QString>() << "all" << "md5" << "ext");
+		REQUIRE(resolutionVisitor.hasTagConditions());
+		REQUIRE(resolutionVisitor.hasNamespaces());
+		REQUIRE(!resolutionVisitor.hasJavaScript());
+	}
+
+	SECTION("Condition")
+	{
+		FilenameParser parser("%rating% & \"tag\"");
+		auto ast = parser.parseCondition();
+
+		FilenameResolutionVisitor resolutionVisitor;
+		auto results = resolutionVisitor.run(*ast);
+
+		REQUIRE(results == QSet<QString>() << "rating");
+		REQUIRE(resolutionVisitor.hasTagConditions());
+	}
 }
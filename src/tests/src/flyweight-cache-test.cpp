@@ -0,0 +1,88 @@
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QString>
+#include <thread>
+#include <vector>
+#include "flyweight-cache.h"
+#include "catch.h"
+
+
+struct FlyweightTestObject
+{
+	explicit FlyweightTestObject(const QString &key) : key(key) { instances.ref(); }
+	QString key;
+	static QAtomicInt instances;
+};
+QAtomicInt FlyweightTestObject::instances;
+
+class FlyweightTestCache : public FlyweightCache<QString, FlyweightTestObject, 4, 8>
+{};
+
+
+TEST_CASE("FlyweightCache")
+{
+	FlyweightTestCache::Sweep();
+
+	SECTION("Returns the same object for the same key")
+	{
+		auto a = FlyweightTestCache::Get("a");
+		auto b = FlyweightTestCache::Get("a");
+		auto c = FlyweightTestCache::Get("c");
+
+		REQUIRE(a == b);
+		REQUIRE(a != c);
+		REQUIRE(a->key == QString("a"));
+		REQUIRE(c->key == QString("c"));
+	}
+
+	SECTION("Creates a new object once the previous one is destroyed")
+	{
+		auto a = FlyweightTestCache::Get("a");
+		const int instances = FlyweightTestObject::instances.load();
+		a.clear();
+
+		auto b = FlyweightTestCache::Get("a");
+		REQUIRE(b->key == QString("a"));
+		REQUIRE(FlyweightTestObject::instances.load() == instances + 1);
+	}
+
+	SECTION("Sweeps dead entries")
+	{
+		auto alive = FlyweightTestCache::Get("alive");
+		for (int i = 0; i < 100; ++i) {
+			FlyweightTestCache::Get(QString::number(i));
+		}
+
+		// Entries are periodically swept while inserting
+		REQUIRE(FlyweightTestCache::Count() < 100);
+
+		FlyweightTestCache::Sweep();
+		REQUIRE(FlyweightTestCache::Count() == 1);
+		REQUIRE(FlyweightTestCache::Get("alive") == alive);
+	}
+
+	SECTION("Concurrent access")
+	{
+		auto kept = FlyweightTestCache::Get("kept");
+
+		std::vector<std::thread> threads;
+		std::vector<int> results(8, 1);
+		for (int t = 0; t < 8; ++t) {
+			threads.emplace_back([t, &kept, &results]() {
+				for (int i = 0; i < 1000; ++i) {
+					auto obj = FlyweightTestCache::Get(QString::number(i % 50));
+					if (obj->key != QString::number(i % 50) || FlyweightTestCache::Get("kept") != kept) {
+						results[t] = 0;
+					}
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+
+		for (int result : results) {
+			REQUIRE(result == 1);
+		}
+	}
+}
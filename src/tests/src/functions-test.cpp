@@ -271,6 +271,26 @@ TEST_CASE("Functions")
 		REQUIRE(levenshtein("12345678", "87654321") == 8);
 	}
 
+	SECTION("Levenshtein with a maximum distance")
+	{
+		// Within the maximum, the distance is exact
+		REQUIRE(levenshtein("password", "password", 0) == 0);
+		REQUIRE(levenshtein("password", "passXord", 1) == 1);
+		REQUIRE(levenshtein("12345678", "34567812", 4) == 4);
+		REQUIRE(levenshtein("12345678", "34567812", 10) == 4);
+
+		// Above it, "maximum + 1" is returned
+		REQUIRE(levenshtein("12345678", "56781234", 3) == 4);
+		REQUIRE(levenshtein("password", "passXord", 0) == 1);
+		REQUIRE(levenshtein("", "12345", 2) == 3);
+		REQUIRE(levenshtein("1", "1234567890", 1) == 2);
+
+		// Non-ASCII characters and long strings
+		REQUIRE(levenshtein(QString("caf") + QChar(0xE9), "cafe", 1) == 1);
+		REQUIRE(levenshtein(QString(100, 'a'), QString(99, 'a') + "b", 5) == 1);
+		REQUIRE(levenshtein(QString(100, 'a'), QString(100, 'b'), 5) == 6);
+	}
+
 	SECTION("RemoveWildards")
 	{
 		REQUIRE(removeWildards(QStringList(), QStringList()) == QStringList());
@@ -475,6 +495,9 @@ TEST_CASE("Functions")
 	{
 		REQUIRE(decodeHtmlEntities("pok&eacute;mon") == QString("pokémon"));
 		REQUIRE(decodeHtmlEntities("a&amp;b") == QString("a&b"));
+		REQUIRE(decodeHtmlEntities("no entities") == QString("no entities"));
+		REQUIRE(decodeHtmlEntities("&zwnj;&thetasym;&theta;&#65;&#x42;") == QString("\u200C\u03D1\u03B8AB"));
+		REQUIRE(decodeHtmlEntities("&amp &ampx; &unknown; a & b;") == QString("&amp &ampx; &unknown; a & b;"));
 	}
 
 	SECTION("splitCommand")
@@ -73,7 +73,7 @@ QList<QSharedPointer<Image>> getImages(const QString &source, const QString &sit
 	// Wait for downloader
 	QSignalSpy spy(&downloader, SIGNAL(finishedImages(QList<QSharedPointer<Image>>)));
 	downloader.getUrls();
-	REQUIRE(spy.count() == 1);
+	REQUIRE((spy.count() == 1 || spy.wait()));
 
 	// Get results
 	QList<QVariant> arguments = spy.takeFirst();
@@ -145,7 +145,7 @@ QList<Tag> getPageTags(const QString &source, const QString &site, const QString
 	// Wait for downloader
 	QSignalSpy spy(&downloader, SIGNAL(finishedTags(QList<Tag>)));
 	downloader.getPageTags();
-	REQUIRE(spy.count() == 1);
+	REQUIRE((spy.count() == 1 || spy.wait()));
 
 	// Get results
 	QList<QVariant> arguments = spy.takeFirst();
@@ -10,7 +10,7 @@
 #include "source-helpers.h"
 
 
-QList<int> getResults(Profile *profile, Site *site, QString search, int perPage, int total, int packSize, bool galleriesCountAsOne)
+QList<int> getResults(Profile *profile, Site *site, QString search, int perPage, int total, int packSize, bool galleriesCountAsOne, int prefetch = 0, int galleryPrefetch = 0)
 {
 	QList<int> ret;
 
@@ -18,6 +18,8 @@ QList<int> getResults(Profile *profile, Site *site, QString search, int perPage,
 	query.galleriesCountAsOne = galleriesCountAsOne;
 
 	PackLoader loader(profile, query, packSize, nullptr);
+	loader.setPrefetch(prefetch);
+	loader.setGalleryPrefetch(galleryPrefetch);
 	loader.start();
 	while (loader.hasNext()) {
 		auto images = loader.next();
@@ -77,6 +79,120 @@ TEST_CASE("PackLoader")
 		REQUIRE(getResults(profile, &site, "filesize:<200KB", 1, 3, 100, true) == QList<int>() << 3);
 	}
 
+	SECTION("Prefetch")
+	{
+		setupSource("Danbooru (2.0)");
+		setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+		Source source(profile, "tests/resources/sites/Danbooru (2.0)");
+		Site site("danbooru.donmai.us", &source);
+
+		// Login first
+		QSignalSpy spy(&site, SIGNAL(loggedIn(Site*, Site::LoginResult)));
+		QTimer::singleShot(0, &site, SLOT(login()));
+		REQUIRE(spy.wait());
+
+		// Same results and loaded pages as without prefetching
+		for (int prefetch : QList<int> { 1, 2, 3 }) {
+			for (int i = 1; i <= 8; ++i) {
+				CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-2-" + QString::number(i) + ".xml");
+			}
+			REQUIRE(getResults(profile, &site, "filesize:<200KB", 2, 13, 3, true) == QList<int>() << 3 << 3 << 3 << 3 << 1);
+			const int remaining = CustomNetworkAccessManager::NextFiles.count();
+			CustomNetworkAccessManager::NextFiles.clear();
+
+			for (int i = 1; i <= 8; ++i) {
+				CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-2-" + QString::number(i) + ".xml");
+			}
+			REQUIRE(getResults(profile, &site, "filesize:<200KB", 2, 13, 3, true, prefetch) == QList<int>() << 3 << 3 << 3 << 3 << 1);
+			REQUIRE(CustomNetworkAccessManager::NextFiles.count() == remaining);
+			CustomNetworkAccessManager::NextFiles.clear();
+		}
+	}
+
+	SECTION("Checkpoint")
+	{
+		setupSource("Danbooru (2.0)");
+		setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+		Source source(profile, "tests/resources/sites/Danbooru (2.0)");
+		Site site("danbooru.donmai.us", &source);
+
+		// Login first
+		QSignalSpy spy(&site, SIGNAL(loggedIn(Site*, Site::LoginResult)));
+		QTimer::singleShot(0, &site, SLOT(login()));
+		REQUIRE(spy.wait());
+
+		DownloadQueryGroup query(QStringList() << "filesize:<200KB", 1, 2, 13, QStringList(), false, &site, "%md5%.%ext%", "");
+
+		// Stop after the second pack of 3, the second page of 2 having one image left
+		for (int i = 1; i <= 3; ++i) {
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-2-" + QString::number(i) + ".xml");
+		}
+		DownloadQueryGroup::Checkpoint checkpoint;
+		{
+			PackLoader loader(profile, query, 3, nullptr);
+			loader.start();
+			REQUIRE(loader.next().count() == 3);
+			REQUIRE(loader.checkpoint().page == 1);
+			REQUIRE(loader.checkpoint().total == 0);
+			REQUIRE(loader.next().count() == 3);
+			checkpoint = loader.checkpoint();
+		}
+		CustomNetworkAccessManager::NextFiles.clear();
+
+		REQUIRE(checkpoint.page == 2);
+		REQUIRE(checkpoint.total == 3);
+		REQUIRE(checkpoint.skip == 1);
+		REQUIRE(checkpoint.lastPage == 1);
+		REQUIRE(checkpoint.lastPageMinId > 0);
+
+		// Resuming directly loads the second page, without counting its first image again
+		query.progressVal = 3;
+		query.checkpoint = checkpoint;
+		for (int i = 2; i <= 8; ++i) {
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-2-" + QString::number(i) + ".xml");
+		}
+		QList<int> counts;
+		PackLoader loader(profile, query, 3, nullptr);
+		loader.start();
+		while (loader.hasNext()) {
+			counts.append(loader.next().count());
+		}
+		REQUIRE(counts == QList<int>() << 3 << 3 << 3 << 1);
+		CustomNetworkAccessManager::NextFiles.clear();
+	}
+
+	SECTION("MaxLimit")
+	{
+		setupSource("Danbooru (2.0)");
+		setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+		Source source(profile, "tests/resources/sites/Danbooru (2.0)");
+		Site site("danbooru.donmai.us", &source);
+
+		// Login first
+		QSignalSpy spy(&site, SIGNAL(loggedIn(Site*, Site::LoginResult)));
+		QTimer::singleShot(0, &site, SLOT(login()));
+		REQUIRE(spy.wait());
+
+		// 2 packs of 9 from a single page, instead of 8 pages of 2
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-20-1.xml");
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/pack-loader-2-2.xml");
+
+		DownloadQueryGroup query(QStringList() << "filesize:<200KB", 1, 2, 15, QStringList(), false, &site, "%md5%.%ext%", "");
+		PackLoader loader(profile, query, 9, nullptr);
+		loader.setUseMaxLimit(true);
+		loader.start();
+
+		REQUIRE(loader.next().count() == 9);
+		REQUIRE(loader.checkpoint().perPage == 15);
+		REQUIRE(loader.next().count() == 6);
+		REQUIRE(!loader.hasNext());
+		REQUIRE(CustomNetworkAccessManager::NextFiles.count() == 1);
+		CustomNetworkAccessManager::NextFiles.clear();
+	}
+
 	SECTION("WrongResultsCount")
 	{
 		setupSource("Gelbooru (0.2)");
@@ -138,6 +254,14 @@ TEST_CASE("PackLoader")
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-gallery-3-1.html");
 		REQUIRE(getResults(profile, &site, "tomose shunsaku", 1, 3, 50, true) == QList<int>() << 50 << 37);
 
+		// Same results when loading galleries in parallel
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-list.html");
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-gallery-1-1.html");
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-gallery-2-1.html");
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-gallery-3-1.html");
+		REQUIRE(getResults(profile, &site, "tomose shunsaku", 1, 3, 50, true, 0, 4) == QList<int>() << 50 << 37);
+		REQUIRE(CustomNetworkAccessManager::NextFiles.isEmpty());
+
 		// 1 pack of 50 from 1 gallery of 31 (images)
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-list.html");
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/e-hentai.org/pack-loader-gallery-1-1.html");
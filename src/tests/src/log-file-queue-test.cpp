@@ -0,0 +1,73 @@
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include "log-file-queue.h"
+#include "post-save-queue.h"
+#include "catch.h"
+
+
+static QString readFile(const QString &path)
+{
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+		return QString();
+	}
+	return QString::fromUtf8(file.readAll());
+}
+
+
+TEST_CASE("LogFileQueue")
+{
+	QDir("tests/resources/tmp/log-files").removeRecursively();
+	QDir().mkpath("tests/resources/tmp/log-files");
+
+	SECTION("Contents are appended in order, one per line")
+	{
+		PostSaveQueue postSaveQueue(2, 100);
+		LogFileQueue queue(&postSaveQueue);
+		for (int i = 0; i < 10; ++i) {
+			queue.add(QString("tests/resources/tmp/log-files/%1.txt").arg(i % 2 == 0 ? "a" : "b"), QString::number(i));
+		}
+		REQUIRE(postSaveQueue.waitForDone(5000));
+
+		REQUIRE(readFile("tests/resources/tmp/log-files/a.txt") == QString("0\n2\n4\n6\n8"));
+		REQUIRE(readFile("tests/resources/tmp/log-files/b.txt") == QString("1\n3\n5\n7\n9"));
+	}
+
+	SECTION("Existing files are appended to")
+	{
+		QFile file("tests/resources/tmp/log-files/existing.txt");
+		file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate);
+		file.write("first");
+		file.close();
+
+		PostSaveQueue postSaveQueue(1, 100);
+		LogFileQueue queue(&postSaveQueue, 0);
+		queue.add("tests/resources/tmp/log-files/existing.txt", "second");
+		REQUIRE(postSaveQueue.waitForDone(5000));
+		queue.add("tests/resources/tmp/log-files/existing.txt", "third");
+		REQUIRE(postSaveQueue.waitForDone(5000));
+
+		REQUIRE(readFile("tests/resources/tmp/log-files/existing.txt") == QString("first\nsecond\nthird"));
+	}
+
+	SECTION("Only the most recently used files are kept open")
+	{
+		PostSaveQueue postSaveQueue(1, 100);
+		LogFileQueue queue(&postSaveQueue, 1);
+		queue.add("tests/resources/tmp/log-files/a.txt", "1");
+		queue.add("tests/resources/tmp/log-files/b.txt", "2");
+		REQUIRE(postSaveQueue.waitForDone(5000));
+
+		// "a.txt" was closed when "b.txt" was opened, so it can be removed on all platforms
+		REQUIRE(QFile::remove("tests/resources/tmp/log-files/a.txt"));
+		queue.add("tests/resources/tmp/log-files/a.txt", "3");
+		queue.add("tests/resources/tmp/log-files/b.txt", "4");
+		REQUIRE(postSaveQueue.waitForDone(5000));
+
+		REQUIRE(readFile("tests/resources/tmp/log-files/a.txt") == QString("3"));
+		REQUIRE(readFile("tests/resources/tmp/log-files/b.txt") == QString("2\n4"));
+	}
+
+	QDir("tests/resources/tmp/log-files").removeRecursively();
+}
@@ -1,3 +1,4 @@
+#include <QDateTime>
 #include <QNetworkRequest>
 #include <QSettings>
 #include <QSignalSpy>
@@ -77,4 +78,55 @@ TEST_CASE("OAuth2Login")
 		testLogin("client_credentials", "body", "tests/resources/oauth2/no_token_type.json", Login::Result::Failure, QString(), site, &accessManager);
 		testLogin("password", "body", "tests/resources/oauth2/wrong_token_type.json", Login::Result::Failure, QString(), site, &accessManager);
 	}
+
+	SECTION("PersistedToken")
+	{
+		MixedSettings *settings = site->settings();
+		settings->setValue("auth/accessToken", "persisted_token");
+		settings->setValue("auth/refreshToken", "refresh_token");
+		settings->setValue("auth/expires", QDateTime::currentDateTime().addSecs(3600));
+
+		OAuth2Auth auth("oauth2", "refresh_token", "/token", "/authorization", "/redirect", "");
+		OAuth2Login login(&auth, site, &accessManager, settings);
+
+		// A token that is still valid can be used right away, without any request
+		QSignalSpy spy(&login, SIGNAL(loggedIn(Login::Result)));
+		login.login();
+		REQUIRE(spy.count() == 1);
+		REQUIRE(spy.takeFirst().at(0).value<Login::Result>() == Login::Result::Success);
+
+		QNetworkRequest req;
+		login.complementRequest(&req);
+		REQUIRE(QString(req.rawHeader("Authorization")) == QString("Bearer persisted_token"));
+
+		settings->remove("auth/expires");
+	}
+
+	SECTION("SingleRefresh")
+	{
+		MixedSettings *settings = site->settings();
+		settings->setValue("auth/accessToken", "");
+		settings->setValue("auth/refreshToken", "refresh_token");
+		settings->remove("auth/expires");
+
+		OAuth2Auth auth("oauth2", "refresh_token", "/token", "/authorization", "/redirect", "");
+		OAuth2Login login(&auth, site, &accessManager, settings);
+
+		// Logins during a refresh wait for it instead of starting another one
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/oauth2/ok_refresh.json");
+		QSignalSpy spy(&login, SIGNAL(loggedIn(Login::Result)));
+		login.login();
+		login.login();
+		REQUIRE(spy.wait());
+		REQUIRE(spy.count() == 1);
+		REQUIRE(spy.takeFirst().at(0).value<Login::Result>() == Login::Result::Success);
+		REQUIRE(CustomNetworkAccessManager::NextFiles.isEmpty());
+
+		// The new tokens and their expiration are kept for the next runs
+		REQUIRE(settings->value("auth/accessToken").toString() == QString("refreshed_token"));
+		REQUIRE(settings->value("auth/refreshToken").toString() == QString("new_refresh_token"));
+		REQUIRE(settings->value("auth/expires").toDateTime() > QDateTime::currentDateTime());
+
+		settings->remove("auth/expires");
+	}
 }
@@ -0,0 +1,55 @@
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include "login/session-manager.h"
+#include "models/profile.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("SessionManager")
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	const QScopedPointer<Profile> profile(makeProfile());
+	Site *site = profile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	SessionManager manager;
+	QSignalSpy finishedSpy(&manager, SIGNAL(finished()));
+	QSignalSpy progressSpy(&manager, SIGNAL(progress(int, int)));
+
+	SECTION("No sites")
+	{
+		manager.login({});
+
+		REQUIRE(!manager.isRunning());
+		REQUIRE(finishedSpy.wait());
+		REQUIRE(finishedSpy.count() == 1);
+		REQUIRE(progressSpy.isEmpty());
+	}
+
+	SECTION("Sites are only logged in once")
+	{
+		manager.login({ site, site });
+
+		REQUIRE(manager.isRunning());
+		REQUIRE(finishedSpy.wait());
+		REQUIRE(!manager.isRunning());
+		REQUIRE(finishedSpy.count() == 1);
+
+		REQUIRE(progressSpy.count() == 2);
+		REQUIRE(progressSpy[0] == QList<QVariant>({ 0, 1 }));
+		REQUIRE(progressSpy[1] == QList<QVariant>({ 1, 1 }));
+	}
+
+	SECTION("Cancel")
+	{
+		manager.login({ site });
+		manager.cancel();
+
+		REQUIRE(!manager.isRunning());
+		REQUIRE(!finishedSpy.wait(500));
+	}
+}
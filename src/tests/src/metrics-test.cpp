@@ -0,0 +1,74 @@
+#include <QString>
+#include "metrics.h"
+#include "catch.h"
+
+
+TEST_CASE("Metrics")
+{
+	Metrics metrics;
+
+	SECTION("Label escaping")
+	{
+		REQUIRE(Metrics::label("site", "a\"b\\c") == QString("site=\"a\\\"b\\\\c\""));
+	}
+
+	SECTION("Counters")
+	{
+		metrics.increment("requests_total", Metrics::label("host", "a"));
+		metrics.increment("requests_total", Metrics::label("host", "a"), 2);
+		metrics.increment("requests_total", Metrics::label("host", "b"));
+
+		const QList<Metrics::Series> series = metrics.series();
+		REQUIRE(series.count() == 2);
+		REQUIRE(series[0].labels == QString("host=\"a\""));
+		REQUIRE(series[0].value == 3);
+		REQUIRE(series[1].value == 1);
+	}
+
+	SECTION("Gauges")
+	{
+		metrics.setGauge("queue_size", QString(), 5);
+		metrics.setGauge("queue_size", QString(), 2);
+
+		REQUIRE(metrics.series().first().value == 2);
+		REQUIRE(metrics.toPrometheus() == QString("# TYPE queue_size gauge\nqueue_size 2\n"));
+	}
+
+	SECTION("Histograms")
+	{
+		metrics.observe("duration_ms", QString(), 3);
+		metrics.observe("duration_ms", QString(), 7);
+		metrics.observe("duration_ms", QString(), 100000);
+
+		const Metrics::Series series = metrics.series().first();
+		REQUIRE(series.count == 3);
+		REQUIRE(series.sum == 100010);
+
+		const QString prometheus = metrics.toPrometheus();
+		REQUIRE(prometheus.contains("duration_ms_bucket{le=\"1\"} 0\n"));
+		REQUIRE(prometheus.contains("duration_ms_bucket{le=\"5\"} 1\n"));
+		REQUIRE(prometheus.contains("duration_ms_bucket{le=\"10\"} 2\n"));
+		REQUIRE(prometheus.contains("duration_ms_bucket{le=\"30000\"} 2\n"));
+		REQUIRE(prometheus.contains("duration_ms_bucket{le=\"+Inf\"} 3\n"));
+		REQUIRE(prometheus.contains("duration_ms_sum 100010\n"));
+		REQUIRE(prometheus.contains("duration_ms_count 3\n"));
+	}
+
+	SECTION("Prometheus export with help and labels")
+	{
+		metrics.describe("downloads_total", Metrics::Counter, "Image downloads.");
+		metrics.increment("downloads_total", Metrics::label("result", "Saved"));
+
+		REQUIRE(metrics.toPrometheus() == QString("# HELP downloads_total Image downloads.\n# TYPE downloads_total counter\ndownloads_total{result=\"Saved\"} 1\n"));
+	}
+
+	SECTION("Clear")
+	{
+		metrics.describe("downloads_total", Metrics::Counter, "Image downloads.");
+		metrics.increment("downloads_total");
+		metrics.clear();
+
+		REQUIRE(metrics.series().isEmpty());
+		REQUIRE(metrics.toPrometheus().isEmpty());
+	}
+}
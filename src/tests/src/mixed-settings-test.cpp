@@ -37,6 +37,34 @@ TEST_CASE("MixedSettings")
 		REQUIRE(settings.value("test").toString() == QString("child"));
 	}
 
+	SECTION("ValueCached")
+	{
+		MixedSettings settings(QList<QSettings*>() << child << parent);
+
+		parent->setValue("test", "parent");
+		REQUIRE(settings.value("test").toString() == QString("parent"));
+		REQUIRE(settings.value("other", "default").toString() == QString("default"));
+		REQUIRE(settings.value("other", "default2").toString() == QString("default2"));
+
+		settings.setValue("test", "child", "default");
+		REQUIRE(settings.value("test").toString() == QString("child"));
+	}
+
+	SECTION("ValueInGroup")
+	{
+		MixedSettings settings(QList<QSettings*>() << child << parent);
+
+		child->setValue("test", "root");
+		child->setValue("Group/test", "group");
+		REQUIRE(settings.value("test").toString() == QString("root"));
+
+		settings.beginGroup("Group");
+		REQUIRE(settings.value("test").toString() == QString("group"));
+		settings.endGroup();
+
+		REQUIRE(settings.value("test").toString() == QString("root"));
+	}
+
 	SECTION("ValueDefault")
 	{
 		MixedSettings settings(QList<QSettings*>() << child << parent);
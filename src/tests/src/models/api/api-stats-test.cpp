@@ -0,0 +1,93 @@
+#include <QDateTime>
+#include <QStringList>
+#include <QTemporaryDir>
+#include "models/api/api-stats.h"
+#include "catch.h"
+
+
+TEST_CASE("ApiStats")
+{
+	const QStringList apis { "Json", "Xml", "Html" };
+	const QDateTime now = QDateTime::currentDateTimeUtc();
+
+	SECTION("Keep the original order without data")
+	{
+		ApiStats stats;
+		REQUIRE(stats.sort(apis) == apis);
+	}
+
+	SECTION("A few failures are not enough to demote an API")
+	{
+		ApiStats stats;
+		stats.add("Json", false, 0, now);
+		stats.add("Json", false, 0, now);
+
+		REQUIRE(!stats.isFailing("Json", now));
+		REQUIRE(stats.sort(apis, now) == apis);
+	}
+
+	SECTION("Failing APIs are tried last")
+	{
+		ApiStats stats;
+		for (int i = 0; i < 5; ++i) {
+			stats.add("Json", false, 0, now);
+			stats.add("Xml", true, 200, now);
+			stats.add("Html", true, 200, now);
+		}
+
+		REQUIRE(stats.isFailing("Json", now));
+		REQUIRE(stats.successRate("Xml") > 0.99);
+		REQUIRE(stats.sort(apis, now) == QStringList { "Xml", "Html", "Json" });
+	}
+
+	SECTION("Much slower APIs are tried later")
+	{
+		ApiStats stats;
+		for (int i = 0; i < 5; ++i) {
+			stats.add("Json", true, 2000, now);
+			stats.add("Xml", true, 300, now);
+			stats.add("Html", true, 400, now);
+		}
+
+		REQUIRE(stats.latency("Json") == 2000);
+		REQUIRE(stats.sort(apis, now) == QStringList { "Xml", "Html", "Json" });
+	}
+
+	SECTION("Failing APIs are probed again after a while")
+	{
+		ApiStats stats(QString(), 3600);
+		const QDateTime old = now.addSecs(-7200);
+		for (int i = 0; i < 5; ++i) {
+			stats.add("Json", false, 0, old);
+		}
+
+		REQUIRE(!stats.isFailing("Json", now));
+		REQUIRE(stats.sort(apis, now) == apis);
+
+		// Recovered APIs get promoted back
+		for (int i = 0; i < 4; ++i) {
+			stats.add("Json", true, 200, now);
+		}
+		REQUIRE(stats.successRate("Json") > 0.5);
+		REQUIRE(stats.sort(apis, now) == apis);
+	}
+
+	SECTION("Persistence")
+	{
+		QTemporaryDir dir;
+		REQUIRE(dir.isValid());
+		const QString file = dir.filePath("apis.json");
+
+		{
+			ApiStats stats(file);
+			for (int i = 0; i < 5; ++i) {
+				stats.add("Json", false, 0, now);
+			}
+			REQUIRE(stats.save());
+		}
+
+		ApiStats stats(file);
+		REQUIRE(stats.isFailing("Json", now));
+		REQUIRE(stats.sort(apis, now).last() == QString("Json"));
+	}
+}
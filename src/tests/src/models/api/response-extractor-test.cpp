@@ -0,0 +1,104 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include "catch.h"
+#include "models/api/response-extractor.h"
+
+
+TEST_CASE("ResponseExtractor")
+{
+	SECTION("Invalid without fields")
+	{
+		REQUIRE(!ResponseExtractor().isValid());
+		REQUIRE(!ResponseExtractor(ResponseExtractor::Json, "/posts", {}).isValid());
+	}
+
+	SECTION("JSON pointers")
+	{
+		const QJsonValue root = QJsonDocument::fromJson(R"({"a": {"b/c": [1, {"d~e": "f"}]}})").object();
+
+		REQUIRE(ResponseExtractor::jsonPointer(root, "") == root);
+		REQUIRE(ResponseExtractor::jsonPointer(root, "/a/b~1c/0").toInt() == 1);
+		REQUIRE(ResponseExtractor::jsonPointer(root, "/a/b~1c/1/d~0e").toString() == QString("f"));
+		REQUIRE(ResponseExtractor::jsonPointer(root, "/a/x").isUndefined());
+		REQUIRE(ResponseExtractor::jsonPointer(root, "/a/b~1c/y").isUndefined());
+		REQUIRE(ResponseExtractor::jsonPointer(root, "a").isUndefined());
+	}
+
+	SECTION("JSON")
+	{
+		const QMap<QString, QString> fields {
+			{ "id", "/id" },
+			{ "file_url", "/file/url" },
+			{ "tags", "/tags" },
+			{ "sources", "/sources" },
+			{ "rating", "/rating" },
+		};
+		ResponseExtractor extractor(ResponseExtractor::Json, "/posts", fields, "/count");
+		REQUIRE(extractor.isValid());
+
+		const auto result = extractor.extract(R"({
+			"count": 123,
+			"posts": [
+				{ "id": 1, "file": { "url": "a.jpg" }, "tags": ["tag1", "tag2"], "sources": ["s1", "s2"] },
+				{ "id": 2, "rating": "safe" },
+				{ "other": true }
+			]
+		})");
+
+		REQUIRE(result.error.isEmpty());
+		REQUIRE(result.imageCount == 123);
+		REQUIRE(result.pageCount == -1);
+		REQUIRE(result.images.count() == 2);
+		REQUIRE(result.images[0]["id"] == QString("1"));
+		REQUIRE(result.images[0]["file_url"] == QString("a.jpg"));
+		REQUIRE(result.images[0]["tags"] == QString("tag1 tag2"));
+		REQUIRE(result.images[0]["sources"] == QString("s1\ns2"));
+		REQUIRE(!result.images[0].contains("rating"));
+		REQUIRE(result.images[1]["rating"] == QString("safe"));
+	}
+
+	SECTION("JSON errors")
+	{
+		ResponseExtractor extractor(ResponseExtractor::Json, "/posts", { { "id", "/id" } });
+
+		REQUIRE(!extractor.extract("<html></html>").error.isEmpty());
+		REQUIRE(!extractor.extract(R"({"error": "Invalid search"})").error.isEmpty());
+		REQUIRE(extractor.extract(R"({"posts": []})").error.isEmpty());
+	}
+
+	SECTION("XML")
+	{
+		const QMap<QString, QString> fields {
+			{ "id", "@id" },
+			{ "file_url", "file/@url" },
+			{ "tags", "tags" },
+		};
+		ResponseExtractor extractor(ResponseExtractor::Xml, "posts/post", fields, "@count");
+
+		const auto result = extractor.extract(R"(<?xml version="1.0"?>
+			<posts count="42">
+				<post id="1"><file url="a.jpg"/><tags>tag1 tag2</tags></post>
+				<post id="2"/>
+			</posts>)");
+
+		REQUIRE(result.error.isEmpty());
+		REQUIRE(result.imageCount == 42);
+		REQUIRE(result.images.count() == 2);
+		REQUIRE(result.images[0]["id"] == QString("1"));
+		REQUIRE(result.images[0]["file_url"] == QString("a.jpg"));
+		REQUIRE(result.images[0]["tags"] == QString("tag1 tag2"));
+		REQUIRE(result.images[1]["id"] == QString("2"));
+		REQUIRE(!result.images[1].contains("file_url"));
+	}
+
+	SECTION("XML errors")
+	{
+		ResponseExtractor extractor(ResponseExtractor::Xml, "posts/post", { { "id", "@id" } });
+
+		REQUIRE(!extractor.extract("{}").error.isEmpty());
+		REQUIRE(!extractor.extract("<error>Invalid search</error>").error.isEmpty());
+		REQUIRE(extractor.extract("<posts count=\"0\"/>").error.isEmpty());
+	}
+}
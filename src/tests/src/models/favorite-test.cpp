@@ -1,5 +1,6 @@
 #include <QDir>
 #include <QFile>
+#include <QImage>
 #include <QJsonObject>
 #include <QPixmap>
 #include <algorithm>
@@ -207,6 +208,21 @@ TEST_CASE("Favorite")
 			Favorite fav("tag1", 50, date, QDir::currentPath() + "/tests/resources/image_200x200.png");
 			QPixmap actual = fav.getImage();
 
+			REQUIRE(file.exists() == true);
+			REQUIRE(actual.isNull() == false);
+			REQUIRE(actual.size() == QSize(150, 150));
+		}
+		SECTION("GetThumbnail")
+		{
+			QFile file(savePath("thumbs/tag1.png"));
+			if (file.exists()) {
+				file.remove();
+			}
+
+			QDateTime date = QDateTime::fromString("2016-07-02 16:35:12", "yyyy-MM-dd HH:mm:ss");
+			Favorite fav("tag1", 50, date, QDir::currentPath() + "/tests/resources/image_200x200.png");
+			QImage actual = fav.getThumbnail();
+
 			REQUIRE(file.exists() == true);
 			REQUIRE(actual.isNull() == false);
 			REQUIRE(actual.size() == QSize(150, 150));
@@ -54,6 +54,36 @@ TEST_CASE("Blacklist")
 		REQUIRE(Blacklist(QStringList() << "character1" << "artist1").match(tokens, false) == QStringList());
 	}
 
+	SECTION("Matches")
+	{
+		QMap<QString, Token> tokens;
+		tokens.insert("allos", Token(QStringList() << "tag1" << "tag2" << "tag3"));
+
+		REQUIRE(!Blacklist(QStringList() << "tag8" << "tag7").matches(tokens));
+		REQUIRE(Blacklist(QStringList() << "tag1" << "tag7").matches(tokens));
+		REQUIRE(Blacklist(QStringList() << "tag8" << "tag7").matches(tokens, false));
+		REQUIRE(!Blacklist(QStringList() << "tag1" << "tag2").matches(tokens, false));
+	}
+
+	SECTION("Match complex rules")
+	{
+		QMap<QString, Token> tokens;
+		tokens.insert("allos", Token(QStringList() << "tag1" << "tag2" << "tag3"));
+
+		Blacklist blacklist;
+		blacklist.add(QStringList() << "tag1" << "tag8");
+		blacklist.add(QStringList() << "tag2" << "tag3");
+		blacklist.add(QStringList() << "-tag8" << "tag3");
+		blacklist.add(QStringList() << "tag*");
+		blacklist.add(QStringList() << "-tag1");
+
+		REQUIRE(blacklist.match(tokens) == QStringList() << "tag2 tag3" << "-tag8 tag3" << "tag*");
+
+		// The index should be kept up to date when removing rules
+		blacklist.remove("tag*");
+		REQUIRE(blacklist.match(tokens) == QStringList() << "tag2 tag3" << "-tag8 tag3");
+	}
+
 	SECTION("Escaping colon in tags")
 	{
 		Blacklist blacklist(QStringList() << "re::zero");
@@ -69,4 +99,12 @@ TEST_CASE("Blacklist")
 		REQUIRE(blacklist.match(tokensWith) == QStringList("re:zero"));
 		REQUIRE(blacklist.match(tokensWithout) == QStringList());
 	}
+
+	SECTION("Plain tags")
+	{
+		Blacklist blacklist(QStringList() << "tag1" << "tag*" << "rating:explicit" << "-tag2" << "re::zero");
+		blacklist.add(QStringList() << "tag3" << "tag4");
+
+		REQUIRE(blacklist.plainTags() == QStringList() << "tag1");
+	}
 }
@@ -75,6 +75,16 @@ TEST_CASE("MetaFilter")
 		REQUIRE(MetaFilter("id", "10", true).match(tokens) == QString());
 	}
 
+	SECTION("MatchLargeNumbers")
+	{
+		QMap<QString, Token> tokens;
+		tokens.insert("id", Token(Q_UINT64_C(5000000000)));
+
+		REQUIRE(MetaFilter("id", ">4000000000").match(tokens) == QString());
+		REQUIRE(MetaFilter("id", "4000000000..6000000000").match(tokens) == QString());
+		REQUIRE(MetaFilter("id", "<=4000000000").match(tokens) == QString("image's id does not match"));
+	}
+
 	SECTION("MatchDate")
 	{
 		QMap<QString, Token> tokens;
@@ -116,4 +116,84 @@ TEST_CASE("PostFilter")
 		filters = PostFilter(QStringList() << "-id:<=10000" << "-width:>100" << "-date:<2017-01-01").match(tokens);
 		REQUIRE(filters == QStringList() << "image's id match" << "image's width match" << "image's date match");
 	}
+
+	SECTION("FilterAvailable")
+	{
+		QMap<QString, QString> listing = details;
+		const ImageFactoryData parsed = ImageFactory::parse(listing, QVariantMap(), QList<Tag>());
+		const auto tokens = ImageFactory::listingTokens(listing, parsed);
+
+		REQUIRE(tokens.contains("id"));
+		REQUIRE(tokens.contains("md5"));
+		REQUIRE(tokens.contains("width"));
+		REQUIRE(tokens.contains("rating"));
+		REQUIRE(tokens.contains("allos"));
+		REQUIRE(!tokens.contains("date"));
+
+		// Filters on values not in the listing are ignored
+		const QStringList available = PostFilter(QStringList() << "id:>10000" << "width:<=100" << "date:>=2017-01-01" << "-tag1" << "score:>100").matchAvailable(tokens);
+		REQUIRE(available.count() == 4);
+		REQUIRE(available == PostFilter(QStringList() << "id:>10000" << "width:<=100" << "-tag1" << "score:>100").match(img->tokens(profile)));
+
+		// No match
+		REQUIRE(PostFilter(QStringList() << "id:<=10000" << "tag1" << "-tag4" << "rating:safe").matchAvailable(tokens).isEmpty());
+
+		// Tag filters need the listing to have tags
+		listing.clear();
+		listing["id"] = "7331";
+		const auto noTags = ImageFactory::listingTokens(listing, ImageFactory::parse(listing, QVariantMap(), QList<Tag>()));
+		REQUIRE(PostFilter(QStringList() << "-id:7331" << "tag4").matchAvailable(noTags) == QStringList() << "image's id match");
+	}
+
+	SECTION("Needs")
+	{
+		const auto tokens = img->tokens(profile);
+
+		REQUIRE(PostFilter(QStringList() << "width:>=1920").needs(tokens, { "width", "height" }));
+		REQUIRE(PostFilter(QStringList() << "-tag1" << "filesize:<5MB").needs(tokens, { "filesize" }));
+		REQUIRE(!PostFilter(QStringList() << "-tag1" << "score:>100").needs(tokens, { "width", "height", "filesize" }));
+		REQUIRE(!PostFilter().needs(tokens, { "width" }));
+	}
+
+	SECTION("PushDown")
+	{
+		const QStringList modifiers { "rating:safe", "id:", "width:", "score:" };
+		const PostFilter postFilter(QStringList() << "width:>=1920" << "rating:safe" << "rating:explicit" << "date:<2017-01-01" << "-score:>10" << "tag1" << "-tag2" << "tag*" << "%md5%");
+
+		SECTION("Translatable filters are moved to the search")
+		{
+			QStringList search { "tag3" };
+			const PostFilter remaining = postFilter.pushDown(search, modifiers);
+
+			REQUIRE(search == QStringList() << "tag3" << "width:>=1920" << "rating:safe" << "tag1" << "-tag2");
+			REQUIRE(remaining.count() == 5);
+		}
+
+		SECTION("Filters already in the search are removed")
+		{
+			QStringList search { "rating:safe" };
+			const PostFilter remaining = postFilter.pushDown(search, modifiers);
+
+			REQUIRE(search == QStringList() << "rating:safe" << "width:>=1920" << "tag1" << "-tag2");
+			REQUIRE(remaining.count() == 5);
+		}
+
+		SECTION("Tag limit")
+		{
+			QStringList search { "tag3" };
+			const PostFilter remaining = postFilter.pushDown(search, modifiers, 2);
+
+			REQUIRE(search == QStringList() << "tag3" << "width:>=1920");
+			REQUIRE(remaining.count() == 8);
+		}
+
+		SECTION("No modifiers")
+		{
+			QStringList search { "tag3" };
+			const PostFilter remaining = postFilter.pushDown(search, {});
+
+			REQUIRE(search == QStringList() << "tag3");
+			REQUIRE(remaining.count() == 9);
+		}
+	}
 }
@@ -123,6 +123,24 @@ TEST_CASE("ImageSize")
 		REQUIRE(is.md5() == "956ddde86fb5ce85218b21e2f49e5c50");
 	}
 
+	SECTION("MD5 of a missing file")
+	{
+		ImageSize is;
+		is.setSavePath("tests/resources/does_not_exist.png");
+		REQUIRE(is.md5() == "");
+	}
+
+	SECTION("MD5 already known")
+	{
+		ImageSize is;
+		is.setSavePath("tests/resources/image_1x1.png");
+		is.setMd5("known");
+		REQUIRE(is.md5() == "known");
+
+		is.setMd5(QString());
+		REQUIRE(is.md5() == "956ddde86fb5ce85218b21e2f49e5c50");
+	}
+
 	SECTION("Serialization")
 	{
 		ImageSize original;
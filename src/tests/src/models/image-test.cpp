@@ -4,6 +4,7 @@
 #include <QScopedPointer>
 #include <QSettings>
 #include <QSignalSpy>
+#include "downloader/extension-rotator.h"
 #include "loader/token.h"
 #include "models/image.h"
 #include "models/image-factory.h"
@@ -121,6 +122,22 @@ TEST_CASE("Image")
 		REQUIRE(!img->hasTag("copyright3"));
 	}
 
+	SECTION("ExtensionRotator")
+	{
+		ExtensionRotator *rotator = img->extensionRotator();
+		REQUIRE(rotator != nullptr);
+		REQUIRE(img->extensionRotator() == rotator);
+	}
+
+	SECTION("MemoryUsage")
+	{
+		const qint64 usage = img->memoryUsage();
+		REQUIRE(usage > static_cast<qint64>(sizeof(Image)));
+
+		img->setTags(QList<Tag>());
+		REQUIRE(img->memoryUsage() < usage);
+	}
+
 
 	/*SECTION("Md5FromFile")
 	{
@@ -0,0 +1,84 @@
+#include <QFile>
+#include <QStringList>
+#include "models/local-index.h"
+#include "catch.h"
+#include "raii-helpers.h"
+
+
+static QStringList paths(const QList<LocalIndex::Entry> &entries)
+{
+	QStringList ret;
+	for (const LocalIndex::Entry &entry : entries) {
+		ret.append(entry.path);
+	}
+	return ret;
+}
+
+
+TEST_CASE("LocalIndex")
+{
+	FileDeleter indexDeleter("tests/resources/local-index.txt", true);
+
+	QFile f("tests/resources/local-index.txt");
+	f.open(QFile::WriteOnly | QFile::Text | QFile::Truncate);
+	f.write("+\tmd5a\tdanbooru.donmai.us\ttests/resources/a.png\ttag1 tag2 character_a\n");
+	f.write("+\tmd5b\tdanbooru.donmai.us\ttests/resources/b.png\ttag2 tag3 character_b\n");
+	f.write("+\tmd5c\tgelbooru.com\ttests/resources/c.png\ttag1 tag2 tag3\n");
+	f.write("-\ttests/resources/d.png\n");
+	f.close();
+
+	SECTION("The constructor should load all the files")
+	{
+		LocalIndex index("tests/resources/local-index.txt");
+		REQUIRE(index.count() == 3);
+		REQUIRE(index.containsMd5("md5a"));
+		REQUIRE(!index.containsMd5("md5d"));
+	}
+
+	SECTION("Search files having all the tags, most recent first")
+	{
+		LocalIndex index("tests/resources/local-index.txt");
+		REQUIRE(paths(index.search({ "tag2" })) == QStringList({ "tests/resources/c.png", "tests/resources/b.png", "tests/resources/a.png" }));
+		REQUIRE(paths(index.search({ "tag1", "tag2" })) == QStringList({ "tests/resources/c.png", "tests/resources/a.png" }));
+		REQUIRE(paths(index.search({ "Tag1", "tag3" })) == QStringList({ "tests/resources/c.png" }));
+		REQUIRE(index.search({ "tag1", "not_found" }).isEmpty());
+	}
+
+	SECTION("Search with excluded tags, prefixes and limits")
+	{
+		LocalIndex index("tests/resources/local-index.txt");
+		REQUIRE(paths(index.search({ "tag2", "-tag1" })) == QStringList({ "tests/resources/b.png" }));
+		REQUIRE(paths(index.search({ "character_*" })) == QStringList({ "tests/resources/b.png", "tests/resources/a.png" }));
+		REQUIRE(paths(index.search({ "tag2" }, 2)) == QStringList({ "tests/resources/c.png", "tests/resources/b.png" }));
+		REQUIRE(paths(index.search({ "-tag3" })) == QStringList({ "tests/resources/a.png" }));
+	}
+
+	SECTION("Search results contain the file information")
+	{
+		LocalIndex index("tests/resources/local-index.txt");
+		const QList<LocalIndex::Entry> entries = index.search({ "character_b" });
+		REQUIRE(entries.count() == 1);
+		REQUIRE(entries[0].md5 == QString("md5b"));
+		REQUIRE(entries[0].site == QString("danbooru.donmai.us"));
+		REQUIRE(entries[0].tags == QStringList({ "tag2", "tag3", "character_b" }));
+	}
+
+	SECTION("Added and removed files are saved to the file")
+	{
+		{
+			LocalIndex index("tests/resources/local-index.txt");
+			index.add("tests/resources/e.png", "md5e", "gelbooru.com", { "Tag One", "tag3" });
+			index.add("tests/resources/a.png", "md5a", "danbooru.donmai.us", { "tag4" });
+			index.remove("tests/resources/b.png");
+			REQUIRE(index.count() == 3);
+			REQUIRE(paths(index.search({ "tag_one" })) == QStringList({ "tests/resources/e.png" }));
+			REQUIRE(paths(index.search({ "tag1" })) == QStringList({ "tests/resources/c.png" }));
+		}
+
+		LocalIndex index("tests/resources/local-index.txt");
+		REQUIRE(index.count() == 3);
+		REQUIRE(!index.containsMd5("md5b"));
+		REQUIRE(paths(index.search({ "tag3" })) == QStringList({ "tests/resources/e.png", "tests/resources/c.png" }));
+		REQUIRE(paths(index.search({ "tag4" })) == QStringList({ "tests/resources/a.png" }));
+	}
+}
@@ -0,0 +1,111 @@
+#include <QFile>
+#include <QMultiHash>
+#include <QSettings>
+#include <QSignalSpy>
+#include "models/md5-database/md5-database-binary.h"
+#include "catch.h"
+#include "raii-helpers.h"
+
+
+TEST_CASE("Md5DatabaseBinary")
+{
+	FileDeleter databaseDeleter("tests/resources/md5s.bin", true);
+	FileDeleter logDeleter("tests/resources/md5s.bin.log", true);
+
+	QSettings settings("tests/resources/settings.ini", QSettings::IniFormat);
+
+	{
+		QMultiHash<QString, QString> md5s;
+		md5s.insert("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+		md5s.insert("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_200x200.png");
+		md5s.insert("ad0234829205b9033196ba818f7a872b", "tests/resources/image_1x1.png");
+
+		Md5DatabaseBinary db("tests/resources/md5s.bin", &settings);
+		db.setMd5s(md5s);
+	}
+
+	SECTION("The constructor should map the existing file")
+	{
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		REQUIRE(md5s.count() == 3);
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").count() == 2);
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").contains("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").contains("tests/resources/image_200x200.png"));
+		REQUIRE(md5s.exists("ad0234829205b9033196ba818f7a872b") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98").isEmpty());
+	}
+
+	SECTION("Changes are kept in the log until merged")
+	{
+		{
+			Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+			md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+			md5s.remove("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+			REQUIRE(md5s.count() == 3);
+		}
+
+		REQUIRE(QFile("tests/resources/md5s.bin.log").size() > 0);
+
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		REQUIRE(md5s.count() == 3);
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_200x200.png"));
+	}
+
+	SECTION("sync() merges the log into the file")
+	{
+		{
+			Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+			md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+			md5s.remove("ad0234829205b9033196ba818f7a872b");
+			md5s.sync();
+		}
+
+		REQUIRE(QFile("tests/resources/md5s.bin.log").size() == 0);
+
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		REQUIRE(md5s.count() == 3);
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").count() == 2);
+		REQUIRE(md5s.exists("ad0234829205b9033196ba818f7a872b").isEmpty());
+	}
+
+	SECTION("The log is merged in the background once big enough")
+	{
+		settings.setValue("md5_log_threshold", 2);
+
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		QSignalSpy spy(&md5s, SIGNAL(merged()));
+		md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+		md5s.add("8ad8757baa8564dc136c1e07507f4a99", "tests/resources/image_200x200.png");
+		REQUIRE(spy.wait());
+
+		// Changes made during the merge are still visible
+		md5s.add("8ad8757baa8564dc136c1e07507f4a97", "tests/resources/image_200x200.png");
+		REQUIRE(md5s.count() == 6);
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a97") == QStringList("tests/resources/image_200x200.png"));
+
+		settings.remove("md5_log_threshold");
+	}
+
+	SECTION("Can remove an MD5 using remove()")
+	{
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		md5s.remove("5a105e8b9d40e1329780d62ea2265d8a");
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").isEmpty());
+		REQUIRE(md5s.count() == 1);
+
+		md5s.add("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.count() == 2);
+	}
+
+	SECTION("Invalid MD5s are ignored")
+	{
+		Md5DatabaseBinary md5s("tests/resources/md5s.bin", &settings);
+		md5s.add("new", "tests/resources/image_1x1.png");
+		REQUIRE(md5s.exists("new").isEmpty());
+		REQUIRE(md5s.count() == 3);
+	}
+}
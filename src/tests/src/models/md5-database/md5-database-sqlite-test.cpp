@@ -1,4 +1,5 @@
 #include <QFile>
+#include <QSet>
 #include <QSettings>
 #include <QSignalSpy>
 #include "models/md5-database/md5-database-sqlite.h"
@@ -33,6 +34,17 @@ TEST_CASE("Md5DatabaseSqlite")
 		REQUIRE(md5s.count() == 3);
 	}
 
+	SECTION("Can check many MD5s at once using known()")
+	{
+		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+		md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+		md5s.remove("ad0234829205b9033196ba818f7a872b");
+
+		const QStringList query { "5a105e8b9d40e1329780d62ea2265d8a", "ad0234829205b9033196ba818f7a872b", "8ad8757baa8564dc136c1e07507f4a98", "00000000000000000000000000000000" };
+		REQUIRE(md5s.known(query) == QSet<QString>({ "5a105e8b9d40e1329780d62ea2265d8a", "8ad8757baa8564dc136c1e07507f4a98" }));
+		REQUIRE(md5s.known({}).isEmpty());
+	}
+
 	SECTION("Can remove an MD5 using remove()")
 	{
 		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
@@ -47,6 +59,70 @@ TEST_CASE("Md5DatabaseSqlite")
 		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_200x200.png"));
 	}
 
+	SECTION("Pending writes are visible before being committed")
+	{
+		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+		md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+		md5s.remove("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+		md5s.remove("ad0234829205b9033196ba818f7a872b");
+
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_200x200.png"));
+		REQUIRE(md5s.exists("ad0234829205b9033196ba818f7a872b").isEmpty());
+		REQUIRE(md5s.count() == 2);
+	}
+
+	SECTION("Pending writes are committed at once after the flush interval")
+	{
+		settings.setValue("md5_flush_interval", 100);
+		{
+			Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+			QSignalSpy spy(&md5s, SIGNAL(flushed()));
+			md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+			md5s.add("8ad8757baa8564dc136c1e07507f4a99", "tests/resources/image_200x200.png");
+			REQUIRE(spy.wait());
+			REQUIRE(!spy.wait(300));
+			REQUIRE(spy.count() == 1);
+		}
+		settings.remove("md5_flush_interval");
+
+		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+		REQUIRE(md5s.count() == 5);
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a99") == QStringList("tests/resources/image_200x200.png"));
+	}
+
+	SECTION("Can add many MD5s at once using addAll()")
+	{
+		{
+			Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+			QSignalSpy spy(&md5s, SIGNAL(flushed()));
+			md5s.addAll({
+				{ "8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png" },
+				{ "8ad8757baa8564dc136c1e07507f4a99", "tests/resources/image_200x200.png" },
+				{ "8ad8757baa8564dc136c1e07507f4a99", "tests/resources/image_200x200.png" },
+				{ "5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png" },
+			});
+			REQUIRE(spy.count() == 1);
+			REQUIRE(md5s.count() == 5);
+		}
+
+		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+		REQUIRE(md5s.count() == 5);
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a99") == QStringList("tests/resources/image_200x200.png"));
+	}
+
+	SECTION("Pending writes are committed on destruction")
+	{
+		{
+			Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+			md5s.remove("5a105e8b9d40e1329780d62ea2265d8a");
+		}
+
+		Md5DatabaseSqlite md5s("tests/resources/md5s-test.sqlite", &settings);
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").isEmpty());
+		REQUIRE(md5s.count() == 1);
+	}
+
 	SECTION("action()")
 	{
 		SECTION("when 'keep deleted' is set to false")
@@ -94,39 +94,103 @@ TEST_CASE("Md5DatabaseText")
 		settings.remove("md5_flush_interval");
 	}
 
-	SECTION("Can remove an MD5 using remove()")
+	SECTION("MD5s added after the first lookup are found")
 	{
 		Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
-		md5s.remove("5a105e8b9d40e1329780d62ea2265d8a");
-		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").isEmpty());
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98").isEmpty());
 
-		md5s.sync();
+		md5s.add("8ad8757baa8564dc136c1e07507f4a98", "tests/resources/image_1x1.png");
+		REQUIRE(md5s.exists("8ad8757baa8564dc136c1e07507f4a98") == QStringList("tests/resources/image_1x1.png"));
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").count() == 2);
+	}
+
+	SECTION("Can remove an MD5 using remove()")
+	{
+		{
+			Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+			md5s.remove("5a105e8b9d40e1329780d62ea2265d8a");
+			REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").isEmpty());
 
+			md5s.sync();
+		}
+
+		// Removals are appended as tombstones
 		QFile f("tests/resources/md5s.txt");
 		f.open(QFile::ReadOnly | QFile::Text);
 		QStringList lines = QString(f.readAll()).split("\n", Qt::SkipEmptyParts);
 		f.close();
 
-		REQUIRE(lines.count() == 1);
-		REQUIRE(lines.contains("ad0234829205b9033196ba818f7a872btests/resources/image_1x1.png"));
+		REQUIRE(lines.count() == 4);
+		REQUIRE(lines.last() == QString("-5a105e8b9d40e1329780d62ea2265d8a"));
+
+		Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+		REQUIRE(md5s.count() == 1);
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").isEmpty());
+		REQUIRE(md5s.exists("ad0234829205b9033196ba818f7a872b") == QStringList("tests/resources/image_1x1.png"));
 	}
 
 	SECTION("Can remove a single MD5 path using remove()")
 	{
+		{
+			Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+			md5s.remove("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+			REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_200x200.png"));
+
+			md5s.sync();
+		}
+
+		QFile f("tests/resources/md5s.txt");
+		f.open(QFile::ReadOnly | QFile::Text);
+		QStringList lines = QString(f.readAll()).split("\n", Qt::SkipEmptyParts);
+		f.close();
+
+		REQUIRE(lines.count() == 4);
+		REQUIRE(lines.last() == QString("-5a105e8b9d40e1329780d62ea2265d8atests/resources/image_1x1.png"));
+
 		Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
-		md5s.remove("5a105e8b9d40e1329780d62ea2265d8a", "tests/resources/image_1x1.png");
+		REQUIRE(md5s.count() == 2);
 		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a") == QStringList("tests/resources/image_200x200.png"));
+	}
+
+	SECTION("The file is compacted once it contains too much garbage")
+	{
+		settings.setValue("md5_compact_min_lines", 0);
 
+		Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+		QSignalSpy spy(&md5s, SIGNAL(compacted()));
+		md5s.remove("5a105e8b9d40e1329780d62ea2265d8a");
 		md5s.sync();
+		REQUIRE(spy.count() == 1);
 
 		QFile f("tests/resources/md5s.txt");
 		f.open(QFile::ReadOnly | QFile::Text);
 		QStringList lines = QString(f.readAll()).split("\n", Qt::SkipEmptyParts);
 		f.close();
 
-		REQUIRE(lines.count() == 2);
-		REQUIRE(lines.contains("5a105e8b9d40e1329780d62ea2265d8atests/resources/image_200x200.png"));
-		REQUIRE(lines.contains("ad0234829205b9033196ba818f7a872btests/resources/image_1x1.png"));
+		REQUIRE(lines == QStringList("ad0234829205b9033196ba818f7a872btests/resources/image_1x1.png"));
+
+		settings.remove("md5_compact_min_lines");
+	}
+
+	SECTION("Changes made during a compaction are kept")
+	{
+		{
+			Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+			md5s.compact();
+
+			// Enough changes to be flushed while the compaction is running
+			for (int i = 0; i < 100; ++i) {
+				md5s.add(QString("%1").arg(i, 32, 10, QChar('0')), "tests/resources/image_1x1.png");
+			}
+			md5s.remove("ad0234829205b9033196ba818f7a872b");
+			md5s.sync();
+		}
+
+		Md5DatabaseText md5s("tests/resources/md5s.txt", &settings);
+		REQUIRE(md5s.count() == 102);
+		REQUIRE(md5s.exists("5a105e8b9d40e1329780d62ea2265d8a").count() == 2);
+		REQUIRE(md5s.exists("ad0234829205b9033196ba818f7a872b").isEmpty());
+		REQUIRE(md5s.exists(QString("%1").arg(99, 32, 10, QChar('0'))) == QStringList("tests/resources/image_1x1.png"));
 	}
 
 	SECTION("action()")
@@ -0,0 +1,54 @@
+#include <QList>
+#include <QStringList>
+#include "models/monitor-batcher.h"
+#include "models/search-query/search-query.h"
+#include "search/search-format.h"
+#include "tags/tag.h"
+#include "catch.h"
+
+
+TEST_CASE("MonitorBatcher")
+{
+	SECTION("Batch tag")
+	{
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "tag_1" }), {}) == QString("tag_1"));
+
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "tag_1", "tag_2" }), {}).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "tag_1" }), { "rating:safe" }).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "-tag_1" }), {}).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "~tag_1" }), {}).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "rating:safe" }), {}).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(QStringList { "tag_*" }), {}).isEmpty());
+		REQUIRE(MonitorBatcher::batchTag(SearchQuery(), {}).isEmpty());
+	}
+
+	SECTION("OR search")
+	{
+		const SearchFormat prefix({ " ", "" }, { " ", "~" }, false, SearchFormat::Or);
+		REQUIRE(MonitorBatcher::orSearch(prefix, { "a", "b", "c" }) == QString("~a ~b ~c"));
+
+		const SearchFormat separator({ " ", "" }, { " OR ", "" }, true, SearchFormat::And);
+		REQUIRE(MonitorBatcher::orSearch(separator, { "a", "b" }) == QString("a OR b"));
+	}
+
+	SECTION("OR search not supported")
+	{
+		const SearchFormat andOnly({ " ", "" }, {}, false, SearchFormat::And);
+		REQUIRE(MonitorBatcher::orSearch(andOnly, { "a", "b" }).isEmpty());
+
+		const SearchFormat prefix({ " ", "" }, { " ", "~" }, false, SearchFormat::Or);
+		REQUIRE(MonitorBatcher::orSearch(prefix, { "a" }).isEmpty());
+		REQUIRE(MonitorBatcher::orSearch(prefix, {}).isEmpty());
+	}
+
+	SECTION("Has tag")
+	{
+		const QList<Tag> tags { Tag("tag_1"), Tag("Some tag") };
+
+		REQUIRE(MonitorBatcher::hasTag(tags, "tag_1"));
+		REQUIRE(MonitorBatcher::hasTag(tags, "TAG_1"));
+		REQUIRE(MonitorBatcher::hasTag(tags, "some_tag"));
+		REQUIRE(MonitorBatcher::hasTag(tags, "some tag"));
+		REQUIRE(!MonitorBatcher::hasTag(tags, "tag_2"));
+	}
+}
@@ -0,0 +1,61 @@
+#include <QList>
+#include <QString>
+#include "models/monitor-scheduler.h"
+#include "catch.h"
+
+
+TEST_CASE("MonitorScheduler")
+{
+	SECTION("Empty")
+	{
+		MonitorScheduler scheduler;
+
+		REQUIRE(scheduler.isEmpty());
+		REQUIRE(scheduler.dueCount() == 0);
+		REQUIRE(scheduler.lag() == 0);
+		REQUIRE(scheduler.takeDue().isEmpty());
+	}
+
+	SECTION("Due monitors are returned the most late first")
+	{
+		MonitorScheduler scheduler;
+		scheduler.add(0, 100);
+		scheduler.add(1, -10);
+		scheduler.add(2, 50);
+		scheduler.add(3, -60);
+		scheduler.add(4, 0);
+
+		REQUIRE(scheduler.count() == 5);
+		REQUIRE(scheduler.dueCount() == 3);
+		REQUIRE(scheduler.lag() == 60);
+
+		REQUIRE(scheduler.takeDue() == QList<int>({ 3, 1, 4 }));
+		REQUIRE(scheduler.count() == 2);
+		REQUIRE(scheduler.dueCount() == 0);
+		REQUIRE(scheduler.lag() == 0);
+		REQUIRE(scheduler.secsToNext() == 50);
+	}
+
+	SECTION("Limit the number of due monitors")
+	{
+		MonitorScheduler scheduler;
+		for (int i = 0; i < 10; ++i) {
+			scheduler.add(i, -i);
+		}
+
+		REQUIRE(scheduler.takeDue(3) == QList<int>({ 9, 8, 7 }));
+		REQUIRE(scheduler.dueCount() == 7);
+		REQUIRE(scheduler.lag() == 6);
+	}
+
+	SECTION("Jitter")
+	{
+		const qint64 jitter = MonitorScheduler::jitter("tag_1", 3600, 0.1);
+		REQUIRE(jitter >= 0);
+		REQUIRE(jitter <= 360);
+		REQUIRE(MonitorScheduler::jitter("tag_1", 3600, 0.1) == jitter);
+
+		REQUIRE(MonitorScheduler::jitter("tag_1", 3600, 0) == 0);
+		REQUIRE(MonitorScheduler::jitter("tag_1", 0, 0.1) == 0);
+	}
+}
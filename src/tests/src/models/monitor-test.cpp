@@ -55,9 +55,19 @@ TEST_CASE("Monitor")
 		REQUIRE(monitor.preciseCumulated() == false);
 	}
 
+	SECTION("LastId")
+	{
+		Monitor monitor(sites, 60, QDateTime(QDate(2016, 7, 2), QTime(16, 35, 12)), false, "", "", 0, true);
+		REQUIRE(monitor.lastId(sites.first()) == 0);
+
+		monitor.setLastId(sites.first(), 1234);
+		REQUIRE(monitor.lastId(sites.first()) == 1234);
+	}
+
 	SECTION("Serialization")
 	{
 		Monitor original(sites, 60, QDateTime(QDate(2016, 7, 2), QTime(16, 35, 12)), false, "", "", 12, true);
+		original.setLastId(sites.first(), 1234);
 
 		QJsonObject json;
 		original.toJson(json);
@@ -69,6 +79,7 @@ TEST_CASE("Monitor")
 		REQUIRE(dest.lastCheck() == original.lastCheck());
 		REQUIRE(dest.cumulated() == original.cumulated());
 		REQUIRE(dest.preciseCumulated() == original.preciseCumulated());
+		REQUIRE(dest.lastId(sites.first()) == 1234);
 	}
 
 	SECTION("Compare")
@@ -65,4 +65,18 @@ TEST_CASE("PageApi")
 
 		REQUIRE(pageApi.url().toString() == QString("https://danbooru.donmai.us/posts.xml?limit=25&page=b0&tags=test tag&login=user&password_hash=a867ce3dbb1f52ccb763d4a1ff4bee5baaea37c1"));
 	}
+
+	SECTION("ParseUrlCursorWithoutIds")
+	{
+		Site *site = sites.first();
+
+		QStringList tags = QStringList() << "test" << "tag";
+		Page prevPage(profile, site, sites, tags, 1);
+		Page page(profile, site, sites, tags, 2);
+		PageApi pageApi(&page, profile, site, site->getApis().first(), tags, 2);
+		pageApi.setLastPage(&prevPage, true);
+
+		// The previous page was never loaded, so its IDs can't be used as a cursor
+		REQUIRE(pageApi.url().toString() == QString("https://danbooru.donmai.us/posts.xml?limit=25&page=2&tags=test tag&login=user&password_hash=a867ce3dbb1f52ccb763d4a1ff4bee5baaea37c1"));
+	}
 }
@@ -0,0 +1,98 @@
+#include <QScopedPointer>
+#include <QSettings>
+#include <QSharedPointer>
+#include <QSignalSpy>
+#include <QThread>
+#include "custom-network-access-manager.h"
+#include "models/page.h"
+#include "models/page-cache.h"
+#include "models/profile.h"
+#include "models/search-query/search-query.h"
+#include "models/site.h"
+#include "catch.h"
+#include "source-helpers.h"
+
+
+TEST_CASE("PageCache")
+{
+	setupSource("Danbooru (2.0)");
+	setupSite("Danbooru (2.0)", "danbooru.donmai.us");
+
+	// Force HTML source
+	QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/settings.ini", QSettings::IniFormat);
+	siteSettings.clear();
+	siteSettings.setValue("sources/usedefault", false);
+	siteSettings.setValue("sources/source_1", "html");
+	siteSettings.sync();
+
+	const QScopedPointer<Profile> pProfile(makeProfile());
+	auto profile = pProfile.data();
+
+	Site *site = profile->getSites().value("danbooru.donmai.us");
+	REQUIRE(site != nullptr);
+
+	const auto loadPage = [profile, site](int page) {
+		QSharedPointer<Page> ret(new Page(profile, site, { site }, QStringList { "rating:safe" }, page, 20));
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/results.html");
+		QSignalSpy spy(ret.data(), SIGNAL(finishedLoading(Page*)));
+		ret->load();
+		spy.wait();
+		return ret;
+	};
+
+	SECTION("Keys")
+	{
+		const SearchQuery query(QStringList { "tag1", "tag2" });
+		const QString key = PageCache::key("danbooru.donmai.us", query, 1, 20, {});
+
+		REQUIRE(key == PageCache::key("danbooru.donmai.us", SearchQuery(QStringList { "tag1", "tag2" }), 1, 20, {}));
+		REQUIRE(key != PageCache::key("gelbooru.com", query, 1, 20, {}));
+		REQUIRE(key != PageCache::key("danbooru.donmai.us", SearchQuery(QStringList { "tag1" }), 1, 20, {}));
+		REQUIRE(key != PageCache::key("danbooru.donmai.us", query, 2, 20, {}));
+		REQUIRE(key != PageCache::key("danbooru.donmai.us", query, 1, 40, {}));
+		REQUIRE(key != PageCache::key("danbooru.donmai.us", query, 1, 20, { "rating:safe" }));
+	}
+
+	SECTION("Loaded pages are returned")
+	{
+		PageCache cache;
+		const QSharedPointer<Page> page = loadPage(1);
+		REQUIRE(page->isLoaded());
+
+		cache.insert("key", page);
+		REQUIRE(cache.get("key") == page);
+		REQUIRE(cache.get("other").isNull());
+	}
+
+	SECTION("Pages still loading are not returned")
+	{
+		PageCache cache;
+		const QSharedPointer<Page> page(new Page(profile, site, { site }, QStringList { "rating:safe" }, 1, 20));
+
+		cache.insert("key", page);
+		REQUIRE(cache.get("key").isNull());
+	}
+
+	SECTION("Old pages expire")
+	{
+		PageCache cache(0);
+		cache.insert("key", loadPage(1));
+
+		QThread::msleep(10);
+		REQUIRE(cache.get("key").isNull());
+	}
+
+	SECTION("Only the last pages are kept")
+	{
+		PageCache cache(60, 2);
+		cache.insert("1", loadPage(1));
+		cache.insert("2", loadPage(2));
+		cache.insert("3", loadPage(3));
+
+		REQUIRE(cache.get("1").isNull());
+		REQUIRE(!cache.get("2").isNull());
+		REQUIRE(!cache.get("3").isNull());
+	}
+
+	CustomNetworkAccessManager::NextFiles.clear();
+}
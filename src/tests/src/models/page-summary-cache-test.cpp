@@ -0,0 +1,56 @@
+#include <QThread>
+#include "models/page-summary-cache.h"
+#include "catch.h"
+
+
+TEST_CASE("PageSummaryCache")
+{
+	SECTION("Basic usage")
+	{
+		PageSummaryCache cache;
+		cache.insert({ "tag1", "tag2" }, 1, { "wiki", { Tag("related") } });
+
+		PageSummaryCache::Summary summary;
+		REQUIRE(cache.get({ "tag1", "tag2" }, 1, &summary));
+		REQUIRE(summary.wiki == QString("wiki"));
+		REQUIRE(summary.tags.count() == 1);
+		REQUIRE(summary.tags[0].text() == QString("related"));
+
+		// Tag order doesn't matter, but the page does
+		REQUIRE(cache.get({ "tag2", "tag1" }, 1, &summary));
+		REQUIRE(!cache.get({ "tag1", "tag2" }, 2, &summary));
+		REQUIRE(!cache.get({ "tag1" }, 1, &summary));
+	}
+
+	SECTION("Empty summaries are ignored")
+	{
+		PageSummaryCache cache;
+		cache.insert({ "tag" }, 1, {});
+
+		PageSummaryCache::Summary summary;
+		REQUIRE(!cache.get({ "tag" }, 1, &summary));
+	}
+
+	SECTION("Old entries expire")
+	{
+		PageSummaryCache cache(0);
+		cache.insert({ "tag" }, 1, { "wiki", {} });
+		QThread::msleep(5);
+
+		PageSummaryCache::Summary summary;
+		REQUIRE(!cache.get({ "tag" }, 1, &summary));
+	}
+
+	SECTION("Only the most recent searches are kept")
+	{
+		PageSummaryCache cache(60, 2);
+		cache.insert({ "a" }, 1, { "wiki a", {} });
+		cache.insert({ "b" }, 1, { "wiki b", {} });
+		cache.insert({ "c" }, 1, { "wiki c", {} });
+
+		PageSummaryCache::Summary summary;
+		REQUIRE(!cache.get({ "a" }, 1, &summary));
+		REQUIRE(cache.get({ "c" }, 1, &summary));
+		REQUIRE(summary.wiki == QString("wiki c"));
+	}
+}
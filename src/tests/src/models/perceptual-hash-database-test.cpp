@@ -0,0 +1,46 @@
+#include <QFile>
+#include "models/perceptual-hash-database.h"
+#include "catch.h"
+#include "raii-helpers.h"
+
+
+TEST_CASE("PerceptualHashDatabase")
+{
+	FileDeleter databaseDeleter("tests/resources/phashes.txt", true);
+
+	QFile f("tests/resources/phashes.txt");
+	f.open(QFile::WriteOnly | QFile::Text | QFile::Truncate);
+	f.write("00000000000000ff tests/resources/a.png\n");
+	f.write("00000000000000fe tests/resources/b.png\n");
+	f.write("00000000000000ff tests/resources/c.png\n");
+	f.write("ffffffffffffffff tests/resources/d.png\n");
+	f.close();
+
+	SECTION("The constructor should load all the hashes")
+	{
+		PerceptualHashDatabase db("tests/resources/phashes.txt");
+		REQUIRE(db.count() == 4);
+	}
+
+	SECTION("Find similar hashes, closest first")
+	{
+		PerceptualHashDatabase db("tests/resources/phashes.txt");
+		REQUIRE(db.find(0xffULL, 0) == QStringList({ "tests/resources/a.png", "tests/resources/c.png" }));
+		REQUIRE(db.find(0xfeULL, 1) == QStringList({ "tests/resources/b.png", "tests/resources/a.png", "tests/resources/c.png" }));
+		REQUIRE(db.find(0x1ULL, 4).isEmpty());
+		REQUIRE(db.find(0xfffffffffffffff0ULL, 4) == QStringList({ "tests/resources/d.png" }));
+	}
+
+	SECTION("Added hashes are saved to the file")
+	{
+		{
+			PerceptualHashDatabase db("tests/resources/phashes.txt");
+			db.add(0x123456789abcdef0ULL, "tests/resources/e.png");
+			REQUIRE(db.find(0x123456789abcdef1ULL, 1) == QStringList("tests/resources/e.png"));
+		}
+
+		PerceptualHashDatabase db("tests/resources/phashes.txt");
+		REQUIRE(db.count() == 5);
+		REQUIRE(db.find(0x123456789abcdef0ULL, 0) == QStringList("tests/resources/e.png"));
+	}
+}
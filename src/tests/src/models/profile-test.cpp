@@ -95,6 +95,30 @@ TEST_CASE("Profile")
 		REQUIRE(lines[0].toObject().value("tag").toString() == QString("tag_2"));
 	}
 
+	SECTION("ListIndexes")
+	{
+		const int version = profile->listsVersion();
+
+		REQUIRE(profile->isFavorite("tag_1"));
+		REQUIRE(!profile->isFavorite("tag_3"));
+
+		profile->addFavorite(Favorite("tag_3", 70, dates[2]));
+		REQUIRE(profile->isFavorite("tag_3"));
+		REQUIRE(profile->listsVersion() != version);
+
+		profile->addKeptForLater("later");
+		REQUIRE(profile->isKeptForLater("later"));
+		REQUIRE(!profile->isKeptForLater("LATER"));
+
+		profile->addIgnored("Ignored");
+		REQUIRE(profile->isIgnored("ignored"));
+		profile->removeIgnored("Ignored");
+		REQUIRE(!profile->isIgnored("ignored"));
+
+		profile->removeKeptForLater("later");
+		profile->removeFavorite(Favorite("tag_3", 70, dates[2]));
+	}
+
 	#ifndef Q_OS_WIN
 		SECTION("RemoveFavoriteThumb")
 		{
@@ -1,4 +1,5 @@
 #include <QNetworkCookie>
+#include <QNetworkRequest>
 #include <QScopedPointer>
 #include <QSettings>
 #include <QSignalSpy>
@@ -112,6 +113,36 @@ TEST_CASE("Site")
 		REQUIRE(siteCookies[1].value() == cookies[1].value());
 	}
 
+	SECTION("IgnoreAcceptEncodingHeader")
+	{
+		QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/defaults.ini", QSettings::IniFormat);
+		siteSettings.setValue("Headers/Accept-Encoding", "br");
+		siteSettings.setValue("Headers/X-Test", "value");
+		siteSettings.sync();
+
+		site->loadConfig();
+		const QNetworkRequest request = site->makeRequest(QUrl("https://danbooru.donmai.us/posts.json"));
+
+		REQUIRE(request.rawHeader("Accept-Encoding").isEmpty());
+		REQUIRE(request.rawHeader("X-Test") == QByteArray("value"));
+
+		siteSettings.remove("Headers");
+		siteSettings.sync();
+	}
+
+	SECTION("ThumbnailFormats")
+	{
+		QSettings siteSettings("tests/resources/sites/Danbooru (2.0)/danbooru.donmai.us/defaults.ini", QSettings::IniFormat);
+		siteSettings.setValue("download/thumbnail_formats", QStringList { "PNG", "not-a-format", "jpg" });
+		siteSettings.sync();
+
+		site->loadConfig();
+		REQUIRE(site->thumbnailFormats() == QStringList { "png", "jpg" });
+
+		siteSettings.remove("download/thumbnail_formats");
+		siteSettings.sync();
+	}
+
 	SECTION("LoginNone")
 	{
 		// Prepare settings
@@ -1,4 +1,5 @@
 #include <QScopedPointer>
+#include <QSignalSpy>
 #include "custom-network-access-manager.h"
 #include "models/profile.h"
 #include "models/source.h"
@@ -7,6 +8,18 @@
 #include "source-helpers.h"
 
 
+Source *guess(SourceGuesser &guesser)
+{
+	QSignalSpy spy(&guesser, SIGNAL(finished(Source*)));
+	guesser.start();
+	if (spy.isEmpty()) {
+		REQUIRE(spy.wait());
+	}
+	REQUIRE(!guesser.isRunning());
+	return spy.first().first().value<Source*>();
+}
+
+
 TEST_CASE("SourceGuesser")
 {
 	setupSource("Danbooru");
@@ -22,7 +35,7 @@ TEST_CASE("SourceGuesser")
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
 
 		SourceGuesser guesser("https://danbooru.donmai.us", sources);
-		Source *source = guesser.start();
+		Source *source = guess(guesser);
 
 		REQUIRE(source == nullptr);
 	}
@@ -35,7 +48,7 @@ TEST_CASE("SourceGuesser")
 		CustomNetworkAccessManager::NextFiles.enqueue("404");
 
 		SourceGuesser guesser("http://behoimi.org", sources);
-		Source *source = guesser.start();
+		Source *source = guess(guesser);
 
 		REQUIRE(source == nullptr);
 	}
@@ -48,7 +61,7 @@ TEST_CASE("SourceGuesser")
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/behoimi.org/homepage.html");
 
 		SourceGuesser guesser("http://behoimi.org", sources);
-		Source *source = guesser.start();
+		Source *source = guess(guesser);
 
 		REQUIRE(source != nullptr);
 		REQUIRE(source->getName() == QString("Danbooru"));
@@ -62,9 +75,45 @@ TEST_CASE("SourceGuesser")
 		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
 
 		SourceGuesser guesser("https://danbooru.donmai.us", sources);
-		Source *source = guesser.start();
+		Source *source = guess(guesser);
 
 		REQUIRE(source != nullptr);
 		REQUIRE(source->getName() == QString("Danbooru (2.0)"));
 	}
+
+	SECTION("FirstMatchInOrder")
+	{
+		QList<Source*> sources;
+		sources.append(profile->getSources().value("Danbooru"));
+		sources.append(profile->getSources().value("Danbooru (2.0)"));
+
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		SourceGuesser guesser("https://danbooru.donmai.us", sources);
+		QSignalSpy progressSpy(&guesser, SIGNAL(progress(int)));
+		Source *source = guess(guesser);
+
+		REQUIRE(source != nullptr);
+		REQUIRE(source->getName() == QString("Danbooru (2.0)"));
+		REQUIRE(progressSpy.count() == 2);
+		CustomNetworkAccessManager::NextFiles.clear();
+	}
+
+	SECTION("Cancel")
+	{
+		QList<Source*> sources;
+		sources.append(profile->getSources().value("Danbooru (2.0)"));
+
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		SourceGuesser guesser("https://danbooru.donmai.us", sources);
+		QSignalSpy spy(&guesser, SIGNAL(finished(Source*)));
+		guesser.start();
+		guesser.cancel();
+
+		REQUIRE(!guesser.isRunning());
+		REQUIRE(!spy.wait(500));
+		CustomNetworkAccessManager::NextFiles.clear();
+	}
 }
@@ -0,0 +1,80 @@
+#include <QDir>
+#include <QFile>
+#include <QUrl>
+#include "catch.h"
+#include "models/url-downloader/url-downloader.h"
+#include "models/url-downloader/url-downloader-manager.h"
+#include "raii-helpers.h"
+
+
+static void writeDownloader(const QString &dir, const QString &name, const QString &handlers)
+{
+	QDir().mkpath(dir);
+	QFile f(dir + "/downloader.js");
+	f.open(QFile::WriteOnly | QFile::Text);
+	f.write(QString("export var downloader = { name: \"%1\", handlers: [%2] };").arg(name, handlers).toUtf8());
+	f.close();
+}
+
+
+TEST_CASE("UrlDownloader")
+{
+	SECTION("Host from regex")
+	{
+		REQUIRE(UrlDownloader::hostFromRegex("^https?://(?:www\\.)?example\\.com/") == QString("example.com"));
+		REQUIRE(UrlDownloader::hostFromRegex("^https://img\\.example\\.com$") == QString("img.example.com"));
+		REQUIRE(UrlDownloader::hostFromRegex("^https?://Example\\.com:8080/") == QString("example.com"));
+
+		// Regexes that could match other hosts
+		REQUIRE(UrlDownloader::hostFromRegex("example\\.com/") == QString());
+		REQUIRE(UrlDownloader::hostFromRegex("^https?://example.com/") == QString());
+		REQUIRE(UrlDownloader::hostFromRegex("^https?://[^/]+/image") == QString());
+		REQUIRE(UrlDownloader::hostFromRegex("^https?://example\\.(com|net)/") == QString());
+	}
+}
+
+TEST_CASE("UrlDownloaderManager")
+{
+	const QString root = "tests/resources/url-downloaders";
+	DirectoryDeleter removeRoot(root);
+
+	writeDownloader(root + "/any", "Any", "{ regexes: [\"/any/\"] }");
+	writeDownloader(root + "/example", "Example", "{ regexes: [\"^https?://(?:www\\\\.)?example\\\\.com/\"] }");
+	writeDownloader(root + "/declared", "Declared", "{ hosts: [\"other.org\"], regexes: [\"other\\\\.org/image\"] }");
+	UrlDownloaderManager manager(root);
+
+	SECTION("Single URL")
+	{
+		UrlDownloader *example = manager.canDownload(QUrl("https://www.example.com/image/1"));
+		REQUIRE(example != nullptr);
+		REQUIRE(example->name() == QString("Example"));
+
+		UrlDownloader *declared = manager.canDownload(QUrl("https://cdn.other.org/image/1"));
+		REQUIRE(declared != nullptr);
+		REQUIRE(declared->name() == QString("Declared"));
+
+		// Downloaders that can handle any host are still checked
+		UrlDownloader *any = manager.canDownload(QUrl("https://unknown.net/any/1"));
+		REQUIRE(any != nullptr);
+		REQUIRE(any->name() == QString("Any"));
+
+		// Regexes are not checked for the URLs of other hosts
+		REQUIRE(manager.canDownload(QUrl("https://unknown.net/image/1")) == nullptr);
+		REQUIRE(manager.canDownload(QUrl("https://example.org/other.org/image")) == nullptr);
+	}
+
+	SECTION("Many URLs")
+	{
+		QList<QUrl> urls;
+		for (int i = 0; i < 500; ++i) {
+			urls.append(QUrl(i % 2 == 0 ? "https://example.com/" + QString::number(i) : "https://unknown.net/" + QString::number(i)));
+		}
+
+		const QList<UrlDownloader*> downloaders = manager.canDownload(urls);
+		REQUIRE(downloaders.count() == urls.count());
+		for (int i = 0; i < urls.count(); ++i) {
+			REQUIRE(downloaders[i] == manager.canDownload(urls[i]));
+			REQUIRE((downloaders[i] != nullptr) == (i % 2 == 0));
+		}
+	}
+}
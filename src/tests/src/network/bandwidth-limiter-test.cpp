@@ -0,0 +1,58 @@
+#include "network/bandwidth-limiter.h"
+#include <QList>
+#include "catch.h"
+
+
+TEST_CASE("BandwidthLimiter")
+{
+	SECTION("NoLimit")
+	{
+		BandwidthLimiter limiter;
+
+		REQUIRE(!limiter.isLimited());
+		REQUIRE(limiter.available(1000000) == 1000000);
+		REQUIRE(limiter.msToRead(1000000) == 0);
+	}
+
+	SECTION("Burst")
+	{
+		// A quarter of a second of data can be read right away
+		BandwidthLimiter limiter(400000);
+
+		REQUIRE(limiter.isLimited());
+		REQUIRE(limiter.available(1000000) == 100000);
+		REQUIRE(limiter.available(5000) == 5000);
+	}
+
+	SECTION("Consume")
+	{
+		BandwidthLimiter limiter(400000);
+		limiter.consume(100000);
+
+		REQUIRE(limiter.available(1000) < 1000);
+		REQUIRE(limiter.msToRead(100000) > 200);
+	}
+
+	SECTION("Acquire from several limiters")
+	{
+		BandwidthLimiter fast(4000000);
+		BandwidthLimiter slow(40000);
+		const QList<BandwidthLimiter*> limiters { &fast, &slow };
+
+		// The slowest limiter decides, but both are consumed
+		REQUIRE(BandwidthLimiter::acquire(limiters, 1000000) == 10000);
+		REQUIRE(fast.available(1000000) < 1000000);
+		REQUIRE(BandwidthLimiter::acquire(limiters, 1000000) < 1000);
+		REQUIRE(BandwidthLimiter::msToRead(limiters, 4096) > 50);
+	}
+
+	SECTION("Disable")
+	{
+		BandwidthLimiter limiter(400000);
+		limiter.consume(100000);
+		limiter.setRate(0);
+
+		REQUIRE(!limiter.isLimited());
+		REQUIRE(limiter.available(1000000) == 1000000);
+	}
+}
@@ -0,0 +1,92 @@
+#include "network/mirror-selector.h"
+#include <QStringList>
+#include <QUrl>
+#include "catch.h"
+
+
+TEST_CASE("MirrorSelector")
+{
+	const QUrl url("https://a.example.com/images/1.jpg");
+
+	SECTION("Ignore other hosts")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		const QUrl other("https://other.com/images/1.jpg");
+
+		REQUIRE(selector.rewrite(other) == other);
+	}
+
+	SECTION("Single mirror")
+	{
+		MirrorSelector selector(QStringList { "a.example.com" });
+
+		REQUIRE(selector.rewrite(url) == url);
+	}
+
+	SECTION("Measure unknown mirrors first")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		selector.reportSuccess("a.example.com", 100, 1000000, 1000);
+
+		REQUIRE(selector.rewrite(url).host() == QString("b.example.com"));
+		REQUIRE(selector.rewrite(url).path() == QString("/images/1.jpg"));
+	}
+
+	SECTION("Choose the fastest mirror")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com", "c.example.com" });
+		selector.reportSuccess("a.example.com", 100, 1000000, 1000);
+		selector.reportSuccess("b.example.com", 50, 1000000, 200);
+		selector.reportSuccess("c.example.com", 500, 1000000, 2000);
+
+		REQUIRE(selector.rewrite(url).host() == QString("b.example.com"));
+	}
+
+	SECTION("Moving averages")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		selector.reportSuccess("a.example.com", 100, 1000, 10);
+		selector.reportSuccess("a.example.com", 200, 1000, 10);
+
+		const MirrorSelector::Stats stats = selector.stats("a.example.com");
+		REQUIRE(stats.samples == 2);
+		REQUIRE(stats.latency > 100);
+		REQUIRE(stats.latency < 200);
+	}
+
+	SECTION("Skip failing mirrors")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		selector.reportSuccess("a.example.com", 100, 1000000, 1000);
+		selector.reportSuccess("b.example.com", 50, 1000000, 200);
+		selector.reportFailure("b.example.com");
+
+		REQUIRE(!selector.isHealthy("b.example.com"));
+		REQUIRE(selector.rewrite(url) == url);
+
+		// A success makes it healthy again
+		selector.reportSuccess("b.example.com", 50, 1000000, 200);
+		REQUIRE(selector.isHealthy("b.example.com"));
+	}
+
+	SECTION("Keep the original host if all mirrors fail")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		selector.reportFailure("a.example.com");
+		selector.reportFailure("b.example.com");
+
+		REQUIRE(selector.rewrite(url) == url);
+	}
+
+	SECTION("Changing the mirrors keeps the measures of the remaining ones")
+	{
+		MirrorSelector selector(QStringList { "a.example.com", "b.example.com" });
+		selector.reportSuccess("a.example.com", 100, 1000, 10);
+		selector.reportSuccess("b.example.com", 100, 1000, 10);
+		selector.setMirrors(QStringList { "A.example.com", "c.example.com" });
+
+		REQUIRE(selector.mirrors() == QStringList { "a.example.com", "c.example.com" });
+		REQUIRE(selector.stats("a.example.com").samples == 1);
+		REQUIRE(selector.stats("b.example.com").samples == 0);
+	}
+}
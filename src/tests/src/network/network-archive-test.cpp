@@ -0,0 +1,86 @@
+#include "network/network-archive.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QUrl>
+#include "catch.h"
+
+
+NetworkArchive::Response makeResponse(const QByteArray &content, int statusCode = 200)
+{
+	NetworkArchive::Response response;
+	response.statusCode = statusCode;
+	response.reasonPhrase = statusCode == 200 ? "OK" : "Not Found";
+	response.contentType = "application/json";
+	response.content = content;
+	return response;
+}
+
+
+TEST_CASE("NetworkArchive")
+{
+	QTemporaryDir dir;
+	REQUIRE(dir.isValid());
+	const QString path = dir.filePath("archive.bin");
+
+	NetworkArchive archive;
+
+	SECTION("Disabled by default")
+	{
+		REQUIRE(archive.mode() == NetworkArchive::Disabled);
+
+		archive.record("GET", QUrl("https://www.example.com/"), makeResponse("test"));
+		REQUIRE(archive.count() == 0);
+	}
+
+	SECTION("Record and replay")
+	{
+		REQUIRE(archive.open(path, NetworkArchive::Record));
+		REQUIRE(archive.isRecording());
+		archive.record("GET", QUrl("https://www.example.com/posts.json?page=1"), makeResponse("[1]"));
+		archive.record("GET", QUrl("https://www.example.com/posts.json?page=2"), makeResponse("[2]"));
+		archive.record("GET", QUrl("https://www.example.com/posts.json?page=2"), makeResponse("[3]"));
+		archive.record("POST", QUrl("https://www.example.com/login"), makeResponse(QByteArray(), 404));
+		REQUIRE(archive.count() == 3);
+		REQUIRE(archive.close());
+		REQUIRE(QFile::exists(path));
+
+		NetworkArchive replay;
+		REQUIRE(replay.open(path, NetworkArchive::Replay));
+		REQUIRE(replay.isReplaying());
+		REQUIRE(replay.count() == 3);
+
+		NetworkArchive::Response response;
+		REQUIRE(replay.find("GET", QUrl("https://www.example.com/posts.json?page=1"), &response));
+		REQUIRE(response.statusCode == 200);
+		REQUIRE(response.contentType == QByteArray("application/json"));
+		REQUIRE(response.content == QByteArray("[1]"));
+
+		// Only the last response is kept
+		REQUIRE(replay.find("GET", QUrl("https://www.example.com/posts.json?page=2"), &response));
+		REQUIRE(response.content == QByteArray("[3]"));
+
+		// The method is part of the key
+		REQUIRE(!replay.find("GET", QUrl("https://www.example.com/login"), &response));
+		REQUIRE(replay.find("POST", QUrl("https://www.example.com/login"), &response));
+		REQUIRE(response.statusCode == 404);
+
+		REQUIRE(!replay.find("GET", QUrl("https://www.example.com/missing"), &response));
+	}
+
+	SECTION("Invalid archive")
+	{
+		QFile file(path);
+		REQUIRE(file.open(QFile::WriteOnly));
+		file.write("not an archive");
+		file.close();
+
+		REQUIRE(!archive.open(path, NetworkArchive::Replay));
+		REQUIRE(archive.mode() == NetworkArchive::Disabled);
+	}
+
+	SECTION("Missing archive")
+	{
+		REQUIRE(!archive.open(dir.filePath("missing.bin"), NetworkArchive::Replay));
+		REQUIRE(archive.mode() == NetworkArchive::Disabled);
+	}
+}
@@ -0,0 +1,43 @@
+#include "network/network-disk-cache.h"
+#include <QNetworkCacheMetaData>
+#include <QTemporaryDir>
+#include <QUrl>
+#include "catch.h"
+
+
+QNetworkCacheMetaData makeMetaData(qint64 size)
+{
+	QNetworkCacheMetaData metaData;
+	metaData.setUrl(QUrl("https://www.example.com/file.json"));
+	metaData.setSaveToDisk(true);
+	metaData.setRawHeaders({ { "Content-Length", QByteArray::number(size) } });
+	return metaData;
+}
+
+
+TEST_CASE("NetworkDiskCache")
+{
+	QTemporaryDir dir;
+	REQUIRE(dir.isValid());
+
+	NetworkDiskCache cache;
+	cache.setCacheDirectory(dir.path());
+
+	SECTION("No limit by default")
+	{
+		QIODevice *device = cache.prepare(makeMetaData(10 * 1024 * 1024));
+		REQUIRE(device != nullptr);
+		cache.remove(QUrl("https://www.example.com/file.json"));
+	}
+
+	SECTION("Refuse big items")
+	{
+		cache.setMaximumItemSize(1024);
+
+		REQUIRE(cache.prepare(makeMetaData(2048)) == nullptr);
+
+		QIODevice *device = cache.prepare(makeMetaData(512));
+		REQUIRE(device != nullptr);
+		cache.remove(QUrl("https://www.example.com/file.json"));
+	}
+}
@@ -0,0 +1,129 @@
+#include <QEventLoop>
+#include <QList>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTimer>
+#include "custom-network-access-manager.h"
+#include "network/network-manager.h"
+#include "network/network-reply.h"
+#include "catch.h"
+
+#define STRESS_REQUESTS 2000
+#define STRESS_MAX_CONCURRENCY 8
+#define STRESS_MAX_LATENCY 5
+
+
+TEST_CASE("NetworkManager stress", "[stress]")
+{
+	QRandomGenerator random(1337);
+	CustomNetworkAccessManager::TestLatency = STRESS_MAX_LATENCY;
+
+	NetworkManager manager;
+	manager.setMaxConcurrency(STRESS_MAX_CONCURRENCY);
+	manager.setPriority(1, NetworkManager::BatchPage);
+	manager.setPriority(2, NetworkManager::BatchFile);
+	manager.setMaxConcurrency(NetworkManager::BatchFile, 3);
+
+	const int before = NetworkManager::activeRequests();
+
+	// Violations are only counted in the callbacks, as Catch assertions can't be thrown through the event loop
+	int violations = 0;
+	int maxActive = 0;
+	int expected = 0;
+	QSet<NetworkReply*> done;
+	QEventLoop loop;
+
+	const auto markDone = [&](NetworkReply *reply) {
+		const int active = NetworkManager::activeRequests() - before;
+		maxActive = qMax(maxActive, active);
+		if (active > STRESS_MAX_CONCURRENCY) {
+			violations++;
+		}
+
+		done.insert(reply);
+		if (done.count() == expected) {
+			loop.quit();
+		}
+	};
+
+	QList<QPointer<NetworkReply>> replies;
+	for (int i = 0; i < STRESS_REQUESTS; ++i) {
+		CustomNetworkAccessManager::NextFiles.enqueue(random.bounded(10) == 0 ? "500" : "tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		// Unique URLs so that replies don't share their transfers
+		const QUrl url("https://danbooru.donmai.us/?stress=" + QString::number(i));
+		NetworkReply *reply = manager.get(QNetworkRequest(url), static_cast<int>(random.bounded(3)));
+		replies.append(reply);
+		expected++;
+
+		const quint32 action = random.bounded(10);
+		if (action == 0) {
+			// Requests aborted while queued never start, and don't emit any signal
+			reply->abort();
+			done.insert(reply);
+		} else if (action == 1) {
+			// Delete at a random time, without waiting for the reply to finish
+			QObject::connect(reply, &QObject::destroyed, &loop, [&markDone, reply]() { markDone(reply); });
+			QTimer::singleShot(static_cast<int>(random.bounded(20)), reply, &QObject::deleteLater);
+		} else {
+			QObject::connect(reply, &NetworkReply::finished, &loop, [&markDone, reply]() { markDone(reply); });
+			QObject::connect(reply, &NetworkReply::aborted, &loop, [&markDone, reply]() { markDone(reply); });
+
+			// Abort at a random time, while queued, throttled or running
+			if (action == 2) {
+				QTimer::singleShot(static_cast<int>(random.bounded(20)), reply, [&done, &markDone, reply]() {
+					reply->abort();
+					if (!done.contains(reply) && !reply->isRunning()) {
+						markDone(reply);
+					}
+				});
+			}
+		}
+	}
+
+	QTimer timeout;
+	timeout.setSingleShot(true);
+	QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+	timeout.start(30000);
+	if (done.count() < expected) {
+		loop.exec();
+	}
+
+	CustomNetworkAccessManager::TestLatency = 0;
+	CustomNetworkAccessManager::NextFiles.clear();
+
+	REQUIRE(timeout.isActive());
+	REQUIRE(done.count() == expected);
+	REQUIRE(violations == 0);
+	REQUIRE(maxActive <= STRESS_MAX_CONCURRENCY);
+
+	// Let the last replies release their slots
+	QTimer::singleShot(STRESS_MAX_LATENCY * 2, &loop, &QEventLoop::quit);
+	loop.exec();
+	REQUIRE(NetworkManager::activeRequests() == before);
+
+	// No slot leaked, so all the slots can still be used at once
+	CustomNetworkAccessManager::TestLatency = 50;
+	QList<NetworkReply*> last;
+	for (int i = 0; i < STRESS_MAX_CONCURRENCY; ++i) {
+		last.append(manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/?last=" + QString::number(i)))));
+	}
+	QTimer::singleShot(0, &loop, &QEventLoop::quit);
+	loop.exec();
+	REQUIRE(NetworkManager::activeRequests() == before + STRESS_MAX_CONCURRENCY);
+	CustomNetworkAccessManager::TestLatency = 0;
+
+	for (NetworkReply *reply : last) {
+		QSignalSpy spy(reply, SIGNAL(finished()));
+		REQUIRE((!reply->isRunning() || spy.wait()));
+		reply->deleteLater();
+	}
+	for (const QPointer<NetworkReply> &reply : replies) {
+		if (!reply.isNull()) {
+			reply->deleteLater();
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#include <QNetworkRequest>
+#include <QSignalSpy>
+#include <QTimer>
+#include "custom-network-access-manager.h"
+#include "network/network-manager.h"
+#include "network/network-reply.h"
+#include "catch.h"
+
+
+TEST_CASE("NetworkManager")
+{
+	NetworkManager manager;
+
+	SECTION("Paused requests are kept until resumed")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		manager.pause();
+		REQUIRE(manager.isPaused());
+
+		NetworkReply *reply = manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/")));
+		QSignalSpy spy(reply, SIGNAL(finished()));
+		REQUIRE(!spy.wait(200));
+		REQUIRE(reply->isRunning());
+
+		manager.resume();
+		REQUIRE(!manager.isPaused());
+		REQUIRE(spy.wait());
+		REQUIRE(reply->error() == NetworkReply::NetworkError::NoError);
+
+		reply->deleteLater();
+	}
+
+	SECTION("Identical requests share the same transfer")
+	{
+		// If the second request was sent separately, it would get the 404 error
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+		CustomNetworkAccessManager::NextFiles.enqueue("404");
+
+		const QNetworkRequest request(QUrl("https://danbooru.donmai.us/"));
+		NetworkReply *first = manager.get(request);
+		NetworkReply *second = manager.get(request);
+		QSignalSpy firstSpy(first, SIGNAL(finished()));
+		QSignalSpy secondSpy(second, SIGNAL(finished()));
+		REQUIRE((firstSpy.count() > 0 || firstSpy.wait()));
+		REQUIRE((secondSpy.count() > 0 || secondSpy.wait()));
+
+		REQUIRE(CustomNetworkAccessManager::NextFiles.count() == 1);
+		CustomNetworkAccessManager::NextFiles.clear();
+
+		const QByteArray firstData = first->readAll();
+		REQUIRE(!firstData.isEmpty());
+		REQUIRE(second->readAll() == firstData);
+		REQUIRE(second->error() == NetworkReply::NetworkError::NoError);
+
+		first->deleteLater();
+		second->deleteLater();
+	}
+
+	SECTION("Aborting a shared request does not cancel the others")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		const QNetworkRequest request(QUrl("https://danbooru.donmai.us/"));
+		NetworkReply *first = manager.get(request);
+		NetworkReply *second = manager.get(request);
+		QSignalSpy firstSpy(first, SIGNAL(aborted()));
+		QSignalSpy secondSpy(second, SIGNAL(finished()));
+
+		// Abort the first request once the manager started it, but before its transfer started
+		QTimer::singleShot(0, first, SLOT(abort()));
+
+		REQUIRE(secondSpy.wait());
+		REQUIRE(firstSpy.count() == 1);
+		REQUIRE(!second->readAll().isEmpty());
+		REQUIRE(second->error() == NetworkReply::NetworkError::NoError);
+
+		first->deleteLater();
+		second->deleteLater();
+	}
+
+	SECTION("Running requests are counted across managers")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+		const int before = NetworkManager::activeRequests();
+		NetworkReply *reply = manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/")));
+		QSignalSpy spy(reply, SIGNAL(finished()));
+
+		// Requests are started asynchronously
+		QTimer::singleShot(0, [&]() { REQUIRE(NetworkManager::activeRequests() == before + 1); });
+
+		REQUIRE(spy.wait());
+		REQUIRE(NetworkManager::activeRequests() == before);
+		REQUIRE(NetworkManager::msSinceLastActivity() < 1000);
+
+		reply->deleteLater();
+	}
+}
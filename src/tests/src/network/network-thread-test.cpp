@@ -0,0 +1,78 @@
+#include <QNetworkRequest>
+#include <QSignalSpy>
+#include <QThread>
+#include "custom-network-access-manager.h"
+#include "network/network-manager.h"
+#include "network/network-reply.h"
+#include "network/network-thread.h"
+#include "catch.h"
+
+
+TEST_CASE("NetworkThread")
+{
+	NetworkThread &networkThread = NetworkThread::getInstance();
+	networkThread.start();
+	REQUIRE(networkThread.isRunning());
+	REQUIRE(networkThread.accessManager() != nullptr);
+	REQUIRE(networkThread.accessManager()->thread() != QThread::currentThread());
+
+	{
+		NetworkManager manager;
+
+		SECTION("Data is received on the calling thread")
+		{
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+
+			NetworkReply *reply = manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/")));
+			QSignalSpy spy(reply, SIGNAL(finished()));
+			REQUIRE(spy.wait());
+
+			REQUIRE(!reply->isRunning());
+			REQUIRE(reply->error() == NetworkReply::NetworkError::NoError);
+			REQUIRE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 200);
+			REQUIRE(!reply->readAll().isEmpty());
+
+			reply->deleteLater();
+		}
+
+		SECTION("Errors are received on the calling thread")
+		{
+			CustomNetworkAccessManager::NextFiles.enqueue("404");
+
+			NetworkReply *reply = manager.get(QNetworkRequest(QUrl("https://danbooru.donmai.us/")));
+			QSignalSpy spy(reply, SIGNAL(finished()));
+			REQUIRE(spy.wait());
+
+			REQUIRE(reply->error() == NetworkReply::NetworkError::ContentNotFoundError);
+			REQUIRE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 404);
+
+			reply->deleteLater();
+		}
+
+		SECTION("Identical requests share the same transfer")
+		{
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+			CustomNetworkAccessManager::NextFiles.enqueue("404");
+
+			const QNetworkRequest request(QUrl("https://danbooru.donmai.us/"));
+			NetworkReply *first = manager.get(request);
+			NetworkReply *second = manager.get(request);
+			QSignalSpy firstSpy(first, SIGNAL(finished()));
+			QSignalSpy secondSpy(second, SIGNAL(finished()));
+			REQUIRE((firstSpy.count() > 0 || firstSpy.wait()));
+			REQUIRE((secondSpy.count() > 0 || secondSpy.wait()));
+
+			REQUIRE(first->error() == NetworkReply::NetworkError::NoError);
+			REQUIRE(second->error() == NetworkReply::NetworkError::NoError);
+			REQUIRE(first->readAll() == second->readAll());
+
+			CustomNetworkAccessManager::NextFiles.clear();
+			first->deleteLater();
+			second->deleteLater();
+		}
+	}
+
+	networkThread.stop();
+	REQUIRE(!networkThread.isRunning());
+	REQUIRE(networkThread.accessManager() == nullptr);
+}
@@ -0,0 +1,67 @@
+#include "network/persistent-cookie-jar.h"
+#include <QDateTime>
+#include <QFile>
+#include <QNetworkCookie>
+#include <QTemporaryDir>
+#include <QUrl>
+#include "catch.h"
+
+
+static QNetworkCookie makeCookie(const QByteArray &name, const QByteArray &value, bool session = false)
+{
+	QNetworkCookie cookie(name, value);
+	if (!session) {
+		cookie.setExpirationDate(QDateTime::currentDateTimeUtc().addDays(1));
+	}
+	return cookie;
+}
+
+
+TEST_CASE("PersistentCookieJar")
+{
+	QTemporaryDir dir;
+	REQUIRE(dir.isValid());
+
+	const QString filename = dir.path() + "/cookies.txt";
+	const QUrl url("https://www.example.com/");
+
+	SECTION("Changes are not written immediately")
+	{
+		PersistentCookieJar jar(filename, nullptr, 60 * 1000);
+		REQUIRE(jar.setCookiesFromUrl({ makeCookie("name", "value") }, url));
+
+		REQUIRE(!QFile::exists(filename));
+
+		jar.save();
+		REQUIRE(QFile::exists(filename));
+	}
+
+	SECTION("Cookies are saved on destruction and loaded back")
+	{
+		{
+			PersistentCookieJar jar(filename, nullptr, 60 * 1000);
+			jar.setCookiesFromUrl({ makeCookie("name", "value"), makeCookie("session", "value", true) }, url);
+		}
+
+		PersistentCookieJar jar(filename);
+		const QList<QNetworkCookie> cookies = jar.cookiesForUrl(url);
+		REQUIRE(cookies.count() == 1);
+		REQUIRE(cookies.first().name() == QByteArray("name"));
+		REQUIRE(cookies.first().value() == QByteArray("value"));
+	}
+
+	SECTION("Unchanged cookies are not rewritten")
+	{
+		{
+			PersistentCookieJar jar(filename, nullptr, 60 * 1000);
+			jar.setCookiesFromUrl({ makeCookie("name", "value") }, url);
+		}
+
+		PersistentCookieJar jar(filename, nullptr, 60 * 1000);
+		QFile::remove(filename);
+		jar.setCookiesFromUrl({ makeCookie("session", "value", true) }, url);
+		jar.save();
+
+		REQUIRE(!QFile::exists(filename));
+	}
+}
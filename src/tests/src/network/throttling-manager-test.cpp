@@ -0,0 +1,81 @@
+#include "network/throttling-manager.h"
+#include <QDateTime>
+#include <QLocale>
+#include "catch.h"
+
+
+TEST_CASE("ThrottlingManager")
+{
+	SECTION("NoThrottling")
+	{
+		ThrottlingManager manager;
+
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.rate(0) == 0);
+	}
+
+	SECTION("Interval")
+	{
+		ThrottlingManager manager;
+		manager.setInterval(0, 1000);
+
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.reserve(0) > 900);
+		REQUIRE(manager.reserve(0) > 1900);
+		REQUIRE(manager.reserve(1) == 0);
+		REQUIRE(manager.rate(0) == 1.0);
+	}
+
+	SECTION("Burst")
+	{
+		ThrottlingManager manager;
+		manager.setInterval(0, 1000);
+		manager.setBurst(0, 3);
+
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.reserve(0) == 0);
+		REQUIRE(manager.reserve(0) > 900);
+	}
+
+	SECTION("ServerErrorBackoff")
+	{
+		ThrottlingManager manager;
+		manager.setInterval(0, 1000);
+
+		manager.report(0, 503);
+		REQUIRE(manager.currentInterval(0) > 1000);
+		REQUIRE(manager.rate(0) < 1.0);
+
+		const int penalized = manager.currentInterval(0);
+		manager.report(0, 200);
+		REQUIRE(manager.currentInterval(0) < penalized);
+	}
+
+	SECTION("ClientErrorsAreIgnored")
+	{
+		ThrottlingManager manager;
+		manager.setInterval(0, 1000);
+		manager.report(0, 404);
+
+		REQUIRE(manager.currentInterval(0) == 1000);
+	}
+
+	SECTION("RetryAfterSeconds")
+	{
+		ThrottlingManager manager;
+		manager.report(0, 429, "10");
+
+		REQUIRE(manager.msToRequest(0) > 9000);
+	}
+
+	SECTION("RetryAfterDate")
+	{
+		ThrottlingManager manager;
+		const QByteArray date = QLocale::c().toString(QDateTime::currentDateTimeUtc().addSecs(20), QStringLiteral("ddd, dd MMM yyyy HH:mm:ss 'GMT'")).toLatin1();
+		manager.report(0, 429, date);
+
+		REQUIRE(manager.msToRequest(0) > 15000);
+	}
+}
@@ -0,0 +1,51 @@
+#include "network/throughput-estimator.h"
+#include "catch.h"
+
+
+TEST_CASE("ThroughputEstimator")
+{
+	SECTION("No estimate")
+	{
+		ThroughputEstimator estimator;
+
+		REQUIRE(!estimator.hasEstimate());
+		REQUIRE(estimator.estimatedMs(1000000) == -1);
+	}
+
+	SECTION("Estimate")
+	{
+		ThroughputEstimator estimator;
+		estimator.addTransfer(1000000, 1000);
+
+		REQUIRE(estimator.hasEstimate());
+		REQUIRE(estimator.bytesPerSecond() == 1000000);
+		REQUIRE(estimator.estimatedMs(5000000) == 5000);
+		REQUIRE(estimator.estimatedMs(0) == -1);
+	}
+
+	SECTION("Ignore small transfers")
+	{
+		ThroughputEstimator estimator(0.3, 64 * 1024);
+		estimator.addTransfer(1000, 1);
+
+		REQUIRE(!estimator.hasEstimate());
+	}
+
+	SECTION("Moving average")
+	{
+		ThroughputEstimator estimator(0.5);
+		estimator.addTransfer(1000000, 1000);
+		estimator.addTransfer(3000000, 1000);
+
+		REQUIRE(estimator.bytesPerSecond() == 2000000);
+	}
+
+	SECTION("Clear")
+	{
+		ThroughputEstimator estimator;
+		estimator.addTransfer(1000000, 1000);
+		estimator.clear();
+
+		REQUIRE(!estimator.hasEstimate());
+	}
+}
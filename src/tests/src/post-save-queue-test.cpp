@@ -0,0 +1,78 @@
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include "post-save-queue.h"
+#include "catch.h"
+
+
+TEST_CASE("PostSaveQueue")
+{
+	SECTION("Jobs with the same key are run in order")
+	{
+		QMutex mutex;
+		QList<int> results;
+
+		PostSaveQueue queue(4, 100);
+		for (int i = 0; i < 20; ++i) {
+			queue.run("file.txt", [&mutex, &results, i]() {
+				QMutexLocker locker(&mutex);
+				results.append(i);
+			});
+		}
+		REQUIRE(queue.waitForDone(5000));
+
+		QList<int> expected;
+		for (int i = 0; i < 20; ++i) {
+			expected.append(i);
+		}
+		REQUIRE(results == expected);
+		REQUIRE(queue.pendingCount() == 0);
+	}
+
+	SECTION("Jobs are run in the background")
+	{
+		QAtomicInt done(0);
+		QThread *caller = QThread::currentThread();
+		QThread *worker = nullptr;
+
+		PostSaveQueue queue(2, 100);
+		queue.run("a", [&done, &worker]() {
+			worker = QThread::currentThread();
+			done.fetchAndAddRelaxed(1);
+		});
+		queue.run("b", [&done]() { done.fetchAndAddRelaxed(1); });
+		REQUIRE(queue.waitForDone(5000));
+
+		REQUIRE(done.loadRelaxed() == 2);
+		REQUIRE(worker != caller);
+	}
+
+	SECTION("Adding jobs blocks once the maximum is reached")
+	{
+		QAtomicInt done(0);
+
+		PostSaveQueue queue(1, 2);
+		for (int i = 0; i < 10; ++i) {
+			queue.run(QString::number(i), [&done]() {
+				QThread::msleep(5);
+				done.fetchAndAddRelaxed(1);
+			});
+			REQUIRE(queue.pendingCount() <= 2);
+		}
+		REQUIRE(queue.waitForDone(5000));
+
+		REQUIRE(done.loadRelaxed() == 10);
+	}
+
+	SECTION("No maximum runs jobs synchronously")
+	{
+		QThread *worker = nullptr;
+
+		PostSaveQueue queue(2, 0);
+		queue.run("a", [&worker]() { worker = QThread::currentThread(); });
+
+		REQUIRE(worker == QThread::currentThread());
+	}
+}
@@ -0,0 +1,70 @@
+#include <QSignalSpy>
+#include "custom-network-access-manager.h"
+#include "network/network-manager.h"
+#include "reverse-search/reverse-search-batch.h"
+#include "reverse-search/reverse-search-engine.h"
+#include "catch.h"
+
+
+TEST_CASE("ReverseSearchBatch")
+{
+	qRegisterMetaType<ReverseSearchResult>("ReverseSearchResult");
+
+	NetworkManager manager;
+	ReverseSearchCache cache;
+	const QList<ReverseSearchEngine> engines {
+		ReverseSearchEngine(1, QString(), "First", "https://first.com/?url={url}", 1),
+		ReverseSearchEngine(2, QString(), "Second", "https://second.com/?url={url}", 2),
+	};
+
+	// The same image twice, to only look it up once
+	const QList<QPair<QString, QUrl>> images {
+		qMakePair(QString("md5a"), QUrl("https://example.com/a.jpg")),
+		qMakePair(QString("md5b"), QUrl("https://example.com/b.jpg")),
+		qMakePair(QString("md5a"), QUrl("https://example.com/a.jpg")),
+	};
+
+	SECTION("Requests each image once per engine and caches the results")
+	{
+		for (int i = 0; i < 4; ++i) {
+			CustomNetworkAccessManager::NextFiles.enqueue("tests/resources/pages/danbooru.donmai.us/homepage.html");
+		}
+
+		ReverseSearchBatch batch(&manager, engines, &cache);
+		QSignalSpy resultSpy(&batch, SIGNAL(resultLoaded(ReverseSearchResult)));
+		QSignalSpy finishedSpy(&batch, SIGNAL(finished()));
+		batch.start(images);
+		REQUIRE(batch.isRunning());
+		REQUIRE(finishedSpy.wait());
+
+		REQUIRE(resultSpy.count() == 4);
+		REQUIRE(CustomNetworkAccessManager::NextFiles.isEmpty());
+		REQUIRE(cache.count() == 4);
+		REQUIRE(cache.contains("md5a", 1));
+		REQUIRE(cache.contains("md5b", 2));
+		REQUIRE(!cache.value("md5a", 2).content.isEmpty());
+
+		// Cached results are returned without any new request
+		ReverseSearchBatch second(&manager, engines, &cache);
+		QSignalSpy secondResultSpy(&second, SIGNAL(resultLoaded(ReverseSearchResult)));
+		QSignalSpy secondFinishedSpy(&second, SIGNAL(finished()));
+		second.start(images);
+		REQUIRE(!second.isRunning());
+		REQUIRE(secondResultSpy.count() == 4);
+		REQUIRE(secondFinishedSpy.count() == 1);
+	}
+
+	SECTION("Failed lookups are not cached")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("404");
+
+		ReverseSearchBatch batch(&manager, { engines.first() }, &cache);
+		QSignalSpy resultSpy(&batch, SIGNAL(resultLoaded(ReverseSearchResult)));
+		QSignalSpy finishedSpy(&batch, SIGNAL(finished()));
+		batch.start({ images.first() });
+		REQUIRE(finishedSpy.wait());
+
+		REQUIRE(resultSpy.count() == 1);
+		REQUIRE(cache.count() == 0);
+	}
+}
@@ -84,4 +84,23 @@ TEST_CASE("SearchFormatVisitor")
 
 		delete search;
 	}
+
+	SECTION("Nested prefix")
+	{
+		auto *search = new SearchNodeOp(
+			SearchNodeOp::Or,
+			new SearchNodeOp(
+				SearchNodeOp::Or,
+				new SearchNodeTag(Tag("a")),
+				new SearchNodeTag(Tag("b"))
+			),
+			new SearchNodeTag(Tag("c"))
+		);
+
+		SearchFormat format({ " ", "" }, { " ", "~" }, false, SearchFormat::Or);
+
+		REQUIRE(SearchFormatVisitor(format).run(*search) == QString("~a ~b ~c"));
+
+		delete search;
+	}
 }
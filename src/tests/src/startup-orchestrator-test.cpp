@@ -0,0 +1,69 @@
+#include <QSignalSpy>
+#include <QStringList>
+#include "startup-orchestrator.h"
+#include "catch.h"
+
+
+TEST_CASE("StartupOrchestrator")
+{
+	StartupOrchestrator startup;
+	QSignalSpy spy(&startup, SIGNAL(finished()));
+	QStringList ran;
+
+	SECTION("Tasks are only run once ready, by priority")
+	{
+		startup.defer("low", [&ran]() { ran.append("low"); }, StartupOrchestrator::Low);
+		startup.defer("normal 1", [&ran]() { ran.append("normal 1"); });
+		startup.defer("high", [&ran]() { ran.append("high"); }, StartupOrchestrator::High);
+		startup.defer("normal 2", [&ran]() { ran.append("normal 2"); });
+		startup.phase("phase");
+
+		REQUIRE(!startup.isReady());
+		REQUIRE(ran.isEmpty());
+
+		startup.ready();
+		REQUIRE(startup.isReady());
+		REQUIRE(ran.isEmpty());
+
+		REQUIRE(spy.wait());
+		REQUIRE(ran == QStringList({ "high", "normal 1", "normal 2", "low" }));
+	}
+
+	SECTION("Tasks deferred when already ready")
+	{
+		startup.ready();
+		REQUIRE(spy.wait());
+
+		startup.defer("late", [&ran]() { ran.append("late"); });
+		REQUIRE(spy.wait());
+		REQUIRE(ran == QStringList({ "late" }));
+	}
+
+	SECTION("Tasks can defer other tasks")
+	{
+		startup.defer("first", [&ran, &startup]() {
+			ran.append("first");
+			startup.defer("second", [&ran]() { ran.append("second"); }, StartupOrchestrator::Low);
+		});
+		startup.defer("third", [&ran]() { ran.append("third"); }, StartupOrchestrator::Low);
+
+		startup.ready();
+		REQUIRE(spy.wait());
+		REQUIRE(ran == QStringList({ "first", "third", "second" }));
+	}
+
+	SECTION("Report")
+	{
+		startup.phase("first phase");
+		startup.phase("second phase");
+		startup.defer("task", []() {});
+
+		startup.ready();
+		REQUIRE(spy.wait());
+
+		const QString report = startup.report();
+		REQUIRE(report.contains("first phase: "));
+		REQUIRE(report.contains("second phase: "));
+		REQUIRE(report.contains("1 deferred tasks (task: "));
+	}
+}
@@ -0,0 +1,54 @@
+#include <QList>
+#include <QStringList>
+#include "tags/tag.h"
+#include "tags/tag-counter.h"
+#include "catch.h"
+
+
+TEST_CASE("TagCounter")
+{
+	SECTION("Empty")
+	{
+		TagCounter counter;
+		REQUIRE(counter.isEmpty());
+		REQUIRE(counter.count() == 0);
+		REQUIRE(counter.sortedTags().isEmpty());
+	}
+
+	SECTION("Merge counts")
+	{
+		TagCounter counter;
+		REQUIRE(counter.add(Tag("tag1", "general", 1, QStringList()), 1) == 0);
+		REQUIRE(counter.add(Tag("tag2", "artist", 5, QStringList()), 5) == 1);
+		REQUIRE(counter.add(Tag("tag1", "unknown", 3, QStringList()), 3) == 0);
+
+		REQUIRE(counter.count() == 2);
+		REQUIRE(counter.tags()[0].text() == QString("tag1"));
+		REQUIRE(counter.tags()[0].type().name() == QString("general"));
+		REQUIRE(counter.tags()[0].count() == 4);
+		REQUIRE(counter.tags()[1].count() == 5);
+	}
+
+	SECTION("Sorted by count")
+	{
+		TagCounter counter;
+		counter.add(QList<Tag>
+		{
+			Tag("tag1", "general", 1, QStringList()),
+			Tag("tag2", "general", 10, QStringList()),
+			Tag("tag3", "general", 5, QStringList()),
+			Tag("tag1", "general", 20, QStringList()),
+		});
+
+		const QList<Tag> sorted = counter.sortedTags();
+		REQUIRE(sorted.count() == 3);
+		REQUIRE(sorted[0].text() == QString("tag1"));
+		REQUIRE(sorted[1].text() == QString("tag2"));
+		REQUIRE(sorted[2].text() == QString("tag3"));
+
+		const QList<Tag> top = counter.sortedTags(2);
+		REQUIRE(top.count() == 2);
+		REQUIRE(top[0].text() == QString("tag1"));
+		REQUIRE(top[1].text() == QString("tag2"));
+	}
+}
@@ -137,6 +137,48 @@ TEST_CASE("TagDatabaseInMemory")
 		REQUIRE(database.count() == 4);
 	}
 
+	SECTION("Load duplicate and non-ASCII tags")
+	{
+		QTemporaryFile file;
+		REQUIRE(file.open());
+		file.write("tag2,0\r\ntag1,0\r\n\xc3\xa9t\xc3\xa9,4\r\ntag1,3\r\ntag10,1");
+		file.seek(0);
+
+		TagDatabaseInMemory database("tests/resources/tag-types.txt", file.fileName());
+		REQUIRE(database.load());
+
+		QMap<QString, TagType> types = database.getTagTypes(QStringList() << "tag1" << "tag10" << QString::fromUtf8("\xc3\xa9t\xc3\xa9") << "tag");
+
+		REQUIRE(types.count() == 3);
+		REQUIRE(types.value("tag1").name() == QString("copyright"));
+		REQUIRE(types.value("tag10").name() == QString("artist"));
+		REQUIRE(types.value(QString::fromUtf8("\xc3\xa9t\xc3\xa9")).name() == QString("character"));
+		REQUIRE(database.count() == 4);
+	}
+
+	SECTION("Keep tag types that are not in the tag type database")
+	{
+		database.setTags(QList<Tag>() << Tag("tag1", TagType("custom")) << Tag("tag2", TagType("general")));
+
+		QMap<QString, TagType> types = database.getTagTypes(QStringList() << "tag1" << "tag2");
+
+		REQUIRE(types.count() == 2);
+		REQUIRE(types.value("tag1").name() == QString("custom"));
+		REQUIRE(types.value("tag2").name() == QString("general"));
+	}
+
+	SECTION("Add tags to the existing ones")
+	{
+		database.setTags(QList<Tag>() << Tag("tag3", TagType("general")) << Tag("tag1", TagType("artist")));
+		database.addTags(QList<Tag>() << Tag("tag2", TagType("copyright")) << Tag("tag1", TagType("character")));
+		REQUIRE(database.count() == 3);
+
+		QMap<QString, TagType> types = database.getTagTypes(QStringList() << "tag1" << "tag2" << "tag3");
+		REQUIRE(types.count() == 3);
+		REQUIRE(types.value("tag1").name() == QString("character"));
+		REQUIRE(types.value("tag2").name() == QString("copyright"));
+		REQUIRE(types.value("tag3").name() == QString("general"));
+	}
 
 	SECTION("Don't save empty")
 	{
@@ -170,4 +212,61 @@ TEST_CASE("TagDatabaseInMemory")
 		REQUIRE(content.contains("tag2,3\n"));
 		REQUIRE(f.remove());
 	}
+
+	SECTION("Only append new tags when saving")
+	{
+		QString filename = "test_tmp_tags_file.txt";
+
+		{
+			TagDatabaseInMemory database("tests/resources/tag-types.txt", filename);
+			REQUIRE(database.load());
+			database.setTags(QList<Tag>() << Tag("tag1", TagType("general")) << Tag("tag2", TagType("copyright")) << Tag("tag3", TagType("general")) << Tag("tag4", TagType("general")));
+			REQUIRE(database.save());
+		}
+
+		{
+			TagDatabaseInMemory database("tests/resources/tag-types.txt", filename);
+			REQUIRE(database.load());
+			database.addTags(QList<Tag>() << Tag("tag2", TagType("general")));
+			REQUIRE(database.save());
+		}
+
+		QFile f(filename);
+		REQUIRE(f.open(QFile::ReadOnly | QFile::Text));
+		QString content = f.readAll();
+		f.close();
+		REQUIRE(content.endsWith("tag4,0\ntag2,0\n"));
+
+		TagDatabaseInMemory database("tests/resources/tag-types.txt", filename);
+		REQUIRE(database.load());
+		REQUIRE(database.count() == 4);
+		REQUIRE(database.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("general"));
+		REQUIRE(f.remove());
+	}
+
+	SECTION("Tag types returned by the site are kept between sessions")
+	{
+		const QString cacheFile = "test_tmp_tag_types_cache.txt";
+		QFile::remove(cacheFile);
+
+		{
+			TagDatabaseInMemory database("tests/resources/tag-types.txt", "test_tmp_tags_empty.txt");
+			database.setTypeCacheFile(cacheFile);
+			database.cacheTags(QList<Tag>() << Tag("cached_tag", TagType("artist")));
+		}
+
+		// Add an entry that was last seen a long time ago
+		QFile f(cacheFile);
+		REQUIRE(f.open(QFile::Append));
+		f.write("old_tag\tcopyright\t1000\n");
+		f.close();
+
+		TagDatabaseInMemory database("tests/resources/tag-types.txt", "test_tmp_tags_empty.txt");
+		database.setTypeCacheFile(cacheFile);
+		const QMap<QString, TagType> types = database.getTagTypes(QStringList() << "cached_tag" << "old_tag");
+		REQUIRE(types.count() == 1);
+		REQUIRE(types.value("cached_tag").name() == QString("artist"));
+
+		REQUIRE(f.remove());
+	}
 }
@@ -0,0 +1,82 @@
+#include <QFile>
+#include <QTemporaryFile>
+#include "tags/tag.h"
+#include "tags/tag-database-mapped.h"
+#include "catch.h"
+
+
+TEST_CASE("TagDatabaseMapped")
+{
+	const QString filename = "test_tmp_tags_file.idx";
+	QFile::remove(filename);
+
+	SECTION("Load non-existing file")
+	{
+		TagDatabaseMapped database("tests/resources/tag-types.txt", filename);
+		REQUIRE(database.load());
+
+		REQUIRE(database.getTagTypes(QStringList() << "tag1").isEmpty());
+		REQUIRE(database.count() == 0);
+	}
+
+	SECTION("Reject invalid files")
+	{
+		QTemporaryFile file;
+		REQUIRE(file.open());
+		file.write("tag1,0\ntag2,1\ntag3,3\ntag4,4\ntag5,0\ntag6,1\ntag7,3\n");
+		file.flush();
+
+		TagDatabaseMapped database("tests/resources/tag-types.txt", file.fileName());
+		REQUIRE(!database.load());
+		REQUIRE(database.count() == 0);
+	}
+
+	SECTION("Look up tags before and after saving")
+	{
+		TagDatabaseMapped database("tests/resources/tag-types.txt", filename);
+		REQUIRE(database.load());
+		database.setTags(QList<Tag>() << Tag("tag3", TagType("general")) << Tag("tag1", TagType("artist")) << Tag(QString::fromUtf8("\xc3\xa9t\xc3\xa9"), TagType("custom")));
+		REQUIRE(database.count() == 3);
+		REQUIRE(database.getTagTypes(QStringList() << "tag1").value("tag1").name() == QString("artist"));
+
+		REQUIRE(database.save());
+		REQUIRE(QFile::exists(filename));
+		REQUIRE(database.count() == 3);
+
+		const QMap<QString, TagType> types = database.getTagTypes(QStringList() << "tag1" << "tag2" << "tag3" << QString::fromUtf8("\xc3\xa9t\xc3\xa9"));
+		REQUIRE(types.count() == 3);
+		REQUIRE(types.value("tag1").name() == QString("artist"));
+		REQUIRE(types.value("tag3").name() == QString("general"));
+		REQUIRE(types.value(QString::fromUtf8("\xc3\xa9t\xc3\xa9")).name() == QString("custom"));
+	}
+
+	SECTION("Share the file between databases")
+	{
+		TagDatabaseMapped writer("tests/resources/tag-types.txt", filename);
+		REQUIRE(writer.load());
+		writer.setTags(QList<Tag>() << Tag("tag1", TagType("artist")) << Tag("tag2", TagType("general")));
+		REQUIRE(writer.save());
+
+		TagDatabaseMapped reader("tests/resources/tag-types.txt", filename);
+		REQUIRE(reader.load());
+		REQUIRE(reader.count() == 2);
+		REQUIRE(reader.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("general"));
+
+		// Replacing the file does not affect the databases still mapping the previous one
+		#ifndef Q_OS_WIN
+		writer.addTags(QList<Tag>() << Tag("tag2", TagType("copyright")) << Tag("tag4", TagType("character")));
+		REQUIRE(writer.save());
+		REQUIRE(writer.count() == 3);
+		REQUIRE(writer.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("copyright"));
+		REQUIRE(reader.count() == 2);
+		REQUIRE(reader.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("general"));
+
+		reader.close();
+		REQUIRE(reader.load());
+		REQUIRE(reader.count() == 3);
+		REQUIRE(reader.getTagTypes(QStringList() << "tag4").value("tag4").name() == QString("character"));
+		#endif
+	}
+
+	QFile::remove(filename);
+}
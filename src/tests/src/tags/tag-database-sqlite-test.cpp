@@ -68,4 +68,57 @@ TEST_CASE("TagDatabaseSqlite")
 		qDebug() << "Elapsed" << elapsed << "ms";
 		REQUIRE(elapsed < 20);
 	}
+
+	SECTION("Cached lookups are invalidated when the tags change")
+	{
+		database.setTags(QList<Tag>() << Tag(1, "tag1", TagType("general"), 0) << Tag(2, "tag2", TagType("artist"), 0));
+		REQUIRE(database.getTagIds(QStringList() << "tag1" << "tag3") == (QMap<QString, int> {{ "tag1", 1 }}));
+
+		database.setTags(QList<Tag>() << Tag(1, "tag1", TagType("general"), 0) << Tag(3, "tag3", TagType("copyright"), 0));
+		REQUIRE(database.getTagIds(QStringList() << "tag1" << "tag3") == (QMap<QString, int> {{ "tag1", 1 }, { "tag3", 3 }}));
+		REQUIRE(database.getTagTypes(QStringList() << "tag3").value("tag3").name() == QString("copyright"));
+	}
+
+	SECTION("Add tags to the existing ones")
+	{
+		database.setTags(QList<Tag>() << Tag(1, "tag1", TagType("general"), 0) << Tag(2, "tag2", TagType("artist"), 0));
+		REQUIRE(database.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("artist"));
+
+		database.addTags(QList<Tag>() << Tag(2, "tag2", TagType("copyright"), 0) << Tag(3, "tag3", TagType("character"), 0));
+		REQUIRE(database.count() == 3);
+		REQUIRE(database.getTagIds(QStringList() << "tag1" << "tag3") == (QMap<QString, int> {{ "tag1", 1 }, { "tag3", 3 }}));
+		REQUIRE(database.getTagTypes(QStringList() << "tag2").value("tag2").name() == QString("copyright"));
+	}
+
+	SECTION("Tags seen in pages are resolved without the database")
+	{
+		database.setTags(QList<Tag>() << Tag("tag1", TagType("general")) << Tag("tag2", TagType("artist")));
+		database.cacheTags(QList<Tag>() << Tag("tag2", TagType("copyright")) << Tag("tag5", TagType("character")) << Tag("tag6"));
+
+		QMap<QString, TagType> types = database.getTagTypes(QStringList() << "tag1" << "tag2" << "tag5" << "tag6");
+		REQUIRE(types.count() == 3);
+		REQUIRE(types.value("tag1").name() == QString("general"));
+		REQUIRE(types.value("tag2").name() == QString("copyright"));
+		REQUIRE(types.value("tag5").name() == QString("character"));
+		REQUIRE(!types.contains("tag6"));
+	}
+
+	SECTION("Lookups of more tags than the SQLite variable limit")
+	{
+		QList<Tag> tags;
+		QStringList names;
+		for (int i = 0; i < 2000; ++i) {
+			const QString name = "tag" + QString::number(i);
+			tags.append(Tag(i, name, TagType("general"), 0));
+			names.append(name);
+		}
+		names.append("missing_tag");
+		database.setTags(tags);
+
+		QMap<QString, int> ids = database.getTagIds(names);
+		REQUIRE(ids.count() == 2000);
+		REQUIRE(ids.value("tag1500") == 1500);
+		REQUIRE(!ids.contains("missing_tag"));
+		REQUIRE(database.count() == 2000);
+	}
 }
@@ -55,3 +55,43 @@ TEST_CASE("TagNameFormat")
 		REQUIRE(format.formatted(QStringList() << "Test" << "tAG") == QString("Test tAG"));
 	}
 }
+
+TEST_CASE("TagNameFormat conversions")
+{
+	const TagNameFormat lower(TagNameFormat::Lower, "_");
+	const TagNameFormat upper(TagNameFormat::Upper, " ");
+	const TagNameFormat caps(TagNameFormat::Caps, "_");
+
+	SECTION("Conversion")
+	{
+		REQUIRE(upper.formatted("test_tag", lower) == QString("Test Tag"));
+		REQUIRE(lower.formatted("Test Tag", upper) == QString("test_tag"));
+		REQUIRE(caps.formatted("test_tag", lower) == QString("TEST_TAG"));
+		REQUIRE(lower.formatted("TEST_TAG", caps) == QString("test_tag"));
+		REQUIRE(lower.formatted("tést_TÀG", caps) == QString("tést_tàg"));
+	}
+
+	SECTION("Already formatted names are kept as is")
+	{
+		const QString name = "test_tag";
+		const QString formatted = lower.formatted(name, caps);
+		REQUIRE(formatted == name);
+		REQUIRE(formatted.constData() == name.constData());
+
+		REQUIRE(lower.isFormatted("test_tag", caps));
+		REQUIRE(lower.isFormatted("test_tag", lower));
+		REQUIRE(!lower.isFormatted("test_Tag", caps));
+		REQUIRE(!lower.isFormatted("test tag", upper));
+		REQUIRE(upper.isFormatted("Test", lower));
+		REQUIRE(!upper.isFormatted("test_tag", lower));
+	}
+
+	SECTION("Interning")
+	{
+		const QSharedPointer<const QString> a = lower.interned("Test Tag", upper);
+		const QSharedPointer<const QString> b = lower.interned("Test Tag", upper);
+		REQUIRE(*a == QString("test_tag"));
+		REQUIRE(a == b);
+		REQUIRE(lower.interned("Other Tag", upper) != a);
+	}
+}
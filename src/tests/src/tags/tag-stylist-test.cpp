@@ -129,6 +129,28 @@ TEST_CASE("TagStylist")
 		REQUIRE_THAT(actual.toStdString(), Matches(expected));
 	}
 
+	SECTION("Cache is cleared when settings or the profile change")
+	{
+		settings.setValue("Coloring/Fonts/artists", ",8.25,-1,5,50,0,0,0,0,0");
+		settings.setValue("Coloring/Colors/artists", "#aa0000");
+		settings.setValue("Coloring/Fonts/ignoreds", ",8.25,-1,5,50,0,0,0,0,0");
+
+		Tag tag("tag_text", "artist", 123, QStringList());
+
+		Profile pro(&settings, QList<Favorite>());
+		TagStylist stylist(&pro);
+		REQUIRE(stylist.stylished(QList<Tag>() << tag).join("").contains("color:#aa0000;"));
+		REQUIRE(stylist.stylished(QList<Tag>() << tag).join("").contains("color:#aa0000;"));
+
+		settings.setValue("Coloring/Colors/artists", "#00aa00");
+		REQUIRE(stylist.stylished(QList<Tag>() << tag).join("").contains("color:#00aa00;"));
+
+		pro.addIgnored("tag_text");
+		REQUIRE(stylist.stylished(QList<Tag>() << tag).join("").contains("color:#999999;"));
+
+		settings.setValue("Coloring/Colors/artists", "#aa0000");
+	}
+
 	SECTION("Sort")
 	{
 		SECTION("Name")
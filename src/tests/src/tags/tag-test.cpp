@@ -221,6 +221,22 @@ TEST_CASE("Tag")
 		REQUIRE(Tag::GetType("copyright, character", ids) == QString("copyright"));
 	}
 
+	SECTION("Interning")
+	{
+		Tag a("tag_text", "artist", 123);
+		Tag b("tag_text", "artist", 123);
+		Tag c("tag_text", "artist", 456);
+
+		REQUIRE(a.isSameRecord(b));
+		REQUIRE(!a.isSameRecord(c));
+		REQUIRE(a == c);
+
+		b.setCount(456);
+		REQUIRE(!a.isSameRecord(b));
+		REQUIRE(a.count() == 123);
+		REQUIRE(b.count() == 456);
+	}
+
 	SECTION("Serialization")
 	{
 		Tag original(123, "tag", TagType("type"), 456, QStringList() << "rel 1" << "rel 2");
@@ -0,0 +1,87 @@
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "tracer.h"
+#include "catch.h"
+
+
+static QJsonArray readEvents(const QString &path)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadOnly));
+	return QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+}
+
+static int countPhase(const QJsonArray &events, const QString &phase)
+{
+	int count = 0;
+	for (const auto &event : events) {
+		if (event.toObject().value("ph").toString() == phase) {
+			count++;
+		}
+	}
+	return count;
+}
+
+
+TEST_CASE("Tracer")
+{
+	QTemporaryDir dir;
+	REQUIRE(dir.isValid());
+	const QString path = dir.filePath("trace.json");
+
+	Tracer tracer;
+
+	SECTION("Disabled by default")
+	{
+		REQUIRE(!tracer.isEnabled());
+		tracer.asyncBegin("test", "cat", 1);
+		REQUIRE(!tracer.stop());
+		REQUIRE(!QFile::exists(path));
+	}
+
+	SECTION("Write events")
+	{
+		tracer.start(path);
+		REQUIRE(tracer.isEnabled());
+
+		tracer.complete("span", "cat", 10, 5, QVariantMap { { "key", "value" } });
+		tracer.asyncBegin("async", "cat", 42);
+		tracer.asyncEnd("async", "cat", 42);
+
+		REQUIRE(tracer.stop());
+		REQUIRE(!tracer.isEnabled());
+
+		const QJsonArray events = readEvents(path);
+		REQUIRE(countPhase(events, "X") == 1);
+		REQUIRE(countPhase(events, "b") == 1);
+		REQUIRE(countPhase(events, "e") == 1);
+		REQUIRE(countPhase(events, "M") == 1);
+
+		for (const auto &value : events) {
+			const QJsonObject event = value.toObject();
+			if (event.value("ph").toString() == "X") {
+				REQUIRE(event.value("name").toString() == QString("span"));
+				REQUIRE(event.value("dur").toInt() == 5);
+				REQUIRE(event.value("args").toObject().value("key").toString() == QString("value"));
+			}
+		}
+	}
+
+	SECTION("Maximum event count")
+	{
+		tracer.start(path, 2);
+		for (int i = 0; i < 5; ++i) {
+			tracer.asyncBegin("async", "cat", i);
+		}
+		REQUIRE(tracer.stop());
+
+		QFile file(path);
+		REQUIRE(file.open(QFile::ReadOnly));
+		const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+		REQUIRE(countPhase(root.value("traceEvents").toArray(), "b") == 2);
+		REQUIRE(root.value("otherData").toObject().value("droppedEvents").toInt() == 3);
+	}
+}
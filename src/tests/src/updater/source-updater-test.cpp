@@ -1,40 +1,94 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
 #include <QSignalSpy>
+#include <QTemporaryFile>
+#include "custom-network-access-manager.h"
+#include "models/profile.h"
 #include "models/source.h"
 #include "updater/source-updater.h"
 #include "catch.h"
+#include "source-helpers.h"
+
+
+static QString writeManifest(QTemporaryFile &file, const QMap<QString, QString> &hashes)
+{
+	QJsonArray sources;
+	for (auto it = hashes.constBegin(); it != hashes.constEnd(); ++it) {
+		QJsonObject source;
+		source["name"] = it.key();
+		source["hash"] = it.value();
+		sources.append(source);
+	}
+
+	QJsonObject manifest;
+	manifest["sources"] = sources;
+
+	file.open();
+	file.write(QJsonDocument(manifest).toJson());
+	file.close();
+	return file.fileName();
+}
+
+static QMap<QString, bool> checkForUpdates(SourceUpdater &updater, int sourceCount)
+{
+	QSignalSpy spy(&updater, SIGNAL(finished(QString, bool)));
+	updater.checkForUpdates();
+	while (spy.count() < sourceCount && spy.wait()) {}
+
+	QMap<QString, bool> ret;
+	for (const QList<QVariant> &arguments : spy) {
+		ret.insert(arguments.at(0).toString(), arguments.at(1).toBool());
+	}
+	return ret;
+}
 
 
 TEST_CASE("SourceUpdater")
 {
-	SECTION("No update")
-	{
-		SourceUpdater updater("Danbooru (2.0)", "tests/resources/sites/Danbooru (2.0)", "http://raw.githubusercontent.com/Bionus/imgbrd-grabber/master/src/sites");
+	setupSource("Danbooru (2.0)");
+	setupSource("Gelbooru (0.2)");
 
-		// Wait for updater
-		QSignalSpy spy(&updater, SIGNAL(finished(QString, bool)));
-		updater.checkForUpdates();
-		REQUIRE(spy.wait());
+	const QScopedPointer<Profile> profile(makeProfile());
+	Source *danbooru = profile->getSources().value("Danbooru (2.0)");
+	Source *gelbooru = profile->getSources().value("Gelbooru (0.2)");
+	REQUIRE(danbooru != nullptr);
+	REQUIRE(gelbooru != nullptr);
+	REQUIRE(!danbooru->getModelHash().isEmpty());
 
-		// Get results
-		QList<QVariant> arguments = spy.takeFirst();
-		bool isNew = arguments.at(1).toBool();
+	SourceUpdater updater({ danbooru, gelbooru });
+	QTemporaryFile manifest;
 
-		REQUIRE(!isNew);
+	SECTION("Only changed sources are new")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue(writeManifest(manifest, {
+			{ "Danbooru (2.0)", danbooru->getModelHash() },
+			{ "Gelbooru (0.2)", "changed" },
+		}));
+
+		const QMap<QString, bool> results = checkForUpdates(updater, 2);
+		REQUIRE(results.count() == 2);
+		REQUIRE(!results["Danbooru (2.0)"]);
+		REQUIRE(results["Gelbooru (0.2)"]);
 	}
 
-	SECTION("Changed")
+	SECTION("Sources missing from the manifest are not new")
 	{
-		SourceUpdater updater("Danbooru", "tests/resources/sites/Danbooru", "http://raw.githubusercontent.com/Bionus/imgbrd-grabber/master/src/sites");
+		CustomNetworkAccessManager::NextFiles.enqueue(writeManifest(manifest, {
+			{ "Danbooru (2.0)", danbooru->getModelHash() },
+		}));
 
-		// Wait for updater
-		QSignalSpy spy(&updater, SIGNAL(finished(QString, bool)));
-		updater.checkForUpdates();
-		REQUIRE(spy.wait());
+		const QMap<QString, bool> results = checkForUpdates(updater, 2);
+		REQUIRE(results.count() == 2);
+		REQUIRE(!results["Danbooru (2.0)"]);
+		REQUIRE(!results["Gelbooru (0.2)"]);
+	}
 
-		// Get results
-		QList<QVariant> arguments = spy.takeFirst();
-		bool isNew = arguments.at(1).toBool();
+	SECTION("Manifest loading error")
+	{
+		CustomNetworkAccessManager::NextFiles.enqueue("404");
 
-		REQUIRE(isNew);
+		REQUIRE(checkForUpdates(updater, 2).isEmpty());
 	}
 }
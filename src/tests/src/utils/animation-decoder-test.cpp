@@ -0,0 +1,109 @@
+#include <QColor>
+#include <QList>
+#include <QSignalSpy>
+#include "utils/animation-decoder.h"
+#include "catch.h"
+
+
+// Three frames of 8x8 pixels, in red, green and blue, shown for 20, 40 and 60 ms and looping forever
+#define ANIMATION_PATH "tests/resources/animated_3frames.gif"
+
+
+static AnimationDecoder::Frame nextFrame(AnimationDecoder &decoder)
+{
+	QSignalSpy spy(&decoder, SIGNAL(frameReady()));
+	for (int i = 0; i < 100 && !decoder.hasFrame(); ++i) {
+		spy.wait(10);
+	}
+	return decoder.takeFrame();
+}
+
+
+TEST_CASE("AnimationDecoder")
+{
+	const QList<QColor> colors { Qt::red, Qt::green, Qt::blue };
+
+	SECTION("Invalid files")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(!decoder.open("tests/resources/你好.txt"));
+		REQUIRE(!decoder.open("tests/resources/not_found.gif"));
+		REQUIRE(!decoder.hasFrame());
+		REQUIRE(decoder.takeFrame().image.isNull());
+	}
+
+	SECTION("Header")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(decoder.open(ANIMATION_PATH));
+		REQUIRE(decoder.size() == QSize(8, 8));
+		REQUIRE(decoder.scaledSize() == QSize(8, 8));
+		REQUIRE(decoder.frameCount() == 3);
+		REQUIRE(decoder.loopCount() == -1);
+	}
+
+	SECTION("Frames are decoded in order and loop")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(decoder.open(ANIMATION_PATH));
+
+		for (int i = 0; i < 7; ++i) {
+			const AnimationDecoder::Frame frame = nextFrame(decoder);
+			REQUIRE(!frame.image.isNull());
+			REQUIRE(frame.number == i % 3);
+			REQUIRE(frame.delay == 20 * (i % 3 + 1));
+			REQUIRE(frame.image.pixelColor(4, 4) == colors[i % 3]);
+		}
+	}
+
+	SECTION("Only a few frames are decoded ahead")
+	{
+		AnimationDecoder decoder(2);
+		REQUIRE(decoder.open(ANIMATION_PATH));
+		nextFrame(decoder);
+
+		QSignalSpy spy(&decoder, SIGNAL(frameReady()));
+		spy.wait(100);
+		REQUIRE(decoder.cachedCount() <= 2);
+	}
+
+	SECTION("Frames are downscaled")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(decoder.open(ANIMATION_PATH, QSize(4, 2)));
+		REQUIRE(decoder.size() == QSize(8, 8));
+		REQUIRE(decoder.scaledSize() == QSize(2, 2));
+
+		const AnimationDecoder::Frame frame = nextFrame(decoder);
+		REQUIRE(frame.image.size() == QSize(2, 2));
+	}
+
+	SECTION("Seeking")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(decoder.open(ANIMATION_PATH));
+		REQUIRE(nextFrame(decoder).number == 0);
+
+		decoder.seek(2);
+		const AnimationDecoder::Frame forward = nextFrame(decoder);
+		REQUIRE(forward.number == 2);
+		REQUIRE(forward.image.pixelColor(4, 4) == colors[2]);
+
+		decoder.seek(1);
+		const AnimationDecoder::Frame backward = nextFrame(decoder);
+		REQUIRE(backward.number == 1);
+		REQUIRE(backward.image.pixelColor(4, 4) == colors[1]);
+	}
+
+	SECTION("Closing stops decoding")
+	{
+		AnimationDecoder decoder;
+		REQUIRE(decoder.open(ANIMATION_PATH));
+		nextFrame(decoder);
+		decoder.close();
+
+		QSignalSpy spy(&decoder, SIGNAL(frameReady()));
+		spy.wait(50);
+		REQUIRE(!decoder.hasFrame());
+	}
+}
@@ -0,0 +1,64 @@
+#include <QString>
+#include <QStringList>
+#include "catch.h"
+#include "utils/auto-complete-index.h"
+
+
+TEST_CASE("AutoCompleteIndex")
+{
+	AutoCompleteIndex index;
+	index.add(QStringList() << "tag_c" << "tag_a" << "other" << "Tag_B" << "tag_a");
+
+	SECTION("Empty index")
+	{
+		AutoCompleteIndex empty;
+		REQUIRE(empty.count() == 0);
+		REQUIRE(empty.complete("tag", 10).isEmpty());
+	}
+
+	SECTION("Duplicates are removed")
+	{
+		REQUIRE(index.count() == 4);
+	}
+
+	SECTION("Same popularity is sorted alphabetically ignoring case")
+	{
+		REQUIRE(index.complete("tag", 10) == QStringList({ "tag_a", "Tag_B", "tag_c" }));
+		REQUIRE(index.complete("TAG_", 10) == QStringList({ "tag_a", "Tag_B", "tag_c" }));
+		REQUIRE(index.complete("o", 10) == QStringList({ "other" }));
+		REQUIRE(index.complete("x", 10).isEmpty());
+	}
+
+	SECTION("Most popular first")
+	{
+		index.add("tag_c", 100);
+		index.add("tag_b", 50);
+		index.add("tag_a", 10);
+		index.add("tag_c", 1);
+
+		REQUIRE(index.count() == 5);
+		REQUIRE(index.complete("tag", 10) == QStringList({ "tag_c", "tag_b", "tag_a", "Tag_B" }));
+	}
+
+	SECTION("Limit")
+	{
+		index.add("tag_b", 50);
+
+		REQUIRE(index.complete("tag", 2) == QStringList({ "tag_b", "tag_a" }));
+		REQUIRE(index.complete("tag", 0).isEmpty());
+	}
+
+	SECTION("Many words")
+	{
+		QStringList words;
+		for (int i = 0; i < 10000; ++i) {
+			words.append(QString("word_%1").arg(i));
+		}
+		index.add(words);
+		index.add("word_1234", 5);
+		index.add("word_42", 3);
+
+		REQUIRE(index.complete("word_", 3) == QStringList({ "word_1234", "word_42", "word_0" }));
+		REQUIRE(index.complete("word_99", 3) == QStringList({ "word_99", "word_990", "word_9900" }));
+	}
+}
@@ -0,0 +1,75 @@
+#include <QString>
+#include <QStringList>
+#include "catch.h"
+#include "utils/bk-tree.h"
+
+
+TEST_CASE("BkTree")
+{
+	BkTree tree;
+	tree.add(QStringList() << "book" << "books" << "cake" << "boo" << "cape" << "cart" << "boon" << "book");
+
+	SECTION("Empty tree")
+	{
+		BkTree empty;
+		REQUIRE(empty.count() == 0);
+		REQUIRE(empty.find("book", 2).isEmpty());
+		REQUIRE(empty.closest("book", 2).isEmpty());
+	}
+
+	SECTION("Duplicates are ignored")
+	{
+		REQUIRE(tree.count() == 7);
+	}
+
+	SECTION("Find")
+	{
+		REQUIRE(tree.find("book", 0) == QStringList({ "book" }));
+		REQUIRE(tree.find("book", 1) == QStringList({ "book", "books", "boo", "boon" }));
+		REQUIRE(tree.find("cake", 1) == QStringList({ "cake", "cape" }));
+		REQUIRE(tree.find("xyz", 1).isEmpty());
+		REQUIRE(tree.find("book", -1).isEmpty());
+	}
+
+	SECTION("Closest")
+	{
+		int distance = -1;
+
+		REQUIRE(tree.closest("book", 2, &distance) == "book");
+		REQUIRE(distance == 0);
+
+		REQUIRE(tree.closest("cart", 2, &distance) == "cart");
+		REQUIRE(tree.closest("carts", 2, &distance) == "cart");
+		REQUIRE(distance == 1);
+
+		REQUIRE(tree.closest("xyz", 1).isEmpty());
+	}
+
+	SECTION("Closest returns the first word added when tied")
+	{
+		int distance = -1;
+
+		// "book", "boo" and "boon" are all one edit away from "boot"
+		REQUIRE(tree.closest("boot", 1, &distance) == "book");
+		REQUIRE(distance == 1);
+
+		// "cake" and "cape" are both one edit away from "cave"
+		REQUIRE(tree.closest("cave", 2, &distance) == "cake");
+		REQUIRE(distance == 1);
+	}
+
+	SECTION("Many words")
+	{
+		QStringList words;
+		for (int i = 0; i < 10000; ++i) {
+			words.append(QString("word_%1").arg(i));
+		}
+		tree.add(words);
+
+		REQUIRE(tree.count() == 10007);
+		REQUIRE(tree.closest("word_1234", 1) == "word_1234");
+		REQUIRE(tree.closest("word_12345", 1) == "word_1234");
+		REQUIRE(tree.find("word_999", 0) == QStringList({ "word_999" }));
+		REQUIRE(tree.find("word_99", 1).count() == 46);
+	}
+}
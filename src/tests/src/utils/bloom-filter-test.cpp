@@ -0,0 +1,63 @@
+#include "catch.h"
+#include "utils/bloom-filter.h"
+
+
+static quint64 mix(quint64 x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+
+TEST_CASE("BloomFilter")
+{
+	SECTION("Empty filter")
+	{
+		BloomFilter filter(100);
+		REQUIRE(filter.count() == 0);
+		REQUIRE(!filter.mayContain(mix(1)));
+	}
+
+	SECTION("No false negatives")
+	{
+		BloomFilter filter(1000);
+		for (quint64 i = 0; i < 1000; ++i) {
+			filter.add(mix(i));
+		}
+
+		REQUIRE(filter.count() == 1000);
+		for (quint64 i = 0; i < 1000; ++i) {
+			REQUIRE(filter.mayContain(mix(i)));
+		}
+	}
+
+	SECTION("Few false positives")
+	{
+		BloomFilter filter(1000, 0.01);
+		for (quint64 i = 0; i < 1000; ++i) {
+			filter.add(mix(i));
+		}
+
+		int falsePositives = 0;
+		for (quint64 i = 1000; i < 11000; ++i) {
+			if (filter.mayContain(mix(i))) {
+				falsePositives++;
+			}
+		}
+		REQUIRE(falsePositives < 300);
+	}
+
+	SECTION("Clear")
+	{
+		BloomFilter filter(10);
+		filter.add(mix(1));
+		filter.clear();
+
+		REQUIRE(filter.count() == 0);
+		REQUIRE(!filter.mayContain(mix(1)));
+	}
+}
@@ -0,0 +1,47 @@
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include "catch.h"
+#include "utils/directory-index.h"
+
+
+TEST_CASE("DirectoryIndex")
+{
+	DirectoryIndex index("tests/resources/recurse/");
+
+	SECTION("Lazily built")
+	{
+		REQUIRE(!index.isBuilt());
+		REQUIRE(index.exists("tests/resources/recurse/test.txt"));
+		REQUIRE(index.isBuilt());
+		REQUIRE(index.count() == 3);
+	}
+
+	SECTION("Recursive scan")
+	{
+		REQUIRE(index.exists("tests/resources/recurse/test.txt"));
+		REQUIRE(index.exists("tests/resources/recurse/test/test1.txt"));
+		REQUIRE(index.exists(QDir::toNativeSeparators("tests/resources/recurse/test/test2.txt")));
+		REQUIRE(index.exists("tests/resources/recurse/test/../test.txt"));
+		REQUIRE(!index.exists("tests/resources/recurse/test/test3.txt"));
+		REQUIRE(!index.exists("tests/resources/recurse/test"));
+	}
+
+	SECTION("Incremental updates")
+	{
+		index.build();
+
+		index.add("tests/resources/recurse/new.txt");
+		REQUIRE(index.exists("tests/resources/recurse/new.txt"));
+
+		index.remove("tests/resources/recurse/test.txt");
+		REQUIRE(!index.exists("tests/resources/recurse/test.txt"));
+	}
+
+	SECTION("Paths outside of the root are checked on disk")
+	{
+		REQUIRE(index.exists("tests/resources/settings.ini") == QFile::exists("tests/resources/settings.ini"));
+		REQUIRE(!index.exists("tests/resources/not_found.txt"));
+		REQUIRE(!index.isBuilt());
+	}
+}
@@ -0,0 +1,74 @@
+#include <QAtomicInt>
+#include <QDir>
+#include <QEventLoop>
+#include <QObject>
+#include <QScopedPointer>
+#include <QThread>
+#include <QTimer>
+#include "utils/disk-scheduler.h"
+#include "catch.h"
+
+
+TEST_CASE("DiskScheduler")
+{
+	SECTION("Device key of paths that don't exist yet")
+	{
+		DiskScheduler scheduler;
+
+		const QString existing = scheduler.deviceKey(QDir::currentPath() + "/tests/resources/image_1x1.png");
+		REQUIRE(!existing.isEmpty());
+		REQUIRE(scheduler.deviceKey(QDir::currentPath() + "/tests/resources/tmp/does/not/exist.jpg") == existing);
+	}
+
+	SECTION("Concurrency per device")
+	{
+		DiskScheduler scheduler(2);
+		REQUIRE(scheduler.concurrency() == 2);
+
+		QAtomicInt running(0);
+		QAtomicInt maxRunning(0);
+		QAtomicInt done(0);
+		const QString path = QDir::currentPath() + "/tests/resources/tmp/file.jpg";
+
+		QObject context;
+		for (int i = 0; i < 8; ++i) {
+			scheduler.runAsync(path, [&running, &maxRunning]() {
+				const int current = running.fetchAndAddOrdered(1) + 1;
+				int max = maxRunning.loadAcquire();
+				while (current > max && !maxRunning.testAndSetOrdered(max, current)) {
+					max = maxRunning.loadAcquire();
+				}
+				QThread::msleep(10);
+				running.fetchAndAddOrdered(-1);
+			}, &context, [&done]() {
+				done.fetchAndAddRelaxed(1);
+			});
+		}
+		REQUIRE(scheduler.waitForDone(5000));
+
+		// Callbacks are called from the event loop
+		QEventLoop loop;
+		QTimer::singleShot(100, &loop, &QEventLoop::quit);
+		loop.exec();
+
+		REQUIRE(maxRunning.loadAcquire() <= 2);
+		REQUIRE(done.loadRelaxed() == 8);
+	}
+
+	SECTION("Destroyed context")
+	{
+		DiskScheduler scheduler(1);
+		bool called = false;
+
+		QScopedPointer<QObject> context(new QObject());
+		scheduler.runAsync("file.jpg", []() {}, context.data(), [&called]() { called = true; });
+		context.reset();
+		REQUIRE(scheduler.waitForDone(5000));
+
+		QEventLoop loop;
+		QTimer::singleShot(50, &loop, &QEventLoop::quit);
+		loop.exec();
+
+		REQUIRE(!called);
+	}
+}
@@ -1,6 +1,9 @@
 #include <QDir>
 #include <QFile>
+#include <QPair>
 #include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include "catch.h"
 #include "utils/file-utils.h"
@@ -21,6 +24,31 @@ TEST_CASE("File utils")
 		REQUIRE(QFile::exists(to + "test/test2.txt"));
 	}
 
+	SECTION("copyFile")
+	{
+		QTemporaryDir dir;
+		REQUIRE(dir.isValid());
+		const QString from = dir.path() + "/from.txt";
+		const QString to = dir.path() + "/to.txt";
+		REQUIRE(writeFile(from, "test data"));
+
+		REQUIRE(copyFile(from, to));
+		QFile file(to);
+		REQUIRE(file.open(QFile::ReadOnly));
+		REQUIRE(file.readAll() == QByteArray("test data"));
+		file.close();
+
+		// Existing files are not overwritten
+		REQUIRE(writeFile(from, "other data"));
+		REQUIRE(!copyFile(from, to));
+		REQUIRE(file.open(QFile::ReadOnly));
+		REQUIRE(file.readAll() == QByteArray("test data"));
+		file.close();
+
+		REQUIRE(!copyFile(dir.path() + "/missing.txt", dir.path() + "/missing-copy.txt"));
+		REQUIRE(!QFile::exists(dir.path() + "/missing-copy.txt"));
+	}
+
 	SECTION("safeWriteFile")
 	{
 		const QString file = "tests/resources/tmp/safe.txt";
@@ -54,4 +82,43 @@ TEST_CASE("File utils")
 			REQUIRE(QFile::exists(file + ".bak"));
 		}
 	}
+
+	SECTION("walkFilesFromDirectory")
+	{
+		QTemporaryDir dir;
+		REQUIRE(dir.isValid());
+		REQUIRE(QDir(dir.path()).mkpath("sub/deep"));
+		REQUIRE(QDir(dir.path()).mkpath("empty"));
+		for (const QString &file : { "b.jpg", "a.jpg", "a.jpg.txt", "c.txt", "sub/d.png", "sub/d.png.log", "sub/deep/e.gif" }) {
+			REQUIRE(writeFile(dir.path() + "/" + file, "test"));
+		}
+
+		SECTION("All files are listed, grouped with their suffixes")
+		{
+			QList<QPair<QString, QStringList>> files;
+			const bool ret = walkFilesFromDirectory(QDir(dir.path()), { ".txt", ".log" }, [&files](const QString &file, const QStringList &children) {
+				files.append(qMakePair(file, children));
+				return true;
+			});
+
+			REQUIRE(ret);
+			REQUIRE(files.count() == 5);
+			REQUIRE(files[0] == qMakePair(QString("a.jpg"), QStringList { "a.jpg.txt" }));
+			REQUIRE(files[1] == qMakePair(QString("b.jpg"), QStringList()));
+			REQUIRE(files[2] == qMakePair(QString("c.txt"), QStringList()));
+			REQUIRE(files[3] == qMakePair(QString("sub/d.png"), QStringList { "sub/d.png.log" }));
+			REQUIRE(files[4] == qMakePair(QString("sub/deep/e.gif"), QStringList()));
+		}
+
+		SECTION("Stop the walk")
+		{
+			int count = 0;
+			const bool ret = walkFilesFromDirectory(QDir(dir.path()), {}, [&count](const QString &, const QStringList &) {
+				return ++count < 2;
+			});
+
+			REQUIRE(!ret);
+			REQUIRE(count == 2);
+		}
+	}
 }
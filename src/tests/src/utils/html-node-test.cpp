@@ -1,4 +1,6 @@
+#include <QList>
 #include <QScopedPointer>
+#include <QStringList>
 #include "catch.h"
 #include "utils/html-node.h"
 
@@ -25,4 +27,39 @@ TEST_CASE("HTML parsing utils")
 		REQUIRE(node->attr("key3") == QString("val3"));
 		REQUIRE(node->attr("key4") == QString());
 	}
+
+	SECTION("Non-ASCII HTML")
+	{
+		QScopedPointer<HtmlNode> node(HtmlNode::fromString(QString::fromUtf8("<p title=\"caf\xC3\xA9\">\xE6\x97\xA5\xE6\x9C\xAC</p>"), true));
+
+		REQUIRE(node != nullptr);
+		REQUIRE(node->attr("title") == QString::fromUtf8("caf\xC3\xA9"));
+		REQUIRE(node->innerText() == QString::fromUtf8("\xE6\x97\xA5\xE6\x9C\xAC"));
+	}
+
+	SECTION("CSS selectors")
+	{
+		QScopedPointer<HtmlNode> node(HtmlNode::fromString("<ul><li><a href=\"a.html\">A</a></li><li><a href=\"b.html\">B</a></li><li>C</li></ul>", true));
+		REQUIRE(node != nullptr);
+
+		const QList<HtmlNode> links = node->find("li > a");
+		REQUIRE(links.count() == 2);
+		REQUIRE(links[1].attr("href") == QString("b.html"));
+
+		REQUIRE(node->findAttr("li > a", "href") == QStringList { "a.html", "b.html" });
+		REQUIRE(node->findText("li") == QStringList { "A", "B", "C" });
+		REQUIRE(node->findText("table").isEmpty());
+	}
+
+	SECTION("Found nodes outlive their document")
+	{
+		QList<HtmlNode> links;
+		{
+			QScopedPointer<HtmlNode> node(HtmlNode::fromString("<p><a href=\"a.html\">A</a></p>", true));
+			links = node->find("a");
+		}
+
+		REQUIRE(links.count() == 1);
+		REQUIRE(links[0].innerText() == QString("A"));
+	}
 }
@@ -0,0 +1,102 @@
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include "catch.h"
+#include "raii-helpers.h"
+#include "utils/json-record-file.h"
+
+
+static QList<QJsonObject> makeRecords(int count)
+{
+	QList<QJsonObject> records;
+	for (int i = 0; i < count; ++i) {
+		records.append(QJsonObject {{ "name", QString("record_%1").arg(i) }, { "value", i }});
+	}
+	return records;
+}
+
+
+TEST_CASE("JsonRecordFile")
+{
+	const QString path = "tests/resources/records.json";
+	FileDeleter removeFile(path, true);
+	FileDeleter removeJournal(path + ".journal", true);
+
+	QList<QJsonObject> records = makeRecords(3);
+
+	SECTION("Missing file")
+	{
+		JsonRecordFile file(path, "records");
+		REQUIRE(file.load().isEmpty());
+	}
+
+	SECTION("Updates are journaled")
+	{
+		JsonRecordFile file(path, "records");
+		REQUIRE(file.save(records));
+		REQUIRE(!QFile::exists(path + ".journal"));
+
+		records[1]["value"] = 42;
+		REQUIRE(file.save(records));
+		REQUIRE(file.journalEntries() == 1);
+		REQUIRE(QFile::exists(path + ".journal"));
+
+		// Saving again without changes does nothing
+		REQUIRE(file.save(records));
+		REQUIRE(file.journalEntries() == 1);
+
+		JsonRecordFile other(path, "records");
+		REQUIRE(other.load() == records);
+		REQUIRE(other.journalEntries() == 1);
+	}
+
+	SECTION("Adding records rewrites the file")
+	{
+		JsonRecordFile file(path, "records");
+		REQUIRE(file.save(records));
+		records[0]["value"] = 42;
+		REQUIRE(file.save(records));
+
+		records.append(QJsonObject {{ "name", "new" }});
+		REQUIRE(file.save(records));
+		REQUIRE(file.journalEntries() == 0);
+		REQUIRE(!QFile::exists(path + ".journal"));
+
+		JsonRecordFile other(path, "records");
+		REQUIRE(other.load() == records);
+	}
+
+	SECTION("The journal is merged once too big")
+	{
+		records = makeRecords(200);
+
+		JsonRecordFile file(path, "records");
+		REQUIRE(file.save(records));
+		for (int i = 0; i < 250; ++i) {
+			records[i % 200]["value"] = 1000 + i;
+			REQUIRE(file.save(records));
+		}
+		REQUIRE(file.journalEntries() < 200);
+
+		JsonRecordFile other(path, "records");
+		REQUIRE(other.load() == records);
+	}
+
+	SECTION("Journals from an older revision are ignored")
+	{
+		JsonRecordFile file(path, "records");
+		REQUIRE(file.save(records));
+		records[0]["value"] = 42;
+		REQUIRE(file.save(records));
+
+		// Simulate a rewrite interrupted before the journal could be removed
+		QFile::copy(path + ".journal", path + ".journal.bak");
+		records.removeFirst();
+		REQUIRE(file.save(records));
+		QFile::rename(path + ".journal.bak", path + ".journal");
+
+		JsonRecordFile other(path, "records");
+		REQUIRE(other.load() == records);
+		REQUIRE(other.journalEntries() == 0);
+	}
+}
@@ -0,0 +1,74 @@
+#include <QBuffer>
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "catch.h"
+#include "utils/json-writer.h"
+
+
+TEST_CASE("JsonWriter")
+{
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+
+	SECTION("Compact objects are written one per line")
+	{
+		{
+			JsonWriter writer(&buffer);
+			writer.beginObject();
+			writer.key("a");
+			writer.value(1);
+			writer.key("b");
+			writer.value(QStringList { "x", "y" });
+			writer.key("c");
+			writer.value(true);
+			writer.endObject();
+			writer.beginObject();
+			writer.endObject();
+		}
+
+		REQUIRE(data == QByteArray("{\"a\":1,\"b\":[\"x\",\"y\"],\"c\":true}\n{}\n"));
+	}
+
+	SECTION("Indented output")
+	{
+		{
+			JsonWriter writer(&buffer, true);
+			writer.beginArray();
+			writer.beginObject();
+			writer.key("a");
+			writer.value("b");
+			writer.endObject();
+			writer.endArray();
+		}
+
+		REQUIRE(data == QByteArray("[\n    {\n        \"a\": \"b\"\n    }\n]\n"));
+	}
+
+	SECTION("String escaping")
+	{
+		const QString text = QString("quote\" backslash\\ new\nline tab\t control") + QChar(0x01) + QString::fromUtf8(" unicode é");
+		{
+			JsonWriter writer(&buffer);
+			writer.beginObject();
+			writer.key("text");
+			writer.value(text);
+			writer.endObject();
+		}
+
+		REQUIRE(data.contains("\\u0001"));
+		const QJsonDocument doc = QJsonDocument::fromJson(data);
+		REQUIRE(doc.object().value("text").toString() == text);
+	}
+
+	SECTION("Data is written when the buffer is full")
+	{
+		JsonWriter writer(&buffer, false, 16);
+		writer.value(QString(100, 'a'));
+		REQUIRE(data.size() > 0);
+
+		writer.flush();
+		REQUIRE(data == "\"" + QByteArray(100, 'a') + "\"\n");
+	}
+}
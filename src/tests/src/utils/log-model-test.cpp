@@ -0,0 +1,101 @@
+#include <QSignalSpy>
+#include <QStringList>
+#include "utils/log-model.h"
+#include "catch.h"
+
+
+static QStringList rows(const LogModel &model)
+{
+	QStringList ret;
+	for (int i = 0; i < model.rowCount(); ++i) {
+		ret.append(model.data(model.index(i)).toString());
+	}
+	return ret;
+}
+
+
+TEST_CASE("LogModel")
+{
+	LogModel model(3);
+
+	SECTION("Add messages")
+	{
+		model.add(QStringList() << "[12:00:00.000][Info] first\n" << "[12:00:00.001][Error] second");
+
+		REQUIRE(rows(model) == QStringList() << "[12:00:00.000][Info] first" << "[12:00:00.001][Error] second");
+		REQUIRE(model.data(model.index(0), LogModel::LevelRole).toInt() == Logger::Info);
+		REQUIRE(model.data(model.index(1), LogModel::LevelRole).toInt() == Logger::Error);
+	}
+
+	SECTION("Keep only the last messages")
+	{
+		QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+		QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+
+		model.add(QStringList() << "[a][Info] 1" << "[a][Info] 2");
+		model.add(QStringList() << "[a][Info] 3" << "[a][Info] 4");
+		REQUIRE(rows(model) == QStringList() << "[a][Info] 2" << "[a][Info] 3" << "[a][Info] 4");
+		REQUIRE(model.totalCount() == 3);
+
+		// Only the changed rows are signaled
+		REQUIRE(removedSpy.count() == 1);
+		REQUIRE(removedSpy[0][1].toInt() == 0);
+		REQUIRE(removedSpy[0][2].toInt() == 0);
+		REQUIRE(insertedSpy.count() == 2);
+
+		// Batches larger than the buffer
+		model.add(QStringList() << "[a][Info] 5" << "[a][Info] 6" << "[a][Info] 7" << "[a][Info] 8");
+		REQUIRE(rows(model) == QStringList() << "[a][Info] 6" << "[a][Info] 7" << "[a][Info] 8");
+	}
+
+	SECTION("Filter by level")
+	{
+		model.add(QStringList() << "[a][Debug] 1" << "[a][Warning] 2" << "[a][Info] 3");
+		model.setMinimumLevel(Logger::Info);
+		REQUIRE(rows(model) == QStringList() << "[a][Warning] 2" << "[a][Info] 3");
+
+		model.setMinimumLevel(Logger::Warning);
+		REQUIRE(rows(model) == QStringList() << "[a][Warning] 2");
+
+		// Filtered messages are still dropped from the buffer
+		model.add(QStringList() << "[a][Debug] 4" << "[a][Error] 5");
+		REQUIRE(rows(model) == QStringList() << "[a][Error] 5");
+
+		model.setMinimumLevel(Logger::Debug);
+		REQUIRE(rows(model) == QStringList() << "[a][Info] 3" << "[a][Debug] 4" << "[a][Error] 5");
+	}
+
+	SECTION("Search")
+	{
+		model.add(QStringList() << "[a][Info] Hello" << "[a][Info] World" << "[a][Info] hello world");
+		model.setSearch("hello");
+		REQUIRE(rows(model) == QStringList() << "[a][Info] Hello" << "[a][Info] hello world");
+
+		model.add(QStringList() << "[a][Info] Nothing");
+		REQUIRE(rows(model) == QStringList() << "[a][Info] hello world");
+
+		model.setSearch(QString());
+		REQUIRE(rows(model).count() == 3);
+	}
+
+	SECTION("Continuation lines keep the level of the previous message")
+	{
+		model.add(QStringList() << "[a][Error] Stack trace:" << "line 1");
+		REQUIRE(model.data(model.index(1), LogModel::LevelRole).toInt() == Logger::Error);
+	}
+
+	SECTION("Links")
+	{
+		model.add(QStringList() << "[a][Info] Loading `https://test.com/page`" << "[a][Info] No link");
+		REQUIRE(model.data(model.index(0), LogModel::LinkRole).toString() == QString("https://test.com/page"));
+		REQUIRE(model.data(model.index(1), LogModel::LinkRole).isNull());
+	}
+
+	SECTION("Clear")
+	{
+		model.add(QStringList() << "[a][Info] 1");
+		model.clear();
+		REQUIRE(model.rowCount() == 0);
+		REQUIRE(model.totalCount() == 0);
+	}
+}
@@ -0,0 +1,86 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include "utils/md5-multi-buffer.h"
+#include "catch.h"
+
+
+static QByteArray md5(const QByteArray &data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+
+TEST_CASE("Md5MultiBuffer")
+{
+	SECTION("Known values")
+	{
+		const QList<QByteArray> md5s = Md5MultiBuffer::hash({ "", "a", "abc", "message digest" });
+		REQUIRE(md5s.count() == 4);
+		REQUIRE(md5s[0] == QByteArray("d41d8cd98f00b204e9800998ecf8427e"));
+		REQUIRE(md5s[1] == QByteArray("0cc175b9c0f1b6a831c399e269772661"));
+		REQUIRE(md5s[2] == QByteArray("900150983cd24fb0d6963f7d28e17f72"));
+		REQUIRE(md5s[3] == QByteArray("f96b697d7cb7938d525a2f31aaf161d0"));
+	}
+
+	SECTION("Messages of all sizes around the padding limits")
+	{
+		// More messages than lanes, with different sizes, so that lanes are refilled at different times
+		QList<QByteArray> messages;
+		for (int size : { 0, 1, 55, 56, 57, 63, 64, 65, 119, 120, 127, 128, 1000, 70000, 200000 }) {
+			QByteArray data(size, Qt::Uninitialized);
+			for (int i = 0; i < size; ++i) {
+				data[i] = static_cast<char>(i * 31 + size);
+			}
+			messages.append(data);
+		}
+
+		const QList<QByteArray> md5s = Md5MultiBuffer::hash(messages);
+		REQUIRE(md5s.count() == messages.count());
+		for (int i = 0; i < messages.count(); ++i) {
+			REQUIRE(md5s[i] == md5(messages[i]));
+		}
+	}
+
+	SECTION("Single message")
+	{
+		REQUIRE(Md5MultiBuffer::hash({ "abc" }) == QList<QByteArray> { "900150983cd24fb0d6963f7d28e17f72" });
+		REQUIRE(Md5MultiBuffer::hash({}).isEmpty());
+	}
+
+	SECTION("Files")
+	{
+		QDir().mkpath("tests/resources/tmp");
+
+		QStringList paths;
+		QList<QByteArray> contents;
+		for (int i = 0; i < 10; ++i) {
+			const QString path = QString("tests/resources/tmp/md5_%1.bin").arg(i);
+			const QByteArray data = QByteArray("test").repeated(i * 50);
+
+			QFile file(path);
+			REQUIRE(file.open(QFile::WriteOnly | QFile::Truncate));
+			file.write(data);
+			file.close();
+
+			paths.append(path);
+			contents.append(data);
+		}
+		paths.insert(3, "tests/resources/tmp/not_found.bin");
+		contents.insert(3, QByteArray());
+		paths.insert(5, QString());
+		contents.insert(5, QByteArray());
+
+		const QStringList md5s = Md5MultiBuffer::hashFiles(paths);
+		REQUIRE(md5s.count() == paths.count());
+		for (int i = 0; i < paths.count(); ++i) {
+			const QString expected = i == 3 || i == 5 ? QString() : QString(md5(contents[i]));
+			REQUIRE(md5s[i] == expected);
+		}
+
+		for (const QString &path : paths) {
+			QFile::remove(path);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#include <QStringList>
+#include "utils/memory-budget.h"
+#include "catch.h"
+
+
+TEST_CASE("MemoryBudget")
+{
+	SECTION("Usage")
+	{
+		MemoryBudget budget;
+		const quint64 a = budget.add("a", 100, []() {});
+		budget.add("b", 200, []() {});
+		budget.add("b", 300, []() {});
+
+		REQUIRE(budget.usage() == 600);
+
+		const QList<MemoryBudget::Usage> breakdown = budget.breakdown();
+		REQUIRE(breakdown.count() == 2);
+		REQUIRE(breakdown[0].category == QString("a"));
+		REQUIRE(breakdown[0].bytes == 100);
+		REQUIRE(breakdown[1].bytes == 500);
+		REQUIRE(breakdown[1].entries == 2);
+
+		budget.resize(a, 50);
+		REQUIRE(budget.usage() == 550);
+
+		budget.remove(a);
+		REQUIRE(budget.usage() == 500);
+		REQUIRE(budget.breakdown()[0].bytes == 0);
+	}
+
+	SECTION("No budget")
+	{
+		MemoryBudget budget;
+		bool evicted = false;
+		budget.add("a", 1000000, [&evicted]() { evicted = true; });
+
+		REQUIRE(budget.trim() == 0);
+		REQUIRE(!evicted);
+	}
+
+	SECTION("Evict the least recently used entries")
+	{
+		MemoryBudget budget(1000);
+		QStringList evicted;
+		const quint64 a = budget.add("test", 400, [&evicted]() { evicted.append("a"); });
+		budget.add("test", 400, [&evicted]() { evicted.append("b"); });
+		budget.touch(a);
+		budget.add("test", 400, [&evicted]() { evicted.append("c"); });
+
+		REQUIRE(evicted == QStringList { "b" });
+		REQUIRE(budget.usage() == 800);
+	}
+
+	SECTION("Lower the budget")
+	{
+		MemoryBudget budget;
+		QStringList evicted;
+		budget.add("test", 400, [&evicted]() { evicted.append("a"); });
+		budget.add("test", 400, [&evicted]() { evicted.append("b"); });
+		budget.setBudget(500);
+
+		REQUIRE(evicted == QStringList { "a" });
+		REQUIRE(budget.usage() == 400);
+	}
+
+	SECTION("Removed entries are not evicted")
+	{
+		MemoryBudget budget(1000);
+		bool evicted = false;
+		const quint64 a = budget.add("test", 400, [&evicted]() { evicted = true; });
+		budget.remove(a);
+		budget.add("test", 900, []() {});
+
+		REQUIRE(!evicted);
+	}
+}
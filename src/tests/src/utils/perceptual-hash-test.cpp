@@ -0,0 +1,52 @@
+#include <QImage>
+#include "catch.h"
+#include "utils/perceptual-hash.h"
+
+
+static QImage gradient(int width, int height, bool reversed = false)
+{
+	QImage image(width, height, QImage::Format_RGB32);
+	for (int x = 0; x < width; ++x) {
+		const int value = 255 * (reversed ? width - 1 - x : x) / (width - 1);
+		for (int y = 0; y < height; ++y) {
+			image.setPixel(x, y, qRgb(value, value, value));
+		}
+	}
+	return image;
+}
+
+
+TEST_CASE("Perceptual hash")
+{
+	SECTION("Hamming distance")
+	{
+		REQUIRE(hammingDistance(0, 0) == 0);
+		REQUIRE(hammingDistance(0, 0xff) == 8);
+		REQUIRE(hammingDistance(0xf0f0f0f0f0f0f0f0ULL, 0x0f0f0f0f0f0f0f0fULL) == 64);
+	}
+
+	SECTION("Resized images have close hashes")
+	{
+		const QImage image = gradient(400, 300);
+		const QImage small = image.scaled(150, 150, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+		REQUIRE(hammingDistance(perceptualHash(image), perceptualHash(small)) <= 4);
+	}
+
+	SECTION("Different images have distant hashes")
+	{
+		const QImage image = gradient(400, 300);
+		const QImage reversed = gradient(400, 300, true);
+
+		REQUIRE(hammingDistance(perceptualHash(image), perceptualHash(reversed)) > 16);
+	}
+
+	SECTION("File")
+	{
+		quint64 hash;
+		REQUIRE(perceptualHashFile("tests/resources/image_200x200.png", &hash));
+		REQUIRE(hash == perceptualHash(QImage("tests/resources/image_200x200.png")));
+
+		REQUIRE(!perceptualHashFile("tests/resources/tag-types.txt", &hash));
+	}
+}
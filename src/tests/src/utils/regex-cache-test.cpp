@@ -0,0 +1,61 @@
+#include <QRegularExpression>
+#include <QString>
+#include "catch.h"
+#include "utils/regex-cache.h"
+
+
+TEST_CASE("RegexCache")
+{
+	SECTION("Compiles regexes")
+	{
+		RegexCache cache;
+
+		const QRegularExpression regex = cache.get("a(b+)c");
+		REQUIRE(regex.isValid());
+		REQUIRE(regex.match("xabbbcx").captured(1) == QString("bbb"));
+	}
+
+	SECTION("Hits and misses")
+	{
+		RegexCache cache;
+		cache.get("abc");
+		cache.get("abc");
+		cache.get("abc", QRegularExpression::CaseInsensitiveOption);
+		cache.get("abc");
+
+		REQUIRE(cache.count() == 2);
+		REQUIRE(cache.hits() == 2);
+		REQUIRE(cache.misses() == 2);
+		REQUIRE(cache.hitRate() == 0.5);
+	}
+
+	SECTION("Options are part of the key")
+	{
+		RegexCache cache;
+
+		REQUIRE(!cache.get("abc").match("ABC").hasMatch());
+		REQUIRE(cache.get("abc", QRegularExpression::CaseInsensitiveOption).match("ABC").hasMatch());
+	}
+
+	SECTION("Bounded size")
+	{
+		RegexCache cache(2);
+		cache.get("a");
+		cache.get("b");
+		cache.get("c");
+
+		REQUIRE(cache.count() == 2);
+	}
+
+	SECTION("Clear")
+	{
+		RegexCache cache;
+		cache.get("abc");
+		cache.clear();
+
+		REQUIRE(cache.count() == 0);
+		REQUIRE(cache.hits() == 0);
+		REQUIRE(cache.misses() == 0);
+		REQUIRE(cache.hitRate() == 0);
+	}
+}
@@ -0,0 +1,99 @@
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QSharedPointer>
+#include <QString>
+#include "catch.h"
+#include "utils/thumbnail-cache.h"
+
+
+TEST_CASE("ThumbnailCache")
+{
+	const QString dir = "tests/resources/thumbnails-cache";
+	QDir(dir).removeRecursively();
+
+	// 1x1 images cost 1 KB each, so only two fit in the memory cache
+	ThumbnailCache cache(dir, 2 * 1024, 1024 * 1024);
+	QImage image(1, 1, QImage::Format_ARGB32);
+	image.fill(Qt::red);
+
+	SECTION("Keys")
+	{
+		REQUIRE(ThumbnailCache::key("site", "md5") == ThumbnailCache::key("site", "md5"));
+		REQUIRE(ThumbnailCache::key("site", "md5") != ThumbnailCache::key("other", "md5"));
+		REQUIRE(ThumbnailCache::key("site", "md5") != ThumbnailCache::key("site", "other"));
+	}
+
+	SECTION("Memory cache")
+	{
+		REQUIRE(cache.image("a").isNull());
+
+		cache.setImage("a", image);
+		REQUIRE(cache.image("a") == image);
+	}
+
+	SECTION("Memory cache evicts the least recently used images")
+	{
+		cache.setImage("a", image);
+		cache.setImage("b", image);
+		cache.image("a");
+		cache.setImage("c", image);
+
+		REQUIRE(!cache.image("a").isNull());
+		REQUIRE(cache.image("b").isNull());
+		REQUIRE(!cache.image("c").isNull());
+	}
+
+	SECTION("Disk cache")
+	{
+		REQUIRE(cache.data("a").isEmpty());
+
+		cache.setData("a", "data");
+		REQUIRE(cache.data("a") == QByteArray("data"));
+
+		// Persisted across instances
+		ThumbnailCache other(dir, 2 * 1024, 1024 * 1024);
+		REQUIRE(other.data("a") == QByteArray("data"));
+		REQUIRE(other.image("a").isNull());
+	}
+
+	SECTION("Remove")
+	{
+		cache.setImage("a", image);
+		cache.setData("a", "data");
+		cache.remove("a");
+
+		REQUIRE(cache.image("a").isNull());
+		REQUIRE(cache.data("a").isEmpty());
+	}
+
+	SECTION("Prune the disk cache")
+	{
+		ThumbnailCache small(dir, 2 * 1024, 10);
+		small.setData("a", "123456");
+		small.setData("b", "123456");
+		small.prune();
+
+		REQUIRE(small.data("a").isEmpty() != small.data("b").isEmpty());
+	}
+
+	SECTION("Caches are shared by directory")
+	{
+		QSharedPointer<ThumbnailCache> first = ThumbnailCache::shared(dir + "/shared", 2 * 1024, 1024 * 1024);
+		QSharedPointer<ThumbnailCache> second = ThumbnailCache::shared(dir + "/../thumbnails-cache/shared", 1024, 1024);
+		QSharedPointer<ThumbnailCache> other = ThumbnailCache::shared(dir + "/other", 2 * 1024, 1024 * 1024);
+
+		REQUIRE(first == second);
+		REQUIRE(first != other);
+
+		first->setImage("a", image);
+		REQUIRE(!second->image("a").isNull());
+
+		// Destroyed once nobody uses it anymore, so its memory cache starts empty again
+		first.clear();
+		second.clear();
+		REQUIRE(ThumbnailCache::shared(dir + "/shared", 2 * 1024, 1024 * 1024)->image("a").isNull());
+	}
+
+	QDir(dir).removeRecursively();
+}
@@ -0,0 +1,86 @@
+#include "utils/wildcard-matcher.h"
+#include <algorithm>
+#include "catch.h"
+
+
+TEST_CASE("WildcardMatcher")
+{
+	SECTION("Empty")
+	{
+		WildcardMatcher matcher;
+
+		REQUIRE(matcher.isEmpty());
+		REQUIRE(!matcher.matches("abc"));
+	}
+
+	SECTION("Exact")
+	{
+		WildcardMatcher matcher;
+		matcher.add("abc");
+
+		REQUIRE(matcher.matches("abc"));
+		REQUIRE(matcher.matches("ABC"));
+		REQUIRE(!matcher.matches("abcd"));
+	}
+
+	SECTION("Prefix")
+	{
+		WildcardMatcher matcher;
+		matcher.add("ab*");
+
+		REQUIRE(matcher.matches("ab"));
+		REQUIRE(matcher.matches("abc"));
+		REQUIRE(matcher.matches("ABCD"));
+		REQUIRE(!matcher.matches("a"));
+		REQUIRE(!matcher.matches("cab"));
+	}
+
+	SECTION("Suffix")
+	{
+		WildcardMatcher matcher;
+		matcher.add("*bc");
+
+		REQUIRE(matcher.matches("bc"));
+		REQUIRE(matcher.matches("abc"));
+		REQUIRE(!matcher.matches("bcd"));
+	}
+
+	SECTION("Generic")
+	{
+		WildcardMatcher matcher;
+		matcher.add("*b*");
+		matcher.add("x*y*z");
+
+		REQUIRE(matcher.matches("abc"));
+		REQUIRE(matcher.matches("b"));
+		REQUIRE(matcher.matches("xyz"));
+		REQUIRE(matcher.matches("x_y_z"));
+		REQUIRE(matcher.matches("xzyz"));
+		REQUIRE(!matcher.matches("xzy"));
+		REQUIRE(!matcher.matches("acd"));
+	}
+
+	SECTION("Values")
+	{
+		WildcardMatcher matcher;
+		matcher.add("abc", 1);
+		matcher.add("a*", 2);
+		matcher.add("*c", 3);
+		matcher.add("*b*", 4);
+		matcher.add("x*", 5);
+
+		QList<int> values = matcher.match("abc");
+		std::sort(values.begin(), values.end());
+		REQUIRE(values == QList<int>() << 1 << 2 << 3 << 4);
+	}
+
+	SECTION("Clear")
+	{
+		WildcardMatcher matcher;
+		matcher.add("a*");
+		matcher.clear();
+
+		REQUIRE(matcher.isEmpty());
+		REQUIRE(!matcher.matches("abc"));
+	}
+}
@@ -0,0 +1,84 @@
+#include <QByteArray>
+#include <QFile>
+#include "catch.h"
+#include "raii-helpers.h"
+#include "utils/zip-writer.h"
+#include "utils/zip.h"
+
+
+static QByteArray readFile(const QString &path)
+{
+	QFile f(path);
+	if (!f.open(QFile::ReadOnly)) {
+		return QByteArray();
+	}
+	return f.readAll();
+}
+
+
+TEST_CASE("ZipWriter")
+{
+	const QString filePath = "tests/resources/test-writer.zip";
+	FileDeleter removeFile(filePath, true);
+	DirectoryDeleter removeDir("tests/resources/unzip-writer-dir");
+
+	SECTION("Stored, deflated and aborted files")
+	{
+		const QByteArray text = QByteArray("Hello world! ").repeated(10000);
+
+		ZipWriter zip(filePath);
+		REQUIRE(zip.open());
+
+		// Added in several chunks
+		REQUIRE(zip.beginFile("text.txt", true));
+		REQUIRE(zip.write(text.left(1000)));
+		REQUIRE(zip.write(text.mid(1000)));
+		REQUIRE(zip.endFile());
+
+		// Aborted files are removed from the archive
+		REQUIRE(zip.beginFile("aborted.txt", false));
+		REQUIRE(zip.write(text));
+		REQUIRE(zip.abortFile());
+
+		REQUIRE(zip.addFile("dir/200x200.png", "tests/resources/image_200x200.png", false));
+		REQUIRE(zip.close());
+
+		// The deflated file should be much smaller than the original
+		REQUIRE(QFile(filePath).size() < text.size() + QFile("tests/resources/image_200x200.png").size());
+
+		REQUIRE(unzipFile(filePath, "tests/resources/unzip-writer-dir"));
+		REQUIRE(readFile("tests/resources/unzip-writer-dir/text.txt") == text);
+		REQUIRE(readFile("tests/resources/unzip-writer-dir/dir/200x200.png") == readFile("tests/resources/image_200x200.png"));
+		REQUIRE(!QFile::exists("tests/resources/unzip-writer-dir/aborted.txt"));
+	}
+
+	SECTION("Closing ends the current file")
+	{
+		ZipWriter zip(filePath);
+		REQUIRE(zip.open());
+		REQUIRE(zip.beginFile("a.txt", false));
+		REQUIRE(zip.write(QByteArray("abc")));
+		REQUIRE(zip.close());
+		REQUIRE(!zip.isOpen());
+
+		REQUIRE(unzipFile(filePath, "tests/resources/unzip-writer-dir"));
+		REQUIRE(readFile("tests/resources/unzip-writer-dir/a.txt") == QByteArray("abc"));
+	}
+
+	SECTION("Writing outside of a file fails")
+	{
+		ZipWriter zip(filePath);
+		REQUIRE(zip.open());
+		REQUIRE(!zip.write(QByteArray("abc")));
+		REQUIRE(!zip.endFile());
+		REQUIRE(zip.close());
+	}
+
+	SECTION("Should compress")
+	{
+		REQUIRE(ZipWriter::shouldCompress("info.txt"));
+		REQUIRE(ZipWriter::shouldCompress("tags.json"));
+		REQUIRE(!ZipWriter::shouldCompress("image.JPG"));
+		REQUIRE(!ZipWriter::shouldCompress("video.webm"));
+	}
+}